@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <fmt/format.h>
+#include <folly/portability/GFlags.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <vector>
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/model/RootId.h"
+#include "eden/fs/service/gen-cpp2/eden_types.h"
+#include "eden/fs/testharness/FakeBackingStore.h"
+#include "eden/fs/testharness/FakeTreeBuilder.h"
+#include "eden/fs/testharness/SyntheticRepo.h"
+#include "eden/fs/testharness/TestMount.h"
+
+DEFINE_uint64(depth, 3, "Number of directory levels of the synthetic repo");
+DEFINE_uint64(dirs_per_dir, 8, "Subdirectories of each directory");
+DEFINE_uint64(files_per_dir, 16, "Files in each directory");
+DEFINE_uint64(file_size, 512, "Average file size in bytes");
+DEFINE_uint64(seed, 0, "Seed of the synthetic repo");
+DEFINE_uint64(
+    changed_files,
+    1000,
+    "Number of files that differ between the two commits checked out");
+DEFINE_uint64(
+    changed_dirs,
+    50,
+    "Number of directories the changed files are spread over");
+DEFINE_uint64(
+    materialized_files,
+    1000,
+    "Number of files modified in the working copy before running status");
+
+/*
+ * End-to-end benchmarks of checkout and status on a TestMount of a synthetic
+ * repository.
+ *
+ * checkout alternates between two commits that differ in --changed_files
+ * files over --changed_dirs directories, and reports the average duration of
+ * each phase of checkout besides the total. status diffs a working copy with
+ * --materialized_files modified files against its commit.
+ *
+ * Each benchmark thread works on its own mount, so that the thread counts
+ * show how checkout and status scale when they run concurrently and contend
+ * on the process-wide state they share.
+ */
+
+namespace {
+
+using namespace facebook::eden;
+using namespace std::chrono;
+
+const RootId kCommit1{"1"};
+const RootId kCommit2{"2"};
+
+SyntheticRepoShape getShape() {
+  SyntheticRepoShape shape;
+  shape.depth = FLAGS_depth;
+  shape.dirsPerDir = FLAGS_dirs_per_dir;
+  shape.filesPerDir = FLAGS_files_per_dir;
+  shape.fileSize = FLAGS_file_size;
+  shape.seed = FLAGS_seed;
+  return shape;
+}
+
+/**
+ * Picks count files spread evenly over dirCount of the directories of files.
+ */
+std::vector<RelativePath> pickFiles(
+    const std::vector<RelativePath>& files,
+    size_t count,
+    size_t dirCount) {
+  std::map<RelativePathPiece, std::vector<RelativePathPiece>> filesByDir;
+  for (const auto& file : files) {
+    filesByDir[file.dirname()].push_back(file);
+  }
+  std::vector<const std::vector<RelativePathPiece>*> dirs;
+  for (const auto& [dir, dirFiles] : filesByDir) {
+    dirs.push_back(&dirFiles);
+  }
+  std::mt19937_64 rng{FLAGS_seed};
+  std::shuffle(dirs.begin(), dirs.end(), rng);
+  dirs.resize(std::min(std::max<size_t>(dirCount, 1), dirs.size()));
+
+  std::vector<RelativePath> picked;
+  for (size_t i = 0; picked.size() < count; ++i) {
+    bool pickedAny = false;
+    for (const auto* dirFiles : dirs) {
+      if (i < dirFiles->size() && picked.size() < count) {
+        picked.emplace_back((*dirFiles)[i]);
+        pickedAny = true;
+      }
+    }
+    if (!pickedAny) {
+      break;
+    }
+  }
+  return picked;
+}
+
+struct Repo {
+  FakeTreeBuilder builder;
+  std::vector<RelativePath> files;
+};
+
+const Repo& getRepo() {
+  static const Repo repo = [] {
+    Repo repo;
+    repo.files = buildSyntheticRepo(repo.builder, getShape());
+    return repo;
+  }();
+  return repo;
+}
+
+void checkout(benchmark::State& state) {
+  auto builder1 = getRepo().builder.clone();
+  TestMount mount{
+      kCommit1,
+      builder1,
+      /*startReady=*/true,
+      /*enableActivityBuffer=*/false};
+
+  auto builder2 = builder1.clone();
+  for (const auto& file : pickFiles(
+           getRepo().files, FLAGS_changed_files, FLAGS_changed_dirs)) {
+    builder2.replaceFile(
+        file, fmt::format("changed contents of {}\n", file.view()));
+  }
+  builder2.finalize(mount.getBackingStore(), /*setReady=*/true);
+  mount.getBackingStore()->putCommit(kCommit2, builder2)->setReady();
+  mount.loadAllInodes();
+
+  auto& edenMount = *mount.getEdenMount();
+  auto* executor = mount.getServerExecutor().get();
+  CheckoutTimes total;
+  bool toCommit2 = true;
+  for (auto _ : state) {
+    auto future =
+        edenMount.checkout(toCommit2 ? kCommit2 : kCommit1, std::nullopt, "")
+            .via(executor);
+    mount.drainServerExecutor();
+    auto result = std::move(future).get();
+    total.didLookupTrees += result.times.didLookupTrees;
+    total.didDiff += result.times.didDiff;
+    total.didAcquireRenameLock += result.times.didAcquireRenameLock;
+    total.didCheckout += result.times.didCheckout;
+    total.didFinish += result.times.didFinish;
+    toCommit2 = !toCommit2;
+  }
+
+  // The phase durations are cumulative since the start of checkout.
+  auto report = [&](const char* name, CheckoutTimes::duration elapsed) {
+    state.counters[name] = benchmark::Counter(
+        duration_cast<duration<double>>(elapsed).count(),
+        benchmark::Counter::kAvgIterations);
+  };
+  report("lookup_trees_s", total.didLookupTrees);
+  report("diff_s", total.didDiff - total.didLookupTrees);
+  report("rename_lock_s", total.didAcquireRenameLock - total.didDiff);
+  report("checkout_s", total.didCheckout - total.didAcquireRenameLock);
+  report("finish_s", total.didFinish - total.didCheckout);
+}
+BENCHMARK(checkout)->ThreadRange(1, 8)->UseRealTime();
+
+void status(benchmark::State& state) {
+  auto builder = getRepo().builder.clone();
+  TestMount mount{
+      kCommit1,
+      builder,
+      /*startReady=*/true,
+      /*enableActivityBuffer=*/false};
+  for (const auto& file : pickFiles(
+           getRepo().files, FLAGS_materialized_files, SIZE_MAX)) {
+    mount.overwriteFile(file.view(), "modified in the working copy\n");
+  }
+
+  auto& edenMount = *mount.getEdenMount();
+  auto* executor = mount.getServerExecutor().get();
+  size_t changed = 0;
+  for (auto _ : state) {
+    auto future = edenMount
+                      .diff(
+                          kCommit1,
+                          folly::CancellationToken{},
+                          /*listIgnored=*/false,
+                          /*enforceCurrentParent=*/false)
+                      .semi()
+                      .via(executor);
+    mount.drainServerExecutor();
+    changed = std::move(future).get()->entries()->size();
+  }
+  state.counters["changed"] = static_cast<double>(changed);
+}
+BENCHMARK(status)->ThreadRange(1, 8)->UseRealTime();
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -5,8 +5,15 @@
  * GNU General Public License version 2.
  */
 
+#include <folly/synchronization/Baton.h>
+#if FOLLY_HAS_COROUTINES
+#include <folly/experimental/coro/BlockingWait.h>
+#include <folly/experimental/coro/Task.h>
+#endif
 #include "eden/common/utils/benchharness/Bench.h"
 #include "eden/fs/utils/ImmediateFuture.h"
+#include "eden/fs/utils/UnboundedQueueExecutor.h"
+#include "eden/fs/utils/WorkStealingExecutor.h"
 
 namespace {
 
@@ -44,9 +51,192 @@ void folly_future(benchmark::State& state) {
   state.SetItemsProcessed(std::move(fut).get());
 }
 
+#if FOLLY_HAS_COROUTINES
+/**
+ * The coroutine equivalent of immediate_future: every ready ImmediateFuture
+ * is awaited inline, without allocating a continuation.
+ */
+void immediate_future_coro(benchmark::State& state) {
+  auto task = [&]() -> folly::coro::Task<uint64_t> {
+    uint64_t value = 0;
+    for (auto _ : state) {
+      value = co_await ImmediateFuture<uint64_t>{value + 1};
+    }
+    co_return value;
+  };
+  state.SetItemsProcessed(folly::coro::blockingWait(task()));
+}
+
+/**
+ * A chain of kChainDepth dependent lookups, like a path walk, done with
+ * nested thenValue continuations.
+ */
+constexpr size_t kChainDepth = 16;
+
+ImmediateFuture<uint64_t> chainedLookup(uint64_t value, size_t depth) {
+  if (depth == 0) {
+    return value;
+  }
+  return ImmediateFuture<uint64_t>{value + 1}.thenValue(
+      [depth](uint64_t v) { return chainedLookup(v, depth - 1); });
+}
+
+void immediate_future_nested_chain(benchmark::State& state) {
+  uint64_t value = 0;
+  for (auto _ : state) {
+    value = chainedLookup(value, kChainDepth).get();
+  }
+  state.SetItemsProcessed(value);
+}
+
+/**
+ * The same lookups done sequentially from a single coroutine.
+ */
+void immediate_future_coro_chain(benchmark::State& state) {
+  auto task = [&]() -> folly::coro::Task<uint64_t> {
+    uint64_t value = 0;
+    for (auto _ : state) {
+      for (size_t depth = 0; depth < kChainDepth; ++depth) {
+        value = co_await ImmediateFuture<uint64_t>{value + 1};
+      }
+    }
+    co_return value;
+  };
+  state.SetItemsProcessed(folly::coro::blockingWait(task()));
+}
+#endif
+
+constexpr size_t kExecutorThreads = 8;
+constexpr size_t kChainLength = 100;
+constexpr size_t kFanOut = 1000;
+
+UnboundedQueueExecutor& getSharedQueueExecutor() {
+  static UnboundedQueueExecutor executor{kExecutorThreads, "SharedQueue"};
+  return executor;
+}
+
+UnboundedQueueExecutor& getWorkStealingExecutor() {
+  static UnboundedQueueExecutor executor{
+      std::make_shared<WorkStealingExecutor>(kExecutorThreads, "WorkStealing")};
+  return executor;
+}
+
+/**
+ * Every task schedules the next one, like the continuations of a chain of
+ * futures .via() the executor.
+ */
+void runChain(
+    folly::Executor& executor,
+    size_t remaining,
+    folly::Baton<>& done) {
+  if (remaining == 0) {
+    done.post();
+    return;
+  }
+  executor.add([&executor, remaining, &done] {
+    runChain(executor, remaining - 1, done);
+  });
+}
+
+void executorChain(benchmark::State& state, UnboundedQueueExecutor& executor) {
+  for (auto _ : state) {
+    folly::Baton<> done;
+    runChain(executor, kChainLength, done);
+    done.wait();
+  }
+  state.SetItemsProcessed(state.iterations() * kChainLength);
+}
+
+/**
+ * A task adding many small tasks at once, like a checkout diffing the
+ * entries of a tree.
+ */
+void executorFanOut(benchmark::State& state, UnboundedQueueExecutor& executor) {
+  for (auto _ : state) {
+    std::atomic<size_t> remaining{kFanOut};
+    folly::Baton<> done;
+    executor.add([&] {
+      for (size_t i = 0; i < kFanOut; ++i) {
+        executor.add([&] {
+          if (--remaining == 0) {
+            done.post();
+          }
+        });
+      }
+    });
+    done.wait();
+  }
+  state.SetItemsProcessed(state.iterations() * kFanOut);
+}
+
+/**
+ * The latency of a single task added from outside the executor, like a
+ * thrift request, while the executor is busy with a fan-out.
+ */
+void executorLatencyUnderLoad(
+    benchmark::State& state,
+    UnboundedQueueExecutor& executor) {
+  for (auto _ : state) {
+    std::atomic<size_t> remaining{kFanOut};
+    folly::Baton<> loadDone;
+    executor.add([&] {
+      for (size_t i = 0; i < kFanOut; ++i) {
+        executor.add([&] {
+          if (--remaining == 0) {
+            loadDone.post();
+          }
+        });
+      }
+    });
+
+    folly::Baton<> done;
+    executor.add([&] { done.post(); });
+    done.wait();
+
+    state.PauseTiming();
+    loadDone.wait();
+    state.ResumeTiming();
+  }
+}
+
+void shared_queue_chain(benchmark::State& state) {
+  executorChain(state, getSharedQueueExecutor());
+}
+
+void work_stealing_chain(benchmark::State& state) {
+  executorChain(state, getWorkStealingExecutor());
+}
+
+void shared_queue_fan_out(benchmark::State& state) {
+  executorFanOut(state, getSharedQueueExecutor());
+}
+
+void work_stealing_fan_out(benchmark::State& state) {
+  executorFanOut(state, getWorkStealingExecutor());
+}
+
+void shared_queue_latency_under_load(benchmark::State& state) {
+  executorLatencyUnderLoad(state, getSharedQueueExecutor());
+}
+
+void work_stealing_latency_under_load(benchmark::State& state) {
+  executorLatencyUnderLoad(state, getWorkStealingExecutor());
+}
+
 BENCHMARK(immediate_future);
 BENCHMARK(immediate_future_exc);
 BENCHMARK(folly_future);
+#if FOLLY_HAS_COROUTINES
+BENCHMARK(immediate_future_coro);
+BENCHMARK(immediate_future_nested_chain);
+BENCHMARK(immediate_future_coro_chain);
+#endif
+BENCHMARK(shared_queue_chain);
+BENCHMARK(work_stealing_chain);
+BENCHMARK(shared_queue_fan_out);
+BENCHMARK(work_stealing_fan_out);
+BENCHMARK(shared_queue_latency_under_load);
+BENCHMARK(work_stealing_latency_under_load);
 } // namespace
 
 EDEN_BENCHMARK_MAIN();
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/String.h>
+#include <string>
+#include <vector>
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/model/Hash.h"
+
+namespace {
+
+using namespace facebook::eden;
+
+std::vector<Hash20> makeHashes(size_t count) {
+  std::vector<Hash20> hashes;
+  hashes.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    hashes.push_back(Hash20::sha1(folly::to<std::string>(i)));
+  }
+  return hashes;
+}
+
+std::vector<std::string> makeHexHashes(size_t count) {
+  std::vector<std::string> hexHashes;
+  for (const auto& hash : makeHashes(count)) {
+    hexHashes.push_back(hash.toString());
+  }
+  return hexHashes;
+}
+
+void follyHexlify(benchmark::State& state) {
+  auto hashes = makeHashes(state.range(0));
+  for (auto _ : state) {
+    for (const auto& hash : hashes) {
+      std::string result;
+      folly::hexlify(hash.getBytes(), result);
+      benchmark::DoNotOptimize(result);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * hashes.size());
+}
+
+void hashToString(benchmark::State& state) {
+  auto hashes = makeHashes(state.range(0));
+  for (auto _ : state) {
+    for (const auto& hash : hashes) {
+      benchmark::DoNotOptimize(hash.toString());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * hashes.size());
+}
+
+void hashesToHexBatch(benchmark::State& state) {
+  auto hashes = makeHashes(state.range(0));
+  std::string result(hashes.size() * Hash20::RAW_SIZE * 2, '\0');
+  for (auto _ : state) {
+    hashesToHex(HashRange{hashes.data(), hashes.size()}, result.data());
+    benchmark::DoNotOptimize(result);
+  }
+  state.SetItemsProcessed(state.iterations() * hashes.size());
+}
+
+void follyUnhexlify(benchmark::State& state) {
+  auto hexHashes = makeHexHashes(state.range(0));
+  for (auto _ : state) {
+    for (const auto& hex : hexHashes) {
+      std::string result;
+      folly::unhexlify(hex, result);
+      benchmark::DoNotOptimize(result);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * hexHashes.size());
+}
+
+void hashFromHex(benchmark::State& state) {
+  auto hexHashes = makeHexHashes(state.range(0));
+  for (auto _ : state) {
+    for (const auto& hex : hexHashes) {
+      benchmark::DoNotOptimize(Hash20{hex});
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * hexHashes.size());
+}
+
+void hashesFromHexBatch(benchmark::State& state) {
+  std::string hex;
+  for (const auto& hexHash : makeHexHashes(state.range(0))) {
+    hex += hexHash;
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(hashesFromHex(hex));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(follyHexlify)->Arg(1000)->Arg(100000);
+BENCHMARK(hashToString)->Arg(1000)->Arg(100000);
+BENCHMARK(hashesToHexBatch)->Arg(1000)->Arg(100000);
+BENCHMARK(follyUnhexlify)->Arg(1000)->Arg(100000);
+BENCHMARK(hashFromHex)->Arg(1000)->Arg(100000);
+BENCHMARK(hashesFromHexBatch)->Arg(1000)->Arg(100000);
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
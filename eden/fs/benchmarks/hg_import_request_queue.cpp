@@ -5,6 +5,9 @@
  * GNU General Public License version 2.
  */
 
+#include <folly/Try.h>
+#include <atomic>
+#include <thread>
 #include "eden/common/utils/benchharness/Bench.h"
 #include "eden/fs/config/ReloadableConfig.h"
 #include "eden/fs/store/ImportPriority.h"
@@ -68,6 +71,97 @@ void dequeue(benchmark::State& state) {
   }
 }
 
+/**
+ * Many producer threads enqueue into one shared queue while a few consumer
+ * threads drain it, as the HgQueuedBackingStore worker threads do. The first
+ * argument is the number of producers, the second the number of consumers.
+ * Producers mix in some High priority requests and some duplicates to
+ * exercise priority bumps.
+ */
+void enqueueDequeueContended(benchmark::State& state) {
+  auto rawEdenConfig = EdenConfig::createTestEdenConfig();
+  rawEdenConfig->importBatchSize.setValue(32, ConfigSource::Default, true);
+  auto edenConfig = std::make_shared<ReloadableConfig>(
+      rawEdenConfig, ConfigReloadBehavior::NoReload);
+
+  auto producerCount = static_cast<size_t>(state.range(0));
+  auto consumerCount = static_cast<size_t>(state.range(1));
+  constexpr size_t kRequestsPerProducer = 2000;
+  constexpr size_t kDuplicateEvery = 8;
+  constexpr size_t kHighPriorityEvery = 64;
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::vector<std::vector<std::shared_ptr<HgImportRequest>>> requests{
+        producerCount};
+    for (auto& producerRequests : requests) {
+      producerRequests.reserve(kRequestsPerProducer);
+      for (size_t i = 0; i < kRequestsPerProducer; i++) {
+        if (i % kDuplicateEvery == kDuplicateEvery - 1) {
+          // Duplicate of the previous request, with a higher priority.
+          auto* previous = producerRequests.back()
+                               ->getRequest<HgImportRequest::BlobImport>();
+          producerRequests.emplace_back(HgImportRequest::makeBlobImportRequest(
+              previous->hash,
+              previous->proxyHash,
+              kDefaultFsImportPriority,
+              ObjectFetchContext::Cause::Unknown));
+        } else {
+          producerRequests.emplace_back(makeBlobImportRequest(
+              i % kHighPriorityEvery == 0 ? kDefaultFsImportPriority
+                                          : kThriftPrefetchPriority));
+        }
+      }
+    }
+    auto uniqueRequests = producerCount *
+        (kRequestsPerProducer - kRequestsPerProducer / kDuplicateEvery);
+    auto queue = std::make_unique<HgImportRequestQueue>(edenConfig);
+    std::atomic<size_t> dequeued{0};
+    state.ResumeTiming();
+
+    std::vector<std::thread> consumers;
+    for (size_t i = 0; i < consumerCount; i++) {
+      consumers.emplace_back([&] {
+        while (true) {
+          auto batch = queue->dequeue();
+          if (batch.empty()) {
+            return;
+          }
+          for (auto& request : batch) {
+            auto* import = request->getRequest<HgImportRequest::BlobImport>();
+            folly::Try<BlobPtr> blob{
+                std::make_shared<const Blob>(import->hash, folly::IOBuf{})};
+            queue->markImportAsFinished<Blob>(import->hash, blob);
+          }
+          if (dequeued.fetch_add(batch.size()) + batch.size() >=
+              uniqueRequests) {
+            queue->stop();
+          }
+        }
+      });
+    }
+
+    std::vector<std::thread> producers;
+    for (size_t i = 0; i < producerCount; i++) {
+      producers.emplace_back([&, i] {
+        for (auto& request : requests[i]) {
+          queue->enqueueBlob(std::move(request));
+        }
+      });
+    }
+
+    for (auto& producer : producers) {
+      producer.join();
+    }
+    for (auto& consumer : consumers) {
+      consumer.join();
+    }
+  }
+
+  state.SetItemsProcessed(
+      state.iterations() * producerCount * kRequestsPerProducer);
+}
+
 BENCHMARK(enqueue)
     ->Unit(benchmark::kNanosecond)
     ->Threads(1)
@@ -75,7 +169,8 @@ BENCHMARK(enqueue)
     ->Threads(4)
     ->Threads(8)
     ->Threads(16)
-    ->Threads(32);
+    ->Threads(32)
+    ->Threads(64);
 
 BENCHMARK(dequeue)
     ->Unit(benchmark::kNanosecond)
@@ -84,7 +179,16 @@ BENCHMARK(dequeue)
     ->Threads(4)
     ->Threads(8)
     ->Threads(16)
-    ->Threads(32);
+    ->Threads(32)
+    ->Threads(64);
+
+BENCHMARK(enqueueDequeueContended)
+    ->ArgNames({"producers", "consumers"})
+    ->Args({1, 1})
+    ->Args({8, 4})
+    ->Args({64, 8})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
 } // namespace
 
 EDEN_BENCHMARK_MAIN();
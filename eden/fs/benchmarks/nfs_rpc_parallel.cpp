@@ -0,0 +1,219 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include <folly/Utility.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/IOThreadPoolExecutor.h>
+#include <folly/init/Init.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/portability/GFlags.h>
+#include <folly/synchronization/test/Barrier.h>
+#include <inttypes.h>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/nfs/NfsdRpc.h"
+#include "eden/fs/nfs/rpc/Server.h"
+#include "eden/fs/nfs/rpc/StreamClient.h"
+#include "eden/fs/telemetry/NullStructuredLogger.h"
+#include "eden/fs/testharness/TempFile.h"
+
+DEFINE_uint64(clients, 4, "The number of concurrent client connections");
+DEFINE_uint64(
+    iterations,
+    100000,
+    "Number of READs per client, each after lookups_per_read LOOKUPs");
+DEFINE_uint64(
+    lookups_per_read,
+    1,
+    "Number of LOOKUPs before each READ, to model path resolution heavy "
+    "workloads");
+DEFINE_bool(
+    unix_socket,
+    false,
+    "Serve on a unix socket instead of a localhost TCP socket");
+DEFINE_uint64(
+    io_threads,
+    0,
+    "Number of EventBase threads the connections are spread over. With 0, "
+    "every connection shares the accepting EventBase");
+DEFINE_uint64(servicing_threads, 8, "Number of request servicing threads");
+DEFINE_uint32(read_size, 4096, "Number of bytes returned by each READ");
+
+using namespace facebook::eden;
+
+namespace {
+
+/**
+ * Answers LOOKUP and READ with canned results. The arguments are still
+ * decoded and the results encoded, so this measures the RPC server and the
+ * XDR layer without any file system underneath.
+ */
+class CannedNfsProcessor : public RpcServerProcessor {
+ public:
+  ImmediateFuture<folly::Unit> dispatchRpc(
+      folly::io::Cursor deser,
+      folly::io::QueueAppender ser,
+      uint32_t xid,
+      uint32_t /*progNumber*/,
+      uint32_t /*progVersion*/,
+      uint32_t procNumber) override {
+    serializeReply(ser, accept_stat::SUCCESS, xid);
+    switch (static_cast<nfsv3Procs>(procNumber)) {
+      case nfsv3Procs::lookup: {
+        auto args = XdrTrait<LOOKUP3args>::deserialize(deser);
+        LOOKUP3res res{
+            {{nfsstat3::NFS3_OK,
+              LOOKUP3resok{
+                  nfs_fh3{InodeNumber{args.what.dir.ino.get() + 1}},
+                  post_op_attr{},
+                  post_op_attr{}}}}};
+        XdrTrait<LOOKUP3res>::serialize(ser, res);
+        break;
+      }
+      case nfsv3Procs::read: {
+        auto args = XdrTrait<READ3args>::deserialize(deser);
+        auto data = folly::IOBuf::create(args.count);
+        memset(data->writableData(), 'a', args.count);
+        data->append(args.count);
+        READ3res res{
+            {{nfsstat3::NFS3_OK,
+              READ3resok{
+                  /*file_attributes*/ post_op_attr{},
+                  /*count*/ args.count,
+                  /*eof*/ false,
+                  /*data*/ std::move(data),
+              }}}};
+        XdrTrait<READ3res>::serialize(ser, res);
+        break;
+      }
+      default:
+        break;
+    }
+    return folly::unit;
+  }
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+
+  folly::ScopedEventBaseThread acceptThread{"NfsAccept"};
+  auto* acceptEvb = acceptThread.getEventBase();
+  std::unique_ptr<folly::IOThreadPoolExecutor> ioThreads;
+  std::vector<folly::EventBase*> connectionEvbs;
+  if (FLAGS_io_threads > 0) {
+    ioThreads =
+        std::make_unique<folly::IOThreadPoolExecutor>(FLAGS_io_threads);
+    for (auto& evb : ioThreads->getAllEventBases()) {
+      connectionEvbs.push_back(evb.get());
+    }
+  }
+
+  auto server = RpcServer::create(
+      std::make_shared<CannedNfsProcessor>(),
+      acceptEvb,
+      std::move(connectionEvbs),
+      std::make_shared<folly::CPUThreadPoolExecutor>(FLAGS_servicing_threads),
+      std::make_shared<NullStructuredLogger>());
+  auto tempDir = makeTempDir("eden_nfs_rpc_parallel");
+  folly::SocketAddress addr{"127.0.0.1", 0};
+  if (FLAGS_unix_socket) {
+    addr = folly::SocketAddress::makeFromPath(
+        (tempDir.path() / "nfsd.socket").string());
+  }
+  acceptEvb->runInEventBaseThreadAndWait([&] { server->initialize(addr); });
+
+  // The main thread also waits, to start the wall clock.
+  folly::test::Barrier gate{FLAGS_clients + 1};
+
+  std::mutex result_mutex;
+  StatAccumulator combined_lookup;
+  StatAccumulator combined_read;
+
+  auto thread = [&] {
+    StreamClient client{server->getAddr()};
+    client.connect();
+    StatAccumulator lookup_accum;
+    StatAccumulator read_accum;
+
+    gate.wait();
+
+    for (uint64_t i = 0; i < FLAGS_iterations; ++i) {
+      nfs_fh3 fh{kRootNodeId};
+      for (uint64_t l = 0; l < FLAGS_lookups_per_read; ++l) {
+        uint64_t start_time = getTime();
+        auto lookup = client.call<LOOKUP3res>(
+            kNfsdProgNumber,
+            kNfsd3ProgVersion,
+            folly::to_underlying(nfsv3Procs::lookup),
+            LOOKUP3args{diropargs3{fh, "file"}});
+        lookup_accum.add(getTime() - start_time);
+        fh = std::get<LOOKUP3resok>(lookup.v).object;
+      }
+
+      uint64_t start_time = getTime();
+      client.call<READ3res>(
+          kNfsdProgNumber,
+          kNfsd3ProgVersion,
+          folly::to_underlying(nfsv3Procs::read),
+          READ3args{fh, 0, FLAGS_read_size});
+      read_accum.add(getTime() - start_time);
+    }
+
+    std::lock_guard guard{result_mutex};
+    combined_lookup.combine(lookup_accum);
+    combined_read.combine(read_accum);
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(FLAGS_clients);
+  for (uint64_t t = 0; t < FLAGS_clients; ++t) {
+    threads.emplace_back(thread);
+  }
+
+  gate.wait();
+  auto start = std::chrono::steady_clock::now();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  printf(
+      "LOOKUP\n  minimum: %" PRIu64 " ns\n  average: %" PRIu64 " ns\n",
+      combined_lookup.getMinimum(),
+      combined_lookup.getAverage());
+  printf(
+      "READ\n  minimum: %" PRIu64 " ns\n  average: %" PRIu64 " ns\n",
+      combined_read.getMinimum(),
+      combined_read.getAverage());
+  printf(
+      "throughput: %.0f requests per second across %" PRIu64
+      " connections and %" PRIu64 " IO threads\n",
+      static_cast<double>(
+          (FLAGS_lookups_per_read + 1) * FLAGS_clients * FLAGS_iterations) /
+          elapsed.count(),
+      FLAGS_clients,
+      FLAGS_io_threads);
+  printf("transport: %s\n", FLAGS_unix_socket ? "unix socket" : "TCP");
+
+  // The listening socket must be closed on the EventBase it is attached to.
+  acceptEvb->runInEventBaseThreadAndWait([&] { server.reset(); });
+}
+
+#else
+
+int main() {
+  return 0;
+}
+
+#endif
@@ -13,7 +13,9 @@
 #include <folly/portability/Unistd.h>
 #include <folly/synchronization/test/Barrier.h>
 #include <inttypes.h>
+#include <sched.h>
 #include <string.h>
+#include <chrono>
 #include <limits>
 #include <mutex>
 #include <system_error>
@@ -22,6 +24,35 @@
 
 DEFINE_uint64(threads, 1, "The number of concurrent open/close threads");
 DEFINE_uint64(iterations, 100000, "Number of open/close iterations per thread");
+DEFINE_bool(
+    pin_threads,
+    false,
+    "Pin each thread to its own CPU, so runs with different --threads values "
+    "measure how the file system scales rather than the scheduler");
+
+namespace {
+void pinToCpu(uint64_t index) {
+#ifdef __linux__
+  cpu_set_t cpus;
+  folly::checkUnixError(
+      sched_getaffinity(0, sizeof(cpus), &cpus), "sched_getaffinity");
+  auto count = static_cast<uint64_t>(CPU_COUNT(&cpus));
+  // Pick the index-th CPU we are allowed to run on, wrapping around.
+  uint64_t target = index % count;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &cpus) && target-- == 0) {
+      CPU_ZERO(&cpus);
+      CPU_SET(cpu, &cpus);
+      folly::checkUnixError(
+          sched_setaffinity(0, sizeof(cpus), &cpus), "sched_setaffinity");
+      return;
+    }
+  }
+#else
+  (void)index;
+#endif
+}
+} // namespace
 
 using namespace facebook::eden;
 
@@ -54,13 +85,17 @@ int main(int argc, char** argv) {
     ::close(fd);
   }
 
-  folly::test::Barrier gate{FLAGS_threads};
+  // The main thread also waits, to start the wall clock.
+  folly::test::Barrier gate{FLAGS_threads + 1};
 
   std::mutex result_mutex;
   StatAccumulator combined_open;
   StatAccumulator combined_close;
 
-  auto thread = [&] {
+  auto thread = [&](uint64_t index) {
+    if (FLAGS_pin_threads) {
+      pinToCpu(index);
+    }
     StatAccumulator open_accum;
     StatAccumulator close_accum;
     int file_index = 1;
@@ -95,12 +130,16 @@ int main(int argc, char** argv) {
   std::vector<std::thread> threads;
   threads.reserve(FLAGS_threads);
   for (uint64_t t = 0; t < FLAGS_threads; ++t) {
-    threads.emplace_back(thread);
+    threads.emplace_back(thread, t);
   }
 
+  gate.wait();
+  auto start = std::chrono::steady_clock::now();
   for (auto& thread : threads) {
     thread.join();
   }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
 
   printf(
       "open()\n  minimum: %" PRIu64 " ns\n  average: %" PRIu64 " ns\n",
@@ -110,4 +149,9 @@ int main(int argc, char** argv) {
       "close()\n  minimum: %" PRIu64 " ns\n  average: %" PRIu64 " ns\n",
       combined_close.getMinimum(),
       combined_close.getAverage());
+  printf(
+      "throughput: %.0f open/close pairs per second across %" PRIu64
+      " threads\n",
+      static_cast<double>(FLAGS_threads * FLAGS_iterations) / elapsed.count(),
+      FLAGS_threads);
 }
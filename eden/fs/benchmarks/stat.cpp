@@ -29,6 +29,23 @@ void call_fstat(benchmark::State& state) {
 }
 BENCHMARK(call_fstat);
 
+/**
+ * Unlike fstat(), stat() also resolves the path, so this measures the
+ * kernel's entry cache as well as its attribute cache.
+ */
+void call_stat(benchmark::State& state) {
+  // Only the path is used below.
+  folly::File{FLAGS_filename, O_CREAT | O_RDONLY | O_CLOEXEC};
+  struct stat buf;
+
+  for (auto _ : state) {
+    folly::checkUnixError(::stat(FLAGS_filename.c_str(), &buf), "stat failed");
+  }
+
+  folly::checkUnixError(::unlink(FLAGS_filename.c_str()));
+}
+BENCHMARK(call_stat);
+
 } // namespace
 
 EDEN_BENCHMARK_MAIN();
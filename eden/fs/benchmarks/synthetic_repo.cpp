@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/portability/GFlags.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/inodes/FileInode.h"
+#include "eden/fs/inodes/VirtualInode.h"
+#include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/testharness/FakeBackingStore.h"
+#include "eden/fs/testharness/FakeTreeBuilder.h"
+#include "eden/fs/testharness/SyntheticRepo.h"
+#include "eden/fs/testharness/TestMount.h"
+
+DEFINE_uint64(depth, 3, "Number of directory levels of the synthetic repo");
+DEFINE_uint64(dirs_per_dir, 8, "Subdirectories of each directory");
+DEFINE_uint64(files_per_dir, 16, "Files in each directory");
+DEFINE_uint64(file_size, 512, "Average file size in bytes");
+DEFINE_uint64(seed, 0, "Seed of the synthetic repo and of the access order");
+
+/*
+ * These benchmarks run the inode layer against a synthetic repository in a
+ * FakeBackingStore, in a random order, starting from a freshly mounted
+ * repository. Besides the time per operation, they report the number of
+ * backing store fetches per operation, which must not regress.
+ */
+
+namespace {
+
+using namespace facebook::eden;
+
+struct SyntheticRepo {
+  FakeTreeBuilder builder;
+  std::vector<RelativePath> files;
+  std::vector<RelativePath> directories;
+};
+
+const SyntheticRepo& getSyntheticRepo() {
+  static const SyntheticRepo repo = [] {
+    SyntheticRepoShape shape;
+    shape.depth = FLAGS_depth;
+    shape.dirsPerDir = FLAGS_dirs_per_dir;
+    shape.filesPerDir = FLAGS_files_per_dir;
+    shape.fileSize = FLAGS_file_size;
+    shape.seed = FLAGS_seed;
+
+    SyntheticRepo repo;
+    repo.files = buildSyntheticRepo(repo.builder, shape);
+    for (const auto& file : repo.files) {
+      repo.directories.push_back(file.dirname().copy());
+    }
+    std::sort(repo.directories.begin(), repo.directories.end());
+    repo.directories.erase(
+        std::unique(repo.directories.begin(), repo.directories.end()),
+        repo.directories.end());
+
+    std::mt19937_64 rng{FLAGS_seed};
+    std::shuffle(repo.files.begin(), repo.files.end(), rng);
+    std::shuffle(repo.directories.begin(), repo.directories.end(), rng);
+    return repo;
+  }();
+  return repo;
+}
+
+/**
+ * Runs operation on each path in turn, on a new mount of the synthetic repo.
+ */
+template <typename Operation>
+void runOnPaths(
+    benchmark::State& state,
+    const std::vector<RelativePath>& paths,
+    Operation&& operation) {
+  auto builder = getSyntheticRepo().builder.clone();
+  TestMount mount{builder, /*startReady=*/true, /*enableActivityBuffer=*/false};
+  auto& backingStore = *mount.getBackingStore();
+  auto fetchesBefore = backingStore.getTotalAccessCount();
+
+  size_t i = 0;
+  for (auto _ : state) {
+    operation(*mount.getEdenMount(), paths[i]);
+    i = (i + 1) % paths.size();
+  }
+
+  state.counters["fetches"] = benchmark::Counter(
+      static_cast<double>(backingStore.getTotalAccessCount() - fetchesBefore),
+      benchmark::Counter::kAvgIterations);
+}
+
+void stat_files(benchmark::State& state) {
+  runOnPaths(
+      state,
+      getSyntheticRepo().files,
+      [](EdenMount& mount, RelativePathPiece path) {
+        auto& context = ObjectFetchContext::getNullContext();
+        auto inode = mount.getInodeSlow(path, context).get();
+        benchmark::DoNotOptimize(inode->stat(context).get());
+      });
+}
+BENCHMARK(stat_files);
+
+void read_files(benchmark::State& state) {
+  runOnPaths(
+      state,
+      getSyntheticRepo().files,
+      [](EdenMount& mount, RelativePathPiece path) {
+        auto& context = ObjectFetchContext::getNullContext();
+        auto inode = mount.getInodeSlow(path, context).get().asFilePtr();
+        benchmark::DoNotOptimize(inode->readAll(context).get());
+      });
+}
+BENCHMARK(read_files);
+
+void list_directories(benchmark::State& state) {
+  runOnPaths(
+      state,
+      getSyntheticRepo().directories,
+      [](EdenMount& mount, RelativePathPiece path) {
+        auto& context = ObjectFetchContext::getNullContext();
+        auto inode = mount.getVirtualInode(path, context).get();
+        benchmark::DoNotOptimize(
+            inode.getChildren(path, mount.getObjectStore(), context));
+      });
+}
+BENCHMARK(list_directories);
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -0,0 +1,453 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <folly/Exception.h>
+#include <folly/FileUtil.h>
+#include <folly/String.h>
+#include <folly/init/Init.h>
+#include <folly/io/async/EventBaseThread.h>
+#include <folly/json/dynamic.h>
+#include <folly/json/json.h>
+#include <folly/portability/GFlags.h>
+#include <folly/portability/Unistd.h>
+#include <folly/synchronization/test/Barrier.h>
+#include <sys/stat.h>
+#include <thrift/lib/cpp2/async/HeaderClientChannel.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cinttypes>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "eden/fs/service/gen-cpp2/EdenService.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+DEFINE_string(mount, "", "Root of the EdenFS mount to replay the trace in");
+DEFINE_string(trace, "", "The trace to replay, see below for its format");
+DEFINE_string(
+    trace_root,
+    "",
+    "Absolute paths under this directory are replayed relative to --mount. "
+    "Use the root of the repository the trace was recorded in");
+DEFINE_uint64(threads, 1, "Number of threads replaying the trace");
+DEFINE_uint64(repeat, 1, "Number of times each thread replays its share");
+DEFINE_uint64(read_size, 64 * 1024, "Bytes read by each read operation");
+DEFINE_string(
+    counter_regex,
+    "((store\\.hg)|(object_store))\\..*\\.count",
+    "EdenFS counters whose change is reported, such as fetch counts");
+DEFINE_string(json, "", "Write the results to this file as JSON");
+DEFINE_string(
+    baseline,
+    "",
+    "The --json output of a previous run, for instance with a previous "
+    "EdenFS version, to compare the results with");
+
+/*
+ * Replays the file system operations of a trace against an EdenFS mount,
+ * spreading them over --threads threads, and reports the latency
+ * distribution of each kind of operation, along with the change of the
+ * EdenFS counters matching --counter_regex.
+ *
+ * The trace is either strace output (for instance from
+ * `strace -f -e trace=%file,getdents64 -o trace.txt buck build ...`), from
+ * which the stat, open and readlink calls are replayed, or a list of
+ * operations, one per line:
+ *
+ *   stat PATH
+ *   lstat PATH
+ *   open PATH
+ *   read PATH
+ *   readdir PATH
+ *   readlink PATH
+ *
+ * where read opens the file and reads up to --read_size bytes, and readdir
+ * lists the directory. PATH is relative to the mount, or absolute under
+ * --trace_root.
+ */
+
+namespace {
+
+using namespace facebook::eden;
+using Clock = std::chrono::steady_clock;
+
+enum class Op { STAT, LSTAT, OPEN, READ, READDIR, READLINK };
+constexpr std::array<const char*, 6> kOpNames{
+    "stat",
+    "lstat",
+    "open",
+    "read",
+    "readdir",
+    "readlink",
+};
+
+std::optional<Op> parseOp(folly::StringPiece name) {
+  for (size_t i = 0; i < kOpNames.size(); ++i) {
+    if (name == kOpNames[i]) {
+      return static_cast<Op>(i);
+    }
+  }
+  // strace syscall names.
+  if (name == "open" || name == "openat" || name == "creat") {
+    return Op::OPEN;
+  }
+  if (name == "stat" || name == "stat64" || name == "newfstatat" ||
+      name == "statx" || name == "access" || name == "faccessat" ||
+      name == "faccessat2") {
+    return Op::STAT;
+  }
+  if (name == "lstat" || name == "lstat64") {
+    return Op::LSTAT;
+  }
+  if (name == "readlink" || name == "readlinkat") {
+    return Op::READLINK;
+  }
+  return std::nullopt;
+}
+
+struct Operation {
+  Op op;
+  std::string path;
+};
+
+/**
+ * Returns the path relative to the mount, or std::nullopt if the path is
+ * outside of the traced repository.
+ */
+std::optional<std::string> rebasePath(folly::StringPiece path) {
+  if (!path.startsWith('/')) {
+    return path.str();
+  }
+  folly::StringPiece root{FLAGS_trace_root};
+  if (root.empty() || !path.startsWith(root)) {
+    return std::nullopt;
+  }
+  path.advance(root.size());
+  while (path.startsWith('/')) {
+    path.advance(1);
+  }
+  return path.str();
+}
+
+/**
+ * Parses "stat PATH", or a strace line like
+ * `1234  openat(AT_FDCWD, "/repo/foo", O_RDONLY) = 3`.
+ */
+std::optional<Operation> parseLine(folly::StringPiece line) {
+  line = folly::trimWhitespace(line);
+  auto paren = line.find('(');
+  if (paren == folly::StringPiece::npos) {
+    auto space = line.find(' ');
+    if (space == folly::StringPiece::npos) {
+      return std::nullopt;
+    }
+    auto op = parseOp(line.subpiece(0, space));
+    auto path = rebasePath(folly::trimWhitespace(line.subpiece(space + 1)));
+    if (!op || !path) {
+      return std::nullopt;
+    }
+    return Operation{*op, std::move(*path)};
+  }
+
+  // The syscall name is the last word before the parenthesis, after the pid
+  // and timestamps strace may print.
+  auto head = line.subpiece(0, paren);
+  auto nameStart = head.rfind(' ');
+  auto op = parseOp(
+      nameStart == folly::StringPiece::npos ? head
+                                            : head.subpiece(nameStart + 1));
+  if (!op) {
+    return std::nullopt;
+  }
+  auto quote = line.find('"', paren);
+  if (quote == folly::StringPiece::npos) {
+    return std::nullopt;
+  }
+  auto endQuote = line.find('"', quote + 1);
+  if (endQuote == folly::StringPiece::npos) {
+    return std::nullopt;
+  }
+  auto path = rebasePath(line.subpiece(quote + 1, endQuote - quote - 1));
+  if (!path) {
+    return std::nullopt;
+  }
+  return Operation{*op, std::move(*path)};
+}
+
+std::vector<Operation> loadTrace() {
+  std::string contents;
+  if (!folly::readFile(FLAGS_trace.c_str(), contents)) {
+    folly::throwSystemError("failed to read ", FLAGS_trace);
+  }
+  std::vector<folly::StringPiece> lines;
+  folly::split('\n', contents, lines);
+  std::vector<Operation> operations;
+  for (auto line : lines) {
+    if (auto operation = parseLine(line)) {
+      operations.push_back(std::move(*operation));
+    }
+  }
+  return operations;
+}
+
+/** Returns false if the operation failed, which traces commonly contain. */
+bool runOperation(int mountFd, const Operation& operation, char* buffer) {
+  auto path = operation.path.empty() ? "." : operation.path.c_str();
+  struct stat st;
+  switch (operation.op) {
+    case Op::STAT:
+      return ::fstatat(mountFd, path, &st, 0) == 0;
+    case Op::LSTAT:
+      return ::fstatat(mountFd, path, &st, AT_SYMLINK_NOFOLLOW) == 0;
+    case Op::OPEN:
+    case Op::READ: {
+      int fd = ::openat(mountFd, path, O_RDONLY | O_CLOEXEC);
+      if (fd < 0) {
+        return false;
+      }
+      bool success = true;
+      if (operation.op == Op::READ) {
+        success = ::read(fd, buffer, FLAGS_read_size) >= 0;
+      }
+      ::close(fd);
+      return success;
+    }
+    case Op::READDIR: {
+      int fd = ::openat(mountFd, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+      if (fd < 0) {
+        return false;
+      }
+      auto* dir = ::fdopendir(fd);
+      if (!dir) {
+        ::close(fd);
+        return false;
+      }
+      while (::readdir(dir) != nullptr) {
+      }
+      ::closedir(dir);
+      return true;
+    }
+    case Op::READLINK:
+      return ::readlinkat(mountFd, path, buffer, FLAGS_read_size) >= 0;
+  }
+  return false;
+}
+
+struct OpStats {
+  std::vector<uint64_t> latenciesNs;
+  uint64_t errors{0};
+};
+
+uint64_t percentile(const std::vector<uint64_t>& sorted, double p) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  auto index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1));
+  return sorted[index];
+}
+
+std::unique_ptr<EdenServiceAsyncClient> connect(
+    folly::EventBase* eventBase,
+    const AbsolutePath& mount) {
+  auto socketPath = mount + ".eden/socket"_relpath;
+  auto socket = folly::AsyncSocket::newSocket(
+      eventBase, folly::SocketAddress::makeFromPath(socketPath.stringPiece()));
+  auto channel =
+      apache::thrift::HeaderClientChannel::newChannel(std::move(socket));
+  return std::make_unique<EdenServiceAsyncClient>(std::move(channel));
+}
+
+std::map<std::string, int64_t> getCounters(
+    EdenServiceAsyncClient& client,
+    folly::EventBase* eventBase) {
+  auto counters = client.semifuture_getRegexCounters(FLAGS_counter_regex)
+                      .via(eventBase)
+                      .get();
+  return {counters.begin(), counters.end()};
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  folly::init(&argc, &argv);
+  if (FLAGS_mount.empty() || FLAGS_trace.empty()) {
+    fprintf(stderr, "Both --mount and --trace are required\n");
+    return 1;
+  }
+  AbsolutePath mount{FLAGS_mount};
+
+  auto operations = loadTrace();
+  if (operations.empty()) {
+    fprintf(stderr, "No operations found in %s\n", FLAGS_trace.c_str());
+    return 1;
+  }
+
+  auto evbThread = folly::EventBaseThread();
+  auto* eventBase = evbThread.getEventBase();
+  auto client = connect(eventBase, mount);
+  auto countersBefore = getCounters(*client, eventBase);
+
+  int mountFd = ::open(mount.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  folly::checkUnixError(mountFd, "failed to open ", mount);
+
+  folly::test::Barrier gate{FLAGS_threads + 1};
+  std::mutex statsMutex;
+  std::array<OpStats, kOpNames.size()> stats;
+
+  auto thread = [&](uint64_t index) {
+    std::array<OpStats, kOpNames.size()> threadStats;
+    std::vector<char> buffer(FLAGS_read_size);
+    gate.wait();
+    for (uint64_t r = 0; r < FLAGS_repeat; ++r) {
+      // Each thread replays every --threads-th operation, in trace order.
+      for (size_t i = index; i < operations.size(); i += FLAGS_threads) {
+        const auto& operation = operations[i];
+        auto start = Clock::now();
+        bool success = runOperation(mountFd, operation, buffer.data());
+        auto elapsed = Clock::now() - start;
+        auto& opStats = threadStats[static_cast<size_t>(operation.op)];
+        opStats.latenciesNs.push_back(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                .count());
+        opStats.errors += !success;
+      }
+    }
+
+    std::lock_guard guard{statsMutex};
+    for (size_t op = 0; op < stats.size(); ++op) {
+      auto& from = threadStats[op];
+      stats[op].latenciesNs.insert(
+          stats[op].latenciesNs.end(),
+          from.latenciesNs.begin(),
+          from.latenciesNs.end());
+      stats[op].errors += from.errors;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(FLAGS_threads);
+  for (uint64_t t = 0; t < FLAGS_threads; ++t) {
+    threads.emplace_back(thread, t);
+  }
+  gate.wait();
+  auto start = Clock::now();
+  for (auto& t : threads) {
+    t.join();
+  }
+  std::chrono::duration<double> elapsed = Clock::now() - start;
+  ::close(mountFd);
+
+  auto countersAfter = getCounters(*client, eventBase);
+
+  folly::dynamic baseline = nullptr;
+  if (!FLAGS_baseline.empty()) {
+    std::string contents;
+    if (!folly::readFile(FLAGS_baseline.c_str(), contents)) {
+      folly::throwSystemError("failed to read ", FLAGS_baseline);
+    }
+    baseline = folly::parseJson(contents);
+  }
+
+  folly::dynamic results = folly::dynamic::object;
+  folly::dynamic ops = folly::dynamic::object;
+  printf(
+      "%" PRIu64 " operations in %.3f s across %" PRIu64 " threads\n",
+      static_cast<uint64_t>(operations.size() * FLAGS_repeat),
+      elapsed.count(),
+      FLAGS_threads);
+  printf(
+      "%-9s %9s %7s %10s %10s %10s %10s %10s\n",
+      "op",
+      "count",
+      "errors",
+      "p50 ns",
+      "p90 ns",
+      "p99 ns",
+      "p99.9 ns",
+      "max ns");
+  for (size_t op = 0; op < stats.size(); ++op) {
+    auto& opStats = stats[op];
+    if (opStats.latenciesNs.empty()) {
+      continue;
+    }
+    auto& sorted = opStats.latenciesNs;
+    std::sort(sorted.begin(), sorted.end());
+    folly::dynamic result = folly::dynamic::object("count", sorted.size())(
+        "errors", opStats.errors)("p50", percentile(sorted, 0.5))(
+        "p90", percentile(sorted, 0.9))("p99", percentile(sorted, 0.99))(
+        "p999", percentile(sorted, 0.999))("max", sorted.back());
+    printf(
+        "%-9s %9zu %7" PRIu64 " %10" PRIu64 " %10" PRIu64 " %10" PRIu64
+        " %10" PRIu64 " %10" PRIu64 "\n",
+        kOpNames[op],
+        sorted.size(),
+        opStats.errors,
+        percentile(sorted, 0.5),
+        percentile(sorted, 0.9),
+        percentile(sorted, 0.99),
+        percentile(sorted, 0.999),
+        sorted.back());
+    if (baseline.isObject()) {
+      auto* before = baseline["ops"].get_ptr(kOpNames[op]);
+      if (before) {
+        auto change = [&](const char* key) {
+          return 100.0 *
+              (result[key].asDouble() / (*before)[key].asDouble() - 1);
+        };
+        printf(
+            "%-9s p50 %+.1f%%, p99 %+.1f%% compared to the baseline\n",
+            "",
+            change("p50"),
+            change("p99"));
+      }
+    }
+    ops[kOpNames[op]] = std::move(result);
+  }
+  results["ops"] = std::move(ops);
+
+  folly::dynamic counters = folly::dynamic::object;
+  printf("\ncounter changes:\n");
+  for (const auto& [name, after] : countersAfter) {
+    auto it = countersBefore.find(name);
+    auto delta = after - (it == countersBefore.end() ? 0 : it->second);
+    if (delta == 0) {
+      continue;
+    }
+    counters[name] = delta;
+    std::string comparison;
+    if (baseline.isObject()) {
+      auto* before = baseline["counters"].get_ptr(name);
+      comparison = folly::to<std::string>(
+          " (baseline: ", before ? before->asInt() : 0, ")");
+    }
+    printf("  %s: %" PRId64 "%s\n", name.c_str(), delta, comparison.c_str());
+  }
+  results["counters"] = std::move(counters);
+
+  if (!FLAGS_json.empty()) {
+    if (!folly::writeFile(folly::toPrettyJson(results), FLAGS_json.c_str())) {
+      folly::throwSystemError("failed to write ", FLAGS_json);
+    }
+  }
+  return 0;
+}
+
+#else
+
+int main() {
+  return 1;
+}
+
+#endif
@@ -493,6 +493,7 @@ class FilesystemChecker:
     def _load_inode_info(self, inode_number: int) -> InodeInfo:
         self._update_max_inode_number(inode_number)
         dir_data = None
+        dir_version = overlay_mod.OverlayHeader.VERSION_1
         stat_info = None
         error = None
         try:
@@ -501,6 +502,7 @@ class FilesystemChecker:
                 header = self.overlay.read_header(f)
                 if header.type == overlay_mod.OverlayHeader.TYPE_DIR:
                     dir_data = f.read()
+                    dir_version = header.version
                     type = InodeType.DIR
                 elif header.type == overlay_mod.OverlayHeader.TYPE_FILE:
                     type = InodeType.FILE
@@ -516,7 +518,9 @@ class FilesystemChecker:
         children: List[ChildInfo] = []
         if dir_data is not None:
             try:
-                parsed_data = self.overlay.parse_dir_inode_data(dir_data)
+                parsed_data = self.overlay.parse_dir_inode_data(
+                    dir_data, dir_version
+                )
                 dir_entries = parsed_data.entries
             except Exception as ex:
                 type = InodeType.DIR_ERROR
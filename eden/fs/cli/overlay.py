@@ -47,6 +47,8 @@ class InodeLookupError(Exception):
 class OverlayHeader:
     LENGTH = 64
     VERSION_1 = 1
+    # Directories encoded as a CompactOverlayDir rather than with thrift.
+    VERSION_COMPACT_DIR = 2
 
     TYPE_DIR = b"OVDR"
     TYPE_FILE = b"OVFL"
@@ -79,7 +81,9 @@ class OverlayHeader:
             raise InvalidOverlayFile(
                 "overlay file is too short to contain a header: length={len(data)}"
             )
-        if version != cls.VERSION_1:
+        if version != cls.VERSION_1 and not (
+            header_id == cls.TYPE_DIR and version == cls.VERSION_COMPACT_DIR
+        ):
             raise InvalidOverlayFile(f"unsupported overlay file version {version}")
 
         return OverlayHeader(
@@ -220,9 +224,82 @@ class Overlay:
             header = self.check_header(f, inode_number, OverlayHeader.TYPE_DIR)
             data = f.read()
 
-        return (header, self.parse_dir_inode_data(data))
+        return (header, self.parse_dir_inode_data(data, header.version))
+
+    def parse_compact_dir_inode_data(self, data: bytes) -> OverlayDir:
+        """Parse a directory encoded as a CompactOverlayDir, whose format is
+        described in eden/fs/inodes/fscatalog/CompactOverlayDir.h."""
+        entry_count, pool_size = struct.unpack_from("<II", data, 0)
+        pool_start = 8 + entry_count * 32
+        records_start = pool_start + pool_size
+        if len(data) < records_start:
+            raise InvalidOverlayFile("compact overlay directory is truncated")
+
+        entries = {}
+        for i in range(entry_count):
+            (
+                name_offset,
+                name_length,
+                hash_offset,
+                hash_length,
+                mode,
+                _reserved,
+                inode_number,
+            ) = struct.unpack_from("<IIIIIIQ", data, 8 + i * 32)
+            name_start = pool_start + name_offset
+            hash_start = pool_start + hash_offset
+            name = data[name_start : name_start + name_length].decode(
+                "utf-8", errors="surrogateescape"
+            )
+            entries[name] = OverlayEntry(
+                mode=mode,
+                inodeNumber=inode_number,
+                hash=data[hash_start : hash_start + hash_length] or None,
+            )
+
+        # Apply the records appended since, ignoring one cut short.
+        offset = records_start
+        try:
+            while offset < len(data):
+                record_type = data[offset]
+                offset += 1
+                if record_type == 1:
+                    mode, inode_number = struct.unpack_from("<IQ", data, offset)
+                    offset += 12
+                (name_length,) = struct.unpack_from("<I", data, offset)
+                offset += 4
+                name_data = data[offset : offset + name_length]
+                if len(name_data) != name_length:
+                    break
+                offset += name_length
+                name = name_data.decode("utf-8", errors="surrogateescape")
+                if record_type == 2:
+                    entries.pop(name, None)
+                    continue
+                if record_type != 1:
+                    raise InvalidOverlayFile(
+                        f"unknown compact overlay directory record {record_type}"
+                    )
+                (hash_length,) = struct.unpack_from("<I", data, offset)
+                offset += 4
+                hash_data = data[offset : offset + hash_length]
+                if len(hash_data) != hash_length:
+                    break
+                offset += hash_length
+                entries[name] = OverlayEntry(
+                    mode=mode, inodeNumber=inode_number, hash=hash_data or None
+                )
+        except struct.error:
+            pass
+
+        return OverlayDir(entries=entries)
+
+    def parse_dir_inode_data(
+        self, data: bytes, version: int = OverlayHeader.VERSION_1
+    ) -> OverlayDir:
+        if version == OverlayHeader.VERSION_COMPACT_DIR:
+            return self.parse_compact_dir_inode_data(data)
 
-    def parse_dir_inode_data(self, data: bytes) -> OverlayDir:
         from thrift.protocol import TCompactProtocol
         from thrift.util import Serializer
 
@@ -418,6 +418,8 @@ class LocalStoreCmd(Subcmd):
             ("tree", True),
             ("treemeta", True),
             ("hgcommit2tree", True),
+            ("globresult", True),
+            ("treedigest", True),
             ("scsproxyhash", True),
             ("hgproxyhash", False),
         ]
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/config/CacheEvictionPolicy.h"
+
+namespace facebook::eden {
+
+namespace {
+
+constexpr auto cacheEvictionPolicyStr = [] {
+  std::array<folly::StringPiece, 3> mapping{};
+  mapping[folly::to_underlying(CacheEvictionPolicy::LRU)] = "LRU";
+  mapping[folly::to_underlying(CacheEvictionPolicy::SLRU)] = "SLRU";
+  mapping[folly::to_underlying(CacheEvictionPolicy::TinyLFU)] = "TinyLFU";
+  return mapping;
+}();
+
+}
+
+folly::Expected<CacheEvictionPolicy, std::string>
+FieldConverter<CacheEvictionPolicy>::fromString(
+    folly::StringPiece value,
+    const std::map<std::string, std::string>& /*unused*/) const {
+  for (auto policy = 0ul; policy < cacheEvictionPolicyStr.size(); policy++) {
+    if (value.equals(
+            cacheEvictionPolicyStr[policy], folly::AsciiCaseInsensitive())) {
+      return static_cast<CacheEvictionPolicy>(policy);
+    }
+  }
+
+  return folly::makeUnexpected(fmt::format(
+      "Failed to convert value '{}' to a CacheEvictionPolicy.", value));
+}
+
+std::string FieldConverter<CacheEvictionPolicy>::toDebugString(
+    CacheEvictionPolicy value) const {
+  return cacheEvictionPolicyStr[folly::to_underlying(value)].str();
+}
+
+} // namespace facebook::eden
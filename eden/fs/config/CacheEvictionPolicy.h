@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include "eden/fs/config/FieldConverter.h"
+
+namespace facebook::eden {
+
+/**
+ * The admission and eviction policy used by an in-memory ObjectCache.
+ */
+enum class CacheEvictionPolicy {
+  /**
+   * A single least-recently-used queue.
+   */
+  LRU,
+
+  /**
+   * Segmented LRU: new objects enter a probationary segment and are promoted
+   * to a protected segment once they are hit again. A scan of one-shot objects
+   * only churns the probationary segment.
+   */
+  SLRU,
+
+  /**
+   * W-TinyLFU: a small LRU admission window in front of a segmented LRU. An
+   * object leaving the window only displaces an object of the main segment
+   * if a frequency sketch estimates that it has been accessed more often.
+   */
+  TinyLFU,
+};
+
+template <>
+class FieldConverter<CacheEvictionPolicy> {
+ public:
+  folly::Expected<CacheEvictionPolicy, std::string> fromString(
+      folly::StringPiece value,
+      const std::map<std::string, std::string>& convData) const;
+
+  std::string toDebugString(CacheEvictionPolicy value) const;
+};
+
+} // namespace facebook::eden
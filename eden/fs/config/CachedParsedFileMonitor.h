@@ -21,7 +21,8 @@ namespace facebook::eden {
  * created by parsing a data file. The object can be accessed through
  * "getFileContents()". "getFileContents()" will reload and parse the file as
  * necessary. A throttle is applied to limit change checks to at
- * most to 1 per throttleDuration.
+ * most to 1 per throttleDuration. Given a FileChangeWatcher, the cached value
+ * is returned without any syscall until the file may have changed.
  *
  * The parsed value T is deduced through the Parser. The Parser and T must
  * be default constructable and provide following:
@@ -35,8 +36,9 @@ class CachedParsedFileMonitor {
  public:
   CachedParsedFileMonitor(
       AbsolutePathPiece filePath,
-      std::chrono::milliseconds throttleDuration)
-      : fileChangeMonitor_{filePath, throttleDuration} {}
+      std::chrono::milliseconds throttleDuration,
+      std::shared_ptr<FileChangeWatcher> watcher = nullptr)
+      : fileChangeMonitor_{filePath, throttleDuration, std::move(watcher)} {}
 
   /**
    * Get the parsed file contents.  If the file (or its path) has changed we
@@ -37,13 +37,18 @@ constexpr folly::StringPiece kMountProtocol{"protocol"};
 constexpr folly::StringPiece kRequireUtf8Path{"require-utf8-path"};
 constexpr folly::StringPiece kEnableTreeOverlay{"enable-tree-overlay"};
 constexpr folly::StringPiece kUseWriteBackCache{"use-write-back-cache"};
+constexpr folly::StringPiece kEnableFilter{"enable-filter"};
 #ifdef _WIN32
 constexpr folly::StringPiece kRepoGuid{"guid"};
 #endif
 
 // Files of interest in the client directory.
 const RelativePathPiece kSnapshotFile{"SNAPSHOT"};
+const RelativePathPiece kCheckoutCheckpointFile{"CHECKOUT_CHECKPOINT"};
+const RelativePathPiece kJournalLogFile{"journal.log"};
 const RelativePathPiece kOverlayDir{"local"};
+const RelativePathPiece kFilterFile{"filter"};
+const RelativePathPiece kFiltersDir{"filters"};
 
 // File holding mapping of client directories.
 const RelativePathPiece kClientDirectoryMap{"config.json"};
@@ -278,10 +283,26 @@ AbsolutePath CheckoutConfig::getSnapshotPath() const {
   return clientDirectory_ + kSnapshotFile;
 }
 
+AbsolutePath CheckoutConfig::getCheckoutCheckpointPath() const {
+  return clientDirectory_ + kCheckoutCheckpointFile;
+}
+
+AbsolutePath CheckoutConfig::getJournalLogPath() const {
+  return clientDirectory_ + kJournalLogFile;
+}
+
 AbsolutePath CheckoutConfig::getOverlayPath() const {
   return clientDirectory_ + kOverlayDir;
 }
 
+AbsolutePath CheckoutConfig::getFilterPath() const {
+  return clientDirectory_ + kFilterFile;
+}
+
+AbsolutePath CheckoutConfig::getFiltersDir() const {
+  return clientDirectory_ + kFiltersDir;
+}
+
 std::unique_ptr<CheckoutConfig> CheckoutConfig::loadFromClientDirectory(
     AbsolutePathPiece mountPath,
     AbsolutePathPiece clientDirectory) {
@@ -322,6 +343,9 @@ std::unique_ptr<CheckoutConfig> CheckoutConfig::loadFromClientDirectory(
   auto useWriteBackCache = repository->get_as<bool>(kUseWriteBackCache.str());
   config->useWriteBackCache_ = useWriteBackCache.value_or(false);
 
+  auto enableFilter = repository->get_as<bool>(kEnableFilter.str());
+  config->enableFilter_ = enableFilter.value_or(false);
+
 #ifdef _WIN32
   auto guid = repository->get_as<std::string>(kRepoGuid.str());
   config->repoGuid_ = guid ? Guid{*guid} : Guid::generate();
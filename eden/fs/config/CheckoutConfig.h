@@ -82,6 +82,15 @@ class CheckoutConfig {
   /** @return Path to the directory where overlay information is stored. */
   AbsolutePath getOverlayPath() const;
 
+  /**
+   * Path to the filter of a filtered mount, in the format PathFilter::parse()
+   * accepts. A missing file shows everything.
+   */
+  AbsolutePath getFilterPath() const;
+
+  /** Path to the directory holding every filter the mount has used. */
+  AbsolutePath getFiltersDir() const;
+
   /**
    * Get the repository type.
    *
@@ -119,6 +128,15 @@ class CheckoutConfig {
   /** Path to the file where the current commit ID is stored */
   AbsolutePath getSnapshotPath() const;
 
+  /**
+   * Path to the file where a checkout records the directories it finished
+   * updating, for an interrupted checkout to be resumed from.
+   */
+  AbsolutePath getCheckoutCheckpointPath() const;
+
+  /** Path to the file where the journal is persisted across restarts. */
+  AbsolutePath getJournalLogPath() const;
+
   /** Path to the client directory */
   const AbsolutePath& getClientDirectory() const;
 
@@ -142,6 +160,14 @@ class CheckoutConfig {
     return useWriteBackCache_;
   }
 
+  /**
+   * Whether the paths that the filter at getFilterPath() hides are pruned
+   * from the trees of this mount.
+   */
+  bool getEnableFilter() const {
+    return enableFilter_;
+  }
+
 #ifdef _WIN32
   /** Guid for that repository */
   Guid getRepoGuid() const {
@@ -163,6 +189,8 @@ class CheckoutConfig {
 
   bool useWriteBackCache_{false};
 
+  bool enableFilter_{false};
+
 #ifdef _WIN32
   Guid repoGuid_;
 #endif
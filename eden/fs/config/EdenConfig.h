@@ -19,9 +19,11 @@
 #include <thrift/lib/cpp/concurrency/ThreadManager.h>
 
 #include "common/rust/shed/hostcaps/hostcaps.h"
+#include "eden/fs/config/CacheEvictionPolicy.h"
 #include "eden/fs/config/ConfigSetting.h"
 #include "eden/fs/config/FileChangeMonitor.h"
 #include "eden/fs/config/HgObjectIdFormat.h"
+#include "eden/fs/config/LocalStoreCompression.h"
 #include "eden/fs/config/MountProtocol.h"
 #include "eden/fs/eden-config.h"
 #include "eden/fs/model/Hash.h"
@@ -243,6 +245,15 @@ class EdenConfig : private ConfigSettingManager {
       false,
       this};
 
+  /**
+   * On hosts with several NUMA nodes, pin the FUSE worker threads and the
+   * backing store import threads to the CPUs of one node each, spreading
+   * every pool evenly across the nodes. The blobs an import thread
+   * allocates are then local to its node. Takes effect for new mounts and
+   * backing stores.
+   */
+  ConfigSetting<bool> numaPinThreads{"core:numa-pin-threads", false, this};
+
   // [config]
 
   /**
@@ -293,6 +304,98 @@ class EdenConfig : private ConfigSettingManager {
       std::chrono::seconds(30),
       this};
 
+  /**
+   * The number of expensive Thrift requests, like globs, prefetches and
+   * status, that run at once before the others queue, so that they don't
+   * starve the cheap ones. Zero to not limit them. Read at startup.
+   */
+  ConfigSetting<uint32_t> thriftMaxExpensiveRequests{
+      "thrift:max-expensive-requests",
+      0,
+      this};
+
+  /**
+   * The number of expensive Thrift requests a single client process may have
+   * running at once before its other ones queue. Zero for no limit.
+   */
+  ConfigSetting<uint32_t> thriftMaxExpensiveRequestsPerPid{
+      "thrift:max-expensive-requests-per-pid",
+      0,
+      this};
+
+  /**
+   * The number of queued expensive Thrift requests above which the newest
+   * one of the client with the most queued fails with EAGAIN. Zero to never
+   * fail them.
+   */
+  ConfigSetting<uint32_t> thriftMaxQueuedExpensiveRequests{
+      "thrift:max-queued-expensive-requests",
+      0,
+      this};
+
+  /**
+   * The number of files an ensureMaterialized call materializes at once. The
+   * others wait for their turn instead of all fetching their blob together.
+   * Zero to not limit them.
+   */
+  ConfigSetting<uint32_t> ensureMaterializedMaxInFlightFiles{
+      "thrift:ensure-materialized-max-in-flight-files",
+      256,
+      this};
+
+  /**
+   * Upper bounds of the walks of the streaming debug endpoints
+   * (streamInodeStatus and streamScmTree). Clients may lower them but not
+   * raise them.
+   */
+  ConfigSetting<size_t> thriftDebugWalkMaxDepth{
+      "thrift:debug-walk-max-depth",
+      4096,
+      this};
+  ConfigSetting<size_t> thriftDebugWalkMaxEntries{
+      "thrift:debug-walk-max-entries",
+      10'000'000,
+      this};
+
+  /**
+   * Number of tree fetches preloadDirectories issues together. The backing
+   * store groups queued fetches into batched imports of up to
+   * hg:import-batch-size-tree trees.
+   */
+  ConfigSetting<size_t> thriftPreloadBatchSize{
+      "thrift:preload-batch-size",
+      1024,
+      this};
+
+  /**
+   * Number of trees after which a preloadDirectories call fails.
+   */
+  ConfigSetting<size_t> thriftPreloadMaxTrees{
+      "thrift:preload-max-trees",
+      1'000'000,
+      this};
+
+  /**
+   * How often streamCheckoutProgress publishes the progress of a checkout.
+   */
+  ConfigSetting<std::chrono::nanoseconds> thriftCheckoutProgressInterval{
+      "thrift:checkout-progress-interval",
+      std::chrono::seconds(1),
+      this};
+
+  /**
+   * Number of paths in each chunk of a streamScmStatus stream, and number of
+   * chunks that wait to be sent before the diff pauses.
+   */
+  ConfigSetting<size_t> thriftStatusStreamChunkSize{
+      "thrift:status-stream-chunk-size",
+      1024,
+      this};
+  ConfigSetting<size_t> thriftStatusStreamMaxPendingChunks{
+      "thrift:status-stream-max-pending-chunks",
+      8,
+      this};
+
   // [ssl]
 
   ConfigSetting<AbsolutePath> clientCertificate{
@@ -317,6 +420,86 @@ class EdenConfig : private ConfigSettingManager {
       10,
       this};
 
+  /**
+   * How many Tree fetches checkout may keep in flight ahead of the
+   * directories it is updating. Zero disables prefetching Trees for
+   * checkout.
+   */
+  ConfigSetting<uint64_t> checkoutTreePrefetchConcurrency{
+      "mount:checkout-tree-prefetch-concurrency",
+      64,
+      this};
+
+  /**
+   * Whether to reuse the last status of a mount while its journal and the
+   * user and system ignore files are unchanged.
+   */
+  ConfigSetting<bool> enableStatusCache{
+      "mount:enable-status-cache",
+      true,
+      this};
+
+  /**
+   * When the resident memory of EdenFS exceeds this many bytes, unload
+   * unreferenced inodes that have not been accessed recently until it drops
+   * back below. Zero disables unloading under memory pressure.
+   */
+  ConfigSetting<uint64_t> memoryPressureUnloadRssBytes{
+      "mount:memory-pressure-unload-rss-bytes",
+      0,
+      this};
+
+  /**
+   * How often to compare resident memory against
+   * mount:memory-pressure-unload-rss-bytes. At most one unload pass runs per
+   * interval, which keeps it from competing with filesystem requests.
+   */
+  ConfigSetting<std::chrono::nanoseconds> memoryPressureUnloadInterval{
+      "mount:memory-pressure-unload-interval",
+      std::chrono::minutes(1),
+      this};
+
+  /**
+   * The first unload pass under memory pressure only unloads inodes that
+   * were not accessed for this long. Each following pass, while memory is
+   * still above the mark, halves the age down to
+   * mount:memory-pressure-unload-min-age.
+   */
+  ConfigSetting<std::chrono::nanoseconds> memoryPressureUnloadMaxAge{
+      "mount:memory-pressure-unload-max-age",
+      std::chrono::hours(1),
+      this};
+
+  /**
+   * Inodes accessed more recently than this are never unloaded because of
+   * memory pressure.
+   */
+  ConfigSetting<std::chrono::nanoseconds> memoryPressureUnloadMinAge{
+      "mount:memory-pressure-unload-min-age",
+      std::chrono::minutes(5),
+      this};
+
+  // [journal]
+
+  /**
+   * Minimum time between two notifications of the journal subscribers, such
+   * as streamJournalChanged clients. The changes recorded in between are
+   * reported by a single notification. 0 notifies subscribers synchronously
+   * on every change.
+   */
+  ConfigSetting<std::chrono::nanoseconds> journalNotificationInterval{
+      "journal:notification-interval",
+      std::chrono::milliseconds(10),
+      this};
+
+  /**
+   * Whether to keep the journal of each mount in a log on disk, so that
+   * clients such as Watchman keep getting the files changed since a position
+   * from before an edenfs restart or graceful takeover, rather than a
+   * truncated result. Takes effect when a mount starts.
+   */
+  ConfigSetting<bool> journalPersist{"journal:persist", false, this};
+
   // [store]
 
   /**
@@ -356,6 +539,247 @@ class EdenConfig : private ConfigSettingManager {
       20'000'000,
       this};
 
+  ConfigSetting<uint64_t> localStoreGlobResultSizeLimit{
+      "store:globresult-size-limit",
+      1'000'000'000,
+      this};
+
+  ConfigSetting<uint64_t> localStoreTreeDigestSizeLimit{
+      "store:treedigest-size-limit",
+      100'000'000,
+      this};
+
+  ConfigSetting<uint64_t> localStoreBlobChunkSizeLimit{
+      "store:blobchunk-size-limit",
+      15'000'000'000,
+      this};
+
+  ConfigSetting<uint64_t> localStoreAccessModelSizeLimit{
+      "store:accessmodel-size-limit",
+      100'000'000,
+      this};
+
+  /**
+   * Number of values of the small-value key spaces, such as proxy hashes and
+   * blob metadata, kept in memory in front of the on-disk local store. Zero
+   * disables the in-memory tier. Only read at startup.
+   */
+  ConfigSetting<uint64_t> localStoreHotTierEntries{
+      "store:hot-tier-entries",
+      200'000,
+      this};
+
+  /**
+   * Number of writes to the ephemeral small-value key spaces that the
+   * in-memory tier accumulates before writing them to disk in the
+   * background. Only read at startup.
+   */
+  ConfigSetting<uint64_t> localStoreWriteBackBatchSize{
+      "store:write-back-batch-size",
+      4096,
+      this};
+
+  /**
+   * Bytes of imported objects that may wait to be written to the local store
+   * on its writer thread. Objects imported while the queue is full are not
+   * cached. With 0, imported objects are written inline. Only read at
+   * startup.
+   */
+  ConfigSetting<uint64_t> localStoreWriteQueueBytes{
+      "store:write-queue-bytes",
+      64 * 1024 * 1024,
+      this};
+
+  /**
+   * Bits of the bloom filters of the trees and of the blobs stored in the
+   * local store, which let lookups of missing objects skip it. About 8 bits
+   * per stored object keep the false positives around 2%. Zero disables the
+   * filters. Only read at startup.
+   */
+  ConfigSetting<uint64_t> localStoreMissingFilterBits{
+      "store:missing-object-filter-bits",
+      64 * 1024 * 1024,
+      this};
+
+  /**
+   * Number of the trees and of the blobs recently found missing from the
+   * local store that are remembered, so that their next lookups skip it.
+   * Only read at startup.
+   */
+  ConfigSetting<uint64_t> localStoreMissingObjectEntries{
+      "store:missing-object-entries",
+      10'000,
+      this};
+
+  /**
+   * Blobs of at least this many bytes are stored in the local store as
+   * content-defined chunks, which versions of a file that differ by a few
+   * bytes share. Zero stores all blobs whole. Only read at startup.
+   */
+  ConfigSetting<uint64_t> localStoreChunkedBlobMinSize{
+      "store:chunked-blob-min-size",
+      0,
+      this};
+
+  /**
+   * Blobs of at least this many bytes are stored as files of a directory
+   * next to the local store, rather than in it, and reading them maps their
+   * file. Takes precedence over store:chunked-blob-min-size. Zero disables
+   * the blob file cache. Only read at startup, and not supported on Windows.
+   */
+  ConfigSetting<uint64_t> blobFileCacheMinSize{
+      "store:blob-file-cache-min-size",
+      0,
+      this};
+
+  /**
+   * Size, in bytes, above which the least recently used files of the blob
+   * file cache are removed. Only read at startup.
+   */
+  ConfigSetting<uint64_t> blobFileCacheMaxSize{
+      "store:blob-file-cache-max-size",
+      10ull * 1024 * 1024 * 1024,
+      this};
+
+  /**
+   * Blobs of at least this many bytes fetched from the backing store are
+   * copied into sealed memfds, which debugGetScmBlobFd hands to clients
+   * without copying the contents again. Zero keeps all blobs in private
+   * memory. Only supported on Linux.
+   */
+  ConfigSetting<uint64_t> memfdBlobMinSize{
+      "store:memfd-blob-min-size",
+      0,
+      this};
+
+  /**
+   * Size, in bits, of the sketch tracking the recent accesses to each
+   * ephemeral key space of the RocksDB local store, per epoch. When a key
+   * space is over its limit, the entries that were not accessed since the
+   * previous collection are evicted until it is back under it. Zero makes
+   * the collection clear the whole key space instead. Only read at startup.
+   */
+  ConfigSetting<uint64_t> localStoreGcAccessSketchBits{
+      "store:gc-access-sketch-bits",
+      8 * 1024 * 1024,
+      this};
+
+  /**
+   * How long the local store garbage collection pauses between two slices of
+   * a key space.
+   */
+  ConfigSetting<std::chrono::nanoseconds> localStoreGcSliceInterval{
+      "store:gc-slice-interval",
+      std::chrono::seconds(1),
+      this};
+
+  /*
+   * The following settings control the connections of the SQLite local
+   * store. They are only read when the local store is opened.
+   */
+
+  /**
+   * Number of read-only connections serving the lookups of the SQLite local
+   * store, which then don't wait on each other nor on writes. Zero serves
+   * them from the single connection used for writes.
+   */
+  ConfigSetting<uint64_t> sqliteReadConnections{
+      "store:sqlite-read-connections",
+      4,
+      this};
+
+  /**
+   * Maximum number of bytes of the SQLite local store read through
+   * memory-mapped I/O by each connection. Zero keeps the SQLite default.
+   */
+  ConfigSetting<uint64_t> sqliteMmapSize{"store:sqlite-mmap-size", 0, this};
+
+  /**
+   * Size of the page cache of each connection of the SQLite local store, in
+   * KiB. Zero keeps the SQLite default.
+   */
+  ConfigSetting<uint64_t> sqliteCacheSizeKB{
+      "store:sqlite-cache-size-kb",
+      0,
+      this};
+
+  /*
+   * The following settings control how the RocksDB local store lays out the
+   * column family of each key space, depending on its StorageProfile. They
+   * are only read when the local store is opened.
+   */
+
+  /**
+   * Whether values of large-value key spaces, such as blobs, are kept in blob
+   * files rather than in the LSM tree, so that compactions don't rewrite
+   * them. Disabling it leaves the existing blob files readable.
+   */
+  ConfigSetting<bool> rocksDbEnableBlobFiles{
+      "store:rocksdb-enable-blob-files",
+      true,
+      this};
+
+  /**
+   * Values smaller than this are kept in the LSM tree even when blob files
+   * are enabled.
+   */
+  ConfigSetting<uint64_t> rocksDbMinBlobSize{
+      "store:rocksdb-min-blob-size",
+      4096,
+      this};
+
+  ConfigSetting<LocalStoreCompression> rocksDbBlobCompression{
+      "store:rocksdb-blob-compression",
+      LocalStoreCompression::LZ4,
+      this};
+
+  /**
+   * Bits per key of the Ribbon filters of small-value key spaces. Zero uses
+   * the bloom filters the other key spaces use.
+   */
+  ConfigSetting<double> rocksDbSmallValueFilterBitsPerKey{
+      "store:rocksdb-small-value-filter-bits-per-key",
+      10.0,
+      this};
+
+  /**
+   * Small values are mostly hashes, which don't compress.
+   */
+  ConfigSetting<LocalStoreCompression> rocksDbSmallValueCompression{
+      "store:rocksdb-small-value-compression",
+      LocalStoreCompression::None,
+      this};
+
+  /**
+   * Number of entries of the memory-mapped blob metadata index that is
+   * consulted before the local store. Each entry takes 88 bytes on disk. Zero
+   * disables the index. Only read at startup, and not supported on Windows.
+   */
+  ConfigSetting<uint64_t> blobMetadataIndexEntries{
+      "store:blob-metadata-index-entries",
+      0,
+      this};
+
+  /**
+   * Number of blob metadata and of tree digest entries kept in memory, split
+   * evenly between the repositories. The mounts of a repository share its
+   * entries.
+   */
+  ConfigSetting<uint64_t> metadataCacheEntries{
+      "store:metadata-cache-entries",
+      1'000'000,
+      this};
+
+  /**
+   * Number of threads hashing the contents of the blobs fetched from the
+   * backing store. Zero hashes blobs on the thread that fetched them. Only
+   * read at startup.
+   */
+  ConfigSetting<uint64_t> blobHashingThreads{
+      "store:blob-hashing-threads",
+      0,
+      this};
+
   /**
    * The minimum duration between logging occurrences of failed HgProxyHash
    * loads.
@@ -374,6 +798,43 @@ class EdenConfig : private ConfigSettingManager {
       100000,
       this};
 
+  /**
+   * A process fetching more than this many objects from the backing store
+   * within fetch-heavy-window is considered heavy, and its fetches are
+   * treated according to fetch-heavy-deprioritize and fetch-heavy-rate-limit.
+   * 0 disables this policy.
+   */
+  ConfigSetting<uint64_t> fetchHeavyWindowThreshold{
+      "store:fetch-heavy-window-threshold",
+      10000,
+      this};
+
+  /**
+   * The sliding window over which the fetch rate of processes is measured.
+   */
+  ConfigSetting<std::chrono::nanoseconds> fetchHeavyWindow{
+      "store:fetch-heavy-window",
+      std::chrono::seconds{10},
+      this};
+
+  /**
+   * Whether the fetches of heavy processes are imported with the lowest
+   * priority class, after the interactive ones.
+   */
+  ConfigSetting<bool> fetchHeavyDeprioritize{
+      "store:fetch-heavy-deprioritize",
+      true,
+      this};
+
+  /**
+   * The maximum number of backing store fetches per second of a heavy
+   * process, the others are delayed. 0 means no limit.
+   */
+  ConfigSetting<uint64_t> fetchHeavyRateLimit{
+      "store:fetch-heavy-rate-limit",
+      0,
+      this};
+
   /**
    * The maximum number of tree prefetch operations to allow in parallel for any
    * checkout.  Setting this to 0 will disable prefetch operations.
@@ -433,6 +894,57 @@ class EdenConfig : private ConfigSettingManager {
    */
   ConfigSetting<uint32_t> maximumFuseRequests{"fuse:max-requests", 1000, this};
 
+  /**
+   * Whether each FUSE worker thread should read requests from its own clone of
+   * the /dev/fuse descriptor (FUSE_DEV_IOC_CLONE) instead of all of them
+   * sharing one. This reduces contention in the kernel on mounts with many
+   * worker threads. Falls back to sharing the descriptor if cloning fails.
+   */
+  ConfigSetting<bool> fuseCloneDevicePerThread{
+      "fuse:clone-device-per-thread",
+      false,
+      this};
+
+  /**
+   * Whether to ask the kernel to list directories with FUSE_READDIRPLUS,
+   * which returns the attributes of the entries along with their names, in
+   * place of a FUSE_LOOKUP per entry. This loads the inodes of the entries
+   * listed, so it is only worth it when the entries are looked up anyway,
+   * which the kernel guesses from the lookups following its previous
+   * listings (FUSE_READDIRPLUS_AUTO).
+   */
+  ConfigSetting<bool> fuseReaddirplus{"fuse:readdirplus", false, this};
+
+  /**
+   * The number of threads sending queued invalidations to the kernel. Each
+   * invalidation can block on a kernel inode lock, so large checkouts finish
+   * invalidating sooner with several.
+   */
+  ConfigSetting<uint32_t> fuseInvalidationThreads{
+      "fuse:invalidation-threads",
+      1,
+      this};
+
+  /**
+   * The number of FUSE requests handled at once before the others queue in
+   * EdenFS, metadata requests ahead of reads and directory listings, and the
+   * processes with the fewest requests in flight first. Zero to never queue.
+   */
+  ConfigSetting<uint32_t> fuseOverloadMaxInFlightRequests{
+      "fuse:overload-max-in-flight-requests",
+      0,
+      this};
+
+  /**
+   * The number of queued FUSE reads and directory listings above which the
+   * newest one of the process with the most queued fails with EAGAIN. Zero
+   * to never fail them.
+   */
+  ConfigSetting<uint32_t> fuseOverloadMaxQueuedBulkRequests{
+      "fuse:overload-max-queued-bulk-requests",
+      0,
+      this};
+
   // [nfs]
 
   /**
@@ -464,11 +976,57 @@ class EdenConfig : private ConfigSettingManager {
       1000,
       this};
 
+  /**
+   * Number of EventBase threads that read from and write to the NFS sockets.
+   * Each mount's connection is assigned one of them, round-robin. When 0, all
+   * the sockets share the main EventBase, which caps the combined NFS
+   * throughput of all the mounts at what a single thread can frame and write.
+   */
+  ConfigSetting<uint64_t> numNfsIoThreads{"nfs:num-io-threads", 0, this};
+
+  /**
+   * The number of NFS requests of a mount handled at once before the others
+   * queue, metadata requests ahead of reads and directory listings. Zero to
+   * never queue.
+   */
+  ConfigSetting<uint32_t> nfsOverloadMaxInFlightRequests{
+      "nfs:overload-max-in-flight-requests",
+      0,
+      this};
+
+  /**
+   * The number of queued NFS reads and directory listings above which the
+   * newest one is answered with NFS3ERR_JUKEBOX, for the client to retry it
+   * later. Zero to never shed them.
+   */
+  ConfigSetting<uint32_t> nfsOverloadMaxQueuedBulkRequests{
+      "nfs:overload-max-queued-bulk-requests",
+      0,
+      this};
+
   /**
    * Buffer size for read and writes requests. Default to 1 MiB.
    */
   ConfigSetting<uint32_t> nfsIoSize{"nfs:iosize", 1024 * 1024, this};
 
+  /**
+   * Bytes of UNSTABLE writes to a file buffered in memory, coalesced, before
+   * they are applied to the file. They are otherwise applied when the client
+   * COMMITs them, or before another request can observe them. Zero applies
+   * every write immediately.
+   */
+  ConfigSetting<uint64_t> nfsWriteGatherMaxBytes{
+      "nfs:write-gather-max-bytes",
+      8 * 1024 * 1024,
+      this};
+
+  /**
+   * Whether the NFS server also serves NFSv4.1, whose COMPOUND requests
+   * resolve a path or list a directory with its attributes in a single round
+   * trip. Only the operations reading the repository are supported.
+   */
+  ConfigSetting<bool> nfsEnableNfsv41{"nfs:enable-nfsv4.1", false, this};
+
   /**
    * Whether EdenFS NFS sockets should bind themself to unix sockets instead of
    * TCP ones.
@@ -535,6 +1093,17 @@ class EdenConfig : private ConfigSettingManager {
       1,
       this};
 
+  /**
+   * Controls the number of threads per mount handling file change
+   * notifications. Notifications on the same path, or on one of its
+   * ancestors or descendants, are still handled in the order they were
+   * received.
+   */
+  ConfigSetting<uint8_t> prjfsNumNotificationThreads{
+      "prjfs:num-notification-threads",
+      4,
+      this};
+
   /**
    * Not sure if a Windows behavior, or a ProjectedFS one, but symlinks
    * aren't created atomically, they start their life as a directory, and
@@ -576,6 +1145,27 @@ class EdenConfig : private ConfigSettingManager {
    */
   ConfigSetting<bool> useAuxMetadata{"hg:use-aux-metadata", true, this};
 
+  /**
+   * Whether the trees imported in a batch are fetched along with the size and
+   * SHA-1 of their files, which are then persisted in the LocalStore. This
+   * lets stat() on the entries of a freshly checked out directory be served
+   * without a metadata fetch per file.
+   */
+  ConfigSetting<bool> persistTreeAuxMetadata{
+      "hg:persist-tree-aux-metadata",
+      false,
+      this};
+
+  /**
+   * Whether importing a tree queues a low priority fetch of the size and
+   * SHA-1 of its files that didn't come along with it, so that the first
+   * stat() of these files doesn't have to fetch them one at a time.
+   */
+  ConfigSetting<bool> prefetchAuxMetadata{
+      "hg:prefetch-aux-metadata",
+      false,
+      this};
+
   /**
    * Which object ID format should the HgBackingStore use?
    */
@@ -597,6 +1187,15 @@ class EdenConfig : private ConfigSettingManager {
       false,
       this};
 
+  /**
+   * Number of proxy hashes of legacy 20-byte object IDs that are kept in
+   * memory once loaded from the local store. Only read at startup.
+   */
+  ConfigSetting<uint64_t> hgProxyHashCacheEntries{
+      "hg:proxy-hash-cache-entries",
+      100'000,
+      this};
+
   /**
    * Controls the number of blob or prefetch import requests we batch in
    * HgBackingStore
@@ -611,6 +1210,94 @@ class EdenConfig : private ConfigSettingManager {
       1,
       this};
 
+  /**
+   * When non-zero, blob and tree import batches adapt their size between 1
+   * and hg:import-batch-size(-tree): the size doubles while batches are full
+   * and imported within this latency, and halves when a batch takes longer.
+   */
+  ConfigSetting<std::chrono::nanoseconds> importBatchTargetLatency{
+      "hg:import-batch-target-latency",
+      std::chrono::nanoseconds::zero(),
+      this};
+
+  /**
+   * How long an import thread waits for more requests to arrive before
+   * importing a batch that is not full. Requests of the High priority class,
+   * which filesystem requests use, are never delayed. Zero disables it.
+   */
+  ConfigSetting<std::chrono::nanoseconds> importBatchLinger{
+      "hg:import-batch-linger",
+      std::chrono::nanoseconds::zero(),
+      this};
+
+  /**
+   * Within a priority class, import requests gain one unit of priority
+   * adjustment for every interval they spend waiting in the import queue, so
+   * that a steady stream of higher priority requests cannot starve them.
+   * Zero disables aging.
+   */
+  ConfigSetting<std::chrono::nanoseconds> importRequestAgingInterval{
+      "hg:import-request-aging-interval",
+      std::chrono::seconds(1),
+      this};
+
+  /**
+   * An import request that has been waiting for longer than this is served
+   * before requests of a higher priority class. Zero disables it.
+   */
+  ConfigSetting<std::chrono::nanoseconds> importRequestStarvationThreshold{
+      "hg:import-request-starvation-threshold",
+      std::chrono::seconds(30),
+      this};
+
+  /**
+   * When non-zero, the import requests of a priority class are served in
+   * deficit round-robin between the processes they are fetched for: each
+   * client in turn gets up to this many requests imported, so that one
+   * process prefetching a large directory doesn't delay the fetches of the
+   * others. Requests are ordered by priority only within a client. Zero
+   * serves the whole class in priority order.
+   */
+  ConfigSetting<uint32_t> importFairShareQuantum{
+      "hg:import-fair-share-quantum",
+      0,
+      this};
+
+  /**
+   * Once this many import batches in a row failed, or took longer than
+   * hg:degraded-backend-slow-fetch, the backing store is considered degraded:
+   * objects present locally are still served, but the others are not
+   * fetched, see hg:degraded-backend-fail-fast. Zero disables it.
+   */
+  ConfigSetting<uint32_t> degradedBackendFailureThreshold{
+      "hg:degraded-backend-failure-threshold",
+      5,
+      this};
+
+  ConfigSetting<std::chrono::nanoseconds> degradedBackendSlowFetch{
+      "hg:degraded-backend-slow-fetch",
+      std::chrono::seconds(20),
+      this};
+
+  /**
+   * While the backing store is degraded, a single fetch is let through once
+   * per this interval, to find out whether it recovered.
+   */
+  ConfigSetting<std::chrono::nanoseconds> degradedBackendCooldown{
+      "hg:degraded-backend-cooldown",
+      std::chrono::seconds(30),
+      this};
+
+  /**
+   * While the backing store is degraded, whether the fetches of the objects
+   * missing locally fail right away with EAGAIN, or are queued with a low
+   * priority instead.
+   */
+  ConfigSetting<bool> degradedBackendFailFast{
+      "hg:degraded-backend-fail-fast",
+      true,
+      this};
+
   // [backingstore]
 
   /**
@@ -637,6 +1324,22 @@ class EdenConfig : private ConfigSettingManager {
       "",
       this};
 
+  /**
+   * When above 1, structured log events are accumulated per thread and sent
+   * to scribe-cat in columnar batches of up to this many events, instead of
+   * one line per event.
+   */
+  ConfigSetting<size_t> scribeBatchSize{"telemetry:scribe-batch-size", 0, this};
+
+  /**
+   * The maximum time a structured log event waits in a batch before being
+   * sent to scribe-cat, when scribe-batch-size is set.
+   */
+  ConfigSetting<std::chrono::nanoseconds> scribeBatchInterval{
+      "telemetry:scribe-batch-interval",
+      std::chrono::seconds(1),
+      this};
+
   /**
    * Controls which paths eden will log data fetches for when this is set.
    * Fetches for any paths that match the regex will be logged.
@@ -700,6 +1403,16 @@ class EdenConfig : private ConfigSettingManager {
       std::vector<std::string>{},
       this};
 
+  /**
+   * How often to sample the phases of the in-flight filesystem requests into
+   * the ring buffer that getRequestSamples exports as folded stacks. 0
+   * disables the sampling.
+   */
+  ConfigSetting<std::chrono::nanoseconds> requestSampleInterval{
+      "telemetry:request-sample-interval",
+      std::chrono::milliseconds(10),
+      this};
+
   /**
    * Controls the capacity of the internal buffer for NFS Tracebus.
    */
@@ -734,10 +1447,41 @@ class EdenConfig : private ConfigSettingManager {
       100,
       this};
 
+  /**
+   * Controls whether the hot locks, like the InodeMap and TreeInode locks,
+   * record how long they are waited for and held. The results are exported as
+   * "lock.*" counters and by getLatencyHistograms.
+   */
+  ConfigSetting<bool> lockContentionStats{
+      "telemetry:lock-contention-stats",
+      false,
+      this};
+
+  /**
+   * How often to compute the expensive counters, like the per-mount inode
+   * and journal counters and the import request metrics. Scrapes return the
+   * values computed last. 0 computes them on every scrape instead.
+   */
+  ConfigSetting<std::chrono::nanoseconds> cachedCountersInterval{
+      "telemetry:cached-counters-interval",
+      std::chrono::seconds(5),
+      this};
+
+  /**
+   * When set, only the expensive counters whose name matches this regex are
+   * computed. The others read as 0.
+   */
+  ConfigSetting<std::optional<std::shared_ptr<RE2>>> cachedCountersFilter{
+      "telemetry:cached-counters-filter",
+      std::nullopt,
+      this};
+
   // [experimental]
 
   /**
-   * Controls whether interrupted checkouts can be resumed.
+   * Controls whether interrupted checkouts can be resumed. Checkouts then
+   * record the directories they finish updating, which a resumed checkout
+   * skips.
    */
   ConfigSetting<bool> allowResumeCheckout{
       "experimental:allow-resume-checkout",
@@ -794,6 +1538,61 @@ class EdenConfig : private ConfigSettingManager {
       16,
       this};
 
+  /**
+   * Number of independently locked shards the in-memory tree cache is split
+   * into. The cache size and minimum element count are divided between the
+   * shards. Only read at startup.
+   */
+  ConfigSetting<size_t> inMemoryTreeCacheShardCount{
+      "treecache:shard-count",
+      1,
+      this};
+
+  /**
+   * Which trees the in-memory tree cache evicts when full. One of LRU, SLRU or
+   * TinyLFU. Only read at startup.
+   */
+  ConfigSetting<CacheEvictionPolicy> inMemoryTreeCacheEvictionPolicy{
+      "treecache:eviction-policy",
+      CacheEvictionPolicy::LRU,
+      this};
+
+  // [blobcache]
+
+  /**
+   * Which blobs the in-memory blob cache evicts when full. One of LRU, SLRU or
+   * TinyLFU. SLRU and TinyLFU prevent a scan of blobs that are only read once,
+   * like a glob or grep over the repository, from evicting frequently read
+   * blobs. Only read at startup.
+   */
+  ConfigSetting<CacheEvictionPolicy> blobCacheEvictionPolicy{
+      "blobcache:eviction-policy",
+      CacheEvictionPolicy::LRU,
+      this};
+
+  /**
+   * Whether a blob is evicted from the in-memory blob cache as soon as a
+   * file has been read entirely, even if other readers asked to keep it.
+   * The kernel then serves the file from its page cache, so the blob would
+   * only take the same memory twice. Reading the file after the kernel
+   * dropped its pages reloads the blob from the local store.
+   */
+  ConfigSetting<bool> blobCacheReleaseFullyReadBlobs{
+      "blobcache:release-fully-read-blobs",
+      false,
+      this};
+
+  /**
+   * The maximum number of trees, and of blobs, whose ids are saved when
+   * EdenFS stops or hands its mounts over to a new process. The next process
+   * reloads them from the LocalStore into its in-memory caches in the
+   * background. 0 disables the snapshot.
+   */
+  ConfigSetting<size_t> cacheSnapshotEntries{
+      "store:cache-snapshot-entries",
+      0,
+      this};
+
   // [notifications]
 
   /**
@@ -844,6 +1643,24 @@ class EdenConfig : private ConfigSettingManager {
   ConfigSetting<uint64_t> maxLogFileSize{"log:max-file-size", 50000000, this};
   ConfigSetting<uint64_t> maxRotatedLogFiles{"log:num-rotated-logs", 3, this};
 
+  /**
+   * How much of EdenFS's output the monitor queues while the log file is slow
+   * to write, before dropping it. Zero to write the output synchronously,
+   * which blocks EdenFS once its output pipe fills.
+   */
+  ConfigSetting<uint64_t> maxBufferedLogBytes{
+      "log:max-buffered-bytes",
+      16 * 1024 * 1024,
+      this};
+
+  /**
+   * Whether the monitor gzips rotated log files.
+   */
+  ConfigSetting<bool> compressRotatedLogs{
+      "log:compress-rotated-logs",
+      false,
+      this};
+
   // [prefetch-profiles]
 
   /**
@@ -893,6 +1710,41 @@ class EdenConfig : private ConfigSettingManager {
       1500,
       this};
 
+  /**
+   * Whether to learn which files processes read after reading a given file,
+   * and prefetch them in the background the next time that file is read.
+   */
+  ConfigSetting<bool> enableLearnedPrefetch{
+      "prefetch-profiles:learned-prefetching-enabled",
+      false,
+      this};
+
+  /**
+   * The files a process reads without pausing for longer than this are
+   * learned as following the first of them.
+   */
+  ConfigSetting<std::chrono::nanoseconds> learnedPrefetchWindow{
+      "prefetch-profiles:learned-prefetch-window",
+      std::chrono::seconds(5),
+      this};
+
+  /**
+   * The maximum number of files remembered, and prefetched, after a file.
+   */
+  ConfigSetting<uint32_t> learnedPrefetchMaxFiles{
+      "prefetch-profiles:learned-prefetch-max-files",
+      300,
+      this};
+
+  /**
+   * The number of times a file must have been read, and followed by the
+   * same files in at least half of them, before those are prefetched.
+   */
+  ConfigSetting<uint32_t> learnedPrefetchMinSessions{
+      "prefetch-profiles:learned-prefetch-min-sessions",
+      2,
+      this};
+
   /**
    * DANGER: this option will put overlay into memory and skip persisting any
    * actual data to disk. This will guarantee to cause EdenFS corruption after
@@ -937,6 +1789,46 @@ class EdenConfig : private ConfigSettingManager {
       64 * 1024 * 1024,
       this};
 
+  /**
+   * Whether the overlay garbage collector should unlink the files of
+   * forgotten directories through io_uring, one submission per batch, rather
+   * than with one unlinkat(2) call per file. Falls back to unlinkat(2) if
+   * io_uring is unavailable. Only used by overlays that store file contents
+   * on disk, on Linux.
+   */
+  ConfigSetting<bool> overlayGCUseIoUring{
+      "overlay:gc-use-io-uring",
+      false,
+      this};
+
+  /**
+   * How many threads the overlay garbage collector uses to collect the
+   * subdirectories of forgotten directories. The threads only run while there
+   * is a backlog to collect.
+   */
+  ConfigSetting<uint32_t> overlayGCThreads{"overlay:gc-threads", 4, this};
+
+  /**
+   * Whether the overlay garbage collector runs at the lowest best-effort I/O
+   * priority, so that collecting large forgotten trees after a checkout does
+   * not slow down filesystem requests. Only used on Linux.
+   */
+  ConfigSetting<bool> overlayGCLowIOPriority{
+      "overlay:gc-low-io-priority",
+      true,
+      this};
+
+  /**
+   * Whether the memory mapping of the inode metadata table should be backed
+   * by transparent huge pages, to reduce TLB misses on overlays with many
+   * inodes. This is a hint that the filesystem holding the overlay may not
+   * honor. Only applies when the mount is opened.
+   */
+  ConfigSetting<bool> inodeTableHugePages{
+      "overlay:inode-table-huge-pages",
+      false,
+      this};
+
   // [clone]
 
   /**
@@ -956,11 +1848,25 @@ class EdenConfig : private ConfigSettingManager {
 
   /**
    * When FSCK is running, how often should we log about the number of scanned
-   * directories. This is the number of directories that are scanned in between
-   * logs.
+   * directories, or overlay inodes when checking an overlay. This is the number
+   * of directories or inodes that are scanned in between logs.
    */
   ConfigSetting<uint64_t> fsckLogFrequency{"fsck:log-frequency", 10000, this};
 
+  /**
+   * Number of threads reading the overlay when it is checked after an unclean
+   * shutdown.
+   */
+  ConfigSetting<uint32_t> fsckScanThreads{"fsck:scan-threads", 4, this};
+
+  /**
+   * If true, an overlay that wasn't shut down cleanly is checked in the
+   * background while its mount is served, instead of before. Inodes created
+   * during the check are numbered in a range reserved for it, and the errors
+   * it finds are repaired, synchronously, the next time the mount starts.
+   */
+  ConfigSetting<bool> lazyFsck{"fsck:lazy-fsck", false, this};
+
   // [glob]
 
   /**
@@ -974,6 +1880,26 @@ class EdenConfig : private ConfigSettingManager {
       true,
       this};
 
+  /**
+   * Whether the results of globs against source control trees should be
+   * remembered in the LocalStore, keyed by tree and pattern set, so that
+   * evaluating the same globs against the same trees again doesn't need to
+   * fetch and walk them.
+   */
+  ConfigSetting<bool> globUseResultCache{"glob:use-result-cache", false, this};
+
+  // [diff]
+
+  /**
+   * Maximum number of subdirectories of a source control tree that a diff
+   * compares concurrently. The others wait for one of these to complete. 0
+   * means no limit.
+   */
+  ConfigSetting<size_t> diffMaxSubtreeFanout{
+      "diff:max-subtree-fanout",
+      256,
+      this};
+
   // [facebook]
   // Facebook internal
 
@@ -88,6 +88,10 @@ FileChangeMonitor::checkIfUpdated(bool noThrottle) {
   // Update lastCheck - we use it for throttling
   lastCheck_ = std::chrono::steady_clock::now();
 
+  if (!mayHaveChanged()) {
+    return rslt;
+  }
+
   // If there was an open error last time around, we can by-pass stat because
   // the most likely scenario is for open to continue failing.
   // If there was no open error, proceed to do stat to check for file changes.
@@ -138,6 +142,29 @@ FileChangeMonitor::checkIfUpdated(bool noThrottle) {
   return rslt;
 }
 
+bool FileChangeMonitor::mayHaveChanged() {
+  if (!watcher_) {
+    return true;
+  }
+  if (!watch_ || !watch_->isActive()) {
+    // Watch the file again, for instance once its directory exists. The
+    // changes made before it is watched are found by stat'ing it.
+    watch_ = watcher_->watch(filePath_);
+    seenChanges_.reset();
+    if (!watch_) {
+      return true;
+    }
+  }
+  // Read the count before stat'ing the file, so that a change made while it
+  // is checked is noticed by the next check.
+  auto changes = watch_->getChangeCount();
+  if (seenChanges_ == changes) {
+    return false;
+  }
+  seenChanges_ = changes;
+  return true;
+}
+
 bool FileChangeMonitor::isChanged() {
   struct stat currentStat;
   int prevStatErrno{statErrno_};
@@ -11,8 +11,10 @@
 #include <sys/stat.h>
 #include <chrono>
 #include <functional>
+#include <memory>
 #include <optional>
 
+#include "eden/fs/config/FileChangeWatcher.h"
 #include "eden/fs/utils/PathFuncs.h"
 
 namespace facebook::eden {
@@ -66,6 +68,9 @@ FileChangeReason hasFileChanged(
  *
  * FileChangeMonitor performs checks on demand. The throttleDuration setting
  * can further limit resource usage (to a maximum of 1 check/throttleDuration).
+ * Given a FileChangeWatcher, the checks don't stat the file until the watcher
+ * notices that it may have changed, and fall back to stat'ing it when it
+ * can't be watched.
  *
  * FileChangeMonitor is not thread safe - users are responsible for locking as
  * necessary.
@@ -75,11 +80,15 @@ class FileChangeMonitor {
   /**
    * Construct a FileChangeMonitor for the provided filePath.
    * @param throttleDuration specifies minimum time between file stats.
+   * @param watcher if set, notifies the monitor of the changes of the file.
    */
   FileChangeMonitor(
       AbsolutePathPiece filePath,
-      std::chrono::milliseconds throttleDuration)
-      : filePath_{filePath}, throttleDuration_{throttleDuration} {
+      std::chrono::milliseconds throttleDuration,
+      std::shared_ptr<FileChangeWatcher> watcher = nullptr)
+      : filePath_{filePath},
+        throttleDuration_{throttleDuration},
+        watcher_{std::move(watcher)} {
     resetToForceChange();
   }
 
@@ -152,6 +161,12 @@ class FileChangeMonitor {
    */
   bool isChanged();
 
+  /**
+   * Whether the watcher noticed a possible change since the last check, or
+   * the file can't be watched. Starts watching the file if it isn't yet.
+   */
+  bool mayHaveChanged();
+
   /**
    * Reset to base state. The next call to isChanged will return true
    * (this requires throttle to NOT activate). Useful during initialization and
@@ -165,6 +180,8 @@ class FileChangeMonitor {
 
     statErrno_ = 0;
     openErrno_ = 0;
+    watch_.reset();
+    seenChanges_.reset();
     // Set lastCheck in past so throttle does not apply.
     lastCheck_ = std::chrono::steady_clock::now() - throttleDuration_ -
         std::chrono::seconds{1};
@@ -176,6 +193,11 @@ class FileChangeMonitor {
   int openErrno_{0};
   std::chrono::milliseconds throttleDuration_;
   std::chrono::steady_clock::time_point lastCheck_;
+  std::shared_ptr<FileChangeWatcher> watcher_;
+  /** Shared by the copies of the monitor, which each track seenChanges_. */
+  std::shared_ptr<FileChangeWatcher::Watch> watch_;
+  /** The change count of watch_ when the file was last checked. */
+  std::optional<uint64_t> seenChanges_;
 };
 
 } // namespace facebook::eden
@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/config/FileChangeWatcher.h"
+
+#include <folly/FileUtil.h>
+#include <folly/String.h>
+#include <folly/logging/xlog.h>
+#include <folly/system/ThreadName.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <array>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#endif
+
+namespace facebook::eden {
+
+#ifdef __linux__
+
+namespace {
+/** The changes of a directory that may change one of its files. */
+constexpr uint32_t kFileEvents = IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE |
+    IN_DELETE | IN_MODIFY | IN_MOVED_FROM | IN_MOVED_TO;
+/** The changes after which the directory isn't watched anymore. */
+constexpr uint32_t kDirectoryEvents =
+    IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED;
+} // namespace
+
+std::shared_ptr<FileChangeWatcher> FileChangeWatcher::create() {
+  int inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotify == -1) {
+    XLOG(WARN) << "unable to watch files for changes: "
+               << folly::errnoStr(errno);
+    return nullptr;
+  }
+  folly::File inotifyFile{inotify, /*ownsFd=*/true};
+  int stopEvent = eventfd(0, EFD_CLOEXEC);
+  if (stopEvent == -1) {
+    XLOG(WARN) << "unable to watch files for changes: "
+               << folly::errnoStr(errno);
+    return nullptr;
+  }
+  return std::shared_ptr<FileChangeWatcher>{new FileChangeWatcher{
+      std::move(inotifyFile), folly::File{stopEvent, /*ownsFd=*/true}}};
+}
+
+FileChangeWatcher::FileChangeWatcher(folly::File inotify, folly::File stopEvent)
+    : inotify_{std::move(inotify)}, stopEvent_{std::move(stopEvent)} {
+  thread_ = std::thread{[this] {
+    folly::setThreadName("FileWatcher");
+    run();
+  }};
+}
+
+FileChangeWatcher::~FileChangeWatcher() {
+  uint64_t one = 1;
+  XCHECK_NE(-1, folly::writeNoInt(stopEvent_.fd(), &one, sizeof(one)))
+      << "failed to stop the file change watcher: " << folly::errnoStr(errno);
+  thread_.join();
+
+  // Let the files still watched be polled.
+  for (auto& [wd, directory] : *directories_.wlock()) {
+    for (auto& [name, weakWatch] : directory.files) {
+      if (auto watch = weakWatch.lock()) {
+        watch->active_.store(false, std::memory_order_release);
+        watch->changed();
+      }
+    }
+  }
+}
+
+std::shared_ptr<FileChangeWatcher::Watch> FileChangeWatcher::watch(
+    AbsolutePathPiece path) {
+  struct stat st;
+  if (lstat(path.c_str(), &st) == 0 && S_ISLNK(st.st_mode)) {
+    return nullptr;
+  }
+
+  auto directories = directories_.wlock();
+  // Watching a directory again returns its existing watch descriptor.
+  int wd = inotify_add_watch(
+      inotify_.fd(),
+      path.dirname().copy().c_str(),
+      kFileEvents | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR);
+  if (wd == -1) {
+    XLOG(DBG3) << "unable to watch " << path
+               << " for changes: " << folly::errnoStr(errno);
+    return nullptr;
+  }
+
+  auto& files = (*directories)[wd].files;
+  files.erase(
+      std::remove_if(
+          files.begin(),
+          files.end(),
+          [](const auto& file) { return file.second.expired(); }),
+      files.end());
+  auto watch = std::make_shared<Watch>();
+  files.emplace_back(path.basename().asString(), watch);
+  return watch;
+}
+
+void FileChangeWatcher::run() {
+  // Large enough for many events, and aligned as inotify_event requires.
+  alignas(struct inotify_event) char buffer[16 * 1024];
+  while (true) {
+    std::array<struct pollfd, 2> fds{{
+        {inotify_.fd(), POLLIN, 0},
+        {stopEvent_.fd(), POLLIN, 0},
+    }};
+    if (poll(fds.data(), fds.size(), -1) == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      XLOG(ERR) << "error waiting for file changes: " << folly::errnoStr(errno);
+      return;
+    }
+    if (fds[1].revents) {
+      return;
+    }
+
+    auto size = folly::readNoInt(inotify_.fd(), buffer, sizeof(buffer));
+    if (size == -1) {
+      if (errno != EAGAIN) {
+        XLOG(ERR) << "error reading file changes: " << folly::errnoStr(errno);
+        return;
+      }
+      continue;
+    }
+    processEvents(buffer, size);
+  }
+}
+
+void FileChangeWatcher::processEvents(const char* buffer, size_t size) {
+  auto directories = directories_.wlock();
+  size_t offset = 0;
+  while (offset < size) {
+    auto* event =
+        reinterpret_cast<const struct inotify_event*>(buffer + offset);
+    offset += sizeof(struct inotify_event) + event->len;
+
+    if (event->mask & IN_Q_OVERFLOW) {
+      // Events were lost: any file may have changed.
+      for (auto& [wd, directory] : *directories) {
+        for (auto& [name, weakWatch] : directory.files) {
+          if (auto watch = weakWatch.lock()) {
+            watch->changed();
+          }
+        }
+      }
+      continue;
+    }
+
+    auto it = directories->find(event->wd);
+    if (it == directories->end()) {
+      continue;
+    }
+    auto& files = it->second.files;
+
+    if (event->mask & kDirectoryEvents) {
+      // The directory is gone, or its path doesn't lead to it anymore.
+      for (auto& [name, weakWatch] : files) {
+        if (auto watch = weakWatch.lock()) {
+          watch->active_.store(false, std::memory_order_release);
+          watch->changed();
+        }
+      }
+      if (!(event->mask & IN_IGNORED)) {
+        inotify_rm_watch(inotify_.fd(), event->wd);
+      }
+      directories->erase(it);
+      continue;
+    }
+
+    if (event->len == 0) {
+      continue;
+    }
+    folly::StringPiece name{event->name};
+    bool watched = false;
+    for (auto& [fileName, weakWatch] : files) {
+      if (fileName == name) {
+        if (auto watch = weakWatch.lock()) {
+          watch->changed();
+        }
+      }
+      watched = watched || !weakWatch.expired();
+    }
+    if (!watched) {
+      // Stop watching directories whose files aren't watched anymore.
+      inotify_rm_watch(inotify_.fd(), event->wd);
+      directories->erase(it);
+    }
+  }
+}
+
+#else
+
+std::shared_ptr<FileChangeWatcher> FileChangeWatcher::create() {
+  return nullptr;
+}
+
+FileChangeWatcher::FileChangeWatcher(folly::File inotify, folly::File stopEvent)
+    : inotify_{std::move(inotify)}, stopEvent_{std::move(stopEvent)} {}
+
+FileChangeWatcher::~FileChangeWatcher() = default;
+
+std::shared_ptr<FileChangeWatcher::Watch> FileChangeWatcher::watch(
+    AbsolutePathPiece /*path*/) {
+  return nullptr;
+}
+
+void FileChangeWatcher::run() {}
+
+void FileChangeWatcher::processEvents(
+    const char* /*buffer*/,
+    size_t /*size*/) {}
+
+#endif
+
+} // namespace facebook::eden
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/File.h>
+#include <folly/Synchronized.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/**
+ * Notifies FileChangeMonitors of changes to their files, so that they don't
+ * have to stat them to find out that they didn't change.
+ *
+ * The directory of each file is watched with inotify, which also notices the
+ * file being created, removed or replaced by a rename. A background thread
+ * reads the notifications and counts the changes of each watched file, which
+ * the monitors compare to the count they last saw.
+ *
+ * The notifications are delivered asynchronously: a change is seen shortly
+ * after the write that made it, not necessarily by the next check.
+ */
+class FileChangeWatcher {
+ public:
+  /**
+   * The changes of a watched file. Destroying the Watch stops counting them.
+   */
+  class Watch {
+   public:
+    /**
+     * Grows whenever the file may have changed.
+     */
+    uint64_t getChangeCount() const {
+      return changes_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * False once the changes of the file can't be watched anymore, for
+     * instance because its directory was removed or renamed. The file must
+     * then be polled instead.
+     */
+    bool isActive() const {
+      return active_.load(std::memory_order_acquire);
+    }
+
+   private:
+    friend class FileChangeWatcher;
+
+    void changed() {
+      changes_.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    std::atomic<uint64_t> changes_{0};
+    std::atomic<bool> active_{true};
+  };
+
+  /**
+   * Returns nullptr on platforms without inotify, or if it can't be used.
+   */
+  static std::shared_ptr<FileChangeWatcher> create();
+
+  ~FileChangeWatcher();
+
+  FileChangeWatcher(const FileChangeWatcher&) = delete;
+  FileChangeWatcher& operator=(const FileChangeWatcher&) = delete;
+
+  /**
+   * Start watching a file. Returns nullptr if it can't be watched, for
+   * instance because its directory doesn't exist, or because it is a symlink,
+   * whose target may change without its directory being notified.
+   */
+  std::shared_ptr<Watch> watch(AbsolutePathPiece path);
+
+ private:
+  struct WatchedDirectory {
+    /** The names of the watched files of the directory, and their watches. */
+    std::vector<std::pair<std::string, std::weak_ptr<Watch>>> files;
+  };
+
+  FileChangeWatcher(folly::File inotify, folly::File stopEvent);
+
+  void run();
+  void processEvents(const char* buffer, size_t size);
+
+  folly::File inotify_;
+  folly::File stopEvent_;
+  /** Keyed by inotify watch descriptor. */
+  folly::Synchronized<std::unordered_map<int, WatchedDirectory>> directories_;
+  std::thread thread_;
+};
+
+} // namespace facebook::eden
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/config/LocalStoreCompression.h"
+
+namespace facebook::eden {
+
+namespace {
+
+constexpr auto localStoreCompressionStr = [] {
+  std::array<folly::StringPiece, 5> mapping{};
+  mapping[folly::to_underlying(LocalStoreCompression::None)] = "none";
+  mapping[folly::to_underlying(LocalStoreCompression::Snappy)] = "snappy";
+  mapping[folly::to_underlying(LocalStoreCompression::Zlib)] = "zlib";
+  mapping[folly::to_underlying(LocalStoreCompression::LZ4)] = "lz4";
+  mapping[folly::to_underlying(LocalStoreCompression::Zstd)] = "zstd";
+  return mapping;
+}();
+
+}
+
+folly::Expected<LocalStoreCompression, std::string>
+FieldConverter<LocalStoreCompression>::fromString(
+    folly::StringPiece value,
+    const std::map<std::string, std::string>& /*unused*/) const {
+  for (auto compression = 0ul; compression < localStoreCompressionStr.size();
+       compression++) {
+    if (value.equals(
+            localStoreCompressionStr[compression],
+            folly::AsciiCaseInsensitive())) {
+      return static_cast<LocalStoreCompression>(compression);
+    }
+  }
+
+  return folly::makeUnexpected(fmt::format(
+      "Failed to convert value '{}' to a LocalStoreCompression.", value));
+}
+
+std::string FieldConverter<LocalStoreCompression>::toDebugString(
+    LocalStoreCompression value) const {
+  return localStoreCompressionStr[folly::to_underlying(value)].str();
+}
+
+} // namespace facebook::eden
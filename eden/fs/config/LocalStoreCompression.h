@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include "eden/fs/config/FieldConverter.h"
+
+namespace facebook::eden {
+
+/**
+ * The compression algorithm applied to the values of a local store key
+ * space, on local stores that support it.
+ */
+enum class LocalStoreCompression {
+  None,
+  Snappy,
+  Zlib,
+  LZ4,
+  Zstd,
+};
+
+template <>
+class FieldConverter<LocalStoreCompression> {
+ public:
+  folly::Expected<LocalStoreCompression, std::string> fromString(
+      folly::StringPiece value,
+      const std::map<std::string, std::string>& convData) const;
+
+  std::string toDebugString(LocalStoreCompression value) const;
+};
+
+} // namespace facebook::eden
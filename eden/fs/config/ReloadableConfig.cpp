@@ -22,51 +22,56 @@ constexpr std::chrono::seconds kEdenConfigMinimumPollDuration{5};
 namespace facebook::eden {
 
 ReloadableConfig::ReloadableConfig(std::shared_ptr<const EdenConfig> config)
-    : state_{ConfigState{config}} {}
+    : config_{std::move(config)} {}
 ReloadableConfig::ReloadableConfig(
     std::shared_ptr<const EdenConfig> config,
     ConfigReloadBehavior reloadBehavior)
-    : state_{ConfigState{config}}, reloadBehavior_{reloadBehavior} {}
+    : config_{std::move(config)}, reloadBehavior_{reloadBehavior} {}
 
 ReloadableConfig::~ReloadableConfig() {}
 
 std::shared_ptr<const EdenConfig> ReloadableConfig::getEdenConfig(
     ConfigReloadBehavior reload) {
-  auto now = std::chrono::steady_clock::now();
-
   // TODO: Update this monitoring code to use FileChangeMonitor.
-  bool shouldReload;
   if (reloadBehavior_.has_value()) {
     reload = reloadBehavior_.value();
   }
   switch (reload) {
     case ConfigReloadBehavior::NoReload:
-      shouldReload = false;
       break;
-    case ConfigReloadBehavior::ForceReload:
-      shouldReload = true;
+    case ConfigReloadBehavior::ForceReload: {
+      std::lock_guard<std::mutex> lock{reloadMutex_};
+      reloadLocked(std::chrono::steady_clock::now());
       break;
+    }
     case ConfigReloadBehavior::AutoReload: {
+      auto now = std::chrono::steady_clock::now();
       auto lastCheck = std::chrono::steady_clock::time_point{
           std::chrono::steady_clock::duration{
               lastCheck_.load(std::memory_order_acquire)}};
-      shouldReload = now - lastCheck >= kEdenConfigMinimumPollDuration;
+      if (now - lastCheck < kEdenConfigMinimumPollDuration) {
+        break;
+      }
+      // Only one caller needs to check the config files, the others keep
+      // using the current snapshot rather than waiting for it.
+      std::unique_lock<std::mutex> lock{reloadMutex_, std::try_to_lock};
+      if (lock.owns_lock()) {
+        reloadLocked(now);
+      }
       break;
     }
     default:
       EDEN_BUG() << "Unexpected reload flag: " << enumValue(reload);
   }
 
-  if (!shouldReload) {
-    return state_.rlock()->config;
-  }
-
-  auto state = state_.wlock();
+  return config_.load(std::memory_order_acquire);
+}
 
+void ReloadableConfig::reloadLocked(std::chrono::steady_clock::time_point now) {
   // Throttle the updates when using ConfigReloadBehavior::AutoReload
   lastCheck_.store(now.time_since_epoch().count(), std::memory_order_release);
 
-  auto& config = state->config;
+  auto config = config_.load(std::memory_order_acquire);
 
   auto userConfigChanged = config->hasUserConfigFileChanged();
   auto systemConfigChanged = config->hasSystemConfigFileChanged();
@@ -82,9 +87,8 @@ std::shared_ptr<const EdenConfig> ReloadableConfig::getEdenConfig(
                  << systemConfigChanged.str();
       newConfig->loadSystemConfig();
     }
-    state->config = std::move(newConfig);
+    config_.store(std::move(newConfig), std::memory_order_release);
   }
-  return state->config;
 }
 
 } // namespace facebook::eden
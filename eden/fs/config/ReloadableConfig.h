@@ -7,10 +7,13 @@
 
 #pragma once
 
+#include <atomic>
 #include <chrono>
 #include <memory>
+#include <mutex>
+#include <optional>
 
-#include <folly/Synchronized.h>
+#include <folly/concurrency/AtomicSharedPtr.h>
 
 #include "eden/fs/config/gen-cpp2/eden_config_types.h"
 
@@ -35,18 +38,25 @@ class ReloadableConfig {
    *
    * The config data may be reloaded from disk depending on the value of the
    * reload parameter.
+   *
+   * The returned EdenConfig is an immutable snapshot: reloading publishes a
+   * new one. Unless a reload is forced, this never blocks. When the config
+   * files are due to be checked, a single caller checks them while the others
+   * keep using the current snapshot.
    */
   std::shared_ptr<const EdenConfig> getEdenConfig(
       ConfigReloadBehavior reload = ConfigReloadBehavior::AutoReload);
 
  private:
-  struct ConfigState {
-    explicit ConfigState(const std::shared_ptr<const EdenConfig>& config)
-        : config{config} {}
-    std::shared_ptr<const EdenConfig> config;
-  };
+  /**
+   * Reloads the config files that changed. Must be called with reloadMutex_
+   * held.
+   */
+  void reloadLocked(std::chrono::steady_clock::time_point now);
 
-  folly::Synchronized<ConfigState> state_;
+  folly::atomic_shared_ptr<const EdenConfig> config_;
+  // Serializes reloads, readers never take it.
+  std::mutex reloadMutex_;
   std::atomic<std::chrono::steady_clock::time_point::rep> lastCheck_{};
 
   // Reload behavior, when set this overrides reload behavior passed to methods
@@ -10,6 +10,7 @@
 #include <folly/experimental/TestUtil.h>
 #include <folly/portability/GTest.h>
 #include <folly/test/TestUtils.h>
+#include <thread>
 
 #include "eden/fs/config/FileChangeMonitor.h"
 #include "eden/fs/utils/FileUtils.h"
@@ -427,3 +428,65 @@ TEST_F(FileChangeMonitorTest, openFailFixTest) {
   EXPECT_EQ(fcp.getFileContents(), dataOne_);
 }
 #endif
+
+#ifdef __linux__
+namespace {
+/**
+ * The watcher notices changes asynchronously: check until it has.
+ */
+bool invokeOnceNoticed(FileChangeMonitor& fcm, MockFileChangeProcessor& fcp) {
+  for (int i = 0; i < 1000; ++i) {
+    if (fcm.invokeIfUpdated(std::ref(fcp))) {
+      return true;
+    }
+    /* sleep override */
+    std::this_thread::sleep_for(1ms);
+  }
+  return false;
+}
+} // namespace
+
+TEST_F(FileChangeMonitorTest, watchedFileChangesAreNoticed) {
+  auto watcher = FileChangeWatcher::create();
+  ASSERT_TRUE(watcher);
+  MockFileChangeProcessor fcp;
+  FileChangeMonitor fcm{pathOne_, 0s, watcher};
+
+  EXPECT_TRUE(fcm.invokeIfUpdated(std::ref(fcp)));
+  EXPECT_EQ(fcp.getFileContents(), dataOne_);
+  EXPECT_FALSE(fcm.invokeIfUpdated(std::ref(fcp)));
+
+  // Replaced by a rename, as editors do.
+  writeFileAtomic(pathOne_, dataTwo_).throwUnlessValue();
+  EXPECT_TRUE(invokeOnceNoticed(fcm, fcp));
+  EXPECT_EQ(fcp.getFileContents(), dataTwo_);
+
+  // Changes to other files of the directory aren't changes of this one.
+  writeFileAtomic(pathTwo_, dataOne_).throwUnlessValue();
+  EXPECT_FALSE(fcm.invokeIfUpdated(std::ref(fcp)));
+  EXPECT_EQ(fcp.getCallbackCount(), 2);
+}
+
+TEST_F(FileChangeMonitorTest, watchedDirectoryRemovalFallsBackToPolling) {
+  auto watcher = FileChangeWatcher::create();
+  ASSERT_TRUE(watcher);
+  MockFileChangeProcessor fcp;
+  auto dir = rootPath_ + "dir"_pc;
+  auto path = dir + "file"_pc;
+  ASSERT_EQ(0, mkdir(dir.c_str(), 0755));
+  writeFileAtomic(path, dataOne_).throwUnlessValue();
+  FileChangeMonitor fcm{path, 0s, watcher};
+  EXPECT_TRUE(fcm.invokeIfUpdated(std::ref(fcp)));
+
+  ASSERT_EQ(0, unlink(path.c_str()));
+  ASSERT_EQ(0, rmdir(dir.c_str()));
+  EXPECT_TRUE(invokeOnceNoticed(fcm, fcp));
+  EXPECT_EQ(fcp.getErrorNum(), ENOENT);
+
+  // The file is found again once the directory is recreated.
+  ASSERT_EQ(0, mkdir(dir.c_str(), 0755));
+  writeFileAtomic(path, dataTwo_).throwUnlessValue();
+  EXPECT_TRUE(invokeOnceNoticed(fcm, fcp));
+  EXPECT_EQ(fcp.getFileContents(), dataTwo_);
+}
+#endif
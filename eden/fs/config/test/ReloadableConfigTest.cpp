@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/config/ReloadableConfig.h"
+
+#include <fmt/format.h>
+#include <folly/experimental/TestUtil.h>
+#include <folly/portability/GTest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/utils/FileUtils.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+using folly::test::TemporaryDirectory;
+using namespace folly::literals::string_piece_literals;
+using namespace facebook::eden;
+using namespace facebook::eden::path_literals;
+
+namespace {
+
+class ReloadableConfigTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    rootTestDir_ = canonicalPath(tempDir_.path().string());
+    userConfigPath_ = rootTestDir_ + ".edenrc"_pc;
+    auto systemConfigDir = rootTestDir_ + "etc-eden"_pc;
+    ensureDirectoryExists(systemConfigDir);
+
+    writeFile(userConfigPath_, "[overlay]\nbuffered = false\n"_sp).value();
+    auto config = std::make_shared<EdenConfig>(
+        "username",
+        42,
+        rootTestDir_,
+        userConfigPath_,
+        systemConfigDir,
+        systemConfigDir + "edenfs.rc"_pc);
+    config->loadUserConfig();
+    initialConfig_ = config;
+  }
+
+  TemporaryDirectory tempDir_{"eden_reloadable_config_test_"};
+  AbsolutePath rootTestDir_;
+  AbsolutePath userConfigPath_;
+  std::shared_ptr<const EdenConfig> initialConfig_;
+};
+
+} // namespace
+
+TEST_F(ReloadableConfigTest, reload_publishes_a_new_snapshot) {
+  ReloadableConfig reloadable{initialConfig_};
+  auto before = reloadable.getEdenConfig(ConfigReloadBehavior::NoReload);
+  EXPECT_EQ(initialConfig_, before);
+  EXPECT_FALSE(before->overlayBuffered.getValue());
+
+  writeFile(userConfigPath_, "[overlay]\nbuffered = true # reloaded\n"_sp)
+      .value();
+  auto after = reloadable.getEdenConfig(ConfigReloadBehavior::ForceReload);
+  EXPECT_NE(before, after);
+  EXPECT_TRUE(after->overlayBuffered.getValue());
+
+  // Snapshots are immutable, the old one is unaffected.
+  EXPECT_FALSE(before->overlayBuffered.getValue());
+  EXPECT_EQ(after, reloadable.getEdenConfig(ConfigReloadBehavior::NoReload));
+}
+
+TEST_F(ReloadableConfigTest, readers_see_a_config_during_reloads) {
+  ReloadableConfig reloadable{initialConfig_};
+  std::atomic<bool> done{false};
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; ++i) {
+    readers.emplace_back([&] {
+      while (!done.load()) {
+        auto config = reloadable.getEdenConfig();
+        ASSERT_TRUE(config);
+      }
+    });
+  }
+
+  for (int i = 0; i < 20; ++i) {
+    writeFile(
+        userConfigPath_,
+        folly::StringPiece{fmt::format(
+            "[overlay]\nbuffered = {} # {}\n", i % 2 == 0, i)})
+        .value();
+    reloadable.getEdenConfig(ConfigReloadBehavior::ForceReload);
+  }
+  done.store(true);
+  for (auto& reader : readers) {
+    reader.join();
+  }
+}
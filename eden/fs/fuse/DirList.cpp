@@ -16,18 +16,39 @@ using folly::StringPiece;
 
 namespace facebook::eden {
 
-FuseDirList::FuseDirList(size_t maxSize)
-    : buf_(new char[maxSize]), end_(buf_.get() + maxSize), cur_(buf_.get()) {}
+namespace {
+size_t direntOffset(bool plus) {
+#ifdef __linux__
+  if (plus) {
+    return offsetof(fuse_direntplus, dirent);
+  }
+#else
+  XCHECK(!plus) << "FUSE_READDIRPLUS is only supported on Linux";
+#endif
+  return 0;
+}
+} // namespace
+
+FuseDirList::FuseDirList(size_t maxSize, bool plus)
+    : buf_(new char[maxSize]),
+      end_(buf_.get() + maxSize),
+      cur_(buf_.get()),
+      plus_(plus) {}
 
 bool FuseDirList::add(StringPiece name, ino_t inode, dtype_t type, off_t off) {
   const size_t avail = end_ - cur_;
-  const auto entLength = FUSE_NAME_OFFSET + name.size();
+  const auto prefix = direntOffset(plus_);
+  const auto entLength = prefix + FUSE_NAME_OFFSET + name.size();
   const auto fullSize = FUSE_DIRENT_ALIGN(entLength);
   if (fullSize > avail) {
     return false;
   }
 
-  fuse_dirent* const dirent = reinterpret_cast<fuse_dirent*>(cur_);
+  if (plus_) {
+    memset(cur_, 0, prefix);
+    entryOffsets_.push_back(cur_ - buf_.get());
+  }
+  fuse_dirent* const dirent = reinterpret_cast<fuse_dirent*>(cur_ + prefix);
   dirent->ino = inode;
   dirent->off = off;
   dirent->namelen = name.size();
@@ -43,6 +64,15 @@ bool FuseDirList::add(StringPiece name, ino_t inode, dtype_t type, off_t off) {
   return true;
 }
 
+#ifdef __linux__
+void FuseDirList::setEntryOut(size_t index, const fuse_entry_out& entryOut) {
+  XCHECK(plus_) << "Only FUSE_READDIRPLUS entries have a fuse_entry_out";
+  auto* direntplus =
+      reinterpret_cast<fuse_direntplus*>(buf_.get() + entryOffsets_.at(index));
+  direntplus->entry_out = entryOut;
+}
+#endif
+
 StringPiece FuseDirList::getBuf() const {
   return StringPiece(buf_.get(), cur_ - buf_.get());
 }
@@ -50,16 +80,17 @@ StringPiece FuseDirList::getBuf() const {
 std::vector<FuseDirList::ExtractedEntry> FuseDirList::extract() const {
   std::vector<FuseDirList::ExtractedEntry> result;
 
+  const auto prefix = direntOffset(plus_);
   char* p = buf_.get();
   while (p != cur_) {
-    auto entry = reinterpret_cast<fuse_dirent*>(p);
+    auto entry = reinterpret_cast<fuse_dirent*>(p + prefix);
     result.emplace_back(ExtractedEntry{
         std::string{entry->name, entry->name + entry->namelen},
         entry->ino,
         static_cast<dtype_t>(entry->type),
         static_cast<off_t>(entry->off)});
 
-    p += FUSE_DIRENT_ALIGN(FUSE_NAME_OFFSET + entry->namelen);
+    p += FUSE_DIRENT_ALIGN(prefix + FUSE_NAME_OFFSET + entry->namelen);
   }
   return result;
 }
@@ -9,7 +9,9 @@
 #include <folly/Range.h>
 #include <sys/stat.h>
 #include <memory>
+#include <vector>
 #include "eden/fs/utils/DirType.h"
+#include "eden/fs/utils/FsChannelTypes.h"
 
 namespace facebook::eden {
 
@@ -20,6 +22,9 @@ class FuseDirList {
   std::unique_ptr<char[]> buf_;
   char* end_;
   char* cur_;
+  bool plus_;
+  // Offset in buf_ of each entry, to fill in their fuse_entry_out.
+  std::vector<size_t> entryOffsets_;
 
  public:
   struct ExtractedEntry {
@@ -29,7 +34,13 @@ class FuseDirList {
     off_t offset;
   };
 
-  explicit FuseDirList(size_t maxSize);
+  /**
+   * When plus is true, the list is the reply of a FUSE_READDIRPLUS, and each
+   * of its entries is preceded by a fuse_entry_out. Those are zeroed until
+   * setEntryOut() fills them in, and the kernel does not create a dentry for
+   * an entry whose nodeid is 0.
+   */
+  explicit FuseDirList(size_t maxSize, bool plus = false);
 
   FuseDirList(const FuseDirList&) = delete;
   FuseDirList& operator=(const FuseDirList&) = delete;
@@ -42,6 +53,15 @@ class FuseDirList {
    */
   bool add(folly::StringPiece name, ino_t inode, dtype_t type, off_t off);
 
+#ifdef __linux__
+  /**
+   * Set the attributes of the index-th entry of a FUSE_READDIRPLUS list.
+   *
+   * A non-zero nodeid counts as a lookup by the kernel, which will forget it.
+   */
+  void setEntryOut(size_t index, const fuse_entry_out& entryOut);
+#endif
+
   folly::StringPiece getBuf() const;
 
   /**
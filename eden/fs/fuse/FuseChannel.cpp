@@ -10,13 +10,22 @@
 #include "eden/fs/fuse/FuseChannel.h"
 
 #include <boost/cast.hpp>
+#include <fcntl.h>
 #include <fmt/core.h>
+#include <folly/Exception.h>
+#include <folly/container/F14Map.h>
+#include <folly/container/F14Set.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
 #include <folly/executors/QueuedImmediateExecutor.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
 #include <folly/futures/Future.h>
 #include <folly/logging/xlog.h>
+#include <folly/stop_watch.h>
 #include <folly/system/ThreadName.h>
 #include <signal.h>
+#include <sys/ioctl.h>
 #include <chrono>
+#include <string_view>
 #include <type_traits>
 #include "eden/common/utils/Synchronized.h"
 #include "eden/fs/fuse/DirList.h"
@@ -25,6 +34,7 @@
 #include "eden/fs/telemetry/FsEventLogger.h"
 #include "eden/fs/utils/Bug.h"
 #include "eden/fs/utils/IDGen.h"
+#include "eden/fs/utils/NumaTopology.h"
 #include "eden/fs/utils/StaticAssert.h"
 #include "eden/fs/utils/SystemError.h"
 #include "eden/fs/utils/Thread.h"
@@ -217,6 +227,11 @@ static_assert(
 // This is the minimum size used by libfuse so we use it too!
 constexpr size_t MIN_BUFSIZE = 0x21000;
 
+// The largest number of pages the kernel may read in one FUSE_READ, 1 MiB,
+// instead of the default of 32. This is also the kernel's limit. Writes are
+// still bounded by max_write, which is derived from our read buffer size.
+constexpr uint16_t kMaxPagesPerRequest = 256;
+
 using Handler = ImmediateFuture<folly::Unit> (FuseChannel::*)(
     FuseRequestContext& request,
     const fuse_in_header& header,
@@ -479,7 +494,13 @@ constexpr auto kFuseHandlers = [] {
       &FuseStats::fallocate,
       Write};
 #ifdef __linux__
-  handlers[FUSE_READDIRPLUS] = {"FUSE_READDIRPLUS", Read};
+  handlers[FUSE_READDIRPLUS] = {
+      "FUSE_READDIRPLUS",
+      &FuseChannel::fuseReadDirPlus,
+      &argrender::readdir,
+      &FuseStats::readdirplus,
+      Read,
+      SamplingGroup::Three};
   handlers[FUSE_RENAME2] = {"FUSE_RENAME2", Write};
   handlers[FUSE_LSEEK] = {"FUSE_LSEEK"};
   handlers[FUSE_COPY_FILE_RANGE] = {"FUSE_COPY_FILE_RANGE", Write};
@@ -508,6 +529,20 @@ constexpr const HandlerEntry* lookupFuseHandlerEntry(uint32_t opcode) {
   return entry.name.empty() ? nullptr : &entry;
 }
 
+/**
+ * The short names of the opcodes that have a stat, indexed by opcode, for
+ * FsChannelLatencies.
+ */
+std::vector<std::string> getFuseLatencyOpNames() {
+  std::vector<std::string> names(std::size(kFuseHandlers));
+  for (size_t opcode = 0; opcode < std::size(kFuseHandlers); ++opcode) {
+    if (kFuseHandlers[opcode].stat) {
+      names[opcode] = kFuseHandlers[opcode].getShortName();
+    }
+  }
+  return names;
+}
+
 constexpr std::pair<uint32_t, const char*> kCapsLabels[] = {
     {FUSE_ASYNC_READ, "ASYNC_READ"},
     {FUSE_POSIX_LOCKS, "POSIX_LOCKS"},
@@ -610,6 +645,27 @@ SamplingGroup fuseOpcodeSamplingGroup(uint32_t opcode) {
   return entry ? entry->samplingGroup : SamplingGroup::DropAll;
 }
 
+/**
+ * How the overload controller treats a request, or nullopt for the requests
+ * that are never held back: forgets get no reply and free memory.
+ */
+std::optional<FsChannelOverloadController::RequestKind> overloadRequestKind(
+    uint32_t opcode) {
+  switch (opcode) {
+    case FUSE_FORGET:
+    case FUSE_BATCH_FORGET:
+      return std::nullopt;
+    case FUSE_READ:
+    case FUSE_READDIR:
+#ifdef __linux__
+    case FUSE_READDIRPLUS:
+#endif
+      return FsChannelOverloadController::RequestKind::Bulk;
+    default:
+      return FsChannelOverloadController::RequestKind::Metadata;
+  }
+}
+
 } // namespace
 
 StringPiece fuseOpcodeName(uint32_t opcode) {
@@ -695,14 +751,17 @@ std::ostream& operator<<(
             << ")";
 }
 
-void FuseChannel::replyError(const fuse_in_header& request, int errorCode) {
+void FuseChannel::replyError(
+    int fuseDevice,
+    const fuse_in_header& request,
+    int errorCode) {
   fuse_out_header err;
   err.len = sizeof(err);
   err.error = -errorCode;
   err.unique = request.unique;
   XLOG(DBG7) << "replyError unique=" << err.unique << " error=" << errorCode
              << " " << folly::errnoStr(errorCode);
-  auto res = write(fuseDevice_.fd(), &err, sizeof(err));
+  auto res = write(fuseDevice, &err, sizeof(err));
   if (res != sizeof(err)) {
     if (res < 0) {
       throwSystemError("replyError: error writing to fuse device");
@@ -713,6 +772,7 @@ void FuseChannel::replyError(const fuse_in_header& request, int errorCode) {
 }
 
 void FuseChannel::sendReply(
+    int fuseDevice,
     const fuse_in_header& request,
     folly::fbvector<iovec>&& vec) const {
   fuse_out_header out;
@@ -721,10 +781,11 @@ void FuseChannel::sendReply(
 
   vec.insert(vec.begin(), make_iovec(out));
 
-  sendRawReply(vec.data(), vec.size());
+  sendRawReply(fuseDevice, vec.data(), vec.size());
 }
 
 void FuseChannel::sendReply(
+    int fuseDevice,
     const fuse_in_header& request,
     const folly::IOBuf& buf) const {
   fuse_out_header out;
@@ -736,10 +797,11 @@ void FuseChannel::sendReply(
   vec.push_back(make_iovec(out));
   buf.appendToIov(&vec);
 
-  sendRawReply(vec.data(), vec.size());
+  sendRawReply(fuseDevice, vec.data(), vec.size());
 }
 
 void FuseChannel::sendReply(
+    int fuseDevice,
     const fuse_in_header& request,
     folly::ByteRange bytes) const {
   fuse_out_header out;
@@ -752,10 +814,13 @@ void FuseChannel::sendReply(
   iov[1].iov_base = const_cast<uint8_t*>(bytes.data());
   iov[1].iov_len = bytes.size();
 
-  sendRawReply(iov.data(), iov.size());
+  sendRawReply(fuseDevice, iov.data(), iov.size());
 }
 
-void FuseChannel::sendRawReply(const iovec iov[], size_t count) const {
+void FuseChannel::sendRawReply(
+    int fuseDevice,
+    const iovec iov[],
+    size_t count) const {
   // Ensure that the length is set correctly
   XDCHECK_EQ(iov[0].iov_len, sizeof(fuse_out_header));
   const auto header = reinterpret_cast<fuse_out_header*>(iov[0].iov_base);
@@ -764,7 +829,7 @@ void FuseChannel::sendRawReply(const iovec iov[], size_t count) const {
     header->len += iov[i].iov_len;
   }
 
-  const auto res = writev(fuseDevice_.fd(), iov, count);
+  const auto res = writev(fuseDevice, iov, count);
   const int err = errno;
   XLOG(DBG7) << "sendRawReply: unique=" << header->unique
              << " header->len=" << header->len << " wrote=" << res;
@@ -795,7 +860,12 @@ FuseChannel::FuseChannel(
     CaseSensitivity caseSensitive,
     bool requireUtf8Path,
     int32_t maximumBackgroundRequests,
-    bool useWriteBackCache)
+    bool useWriteBackCache,
+    bool cloneDevicePerThread,
+    size_t numInvalidationThreads,
+    bool pinThreadsToNumaNodes,
+    bool useReaddirplus,
+    FsChannelOverloadController::Config overloadConfig)
     : bufferSize_(std::max(size_t(getpagesize()) + 0x1000, MIN_BUFSIZE)),
       numThreads_(numThreads),
       dispatcher_(std::move(dispatcher)),
@@ -807,14 +877,27 @@ FuseChannel::FuseChannel(
       requireUtf8Path_{requireUtf8Path},
       maximumBackgroundRequests_{maximumBackgroundRequests},
       useWriteBackCache_{useWriteBackCache},
+      cloneDevicePerThread_{cloneDevicePerThread},
+      pinThreadsToNumaNodes_{pinThreadsToNumaNodes},
+      useReaddirplus_{useReaddirplus},
       fuseDevice_(std::move(fuseDevice)),
+      numInvalidationThreads_(std::max<size_t>(numInvalidationThreads, 1)),
       processAccessLog_(std::move(processNameCache)),
+      overloadController_(
+          std::make_shared<FsChannelOverloadController>(overloadConfig)),
+      latencies_(std::make_shared<FsChannelLatencies>(
+          "fuse",
+          mountPath.asString(),
+          getFuseLatencyOpNames())),
       traceDetailedArguments_(std::make_shared<std::atomic<size_t>>(0)),
       traceBus_(TraceBus<FuseTraceEvent>::create(
           "FuseTrace" + mountPath.asString(),
           kTraceBusCapacity)) {
   XCHECK_GE(numThreads_, 1ul);
   installSignalHandler();
+  if (auto* stats = dispatcher_->getStats()) {
+    stats->registerLatencies(latencies_);
+  }
 
   traceSubscriptionHandles_.push_back(traceBus_->subscribeFunction(
       "FuseChannel request tracking",
@@ -903,9 +986,18 @@ void FuseChannel::startWorkerThreads() {
   try {
     state->workerThreads.reserve(numThreads_);
     while (state->workerThreads.size() < numThreads_) {
-      state->workerThreads.emplace_back([this] { fuseWorkerThread(); });
+      state->workerThreads.emplace_back(
+          [this, index = state->workerThreads.size()] {
+            fuseWorkerThread(index);
+          });
     }
 
+    if (numInvalidationThreads_ > 1) {
+      invalidationHelpers_ = std::make_unique<folly::CPUThreadPoolExecutor>(
+          numInvalidationThreads_ - 1,
+          std::make_shared<folly::NamedThreadFactory>(
+              fmt::format("inval{}", mountPath_.basename())));
+    }
     invalidationThread_ = std::thread([this] { invalidationThread(); });
   } catch (const std::exception& ex) {
     XLOG(ERR) << "Error starting FUSE worker threads: " << exceptionStr(ex);
@@ -996,23 +1088,126 @@ folly::Future<folly::Unit> FuseChannel::flushInvalidations() {
   return result;
 }
 
+/**
+ * Send a run of inode and directory entry invalidations that were queued
+ * between two flushes, dropping duplicates.
+ *
+ * This method always runs in the invalidation thread, but may hand part of
+ * the work to invalidationHelpers_.
+ */
+void FuseChannel::sendInvalidations(std::vector<InvalidationEntry*>& entries) {
+  if (entries.empty()) {
+    return;
+  }
+
+  // Checkout often invalidates the same directory several times, and the
+  // same name in it as it is removed and then added again.  The first
+  // occurrence is kept; repeated inode invalidations widen its range instead.
+  folly::F14FastMap<InodeNumber, InvalidationEntry*> inodes;
+  folly::F14FastMap<InodeNumber, folly::F14FastSet<std::string_view>> names;
+  std::vector<InvalidationEntry*> unique;
+  unique.reserve(entries.size());
+  for (auto* entry : entries) {
+    if (entry->type == InvalidationType::DIR_ENTRY) {
+      auto name = entry->name.stringPiece();
+      if (names[entry->inode]
+              .emplace(std::string_view{name.data(), name.size()})
+              .second) {
+        unique.push_back(entry);
+      }
+      continue;
+    }
+
+    XDCHECK(entry->type == InvalidationType::INODE);
+    auto [it, inserted] = inodes.emplace(entry->inode, entry);
+    if (inserted) {
+      unique.push_back(entry);
+      continue;
+    }
+    // A negative offset only invalidates attributes, which invalidating any
+    // range does too.
+    auto& into = it->second->range;
+    const auto& from = entry->range;
+    if (from.offset < 0) {
+      continue;
+    }
+    if (into.offset < 0) {
+      into = from;
+      continue;
+    }
+    // A length of 0 extends to the end of the file.
+    int64_t end = (into.length <= 0 || from.length <= 0)
+        ? 0
+        : std::max(into.offset + into.length, from.offset + from.length);
+    into.offset = std::min(into.offset, from.offset);
+    into.length = end == 0 ? 0 : end - into.offset;
+  }
+
+  if (auto* stats = dispatcher_->getStats()) {
+    if (auto coalesced = entries.size() - unique.size()) {
+      stats->increment(
+          &FuseStats::invalidationsCoalesced, static_cast<double>(coalesced));
+    }
+  }
+
+  constexpr size_t kMinParallelInvalidations = 64;
+  if (!invalidationHelpers_ || unique.size() < kMinParallelInvalidations) {
+    for (auto* entry : unique) {
+      sendInvalidation(*entry);
+    }
+    return;
+  }
+
+  // Shard by inode number so that the invalidations of one kernel inode,
+  // including those of its directory entries, keep their relative order.
+  std::vector<std::vector<InvalidationEntry*>> shards(numInvalidationThreads_);
+  for (auto* entry : unique) {
+    shards[std::hash<InodeNumber>{}(entry->inode) % shards.size()].push_back(
+        entry);
+  }
+  std::vector<folly::Future<folly::Unit>> helpers;
+  for (size_t i = 1; i < shards.size(); ++i) {
+    if (!shards[i].empty()) {
+      helpers.push_back(
+          folly::via(invalidationHelpers_.get(), [this, &shard = shards[i]] {
+            for (auto* entry : shard) {
+              sendInvalidation(*entry);
+            }
+          }));
+    }
+  }
+  for (auto* entry : shards[0]) {
+    sendInvalidation(*entry);
+  }
+  folly::collectAll(helpers).wait();
+}
+
 /**
  * Send an element from the invalidation queue.
  *
- * This method always runs in the invalidation thread.
+ * This method runs in the invalidation thread, or in one of the
+ * invalidationHelpers_ threads.
  */
 void FuseChannel::sendInvalidation(InvalidationEntry& entry) {
   // We catch any exceptions that occur and simply log an error message.
   // There is not much else we can do in this situation.
   XLOG(DBG6) << "sending invalidation request: " << entry;
+  folly::stop_watch<std::chrono::microseconds> watch;
+  auto* stats = dispatcher_->getStats();
   try {
     switch (entry.type) {
       case InvalidationType::INODE:
         sendInvalidateInode(
             entry.inode, entry.range.offset, entry.range.length);
+        if (stats) {
+          stats->addDuration(&FuseStats::invalidateInode, watch.elapsed());
+        }
         return;
       case InvalidationType::DIR_ENTRY:
         sendInvalidateEntry(entry.inode, entry.name);
+        if (stats) {
+          stats->addDuration(&FuseStats::invalidateEntry, watch.elapsed());
+        }
         return;
       case InvalidationType::FLUSH:
         // Fulfill the promise to indicate that all previous entries in the
@@ -1042,7 +1237,7 @@ void FuseChannel::sendInvalidation(InvalidationEntry& entry) {
 /**
  * Send a FUSE_NOTIFY_INVAL_INODE message to the kernel.
  *
- * This method always runs in the invalidation thread.
+ * This method runs in the invalidation thread or one of its helpers.
  */
 void FuseChannel::sendInvalidateInode(
     InodeNumber ino,
@@ -1068,7 +1263,7 @@ void FuseChannel::sendInvalidateInode(
   iov[1].iov_len = sizeof(notify);
 
   try {
-    sendRawReply(iov.data(), iov.size());
+    sendRawReply(fuseDevice_.fd(), iov.data(), iov.size());
     XLOG(DBG7) << "sendInvalidateInode(ino=" << ino << ", off=" << off
                << ", len=" << len << ") OK!";
   } catch (const std::system_error& exc) {
@@ -1089,7 +1284,7 @@ void FuseChannel::sendInvalidateInode(
 /**
  * Send a FUSE_NOTIFY_INVAL_ENTRY message to the kernel.
  *
- * This method always runs in the invalidation thread.
+ * This method runs in the invalidation thread or one of its helpers.
  */
 void FuseChannel::sendInvalidateEntry(
     InodeNumber parent,
@@ -1127,7 +1322,7 @@ void FuseChannel::sendInvalidateEntry(
   iov[3].iov_len = 1;
 
   try {
-    sendRawReply(iov.data(), iov.size());
+    sendRawReply(fuseDevice_.fd(), iov.data(), iov.size());
   } catch (const std::system_error& exc) {
     // Ignore ENOENT.  This can happen for inode numbers that we allocated on
     // our own and haven't actually told the kernel about yet.
@@ -1241,18 +1436,21 @@ void FuseChannel::initWorkerThread() noexcept {
   initPromise_.setValue(sessionCompletePromise_.getSemiFuture());
 
   // Continue to run like a normal FUSE worker thread.
-  fuseWorkerThread();
+  fuseWorkerThread(0);
 }
 
-void FuseChannel::fuseWorkerThread() noexcept {
+void FuseChannel::fuseWorkerThread(size_t index) noexcept {
   disablePthreadCancellation();
+  if (pinThreadsToNumaNodes_) {
+    NumaTopology::get().pinCurrentThread(index);
+  }
   setThreadName(fmt::format("fuse{}", mountPath_.basename()));
   setThreadSigmask();
   *(liveRequestWatches_.get()) =
-      std::make_shared<RequestMetricsScope::LockedRequestWatchList>();
+      std::make_shared<RequestMetricsScope::RequestWatchList>();
 
   try {
-    processSession();
+    processSession(openWorkerDevice());
   } catch (const std::exception& ex) {
     XLOG(ERR) << "unexpected error in FUSE worker thread: " << exceptionStr(ex);
     // Request that all other FUSE threads exit.
@@ -1280,6 +1478,32 @@ void FuseChannel::fuseWorkerThread() noexcept {
   }
 }
 
+int FuseChannel::openWorkerDevice() {
+  if (!cloneDevicePerThread_) {
+    return fuseDevice_.fd();
+  }
+
+#ifdef FUSE_DEV_IOC_CLONE
+  // A clone shares the FUSE connection, and therefore the kernel's queue of
+  // pending requests, but has its own list of requests being processed, so
+  // the worker threads no longer serialize on the lock protecting it.
+  try {
+    folly::File clone{"/dev/fuse", O_RDWR | O_CLOEXEC};
+    uint32_t sessionFd = fuseDevice_.fd();
+    folly::checkUnixError(
+        ioctl(clone.fd(), FUSE_DEV_IOC_CLONE, &sessionFd),
+        "FUSE_DEV_IOC_CLONE failed");
+    int fd = clone.fd();
+    state_.wlock()->clonedDevices.push_back(std::move(clone));
+    return fd;
+  } catch (const std::exception& ex) {
+    XLOG(WARN) << "unable to clone the FUSE device for " << mountPath_
+               << ", sharing it instead: " << exceptionStr(ex);
+  }
+#endif
+  return fuseDevice_.fd();
+}
+
 void FuseChannel::invalidationThread() noexcept {
   setThreadName(fmt::format("inval{}", mountPath_.basename()));
 
@@ -1313,10 +1537,20 @@ void FuseChannel::invalidationThread() noexcept {
       lockedQueue->queue.swap(entries);
     }
 
-    // Process all of the entries we found
+    // Process all of the entries we found.  Everything queued before a flush
+    // must have been sent before its promise is fulfilled, but the entries
+    // between two flushes can be coalesced and sent in any order.
+    std::vector<InvalidationEntry*> pending;
     for (auto& entry : entries) {
-      sendInvalidation(entry);
+      if (entry.type == InvalidationType::FLUSH) {
+        sendInvalidations(pending);
+        pending.clear();
+        sendInvalidation(entry);
+      } else {
+        pending.push_back(&entry);
+      }
     }
+    sendInvalidations(pending);
     entries.clear();
   }
 }
@@ -1331,6 +1565,7 @@ void FuseChannel::stopInvalidationThread() {
   invalidationQueue_.lock()->stop = true;
   invalidationCV_.notify_one();
   invalidationThread_.join();
+  invalidationHelpers_.reset();
 }
 
 void FuseChannel::readInitPacket() {
@@ -1399,7 +1634,7 @@ void FuseChannel::readInitPacket() {
   }
 
   if (init.header.opcode != FUSE_INIT) {
-    replyError(init.header, EPROTO);
+    replyError(fuseDevice_.fd(), init.header, EPROTO);
     throw_<std::runtime_error>(
         "expected to receive FUSE_INIT for \"",
         mountPath_,
@@ -1433,9 +1668,24 @@ void FuseChannel::readInitPacket() {
   const auto capable = init.init.flags;
   auto& want = connInfo.flags;
 
-  // TODO: follow up and look at the new flags; particularly
-  // FUSE_DO_READDIRPLUS, FUSE_READDIRPLUS_AUTO. FUSE_SPLICE_XXX are interesting
-  // too, but may not directly benefit eden today.
+  // FUSE_SPLICE_XXX are deliberately not requested. Read replies are built
+  // from the blob or from a pread() of the overlay file into an IOBuf, and
+  // sendRawReply() writev()s them with a single copy into the kernel; a
+  // vmsplice()/splice() pair through a pipe copies the same pages once too,
+  // but costs two system calls. FUSE_SPLICE_MOVE would avoid that copy, but
+  // the kernel no longer moves pages and always falls back to copying. The
+  // only saving splice could bring is for materialized files, by splicing
+  // the overlay file straight into /dev/fuse instead of reading it into an
+  // IOBuf first, which would require FuseDispatcher::read() to return a file
+  // range instead of a BufVec.
+  //
+  // FUSE_SETUPMAPPING and FUSE_REMOVEMAPPING (DAX) are only sent by virtio-fs,
+  // where the daemon maps file ranges into the shared memory window of a
+  // VM, never over /dev/fuse. Overlay files could not be mapped anyway: they
+  // start with a FileContentStore header, so their contents are not page
+  // aligned. Page faults on mapped files are served by the kernel page cache
+  // once the pages were read; FUSE_MAX_PAGES below lets it read them, and any
+  // large read, in 1 MiB requests rather than 128 KiB ones.
   //
   // FUSE_ATOMIC_O_TRUNC is a nice optimization when the kernel supports it
   // and the FUSE daemon requires handling open/release for stateful file
@@ -1459,6 +1709,19 @@ void FuseChannel::readInitPacket() {
   want |= FUSE_CACHE_SYMLINKS;
   // We can handle almost any request in parallel.
   want |= FUSE_PARALLEL_DIROPS;
+  // Let the kernel send fewer, larger FUSE_READ requests for readahead and
+  // large reads.
+  want |= FUSE_MAX_PAGES;
+  connInfo.max_pages = kMaxPagesPerRequest;
+  if (useReaddirplus_) {
+    // Return the attributes of the entries of a directory with their names,
+    // sparing a FUSE_LOOKUP per entry. With FUSE_READDIRPLUS_AUTO, the kernel
+    // only does so when the entries of its previous listing were looked up,
+    // like `ls -l` does, and uses FUSE_READDIR otherwise.
+    want |= FUSE_DO_READDIRPLUS | FUSE_READDIRPLUS_AUTO;
+  }
+#else
+  (void)useReaddirplus_;
 #endif
 
 #ifdef FUSE_WRITEBACK_CACHE
@@ -1473,6 +1736,15 @@ void FuseChannel::readInitPacket() {
 #ifdef FUSE_NO_OPEN_SUPPORT
   // File handles are stateless so the kernel does not need to send open() and
   // release().
+  //
+  // This also rules out FUSE_PASSTHROUGH (Linux 6.9), which is set up per
+  // open() by handing the kernel a backing descriptor. Materialized files
+  // could not use it anyway: the kernel maps file offsets 1:1 onto the
+  // backing file, but overlay files start with a FileContentStore header.
+  // Passthrough writes would also bypass FileInode, leaving the journal and
+  // the cached size and SHA-1 stale, and the kernel fails an open() with EIO
+  // if its inode is already open in the other (cached or passthrough) mode,
+  // which a file materialized while open would run into.
   want |= FUSE_NO_OPEN_SUPPORT;
 #endif
 #ifdef FUSE_NO_OPENDIR_SUPPORT
@@ -1500,7 +1772,7 @@ void FuseChannel::readInitPacket() {
              << ", want=" << capsFlagsToLabel(want);
 
   if (init.init.major != FUSE_KERNEL_VERSION) {
-    replyError(init.header, EPROTO);
+    replyError(fuseDevice_.fd(), init.header, EPROTO);
     throw_<std::runtime_error>(
         "Unsupported FUSE kernel version ",
         init.init.major,
@@ -1525,12 +1797,13 @@ void FuseChannel::readInitPacket() {
       FUSE_KERNEL_MINOR_VERSION > 22,
       "Your kernel headers are too old to build Eden.");
   if (init.init.minor > 22) {
-    sendReply(init.header, connInfo);
+    sendReply(fuseDevice_.fd(), init.header, connInfo);
   } else {
     // If the protocol version predates the expansion of fuse_init_out, only
     // send the start of the packet.
     static_assert(FUSE_COMPAT_22_INIT_OUT_SIZE <= sizeof(connInfo));
     sendReply(
+        fuseDevice_.fd(),
         init.header,
         ByteRange{
             reinterpret_cast<const uint8_t*>(&connInfo),
@@ -1541,22 +1814,24 @@ void FuseChannel::readInitPacket() {
       FUSE_KERNEL_MINOR_VERSION == 19,
       "osxfuse: API/ABI likely changed, may need something like the"
       " linux code above to send the correct response to the kernel");
-  sendReply(init.header, connInfo);
+  sendReply(fuseDevice_.fd(), init.header, connInfo);
 #endif
 
   dispatcher_->initConnection(connInfo);
 }
 
-void FuseChannel::processSession() {
+void FuseChannel::processSession(int fuseDevice) {
   std::vector<char> buf(bufferSize_);
   // Save this for the sanity check later in the loop to avoid
   // additional syscalls on each loop iteration.
   auto myPid = getpid();
 
   while (!stop_.load(std::memory_order_relaxed)) {
-    // TODO: FUSE_SPLICE_READ allows using splice(2) here if we enable it.
-    // We can look at turning this on once the main plumbing is complete.
-    auto res = read(fuseDevice_.fd(), buf.data(), buf.size());
+    // FUSE_SPLICE_READ would let us splice(2) requests into a pipe here,
+    // but every request is decoded from user space memory anyway, and only
+    // the payload of FUSE_WRITE could be forwarded without a copy. See the
+    // comment about FUSE_SPLICE_XXX in readInitPacket().
+    auto res = read(fuseDevice, buf.data(), buf.size());
     if (UNLIKELY(res < 0)) {
       int error = errno;
       if (stop_.load(std::memory_order_relaxed)) {
@@ -1642,7 +1917,7 @@ void FuseChannel::processSession() {
       bool matched = false;
       for (auto fastTrack : kFastTracks) {
         if (namePiece == fastTrack) {
-          replyError(*header, ENODATA);
+          replyError(fuseDevice, *header, ENODATA);
           matched = true;
           break;
         }
@@ -1661,7 +1936,7 @@ void FuseChannel::processSession() {
     // to resolve this deadlock on kernel inode locks without rebooting the
     // system.
     if (UNLIKELY(static_cast<pid_t>(header->pid) == myPid)) {
-      replyError(*header, EIO);
+      replyError(fuseDevice, *header, EIO);
       XLOG(CRITICAL) << "Received FUSE request from our own pid: opcode="
                      << header->opcode << " nodeid=" << header->nodeid
                      << " pid=" << header->pid;
@@ -1675,7 +1950,7 @@ void FuseChannel::processSession() {
 
     switch (header->opcode) {
       case FUSE_INIT:
-        replyError(*header, EPROTO);
+        replyError(fuseDevice, *header, EPROTO);
         throw std::runtime_error(
             "received FUSE_INIT after we have been initialized!?");
 
@@ -1685,7 +1960,7 @@ void FuseChannel::processSession() {
         // Deliberately not handling locking; this causes
         // the kernel to do it for us
         XLOG(DBG7) << fuseOpcodeName(header->opcode);
-        replyError(*header, ENOSYS);
+        replyError(fuseDevice, *header, ENOSYS);
         break;
 
 #ifdef __linux__
@@ -1694,14 +1969,14 @@ void FuseChannel::processSession() {
         // for us.  Returning ENOSYS causes the kernel to implement it for us,
         // and will cause it to stop sending subsequent FUSE_LSEEK requests.
         XLOG(DBG7) << "FUSE_LSEEK";
-        replyError(*header, ENOSYS);
+        replyError(fuseDevice, *header, ENOSYS);
         break;
 #endif
 
       case FUSE_POLL:
         // We do not currently implement FUSE_POLL.
         XLOG(DBG7) << "FUSE_POLL";
-        replyError(*header, ENOSYS);
+        replyError(fuseDevice, *header, ENOSYS);
         break;
 
       case FUSE_INTERRUPT: {
@@ -1722,7 +1997,7 @@ void FuseChannel::processSession() {
         // we have responded, which in turn blocks our attempt to gracefully
         // unmount, so we respond here.  It doesn't hurt Linux to respond
         // so we do it for both platforms.
-        replyError(*header, 0);
+        replyError(fuseDevice, *header, 0);
         break;
 
       case FUSE_NOTIFY_REPLY:
@@ -1735,7 +2010,7 @@ void FuseChannel::processSession() {
       case FUSE_IOCTL:
         // Rather than the default ENOSYS, we need to return ENOTTY
         // to indicate that the requested ioctl is not supported
-        replyError(*header, ENOTTY);
+        replyError(fuseDevice, *header, ENOTTY);
         break;
 
       default: {
@@ -1752,7 +2027,13 @@ void FuseChannel::processSession() {
           // This is a shared_ptr because, due to timeouts, the internal request
           // lifetime may not match the FUSE request lifetime, so we capture it
           // in both. I'm sure this could be improved with some cleverness.
-          auto request = std::make_shared<FuseRequestContext>(this, *header);
+          // The context is allocated and freed at every request, so its
+          // memory is recycled rather than returned to the allocator.
+          auto request = std::allocate_shared<FuseRequestContext>(
+              RecyclingAllocator<FuseRequestContext>{},
+              this,
+              *header,
+              fuseDevice);
 
           ++state_.wlock()->pendingRequests;
 
@@ -1778,8 +2059,17 @@ void FuseChannel::processSession() {
                         dispatcher_->getStats(),
                         handlerEntry->stat,
                         *(liveRequestWatches_.get()));
-                    return (this->*handlerEntry->handler)(
-                               *request, request->getReq(), arg)
+                    request->setLatencies(latencies_, headerCopy.opcode);
+                    return admitRequest(
+                               headerCopy,
+                               arg,
+                               [this, handlerEntry, request](
+                                   folly::ByteRange admittedArg) {
+                                 return (this->*handlerEntry->handler)(
+                                     *request,
+                                     request->getReq(),
+                                     admittedArg);
+                               })
                         .semi()
                         .via(&folly::QueuedImmediateExecutor::instance());
                   }).ensure([request] {
@@ -1819,7 +2109,7 @@ void FuseChannel::processSession() {
             });
 
         try {
-          replyError(*header, ENOSYS);
+          replyError(fuseDevice, *header, ENOSYS);
         } catch (const std::system_error& exc) {
           XLOG(ERR) << "Failed to write error response to fuse: " << exc.what();
           requestSessionExit(StopReason::FUSE_WRITE_ERROR);
@@ -1831,6 +2121,53 @@ void FuseChannel::processSession() {
   }
 }
 
+ImmediateFuture<folly::Unit> FuseChannel::admitRequest(
+    const fuse_in_header& header,
+    folly::ByteRange arg,
+    folly::Function<ImmediateFuture<folly::Unit>(folly::ByteRange)> run) {
+  auto kind = overloadRequestKind(header.opcode);
+  if (!kind) {
+    return run(arg);
+  }
+
+  auto* stats = dispatcher_->getStats();
+  auto admission =
+      overloadController_->admit(static_cast<pid_t>(header.pid), *kind);
+  if (admission.isReady()) {
+    auto slot = std::move(admission).getTry();
+    if (slot.hasException()) {
+      if (stats) {
+        stats->increment(&FuseStats::requestsShed);
+      }
+      return folly::Try<folly::Unit>{std::move(slot.exception())};
+    }
+    return run(arg).ensure([slot = std::move(slot).value()] {});
+  }
+
+  if (stats) {
+    stats->increment(&FuseStats::requestsDeferred);
+  }
+  return std::move(admission)
+      .thenTry([stats,
+                run = std::move(run),
+                argCopy = std::vector<uint8_t>(arg.begin(), arg.end())](
+                   folly::Try<FsChannelOverloadController::Slot>&&
+                       slot) mutable -> ImmediateFuture<folly::Unit> {
+        if (slot.hasException()) {
+          if (stats) {
+            stats->increment(&FuseStats::requestsShed);
+          }
+          return folly::Try<folly::Unit>{std::move(slot.exception())};
+        }
+        if (stats) {
+          stats->addDuration(
+              &FuseStats::requestQueueDelay, slot->getQueueDelay());
+        }
+        return run(folly::ByteRange{argCopy.data(), argCopy.size()})
+            .ensure([slot = std::move(slot).value()] {});
+      });
+}
+
 void FuseChannel::sessionComplete(folly::Synchronized<State>::LockedPtr state) {
   // Check to see if we should delete ourself after fulfilling
   // sessionCompletePromise_
@@ -1844,6 +2181,9 @@ void FuseChannel::sessionComplete(folly::Synchronized<State>::LockedPtr state) {
     data.fuseSettings = connInfo_.value();
   }
 
+  // Every request read from the clones has been answered by now.
+  state->clonedDevices.clear();
+
   // Unlock the state before the remaining steps
   state.unlock();
 
@@ -2351,6 +2691,28 @@ ImmediateFuture<folly::Unit> FuseChannel::fuseReadDir(
       });
 }
 
+#ifdef __linux__
+ImmediateFuture<folly::Unit> FuseChannel::fuseReadDirPlus(
+    FuseRequestContext& request,
+    const fuse_in_header& header,
+    ByteRange arg) {
+  auto read = reinterpret_cast<const fuse_read_in*>(arg.data());
+  XLOG(DBG7) << "FUSE_READDIRPLUS";
+  auto ino = InodeNumber{header.nodeid};
+  return dispatcher_
+      ->readdirplus(
+          ino,
+          FuseDirList{read->size, /*plus=*/true},
+          read->offset,
+          read->fh,
+          request.getObjectFetchContext())
+      .thenValue([&request](FuseDirList&& list) {
+        const auto buf = list.getBuf();
+        request.sendReply(StringPiece{buf});
+      });
+}
+#endif
+
 ImmediateFuture<folly::Unit> FuseChannel::fuseReleaseDir(
     FuseRequestContext& request,
     const fuse_in_header& header,
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <folly/File.h>
+#include <folly/Function.h>
 #include <folly/Range.h>
 #include <folly/Synchronized.h>
 #include <folly/futures/Future.h>
@@ -26,9 +27,11 @@
 
 #include "eden/fs/fuse/FuseDispatcher.h"
 #include "eden/fs/inodes/InodeNumber.h"
+#include "eden/fs/telemetry/FsChannelLatencies.h"
 #include "eden/fs/telemetry/RequestMetricsScope.h"
 #include "eden/fs/telemetry/TraceBus.h"
 #include "eden/fs/utils/CaseSensitivity.h"
+#include "eden/fs/utils/FsChannelOverloadController.h"
 #include "eden/fs/utils/FsChannelTypes.h"
 #include "eden/fs/utils/PathFuncs.h"
 #include "eden/fs/utils/ProcessAccessLog.h"
@@ -38,6 +41,7 @@
 #endif
 
 namespace folly {
+class CPUThreadPoolExecutor;
 struct Unit;
 } // namespace folly
 
@@ -224,6 +228,19 @@ class FuseChannel {
    * The caller is expected to follow up with a call to the
    * initialize() method to perform the handshake with the
    * kernel and set up the thread pool.
+   *
+   * If cloneDevicePerThread is true, each worker thread reads requests from
+   * its own clone of fuseDevice (FUSE_DEV_IOC_CLONE) rather than all of them
+   * contending on the one descriptor.
+   *
+   * numInvalidationThreads is the number of threads that send queued
+   * invalidations to the kernel.
+   *
+   * If pinThreadsToNumaNodes is true, the worker threads are spread across
+   * the NUMA nodes of the host, each pinned to the CPUs of one node.
+   *
+   * If useReaddirplus is true, the kernel is asked to list directories with
+   * FUSE_READDIRPLUS when it expects their entries to be looked up next.
    */
   FuseChannel(
       folly::File&& fuseDevice,
@@ -238,7 +255,12 @@ class FuseChannel {
       CaseSensitivity caseSensitive,
       bool requireUtf8Path,
       int32_t maximumBackgroundRequests,
-      bool useWriteBackCache);
+      bool useWriteBackCache,
+      bool cloneDevicePerThread,
+      size_t numInvalidationThreads,
+      bool pinThreadsToNumaNodes,
+      bool useReaddirplus,
+      FsChannelOverloadController::Config overloadConfig);
 
   /**
    * Destroy the FuseChannel.
@@ -352,6 +374,9 @@ class FuseChannel {
    * Wait for all currently scheduled invalidateInode() and invalidateEntry()
    * operations to complete.
    *
+   * Invalidations queued between two flushes may be sent in any order, and
+   * duplicates among them are only sent once.
+   *
    * The returned Future will complete once all invalidation operations
    * scheduled before this flushInvalidations() call have finished.  This
    * future will normally be completed in the FuseChannel's invalidation
@@ -364,10 +389,14 @@ class FuseChannel {
    * status (no additional payload).
    * `err` may be 0 (indicating success) or a positive errno value.
    *
+   * `fuseDevice` is the descriptor the request was read from.  When the
+   * worker threads read from cloned devices the kernel only accepts the reply
+   * on the clone that delivered the request.
+   *
    * throws system_error if the write fails.  Writes can fail if the
    * data we send to the kernel is invalid.
    */
-  void replyError(const fuse_in_header& request, int err);
+  void replyError(int fuseDevice, const fuse_in_header& request, int err);
 
   /**
    * Sends a raw data packet to the kernel.
@@ -380,7 +409,7 @@ class FuseChannel {
    * throws system_error if the write fails.  Writes can fail if the
    * data we send to the kernel is invalid.
    */
-  void sendRawReply(const iovec iov[], size_t count) const;
+  void sendRawReply(int fuseDevice, const iovec iov[], size_t count) const;
 
   /**
    * Sends a range of contiguous bytes as a reply to the kernel.
@@ -391,11 +420,16 @@ class FuseChannel {
    * throws system_error if the write fails.  Writes can fail if the
    * data we send to the kernel is invalid.
    */
-  void sendReply(const fuse_in_header& request, folly::ByteRange bytes) const;
+  void sendReply(
+      int fuseDevice,
+      const fuse_in_header& request,
+      folly::ByteRange bytes) const;
 
-  void sendReply(const fuse_in_header& request, folly::StringPiece bytes)
-      const {
-    sendReply(request, folly::ByteRange{bytes});
+  void sendReply(
+      int fuseDevice,
+      const fuse_in_header& request,
+      folly::StringPiece bytes) const {
+    sendReply(fuseDevice, request, folly::ByteRange{bytes});
   }
 
   /**
@@ -407,8 +441,10 @@ class FuseChannel {
    * throws system_error if the write fails.  Writes can fail if the
    * data we send to the kernel is invalid.
    */
-  void sendReply(const fuse_in_header& request, folly::fbvector<iovec>&& vec)
-      const;
+  void sendReply(
+      int fuseDevice,
+      const fuse_in_header& request,
+      folly::fbvector<iovec>&& vec) const;
 
   /**
    * Sends a reply to a kernel request potentially consisting of multiple
@@ -417,7 +453,10 @@ class FuseChannel {
    * throws system_error if the write fails.  Writes can fail if the
    * data we send to the kernel is invalid.
    */
-  void sendReply(const fuse_in_header& request, const folly::IOBuf& buf) const;
+  void sendReply(
+      int fuseDevice,
+      const fuse_in_header& request,
+      const folly::IOBuf& buf) const;
 
   /**
    * Sends a reply to the kernel.
@@ -428,10 +467,14 @@ class FuseChannel {
    * data we send to the kernel is invalid.
    */
   template <typename T>
-  void sendReply(const fuse_in_header& request, const T& payload) const {
+  void sendReply(
+      int fuseDevice,
+      const fuse_in_header& request,
+      const T& payload) const {
     static_assert(std::is_standard_layout_v<T>);
     static_assert(std::is_trivial_v<T>);
     sendReply(
+        fuseDevice,
         request,
         folly::ByteRange{
             reinterpret_cast<const uint8_t*>(&payload), sizeof(T)});
@@ -506,6 +549,15 @@ class FuseChannel {
      * or running.
      */
     StopReason stopReason{StopReason::RUNNING};
+
+    /**
+     * The per-thread clones of fuseDevice_, if cloneDevicePerThread_ is set.
+     *
+     * Requests read from a clone can only be answered through that clone, so
+     * these outlive the worker threads that opened them and are only closed
+     * once the last outstanding request has completed.
+     */
+    std::vector<folly::File> clonedDevices;
   };
 
   /**
@@ -665,6 +717,12 @@ class FuseChannel {
       FuseRequestContext& request,
       const fuse_in_header& header,
       folly::ByteRange arg);
+#ifdef __linux__
+  ImmediateFuture<folly::Unit> fuseReadDirPlus(
+      FuseRequestContext& request,
+      const fuse_in_header& header,
+      folly::ByteRange arg);
+#endif
   ImmediateFuture<folly::Unit> fuseReleaseDir(
       FuseRequestContext& request,
       const fuse_in_header& header,
@@ -697,15 +755,33 @@ class FuseChannel {
  private:
   void setThreadSigmask();
   void initWorkerThread() noexcept;
-  void fuseWorkerThread() noexcept;
+  void fuseWorkerThread(size_t index) noexcept;
   void invalidationThread() noexcept;
   void stopInvalidationThread();
   void sendInvalidation(InvalidationEntry& entry);
+  void sendInvalidations(std::vector<InvalidationEntry*>& entries);
   void sendInvalidateInode(InodeNumber ino, int64_t off, int64_t len);
   void sendInvalidateEntry(InodeNumber parent, PathComponentPiece name);
   void readInitPacket();
   void startWorkerThreads();
 
+  /**
+   * Returns the descriptor the calling worker thread should read requests
+   * from: a new clone of fuseDevice_ if cloneDevicePerThread_ is set and the
+   * kernel supports it, or fuseDevice_ itself otherwise.
+   */
+  int openWorkerDevice();
+
+  /**
+   * Runs the request once overloadController_ admits it. As arg points into
+   * the buffer the next request is read into, it is copied if the request
+   * has to queue.
+   */
+  ImmediateFuture<folly::Unit> admitRequest(
+      const fuse_in_header& header,
+      folly::ByteRange arg,
+      folly::Function<ImmediateFuture<folly::Unit>(folly::ByteRange)> run);
+
   /**
    * sessionComplete() will fulfill the sessionCompletePromise_.
    *
@@ -731,9 +807,10 @@ class FuseChannel {
    * Dispatches fuse requests until the session is torn down.
    * This function blocks until the fuse session is stopped.
    * The intent is that this is called from each of the
-   * fuse worker threads provided by the MountPoint.
+   * fuse worker threads provided by the MountPoint, with the descriptor
+   * returned by openWorkerDevice().
    */
-  void processSession();
+  void processSession(int fuseDevice);
 
   /**
    * Requests that the worker threads terminate their processing loop.
@@ -757,6 +834,9 @@ class FuseChannel {
   bool requireUtf8Path_;
   int32_t maximumBackgroundRequests_;
   bool useWriteBackCache_;
+  bool cloneDevicePerThread_;
+  bool pinThreadsToNumaNodes_;
+  bool useReaddirplus_;
 
   /*
    * connInfo_ is modified during the initialization process,
@@ -802,9 +882,21 @@ class FuseChannel {
   folly::Synchronized<InvalidationQueue, std::mutex> invalidationQueue_;
   std::condition_variable invalidationCV_;
   std::thread invalidationThread_;
+  /**
+   * Helps invalidationThread_ send large batches if numInvalidationThreads_
+   * is more than one, so that one invalidation blocked on a kernel inode lock
+   * does not hold up the rest of the batch behind it.
+   */
+  std::unique_ptr<folly::CPUThreadPoolExecutor> invalidationHelpers_;
+  const size_t numInvalidationThreads_;
 
   ProcessAccessLog processAccessLog_;
 
+  std::shared_ptr<FsChannelOverloadController> overloadController_;
+
+  // Latency histograms of the requests of this mount, indexed by opcode.
+  std::shared_ptr<FsChannelLatencies> latencies_;
+
   // this tracks metrics for live FUSE requests, this is a thread local
   // to avoid contention between the FuseWorkerThreads as they kick off
   // requests.
@@ -813,7 +905,7 @@ class FuseChannel {
   // requests as these may outlive the spawning worker thread.
   class ThreadLocalTag {};
   folly::ThreadLocal<
-      std::shared_ptr<RequestMetricsScope::LockedRequestWatchList>,
+      std::shared_ptr<RequestMetricsScope::RequestWatchList>,
       ThreadLocalTag>
       liveRequestWatches_;
 
@@ -216,6 +216,15 @@ ImmediateFuture<FuseDirList> FuseDispatcher::readdir(
   FUSELL_NOT_IMPL();
 }
 
+ImmediateFuture<FuseDirList> FuseDispatcher::readdirplus(
+    InodeNumber,
+    FuseDirList&&,
+    off_t,
+    uint64_t,
+    const ObjectFetchContextPtr&) {
+  FUSELL_NOT_IMPL();
+}
+
 ImmediateFuture<struct fuse_kstatfs> FuseDispatcher::statfs(
     InodeNumber /*ino*/) {
   struct fuse_kstatfs info = {};
@@ -112,6 +112,12 @@ class FuseDispatcher {
         // and we never achieve a cache hit.  Limiting ourselves
         // to the maximum possible signed 32 bit value gives us
         // ta large and effective timeout
+        //
+        // Every inode gets this TTL, materialized or not: changes to
+        // materialized inodes arrive through FUSE requests, which update
+        // the kernel's cache themselves, and checkout explicitly
+        // invalidates anything it changes.  A per-state TTL could only ever
+        // be shorter, turning cache hits into FUSE_GETATTR requests.
         uint64_t timeout = std::numeric_limits<int32_t>::max());
 
     fuse_attr_out asFuseAttr() const;
@@ -394,6 +400,20 @@ class FuseDispatcher {
       uint64_t fh,
       const ObjectFetchContextPtr& context);
 
+  /**
+   * Read directory, along with the attributes of its entries.
+   *
+   * Like readdir(), but dirList was constructed for FUSE_READDIRPLUS, and
+   * each entry's fuse_entry_out is set with FuseDirList::setEntryOut(). Each
+   * entry given a nodeid counts as a lookup of it.
+   */
+  virtual ImmediateFuture<FuseDirList> readdirplus(
+      InodeNumber ino,
+      FuseDirList&& dirList,
+      off_t offset,
+      uint64_t fh,
+      const ObjectFetchContextPtr& context);
+
   /**
    * Get file system statistics
    *
@@ -18,10 +18,13 @@
 #include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/telemetry/RequestMetricsScope.h"
 #include "eden/fs/utils/FsChannelTypes.h"
+#include "eden/fs/utils/RecyclingAllocator.h"
 
 namespace facebook::eden {
 
-class FuseObjectFetchContext : public FsObjectFetchContext {
+class FuseObjectFetchContext
+    : public FsObjectFetchContext,
+      public RecycledAllocation<FuseObjectFetchContext> {
  public:
   FuseObjectFetchContext(pid_t pid, uint32_t opcode)
       : pid_{pid}, opcode_{opcode} {}
@@ -48,9 +51,14 @@ class FuseObjectFetchContext : public FsObjectFetchContext {
  */
 class FuseRequestContext : public RequestContext {
  public:
-  explicit FuseRequestContext(
+  /**
+   * fuseDevice is the descriptor the request was read from, which the reply
+   * must be written to.
+   */
+  FuseRequestContext(
       FuseChannel* channel,
-      const fuse_in_header& fuseHeader);
+      const fuse_in_header& fuseHeader,
+      int fuseDevice);
 
   FuseRequestContext(const FuseRequestContext&) = delete;
   FuseRequestContext& operator=(const FuseRequestContext&) = delete;
@@ -111,7 +119,8 @@ class FuseRequestContext : public RequestContext {
 
   template <typename... T>
   void sendReply(T&&... payload) {
-    channel_->sendReply(stealReqWithResult(0), std::forward<T>(payload)...);
+    channel_->sendReply(
+        fuseDevice_, stealReqWithResult(0), std::forward<T>(payload)...);
   }
 
   /**
@@ -121,7 +130,8 @@ class FuseRequestContext : public RequestContext {
    */
   template <typename T>
   void sendReplyWithInode(uint64_t nodeid, T&& reply) {
-    channel_->sendReply(stealReqWithResult(nodeid), std::forward<T>(reply));
+    channel_->sendReply(
+        fuseDevice_, stealReqWithResult(nodeid), std::forward<T>(reply));
   }
 
   // Reply with a negative errno value or 0 for success
@@ -137,6 +147,7 @@ class FuseRequestContext : public RequestContext {
 
   FuseChannel* channel_;
   const fuse_in_header fuseHeader_;
+  const int fuseDevice_;
 
   std::optional<int64_t> result_;
 };
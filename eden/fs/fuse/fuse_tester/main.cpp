@@ -6,25 +6,43 @@
  */
 
 #include <boost/filesystem.hpp>
+#include <fmt/format.h>
+#include <folly/Conv.h>
 #include <folly/Exception.h>
+#include <folly/FileUtil.h>
+#include <folly/Random.h>
+#include <folly/String.h>
+#include <folly/Synchronized.h>
 #include <folly/init/Init.h>
+#include <folly/io/IOBuf.h>
 #include <folly/io/async/EventBase.h>
 #include <folly/io/async/EventBaseThread.h>
 #include <folly/logging/Init.h>
+#include <folly/logging/LoggerDB.h>
 #include <folly/logging/xlog.h>
 #include <folly/portability/GFlags.h>
 #include <signal.h>
 #include <sysexits.h>
+#include <array>
+#include <atomic>
+#include <map>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 #include "eden/common/utils/ProcessNameCache.h"
+#include "eden/fs/fuse/DirList.h"
 #include "eden/fs/fuse/FuseChannel.h"
 #include "eden/fs/fuse/FuseDispatcher.h"
 #include "eden/fs/fuse/privhelper/PrivHelper.h"
 #include "eden/fs/fuse/privhelper/PrivHelperImpl.h"
 #include "eden/fs/store/ObjectStore.h"
 #include "eden/fs/telemetry/EdenStats.h"
+#include "eden/fs/telemetry/LatencyHistogram.h"
+#include "eden/fs/testharness/FakeFuse.h"
 #include "eden/fs/utils/CaseSensitivity.h"
 #include "eden/fs/utils/EnumValue.h"
 #include "eden/fs/utils/PathFuncs.h"
+#include "eden/fs/utils/Throw.h"
 #include "eden/fs/utils/UserInfo.h"
 
 using namespace facebook::eden;
@@ -33,6 +51,39 @@ using folly::exceptionStr;
 using std::string;
 
 DEFINE_int32(numFuseThreads, 4, "The number of FUSE worker threads");
+DEFINE_bool(
+    cloneFuseDevice,
+    false,
+    "Give each FUSE worker thread its own clone of the FUSE device");
+
+DEFINE_bool(
+    load,
+    false,
+    "Instead of mounting PATH, send requests to a FuseChannel over a "
+    "socketpair, without a kernel or privileges, and report their latencies");
+DEFINE_int32(loadThreads, 8, "The number of threads sending requests");
+DEFINE_double(
+    qps,
+    0,
+    "The rate of requests to send, over all the threads. 0 sends them as "
+    "fast as --maxInFlight allows");
+DEFINE_int32(maxInFlight, 1024, "The maximum number of requests in flight");
+DEFINE_int32(durationSeconds, 10, "How long to send requests for");
+DEFINE_string(
+    mix,
+    "lookup=4,getattr=4,read=1,readdir=1",
+    "The weights of the opcodes of the synthetic requests");
+DEFINE_string(
+    replay,
+    "",
+    "Replay the requests recorded in this file, in a loop, instead of "
+    "synthesizing them. Each line is one of: lookup PARENT NAME, "
+    "getattr INODE, read INODE OFFSET SIZE, readdir INODE OFFSET SIZE");
+DEFINE_int32(numFiles, 1000, "The number of files of the synthetic mount");
+DEFINE_int32(
+    fileSize,
+    64 * 1024,
+    "The size of the files of the synthetic mount");
 
 FOLLY_INIT_LOGGING_CONFIG("eden=DBG2,eden.fs.fuse=DBG7");
 
@@ -62,6 +113,522 @@ class TestDispatcher : public FuseDispatcher {
   UserInfo identity_;
 };
 
+/**
+ * Serves a synthetic mount whose root contains --numFiles files of
+ * --fileSize zeros, named file0, file1, etc. and numbered from 2.
+ */
+class LoadDispatcher : public FuseDispatcher {
+ public:
+  LoadDispatcher(EdenStats* stats, uint64_t numFiles, uint64_t fileSize)
+      : FuseDispatcher(stats),
+        numFiles_{numFiles},
+        fileSize_{fileSize},
+        zeros_(kMaxRead, '\0') {}
+
+  ImmediateFuture<fuse_entry_out> lookup(
+      uint64_t /*requestID*/,
+      InodeNumber parent,
+      PathComponentPiece name,
+      const ObjectFetchContextPtr& /*context*/) override {
+    auto piece = name.stringPiece();
+    if (parent != kRootNodeId || !piece.removePrefix("file")) {
+      folly::throwSystemErrorExplicit(ENOENT);
+    }
+    auto index = folly::tryTo<uint64_t>(piece);
+    if (index.hasError() || *index >= numFiles_) {
+      folly::throwSystemErrorExplicit(ENOENT);
+    }
+    auto attr = getAttr(InodeNumber{*index + 2});
+    fuse_entry_out entry = {};
+    entry.nodeid = attr.st.st_ino;
+    auto fuseAttr = attr.asFuseAttr();
+    entry.attr = fuseAttr.attr;
+    entry.attr_valid = fuseAttr.attr_valid;
+    entry.entry_valid = fuseAttr.attr_valid;
+    return entry;
+  }
+
+  ImmediateFuture<Attr> getattr(
+      InodeNumber ino,
+      const ObjectFetchContextPtr& /*context*/) override {
+    return getAttr(ino);
+  }
+
+  ImmediateFuture<BufVec> read(
+      InodeNumber ino,
+      size_t size,
+      off_t off,
+      const ObjectFetchContextPtr& /*context*/) override {
+    checkFile(ino);
+    auto start = std::min<uint64_t>(off, fileSize_);
+    auto length = std::min<uint64_t>({size, fileSize_ - start, kMaxRead});
+    return folly::IOBuf::wrapBuffer(zeros_.data(), length);
+  }
+
+  ImmediateFuture<FuseDirList> readdir(
+      InodeNumber ino,
+      FuseDirList&& list,
+      off_t offset,
+      uint64_t /*fh*/,
+      const ObjectFetchContextPtr& /*context*/) override {
+    if (ino != kRootNodeId) {
+      folly::throwSystemErrorExplicit(ENOTDIR);
+    }
+    // Offset 1 is after ".", and offset N + 2 after file N.
+    if (offset == 0 &&
+        !list.add(".", kRootNodeId.get(), dtype_t::Dir, offset + 1)) {
+      return std::move(list);
+    }
+    for (uint64_t index = std::max<off_t>(offset, 1) - 1; index < numFiles_;
+         ++index) {
+      if (!list.add(
+              fmt::format("file{}", index),
+              index + 2,
+              dtype_t::Regular,
+              index + 2)) {
+        break;
+      }
+    }
+    return std::move(list);
+  }
+
+ private:
+  static constexpr uint64_t kMaxRead = 1024 * 1024;
+
+  void checkFile(InodeNumber ino) const {
+    if (ino.get() < 2 || ino.get() - 2 >= numFiles_) {
+      folly::throwSystemErrorExplicit(ENOENT);
+    }
+  }
+
+  Attr getAttr(InodeNumber ino) const {
+    struct stat st = {};
+    st.st_ino = ino.get();
+    if (ino == kRootNodeId) {
+      st.st_mode = S_IFDIR | 0755;
+      st.st_nlink = 2;
+    } else {
+      checkFile(ino);
+      st.st_mode = S_IFREG | 0644;
+      st.st_nlink = 1;
+      st.st_size = fileSize_;
+    }
+    return Attr(st);
+  }
+
+  const uint64_t numFiles_;
+  const uint64_t fileSize_;
+  const std::string zeros_;
+};
+
+/** A request sent by the load generator. */
+struct LoadRequest {
+  uint32_t opcode{0};
+  uint64_t inode{0};
+  /** The name looked up. */
+  std::string name;
+  /** The offset and size read. */
+  uint64_t offset{0};
+  uint32_t size{0};
+};
+
+const std::map<folly::StringPiece, uint32_t> kLoadOpcodes{
+    {"getattr", FUSE_GETATTR},
+    {"lookup", FUSE_LOOKUP},
+    {"read", FUSE_READ},
+    {"readdir", FUSE_READDIR},
+};
+
+folly::StringPiece getOpcodeName(uint32_t opcode) {
+  for (const auto& [name, value] : kLoadOpcodes) {
+    if (value == opcode) {
+      return name;
+    }
+  }
+  return "unknown";
+}
+
+uint32_t parseOpcode(folly::StringPiece name) {
+  auto it = kLoadOpcodes.find(name);
+  if (it == kLoadOpcodes.end()) {
+    throwf<std::invalid_argument>("unsupported opcode {}", name);
+  }
+  return it->second;
+}
+
+/**
+ * Parse a request stream, one request per line as documented by --replay.
+ * Empty lines and lines starting with # are ignored.
+ */
+std::vector<LoadRequest> parseRecordedRequests(folly::StringPiece contents) {
+  std::vector<LoadRequest> requests;
+  std::vector<folly::StringPiece> lines;
+  folly::split('\n', contents, lines);
+  for (size_t i = 0; i < lines.size(); ++i) {
+    auto line = folly::trimWhitespace(lines[i]);
+    if (line.empty() || line.startsWith('#')) {
+      continue;
+    }
+    std::vector<folly::StringPiece> fields;
+    folly::split(' ', line, fields, /*ignoreEmpty=*/true);
+    try {
+      LoadRequest request;
+      request.opcode = parseOpcode(fields.at(0));
+      request.inode = folly::to<uint64_t>(fields.at(1));
+      if (request.opcode == FUSE_LOOKUP) {
+        request.name = fields.at(2).str();
+      } else if (request.opcode != FUSE_GETATTR) {
+        request.offset = folly::to<uint64_t>(fields.at(2));
+        request.size = folly::to<uint32_t>(fields.at(3));
+      }
+      requests.push_back(std::move(request));
+    } catch (const std::exception& ex) {
+      throwf<std::invalid_argument>(
+          "invalid request on line {}: {}: {}", i + 1, line, ex.what());
+    }
+  }
+  if (requests.empty()) {
+    throw std::invalid_argument("no requests to replay");
+  }
+  return requests;
+}
+
+/**
+ * Parse the weights of a synthetic mix, like "lookup=4,getattr=1".
+ */
+std::vector<std::pair<uint32_t, uint32_t>> parseMix(folly::StringPiece mix) {
+  std::vector<std::pair<uint32_t, uint32_t>> weights;
+  std::vector<folly::StringPiece> entries;
+  folly::split(',', mix, entries, /*ignoreEmpty=*/true);
+  for (auto entry : entries) {
+    folly::StringPiece name;
+    folly::StringPiece weight;
+    if (!folly::split('=', entry, name, weight)) {
+      throwf<std::invalid_argument>("invalid mix entry {}", entry);
+    }
+    weights.emplace_back(parseOpcode(name), folly::to<uint32_t>(weight));
+  }
+  if (weights.empty()) {
+    throw std::invalid_argument("empty mix");
+  }
+  return weights;
+}
+
+LoadRequest makeSyntheticRequest(
+    const std::vector<std::pair<uint32_t, uint32_t>>& weights,
+    uint32_t totalWeight) {
+  auto pick = folly::Random::rand32(totalWeight);
+  auto opcode = weights.back().first;
+  for (const auto& [candidate, weight] : weights) {
+    if (pick < weight) {
+      opcode = candidate;
+      break;
+    }
+    pick -= weight;
+  }
+
+  LoadRequest request;
+  request.opcode = opcode;
+  auto file = folly::Random::rand64(FLAGS_numFiles);
+  switch (opcode) {
+    case FUSE_LOOKUP:
+      request.inode = kRootNodeId.get();
+      request.name = fmt::format("file{}", file);
+      break;
+    case FUSE_GETATTR:
+      request.inode = file + 2;
+      break;
+    case FUSE_READ: {
+      constexpr uint32_t kReadSize = 64 * 1024;
+      auto chunks = std::max<uint64_t>(FLAGS_fileSize / kReadSize, 1);
+      request.inode = file + 2;
+      request.offset = folly::Random::rand64(chunks) * kReadSize;
+      request.size = kReadSize;
+      break;
+    }
+    case FUSE_READDIR:
+      request.inode = kRootNodeId.get();
+      request.size = 4096;
+      break;
+  }
+  return request;
+}
+
+/**
+ * Sends requests over a FakeFuse connection from many threads, and records
+ * the latency of their responses, received by a single thread.
+ */
+class LoadGenerator {
+ public:
+  explicit LoadGenerator(FakeFuse& fuse) : fuse_{fuse} {}
+
+  void run(folly::FunctionRef<LoadRequest(size_t thread)> nextRequest) {
+    auto start = std::chrono::steady_clock::now();
+    auto end = start + std::chrono::seconds(FLAGS_durationSeconds);
+    std::thread receiver{[this] { receiveResponses(); }};
+
+    std::vector<std::thread> senders;
+    for (int i = 0; i < FLAGS_loadThreads; ++i) {
+      senders.emplace_back([&, i] {
+        // Requests are scheduled at a fixed rate, and their latency measured
+        // from when they were due, so that a slow response delaying the
+        // following requests isn't hidden.
+        auto interval = FLAGS_qps > 0
+            ? std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                  std::chrono::duration<double>(FLAGS_loadThreads / FLAGS_qps))
+            : std::chrono::steady_clock::duration::zero();
+        for (auto due = std::chrono::steady_clock::now(); due < end;
+             due += interval) {
+          if (interval.count() > 0) {
+            std::this_thread::sleep_until(due);
+          } else {
+            due = std::chrono::steady_clock::now();
+          }
+          while (inFlight_.load(std::memory_order_acquire) >=
+                 FLAGS_maxInFlight) {
+            std::this_thread::yield();
+          }
+          send(nextRequest(i), due);
+        }
+      });
+    }
+    for (auto& sender : senders) {
+      sender.join();
+    }
+    sendersDone_.store(true, std::memory_order_release);
+    receiver.join();
+    elapsed_ = std::chrono::steady_clock::now() - start;
+  }
+
+  void report() const {
+    auto seconds = std::chrono::duration<double>(elapsed_).count();
+    uint64_t total = 0;
+    fmt::print(
+        "{:<10} {:>10} {:>8} {:>8} {:>8} {:>8} {:>8} {:>8}\n",
+        "opcode",
+        "count",
+        "errors",
+        "p50 us",
+        "p90 us",
+        "p99 us",
+        "p99.9 us",
+        "max us");
+    for (const auto& [opcode, stats] : stats_) {
+      total += stats.latency.getCount();
+      fmt::print(
+          "{:<10} {:>10} {:>8} {:>8} {:>8} {:>8} {:>8} {:>8}\n",
+          getOpcodeName(opcode),
+          stats.latency.getCount(),
+          stats.errors,
+          stats.latency.getPercentile(50),
+          stats.latency.getPercentile(90),
+          stats.latency.getPercentile(99),
+          stats.latency.getPercentile(99.9),
+          stats.latency.getMax());
+    }
+    fmt::print(
+        "{} responses in {:.1f}s: {:.0f} per second, {} unanswered\n",
+        total,
+        seconds,
+        total / seconds,
+        inFlight_.load());
+  }
+
+ private:
+  struct Pending {
+    uint32_t opcode;
+    std::chrono::steady_clock::time_point start;
+  };
+
+  struct OpcodeStats {
+    LatencyHistogram latency;
+    uint64_t errors{0};
+  };
+
+  static constexpr size_t kShards = 64;
+  using Shard = folly::Synchronized<std::unordered_map<uint32_t, Pending>>;
+
+  void send(
+      const LoadRequest& request,
+      std::chrono::steady_clock::time_point due) {
+    std::string arg;
+    switch (request.opcode) {
+      case FUSE_LOOKUP:
+        // Names are NUL terminated.
+        arg = request.name;
+        arg.push_back('\0');
+        break;
+      case FUSE_GETATTR: {
+        fuse_getattr_in getattr = {};
+        arg.assign(reinterpret_cast<const char*>(&getattr), sizeof(getattr));
+        break;
+      }
+      default: {
+        fuse_read_in read = {};
+        read.offset = request.offset;
+        read.size = request.size;
+        arg.assign(reinterpret_cast<const char*>(&read), sizeof(read));
+        break;
+      }
+    }
+
+    auto requestID = fuse_.allocateRequestID();
+    inFlight_.fetch_add(1, std::memory_order_acq_rel);
+    pending_[requestID % kShards].wlock()->emplace(
+        requestID, Pending{request.opcode, due});
+    fuse_.sendRequestWithID(
+        requestID, request.opcode, request.inode, folly::ByteRange{arg});
+  }
+
+  void receiveResponses() {
+    // Give up on the requests still in flight after this long.
+    constexpr auto kDrainTimeout = std::chrono::seconds(10);
+    std::optional<std::chrono::steady_clock::time_point> drainDeadline;
+    while (true) {
+      if (sendersDone_.load(std::memory_order_acquire)) {
+        if (inFlight_.load(std::memory_order_acquire) == 0) {
+          return;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (!drainDeadline) {
+          drainDeadline = now + kDrainTimeout;
+        } else if (now >= *drainDeadline) {
+          return;
+        }
+      }
+
+      FakeFuse::Response response;
+      try {
+        response = fuse_.recvResponse();
+      } catch (const std::system_error& ex) {
+        if (ex.code().value() == EAGAIN) {
+          continue;
+        }
+        throw;
+      }
+      auto end = std::chrono::steady_clock::now();
+
+      auto requestID = static_cast<uint32_t>(response.header.unique);
+      std::optional<Pending> pending;
+      {
+        auto shard = pending_[requestID % kShards].wlock();
+        auto it = shard->find(requestID);
+        if (it != shard->end()) {
+          pending = it->second;
+          shard->erase(it);
+        }
+      }
+      if (!pending) {
+        XLOG(WARN) << "response to unknown request " << requestID;
+        continue;
+      }
+      inFlight_.fetch_sub(1, std::memory_order_acq_rel);
+      auto& stats = stats_[pending->opcode];
+      stats.latency.record(
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              end - pending->start)
+              .count());
+      if (response.header.error != 0) {
+        ++stats.errors;
+      }
+    }
+  }
+
+  FakeFuse& fuse_;
+  std::atomic<int64_t> inFlight_{0};
+  std::atomic<bool> sendersDone_{false};
+  std::array<Shard, kShards> pending_;
+  /** Only accessed by the receiving thread, until run() returns. */
+  std::map<uint32_t, OpcodeStats> stats_;
+  std::chrono::steady_clock::duration elapsed_{};
+};
+
+int runLoad() {
+  // Logging each request would dominate the measurements.
+  folly::LoggerDB::get().getCategory("eden")->setLevel(folly::LogLevel::INFO);
+  folly::LoggerDB::get().getCategory("eden.fs.fuse")->setLevel(
+      folly::LogLevel::INFO);
+
+  std::vector<LoadRequest> recorded;
+  std::vector<std::pair<uint32_t, uint32_t>> weights;
+  uint32_t totalWeight = 0;
+  try {
+    if (FLAGS_loadThreads <= 0 || FLAGS_numFiles <= 0 || FLAGS_fileSize < 0) {
+      throw std::invalid_argument(
+          "--loadThreads and --numFiles must be positive, "
+          "and --fileSize not negative");
+    }
+    if (!FLAGS_replay.empty()) {
+      std::string contents;
+      if (!folly::readFile(FLAGS_replay.c_str(), contents)) {
+        folly::throwSystemError("failed to read ", FLAGS_replay);
+      }
+      recorded = parseRecordedRequests(contents);
+    } else {
+      weights = parseMix(FLAGS_mix);
+      for (const auto& [opcode, weight] : weights) {
+        totalWeight += weight;
+      }
+      if (totalWeight == 0) {
+        throw std::invalid_argument("the mix weights are all 0");
+      }
+    }
+  } catch (const std::exception& ex) {
+    fprintf(stderr, "error: %s\n", exceptionStr(ex).c_str());
+    return EX_USAGE;
+  }
+
+  EdenStats stats;
+  folly::Logger straceLogger{"eden.strace"};
+  FakeFuse fuse;
+  std::unique_ptr<FuseChannel, FuseChannelDeleter> channel(new FuseChannel(
+      fuse.start(),
+      AbsolutePath{"/fuse_tester/load"},
+      FLAGS_numFuseThreads,
+      std::make_unique<LoadDispatcher>(
+          &stats, FLAGS_numFiles, FLAGS_fileSize),
+      &straceLogger,
+      std::make_shared<ProcessNameCache>(),
+      /*fsEventLogger=*/nullptr,
+      std::chrono::seconds(60),
+      /*notifications=*/nullptr,
+      CaseSensitivity::Sensitive,
+      /*requireUtf8Path=*/true,
+      /*maximumBackgroundRequests=*/12 /* the default on Linux */,
+      /*useWriteBackCache=*/false,
+      FLAGS_cloneFuseDevice,
+      /*numInvalidationThreads=*/1,
+      /*pinThreadsToNumaNodes=*/false,
+      /*useReaddirplus=*/false,
+      /*overloadConfig=*/{}));
+
+  auto initFuture = channel->initialize();
+  fuse.sendInitRequest();
+  auto initResponse = fuse.recvResponse();
+  if (initResponse.header.error != 0) {
+    fprintf(stderr, "error: FUSE_INIT failed: %d\n", initResponse.header.error);
+    return EX_SOFTWARE;
+  }
+  auto completionFuture = std::move(initFuture).get(10s);
+
+  XLOG(INFO) << "Sending requests for " << FLAGS_durationSeconds << "s";
+  std::atomic<size_t> nextRecorded{0};
+  LoadGenerator generator{fuse};
+  generator.run([&](size_t /*thread*/) {
+    if (!recorded.empty()) {
+      return recorded[nextRecorded.fetch_add(1) % recorded.size()];
+    }
+    return makeSyntheticRequest(weights, totalWeight);
+  });
+  generator.report();
+
+  // Closing the connection stops the channel, as unmounting would.
+  fuse.close();
+  auto stopData = std::move(completionFuture).get(10s);
+  XLOG(INFO) << "FUSE channel done; stop_reason=" << enumValue(stopData.reason);
+  return EX_OK;
+}
+
 void ensureEmptyDirectory(AbsolutePathPiece path) {
   boost::filesystem::path boostPath(
       path.stringPiece().begin(), path.stringPiece().end());
@@ -80,8 +647,12 @@ void ensureEmptyDirectory(AbsolutePathPiece path) {
 int main(int argc, char** argv) {
   // Make sure to run this before any flag values are read.
   folly::init(&argc, &argv);
+  if (FLAGS_load) {
+    return runLoad();
+  }
   if (argc != 2) {
     fprintf(stderr, "usage: test_mount PATH\n");
+    fprintf(stderr, "       test_mount --load [--replay FILE]\n");
     return EX_NOPERM;
   }
 
@@ -139,7 +710,12 @@ int main(int argc, char** argv) {
       CaseSensitivity::Sensitive,
       /*requireUtf8Path=*/true,
       /*maximumBackgroundRequests=*/12 /* the default on Linux */,
-      /*useWriteBackCache=*/false));
+      /*useWriteBackCache=*/false,
+      FLAGS_cloneFuseDevice,
+      /*numInvalidationThreads=*/1,
+      /*pinThreadsToNumaNodes=*/false,
+      /*useReaddirplus=*/false,
+      /*overloadConfig=*/{}));
 
   XLOG(INFO) << "Starting FUSE...";
   auto completionFuture = channel->initialize().get();
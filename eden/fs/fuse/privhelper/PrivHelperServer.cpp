@@ -18,6 +18,8 @@
 #include <folly/SocketAddress.h>
 #include <folly/String.h>
 #include <folly/Utility.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
 #include <folly/init/Init.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
@@ -70,6 +72,31 @@ void PrivHelperServer::init(folly::File&& socket, uid_t uid, gid_t gid) {
   initPartial(std::move(socket), uid, gid);
 }
 
+namespace {
+// EdenFS mounts all of its checkouts at once when it starts, but rarely more
+// than a handful of them.
+constexpr size_t kMountThreads = 8;
+
+/**
+ * Whether a message mounts or unmounts, and so may block for a while. The
+ * other messages are quick and update state read by mounts, so they are
+ * processed in order on the event base.
+ */
+bool isMountMessage(PrivHelperConn::MsgType msgType) {
+  switch (msgType) {
+    case PrivHelperConn::REQ_MOUNT_FUSE:
+    case PrivHelperConn::REQ_MOUNT_NFS:
+    case PrivHelperConn::REQ_MOUNT_BIND:
+    case PrivHelperConn::REQ_UNMOUNT_FUSE:
+    case PrivHelperConn::REQ_UNMOUNT_NFS:
+    case PrivHelperConn::REQ_UNMOUNT_BIND:
+      return true;
+    default:
+      return false;
+  }
+}
+} // namespace
+
 void PrivHelperServer::initPartial(folly::File&& socket, uid_t uid, gid_t gid) {
   // Make sure init() is only called once.
   XCHECK_EQ(uid_, std::numeric_limits<uid_t>::max());
@@ -90,6 +117,9 @@ void PrivHelperServer::initPartial(folly::File&& socket, uid_t uid, gid_t gid) {
   // NotificationQueue code checks to ensure that it isn't used across a fork.
   eventBase_ = std::make_unique<folly::EventBase>();
   conn_ = UnixSocket::makeUnique(eventBase_.get(), std::move(socket));
+  mountExecutor_ = std::make_unique<folly::CPUThreadPoolExecutor>(
+      kMountThreads,
+      std::make_shared<folly::NamedThreadFactory>("PrivHelperMount"));
   uid_ = uid;
   gid_ = gid;
 
@@ -836,7 +866,7 @@ UnixSocket::Message PrivHelperServer::processTakeoverStartupMsg(
 
   sanityCheckMountPoint(mountPath);
 
-  mountPoints_.insert(mountPath);
+  mountPoints_.wlock()->insert(mountPath);
   return makeResponse();
 }
 
@@ -849,7 +879,7 @@ UnixSocket::Message PrivHelperServer::processMountMsg(Cursor& cursor) {
   sanityCheckMountPoint(mountPath);
 
   auto fuseDev = fuseMount(mountPath.c_str(), readOnly);
-  mountPoints_.insert(mountPath);
+  mountPoints_.wlock()->insert(mountPath);
 
   return makeResponse(std::move(fuseDev));
 }
@@ -872,7 +902,7 @@ UnixSocket::Message PrivHelperServer::processMountNfsMsg(Cursor& cursor) {
   sanityCheckMountPoint(mountPath);
 
   nfsMount(mountPath, mountdAddr, nfsdAddr, readOnly, iosize, useReaddirplus);
-  mountPoints_.insert(mountPath);
+  mountPoints_.wlock()->insert(mountPath);
 
   return makeResponse();
 }
@@ -882,13 +912,12 @@ UnixSocket::Message PrivHelperServer::processUnmountMsg(Cursor& cursor) {
   PrivHelperConn::parseUnmountRequest(cursor, mountPath);
   XLOG(DBG3) << "unmount \"" << mountPath << "\"";
 
-  const auto it = mountPoints_.find(mountPath);
-  if (it == mountPoints_.end()) {
+  if (mountPoints_.rlock()->count(mountPath) == 0) {
     throw_<std::domain_error>("No FUSE mount found for ", mountPath);
   }
 
   unmount(mountPath.c_str());
-  mountPoints_.erase(mountPath);
+  mountPoints_.wlock()->erase(mountPath);
   return makeResponse();
 }
 
@@ -897,13 +926,12 @@ UnixSocket::Message PrivHelperServer::processNfsUnmountMsg(Cursor& cursor) {
   PrivHelperConn::parseNfsUnmountRequest(cursor, mountPath);
   XLOG(DBG3) << "unmount \"" << mountPath << "\"";
 
-  const auto it = mountPoints_.find(mountPath);
-  if (it == mountPoints_.end()) {
+  if (mountPoints_.rlock()->count(mountPath) == 0) {
     throw_<std::domain_error>("No NFS mount found for ", mountPath);
   }
 
   unmount(mountPath.c_str());
-  mountPoints_.erase(mountPath);
+  mountPoints_.wlock()->erase(mountPath);
   return makeResponse();
 }
 
@@ -913,17 +941,15 @@ UnixSocket::Message PrivHelperServer::processTakeoverShutdownMsg(
   PrivHelperConn::parseTakeoverShutdownRequest(cursor, mountPath);
   XLOG(DBG3) << "takeover shutdown \"" << mountPath << "\"";
 
-  const auto it = mountPoints_.find(mountPath);
-  if (it == mountPoints_.end()) {
+  if (mountPoints_.wlock()->erase(mountPath) == 0) {
     throw_<std::domain_error>("No mount found for ", mountPath);
   }
 
-  mountPoints_.erase(mountPath);
   return makeResponse();
 }
 
 std::string PrivHelperServer::findMatchingMountPrefix(folly::StringPiece path) {
-  for (const auto& mountPoint : mountPoints_) {
+  for (const auto& mountPoint : *mountPoints_.rlock()) {
     if (boost::starts_with(path, mountPoint + "/")) {
       return mountPoint;
     }
@@ -1004,7 +1030,9 @@ UnixSocket::Message PrivHelperServer::processSetUseEdenFs(
     folly::io::Cursor& cursor,
     UnixSocket::Message& /* request */) {
   XLOG(DBG3) << "set use /dev/edenfs";
-  PrivHelperConn::parseSetUseEdenFsRequest(cursor, useDevEdenFs_);
+  bool useDevEdenFs;
+  PrivHelperConn::parseSetUseEdenFsRequest(cursor, useDevEdenFs);
+  useDevEdenFs_ = useDevEdenFs;
 
   return makeResponse();
 }
@@ -1079,20 +1107,54 @@ void PrivHelperServer::run() {
   // too.
   XLOG(DBG5) << "privhelper process exiting";
 
+  // Let the mounts in progress finish, so that they get unmounted below.
+  mountExecutor_->join();
+
   // Unmount all active mount points
   cleanupMountPoints();
 }
 
 void PrivHelperServer::messageReceived(UnixSocket::Message&& message) noexcept {
   try {
-    processAndSendResponse(std::move(message));
+    Cursor cursor{&message.data};
+    cursor.skip(sizeof(uint32_t));
+    const auto msgType =
+        static_cast<PrivHelperConn::MsgType>(cursor.readBE<uint32_t>());
+    if (isMountMessage(msgType)) {
+      // The client waits for a mount to complete before it bind mounts in it
+      // or unmounts it, so these don't need to be ordered with each other.
+      mountExecutor_->add([this, message = std::move(message)]() mutable {
+        try {
+          auto response = processRequest(std::move(message));
+          eventBase_->runInEventBaseThread(
+              [this, response = std::move(response)]() mutable {
+                sendResponse(std::move(response));
+              });
+        } catch (const std::exception& ex) {
+          XLOG(ERR) << "error processing privhelper request: "
+                    << folly::exceptionStr(ex);
+        }
+      });
+      return;
+    }
+    sendResponse(processRequest(std::move(message)));
   } catch (const std::exception& ex) {
     XLOG(ERR) << "error processing privhelper request: "
               << folly::exceptionStr(ex);
   }
 }
 
-void PrivHelperServer::processAndSendResponse(UnixSocket::Message&& message) {
+void PrivHelperServer::sendResponse(UnixSocket::Message&& response) noexcept {
+  try {
+    conn_->send(std::move(response));
+  } catch (const std::exception& ex) {
+    XLOG(ERR) << "error sending privhelper response: "
+              << folly::exceptionStr(ex);
+  }
+}
+
+UnixSocket::Message PrivHelperServer::processRequest(
+    UnixSocket::Message&& message) {
   Cursor cursor{&message.data};
   const auto xid = cursor.readBE<uint32_t>();
   const auto msgType =
@@ -1133,7 +1195,7 @@ void PrivHelperServer::processAndSendResponse(UnixSocket::Message&& message) {
   respCursor.writeBE<uint32_t>(xid);
   respCursor.writeBE<uint32_t>(responseType);
 
-  conn_->send(std::move(response));
+  return response;
 }
 
 UnixSocket::Message PrivHelperServer::makeResponse() {
@@ -1207,7 +1269,8 @@ void PrivHelperServer::receiveError(
 }
 
 void PrivHelperServer::cleanupMountPoints() {
-  for (const auto& mountPoint : mountPoints_) {
+  auto mountPoints = mountPoints_.wlock();
+  for (const auto& mountPoint : *mountPoints) {
     try {
       unmount(mountPoint.c_str());
     } catch (const std::exception& ex) {
@@ -1216,7 +1279,7 @@ void PrivHelperServer::cleanupMountPoints() {
     }
   }
 
-  mountPoints_.clear();
+  mountPoints->clear();
 }
 
 } // namespace facebook::eden
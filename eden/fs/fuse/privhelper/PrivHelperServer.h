@@ -7,8 +7,11 @@
 
 #pragma once
 
+#include <folly/Synchronized.h>
 #include <sys/types.h>
+#include <atomic>
 #include <limits>
+#include <memory>
 #include <set>
 #include <string>
 #include <unordered_map>
@@ -16,6 +19,7 @@
 #include "eden/fs/utils/UnixSocket.h"
 
 namespace folly {
+class CPUThreadPoolExecutor;
 class EventBase;
 class File;
 class SocketAddress;
@@ -70,7 +74,12 @@ class PrivHelperServer : private UnixSocket::ReceiveCallback {
   void socketClosed() noexcept override;
   void receiveError(const folly::exception_wrapper& ew) noexcept override;
 
-  void processAndSendResponse(UnixSocket::Message&& message);
+  /**
+   * Processes a request and returns the response to send back, with its
+   * header.
+   */
+  UnixSocket::Message processRequest(UnixSocket::Message&& message);
+  void sendResponse(UnixSocket::Message&& response) noexcept;
   UnixSocket::Message processMessage(
       PrivHelperConn::MsgType msgType,
       folly::io::Cursor& cursor,
@@ -127,12 +136,18 @@ class PrivHelperServer : private UnixSocket::ReceiveCallback {
   UnixSocket::UniquePtr conn_;
   uid_t uid_{std::numeric_limits<uid_t>::max()};
   gid_t gid_{std::numeric_limits<gid_t>::max()};
-  std::chrono::nanoseconds fuseTimeout_{std::chrono::seconds(60)};
-  bool useDevEdenFs_{false};
+  std::atomic<std::chrono::nanoseconds> fuseTimeout_{
+      std::chrono::seconds(60)};
+  std::atomic<bool> useDevEdenFs_{false};
+
+  /**
+   * Mounts and unmounts run on these threads rather than on the event base,
+   * so that a slow mount, like an NFS one waiting on the kernel, doesn't hold
+   * up the mounts of the other checkouts while EdenFS starts.
+   */
+  std::unique_ptr<folly::CPUThreadPoolExecutor> mountExecutor_;
 
-  // The privhelper server only has a single thread,
-  // so we don't need to lock the following state
-  std::set<std::string> mountPoints_;
+  folly::Synchronized<std::set<std::string>> mountPoints_;
 };
 
 } // namespace facebook::eden
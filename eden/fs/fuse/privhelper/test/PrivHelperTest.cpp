@@ -243,6 +243,28 @@ TEST_F(PrivHelperTest, fuseMount) {
   // from the unmount operation.
 }
 
+TEST_F(PrivHelperTest, fuseMountsRunConcurrently) {
+  auto mountPoint1 = makeTempDir("foo");
+  auto path1 = mountPoint1.path().string();
+  auto mountPoint2 = makeTempDir("bar");
+  auto path2 = mountPoint2.path().string();
+
+  auto filePromise1 = server_.setFuseMountResult(path1);
+  auto filePromise2 = server_.setFuseMountResult(path2);
+
+  auto result1 = client_->fuseMount(path1, false);
+  auto result2 = client_->fuseMount(path2, false);
+
+  // The second mount completes while the first one is still in progress.
+  TemporaryFile tempFile;
+  filePromise2.setValue(File(tempFile.fd(), /* ownsFD */ false));
+  std::move(result2).get(1s);
+  EXPECT_FALSE(result1.isReady());
+
+  filePromise1.setValue(File(tempFile.fd(), /* ownsFD */ false));
+  std::move(result1).get(1s);
+}
+
 TEST_F(PrivHelperTest, fuseMountPermissions) {
   if (getuid() != 0) {
     auto path = folly::kIsApple ? "/var/root/bar" : "/root/bar";
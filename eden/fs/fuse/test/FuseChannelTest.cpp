@@ -66,7 +66,9 @@ fuse_entry_out genRandomLookupResponse(uint64_t nodeid) {
 class FuseChannelTest : public ::testing::Test {
  protected:
   unique_ptr<FuseChannel, FuseChannelDeleter> createChannel(
-      size_t numThreads = 2) {
+      size_t numThreads = 2,
+      bool cloneDevicePerThread = false,
+      size_t numInvalidationThreads = 1) {
     auto testDispatcher = std::make_unique<TestDispatcher>(&stats_);
     dispatcher_ = testDispatcher.get();
     return unique_ptr<FuseChannel, FuseChannelDeleter>(new FuseChannel(
@@ -82,7 +84,12 @@ class FuseChannelTest : public ::testing::Test {
         CaseSensitivity::Sensitive,
         /*requireUtf8Path=*/true,
         /*maximumBackgroundRequests=*/12,
-        /*useWriteBackCache=*/false));
+        /*useWriteBackCache=*/false,
+        cloneDevicePerThread,
+        numInvalidationThreads,
+        /*pinThreadsToNumaNodes=*/false,
+        /*useReaddirplus=*/false,
+        /*overloadConfig=*/{}));
   }
 
   FuseChannel::StopFuture performInit(
@@ -190,6 +197,69 @@ TEST_F(FuseChannelTest, testTakeoverStop) {
   EXPECT_EQ(flags, stopData.fuseSettings.flags);
 }
 
+#ifdef __linux__
+TEST_F(FuseChannelTest, testInitRequestsLargeReads) {
+  auto channel = createChannel();
+  auto completeFuture = performInit(
+      channel.get(),
+      FUSE_KERNEL_VERSION,
+      FUSE_KERNEL_MINOR_VERSION,
+      /*maxReadahead=*/0,
+      FUSE_ASYNC_READ | FUSE_MAX_PAGES);
+
+  channel->takeoverStop();
+
+  auto stopData = std::move(completeFuture).get(kTimeout);
+  EXPECT_EQ(FUSE_ASYNC_READ | FUSE_MAX_PAGES, stopData.fuseSettings.flags);
+  EXPECT_EQ(256, stopData.fuseSettings.max_pages);
+}
+#endif
+
+TEST_F(FuseChannelTest, testCloneFallsBackToSharedDevice) {
+  // FakeFuse is a socket, which cannot be cloned, so the worker threads must
+  // fall back to sharing it and still serve requests.
+  auto channel = createChannel(2, /*cloneDevicePerThread=*/true);
+  auto completeFuture = performInit(channel.get());
+
+  fuse_lk_in lk{};
+  auto unique = fuse_.sendRequest(FUSE_GETLK, FUSE_ROOT_ID, lk);
+  auto response = fuse_.recvResponse();
+  EXPECT_EQ(unique, response.header.unique);
+  EXPECT_EQ(-ENOSYS, response.header.error);
+
+  channel->takeoverStop();
+  auto stopData = std::move(completeFuture).get(kTimeout);
+  EXPECT_EQ(stopData.reason, FuseChannel::StopReason::TAKEOVER);
+  EXPECT_TRUE(stopData.fuseDevice);
+}
+
+TEST_F(FuseChannelTest, duplicateInvalidationsAreSentOnce) {
+  auto channel = createChannel(2, false, /*numInvalidationThreads=*/3);
+  auto completeFuture = performInit(channel.get());
+
+  // Enough distinct inodes to spread the batch over every invalidation
+  // thread, each queued twice.
+  std::vector<InodeNumber> inodes;
+  for (uint64_t i = 0; i < 200; ++i) {
+    inodes.push_back(InodeNumber{100 + i % 100});
+  }
+  channel->invalidateInodes(folly::range(inodes));
+  std::move(channel->flushInvalidations()).get(kTimeout);
+
+  std::unordered_map<uint64_t, size_t> sent;
+  for (const auto& response : fuse_.getAllResponses()) {
+    ASSERT_EQ(FUSE_NOTIFY_INVAL_INODE, response.header.error);
+    ASSERT_EQ(sizeof(fuse_notify_inval_inode_out), response.body.size());
+    const auto* notify = reinterpret_cast<const fuse_notify_inval_inode_out*>(
+        response.body.data());
+    ++sent[notify->ino];
+  }
+  EXPECT_EQ(100u, sent.size());
+  for (const auto& [ino, count] : sent) {
+    EXPECT_EQ(1u, count) << "inode " << ino;
+  }
+}
+
 TEST_F(FuseChannelTest, testInitUnmountRace) {
   auto channel = createChannel();
   auto completeFuture = performInit(channel.get());
@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/AccessPrefetcher.h"
+
+#include <folly/futures/Future.h>
+#include <folly/logging/xlog.h>
+
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/model/TreeEntry.h"
+#include "eden/fs/store/ImportPriority.h"
+#include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/telemetry/EdenStats.h"
+#include "eden/fs/utils/ImmediateFuture.h"
+
+namespace facebook::eden {
+
+namespace {
+
+class LearnedPrefetchContext : public ObjectFetchContext {
+ public:
+  explicit LearnedPrefetchContext(pid_t clientPid) : clientPid_{clientPid} {}
+
+  ImportPriority getPriority() const override {
+    return kReaddirPrefetchPriority;
+  }
+  std::optional<pid_t> getClientPid() const override {
+    return clientPid_;
+  }
+  Cause getCause() const override {
+    return Cause::Prefetch;
+  }
+  const std::unordered_map<std::string, std::string>* FOLLY_NULLABLE
+  getRequestInfo() const override {
+    return nullptr;
+  }
+
+ private:
+  pid_t clientPid_;
+};
+
+struct PredictedBlob {
+  RelativePath path;
+  ObjectId id;
+  uint64_t size;
+};
+
+} // namespace
+
+AccessPrefetcher::AccessPrefetcher(EdenMount& mount)
+    : mount_{mount},
+      modelStore_{mount.getObjectStore()->getLocalStore()} {}
+
+bool AccessPrefetcher::isEnabled() const {
+  return mount_.getEdenConfig()->enableLearnedPrefetch.getValue();
+}
+
+Hash20 AccessPrefetcher::getModelKey(RelativePathPiece trigger) const {
+  std::string key = mount_.getPath().value();
+  key.push_back('\0');
+  key.append(trigger.view());
+  return Hash20::sha1(key);
+}
+
+void AccessPrefetcher::recordRead(pid_t pid, RelativePath path) {
+  auto config = mount_.getEdenConfig();
+  auto window = config->learnedPrefetchWindow.getValue();
+  auto maxFiles = config->learnedPrefetchMaxFiles.getValue();
+  auto now = std::chrono::steady_clock::now();
+
+  std::vector<Session> finished;
+  uint64_t sessionId;
+  {
+    auto sessions = sessions_.wlock();
+    auto it = sessions->find(pid);
+    if (it != sessions->end() && now - it->second.lastRead <= window) {
+      auto& session = it->second;
+      session.lastRead = now;
+      if (session.prefetched.erase(path) != 0) {
+        mount_.getStats()->increment(&AccessPrefetcherStats::hits);
+      }
+      if (path != session.trigger && session.reads.size() < maxFiles &&
+          session.seen.insert(path).second) {
+        session.reads.push_back(std::move(path));
+      }
+      return;
+    }
+
+    if (it != sessions->end()) {
+      finished.push_back(std::move(it->second));
+      sessions->erase(it);
+    } else if (sessions->size() >= kMaxSessions) {
+      for (auto expired = sessions->begin(); expired != sessions->end();) {
+        if (now - expired->second.lastRead > window) {
+          finished.push_back(std::move(expired->second));
+          expired = sessions->erase(expired);
+        } else {
+          ++expired;
+        }
+      }
+      if (sessions->size() >= kMaxSessions) {
+        // Too many processes are reading files concurrently, their sessions
+        // can't be told apart reliably enough to learn from them.
+        return;
+      }
+    }
+
+    sessionId = ++nextSessionId_;
+    sessions->emplace(pid, Session{sessionId, path, now});
+  }
+
+  // Learning and predicting read from and write to the LocalStore, don't
+  // block the FUSE or NFS thread on them.
+  folly::via(
+      mount_.getServerThreadPool().get(),
+      [mount = mount_.getWeakMount(),
+       finished = std::move(finished),
+       pid,
+       sessionId,
+       path = std::move(path)]() mutable {
+        auto edenMount = mount.lock();
+        if (!edenMount) {
+          return;
+        }
+        auto& prefetcher = edenMount->getAccessPrefetcher();
+        for (auto& session : finished) {
+          prefetcher.finishSession(std::move(session));
+        }
+        prefetcher.prefetchFollowers(pid, sessionId, std::move(path));
+      });
+}
+
+void AccessPrefetcher::flush() {
+  SessionMap sessions;
+  sessions_.wlock()->swap(sessions);
+  for (auto& [pid, session] : sessions) {
+    finishSession(std::move(session));
+  }
+}
+
+void AccessPrefetcher::finishSession(Session session) {
+  auto* stats = mount_.getStats();
+  for (const auto& [path, size] : session.prefetched) {
+    stats->increment(&AccessPrefetcherStats::wastedBlobs);
+    stats->increment(&AccessPrefetcherStats::wastedBytes, size);
+  }
+
+  auto key = getModelKey(session.trigger);
+  auto model = modelStore_.get(key);
+  if (!model && session.reads.empty()) {
+    // Don't store a model for every file that is read on its own.
+    return;
+  }
+  if (!model) {
+    model.emplace();
+  }
+  model->learn(
+      session.reads,
+      mount_.getEdenConfig()->learnedPrefetchMaxFiles.getValue());
+  modelStore_.put(key, *model);
+  stats->increment(&AccessPrefetcherStats::modelsLearned);
+}
+
+void AccessPrefetcher::prefetchFollowers(
+    pid_t pid,
+    uint64_t sessionId,
+    RelativePath trigger) {
+  auto model = modelStore_.get(getModelKey(trigger));
+  auto minSessions =
+      mount_.getEdenConfig()->learnedPrefetchMinSessions.getValue();
+  if (!model || model->sessions < std::max(minSessions, uint32_t{1})) {
+    return;
+  }
+
+  ObjectFetchContextPtr context = makeRefPtr<LearnedPrefetchContext>(pid);
+  std::vector<ImmediateFuture<std::optional<PredictedBlob>>> futures;
+  for (auto& follower : model->followers) {
+    // Followers are sorted by decreasing number of sessions.
+    if (uint64_t{follower.sessions} * 2 < model->sessions) {
+      break;
+    }
+    futures.push_back(
+        mount_.getTreeOrTreeEntry(follower.path, context)
+            .thenTry([path = std::move(follower.path)](
+                         folly::Try<std::variant<
+                             std::shared_ptr<const Tree>,
+                             TreeEntry>> result) mutable
+                     -> std::optional<PredictedBlob> {
+              // The file may have been removed, or replaced by a directory,
+              // since the model was learned.
+              if (result.hasException()) {
+                return std::nullopt;
+              }
+              auto* entry = std::get_if<TreeEntry>(&result.value());
+              if (!entry || entry->isTree()) {
+                return std::nullopt;
+              }
+              return PredictedBlob{
+                  std::move(path),
+                  entry->getHash(),
+                  entry->getSize().value_or(0)};
+            }));
+  }
+  if (futures.empty()) {
+    return;
+  }
+
+  // The resolution of the paths may complete asynchronously, run the rest on
+  // the server thread pool.
+  collectAllSafe(std::move(futures))
+      .thenValue([mount = mount_.getWeakMount(),
+                  pid,
+                  sessionId,
+                  context = context.copy()](
+                     std::vector<std::optional<PredictedBlob>> predicted) {
+        auto edenMount = mount.lock();
+        if (!edenMount) {
+          return ImmediateFuture<folly::Unit>{folly::unit};
+        }
+        auto& prefetcher = edenMount->getAccessPrefetcher();
+
+        auto ids = std::make_shared<std::vector<ObjectId>>();
+        {
+          auto sessions = prefetcher.sessions_.wlock();
+          auto it = sessions->find(pid);
+          if (it == sessions->end() || it->second.id != sessionId) {
+            // The session ended before its files were resolved.
+            return ImmediateFuture<folly::Unit>{folly::unit};
+          }
+          auto& session = it->second;
+          for (auto& blob : predicted) {
+            if (!blob || session.seen.count(blob->path) != 0) {
+              continue;
+            }
+            ids->push_back(blob->id);
+            session.prefetched.emplace(std::move(blob->path), blob->size);
+          }
+        }
+        if (ids->empty()) {
+          return ImmediateFuture<folly::Unit>{folly::unit};
+        }
+
+        auto* stats = edenMount->getStats();
+        stats->increment(&AccessPrefetcherStats::prefetches);
+        stats->increment(&AccessPrefetcherStats::prefetchedBlobs, ids->size());
+        XLOG(DBG4) << "prefetching " << ids->size() << " files learned from "
+                   << "previous reads";
+        return edenMount->getObjectStore()
+            ->prefetchBlobs(*ids, context)
+            .ensure([ids, edenMount] {});
+      })
+      .thenError([](const folly::exception_wrapper& ew) {
+        XLOG(DBG3) << "learned prefetch failed: " << ew.what();
+        return folly::unit;
+      })
+      .semi()
+      .via(mount_.getServerThreadPool().get());
+}
+
+} // namespace facebook::eden
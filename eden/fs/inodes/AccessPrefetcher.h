@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <folly/container/F14Set.h>
+#include <sys/types.h>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include "eden/fs/model/Hash.h"
+#include "eden/fs/store/AccessModelStore.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+class EdenMount;
+
+/**
+ * Learns which files processes read after reading a given file, and
+ * prefetches them the next time that file is read.
+ *
+ * The reads of a process are grouped in sessions: a session starts with the
+ * first file read by a process, its trigger, and lasts as long as the
+ * process keeps reading files without pausing for more than
+ * learned-prefetch-window. When a session ends, the files read during it are
+ * learned into the AccessModel of its trigger, stored in the LocalStore.
+ *
+ * When a session starts, the files that followed its trigger in at least half
+ * of the previous sessions are prefetched at a low priority.
+ */
+class AccessPrefetcher {
+ public:
+  explicit AccessPrefetcher(EdenMount& mount);
+
+  AccessPrefetcher(const AccessPrefetcher&) = delete;
+  AccessPrefetcher& operator=(const AccessPrefetcher&) = delete;
+
+  bool isEnabled() const;
+
+  /**
+   * Records that the given process started reading the file at path.
+   */
+  void recordRead(pid_t pid, RelativePath path);
+
+  /**
+   * Ends every session and synchronously learns from them.
+   */
+  void flush();
+
+ private:
+  // Bounds the memory used by processes that read a single file and exit.
+  static constexpr size_t kMaxSessions = 1024;
+
+  struct Session {
+    Session(
+        uint64_t id,
+        RelativePath trigger,
+        std::chrono::steady_clock::time_point now)
+        : id{id}, trigger{std::move(trigger)}, lastRead{now} {}
+
+    uint64_t id;
+    RelativePath trigger;
+    std::chrono::steady_clock::time_point lastRead;
+    // The files read after the trigger, in order.
+    std::vector<RelativePath> reads;
+    folly::F14FastSet<RelativePath> seen;
+    // The prefetched files not read yet, with their size.
+    folly::F14FastMap<RelativePath, uint64_t> prefetched;
+  };
+
+  using SessionMap = folly::F14NodeMap<pid_t, Session>;
+
+  Hash20 getModelKey(RelativePathPiece trigger) const;
+
+  /**
+   * Learns from the session, and accounts the prefetched files that weren't
+   * read as wasted.
+   */
+  void finishSession(Session session);
+
+  /**
+   * Prefetches the files predicted to be read in the given session.
+   */
+  void prefetchFollowers(pid_t pid, uint64_t sessionId, RelativePath trigger);
+
+  EdenMount& mount_;
+  AccessModelStore modelStore_;
+  folly::Synchronized<SessionMap> sessions_;
+  std::atomic<uint64_t> nextSessionId_{0};
+};
+
+} // namespace facebook::eden
@@ -131,14 +131,16 @@ Future<InvalidationRequired> CheckoutAction::run(
               rc->error("error getting old tree", std::move(ew));
             });
       } else {
-        store->getBlobSha1(oldEntry.second.getHash(), ctx->getFetchContext())
-            .thenValue([rc = LoadingRefcount(this)](Hash20 oldBlobSha1) {
-              rc->setOldBlob(std::move(oldBlobSha1));
+        store
+            ->getBlobMetadata(
+                oldEntry.second.getHash(), ctx->getFetchContext())
+            .thenValue([rc = LoadingRefcount(this)](BlobMetadata metadata) {
+              rc->setOldBlob(std::move(metadata));
             })
             .semi()
             .via(&folly::QueuedImmediateExecutor::instance())
             .thenError([rc = LoadingRefcount(this)](exception_wrapper&& ew) {
-              rc->error("error getting old blob Sha1", std::move(ew));
+              rc->error("error getting old blob metadata", std::move(ew));
             });
       }
     }
@@ -186,14 +188,14 @@ Future<InvalidationRequired> CheckoutAction::run(
 
 void CheckoutAction::setOldTree(std::shared_ptr<const Tree> tree) {
   XCHECK(!oldTree_);
-  XCHECK(!oldBlobSha1_);
+  XCHECK(!oldBlobMetadata_);
   oldTree_ = std::move(tree);
 }
 
-void CheckoutAction::setOldBlob(Hash20 blobSha1) {
+void CheckoutAction::setOldBlob(BlobMetadata blobMetadata) {
   XCHECK(!oldTree_);
-  XCHECK(!oldBlobSha1_);
-  oldBlobSha1_ = std::move(blobSha1);
+  XCHECK(!oldBlobMetadata_);
+  oldBlobMetadata_ = std::move(blobMetadata);
 }
 
 void CheckoutAction::setNewTree(std::shared_ptr<const Tree> tree) {
@@ -256,7 +258,7 @@ bool CheckoutAction::ensureDataReady() noexcept {
   // Make sure we actually have all the data we need.
   // (Just in case something went wrong when wiring up the callbacks in such a
   // way that we also failed to call error().)
-  if (oldScmEntry_.has_value() && (!oldTree_ && !oldBlobSha1_)) {
+  if (oldScmEntry_.has_value() && (!oldTree_ && !oldBlobMetadata_)) {
     promise_.setException(
         std::runtime_error("failed to load data for old TreeEntry"));
     return false;
@@ -329,7 +331,7 @@ Future<bool> CheckoutAction::hasConflict() {
     // conflicts for individual leaf inodes that were modified, and not for the
     // parent directories.
     return false;
-  } else if (oldBlobSha1_) {
+  } else if (oldBlobMetadata_) {
     auto fileInode = inode_.asFilePtrOrNull();
     if (!fileInode) {
       // This was a file, but has been replaced with a directory on disk
@@ -341,7 +343,7 @@ Future<bool> CheckoutAction::hasConflict() {
     return fileInode
         ->isSameAs(
             oldScmEntry_.value().second.getHash(),
-            oldBlobSha1_.value(),
+            oldBlobMetadata_.value(),
             oldScmEntry_.value().second.getType(),
             ctx_->getFetchContext())
         .thenValue([this](bool isSame) {
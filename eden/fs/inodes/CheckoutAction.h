@@ -13,6 +13,7 @@
 #include <vector>
 #include "eden/fs/fuse/Invalidation.h"
 #include "eden/fs/inodes/InodePtr.h"
+#include "eden/fs/model/BlobMetadata.h"
 #include "eden/fs/model/Tree.h"
 
 namespace folly {
@@ -113,7 +114,7 @@ class CheckoutAction {
       folly::Future<InodePtr> inodeFuture);
 
   void setOldTree(std::shared_ptr<const Tree> tree);
-  void setOldBlob(Hash20 blobSha1);
+  void setOldBlob(BlobMetadata blobMetadata);
   void setNewTree(std::shared_ptr<const Tree> tree);
   void setNewBlob();
   void setInode(InodePtr inode);
@@ -172,13 +173,14 @@ class CheckoutAction {
    * and the same goes for newTree_ and newBlob_.
    *
    * Note that for trees we download the full tree. For the old blob we
-   * only download the sha1 as this is all we will need. We don't actually ever
-   * need the data from new blob.  So we just record if the destination is
-   * a new blob, and not bother loading the blob data itself.
+   * only download its metadata (sha1 and size) as this is all we will
+   * need. We don't actually ever need the data from new blob.  So we just
+   * record if the destination is a new blob, and not bother loading the blob
+   * data itself.
    */
   InodePtr inode_;
   std::shared_ptr<const Tree> oldTree_;
-  std::optional<Hash20> oldBlobSha1_;
+  std::optional<BlobMetadata> oldBlobMetadata_;
   std::shared_ptr<const Tree> newTree_;
   bool newBlobMarker_ = false;
 
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/CheckoutCheckpoint.h"
+
+#include <folly/Exception.h>
+#include <folly/FileUtil.h>
+#include <folly/String.h>
+#include <folly/logging/xlog.h>
+#include <folly/portability/Fcntl.h>
+#include <string>
+#include <vector>
+
+#include "eden/fs/utils/FileUtils.h"
+
+namespace facebook::eden {
+
+namespace {
+
+constexpr folly::StringPiece kMagic{"eden-checkout-checkpoint-1"};
+
+std::string makeHeader(const RootId& fromRoot, const RootId& toRoot) {
+  std::string header = kMagic.str();
+  header.push_back('\0');
+  header.append(fromRoot.value());
+  header.push_back('\0');
+  header.append(toRoot.value());
+  header.push_back('\0');
+  return header;
+}
+
+} // namespace
+
+CheckoutCheckpoint::CheckoutCheckpoint(
+    AbsolutePath path,
+    const RootId& fromRoot,
+    const RootId& toRoot,
+    bool resume)
+    : path_{std::move(path)} {
+  auto header = makeHeader(fromRoot, toRoot);
+  // The part of the file to keep: everything up to the last complete record.
+  std::string contents = header;
+  if (resume) {
+    auto existing = readFile(path_);
+    if (existing.hasValue() &&
+        folly::StringPiece{existing.value()}.startsWith(header)) {
+      std::vector<folly::StringPiece> records;
+      folly::split('\0', existing.value(), records);
+      // The header takes the first three records, and the piece after the
+      // last NUL is either empty or a record cut short.
+      auto kept = header.size();
+      try {
+        for (size_t i = 3; i + 1 < records.size(); ++i) {
+          completed_.emplace(records[i]);
+          kept += records[i].size() + 1;
+        }
+      } catch (const std::exception& ex) {
+        XLOG(WARN) << "ignoring corrupt checkout checkpoint " << path_ << ": "
+                   << folly::exceptionStr(ex);
+        completed_.clear();
+        kept = header.size();
+      }
+      contents = existing.value().substr(0, kept);
+    }
+  }
+
+  try {
+    writeFileAtomic(path_, folly::ByteRange{folly::StringPiece{contents}})
+        .value();
+    *file_.lock() =
+        folly::File{path_.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC};
+  } catch (const std::exception& ex) {
+    disable(ex);
+  }
+  XLOG(DBG2) << "checkout checkpoint " << path_ << " resumes "
+             << completed_.size() << " completed directories";
+}
+
+void CheckoutCheckpoint::markComplete(RelativePathPiece path) {
+  std::string record{path.view()};
+  record.push_back('\0');
+
+  auto file = file_.lock();
+  if (!file->has_value()) {
+    return;
+  }
+  try {
+    folly::checkUnixError(
+        folly::writeFull((*file)->fd(), record.data(), record.size()),
+        "failed to append to ",
+        path_);
+  } catch (const std::exception& ex) {
+    file.unlock();
+    disable(ex);
+  }
+}
+
+void CheckoutCheckpoint::remove() {
+  file_.lock()->reset();
+  try {
+    removeFileWithAbsolutePath(path_);
+  } catch (const std::exception& ex) {
+    XLOG(WARN) << "failed to remove checkout checkpoint " << path_ << ": "
+               << folly::exceptionStr(ex);
+  }
+}
+
+void CheckoutCheckpoint::disable(const std::exception& ex) {
+  XLOG(WARN) << "disabling checkout checkpoint " << path_ << ": "
+             << folly::exceptionStr(ex);
+  file_.lock()->reset();
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/File.h>
+#include <folly/Synchronized.h>
+#include <mutex>
+#include <optional>
+#include <unordered_set>
+
+#include "eden/fs/model/RootId.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/**
+ * Records on disk the directories that a checkout finished updating, so that
+ * the checkout can skip them if it is interrupted and then resumed.
+ *
+ * The file starts with the IDs of the source and destination commits,
+ * followed by the NUL-terminated path of each completed directory. Every path
+ * is appended with a single write: a path cut short by a crash is ignored.
+ *
+ * Checkpointing is best effort: failing to write the file disables it rather
+ * than failing the checkout, which only makes a later resume redo more work.
+ */
+class CheckoutCheckpoint {
+ public:
+  /**
+   * If resume is true and the file at path was written by a checkout from
+   * fromRoot to toRoot, the directories it records are reported complete.
+   * Otherwise, the file is started over.
+   */
+  CheckoutCheckpoint(
+      AbsolutePath path,
+      const RootId& fromRoot,
+      const RootId& toRoot,
+      bool resume);
+
+  CheckoutCheckpoint(const CheckoutCheckpoint&) = delete;
+  CheckoutCheckpoint& operator=(const CheckoutCheckpoint&) = delete;
+
+  /**
+   * Whether the interrupted checkout being resumed completed this directory.
+   */
+  bool isComplete(RelativePathPiece path) const {
+    return completed_.count(RelativePath{path}) != 0;
+  }
+
+  /**
+   * Number of directories completed by the interrupted checkout.
+   */
+  size_t getResumedCount() const {
+    return completed_.size();
+  }
+
+  /**
+   * Record that a directory and everything under it was updated.
+   *
+   * May be called concurrently.
+   */
+  void markComplete(RelativePathPiece path);
+
+  /**
+   * Remove the file once the checkout is complete.
+   */
+  void remove();
+
+ private:
+  void disable(const std::exception& ex);
+
+  const AbsolutePath path_;
+  std::unordered_set<RelativePath> completed_;
+  /** Unset once checkpointing is disabled. */
+  folly::Synchronized<std::optional<folly::File>, std::mutex> file_;
+};
+
+} // namespace facebook::eden
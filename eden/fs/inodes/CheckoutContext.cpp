@@ -12,6 +12,9 @@
 #include <optional>
 
 #include "eden/fs/config/CheckoutConfig.h"
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/inodes/CheckoutCheckpoint.h"
+#include "eden/fs/inodes/CheckoutTreePrefetcher.h"
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/InodePtr.h"
 #include "eden/fs/inodes/TreeInode.h"
@@ -35,7 +38,11 @@ CheckoutContext::CheckoutContext(
           thriftMethodName,
           requestInfo)} {}
 
-CheckoutContext::~CheckoutContext() {}
+CheckoutContext::~CheckoutContext() {
+  if (treePrefetcher_) {
+    treePrefetcher_->stop();
+  }
+}
 
 void CheckoutContext::start(
     RenameLock&& renameLock,
@@ -70,6 +77,94 @@ void CheckoutContext::start(
   }
 }
 
+void CheckoutContext::startCheckpoint(
+    const RootId& fromRoot,
+    const RootId& toRoot,
+    bool resume) {
+  XCHECK(!isDryRun());
+  checkpoint_ = std::make_unique<CheckoutCheckpoint>(
+      mount_->getCheckoutConfig()->getCheckoutCheckpointPath(),
+      fromRoot,
+      toRoot,
+      resume);
+}
+
+bool CheckoutContext::isSubtreeCheckpointed(RelativePathPiece path) {
+  if (!checkpoint_ || !checkpoint_->isComplete(path)) {
+    return false;
+  }
+  directoriesResumed_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+void CheckoutContext::markSubtreeComplete(RelativePathPiece path) {
+  // The root is only complete once the whole checkout is, at which point the
+  // checkpoint is removed.
+  if (!checkpoint_ || path.empty()) {
+    return;
+  }
+  {
+    auto conflicts = conflicts_.rlock();
+    for (const auto& conflict : *conflicts) {
+      auto conflictPath = RelativePathPiece{*conflict.path_ref()};
+      if (conflictPath == path || path.isParentDirOf(conflictPath)) {
+        return;
+      }
+    }
+  }
+  checkpoint_->markComplete(path);
+}
+
+CheckoutProgress CheckoutContext::getProgress() const {
+  CheckoutProgress progress;
+  progress.directoriesStarted =
+      directoriesStarted_.load(std::memory_order_relaxed);
+  progress.directoriesFinished =
+      directoriesFinished_.load(std::memory_order_relaxed);
+  progress.directoriesResumed =
+      directoriesResumed_.load(std::memory_order_relaxed);
+  progress.entriesUpdated = entriesUpdated_.load(std::memory_order_relaxed);
+  progress.treesFetched = fetchContext_->countFetchesOfTypeAndOrigin(
+      ObjectFetchContext::Tree, ObjectFetchContext::FromNetworkFetch);
+  progress.blobsFetched = fetchContext_->countFetchesOfTypeAndOrigin(
+      ObjectFetchContext::Blob, ObjectFetchContext::FromNetworkFetch);
+  progress.blobMetadataFetched = fetchContext_->countFetchesOfTypeAndOrigin(
+      ObjectFetchContext::BlobMetadata, ObjectFetchContext::FromNetworkFetch);
+  progress.elapsed = stopWatch_.elapsed();
+
+  // Directories are only known once their parent is processed, so the
+  // estimate grows as the checkout discovers more of them.
+  if (progress.directoriesFinished > 0 &&
+      progress.directoriesStarted >= progress.directoriesFinished) {
+    progress.estimatedRemaining = progress.elapsed *
+        (progress.directoriesStarted - progress.directoriesFinished) /
+        progress.directoriesFinished;
+  }
+  return progress;
+}
+
+void CheckoutContext::prefetchTrees(
+    std::shared_ptr<const Tree> fromTree,
+    std::shared_ptr<const Tree> toTree) {
+  XCHECK(!treePrefetcher_);
+  auto concurrency =
+      mount_->getEdenConfig()->checkoutTreePrefetchConcurrency.getValue();
+  if (concurrency == 0) {
+    return;
+  }
+  treePrefetcher_ = std::make_shared<CheckoutTreePrefetcher>(
+      mount_->getObjectStorePtr(), getFetchContext(), concurrency);
+  treePrefetcher_->start(std::move(fromTree), std::move(toTree));
+}
+
+void CheckoutContext::recordTreePrefetch(CheckoutTimes& times) const {
+  if (!treePrefetcher_) {
+    return;
+  }
+  times.treePrefetch = treePrefetcher_->getDuration();
+  times.treesPrefetched = treePrefetcher_->getTreesFetched();
+}
+
 Future<vector<CheckoutConflict>> CheckoutContext::finish(RootId newSnapshot) {
   auto config = mount_->getCheckoutConfig();
 
@@ -83,6 +178,16 @@ Future<vector<CheckoutConflict>> CheckoutContext::finish(RootId newSnapshot) {
     config->setCheckedOutCommit(newSnapshot);
   }
 
+  // Checkout has visited every directory it needed; anything still queued
+  // for prefetch is no longer useful.
+  if (treePrefetcher_) {
+    treePrefetcher_->stop();
+  }
+
+  if (checkpoint_) {
+    checkpoint_->remove();
+  }
+
   // Release the rename lock.
   // This allows any filesystem unlink() or rename() operations to proceed.
   renameLock_.unlock();
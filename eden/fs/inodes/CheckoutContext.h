@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
 #include <optional>
 #include <unordered_map>
 #include <vector>
@@ -30,7 +32,9 @@ struct Unit;
 
 namespace facebook::eden {
 
+class CheckoutCheckpoint;
 class CheckoutConflict;
+class CheckoutTreePrefetcher;
 class TreeInode;
 class Tree;
 
@@ -87,6 +91,63 @@ class CheckoutContext {
       RootId newSnapshot,
       std::shared_ptr<const Tree> toTree);
 
+  /**
+   * Record the directories that this checkout completes in the mount's
+   * checkpoint file, and, when resuming the checkout from fromRoot to toRoot,
+   * skip those recorded by the interrupted one.
+   *
+   * Must be called after start(), and not for a dry run.
+   */
+  void startCheckpoint(
+      const RootId& fromRoot,
+      const RootId& toRoot,
+      bool resume);
+
+  /**
+   * Returns true if the interrupted checkout being resumed already updated
+   * the directory at path and everything under it.
+   */
+  bool isSubtreeCheckpointed(RelativePathPiece path);
+
+  /**
+   * Record that the directory at path and everything under it were updated.
+   *
+   * Directories with conflicts are not recorded, since a resumed checkout
+   * must report them again.
+   */
+  void markSubtreeComplete(RelativePathPiece path);
+
+  void didStartDirectory() {
+    directoriesStarted_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void didFinishDirectory() {
+    directoriesFinished_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void didUpdateEntry() {
+    entriesUpdated_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  CheckoutProgress getProgress() const;
+
+  /**
+   * Start fetching, in the background, the Trees of the directories that
+   * differ between fromTree and toTree, so that they are cached by the time
+   * TreeInode::checkout gets to them.
+   *
+   * The number of fetches in flight is bounded by
+   * mount:checkout-tree-prefetch-concurrency.
+   */
+  void prefetchTrees(
+      std::shared_ptr<const Tree> fromTree,
+      std::shared_ptr<const Tree> toTree);
+
+  /**
+   * Record how long the Tree prefetch took and how many Trees it fetched.
+   */
+  void recordTreePrefetch(CheckoutTimes& times) const;
+
   /**
    * Complete the checkout operation
    *
@@ -150,5 +211,16 @@ class CheckoutContext {
   // if some data load operations complete asynchronously on other threads.
   // Therefore access to the conflicts list must be synchronized.
   folly::Synchronized<std::vector<CheckoutConflict>> conflicts_;
+
+  std::shared_ptr<CheckoutTreePrefetcher> treePrefetcher_;
+
+  /** Only set by startCheckpoint(). */
+  std::unique_ptr<CheckoutCheckpoint> checkpoint_;
+
+  const folly::stop_watch<> stopWatch_;
+  std::atomic<size_t> directoriesStarted_{0};
+  std::atomic<size_t> directoriesFinished_{0};
+  std::atomic<size_t> directoriesResumed_{0};
+  std::atomic<size_t> entriesUpdated_{0};
 };
 } // namespace facebook::eden
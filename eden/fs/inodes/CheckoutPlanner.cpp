@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/CheckoutPlanner.h"
+
+#include <folly/Synchronized.h>
+#include <folly/logging/xlog.h>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/service/gen-cpp2/eden_types.h"
+#include "eden/fs/store/DiffCallback.h"
+#include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/store/PathLoader.h"
+
+namespace facebook::eden {
+
+namespace {
+/**
+ * Turns the differences between the current and destination trees into the
+ * entries of the plan.
+ *
+ * The diff calls it concurrently from the threads completing its fetches.
+ */
+class CheckoutPlanCallback : public DiffCallback {
+ public:
+  CheckoutPlanCallback(
+      std::unique_ptr<ScmStatus> localChanges,
+      bool collectBlobPaths,
+      folly::Function<void(const CheckoutPlanEntry&)> onEntry)
+      : localChanges_{std::move(localChanges)},
+        collectBlobPaths_{collectBlobPaths},
+        onEntry_{std::move(onEntry)} {}
+
+  // Files added by the destination are checked out even if they match an
+  // ignore rule.
+  void ignoredPath(RelativePathPiece path, dtype_t type) override {
+    plan(path, type, CheckoutPlanEntry::Change::Added);
+  }
+
+  void addedPath(RelativePathPiece path, dtype_t type) override {
+    plan(path, type, CheckoutPlanEntry::Change::Added);
+  }
+
+  void removedPath(RelativePathPiece path, dtype_t type) override {
+    plan(path, type, CheckoutPlanEntry::Change::Removed);
+  }
+
+  void modifiedPath(RelativePathPiece path, dtype_t type) override {
+    plan(path, type, CheckoutPlanEntry::Change::Modified);
+  }
+
+  void diffError(RelativePathPiece path, const folly::exception_wrapper& ew)
+      override {
+    XLOG(DBG3) << "error planning the checkout of " << path << ": " << ew;
+    auto state = state_.lock();
+    if (!state->error) {
+      state->error = ew;
+    }
+  }
+
+  /**
+   * Returns the plan, throwing the first error that the diff reported.
+   */
+  CheckoutPlan getPlan() {
+    auto state = state_.lock();
+    if (state->error) {
+      state->error.throw_exception();
+    }
+    return state->plan;
+  }
+
+  std::vector<RelativePath> extractBlobPaths() {
+    return std::move(state_.lock()->blobPaths);
+  }
+
+ private:
+  void plan(
+      RelativePathPiece path,
+      dtype_t type,
+      CheckoutPlanEntry::Change change) {
+    CheckoutPlanEntry entry{path.copy(), type, change};
+    bool isDir = type == dtype_t::Dir;
+    if (!isDir) {
+      entry.conflict =
+          localChanges_->entries_ref()->count(path.asString()) != 0;
+    }
+
+    auto state = state_.lock();
+    auto& plan = state->plan;
+    // A file replaced by a directory, or the reverse, is reported twice.
+    if (state->paths.insert(entry.path).second) {
+      ++plan.inodesInvalidated;
+    }
+    if (change != CheckoutPlanEntry::Change::Removed) {
+      if (isDir) {
+        ++plan.treesToFetch;
+      } else {
+        ++plan.blobsToFetch;
+        if (collectBlobPaths_) {
+          state->blobPaths.push_back(entry.path);
+        }
+      }
+    }
+    if (entry.conflict) {
+      ++plan.conflicts;
+    }
+    onEntry_(entry);
+  }
+
+  struct State {
+    CheckoutPlan plan;
+    std::unordered_set<RelativePath> paths;
+    std::vector<RelativePath> blobPaths;
+    folly::exception_wrapper error;
+  };
+
+  const std::unique_ptr<ScmStatus> localChanges_;
+  const bool collectBlobPaths_;
+  folly::Function<void(const CheckoutPlanEntry&)> onEntry_;
+  folly::Synchronized<State, std::mutex> state_;
+};
+
+ImmediateFuture<folly::Unit> prefetchPlannedBlobs(
+    std::shared_ptr<EdenMount> mount,
+    const RootId& toRoot,
+    std::vector<RelativePath> paths,
+    const ObjectFetchContextPtr& context) {
+  if (paths.empty()) {
+    return folly::unit;
+  }
+  auto* objectStore = mount->getObjectStore();
+  return objectStore->getRootTree(toRoot, context)
+      .thenValue([mount,
+                  paths = std::move(paths),
+                  context = context.copy()](
+                     std::shared_ptr<const Tree> root) {
+        return resolveTreeEntries(
+            *mount->getObjectStore(), context, std::move(root), paths);
+      })
+      .thenValue([mount, context = context.copy()](
+                     std::vector<folly::Try<TreeEntry>> entries) {
+        auto ids = std::make_shared<std::vector<ObjectId>>();
+        ids->reserve(entries.size());
+        for (const auto& entry : entries) {
+          // The plan came from the same trees: errors are failed fetches,
+          // which the checkout will retry.
+          if (entry.hasValue()) {
+            ids->push_back(entry.value().getHash());
+          }
+        }
+        return mount->getObjectStore()
+            ->prefetchBlobs(*ids, context)
+            .ensure([ids] {});
+      });
+}
+} // namespace
+
+ImmediateFuture<CheckoutPlan> planCheckout(
+    std::shared_ptr<EdenMount> mount,
+    RootId toRoot,
+    bool prefetch,
+    folly::CancellationToken cancellation,
+    const ObjectFetchContextPtr& context,
+    folly::Function<void(const CheckoutPlanEntry&)> onEntry) {
+  auto fromRoot = mount->getCheckedOutRootId();
+  auto localChanges = mount->diff(
+      fromRoot,
+      cancellation,
+      /*listIgnored=*/false,
+      /*enforceCurrentParent=*/false);
+  return std::move(localChanges)
+      .thenValue([mount,
+                  fromRoot,
+                  toRoot,
+                  prefetch,
+                  cancellation,
+                  onEntry = std::move(onEntry)](
+                     std::unique_ptr<ScmStatus> localChanges) mutable {
+        auto callback = std::make_shared<CheckoutPlanCallback>(
+            std::move(localChanges), prefetch, std::move(onEntry));
+        return mount
+            ->diffBetweenRoots(
+                fromRoot, toRoot, std::move(cancellation), callback.get())
+            .thenValue([callback](folly::Unit) { return callback; });
+      })
+      .thenValue(
+          [mount, toRoot, prefetch, context = context.copy()](
+              std::shared_ptr<CheckoutPlanCallback> callback)
+              -> ImmediateFuture<CheckoutPlan> {
+            auto plan = callback->getPlan();
+            if (!prefetch) {
+              return plan;
+            }
+            return prefetchPlannedBlobs(
+                       mount, toRoot, callback->extractBlobPaths(), context)
+                .thenValue([plan](folly::Unit) { return plan; });
+          });
+}
+
+} // namespace facebook::eden
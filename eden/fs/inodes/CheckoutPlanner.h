@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/CancellationToken.h>
+#include <folly/Function.h>
+#include <cstddef>
+#include <memory>
+
+#include "eden/fs/model/RootId.h"
+#include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/utils/DirType.h"
+#include "eden/fs/utils/ImmediateFuture.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+class EdenMount;
+
+/**
+ * A path that a checkout would update.
+ */
+struct CheckoutPlanEntry {
+  enum class Change { Added, Removed, Modified };
+
+  RelativePath path;
+  /**
+   * The type of the entry in the destination tree, or in the current one for
+   * removals.
+   */
+  dtype_t type;
+  Change change;
+  /**
+   * Whether the file was changed in the working copy too, in which case
+   * checking it out conflicts.
+   */
+  bool conflict{false};
+};
+
+struct CheckoutPlan {
+  /**
+   * Trees of the destination that the checkout reads: those of the added
+   * and modified directories.
+   */
+  size_t treesToFetch{0};
+  /**
+   * Blobs of the destination that the checkout reads: those of the added
+   * and modified files.
+   */
+  size_t blobsToFetch{0};
+  size_t conflicts{0};
+  /**
+   * Paths whose inodes and kernel cache entries the checkout invalidates.
+   */
+  size_t inodesInvalidated{0};
+};
+
+/**
+ * Estimate the cost of checking out toRoot, without checking it out.
+ *
+ * Unlike a DRY_RUN checkout, which walks the inodes, this diffs the source
+ * control trees of the current commit and of toRoot with diffRoots(), so
+ * that only the trees that differ are fetched and no inode is loaded. The
+ * conflicts are the changed files that are also changed in the working copy,
+ * as reported by a status against the current commit.
+ *
+ * onEntry is called, one call at a time, with each path as it is planned.
+ * If prefetch is true, the blobs that the checkout would read are fetched
+ * once the plan is complete; the trees were already fetched by the planning.
+ */
+ImmediateFuture<CheckoutPlan> planCheckout(
+    std::shared_ptr<EdenMount> mount,
+    RootId toRoot,
+    bool prefetch,
+    folly::CancellationToken cancellation,
+    const ObjectFetchContextPtr& context,
+    folly::Function<void(const CheckoutPlanEntry&)> onEntry);
+
+} // namespace facebook::eden
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/CheckoutTreePrefetcher.h"
+
+#include <folly/executors/QueuedImmediateExecutor.h>
+#include <folly/logging/xlog.h>
+#include <vector>
+
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/utils/ImmediateFuture.h"
+
+namespace facebook::eden {
+
+CheckoutTreePrefetcher::CheckoutTreePrefetcher(
+    std::shared_ptr<ObjectStore> objectStore,
+    const ObjectFetchContextPtr& fetchContext,
+    size_t maxConcurrency)
+    : objectStore_{std::move(objectStore)},
+      fetchContext_{fetchContext.copy()},
+      maxConcurrency_{maxConcurrency} {}
+
+void CheckoutTreePrefetcher::start(
+    std::shared_ptr<const Tree> fromTree,
+    std::shared_ptr<const Tree> toTree) {
+  stopWatch_.reset();
+  enqueueChildren(fromTree.get(), toTree.get());
+  fetchPending();
+}
+
+void CheckoutTreePrefetcher::stop() {
+  auto state = state_.wlock();
+  state->stopped = true;
+  state->pending.clear();
+}
+
+size_t CheckoutTreePrefetcher::getTreesFetched() const {
+  return state_.rlock()->treesFetched;
+}
+
+std::optional<CheckoutTreePrefetcher::Duration>
+CheckoutTreePrefetcher::getDuration() const {
+  return state_.rlock()->duration;
+}
+
+void CheckoutTreePrefetcher::enqueueChildren(
+    const Tree* fromTree,
+    const Tree* toTree) {
+  if (!toTree) {
+    // Directories removed by the checkout are not looked into unless they
+    // are loaded, so there is nothing worth prefetching under them.
+    return;
+  }
+
+  std::vector<PendingDirectory> children;
+  for (const auto& [name, entry] : *toTree) {
+    if (!entry.isTree()) {
+      continue;
+    }
+    std::optional<ObjectId> fromId;
+    if (fromTree) {
+      auto it = fromTree->find(name);
+      if (it != fromTree->end() && it->second.isTree()) {
+        if (it->second.getHash() == entry.getHash()) {
+          // Checkout short circuits unchanged subtrees.
+          continue;
+        }
+        fromId = it->second.getHash();
+      }
+    }
+    children.push_back(PendingDirectory{std::move(fromId), entry.getHash()});
+  }
+
+  if (children.empty()) {
+    return;
+  }
+  auto state = state_.wlock();
+  if (state->stopped) {
+    return;
+  }
+  for (auto& child : children) {
+    state->pending.push_back(std::move(child));
+  }
+}
+
+void CheckoutTreePrefetcher::fetchPending() {
+  std::vector<PendingDirectory> toFetch;
+  {
+    auto state = state_.wlock();
+    while (!state->stopped && state->inFlight < maxConcurrency_ &&
+           !state->pending.empty()) {
+      toFetch.push_back(std::move(state->pending.front()));
+      state->pending.pop_front();
+      ++state->inFlight;
+    }
+    if (!state->stopped && state->inFlight == 0 && state->pending.empty() &&
+        !state->duration) {
+      state->duration = stopWatch_.elapsed();
+    }
+  }
+
+  for (auto& directory : toFetch) {
+    fetch(std::move(directory));
+  }
+}
+
+void CheckoutTreePrefetcher::fetch(PendingDirectory directory) {
+  auto getTree = [this](const std::optional<ObjectId>& id) {
+    return id ? objectStore_->getTree(*id, fetchContext_)
+              : ImmediateFuture<std::shared_ptr<const Tree>>{
+                    std::shared_ptr<const Tree>{}};
+  };
+
+  // The QueuedImmediateExecutor runs the callback inline, but defers it
+  // while another callback is running on this thread, so that a long run of
+  // cached Trees does not recurse through fetchPending().
+  collectAllSafe(getTree(directory.fromId), getTree(directory.toId))
+      .semi()
+      .via(&folly::QueuedImmediateExecutor::instance())
+      .thenTry(
+          [self = shared_from_this()](
+              folly::Try<std::tuple<
+                  std::shared_ptr<const Tree>,
+                  std::shared_ptr<const Tree>>>&& result) {
+            if (result.hasValue()) {
+              auto& [fromTree, toTree] = result.value();
+              self->onFetched(std::move(fromTree), std::move(toTree));
+            } else {
+              XLOG(DBG3) << "error prefetching trees for checkout: "
+                         << result.exception();
+              self->onFetched(nullptr, nullptr);
+            }
+            self->fetchPending();
+          });
+}
+
+void CheckoutTreePrefetcher::onFetched(
+    std::shared_ptr<const Tree> fromTree,
+    std::shared_ptr<const Tree> toTree) {
+  enqueueChildren(fromTree.get(), toTree.get());
+  auto state = state_.wlock();
+  --state->inFlight;
+  state->treesFetched += (fromTree ? 1 : 0) + (toTree ? 1 : 0);
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/stop_watch.h>
+#include <deque>
+#include <memory>
+#include <optional>
+
+#include "eden/fs/model/ObjectId.h"
+#include "eden/fs/store/ObjectFetchContext.h"
+
+namespace facebook::eden {
+
+class ObjectStore;
+class Tree;
+
+/**
+ * Fetches the source control Trees a checkout will need ahead of the
+ * TreeInodes that process them.
+ *
+ * TreeInode::checkout only fetches the Trees of a directory's children once
+ * it has locked that directory and computed its actions, so on a cold cache
+ * each level of the diff waits on the tree fetches of the level above.
+ * Starting from the root Trees, this walks the subtrees that differ between
+ * the source and destination commits and keeps up to maxConcurrency of their
+ * fetches in flight, so that by the time checkout reaches a directory its
+ * Trees are usually already cached.
+ *
+ * The prefetcher only warms the ObjectStore caches: checkout does not wait
+ * for it, and a failed prefetch is retried by checkout itself.
+ */
+class CheckoutTreePrefetcher
+    : public std::enable_shared_from_this<CheckoutTreePrefetcher> {
+ public:
+  using Duration = folly::stop_watch<>::duration;
+
+  CheckoutTreePrefetcher(
+      std::shared_ptr<ObjectStore> objectStore,
+      const ObjectFetchContextPtr& fetchContext,
+      size_t maxConcurrency);
+
+  /**
+   * Start prefetching the subtrees that differ between fromTree and toTree.
+   */
+  void start(
+      std::shared_ptr<const Tree> fromTree,
+      std::shared_ptr<const Tree> toTree);
+
+  /**
+   * Stop issuing new fetches. Fetches that are already in flight complete in
+   * the background.
+   */
+  void stop();
+
+  /**
+   * The number of Trees this prefetcher fetched.
+   */
+  size_t getTreesFetched() const;
+
+  /**
+   * How long it took to walk the whole diff frontier, or nullopt if the walk
+   * is still running or was stopped before it finished.
+   */
+  std::optional<Duration> getDuration() const;
+
+ private:
+  /**
+   * A directory whose source and destination Trees differ. Either ID is
+   * unset if the directory does not exist in that commit.
+   */
+  struct PendingDirectory {
+    std::optional<ObjectId> fromId;
+    std::optional<ObjectId> toId;
+  };
+
+  struct State {
+    std::deque<PendingDirectory> pending;
+    size_t inFlight{0};
+    size_t treesFetched{0};
+    bool stopped{false};
+    std::optional<Duration> duration;
+  };
+
+  void enqueueChildren(const Tree* fromTree, const Tree* toTree);
+  void fetchPending();
+  void fetch(PendingDirectory directory);
+  void onFetched(
+      std::shared_ptr<const Tree> fromTree,
+      std::shared_ptr<const Tree> toTree);
+
+  std::shared_ptr<ObjectStore> objectStore_;
+  ObjectFetchContextPtr fetchContext_;
+  size_t maxConcurrency_;
+  folly::stop_watch<> stopWatch_;
+  folly::Synchronized<State> state_;
+};
+
+} // namespace facebook::eden
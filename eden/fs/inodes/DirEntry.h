@@ -6,6 +6,7 @@
  */
 
 #pragma once
+#include <folly/FBString.h>
 #include <optional>
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/inodes/InodePtr.h"
@@ -269,6 +270,22 @@ static_assert(CheckSize<DirEntry, 40>(), "DirEntry is five words");
 struct DirContents : PathMap<DirEntry> {
   explicit DirContents(CaseSensitivity caseSensitive)
       : PathMap(caseSensitive) {}
+
+  /**
+   * An estimate of the memory used by these entries: the allocated slots,
+   * including unused capacity, plus the names too long to be stored inline.
+   */
+  size_t getSizeBytes() const {
+    static const size_t kInlineNameCapacity = folly::fbstring{}.capacity();
+    size_t bytes = capacity() * sizeof(value_type);
+    for (const auto& entry : *this) {
+      auto nameCapacity = entry.first.value().capacity();
+      if (nameCapacity > kInlineNameCapacity) {
+        bytes += nameCapacity + 1;
+      }
+    }
+    return bytes;
+  }
 };
 
 } // namespace facebook::eden
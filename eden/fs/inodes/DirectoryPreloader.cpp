@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/DirectoryPreloader.h"
+
+#include <folly/logging/xlog.h>
+#include <algorithm>
+
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/inodes/InodePtr.h"
+#include "eden/fs/inodes/PathError.h"
+#include "eden/fs/inodes/VirtualInode.h"
+#include "eden/fs/utils/EdenError.h"
+#include "eden/fs/utils/ImmediateFuture.h"
+
+namespace facebook::eden {
+
+namespace {
+struct PendingDirectory {
+  RelativePath path;
+  VirtualInode inode;
+  // Levels left to preload below path.
+  size_t depth;
+};
+
+void checkTreeLimit(size_t treesFetched, size_t maxTrees) {
+  if (treesFetched > maxTrees) {
+    throw newEdenError(
+        EdenErrorType::GENERIC_ERROR,
+        "preload stopped after fetching ",
+        maxTrees,
+        " trees");
+  }
+}
+
+/**
+ * Load the TreeInodes of directories, batchSize at a time.
+ */
+void loadInodes(
+    const EdenMount& mount,
+    const std::vector<PendingDirectory>& directories,
+    size_t batchSize,
+    const ObjectFetchContextPtr& context,
+    DirectoryPreloadProgress& progress) {
+  for (size_t start = 0; start < directories.size(); start += batchSize) {
+    auto end = std::min(start + batchSize, directories.size());
+    std::vector<ImmediateFuture<InodePtr>> futures;
+    futures.reserve(end - start);
+    for (size_t i = start; i < end; ++i) {
+      futures.push_back(mount.getInodeSlow(directories[i].path, context));
+    }
+    collectAllSafe(std::move(futures)).get();
+    progress.inodesLoaded += end - start;
+  }
+}
+} // namespace
+
+DirectoryPreloadProgress preloadDirectories(
+    const EdenMount& mount,
+    const std::vector<DirectoryPreloadRequest>& directories,
+    const DirectoryPreloadOptions& options,
+    const ObjectFetchContextPtr& context,
+    folly::FunctionRef<void(const DirectoryPreloadProgress&)> onProgress) {
+  auto batchSize = std::max(options.batchSize, size_t{1});
+  auto* objectStore = mount.getObjectStore();
+  DirectoryPreloadProgress progress;
+
+  std::vector<RelativePath> paths;
+  paths.reserve(directories.size());
+  for (const auto& directory : directories) {
+    paths.push_back(directory.path);
+  }
+  auto roots = mount.getVirtualInodes(paths, context).get();
+
+  std::vector<PendingDirectory> level;
+  level.reserve(directories.size());
+  for (size_t i = 0; i < directories.size(); ++i) {
+    auto inode = std::move(roots[i]).value();
+    if (!inode.isDirectory()) {
+      throw PathError(ENOTDIR, directories[i].path);
+    }
+    level.push_back(PendingDirectory{
+        directories[i].path, std::move(inode), directories[i].depth});
+  }
+  progress.treesFetched = level.size();
+  checkTreeLimit(progress.treesFetched, options.maxTrees);
+
+  while (!level.empty()) {
+    if (options.loadInodes) {
+      loadInodes(mount, level, batchSize, context, progress);
+    }
+
+    std::vector<PendingDirectory> nextLevel;
+    progress.pendingDirectories = level.size();
+    auto it = level.begin();
+    while (it != level.end()) {
+      // Request the subtrees of as many directories as fit in a batch. The
+      // files of the directories are not fetched.
+      std::vector<RelativePath> childPaths;
+      std::vector<size_t> childDepths;
+      std::vector<ImmediateFuture<VirtualInode>> children;
+      for (; it != level.end() && children.size() < batchSize; ++it) {
+        --progress.pendingDirectories;
+        if (it->depth == 0) {
+          continue;
+        }
+        auto entries =
+            it->inode.getChildren(it->path, objectStore, context).value();
+        for (auto& [name, child] : entries) {
+          childPaths.push_back(it->path + name);
+          childDepths.push_back(it->depth - 1);
+          children.push_back(std::move(child));
+        }
+      }
+
+      auto loaded = collectAllSafe(std::move(children)).get();
+      for (size_t i = 0; i < loaded.size(); ++i) {
+        if (loaded[i].isDirectory()) {
+          nextLevel.push_back(PendingDirectory{
+              std::move(childPaths[i]), std::move(loaded[i]), childDepths[i]});
+          ++progress.treesFetched;
+        }
+      }
+      checkTreeLimit(progress.treesFetched, options.maxTrees);
+      onProgress(progress);
+    }
+
+    XLOG(DBG4) << "preloaded level " << progress.depth << " of "
+               << mount.getPath() << ": " << nextLevel.size()
+               << " directories";
+    level = std::move(nextLevel);
+    if (!level.empty()) {
+      ++progress.depth;
+    }
+  }
+
+  return progress;
+}
+
+} // namespace facebook::eden
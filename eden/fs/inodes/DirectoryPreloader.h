@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/FunctionRef.h>
+#include <cstddef>
+#include <vector>
+
+#include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+class EdenMount;
+
+struct DirectoryPreloadRequest {
+  RelativePath path;
+  /**
+   * Number of directory levels below path to preload. 0 only preloads the
+   * tree of path itself.
+   */
+  size_t depth;
+};
+
+struct DirectoryPreloadOptions {
+  /**
+   * Also load the TreeInodes of the preloaded directories, so that lookups
+   * in them are answered from memory.
+   */
+  bool loadInodes{false};
+  /**
+   * Number of tree fetches issued together. The backing store groups the
+   * queued fetches into batched imports.
+   */
+  size_t batchSize{1024};
+  /**
+   * Number of trees after which the preload fails, to bound the work a
+   * single request can cause.
+   */
+  size_t maxTrees{1'000'000};
+};
+
+struct DirectoryPreloadProgress {
+  /**
+   * The directory level being preloaded, relative to the requested
+   * directories.
+   */
+  size_t depth{0};
+  size_t treesFetched{0};
+  size_t inodesLoaded{0};
+  /**
+   * Directories of the current level whose children are not fetched yet.
+   */
+  size_t pendingDirectories{0};
+};
+
+/**
+ * Fetch the trees of directories and of their subdirectories, up to their
+ * requested depth, and optionally load their inodes, ahead of a known
+ * workload such as a build.
+ *
+ * The directories are walked breadth-first: the trees of a whole level are
+ * requested together, in chunks of batchSize, rather than one directory
+ * after the other, so that the backing store can import them in batches.
+ *
+ * onProgress is called after each chunk. This blocks until the preload is
+ * done and returns the final progress. Throws if a directory doesn't exist
+ * or a tree can't be fetched, or if more than maxTrees trees would be
+ * fetched.
+ */
+DirectoryPreloadProgress preloadDirectories(
+    const EdenMount& mount,
+    const std::vector<DirectoryPreloadRequest>& directories,
+    const DirectoryPreloadOptions& options,
+    const ObjectFetchContextPtr& context,
+    folly::FunctionRef<void(const DirectoryPreloadProgress&)> onProgress);
+
+} // namespace facebook::eden
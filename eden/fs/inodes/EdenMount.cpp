@@ -11,20 +11,26 @@
 #include <folly/ExceptionWrapper.h>
 #include <folly/FBString.h>
 #include <folly/File.h>
+#include <folly/Utility.h>
 #include <folly/chrono/Conv.h>
+#include <folly/container/F14Map.h>
 #include <folly/futures/Future.h>
+#include <folly/futures/SharedPromise.h>
 #include <folly/io/async/EventBase.h>
+#include <folly/lang/Bits.h>
 #include <folly/logging/Logger.h>
 #include <folly/logging/xlog.h>
 #include <folly/portability/GFlags.h>
 #include <folly/stop_watch.h>
 #include <folly/system/Pid.h>
 #include <folly/system/ThreadName.h>
+#include <numeric>
 
 #include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/config/MountProtocol.h"
 #include "eden/fs/fuse/FuseChannel.h"
 #include "eden/fs/fuse/privhelper/PrivHelper.h"
+#include "eden/fs/inodes/AccessPrefetcher.h"
 #include "eden/fs/inodes/CheckoutContext.h"
 #include "eden/fs/inodes/EdenDispatcherFactory.h"
 #include "eden/fs/inodes/FileInode.h"
@@ -47,6 +53,7 @@
 #include "eden/fs/store/Diff.h"
 #include "eden/fs/store/DiffCallback.h"
 #include "eden/fs/store/DiffContext.h"
+#include "eden/fs/store/FilteredBackingStore.h"
 #include "eden/fs/store/ObjectStore.h"
 #include "eden/fs/store/ScmStatusDiffCallback.h"
 #include "eden/fs/store/StatsFetchContext.h"
@@ -101,6 +108,44 @@ void InodeTraceEvent::setPath(std::string_view stringPath) {
   path[stringPath.size()] = 0;
 }
 
+namespace {
+constexpr uint32_t kInodeTraceSnapshotVersion = 1;
+
+template <typename T>
+void appendLittleEndian(std::string& out, T value) {
+  value = folly::Endian::little(value);
+  out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+} // namespace
+
+std::string serializeInodeTraceEvents(
+    const ActivityBuffer<InodeTraceEvent>& buffer) {
+  using std::chrono::duration_cast;
+  using std::chrono::nanoseconds;
+
+  std::string out;
+  appendLittleEndian(out, kInodeTraceSnapshotVersion);
+  buffer.forEachEvent([&](const InodeTraceEvent& event) {
+    appendLittleEndian<int64_t>(
+        out,
+        duration_cast<nanoseconds>(event.systemTime.time_since_epoch())
+            .count());
+    appendLittleEndian<int64_t>(
+        out,
+        duration_cast<nanoseconds>(event.monotonicTime.time_since_epoch())
+            .count());
+    appendLittleEndian<uint64_t>(out, event.ino.getRawValue());
+    appendLittleEndian<uint8_t>(out, folly::to_underlying(event.inodeType));
+    appendLittleEndian<uint8_t>(out, folly::to_underlying(event.eventType));
+    appendLittleEndian<uint8_t>(out, folly::to_underlying(event.progress));
+    appendLittleEndian<int64_t>(out, event.duration.count());
+    std::string_view path{event.path ? event.path.get() : ""};
+    appendLittleEndian<uint32_t>(out, path.size());
+    out.append(path);
+  });
+  return out;
+}
+
 // These static asserts exist to make explicit the memory usage of the per-mount
 // InodeTraceBus. TraceBus uses 2 * capacity * sizeof(TraceEvent) memory usage,
 // so limit total memory usage to around 0.67 MB per mount. Note
@@ -203,10 +248,9 @@ constexpr int EdenMount::kMaxSymlinkChainDepth;
 static constexpr folly::StringPiece kEdenStracePrefix = "eden.strace.";
 
 // We compute this when the process is initialized, but stash a copy
-// in each EdenMount.  We may in the future manage to propagate enough
-// state across upgrades or restarts that we can preserve this, but
-// as implemented today, a process restart will invalidate any cached
-// mountGeneration that a client may be holding on to.
+// in each EdenMount.  Unless the journal is persisted across upgrades and
+// restarts, a process restart will invalidate any cached mountGeneration
+// that a client may be holding on to.
 // We take the bottom 16-bits of the pid and 32-bits of the current
 // time and shift them up, leaving 16 bits for a mount point generation
 // number.
@@ -268,15 +312,21 @@ EdenMount::EdenMount(
       overlayFileAccess_{overlay_.get()},
 #endif
       journal_{std::move(journal)},
-      mountGeneration_{globalProcessGeneration | ++mountGeneration},
+      mountGeneration_{initMountGeneration()},
       straceLogger_{
           kEdenStracePrefix.str() + checkoutConfig_->getMountPath().value()},
       lastCheckoutTime_{EdenTimestamp{serverState_->getClock()->getRealtime()}},
       owner_{Owner{getuid(), getgid()}},
       inodeActivityBuffer_{initInodeActivityBuffer()},
       inodeTraceBus_{
-          TraceBus<InodeTraceEvent>::create("inode", kInodeTraceBusCapacity)},
-      clock_{serverState_->getClock()} {
+          TraceBus<InodeTraceEvent>::create(
+              "inode",
+              kInodeTraceBusCapacity,
+              // The inode events are only streamed and kept for debugging,
+              // they must not slow down the filesystem when tracing is on.
+              TraceBus<InodeTraceEvent>::OverflowPolicy::Drop)},
+      clock_{serverState_->getClock()},
+      accessPrefetcher_{std::make_unique<AccessPrefetcher>(*this)} {
   subscribeInodeActivityBuffer();
 }
 
@@ -287,11 +337,9 @@ Overlay::InodeCatalogType EdenMount::getInodeCatalogType(
   }
 
   if (checkoutConfig_->getEnableTreeOverlay()) {
-    if (!folly::kIsWindows) {
-      throw std::runtime_error(
-          "Tree overlay type is only supported on Windows");
-    }
-
+    // On Windows the tree overlay stores everything. Elsewhere, it only
+    // replaces the one-file-per-directory storage of FsInodeCatalog: file
+    // contents are still stored by the FileContentStore.
     if (getEdenConfig()->unsafeInMemoryOverlay.getValue()) {
       if (getEdenConfig()->overlayBuffered.getValue()) {
         return Overlay::InodeCatalogType::TreeInMemoryBuffered;
@@ -377,7 +425,8 @@ class TreeLookupProcessor {
 
 FOLLY_NODISCARD folly::Future<folly::Unit> EdenMount::initialize(
     OverlayChecker::ProgressCallback&& progressCallback,
-    const std::optional<SerializedInodeMap>& takeover) {
+    const std::optional<SerializedInodeMap>& takeover,
+    folly::SemiFuture<folly::Unit> objectStoreReady) {
   transitionState(State::UNINITIALIZED, State::INITIALIZING);
 
   auto parentCommit = checkoutConfig_->getParentCommit();
@@ -390,14 +439,10 @@ FOLLY_NODISCARD folly::Future<folly::Unit> EdenMount::initialize(
   return serverState_->getFaultInjector()
       .checkAsync("mount", getPath().stringPiece())
       .via(getServerThreadPool().get())
-      .thenValue([this, parent](auto&&) {
-        return objectStore_->getRootTree(parent, context)
-            .semi()
-            .via(&folly::QueuedImmediateExecutor::instance());
-      })
       .thenValue([this,
-                  progressCallback = std::move(progressCallback),
                   parent,
+                  progressCallback = std::move(progressCallback),
+                  objectStoreReady = std::move(objectStoreReady),
                   workingCopyParentRootId = parentCommit.getWorkingCopyParent(),
                   inProgressCheckout = parentCommit.isCheckoutInProgress(),
                   checkoutOriginalDest = parentCommit.getLastCheckoutId(
@@ -405,49 +450,96 @@ FOLLY_NODISCARD folly::Future<folly::Unit> EdenMount::initialize(
                   checkoutOriginalSrc = parentCommit.getLastCheckoutId(
                       ParentCommit::RootIdPreference::From),
                   checkoutPid = parentCommit.getInProgressPid()](
-                     std::shared_ptr<const Tree> parentTree) mutable {
-        std::optional<std::tuple<RootId, RootId>> originalCheckoutTrees =
-            std::nullopt;
-        if (inProgressCheckout) {
-          originalCheckoutTrees = {std::make_tuple(
-              checkoutOriginalSrc.value(), checkoutOriginalDest.value())};
-        }
-        *parentState_.wlock() = ParentCommitState{
-            parent,
-            parentTree,
-            workingCopyParentRootId,
-            inProgressCheckout,
-            originalCheckoutTrees,
-            checkoutPid,
-        };
-
-        // Record the transition from no snapshot to the current snapshot in
-        // the journal.  This also sets things up so that we can carry the
-        // snapshot id forward through subsequent journal entries.
-        journal_->recordHashUpdate(parent);
-
-        // Initialize the overlay.
-        // This must be performed before we do any operations that may
-        // allocate inode numbers, including creating the root TreeInode.
-        return overlay_
-            ->initialize(
-                getEdenConfig(),
-                getPath(),
-                std::move(progressCallback),
-                [this](RelativePathPiece path) {
-                  auto lookup = std::make_unique<TreeLookupProcessor>(
-                      path, objectStore_, context.copy());
-                  // Do the next() and the ensure() on separate lines to make
-                  // the order of 'lookup' accesses explicit, so we don't move
-                  // it before calling next.
-                  auto future = lookup->next(getCheckedOutRootTree());
-                  // The 'ensure' makes sure the lookup lasts until the future
-                  // finishes.
-                  return std::move(future).ensure(
-                      [proc = std::move(lookup)] {});
-                })
-            .deferValue([parentTree = std::move(parentTree)](auto&&) mutable {
+                     auto&&) mutable {
+        // Initialize the overlay, on its own thread, while the root tree is
+        // fetched, which may have to wait for the local store to be opened.
+        // The overlay only needs the root tree to repair itself, and this
+        // must be performed before we do any operations that may allocate
+        // inode numbers, including creating the root TreeInode.
+        auto rootTree = std::make_shared<
+            folly::SharedPromise<std::shared_ptr<const Tree>>>();
+        auto overlayInitialized = overlay_->initialize(
+            getEdenConfig(),
+            getPath(),
+            std::move(progressCallback),
+            [this, rootTree](RelativePathPiece path) {
+              return ImmediateFuture<std::shared_ptr<const Tree>>{
+                  rootTree->getSemiFuture()}
+                  .thenValue([this, path = path.copy()](
+                                 std::shared_ptr<const Tree> tree) {
+                    auto lookup = std::make_unique<TreeLookupProcessor>(
+                        path, objectStore_, context.copy());
+                    // Do the next() and the ensure() on separate lines to
+                    // make the order of 'lookup' accesses explicit, so we
+                    // don't move it before calling next.
+                    auto future = lookup->next(std::move(tree));
+                    // The 'ensure' makes sure the lookup lasts until the
+                    // future finishes.
+                    return std::move(future).ensure(
+                        [proc = std::move(lookup)] {});
+                  });
+            });
+
+        return std::move(objectStoreReady)
+            .deferValue([this, parent](auto&&) {
+              return objectStore_->getRootTree(parent, context).semi();
+            })
+            .via(&folly::QueuedImmediateExecutor::instance())
+            .thenTry([rootTree](
+                         folly::Try<std::shared_ptr<const Tree>>&& result) {
+              // Also unblocks the overlay when the fetch failed.
+              rootTree->setTry(
+                  folly::Try<std::shared_ptr<const Tree>>{result});
+              return std::move(result).value();
+            })
+            .thenValue([this,
+                        parent,
+                        workingCopyParentRootId =
+                            std::move(workingCopyParentRootId),
+                        inProgressCheckout,
+                        checkoutOriginalDest = std::move(checkoutOriginalDest),
+                        checkoutOriginalSrc = std::move(checkoutOriginalSrc),
+                        checkoutPid](std::shared_ptr<const Tree> parentTree) {
+              std::optional<std::tuple<RootId, RootId>> originalCheckoutTrees =
+                  std::nullopt;
+              if (inProgressCheckout) {
+                originalCheckoutTrees = {std::make_tuple(
+                    checkoutOriginalSrc.value(),
+                    checkoutOriginalDest.value())};
+              }
+              *parentState_.wlock() = ParentCommitState{
+                  parent,
+                  parentTree,
+                  workingCopyParentRootId,
+                  inProgressCheckout,
+                  originalCheckoutTrees,
+                  checkoutPid,
+              };
+
+              // Record the transition from no snapshot to the current
+              // snapshot in the journal.  This also sets things up so that
+              // we can carry the snapshot id forward through subsequent
+              // journal entries. A journal loaded from its log is already on
+              // a snapshot, which is normally the current one.
+              if (auto latest = journal_->getLatest()) {
+                journal_->recordHashUpdate(latest->toHash, parent);
+              } else {
+                journal_->recordHashUpdate(parent);
+              }
               return parentTree;
+            })
+            .thenTry([overlayInitialized = std::move(overlayInitialized)](
+                         folly::Try<std::shared_ptr<const Tree>>&&
+                             parentTree) mutable {
+              // Wait for the overlay even when the root tree couldn't be
+              // fetched, as it is initialized on behalf of this mount.
+              return std::move(overlayInitialized)
+                  .deferTry([parentTree = std::move(parentTree)](
+                                folly::Try<folly::Unit>&& overlay) mutable {
+                    parentTree.throwUnlessValue();
+                    overlay.throwUnlessValue();
+                    return std::move(parentTree).value();
+                  });
             });
       })
       .thenValue([this, takeover](std::shared_ptr<const Tree> parentTree) {
@@ -961,6 +1053,48 @@ ImmediateFuture<SetPathObjectIdResultAndTimes> EdenMount::setPathsToObjectIds(
             return resultAndTimes;
           });
 }
+
+ImmediateFuture<folly::Unit> EdenMount::cloneDirectory(
+    RelativePath source,
+    RelativePath destination,
+    const ObjectFetchContextPtr& context) {
+  if (destination.empty()) {
+    throw std::domain_error("cannot clone a directory over the mount root");
+  }
+  return getInodeSlow(source, context)
+      .thenValue([this,
+                  destination = std::move(destination),
+                  context = context.copy()](InodePtr inode) mutable {
+        auto tree = inode.asTreePtr();
+        auto treeHash = tree->getContents().rlock()->treeHash;
+        if (!treeHash.has_value()) {
+          throw InodeError(
+              EINVAL,
+              std::move(inode),
+              "materialized directories cannot be cloned");
+        }
+
+        std::vector<SetPathObjectIdObjectAndPath> objects(1);
+        objects[0].path = destination;
+        objects[0].id = std::move(treeHash).value();
+        objects[0].type = facebook::eden::ObjectType::TREE;
+        return setPathsToObjectIds(
+                   std::move(objects), CheckoutMode::NORMAL, context)
+            .thenValue([destination = std::move(destination)](
+                           SetPathObjectIdResultAndTimes&& resultAndTimes) {
+              auto& conflicts = *resultAndTimes.result.conflicts();
+              if (!conflicts.empty()) {
+                throw std::system_error(
+                    EEXIST,
+                    std::generic_category(),
+                    fmt::format(
+                        "cannot clone to {}: {} conflicting paths",
+                        destination,
+                        conflicts.size()));
+              }
+            });
+      });
+}
 #endif // !_WIN32
 
 void EdenMount::destroy() {
@@ -1039,6 +1173,9 @@ folly::SemiFuture<SerializedInodeMap> EdenMount::shutdownImpl(bool doTakeover) {
         // the mount point.
         overlay_->close();
         XLOG(DBG1) << "successfully closed overlay at " << getPath();
+        // Like the overlay, the journal log must be closed before a new
+        // edenfs process takes over the mount and loads it.
+        journal_->closeLog(mountGeneration_);
         auto oldState =
             state_.exchange(State::SHUT_DOWN, std::memory_order_acq_rel);
         if (oldState == State::DESTROYING) {
@@ -1361,6 +1498,99 @@ class VirtualInodeLookupProcessor {
   ObjectFetchContextPtr context_;
 };
 
+/**
+ * Resolves several paths at once, the paths that share a directory being
+ * looked up together past it.
+ */
+class VirtualInodeBatchLookupProcessor {
+ public:
+  VirtualInodeBatchLookupProcessor(
+      const std::vector<RelativePath>& paths,
+      ObjectStore* objectStore,
+      ObjectFetchContextPtr context)
+      : paths_{paths},
+        results_(paths.size()),
+        objectStore_{objectStore},
+        context_{std::move(context)} {
+    components_.reserve(paths.size());
+    for (const auto& path : paths_) {
+      auto components = path.components();
+      components_.emplace_back(components.begin(), components.end());
+    }
+  }
+
+  ImmediateFuture<folly::Unit> start(VirtualInode root) {
+    std::vector<size_t> indices(paths_.size());
+    std::iota(indices.begin(), indices.end(), 0);
+    return next(std::move(root), 0, std::move(indices));
+  }
+
+  std::vector<folly::Try<VirtualInode>> extractResults() {
+    return std::move(results_);
+  }
+
+ private:
+  /**
+   * Resolve the paths of indices, entry being the result of the lookup of
+   * their first depth components.
+   */
+  ImmediateFuture<folly::Unit>
+  next(VirtualInode entry, size_t depth, std::vector<size_t> indices) {
+    // The children are kept in the order they are first seen, for the
+    // lookups to be issued in the order of the request.
+    std::vector<std::pair<PathComponentPiece, std::vector<size_t>>> children;
+    folly::F14FastMap<PathComponentPiece, size_t> childPositions;
+    for (auto index : indices) {
+      const auto& components = components_[index];
+      if (depth == components.size()) {
+        results_[index] = folly::Try<VirtualInode>{entry};
+        continue;
+      }
+      auto [it, inserted] =
+          childPositions.try_emplace(components[depth], children.size());
+      if (inserted) {
+        children.emplace_back(components[depth], std::vector<size_t>{});
+      }
+      children[it->second].second.push_back(index);
+    }
+
+    std::vector<ImmediateFuture<folly::Unit>> futures;
+    futures.reserve(children.size());
+    for (auto& [name, childIndices] : children) {
+      // Lookup errors are reported against the path of the first request.
+      const auto& path = paths_[childIndices.front()];
+      futures.push_back(
+          entry.getOrFindChild(name, path, objectStore_, context_)
+              .thenTry(
+                  [this, depth, childIndices = std::move(childIndices)](
+                      folly::Try<VirtualInode>&& child) mutable
+                  -> ImmediateFuture<folly::Unit> {
+                    if (child.hasException()) {
+                      for (auto index : childIndices) {
+                        results_[index] =
+                            folly::Try<VirtualInode>{child.exception()};
+                      }
+                      return folly::unit;
+                    }
+                    return next(
+                        std::move(child).value(),
+                        depth + 1,
+                        std::move(childIndices));
+                  }));
+    }
+    return collectAllSafe(std::move(futures)).unit();
+  }
+
+  const std::vector<RelativePath> paths_;
+  // The components of each of paths_.
+  std::vector<std::vector<PathComponentPiece>> components_;
+  // Each result is only written by the lookup of its own path.
+  std::vector<folly::Try<VirtualInode>> results_;
+  // See VirtualInodeLookupProcessor::objectStore_.
+  ObjectStore* objectStore_;
+  ObjectFetchContextPtr context_;
+};
+
 } // namespace
 
 ImmediateFuture<VirtualInode> EdenMount::getVirtualInode(
@@ -1375,6 +1605,21 @@ ImmediateFuture<VirtualInode> EdenMount::getVirtualInode(
       [p = std::move(processor)]() mutable { p.reset(); });
 }
 
+ImmediateFuture<std::vector<folly::Try<VirtualInode>>>
+EdenMount::getVirtualInodes(
+    const std::vector<RelativePath>& paths,
+    const ObjectFetchContextPtr& context) const {
+  auto rootInode = static_cast<InodePtr>(getRootInode());
+
+  auto processor = std::make_unique<VirtualInodeBatchLookupProcessor>(
+      paths, getObjectStore(), context.copy());
+  auto future = processor->start(VirtualInode(std::move(rootInode)));
+  return std::move(future).thenValue(
+      [p = std::move(processor)](folly::Unit) mutable {
+        return p->extractResults();
+      });
+}
+
 ImmediateFuture<folly::Unit> EdenMount::waitForPendingNotifications() const {
 #ifdef _WIN32
   if (auto* channel = getPrjfsChannel()) {
@@ -1434,6 +1679,7 @@ folly::Future<CheckoutResult> EdenMount::checkout(
 
   auto ctx = std::make_shared<CheckoutContext>(
       this, checkoutMode, clientPid, thriftMethodCaller);
+  *currentCheckout_.wlock() = ctx;
   XLOG(DBG1) << "starting checkout for " << this->getPath() << ": " << oldParent
              << " to " << snapshotHash;
 
@@ -1502,7 +1748,13 @@ folly::Future<CheckoutResult> EdenMount::checkout(
             .semi()
             .via(&folly::QueuedImmediateExecutor::instance());
       })
-      .thenValue([this, ctx, checkoutTimes, stopWatch, snapshotHash](
+      .thenValue([this,
+                  ctx,
+                  checkoutTimes,
+                  stopWatch,
+                  oldParent,
+                  snapshotHash,
+                  resumingCheckout](
                      std::tuple<shared_ptr<const Tree>, shared_ptr<const Tree>>
                          treeResults) {
         checkoutTimes->didDiff = stopWatch.elapsed();
@@ -1516,6 +1768,10 @@ folly::Future<CheckoutResult> EdenMount::checkout(
             parentState_.wlock(),
             snapshotHash,
             std::get<1>(treeResults));
+        if (!ctx->isDryRun() &&
+            getEdenConfig()->allowResumeCheckout.getValue()) {
+          ctx->startCheckpoint(oldParent, snapshotHash, resumingCheckout);
+        }
 
         checkoutTimes->didAcquireRenameLock = stopWatch.elapsed();
 
@@ -1550,16 +1806,20 @@ folly::Future<CheckoutResult> EdenMount::checkout(
                         treeResults = std::move(treeResults),
                         rootInode = std::move(rootInode)](auto&&) mutable {
               auto& [fromTree, toTree] = treeResults;
+              ctx->prefetchTrees(fromTree, toTree);
               return rootInode->checkout(ctx.get(), fromTree, toTree);
             });
       })
       .thenValue([ctx, checkoutTimes, stopWatch, snapshotHash](auto&&) {
         checkoutTimes->didCheckout = stopWatch.elapsed();
+        ctx->recordTreePrefetch(*checkoutTimes);
 
         // Complete the checkout
         return ctx->finish(snapshotHash);
       })
       .ensure([this, ctx, resumingCheckout]() {
+        currentCheckout_.wlock()->reset();
+
         // Checkout completed, make sure to always reset the checkoutInProgress
         // flag!
         auto parentLock = parentState_.wlock();
@@ -1721,7 +1981,9 @@ std::unique_ptr<DiffContext> EdenMount::createDiffContext(
       listIgnored,
       getCheckoutConfig()->getCaseSensitive(),
       getObjectStore(),
-      serverState_->getTopLevelIgnores());
+      serverState_->getTopLevelIgnores(),
+      serverState_->getEdenConfig()->diffMaxSubtreeFanout.getValue(),
+      &serverState_->getGitIgnoreCache());
 }
 
 ImmediateFuture<Unit> EdenMount::diff(
@@ -1751,44 +2013,9 @@ ImmediateFuture<Unit> EdenMount::diff(
     bool enforceCurrentParent,
     folly::CancellationToken cancellation) const {
   if (enforceCurrentParent) {
-    auto parentInfo = parentState_.rlock();
-
-    if (parentInfo->checkoutInProgress) {
-      if (parentInfo->checkoutPid == folly::get_cached_pid() ||
-          !parentInfo->checkoutOriginalTrees) {
-        return makeImmediateFuture<Unit>(newEdenError(
-            EdenErrorType::CHECKOUT_IN_PROGRESS,
-            "cannot compute status while a checkout is currently in progress"));
-      } else if (getEdenConfig()->allowResumeCheckout.getValue()) {
-        auto [fromCommit, toCommit] = *parentInfo->checkoutOriginalTrees;
-        return makeImmediateFuture<Unit>(newEdenError(
-            EdenErrorType::CHECKOUT_IN_PROGRESS,
-            fmt::format(
-                "cannot compute status while a checkout is in progress - please run 'hg update --clean {}' to resume it",
-                toCommit)));
-      } else {
-        return makeImmediateFuture<Unit>(newEdenError(
-            EdenErrorType::CHECKOUT_IN_PROGRESS,
-            "cannot compute status for an interrupted checkout operation"));
-      }
-    }
-
-    if (parentInfo->workingCopyParentRootId != commitHash) {
-      // Log this occurrence to Scuba
-      getServerState()->getStructuredLogger()->logEvent(ParentMismatch{
-          commitHash.value(), parentInfo->workingCopyParentRootId.value()});
-      return makeImmediateFuture<Unit>(newEdenError(
-          EdenErrorType::OUT_OF_DATE_PARENT,
-          "error computing status: requested parent commit is out-of-date: requested ",
-          commitHash,
-          ", but current parent commit is ",
-          parentInfo->workingCopyParentRootId,
-          ".\nTry running `eden doctor` to remediate"));
+    if (auto error = checkStatusParent(commitHash)) {
+      return makeImmediateFuture<Unit>(std::move(error));
     }
-
-    // TODO: Should we perhaps hold the parentInfo read-lock for the duration
-    // of the status operation?  This would block new checkout operations from
-    // starting until we have finished computing this status call.
   }
 
   // Create a DiffContext object for this diff operation.
@@ -1804,11 +2031,87 @@ ImmediateFuture<Unit> EdenMount::diff(
   return diff(ctxPtr, commitHash).ensure(std::move(stateHolder));
 }
 
+folly::exception_wrapper EdenMount::checkStatusParent(
+    const RootId& commitHash) const {
+  auto parentInfo = parentState_.rlock();
+
+  if (parentInfo->checkoutInProgress) {
+    if (parentInfo->checkoutPid == folly::get_cached_pid() ||
+        !parentInfo->checkoutOriginalTrees) {
+      return folly::exception_wrapper{newEdenError(
+          EdenErrorType::CHECKOUT_IN_PROGRESS,
+          "cannot compute status while a checkout is currently in progress")};
+    } else if (getEdenConfig()->allowResumeCheckout.getValue()) {
+      auto [fromCommit, toCommit] = *parentInfo->checkoutOriginalTrees;
+      return folly::exception_wrapper{newEdenError(
+          EdenErrorType::CHECKOUT_IN_PROGRESS,
+          fmt::format(
+              "cannot compute status while a checkout is in progress - please run 'hg update --clean {}' to resume it",
+              toCommit))};
+    } else {
+      return folly::exception_wrapper{newEdenError(
+          EdenErrorType::CHECKOUT_IN_PROGRESS,
+          "cannot compute status for an interrupted checkout operation")};
+    }
+  }
+
+  if (parentInfo->workingCopyParentRootId != commitHash) {
+    // Log this occurrence to Scuba
+    getServerState()->getStructuredLogger()->logEvent(ParentMismatch{
+        commitHash.value(), parentInfo->workingCopyParentRootId.value()});
+    return folly::exception_wrapper{newEdenError(
+        EdenErrorType::OUT_OF_DATE_PARENT,
+        "error computing status: requested parent commit is out-of-date: requested ",
+        commitHash,
+        ", but current parent commit is ",
+        parentInfo->workingCopyParentRootId,
+        ".\nTry running `eden doctor` to remediate")};
+  }
+
+  // TODO: Should we perhaps hold the parentInfo read-lock for the duration
+  // of the status operation?  This would block new checkout operations from
+  // starting until we have finished computing this status call.
+  return folly::exception_wrapper{};
+}
+
 ImmediateFuture<std::unique_ptr<ScmStatus>> EdenMount::diff(
     const RootId& commitHash,
     folly::CancellationToken cancellation,
     bool listIgnored,
     bool enforceCurrentParent) {
+  std::optional<CachedStatus> cacheKey;
+  if (getEdenConfig()->enableStatusCache.getValue()) {
+    // Every change to the working copy or its parent commit advances the
+    // journal, even once older entries are truncated, so an unchanged
+    // sequence number means the status is unchanged too. The position is
+    // read before diffing: a change racing with the diff only makes the
+    // next call recompute it.
+    auto latest = journal_->getLatest();
+    cacheKey = CachedStatus{
+        commitHash,
+        listIgnored,
+        latest ? latest->sequenceID : 0,
+        serverState_->getTopLevelIgnoresVersion(),
+        nullptr};
+
+    std::shared_ptr<const ScmStatus> cached;
+    {
+      auto cachedStatus = cachedStatus_.rlock();
+      if (cachedStatus->has_value() && (*cachedStatus)->matches(*cacheKey)) {
+        cached = (*cachedStatus)->status;
+      }
+    }
+    if (cached) {
+      if (enforceCurrentParent) {
+        if (auto error = checkStatusParent(commitHash)) {
+          return makeImmediateFuture<std::unique_ptr<ScmStatus>>(
+              std::move(error));
+        }
+      }
+      return std::make_unique<ScmStatus>(*cached);
+    }
+  }
+
   auto callback = std::make_unique<ScmStatusDiffCallback>();
   auto callbackPtr = callback.get();
   return this
@@ -1818,8 +2121,17 @@ ImmediateFuture<std::unique_ptr<ScmStatus>> EdenMount::diff(
           listIgnored,
           enforceCurrentParent,
           std::move(cancellation))
-      .thenValue([callback = std::move(callback)](auto&&) {
-        return std::make_unique<ScmStatus>(callback->extractStatus());
+      .thenValue([this,
+                  callback = std::move(callback),
+                  cacheKey = std::move(cacheKey)](auto&&) mutable {
+        auto status = std::make_unique<ScmStatus>(callback->extractStatus());
+        // Errors are usually transient fetch failures, so statuses that hit
+        // them are not reused.
+        if (cacheKey && status->errors_ref()->empty()) {
+          cacheKey->status = std::make_shared<const ScmStatus>(*status);
+          *cachedStatus_.wlock() = std::move(cacheKey);
+        }
+        return status;
       });
 }
 
@@ -1834,6 +2146,56 @@ ImmediateFuture<folly::Unit> EdenMount::diffBetweenRoots(
       [diffContext = std::move(diffContext), rootInode = getRootInode()] {});
 }
 
+folly::Future<CheckoutResult> EdenMount::applyFilter(
+    std::optional<pid_t> clientPid,
+    folly::StringPiece thriftMethodCaller) {
+  auto filteredStore = std::dynamic_pointer_cast<FilteredBackingStore>(
+      objectStore_->getBackingStore());
+  if (!filteredStore) {
+    return makeFuture<CheckoutResult>(newEdenError(
+        EINVAL,
+        EdenErrorType::ARGUMENT_ERROR,
+        "mount ",
+        getPath(),
+        " is not filtered"));
+  }
+
+  try {
+    filteredStore->setFilter(FilteredBackingStore::loadFilterFile(
+        checkoutConfig_->getFilterPath()));
+  } catch (const std::exception& ex) {
+    return makeFuture<CheckoutResult>(newEdenError(
+        EdenErrorType::ARGUMENT_ERROR,
+        "unable to load the filter of ",
+        getPath(),
+        ": ",
+        ex.what()));
+  }
+
+  auto checkedOut = getCheckedOutRootId();
+  auto workingCopyParent = getWorkingCopyParent();
+  auto target = filteredStore->withCurrentFilter(checkedOut);
+  if (target == checkedOut) {
+    return CheckoutResult{};
+  }
+
+  XLOG(DBG1) << "applying the filter of " << getPath() << ": " << checkedOut
+             << " to " << target;
+  return checkout(target, clientPid, thriftMethodCaller)
+      .thenValue([this,
+                  filteredStore = std::move(filteredStore),
+                  checkedOut = std::move(checkedOut),
+                  workingCopyParent = std::move(workingCopyParent)](
+                     CheckoutResult&& result) {
+        // The checkout moved the working copy parent to the checked out
+        // commit, put it back where it was if it had been reset elsewhere.
+        if (workingCopyParent != checkedOut) {
+          resetParent(filteredStore->withCurrentFilter(workingCopyParent));
+        }
+        return std::move(result);
+      });
+}
+
 void EdenMount::resetParent(const RootId& parent) {
   // Hold the snapshot lock around the entire operation.
   auto parentLock = parentState_.wlock();
@@ -1871,6 +2233,14 @@ bool EdenMount::isCheckoutInProgress() {
   return parentLock->checkoutInProgress;
 }
 
+std::optional<CheckoutProgress> EdenMount::getCheckoutProgress() const {
+  auto ctx = currentCheckout_.rlock()->lock();
+  if (!ctx) {
+    return std::nullopt;
+  }
+  return ctx->getProgress();
+}
+
 RenameLock EdenMount::acquireRenameLock() {
   return RenameLock{this};
 }
@@ -1901,6 +2271,14 @@ std::string EdenMount::getCounterName(CounterName name) {
     case CounterName::PERIODIC_UNLINKED_INODE_UNLOAD:
       return folly::to<std::string>(
           "inodemap.", base, ".unloaded_unlinked_inodes");
+    case CounterName::METADATA_CACHE_ENTRIES:
+      return folly::to<std::string>(
+          "object_store.", base, ".metadata_cache.entries");
+    case CounterName::METADATA_CACHE_SHARED_HITS:
+      return folly::to<std::string>(
+          "object_store.", base, ".metadata_cache.shared_hits");
+    case CounterName::OVERLAY_GC_BACKLOG:
+      return folly::to<std::string>("overlay.", base, ".gc_backlog");
   }
   EDEN_BUG() << "unknown counter name "
              << static_cast<std::underlying_type_t<CounterName>>(name);
@@ -1930,7 +2308,14 @@ std::unique_ptr<FuseChannel, FuseChannelDeleter> makeFuseChannel(
       mount->getCheckoutConfig()->getCaseSensitive(),
       mount->getCheckoutConfig()->getRequireUtf8Path(),
       edenConfig->fuseMaximumRequests.getValue(),
-      mount->getCheckoutConfig()->getUseWriteBackCache())};
+      mount->getCheckoutConfig()->getUseWriteBackCache(),
+      edenConfig->fuseCloneDevicePerThread.getValue(),
+      edenConfig->fuseInvalidationThreads.getValue(),
+      edenConfig->numaPinThreads.getValue(),
+      edenConfig->fuseReaddirplus.getValue(),
+      FsChannelOverloadController::Config{
+          edenConfig->fuseOverloadMaxInFlightRequests.getValue(),
+          edenConfig->fuseOverloadMaxQueuedBulkRequests.getValue()})};
 }
 
 folly::Future<NfsServer::NfsMountInfo> makeNfsChannel(
@@ -1957,7 +2342,13 @@ folly::Future<NfsServer::NfsMountInfo> makeNfsChannel(
                    mount->getServerState()->getNotifier(),
                    mount->getCheckoutConfig()->getCaseSensitive(),
                    iosize,
-                   edenConfig->nfsTraceBusCapacity.getValue());
+                   edenConfig->nfsWriteGatherMaxBytes.getValue(),
+                   edenConfig->nfsEnableNfsv41.getValue(),
+                   edenConfig->nfsTraceBusCapacity.getValue(),
+                   FsChannelOverloadController::Config{
+                       edenConfig->nfsOverloadMaxInFlightRequests.getValue(),
+                       edenConfig->nfsOverloadMaxQueuedBulkRequests
+                           .getValue()});
              })
       .thenValue([mount, connectedSocket = std::move(connectedSocket)](
                      NfsServer::NfsMountInfo mountInfo) mutable {
@@ -2368,6 +2759,18 @@ EdenMount::initInodeActivityBuffer() {
   return std::nullopt;
 }
 
+uint64_t EdenMount::initMountGeneration() {
+  if (serverState_->getEdenConfig()->journalPersist.getValue()) {
+    if (auto generation =
+            journal_->openLog(checkoutConfig_->getJournalLogPath())) {
+      XLOG(DBG1) << "continuing the journal of " << getPath()
+                 << " from the previous edenfs process";
+      return *generation;
+    }
+  }
+  return globalProcessGeneration | ++mountGeneration;
+}
+
 void EdenMount::subscribeInodeActivityBuffer() {
   inodeTraceHandle_ = std::make_shared<InodeTraceHandle>();
 
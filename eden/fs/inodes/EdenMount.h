@@ -59,10 +59,12 @@ class Future;
 
 namespace facebook::eden {
 
+class AccessPrefetcher;
 class BindMount;
 class BlobCache;
 class CheckoutConfig;
 class CheckoutConflict;
+class CheckoutContext;
 class Clock;
 class DiffContext;
 class EdenConfig;
@@ -152,6 +154,14 @@ struct InodeTraceEvent : TraceEventBase {
       InodeEventProgress progress);
 };
 
+/**
+ * Encodes the events of an inode ActivityBuffer, oldest first, in the compact
+ * binary format returned by getRetroactiveInodeEventsSnapshot, see
+ * eden.thrift for its layout.
+ */
+std::string serializeInodeTraceEvents(
+    const ActivityBuffer<InodeTraceEvent>& buffer);
+
 /**
  * Represents types of keys for some fb303 counters.
  */
@@ -193,8 +203,25 @@ enum class CounterName {
    * unlinked inode unloading. This is used on NFS mounts to clean up old
    * inodes.
    */
-  PERIODIC_UNLINKED_INODE_UNLOAD
+  PERIODIC_UNLINKED_INODE_UNLOAD,
+
+  /**
+   * Represents the number of entries of the repository's shared metadata
+   * cache that were inserted for this mount.
+   */
+  METADATA_CACHE_ENTRIES,
 
+  /**
+   * Represents the number of metadata cache hits of this mount on entries
+   * inserted for another mount of the same repository.
+   */
+  METADATA_CACHE_SHARED_HITS,
+
+  /**
+   * Represents the number of forgotten directories the overlay has yet to
+   * collect.
+   */
+  OVERLAY_GC_BACKLOG
 };
 
 /**
@@ -215,6 +242,36 @@ struct CheckoutTimes {
   duration didAcquireRenameLock{};
   duration didCheckout{};
   duration didFinish{};
+  /**
+   * How long prefetching the changed Trees took, running alongside the
+   * checkout phase. Unset if prefetching was disabled or did not finish
+   * before the checkout did.
+   */
+  std::optional<duration> treePrefetch;
+  size_t treesPrefetched{0};
+};
+
+/**
+ * A snapshot of how far along a checkout is.
+ */
+struct CheckoutProgress {
+  /** Directories whose update started, including those finished. */
+  size_t directoriesStarted{0};
+  size_t directoriesFinished{0};
+  /** Directories skipped because an interrupted checkout completed them. */
+  size_t directoriesResumed{0};
+  /** Files and directories replaced, added or removed. */
+  size_t entriesUpdated{0};
+  /** Objects fetched from the network so far. */
+  size_t treesFetched{0};
+  size_t blobsFetched{0};
+  size_t blobMetadataFetched{0};
+  std::chrono::nanoseconds elapsed{0};
+  /**
+   * A rough estimate, assuming that the directories already started take as
+   * long as the ones finished so far. Unset until a directory is finished.
+   */
+  std::optional<std::chrono::nanoseconds> estimatedRemaining;
 };
 
 /**
@@ -297,10 +354,14 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
    * Asynchronous EdenMount initialization - post instantiation.
    *
    * If takeover data is specified, it is used to initialize the inode map.
+   *
+   * The root tree isn't fetched from the ObjectStore before objectStoreReady
+   * completes, but the overlay is initialized meanwhile.
    */
   FOLLY_NODISCARD folly::Future<folly::Unit> initialize(
       OverlayChecker::ProgressCallback&& progressCallback = [](auto) {},
-      const std::optional<SerializedInodeMap>& takeover = std::nullopt);
+      const std::optional<SerializedInodeMap>& takeover = std::nullopt,
+      folly::SemiFuture<folly::Unit> objectStoreReady = folly::makeSemiFuture());
 
   /**
    * Destroy the EdenMount.
@@ -489,6 +550,14 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
     return objectStore_.get();
   }
 
+  /**
+   * Return the ObjectStore used by this mount point, for background work
+   * that may outlive the EdenMount.
+   */
+  const std::shared_ptr<ObjectStore>& getObjectStorePtr() const {
+    return objectStore_;
+  }
+
   /**
    * Return Eden's blob cache.
    *
@@ -673,6 +742,17 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
       RelativePathPiece path,
       const ObjectFetchContextPtr& context) const;
 
+  /**
+   * Look up the VirtualInode of each of paths, as getVirtualInode() would.
+   *
+   * The paths are resolved as a single walk down the trie of their
+   * components: a directory shared by several of them is only looked up
+   * once. The results are in the order of paths.
+   */
+  ImmediateFuture<std::vector<folly::Try<VirtualInode>>> getVirtualInodes(
+      const std::vector<RelativePath>& paths,
+      const ObjectFetchContextPtr& context) const;
+
   /**
    * Check out the specified commit.
    *
@@ -685,6 +765,17 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
       folly::StringPiece thriftMethodCaller,
       CheckoutMode checkoutMode = CheckoutMode::NORMAL);
 
+  /**
+   * Reload the filter of a filtered mount from its filter file, and check out
+   * the current commit with it, which hides and shows the paths it changed.
+   * Local changes are kept as they would be by a checkout.
+   *
+   * Fails with an EdenError if the mount isn't filtered.
+   */
+  folly::Future<CheckoutResult> applyFilter(
+      std::optional<pid_t> clientPid,
+      folly::StringPiece thriftMethodCaller);
+
   /**
    * Chown the repository to the given uid and gid
    */
@@ -716,6 +807,23 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
       bool listIgnored = false,
       bool enforceCurrentParent = true);
 
+  /**
+   * This accepts a callback which will be invoked as differences are found.
+   * Note that the callback methods may be invoked simultaneously from multiple
+   * different threads, and the callback is responsible for performing
+   * synchronization (if it is needed). It will be packaged into a DiffContext
+   * and passed through the TreeInode diff() codepath.
+   *
+   * Unlike the diff() above, the status isn't cached: the callback gets all
+   * of the differences.
+   */
+  FOLLY_NODISCARD ImmediateFuture<folly::Unit> diff(
+      DiffCallback* callback,
+      const RootId& commitHash,
+      bool listIgnored,
+      bool enforceCurrentParent,
+      folly::CancellationToken cancellation) const;
+
   /**
    * Compute the difference between the passed in roots.
    *
@@ -764,6 +872,14 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
    */
   EdenStats* getStats() const;
 
+  /**
+   * Returns the prefetcher learning which files are read together in this
+   * mount.
+   */
+  AccessPrefetcher& getAccessPrefetcher() const {
+    return *accessPrefetcher_;
+  }
+
   const folly::Logger& getStraceLogger() const {
     return straceLogger_;
   }
@@ -795,6 +911,12 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
    */
   bool isCheckoutInProgress();
 
+  /**
+   * Returns how far along the checkout running in this process is, or
+   * std::nullopt if none is.
+   */
+  std::optional<CheckoutProgress> getCheckoutProgress() const;
+
   /**
    * Returns the key value to an fb303 counter.
    */
@@ -892,6 +1014,13 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
    */
   std::optional<ActivityBuffer<InodeTraceEvent>> initInodeActivityBuffer();
 
+  /**
+   * Open the journal log if the journal is persisted, and return the
+   * generation of this mount: the one of the mount that closed the log, if
+   * its journal was loaded, and a new one otherwise.
+   */
+  uint64_t initMountGeneration();
+
   /**
    * Subscribes inodeActivityBuffer_ to the inodeTraceBus_ in order to read and
    * store InodeTraceEvents into the ActivityBuffer as they occur. In addition,
@@ -983,6 +1112,20 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
       CheckoutMode checkoutMode,
       const ObjectFetchContextPtr& context);
 
+  /**
+   * Make destination a copy of the directory at source, without copying
+   * anything: destination is grafted the source control tree source still
+   * matches, and both are materialized independently from then on.
+   *
+   * Fails with EINVAL if source is materialized, as it no longer matches a
+   * source control tree, and with EEXIST if destination conflicts with
+   * existing files.
+   */
+  FOLLY_NODISCARD ImmediateFuture<folly::Unit> cloneDirectory(
+      RelativePath source,
+      RelativePath destination,
+      const ObjectFetchContextPtr& context);
+
   /**
    * Should only be called by the mount contructor. We decide wether this
    * mount should use nfs at construction time and do not change the decision.
@@ -1024,6 +1167,31 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
   friend class SharedRenameLock;
   class JournalDiffCallback;
 
+  /**
+   * The last status computed by diff(), along with the state it was computed
+   * against.
+   */
+  struct CachedStatus {
+    RootId commit;
+    bool listIgnored;
+    uint64_t journalSequence;
+    size_t ignoreFilesVersion;
+    std::shared_ptr<const ScmStatus> status;
+
+    bool matches(const CachedStatus& other) const {
+      return commit == other.commit && listIgnored == other.listIgnored &&
+          journalSequence == other.journalSequence &&
+          ignoreFilesVersion == other.ignoreFilesVersion;
+    }
+  };
+
+  /**
+   * Return an error if a status against commitHash must not be computed
+   * because a checkout is in progress or the working copy parent is
+   * different, or an empty exception_wrapper otherwise.
+   */
+  folly::exception_wrapper checkStatusParent(const RootId& commitHash) const;
+
   /**
    * Attempt to transition from expected -> newState.
    * If the current state is expected then the state is set to newState
@@ -1089,20 +1257,6 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
       folly::CancellationToken cancellation,
       bool listIgnored = false) const;
 
-  /**
-   * This accepts a callback which will be invoked as differences are found.
-   * Note that the callback methods may be invoked simultaneously from multiple
-   * different threads, and the callback is responsible for performing
-   * synchronization (if it is needed). It will be packaged into a DiffContext
-   * and passed through the TreeInode diff() codepath
-   */
-  FOLLY_NODISCARD ImmediateFuture<folly::Unit> diff(
-      DiffCallback* callback,
-      const RootId& commitHash,
-      bool listIgnored,
-      bool enforceCurrentParent,
-      folly::CancellationToken cancellation) const;
-
   /**
    * Signal to unmount() that fuseMount() or takeoverFuse() has started.
    *
@@ -1234,12 +1388,25 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
  private:
   ParentLock parentState_;
 
+  /**
+   * The checkout running in this process, for reporting its progress.
+   */
+  folly::Synchronized<std::weak_ptr<CheckoutContext>> currentCheckout_;
+
   std::unique_ptr<Journal> journal_;
   folly::Synchronized<std::unique_ptr<IActivityRecorder>> activityRecorder_;
 
+  /**
+   * Reused by diff() while the journal and the ignore files are unchanged,
+   * so that repeated status calls do not walk every materialized directory.
+   */
+  folly::Synchronized<std::optional<CachedStatus>> cachedStatus_;
+
   /**
    * A number to uniquely identify this particular incarnation of this mount.
    * We use bits from the process id and the time at which we were mounted.
+   * A mount whose journal was loaded from the log of a previous incarnation
+   * continues it, and thus keeps its generation.
    */
   const uint64_t mountGeneration_;
 
@@ -1367,6 +1534,8 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
    * can be inline without having to include ServerState.h in this file.
    */
   std::shared_ptr<Clock> clock_;
+
+  std::unique_ptr<AccessPrefetcher> accessPrefetcher_;
 };
 
 /**
@@ -10,11 +10,15 @@
 #include <fmt/format.h>
 #include <optional>
 
+#include <folly/Conv.h>
+#include <folly/futures/Future.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
 #include <folly/io/async/EventBase.h>
 #include <folly/logging/xlog.h>
+#include <folly/stop_watch.h>
 
+#include "eden/fs/inodes/AccessPrefetcher.h"
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/InodeError.h"
 #include "eden/fs/inodes/InodeTable.h"
@@ -26,6 +30,7 @@
 #include "eden/fs/store/BackingStore.h"
 #include "eden/fs/store/BlobAccess.h"
 #include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/telemetry/IHiveLogger.h"
 #include "eden/fs/utils/Bug.h"
 #include "eden/fs/utils/Clock.h"
@@ -602,6 +607,25 @@ std::optional<bool> FileInode::isSameAsFast(
   return std::nullopt;
 }
 
+std::optional<bool> FileInode::isSameSizeFast(uint64_t size) {
+  auto state = LockedState{this};
+  if (state->isMaterialized()) {
+#ifndef _WIN32
+    // The size of the overlay file is cached, or one fstat away.
+    if (static_cast<uint64_t>(
+            getOverlayFileAccess(state)->getFileSize(*this)) != size) {
+      return false;
+    }
+#endif // !_WIN32
+  } else if (
+      state->nonMaterializedState->size !=
+          FileInodeState::NonMaterializedState::kUnknownSize &&
+      state->nonMaterializedState->size != size) {
+    return false;
+  }
+  return std::nullopt;
+}
+
 ImmediateFuture<bool> FileInode::isSameAsSlow(
     const Hash20& expectedBlobSha1,
     const ObjectFetchContextPtr& fetchContext) {
@@ -631,15 +655,32 @@ ImmediateFuture<bool> FileInode::isSameAs(
 
 ImmediateFuture<bool> FileInode::isSameAs(
     const ObjectId& blobID,
-    const Hash20& blobSha1,
+    const BlobMetadata& blobMetadata,
     TreeEntryType entryType,
     const ObjectFetchContextPtr& fetchContext) {
   auto result = isSameAsFast(blobID, entryType);
+  if (!result.has_value()) {
+    result = isSameSizeFast(blobMetadata.size);
+  }
   if (result.has_value()) {
     return result.value();
   }
 
-  return isSameAsSlow(blobSha1, fetchContext);
+  if (!state_.rlock()->isMaterialized()) {
+    return isSameAsSlow(blobMetadata.sha1, fetchContext);
+  }
+
+  // Hashing a materialized file reads it whole, unless its SHA-1 is cached:
+  // do so on the server thread pool rather than on the calling thread, which
+  // is typically comparing many files in a row during checkout.
+  return folly::via(
+             getMount()->getServerThreadPool().get(),
+             [self = inodePtrFromThis(),
+              sha1 = blobMetadata.sha1,
+              fetchContext = fetchContext.copy()] {
+               return self->isSameAsSlow(sha1, fetchContext).semi();
+             })
+      .semi();
 }
 
 ImmediateFuture<bool> FileInode::isSameAs(
@@ -722,7 +763,12 @@ ImmediateFuture<vector<string>> FileInode::listxattr() {
 ImmediateFuture<string> FileInode::getxattr(
     StringPiece name,
     const ObjectFetchContextPtr& context) {
-  // Currently, we only support the xattr for the SHA-1 of a regular file.
+  // Currently, we only support the xattrs for the SHA-1 and the size of a
+  // regular file.
+  if (name == kXattrSize) {
+    return stat(context).thenValue(
+        [](const struct stat& st) { return folly::to<string>(st.st_size); });
+  }
   if (name != kXattrSha1) {
     return makeImmediateFuture<string>(
         InodeError(kENOATTR, inodePtrFromThis()));
@@ -1010,7 +1056,8 @@ ImmediateFuture<folly::Unit> FileInode::ensureMaterialized(
 ImmediateFuture<std::tuple<BufVec, bool>>
 FileInode::read(size_t size, off_t off, const ObjectFetchContextPtr& context) {
   XDCHECK_GE(off, 0);
-  return runWhileDataLoaded(
+  folly::stop_watch<std::chrono::microseconds> watch;
+  auto future = runWhileDataLoaded(
       LockedState{this},
       BlobCache::Interest::WantHandle,
       // This function is only called by FUSE.
@@ -1046,6 +1093,12 @@ FileInode::read(size_t size, off_t off, const ObjectFetchContextPtr& context) {
                      << " because it's been fully read.";
           state->interestHandle.reset();
           state->readByteRanges.clear();
+          auto* mount = self->getMount();
+          if (mount->getServerState()
+                  ->getEdenConfig(ConfigReloadBehavior::NoReload)
+                  ->blobCacheReleaseFullyReadBlobs.getValue()) {
+            mount->getBlobCache()->remove(blob->getHash());
+          }
         }
 
         auto buf = blob->getContents();
@@ -1063,6 +1116,15 @@ FileInode::read(size_t size, off_t off, const ObjectFetchContextPtr& context) {
 
         return {BufVec{std::move(result)}, cursor.isAtEnd()};
       });
+  if (future.isReady()) {
+    return future;
+  }
+  return std::move(future).thenValue(
+      [watch, self = inodePtrFromThis()](std::tuple<BufVec, bool>&& result) {
+        self->getMount()->getStats()->addDuration(
+            &FileInodeStats::readBlobWait, watch.elapsed());
+        return std::move(result);
+      });
 }
 
 size_t FileInode::writeImpl(
@@ -1087,13 +1149,24 @@ ImmediateFuture<size_t> FileInode::write(
     BufVec&& buf,
     off_t off,
     const ObjectFetchContextPtr& fetchContext) {
+  auto state = LockedState{this};
+
+  // Minor optimization: if the write overwrites the whole file there is no
+  // need to fetch the blob only to copy it into the overlay.
+  if (writeReplacesContents(state, buf->computeChainDataLength(), off)) {
+    return truncateAndRun(std::move(state), [&](LockedState&& stateLock) {
+      auto vec = buf->getIov();
+      return writeImpl(stateLock, vec.data(), vec.size(), off);
+    });
+  }
+
   return runWhileMaterialized(
-      LockedState{this},
+      std::move(state),
       nullptr,
       [buf = std::move(buf), off, self = inodePtrFromThis()](
-          LockedState&& state) {
+          LockedState&& stateLock) {
         auto vec = buf->getIov();
-        return self->writeImpl(state, vec.data(), vec.size(), off);
+        return self->writeImpl(stateLock, vec.data(), vec.size(), off);
       },
       fetchContext);
 }
@@ -1112,6 +1185,15 @@ ImmediateFuture<size_t> FileInode::write(
     return writeImpl(state, &iov, 1, off);
   }
 
+  if (writeReplacesContents(state, data.size(), off)) {
+    return truncateAndRun(std::move(state), [&](LockedState&& stateLock) {
+      struct iovec iov;
+      iov.iov_base = const_cast<char*>(data.data());
+      iov.iov_len = data.size();
+      return writeImpl(stateLock, &iov, 1, off);
+    });
+  }
+
   return runWhileMaterialized(
       std::move(state),
       nullptr,
@@ -1148,6 +1230,16 @@ ImmediateFuture<std::shared_ptr<const Blob>> FileInode::startLoadingData(
   // Unlock state_ while we wait on the blob data to load
   state.unlock();
 
+  auto clientPid = fetchContext->getClientPid();
+  if (clientPid && fetchContext->getCause() == ObjectFetchContext::Cause::Fs) {
+    auto& prefetcher = getMount()->getAccessPrefetcher();
+    if (prefetcher.isEnabled()) {
+      if (auto path = getPath()) {
+        prefetcher.recordRead(*clientPid, std::move(*path));
+      }
+    }
+  }
+
   auto self = inodePtrFromThis(); // separate line for formatting
   std::move(getBlobFuture)
       .thenTry([self](folly::Try<BlobCache::GetResult> tryResult) mutable {
@@ -1223,7 +1315,8 @@ void FileInode::materializeNow(
     blobSha1 = std::move(blobSha1Future).get();
   }
 
-  getOverlayFileAccess(state)->createFile(getNodeId(), *blob, blobSha1);
+  getOverlayFileAccess(state)->createFile(
+      getNodeId(), state->nonMaterializedState->hash, *blob, blobSha1);
 
   state.setMaterialized();
 }
@@ -1241,6 +1334,17 @@ void FileInode::truncateInOverlay(LockedState& state) {
   getOverlayFileAccess(state)->truncate(*this);
 }
 
+bool FileInode::writeReplacesContents(
+    const LockedState& state,
+    size_t length,
+    off_t off) const {
+  if (off != 0 || !state->nonMaterializedState) {
+    return false;
+  }
+  auto size = state->nonMaterializedState->size;
+  return size != State::NonMaterializedState::kUnknownSize && length >= size;
+}
+
 OverlayFileAccess* FileInode::getOverlayFileAccess(LockedState&) const {
   return getMount()->getOverlayFileAccess();
 }
@@ -191,9 +191,15 @@ class FileInode final : public InodeBaseMetadata<FileInodeState> {
       const Blob& blob,
       TreeEntryType entryType,
       const ObjectFetchContextPtr& fetchContext);
+  /**
+   * Like the above, for a blob whose metadata is known. A materialized file
+   * whose size differs from the blob's is reported as different without
+   * hashing it, and otherwise its contents are hashed on the server thread
+   * pool so that many files can be compared in parallel.
+   */
   ImmediateFuture<bool> isSameAs(
       const ObjectId& blobID,
-      const Hash20& blobSha1,
+      const BlobMetadata& blobMetadata,
       TreeEntryType entryType,
       const ObjectFetchContextPtr& fetchContext);
   ImmediateFuture<bool> isSameAs(
@@ -392,6 +398,20 @@ class FileInode final : public InodeBaseMetadata<FileInodeState> {
    */
   void truncateInOverlay(LockedState& state);
 
+  /**
+   * Returns true if this file is not materialized and a write of `length`
+   * bytes at offset `off` overwrites all of its contents. Such a write does
+   * not need the blob: the file can be materialized empty with
+   * truncateAndRun() instead of copying the blob into the overlay first.
+   *
+   * This only relies on a size that is already cached in the inode state, so
+   * it never triggers a fetch.
+   */
+  bool writeReplacesContents(
+      const LockedState& state,
+      size_t length,
+      off_t off) const;
+
 #endif // !_WIN32
 
   /**
@@ -435,6 +455,15 @@ class FileInode final : public InodeBaseMetadata<FileInodeState> {
       const ObjectId& blobID,
       TreeEntryType entryType);
 
+  /**
+   * Helper function for isSameAs().
+   *
+   * Compares the size of the file with the given size when it is known
+   * without loading the blob: returns false if they differ, and std::nullopt
+   * if they match or the size of the file is not known.
+   */
+  std::optional<bool> isSameSizeFast(uint64_t size);
+
   /**
    * Helper function for isSameAs().
    *
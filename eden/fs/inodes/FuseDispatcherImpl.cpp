@@ -8,7 +8,9 @@
 #ifndef _WIN32
 
 #include "eden/fs/inodes/FuseDispatcherImpl.h"
+#include <folly/Conv.h>
 #include <folly/logging/xlog.h>
+#include <limits>
 #include "eden/fs/fuse/DirList.h"
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/FileInode.h"
@@ -17,8 +19,10 @@
 #include "eden/fs/inodes/Overlay.h"
 #include "eden/fs/inodes/TreeInode.h"
 #include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/store/ObjectStore.h"
 #include "eden/fs/utils/Clock.h"
 #include "eden/fs/utils/SystemError.h"
+#include "eden/fs/utils/XAttr.h"
 
 using namespace folly;
 using std::string;
@@ -45,12 +49,78 @@ fuse_entry_out computeEntryParam(const FuseDispatcher::Attr& attr) {
 
 constexpr int64_t kBrokenInodeCacheSeconds = 5;
 
+// As with FuseDispatcher::Attr, this is the largest signed 32 bit value
+// rather than the largest unsigned 64 bit one: the macOS kext adds the TTL to
+// a signed deadline, which would overflow and never be a cache hit.
+constexpr uint64_t kNegativeEntryCacheSeconds =
+    std::numeric_limits<int32_t>::max();
+
 FuseDispatcher::Attr attrForInodeWithCorruptOverlay(InodeNumber ino) noexcept {
   struct stat st = {};
   st.st_ino = ino.get();
   st.st_mode = S_IFREG;
   return FuseDispatcher::Attr{st, kBrokenInodeCacheSeconds};
 }
+
+/**
+ * Compute the fuse_entry_out returned to the kernel when it looks up inode,
+ * and count that lookup.
+ */
+ImmediateFuture<fuse_entry_out> lookupEntryParam(
+    const InodePtr& inode,
+    const ObjectFetchContextPtr& context) {
+  return makeImmediateFutureWith([&]() { return inode->stat(context); })
+      .thenTry([inode](folly::Try<struct stat> maybeStat) {
+        if (maybeStat.hasValue()) {
+          inode->incFsRefcount();
+          return computeEntryParam(FuseDispatcher::Attr{maybeStat.value()});
+        } else {
+          // The most common case for stat() failing is if this file is
+          // materialized but the data for it in the overlay is missing or
+          // corrupt.  This can happen after a hard reboot where the overlay
+          // data was not synced to disk first.
+          //
+          // We intentionally want to return a result here rather than
+          // failing; otherwise we can't return the inode number to the kernel
+          // at all.  This blocks other operations on the file, like
+          // FUSE_UNLINK.  By successfully returning from the lookup we allow
+          // clients to remove this corrupt file with an unlink operation.
+          // (Even though FUSE_UNLINK does not require the child inode number,
+          // the kernel does not appear to send a FUSE_UNLINK request to us if
+          // it could not get the child inode number first.)
+          XLOG(WARN) << "error getting attributes for inode "
+                     << inode->getNodeId() << " (" << inode->getLogPath()
+                     << "): " << maybeStat.exception().what();
+          inode->incFsRefcount();
+          return computeEntryParam(
+              attrForInodeWithCorruptOverlay(inode->getNodeId()));
+        }
+      });
+}
+
+/**
+ * Returns the source control object of a remembered but unloaded regular
+ * file from its parent's entry, or std::nullopt if the file is loaded,
+ * materialized, or its parent isn't loaded.
+ */
+std::optional<ObjectId> getUnloadedFileObjectId(
+    InodeMap& inodeMap,
+    InodeNumber ino) {
+  auto parentAndName = inodeMap.lookupUnloadedFileParent(ino);
+  if (!parentAndName) {
+    return std::nullopt;
+  }
+  auto& [parent, name] = *parentAndName;
+  auto contents = parent->getContents().rlock();
+  auto it = contents->entries.find(name);
+  // The file may have been loaded, renamed, or materialized since the
+  // InodeMap was looked up.
+  if (it == contents->entries.end() || it->second.getInode() ||
+      it->second.getInodeNumber() != ino) {
+    return std::nullopt;
+  }
+  return it->second.getOptionalHash();
+}
 } // namespace
 
 FuseDispatcherImpl::FuseDispatcherImpl(EdenMount* mount)
@@ -101,47 +171,18 @@ ImmediateFuture<fuse_entry_out> FuseDispatcherImpl::lookup(
         return tree->getOrLoadChild(name, context);
       })
       .thenValue([context = context.copy()](const InodePtr& inode) {
-        return makeImmediateFutureWith([&]() { return inode->stat(context); })
-            .thenTry([inode](folly::Try<struct stat> maybeStat) {
-              if (maybeStat.hasValue()) {
-                inode->incFsRefcount();
-                return computeEntryParam(
-                    FuseDispatcher::Attr{maybeStat.value()});
-              } else {
-                // The most common case for stat() failing is if this file is
-                // materialized but the data for it in the overlay is missing
-                // or corrupt.  This can happen after a hard reboot where the
-                // overlay data was not synced to disk first.
-                //
-                // We intentionally want to return a result here rather than
-                // failing; otherwise we can't return the inode number to the
-                // kernel at all.  This blocks other operations on the file,
-                // like FUSE_UNLINK.  By successfully returning from the
-                // lookup we allow clients to remove this corrupt file with an
-                // unlink operation.  (Even though FUSE_UNLINK does not require
-                // the child inode number, the kernel does not appear to send a
-                // FUSE_UNLINK request to us if it could not get the child inode
-                // number first.)
-                XLOG(WARN) << "error getting attributes for inode "
-                           << inode->getNodeId() << " (" << inode->getLogPath()
-                           << "): " << maybeStat.exception().what();
-                inode->incFsRefcount();
-                return computeEntryParam(
-                    attrForInodeWithCorruptOverlay(inode->getNodeId()));
-              }
-            });
+        return lookupEntryParam(inode, context);
       })
       .thenTry([](folly::Try<fuse_entry_out> try_) {
         if (auto* err = try_.tryGetExceptionObject<std::system_error>()) {
           if (isEnoent(*err)) {
             // Translate ENOENT into a successful response with an
             // inode number of 0 and a large entry_valid time, to let the kernel
-            // cache this negative lookup result.
+            // cache this negative lookup result. Entries created through FUSE
+            // replace it, and checkout invalidates the names it adds.
             fuse_entry_out entry = {};
-            entry.attr_valid =
-                std::numeric_limits<decltype(entry.attr_valid)>::max();
-            entry.entry_valid =
-                std::numeric_limits<decltype(entry.entry_valid)>::max();
+            entry.attr_valid = kNegativeEntryCacheSeconds;
+            entry.entry_valid = kNegativeEntryCacheSeconds;
             return folly::Try<fuse_entry_out>{entry};
           }
         }
@@ -336,6 +377,55 @@ ImmediateFuture<FuseDirList> FuseDispatcherImpl::readdir(
       });
 }
 
+#ifdef __linux__
+ImmediateFuture<FuseDirList> FuseDispatcherImpl::readdirplus(
+    InodeNumber ino,
+    FuseDirList&& dirList,
+    off_t offset,
+    uint64_t /*fh*/,
+    const ObjectFetchContextPtr& context) {
+  return inodeMap_->lookupTreeInode(ino).thenValue(
+      [dirList = std::move(dirList), offset, context = context.copy()](
+          TreeInodePtr inode) mutable {
+        // fuseReaddir prefetches the metadata of all the children at once,
+        // so the stat of each entry below rarely waits on its own fetch.
+        auto list = inode->fuseReaddir(std::move(dirList), offset, context);
+        auto entries = list.extract();
+
+        std::vector<ImmediateFuture<fuse_entry_out>> futures;
+        futures.reserve(entries.size());
+        for (auto& entry : entries) {
+          // The kernel ignores the attributes of . and ..
+          if (entry.name == "." || entry.name == "..") {
+            futures.emplace_back(fuse_entry_out{});
+            continue;
+          }
+          futures.push_back(
+              inode->getOrLoadChild(PathComponent{entry.name}, context)
+                  .thenValue([context = context.copy()](
+                                 const InodePtr& child) {
+                    return lookupEntryParam(child, context);
+                  }));
+        }
+
+        return collectAll(std::move(futures))
+            .thenValue([list = std::move(list)](
+                           std::vector<folly::Try<fuse_entry_out>>
+                               entryOuts) mutable {
+              for (size_t i = 0; i < entryOuts.size(); ++i) {
+                // An entry that was removed or failed to load keeps a nodeid
+                // of 0: the kernel lists it without looking it up, and will
+                // send a FUSE_LOOKUP for it if needed.
+                if (entryOuts[i].hasValue()) {
+                  list.setEntryOut(i, entryOuts[i].value());
+                }
+              }
+              return std::move(list);
+            });
+      });
+}
+#endif
+
 ImmediateFuture<fuse_entry_out> FuseDispatcherImpl::mknod(
     InodeNumber parent,
     PathComponentPiece name,
@@ -456,6 +546,20 @@ ImmediateFuture<string> FuseDispatcherImpl::getxattr(
     InodeNumber ino,
     StringPiece name,
     const ObjectFetchContextPtr& context) {
+  if (name == kXattrSha1 || name == kXattrSize) {
+    // Answer from the source control object of unloaded files rather than
+    // loading them: ObjectStore caches blob metadata.
+    if (auto id = getUnloadedFileObjectId(*inodeMap_, ino)) {
+      auto& objectStore = *mount_->getObjectStore();
+      if (name == kXattrSha1) {
+        return objectStore.getBlobSha1(*id, context).thenValue(
+            [](const Hash20& sha1) { return sha1.toString(); });
+      }
+      return objectStore.getBlobSize(*id, context).thenValue(
+          [](uint64_t size) { return folly::to<string>(size); });
+    }
+  }
+
   return inodeMap_->lookupInode(ino).thenValue(
       [attrName = name.str(), context = context.copy()](const InodePtr& inode) {
         return inode->getxattr(attrName, context);
@@ -118,6 +118,14 @@ class FuseDispatcherImpl : public FuseDispatcher {
       off_t offset,
       uint64_t fh,
       const ObjectFetchContextPtr& context) override;
+#ifdef __linux__
+  ImmediateFuture<FuseDirList> readdirplus(
+      InodeNumber ino,
+      FuseDirList&& dirList,
+      off_t offset,
+      uint64_t fh,
+      const ObjectFetchContextPtr& context) override;
+#endif
 
   ImmediateFuture<std::string> getxattr(
       InodeNumber ino,
@@ -6,9 +6,13 @@
  */
 
 #include "GlobNode.h"
+#include <folly/logging/xlog.h>
+#include <algorithm>
+#include <atomic>
 #include <iomanip>
 #include <iostream>
 #include "eden/fs/inodes/TreeInode.h"
+#include "eden/fs/store/GlobResultCache.h"
 
 using folly::StringPiece;
 using std::string;
@@ -32,12 +36,16 @@ namespace {
  * not materialized.
  */
 struct TreeInodePtrRoot {
+  // Whether the contents are those of a source control tree, which never
+  // change.
+  static constexpr bool kIsSourceControlTree = false;
+
   TreeInodePtr root;
 
   explicit TreeInodePtrRoot(TreeInodePtr root) : root(std::move(root)) {}
 
   /** Return an object that holds a lock over the children */
-  folly::Synchronized<TreeInodeState>::RLockedPtr lockContents() {
+  SynchronizedTreeInodeState::RLockedPtr lockContents() {
     return root->getContents().rlock();
   }
 
@@ -60,7 +68,7 @@ struct TreeInodePtrRoot {
    * The returned iterator yields ENTRY elements that can be
    * used with the entryXXX methods below. */
   const DirContents& iterate(
-      const folly::Synchronized<TreeInodeState>::RLockedPtr& contents) const {
+      const SynchronizedTreeInodeState::RLockedPtr& contents) const {
     return contents->entries;
   }
 
@@ -86,6 +94,15 @@ struct TreeInodePtrRoot {
   bool entryShouldPrefetch(const DirEntry* entry) {
     return !entry->isMaterialized() && !entryIsTree(entry);
   }
+
+  /** Pass a match to the sink. Materialized entries have no id, none is
+   * thus passed along. */
+  void addResult(
+      GlobNode::ResultSink& sink,
+      GlobNode::GlobResult&& result,
+      const DirEntry*) {
+    sink.add(std::move(result));
+  }
 };
 
 /** TreeRoot wraps a Tree for globbing.
@@ -93,6 +110,8 @@ struct TreeInodePtrRoot {
  * we return the entries when lockContents() is called.
  */
 struct TreeRoot {
+  static constexpr bool kIsSourceControlTree = true;
+
   std::shared_ptr<const Tree> tree;
 
   explicit TreeRoot(std::shared_ptr<const Tree> tree) : tree(std::move(tree)) {}
@@ -142,7 +161,75 @@ struct TreeRoot {
   bool entryShouldPrefetch(const TreeEntry* entry) {
     return !entryIsTree(entry);
   }
+
+  void addResult(
+      GlobNode::ResultSink& sink,
+      GlobNode::GlobResult&& result,
+      const TreeEntry* entry) {
+    sink.addTreeEntry(std::move(result), entry->getHash());
+  }
+};
+
+/** Appends the results of a glob evaluation to a ResultList. */
+class ResultListSink : public GlobNode::ResultSink {
+ public:
+  explicit ResultListSink(GlobNode::ResultList& results) : results_{results} {}
+
+  void add(GlobNode::GlobResult&& result) override {
+    results_.wlock()->push_back(std::move(result));
+  }
+
+ private:
+  GlobNode::ResultList& results_;
 };
+
+/**
+ * Records the matches of an evaluation against a source control tree for
+ * the GlobResultCache, and passes them to another sink prefixed with the
+ * path of that tree.
+ */
+class RecordingSink : public GlobNode::ResultSink {
+ public:
+  RecordingSink(GlobNode::ResultSink& results, RelativePathPiece rootPath)
+      : results_{results}, rootPath_{rootPath.copy()} {}
+
+  void add(GlobNode::GlobResult&& result) override {
+    // Without the id of the match, the results can't be remembered.
+    complete_ = false;
+    results_.add(GlobNode::GlobResult{
+        rootPath_ + result.name, result.dtype, *result.originHash});
+  }
+
+  void addTreeEntry(GlobNode::GlobResult&& result, const ObjectId& id)
+      override {
+    entries_.wlock()->push_back(
+        GlobResultCache::Entry{result.name.copy(), result.dtype, id});
+    results_.addTreeEntry(
+        GlobNode::GlobResult{
+            rootPath_ + result.name, result.dtype, *result.originHash},
+        id);
+  }
+
+  void save(const GlobResultCache& cache, const Hash20& key) {
+    if (!complete_) {
+      return;
+    }
+    try {
+      cache.put(key, *entries_.rlock());
+    } catch (const std::exception& ex) {
+      // The results are still correct, they just won't be remembered.
+      XLOG(WARN) << "Failed to store glob results for " << rootPath_ << ": "
+                 << ex.what();
+    }
+  }
+
+ private:
+  GlobNode::ResultSink& results_;
+  RelativePath rootPath_;
+  std::atomic<bool> complete_{true};
+  folly::Synchronized<std::vector<GlobResultCache::Entry>> entries_;
+};
+
 } // namespace
 
 GlobNode::GlobNode(
@@ -151,17 +238,15 @@ GlobNode::GlobNode(
     bool hasSpecials,
     CaseSensitivity caseSensitive)
     : pattern_(pattern.str()),
+      recursiveIndex_(globOptions(includeDotfiles, caseSensitive)),
+      caseSensitive_(caseSensitive),
       includeDotfiles_(includeDotfiles),
       hasSpecials_(hasSpecials) {
   if (includeDotfiles && (pattern == "**" || pattern == "*")) {
     alwaysMatch_ = true;
   } else {
-    auto options =
-        includeDotfiles ? GlobOptions::DEFAULT : GlobOptions::IGNORE_DOTFILES;
-    if (caseSensitive == CaseSensitivity::Insensitive) {
-      options |= GlobOptions::CASE_INSENSITIVE;
-    }
-    auto compiled = GlobMatcher::create(pattern, options);
+    auto compiled = GlobMatcher::create(
+        pattern, globOptions(includeDotfiles, caseSensitive));
     if (compiled.hasError()) {
       throw std::system_error(
           EINVAL,
@@ -175,6 +260,17 @@ GlobNode::GlobNode(
   }
 }
 
+GlobOptions GlobNode::globOptions(
+    bool includeDotfiles,
+    CaseSensitivity caseSensitive) {
+  auto options =
+      includeDotfiles ? GlobOptions::DEFAULT : GlobOptions::IGNORE_DOTFILES;
+  if (caseSensitive == CaseSensitivity::Insensitive) {
+    options |= GlobOptions::CASE_INSENSITIVE;
+  }
+  return options;
+}
+
 void GlobNode::parse(StringPiece pattern) {
   GlobNode* parent = this;
   string normalizedPattern;
@@ -214,6 +310,9 @@ void GlobNode::parse(StringPiece pattern) {
       container->emplace_back(std::make_unique<GlobNode>(
           token, includeDotfiles_, hasSpecials, caseSensitive_));
       node = container->back().get();
+      if (container == &parent->recursiveChildren_) {
+        node->isIndexed_ = parent->recursiveIndex_.add(token);
+      }
     }
 
     // If there are no more tokens remaining then we have a leaf node
@@ -230,6 +329,94 @@ void GlobNode::parse(StringPiece pattern) {
   }
 }
 
+template <typename EVALUATE>
+ImmediateFuture<folly::Unit> GlobNode::evaluateCached(
+    const ObjectStore* store,
+    const ObjectId& treeId,
+    RelativePathPiece rootPath,
+    std::optional<RelativePathPiece> startOfRecursive,
+    GlobNode::PrefetchList* fileBlobsToPrefetch,
+    GlobNode::ResultSink& globResult,
+    const RootId& originRootId,
+    EVALUATE&& evaluate) const {
+  const auto* cache = store->getGlobResultCache();
+  if (!cache) {
+    return evaluate(rootPath, globResult);
+  }
+
+  // The fingerprint has a fixed size, and the tree id is length-prefixed,
+  // which keeps the keys of different evaluations distinct.
+  std::string keyData;
+  auto fingerprint = getFingerprint().getBytes();
+  keyData.append(
+      reinterpret_cast<const char*>(fingerprint.data()), fingerprint.size());
+  auto treeBytes = treeId.getBytes();
+  keyData.append(fmt::format("{}:", treeBytes.size()));
+  keyData.append(
+      reinterpret_cast<const char*>(treeBytes.data()), treeBytes.size());
+  if (startOfRecursive) {
+    keyData.push_back('/');
+    keyData.append(startOfRecursive->view());
+  }
+  auto key = Hash20::sha1(keyData);
+
+  if (auto entries = cache->get(key)) {
+    for (auto& entry : *entries) {
+      if (fileBlobsToPrefetch && entry.dtype != dtype_t::Dir) {
+        fileBlobsToPrefetch->wlock()->push_back(entry.id);
+      }
+      globResult.addTreeEntry(
+          GlobResult{rootPath + entry.name, entry.dtype, originRootId},
+          entry.id);
+    }
+    return folly::unit;
+  }
+
+  // The evaluation is done relative to the tree, so that its results can be
+  // replayed under any path.
+  auto recorder = std::make_shared<RecordingSink>(globResult, rootPath);
+  auto& recorderRef = *recorder;
+  return evaluate(RelativePathPiece{}, recorderRef)
+      .thenValue([cache, key, recorder](folly::Unit) {
+        recorder->save(*cache, key);
+      });
+}
+
+const Hash20& GlobNode::getFingerprint() const {
+  folly::call_once(fingerprintOnce_, [this] {
+    auto childFingerprints =
+        [](const vector<unique_ptr<GlobNode>>& children) {
+          vector<Hash20> fingerprints;
+          fingerprints.reserve(children.size());
+          for (const auto& child : children) {
+            fingerprints.push_back(child->getFingerprint());
+          }
+          // The patterns match the same files whatever order they were
+          // added in.
+          std::sort(fingerprints.begin(), fingerprints.end());
+          return fingerprints;
+        };
+
+    auto description = fmt::format(
+        "v1 {}:{} leaf={} dotfiles={} case={}",
+        pattern_.size(),
+        pattern_,
+        isLeaf_,
+        includeDotfiles_,
+        caseSensitive_ == CaseSensitivity::Sensitive);
+    for (const auto& fingerprint : childFingerprints(children_)) {
+      description.append(" c:");
+      description.append(fingerprint.toString());
+    }
+    for (const auto& fingerprint : childFingerprints(recursiveChildren_)) {
+      description.append(" r:");
+      description.append(fingerprint.toString());
+    }
+    fingerprint_ = Hash20::sha1(description);
+  });
+  return fingerprint_;
+}
+
 template <typename ROOT>
 ImmediateFuture<folly::Unit> GlobNode::evaluateImpl(
     const ObjectStore* store,
@@ -237,7 +424,7 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateImpl(
     RelativePathPiece rootPath,
     ROOT&& root,
     GlobNode::PrefetchList* fileBlobsToPrefetch,
-    GlobNode::ResultList& globResult,
+    GlobNode::ResultSink& globResult,
     const RootId& originRootId) const {
   vector<std::pair<PathComponentPiece, GlobNode*>> recurse;
   vector<ImmediateFuture<folly::Unit>> futures;
@@ -261,25 +448,48 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateImpl(
           if (root.entryShouldLoadChildTree(entry)) {
             recurse.emplace_back(name, node);
           } else {
-            futures.emplace_back(
-                store->getTree(entry->getHash(), context)
-                    .thenValue([candidateName = rootPath + name,
-                                store,
-                                context = context.copy(),
-                                innerNode = node,
-                                fileBlobsToPrefetch,
-                                &globResult,
-                                &originRootId](
-                                   std::shared_ptr<const Tree> dir) mutable {
-                      return innerNode->evaluateImpl(
-                          store,
-                          context,
-                          candidateName,
-                          TreeRoot(std::move(dir)),
-                          fileBlobsToPrefetch,
-                          globResult,
-                          originRootId);
-                    }));
+            auto evaluateChild = [treeId = entry->getHash(),
+                                  store,
+                                  context = context.copy(),
+                                  innerNode = node,
+                                  fileBlobsToPrefetch,
+                                  &originRootId](
+                                     RelativePathPiece candidateName,
+                                     ResultSink& sink) {
+              return store->getTree(treeId, context)
+                  .thenValue([candidateName = candidateName.copy(),
+                              store,
+                              context = context.copy(),
+                              innerNode,
+                              fileBlobsToPrefetch,
+                              &sink,
+                              &originRootId](
+                                 std::shared_ptr<const Tree> dir) mutable {
+                    return innerNode->evaluateImpl(
+                        store,
+                        context,
+                        candidateName,
+                        TreeRoot(std::move(dir)),
+                        fileBlobsToPrefetch,
+                        sink,
+                        originRootId);
+                  });
+            };
+            if constexpr (std::decay_t<ROOT>::kIsSourceControlTree) {
+              // The results are remembered for the outermost source control
+              // tree only.
+              futures.emplace_back(evaluateChild(rootPath + name, globResult));
+            } else {
+              futures.emplace_back(node->evaluateCached(
+                  store,
+                  entry->getHash(),
+                  rootPath + name,
+                  std::nullopt,
+                  fileBlobsToPrefetch,
+                  globResult,
+                  originRootId,
+                  std::move(evaluateChild)));
+            }
           }
         }
       };
@@ -298,8 +508,11 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateImpl(
           name = entry->first;
 
           if (node->isLeaf_) {
-            globResult.wlock()->emplace_back(
-                rootPath + name, entry->second.getDtype(), originRootId);
+            root.addResult(
+                globResult,
+                GlobResult{
+                    rootPath + name, entry->second.getDtype(), originRootId},
+                &entry->second);
 
             if (fileBlobsToPrefetch &&
                 root.entryShouldPrefetch(&entry->second)) {
@@ -317,8 +530,11 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateImpl(
           PathComponentPiece name = entry.first;
           if (node->alwaysMatch_ || node->matcher_.match(name.stringPiece())) {
             if (node->isLeaf_) {
-              globResult.wlock()->emplace_back(
-                  rootPath + name, entry.second.getDtype(), originRootId);
+              root.addResult(
+                  globResult,
+                  GlobResult{
+                      rootPath + name, entry.second.getDtype(), originRootId},
+                  &entry.second);
               if (fileBlobsToPrefetch &&
                   root.entryShouldPrefetch(&entry.second)) {
                 fileBlobsToPrefetch->wlock()->emplace_back(
@@ -377,6 +593,48 @@ ImmediateFuture<folly::Unit> GlobNode::evaluate(
     GlobNode::PrefetchList* fileBlobsToPrefetch,
     GlobNode::ResultList& globResult,
     const RootId& originRootId) const {
+  auto sink = std::make_unique<ResultListSink>(globResult);
+  auto& sinkRef = *sink;
+  return evaluate(
+             store,
+             context,
+             rootPath,
+             std::move(root),
+             fileBlobsToPrefetch,
+             sinkRef,
+             originRootId)
+      .ensure([sink = std::move(sink)] {});
+}
+
+ImmediateFuture<folly::Unit> GlobNode::evaluate(
+    const ObjectStore* store,
+    const ObjectFetchContextPtr& context,
+    RelativePathPiece rootPath,
+    std::shared_ptr<const Tree> tree,
+    GlobNode::PrefetchList* fileBlobsToPrefetch,
+    GlobNode::ResultList& globResult,
+    const RootId& originRootId) const {
+  auto sink = std::make_unique<ResultListSink>(globResult);
+  auto& sinkRef = *sink;
+  return evaluate(
+             store,
+             context,
+             rootPath,
+             std::move(tree),
+             fileBlobsToPrefetch,
+             sinkRef,
+             originRootId)
+      .ensure([sink = std::move(sink)] {});
+}
+
+ImmediateFuture<folly::Unit> GlobNode::evaluate(
+    const ObjectStore* store,
+    const ObjectFetchContextPtr& context,
+    RelativePathPiece rootPath,
+    TreeInodePtr root,
+    GlobNode::PrefetchList* fileBlobsToPrefetch,
+    GlobNode::ResultSink& globResult,
+    const RootId& originRootId) const {
   return evaluateImpl(
       store,
       context,
@@ -393,16 +651,32 @@ ImmediateFuture<folly::Unit> GlobNode::evaluate(
     RelativePathPiece rootPath,
     std::shared_ptr<const Tree> tree,
     GlobNode::PrefetchList* fileBlobsToPrefetch,
-    GlobNode::ResultList& globResult,
+    GlobNode::ResultSink& globResult,
     const RootId& originRootId) const {
-  return evaluateImpl(
+  auto treeId = tree->getHash();
+  return evaluateCached(
       store,
-      context,
+      treeId,
       rootPath,
-      TreeRoot(std::move(tree)),
+      std::nullopt,
       fileBlobsToPrefetch,
       globResult,
-      originRootId);
+      originRootId,
+      [this,
+       store,
+       context = context.copy(),
+       tree = std::move(tree),
+       fileBlobsToPrefetch,
+       &originRootId](RelativePathPiece evaluationRoot, ResultSink& sink) {
+        return evaluateImpl(
+            store,
+            context,
+            evaluationRoot,
+            TreeRoot(tree),
+            fileBlobsToPrefetch,
+            sink,
+            originRootId);
+      });
 }
 
 StringPiece GlobNode::tokenize(StringPiece& pattern, bool* hasSpecials) {
@@ -451,7 +725,7 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateRecursiveComponentImpl(
     RelativePathPiece startOfRecursive,
     ROOT&& root,
     GlobNode::PrefetchList* fileBlobsToPrefetch,
-    GlobNode::ResultList& globResult,
+    GlobNode::ResultSink& globResult,
     const RootId& originRootId) const {
   vector<RelativePath> subDirNames;
   vector<ImmediateFuture<folly::Unit>> futures;
@@ -460,16 +734,30 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateRecursiveComponentImpl(
     for (auto& entry : root.iterate(contents)) {
       auto candidateName = startOfRecursive + entry.first;
 
-      for (auto& node : recursiveChildren_) {
-        if (node->alwaysMatch_ ||
-            node->matcher_.match(candidateName.stringPiece())) {
-          globResult.wlock()->emplace_back(
-              rootPath + candidateName, entry.second.getDtype(), originRootId);
-          if (fileBlobsToPrefetch && root.entryShouldPrefetch(&entry.second)) {
-            fileBlobsToPrefetch->wlock()->emplace_back(entry.second.getHash());
-          }
-          // No sense running multiple matches for this same file.
-          break;
+      // No sense running multiple matches for this same file, the rules
+      // that only look at basenames are thus all checked at once first.
+      bool matched = !recursiveIndex_.empty() &&
+          recursiveIndex_.match(candidateName.view());
+      if (!matched) {
+        matched = std::any_of(
+            recursiveChildren_.begin(),
+            recursiveChildren_.end(),
+            [&](const auto& node) {
+              return !node->isIndexed_ &&
+                  (node->alwaysMatch_ ||
+                   node->matcher_.match(candidateName.view()));
+            });
+      }
+      if (matched) {
+        root.addResult(
+            globResult,
+            GlobResult{
+                rootPath + candidateName,
+                entry.second.getDtype(),
+                originRootId},
+            &entry.second);
+        if (fileBlobsToPrefetch && root.entryShouldPrefetch(&entry.second)) {
+          fileBlobsToPrefetch->wlock()->emplace_back(entry.second.getHash());
         }
       }
 
@@ -479,26 +767,48 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateRecursiveComponentImpl(
         if (root.entryShouldLoadChildTree(&entry.second)) {
           subDirNames.emplace_back(std::move(candidateName));
         } else {
-          futures.emplace_back(
-              store->getTree(entry.second.getHash(), context)
-                  .thenValue([candidateName = std::move(candidateName),
-                              rootPath = rootPath.copy(),
-                              store,
-                              context = context.copy(),
-                              this,
-                              fileBlobsToPrefetch,
-                              &globResult,
-                              &originRootId](std::shared_ptr<const Tree> tree) {
-                    return evaluateRecursiveComponentImpl(
-                        store,
-                        context,
-                        rootPath,
-                        candidateName,
-                        TreeRoot(std::move(tree)),
-                        fileBlobsToPrefetch,
-                        globResult,
-                        originRootId);
-                  }));
+          auto evaluateChild = [treeId = entry.second.getHash(),
+                                candidateName,
+                                store,
+                                context = context.copy(),
+                                this,
+                                fileBlobsToPrefetch,
+                                &originRootId](
+                                   RelativePathPiece evaluationRoot,
+                                   ResultSink& sink) {
+            return store->getTree(treeId, context)
+                .thenValue([candidateName,
+                            rootPath = evaluationRoot.copy(),
+                            store,
+                            context = context.copy(),
+                            this,
+                            fileBlobsToPrefetch,
+                            &sink,
+                            &originRootId](std::shared_ptr<const Tree> tree) {
+                  return evaluateRecursiveComponentImpl(
+                      store,
+                      context,
+                      rootPath,
+                      candidateName,
+                      TreeRoot(std::move(tree)),
+                      fileBlobsToPrefetch,
+                      sink,
+                      originRootId);
+                });
+          };
+          if constexpr (std::decay_t<ROOT>::kIsSourceControlTree) {
+            futures.emplace_back(evaluateChild(rootPath, globResult));
+          } else {
+            futures.emplace_back(evaluateCached(
+                store,
+                entry.second.getHash(),
+                rootPath,
+                RelativePathPiece{candidateName},
+                fileBlobsToPrefetch,
+                globResult,
+                originRootId,
+                std::move(evaluateChild)));
+          }
         }
       }
     }
@@ -6,9 +6,12 @@
  */
 
 #pragma once
+#include <folly/synchronization/CallOnce.h>
+#include <optional>
 #include <ostream>
 #include "eden/fs/inodes/InodePtrFwd.h"
 #include "eden/fs/model/Tree.h"
+#include "eden/fs/model/git/BasenameGlobIndex.h"
 #include "eden/fs/model/git/GlobMatcher.h"
 #include "eden/fs/store/ObjectStore.h"
 #include "eden/fs/utils/CaseSensitivity.h"
@@ -35,7 +38,9 @@ class GlobNode {
   // Two-parameter constructor is intended to create the root of a set of
   // globs that will be parsed into the overall glob tree.
   explicit GlobNode(bool includeDotfiles, CaseSensitivity caseSensitive)
-      : caseSensitive_(caseSensitive), includeDotfiles_(includeDotfiles) {}
+      : recursiveIndex_(globOptions(includeDotfiles, caseSensitive)),
+        caseSensitive_(caseSensitive),
+        includeDotfiles_(includeDotfiles) {}
 
   using PrefetchList = folly::Synchronized<std::vector<ObjectId>>;
 
@@ -86,9 +91,29 @@ class GlobNode {
 
   using ResultList = folly::Synchronized<std::vector<GlobResult>>;
 
+  /**
+   * Receives the results of evaluate() as soon as they are found, which lets
+   * callers process them without waiting for the whole evaluation. add() may
+   * be called concurrently from several threads.
+   */
+  class ResultSink {
+   public:
+    virtual ~ResultSink() = default;
+    virtual void add(GlobResult&& result) = 0;
+
+    /**
+     * Called instead of add() for the matches found in source control trees,
+     * along with the id of their object.
+     */
+    virtual void addTreeEntry(GlobResult&& result, const ObjectId& /*id*/) {
+      add(std::move(result));
+    }
+  };
+
   // Compile and add a new glob pattern to the tree.
   // Compilation splits the pattern into nodes, with one node for each
   // directory separator separated path component.
+  // All the patterns must be added before the tree is first evaluated.
   void parse(folly::StringPiece pattern);
 
   /**
@@ -124,6 +149,35 @@ class GlobNode {
       ResultList& globResult,
       const RootId& originRootId) const;
 
+  /**
+   * Evaluate the compiled glob against the provided TreeInode and path,
+   * passing the results to a sink whose lifetime must exceed the lifetime of
+   * the returned ImmediateFuture.
+   */
+  ImmediateFuture<folly::Unit> evaluate(
+      const ObjectStore* store,
+      const ObjectFetchContextPtr& context,
+      RelativePathPiece rootPath,
+      TreeInodePtr root,
+      PrefetchList* fileBlobsToPrefetch,
+      ResultSink& globResult,
+      const RootId& originRootId) const;
+
+  /**
+   * Evaluate the compiled glob against the provided Tree, passing the results
+   * to a sink.
+   *
+   * See the documention for the overload above.
+   */
+  ImmediateFuture<folly::Unit> evaluate(
+      const ObjectStore* store,
+      const ObjectFetchContextPtr& context,
+      RelativePathPiece rootPath,
+      std::shared_ptr<const Tree> tree,
+      PrefetchList* fileBlobsToPrefetch,
+      ResultSink& globResult,
+      const RootId& originRootId) const;
+
   /**
    * Print a human-readable description of this GlobNode to stderr.
    *
@@ -132,6 +186,10 @@ class GlobNode {
   void debugDump() const;
 
  private:
+  static GlobOptions globOptions(
+      bool includeDotfiles,
+      CaseSensitivity caseSensitive);
+
   // Returns the next glob node token.
   // This is the text from the start of pattern up to the first
   // slash, or the end of the string is there was no slash.
@@ -163,9 +221,32 @@ class GlobNode {
       RelativePathPiece startOfRecursive,
       ROOT&& root,
       PrefetchList* fileBlobsToPrefetch,
-      ResultList& globResult,
+      ResultSink& globResult,
       const RootId& originRootId) const;
 
+  /**
+   * Evaluate this node against the source control tree treeId, through the
+   * results remembered by the store's GlobResultCache when possible.
+   *
+   * evaluate is called with the path to evaluate against and a sink, and
+   * does the actual evaluation on a cache miss. startOfRecursive is set when
+   * the evaluation only covers the recursive children of this node.
+   */
+  template <typename EVALUATE>
+  ImmediateFuture<folly::Unit> evaluateCached(
+      const ObjectStore* store,
+      const ObjectId& treeId,
+      RelativePathPiece rootPath,
+      std::optional<RelativePathPiece> startOfRecursive,
+      PrefetchList* fileBlobsToPrefetch,
+      ResultSink& globResult,
+      const RootId& originRootId,
+      EVALUATE&& evaluate) const;
+
+  // Returns a hash of everything that the evaluation of this node depends
+  // on, besides the tree it is evaluated against.
+  const Hash20& getFingerprint() const;
+
   template <typename ROOT>
   ImmediateFuture<folly::Unit> evaluateImpl(
       const ObjectStore* store,
@@ -173,7 +254,7 @@ class GlobNode {
       RelativePathPiece rootPath,
       ROOT&& root,
       PrefetchList* fileBlobsToPrefetch,
-      ResultList& globResult,
+      ResultSink& globResult,
       const RootId& originRootId) const;
 
   void debugDump(int currentDepth) const;
@@ -186,6 +267,9 @@ class GlobNode {
   std::vector<std::unique_ptr<GlobNode>> children_;
   // List of ** child rules
   std::vector<std::unique_ptr<GlobNode>> recursiveChildren_;
+  // Matches the ** child rules that only look at basenames all at once,
+  // rather than running their matchers one after another.
+  BasenameGlobIndex recursiveIndex_;
 
   // The case sensitivity of this glob node.
   CaseSensitivity caseSensitive_;
@@ -204,6 +288,12 @@ class GlobNode {
   // - this node is "**" or "*"
   // - it was created with includeDotfiles=true.
   bool alwaysMatch_{false};
+  // true for ** child rules matched through their parent's recursiveIndex_.
+  bool isIndexed_{false};
+
+  // Computed on first use by getFingerprint().
+  mutable folly::once_flag fingerprintOnce_;
+  mutable Hash20 fingerprint_;
 };
 
 // Streaming operators for logging and printing
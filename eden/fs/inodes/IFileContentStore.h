@@ -8,6 +8,7 @@
 #pragma once
 
 #include <folly/Range.h>
+#include <exception>
 
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -26,6 +27,8 @@ class IOBuf;
 
 namespace facebook::eden {
 
+class ObjectId;
+
 /**
  * Interface to manage materalized file data.
  */
@@ -57,6 +60,29 @@ class IFileContentStore {
    */
   virtual void removeOverlayFile(InodeNumber inodeNumber) = 0;
 
+  /**
+   * Remove the overlay data associated with each of the passed InodeNumbers.
+   *
+   * Every inode is attempted even if some of them fail; the first error is
+   * rethrown once all of them have been processed. Implementations may
+   * override this to issue the removals as a batch.
+   */
+  virtual void removeOverlayFiles(folly::Range<const InodeNumber*> inodes) {
+    std::exception_ptr firstError;
+    for (auto inodeNumber : inodes) {
+      try {
+        removeOverlayFile(inodeNumber);
+      } catch (const std::exception&) {
+        if (!firstError) {
+          firstError = std::current_exception();
+        }
+      }
+    }
+    if (firstError) {
+      std::rethrow_exception(firstError);
+    }
+  }
+
   /**
    * Returns true if the overlay has data associated with the passed
    * InodeNumber.
@@ -96,6 +122,16 @@ class IFileContentStore {
   virtual folly::File createOverlayFile(
       InodeNumber inodeNumber,
       const folly::IOBuf& contents) = 0;
+
+  /**
+   * Like createOverlayFile(), for a FileInode materialized from the blob
+   * blobId. Files materialized from the same blob may share their data on
+   * disk.
+   */
+  virtual folly::File createOverlayFileForBlob(
+      InodeNumber inodeNumber,
+      const ObjectId& blobId,
+      const folly::IOBuf& contents) = 0;
 #endif
 };
 
@@ -267,7 +267,7 @@ void InodeBase::onPtrRefZero() const {
 }
 
 ParentInodeInfo InodeBase::getParentInfo() const {
-  using ParentContentsPtr = folly::Synchronized<TreeInodeState>::LockedPtr;
+  using ParentContentsPtr = SynchronizedTreeInodeState::LockedPtr;
 
   // Grab our parent's contents_ lock.
   //
@@ -338,12 +338,36 @@ InodeMetadata InodeBase::getMetadataLocked() const {
 }
 #endif
 
+#ifndef _WIN32
+namespace {
+constexpr time_t kAtimeUpdateIntervalSeconds = 24 * 60 * 60;
+
+/**
+ * Like the relatime mount option: atime is only updated when it isn't newer
+ * than mtime or ctime, or is more than a day old. This is enough for tools
+ * that compare atime and mtime, and spares reads from dirtying the
+ * InodeMetadataTable pages of every inode they touch.
+ */
+bool shouldUpdateAtime(const InodeTimestamps& timestamps, EdenTimestamp now) {
+  if (!(timestamps.mtime < timestamps.atime) ||
+      !(timestamps.ctime < timestamps.atime)) {
+    return true;
+  }
+  return now.toTimespec().tv_sec - timestamps.atime.toTimespec().tv_sec >=
+      kAtimeUpdateIntervalSeconds;
+}
+} // namespace
+#endif
+
 void InodeBase::updateAtime() {
 #ifndef _WIN32
-  // TODO: Is it worth implementing relatime-like logic?
   auto now = getNow();
   getMount()->getInodeMetadataTable()->modifyOrThrow(
-      getNodeId(), [&](auto& metadata) { metadata.timestamps.atime = now; });
+      getNodeId(), [&](auto& metadata) {
+        if (shouldUpdateAtime(metadata.timestamps, now)) {
+          metadata.timestamps.atime = now;
+        }
+      });
 #endif
 }
 
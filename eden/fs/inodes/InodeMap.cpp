@@ -125,7 +125,7 @@ InodeMap::~InodeMap() {
 }
 
 inline void InodeMap::insertLoadedInode(
-    const folly::Synchronized<Members>::LockedPtr& data,
+    const SynchronizedMembers::LockedPtr& data,
     InodeBase* inode) {
   auto ret = data->loadedInodes_.emplace(inode->getNodeId(), inode);
   XCHECK(ret.second);
@@ -137,7 +137,7 @@ inline void InodeMap::insertLoadedInode(
 }
 
 void InodeMap::initializeRoot(
-    const folly::Synchronized<Members>::LockedPtr& data,
+    const SynchronizedMembers::LockedPtr& data,
     TreeInodePtr root) {
   XCHECK_EQ(data->loadedInodes_.size(), 0ul)
       << "cannot load InodeMap data over a populated instance";
@@ -157,7 +157,7 @@ void InodeMap::initialize(TreeInodePtr root) {
 
 template <class... Args>
 void InodeMap::initializeUnloadedInode(
-    const folly::Synchronized<Members>::LockedPtr& data,
+    const SynchronizedMembers::LockedPtr& data,
     InodeNumber parentIno,
     InodeNumber ino,
     Args&&... args) {
@@ -266,13 +266,18 @@ void InodeMap::initializeFromOverlay(TreeInodePtr root, Overlay& overlay) {
 }
 
 ImmediateFuture<InodePtr> InodeMap::lookupInode(InodeNumber number) {
+  // Most lookups are for loaded inodes, which only need a shared lock.
+  if (auto inode = lookupLoadedInode(number)) {
+    return inode;
+  }
+
   // Lock the data.
   // We hold it while doing most of our work below, but explicitly unlock it
   // before triggering inode loading or before fulfilling any Promises.
   auto data = data_.wlock();
   std::vector<InodeTraceEvent> startLoadEvents;
 
-  // Check to see if this Inode is already loaded
+  // Check to see if this Inode was loaded since we released the shared lock
   auto loadedIter = data->loadedInodes_.find(number);
   if (loadedIter != data->loadedInodes_.end()) {
     return loadedIter->second.getPtr();
@@ -336,7 +341,7 @@ ImmediateFuture<InodePtr> InodeMap::lookupInode(InodeNumber number) {
       // Grab copies of the arguments we need for startChildLookup(),
       // with the lock still held.
       InodePtr firstLoadedParent = loadedIter->second.getPtr();
-      PathComponent requiredChildName = unloadedData->name;
+      PathComponent requiredChildName = unloadedData->name.copy();
       bool isUnlinked = unloadedData->isUnlinked;
       std::optional<ObjectId> optionalHash = unloadedData->hash;
       auto mode = unloadedData->mode;
@@ -529,7 +534,7 @@ void InodeMap::inodeLoadFailed(
 InodeTraceEvent InodeMap::createInodeLoadStartEvent(
     InodeNumber number,
     UnloadedInode& unloadedData,
-    const folly::Synchronized<Members>::LockedPtr& /* data */) {
+    const SynchronizedMembers::LockedPtr& /* data */) {
   unloadedData.loadStartTime = std::chrono::system_clock::now();
   return InodeTraceEvent(
       unloadedData.loadStartTime,
@@ -577,6 +582,18 @@ ImmediateFuture<TreeInodePtr> InodeMap::lookupTreeInode(InodeNumber number) {
       [](const InodePtr& inode) { return inode.asTreePtr(); });
 }
 
+#if FOLLY_HAS_COROUTINES
+folly::coro::Task<InodePtr> InodeMap::co_lookupInode(InodeNumber number) {
+  co_return co_await lookupInode(number);
+}
+
+folly::coro::Task<TreeInodePtr> InodeMap::co_lookupTreeInode(
+    InodeNumber number) {
+  auto inode = co_await lookupInode(number);
+  co_return inode.asTreePtr();
+}
+#endif
+
 ImmediateFuture<FileInodePtr> InodeMap::lookupFileInode(InodeNumber number) {
   return lookupInode(number).thenValue(
       [](const InodePtr& inode) { return inode.asFilePtr(); });
@@ -607,6 +624,27 @@ FileInodePtr InodeMap::lookupLoadedFile(InodeNumber number) {
   return inode.asFilePtr();
 }
 
+std::optional<std::pair<TreeInodePtr, PathComponent>>
+InodeMap::lookupUnloadedFileParent(InodeNumber number) {
+  auto data = data_.rlock();
+  auto unloadedIt = data->unloadedInodes_.find(number);
+  if (unloadedIt == data->unloadedInodes_.end()) {
+    return std::nullopt;
+  }
+  const auto& unloaded = unloadedIt->second;
+  if (unloaded.isUnlinked || !S_ISREG(unloaded.mode) ||
+      !unloaded.promises.empty()) {
+    return std::nullopt;
+  }
+  auto parentIt = data->loadedInodes_.find(unloaded.parent);
+  if (parentIt == data->loadedInodes_.end()) {
+    return std::nullopt;
+  }
+  return std::make_pair(
+      parentIt->second.getPtr().asTreePtr(),
+      PathComponent{unloaded.name.piece()});
+}
+
 std::optional<RelativePath> InodeMap::getPathForInode(InodeNumber inodeNumber) {
   auto data = data_.rlock();
   return getPathForInodeHelper(inodeNumber, data);
@@ -614,7 +652,7 @@ std::optional<RelativePath> InodeMap::getPathForInode(InodeNumber inodeNumber) {
 
 std::optional<RelativePath> InodeMap::getPathForInodeHelper(
     InodeNumber inodeNumber,
-    const folly::Synchronized<Members>::RLockedPtr& data) {
+    const SynchronizedMembers::RLockedPtr& data) {
   auto loadedIt = data->loadedInodes_.find(inodeNumber);
   if (loadedIt != data->loadedInodes_.cend()) {
     // If the inode is loaded, return its RelativePath
@@ -644,8 +682,10 @@ std::optional<RelativePath> InodeMap::getPathForInodeHelper(
   }
 }
 void InodeMap::decFsRefcount(InodeNumber number, uint32_t count) {
-  InodePtr inodePtr;
-  {
+  // The FS refcount of loaded inodes is tracked by the inode itself, so they
+  // only need a shared lock. Unloaded inodes are updated in the map.
+  InodePtr inodePtr = lookupLoadedInode(number);
+  if (!inodePtr) {
     auto data = data_.wlock();
     inodePtr = decFsRefcountHelper(data, number, count);
   }
@@ -657,7 +697,7 @@ void InodeMap::decFsRefcount(InodeNumber number, uint32_t count) {
 }
 
 InodePtr InodeMap::decFsRefcountHelper(
-    folly::Synchronized<Members>::LockedPtr& data,
+    SynchronizedMembers::LockedPtr& data,
     InodeNumber number,
     uint32_t count,
     bool clearRefCount) {
@@ -935,8 +975,7 @@ Future<SerializedInodeMap> InodeMap::shutdown(
   });
 }
 
-void InodeMap::shutdownComplete(
-    folly::Synchronized<Members>::LockedPtr&& data) {
+void InodeMap::shutdownComplete(SynchronizedMembers::LockedPtr&& data) {
   // We manually dropped our reference count to the root inode in
   // shutdown().  Destroy it now, remove it from the loadedInodes, and call
   // resetNoDecRef() on our pointer to make sure it doesn't try to decrement the
@@ -1055,7 +1094,7 @@ void InodeMap::unloadInode(
     TreeInode* parent,
     PathComponentPiece name,
     bool isUnlinked,
-    const folly::Synchronized<Members>::LockedPtr& data) {
+    const SynchronizedMembers::LockedPtr& data) {
   // Call updateOverlayForUnload() to update the overlay and compute
   // if we need to remember an UnloadedInode entry.
   auto unloadedEntry =
@@ -1084,7 +1123,7 @@ optional<InodeMap::UnloadedInode> InodeMap::updateOverlayForUnload(
     TreeInode* parent,
     PathComponentPiece name,
     bool isUnlinked,
-    const folly::Synchronized<Members>::LockedPtr& data) {
+    const SynchronizedMembers::LockedPtr& data) {
   auto fsCount = inode->getFsRefcount();
   if (isUnlinked && (data->isUnmounted_ || fsCount == 0)) {
     try {
@@ -1247,6 +1286,15 @@ InodeMap::InodeCounts InodeMap::getInodeCounts() const {
   return counts;
 }
 
+size_t InodeMap::estimateMemoryUsage() const {
+  auto data = data_.rlock();
+  // F14NodeMap counts its nodes, which hold the UnloadedInodes.
+  return data->numTreeInodes_ * sizeof(TreeInode) +
+      data->numFileInodes_ * sizeof(FileInode) +
+      data->loadedInodes_.getAllocatedMemorySize() +
+      data->unloadedInodes_.getAllocatedMemorySize();
+}
+
 std::vector<InodeNumber> InodeMap::getReferencedInodes() const {
   std::vector<InodeNumber> inodes;
   {
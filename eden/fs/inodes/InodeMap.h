@@ -7,12 +7,16 @@
 
 #pragma once
 
+#include <folly/SharedMutex.h>
 #include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
 #include <folly/futures/Future.h>
 #include <list>
 #include <memory>
 #include <optional>
-#include <unordered_map>
+#if FOLLY_HAS_COROUTINES
+#include <folly/experimental/coro/Task.h>
+#endif
 
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/InodeNumber.h"
@@ -20,6 +24,7 @@
 #include "eden/fs/inodes/Overlay.h"
 #include "eden/fs/model/ObjectId.h"
 #include "eden/fs/takeover/gen-cpp2/takeover_types.h"
+#include "eden/fs/telemetry/LockContention.h"
 #include "eden/fs/utils/ImmediateFuture.h"
 #include "eden/fs/utils/PathFuncs.h"
 
@@ -38,6 +43,8 @@ class ReloadableConfig;
 
 class InodeMapLock;
 
+inline constexpr char kInodeMapLockSite[] = "inode_map";
+
 /**
  * InodeMap allows looking up Inode objects based on a inode number.
  *
@@ -182,6 +189,18 @@ class InodeMap {
    */
   ImmediateFuture<TreeInodePtr> lookupTreeInode(InodeNumber number);
 
+#if FOLLY_HAS_COROUTINES
+  /**
+   * Coroutine versions of lookupInode() and lookupTreeInode(). Loaded inodes
+   * are returned without suspending.
+   *
+   * As with the other methods, the caller must keep the EdenMount alive until
+   * the returned Task completes.
+   */
+  folly::coro::Task<InodePtr> co_lookupInode(InodeNumber number);
+  folly::coro::Task<TreeInodePtr> co_lookupTreeInode(InodeNumber number);
+#endif
+
   /**
    * Lookup a FileInode object by inode number.
    *
@@ -215,6 +234,17 @@ class InodeMap {
    */
   FileInodePtr lookupLoadedFile(InodeNumber number);
 
+  /**
+   * If this inode number refers to a regular file that is remembered but not
+   * loaded, nor loading, and whose parent is loaded, returns the parent and
+   * the file's name. This lets callers read the file's DirEntry without
+   * loading it.
+   *
+   * Returns std::nullopt in all other cases, including for loaded inodes.
+   */
+  std::optional<std::pair<TreeInodePtr, PathComponent>>
+  lookupUnloadedFileParent(InodeNumber number);
+
   /**
    * Recursively determines the path for a loaded or unloaded inode. If the
    * inode is unloaded, it appends the name of the unloaded inode to the path
@@ -406,6 +436,13 @@ class InodeMap {
    */
   InodeCounts getInodeCounts() const;
 
+  /**
+   * Estimate the bytes used by the loaded inode objects and the tables of
+   * loaded and unloaded inodes, not counting the entries of the loaded
+   * directories.
+   */
+  size_t estimateMemoryUsage() const;
+
   void recordPeriodicInodeUnload(size_t numInodesToUnload);
   /*
    * Return all referenced inodes (loaded and unloaded inodes whose
@@ -455,7 +492,9 @@ class InodeMap {
         uint32_t fsRefcount);
 
     InodeNumber const parent;
-    PathComponent const name;
+    // Unloaded inodes mostly have a handful of distinct names, like
+    // BUCK or __init__.py, so share them.
+    InternedPathComponent const name;
 
     /**
      * A boolean indicating if this inode is unlinked.
@@ -553,13 +592,18 @@ class InodeMap {
      * itself does not hold a reference to the Inode objects.  When an Inode is
      * looked up the InodeMap will wrap the Inode in an InodePtr so that the
      * caller acquires a reference.
+     *
+     * Entries are stored inline, as there can be millions of loaded inodes.
      */
-    std::unordered_map<InodeNumber, LoadedInode> loadedInodes_;
+    folly::F14ValueMap<InodeNumber, LoadedInode> loadedInodes_;
 
     /**
      * The map of currently unloaded inodes
+     *
+     * UnloadedInode is large and lookupInode() holds pointers to several
+     * entries at once, so each entry is allocated separately.
      */
-    std::unordered_map<InodeNumber, UnloadedInode> unloadedInodes_;
+    folly::F14NodeMap<InodeNumber, UnloadedInode> unloadedInodes_;
 
     /**
      * Indicates if the FS mount point has been unmounted.
@@ -597,10 +641,14 @@ class InodeMap {
     std::optional<folly::Promise<folly::Unit>> shutdownPromise;
   };
 
+  using SynchronizedMembers = folly::Synchronized<
+      Members,
+      InstrumentedMutex<folly::SharedMutex, kInodeMapLockSite>>;
+
   InodeMap(InodeMap const&) = delete;
   InodeMap& operator=(InodeMap const&) = delete;
 
-  void shutdownComplete(folly::Synchronized<Members>::LockedPtr&& data);
+  void shutdownComplete(SynchronizedMembers::LockedPtr&& data);
 
   void setupParentLookupPromise(
       folly::Promise<InodePtr>& promise,
@@ -627,7 +675,7 @@ class InodeMap {
   InodeTraceEvent createInodeLoadStartEvent(
       InodeNumber number,
       UnloadedInode& unloadedData,
-      const folly::Synchronized<Members>::WLockedPtr& data);
+      const SynchronizedMembers::WLockedPtr& data);
 
   /**
    * Create and return an inode load failure event that will later be published
@@ -648,7 +696,7 @@ class InodeMap {
 
   std::optional<RelativePath> getPathForInodeHelper(
       InodeNumber inodeNumber,
-      const folly::Synchronized<Members>::RLockedPtr& data);
+      const SynchronizedMembers::RLockedPtr& data);
 
   /**
    * Unload an inode
@@ -664,7 +712,7 @@ class InodeMap {
       TreeInode* parent,
       PathComponentPiece name,
       bool isUnlinked,
-      const folly::Synchronized<Members>::LockedPtr& lock);
+      const SynchronizedMembers::LockedPtr& lock);
 
   /**
    * Update the overlay data for an inode before unloading it.
@@ -678,17 +726,17 @@ class InodeMap {
       TreeInode* parent,
       PathComponentPiece name,
       bool isUnlinked,
-      const folly::Synchronized<Members>::LockedPtr& lock);
+      const SynchronizedMembers::LockedPtr& lock);
 
   void insertLoadedInode(
-      const folly::Synchronized<Members>::LockedPtr& data,
+      const SynchronizedMembers::LockedPtr& data,
       InodeBase* inode);
 
   /**
    * Verify the InodeMap precondition and initialize the root_ member.
    */
   void initializeRoot(
-      const folly::Synchronized<Members>::LockedPtr& data,
+      const SynchronizedMembers::LockedPtr& data,
       TreeInodePtr root);
 
   /**
@@ -702,7 +750,7 @@ class InodeMap {
    */
   template <class... Args>
   void initializeUnloadedInode(
-      const folly::Synchronized<Members>::LockedPtr& data,
+      const SynchronizedMembers::LockedPtr& data,
       InodeNumber parentIno,
       InodeNumber ino,
       Args&&... args);
@@ -715,7 +763,7 @@ class InodeMap {
    * WARNING: The returned inodePtr must be destroyed OUTSIDE of the data lock!
    */
   InodePtr decFsRefcountHelper(
-      folly::Synchronized<Members>::LockedPtr& data,
+      SynchronizedMembers::LockedPtr& data,
       InodeNumber number,
       uint32_t count = 0,
       bool clearRefCount = false);
@@ -745,7 +793,7 @@ class InodeMap {
    * internal lock.  (This makes it safe for InodeBase to perform operations on
    * the InodeMap while holding their own lock.)
    */
-  folly::Synchronized<Members> data_;
+  SynchronizedMembers data_;
 
   /**
    * This boolean controls EdenFS's response to receiving a request for an
@@ -784,8 +832,7 @@ class InodeMap {
  */
 class InodeMapLock {
  public:
-  explicit InodeMapLock(
-      folly::Synchronized<InodeMap::Members>::LockedPtr&& data)
+  explicit InodeMapLock(InodeMap::SynchronizedMembers::LockedPtr&& data)
       : data_(std::move(data)) {}
 
   void unlock() {
@@ -794,6 +841,6 @@ class InodeMapLock {
 
  private:
   friend class InodeMap;
-  folly::Synchronized<InodeMap::Members>::LockedPtr data_;
+  InodeMap::SynchronizedMembers::LockedPtr data_;
 };
 } // namespace facebook::eden
@@ -90,12 +90,18 @@ class InodeTable {
 
   /**
    * Create or open an InodeTable at the specified path.
+   *
+   * Every record is read in when the table is opened to build the index, so
+   * the whole file is populated up front rather than faulted in page by page.
+   * See MappedDiskVector::open() for useHugePages.
    */
   template <typename... OldRecords>
-  static std::unique_ptr<InodeTable> open(folly::StringPiece path) {
+  static std::unique_ptr<InodeTable> open(
+      folly::StringPiece path,
+      bool useHugePages = false) {
     return std::unique_ptr<InodeTable>{
         new InodeTable{MappedDiskVector<Entry>::template open<
-            detail::InodeTableEntry<OldRecords>...>(path, true)}};
+            detail::InodeTableEntry<OldRecords>...>(path, true, useHugePages)}};
   }
 
   /**
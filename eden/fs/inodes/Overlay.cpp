@@ -10,13 +10,16 @@
 #include <boost/filesystem.hpp>
 #include <algorithm>
 
+#include <folly/Conv.h>
 #include <folly/Exception.h>
 #include <folly/File.h>
 #include <folly/FileUtil.h>
 #include <folly/Range.h>
+#include <folly/String.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
 #include <folly/logging/xlog.h>
+#include <folly/portability/Unistd.h>
 #include <folly/stop_watch.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
 #include "eden/fs/config/EdenConfig.h"
@@ -32,12 +35,32 @@
 #include "eden/fs/utils/Bug.h"
 #include "eden/fs/utils/PathFuncs.h"
 
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
 namespace facebook::eden {
 
 namespace {
 constexpr uint64_t ioCountMask = 0x7FFFFFFFFFFFFFFFull;
 constexpr uint64_t ioClosedMask = 1ull << 63;
 
+#ifndef _WIN32
+// Present when a background fsck found errors, which must be repaired before
+// the overlay is used again.
+constexpr folly::StringPiece kFsckRequiredFile{"fsck-required"};
+
+// The number of inode number ranges reserved by background fscks so far.
+constexpr folly::StringPiece kLazyFsckGenerationFile{"lazy-fsck-generation"};
+
+// Each background fsck numbers the inodes created while it runs from its own
+// range of 2^48 inode numbers, above all the inode numbers used before. Inode
+// numbers must fit in an int64_t in thrift structures.
+constexpr uint64_t kLazyFsckRangeBits = 48;
+constexpr uint64_t kMaxLazyFsckGeneration =
+    (uint64_t{1} << (63 - kLazyFsckRangeBits)) - 1;
+#endif
+
 std::unique_ptr<InodeCatalog> makeInodeCatalog(
     AbsolutePathPiece localDir,
     Overlay::InodeCatalogType inodeCatalogType,
@@ -83,12 +106,43 @@ std::unique_ptr<InodeCatalog> makeInodeCatalog(
 }
 
 std::unique_ptr<IFileContentStore> makeFileContentStore(
-    AbsolutePathPiece localDir) {
+    AbsolutePathPiece localDir,
+    const EdenConfig& config) {
 #ifdef _WIN32
   (void)localDir;
+  (void)config;
   return nullptr;
 #else
-  return std::make_unique<FileContentStore>(localDir);
+  return std::make_unique<FileContentStore>(
+      localDir, config.overlayGCUseIoUring.getValue());
+#endif
+}
+
+/**
+ * How many overlay files the GC thread collects before removing them as a
+ * batch.
+ */
+constexpr size_t kGCRemoveBatchSize = 256;
+
+/**
+ * Lowers the I/O priority of the calling thread to the lowest of the
+ * best-effort class. The idle class would starve the GC thread while the
+ * disk is busy, leaving forgotten data around for as long.
+ */
+void lowerThreadIOPriority() {
+#ifdef __linux__
+  constexpr int kIoprioWhoProcess = 1;
+  constexpr int kIoprioClassBE = 2;
+  constexpr int kIoprioClassShift = 13;
+  constexpr int kLowestBEPriority = 7;
+  if (syscall(
+          SYS_ioprio_set,
+          kIoprioWhoProcess,
+          0,
+          (kIoprioClassBE << kIoprioClassShift) | kLowestBEPriority) != 0) {
+    XLOG(DBG3) << "failed to lower the I/O priority of the overlay GC thread: "
+               << folly::errnoStr(errno);
+  }
 #endif
 }
 } // namespace
@@ -122,7 +176,7 @@ Overlay::Overlay(
     InodeCatalogType inodeCatalogType,
     std::shared_ptr<StructuredLogger> logger,
     const EdenConfig& config)
-    : fileContentStore_{makeFileContentStore(localDir)},
+    : fileContentStore_{makeFileContentStore(localDir, config)},
       inodeCatalog_{makeInodeCatalog(
           localDir,
           inodeCatalogType,
@@ -131,6 +185,8 @@ Overlay::Overlay(
       inodeCatalogType_{inodeCatalogType},
       supportsSemanticOperations_{inodeCatalog_->supportsSemanticOperations()},
       localDir_{localDir},
+      gcThreads_{std::max(config.overlayGCThreads.getValue(), uint32_t{1})},
+      gcLowIOPriority_{config.overlayGCLowIOPriority.getValue()},
       caseSensitive_{caseSensitive},
       structuredLogger_{logger} {}
 
@@ -146,6 +202,10 @@ void Overlay::close() {
   if (gcThread_.joinable()) {
     gcThread_.join();
   }
+  // gcThread_ starts fsckThread_, which is thus safe to access now.
+  if (fsckThread_.joinable()) {
+    fsckThread_.join();
+  }
 
   // Make sure everything is shut down in reverse of construction order.
   // Cleanup is not necessary if tree overlay was not initialized and either
@@ -162,8 +222,13 @@ void Overlay::close() {
   // nextInodeNumber_.
   std::optional<InodeNumber> optNextInodeNumber;
   auto nextInodeNumber = nextInodeNumber_.load(std::memory_order_relaxed);
-  if (nextInodeNumber) {
-    optNextInodeNumber = InodeNumber{nextInodeNumber};
+  // Not saving the next inode number marks the overlay as not cleanly closed,
+  // so that the errors found by a background fsck are repaired when it is
+  // opened again.
+  if (nextInodeNumber && !lazyFsckFoundErrors_.load()) {
+    // The rest of the threads' blocks was never allocated, and doesn't need
+    // to be skipped after a restart.
+    optNextInodeNumber = InodeNumber{getMaxInodeNumber().get() + 1};
   }
 
   closeAndWaitForOutstandingIO();
@@ -208,6 +273,9 @@ folly::SemiFuture<Unit> Overlay::initialize(
                            progressCallback = std::move(progressCallback),
                            lookupCallback = lookupCallback,
                            promise = std::move(initPromise)]() mutable {
+    FOLLY_MAYBE_UNUSED auto fsckThreads = config->fsckScanThreads.getValue();
+    FOLLY_MAYBE_UNUSED auto fsckLogFrequency =
+        config->fsckLogFrequency.getValue();
     try {
       initOverlay(
           std::move(config),
@@ -221,6 +289,18 @@ folly::SemiFuture<Unit> Overlay::initialize(
       promise.setException(std::move(ew));
       return;
     }
+#ifndef _WIN32
+    if (lazyFsckPending_) {
+      fsckThread_ = std::thread(
+          [this,
+           fsckThreads,
+           fsckLogFrequency,
+           lookupCallback = lookupCallback]() mutable {
+            lazyFsck(
+                fsckThreads, fsckLogFrequency, std::move(lookupCallback));
+          });
+    }
+#endif // !_WIN32
     promise.setValue();
 
     gcThread();
@@ -234,6 +314,8 @@ void Overlay::initOverlay(
     FOLLY_MAYBE_UNUSED const OverlayChecker::ProgressCallback& progressCallback,
     FOLLY_MAYBE_UNUSED OverlayChecker::LookupCallback& lookupCallback) {
   IORequest req{this};
+  FOLLY_MAYBE_UNUSED auto inodeTableHugePages =
+      config->inodeTableHugePages.getValue();
   auto optNextInodeNumber = inodeCatalog_->initOverlay(true);
   if (fileContentStore_ && inodeCatalogType_ != InodeCatalogType::Legacy) {
     fileContentStore_->initialize(true);
@@ -246,38 +328,35 @@ void Overlay::initOverlay(
     // data in some of the on-disk state.
     //
     // Use OverlayChecker to scan the overlay for any issues, and also compute
-    // correct next inode number as it does so.
-    XLOG(WARN) << "Overlay " << localDir_
-               << " was not shut down cleanly.  Performing fsck scan.";
+    // correct next inode number as it does so. With fsck:lazy-fsck, the scan
+    // runs once the overlay is in use, unless a previous one found errors.
+    auto fsckRequiredPath = localDir_ + PathComponentPiece{kFsckRequiredFile};
+    bool fsckRequired = access(fsckRequiredPath.c_str(), F_OK) == 0;
+    std::optional<InodeNumber> lazyFsckInodeNumber;
+    if (config->lazyFsck.getValue() && !fsckRequired) {
+      lazyFsckInodeNumber = reserveLazyFsckInodeNumbers();
+    }
 
-    // TODO(zeyi): `OverlayCheck` should be associated with the specific
-    // Overlay implementation. `static_cast` is a temporary workaround.
-    //
-    // Note: lookupCallback is a reference but is stored on OverlayChecker.
-    // Therefore OverlayChecker must not exist longer than this initOverlay
-    // call.
-    OverlayChecker checker(
-        static_cast<FsInodeCatalog*>(inodeCatalog_.get()),
-        static_cast<FileContentStore*>(fileContentStore_.get()),
-        std::nullopt,
-        lookupCallback);
-    folly::stop_watch<> fsckRuntime;
-    checker.scanForErrors(progressCallback);
-    auto result = checker.repairErrors();
-    auto fsckRuntimeInSeconds =
-        std::chrono::duration<double>{fsckRuntime.elapsed()}.count();
-    if (result) {
-      // If totalErrors - fixedErrors is nonzero, then we failed to
-      // fix all of the problems.
-      auto success = !(result->totalErrors - result->fixedErrors);
-      structuredLogger_->logEvent(
-          Fsck{fsckRuntimeInSeconds, success, true /*attempted_repair*/});
+    if (lazyFsckInodeNumber.has_value()) {
+      XLOG(WARN) << "Overlay " << localDir_
+                 << " was not shut down cleanly.  Performing fsck scan in the "
+                 << "background, new inodes are numbered from "
+                 << *lazyFsckInodeNumber;
+      optNextInodeNumber = lazyFsckInodeNumber;
+      lazyFsckPending_ = true;
     } else {
-      structuredLogger_->logEvent(Fsck{
-          fsckRuntimeInSeconds, true /*success*/, false /*attempted_repair*/});
+      XLOG(WARN) << "Overlay " << localDir_
+                 << " was not shut down cleanly.  Performing fsck scan.";
+      optNextInodeNumber = fsck(
+          config->fsckScanThreads.getValue(),
+          config->fsckLogFrequency.getValue(),
+          progressCallback,
+          lookupCallback);
+      if (fsckRequired && unlink(fsckRequiredPath.c_str()) != 0 &&
+          errno != ENOENT) {
+        folly::throwSystemError("Failed to remove ", fsckRequiredPath);
+      }
     }
-
-    optNextInodeNumber = checker.getNextInodeNumber();
 #else
     // SqliteInodeCatalog will always return the value of next Inode number, if
     // we end up here - it's a bug.
@@ -300,33 +379,177 @@ void Overlay::initOverlay(
   }
 
   nextInodeNumber_.store(optNextInodeNumber->get(), std::memory_order_relaxed);
+  maxRetiredInodeNumber_.store(
+      optNextInodeNumber->get() - 1, std::memory_order_relaxed);
 
 #ifndef _WIN32
   // Open after infoFile_'s lock is acquired because the InodeTable acquires
   // its own lock, which should be released prior to infoFile_.
   inodeMetadataTable_ = InodeMetadataTable::open(
       (localDir_ + PathComponentPiece{FileContentStore::kMetadataFile})
-          .c_str());
+          .c_str(),
+      inodeTableHugePages);
 #endif // !_WIN32
 }
 
+#ifndef _WIN32
+InodeNumber Overlay::fsck(
+    uint32_t numThreads,
+    uint64_t logFrequency,
+    const OverlayChecker::ProgressCallback& progressCallback,
+    OverlayChecker::LookupCallback& lookupCallback) {
+  // TODO(zeyi): `OverlayCheck` should be associated with the specific
+  // Overlay implementation. `static_cast` is a temporary workaround.
+  //
+  // Note: lookupCallback is a reference but is stored on OverlayChecker.
+  // Therefore OverlayChecker must not exist longer than this call.
+  OverlayChecker checker(
+      static_cast<FsInodeCatalog*>(inodeCatalog_.get()),
+      static_cast<FileContentStore*>(fileContentStore_.get()),
+      std::nullopt,
+      lookupCallback,
+      numThreads,
+      logFrequency);
+  folly::stop_watch<> fsckRuntime;
+  checker.scanForErrors(progressCallback);
+  auto result = checker.repairErrors();
+  auto fsckRuntimeInSeconds =
+      std::chrono::duration<double>{fsckRuntime.elapsed()}.count();
+  if (result) {
+    // If totalErrors - fixedErrors is nonzero, then we failed to
+    // fix all of the problems.
+    auto success = !(result->totalErrors - result->fixedErrors);
+    structuredLogger_->logEvent(
+        Fsck{fsckRuntimeInSeconds, success, true /*attempted_repair*/});
+  } else {
+    structuredLogger_->logEvent(Fsck{
+        fsckRuntimeInSeconds, true /*success*/, false /*attempted_repair*/});
+  }
+
+  return checker.getNextInodeNumber();
+}
+
+std::optional<InodeNumber> Overlay::reserveLazyFsckInodeNumbers() {
+  auto path = localDir_ + PathComponentPiece{kLazyFsckGenerationFile};
+  uint64_t generation = 0;
+  std::string contents;
+  if (folly::readFile(path.c_str(), contents)) {
+    auto parsed = folly::tryTo<uint64_t>(contents);
+    if (parsed.hasError()) {
+      XLOG(WARN) << "Invalid " << path << ": " << contents;
+      return std::nullopt;
+    }
+    generation = parsed.value();
+  } else if (errno != ENOENT) {
+    XLOG(WARN) << "Failed to read " << path << ": "
+               << folly::errnoStr(errno);
+    return std::nullopt;
+  }
+
+  ++generation;
+  if (generation > kMaxLazyFsckGeneration) {
+    return std::nullopt;
+  }
+
+  // The reservation must be durable before any inode is numbered from it.
+  try {
+    folly::writeFileAtomic(
+        path.stringPiece(),
+        folly::to<std::string>(generation),
+        0644,
+        folly::SyncType::WITH_SYNC);
+  } catch (const std::exception& ex) {
+    XLOG(WARN) << "Failed to write " << path << ": " << ex.what();
+    return std::nullopt;
+  }
+  return InodeNumber{generation << kLazyFsckRangeBits};
+}
+
+void Overlay::lazyFsck(
+    uint32_t numThreads,
+    uint64_t logFrequency,
+    OverlayChecker::LookupCallback lookupCallback) noexcept {
+  try {
+    OverlayChecker checker(
+        static_cast<FsInodeCatalog*>(inodeCatalog_.get()),
+        static_cast<FileContentStore*>(fileContentStore_.get()),
+        std::nullopt,
+        lookupCallback,
+        numThreads,
+        logFrequency);
+    folly::stop_watch<> fsckRuntime;
+    checker.scanForErrors();
+    auto fsckRuntimeInSeconds =
+        std::chrono::duration<double>{fsckRuntime.elapsed()}.count();
+
+    const auto& errors = checker.getErrors();
+    if (errors.empty()) {
+      XLOG(INFO) << "Background fsck scan of overlay " << localDir_
+                 << " found no errors";
+      structuredLogger_->logEvent(Fsck{
+          fsckRuntimeInSeconds, true /*success*/, false /*attempted_repair*/});
+      return;
+    }
+
+    checker.logErrors();
+    XLOG(WARN) << "Background fsck scan of overlay " << localDir_ << " found "
+               << errors.size()
+               << " errors, they will be repaired the next time it is opened";
+    lazyFsckFoundErrors_.store(true);
+    structuredLogger_->logEvent(Fsck{
+        fsckRuntimeInSeconds, false /*success*/, false /*attempted_repair*/});
+    folly::writeFileAtomic(
+        (localDir_ + PathComponentPiece{kFsckRequiredFile}).stringPiece(),
+        "",
+        0644,
+        folly::SyncType::WITH_SYNC);
+  } catch (const std::exception& ex) {
+    // Without the marker, the next startup will scan the overlay again, in
+    // the background.
+    XLOG(ERR) << "Background fsck scan of overlay " << localDir_
+              << " failed: " << ex.what();
+    lazyFsckFoundErrors_.store(true);
+  }
+}
+#endif // !_WIN32
+
 InodeNumber Overlay::allocateInodeNumber() {
+  return inodeNumberBlocks_->allocate();
+}
+
+InodeNumber Overlay::InodeNumberBlock::allocate() {
   // InodeNumber should generally be 64-bits wide, in which case it isn't even
   // worth bothering to handle the case where nextInodeNumber_ wraps.  We don't
   // need to bother checking for conflicts with existing inode numbers since
   // this can only happen if we wrap around.  We don't currently support
   // platforms with 32-bit inode numbers.
   static_assert(
-      sizeof(nextInodeNumber_) == sizeof(InodeNumber),
+      sizeof(overlay_.nextInodeNumber_) == sizeof(InodeNumber),
       "expected nextInodeNumber_ and InodeNumber to have the same size");
   static_assert(
       sizeof(InodeNumber) >= 8, "expected InodeNumber to be at least 64 bits");
 
-  // This could be a relaxed atomic operation.  It doesn't matter on x86 but
-  // might on ARM.
-  auto previous = nextInodeNumber_++;
-  XDCHECK_NE(0u, previous) << "allocateInodeNumber called before initialize";
-  return InodeNumber{previous};
+  auto next = next_.load(std::memory_order_relaxed);
+  if (next == end_) {
+    next = overlay_.nextInodeNumber_.fetch_add(
+        kInodeNumberBlockSize, std::memory_order_relaxed);
+    XDCHECK_NE(0u, next) << "allocateInodeNumber called before initialize";
+    end_ = next + kInodeNumberBlockSize;
+  }
+  next_.store(next + 1, std::memory_order_relaxed);
+  return InodeNumber{next};
+}
+
+Overlay::InodeNumberBlock::~InodeNumberBlock() {
+  overlay_.updateMaxRetiredInodeNumber(getMaxAllocated());
+}
+
+void Overlay::updateMaxRetiredInodeNumber(uint64_t inodeNumber) {
+  auto max = maxRetiredInodeNumber_.load(std::memory_order_relaxed);
+  while (max < inodeNumber &&
+         !maxRetiredInodeNumber_.compare_exchange_weak(
+             max, inodeNumber, std::memory_order_relaxed)) {
+  }
 }
 
 DirContents Overlay::loadOverlayDir(InodeNumber inodeNumber) {
@@ -337,6 +560,7 @@ DirContents Overlay::loadOverlayDir(InodeNumber inodeNumber) {
     return result;
   }
   const auto& dir = dirData.value();
+  result.reserve(dir.entries_ref()->size());
 
   bool shouldMigrateToNewFormat = false;
 
@@ -460,6 +684,7 @@ void Overlay::recursivelyRemoveOverlayDir(InodeNumber inodeNumber) {
   // remove this data.
   auto dirData = inodeCatalog_->loadAndRemoveOverlayDir(inodeNumber);
   if (dirData) {
+    gcBacklog_.fetch_add(1, std::memory_order_relaxed);
     gcQueue_.lock()->queue.emplace_back(std::move(*dirData));
     gcCondVar_.notify_one();
   }
@@ -530,12 +755,29 @@ OverlayFile Overlay::createOverlayFile(
       weak_from_this());
 }
 
+OverlayFile Overlay::createOverlayFileForBlob(
+    InodeNumber inodeNumber,
+    const ObjectId& blobId,
+    const folly::IOBuf& contents) {
+  IORequest req{this};
+  XCHECK_LT(inodeNumber.get(), nextInodeNumber_.load(std::memory_order_relaxed))
+      << "createOverlayFileForBlob called with unallocated inode number";
+  XCHECK(fileContentStore_);
+  return OverlayFile(
+      fileContentStore_->createOverlayFileForBlob(
+          inodeNumber, blobId, contents),
+      weak_from_this());
+}
+
 #endif // !_WIN32
 
 InodeNumber Overlay::getMaxInodeNumber() {
-  auto ino = nextInodeNumber_.load(std::memory_order_relaxed);
-  XCHECK_GT(ino, 1u);
-  return InodeNumber{ino - 1};
+  XCHECK_GT(nextInodeNumber_.load(std::memory_order_relaxed), 1u);
+  auto ino = maxRetiredInodeNumber_.load(std::memory_order_relaxed);
+  for (const auto& block : inodeNumberBlocks_.accessAllThreads()) {
+    ino = std::max(ino, block.getMaxAllocated());
+  }
+  return InodeNumber{ino};
 }
 
 bool Overlay::tryIncOutstandingIORequests() {
@@ -585,6 +827,10 @@ void Overlay::closeAndWaitForOutstandingIO() {
 }
 
 void Overlay::gcThread() noexcept {
+  if (gcLowIOPriority_) {
+    lowerThreadIOPriority();
+  }
+
   for (;;) {
     std::vector<GCRequest> requests;
     {
@@ -600,7 +846,16 @@ void Overlay::gcThread() noexcept {
       requests = std::move(lock->queue);
     }
 
+    // Forgotten directories are collected together, but before the requests
+    // queued after them, so that flushes wait for them.
+    std::vector<overlay::OverlayDir> dirs;
     for (auto& request : requests) {
+      if (auto* dir = std::get_if<overlay::OverlayDir>(&request.requestType)) {
+        dirs.push_back(std::move(*dir));
+        continue;
+      }
+      collectForgottenDirs(std::move(dirs));
+      dirs.clear();
       try {
         handleGCRequest(request);
       } catch (const std::exception& e) {
@@ -608,6 +863,7 @@ void Overlay::gcThread() noexcept {
                   << e.what();
       }
     }
+    collectForgottenDirs(std::move(dirs));
   }
 }
 
@@ -625,23 +881,48 @@ void Overlay::handleGCRequest(GCRequest& request) {
     flush->setValue();
     return;
   }
+}
 
-  // Should only include inode numbers for trees.
-  std::queue<InodeNumber> queue;
-
-  // TODO: For better throughput on large tree collections, it might make
-  // sense to split this into two threads: one for traversing the tree and
-  // another that makes the actual unlink calls.
-  auto safeRemoveOverlayFile = [&](InodeNumber inodeNumber) {
-    try {
-      removeOverlayFile(inodeNumber);
-    } catch (const std::exception& e) {
-      XLOG(ERR) << "Failed to remove overlay data for file inode "
-                << inodeNumber << ": " << e.what();
+void Overlay::removeForgottenFiles(std::vector<InodeNumber>& inodes) noexcept {
+  if (inodes.empty()) {
+    return;
+  }
+  try {
+    for (auto ino : inodes) {
+      freeInodeFromMetadataTable(ino);
     }
-  };
+#ifndef _WIN32
+    fileContentStore_->removeOverlayFiles(inodes);
+#endif
+  } catch (const std::exception& e) {
+    XLOG(ERR) << "Failed to remove overlay data for some of " << inodes.size()
+              << " file inodes: " << e.what();
+  }
+  inodes.clear();
+}
+
+void Overlay::collectForgottenDirs(
+    std::vector<overlay::OverlayDir> dirs) noexcept {
+  if (dirs.empty()) {
+    return;
+  }
+
+  std::optional<IORequest> req;
+  try {
+    req.emplace(this);
+  } catch (const std::exception& e) {
+    XLOG(ERR) << "Failed to collect " << dirs.size()
+              << " forgotten directories: " << e.what();
+    gcBacklog_.fetch_sub(dirs.size(), std::memory_order_relaxed);
+    return;
+  }
 
-  auto processDir = [&](const overlay::OverlayDir& dir) {
+  // Appends the tree children of dir to subdirs, and its file children to
+  // files, which are removed in batches so that a store backed by io_uring
+  // can unlink a whole batch with a single system call.
+  auto processDir = [&](const overlay::OverlayDir& dir,
+                        std::vector<InodeNumber>& subdirs,
+                        std::vector<InodeNumber>& files) {
     for (const auto& entry : *dir.entries_ref()) {
       const auto& value = entry.second;
       if (!(*value.inodeNumber_ref())) {
@@ -652,40 +933,106 @@ void Overlay::handleGCRequest(GCRequest& request) {
       auto ino = InodeNumber::fromThrift(*value.inodeNumber_ref());
 
       if (S_ISDIR(*value.mode_ref())) {
-        queue.push(ino);
+        subdirs.push_back(ino);
       } else {
         // No need to recurse, but delete any file at this inode.  Note that,
         // under normal operation, there should be nothing at this path
         // because files are only written into the overlay if they're
         // materialized.
-        safeRemoveOverlayFile(ino);
+        files.push_back(ino);
+        if (files.size() >= kGCRemoveBatchSize) {
+          removeForgottenFiles(files);
+        }
       }
     }
   };
 
-  processDir(std::get<overlay::OverlayDir>(request.requestType));
+  // The subdirectories left to collect, and how many threads are collecting
+  // one, and may thus find more.
+  struct Work {
+    std::vector<InodeNumber> subdirs;
+    size_t busyThreads{0};
+  };
+  folly::Synchronized<Work, std::mutex> work;
+  std::condition_variable workCondVar;
+
+  std::vector<InodeNumber> files;
+  {
+    std::vector<InodeNumber> subdirs;
+    for (const auto& dir : dirs) {
+      processDir(dir, subdirs, files);
+    }
+    gcBacklog_.fetch_add(subdirs.size(), std::memory_order_relaxed);
+    gcBacklog_.fetch_sub(dirs.size(), std::memory_order_relaxed);
+    work.lock()->subdirs = std::move(subdirs);
+  }
 
-  while (!queue.empty()) {
-    auto ino = queue.front();
-    queue.pop();
+  auto collectSubdirs = [&](std::vector<InodeNumber>& files) {
+    std::vector<InodeNumber> found;
+    auto lock = work.lock();
+    for (;;) {
+      while (lock->subdirs.empty() && lock->busyThreads != 0) {
+        workCondVar.wait(lock.as_lock());
+      }
+      if (lock->subdirs.empty()) {
+        break;
+      }
+      auto ino = lock->subdirs.back();
+      lock->subdirs.pop_back();
+      ++lock->busyThreads;
+      lock.unlock();
 
-    overlay::OverlayDir dir;
-    try {
-      freeInodeFromMetadataTable(ino);
-      auto dirData = inodeCatalog_->loadAndRemoveOverlayDir(ino);
-      if (!dirData.has_value()) {
-        XLOG(DBG7) << "no dir data for inode " << ino;
-        continue;
-      } else {
-        dir = std::move(*dirData);
+      try {
+        freeInodeFromMetadataTable(ino);
+        auto dirData = inodeCatalog_->loadAndRemoveOverlayDir(ino);
+        if (dirData.has_value()) {
+          processDir(*dirData, found, files);
+        } else {
+          XLOG(DBG7) << "no dir data for inode " << ino;
+        }
+      } catch (const std::exception& e) {
+        XLOG(ERR) << "While collecting, failed to load tree data for inode "
+                  << ino << ": " << e.what();
       }
-    } catch (const std::exception& e) {
-      XLOG(ERR) << "While collecting, failed to load tree data for inode "
-                << ino << ": " << e.what();
-      continue;
+      gcBacklog_.fetch_add(found.size(), std::memory_order_relaxed);
+      gcBacklog_.fetch_sub(1, std::memory_order_relaxed);
+
+      lock = work.lock();
+      --lock->busyThreads;
+      lock->subdirs.insert(lock->subdirs.end(), found.begin(), found.end());
+      if (!found.empty() ||
+          (lock->subdirs.empty() && lock->busyThreads == 0)) {
+        workCondVar.notify_all();
+      }
+      found.clear();
     }
+  };
 
-    processDir(dir);
+  // Helper threads only pay off for large trees, whose first levels usually
+  // have several subdirectories.
+  std::vector<std::thread> helpers;
+  auto numHelpers =
+      std::min<size_t>(gcThreads_ - 1, work.lock()->subdirs.size());
+  for (size_t i = 0; i < numHelpers; ++i) {
+    try {
+      helpers.emplace_back([&] {
+        if (gcLowIOPriority_) {
+          lowerThreadIOPriority();
+        }
+        std::vector<InodeNumber> helperFiles;
+        collectSubdirs(helperFiles);
+        removeForgottenFiles(helperFiles);
+      });
+    } catch (const std::exception& e) {
+      XLOG(WARN) << "Failed to start an overlay GC helper thread: "
+                 << e.what();
+      break;
+    }
+  }
+  collectSubdirs(files);
+  removeForgottenFiles(files);
+  for (auto& helper : helpers) {
+    helper.join();
   }
 }
 
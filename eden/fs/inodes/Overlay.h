@@ -8,6 +8,7 @@
 #pragma once
 #include <folly/File.h>
 #include <folly/Range.h>
+#include <folly/ThreadLocal.h>
 #include <folly/futures/Future.h>
 #include <folly/futures/Promise.h>
 #include <folly/synchronization/Baton.h>
@@ -42,6 +43,7 @@ class InodeCatalog;
 class IFileContentStore;
 class DirEntry;
 class EdenConfig;
+class ObjectId;
 
 #ifndef _WIN32
 struct InodeMetadata;
@@ -171,8 +173,9 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
    *   inodeCreated() should be called immediately afterwards to register the
    *   new child Inode object.
    *
-   * TODO: It would be easy to extend this function to allocate a range of
-   * inode values in one atomic operation.
+   * Each thread allocates from its own block of kInodeNumberBlockSize inode
+   * numbers, so inode numbers allocated by different threads are not in
+   * allocation order.
    */
   InodeNumber allocateInodeNumber();
 #ifndef _WIN32
@@ -213,6 +216,14 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
    */
   folly::Future<folly::Unit> flushPendingAsync();
 
+  /**
+   * The number of forgotten directories the GC thread has yet to collect,
+   * counting the subdirectories found so far.
+   */
+  size_t getGCBacklog() const {
+    return gcBacklog_.load(std::memory_order_relaxed);
+  }
+
   bool hasOverlayDir(InodeNumber inodeNumber);
 
 #ifndef _WIN32
@@ -244,6 +255,16 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
       InodeNumber inodeNumber,
       const folly::IOBuf& contents);
 
+  /**
+   * Like createOverlayFile(), for a FileInode materialized from the blob
+   * blobId, letting it share its data with the other files materialized from
+   * that blob.
+   */
+  OverlayFile createOverlayFileForBlob(
+      InodeNumber inodeNumber,
+      const ObjectId& blobId,
+      const folly::IOBuf& contents);
+
   /**
    * call statfs(2) on the filesystem in which the overlay is located
    */
@@ -337,6 +358,47 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
   void gcThread() noexcept;
   void handleGCRequest(GCRequest& request);
 
+  /**
+   * Recursively removes the data of the children of the given forgotten
+   * directories, spreading their subdirectories across up to gcThreads_
+   * threads.
+   */
+  void collectForgottenDirs(std::vector<overlay::OverlayDir> dirs) noexcept;
+
+  /**
+   * Removes the data of the given file inodes, and clears the vector.
+   */
+  void removeForgottenFiles(std::vector<InodeNumber>& inodes) noexcept;
+
+#ifndef _WIN32
+  /**
+   * Scans the overlay with OverlayChecker, repairs the errors it finds and
+   * returns the next inode number.
+   */
+  InodeNumber fsck(
+      uint32_t numThreads,
+      uint64_t logFrequency,
+      const OverlayChecker::ProgressCallback& progressCallback,
+      OverlayChecker::LookupCallback& lookupCallback);
+
+  /**
+   * Reserves a range of inode numbers that no inode of this overlay can use
+   * yet, for the inodes created while the overlay is checked in the
+   * background. Returns std::nullopt if no range can be reserved.
+   */
+  std::optional<InodeNumber> reserveLazyFsckInodeNumbers();
+
+  /**
+   * Scans the overlay while it is in use, without repairing it: concurrent
+   * changes could be mistaken for errors. If errors are found, they are
+   * repaired the next time the overlay is opened.
+   */
+  void lazyFsck(
+      uint32_t numThreads,
+      uint64_t logFrequency,
+      OverlayChecker::LookupCallback lookupCallback) noexcept;
+#endif // !_WIN32
+
   // Serialize EdenFS overlay data structure into Thrift data structure
   overlay::OverlayEntry serializeOverlayEntry(const DirEntry& entry);
 
@@ -347,13 +409,71 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
   bool hadCleanStartup_{false};
 
   /**
-   * The next inode number to allocate.  Zero indicates that neither
-   * initializeFromTakeover nor getMaxRecordedInode have been called.
+   * Set by initOverlay() when the overlay must be checked in the background
+   * once it is initialized.
+   */
+  bool lazyFsckPending_{false};
+
+  /**
+   * Set when the background check found errors, the overlay then isn't
+   * marked as cleanly closed.
+   */
+  std::atomic<bool> lazyFsckFoundErrors_{false};
+
+  /**
+   * The inode numbers a thread allocates from, reserved from
+   * nextInodeNumber_ kInodeNumberBlockSize at a time so that threads creating
+   * many inodes concurrently don't all contend on it.
+   */
+  class InodeNumberBlock {
+   public:
+    explicit InodeNumberBlock(Overlay& overlay) : overlay_{overlay} {}
+    ~InodeNumberBlock();
+
+    InodeNumberBlock(const InodeNumberBlock&) = delete;
+    InodeNumberBlock& operator=(const InodeNumberBlock&) = delete;
+
+    InodeNumber allocate();
+
+    /**
+     * The largest inode number allocated from this thread's blocks, or 0.
+     */
+    uint64_t getMaxAllocated() const {
+      auto next = next_.load(std::memory_order_relaxed);
+      return next ? next - 1 : 0;
+    }
+
+   private:
+    Overlay& overlay_;
+    /**
+     * Only written by the owning thread, but read by getMaxInodeNumber().
+     * Blocks are only reserved when allocating from them, so next_ - 1 is
+     * always allocated.
+     */
+    std::atomic<uint64_t> next_{0};
+    uint64_t end_{0};
+  };
+
+  class InodeNumberBlockTag {};
+
+  static constexpr uint64_t kInodeNumberBlockSize = 64;
+
+  void updateMaxRetiredInodeNumber(uint64_t inodeNumber);
+
+  /**
+   * The next inode number to reserve a block from.  Zero indicates that
+   * neither initializeFromTakeover nor getMaxRecordedInode have been called.
    *
    * This value will never be 1.
    */
   std::atomic<uint64_t> nextInodeNumber_{0};
 
+  /**
+   * The largest inode number allocated before initialization, or from the
+   * blocks of threads that exited.
+   */
+  std::atomic<uint64_t> maxRetiredInodeNumber_{0};
+
   std::unique_ptr<IFileContentStore> fileContentStore_;
   std::unique_ptr<InodeCatalog> inodeCatalog_;
   Overlay::InodeCatalogType inodeCatalogType_;
@@ -389,6 +509,15 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
   std::thread gcThread_;
   folly::Synchronized<GCQueue, std::mutex> gcQueue_;
   std::condition_variable gcCondVar_;
+  std::atomic<size_t> gcBacklog_{0};
+  const uint32_t gcThreads_;
+  const bool gcLowIOPriority_;
+
+  /**
+   * Thread which checks the overlay in the background, with fsck:lazy-fsck.
+   * Started by gcThread_ once the overlay is initialized.
+   */
+  std::thread fsckThread_;
 
   /**
    * This uint64_t holds two values, a single bit on the MSB that
@@ -407,6 +536,11 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
 
   std::shared_ptr<StructuredLogger> structuredLogger_;
 
+  // Declared last, so that it is destroyed first: the InodeNumberBlocks
+  // update maxRetiredInodeNumber_ when destroyed.
+  folly::ThreadLocal<InodeNumberBlock, InodeNumberBlockTag> inodeNumberBlocks_{
+      [this] { return new InodeNumberBlock{*this}; }};
+
   friend class IORequest;
 };
 
@@ -9,6 +9,8 @@
 
 #include "eden/fs/inodes/OverlayFileAccess.h"
 
+#include <algorithm>
+
 #include <folly/Expected.h>
 #include <folly/Range.h>
 #include <folly/logging/xlog.h>
@@ -35,10 +37,40 @@ namespace facebook::eden {
 
 DEFINE_uint64(overlayFileCacheSize, 100, "");
 
+OverlayFileAccess::Entry::Info::RunningSha1
+OverlayFileAccess::Entry::Info::RunningSha1::empty() {
+  RunningSha1 running;
+  SHA1_Init(&running.ctx);
+  running.length = 0;
+  return running;
+}
+
 void OverlayFileAccess::Entry::Info::invalidateMetadata() {
   ++version;
   size = std::nullopt;
   sha1 = std::nullopt;
+  runningSha1 = std::nullopt;
+}
+
+void OverlayFileAccess::Entry::Info::recordWrite(
+    const struct iovec* iov,
+    size_t iovcnt,
+    off_t off,
+    size_t written) {
+  auto running = std::move(runningSha1);
+  invalidateMetadata();
+  if (!running || static_cast<uint64_t>(off) != running->length) {
+    return;
+  }
+
+  for (size_t i = 0; i < iovcnt && written > 0; ++i) {
+    auto len = std::min(iov[i].iov_len, written);
+    SHA1_Update(&running->ctx, iov[i].iov_base, len);
+    running->length += len;
+    written -= len;
+  }
+  size = running->length;
+  runningSha1 = std::move(running);
 }
 
 OverlayFileAccess::State::State(size_t cacheSize) : entries{cacheSize} {
@@ -57,15 +89,18 @@ void OverlayFileAccess::createEmptyFile(InodeNumber ino) {
   auto state = state_.wlock();
   XCHECK(!state->entries.exists(ino))
       << "Cannot create overlay file " << ino << " when it's already open!";
-  state->entries.set(
-      ino, std::make_shared<Entry>(std::move(file), size_t{0}, kEmptySha1));
+  auto entry = std::make_shared<Entry>(std::move(file), size_t{0}, kEmptySha1);
+  entry->info.wlock()->runningSha1 = Entry::Info::RunningSha1::empty();
+  state->entries.set(ino, std::move(entry));
 }
 
 void OverlayFileAccess::createFile(
     InodeNumber ino,
+    const ObjectId& blobId,
     const Blob& blob,
     const std::optional<Hash20>& sha1) {
-  auto file = overlay_->createOverlayFile(ino, blob.getContents());
+  auto file =
+      overlay_->createOverlayFileForBlob(ino, blobId, blob.getContents());
   auto state = state_.wlock();
   XCHECK(!state->entries.exists(ino))
       << "Cannot create overlay file " << ino << " when it's already open!";
@@ -131,6 +166,19 @@ Hash20 OverlayFileAccess::getSha1(FileInode& inode) {
     version = info->version;
   }
 
+  {
+    auto info = entry->info.wlock();
+    if (info->runningSha1.has_value()) {
+      // The file was only appended to since it was last hashed: finalize a
+      // copy of the running state, which stays extendable.
+      SHA_CTX ctx = info->runningSha1->ctx;
+      Hash20 sha1;
+      SHA1_Final(sha1.mutableBytes().begin(), &ctx);
+      info->sha1 = sha1;
+      return sha1;
+    }
+  }
+
   // SHA-1 is not known, so recompute it. Do so while the lock is not held to
   // improve concurrency.
 
@@ -161,13 +209,17 @@ Hash20 OverlayFileAccess::getSha1(FileInode& inode) {
   }
 
   static_assert(Hash20::RAW_SIZE == SHA_DIGEST_LENGTH);
+  Entry::Info::RunningSha1 running{
+      ctx, static_cast<uint64_t>(off) - FileContentStore::kHeaderLength};
   Hash20 sha1;
   SHA1_Final(sha1.mutableBytes().begin(), &ctx);
 
-  // Update the cache if the version still matches.
+  // Update the cache if the version still matches. Later appends then extend
+  // the hash instead of discarding it.
   auto info = entry->info.wlock();
   if (version == info->version) {
     info->sha1 = sha1;
+    info->runningSha1 = running;
   }
   return sha1;
 }
@@ -238,7 +290,7 @@ size_t OverlayFileAccess::write(
         "pwritev failed during file write");
   }
   auto info = entry->info.wlock();
-  info->invalidateMetadata();
+  info->recordWrite(iov, iovcnt, off, xfer.value());
 
   return xfer.value();
 }
@@ -255,6 +307,12 @@ void OverlayFileAccess::truncate(FileInode& inode, off_t size) {
 
   auto info = entry->info.wlock();
   info->invalidateMetadata();
+  if (size == 0) {
+    // Files are commonly truncated before being rewritten.
+    info->size = 0;
+    info->sha1 = kEmptySha1;
+    info->runningSha1 = Entry::Info::RunningSha1::empty();
+  }
 }
 
 void OverlayFileAccess::fsync(FileInode& inode, bool datasync) {
@@ -284,6 +342,10 @@ void OverlayFileAccess::fallocate(
         inode.inodePtrFromThis(),
         "unable to fallocate overlay file");
   }
+
+  // fallocate may extend the file.
+  auto info = entry->info.wlock();
+  info->invalidateMetadata();
 }
 
 OverlayFileAccess::EntryPtr OverlayFileAccess::getEntryForInode(
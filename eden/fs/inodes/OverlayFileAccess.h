@@ -10,6 +10,7 @@
 #include <folly/File.h>
 #include <folly/Synchronized.h>
 #include <folly/container/EvictingCacheMap.h>
+#include <folly/portability/OpenSSL.h>
 #include <memory>
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/inodes/InodePtr.h"
@@ -21,6 +22,7 @@ namespace facebook::eden {
 
 class Blob;
 class FileInode;
+class ObjectId;
 class Overlay;
 
 /**
@@ -44,7 +46,7 @@ class OverlayFileAccess {
 
   /**
    * Creates a new file in the overlay populated with the contents of the given
-   * blob. If a sha1 is given, it is cached in memory.
+   * blob, whose id is blobId. If a sha1 is given, it is cached in memory.
    *
    * The caller must verify the overlay file does not already exist. Calls to
    * any other OverlayFileAccess functions for this inode must occur after
@@ -52,6 +54,7 @@ class OverlayFileAccess {
    */
   void createFile(
       InodeNumber ino,
+      const ObjectId& blobId,
       const Blob& blob,
       const std::optional<Hash20>& sha1);
 
@@ -122,6 +125,12 @@ class OverlayFileAccess {
    * concurrent with write or truncate, a version number is incremented on every
    * modification to an entry's file, and checked before writing the cached
    * value back.
+   *
+   * Files are commonly written sequentially, from empty or by appending, so
+   * the SHA-1 state of the whole file is kept along with its length, and
+   * extended by writes at its end instead of being discarded. getSha1 then
+   * finalizes it rather than reading the file back. Any other modification
+   * drops it until the next full hash.
    */
 
   struct Entry {
@@ -137,8 +146,28 @@ class OverlayFileAccess {
 
       void invalidateMetadata();
 
+      /**
+       * Invalidates the metadata after a write of `written` bytes from iov at
+       * offset off, extending the running SHA-1 if the write appended to the
+       * hashed contents.
+       */
+      void recordWrite(
+          const struct iovec* iov,
+          size_t iovcnt,
+          off_t off,
+          size_t written);
+
+      struct RunningSha1 {
+        static RunningSha1 empty();
+
+        SHA_CTX ctx;
+        // The number of bytes hashed into ctx, which is the file size.
+        uint64_t length;
+      };
+
       std::optional<size_t> size;
       std::optional<Hash20> sha1;
+      std::optional<RunningSha1> runningSha1;
       uint64_t version{0};
     };
 
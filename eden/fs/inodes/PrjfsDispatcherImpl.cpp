@@ -12,7 +12,6 @@
 #include <boost/filesystem/path.hpp>
 #include <cpptoml.h>
 #include <folly/executors/QueuedImmediateExecutor.h>
-#include <folly/executors/SerialExecutor.h>
 #include <folly/logging/xlog.h>
 #include <folly/stop_watch.h>
 #include "eden/fs/config/CheckoutConfig.h"
@@ -64,9 +63,12 @@ std::string makeDotEdenConfig(EdenMount& mount) {
 PrjfsDispatcherImpl::PrjfsDispatcherImpl(EdenMount* mount)
     : PrjfsDispatcher(mount->getStats()),
       mount_{mount},
-      executor_{1, "PrjfsDispatcher"},
-      notificationExecutor_{
-          folly::SerialExecutor::create(folly::getKeepAliveToken(&executor_))},
+      executor_{
+          mount->getEdenConfig()->prjfsNumNotificationThreads.getValue(),
+          "PrjfsDispatcher"},
+      notificationScheduler_{
+          folly::getKeepAliveToken(&executor_),
+          mount->getCheckoutConfig()->getCaseSensitive()},
       dotEdenConfig_{makeDotEdenConfig(*mount)} {}
 
 ImmediateFuture<std::vector<PrjfsDirEntry>> PrjfsDispatcherImpl::opendir(
@@ -87,6 +89,11 @@ ImmediateFuture<std::vector<PrjfsDirEntry>> PrjfsDispatcherImpl::opendir(
           if (treeEntry.second.isTree()) {
             ret.emplace_back(
                 treeEntry.first, true, ImmediateFuture<uint64_t>(0ull));
+          } else if (const auto& size = treeEntry.second.getSize()) {
+            // Trees fetched from the backing store often carry the size of
+            // their files, there is no need to fetch the blob metadata then.
+            ret.emplace_back(
+                treeEntry.first, false, ImmediateFuture<uint64_t>(*size));
           } else {
             auto sizeFut =
                 objectStore->getBlobSize(treeEntry.second.getHash(), context);
@@ -153,16 +160,14 @@ ImmediateFuture<std::optional<LookupResult>> PrjfsDispatcherImpl::lookup(
               // call. In rare situation, this might happen during a checkout
               // operation which is already holding locks that the code below
               // also need.
-              folly::via(
-                  notificationExecutor_,
-                  [&mount = *mount_,
-                   path = std::move(path),
-                   context = context.copy()]() {
+              notificationScheduler_.add(
+                  path, [&mount = *mount_, path, context = context.copy()]() {
                     // Finally, let's tell the TreeInode that this file needs
                     // invalidation during update. This is run in a separate
-                    // executor to avoid deadlocks. This is guaranteed to 1) run
-                    // before any other changes to this inode, and 2) before
-                    // checkout starts invalidating files/directories.
+                    // executor to avoid deadlocks. Being ordered on its path,
+                    // this is guaranteed to 1) run before any other changes
+                    // to this inode, and 2) before checkout starts
+                    // invalidating files/directories.
                     // This also cannot race with a decFsRefcount from
                     // TreeInode::invalidateChannelEntryCache due to
                     // getInodeSlow needing to acquire the content lock that
@@ -660,13 +665,14 @@ ImmediateFuture<folly::Unit> fileNotificationImpl(
 ImmediateFuture<folly::Unit> fileNotification(
     EdenMount& mount,
     RelativePath path,
-    folly::Executor::KeepAlive<folly::SequencedExecutor> executor,
+    PathScheduler& scheduler,
     const ObjectFetchContextPtr& context) {
   auto receivedAt = std::chrono::steady_clock::now();
   folly::stop_watch<std::chrono::milliseconds> watch;
 
-  folly::via(
-      executor,
+  mount.getStats()->increment(
+      &PrjfsStats::pendingFileNotifications, scheduler.getPendingCount());
+  auto handleNotification =
       [&mount, path, receivedAt, context = context.copy(), watch]() mutable {
         auto fault = ImmediateFuture{
             mount.getServerState()->getFaultInjector().checkAsync(
@@ -683,7 +689,10 @@ ImmediateFuture<folly::Unit> fileNotification(
             .get();
         mount.getStats()->addDuration(
             &PrjfsStats::queuedFileNotification, watch.elapsed());
-      })
+      };
+
+  scheduler.add(path, std::move(handleNotification))
+      .via(&folly::QueuedImmediateExecutor::instance())
       .thenError([path](const folly::exception_wrapper& ew) {
         // These should in theory never happen, but they sometimes happen
         // due to filesystem errors, antivirus scanning, etc. During
@@ -702,21 +711,21 @@ ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::fileCreated(
     RelativePath path,
     const ObjectFetchContextPtr& context) {
   return fileNotification(
-      *mount_, std::move(path), notificationExecutor_, context);
+      *mount_, std::move(path), notificationScheduler_, context);
 }
 
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::dirCreated(
     RelativePath path,
     const ObjectFetchContextPtr& context) {
   return fileNotification(
-      *mount_, std::move(path), notificationExecutor_, context);
+      *mount_, std::move(path), notificationScheduler_, context);
 }
 
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::fileModified(
     RelativePath path,
     const ObjectFetchContextPtr& context) {
   return fileNotification(
-      *mount_, std::move(path), notificationExecutor_, context);
+      *mount_, std::move(path), notificationScheduler_, context);
 }
 
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::fileRenamed(
@@ -726,9 +735,9 @@ ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::fileRenamed(
   // A rename is just handled like 2 notifications separate notifications on
   // the old and new paths.
   auto oldNotification = fileNotification(
-      *mount_, std::move(oldPath), notificationExecutor_, context);
+      *mount_, std::move(oldPath), notificationScheduler_, context);
   auto newNotification = fileNotification(
-      *mount_, std::move(newPath), notificationExecutor_, context);
+      *mount_, std::move(newPath), notificationScheduler_, context);
 
   return collectAllSafe(std::move(oldNotification), std::move(newNotification))
       .thenValue(
@@ -769,7 +778,7 @@ ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::fileDeleted(
     RelativePath path,
     const ObjectFetchContextPtr& context) {
   return fileNotification(
-      *mount_, std::move(path), notificationExecutor_, context);
+      *mount_, std::move(path), notificationScheduler_, context);
 }
 
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::preFileDelete(
@@ -786,7 +795,7 @@ ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::dirDeleted(
     RelativePath path,
     const ObjectFetchContextPtr& context) {
   return fileNotification(
-      *mount_, std::move(path), notificationExecutor_, context);
+      *mount_, std::move(path), notificationScheduler_, context);
 }
 
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::preDirDelete(
@@ -801,9 +810,10 @@ ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::preDirDelete(
 
 ImmediateFuture<folly::Unit>
 PrjfsDispatcherImpl::waitForPendingNotifications() {
-  // Since the executor is a SequencedExecutor, and the fileNotification
-  // function blocks in the executor, the body of the lambda will only be
-  // executed when all previously enqueued notifications have completed.
+  // Since the root path is ordered after every path, and the
+  // fileNotification function blocks in the executor, the body of the lambda
+  // will only be executed when all previously enqueued notifications have
+  // completed.
   //
   // Note that this synchronization only guarantees that writes from a the
   // calling application thread have completed when the future complete. Writes
@@ -811,7 +821,7 @@ PrjfsDispatcherImpl::waitForPendingNotifications() {
   // ProjectedFS queue and therefore may still be pending when the future
   // complete. This is expected and therefore not a bug.
   return ImmediateFuture{
-      folly::via(notificationExecutor_, []() { return folly::unit; }).semi()};
+      notificationScheduler_.add(RelativePathPiece{}, [] {})};
 }
 
 } // namespace facebook::eden
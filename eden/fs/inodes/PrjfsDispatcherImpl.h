@@ -7,9 +7,9 @@
 
 #pragma once
 
-#include <folly/executors/SequencedExecutor.h>
 #include "eden/fs/prjfs/PrjfsDispatcher.h"
 #include "eden/fs/service/gen-cpp2/eden_types.h"
+#include "eden/fs/utils/PathScheduler.h"
 #include "eden/fs/utils/UnboundedQueueExecutor.h"
 
 namespace facebook::eden {
@@ -86,10 +86,12 @@ class PrjfsDispatcherImpl : public PrjfsDispatcher {
   EdenMount* const mount_;
 
   UnboundedQueueExecutor executor_;
-  // All the notifications are dispatched to this executor. The
-  // waitForPendingNotifications implementation depends on this being a
-  // SequencedExecutor.
-  folly::Executor::KeepAlive<folly::SequencedExecutor> notificationExecutor_;
+  // All the notifications are dispatched to executor_ through this
+  // scheduler, which only runs concurrently the notifications of paths that
+  // are not on the same ancestor chain. The waitForPendingNotifications
+  // implementation depends on the root path being ordered after every
+  // path.
+  PathScheduler notificationScheduler_;
 
   const std::string dotEdenConfig_;
 };
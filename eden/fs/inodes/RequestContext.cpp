@@ -10,6 +10,7 @@
 #include <folly/logging/xlog.h>
 
 #include "eden/fs/telemetry/RequestMetricsScope.h"
+#include "eden/fs/telemetry/RequestSampler.h"
 #include "eden/fs/utils/SystemError.h"
 
 using namespace std::chrono;
@@ -25,6 +26,12 @@ RequestContext::~RequestContext() noexcept {
       XCHECK(latencyStat_) << "stats_ and latencyStat_ must be set together";
       latencyStat_(*stats_).addDuration(diff);
     }
+    if (latencies_) {
+      latencies_->addDuration(latencyOp_, duration_cast<microseconds>(diff));
+    }
+    if (sampled_) {
+      getRequestSampler().remove(*fsObjectFetchContext_->getRequestPhases());
+    }
 
     if (requestWatchList_) {
       { auto temp = std::move(requestMetricsScope_); }
@@ -58,8 +65,7 @@ RequestContext::~RequestContext() noexcept {
 void RequestContext::startRequest(
     EdenStats* stats,
     DurationFn stat,
-    std::shared_ptr<RequestMetricsScope::LockedRequestWatchList>
-        requestWatches) {
+    std::shared_ptr<RequestMetricsScope::RequestWatchList> requestWatches) {
   startTime_ = steady_clock::now();
   XDCHECK(!latencyStat_);
   stats_ = stats;
@@ -70,4 +76,20 @@ void RequestContext::startRequest(
   }
 }
 
+void RequestContext::setLatencies(
+    std::shared_ptr<FsChannelLatencies> latencies,
+    size_t op) {
+  latencies_ = std::move(latencies);
+  latencyOp_ = op;
+
+  auto& sampler = getRequestSampler();
+  const auto& opName = latencies_->getOpName(op);
+  if (!sampled_ && sampler.isEnabled() && !opName.empty()) {
+    auto& phases = *fsObjectFetchContext_->getRequestPhases();
+    phases.setName(latencies_->getChannel(), opName);
+    sampler.add(phases);
+    sampled_ = true;
+  }
+}
+
 } // namespace facebook::eden
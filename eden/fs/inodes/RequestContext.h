@@ -14,6 +14,7 @@
 #include "eden/fs/store/ImportPriority.h"
 #include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/telemetry/EdenStats.h"
+#include "eden/fs/telemetry/FsChannelLatencies.h"
 #include "eden/fs/telemetry/RequestMetricsScope.h"
 #include "eden/fs/utils/ProcessAccessLog.h"
 
@@ -71,8 +72,21 @@ class FsObjectFetchContext : public ObjectFetchContext {
     }
   }
 
+  void lowerPriority(ImportPriority priority) override {
+    ImportPriority prev = priority_.load(std::memory_order_acquire);
+    while (priority < prev &&
+           !priority_.compare_exchange_weak(
+               prev, priority, std::memory_order_acq_rel)) {
+    }
+  }
+
+  RequestPhases* getRequestPhases() override {
+    return &requestPhases_;
+  }
+
  private:
   EdenTopStats edenTopStats_;
+  RequestPhases requestPhases_;
 
   /**
    * Normally, one requestData is created for only one fetch request,
@@ -103,8 +117,7 @@ class RequestContext {
   void startRequest(
       EdenStats* stats,
       StatsGroupBase::Duration T::*stat,
-      std::shared_ptr<RequestMetricsScope::LockedRequestWatchList>
-          requestWatches) {
+      std::shared_ptr<RequestMetricsScope::RequestWatchList> requestWatches) {
     return startRequest(
         stats,
         [stat](EdenStats& stats) -> StatsGroupBase::Duration& {
@@ -113,6 +126,13 @@ class RequestContext {
         std::move(requestWatches));
   }
 
+  /**
+   * Also record the duration of the request in the latency histogram of the
+   * given operation of the channel, and sample its phases under the names of
+   * the channel and operation while it is in flight.
+   */
+  void setLatencies(std::shared_ptr<FsChannelLatencies> latencies, size_t op);
+
   const ObjectFetchContextPtr& getObjectFetchContext() const {
     return fsObjectFetchContext_.as<ObjectFetchContext>();
   }
@@ -134,8 +154,7 @@ class RequestContext {
   void startRequest(
       EdenStats* stats,
       DurationFn stat,
-      std::shared_ptr<RequestMetricsScope::LockedRequestWatchList>
-          requestWatches);
+      std::shared_ptr<RequestMetricsScope::RequestWatchList> requestWatches);
 
   void finishRequest() noexcept;
 
@@ -143,10 +162,13 @@ class RequestContext {
   std::chrono::time_point<std::chrono::steady_clock> startTime_;
   EdenStats* stats_ = nullptr;
   DurationFn latencyStat_;
+  std::shared_ptr<FsChannelLatencies> latencies_;
+  size_t latencyOp_ = 0;
+  // Whether the request is registered with the RequestSampler.
+  bool sampled_ = false;
 
   RequestMetricsScope requestMetricsScope_;
-  std::shared_ptr<RequestMetricsScope::LockedRequestWatchList>
-      requestWatchList_;
+  std::shared_ptr<RequestMetricsScope::RequestWatchList> requestWatchList_;
   ProcessAccessLog& pal_;
 
   const FsObjectFetchContextPtr fsObjectFetchContext_;
@@ -33,6 +33,12 @@ constexpr std::chrono::seconds kUserIgnoreMinPollSeconds{5};
 /** Throttle Ignore change checks, max of 1 per kSystemIgnoreMinPollSeconds */
 constexpr std::chrono::seconds kSystemIgnoreMinPollSeconds{5};
 
+/**
+ * Few directories have a .gitignore file, and the parsed ones are small: keep
+ * enough for the largest repositories.
+ */
+constexpr size_t kGitIgnoreCacheEntries{16 * 1024};
+
 ServerState::ServerState(
     UserInfo userInfo,
     std::shared_ptr<PrivHelper> privHelper,
@@ -62,18 +68,23 @@ ServerState::ServerState(
                     mainEventBase,
                     initialConfig.numNfsThreads.getValue(),
                     initialConfig.maxNfsInflightRequests.getValue(),
+                    initialConfig.numNfsIoThreads.getValue(),
                     structuredLogger_)
               :
 #endif
               nullptr,
       },
       config_{std::move(reloadableConfig)},
+      fileChangeWatcher_{FileChangeWatcher::create()},
       userIgnoreFileMonitor_{CachedParsedFileMonitor<GitIgnoreFileParser>{
           initialConfig.userIgnoreFile.getValue(),
-          kUserIgnoreMinPollSeconds}},
+          kUserIgnoreMinPollSeconds,
+          fileChangeWatcher_}},
       systemIgnoreFileMonitor_{CachedParsedFileMonitor<GitIgnoreFileParser>{
           initialConfig.systemIgnoreFile.getValue(),
-          kSystemIgnoreMinPollSeconds}},
+          kSystemIgnoreMinPollSeconds,
+          fileChangeWatcher_}},
+      gitIgnoreCache_{kGitIgnoreCacheEntries},
       notifier_{std::move(notifier)},
       fsEventLogger_{
           initialConfig.requestSamplesPerMinute.getValue()
@@ -121,4 +132,21 @@ std::unique_ptr<TopLevelIgnores> ServerState::getTopLevelIgnores() {
       std::move(userGitIgnore), std::move(systemGitIgnore));
 }
 
+size_t ServerState::getTopLevelIgnoresVersion() {
+  auto edenConfig = getEdenConfig();
+
+  // Check the files for changes, as getTopLevelIgnores() would, so that an
+  // edit is noticed even if nothing has called getTopLevelIgnores() since.
+  auto userIgnoreFileMonitor = userIgnoreFileMonitor_.wlock();
+  userIgnoreFileMonitor->getFileContents(
+      edenConfig->userIgnoreFile.getValue());
+  auto systemIgnoreFileMonitor = systemIgnoreFileMonitor_.wlock();
+  systemIgnoreFileMonitor->getFileContents(
+      edenConfig->systemIgnoreFile.getValue());
+
+  // Both counts only grow, so their sum changes whenever either does.
+  return userIgnoreFileMonitor->getUpdateCount() +
+      systemIgnoreFileMonitor->getUpdateCount();
+}
+
 } // namespace facebook::eden
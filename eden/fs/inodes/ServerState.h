@@ -14,6 +14,7 @@
 #include "eden/fs/config/CachedParsedFileMonitor.h"
 #include "eden/fs/config/ReloadableConfig.h"
 #include "eden/fs/fuse/privhelper/PrivHelper.h"
+#include "eden/fs/model/git/GitIgnoreCache.h"
 #include "eden/fs/model/git/GitIgnoreFileParser.h"
 #include "eden/fs/notifications/Notifier.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -103,6 +104,19 @@ class ServerState {
    */
   std::unique_ptr<TopLevelIgnores> getTopLevelIgnores();
 
+  /**
+   * Return a number that changes whenever the system or user git ignore
+   * files returned by getTopLevelIgnores() change.
+   */
+  size_t getTopLevelIgnoresVersion();
+
+  /**
+   * The parsed .gitignore files of the diffs of all the mounts.
+   */
+  GitIgnoreCache& getGitIgnoreCache() {
+    return gitIgnoreCache_;
+  }
+
   /**
    * Get the UserInfo object describing the user running this edenfs process.
    */
@@ -197,10 +211,13 @@ class ServerState {
   std::shared_ptr<NfsServer> nfs_;
 
   std::shared_ptr<ReloadableConfig> config_;
+  /** Null on platforms where the ignore files are polled. */
+  std::shared_ptr<FileChangeWatcher> fileChangeWatcher_;
   folly::Synchronized<CachedParsedFileMonitor<GitIgnoreFileParser>>
       userIgnoreFileMonitor_;
   folly::Synchronized<CachedParsedFileMonitor<GitIgnoreFileParser>>
       systemIgnoreFileMonitor_;
+  GitIgnoreCache gitIgnoreCache_;
   std::shared_ptr<Notifier> notifier_;
   std::shared_ptr<FsEventLogger> fsEventLogger_;
 };
@@ -70,6 +70,7 @@ void traverseTreeInodeChildren(
       }
     }
   }
+  callbacks.leaveTreeInode(rootPath);
 }
 
 void traverseObservedInodes(
@@ -51,6 +51,11 @@ struct TraversalCallbacks {
    * should recurse to the entry's children.
    */
   virtual bool shouldRecurse(const ChildEntry& entry) = 0;
+
+  /**
+   * Called once the children of the TreeInode at path have been traversed.
+   */
+  virtual void leaveTreeInode(RelativePathPiece /*path*/) {}
 };
 
 /**
@@ -11,6 +11,7 @@
 #include <folly/FileUtil.h>
 #include <folly/chrono/Conv.h>
 #include <folly/futures/Future.h>
+#include <folly/io/Cursor.h>
 #include <folly/io/async/EventBase.h>
 #include <folly/logging/xlog.h>
 #include <vector>
@@ -32,6 +33,7 @@
 #include "eden/fs/inodes/ServerState.h"
 #include "eden/fs/inodes/TreePrefetchLease.h"
 #include "eden/fs/journal/Journal.h"
+#include "eden/fs/model/Blob.h"
 #include "eden/fs/model/Tree.h"
 #include "eden/fs/model/TreeEntry.h"
 #include "eden/fs/model/git/GitIgnoreStack.h"
@@ -43,6 +45,7 @@
 #include "eden/fs/store/DiffCallback.h"
 #include "eden/fs/store/DiffContext.h"
 #include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/telemetry/Tracing.h"
 #include "eden/fs/utils/Bug.h"
 #include "eden/fs/utils/CaseSensitivity.h"
@@ -258,7 +261,7 @@ std::optional<ImmediateFuture<VirtualInode>> TreeInode::rlockGetOrFindChild(
 
 std::pair<folly::SemiFuture<InodePtr>, TreeInode::LoadChildCleanUp>
 TreeInode::loadChild(
-    folly::Synchronized<TreeInodeState>::LockedPtr& contents,
+    SynchronizedTreeInodeState::LockedPtr& contents,
     PathComponentPiece name,
     const ObjectFetchContextPtr& context) {
   auto inodeLoadFuture = Future<unique_ptr<InodeBase>>::makeEmpty();
@@ -1053,6 +1056,10 @@ DirContents TreeInode::saveDirFromTree(
       tree, overlay, mount->getCheckoutConfig()->getCaseSensitive());
   // buildDirFromTree just allocated inode numbers; they should be saved.
   overlay->saveOverlayDir(inodeNumber, dir);
+  auto* stats = mount->getStats();
+  stats->increment(
+      &TreeInodeStats::dirContentsFromTreeBytes, dir.getSizeBytes());
+  stats->increment(&TreeInodeStats::sourceTreeBytes, tree->getSizeBytes());
   return dir;
 }
 
@@ -1068,7 +1075,9 @@ DirContents TreeInode::buildDirFromTree(
   // other work this loop is doing it may not matter much.
 
   DirContents dir(caseSensitive);
-  // TODO: O(N^2)
+  // Loaded directories are rarely modified, so size the entries exactly
+  // rather than leaving the slack of repeated growth.
+  dir.reserve(tree->size());
   for (const auto& treeEntry : *tree) {
     dir.emplace(
         treeEntry.first,
@@ -1080,7 +1089,7 @@ DirContents TreeInode::buildDirFromTree(
 }
 
 FileInodePtr TreeInode::createImpl(
-    folly::Synchronized<TreeInodeState>::LockedPtr contents,
+    SynchronizedTreeInodeState::LockedPtr contents,
     PathComponentPiece name,
     mode_t mode,
     FOLLY_MAYBE_UNUSED ByteRange fileContents,
@@ -1487,6 +1496,13 @@ InodePtr TreeInode::tryRemoveUnloadedChild(
     throw InodeError(EPERM, inodePtrFromThis());
   }
 #endif
+  // The rename lock keeps the path recorded in the journal accurate.
+  auto renameLock = getMount()->acquireRenameLock();
+  auto myPath = getPath();
+  if (!myPath.has_value()) {
+    throw InodeError(ENOENT, inodePtrFromThis());
+  }
+
   auto contents = contents_.wlock();
 
   auto it = contents->entries.find(name);
@@ -1496,6 +1512,7 @@ InodePtr TreeInode::tryRemoveUnloadedChild(
 
   auto inodeName = copyCanonicalInodeName(it);
   auto inodeNumber = it->second.getInodeNumber();
+  auto isDirectory = it->second.isDirectory();
 
   if (auto node = it->second.getInodePtr()) {
     // The child has a loaded! Fall back to the slow path.
@@ -1510,12 +1527,17 @@ InodePtr TreeInode::tryRemoveUnloadedChild(
   }
 
   updateMtimeAndCtimeLocked(contents->entries, getNow());
-  if (it->second.isDirectory()) {
+  if (isDirectory) {
     getOverlay()->recursivelyRemoveOverlayDir(inodeNumber);
   } else {
     getOverlay()->removeOverlayFile(inodeNumber);
   }
   getOverlay()->removeChild(getNodeId(), name, contents->entries);
+  contents.unlock();
+
+  // The whole subtree goes away with this single delta, its overlay data
+  // being reclaimed by the overlay's GC thread.
+  getMount()->getJournal().recordRemoved(myPath.value() + inodeName);
   return nullptr;
 }
 
@@ -1841,9 +1863,9 @@ class TreeInode::TreeRenameLocks {
    * always both set, so that destContents_ can be used regardless of wether
    * the source and destination are both the same directory or not.
    */
-  folly::Synchronized<TreeInodeState>::LockedPtr srcContentsLock_;
-  folly::Synchronized<TreeInodeState>::LockedPtr destContentsLock_;
-  folly::Synchronized<TreeInodeState>::LockedPtr destChildContentsLock_;
+  SynchronizedTreeInodeState::LockedPtr srcContentsLock_;
+  SynchronizedTreeInodeState::LockedPtr destContentsLock_;
+  SynchronizedTreeInodeState::LockedPtr destChildContentsLock_;
 
   /**
    * Pointers to the source and destination directory contents.
@@ -2248,8 +2270,9 @@ bool TreeInode::readdirImpl(
    *
    * Today, Eden does not support hard links. Therefore, in the short term, we
    * can store inode numbers in off_t and treat them as an index into an
-   * inode-sorted list of entries. This has quadratic time complexity without an
-   * additional index but is correct.
+   * inode-sorted list of entries. That list is kept across calls for large
+   * directories, until entries are added or removed, so that each call resumes
+   * with a binary search rather than sorting the entries again.
    *
    * In the long term, especially when Eden's tree directory structure is stored
    * in SQLite or something similar, we should maintain a seekdir/readdir cookie
@@ -2300,34 +2323,76 @@ bool TreeInode::readdirImpl(
   auto dir = contents_.rlock();
   auto& entries = dir->entries;
 
-  // Compute an index into the PathMap by InodeNumber, only including the
-  // entries that are greater than the given offset.
-  std::vector<std::pair<InodeNumber, size_t>> indices;
-  indices.reserve(entries.size());
-  size_t index = 0;
-  for (auto& entry : entries) {
-    auto inodeNumber = entry.second.getInodeNumber();
-    if (static_cast<off_t>(inodeNumber.get() + 2) > off) {
-      indices.emplace_back(entry.second.getInodeNumber(), index);
-    }
-    ++index;
-  }
-  std::make_heap(indices.begin(), indices.end(), std::greater<>{});
+  // Resume after the entry with the largest inode number not greater than
+  // off - 2.
+  auto resumePosition = [&](const ReaddirIndex& index, off_t after) {
+    auto minInode = static_cast<uint64_t>(std::max<off_t>(after - 2, 0));
+    return std::upper_bound(
+        index.entries.begin(),
+        index.entries.end(),
+        minInode,
+        [](uint64_t inode, const std::pair<InodeNumber, size_t>& entry) {
+          return inode < entry.first.get();
+        });
+  };
 
+  auto index = getReaddirIndex(entries);
+  auto it = resumePosition(*index, off);
   // The provided FuseDirList has limited space. Add entries until no more fit.
-  while (indices.size()) {
-    std::pop_heap(indices.begin(), indices.end(), std::greater<>{});
-    auto& [name, entry] = entries.begin()[indices.back().second];
-    indices.pop_back();
+  while (it != index->entries.end()) {
+    auto& [name, entry] = entries.begin()[it->second];
+    if (entry.getInodeNumber() != it->first) {
+      // The entry was replaced in place, e.g. by a rename, which doesn't
+      // change the generation of the entries. Positions are still valid, but
+      // the order isn't.
+      auto resumeAfter = it == index->entries.begin()
+          ? off
+          : std::max<off_t>(off, std::prev(it)->first.get() + 2);
+      index = getReaddirIndex(entries, /*rebuild=*/true);
+      it = resumePosition(*index, resumeAfter);
+      continue;
+    }
 
     if (!add(name.stringPiece(), entry, entry.getInodeNumber().get() + 2)) {
       return false;
     }
+    ++it;
   }
 
   return true;
 }
 
+std::shared_ptr<const TreeInode::ReaddirIndex> TreeInode::getReaddirIndex(
+    const DirContents& entries,
+    bool rebuild) {
+  auto generation = entries.getGeneration();
+  bool cache = entries.size() >= kMinCachedReaddirIndexSize;
+  if (cache && !rebuild) {
+    auto cached = readdirIndex_.load(std::memory_order_acquire);
+    if (cached && cached->generation == generation) {
+      return cached;
+    }
+  }
+
+  auto index = std::make_shared<ReaddirIndex>();
+  index->generation = generation;
+  index->entries.reserve(entries.size());
+  size_t position = 0;
+  for (auto& entry : entries) {
+    index->entries.emplace_back(entry.second.getInodeNumber(), position);
+    ++position;
+  }
+  std::sort(index->entries.begin(), index->entries.end());
+
+  if (cache) {
+    readdirIndex_.store(index, std::memory_order_release);
+  } else if (readdirIndex_.load(std::memory_order_relaxed)) {
+    // The directory shrunk, don't keep the index of its former entries.
+    readdirIndex_.store(nullptr, std::memory_order_relaxed);
+  }
+  return index;
+}
+
 FuseDirList TreeInode::fuseReaddir(
     FuseDirList&& list,
     off_t off,
@@ -2390,6 +2455,7 @@ ImmediateFuture<Unit> TreeInode::diff(
 
   InodePtr inode;
   ImmediateFuture<InodePtr> gitignoreInodeFuture;
+  std::optional<ObjectId> gitignoreBlobId;
   vector<IncompleteInodeLoad> pendingLoads;
   {
     // We have to get a write lock since we may have to load
@@ -2410,7 +2476,7 @@ ImmediateFuture<Unit> TreeInode::diff(
     // same hash as the tree we are being compared to.
     if (!contents->isMaterialized()) {
       for (auto& tree : trees) {
-        if (getObjectStore().areObjectsKnownIdentical(
+        if (getObjectStore().areTreesKnownEquivalent(
                 contents->treeHash.value(), tree->getHash())) {
           // There are no changes in our tree or any children subtrees.
           return folly::unit;
@@ -2466,8 +2532,23 @@ ImmediateFuture<Unit> TreeInode::diff(
     }
 
     XLOG(DBG7) << "Loading ignore file for " << getLogPath();
-    inode = gitignoreEntry->getInodePtr();
-    if (!inode) {
+    if (!gitignoreEntry->isMaterialized() &&
+        gitignoreEntry->getDtype() == dtype_t::Regular) {
+      // The contents of the file are those of its blob, which was most likely
+      // parsed by a previous diff. Reading the blob rather than the inode also
+      // saves loading it.
+      auto blobId = gitignoreEntry->getHash();
+      if (auto cached = context->getCachedGitIgnore(blobId)) {
+        return computeDiff(
+            std::move(contents),
+            context,
+            currentPath,
+            std::move(trees),
+            make_unique<GitIgnoreStack>(parentIgnore, std::move(cached)),
+            isIgnored);
+      }
+      gitignoreBlobId = std::move(blobId);
+    } else if (!(inode = gitignoreEntry->getInodePtr())) {
       gitignoreInodeFuture = loadChildLocked(
                                  contents->entries,
                                  kIgnoreFilename,
@@ -2484,7 +2565,37 @@ ImmediateFuture<Unit> TreeInode::diff(
     load.finish();
   }
 
-  if (!inode) {
+  if (gitignoreBlobId) {
+    return getObjectStore()
+        .getBlob(*gitignoreBlobId, context->getFetchContext())
+        .thenTry([self = inodePtrFromThis(),
+                  context,
+                  currentPath = RelativePath{currentPath},
+                  trees = std::move(trees),
+                  parentIgnore,
+                  isIgnored,
+                  blobId = *gitignoreBlobId](
+                     folly::Try<shared_ptr<const Blob>> blob) mutable {
+          shared_ptr<const GitIgnore> ignore;
+          if (blob.hasException()) {
+            XLOG(WARN) << "error reading ignore file: "
+                       << folly::exceptionStr(blob.exception());
+          } else {
+            const auto& contentsBuf = blob.value()->getContents();
+            folly::io::Cursor cursor(&contentsBuf);
+            ignore = context->parseGitIgnore(
+                cursor.readFixedString(contentsBuf.computeChainDataLength()),
+                &blobId);
+          }
+          return self->computeDiff(
+              self->contents_.wlock(),
+              context,
+              currentPath,
+              std::move(trees),
+              make_unique<GitIgnoreStack>(parentIgnore, std::move(ignore)),
+              isIgnored);
+        });
+  } else if (!inode) {
     return std::move(gitignoreInodeFuture)
         .thenValue([self = inodePtrFromThis(),
                     context,
@@ -2544,19 +2655,20 @@ ImmediateFuture<Unit> TreeInode::loadGitIgnoreThenDiff(
                 parentIgnore,
                 isIgnored](
                    folly::Try<std::string> ignoreFileContentsTry) mutable {
-        std::string ignoreFileContents;
+        shared_ptr<const GitIgnore> ignore;
         if (ignoreFileContentsTry.hasException()) {
           XLOG(WARN) << "error reading ignore file: "
                      << folly::exceptionStr(ignoreFileContentsTry.exception());
         } else {
-          ignoreFileContents = std::move(ignoreFileContentsTry).value();
+          ignore = context->parseGitIgnore(
+              ignoreFileContentsTry.value(), /*blobId=*/nullptr);
         }
         return self->computeDiff(
             self->contents_.wlock(),
             context,
             currentPath,
             std::move(trees),
-            make_unique<GitIgnoreStack>(parentIgnore, ignoreFileContents),
+            make_unique<GitIgnoreStack>(parentIgnore, std::move(ignore)),
             isIgnored);
       });
 }
@@ -2587,7 +2699,7 @@ due to the fact that we do not need to worry about recursive lock holding since
 the only time a lock is held in this path is when we load gitignore files.
 */
 ImmediateFuture<Unit> TreeInode::computeDiff(
-    folly::Synchronized<TreeInodeState>::LockedPtr contentsLock,
+    SynchronizedTreeInodeState::LockedPtr contentsLock,
     DiffContext* context,
     RelativePathPiece currentPath,
     std::vector<shared_ptr<const Tree>> trees,
@@ -2769,8 +2881,11 @@ ImmediateFuture<Unit> TreeInode::computeDiff(
               // be materialized, and the previous path will be taken.
               treeEntryTypeFromMode(inodeEntry->getInitialMode()) ==
                   scmEntry.getType() &&
-              getObjectStore().areObjectsKnownIdentical(
-                  inodeEntry->getHash(), scmEntry.getHash())) {
+              (inodeEntry->isDirectory()
+                   ? getObjectStore().areTreesKnownEquivalent(
+                         inodeEntry->getHash(), scmEntry.getHash())
+                   : getObjectStore().areObjectsKnownIdentical(
+                         inodeEntry->getHash(), scmEntry.getHash()))) {
             exactMatch = true;
             break;
           }
@@ -2992,6 +3107,17 @@ Future<Unit> TreeInode::checkout(
              << " --> "
              << (toTree ? toTree->getHash().toLogString() : "<none>");
 
+  // Only directories updated to a destination tree are checkpointed, the
+  // ones being emptied before their removal are not.
+  //
+  // The rename lock is held for the whole checkout, see addConflict().
+  if (toTree && ctx->isSubtreeCheckpointed(getUnsafePath())) {
+    XLOG(DBG4) << "checkout: " << getLogPath()
+               << " was updated by the interrupted checkout";
+    return folly::unit;
+  }
+  ctx->didStartDirectory();
+
   vector<unique_ptr<CheckoutAction>> actions;
   vector<IncompleteInodeLoad> pendingLoads;
   bool wasDirectoryListModified = false;
@@ -3081,6 +3207,12 @@ Future<Unit> TreeInode::checkout(
                                        numErrors](auto&&) {
                              // Update our state in the overlay
                              self->saveOverlayPostCheckout(ctx, toTree.get());
+                             ctx->didFinishDirectory();
+                             if (toTree && numErrors == 0 &&
+                                 !ctx->isDryRun()) {
+                               ctx->markSubtreeComplete(
+                                   self->getUnsafePath());
+                             }
 
                              XLOG(DBG4) << "checkout: finished update of "
                                         << self->getLogPath() << ": "
@@ -3331,6 +3463,7 @@ unique_ptr<CheckoutAction> TreeInode::processCheckoutEntry(
             getOverlay()->allocateInodeNumber(),
             newScmEntry->second.getHash());
         XDCHECK(inserted);
+        ctx->didUpdateEntry();
       } else {
         ctx->addError(this, name, success.exception());
       }
@@ -3475,6 +3608,7 @@ unique_ptr<CheckoutAction> TreeInode::processCheckoutEntry(
         getOverlay()->allocateInodeNumber(),
         newScmEntry->second.getHash());
   }
+  ctx->didUpdateEntry();
 
   wasDirectoryListModified = true;
 
@@ -3575,6 +3709,7 @@ Future<InvalidationRequired> TreeInode::checkoutUpdateEntry(
         XDCHECK(inserted);
       }
     }
+    ctx->didUpdateEntry();
 
     // We don't save our own overlay data right now:
     // we'll wait to do that until the checkout operation finishes touching all
@@ -3686,6 +3821,7 @@ Future<InvalidationRequired> TreeInode::checkoutUpdateEntry(
               // Since we've invalidated the entry, even if this fails we need
               // to make sure the directory is also invalidated, fallthrough.
             }
+            ctx->didUpdateEntry();
 
             // If the entry does not exist at the new commit we can stop here.
             // no need to add anything back to our parent's contents.
@@ -8,12 +8,15 @@
 #pragma once
 #include <folly/File.h>
 #include <folly/Portability.h>
+#include <folly/SharedMutex.h>
 #include <folly/Synchronized.h>
+#include <folly/concurrency/AtomicSharedPtr.h>
 #include <optional>
 #include "eden/fs/fuse/Invalidation.h"
 #include "eden/fs/inodes/CheckoutAction.h"
 #include "eden/fs/inodes/DirEntry.h"
 #include "eden/fs/inodes/InodeBase.h"
+#include "eden/fs/telemetry/LockContention.h"
 #include "eden/fs/utils/PathFuncs.h"
 
 namespace facebook::eden {
@@ -67,6 +70,12 @@ struct TreeInodeState {
   std::optional<ObjectId> treeHash;
 };
 
+inline constexpr char kTreeInodeContentsLockSite[] = "tree_inode_contents";
+
+using SynchronizedTreeInodeState = folly::Synchronized<
+    TreeInodeState,
+    InstrumentedMutex<folly::SharedMutex, kTreeInodeContentsLockSite>>;
+
 /**
  * Represents a directory in the file system.
  */
@@ -210,10 +219,10 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
       const ObjectFetchContextPtr& context);
 #endif
 
-  const folly::Synchronized<TreeInodeState>& getContents() const {
+  const SynchronizedTreeInodeState& getContents() const {
     return contents_;
   }
-  folly::Synchronized<TreeInodeState>& getContents() {
+  SynchronizedTreeInodeState& getContents() {
     return contents_;
   }
 
@@ -602,13 +611,31 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
   template <typename Fn>
   bool readdirImpl(off_t offset, const ObjectFetchContextPtr& context, Fn add);
 
+  /**
+   * The positions of the entries of a DirContents sorted by inode number,
+   * which is the order readdir returns them in.
+   */
+  struct ReaddirIndex {
+    /** The generation of the DirContents the positions are valid for. */
+    uint64_t generation{0};
+    std::vector<std::pair<InodeNumber, size_t>> entries;
+  };
+
+  /**
+   * Returns the cached ReaddirIndex of entries if it's still valid, or builds
+   * it otherwise. Must be called with the contents_ lock held.
+   */
+  std::shared_ptr<const ReaddirIndex> getReaddirIndex(
+      const DirContents& entries,
+      bool rebuild = false);
+
   /**
    * createImpl() is a helper function for creating new children inodes.
    *
    * This is used by create(), symlink(), and mknod().
    */
   FileInodePtr createImpl(
-      folly::Synchronized<TreeInodeState>::LockedPtr contentsLock,
+      SynchronizedTreeInodeState::LockedPtr contentsLock,
       PathComponentPiece name,
       mode_t mode,
       folly::ByteRange fileContents,
@@ -714,7 +741,7 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
    * diff once all .gitignore data is loaded.
    */
   FOLLY_NODISCARD ImmediateFuture<folly::Unit> computeDiff(
-      folly::Synchronized<TreeInodeState>::LockedPtr contentsLock,
+      SynchronizedTreeInodeState::LockedPtr contentsLock,
       DiffContext* context,
       RelativePathPiece currentPath,
       std::vector<std::shared_ptr<const Tree>> trees,
@@ -848,7 +875,7 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
    * throw or call loadChildCleanUp despite exceptions.
    */
   std::pair<folly::SemiFuture<InodePtr>, LoadChildCleanUp> loadChild(
-      folly::Synchronized<TreeInodeState>::LockedPtr& contents,
+      SynchronizedTreeInodeState::LockedPtr& contents,
       PathComponentPiece name,
       const ObjectFetchContextPtr& context);
 
@@ -858,12 +885,24 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
    */
   void loadChildCleanUp(PathComponentPiece name, LoadChildCleanUp result);
 
-  folly::Synchronized<TreeInodeState> contents_;
+  SynchronizedTreeInodeState contents_;
 
   /**
    * Only prefetch blob metadata on the first readdir() of a loaded inode.
    */
   std::atomic<bool> prefetched_{false};
+
+  /**
+   * Directories below this size sort their entries on each readdir call
+   * rather than keeping a ReaddirIndex.
+   */
+  static constexpr size_t kMinCachedReaddirIndexSize = 1024;
+
+  /**
+   * Only set for large directories. Concurrent readdir calls, which only
+   * hold the contents_ read lock, may each replace it.
+   */
+  folly::atomic_shared_ptr<const ReaddirIndex> readdirIndex_;
 };
 
 /**
@@ -55,6 +55,30 @@ bool VirtualInode::isDirectory() const {
   return getDtype() == dtype_t::Dir;
 }
 
+std::optional<ObjectId> VirtualInode::getObjectId() const {
+  return std::visit(
+      [](auto&& arg) -> std::optional<ObjectId> {
+        using T = std::decay_t<decltype(arg)>;
+        if constexpr (std::is_same_v<T, InodePtr>) {
+          if (auto file = arg.asFilePtrOrNull()) {
+            return file->getBlobHash();
+          }
+          return arg.asTreePtr()->getContents().rlock()->treeHash;
+        } else if constexpr (std::is_same_v<
+                                 T,
+                                 UnmaterializedUnloadedBlobDirEntry>) {
+          return arg.getHash();
+        } else if constexpr (std::is_same_v<T, TreePtr>) {
+          return arg->getHash();
+        } else if constexpr (std::is_same_v<T, TreeEntry>) {
+          return arg.getHash();
+        } else {
+          static_assert(always_false_v<T>, "non-exhaustive visitor!");
+        }
+      },
+      variant_);
+}
+
 VirtualInode::ContainedType VirtualInode::testGetContainedType() const {
   return std::visit(
       [](auto&& arg) {
@@ -195,9 +219,26 @@ ImmediateFuture<EntryAttributes> VirtualInode::getEntryAttributes(
     RelativePathPiece path,
     ObjectStore* objectStore,
     const ObjectFetchContextPtr& fetchContext) const {
+  return getEntryAttributes(
+      requestedAttributes, path, objectStore, fetchContext, std::nullopt);
+}
+
+ImmediateFuture<EntryAttributes> VirtualInode::getEntryAttributes(
+    EntryAttributeFlags requestedAttributes,
+    RelativePathPiece path,
+    ObjectStore* objectStore,
+    const ObjectFetchContextPtr& fetchContext,
+    std::optional<folly::Try<BlobMetadata>> blobMetadata) const {
   std::optional<folly::Try<Hash20>> sha1;
   std::optional<folly::Try<uint64_t>> size;
   std::optional<folly::Try<TreeEntryType>> type;
+  std::optional<folly::Try<ObjectId>> objectId;
+  if (requestedAttributes.contains(ENTRY_ATTRIBUTE_OBJECT_ID)) {
+    auto id = getObjectId();
+    objectId = id ? folly::Try<ObjectId>{std::move(*id)}
+                  : folly::Try<ObjectId>{
+                        PathError{EINVAL, path, "file is materialized"}};
+  }
   // For non regular files we return errors for hashes and sizes.
   // We intentionally want to refuse to compute the SHA1 of symlinks.
   switch (getDtype()) {
@@ -211,7 +252,11 @@ ImmediateFuture<EntryAttributes> VirtualInode::getEntryAttributes(
       if (requestedAttributes.contains(ENTRY_ATTRIBUTE_TYPE)) {
         type = folly::Try<TreeEntryType>{TreeEntryType::TREE};
       }
-      return EntryAttributes{std::move(sha1), std::move(size), std::move(type)};
+      return EntryAttributes{
+          std::move(sha1),
+          std::move(size),
+          std::move(type),
+          std::move(objectId)};
     case dtype_t::Symlink:
       if (requestedAttributes.contains(ENTRY_ATTRIBUTE_SHA1)) {
         sha1 = folly::Try<Hash20>{PathError(EINVAL, path, "file is a symlink")};
@@ -223,7 +268,11 @@ ImmediateFuture<EntryAttributes> VirtualInode::getEntryAttributes(
       if (requestedAttributes.contains(ENTRY_ATTRIBUTE_TYPE)) {
         type = folly::Try<TreeEntryType>{TreeEntryType::SYMLINK};
       }
-      return EntryAttributes{std::move(sha1), std::move(size), std::move(type)};
+      return EntryAttributes{
+          std::move(sha1),
+          std::move(size),
+          std::move(type),
+          std::move(objectId)};
     case dtype_t::Regular:
       break;
     default:
@@ -244,12 +293,14 @@ ImmediateFuture<EntryAttributes> VirtualInode::getEntryAttributes(
   // sha1 and size come together so, there isn't much point of splitting them up
   if (requestedAttributes.containsAnyOf(
           ENTRY_ATTRIBUTE_SIZE | ENTRY_ATTRIBUTE_SHA1)) {
-    blobMetadataFuture = getBlobMetadata(path, objectStore, fetchContext);
+    blobMetadataFuture = blobMetadata
+        ? ImmediateFuture<BlobMetadata>{std::move(*blobMetadata)}
+        : getBlobMetadata(path, objectStore, fetchContext);
   }
 
   return collectAll(std::move(entryTypeFuture), std::move(blobMetadataFuture))
       .thenValue(
-          [requestedAttributes](
+          [requestedAttributes, objectId = std::move(objectId)](
               std::tuple<folly::Try<TreeEntryType>, folly::Try<BlobMetadata>>
                   rawAttributeData) mutable -> EntryAttributes {
             std::optional<folly::Try<Hash20>> sha1;
@@ -273,7 +324,10 @@ ImmediateFuture<EntryAttributes> VirtualInode::getEntryAttributes(
                   : folly::Try<uint64_t>(blobMetadata.value().size);
             }
             return EntryAttributes{
-                std::move(sha1), std::move(size), std::move(type)};
+                std::move(sha1),
+                std::move(size),
+                std::move(type),
+                std::move(objectId)};
           });
 }
 
@@ -429,6 +483,92 @@ VirtualInode::getChildren(
       variant_);
 }
 
+ImmediateFuture<
+    std::vector<std::pair<RelativePath, folly::Try<EntryAttributes>>>>
+VirtualInode::getEntryAttributesBatch(
+    std::vector<std::pair<RelativePath, folly::Try<VirtualInode>>> entries,
+    EntryAttributeFlags requestedAttributes,
+    ObjectStore* objectStore,
+    const ObjectFetchContextPtr& fetchContext) {
+  // Loaded files are left to their inode, which knows whether they are
+  // materialized.
+  std::vector<ObjectId> blobIds;
+  std::vector<size_t> blobIndices;
+  if (requestedAttributes.containsAnyOf(
+          ENTRY_ATTRIBUTE_SIZE | ENTRY_ATTRIBUTE_SHA1)) {
+    for (size_t i = 0; i < entries.size(); ++i) {
+      const auto& inode = entries[i].second;
+      if (inode.hasValue() &&
+          !std::holds_alternative<InodePtr>(inode->variant_) &&
+          inode->getDtype() == dtype_t::Regular) {
+        blobIds.push_back(inode->getObjectId().value());
+        blobIndices.push_back(i);
+      }
+    }
+  }
+  auto batchFuture = blobIds.empty()
+      ? ImmediateFuture<std::vector<folly::Try<BlobMetadata>>>{
+            std::vector<folly::Try<BlobMetadata>>{}}
+      : objectStore->getBlobMetadataBatch(blobIds, fetchContext);
+
+  return std::move(batchFuture)
+      .thenTry([entries = std::move(entries),
+                blobIndices = std::move(blobIndices),
+                requestedAttributes,
+                objectStore,
+                fetchContext = fetchContext.copy()](
+                   folly::Try<std::vector<folly::Try<BlobMetadata>>>&&
+                       batch) mutable {
+        // If the batch failed as a whole, each file looks its metadata up on
+        // its own.
+        std::vector<std::optional<folly::Try<BlobMetadata>>> blobMetadata(
+            entries.size());
+        if (batch.hasValue()) {
+          XDCHECK_EQ(batch->size(), blobIndices.size());
+          for (size_t i = 0; i < blobIndices.size(); ++i) {
+            blobMetadata[blobIndices[i]] = std::move((*batch)[i]);
+          }
+        }
+
+        // Only the paths are kept until all the attributes are known, the
+        // entries themselves, and the trees they hold, are released now.
+        std::vector<RelativePath> paths;
+        std::vector<ImmediateFuture<EntryAttributes>> futures;
+        paths.reserve(entries.size());
+        futures.reserve(entries.size());
+        for (size_t i = 0; i < entries.size(); ++i) {
+          auto& [path, inode] = entries[i];
+          if (inode.hasException()) {
+            futures.emplace_back(
+                folly::Try<EntryAttributes>{std::move(inode).exception()});
+          } else {
+            futures.push_back(inode->getEntryAttributes(
+                requestedAttributes,
+                path,
+                objectStore,
+                fetchContext,
+                std::move(blobMetadata[i])));
+          }
+          paths.push_back(std::move(path));
+        }
+        entries.clear();
+        return collectAll(std::move(futures))
+            .thenValue([paths = std::move(paths)](
+                           std::vector<folly::Try<EntryAttributes>>&&
+                               attributes) mutable {
+              std::vector<
+                  std::pair<RelativePath, folly::Try<EntryAttributes>>>
+                  result;
+              result.reserve(attributes.size());
+              for (size_t i = 0; i < attributes.size(); ++i) {
+                result.emplace_back(
+                    std::move(paths[i]), std::move(attributes[i]));
+              }
+              return result;
+            });
+      });
+}
+
 ImmediateFuture<
     std::vector<std::pair<PathComponent, folly::Try<EntryAttributes>>>>
 VirtualInode::getChildrenAttributes(
@@ -444,42 +584,143 @@ VirtualInode::getChildrenAttributes(
         children.exception()};
   }
 
-  std::vector<PathComponent> names{};
-  std::vector<ImmediateFuture<EntryAttributes>> attributesFutures{};
+  std::vector<RelativePath> paths{};
+  std::vector<ImmediateFuture<VirtualInode>> childFutures{};
 
-  names.reserve(children.value().size());
-  attributesFutures.reserve(children.value().size());
+  paths.reserve(children.value().size());
+  childFutures.reserve(children.value().size());
 
   for (auto& nameAndvirtualInode : children.value()) {
-    names.push_back(nameAndvirtualInode.first);
-    attributesFutures.push_back(
-        std::move(nameAndvirtualInode.second)
-            .thenValue([requestedAttributes,
-                        subPath = path + nameAndvirtualInode.first,
-                        objectStore,
-                        fetchContext =
-                            fetchContext.copy()](VirtualInode virtualInode) {
-              return virtualInode.getEntryAttributes(
-                  requestedAttributes, subPath, objectStore, fetchContext);
-            }));
+    paths.push_back(path + nameAndvirtualInode.first);
+    childFutures.push_back(std::move(nameAndvirtualInode.second));
   }
-  return collectAll(std::move(attributesFutures))
+  return collectAll(std::move(childFutures))
+      .thenValue([paths = std::move(paths),
+                  requestedAttributes,
+                  objectStore,
+                  fetchContext = fetchContext.copy()](
+                     std::vector<folly::Try<VirtualInode>> inodes) mutable {
+        XDCHECK_EQ(inodes.size(), paths.size())
+            << "Missing/too many children for the names.";
+        std::vector<std::pair<RelativePath, folly::Try<VirtualInode>>> entries;
+        entries.reserve(inodes.size());
+        for (size_t i = 0; i < inodes.size(); ++i) {
+          entries.emplace_back(std::move(paths[i]), std::move(inodes[i]));
+        }
+        return getEntryAttributesBatch(
+            std::move(entries), requestedAttributes, objectStore, fetchContext);
+      })
       .thenValue(
-          [names = std::move(names)](
-              std::vector<folly::Try<EntryAttributes>> attributes) mutable {
+          [](std::vector<std::pair<RelativePath, folly::Try<EntryAttributes>>>
+                 attributes) {
             std::vector<std::pair<PathComponent, folly::Try<EntryAttributes>>>
                 zippedResult{};
             zippedResult.reserve(attributes.size());
-            XDCHECK_EQ(attributes.size(), names.size())
-                << "Missing/too many attributes for the names.";
-            for (uint32_t i = 0; i < attributes.size(); ++i) {
-              zippedResult.push_back(std::make_pair(
-                  std::move(names.at(i)), std::move(attributes.at(i))));
+            for (auto& [childPath, childAttributes] : attributes) {
+              zippedResult.emplace_back(
+                  childPath.basename(), std::move(childAttributes));
             }
             return zippedResult;
           });
 }
 
+namespace {
+using SubtreeEntries =
+    std::vector<std::pair<RelativePath, folly::Try<VirtualInode>>>;
+
+ImmediateFuture<SubtreeEntries> walkSubtree(
+    VirtualInode dir,
+    RelativePath path,
+    ObjectStore* objectStore,
+    const ObjectFetchContextPtr& fetchContext);
+
+/**
+ * Lists child, and everything below it if it is a directory.
+ */
+ImmediateFuture<SubtreeEntries> walkChild(
+    folly::Try<VirtualInode> child,
+    RelativePath path,
+    ObjectStore* objectStore,
+    const ObjectFetchContextPtr& fetchContext) {
+  std::optional<VirtualInode> dir;
+  if (child.hasValue() && child->isDirectory()) {
+    dir = *child;
+  }
+  SubtreeEntries entries;
+  entries.emplace_back(path, std::move(child));
+  if (!dir) {
+    return entries;
+  }
+  return walkSubtree(
+             std::move(*dir), std::move(path), objectStore, fetchContext)
+      .thenValue([entries = std::move(entries)](
+                     SubtreeEntries&& descendants) mutable {
+        entries.insert(
+            entries.end(),
+            std::make_move_iterator(descendants.begin()),
+            std::make_move_iterator(descendants.end()));
+        return std::move(entries);
+      });
+}
+
+/**
+ * Helper function for getSubtreeAttributes: lists every entry below dir,
+ * directories before their children.
+ */
+ImmediateFuture<SubtreeEntries> walkSubtree(
+    VirtualInode dir,
+    RelativePath path,
+    ObjectStore* objectStore,
+    const ObjectFetchContextPtr& fetchContext) {
+  auto children = dir.getChildren(path.piece(), objectStore, fetchContext);
+  if (children.hasException()) {
+    return ImmediateFuture<SubtreeEntries>{children.exception()};
+  }
+
+  std::vector<ImmediateFuture<SubtreeEntries>> futures;
+  futures.reserve(children.value().size());
+  for (auto& [name, childFuture] : children.value()) {
+    futures.push_back(std::move(childFuture)
+                          .thenTry([childPath = path + name,
+                                    objectStore,
+                                    &fetchContext](
+                                       folly::Try<VirtualInode>&& child) {
+                            return walkChild(
+                                std::move(child),
+                                std::move(childPath),
+                                objectStore,
+                                fetchContext);
+                          }));
+  }
+  return collectAllSafe(std::move(futures))
+      .thenValue([](std::vector<SubtreeEntries>&& subtrees) {
+        SubtreeEntries entries;
+        for (auto& subtree : subtrees) {
+          entries.insert(
+              entries.end(),
+              std::make_move_iterator(subtree.begin()),
+              std::make_move_iterator(subtree.end()));
+        }
+        return entries;
+      });
+}
+} // namespace
+
+ImmediateFuture<
+    std::vector<std::pair<RelativePath, folly::Try<EntryAttributes>>>>
+VirtualInode::getSubtreeAttributes(
+    EntryAttributeFlags requestedAttributes,
+    RelativePath path,
+    ObjectStore* objectStore,
+    const ObjectFetchContextPtr& fetchContext) {
+  return walkSubtree(*this, std::move(path), objectStore, fetchContext)
+      .thenValue([requestedAttributes, objectStore, &fetchContext](
+                     SubtreeEntries&& entries) {
+        return getEntryAttributesBatch(
+            std::move(entries), requestedAttributes, objectStore, fetchContext);
+      });
+}
+
 namespace {
 /**
  * Helper function for getOrFindChild when the current node is a Tree.
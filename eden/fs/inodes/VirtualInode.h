@@ -82,6 +82,12 @@ class VirtualInode {
 
   bool isDirectory() const;
 
+  /**
+   * The ID of the source control object this represents, if it isn't
+   * materialized.
+   */
+  std::optional<ObjectId> getObjectId() const;
+
   /**
    * Discover the contained data type.
    *
@@ -125,6 +131,7 @@ class VirtualInode {
    * - sha1
    * - size
    * - source control type
+   * - source control object ID
    *
    * Note that we return error values for sha1s and sizes of directories and
    * symlinks.
@@ -179,7 +186,50 @@ class VirtualInode {
       ObjectStore* objectStore,
       const ObjectFetchContextPtr& fetchContext);
 
+  /**
+   * Collect the attributes of every entry below this directory, paired with
+   * its path, which starts with path.
+   *
+   * The subtree is walked through its source control trees wherever it isn't
+   * loaded, without loading inodes, and the metadata of all its unloaded
+   * files is fetched with a single batched lookup rather than one lookup per
+   * file.
+   *
+   * fetchContext is used in the returned ImmediateFuture, it must have a
+   * lifetime longer than this future.
+   */
+  ImmediateFuture<
+      std::vector<std::pair<RelativePath, folly::Try<EntryAttributes>>>>
+  getSubtreeAttributes(
+      EntryAttributeFlags requestedAttributes,
+      RelativePath path,
+      ObjectStore* objectStore,
+      const ObjectFetchContextPtr& fetchContext);
+
  private:
+  /**
+   * Get the attributes of several entries, fetching the metadata of those
+   * that aren't loaded with one batched lookup.
+   */
+  static ImmediateFuture<
+      std::vector<std::pair<RelativePath, folly::Try<EntryAttributes>>>>
+  getEntryAttributesBatch(
+      std::vector<std::pair<RelativePath, folly::Try<VirtualInode>>> entries,
+      EntryAttributeFlags requestedAttributes,
+      ObjectStore* objectStore,
+      const ObjectFetchContextPtr& fetchContext);
+
+  /**
+   * getEntryAttributes, using blobMetadata as the metadata of this file when
+   * it was already fetched.
+   */
+  ImmediateFuture<EntryAttributes> getEntryAttributes(
+      EntryAttributeFlags requestedAttributes,
+      RelativePathPiece path,
+      ObjectStore* objectStore,
+      const ObjectFetchContextPtr& fetchContext,
+      std::optional<folly::Try<BlobMetadata>> blobMetadata) const;
+
   /**
    * Helper function for getChildrenAttributes
    */
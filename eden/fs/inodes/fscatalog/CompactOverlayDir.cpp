@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/fscatalog/CompactOverlayDir.h"
+
+#include <folly/Conv.h>
+#include <folly/lang/Bits.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace facebook::eden {
+
+namespace {
+
+constexpr uint8_t kAddRecord = 1;
+constexpr uint8_t kRemoveRecord = 2;
+
+template <typename T>
+T load(const uint8_t* data) {
+  return folly::Endian::little(folly::loadUnaligned<T>(data));
+}
+
+template <typename T>
+void append(std::string& out, T value) {
+  value = folly::Endian::little(value);
+  out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void appendString(std::string& out, folly::StringPiece value) {
+  append<uint32_t>(out, folly::to<uint32_t>(value.size()));
+  out.append(value.data(), value.size());
+}
+
+folly::StringPiece getHash(const overlay::OverlayEntry& entry) {
+  if (auto hash = entry.hash_ref()) {
+    return *hash;
+  }
+  return {};
+}
+
+/**
+ * Reads a length-prefixed string of a record at data, returning false if it
+ * is cut short.
+ */
+bool readString(folly::ByteRange& data, folly::StringPiece& value) {
+  if (data.size() < sizeof(uint32_t)) {
+    return false;
+  }
+  auto length = load<uint32_t>(data.data());
+  data.advance(sizeof(uint32_t));
+  if (data.size() < length) {
+    return false;
+  }
+  value = folly::StringPiece{folly::ByteRange{data.data(), length}};
+  data.advance(length);
+  return true;
+}
+
+} // namespace
+
+CompactOverlayDir::CompactOverlayDir(folly::ByteRange data) : data_{data} {
+  if (data.size() < kPrefixLength) {
+    throw std::invalid_argument(folly::to<std::string>(
+        "compact overlay directory too short: ", data.size(), " bytes"));
+  }
+  entryCount_ = load<uint32_t>(data.data());
+  poolSize_ = load<uint32_t>(data.data() + sizeof(uint32_t));
+  if (data.size() < getBaseSize()) {
+    throw std::invalid_argument(folly::to<std::string>(
+        "compact overlay directory of ",
+        entryCount_,
+        " entries and a ",
+        poolSize_,
+        " bytes pool truncated to ",
+        data.size(),
+        " bytes"));
+  }
+
+  for (size_t i = 0; i < entryCount_; ++i) {
+    auto* entry = entryData(i);
+    auto nameEnd = uint64_t{load<uint32_t>(entry)} + load<uint32_t>(entry + 4);
+    auto hashEnd =
+        uint64_t{load<uint32_t>(entry + 8)} + load<uint32_t>(entry + 12);
+    if (nameEnd > poolSize_ || hashEnd > poolSize_) {
+      throw std::invalid_argument(folly::to<std::string>(
+          "compact overlay directory entry ", i, " out of its pool"));
+    }
+  }
+}
+
+size_t CompactOverlayDir::getBaseSize() const {
+  return kPrefixLength + size_t{entryCount_} * kEntryLength + poolSize_;
+}
+
+size_t CompactOverlayDir::getBaseSize(folly::ByteRange prefix) {
+  if (prefix.size() < kPrefixLength) {
+    throw std::invalid_argument(folly::to<std::string>(
+        "compact overlay directory too short: ", prefix.size(), " bytes"));
+  }
+  return kPrefixLength + size_t{load<uint32_t>(prefix.data())} * kEntryLength +
+      load<uint32_t>(prefix.data() + sizeof(uint32_t));
+}
+
+const uint8_t* CompactOverlayDir::entryData(size_t index) const {
+  return data_.data() + kPrefixLength + index * kEntryLength;
+}
+
+CompactOverlayDir::Entry CompactOverlayDir::entry(size_t index) const {
+  auto* entry = entryData(index);
+  auto* pool =
+      data_.data() + kPrefixLength + size_t{entryCount_} * kEntryLength;
+  return Entry{
+      folly::StringPiece{folly::ByteRange{
+          pool + load<uint32_t>(entry), load<uint32_t>(entry + 4)}},
+      load<uint32_t>(entry + 16),
+      load<uint64_t>(entry + 24),
+      folly::ByteRange{
+          pool + load<uint32_t>(entry + 8), load<uint32_t>(entry + 12)}};
+}
+
+std::optional<CompactOverlayDir::Entry> CompactOverlayDir::find(
+    folly::StringPiece name) const {
+  size_t low = 0;
+  size_t high = entryCount_;
+  while (low < high) {
+    auto middle = low + (high - low) / 2;
+    auto candidate = entry(middle);
+    auto cmp = candidate.name.compare(name);
+    if (cmp == 0) {
+      return candidate;
+    } else if (cmp < 0) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return std::nullopt;
+}
+
+overlay::OverlayDir CompactOverlayDir::toOverlayDir(bool* truncated) const {
+  if (truncated) {
+    *truncated = false;
+  }
+  overlay::OverlayDir dir;
+  auto& entries = *dir.entries_ref();
+  for (size_t i = 0; i < entryCount_; ++i) {
+    auto e = entry(i);
+    overlay::OverlayEntry value;
+    value.mode_ref() = static_cast<int32_t>(e.mode);
+    value.inodeNumber_ref() = static_cast<int64_t>(e.inodeNumber);
+    if (!e.hash.empty()) {
+      value.hash_ref() = folly::StringPiece{e.hash}.str();
+    }
+    entries.emplace_hint(entries.end(), e.name.str(), std::move(value));
+  }
+
+  auto records = data_;
+  records.advance(getBaseSize());
+  while (!records.empty()) {
+    auto type = records.front();
+    records.advance(1);
+    folly::StringPiece name;
+    if (type == kRemoveRecord) {
+      if (!readString(records, name)) {
+        if (truncated) {
+          *truncated = true;
+        }
+        break;
+      }
+      entries.erase(name.str());
+    } else if (type == kAddRecord) {
+      if (records.size() < sizeof(uint32_t) + sizeof(uint64_t)) {
+        if (truncated) {
+          *truncated = true;
+        }
+        break;
+      }
+      overlay::OverlayEntry value;
+      value.mode_ref() = static_cast<int32_t>(load<uint32_t>(records.data()));
+      value.inodeNumber_ref() =
+          static_cast<int64_t>(load<uint64_t>(records.data() + 4));
+      records.advance(sizeof(uint32_t) + sizeof(uint64_t));
+      folly::StringPiece hash;
+      if (!readString(records, name) || !readString(records, hash)) {
+        if (truncated) {
+          *truncated = true;
+        }
+        break;
+      }
+      if (!hash.empty()) {
+        value.hash_ref() = hash.str();
+      }
+      entries.insert_or_assign(name.str(), std::move(value));
+    } else {
+      throw std::invalid_argument(folly::to<std::string>(
+          "unknown compact overlay directory record type ", int{type}));
+    }
+  }
+  return dir;
+}
+
+std::string CompactOverlayDir::serialize(const overlay::OverlayDir& dir) {
+  const auto& entries = *dir.entries_ref();
+  std::vector<decltype(&*entries.begin())> sorted;
+  sorted.reserve(entries.size());
+  size_t poolSize = 0;
+  for (const auto& entry : entries) {
+    sorted.push_back(&entry);
+    poolSize += entry.first.size() + getHash(entry.second).size();
+  }
+  std::sort(sorted.begin(), sorted.end(), [](const auto* a, const auto* b) {
+    return folly::StringPiece{a->first} < folly::StringPiece{b->first};
+  });
+
+  std::string out;
+  out.reserve(kPrefixLength + sorted.size() * kEntryLength + poolSize);
+  append<uint32_t>(out, folly::to<uint32_t>(sorted.size()));
+  append<uint32_t>(out, folly::to<uint32_t>(poolSize));
+  uint32_t offset = 0;
+  for (const auto* entry : sorted) {
+    auto hash = getHash(entry->second);
+    append<uint32_t>(out, offset);
+    append<uint32_t>(out, folly::to<uint32_t>(entry->first.size()));
+    append<uint32_t>(out, offset + folly::to<uint32_t>(entry->first.size()));
+    append<uint32_t>(out, folly::to<uint32_t>(hash.size()));
+    append<uint32_t>(out, static_cast<uint32_t>(*entry->second.mode_ref()));
+    append<uint32_t>(out, 0);
+    append<uint64_t>(
+        out, static_cast<uint64_t>(*entry->second.inodeNumber_ref()));
+    offset += entry->first.size() + hash.size();
+  }
+  for (const auto* entry : sorted) {
+    out.append(entry->first);
+    auto hash = getHash(entry->second);
+    out.append(hash.data(), hash.size());
+  }
+  return out;
+}
+
+std::string CompactOverlayDir::serializeAddRecord(
+    folly::StringPiece name,
+    const overlay::OverlayEntry& entry) {
+  std::string out;
+  out.push_back(static_cast<char>(kAddRecord));
+  append<uint32_t>(out, static_cast<uint32_t>(*entry.mode_ref()));
+  append<uint64_t>(out, static_cast<uint64_t>(*entry.inodeNumber_ref()));
+  appendString(out, name);
+  appendString(out, getHash(entry));
+  return out;
+}
+
+std::string CompactOverlayDir::serializeRemoveRecord(folly::StringPiece name) {
+  std::string out;
+  out.push_back(static_cast<char>(kRemoveRecord));
+  appendString(out, name);
+  return out;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "eden/fs/inodes/overlay/gen-cpp2/overlay_types.h"
+
+namespace facebook::eden {
+
+/**
+ * A read-only view of a directory encoded in the compact format used by the
+ * overlay files of FsInodeCatalog from version kCompactDirVersion on.
+ *
+ * The encoding, with all integers little-endian, is:
+ *
+ * - the number of entries and the size of the pool, as 32-bit integers;
+ * - the entries, sorted by name, 32 bytes each: the offset and length in the
+ *   pool of the name and of the hash, the mode and 4 reserved bytes as 32-bit
+ *   integers, and the inode number as a 64-bit integer;
+ * - the pool, holding the names and hashes;
+ * - records of the changes made since, appended one by one.
+ *
+ * A record is a byte for its type, followed for additions by the mode as a
+ * 32-bit integer and the inode number as a 64-bit integer, and then by the
+ * length of the name and the name, then for additions the length of the hash
+ * and the hash, the lengths being 32-bit integers. A record cut short, as
+ * left by a crash while appending it, is ignored.
+ *
+ * Looking up entries does not allocate nor copy the encoded data, which must
+ * outlive the view.
+ */
+class CompactOverlayDir {
+ public:
+  struct Entry {
+    folly::StringPiece name;
+    uint32_t mode;
+    uint64_t inodeNumber;
+    // Empty for materialized entries.
+    folly::ByteRange hash;
+  };
+
+  /**
+   * Parses the encoded directory, without its header. Throws
+   * std::invalid_argument if its entries and pool do not fit in data.
+   */
+  explicit CompactOverlayDir(folly::ByteRange data);
+
+  /**
+   * The number of entries, without the appended records.
+   */
+  size_t size() const {
+    return entryCount_;
+  }
+
+  Entry entry(size_t index) const;
+
+  /**
+   * Looks up an entry by name with a binary search, ignoring the appended
+   * records.
+   */
+  std::optional<Entry> find(folly::StringPiece name) const;
+
+  /**
+   * The number of bytes of the entries and the pool, which records follow.
+   */
+  size_t getBaseSize() const;
+
+  /**
+   * Decodes the directory, with the changes of the appended records. If
+   * truncated is given, it is set to whether the last record was cut short.
+   */
+  overlay::OverlayDir toOverlayDir(bool* truncated = nullptr) const;
+
+  static std::string serialize(const overlay::OverlayDir& dir);
+
+  static std::string serializeAddRecord(
+      folly::StringPiece name,
+      const overlay::OverlayEntry& entry);
+
+  static std::string serializeRemoveRecord(folly::StringPiece name);
+
+  /**
+   * Returns the base size of an encoded directory from its first
+   * kPrefixLength bytes, without parsing the rest.
+   */
+  static size_t getBaseSize(folly::ByteRange prefix);
+
+  static constexpr size_t kPrefixLength = 8;
+  static constexpr size_t kEntryLength = 32;
+
+ private:
+  const uint8_t* entryData(size_t index) const;
+
+  folly::ByteRange data_;
+  uint32_t entryCount_;
+  uint32_t poolSize_;
+};
+
+} // namespace facebook::eden
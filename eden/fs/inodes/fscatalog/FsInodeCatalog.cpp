@@ -13,6 +13,7 @@
 #include <algorithm>
 #include <chrono>
 
+#include <folly/Conv.h>
 #include <folly/Exception.h>
 #include <folly/File.h>
 #include <folly/FileUtil.h>
@@ -23,13 +24,21 @@
 #include <folly/logging/xlog.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
 
+#include "eden/fs/inodes/fscatalog/CompactOverlayDir.h"
 #include "eden/fs/inodes/fscatalog/InodePath.h"
+#include "eden/fs/model/ObjectId.h"
 #include "eden/fs/service/gen-cpp2/eden_types.h"
 #include "eden/fs/utils/EdenError.h"
 #include "eden/fs/utils/FileUtils.h"
+#include "eden/fs/utils/IoUring.h"
 #include "eden/fs/utils/PathFuncs.h"
 #include "eden/fs/utils/Throw.h"
 
+#ifdef __linux__
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+
 namespace facebook::eden {
 
 using apache::thrift::CompactSerializer;
@@ -66,9 +75,35 @@ constexpr uint32_t kOverlayVersion = 1;
 constexpr size_t kInfoHeaderSize =
     kInfoHeaderMagic.size() + sizeof(kOverlayVersion);
 
+/**
+ * The size up to which the records appended to a directory file may grow,
+ * even if it is larger than its entries, before it is written out again.
+ */
+constexpr size_t kMinOverlayDirRecordsSize = 4096;
+
+/**
+ * How many unlinks removeOverlayFiles() submits to io_uring at once.
+ */
+constexpr uint32_t kIoUringEntries = 256;
+
+/**
+ * Files materialized from a blob are cloned into this directory, named after
+ * the blob, so that the later materializations of the blob share their data.
+ * It is emptied whenever the overlay is opened, and holds at most
+ * kMaxBlobCacheEntries files.
+ */
+constexpr const char* kBlobCacheDir{"blobs"};
+constexpr size_t kMaxBlobCacheEntries = 100000;
+/**
+ * Blobs whose hex ids are longer than this, leaving room for the suffix of
+ * the temporary files, are not cached.
+ */
+constexpr size_t kMaxBlobCacheNameLength = 200;
+
 constexpr folly::StringPiece FileContentStore::kHeaderIdentifierDir;
 constexpr folly::StringPiece FileContentStore::kHeaderIdentifierFile;
 constexpr uint32_t FileContentStore::kHeaderVersion;
+constexpr uint32_t FileContentStore::kCompactDirVersion;
 constexpr size_t FileContentStore::kHeaderLength;
 constexpr uint32_t FileContentStore::kNumShards;
 
@@ -98,6 +133,11 @@ void FileContentStore::formatSubdirShardPath(
   return doFormatSubdirPath(shardID, subdirPath);
 }
 
+FileContentStore::FileContentStore(AbsolutePathPiece localDir, bool useIoUring)
+    : localDir_{localDir}, useIoUring_{useIoUring} {}
+
+FileContentStore::~FileContentStore() = default;
+
 bool FileContentStore::initialize(bool createIfNonExisting) {
   // Read the info file.
   auto infoPath = localDir_ + PathComponentPiece{kInfoFile};
@@ -138,6 +178,12 @@ bool FileContentStore::initialize(bool createIfNonExisting) {
       dirFd, "error opening overlay directory handle for ", localDir_.value());
   dirFile_ = File{dirFd, /* ownsFd */ true};
 
+  if (useIoUring_) {
+    ioUring_ = IoUring::tryCreate(kIoUringEntries);
+  }
+
+  resetBlobCache();
+
   return overlayCreated;
 }
 
@@ -306,12 +352,24 @@ void FileContentStore::initNewOverlay() {
 
 optional<overlay::OverlayDir> FsInodeCatalog::loadOverlayDir(
     InodeNumber inodeNumber) {
-  return core_->deserializeOverlayDir(inodeNumber);
+  bool needsRewrite = false;
+  auto dir = core_->deserializeOverlayDir(inodeNumber, &needsRewrite);
+  if (dir && needsRewrite) {
+    // Migrate directories from the thrift format as they are read, and drop
+    // a record cut short by a crash before appending others after it.
+    try {
+      core_->serializeOverlayDir(inodeNumber, *dir);
+    } catch (const std::exception& ex) {
+      XLOG(WARN) << "failed to rewrite overlay data for inode " << inodeNumber
+                 << ": " << ex.what();
+    }
+  }
+  return dir;
 }
 
 std::optional<overlay::OverlayDir> FsInodeCatalog::loadAndRemoveOverlayDir(
     InodeNumber inodeNumber) {
-  auto result = loadOverlayDir(inodeNumber);
+  auto result = core_->deserializeOverlayDir(inodeNumber);
   removeOverlayDir(inodeNumber);
   return result;
 }
@@ -319,19 +377,153 @@ std::optional<overlay::OverlayDir> FsInodeCatalog::loadAndRemoveOverlayDir(
 void FsInodeCatalog::saveOverlayDir(
     InodeNumber inodeNumber,
     overlay::OverlayDir&& odir) {
-  // Ask thrift to serialize it.
-  auto serializedData = CompactSerializer::serialize<std::string>(odir);
+  core_->serializeOverlayDir(inodeNumber, odir);
+}
+
+void FileContentStore::serializeOverlayDir(
+    InodeNumber inodeNumber,
+    const overlay::OverlayDir& odir) {
+  auto serializedData = CompactOverlayDir::serialize(odir);
 
   // Add header to the overlay directory.
-  auto header = FileContentStore::createHeader(
-      FileContentStore::kHeaderIdentifierDir, FileContentStore::kHeaderVersion);
+  auto header = createHeader(kHeaderIdentifierDir, kCompactDirVersion);
 
   std::array<struct iovec, 2> iov;
   iov[0].iov_base = header.data();
   iov[0].iov_len = header.size();
   iov[1].iov_base = const_cast<char*>(serializedData.data());
   iov[1].iov_len = serializedData.size();
-  (void)core_->createOverlayFileImpl(inodeNumber, iov.data(), iov.size());
+  (void)createOverlayFileImpl(inodeNumber, iov.data(), iov.size());
+}
+
+bool FileContentStore::appendOverlayDirRecord(
+    InodeNumber inodeNumber,
+    folly::ByteRange record) {
+  auto path = getFilePath(inodeNumber);
+  int fd = openat(
+      dirFile_.fd(), path.c_str(), O_RDWR | O_APPEND | O_CLOEXEC | O_NOFOLLOW);
+  if (fd == -1) {
+    if (errno == ENOENT) {
+      return false;
+    }
+    folly::throwSystemError(
+        "error opening overlay file for inode ",
+        inodeNumber,
+        " in ",
+        localDir_.view());
+  }
+  folly::File file{fd, /* ownsFd */ true};
+
+  std::array<char, kHeaderLength + CompactOverlayDir::kPrefixLength> prefix;
+  auto bytesRead = folly::preadFull(fd, prefix.data(), prefix.size(), 0);
+  folly::checkUnixError(
+      bytesRead,
+      "error reading overlay file for inode ",
+      inodeNumber,
+      " in ",
+      localDir_.view());
+  if (static_cast<size_t>(bytesRead) != prefix.size()) {
+    return false;
+  }
+  StringPiece contents{prefix.data(), prefix.size()};
+  auto version = validateHeader(
+      inodeNumber, contents, kHeaderIdentifierDir, kCompactDirVersion);
+  if (version != kCompactDirVersion) {
+    return false;
+  }
+  contents.advance(kHeaderLength);
+  auto baseSize =
+      kHeaderLength + CompactOverlayDir::getBaseSize(ByteRange{contents});
+
+  struct stat st;
+  folly::checkUnixError(
+      fstat(fd, &st),
+      "error getting the size of overlay file for inode ",
+      inodeNumber,
+      " in ",
+      localDir_.view());
+  auto size = static_cast<size_t>(st.st_size);
+  if (size < baseSize ||
+      size - baseSize + record.size() >
+          std::max(baseSize, kMinOverlayDirRecordsSize)) {
+    return false;
+  }
+
+  auto bytesWritten = folly::writeFull(fd, record.data(), record.size());
+  folly::checkUnixError(
+      bytesWritten,
+      "error appending to overlay file for inode ",
+      inodeNumber,
+      " in ",
+      localDir_.view());
+  return true;
+}
+
+void FsInodeCatalog::updateOverlayDir(
+    InodeNumber inodeNumber,
+    const std::string& record,
+    folly::FunctionRef<void(overlay::OverlayDir&)> change) {
+  if (core_->appendOverlayDirRecord(
+          inodeNumber, ByteRange{StringPiece{record}})) {
+    return;
+  }
+  auto dir = core_->deserializeOverlayDir(inodeNumber)
+                 .value_or(overlay::OverlayDir{});
+  change(dir);
+  core_->serializeOverlayDir(inodeNumber, dir);
+}
+
+void FsInodeCatalog::addChild(
+    InodeNumber parent,
+    PathComponentPiece name,
+    overlay::OverlayEntry entry) {
+  updateOverlayDir(
+      parent,
+      CompactOverlayDir::serializeAddRecord(name.view(), entry),
+      [&](overlay::OverlayDir& dir) {
+        dir.entries_ref()->insert_or_assign(std::string{name.view()}, entry);
+      });
+}
+
+void FsInodeCatalog::removeChild(
+    InodeNumber parent,
+    PathComponentPiece childName) {
+  updateOverlayDir(
+      parent,
+      CompactOverlayDir::serializeRemoveRecord(childName.view()),
+      [&](overlay::OverlayDir& dir) {
+        dir.entries_ref()->erase(std::string{childName.view()});
+      });
+}
+
+bool FsInodeCatalog::hasChild(
+    InodeNumber parent,
+    PathComponentPiece childName) {
+  auto dir = core_->deserializeOverlayDir(parent);
+  return dir &&
+      dir->entries_ref()->count(std::string{childName.view()}) != 0;
+}
+
+void FsInodeCatalog::renameChild(
+    InodeNumber src,
+    InodeNumber dst,
+    PathComponentPiece srcName,
+    PathComponentPiece dstName) {
+  auto srcDir = core_->deserializeOverlayDir(src);
+  if (!srcDir) {
+    return;
+  }
+  auto it = srcDir->entries_ref()->find(std::string{srcName.view()});
+  if (it == srcDir->entries_ref()->end()) {
+    return;
+  }
+  auto entry = it->second;
+  // The destination entry is written first, so that a crash in between
+  // leaves the child in both directories rather than in neither.
+  addChild(dst, dstName, entry);
+  if (src != dst || srcName != dstName) {
+    removeChild(src, srcName);
+  }
 }
 
 InodePath FileContentStore::getFilePath(InodeNumber inodeNumber) {
@@ -358,7 +550,8 @@ AbsolutePath FileContentStore::getAbsoluteFilePath(
 }
 
 std::optional<overlay::OverlayDir> FileContentStore::deserializeOverlayDir(
-    InodeNumber inodeNumber) {
+    InodeNumber inodeNumber,
+    bool* needsRewrite) {
   // Open the file.  Return std::nullopt if the file does not exist.
   auto path = FileContentStore::getFilePath(inodeNumber);
   int fd = openat(dirFile_.fd(), path.c_str(), O_RDWR | O_CLOEXEC | O_NOFOLLOW);
@@ -390,10 +583,19 @@ std::optional<overlay::OverlayDir> FileContentStore::deserializeOverlayDir(
   }
 
   StringPiece contents{serializedData};
-  FileContentStore::validateHeader(
-      inodeNumber, contents, FileContentStore::kHeaderIdentifierDir);
+  auto version = FileContentStore::validateHeader(
+      inodeNumber,
+      contents,
+      FileContentStore::kHeaderIdentifierDir,
+      kCompactDirVersion);
   contents.advance(FileContentStore::kHeaderLength);
 
+  if (version == kCompactDirVersion) {
+    return CompactOverlayDir{ByteRange{contents}}.toOverlayDir(needsRewrite);
+  }
+  if (needsRewrite) {
+    *needsRewrite = true;
+  }
   return CompactSerializer::deserialize<overlay::OverlayDir>(contents);
 }
 
@@ -482,7 +684,8 @@ InodeTmpPath getFileTmpPath(InodeNumber inodeNumber) {
 folly::File FileContentStore::createOverlayFileImpl(
     InodeNumber inodeNumber,
     iovec* iov,
-    size_t iovCount) {
+    size_t iovCount,
+    int cloneFromFd) {
   // We do not use mkstemp() to create the temporary file, since there is no
   // mkstempat() equivalent that can create files relative to dirFile.  We
   // simply create the file with a fixed suffix, and do not use O_EXCL.  This
@@ -517,13 +720,15 @@ folly::File FileContentStore::createOverlayFileImpl(
     }
   };
 
-  auto sizeWritten = folly::writevFull(tmpFD, iov, iovCount);
-  folly::checkUnixError(
-      sizeWritten,
-      "error writing to overlay file for inode ",
-      inodeNumber,
-      " in ",
-      localDir_.view());
+  if (cloneFromFd == -1 || !tryCloneFile(tmpFD, cloneFromFd)) {
+    auto sizeWritten = folly::writevFull(tmpFD, iov, iovCount);
+    folly::checkUnixError(
+        sizeWritten,
+        "error writing to overlay file for inode ",
+        inodeNumber,
+        " in ",
+        localDir_.view());
+  }
 
   // fdatasync() is required to ensure that we are really reliably and
   // atomically writing out the new file.  Without calling fdatasync() the file
@@ -600,10 +805,120 @@ folly::File FileContentStore::createOverlayFile(
   return createOverlayFileImpl(inodeNumber, iov.data(), iov.size());
 }
 
-void FileContentStore::validateHeader(
+folly::File FileContentStore::createOverlayFileForBlob(
+    InodeNumber inodeNumber,
+    const ObjectId& blobId,
+    const IOBuf& contents) {
+  if (reflinkUnsupported_.load(std::memory_order_relaxed)) {
+    return createOverlayFile(inodeNumber, contents);
+  }
+  auto name = blobId.asHexString();
+  if (name.empty() || name.size() > kMaxBlobCacheNameLength) {
+    return createOverlayFile(inodeNumber, contents);
+  }
+  auto cachePath = folly::to<std::string>(kBlobCacheDir, "/", name);
+
+  auto header = createHeader(kHeaderIdentifierFile, kHeaderVersion);
+  fbvector<struct iovec> iov;
+  iov.resize(1);
+  iov[0].iov_base = header.data();
+  iov[0].iov_len = header.size();
+  contents.appendToIov(&iov);
+
+  // Every overlay file starts with the same header, so a cached file of the
+  // blob is a complete overlay file for it. Its size is checked in case it
+  // was left incomplete.
+  int cacheFd = openat(
+      dirFile_.fd(), cachePath.c_str(), O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+  if (cacheFd != -1) {
+    File cacheFile{cacheFd, /* ownsFd */ true};
+    struct stat st;
+    if (fstat(cacheFd, &st) == 0 &&
+        static_cast<uint64_t>(st.st_size) ==
+            kHeaderLength + contents.computeChainDataLength()) {
+      return createOverlayFileImpl(
+          inodeNumber, iov.data(), iov.size(), cacheFd);
+    }
+  }
+
+  auto file = createOverlayFileImpl(inodeNumber, iov.data(), iov.size());
+  addToBlobCache(cachePath, inodeNumber, file.fd());
+  return file;
+}
+
+bool FileContentStore::tryCloneFile(int destFd, int srcFd) {
+#ifdef __linux__
+  if (ioctl(destFd, FICLONE, srcFd) == 0) {
+    return true;
+  }
+  auto err = errno;
+  if (err == EOPNOTSUPP || err == EXDEV || err == EINVAL || err == ENOTTY) {
+    if (!reflinkUnsupported_.exchange(true, std::memory_order_relaxed)) {
+      XLOG(DBG2) << "overlay in " << localDir_
+                 << " does not support reflinks: " << folly::errnoStr(err);
+    }
+  } else {
+    XLOG(WARN) << "failed to clone overlay file in " << localDir_ << ": "
+               << folly::errnoStr(err);
+  }
+#else
+  (void)destFd;
+  (void)srcFd;
+  reflinkUnsupported_.store(true, std::memory_order_relaxed);
+#endif
+  return false;
+}
+
+void FileContentStore::resetBlobCache() {
+  auto cacheDir = localDir_ + PathComponentPiece{kBlobCacheDir};
+  boost::system::error_code ec;
+  boost::filesystem::remove_all(cacheDir.asString(), ec);
+  if (ec || (::mkdirat(dirFile_.fd(), kBlobCacheDir, 0700) != 0)) {
+    XLOG(WARN) << "failed to reset the overlay blob cache in " << cacheDir
+               << ", files will not share their data: "
+               << (ec ? ec.message() : folly::errnoStr(errno));
+    reflinkUnsupported_.store(true, std::memory_order_relaxed);
+  }
+  blobCacheEntries_.store(0, std::memory_order_relaxed);
+}
+
+void FileContentStore::addToBlobCache(
+    const std::string& cachePath,
+    InodeNumber inodeNumber,
+    int fd) {
+  if (blobCacheEntries_.load(std::memory_order_relaxed) >=
+      kMaxBlobCacheEntries) {
+    return;
+  }
+
+  // Like overlay files, cached files are written under a temporary name and
+  // renamed into place. Concurrent materializations of the same blob may
+  // both add it, which is harmless since the files are identical.
+  auto tmpPath = folly::to<std::string>(cachePath, ".", inodeNumber.get());
+  int tmpFd = openat(
+      dirFile_.fd(),
+      tmpPath.c_str(),
+      O_CREAT | O_WRONLY | O_CLOEXEC | O_NOFOLLOW | O_TRUNC,
+      0600);
+  if (tmpFd == -1) {
+    return;
+  }
+  File tmpFile{tmpFd, /* ownsFd */ true};
+  if (!tryCloneFile(tmpFd, fd) ||
+      renameat(
+          dirFile_.fd(), tmpPath.c_str(), dirFile_.fd(), cachePath.c_str()) !=
+          0) {
+    unlinkat(dirFile_.fd(), tmpPath.c_str(), 0);
+    return;
+  }
+  blobCacheEntries_.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint32_t FileContentStore::validateHeader(
     InodeNumber inodeNumber,
     folly::StringPiece contents,
-    folly::StringPiece headerId) {
+    folly::StringPiece headerId,
+    uint32_t maxVersion) {
   if (contents.size() < kHeaderLength) {
     // Something wrong with the file (may be corrupted)
     throw newEdenError(
@@ -633,13 +948,14 @@ void FileContentStore::validateHeader(
 
   // Validate header version
   auto version = cursor.readBE<uint32_t>();
-  if (version != kHeaderVersion) {
+  if (version < kHeaderVersion || version > maxVersion) {
     throw newEdenError(
         EINVAL,
         EdenErrorType::POSIX_ERROR,
         "Unexpected overlay version :",
         version);
   }
+  return version;
 }
 
 void FileContentStore::removeOverlayFile(InodeNumber inodeNumber) {
@@ -653,6 +969,54 @@ void FileContentStore::removeOverlayFile(InodeNumber inodeNumber) {
   }
 }
 
+void FileContentStore::removeOverlayFiles(
+    folly::Range<const InodeNumber*> inodes) {
+  if (!ioUring_) {
+    IFileContentStore::removeOverlayFiles(inodes);
+    return;
+  }
+
+  std::vector<InodePath> paths;
+  std::vector<IoUring::Op> ops;
+  paths.reserve(inodes.size());
+  ops.reserve(inodes.size());
+  for (auto inodeNumber : inodes) {
+    paths.push_back(getFilePath(inodeNumber));
+    ops.push_back(IoUring::Op::unlinkAt(dirFile_.fd(), paths.back().c_str()));
+  }
+
+  std::vector<int> results;
+  {
+    std::lock_guard<std::mutex> lock{ioUringMutex_};
+    results = ioUring_->submitAndWait(ops);
+  }
+
+  std::exception_ptr firstError;
+  for (size_t i = 0; i < inodes.size(); ++i) {
+    int result = results[i];
+    if (result == -EINVAL) {
+      // The kernel does not support IORING_OP_UNLINKAT.
+      try {
+        removeOverlayFile(inodes[i]);
+      } catch (const std::exception&) {
+        if (!firstError) {
+          firstError = std::current_exception();
+        }
+      }
+    } else if (result == 0) {
+      XLOG(DBG4) << "removed overlay data for inode " << inodes[i];
+    } else if (result != -ENOENT && !firstError) {
+      firstError = std::make_exception_ptr(folly::makeSystemErrorExplicit(
+          -result,
+          "error unlinking overlay file: ",
+          RelativePathPiece{paths[i]}.view()));
+    }
+  }
+  if (firstError) {
+    std::rethrow_exception(firstError);
+  }
+}
+
 void FsInodeCatalog::removeOverlayDir(InodeNumber inodeNumber) {
   core_->removeOverlayFile(inodeNumber);
 }
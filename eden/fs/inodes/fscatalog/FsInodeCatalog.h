@@ -8,11 +8,16 @@
 #pragma once
 
 #include <folly/File.h>
+#include <folly/Function.h>
 #include <folly/Range.h>
 #include <gtest/gtest_prod.h>
 #include <array>
+#include <atomic>
 #include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <optional>
+#include <string>
 #include "eden/fs/inodes/IFileContentStore.h"
 #include "eden/fs/inodes/InodeCatalog.h"
 #include "eden/fs/inodes/InodeNumber.h"
@@ -32,13 +37,23 @@ namespace overlay {
 class OverlayDir;
 }
 class InodePath;
+class IoUring;
 
 /**
  * Class to manage the on disk data.
  */
 class FileContentStore : public IFileContentStore {
  public:
-  explicit FileContentStore(AbsolutePathPiece localDir) : localDir_{localDir} {}
+  /**
+   * If useIoUring is set and the kernel supports it, removeOverlayFiles()
+   * unlinks its files with a single io_uring submission per batch instead of
+   * one unlinkat(2) call per file.
+   */
+  explicit FileContentStore(
+      AbsolutePathPiece localDir,
+      bool useIoUring = false);
+
+  ~FileContentStore() override;
 
   /**
    * Initialize the FileContentStore, acquire the "info" file lock and load the
@@ -91,11 +106,32 @@ class FileContentStore : public IFileContentStore {
       InodeNumber inodeNumber,
       const folly::IOBuf& contents) override;
 
+  /**
+   * Creates the overlay file of a FileInode materialized from a blob.
+   *
+   * On filesystems supporting reflinks, the file is cloned from a previous
+   * materialization of the same blob when there is one, sharing its data on
+   * disk instead of writing out the contents again.
+   */
+  folly::File createOverlayFileForBlob(
+      InodeNumber inodeNumber,
+      const ObjectId& blobId,
+      const folly::IOBuf& contents) override;
+
   /**
    * Remove the overlay directory data associated with the passed InodeNumber.
    */
   void removeOverlayFile(InodeNumber inodeNumber) override;
 
+  void removeOverlayFiles(folly::Range<const InodeNumber*> inodes) override;
+
+  /**
+   * Whether removeOverlayFiles() goes through io_uring.
+   */
+  bool isUsingIoUring() const {
+    return ioUring_ != nullptr;
+  }
+
   /**
    * Helper function that opens an existing overlay file,
    * checks if the file has valid header, and returns the file.
@@ -161,6 +197,11 @@ class FileContentStore : public IFileContentStore {
   static constexpr folly::StringPiece kHeaderIdentifierDir{"OVDR"};
   static constexpr folly::StringPiece kHeaderIdentifierFile{"OVFL"};
   static constexpr uint32_t kHeaderVersion = 1;
+  /**
+   * The version of the directory files encoded as a CompactOverlayDir.
+   * Directories are read in both formats, and rewritten in this one.
+   */
+  static constexpr uint32_t kCompactDirVersion = 2;
   static constexpr size_t kHeaderLength = 64;
   static constexpr uint32_t kNumShards = 256;
   static constexpr size_t kShardDirPathLength = 2;
@@ -202,12 +243,14 @@ class FileContentStore : public IFileContentStore {
       uint32_t version);
 
   /**
-   * Validates an entry's header.
+   * Validates an entry's header, whose version must be between
+   * kHeaderVersion and maxVersion, and returns its version.
    */
-  static void validateHeader(
+  static uint32_t validateHeader(
       InodeNumber inodeNumber,
       folly::StringPiece contents,
-      folly::StringPiece headerId);
+      folly::StringPiece headerId,
+      uint32_t maxVersion = kHeaderVersion);
 
   /**
    * Get the path to the file for the given inode, relative to localDir.
@@ -216,11 +259,56 @@ class FileContentStore : public IFileContentStore {
    */
   static InodePath getFilePath(InodeNumber inodeNumber);
 
+  /**
+   * Loads the directory data of the given inode. If needsRewrite is given,
+   * it is set to whether the data should be written again: it is in the
+   * thrift format of kHeaderVersion, or its last record was cut short.
+   */
   std::optional<overlay::OverlayDir> deserializeOverlayDir(
-      InodeNumber inodeNumber);
+      InodeNumber inodeNumber,
+      bool* needsRewrite = nullptr);
+
+  void serializeOverlayDir(
+      InodeNumber inodeNumber,
+      const overlay::OverlayDir& odir);
 
-  folly::File
-  createOverlayFileImpl(InodeNumber inodeNumber, iovec* iov, size_t iovCount);
+  /**
+   * Appends a record to the directory file of the given inode, unless it is
+   * missing, in the thrift format, or its records have grown as large as its
+   * entries, in which case it returns false and the directory should be
+   * written out in full.
+   */
+  bool appendOverlayDirRecord(InodeNumber inodeNumber, folly::ByteRange record);
+
+  /**
+   * Writes out a new overlay file. If cloneFromFd is not -1, the file is
+   * first cloned from it, and only written out if that fails.
+   */
+  folly::File createOverlayFileImpl(
+      InodeNumber inodeNumber,
+      iovec* iov,
+      size_t iovCount,
+      int cloneFromFd = -1);
+
+  /**
+   * Clones the data of srcFd into the empty file destFd, returning false if
+   * the filesystem can't.
+   */
+  bool tryCloneFile(int destFd, int srcFd);
+
+  /**
+   * Empties the blob cache directory, creating it if needed.
+   */
+  void resetBlobCache();
+
+  /**
+   * Clones the newly created overlay file fd into the blob cache, under
+   * cachePath.
+   */
+  void addToBlobCache(
+      const std::string& cachePath,
+      InodeNumber inodeNumber,
+      int fd);
 
   /** Path to ".eden/CLIENT/local" */
   const AbsolutePath localDir_;
@@ -240,6 +328,22 @@ class FileContentStore : public IFileContentStore {
    * We maintain this so we can use openat(), unlinkat(), etc.
    */
   folly::File dirFile_;
+
+  /**
+   * Set up by initialize() when io_uring was requested and is available.
+   * The ring is not thread-safe, so submissions hold ioUringMutex_.
+   */
+  bool useIoUring_;
+  std::mutex ioUringMutex_;
+  std::unique_ptr<IoUring> ioUring_;
+
+  /**
+   * Set once cloning a file failed because the overlay filesystem does not
+   * support reflinks, after which createOverlayFileForBlob() writes files
+   * out like createOverlayFile().
+   */
+  std::atomic<bool> reflinkUnsupported_{false};
+  std::atomic<size_t> blobCacheEntries_{0};
 };
 
 /**
@@ -251,8 +355,12 @@ class FsInodeCatalog : public InodeCatalog {
  public:
   explicit FsInodeCatalog(FileContentStore* core) : core_(core) {}
 
+  /**
+   * Adding, removing and renaming children append records to the directory
+   * files, instead of writing them again.
+   */
   bool supportsSemanticOperations() const override {
-    return false;
+    return true;
   }
 
   /**
@@ -290,9 +398,33 @@ class FsInodeCatalog : public InodeCatalog {
 
   bool hasOverlayDir(InodeNumber inodeNumber) override;
 
+  void addChild(
+      InodeNumber parent,
+      PathComponentPiece name,
+      overlay::OverlayEntry entry) override;
+
+  void removeChild(InodeNumber parent, PathComponentPiece childName) override;
+
+  bool hasChild(InodeNumber parent, PathComponentPiece childName) override;
+
+  void renameChild(
+      InodeNumber src,
+      InodeNumber dst,
+      PathComponentPiece srcName,
+      PathComponentPiece dstName) override;
+
   void maintenance() override {}
 
  private:
+  /**
+   * Appends record to the directory file of the given inode, or if it can't,
+   * applies the change to the loaded directory and writes it out.
+   */
+  void updateOverlayDir(
+      InodeNumber inodeNumber,
+      const std::string& record,
+      folly::FunctionRef<void(overlay::OverlayDir&)> change);
+
   FileContentStore* core_;
 };
 
@@ -11,6 +11,7 @@
 
 #include <boost/filesystem.hpp>
 #include <fcntl.h>
+#include <algorithm>
 #include <folly/portability/Unistd.h>
 #include <time.h>
 
@@ -25,6 +26,7 @@
 #include <folly/logging/xlog.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
 
+#include "eden/fs/inodes/fscatalog/CompactOverlayDir.h"
 #include "eden/fs/inodes/fscatalog/FsInodeCatalog.h"
 #include "eden/fs/utils/EnumValue.h"
 
@@ -761,8 +763,12 @@ OverlayChecker::OverlayChecker(
     FsInodeCatalog* fs,
     FileContentStore* fcs,
     optional<InodeNumber> nextInodeNumber,
-    LookupCallback& lookupCallback)
-    : impl_{std::make_unique<Impl>(fs, fcs, nextInodeNumber, lookupCallback)} {}
+    LookupCallback& lookupCallback,
+    uint32_t numThreads,
+    uint64_t logFrequency)
+    : impl_{std::make_unique<Impl>(fs, fcs, nextInodeNumber, lookupCallback)},
+      numThreads_{std::max(numThreads, uint32_t{1})},
+      logFrequency_{std::max(logFrequency, uint64_t{1})} {}
 
 OverlayChecker::~OverlayChecker() {}
 
@@ -977,10 +983,12 @@ std::unique_ptr<OverlayChecker::Error> make_error(Args&&... args) {
 void OverlayChecker::readInodes(const ProgressCallback& progressCallback) {
   using namespace folly::gen;
 
-  auto threads = 4;
+  auto threads = numThreads_;
   uint32_t progress10pct = 0;
 
   folly::Synchronized<std::vector<std::unique_ptr<Error>>> errors;
+  // The inode numbers found in the shard directories, with their shard.
+  std::vector<std::tuple<uint64_t, uint32_t>> toLoad;
 
   seq(0u, FileContentStore::kNumShards - 1) |
       pmap(
@@ -1031,7 +1039,15 @@ void OverlayChecker::readInodes(const ProgressCallback& progressCallback) {
             return inodes;
           },
           threads) |
-      rconcat | move |
+      rconcat | move | appendTo(toLoad);
+
+  // Listing the shards first gives the number of inodes to load, for
+  // accurate progress reports.
+  auto total = toLoad.size();
+  impl_->inodes.reserve(total);
+  size_t loaded = 0;
+
+  from(toLoad) |
       pmap(
           [this, &errors](std::tuple<uint64_t, uint32_t> result)
               -> std::optional<InodeInfo> {
@@ -1040,28 +1056,27 @@ void OverlayChecker::readInodes(const ProgressCallback& progressCallback) {
           },
           threads) |
       move |
-      map([this, progressCallback, &progress10pct](
+      map([this, total, &loaded, progressCallback, &progress10pct](
               std::optional<InodeInfo> inodeInfoOpt) -> bool {
-        if (inodeInfoOpt.has_value()) {
-          auto inodeInfo = inodeInfoOpt.value();
-          ShardID shardID = static_cast<ShardID>(inodeInfo.number.get() & 0xff);
-          uint32_t progress = (10 * shardID) / FileContentStore::kNumShards;
-          if (progress > progress10pct) {
-            XLOG(INFO) << "fsck:" << impl_->fcs->getLocalDir() << ": scan "
-                       << progress << "0% complete: " << impl_->inodes.size()
-                       << " inodes scanned";
-            if (auto callback = progressCallback) {
-              callback(progress);
-            }
-            progress10pct = progress;
+        ++loaded;
+        uint32_t progress = (10 * loaded) / total;
+        if (progress > progress10pct) {
+          XLOG(INFO) << "fsck:" << impl_->fcs->getLocalDir() << ": scan "
+                     << progress << "0% complete: " << loaded << " of "
+                     << total << " inodes scanned";
+          if (auto callback = progressCallback) {
+            callback(progress);
           }
+          progress10pct = progress;
+        } else if (loaded % logFrequency_ == 0) {
+          XLOG(INFO) << "fsck:" << impl_->fcs->getLocalDir() << ": scanned "
+                     << loaded << " of " << total << " inodes";
+        }
 
-          updateMaxInodeNumber(inodeInfo.number);
-          impl_->inodes.emplace(inodeInfo.number, inodeInfo);
-          if (impl_->inodes.size() % 10000 == 0) {
-            XLOG(DBG5) << "fsck: " << impl_->fcs->getLocalDir() << ": scanned "
-                       << impl_->inodes.size() << " inodes";
-          }
+        if (inodeInfoOpt.has_value()) {
+          auto number = inodeInfoOpt->number;
+          updateMaxInodeNumber(number);
+          impl_->inodes.emplace(number, std::move(inodeInfoOpt).value());
         }
         return true;
       }) |
@@ -1077,12 +1092,18 @@ void OverlayChecker::readInodes(const ProgressCallback& progressCallback) {
              << impl_->inodes.size() << " inodes";
 }
 
-overlay::OverlayDir loadDirectoryChildren(folly::File& file) {
+overlay::OverlayDir loadDirectoryChildren(
+    folly::File& file,
+    uint32_t version) {
   std::string serializedData;
   if (!folly::readFile(file.fd(), serializedData)) {
     folly::throwSystemError("read failed");
   }
 
+  if (version == FileContentStore::kCompactDirVersion) {
+    return CompactOverlayDir{folly::ByteRange{StringPiece{serializedData}}}
+        .toOverlayDir();
+  }
   return CompactSerializer::deserialize<overlay::OverlayDir>(serializedData);
 }
 
@@ -1153,9 +1174,6 @@ std::optional<OverlayChecker::InodeInfo> OverlayChecker::loadInodeInfo(
       headerContents.data() + FileContentStore::kHeaderIdentifierDir.size(),
       sizeof(uint32_t));
   auto version = folly::Endian::big(versionBE);
-  if (version != FileContentStore::kHeaderVersion) {
-    return inodeError("unknown overlay file format version ", version);
-  }
 
   InodeType type;
   if (typeID == FileContentStore::kHeaderIdentifierDir) {
@@ -1167,9 +1185,15 @@ std::optional<OverlayChecker::InodeInfo> OverlayChecker::loadInodeInfo(
         "unknown overlay file type ID: ", folly::hexlify(ByteRange{typeID}));
   }
 
+  if (version != FileContentStore::kHeaderVersion &&
+      !(type == InodeType::Dir &&
+        version == FileContentStore::kCompactDirVersion)) {
+    return inodeError("unknown overlay file format version ", version);
+  }
+
   if (type == InodeType::Dir) {
     try {
-      return {InodeInfo(number, loadDirectoryChildren(file))};
+      return {InodeInfo(number, loadDirectoryChildren(file, version))};
     } catch (const std::exception& ex) {
       return inodeError(
           "error parsing directory contents: ", folly::exceptionStr(ex));
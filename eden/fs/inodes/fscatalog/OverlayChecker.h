@@ -63,12 +63,17 @@ class OverlayChecker {
    * FileContentStore for the duration of the check operation.  The caller is
    * responsible for ensuring that the FsInodeCatalog and FileContentStore
    * objects exist for at least as long as the OverlayChecker object.
+   *
+   * scanForErrors() reads the overlay with numThreads threads, and logs its
+   * progress every logFrequency inodes.
    */
   OverlayChecker(
       FsInodeCatalog* fs,
       FileContentStore* fcs,
       std::optional<InodeNumber> nextInodeNumber,
-      LookupCallback& lookupCallback);
+      LookupCallback& lookupCallback,
+      uint32_t numThreads = 4,
+      uint64_t logFrequency = 10000);
 
   ~OverlayChecker();
 
@@ -217,6 +222,8 @@ class OverlayChecker {
   std::unique_ptr<Impl> impl_;
   std::vector<std::unique_ptr<Error>> errors_;
   uint64_t maxInodeNumber_{kRootNodeId.get()};
+  uint32_t numThreads_;
+  uint64_t logFrequency_;
 
   std::unordered_map<InodeNumber, PathInfo> pathCache_;
 };
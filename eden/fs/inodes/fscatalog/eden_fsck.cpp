@@ -6,7 +6,9 @@
  */
 
 #include <sysexits.h>
+#include <algorithm>
 #include <optional>
+#include <thread>
 
 #include <folly/Exception.h>
 #include <folly/init/Init.h>
@@ -23,6 +25,14 @@ DEFINE_bool(
     dry_run,
     false,
     "Only report errors, without attempting to fix any problems");
+DEFINE_uint32(
+    threads,
+    std::max(std::thread::hardware_concurrency(), 1u),
+    "Number of threads reading the overlay");
+DEFINE_uint64(
+    log_frequency,
+    10000,
+    "Log the scan progress every this many inodes");
 
 using namespace facebook::eden;
 
@@ -60,7 +70,9 @@ int main(int argc, char** argv) {
       &fsInodeCatalog.value(),
       &fileContentStore.value(),
       nextInodeNumber,
-      lookup);
+      lookup,
+      FLAGS_threads,
+      FLAGS_log_frequency);
   checker.scanForErrors();
   if (FLAGS_dry_run) {
     checker.logErrors();
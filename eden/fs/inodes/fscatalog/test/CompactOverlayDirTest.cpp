@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/fscatalog/CompactOverlayDir.h"
+
+#include <folly/Range.h>
+#include <folly/portability/GTest.h>
+#include <sys/stat.h>
+#include <stdexcept>
+#include <string>
+
+using namespace facebook::eden;
+using folly::ByteRange;
+using folly::StringPiece;
+
+namespace {
+
+overlay::OverlayEntry makeEntry(
+    int32_t mode,
+    int64_t inodeNumber,
+    std::optional<std::string> hash = std::nullopt) {
+  overlay::OverlayEntry entry;
+  entry.mode_ref() = mode;
+  entry.inodeNumber_ref() = inodeNumber;
+  if (hash) {
+    entry.hash_ref() = *hash;
+  }
+  return entry;
+}
+
+overlay::OverlayDir makeDir() {
+  overlay::OverlayDir dir;
+  auto& entries = *dir.entries_ref();
+  entries["zeta"] = makeEntry(S_IFREG | 0644, 12);
+  entries["alpha"] = makeEntry(S_IFDIR | 0755, 10, "tree-hash");
+  entries["mid"] = makeEntry(S_IFREG | 0755, 11, "blob-hash");
+  return dir;
+}
+
+CompactOverlayDir parse(const std::string& data) {
+  return CompactOverlayDir{ByteRange{StringPiece{data}}};
+}
+
+} // namespace
+
+TEST(CompactOverlayDir, roundTrips) {
+  auto dir = makeDir();
+  auto data = CompactOverlayDir::serialize(dir);
+  EXPECT_EQ(dir, parse(data).toOverlayDir());
+  EXPECT_EQ(data.size(), parse(data).getBaseSize());
+
+  auto empty = CompactOverlayDir::serialize(overlay::OverlayDir{});
+  EXPECT_EQ(0u, parse(empty).size());
+  EXPECT_TRUE(parse(empty).toOverlayDir().entries_ref()->empty());
+}
+
+TEST(CompactOverlayDir, looksUpEntriesInPlace) {
+  auto data = CompactOverlayDir::serialize(makeDir());
+  auto compact = parse(data);
+  ASSERT_EQ(3u, compact.size());
+  EXPECT_EQ("alpha", compact.entry(0).name);
+  EXPECT_EQ("mid", compact.entry(1).name);
+  EXPECT_EQ("zeta", compact.entry(2).name);
+
+  auto mid = compact.find("mid");
+  ASSERT_TRUE(mid.has_value());
+  EXPECT_EQ(11u, mid->inodeNumber);
+  EXPECT_EQ(uint32_t{S_IFREG | 0755}, mid->mode);
+  EXPECT_EQ("blob-hash", StringPiece{mid->hash});
+  EXPECT_TRUE(compact.find("zeta")->hash.empty());
+  EXPECT_FALSE(compact.find("beta").has_value());
+}
+
+TEST(CompactOverlayDir, appliesAppendedRecords) {
+  auto data = CompactOverlayDir::serialize(makeDir());
+  data += CompactOverlayDir::serializeRemoveRecord("zeta");
+  data += CompactOverlayDir::serializeAddRecord(
+      "beta", makeEntry(S_IFREG | 0644, 13, "other-hash"));
+  data += CompactOverlayDir::serializeAddRecord(
+      "mid", makeEntry(S_IFREG | 0644, 11));
+
+  auto expected = makeDir();
+  auto& entries = *expected.entries_ref();
+  entries.erase("zeta");
+  entries["beta"] = makeEntry(S_IFREG | 0644, 13, "other-hash");
+  entries["mid"] = makeEntry(S_IFREG | 0644, 11);
+
+  bool truncated = true;
+  EXPECT_EQ(expected, parse(data).toOverlayDir(&truncated));
+  EXPECT_FALSE(truncated);
+  // Lookups ignore the records.
+  EXPECT_TRUE(parse(data).find("zeta").has_value());
+}
+
+TEST(CompactOverlayDir, ignoresRecordCutShort) {
+  auto data = CompactOverlayDir::serialize(makeDir());
+  data += CompactOverlayDir::serializeRemoveRecord("zeta");
+  auto record = CompactOverlayDir::serializeAddRecord(
+      "beta", makeEntry(S_IFREG | 0644, 13, "other-hash"));
+  data += record.substr(0, record.size() - 3);
+
+  auto expected = makeDir();
+  expected.entries_ref()->erase("zeta");
+
+  bool truncated = false;
+  EXPECT_EQ(expected, parse(data).toOverlayDir(&truncated));
+  EXPECT_TRUE(truncated);
+}
+
+TEST(CompactOverlayDir, rejectsTruncatedEntries) {
+  auto data = CompactOverlayDir::serialize(makeDir());
+  EXPECT_THROW(parse(data.substr(0, 4)), std::invalid_argument);
+  EXPECT_THROW(parse(data.substr(0, data.size() - 1)), std::invalid_argument);
+}
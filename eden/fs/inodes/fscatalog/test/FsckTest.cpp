@@ -5,6 +5,7 @@
  * GNU General Public License version 2.
  */
 
+#include <algorithm>
 #include <memory>
 
 #include <folly/Conv.h>
@@ -360,6 +361,35 @@ TEST(Fsck, testNoErrors) {
           .toString());
 }
 
+TEST(Fsck, testProgressWithManyThreads) {
+  auto overlay = make_shared<TestOverlay>();
+  auto root = overlay->init();
+  SimpleOverlayLayout layout(root);
+  overlay->closeCleanly();
+
+  FileContentStore fcs(overlay->overlayPath());
+  FsInodeCatalog fs(&fcs);
+  auto nextInode = fs.initOverlay(/*createIfNonExisting=*/false);
+  OverlayChecker::LookupCallback lookup = [](auto&&) {
+    return makeImmediateFuture<OverlayChecker::LookupCallbackValue>(
+        std::runtime_error("no lookup callback"));
+  };
+  OverlayChecker checker(
+      &fs, &fcs, nextInode, lookup, /*numThreads=*/8, /*logFrequency=*/1);
+  std::vector<uint16_t> progress;
+  checker.scanForErrors(
+      [&progress](uint16_t percent) { progress.push_back(percent); });
+  EXPECT_EQ(0, checker.getErrors().size());
+
+  // Progress is reported per loaded inode, so the scan ends at 100%.
+  ASSERT_FALSE(progress.empty());
+  EXPECT_TRUE(std::is_sorted(progress.begin(), progress.end()));
+  EXPECT_EQ(10, progress.back());
+  EXPECT_EQ(
+      "src/foo/x/y/z.txt",
+      checker.computePath(layout.src_foo_x_y_zTxt.number()).toString());
+}
+
 TEST(Fsck, testMissingNextInodeNumber) {
   auto overlay = make_shared<TestOverlay>();
   auto root = overlay->init();
@@ -138,6 +138,24 @@ void BufferedSqliteInodeCatalog::process(
   Operation operation = Operation{operationType, work.get()};
 
   auto state = state_.lock();
+  if (operationType == OperationType::Write &&
+      !state->workerThreadStopRequested) {
+    auto waitingIter = state->waitingOperation.find(operationKey);
+    if (waitingIter != state->waitingOperation.end() &&
+        waitingIter->second.operationType == OperationType::Write) {
+      // The directory is already queued to be written and nothing newer
+      // than that write is queued for it: replace the queued contents so
+      // that a burst of changes to one directory is only serialized once.
+      // This does not need to wait for room in the buffer since it does not
+      // queue more work.
+      auto& queuedWork = *waitingIter->second.work;
+      state->totalSize -= queuedWork.estimateIndirectMemoryUsage;
+      queuedWork = std::move(*work);
+      state->totalSize += size;
+      return;
+    }
+  }
+
   fullCV_.wait(state.as_lock(), [&] {
     return state->totalSize < bufferSize_ || state->workerThreadStopRequested;
   });
@@ -73,6 +73,7 @@ class BufferedSqliteInodeCatalog : public SqliteInodeCatalog {
 
  private:
   FRIEND_TEST(RawSqliteInodeCatalogTest, manual_recursive_delete);
+  FRIEND_TEST(RawSqliteInodeCatalogTest, coalesces_queued_writes);
   friend class DebugDumpSqliteInodeCatalogInodesTest;
   enum class OperationType {
     Write,
@@ -134,6 +135,16 @@ class BufferedSqliteInodeCatalog : public SqliteInodeCatalog {
    * Puts an folly::Function on a worker thread to be processed asynchronously.
    * The function should return a bool indicating whether or not the worker
    * thread should stop.
+   *
+   * A Write for an inode whose most recent queued operation is also a Write
+   * replaces that queued Work instead of adding a new one, so a directory is
+   * written at most once per batch of the worker thread. Writes to
+   * different inodes can therefore reach the database in a different order
+   * than they were issued. Queued writes are already lost if EdenFS crashes;
+   * with coalescing, a crash in the middle of a batch can also leave a
+   * directory referencing a child directory that has not been written yet.
+   * Overlay::loadOverlayDir() loads such a child as an empty directory, as it
+   * does for any other directory whose queued write was lost.
    */
   void process(
       folly::Function<bool()> fn,
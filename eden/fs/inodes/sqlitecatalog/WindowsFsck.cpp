@@ -10,7 +10,12 @@
 
 #ifdef _WIN32
 #include <boost/filesystem.hpp>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
+#include <folly/futures/Future.h>
 #include <folly/portability/Windows.h>
+#include <algorithm>
+#include <atomic>
 
 #include <ProjectedFSLib.h> // @manual
 #include <winioctl.h> // @manual
@@ -503,21 +508,68 @@ std::optional<InodeNumber> fixup(
   }
 }
 
-// Returns true if the given path is considered materialized.
-bool processChildren(
-    SqliteInodeCatalog& inodeCatalog,
-    RelativePathPiece path,
-    AbsolutePathPiece root,
+/**
+ * Reconciles the overlay with the disk state of a mount, a directory at a
+ * time.
+ *
+ * The directories are scanned concurrently on a thread pool, which mostly
+ * overlaps the enumeration of directories on disk and the fetching of their
+ * source control trees. The overlay entries of a directory are only updated
+ * by the task scanning it, except for the entries of its children
+ * directories, each of which is updated once the scan of that child
+ * completes.
+ */
+class ParallelFsck {
+ public:
+  ParallelFsck(
+      SqliteInodeCatalog& inodeCatalog,
+      AbsolutePathPiece root,
+      const SqliteInodeCatalog::LookupCallback& callback,
+      uint64_t logFrequency,
+      uint32_t numThreads)
+      : inodeCatalog_{inodeCatalog},
+        root_{root},
+        callback_{callback},
+        logFrequency_{std::max(logFrequency, uint64_t{1})},
+        executor_{
+            std::max(numThreads, uint32_t{1}),
+            std::make_shared<folly::NamedThreadFactory>("WindowsFsck")} {}
+
+  /**
+   * Fix up the children of the given directory, and recursively those of its
+   * children directories. The returned future is true if the directory is
+   * considered materialized.
+   */
+  folly::Future<bool> processChildren(
+      RelativePath path,
+      InodeNumber inodeNumber,
+      const PathMap<overlay::OverlayEntry>& insensitiveOverlayDir,
+      const std::shared_ptr<const Tree>& scmTree);
+
+ private:
+  folly::Future<bool> processChildDirectory(
+      RelativePath childPath,
+      InodeNumber childInodeNumber,
+      bool inScm);
+
+  SqliteInodeCatalog& inodeCatalog_;
+  AbsolutePathPiece root_;
+  const SqliteInodeCatalog::LookupCallback& callback_;
+  uint64_t logFrequency_;
+  std::atomic<uint64_t> traversedDirectories_{0};
+  folly::CPUThreadPoolExecutor executor_;
+};
+
+folly::Future<bool> ParallelFsck::processChildren(
+    RelativePath path,
     InodeNumber inodeNumber,
     const PathMap<overlay::OverlayEntry>& insensitiveOverlayDir,
-    const std::shared_ptr<const Tree>& scmTree,
-    const SqliteInodeCatalog::LookupCallback& callback,
-    uint64_t logFrequency,
-    uint64_t& traversedDirectories) {
+    const std::shared_ptr<const Tree>& scmTree) {
   XLOGF(DBG9, "processChildren - {}", path);
 
-  traversedDirectories++;
-  if (traversedDirectories % logFrequency == 0) {
+  auto traversedDirectories =
+      traversedDirectories_.fetch_add(1, std::memory_order_relaxed) + 1;
+  if (traversedDirectories % logFrequency_ == 0) {
     // TODO: We could also report the progress to the StartupLogger to be
     // displayed in the user console. That however requires a percent and it's
     // a bit unclear how we can compute this percent.
@@ -528,7 +580,7 @@ bool processChildren(
   PathMap<FsckFileState> children{CaseSensitivity::Insensitive};
 
   // Populate children disk information
-  auto absPath = (root + path + "*"_relpath).wide();
+  auto absPath = (root_ + path + "*"_relpath).wide();
 
   WIN32_FIND_DATAW findFileData;
   HANDLE h = FindFirstFileExW(
@@ -537,7 +589,7 @@ bool processChildren(
       &findFileData,
       FindExSearchNameMatch,
       nullptr,
-      0);
+      FIND_FIRST_EX_LARGE_FETCH);
   if (h == INVALID_HANDLE_VALUE) {
     throw std::runtime_error(
         fmt::format("unable to iterate over directory - {}", path));
@@ -551,7 +603,7 @@ bool processChildren(
     }
     PathComponent name{findFileData.cFileName};
     auto& childState = children[name];
-    populateDiskState(root, path + name, childState, findFileData);
+    populateDiskState(root_, path + name, childState, findFileData);
   } while (FindNextFileW(h, &findFileData) != 0);
 
   auto error = GetLastError();
@@ -570,7 +622,7 @@ bool processChildren(
   // Don't recurse if there are no disk children for fixing up or overlay
   // children for deleting.
   if (children.empty()) {
-    return false;
+    return folly::makeFuture(false);
   }
 
   // Populate children scm information
@@ -584,13 +636,14 @@ bool processChildren(
 
   // Recurse for any children.
   bool anyChildMaterialized = false;
+  std::vector<folly::Future<bool>> childDirectories;
   for (auto& [childName, childState] : children) {
     auto childPath = path + childName;
     XLOGF(DBG9, "process child - {}", childPath);
 
     std::optional<InodeNumber> childInodeNumberOpt = fixup(
         childState,
-        inodeCatalog,
+        inodeCatalog_,
         childPath,
         inodeNumber,
         insensitiveOverlayDir);
@@ -599,58 +652,86 @@ bool processChildren(
 
     if (childState.desiredDtype == dtype_t::Dir && childState.onDisk &&
         !childState.diskEmptyPlaceholder && childInodeNumberOpt.has_value()) {
-      // Fetch child scm tree.
-      std::shared_ptr<const Tree> childScmTree;
-      if (childState.scmDtype == dtype_t::Dir) {
-        // TODO: handle scm failure
-        auto scmEntryTry = callback(childPath).getTry();
-        std::variant<
-            std::shared_ptr<const facebook::eden::Tree>,
-            facebook::eden::TreeEntry>& childScmEntry = scmEntryTry.value();
-        // It's guaranteed to be a Tree since scmDtype is Dir.
-        childScmTree = std::get<std::shared_ptr<const Tree>>(childScmEntry);
-      }
+      childDirectories.push_back(
+          folly::via(
+              &executor_,
+              [this,
+               childPath,
+               childInodeNumber = *childInodeNumberOpt,
+               inScm = childState.scmDtype == dtype_t::Dir]() mutable {
+                return processChildDirectory(
+                    std::move(childPath), childInodeNumber, inScm);
+              })
+              .thenValue([this,
+                          inodeNumber,
+                          childPath,
+                          childDtype = childState.desiredDtype,
+                          diskMaterialized = childState.diskMaterialized,
+                          hasScmHash = childState.desiredHash.has_value()](
+                             bool descendantMaterialized) {
+                bool childMaterialized =
+                    diskMaterialized || descendantMaterialized;
+                if (childMaterialized && hasScmHash) {
+                  XLOGF(
+                      DBG9,
+                      "Directory {} has a materialized child, and therefore is materialized too. Marking.",
+                      childPath);
+                  // Refresh the parent state so we see and update the current
+                  // overlay entry.
+                  auto updatedOverlayDir =
+                      *inodeCatalog_.loadOverlayDir(inodeNumber);
+                  auto updatedInsensitiveOverlayDir =
+                      toPathMap(updatedOverlayDir);
+                  // Update the overlay entry to remove the scmHash.
+                  addOrUpdateOverlay(
+                      inodeCatalog_,
+                      inodeNumber,
+                      childPath.basename(),
+                      childDtype,
+                      std::nullopt,
+                      updatedInsensitiveOverlayDir);
+                }
+                return childMaterialized;
+              }));
+    }
+  }
 
-      auto childInodeNumber = *childInodeNumberOpt;
-      auto childOverlayDir = *inodeCatalog.loadOverlayDir(childInodeNumber);
-      auto childInsensitiveOverlayDir = toPathMap(childOverlayDir);
-      bool childMaterialized = childState.diskMaterialized;
-      childMaterialized |= processChildren(
-          inodeCatalog,
-          childPath,
-          root,
-          childInodeNumber,
-          childInsensitiveOverlayDir,
-          childScmTree,
-          callback,
-          logFrequency,
-          traversedDirectories);
-      anyChildMaterialized |= childMaterialized;
+  if (childDirectories.empty()) {
+    return folly::makeFuture(anyChildMaterialized);
+  }
+  return folly::collect(std::move(childDirectories))
+      .via(&executor_)
+      .thenValue([anyChildMaterialized](std::vector<bool> childMaterialized) {
+        return anyChildMaterialized ||
+            std::find(
+                childMaterialized.begin(), childMaterialized.end(), true) !=
+            childMaterialized.end();
+      });
+}
 
-      if (childMaterialized && childState.desiredHash != std::nullopt) {
-        XLOGF(
-            DBG9,
-            "Directory {} has a materialized child, and therefore is materialized too. Marking.",
-            childPath);
-        childState.diskMaterialized = true;
-        childState.desiredHash = std::nullopt;
-        // Refresh the parent state so we see and update the current overlay
-        // entry.
-        auto updatedOverlayDir = *inodeCatalog.loadOverlayDir(inodeNumber);
-        auto updatedInsensitiveOverlayDir = toPathMap(updatedOverlayDir);
-        // Update the overlay entry to remove the scmHash.
-        addOrUpdateOverlay(
-            inodeCatalog,
-            inodeNumber,
-            childName,
-            childState.desiredDtype,
-            childState.desiredHash,
-            updatedInsensitiveOverlayDir);
-      }
-    }
+folly::Future<bool> ParallelFsck::processChildDirectory(
+    RelativePath childPath,
+    InodeNumber childInodeNumber,
+    bool inScm) {
+  // Fetch child scm tree.
+  std::shared_ptr<const Tree> childScmTree;
+  if (inScm) {
+    // TODO: handle scm failure
+    auto scmEntryTry = callback_(childPath).getTry();
+    std::variant<
+        std::shared_ptr<const facebook::eden::Tree>,
+        facebook::eden::TreeEntry>& childScmEntry = scmEntryTry.value();
+    // It's guaranteed to be a Tree since scmDtype is Dir.
+    childScmTree = std::get<std::shared_ptr<const Tree>>(childScmEntry);
   }
 
-  return anyChildMaterialized;
+  auto childOverlayDir = *inodeCatalog_.loadOverlayDir(childInodeNumber);
+  auto childInsensitiveOverlayDir = toPathMap(childOverlayDir);
+  return processChildren(
+      std::move(childPath),
+      childInodeNumber,
+      childInsensitiveOverlayDir,
+      childScmTree);
 }
 
 void scanCurrentDir(
@@ -810,17 +891,15 @@ void windowsFsckScanLocalChanges(
           facebook::eden::TreeEntry>& scmEntry = scmEntryTry.value();
       std::shared_ptr<const Tree> scmTree =
           std::get<std::shared_ptr<const Tree>>(scmEntry);
-      uint64_t traversedDirectories = 1;
-      processChildren(
+      ParallelFsck fsck{
           inodeCatalog,
-          ""_relpath,
           mountPath,
-          kRootNodeId,
-          insensitiveOverlayDir,
-          scmTree,
           callback,
           config->fsckLogFrequency.getValue(),
-          traversedDirectories);
+          config->fsckScanThreads.getValue()};
+      fsck.processChildren(
+              RelativePath{}, kRootNodeId, insensitiveOverlayDir, scmTree)
+          .get();
     } else {
       scanCurrentDir(
           inodeCatalog,
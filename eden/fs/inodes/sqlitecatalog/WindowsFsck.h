@@ -45,6 +45,8 @@ class EdenConfig;
  *
  * See also: https://docs.microsoft.com/en-us/windows/win32/projfs/cache-state
  *
+ * When `fsck:use-thorough-fsck` is set, directories are scanned concurrently
+ * by `fsck:scan-threads` threads.
  */
 void windowsFsckScanLocalChanges(
     std::shared_ptr<const EdenConfig> config,
@@ -9,7 +9,9 @@
 #include "eden/fs/inodes/sqlitecatalog/BufferedSqliteInodeCatalog.h"
 #include "eden/fs/inodes/test/OverlayTestUtil.h"
 
+#include <fmt/format.h>
 #include <iomanip>
+#include <thread>
 
 #include <folly/portability/GTest.h>
 #include <folly/test/TestUtils.h>
@@ -377,6 +379,48 @@ TEST_P(RawSqliteInodeCatalogTest, manual_recursive_delete) {
   }
 }
 
+TEST_P(RawSqliteInodeCatalogTest, coalesces_queued_writes) {
+  if (overlayType() != Overlay::InodeCatalogType::TreeBuffered) {
+    GTEST_SKIP() << "only the buffered catalog queues writes";
+  }
+  auto* catalog =
+      static_cast<BufferedSqliteInodeCatalog*>(overlay->getRawInodeCatalog());
+  auto dirIno = overlay->allocateInodeNumber();
+  auto otherIno = overlay->allocateInodeNumber();
+
+  folly::Promise<folly::Unit> promise;
+  SCOPE_EXIT {
+    promise.setValue(folly::unit);
+  };
+  catalog->pause(promise.getFuture());
+  // Wait for the worker thread to pick up the pause so that the writes below
+  // stay queued.
+  while (!catalog->state_.lock()->work.empty()) {
+    std::this_thread::yield();
+  }
+
+  DirContents contents(kPathMapDefaultCaseSensitive);
+  DirContents empty(kPathMapDefaultCaseSensitive);
+  for (int i = 0; i < 10; ++i) {
+    contents.emplace(
+        PathComponent{fmt::format("file{}", i)},
+        S_IFREG | 0644,
+        overlay->allocateInodeNumber());
+    overlay->saveOverlayDir(dirIno, contents);
+    overlay->saveOverlayDir(otherIno, empty);
+  }
+  EXPECT_EQ(2, catalog->state_.lock()->work.size());
+
+  // The queued write holds the latest contents.
+  auto loaded = overlay->loadOverlayDir(dirIno);
+  EXPECT_EQ(10, loaded.size());
+
+  // A removal is not merged with the writes queued before it.
+  overlay->removeOverlayDir(otherIno);
+  overlay->saveOverlayDir(otherIno, empty);
+  EXPECT_EQ(4, catalog->state_.lock()->work.size());
+}
+
 INSTANTIATE_TEST_SUITE_P(
     RawSqliteInodeCatalogTest,
     RawSqliteInodeCatalogTest,
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/CheckoutCheckpoint.h"
+
+#include <folly/experimental/TestUtil.h>
+#include <folly/portability/GTest.h>
+#include <string>
+
+#include "eden/fs/testharness/TempFile.h"
+#include "eden/fs/utils/FileUtils.h"
+
+using namespace facebook::eden;
+
+namespace {
+struct CheckoutCheckpointTest : ::testing::Test {
+  CheckoutCheckpoint open(bool resume, RootId to = RootId{"2"}) {
+    return CheckoutCheckpoint{path, RootId{"1"}, to, resume};
+  }
+
+  folly::test::TemporaryDirectory testDir = makeTempDir();
+  AbsolutePath path =
+      canonicalPath(testDir.path().string()) + "CHECKOUT_CHECKPOINT"_relpath;
+};
+} // namespace
+
+TEST_F(CheckoutCheckpointTest, resumesCompletedDirectories) {
+  {
+    auto checkpoint = open(/*resume=*/false);
+    EXPECT_EQ(0, checkpoint.getResumedCount());
+    checkpoint.markComplete("a/b"_relpath);
+    checkpoint.markComplete("c"_relpath);
+  }
+
+  auto checkpoint = open(/*resume=*/true);
+  EXPECT_EQ(2, checkpoint.getResumedCount());
+  EXPECT_TRUE(checkpoint.isComplete("a/b"_relpath));
+  EXPECT_TRUE(checkpoint.isComplete("c"_relpath));
+  EXPECT_FALSE(checkpoint.isComplete("a"_relpath));
+
+  // Directories completed after resuming are kept for the next resume.
+  checkpoint.markComplete("a"_relpath);
+  EXPECT_EQ(3, open(/*resume=*/true).getResumedCount());
+}
+
+TEST_F(CheckoutCheckpointTest, startsOverForAnotherCheckout) {
+  open(/*resume=*/false).markComplete("a"_relpath);
+  EXPECT_EQ(0, open(/*resume=*/true, RootId{"3"}).getResumedCount());
+  // Which also discarded the directories of the first checkout.
+  EXPECT_EQ(0, open(/*resume=*/true).getResumedCount());
+
+  open(/*resume=*/false).markComplete("a"_relpath);
+  EXPECT_EQ(0, open(/*resume=*/false).getResumedCount());
+  EXPECT_EQ(0, open(/*resume=*/true).getResumedCount());
+}
+
+TEST_F(CheckoutCheckpointTest, ignoresPathCutShort) {
+  open(/*resume=*/false).markComplete("a"_relpath);
+  auto contents = readFile(path).value();
+  writeFile(path, folly::ByteRange{folly::StringPiece{contents + "b/c"}})
+      .value();
+
+  auto checkpoint = open(/*resume=*/true);
+  EXPECT_EQ(1, checkpoint.getResumedCount());
+  EXPECT_FALSE(checkpoint.isComplete("b/c"_relpath));
+  checkpoint.markComplete("d"_relpath);
+
+  auto resumed = open(/*resume=*/true);
+  EXPECT_EQ(2, resumed.getResumedCount());
+  EXPECT_TRUE(resumed.isComplete("d"_relpath));
+}
+
+TEST_F(CheckoutCheckpointTest, removesTheFile) {
+  auto checkpoint = open(/*resume=*/false);
+  checkpoint.markComplete("a"_relpath);
+  checkpoint.remove();
+  EXPECT_FALSE(readFile(path).hasValue());
+  // Nothing is recorded once removed.
+  checkpoint.markComplete("b"_relpath);
+  EXPECT_FALSE(readFile(path).hasValue());
+}
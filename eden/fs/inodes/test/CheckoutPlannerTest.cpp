@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/CheckoutPlanner.h"
+
+#include <folly/executors/ManualExecutor.h>
+#include <folly/portability/GTest.h>
+#include <map>
+
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/testharness/FakeBackingStore.h"
+#include "eden/fs/testharness/FakeTreeBuilder.h"
+#include "eden/fs/testharness/TestMount.h"
+
+using namespace facebook::eden;
+using Change = CheckoutPlanEntry::Change;
+
+namespace {
+struct PlannerTest : ::testing::Test {
+  void SetUp() override {
+    builder1.setFile("a/abc.txt", "abc\n");
+    builder1.setFile("a/xyz.txt", "xyz\n");
+    builder1.setFile("readme.txt", "readme\n");
+    mount.initialize(RootId{"1"}, builder1);
+
+    builder2 = builder1.clone();
+    builder2.replaceFile("a/abc.txt", "new abc\n");
+    builder2.removeFile("a/xyz.txt");
+    builder2.setFile("b/new.txt", "new\n");
+    builder2.finalize(mount.getBackingStore(), true);
+    mount.getBackingStore()->putCommit("2", builder2)->setReady();
+  }
+
+  CheckoutPlan plan(bool prefetch = false) {
+    entries.clear();
+    auto executor = mount.getServerExecutor().get();
+    return planCheckout(
+               mount.getEdenMount(),
+               RootId{"2"},
+               prefetch,
+               folly::CancellationToken{},
+               ObjectFetchContext::getNullContext(),
+               [this](const CheckoutPlanEntry& entry) {
+                 entries.emplace(
+                     entry.path.asString(),
+                     std::make_pair(entry.change, entry.conflict));
+               })
+        .semi()
+        .via(executor)
+        .getVia(executor);
+  }
+
+  FakeTreeBuilder builder1;
+  FakeTreeBuilder builder2;
+  TestMount mount;
+  std::map<std::string, std::pair<Change, bool>> entries;
+};
+} // namespace
+
+TEST_F(PlannerTest, plansChangesBetweenCommits) {
+  auto result = plan();
+  EXPECT_EQ(2, result.treesToFetch);
+  EXPECT_EQ(2, result.blobsToFetch);
+  EXPECT_EQ(0, result.conflicts);
+  EXPECT_EQ(5, result.inodesInvalidated);
+
+  std::map<std::string, std::pair<Change, bool>> expected{
+      {"a", {Change::Modified, false}},
+      {"a/abc.txt", {Change::Modified, false}},
+      {"a/xyz.txt", {Change::Removed, false}},
+      {"b", {Change::Added, false}},
+      {"b/new.txt", {Change::Added, false}},
+  };
+  EXPECT_EQ(expected, entries);
+
+  // Planning checks nothing out.
+  EXPECT_EQ(RootId{"1"}, mount.getEdenMount()->getCheckedOutRootId());
+  EXPECT_TRUE(mount.hasFileAt("a/xyz.txt"));
+}
+
+TEST_F(PlannerTest, reportsFilesChangedInTheWorkingCopyAsConflicts) {
+  mount.overwriteFile("a/abc.txt", "local edit\n");
+  mount.mkdir("b");
+  mount.addFile("b/new.txt", "untracked\n");
+  mount.overwriteFile("readme.txt", "local readme\n");
+
+  auto result = plan();
+  EXPECT_EQ(2, result.conflicts);
+  EXPECT_TRUE(entries.at("a/abc.txt").second);
+  EXPECT_TRUE(entries.at("b/new.txt").second);
+  EXPECT_FALSE(entries.at("a/xyz.txt").second);
+  // Unchanged by the checkout, so not part of the plan.
+  EXPECT_EQ(0, entries.count("readme.txt"));
+}
+
+TEST_F(PlannerTest, prefetchesThePlannedBlobs) {
+  auto* backingStore = mount.getBackingStore().get();
+  auto newBlob = builder2.getStoredBlob("b/new.txt"_relpath)->get().getHash();
+
+  plan();
+  EXPECT_EQ(0, backingStore->getPrefetchCount(newBlob));
+  EXPECT_EQ(2, plan(/*prefetch=*/true).blobsToFetch);
+  EXPECT_EQ(1, backingStore->getPrefetchCount(newBlob));
+}
@@ -712,6 +712,35 @@ TEST(Checkout, modifyThenRevert) {
 #endif
 }
 
+TEST(Checkout, comparesMaterializedFilesBySizeThenContents) {
+  auto srcBuilder = FakeTreeBuilder();
+  srcBuilder.setFile("a/longer.txt", "test contents\n");
+  srcBuilder.setFile("a/same_size.txt", "test contents\n");
+  srcBuilder.setFile("a/unchanged.txt", "test contents\n");
+  TestMount testMount{srcBuilder};
+  auto originalCommit = testMount.getEdenMount()->getCheckedOutRootId();
+
+  // Materialize all three files, only two of which end up different.
+  testMount.overwriteFile("a/longer.txt", "test contents, longer\n");
+  testMount.overwriteFile("a/same_size.txt", "test CONTENTS\n");
+  testMount.overwriteFile("a/unchanged.txt", "test contents\n");
+
+  auto executor = testMount.getServerExecutor().get();
+  auto checkoutResult = testMount.getEdenMount()
+                            ->checkout(
+                                originalCommit,
+                                std::nullopt,
+                                __func__,
+                                CheckoutMode::DRY_RUN)
+                            .waitVia(executor);
+  ASSERT_TRUE(checkoutResult.isReady());
+  EXPECT_THAT(
+      std::move(checkoutResult).get().conflicts,
+      UnorderedElementsAre(
+          makeConflict(ConflictType::MODIFIED_MODIFIED, "a/longer.txt"),
+          makeConflict(ConflictType::MODIFIED_MODIFIED, "a/same_size.txt")));
+}
+
 TEST(Checkout, modifyThenCheckoutRevisionWithoutFile) {
   auto builder1 = FakeTreeBuilder();
   builder1.setFile("src/main.c", "// Some code.\n");
@@ -741,6 +770,36 @@ TEST(Checkout, modifyThenCheckoutRevisionWithoutFile) {
           makeConflict(ConflictType::MODIFIED_REMOVED, "src/test.c")));
 }
 
+TEST(Checkout, resumableCheckoutRemovesItsCheckpointOnceComplete) {
+  auto builder1 = FakeTreeBuilder();
+  builder1.setFile("src/main.c", "// Some code.\n");
+  builder1.setFile("doc/readme.txt", "readme\n");
+  TestMount testMount{RootId{"1"}, builder1};
+  testMount.getEdenConfig()->allowResumeCheckout.setValue(
+      true, ConfigSource::CommandLine);
+
+  auto builder2 = builder1.clone();
+  builder2.replaceFile("src/main.c", "// More code.\n");
+  builder2.replaceFile("doc/readme.txt", "new readme\n");
+  builder2.finalize(testMount.getBackingStore(), true);
+  testMount.getBackingStore()->putCommit("2", builder2)->setReady();
+
+  auto edenMount = testMount.getEdenMount();
+  EXPECT_FALSE(edenMount->getCheckoutProgress().has_value());
+
+  auto executor = testMount.getServerExecutor().get();
+  auto result = edenMount->checkout(RootId("2"), std::nullopt, __func__)
+                    .waitVia(executor);
+  ASSERT_TRUE(result.isReady());
+  EXPECT_THAT(std::move(result).get().conflicts, testing::IsEmpty());
+
+  EXPECT_FALSE(edenMount->getCheckoutProgress().has_value());
+  EXPECT_FALSE(
+      readFile(edenMount->getCheckoutConfig()->getCheckoutCheckpointPath())
+          .hasValue());
+  EXPECT_EQ("new readme\n", testMount.readFile("doc/readme.txt"));
+}
+
 TEST(Checkout, createUntrackedFileAndCheckoutAsTrackedFile) {
   auto builder1 = FakeTreeBuilder();
   builder1.setFile("src/main.c", "// Some code.\n");
@@ -1454,6 +1513,39 @@ TEST(Checkout, testSetPathObjectIdCheckoutMultipleFiles) {
   EXPECT_FILE_INODE(testMount.getFileInode(path2), contents2, 0644);
 }
 
+TEST(Checkout, cloneDirectory) {
+  auto builder = FakeTreeBuilder{};
+  builder.setFile("src/a.txt", "a\n");
+  builder.setFile("src/sub/b.txt", "b\n");
+  TestMount testMount{builder};
+
+  auto clone = [&](folly::StringPiece source, folly::StringPiece destination) {
+    auto future = testMount.getEdenMount()
+                      ->cloneDirectory(
+                          RelativePath{source},
+                          RelativePath{destination},
+                          ObjectFetchContext::getNullContext())
+                      .semi()
+                      .via(testMount.getServerExecutor().get());
+    testMount.drainServerExecutor();
+    return std::move(future).getTry();
+  };
+
+  ASSERT_TRUE(clone("src", "copy").hasValue());
+  EXPECT_FILE_INODE(testMount.getFileInode("copy/a.txt"_relpath), "a\n", 0644);
+  EXPECT_FILE_INODE(
+      testMount.getFileInode("copy/sub/b.txt"_relpath), "b\n", 0644);
+
+  // The copies are independent.
+  testMount.overwriteFile("copy/a.txt", "changed\n");
+  EXPECT_FILE_INODE(testMount.getFileInode("src/a.txt"_relpath), "a\n", 0644);
+
+  // Cloning over existing files fails.
+  EXPECT_THROW_ERRNO(clone("src", "copy").value(), EEXIST);
+  // As does cloning a materialized directory.
+  EXPECT_THROW_ERRNO(clone("copy", "copy2").value(), EINVAL);
+}
+
 #endif
 
 template <typename Unloader>
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/CheckoutTreePrefetcher.h"
+
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/testharness/FakeBackingStore.h"
+#include "eden/fs/testharness/FakeTreeBuilder.h"
+#include "eden/fs/testharness/TestMount.h"
+
+using namespace facebook::eden;
+
+namespace {
+FakeTreeBuilder makeSourceBuilder() {
+  FakeTreeBuilder builder;
+  builder.setFile("a/b/c/file.txt", "one\n");
+  builder.setFile("unchanged/file.txt", "same\n");
+  return builder;
+}
+
+std::shared_ptr<CheckoutTreePrefetcher> makePrefetcher(
+    TestMount& mount,
+    size_t maxConcurrency) {
+  return std::make_shared<CheckoutTreePrefetcher>(
+      mount.getEdenMount()->getObjectStorePtr(),
+      ObjectFetchContext::getNullContext(),
+      maxConcurrency);
+}
+} // namespace
+
+TEST(CheckoutTreePrefetcher, fetchesOnlyChangedSubtrees) {
+  auto srcBuilder = makeSourceBuilder();
+  TestMount mount{srcBuilder};
+
+  auto destBuilder = srcBuilder.clone();
+  destBuilder.replaceFile("a/b/c/file.txt", "two\n");
+  destBuilder.setFile("new/d/file.txt", "new\n");
+  destBuilder.finalize(mount.getBackingStore(), true);
+  auto toTree = std::make_shared<const Tree>(destBuilder.getRoot()->get());
+
+  auto unchangedHash =
+      srcBuilder.getStoredTree("unchanged"_relpath)->get().getHash();
+  auto unchangedAccesses =
+      mount.getBackingStore()->getAccessCount(unchangedHash);
+
+  for (size_t concurrency : {1, 64}) {
+    SCOPED_TRACE(concurrency);
+    auto prefetcher = makePrefetcher(mount, concurrency);
+    prefetcher->start(mount.getRootTree(), toTree);
+    mount.drainServerExecutor();
+
+    // a, a/b and a/b/c in both commits, then new and new/d.
+    EXPECT_EQ(8, prefetcher->getTreesFetched());
+    EXPECT_TRUE(prefetcher->getDuration().has_value());
+  }
+  EXPECT_EQ(
+      unchangedAccesses,
+      mount.getBackingStore()->getAccessCount(unchangedHash));
+}
+
+TEST(CheckoutTreePrefetcher, stopDropsQueuedDirectories) {
+  auto srcBuilder = makeSourceBuilder();
+  TestMount mount{srcBuilder};
+
+  auto destBuilder = srcBuilder.clone();
+  destBuilder.replaceFile("a/b/c/file.txt", "two\n");
+  destBuilder.finalize(mount.getBackingStore(), false);
+  auto toTree = std::make_shared<const Tree>(destBuilder.getRoot()->get());
+
+  auto prefetcher = makePrefetcher(mount, 1);
+  prefetcher->start(mount.getRootTree(), toTree);
+  mount.drainServerExecutor();
+  EXPECT_EQ(0, prefetcher->getTreesFetched());
+
+  // The fetch of "a" is in flight; its children must not be queued once the
+  // prefetcher is stopped.
+  prefetcher->stop();
+  destBuilder.setAllReady();
+  mount.drainServerExecutor();
+  EXPECT_EQ(2, prefetcher->getTreesFetched());
+  EXPECT_FALSE(prefetcher->getDuration().has_value());
+}
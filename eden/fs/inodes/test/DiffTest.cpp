@@ -2209,3 +2209,64 @@ TEST(DiffTest, multiTreeDiff) {
       *status.entries(),
       UnorderedElementsAre(std::make_pair("b", ScmFileStatus::MODIFIED)));
 }
+
+TEST(DiffTest, cachedStatusFollowsWorkingCopyChanges) {
+  DiffTest test;
+  auto& mount = test.getMount();
+  auto status = [&] {
+    auto df = test.diffFuture().semi().via(mount.getServerExecutor().get());
+    mount.drainServerExecutor();
+    return EXPECT_FUTURE_RESULT(df);
+  };
+
+  // The second call is answered from the cache.
+  EXPECT_THAT(*status().entries_ref(), UnorderedElementsAre());
+  EXPECT_THAT(*status().entries_ref(), UnorderedElementsAre());
+
+  mount.addFile("src/new.txt", "extra stuff");
+  EXPECT_THAT(
+      *status().entries_ref(),
+      UnorderedElementsAre(
+          std::make_pair("src/new.txt", ScmFileStatus::ADDED)));
+
+  mount.overwriteFile("src/1.txt", "This file has been updated.\n");
+  EXPECT_THAT(
+      *status().entries_ref(),
+      UnorderedElementsAre(
+          std::make_pair("src/new.txt", ScmFileStatus::ADDED),
+          std::make_pair("src/1.txt", ScmFileStatus::MODIFIED)));
+
+#ifndef _WIN32
+  mount.chmod("src/2.txt", 0755);
+  EXPECT_THAT(
+      *status().entries_ref(),
+      UnorderedElementsAre(
+          std::make_pair("src/new.txt", ScmFileStatus::ADDED),
+          std::make_pair("src/1.txt", ScmFileStatus::MODIFIED),
+          std::make_pair("src/2.txt", ScmFileStatus::MODIFIED)));
+  mount.chmod("src/2.txt", 0644);
+#endif // !_WIN32
+
+  mount.deleteFile("src/new.txt");
+  mount.overwriteFile("src/1.txt", "This is src/1.txt.\n");
+  EXPECT_THAT(*status().entries_ref(), UnorderedElementsAre());
+}
+
+TEST(DiffTest, cachedStatusFollowsParentChanges) {
+  DiffTest test;
+  auto& mount = test.getMount();
+  auto status = [&] {
+    auto df = test.diffFuture().semi().via(mount.getServerExecutor().get());
+    mount.drainServerExecutor();
+    return EXPECT_FUTURE_RESULT(df);
+  };
+  EXPECT_THAT(*status().entries_ref(), UnorderedElementsAre());
+
+  auto b2 = test.getBuilder().clone();
+  b2.replaceFile("src/1.txt", "This file was changed in the new commit.\n");
+  mount.resetCommit(b2, /* setReady = */ true);
+  EXPECT_THAT(
+      *status().entries_ref(),
+      UnorderedElementsAre(
+          std::make_pair("src/1.txt", ScmFileStatus::MODIFIED)));
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/DirectoryPreloader.h"
+
+#include <folly/portability/GTest.h>
+#include <limits>
+
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/inodes/InodeMap.h"
+#include "eden/fs/inodes/PathError.h"
+#include "eden/fs/service/gen-cpp2/eden_types.h"
+#include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/testharness/FakeTreeBuilder.h"
+#include "eden/fs/testharness/TestMount.h"
+
+using namespace facebook::eden;
+
+namespace {
+FakeTreeBuilder makeBuilder() {
+  FakeTreeBuilder builder;
+  builder.setFile("src/lib/util/util.cpp", "util\n");
+  builder.setFile("src/lib/main.cpp", "main\n");
+  builder.setFile("src/app/app.cpp", "app\n");
+  builder.setFile("docs/README", "docs\n");
+  return builder;
+}
+
+DirectoryPreloadProgress preload(
+    TestMount& mount,
+    std::vector<DirectoryPreloadRequest> directories,
+    DirectoryPreloadOptions options = {}) {
+  return preloadDirectories(
+      *mount.getEdenMount(),
+      directories,
+      options,
+      ObjectFetchContext::getNullContext(),
+      [](const DirectoryPreloadProgress&) {});
+}
+} // namespace
+
+TEST(DirectoryPreloader, fetchesTreesUpToTheRequestedDepth) {
+  auto builder = makeBuilder();
+  TestMount mount{builder};
+
+  EXPECT_EQ(1, preload(mount, {{"src"_relpath, 0}}).treesFetched);
+  // src, src/lib and src/app.
+  EXPECT_EQ(3, preload(mount, {{"src"_relpath, 1}}).treesFetched);
+  auto progress = preload(
+      mount,
+      {{"src"_relpath, std::numeric_limits<size_t>::max()},
+       {"docs"_relpath, 0}});
+  EXPECT_EQ(5, progress.treesFetched);
+  EXPECT_EQ(0, progress.inodesLoaded);
+  EXPECT_EQ(2, progress.depth);
+}
+
+TEST(DirectoryPreloader, reportsProgressOfEachBatch) {
+  auto builder = makeBuilder();
+  TestMount mount{builder};
+
+  std::vector<DirectoryPreloadProgress> reports;
+  DirectoryPreloadOptions options;
+  options.batchSize = 1;
+  preloadDirectories(
+      *mount.getEdenMount(),
+      {{RelativePath{}, std::numeric_limits<size_t>::max()}},
+      options,
+      ObjectFetchContext::getNullContext(),
+      [&](const DirectoryPreloadProgress& progress) {
+        reports.push_back(progress);
+      });
+
+  ASSERT_FALSE(reports.empty());
+  for (size_t i = 1; i < reports.size(); ++i) {
+    EXPECT_LE(reports[i - 1].treesFetched, reports[i].treesFetched);
+  }
+  // The root, src, src/lib, src/lib/util, src/app and docs.
+  EXPECT_EQ(6, reports.back().treesFetched);
+  EXPECT_EQ(0, reports.back().pendingDirectories);
+}
+
+TEST(DirectoryPreloader, loadsInodes) {
+  auto builder = makeBuilder();
+  TestMount mount{builder};
+  auto* inodeMap = mount.getEdenMount()->getInodeMap();
+  auto loadedBefore = inodeMap->getInodeCounts().treeCount;
+
+  DirectoryPreloadOptions options;
+  options.loadInodes = true;
+  auto progress = preload(mount, {{"src/lib"_relpath, 1}}, options);
+  EXPECT_EQ(2, progress.inodesLoaded);
+  // src, src/lib and src/lib/util.
+  EXPECT_EQ(loadedBefore + 3, inodeMap->getInodeCounts().treeCount);
+}
+
+TEST(DirectoryPreloader, failsOnFilesAndPastTheTreeLimit) {
+  auto builder = makeBuilder();
+  TestMount mount{builder};
+
+  EXPECT_THROW(preload(mount, {{"docs/README"_relpath, 0}}), PathError);
+
+  DirectoryPreloadOptions options;
+  options.maxTrees = 2;
+  EXPECT_THROW(preload(mount, {{"src"_relpath, 1}}, options), EdenError);
+}
@@ -480,6 +480,53 @@ TEST_F(FileInodeTest, fallocate) {
 }
 #endif
 
+TEST_F(FileInodeTest, readsUpdateAtimeLikeRelatime) {
+  auto inode = mount_.getFileInode("dir/a.txt");
+  auto& clock = mount_.getClock();
+  auto read = [&] {
+    inode->read(4, 0, ObjectFetchContext::getNullContext()).get(0ms);
+    return inode->getMetadata().timestamps.atime;
+  };
+
+  // atime is updated when it isn't newer than mtime.
+  clock.advance(1min);
+  auto firstRead = read();
+  EXPECT_LT(inode->getMetadata().timestamps.mtime, firstRead);
+
+  // Then only once it's a day old.
+  clock.advance(1h);
+  EXPECT_EQ(firstRead, read());
+  clock.advance(24h);
+  EXPECT_LT(firstRead, read());
+}
+
+TEST_F(FileInodeTest, sha1OfAppendedAndRewrittenFile) {
+  auto inode = mount_.getFileInode("dir/a.txt");
+  auto sha1 = [&] {
+    return inode->getSha1(ObjectFetchContext::getNullContext()).get(0ms);
+  };
+
+  // Truncating and appending extends the hash of the contents.
+  DesiredMetadata desired;
+  desired.size = 0;
+  (void)inode->setattr(desired, ObjectFetchContext::getNullContext()).get(0ms);
+  EXPECT_EQ(kEmptySha1, sha1());
+  inode->write("abc"_sp, 0, ObjectFetchContext::getNullContext()).get(0ms);
+  EXPECT_EQ(Hash20::sha1(std::string{"abc"}), sha1());
+  inode->write("def"_sp, 3, ObjectFetchContext::getNullContext()).get(0ms);
+  EXPECT_EQ(Hash20::sha1(std::string{"abcdef"}), sha1());
+
+  // Writes anywhere else rehash the file, which appends then extend again.
+  inode->write("X"_sp, 1, ObjectFetchContext::getNullContext()).get(0ms);
+  EXPECT_EQ(Hash20::sha1(std::string{"aXcdef"}), sha1());
+  inode->write("gh"_sp, 6, ObjectFetchContext::getNullContext()).get(0ms);
+  EXPECT_EQ(Hash20::sha1(std::string{"aXcdefgh"}), sha1());
+
+  desired.size = 4;
+  (void)inode->setattr(desired, ObjectFetchContext::getNullContext()).get(0ms);
+  EXPECT_EQ(Hash20::sha1(std::string{"aXcd"}), sha1());
+}
+
 TEST(FileInode, truncatingDuringLoad) {
   FakeTreeBuilder builder;
   builder.setFiles({{"notready.txt", "Contents not ready.\n"}});
@@ -563,6 +610,30 @@ TEST(FileInode, writeDuringLoad) {
   EXPECT_FILE_INODE(inode, "ConTENTS not ready.\n", 0644);
 }
 
+TEST(FileInode, overwritingWholeFileDoesNotLoadBlob) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"file.txt", "old contents\n"}});
+  TestMount mount_{builder};
+
+  auto inode = mount_.getFileInode("file.txt");
+  // Cache the file size in the inode.
+  EXPECT_EQ(
+      13, inode->stat(ObjectFetchContext::getNullContext()).get(0ms).st_size);
+
+  auto blobHash = *inode->getBlobHash();
+  auto backingStore = mount_.getBackingStore();
+  backingStore->getStoredBlob(blobHash)->notReady();
+  auto accesses = backingStore->getAccessCount(blobHash);
+
+  auto newContents = "new contents!\n"_sp;
+  auto writeFuture =
+      inode->write(newContents, 0, ObjectFetchContext::getNullContext());
+  ASSERT_TRUE(writeFuture.isReady());
+  EXPECT_EQ(newContents.size(), std::move(writeFuture).get(0ms));
+  EXPECT_EQ(accesses, backingStore->getAccessCount(blobHash));
+  EXPECT_FILE_INODE(inode, newContents, 0644);
+}
+
 TEST(FileInode, truncateDuringLoad) {
   // Build a tree to test against, but do not mark the state ready yet
   FakeTreeBuilder builder;
@@ -17,8 +17,10 @@
 #include <folly/portability/GTest.h>
 #include <folly/test/TestUtils.h>
 
+#include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/inodes/TreeInode.h"
 #include "eden/fs/model/TestOps.h"
+#include "eden/fs/store/LocalStore.h"
 #include "eden/fs/testharness/FakeBackingStore.h"
 #include "eden/fs/testharness/FakeTreeBuilder.h"
 #include "eden/fs/testharness/TestChecks.h"
@@ -436,6 +438,87 @@ TEST(GlobNodeTest, treeLoadError) {
   }
 }
 
+TEST(GlobNodeTest, resultsAreStreamedAsTheyAreFound) {
+  struct RecordingSink : GlobNode::ResultSink {
+    void add(GlobResult&& result) override {
+      results.wlock()->push_back(std::move(result));
+    }
+
+    folly::Synchronized<std::vector<GlobResult>> results;
+  };
+
+  auto mount = TestMount{};
+  auto builder = FakeTreeBuilder{};
+  builder.setFiles({{"dir/a.txt", "a"}, {"dir/sub/b.txt", "b"}});
+  mount.initialize(builder, /*startReady=*/false);
+  builder.setReady("dir");
+
+  GlobNode globRoot(
+      /*includeDotfiles=*/false, mount.getConfig()->getCaseSensitive());
+  globRoot.parse("**/*.txt");
+  RecordingSink sink;
+  auto future = globRoot
+                    .evaluate(
+                        mount.getEdenMount()->getObjectStore(),
+                        ObjectFetchContext::getNullContext(),
+                        RelativePathPiece(),
+                        mount.getTreeInode(RelativePathPiece()),
+                        /*fileBlobsToPrefetch=*/nullptr,
+                        sink,
+                        kZeroRootId)
+                    .semi()
+                    .via(mount.getServerExecutor().get());
+  mount.drainServerExecutor();
+
+  // dir/sub is still loading, but dir/a.txt was already found.
+  EXPECT_FALSE(future.isReady());
+  EXPECT_EQ(
+      (std::vector<GlobResult>{
+          GlobResult("dir/a.txt"_relpath, dtype_t::Regular, kZeroRootId)}),
+      *sink.results.rlock());
+
+  builder.setAllReady();
+  mount.drainServerExecutor();
+  std::move(future).get(kSmallTimeout);
+  EXPECT_EQ(2, sink.results.rlock()->size());
+}
+
+TEST(GlobNodeTest, resultsAreReplayedFromTheResultCache) {
+  auto mount = TestMount{};
+  auto builder = FakeTreeBuilder{};
+  builder.setFiles({{"dir/a.txt", "a"}, {"dir/sub/b.txt", "b"}});
+  mount.initialize(builder);
+  mount.getEdenConfig()->globUseResultCache.setValue(
+      true, ConfigSource::CommandLine);
+  auto subTreeId = builder.getStoredTree("dir/sub"_relpath)->get().getHash();
+
+  for (int i = 0; i < 2; ++i) {
+    SCOPED_TRACE(folly::to<std::string>("evaluation ", i));
+    // Forget the trees, so that walking them again would fetch them from the
+    // backing store.
+    mount.getTreeCache()->clear();
+    mount.getLocalStore()->clearKeySpace(KeySpace::TreeFamily);
+
+    GlobNode globRoot(
+        /*includeDotfiles=*/false, mount.getConfig()->getCaseSensitive());
+    globRoot.parse("**/*.txt");
+    auto prefetchHashes = std::make_shared<GlobNode::PrefetchList>();
+    auto future = evaluateGlob(mount, globRoot, prefetchHashes, kZeroRootId);
+    mount.drainServerExecutor();
+    auto matches = std::move(future).get(kSmallTimeout);
+
+    std::sort(matches.begin(), matches.end());
+    EXPECT_EQ(
+        (std::vector<GlobResult>{
+            GlobResult("dir/a.txt"_relpath, dtype_t::Regular, kZeroRootId),
+            GlobResult(
+                "dir/sub/b.txt"_relpath, dtype_t::Regular, kZeroRootId)}),
+        matches);
+    EXPECT_EQ(2, prefetchHashes->rlock()->size());
+    EXPECT_EQ(1, mount.getBackingStore()->getAccessCount(subTreeId));
+  }
+}
+
 TEST_P(GlobNodeTest, testCommitHashSet) {
   const RootId randomHash{"37ce5515c1b313ce722366c31c10db0883fff7e0"};
 
@@ -10,6 +10,8 @@
 #include <folly/String.h>
 #include <folly/portability/GTest.h>
 #include <folly/test/TestUtils.h>
+#include <atomic>
+#include <thread>
 
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/FileInode.h"
@@ -109,6 +111,52 @@ TEST(InodeMap, simpleLookups) {
       inodeMap->lookupTreeInode(noop->getNodeId()).get(), ENOTDIR);
 }
 
+TEST(InodeMap, memoryUsageGrowsWithLoadedInodes) {
+  FakeTreeBuilder builder;
+  for (int i = 0; i < 100; ++i) {
+    builder.setFile(fmt::format("src/file{}.c", i), "int main() {}\n");
+  }
+  TestMount testMount{builder};
+  auto* inodeMap = testMount.getEdenMount()->getInodeMap();
+
+  auto before = inodeMap->estimateMemoryUsage();
+  testMount.loadAllInodes();
+  auto after = inodeMap->estimateMemoryUsage();
+  EXPECT_GE(after, before + 100 * sizeof(FileInode));
+}
+
+TEST(InodeMap, concurrentLookupsOfLoadedInodes) {
+  FakeTreeBuilder builder;
+  builder.setFile("src/noop.c", "int main() { return 0; }\n");
+  builder.setFile("src/other.c", "int other() { return 1; }\n");
+  TestMount testMount{builder};
+  auto* inodeMap = testMount.getEdenMount()->getInodeMap();
+
+  auto noop = testMount.getFileInode("src/noop.c");
+  auto other = testMount.getFileInode("src/other.c");
+
+  // Loaded inodes are returned immediately, from any thread.
+  std::vector<std::thread> threads;
+  std::atomic<size_t> mismatches{0};
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < 1000; ++j) {
+        auto& expected = j % 2 ? noop : other;
+        auto inode = inodeMap->lookupInode(expected->getNodeId());
+        if (!inode.isReady() ||
+            std::move(inode).get(0ms).get() != expected.get()) {
+          ++mismatches;
+        }
+        inodeMap->lookupLoadedInode(expected->getNodeId());
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, mismatches.load());
+}
+
 TEST(InodeMap, asyncLookup) {
   auto builder = FakeTreeBuilder();
   builder.setFile("README", "docs go here\n");
@@ -558,6 +606,33 @@ TEST(InodeMap, unloadedFileMetadataIsForgotten) {
   EXPECT_FALSE(mount.hasMetadata(file1ino));
   EXPECT_FALSE(mount.hasMetadata(file2ino));
 }
+
+TEST(InodeMap, lookupUnloadedFileParent) {
+  FakeTreeBuilder builder;
+  builder.setFile("dir/file.txt", "contents");
+  TestMount mount{builder};
+  auto inodeMap = mount.getEdenMount()->getInodeMap();
+
+  auto dir = mount.getTreeInode("dir"_relpath);
+  auto file = mount.getFileInode("dir/file.txt"_relpath);
+  auto fileIno = file->getNodeId();
+  file->incFsRefcount();
+
+  // Loaded inodes and directories are not returned.
+  EXPECT_FALSE(inodeMap->lookupUnloadedFileParent(fileIno).has_value());
+  EXPECT_FALSE(
+      inodeMap->lookupUnloadedFileParent(dir->getNodeId()).has_value());
+
+  file.reset();
+  dir->unloadChildrenNow();
+  EXPECT_FALSE(inodeMap->lookupLoadedInode(fileIno));
+  auto parentAndName = inodeMap->lookupUnloadedFileParent(fileIno);
+  ASSERT_TRUE(parentAndName.has_value());
+  EXPECT_EQ(dir, parentAndName->first);
+  EXPECT_EQ("file.txt"_pc, parentAndName->second);
+
+  inodeMap->decFsRefcount(fileIno);
+}
 #endif
 
 struct InodePersistenceTreeTest : ::testing::Test {
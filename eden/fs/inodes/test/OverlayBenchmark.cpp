@@ -9,6 +9,7 @@
 #include <folly/portability/GFlags.h>
 #include <folly/stop_watch.h>
 #include <stdlib.h>
+#include <optional>
 
 #include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/inodes/DirEntry.h"
@@ -19,10 +20,35 @@ using namespace facebook::eden;
 using namespace folly::string_piece_literals;
 
 DEFINE_string(overlayPath, "", "Directory where the test overlay is created");
+DEFINE_string(
+    inodeCatalogType,
+    "default",
+    "Which directory storage to benchmark: default, legacy, tree, "
+    "tree-synchronous-off, tree-buffered or tree-synchronous-off-buffered");
 
 namespace {
 
-void benchmarkOverlayTreeWrites(AbsolutePathPiece overlayPath) {
+std::optional<Overlay::InodeCatalogType> parseInodeCatalogType(
+    folly::StringPiece name) {
+  if (name == "default") {
+    return kDefaultInodeCatalogType;
+  } else if (name == "legacy") {
+    return Overlay::InodeCatalogType::Legacy;
+  } else if (name == "tree") {
+    return Overlay::InodeCatalogType::Tree;
+  } else if (name == "tree-synchronous-off") {
+    return Overlay::InodeCatalogType::TreeSynchronousOff;
+  } else if (name == "tree-buffered") {
+    return Overlay::InodeCatalogType::TreeBuffered;
+  } else if (name == "tree-synchronous-off-buffered") {
+    return Overlay::InodeCatalogType::TreeSynchronousOffBuffered;
+  }
+  return std::nullopt;
+}
+
+void benchmarkOverlayTreeWrites(
+    AbsolutePathPiece overlayPath,
+    Overlay::InodeCatalogType inodeCatalogType) {
   // A large mount will contain 500,000 trees. If they're all loaded, they
   // will all be written into the overlay. This benchmark simulates that
   // workload and measures how long it takes.
@@ -33,7 +59,7 @@ void benchmarkOverlayTreeWrites(AbsolutePathPiece overlayPath) {
   auto overlay = Overlay::create(
       overlayPath,
       kPathMapDefaultCaseSensitive,
-      kDefaultInodeCatalogType,
+      inodeCatalogType,
       std::make_shared<NullStructuredLogger>(),
       *EdenConfig::createTestEdenConfig());
   printf("Initalizing Overlay...\n");
@@ -109,8 +135,17 @@ int main(int argc, char* argv[]) {
     return 1;
   }
 
+  auto inodeCatalogType = parseInodeCatalogType(FLAGS_inodeCatalogType);
+  if (!inodeCatalogType) {
+    fprintf(
+        stderr,
+        "error: unknown inodeCatalogType %s\n",
+        FLAGS_inodeCatalogType.c_str());
+    return 1;
+  }
+
   auto overlayPath = normalizeBestEffort(FLAGS_overlayPath.c_str());
-  benchmarkOverlayTreeWrites(overlayPath);
+  benchmarkOverlayTreeWrites(overlayPath, *inodeCatalogType);
 
   return 0;
 }
@@ -11,17 +11,21 @@
 #include "eden/fs/inodes/fscatalog/FsInodeCatalog.h"
 #include "eden/fs/inodes/test/OverlayTestUtil.h"
 
+#include <folly/Conv.h>
 #include <folly/Exception.h>
 #include <folly/Expected.h>
 #include <folly/FileUtil.h>
 #include <folly/Range.h>
 #include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/io/IOBuf.h>
 #include <folly/experimental/TestUtil.h>
 #include <folly/logging/test/TestLogHandler.h>
 #include <folly/portability/GTest.h>
 #include <folly/synchronization/test/Barrier.h>
 #include <folly/test/TestUtils.h>
 #include <algorithm>
+#include <set>
+#include <thread>
 
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/FileInode.h"
@@ -306,6 +310,85 @@ TEST(PlainOverlayTest, unclean_overlay_is_dirty) {
   EXPECT_FALSE(overlay->hadCleanStartup());
 }
 
+namespace {
+std::shared_ptr<EdenConfig> makeLazyFsckConfig() {
+  auto config = EdenConfig::createTestEdenConfig();
+  config->lazyFsck.setValue(true, ConfigSource::Default, true);
+  return config;
+}
+
+std::shared_ptr<Overlay> openOverlay(
+    AbsolutePathPiece localDir,
+    std::shared_ptr<EdenConfig> config) {
+  auto overlay = Overlay::create(
+      localDir.copy(),
+      kPathMapDefaultCaseSensitive,
+      kInodeCatalogType,
+      std::make_shared<NullStructuredLogger>(),
+      *config);
+  overlay->initialize(std::move(config)).get();
+  return overlay;
+}
+
+void markUnclean(AbsolutePathPiece localDir) {
+  if (unlink((localDir + "next-inode-number"_pc).c_str())) {
+    folly::throwSystemError("removing saved inode number");
+  }
+}
+} // namespace
+
+TEST(PlainOverlayTest, lazy_fsck_numbers_inodes_from_a_reserved_range) {
+  folly::test::TemporaryDirectory testDir;
+  auto localDir = AbsolutePath{testDir.path().string()};
+  openOverlay(localDir, makeLazyFsckConfig())->close();
+  markUnclean(localDir);
+
+  auto overlay = openOverlay(localDir, makeLazyFsckConfig());
+  EXPECT_FALSE(overlay->hadCleanStartup());
+  EXPECT_EQ(InodeNumber{1ull << 48}, overlay->allocateInodeNumber());
+  overlay->close();
+
+  // The range is kept after a clean restart.
+  overlay = openOverlay(localDir, makeLazyFsckConfig());
+  EXPECT_TRUE(overlay->hadCleanStartup());
+  EXPECT_EQ(InodeNumber{(1ull << 48) + 1}, overlay->allocateInodeNumber());
+  overlay->close();
+
+  // And the next background fsck reserves a range above it.
+  markUnclean(localDir);
+  overlay = openOverlay(localDir, makeLazyFsckConfig());
+  EXPECT_EQ(InodeNumber{2ull << 48}, overlay->allocateInodeNumber());
+}
+
+TEST(PlainOverlayTest, lazy_fsck_errors_are_repaired_at_next_start) {
+  folly::test::TemporaryDirectory testDir;
+  auto localDir = AbsolutePath{testDir.path().string()};
+  {
+    auto overlay = openOverlay(localDir, makeLazyFsckConfig());
+    // The root refers to a materialized file that isn't in the overlay.
+    DirContents root(kPathMapDefaultCaseSensitive);
+    root.emplace(
+        PathComponentPiece{"missing"},
+        S_IFREG | 0644,
+        overlay->allocateInodeNumber());
+    overlay->saveOverlayDir(kRootNodeId, root);
+    overlay->close();
+  }
+  markUnclean(localDir);
+
+  // Closing the overlay waits for the background fsck.
+  openOverlay(localDir, makeLazyFsckConfig())->close();
+  auto fsckRequiredPath = localDir + "fsck-required"_pc;
+  EXPECT_EQ(0, access(fsckRequiredPath.c_str(), F_OK));
+  EXPECT_NE(0, access((localDir + "next-inode-number"_pc).c_str(), F_OK));
+
+  // The errors are repaired synchronously, without reserving a new range.
+  auto overlay = openOverlay(localDir, makeLazyFsckConfig());
+  EXPECT_FALSE(overlay->hadCleanStartup());
+  EXPECT_NE(0, access(fsckRequiredPath.c_str(), F_OK));
+  EXPECT_LT(overlay->allocateInodeNumber(), InodeNumber{2ull << 48});
+}
+
 enum class OverlayRestartMode {
   CLEAN,
   UNCLEAN,
@@ -501,6 +584,119 @@ TEST_P(RawOverlayTest, cannot_remove_overlay_file_when_closed) {
       "cannot access overlay after it is closed");
 }
 
+TEST_P(RawOverlayTest, files_materialized_from_a_blob_are_independent) {
+  auto blobId = ObjectId::fromHex("0123456789012345678901234567890123456789");
+  auto contents = folly::IOBuf::copyBuffer("contents");
+  auto readContents = [&](InodeNumber ino) {
+    std::string data;
+    EXPECT_TRUE(folly::readFile(getOverlayFilePath(ino).c_str(), data));
+    return data.substr(FileContentStore::kHeaderLength);
+  };
+
+  auto ino2 = overlay->allocateInodeNumber();
+  overlay->createOverlayFileForBlob(ino2, blobId, *contents);
+  auto ino3 = overlay->allocateInodeNumber();
+  overlay->createOverlayFileForBlob(ino3, blobId, *contents);
+
+  // Writing to one of the files, whether they share data on disk or not,
+  // leaves the other one alone.
+  {
+    folly::File file{getOverlayFilePath(ino2).c_str(), O_WRONLY};
+    ASSERT_EQ(
+        3,
+        folly::pwriteFull(
+            file.fd(), "CON", 3, FileContentStore::kHeaderLength));
+  }
+  EXPECT_EQ("CONtents", readContents(ino2));
+  EXPECT_EQ("contents", readContents(ino3));
+
+  recreate();
+  auto ino4 = overlay->allocateInodeNumber();
+  overlay->createOverlayFileForBlob(ino4, blobId, *contents);
+  EXPECT_EQ("contents", readContents(ino4));
+}
+
+TEST_P(RawOverlayTest, child_changes_survive_restart) {
+  auto dirIno = overlay->allocateInodeNumber();
+  auto otherDirIno = overlay->allocateInodeNumber();
+  auto aIno = overlay->allocateInodeNumber();
+  auto bIno = overlay->allocateInodeNumber();
+  auto cIno = overlay->allocateInodeNumber();
+
+  DirContents dir(kPathMapDefaultCaseSensitive);
+  dir.emplace("a"_pc, S_IFREG | 0644, aIno);
+  overlay->saveOverlayDir(dirIno, dir);
+  DirContents otherDir(kPathMapDefaultCaseSensitive);
+  overlay->saveOverlayDir(otherDirIno, otherDir);
+
+  auto b = dir.emplace("b"_pc, S_IFREG | 0644, bIno);
+  overlay->addChild(dirIno, *b.first, dir);
+  auto c = dir.emplace("c"_pc, S_IFDIR | 0755, cIno);
+  overlay->addChild(dirIno, *c.first, dir);
+  dir.erase("a"_pc);
+  overlay->removeChild(dirIno, "a"_pc, dir);
+  otherDir.emplace("moved"_pc, S_IFREG | 0644, bIno);
+  dir.erase("b"_pc);
+  overlay->renameChild(
+      dirIno, otherDirIno, "b"_pc, "moved"_pc, dir, otherDir);
+
+  recreate();
+
+  auto loaded = overlay->loadOverlayDir(dirIno);
+  ASSERT_EQ(1, loaded.size());
+  EXPECT_EQ(cIno, loaded.at("c"_pc).getInodeNumber());
+  EXPECT_EQ(S_IFDIR | 0755, loaded.at("c"_pc).getInitialMode());
+  auto otherLoaded = overlay->loadOverlayDir(otherDirIno);
+  ASSERT_EQ(1, otherLoaded.size());
+  EXPECT_EQ(bIno, otherLoaded.at("moved"_pc).getInodeNumber());
+}
+
+TEST_P(RawOverlayTest, gc_collects_whole_forgotten_tree) {
+  // A directory with 3 subdirectories, each with 2 subdirectories holding a
+  // file.
+  auto topIno = overlay->allocateInodeNumber();
+  std::vector<InodeNumber> dirInodes;
+  std::vector<InodeNumber> fileInodes;
+  DirContents top(kPathMapDefaultCaseSensitive);
+  for (int i = 0; i < 3; ++i) {
+    auto midIno = overlay->allocateInodeNumber();
+    DirContents mid(kPathMapDefaultCaseSensitive);
+    for (int j = 0; j < 2; ++j) {
+      auto leafIno = overlay->allocateInodeNumber();
+      auto fileIno = overlay->allocateInodeNumber();
+      overlay->createOverlayFile(fileIno, folly::ByteRange{"contents"_sp});
+      DirContents leaf(kPathMapDefaultCaseSensitive);
+      leaf.emplace("file"_pc, S_IFREG | 0644, fileIno);
+      overlay->saveOverlayDir(leafIno, leaf);
+      mid.emplace(
+          PathComponent{folly::to<std::string>("leaf", j)},
+          S_IFDIR | 0755,
+          leafIno);
+      dirInodes.push_back(leafIno);
+      fileInodes.push_back(fileIno);
+    }
+    overlay->saveOverlayDir(midIno, mid);
+    top.emplace(
+        PathComponent{folly::to<std::string>("mid", i)},
+        S_IFDIR | 0755,
+        midIno);
+    dirInodes.push_back(midIno);
+  }
+  overlay->saveOverlayDir(topIno, top);
+
+  overlay->recursivelyRemoveOverlayDir(topIno);
+  overlay->flushPendingAsync().get(std::chrono::seconds{60});
+
+  EXPECT_FALSE(overlay->hasOverlayDir(topIno));
+  for (auto ino : dirInodes) {
+    EXPECT_FALSE(overlay->hasOverlayDir(ino)) << ino;
+  }
+  for (auto ino : fileInodes) {
+    EXPECT_FALSE(overlay->hasOverlayFile(ino)) << ino;
+  }
+  EXPECT_EQ(0, overlay->getGCBacklog());
+}
+
 TEST_P(RawOverlayTest, max_inode_number_is_1_if_overlay_is_empty) {
   EXPECT_EQ(kRootNodeId, overlay->getMaxInodeNumber());
   EXPECT_EQ(2_ino, overlay->allocateInodeNumber());
@@ -516,6 +712,38 @@ TEST_P(RawOverlayTest, max_inode_number_is_1_if_overlay_is_empty) {
   EXPECT_EQ(2_ino, overlay->allocateInodeNumber());
 }
 
+TEST_P(RawOverlayTest, inode_numbers_allocated_by_threads_are_unique) {
+  constexpr size_t kThreads = 4;
+  constexpr size_t kInodesPerThread = 100;
+  std::vector<std::vector<InodeNumber>> allocated(kThreads);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kThreads; ++i) {
+    threads.emplace_back([&, i] {
+      for (size_t j = 0; j < kInodesPerThread; ++j) {
+        allocated[i].push_back(overlay->allocateInodeNumber());
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  // One more from this thread, which is still running.
+  auto last = overlay->allocateInodeNumber();
+
+  std::set<InodeNumber> unique{last};
+  for (const auto& inodes : allocated) {
+    unique.insert(inodes.begin(), inodes.end());
+  }
+  EXPECT_EQ(kThreads * kInodesPerThread + 1, unique.size());
+  EXPECT_EQ(*unique.rbegin(), overlay->getMaxInodeNumber());
+
+  // The unused part of the blocks of the threads isn't skipped.
+  recreate(OverlayRestartMode::CLEAN);
+  EXPECT_EQ(*unique.rbegin(), overlay->getMaxInodeNumber());
+  EXPECT_EQ(
+      InodeNumber{unique.rbegin()->get() + 1}, overlay->allocateInodeNumber());
+}
+
 TEST_P(RawOverlayTest, remembers_max_inode_number_of_tree_inodes) {
   auto ino2 = overlay->allocateInodeNumber();
   EXPECT_EQ(2_ino, ino2);
@@ -18,6 +18,7 @@ using namespace facebook::eden;
 
 struct TestCallbacks : TraversalCallbacks {
   std::vector<RelativePath> paths;
+  std::vector<RelativePath> leftPaths;
 
   void visitTreeInode(
       RelativePathPiece path,
@@ -36,6 +37,10 @@ struct TestCallbacks : TraversalCallbacks {
     (void)entry;
     return true;
   }
+
+  void leaveTreeInode(RelativePathPiece path) override {
+    leftPaths.emplace_back(path);
+  }
 };
 
 TEST(TraverseTest, does_not_traverse_unallocated_and_unmaterialized_trees) {
@@ -74,3 +79,22 @@ TEST(TraverseTest, does_traverse_loaded_trees) {
   EXPECT_EQ("dir1", callbacks.paths.at(2));
   EXPECT_EQ("dir1/dir2", callbacks.paths.at(3));
 }
+
+TEST(TraverseTest, leaves_trees_after_their_children) {
+  FakeTreeBuilder builder;
+  builder.setFile("dir1/dir2/file", "test\n");
+  TestMount mount{builder};
+
+  auto rootPath = RelativePath{""};
+  auto root = mount.getTreeInode(rootPath);
+  auto file = mount.getFileInode("dir1/dir2/file");
+
+  TestCallbacks callbacks;
+  traverseObservedInodes(*root, rootPath, callbacks);
+
+  ASSERT_EQ(4, callbacks.leftPaths.size());
+  EXPECT_EQ(".eden", callbacks.leftPaths.at(0));
+  EXPECT_EQ("dir1/dir2", callbacks.leftPaths.at(1));
+  EXPECT_EQ("dir1", callbacks.leftPaths.at(2));
+  EXPECT_EQ("", callbacks.leftPaths.at(3));
+}
@@ -7,6 +7,7 @@
 
 #include "eden/fs/inodes/TreeInode.h"
 
+#include <fmt/format.h>
 #include <folly/Exception.h>
 #include <folly/Random.h>
 #include <folly/executors/ManualExecutor.h>
@@ -17,6 +18,7 @@
 #include <optional>
 #include "eden/fs/fuse/DirList.h"
 #include "eden/fs/inodes/FileInode.h"
+#include "eden/fs/journal/Journal.h"
 #include "eden/fs/model/Tree.h"
 #include "eden/fs/model/TreeEntry.h"
 #include "eden/fs/nfs/DirList.h"
@@ -199,6 +201,43 @@ TEST(TreeInode, fuseReaddirRespectsOffset) {
   EXPECT_EQ(0, resultE.size());
 }
 
+#ifdef __linux__
+TEST(TreeInode, fuseReaddirPlusEntriesCarryTheirEntryOut) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"file", ""}});
+  TestMount mount{builder};
+
+  auto root = mount.getEdenMount()->getRootInode();
+  auto list = root->fuseReaddir(
+      FuseDirList{4096, /*plus=*/true},
+      0,
+      ObjectFetchContext::getNullContext());
+  auto result = list.extract();
+  ASSERT_EQ(4, result.size());
+  EXPECT_EQ("file", result[2].name);
+
+  fuse_entry_out entryOut = {};
+  entryOut.nodeid = result[2].inode;
+  entryOut.attr.ino = result[2].inode;
+  list.setEntryOut(2, entryOut);
+
+  // The entries are unchanged, and only the entry given attributes has a
+  // nodeid.
+  auto buf = list.getBuf();
+  auto* p = buf.data();
+  for (size_t i = 0; i < result.size(); ++i) {
+    auto* direntplus = reinterpret_cast<const fuse_direntplus*>(p);
+    const auto& dirent = direntplus->dirent;
+    EXPECT_EQ(result[i].name, std::string(dirent.name, dirent.namelen));
+    EXPECT_EQ(static_cast<uint64_t>(result[i].offset), dirent.off);
+    EXPECT_EQ(i == 2 ? result[i].inode : 0, direntplus->entry_out.nodeid);
+    p += FUSE_DIRENTPLUS_SIZE(direntplus);
+  }
+  EXPECT_EQ(buf.end(), p);
+  EXPECT_EQ(4, list.extract().size());
+}
+#endif
+
 TEST(TreeInode, fuseReaddirIgnoresWildOffsets) {
   TestMount mount{FakeTreeBuilder{}};
 
@@ -380,6 +419,50 @@ TEST(TreeInode, fuzzConcurrentModificationAndReaddir) {
   }
   std::cout << "Ran " << iterations << " iterations" << std::endl;
 }
+
+TEST(TreeInode, fuzzConcurrentModificationAndReaddirOfLargeDirectory) {
+  // Large enough for readdir to keep its index of the entries across calls.
+  std::vector<std::string> names;
+  for (int i = 0; i < 2000; ++i) {
+    names.push_back(fmt::format("{:0>{}}", i, kDirListNameSize));
+  }
+
+  for (int i = 0; i < 3; ++i) {
+    runConcurrentModificationAndReaddirIteration(names);
+  }
+}
+
+TEST(TreeInode, readdirOfLargeDirectoryResumesInOrder) {
+  FakeTreeBuilder builder;
+  for (int i = 0; i < 2000; ++i) {
+    builder.setFile(fmt::format("file{}", i), "");
+  }
+  TestMount mount{builder};
+  auto root = mount.getEdenMount()->getRootInode();
+
+  std::vector<std::string> names;
+  off_t lastOffset = 0;
+  for (;;) {
+    auto result = root->fuseReaddir(
+                          FuseDirList{kDirListBufferSize},
+                          lastOffset,
+                          ObjectFetchContext::getNullContext())
+                      .extract();
+    if (result.empty()) {
+      break;
+    }
+    for (auto& entry : result) {
+      EXPECT_GT(entry.offset, lastOffset);
+      lastOffset = entry.offset;
+      names.push_back(entry.name);
+    }
+  }
+
+  // ., .., .eden and the files.
+  EXPECT_EQ(2003, names.size());
+  std::sort(names.begin(), names.end());
+  EXPECT_EQ(names.end(), std::unique(names.begin(), names.end()));
+}
 #endif
 
 TEST(TreeInode, create) {
@@ -399,6 +482,34 @@ TEST(TreeInode, create) {
 #endif
 }
 
+TEST(TreeInode, entriesLoadedFromTreeHaveNoSpareCapacity) {
+  FakeTreeBuilder builder;
+  builder.setFile("somedir/a", "a\n");
+  builder.setFile("somedir/b", "b\n");
+  builder.setFile("somedir/c", "c\n");
+  TestMount mount{builder};
+
+  auto somedir = mount.getTreeInode("somedir"_relpath);
+  auto contents = somedir->getContents().rlock();
+  EXPECT_EQ(3, contents->entries.size());
+  EXPECT_EQ(3, contents->entries.capacity());
+}
+
+TEST(TreeInode, dirContentsSizeCountsLongNames) {
+  DirContents dir{kPathMapDefaultCaseSensitive};
+  dir.emplace("short"_pc, S_IFREG | 0644, InodeNumber{2});
+  auto shortSize = dir.getSizeBytes();
+  EXPECT_EQ(dir.capacity() * sizeof(DirContents::value_type), shortSize);
+
+  dir.emplace(
+      PathComponentPiece{std::string(100, 'x')},
+      S_IFREG | 0644,
+      InodeNumber{3});
+  EXPECT_GT(
+      dir.getSizeBytes(),
+      dir.capacity() * sizeof(DirContents::value_type) + 100);
+}
+
 TEST(TreeInode, createExists) {
   FakeTreeBuilder builder;
   builder.setFile("somedir/foo.txt", "test\n");
@@ -455,6 +566,30 @@ TEST(TreeInode, removeRecursively) {
   EXPECT_THROW_ERRNO(mount.getTreeInode("somedir"_relpath), ENOENT);
 }
 
+TEST(TreeInode, removeRecursivelyUnloadedRecordsOneJournalDelta) {
+  FakeTreeBuilder builder;
+  builder.setFile("somedir/foo.txt", "foo\n");
+  builder.setFile("somedir/otherdir/foo.txt", "test\n");
+  TestMount mount{builder};
+
+  auto& journal = mount.getEdenMount()->getJournal();
+  auto testStart = journal.getLatest()->sequenceID;
+
+  auto root = mount.getEdenMount()->getRootInode();
+  root->removeRecursively(
+          "somedir"_pc,
+          InvalidationRequired::No,
+          ObjectFetchContext::getNullContext())
+      .get(0ms);
+
+  EXPECT_THROW_ERRNO(mount.getTreeInode("somedir"_relpath), ENOENT);
+  auto delta = journal.accumulateRange(testStart + 1);
+  ASSERT_TRUE(delta);
+  EXPECT_EQ(testStart + 1, delta->fromSequence);
+  EXPECT_EQ(testStart + 1, delta->toSequence);
+  EXPECT_EQ(1, delta->changedFilesInOverlay.count("somedir"_relpath));
+}
+
 TEST(TreeInode, removeRecursivelyNotReady) {
   FakeTreeBuilder builder;
   builder.setFile("somedir/foo.txt", "foo\n");
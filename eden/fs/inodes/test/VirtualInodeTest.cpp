@@ -742,6 +742,45 @@ TEST(VirtualInodeTest, getChildrenAttributes) {
   VERIFY_TREE(flags);
 }
 
+TEST(VirtualInodeTest, getSubtreeAttributes) {
+  TestFileDatabase files;
+  auto flags = VERIFY_DEFAULT & (~VERIFY_SHA1);
+  auto mount = TestMount{MakeTestTreeBuilder(files)};
+  VERIFY_TREE(flags);
+  auto requested =
+      ENTRY_ATTRIBUTE_SIZE | ENTRY_ATTRIBUTE_SHA1 | ENTRY_ATTRIBUTE_TYPE;
+
+  auto result = mount.getVirtualInode(RelativePathPiece{})
+                    .getSubtreeAttributes(
+                        requested,
+                        RelativePath{},
+                        mount.getEdenMount()->getObjectStore(),
+                        ObjectFetchContext::getNullContext())
+                    .get(kFutureTimeout);
+
+  size_t expectedEntries = 0;
+  for (auto info : files.getOriginalItems()) {
+    if (info->path.empty()) {
+      continue;
+    }
+    ++expectedEntries;
+    EXPECT_THAT(
+        result,
+        testing::Contains(testing::Pair(
+            info->path,
+            mount.getVirtualInode(info->path)
+                .getEntryAttributes(
+                    requested,
+                    info->path,
+                    mount.getEdenMount()->getObjectStore(),
+                    ObjectFetchContext::getNullContext())
+                .getTry())));
+  }
+  EXPECT_EQ(expectedEntries, result.size());
+  // The walk must not have loaded any inode.
+  VERIFY_TREE(flags);
+}
+
 TEST(VirtualInodeTest, statDoesNotChangeState) {
   TestFileDatabase files;
   auto flags = VERIFY_DEFAULT | VERIFY_STAT;
@@ -883,6 +922,68 @@ TEST(VirtualInodeTest, getEntryAttributesAttributeError) {
   EXPECT_FALSE(attributes.type.value().hasException());
 }
 
+TEST(VirtualInodeTest, getEntryAttributesObjectId) {
+  TestFileDatabase files;
+  auto builder = MakeTestTreeBuilder(files);
+  auto mount = TestMount{builder};
+
+  std::string path = "root_dirA/child1_fileA1";
+  auto attributes = mount.getVirtualInode(path)
+                        .getEntryAttributes(
+                            ENTRY_ATTRIBUTE_OBJECT_ID,
+                            RelativePathPiece{path},
+                            mount.getEdenMount()->getObjectStore(),
+                            ObjectFetchContext::getNullContext())
+                        .get(kFutureTimeout);
+  EXPECT_EQ(
+      builder.getStoredBlob(RelativePathPiece{path})->get().getHash(),
+      attributes.objectId.value().value());
+  EXPECT_FALSE(attributes.sha1.has_value());
+
+  // A materialized file no longer has a source control object.
+  mount.overwriteFile(folly::StringPiece{path}, "new contents");
+  attributes = mount.getVirtualInode(path)
+                   .getEntryAttributes(
+                       ENTRY_ATTRIBUTE_OBJECT_ID,
+                       RelativePathPiece{path},
+                       mount.getEdenMount()->getObjectStore(),
+                       ObjectFetchContext::getNullContext())
+                   .get(kFutureTimeout);
+  EXPECT_TRUE(attributes.objectId.value().hasException());
+}
+
+TEST(VirtualInodeTest, getVirtualInodesMatchesIndividualLookups) {
+  TestFileDatabase files;
+  auto flags = VERIFY_DEFAULT & (~VERIFY_SHA1);
+  auto mount = TestMount{MakeTestTreeBuilder(files)};
+
+  auto originals = files.getOriginalItems();
+  std::vector<RelativePath> paths;
+  for (auto info : originals) {
+    paths.push_back(info->path);
+  }
+  paths.emplace_back("root_dirB/child1_dirB1/missing");
+  paths.emplace_back("root_fileA/not_a_directory");
+  paths.emplace_back("root_dirA");
+
+  auto inodesFuture = mount.getEdenMount()
+                          ->getVirtualInodes(
+                              paths, ObjectFetchContext::getNullContext())
+                          .semi()
+                          .via(mount.getServerExecutor().get());
+  mount.drainServerExecutor();
+  auto inodes = std::move(inodesFuture).get(0ms);
+  ASSERT_EQ(paths.size(), inodes.size());
+
+  for (size_t i = 0; i < originals.size(); ++i) {
+    EXPECT_INODE_OR(inodes[i].value(), *originals[i]);
+  }
+  EXPECT_THROW_ERRNO(inodes[originals.size()].value(), ENOENT);
+  EXPECT_THROW_ERRNO(inodes[originals.size() + 1].value(), ENOTDIR);
+  EXPECT_TRUE(inodes[originals.size() + 2].value().isDirectory());
+  VERIFY_TREE(flags);
+}
+
 TEST(VirtualInodeTest, sha1DoesNotChangeState) {
   TestFileDatabase files;
   auto mount = TestMount{MakeTestTreeBuilder(files)};
@@ -7,10 +7,72 @@
 
 #include "Journal.h"
 #include <folly/logging/xlog.h>
+#include <folly/system/ThreadName.h>
 #include "eden/fs/journal/JournalDelta.h"
+#include "eden/fs/utils/CoarseClock.h"
 
 namespace facebook::eden {
 
+namespace {
+folly::StringPiece eventCharacterizationFor(const PathChangeInfo& ci) {
+  if (ci.existedBefore && !ci.existedAfter) {
+    return "Removed";
+  } else if (!ci.existedBefore && ci.existedAfter) {
+    return "Created";
+  } else if (ci.existedBefore && ci.existedAfter) {
+    return "Changed";
+  } else {
+    return "Ghost";
+  }
+}
+
+/**
+ * Merge the changes of an older delta, or summary of deltas, into
+ * changedFiles, skipping the paths that pathFilter rejects.
+ */
+void mergeOlderChangedFiles(
+    std::unordered_map<RelativePath, PathChangeInfo>& changedFiles,
+    const std::unordered_map<RelativePath, PathChangeInfo>& olderChanges,
+    const Journal::PathFilter& pathFilter = nullptr) {
+  for (auto& entry : olderChanges) {
+    auto& name = entry.first;
+    auto& olderInfo = entry.second;
+    auto* info = folly::get_ptr(changedFiles, name);
+    if (!info) {
+      // Paths already in changedFiles were accepted by a newer delta.
+      if (pathFilter && !pathFilter(name)) {
+        continue;
+      }
+      changedFiles.emplace(name, olderInfo);
+    } else {
+      if (info->existedBefore != olderInfo.existedAfter) {
+        auto event1 = eventCharacterizationFor(olderInfo);
+        auto event2 = eventCharacterizationFor(*info);
+        XLOG(ERR) << "Journal for " << name << " holds invalid " << event1
+                  << ", " << event2 << " sequence";
+      }
+
+      info->existedBefore = olderInfo.existedBefore;
+    }
+  }
+}
+
+size_t estimateChangedFilesMemoryUsage(
+    const std::unordered_map<RelativePath, PathChangeInfo>& changedFiles) {
+  // Same layout assumptions as RootUpdateJournalDelta::estimateMemoryUsage.
+  size_t mem = 0;
+  size_t elemSize = folly::goodMallocSize(
+      sizeof(void*) + sizeof(RelativePath) + sizeof(PathChangeInfo) +
+      sizeof(size_t));
+  mem += elemSize * changedFiles.size();
+  mem += folly::goodMallocSize(sizeof(void*) * changedFiles.bucket_count());
+  for (auto& entry : changedFiles) {
+    mem += estimateIndirectMemoryUsage(entry.first);
+  }
+  return mem;
+}
+} // namespace
+
 JournalDeltaPtr Journal::DeltaState::frontPtr() noexcept {
   bool isFileChangeEmpty = fileChangeDeltas.empty();
   bool isHashUpdateEmpty = hashUpdateDeltas.empty();
@@ -32,18 +94,17 @@ JournalDeltaPtr Journal::DeltaState::frontPtr() noexcept {
 }
 
 void Journal::DeltaState::popFront() {
-  bool isFileChangeEmpty = fileChangeDeltas.empty();
-  bool isHashUpdateEmpty = hashUpdateDeltas.empty();
-  if (!isFileChangeEmpty && !isHashUpdateEmpty) {
-    if (fileChangeDeltas.front().sequenceID <
-        hashUpdateDeltas.front().sequenceID) {
-      fileChangeDeltas.pop_front();
-    } else {
-      hashUpdateDeltas.pop_front();
-    }
-  } else if (!isFileChangeEmpty) {
+  if (isFileChangeInFront()) {
+    auto sequence = fileChangeDeltas.front().sequenceID;
     fileChangeDeltas.pop_front();
-  } else if (!isHashUpdateEmpty) {
+    if (!fileChangeSummaries.empty() &&
+        fileChangeSummaries.front().fromSequence <= sequence) {
+      summaryMemoryUsage -= fileChangeSummaries.front().memoryUsage;
+      fileChangeSummaries.pop_front();
+    } else if (sequence > lastSummarizedSequence) {
+      --unsummarizedFileChanges;
+    }
+  } else if (!hashUpdateDeltas.empty()) {
     hashUpdateDeltas.pop_front();
   }
 }
@@ -90,16 +151,96 @@ bool Journal::DeltaState::isFileChangeInBack() const {
 
 void Journal::DeltaState::appendDelta(FileChangeJournalDelta&& delta) {
   fileChangeDeltas.emplace_back(std::move(delta));
+  if (++unsummarizedFileChanges > kFileChangeSummarySize) {
+    summarizeFileChanges();
+  }
 }
 
 void Journal::DeltaState::appendDelta(RootUpdateJournalDelta&& delta) {
   hashUpdateDeltas.emplace_back(std::move(delta));
 }
 
-Journal::Journal(std::shared_ptr<EdenStats> edenStats)
-    : edenStats_{std::move(edenStats)} {
+void Journal::DeltaState::internPaths(FileChangeJournalDelta& delta) {
+  if (delta.isPath1Valid) {
+    delta.path1 = internPath(delta.path1);
+  }
+  if (delta.isPath2Valid) {
+    delta.path2 = internPath(delta.path2);
+  }
+}
+
+std::shared_ptr<const RelativePath> Journal::DeltaState::internPath(
+    const std::shared_ptr<const RelativePath>& path) {
+  auto it = internedPaths.find(*path);
+  if (it != internedPaths.end()) {
+    auto interned = it->second.lock();
+    XDCHECK(interned);
+    return interned;
+  }
+
+  // The path, its shared_ptr control block and its table entry.
+  size_t memoryUsage = folly::goodMallocSize(sizeof(RelativePath)) +
+      folly::goodMallocSize(4 * sizeof(void*)) +
+      estimateIndirectMemoryUsage(*path);
+  auto interned = std::shared_ptr<const RelativePath>(
+      new RelativePath(*path),
+      [this, memoryUsage](const RelativePath* interned) {
+        internedPaths.erase(*interned);
+        internedPathsMemoryUsage -= memoryUsage;
+        delete interned;
+      });
+  internedPaths.emplace(*interned, interned);
+  internedPathsMemoryUsage += memoryUsage;
+  return interned;
+}
+
+void Journal::DeltaState::summarizeFileChanges() {
+  auto end = fileChangeDeltas.begin() +
+      (fileChangeDeltas.size() - unsummarizedFileChanges +
+       kFileChangeSummarySize);
+  auto begin = end - kFileChangeSummarySize;
+  XDCHECK(end < fileChangeDeltas.end());
+
+  FileChangeSummary summary;
+  summary.fromSequence = begin->sequenceID;
+  summary.fromTime = begin->time;
+  summary.toSequence = (end - 1)->sequenceID;
+  summary.toTime = (end - 1)->time;
+  for (auto it = end; it != begin;) {
+    --it;
+    mergeOlderChangedFiles(
+        summary.changedFilesInOverlay, it->getChangedFilesInOverlay());
+  }
+  summary.memoryUsage = sizeof(FileChangeSummary) +
+      estimateChangedFilesMemoryUsage(summary.changedFilesInOverlay);
+
+  summaryMemoryUsage += summary.memoryUsage;
+  lastSummarizedSequence = summary.toSequence;
+  unsummarizedFileChanges -= kFileChangeSummarySize;
+  fileChangeSummaries.push_back(std::move(summary));
+}
+
+Journal::Journal(
+    std::shared_ptr<EdenStats> edenStats,
+    std::chrono::milliseconds notificationInterval)
+    : edenStats_{std::move(edenStats)},
+      notificationInterval_{notificationInterval} {
   // Add 0 so that this counter shows up in ODS
   edenStats_->increment(&JournalStats::truncatedReads, 0);
+  if (notificationInterval_.count() > 0) {
+    notificationThread_ = std::thread{[this] {
+      folly::setThreadName("JournalNotify");
+      runNotificationThread();
+    }};
+  }
+}
+
+Journal::~Journal() {
+  if (notificationThread_.joinable()) {
+    notificationState_.lock()->stopRequested = true;
+    notificationCondition_.notify_one();
+    notificationThread_.join();
+  }
 }
 
 void Journal::recordCreated(RelativePathPiece fileName) {
@@ -168,7 +309,7 @@ void Journal::truncateIfNecessary(DeltaState& deltaState) {
 
 bool Journal::compact(FileChangeJournalDelta& delta, DeltaState& deltaState) {
   auto back = deltaState.backPtr().getAsFileChangeJournalDelta();
-  if (back && delta.isModification() && delta.isSameAction(*back)) {
+  if (back && delta.canReplace(*back)) {
     deltaState.stats->latestTimestamp = delta.time;
     deltaState.deltaMemoryUsage -= back->estimateMemoryUsage();
     deltaState.deltaMemoryUsage += delta.estimateMemoryUsage();
@@ -187,14 +328,30 @@ bool Journal::compact(
 template <typename T>
 bool Journal::addDeltaBeforeNotifying(T&& delta, DeltaState& deltaState) {
   delta.sequenceID = deltaState.nextSequence++;
-  delta.time = std::chrono::steady_clock::now();
+  // Journal timestamps are only reported, and a tick of precision is enough.
+  delta.time = coarseSteadyNow();
 
+  if (deltaState.log) {
+    deltaState.log->append(delta);
+  }
+  insertDelta(std::forward<T>(delta), deltaState);
+  if (deltaState.log && deltaState.log->shouldCompact()) {
+    rewriteLog(deltaState);
+  }
+
+  bool shouldNotify = deltaState.lastModificationHasBeenObserved;
+  deltaState.lastModificationHasBeenObserved = false;
+  return shouldNotify;
+}
+
+template <typename T>
+void Journal::insertDelta(T&& delta, DeltaState& deltaState) {
   truncateIfNecessary(deltaState);
 
-  // We will compact the delta if possible. We can compact the delta if it is
-  // a modification to a single file and matches the last delta added to the
-  // Journal. For a consumer the only differences seen due to compaction are
-  // that:
+  // We will compact the delta if possible. We can compact the delta if the
+  // last delta added to the Journal is a modification to a single file and
+  // this delta only touches that same file, modifying or removing it. For a
+  // consumer the only differences seen due to compaction are that:
   // - getDebugRawJournalInfo will skip entries in its list
   // - The stats should show a different memory usage and number of entries
   // - accumulateRange will return a different fromSequence and fromTime than
@@ -216,10 +373,70 @@ bool Journal::addDeltaBeforeNotifying(T&& delta, DeltaState& deltaState) {
   }
 
   deltaState.stats->earliestTimestamp = deltaState.frontPtr()->time;
+}
 
-  bool shouldNotify = deltaState.lastModificationHasBeenObserved;
-  deltaState.lastModificationHasBeenObserved = false;
-  return shouldNotify;
+void Journal::rewriteLog(DeltaState& deltaState) {
+  auto& log = *deltaState.log;
+  log.rewrite([&] {
+    auto fileChange = deltaState.fileChangeDeltas.begin();
+    auto rootUpdate = deltaState.hashUpdateDeltas.begin();
+    while (fileChange != deltaState.fileChangeDeltas.end() ||
+           rootUpdate != deltaState.hashUpdateDeltas.end()) {
+      if (rootUpdate == deltaState.hashUpdateDeltas.end() ||
+          (fileChange != deltaState.fileChangeDeltas.end() &&
+           fileChange->sequenceID < rootUpdate->sequenceID)) {
+        log.append(*fileChange++);
+      } else {
+        log.append(*rootUpdate++);
+      }
+    }
+  });
+}
+
+std::optional<uint64_t> Journal::openLog(AbsolutePath path) {
+  auto log = std::make_unique<JournalLog>(std::move(path));
+  auto contents = log->load();
+
+  auto deltaState = deltaState_.lock();
+  XCHECK(deltaState->empty() && !deltaState->log)
+      << "the journal log must be opened before recording changes";
+  std::optional<uint64_t> mountGeneration;
+  if (contents) {
+    mountGeneration = contents->mountGeneration;
+    auto& fileChanges = contents->fileChangeDeltas;
+    auto& rootUpdates = contents->hashUpdateDeltas;
+    auto fileChange = fileChanges.begin();
+    auto rootUpdate = rootUpdates.begin();
+    while (fileChange != fileChanges.end() ||
+           rootUpdate != rootUpdates.end()) {
+      if (rootUpdate == rootUpdates.end() ||
+          (fileChange != fileChanges.end() &&
+           fileChange->sequenceID < rootUpdate->sequenceID)) {
+        deltaState->internPaths(*fileChange);
+        insertDelta(std::move(*fileChange++), *deltaState);
+      } else {
+        insertDelta(std::move(*rootUpdate++), *deltaState);
+      }
+    }
+    deltaState->nextSequence = contents->nextSequence;
+    deltaState->currentHash = std::move(contents->currentHash);
+  }
+
+  // Start the log over with the loaded deltas, which also drops the mark of
+  // the clean close: if this process crashes, the log isn't loaded again.
+  deltaState->log = std::move(log);
+  rewriteLog(*deltaState);
+  return mountGeneration;
+}
+
+void Journal::closeLog(uint64_t mountGeneration) {
+  auto deltaState = deltaState_.lock();
+  if (!deltaState->log) {
+    return;
+  }
+  deltaState->log->close(
+      mountGeneration, deltaState->nextSequence, deltaState->currentHash);
+  deltaState->log.reset();
 }
 
 void Journal::notifySubscribers() const {
@@ -229,14 +446,60 @@ void Journal::notifySubscribers() const {
   }
 }
 
+void Journal::requestNotification() {
+  if (!notificationThread_.joinable()) {
+    notifySubscribers();
+    return;
+  }
+  // The notification thread clears the flag before notifying subscribers,
+  // a change that still finds it set will thus be observed by them.
+  if (notificationPending_.exchange(true, std::memory_order_acq_rel)) {
+    return;
+  }
+  notificationState_.lock()->requestedAt = std::chrono::steady_clock::now();
+  notificationCondition_.notify_one();
+}
+
+void Journal::runNotificationThread() {
+  // Far enough in the past for the first notification not to wait.
+  auto lastNotification =
+      std::chrono::steady_clock::now() - notificationInterval_;
+  while (true) {
+    std::chrono::steady_clock::time_point requestedAt;
+    {
+      auto state = notificationState_.lock();
+      notificationCondition_.wait(state.as_lock(), [&] {
+        return state->stopRequested || state->requestedAt.has_value();
+      });
+      // Let the changes recorded until then be covered by this notification.
+      notificationCondition_.wait_until(
+          state.as_lock(), lastNotification + notificationInterval_, [&] {
+            return state->stopRequested;
+          });
+      if (state->stopRequested) {
+        return;
+      }
+      requestedAt = *state->requestedAt;
+      state->requestedAt.reset();
+    }
+    notificationPending_.store(false, std::memory_order_release);
+
+    lastNotification = std::chrono::steady_clock::now();
+    edenStats_->addDuration(
+        &JournalStats::notificationLag, lastNotification - requestedAt);
+    notifySubscribers();
+  }
+}
+
 void Journal::addDelta(FileChangeJournalDelta&& delta) {
   bool shouldNotify;
   {
     auto deltaState = deltaState_.lock();
+    deltaState->internPaths(delta);
     shouldNotify = addDeltaBeforeNotifying(std::move(delta), *deltaState);
   }
   if (shouldNotify) {
-    notifySubscribers();
+    requestNotification();
   }
 }
 
@@ -254,7 +517,7 @@ void Journal::addDelta(RootUpdateJournalDelta&& delta, RootId newRootId) {
     deltaState->currentHash = std::move(newRootId);
   }
   if (shouldNotify) {
-    notifySubscribers();
+    requestNotification();
   }
 }
 
@@ -319,20 +582,6 @@ std::optional<InternalJournalStats> Journal::getStats() {
   return deltaState_.lock()->stats;
 }
 
-namespace {
-folly::StringPiece eventCharacterizationFor(const PathChangeInfo& ci) {
-  if (ci.existedBefore && !ci.existedAfter) {
-    return "Removed";
-  } else if (!ci.existedBefore && ci.existedAfter) {
-    return "Created";
-  } else if (ci.existedBefore && ci.existedAfter) {
-    return "Changed";
-  } else {
-    return "Ghost";
-  }
-}
-} // namespace
-
 void Journal::setMemoryLimit(size_t limit) {
   auto deltaState = deltaState_.lock();
   deltaState->memoryLimit = limit;
@@ -366,6 +615,9 @@ size_t Journal::estimateMemoryUsage(const DeltaState& deltaState) const {
   if (deltaState.stats) {
     memoryUsage += deltaState.deltaMemoryUsage;
   }
+  memoryUsage += deltaState.summaryMemoryUsage;
+  memoryUsage += deltaState.internedPathsMemoryUsage +
+      deltaState.internedPaths.getAllocatedMemorySize();
   return memoryUsage;
 }
 
@@ -377,7 +629,13 @@ void Journal::flush() {
     auto lastHash = deltaState->currentHash;
     deltaState->fileChangeDeltas.clear();
     deltaState->hashUpdateDeltas.clear();
+    deltaState->fileChangeSummaries.clear();
+    deltaState->unsummarizedFileChanges = 0;
+    deltaState->summaryMemoryUsage = 0;
     deltaState->stats = std::nullopt;
+    if (deltaState->log) {
+      rewriteLog(*deltaState);
+    }
     auto delta = RootUpdateJournalDelta();
     /* Tracking the hash correctly when the journal is flushed is important
      * since Watchman uses the hash to correctly determine what additional files
@@ -390,12 +648,13 @@ void Journal::flush() {
     shouldNotify = addDeltaBeforeNotifying(std::move(delta), *deltaState);
   }
   if (shouldNotify) {
-    notifySubscribers();
+    requestNotification();
   }
 }
 
 std::unique_ptr<JournalDeltaRange> Journal::accumulateRange(
-    SequenceNumber from) {
+    SequenceNumber from,
+    const PathFilter& pathFilter) {
   XDCHECK(from > 0);
   std::unique_ptr<JournalDeltaRange> result = nullptr;
 
@@ -406,57 +665,79 @@ std::unique_ptr<JournalDeltaRange> Journal::accumulateRange(
     result = std::make_unique<JournalDeltaRange>();
     result->isTruncated = true;
   } else {
-    forEachDelta(
-        *deltaState,
+    auto extendRange = [&](SequenceNumber sequence,
+                           std::chrono::steady_clock::time_point time) {
+      if (!result) {
+        result = std::make_unique<JournalDeltaRange>();
+        result->toSequence = sequence;
+        result->toTime = time;
+        result->fromSequence = sequence;
+        result->fromTime = time;
+        result->snapshotTransitions.push_back(deltaState->currentHash);
+        return;
+      }
+      if (sequence > result->toSequence) {
+        result->toSequence = sequence;
+        result->toTime = time;
+      }
+      // Capture the lower bound.
+      if (sequence < result->fromSequence) {
+        result->fromSequence = sequence;
+        result->fromTime = time;
+      }
+    };
+
+    // Root updates are rare, and their order matters.
+    for (auto it = deltaState->hashUpdateDeltas.rbegin();
+         it != deltaState->hashUpdateDeltas.rend() && it->sequenceID >= from;
+         ++it) {
+      extendRange(it->sequenceID, it->time);
+      result->snapshotTransitions.push_back(it->fromHash);
+
+      // Merge the unclean status list
+      for (const auto& path : it->uncleanPaths) {
+        if (!pathFilter || pathFilter(path)) {
+          result->uncleanPaths.insert(path);
+        }
+      }
+    }
+
+    // File changes are merged from the newest to the oldest, using the
+    // summaries of the blocks that are entirely in the range.
+    const auto& deltas = deltaState->fileChangeDeltas;
+    const auto& summaries = deltaState->fileChangeSummaries;
+    auto begin = std::lower_bound(
+        deltas.begin(),
+        deltas.end(),
         from,
-        std::nullopt,
-        [&](const FileChangeJournalDelta& current) -> void {
-          ++filesAccumulated;
-          if (!result) {
-            result = std::make_unique<JournalDeltaRange>();
-            result->toSequence = current.sequenceID;
-            result->toTime = current.time;
-            result->snapshotTransitions.push_back(deltaState->currentHash);
-          }
-          // Capture the lower bound.
-          result->fromSequence = current.sequenceID;
-          result->fromTime = current.time;
-
-          for (auto& entry : current.getChangedFilesInOverlay()) {
-            auto& name = entry.first;
-            auto& currentInfo = entry.second;
-            auto* resultInfo =
-                folly::get_ptr(result->changedFilesInOverlay, name);
-            if (!resultInfo) {
-              result->changedFilesInOverlay.emplace(name, currentInfo);
-            } else {
-              if (resultInfo->existedBefore != currentInfo.existedAfter) {
-                auto event1 = eventCharacterizationFor(currentInfo);
-                auto event2 = eventCharacterizationFor(*resultInfo);
-                XLOG(ERR) << "Journal for " << name << " holds invalid "
-                          << event1 << ", " << event2 << " sequence";
-              }
-
-              resultInfo->existedBefore = currentInfo.existedBefore;
-            }
-          }
-        },
-        [&](const RootUpdateJournalDelta& current) -> void {
-          if (!result) {
-            result = std::make_unique<JournalDeltaRange>();
-            result->toSequence = current.sequenceID;
-            result->toTime = current.time;
-            result->snapshotTransitions.push_back(deltaState->currentHash);
-          }
-          // Capture the lower bound.
-          result->fromSequence = current.sequenceID;
-          result->fromTime = current.time;
-          result->snapshotTransitions.push_back(current.fromHash);
-
-          // Merge the unclean status list
-          result->uncleanPaths.insert(
-              current.uncleanPaths.begin(), current.uncleanPaths.end());
+        [](const FileChangeJournalDelta& delta, SequenceNumber sequence) {
+          return delta.sequenceID < sequence;
         });
+    auto summaryIt = summaries.rbegin();
+    auto it = deltas.end();
+    while (it != begin) {
+      if (summaryIt != summaries.rend() && summaryIt->fromSequence >= from &&
+          (it - 1)->sequenceID == summaryIt->toSequence) {
+        extendRange(summaryIt->toSequence, summaryIt->toTime);
+        mergeOlderChangedFiles(
+            result->changedFilesInOverlay,
+            summaryIt->changedFilesInOverlay,
+            pathFilter);
+        extendRange(summaryIt->fromSequence, summaryIt->fromTime);
+        filesAccumulated += kFileChangeSummarySize;
+        it -= kFileChangeSummarySize;
+        ++summaryIt;
+        continue;
+      }
+
+      --it;
+      ++filesAccumulated;
+      extendRange(it->sequenceID, it->time);
+      mergeOlderChangedFiles(
+          result->changedFilesInOverlay,
+          it->getChangedFilesInOverlay(),
+          pathFilter);
+    }
   }
 
   if (result) {
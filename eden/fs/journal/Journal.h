@@ -9,18 +9,28 @@
 
 #include <folly/Function.h>
 #include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <memory>
+#include <mutex>
 #include <optional>
+#include <thread>
 #include <unordered_map>
 #include "eden/fs/journal/JournalDelta.h"
+#include "eden/fs/journal/JournalLog.h"
 #include "eden/fs/model/RootId.h"
 #include "eden/fs/service/gen-cpp2/streamingeden_types.h"
 #include "eden/fs/telemetry/EdenStats.h"
+#include "eden/fs/telemetry/LockContention.h"
 
 namespace facebook::eden {
 
+inline constexpr char kJournalDeltaStateLockSite[] = "journal_delta_state";
+
 /** Contains statistics about the current state of the journal */
 struct InternalJournalStats {
   size_t entryCount = 0;
@@ -55,19 +65,49 @@ struct JournalDeltaInfo {
  * the larger list of files.
  *
  * The Journal class is thread-safe.  Subscribers are called on the thread
- * that called addDelta.
+ * that called addDelta, unless the Journal has a notification interval, in
+ * which case they are called on its notification thread.
  */
 class Journal {
  public:
   using SequenceNumber = JournalDelta::SequenceNumber;
   using SubscriberId = uint64_t;
   using SubscriberCallback = std::function<void()>;
+  /** Returns whether a changed path should be accumulated. */
+  using PathFilter = std::function<bool(RelativePathPiece)>;
 
-  explicit Journal(std::shared_ptr<EdenStats> edenStats);
+  /**
+   * With a non-zero notificationInterval, subscribers are notified from a
+   * dedicated thread at most once per notificationInterval, however many
+   * changes are recorded in between, and recording a change doesn't wait
+   * for them.
+   */
+  explicit Journal(
+      std::shared_ptr<EdenStats> edenStats,
+      std::chrono::milliseconds notificationInterval =
+          std::chrono::milliseconds{0});
+  ~Journal();
 
   Journal(const Journal&) = delete;
   Journal& operator=(const Journal&) = delete;
 
+  /**
+   * Keep the deltas in a JournalLog at path, so that they survive restarts
+   * and graceful takeovers. If the log at path was closed cleanly, its deltas
+   * are loaded first, and the generation of the mount that closed it is
+   * returned: a mount reusing it keeps the positions it handed out valid.
+   *
+   * Must be called before any change is recorded.
+   */
+  std::optional<uint64_t> openLog(AbsolutePath path);
+
+  /**
+   * Write the changes recorded so far to the log and mark it as closed
+   * cleanly by a mount of this generation. The later changes are not
+   * persisted.
+   */
+  void closeLog(uint64_t mountGeneration);
+
   // Functions to record writes:
 
   void recordCreated(RelativePathPiece fileName);
@@ -120,9 +160,16 @@ class Journal {
    * The default limit value indicates that all deltas should be summed.
    *
    * If the limitSequence means that no deltas will match, returns nullptr.
+   *
+   * Blocks of kFileChangeSummarySize file changes that are entirely in the
+   * range are merged from their precomputed summaries rather than replayed.
+   *
+   * When pathFilter is set, only the changed and unclean paths it accepts are
+   * accumulated. It is called with the Journal lock held.
    */
   std::unique_ptr<JournalDeltaRange> accumulateRange(
-      SequenceNumber limitSequence = 1);
+      SequenceNumber limitSequence = 1,
+      const PathFilter& pathFilter = nullptr);
 
   // Subscription functionality:
 
@@ -188,23 +235,66 @@ class Journal {
 
   static constexpr size_t kDefaultJournalMemoryLimit = 1000000000;
 
+  /**
+   * Number of consecutive FileChangeJournalDeltas accumulated into each
+   * FileChangeSummary.
+   */
+  static constexpr size_t kFileChangeSummarySize = 1024;
+
+  /**
+   * The accumulation of a block of consecutive FileChangeJournalDeltas, as
+   * accumulateRange would compute it.
+   */
+  struct FileChangeSummary {
+    SequenceNumber fromSequence;
+    SequenceNumber toSequence;
+    std::chrono::steady_clock::time_point fromTime;
+    std::chrono::steady_clock::time_point toTime;
+    std::unordered_map<RelativePath, PathChangeInfo> changedFilesInOverlay;
+    size_t memoryUsage = 0;
+  };
+
   struct DeltaState {
     /**
      * The sequence number that we'll use for the next entry that we link into
      * the chain.
      */
     SequenceNumber nextSequence{1};
+    /**
+     * The paths of fileChangeDeltas, each stored once however many deltas
+     * touch it. An entry is removed when the last delta referencing its path
+     * is destroyed, which is why this must be declared before the deltas.
+     */
+    folly::F14FastMap<RelativePathPiece, std::weak_ptr<const RelativePath>>
+        internedPaths;
+    size_t internedPathsMemoryUsage = 0;
     /**
      * All recorded entries. Newer (more recent) deltas are added to the back of
      * the appropriate deque.
      */
     std::deque<FileChangeJournalDelta> fileChangeDeltas;
     std::deque<RootUpdateJournalDelta> hashUpdateDeltas;
+    /**
+     * Summaries of consecutive blocks of kFileChangeSummarySize
+     * fileChangeDeltas, oldest first, so that accumulateRange doesn't need to
+     * replay every delta of a long range. A summary is dropped as soon as its
+     * oldest delta is truncated.
+     *
+     * The back delta may still be compacted, the deltas are thus only
+     * summarized once a full block of them is older than it.
+     */
+    std::deque<FileChangeSummary> fileChangeSummaries;
+    /// Number of deltas at the back of fileChangeDeltas not summarized yet.
+    size_t unsummarizedFileChanges = 0;
+    SequenceNumber lastSummarizedSequence = 0;
+    size_t summaryMemoryUsage = 0;
     RootId currentHash;
     /// The stats about this Journal up to the latest delta.
     std::optional<InternalJournalStats> stats;
     size_t memoryLimit = kDefaultJournalMemoryLimit;
     size_t deltaMemoryUsage = 0;
+    /// Set between openLog and closeLog.
+    std::unique_ptr<JournalLog> log;
 
     // Set to false when a delta is added.
     // Set to true when getLatest() or accumulateRange() are called.
@@ -225,6 +315,19 @@ class Journal {
     void appendDelta(FileChangeJournalDelta&& delta);
     void appendDelta(RootUpdateJournalDelta&& delta);
 
+    /**
+     * Replace the paths of delta with the ones shared with the other deltas.
+     */
+    void internPaths(FileChangeJournalDelta& delta);
+    std::shared_ptr<const RelativePath> internPath(
+        const std::shared_ptr<const RelativePath>& path);
+
+    /**
+     * Summarize the oldest kFileChangeSummarySize unsummarized deltas, which
+     * must not include the back delta.
+     */
+    void summarizeFileChanges();
+
     JournalDelta::SequenceNumber getFrontSequenceID() const {
       if (isFileChangeInFront()) {
         return fileChangeDeltas.front().sequenceID;
@@ -233,7 +336,10 @@ class Journal {
       }
     }
   };
-  folly::Synchronized<DeltaState, std::mutex> deltaState_;
+  folly::Synchronized<
+      DeltaState,
+      InstrumentedMutex<std::mutex, kJournalDeltaStateLockSite>>
+      deltaState_;
 
   /**
    * Removes the oldest deltas until the memory usage of the journal is below
@@ -264,12 +370,32 @@ class Journal {
   template <typename T>
   [[nodiscard]] bool addDeltaBeforeNotifying(T&& delta, DeltaState& deltaState);
 
+  /**
+   * Insert a delta that has its sequence number and timestamp, truncating or
+   * compacting older deltas if needed.
+   */
+  template <typename T>
+  void insertDelta(T&& delta, DeltaState& deltaState);
+
+  /**
+   * Replace the contents of the log with the deltas in memory.
+   */
+  void rewriteLog(DeltaState& deltaState);
+
   /**
    * Notify subscribers that a change has happened. Must not be called while
    * Journal locks are held.
    */
   void notifySubscribers() const;
 
+  /**
+   * Notify subscribers, either right away or through the notification
+   * thread. Must not be called while Journal locks are held.
+   */
+  void requestNotification();
+
+  void runNotificationThread();
+
   size_t estimateMemoryUsage(const DeltaState& deltaState) const;
 
   /**
@@ -288,5 +414,23 @@ class Journal {
   folly::Synchronized<SubscriberState> subscriberState_;
 
   std::shared_ptr<EdenStats> edenStats_;
+
+  struct NotificationState {
+    bool stopRequested = false;
+    /// When the oldest change that subscribers were not notified of yet was
+    /// recorded.
+    std::optional<std::chrono::steady_clock::time_point> requestedAt;
+  };
+
+  const std::chrono::milliseconds notificationInterval_;
+  /**
+   * Set while a notification is waiting for the notification thread, so
+   * that the changes recorded meanwhile only need to check it.
+   */
+  std::atomic<bool> notificationPending_{false};
+  folly::Synchronized<NotificationState, std::mutex> notificationState_;
+  std::condition_variable notificationCondition_;
+  // Only started with a non-zero notificationInterval_.
+  std::thread notificationThread_;
 };
 } // namespace facebook::eden
@@ -13,21 +13,21 @@ namespace facebook::eden {
 FileChangeJournalDelta::FileChangeJournalDelta(
     RelativePathPiece fileName,
     FileChangeJournalDelta::Created)
-    : path1{fileName.copy()},
+    : path1{std::make_shared<const RelativePath>(fileName.copy())},
       info1{PathChangeInfo{false, true}},
       isPath1Valid{true} {}
 
 FileChangeJournalDelta::FileChangeJournalDelta(
     RelativePathPiece fileName,
     FileChangeJournalDelta::Removed)
-    : path1{fileName.copy()},
+    : path1{std::make_shared<const RelativePath>(fileName.copy())},
       info1{PathChangeInfo{true, false}},
       isPath1Valid{true} {}
 
 FileChangeJournalDelta::FileChangeJournalDelta(
     RelativePathPiece fileName,
     FileChangeJournalDelta::Changed)
-    : path1{fileName.copy()},
+    : path1{std::make_shared<const RelativePath>(fileName.copy())},
       info1{PathChangeInfo{true, true}},
       isPath1Valid{true} {}
 
@@ -35,8 +35,8 @@ FileChangeJournalDelta::FileChangeJournalDelta(
     RelativePathPiece oldName,
     RelativePathPiece newName,
     FileChangeJournalDelta::Renamed)
-    : path1{oldName.copy()},
-      path2{newName.copy()},
+    : path1{std::make_shared<const RelativePath>(oldName.copy())},
+      path2{std::make_shared<const RelativePath>(newName.copy())},
       info1{PathChangeInfo{true, false}},
       info2{PathChangeInfo{false, true}},
       isPath1Valid{true},
@@ -46,28 +46,15 @@ FileChangeJournalDelta::FileChangeJournalDelta(
     RelativePathPiece oldName,
     RelativePathPiece newName,
     FileChangeJournalDelta::Replaced)
-    : path1{oldName.copy()},
-      path2{newName.copy()},
+    : path1{std::make_shared<const RelativePath>(oldName.copy())},
+      path2{std::make_shared<const RelativePath>(newName.copy())},
       info1{PathChangeInfo{true, false}},
       info2{PathChangeInfo{true, true}},
       isPath1Valid{true},
       isPath2Valid{true} {}
 
 size_t FileChangeJournalDelta::estimateMemoryUsage() const {
-  size_t mem = sizeof(FileChangeJournalDelta);
-
-  /* NOTE: The following code assumes an unordered_set is separated into an
-   * array of buckets, each one being a chain of nodes containing a next
-   * pointer, a key-value pair, and a stored hash
-   */
-  if (isPath1Valid) {
-    mem += facebook::eden::estimateIndirectMemoryUsage(path1);
-  }
-  if (isPath2Valid) {
-    mem += facebook::eden::estimateIndirectMemoryUsage(path2);
-  }
-
-  return mem;
+  return sizeof(FileChangeJournalDelta);
 }
 
 size_t RootUpdateJournalDelta::estimateMemoryUsage() const {
@@ -101,10 +88,10 @@ std::unordered_map<RelativePath, PathChangeInfo>
 FileChangeJournalDelta::getChangedFilesInOverlay() const {
   std::unordered_map<RelativePath, PathChangeInfo> changedFilesInOverlay;
   if (isPath1Valid) {
-    changedFilesInOverlay[path1] = info1;
+    changedFilesInOverlay[*path1] = info1;
   }
   if (isPath2Valid) {
-    changedFilesInOverlay[path2] = info2;
+    changedFilesInOverlay[*path2] = info2;
   }
   return changedFilesInOverlay;
 }
@@ -114,11 +101,32 @@ bool FileChangeJournalDelta::isModification() const {
       info1.existedAfter;
 }
 
+namespace {
+bool isSamePath(
+    bool isValid,
+    const std::shared_ptr<const RelativePath>& path,
+    bool isOtherValid,
+    const std::shared_ptr<const RelativePath>& otherPath) {
+  if (isValid != isOtherValid) {
+    return false;
+  }
+  return !isValid || path == otherPath || *path == *otherPath;
+}
+} // namespace
+
 bool FileChangeJournalDelta::isSameAction(
     const FileChangeJournalDelta& other) const {
-  return isPath1Valid == other.isPath1Valid && info1 == other.info1 &&
-      path1 == other.path1 && isPath2Valid == other.isPath2Valid &&
-      info2 == other.info2 && path2 == other.path2;
+  return info1 == other.info1 &&
+      isSamePath(isPath1Valid, path1, other.isPath1Valid, other.path1) &&
+      info2 == other.info2 &&
+      isSamePath(isPath2Valid, path2, other.isPath2Valid, other.path2);
+}
+
+bool FileChangeJournalDelta::canReplace(
+    const FileChangeJournalDelta& older) const {
+  return older.isModification() && isPath1Valid && !isPath2Valid &&
+      info1.existedBefore &&
+      isSamePath(isPath1Valid, path1, older.isPath1Valid, older.path1);
 }
 
 JournalDeltaPtr::JournalDeltaPtr(std::nullptr_t) {}
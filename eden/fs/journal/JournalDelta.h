@@ -8,6 +8,7 @@
 #pragma once
 
 #include <chrono>
+#include <memory>
 #include <type_traits>
 #include <unordered_set>
 #include <variant>
@@ -95,9 +96,14 @@ class FileChangeJournalDelta : public JournalDelta {
       RelativePathPiece newName,
       Replaced);
 
-  /** Which of these paths actually contain information */
-  RelativePath path1;
-  RelativePath path2;
+  /**
+   * Which of these paths actually contain information.
+   *
+   * The Journal replaces them with the copy it shares between all the deltas
+   * that touch the same path.
+   */
+  std::shared_ptr<const RelativePath> path1;
+  std::shared_ptr<const RelativePath> path2;
   PathChangeInfo info1;
   PathChangeInfo info2;
   bool isPath1Valid = false;
@@ -113,7 +119,18 @@ class FileChangeJournalDelta : public JournalDelta {
    * sequenceID [whether they do the same action] */
   bool isSameAction(const FileChangeJournalDelta& other) const;
 
-  /** Get memory used (in bytes) by this Delta */
+  /**
+   * Checks whether this delta can take the place of the older delta that
+   * immediately precedes it without any reader noticing: the older delta
+   * only modified a file, and this one only touches that same file, which
+   * therefore existed before it.
+   */
+  bool canReplace(const FileChangeJournalDelta& older) const;
+
+  /**
+   * Get memory used (in bytes) by this Delta. The paths are shared between
+   * deltas and accounted for separately by the Journal.
+   */
   size_t estimateMemoryUsage() const;
 };
 
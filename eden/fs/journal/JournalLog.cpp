@@ -0,0 +1,298 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/journal/JournalLog.h"
+
+#include <folly/Exception.h>
+#include <folly/FileUtil.h>
+#include <folly/lang/Bits.h>
+#include <folly/logging/xlog.h>
+#include <folly/portability/Fcntl.h>
+#include <cstring>
+#include <stdexcept>
+
+#include "eden/fs/utils/FileUtils.h"
+
+namespace facebook::eden {
+
+namespace {
+
+constexpr folly::StringPiece kMagic{"eden-journal-log-1"};
+
+enum RecordType : uint8_t {
+  kFileChangeRecord = 1,
+  kRootUpdateRecord = 2,
+  /** The last record of a log closed cleanly. */
+  kClosedRecord = 3,
+};
+
+enum FileChangeFlags : uint8_t {
+  kPath1Valid = 1 << 0,
+  kPath2Valid = 1 << 1,
+  kPath1ExistedBefore = 1 << 2,
+  kPath1ExistedAfter = 1 << 3,
+  kPath2ExistedBefore = 1 << 4,
+  kPath2ExistedAfter = 1 << 5,
+};
+
+void appendInt(std::string& out, uint64_t value) {
+  value = folly::Endian::little(value);
+  out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void appendString(std::string& out, folly::StringPiece str) {
+  appendInt(out, str.size());
+  out.append(str.data(), str.size());
+}
+
+class RecordReader {
+ public:
+  explicit RecordReader(folly::StringPiece data) : data_{data} {}
+
+  bool done() const {
+    return data_.empty();
+  }
+
+  uint8_t readByte() {
+    need(1);
+    auto value = static_cast<uint8_t>(data_.front());
+    data_.advance(1);
+    return value;
+  }
+
+  uint64_t readInt() {
+    uint64_t value;
+    need(sizeof(value));
+    std::memcpy(&value, data_.data(), sizeof(value));
+    data_.advance(sizeof(value));
+    return folly::Endian::little(value);
+  }
+
+  folly::StringPiece readString() {
+    auto size = readInt();
+    need(size);
+    auto str = data_.subpiece(0, size);
+    data_.advance(size);
+    return str;
+  }
+
+ private:
+  void need(size_t size) const {
+    if (data_.size() < size) {
+      throw std::out_of_range("journal log record cut short");
+    }
+  }
+
+  folly::StringPiece data_;
+};
+
+} // namespace
+
+JournalLog::JournalLog(AbsolutePath path)
+    : path_{std::move(path)},
+      systemMinusSteady_{
+          std::chrono::system_clock::now().time_since_epoch() -
+          std::chrono::duration_cast<std::chrono::system_clock::duration>(
+              std::chrono::steady_clock::now().time_since_epoch())} {}
+
+JournalLog::~JournalLog() {
+  flush();
+}
+
+std::optional<JournalLog::Contents> JournalLog::load() const {
+  auto data = readFile(path_);
+  if (data.hasException()) {
+    XLOG(DBG2) << "no journal log to load at " << path_ << ": "
+               << data.exception().what();
+    return std::nullopt;
+  }
+
+  try {
+    RecordReader reader{data.value()};
+    if (reader.readString() != kMagic) {
+      throw std::runtime_error("unknown journal log format");
+    }
+    Contents contents;
+    while (!reader.done()) {
+      switch (reader.readByte()) {
+        case kFileChangeRecord: {
+          FileChangeJournalDelta delta;
+          delta.sequenceID = reader.readInt();
+          delta.time = fromSystemNanos(reader.readInt());
+          auto flags = reader.readByte();
+          delta.isPath1Valid = flags & kPath1Valid;
+          delta.isPath2Valid = flags & kPath2Valid;
+          delta.info1 = PathChangeInfo{
+              bool(flags & kPath1ExistedBefore),
+              bool(flags & kPath1ExistedAfter)};
+          delta.info2 = PathChangeInfo{
+              bool(flags & kPath2ExistedBefore),
+              bool(flags & kPath2ExistedAfter)};
+          if (delta.isPath1Valid) {
+            delta.path1 =
+                std::make_shared<const RelativePath>(reader.readString());
+          }
+          if (delta.isPath2Valid) {
+            delta.path2 =
+                std::make_shared<const RelativePath>(reader.readString());
+          }
+          contents.fileChangeDeltas.push_back(std::move(delta));
+          break;
+        }
+        case kRootUpdateRecord: {
+          RootUpdateJournalDelta delta;
+          delta.sequenceID = reader.readInt();
+          delta.time = fromSystemNanos(reader.readInt());
+          delta.fromHash = RootId{reader.readString().str()};
+          auto uncleanCount = reader.readInt();
+          for (uint64_t i = 0; i < uncleanCount; ++i) {
+            delta.uncleanPaths.emplace(reader.readString());
+          }
+          contents.hashUpdateDeltas.push_back(std::move(delta));
+          break;
+        }
+        case kClosedRecord:
+          contents.mountGeneration = reader.readInt();
+          contents.nextSequence = reader.readInt();
+          contents.currentHash = RootId{reader.readString().str()};
+          if (!reader.done()) {
+            throw std::runtime_error("records after the end of the log");
+          }
+          XLOG(DBG2) << "loaded journal log " << path_ << " with "
+                     << contents.fileChangeDeltas.size() << " file changes and "
+                     << contents.hashUpdateDeltas.size() << " root updates";
+          return contents;
+        default:
+          throw std::runtime_error("unknown journal log record");
+      }
+    }
+    XLOG(INFO) << "discarding journal log " << path_
+               << " that wasn't closed cleanly";
+  } catch (const std::exception& ex) {
+    XLOG(WARN) << "discarding corrupt journal log " << path_ << ": "
+               << folly::exceptionStr(ex);
+  }
+  return std::nullopt;
+}
+
+void JournalLog::append(const FileChangeJournalDelta& delta) {
+  if (!file_ && !rewriting_) {
+    return;
+  }
+  auto start = buffer_.size();
+  buffer_.push_back(kFileChangeRecord);
+  appendInt(buffer_, delta.sequenceID);
+  appendInt(buffer_, toSystemNanos(delta.time));
+  uint8_t flags = (delta.isPath1Valid ? kPath1Valid : 0) |
+      (delta.isPath2Valid ? kPath2Valid : 0) |
+      (delta.info1.existedBefore ? kPath1ExistedBefore : 0) |
+      (delta.info1.existedAfter ? kPath1ExistedAfter : 0) |
+      (delta.info2.existedBefore ? kPath2ExistedBefore : 0) |
+      (delta.info2.existedAfter ? kPath2ExistedAfter : 0);
+  buffer_.push_back(flags);
+  if (delta.isPath1Valid) {
+    appendString(buffer_, delta.path1->view());
+  }
+  if (delta.isPath2Valid) {
+    appendString(buffer_, delta.path2->view());
+  }
+  size_ += buffer_.size() - start;
+  if (!rewriting_ && buffer_.size() >= kFlushSize) {
+    flush();
+  }
+}
+
+void JournalLog::append(const RootUpdateJournalDelta& delta) {
+  if (!file_ && !rewriting_) {
+    return;
+  }
+  auto start = buffer_.size();
+  buffer_.push_back(kRootUpdateRecord);
+  appendInt(buffer_, delta.sequenceID);
+  appendInt(buffer_, toSystemNanos(delta.time));
+  appendString(buffer_, delta.fromHash.value());
+  appendInt(buffer_, delta.uncleanPaths.size());
+  for (const auto& path : delta.uncleanPaths) {
+    appendString(buffer_, path.view());
+  }
+  size_ += buffer_.size() - start;
+  if (!rewriting_ && buffer_.size() >= kFlushSize) {
+    flush();
+  }
+}
+
+void JournalLog::rewrite(folly::FunctionRef<void()> appendAll) {
+  // The records not written yet are part of what appendAll appends.
+  buffer_.clear();
+  appendString(buffer_, kMagic);
+  rewriting_ = true;
+  appendAll();
+  rewriting_ = false;
+
+  try {
+    writeFileAtomic(path_, folly::ByteRange{folly::StringPiece{buffer_}})
+        .value();
+    file_ = folly::File{path_.c_str(), O_WRONLY | O_APPEND | O_CLOEXEC};
+    size_ = buffer_.size();
+    compactedSize_ = size_;
+  } catch (const std::exception& ex) {
+    disable(ex);
+  }
+  buffer_.clear();
+}
+
+void JournalLog::close(
+    uint64_t mountGeneration,
+    SequenceNumber nextSequence,
+    const RootId& currentHash) {
+  if (!file_) {
+    return;
+  }
+  buffer_.push_back(kClosedRecord);
+  appendInt(buffer_, mountGeneration);
+  appendInt(buffer_, nextSequence);
+  appendString(buffer_, currentHash.value());
+  flush();
+  file_.reset();
+}
+
+void JournalLog::flush() {
+  if (!file_ || buffer_.empty()) {
+    return;
+  }
+  try {
+    folly::checkUnixError(
+        folly::writeFull(file_->fd(), buffer_.data(), buffer_.size()),
+        "failed to append to ",
+        path_);
+  } catch (const std::exception& ex) {
+    disable(ex);
+  }
+  buffer_.clear();
+}
+
+uint64_t JournalLog::toSystemNanos(
+    std::chrono::steady_clock::time_point time) const {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             time.time_since_epoch() + systemMinusSteady_)
+      .count();
+}
+
+std::chrono::steady_clock::time_point JournalLog::fromSystemNanos(
+    uint64_t nanos) const {
+  return std::chrono::steady_clock::time_point{
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::nanoseconds{nanos} - systemMinusSteady_)};
+}
+
+void JournalLog::disable(const std::exception& ex) {
+  XLOG(WARN) << "disabling journal log " << path_ << ": "
+             << folly::exceptionStr(ex);
+  file_.reset();
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/File.h>
+#include <folly/Function.h>
+#include <chrono>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "eden/fs/journal/JournalDelta.h"
+#include "eden/fs/model/RootId.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/**
+ * An append-only on-disk log of the deltas of a Journal, so that the journal
+ * of a mount survives edenfs restarts and graceful takeovers, and clients
+ * holding a position from before keep getting incremental results.
+ *
+ * The deltas are appended as they are recorded, buffered in memory up to
+ * kFlushSize bytes. Once the log has grown to twice its size after the last
+ * compaction, the Journal compacts it by rewriting it from its in-memory
+ * deltas, which are themselves compacted and truncated.
+ *
+ * close() marks the log as closed cleanly. A log that wasn't, because edenfs
+ * crashed or failed to write it, may miss the last deltas and is discarded
+ * when loaded: the journal then starts over, and clients see the mount
+ * generation change as they would without the log.
+ *
+ * Like CheckoutCheckpoint, the log is best effort: failing to write it
+ * disables it rather than failing the change being recorded.
+ */
+class JournalLog {
+ public:
+  using SequenceNumber = JournalDelta::SequenceNumber;
+
+  /** The contents of a log closed cleanly. */
+  struct Contents {
+    uint64_t mountGeneration = 0;
+    SequenceNumber nextSequence = 1;
+    std::vector<FileChangeJournalDelta> fileChangeDeltas;
+    std::vector<RootUpdateJournalDelta> hashUpdateDeltas;
+    RootId currentHash;
+  };
+
+  /** Bytes of records buffered before they are written. */
+  static constexpr size_t kFlushSize = 64 * 1024;
+  /** The log isn't compacted before it reaches this size. */
+  static constexpr size_t kMinCompactionSize = 64 * 1024 * 1024;
+
+  explicit JournalLog(AbsolutePath path);
+  ~JournalLog();
+
+  JournalLog(const JournalLog&) = delete;
+  JournalLog& operator=(const JournalLog&) = delete;
+
+  /**
+   * Read the log left by the previous edenfs process, if it was closed
+   * cleanly.
+   */
+  std::optional<Contents> load() const;
+
+  void append(const FileChangeJournalDelta& delta);
+  void append(const RootUpdateJournalDelta& delta);
+
+  /**
+   * Whether the log grew enough since it was last rewritten to be compacted.
+   */
+  bool shouldCompact() const {
+    return size_ >= kMinCompactionSize && size_ >= 2 * compactedSize_;
+  }
+
+  /**
+   * Replace the log with the deltas that appendAll appends.
+   */
+  void rewrite(folly::FunctionRef<void()> appendAll);
+
+  /**
+   * Write the buffered deltas and mark the log as closed cleanly by a mount
+   * of this generation, along with the state of its Journal that isn't in
+   * the deltas.
+   */
+  void close(
+      uint64_t mountGeneration,
+      SequenceNumber nextSequence,
+      const RootId& currentHash);
+
+ private:
+  void flush();
+  void disable(const std::exception& ex);
+  uint64_t toSystemNanos(std::chrono::steady_clock::time_point time) const;
+  std::chrono::steady_clock::time_point fromSystemNanos(uint64_t nanos) const;
+
+  const AbsolutePath path_;
+  /** Unset once the log is closed or disabled. */
+  std::optional<folly::File> file_;
+  /** The records not written yet. */
+  std::string buffer_;
+  bool rewriting_ = false;
+  size_t size_ = 0;
+  size_t compactedSize_ = 0;
+  /**
+   * Delta times are steady_clock times, which don't survive a restart, and
+   * are thus stored as system_clock times.
+   */
+  const std::chrono::system_clock::duration systemMinusSteady_;
+};
+
+} // namespace facebook::eden
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/journal/JournalLog.h"
+
+#include <folly/experimental/TestUtil.h>
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/journal/Journal.h"
+#include "eden/fs/utils/FileUtils.h"
+
+using namespace facebook::eden;
+
+namespace {
+struct JournalLogTest : ::testing::Test {
+  std::unique_ptr<Journal> makeJournal() {
+    return std::make_unique<Journal>(edenStats);
+  }
+
+  std::shared_ptr<EdenStats> edenStats{std::make_shared<EdenStats>()};
+  folly::test::TemporaryDirectory testDir;
+  AbsolutePath path =
+      canonicalPath(testDir.path().string()) + "journal.log"_relpath;
+};
+} // namespace
+
+TEST_F(JournalLogTest, closedLogIsLoaded) {
+  {
+    auto journal = makeJournal();
+    EXPECT_FALSE(journal->openLog(path).has_value());
+    journal->recordHashUpdate(RootId{"a"});
+    journal->recordCreated("src/new.cpp"_relpath);
+    journal->recordRenamed("old"_relpath, "renamed"_relpath);
+    journal->recordUncleanPaths(
+        RootId{"a"}, RootId{"b"}, {RelativePath{"unclean"}});
+    journal->recordChanged("src/new.cpp"_relpath);
+    journal->closeLog(42);
+  }
+
+  auto journal = makeJournal();
+  EXPECT_EQ(42, journal->openLog(path).value_or(0));
+
+  auto latest = journal->getLatest();
+  ASSERT_TRUE(latest);
+  EXPECT_EQ(5, latest->sequenceID);
+  EXPECT_EQ(RootId{"b"}, latest->toHash);
+
+  // A position from before the restart still gets the changes since.
+  auto range = journal->accumulateRange(2);
+  ASSERT_NE(nullptr, range);
+  EXPECT_FALSE(range->isTruncated);
+  EXPECT_EQ(2, range->fromSequence);
+  EXPECT_EQ(5, range->toSequence);
+  EXPECT_EQ(
+      (std::vector<RootId>{RootId{"a"}, RootId{"b"}}),
+      range->snapshotTransitions);
+  auto& changed = range->changedFilesInOverlay;
+  EXPECT_EQ(3, changed.size());
+  EXPECT_TRUE(changed[RelativePath{"src/new.cpp"}].isNew());
+  EXPECT_FALSE(changed[RelativePath{"old"}].existedAfter);
+  EXPECT_EQ(1, range->uncleanPaths.count(RelativePath{"unclean"}));
+
+  journal->recordRemoved("src/new.cpp"_relpath);
+  EXPECT_EQ(6, journal->getLatest()->sequenceID);
+}
+
+TEST_F(JournalLogTest, logNotClosedIsDiscarded) {
+  {
+    auto journal = makeJournal();
+    EXPECT_FALSE(journal->openLog(path).has_value());
+    journal->recordHashUpdate(RootId{"a"});
+    journal->recordCreated("file"_relpath);
+  }
+
+  auto journal = makeJournal();
+  EXPECT_FALSE(journal->openLog(path).has_value());
+  EXPECT_FALSE(journal->getLatest());
+}
+
+TEST_F(JournalLogTest, loadedLogIsOnlyLoadedOnce) {
+  {
+    auto journal = makeJournal();
+    EXPECT_FALSE(journal->openLog(path).has_value());
+    journal->recordCreated("file"_relpath);
+    journal->closeLog(1);
+  }
+  {
+    // Crashes after loading the log.
+    auto journal = makeJournal();
+    EXPECT_EQ(1, journal->openLog(path).value_or(0));
+    journal->recordCreated("other"_relpath);
+  }
+
+  auto journal = makeJournal();
+  EXPECT_FALSE(journal->openLog(path).has_value());
+}
+
+TEST_F(JournalLogTest, flushedChangesAreNotLoaded) {
+  {
+    auto journal = makeJournal();
+    EXPECT_FALSE(journal->openLog(path).has_value());
+    journal->recordHashUpdate(RootId{"a"});
+    journal->recordCreated("file"_relpath);
+    journal->flush();
+    journal->closeLog(1);
+  }
+
+  auto journal = makeJournal();
+  EXPECT_EQ(1, journal->openLog(path).value_or(0));
+  auto range = journal->accumulateRange(1);
+  ASSERT_NE(nullptr, range);
+  EXPECT_TRUE(range->isTruncated);
+  EXPECT_EQ(0, range->changedFilesInOverlay.size());
+  EXPECT_EQ(RootId{"a"}, journal->getLatest()->toHash);
+}
+
+TEST_F(JournalLogTest, corruptLogIsDiscarded) {
+  {
+    auto journal = makeJournal();
+    EXPECT_FALSE(journal->openLog(path).has_value());
+    journal->recordCreated("file"_relpath);
+    journal->closeLog(1);
+  }
+  auto contents = readFile(path).value();
+  auto cutShort = folly::StringPiece{contents}.subpiece(0, 30);
+  ASSERT_TRUE(writeFile(path, folly::ByteRange{cutShort}).hasValue());
+
+  auto journal = makeJournal();
+  EXPECT_FALSE(journal->openLog(path).has_value());
+  EXPECT_FALSE(journal->getLatest());
+}
@@ -7,8 +7,13 @@
 
 #include "eden/fs/journal/Journal.h"
 
+#include <fmt/format.h>
+#include <folly/Conv.h>
 #include <folly/portability/GMock.h>
 #include <folly/portability/GTest.h>
+#include <folly/synchronization/Baton.h>
+#include <atomic>
+#include <thread>
 
 #include "eden/fs/model/RootId.h"
 
@@ -551,6 +556,149 @@ TEST_F(JournalTest, compaction) {
   EXPECT_EQ(1, summed->changedFilesInOverlay.size());
 }
 
+TEST_F(JournalTest, long_ranges_match_their_deltas) {
+  // Spans several summarized blocks, with a root update in the middle.
+  constexpr int kDeltas = 2600;
+  constexpr int kFiles = 100;
+  RootId hash1{"0000000000000000000000000000000000000001"};
+  for (int i = 0; i < kDeltas; ++i) {
+    auto path = RelativePath{fmt::format("dir/file{}", i % kFiles)};
+    if (i == 1500) {
+      journal.recordHashUpdate(hash1);
+    } else if (i < kFiles) {
+      journal.recordCreated(path);
+    } else {
+      journal.recordChanged(path);
+    }
+  }
+
+  for (Journal::SequenceNumber from : {1, 2, 99, 1024, 1025, 1500, 2501}) {
+    auto summed = journal.accumulateRange(from);
+    ASSERT_NE(nullptr, summed);
+    EXPECT_FALSE(summed->isTruncated);
+    EXPECT_EQ(from, summed->fromSequence);
+    EXPECT_EQ(kDeltas, summed->toSequence);
+
+    EXPECT_EQ(
+        std::min<size_t>(kFiles, kDeltas - from + 1),
+        summed->changedFilesInOverlay.size())
+        << "from " << from;
+    for (const auto& [path, info] : summed->changedFilesInOverlay) {
+      auto index = folly::to<int>(path.basename().stringPiece().subpiece(4));
+      // Files are created by the first kFiles deltas, at sequence index + 1.
+      EXPECT_EQ(Journal::SequenceNumber(index) + 1 < from, info.existedBefore)
+          << path << " from " << from;
+      EXPECT_TRUE(info.existedAfter) << path;
+    }
+
+    std::vector<RootId> expectedTransitions;
+    if (from <= 1501) {
+      expectedTransitions.emplace_back();
+    }
+    expectedTransitions.push_back(hash1);
+    EXPECT_EQ(expectedTransitions, summed->snapshotTransitions)
+        << "from " << from;
+  }
+}
+
+TEST_F(JournalTest, truncation_of_summarized_deltas) {
+  for (int i = 0; i < 3000; ++i) {
+    journal.recordCreated(RelativePath{fmt::format("file{}", i)});
+  }
+  journal.setMemoryLimit(journal.estimateMemoryUsage() / 2);
+  journal.recordCreated("last"_relpath);
+
+  auto remembered = journal.getStats()->entryCount;
+  ASSERT_LT(remembered, 3000);
+  Journal::SequenceNumber firstUntruncated = 3001 - remembered + 1;
+  EXPECT_TRUE(journal.accumulateRange(firstUntruncated - 1)->isTruncated);
+  // The second summarized block covers 1025 to 2048.
+  std::vector<Journal::SequenceNumber> froms{
+      firstUntruncated, firstUntruncated + 1, 2048, 2049};
+  for (auto from : froms) {
+    if (from < firstUntruncated) {
+      continue;
+    }
+    auto summed = journal.accumulateRange(from);
+    ASSERT_NE(nullptr, summed);
+    EXPECT_FALSE(summed->isTruncated);
+    EXPECT_EQ(from, summed->fromSequence);
+    EXPECT_EQ(3001, summed->toSequence);
+    EXPECT_EQ(3001 - from + 1, summed->changedFilesInOverlay.size());
+  }
+}
+
+TEST_F(JournalTest, removal_after_modification_is_compacted) {
+  journal.recordCreated("file1.txt"_relpath);
+  journal.recordChanged("file1.txt"_relpath);
+  journal.recordRemoved("file1.txt"_relpath);
+  ASSERT_EQ(2, journal.getStats()->entryCount);
+  ASSERT_EQ(3, journal.getLatest()->sequenceID);
+
+  // Whoever saw the file changed now sees it removed.
+  auto summed = journal.accumulateRange(2);
+  ASSERT_NE(nullptr, summed);
+  EXPECT_EQ(3, summed->fromSequence);
+  EXPECT_EQ(
+      (PathChangeInfo{true, false}),
+      summed->changedFilesInOverlay.at("file1.txt"_relpath));
+
+  // A creation can't be folded into a removal.
+  journal.recordCreated("file1.txt"_relpath);
+  ASSERT_EQ(3, journal.getStats()->entryCount);
+}
+
+TEST_F(JournalTest, repeated_paths_are_stored_once) {
+  Journal distinctJournal{edenStats};
+  auto longName = std::string(200, 'a');
+  auto baseline = journal.estimateMemoryUsage();
+  for (int i = 0; i < 100; ++i) {
+    auto path = RelativePath{longName};
+    auto distinctPath = RelativePath{fmt::format("{}{}", longName, i)};
+    if (i % 2 == 0) {
+      journal.recordCreated(path);
+    } else {
+      journal.recordRemoved(path);
+    }
+    distinctJournal.recordCreated(distinctPath);
+  }
+
+  auto repeatedUsage = journal.estimateMemoryUsage() - baseline;
+  auto distinctUsage = distinctJournal.estimateMemoryUsage() - baseline;
+  EXPECT_LT(repeatedUsage + 99 * longName.size(), distinctUsage);
+
+  // Dropping the deltas also drops their paths.
+  distinctJournal.flush();
+  EXPECT_LT(
+      distinctJournal.estimateMemoryUsage(),
+      baseline + 100 * longName.size());
+}
+
+TEST_F(JournalTest, path_filter_limits_accumulated_paths) {
+  // Enough deltas for the filter to also apply to summarized blocks.
+  for (int i = 0; i < 2100; ++i) {
+    journal.recordChanged(RelativePath{fmt::format("dir{}/file", i % 4)});
+  }
+  RootId hash1{"0000000000000000000000000000000000000001"};
+  journal.recordUncleanPaths(
+      RootId{}, hash1, {RelativePath{"dir0/unclean"}, RelativePath{"dir1/x"}});
+
+  size_t calls = 0;
+  auto summed = journal.accumulateRange(1, [&](RelativePathPiece path) {
+    ++calls;
+    return path.stringPiece().startsWith("dir0/");
+  });
+  ASSERT_NE(nullptr, summed);
+  EXPECT_EQ(2101, summed->toSequence);
+  EXPECT_EQ(1, summed->changedFilesInOverlay.size());
+  EXPECT_EQ(1, summed->changedFilesInOverlay.count("dir0/file"_relpath));
+  EXPECT_EQ(
+      std::unordered_set<RelativePath>{RelativePath{"dir0/unclean"}},
+      summed->uncleanPaths);
+  // Paths already accepted are not checked again.
+  EXPECT_LT(calls, 2100);
+}
+
 TEST_F(JournalTest, update_transitions_are_all_recorded) {
   RootId hash1{"0000000000000000000000000000000000000001"};
   RootId hash2{"0000000000000000000000000000000000000002"};
@@ -657,3 +805,32 @@ TEST_F(JournalTest, all_subscribers_are_notified_after_any_observation) {
   EXPECT_EQ(2u, calls1);
   EXPECT_EQ(2u, calls2);
 }
+
+TEST(
+    JournalNotificationTest,
+    subscribers_are_notified_at_most_once_per_interval) {
+  std::atomic<unsigned> calls{0};
+  std::thread::id calledFrom;
+  folly::Baton<> notified;
+  // Long enough for no second notification to be sent during the test.
+  Journal journal{std::make_shared<EdenStats>(), std::chrono::hours{1}};
+  auto sub = journal.registerSubscriber([&] {
+    calledFrom = std::this_thread::get_id();
+    ++calls;
+    notified.post();
+  });
+  (void)sub;
+
+  // The first change is notified right away, from the notification thread.
+  journal.recordChanged("foo"_relpath);
+  ASSERT_TRUE(notified.try_wait_for(std::chrono::seconds{10}));
+  EXPECT_EQ(1u, calls);
+  EXPECT_NE(std::this_thread::get_id(), calledFrom);
+  EXPECT_EQ(1u, journal.getLatest()->sequenceID);
+
+  journal.recordChanged("foo"_relpath);
+  journal.recordChanged("bar"_relpath);
+  std::this_thread::sleep_for(std::chrono::milliseconds{10});
+  EXPECT_EQ(1u, calls);
+  // Destroying the journal doesn't wait for the pending notification.
+}
@@ -7,7 +7,9 @@
 
 #pragma once
 
+#include <folly/File.h>
 #include <folly/io/IOBuf.h>
+#include <memory>
 #include <string>
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/model/ObjectId.h"
@@ -26,6 +28,19 @@ class Blob {
         contents_{contents},
         size_{contents_.computeChainDataLength()} {}
 
+  /**
+   * A blob whose contents are a mapping of file, a sealed memfd that can be
+   * handed to other processes. See makeSealedMemfd().
+   */
+  Blob(
+      const ObjectId& hash,
+      folly::IOBuf&& contents,
+      std::shared_ptr<folly::File> file)
+      : hash_{hash},
+        contents_{std::move(contents)},
+        size_{contents_.computeChainDataLength()},
+        file_{std::move(file)} {}
+
   /**
    * Convenience constructor for unit tests. Always copies the given
    * StringPiece.
@@ -51,10 +66,25 @@ class Blob {
     return size_;
   }
 
+  /**
+   * The sealed memfd holding the contents, or nullptr if they live in
+   * private memory.
+   */
+  const std::shared_ptr<folly::File>& getFile() const {
+    return file_;
+  }
+
  private:
   const ObjectId hash_;
   const folly::IOBuf contents_;
   const size_t size_;
+  const std::shared_ptr<folly::File> file_;
 };
 
+/**
+ * Blobs are immutable once imported, so a single instance can be shared by
+ * every reader of the same object.
+ */
+using BlobPtr = std::shared_ptr<const Blob>;
+
 } // namespace facebook::eden
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
 #include "eden/fs/model/Hash.h"
 
 namespace facebook::eden {
@@ -25,4 +26,6 @@ class BlobMetadata {
   uint64_t size;
 };
 
+using BlobMetadataPtr = std::shared_ptr<const BlobMetadata>;
+
 } // namespace facebook::eden
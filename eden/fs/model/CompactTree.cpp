@@ -0,0 +1,350 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/model/CompactTree.h"
+
+#include <folly/Memory.h>
+#include <folly/Utility.h>
+#include <folly/io/Cursor.h>
+#include <folly/logging/xlog.h>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/utils/Memory.h"
+
+namespace facebook::eden {
+
+namespace {
+
+/**
+ * Size of an entry of a V1 serialized tree, excluding its hash and its name.
+ */
+constexpr size_t kSerializedEntryOverhead = sizeof(uint8_t) +
+    sizeof(uint16_t) + sizeof(uint16_t) + sizeof(uint64_t) + Hash20::RAW_SIZE;
+
+constexpr uint64_t kNoSize = std::numeric_limits<uint64_t>::max();
+
+template <typename T>
+T read(folly::StringPiece& data) {
+  T value;
+  memcpy(&value, data.data(), sizeof(T));
+  data.advance(sizeof(T));
+  return value;
+}
+
+size_t poolSize(const Tree& tree) {
+  size_t size = 0;
+  for (const auto& [name, entry] : tree) {
+    size += name.value().size() + entry.getHash().size();
+  }
+  return size;
+}
+
+} // namespace
+
+PathComponentPiece CompactTree::Entry::getName() const {
+  // Names were validated when the tree was built.
+  return PathComponentPiece{
+      folly::StringPiece{pool_ + record_->nameOffset, record_->nameSize},
+      detail::SkipPathSanityCheck{}};
+}
+
+folly::ByteRange CompactTree::Entry::getHashBytes() const {
+  return folly::ByteRange{
+      reinterpret_cast<const uint8_t*>(pool_ + record_->hashOffset),
+      record_->hashSize};
+}
+
+TreeEntryType CompactTree::Entry::getType() const {
+  return record_->type;
+}
+
+std::optional<uint64_t> CompactTree::Entry::getSize() const {
+  if (record_->flags & kHasSize) {
+    return record_->size;
+  }
+  return std::nullopt;
+}
+
+std::optional<Hash20> CompactTree::Entry::getContentSha1() const {
+  if (record_->flags & kHasContentSha1) {
+    return Hash20{folly::ByteRange{record_->contentSha1, Hash20::RAW_SIZE}};
+  }
+  return std::nullopt;
+}
+
+TreeEntry CompactTree::Entry::toTreeEntry() const {
+  return TreeEntry{getHash(), getType(), getSize(), getContentSha1()};
+}
+
+CompactTree::CompactTree(
+    ObjectId hash,
+    CaseSensitivity caseSensitive,
+    size_t size,
+    size_t poolSize)
+    : hash_{std::move(hash)},
+      caseSensitive_{caseSensitive},
+      size_{size},
+      poolOffset_{size * sizeof(Record)},
+      bufferSize_{poolOffset_ + poolSize},
+      buffer_{new char[std::max<size_t>(bufferSize_, 1)]} {}
+
+CompactTree::CompactTree(const Tree& tree)
+    : CompactTree{
+          tree.getHash(),
+          tree.getCaseSensitivity(),
+          tree.size(),
+          poolSize(tree)} {
+  auto* record = records();
+  uint32_t offset = 0;
+  for (const auto& [name, entry] : tree) {
+    auto nameBytes = name.value();
+    auto hashBytes = entry.getHash().getBytes();
+
+    *record = Record{};
+    record->type = entry.getType();
+    record->nameOffset = offset;
+    record->nameSize = folly::to_narrow(nameBytes.size());
+    memcpy(pool() + offset, nameBytes.data(), nameBytes.size());
+    offset += record->nameSize;
+
+    record->hashOffset = offset;
+    record->hashSize = folly::to_narrow(hashBytes.size());
+    memcpy(pool() + offset, hashBytes.data(), hashBytes.size());
+    offset += record->hashSize;
+
+    if (auto size = entry.getSize()) {
+      record->flags |= kHasSize;
+      record->size = *size;
+    }
+    if (auto sha1 = entry.getContentSha1()) {
+      record->flags |= kHasContentSha1;
+      memcpy(
+          record->contentSha1, sha1->getBytes().data(), Hash20::RAW_SIZE);
+    }
+    ++record;
+  }
+  // Tree entries are already sorted with the same comparison.
+}
+
+std::unique_ptr<CompactTree> CompactTree::tryDeserialize(
+    ObjectId hash,
+    folly::StringPiece data) {
+  if (data.size() < 2 * sizeof(uint32_t)) {
+    XLOG(ERR) << "Can not read tree header, bytes remaining " << data.size();
+    return nullptr;
+  }
+  switch (read<uint32_t>(data)) {
+    case Tree::V1_VERSION:
+      return tryDeserializeV1(std::move(hash), data);
+    case Tree::V2_VERSION:
+      return tryDeserializeV2(std::move(hash), data);
+  }
+  return nullptr;
+}
+
+std::unique_ptr<CompactTree> CompactTree::tryDeserializeV1(
+    ObjectId hash,
+    folly::StringPiece data) {
+  auto numEntries = read<uint32_t>(data);
+
+  // Validate the entries and compute the size of the pool before allocating
+  // the buffer.
+  size_t pool = 0;
+  auto remaining = data;
+  for (size_t i = 0; i < numEntries; ++i) {
+    if (remaining.size() < kSerializedEntryOverhead) {
+      XLOG(ERR) << "Truncated tree entry, bytes remaining "
+                << remaining.size();
+      return nullptr;
+    }
+    remaining.advance(sizeof(uint8_t));
+    auto hashSize = read<uint16_t>(remaining);
+    if (remaining.size() < hashSize + sizeof(uint16_t)) {
+      XLOG(ERR) << "Can not read tree entry hash, bytes remaining "
+                << remaining.size() << " need " << hashSize;
+      return nullptr;
+    }
+    remaining.advance(hashSize);
+    auto nameSize = read<uint16_t>(remaining);
+    auto tailSize = sizeof(uint64_t) + Hash20::RAW_SIZE;
+    if (remaining.size() < nameSize + tailSize) {
+      XLOG(ERR) << "Can not read tree entry name, bytes remaining "
+                << remaining.size() << " need " << nameSize;
+      return nullptr;
+    }
+    remaining.advance(nameSize + tailSize);
+    pool += hashSize + nameSize;
+  }
+  if (remaining.size() != 0u) {
+    XLOG(ERR) << "Corrupted tree data, extra bytes remaining "
+              << remaining.size();
+    return nullptr;
+  }
+  if (pool > std::numeric_limits<uint32_t>::max()) {
+    XLOG(ERR) << "Tree too large to be compacted: " << pool << " bytes";
+    return nullptr;
+  }
+
+  std::unique_ptr<CompactTree> tree{new CompactTree{
+      std::move(hash), kPathMapDefaultCaseSensitive, numEntries, pool}};
+  auto* record = tree->records();
+  uint32_t offset = 0;
+  bool sorted = true;
+  for (size_t i = 0; i < numEntries; ++i, ++record) {
+    *record = Record{};
+    record->type = static_cast<TreeEntryType>(read<uint8_t>(data));
+
+    record->hashSize = read<uint16_t>(data);
+    record->hashOffset = offset;
+    memcpy(tree->pool() + offset, data.data(), record->hashSize);
+    data.advance(record->hashSize);
+    offset += record->hashSize;
+
+    record->nameSize = read<uint16_t>(data);
+    // Validates the name, like when constructing a PathComponent.
+    PathComponentPiece name{
+        folly::StringPiece{data.data(), record->nameSize}};
+    record->nameOffset = offset;
+    memcpy(tree->pool() + offset, data.data(), record->nameSize);
+    data.advance(record->nameSize);
+    offset += record->nameSize;
+
+    auto size = read<uint64_t>(data);
+    if (size != kNoSize) {
+      record->flags |= kHasSize;
+      record->size = size;
+    }
+    memcpy(record->contentSha1, data.data(), Hash20::RAW_SIZE);
+    data.advance(Hash20::RAW_SIZE);
+    if (Hash20{folly::ByteRange{record->contentSha1, Hash20::RAW_SIZE}} !=
+        kZeroHash) {
+      record->flags |= kHasContentSha1;
+    }
+
+    if (i > 0 && sorted) {
+      auto previous = Entry{record - 1, tree->pool()}.getName();
+      sorted = isPathPieceLess(previous, name, tree->caseSensitive_);
+    }
+  }
+
+  if (!sorted) {
+    tree->sortRecords();
+  }
+  return tree;
+}
+
+std::unique_ptr<CompactTree> CompactTree::tryDeserializeV2(
+    ObjectId hash,
+    folly::StringPiece data) {
+  auto numEntries = read<uint32_t>(data);
+  if (data.size() / sizeof(Record) < numEntries) {
+    XLOG(ERR) << "Can not read " << numEntries
+              << " tree records, bytes remaining " << data.size();
+    return nullptr;
+  }
+  auto poolSize = data.size() - numEntries * sizeof(Record);
+
+  std::unique_ptr<CompactTree> tree{new CompactTree{
+      std::move(hash), kPathMapDefaultCaseSensitive, numEntries, poolSize}};
+  memcpy(tree->buffer_.get(), data.data(), data.size());
+
+  const auto* pool = tree->pool();
+  const auto* record = tree->records();
+  bool sorted = true;
+  for (size_t i = 0; i < numEntries; ++i, ++record) {
+    if (uint64_t{record->nameOffset} + record->nameSize > poolSize ||
+        uint64_t{record->hashOffset} + record->hashSize > poolSize ||
+        record->type > TreeEntryType::SYMLINK ||
+        (record->flags & ~kKnownFlags) != 0) {
+      XLOG(ERR) << "Corrupted tree record " << i << " of " << numEntries;
+      return nullptr;
+    }
+    // Validates the name, like when constructing a PathComponent.
+    PathComponentPiece name{
+        folly::StringPiece{pool + record->nameOffset, record->nameSize}};
+
+    if (i > 0 && sorted) {
+      auto previous = Entry{record - 1, pool}.getName();
+      sorted = isPathPieceLess(previous, name, tree->caseSensitive_);
+    }
+  }
+
+  // Trees serialized with a different case sensitivity need to be sorted
+  // again.
+  if (!sorted) {
+    tree->sortRecords();
+  }
+  return tree;
+}
+
+folly::IOBuf CompactTree::serialize() const {
+  auto recordsSize = size_ * sizeof(Record);
+  auto poolSize = bufferSize_ - poolOffset_;
+  folly::IOBuf buf(
+      folly::IOBuf::CREATE, 2 * sizeof(uint32_t) + recordsSize + poolSize);
+  folly::io::Appender appender(&buf, 0);
+
+  XCHECK_LE(size_, std::numeric_limits<uint32_t>::max());
+  appender.write<uint32_t>(Tree::V2_VERSION);
+  appender.write<uint32_t>(static_cast<uint32_t>(size_));
+  appender.push(
+      reinterpret_cast<const uint8_t*>(buffer_.get()), recordsSize);
+  appender.push(reinterpret_cast<const uint8_t*>(pool()), poolSize);
+  return buf;
+}
+
+void CompactTree::sortRecords() {
+  auto* pool = this->pool();
+  auto less = [&](const Record& lhs, const Record& rhs) {
+    return isPathPieceLess(
+        Entry{&lhs, pool}.getName(),
+        Entry{&rhs, pool}.getName(),
+        caseSensitive_);
+  };
+  auto* first = records();
+  auto* last = first + size_;
+  std::stable_sort(first, last, less);
+  last = std::unique(first, last, [&](const Record& lhs, const Record& rhs) {
+    return !less(lhs, rhs) && !less(rhs, lhs);
+  });
+  size_ = last - first;
+}
+
+std::optional<CompactTree::Entry> CompactTree::find(
+    PathComponentPiece name) const {
+  auto* pool = this->pool();
+  auto* first = records();
+  auto* last = first + size_;
+  auto* it = std::partition_point(first, last, [&](const Record& record) {
+    return isPathPieceLess(
+        Entry{&record, pool}.getName(), name, caseSensitive_);
+  });
+  if (it == last ||
+      isPathPieceLess(name, Entry{it, pool}.getName(), caseSensitive_)) {
+    return std::nullopt;
+  }
+  return Entry{it, pool};
+}
+
+size_t CompactTree::getSizeBytes() const {
+  return sizeof(*this) + folly::goodMallocSize(bufferSize_) +
+      estimateIndirectMemoryUsage(hash_.getBytes());
+}
+
+std::unique_ptr<Tree> CompactTree::toTree() const {
+  Tree::container entries{caseSensitive_};
+  entries.reserve(size_);
+  for (auto entry : *this) {
+    entries.emplace(entry.getName(), entry.toTreeEntry());
+  }
+  return std::make_unique<Tree>(std::move(entries), hash_);
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/io/IOBuf.h>
+#include <iterator>
+#include <memory>
+#include <optional>
+
+#include "eden/fs/model/Hash.h"
+#include "eden/fs/model/ObjectId.h"
+#include "eden/fs/model/TreeEntry.h"
+#include "eden/fs/utils/CaseSensitivity.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+class Tree;
+
+/**
+ * A read-only Tree stored in a single allocation.
+ *
+ * The buffer holds an array of fixed-width records, sorted by name, followed
+ * by a pool holding the names and the object IDs of all the entries. Looking
+ * up a name is a binary search over the records, and decoding a serialized
+ * tree allocates the buffer once instead of allocating a PathComponent and an
+ * ObjectId per entry.
+ *
+ * The buffer is also the V2 serialization format of trees: a serialized V2
+ * tree is a version and an entry count followed by the buffer, so it can be
+ * decoded with a single copy and validated without parsing every entry.
+ *
+ * Entries are returned as lightweight views into the buffer: they are only
+ * valid for as long as the CompactTree is alive.
+ */
+class CompactTree {
+ private:
+  struct Record;
+
+ public:
+  /**
+   * View of one entry of a CompactTree.
+   */
+  class Entry {
+   public:
+    PathComponentPiece getName() const;
+
+    folly::ByteRange getHashBytes() const;
+
+    ObjectId getHash() const {
+      return ObjectId{getHashBytes()};
+    }
+
+    TreeEntryType getType() const;
+
+    bool isTree() const {
+      return getType() == TreeEntryType::TREE;
+    }
+
+    std::optional<uint64_t> getSize() const;
+    std::optional<Hash20> getContentSha1() const;
+
+    /**
+     * Copy this entry into a standalone TreeEntry.
+     */
+    TreeEntry toTreeEntry() const;
+
+   private:
+    friend class CompactTree;
+    Entry(const Record* record, const char* pool)
+        : record_{record}, pool_{pool} {}
+
+    const Record* record_;
+    const char* pool_;
+  };
+
+  class const_iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = Entry;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = Entry;
+
+    Entry operator*() const {
+      return Entry{record_, pool_};
+    }
+
+    const_iterator& operator++() {
+      ++record_;
+      return *this;
+    }
+
+    const_iterator operator++(int) {
+      auto result = *this;
+      ++record_;
+      return result;
+    }
+
+    bool operator==(const const_iterator& other) const {
+      return record_ == other.record_;
+    }
+
+    bool operator!=(const const_iterator& other) const {
+      return record_ != other.record_;
+    }
+
+   private:
+    friend class CompactTree;
+    const_iterator(const Record* record, const char* pool)
+        : record_{record}, pool_{pool} {}
+
+    const Record* record_;
+    const char* pool_;
+  };
+
+  /**
+   * Copy the entries of a Tree.
+   */
+  explicit CompactTree(const Tree& tree);
+
+  CompactTree(const CompactTree&) = delete;
+  CompactTree& operator=(const CompactTree&) = delete;
+
+  /**
+   * Decode a tree serialized in the V1 or the V2 format.
+   *
+   * Returns nullptr if the serialization format is not supported or the data
+   * is corrupted.
+   */
+  static std::unique_ptr<CompactTree> tryDeserialize(
+      ObjectId hash,
+      folly::StringPiece data);
+
+  /**
+   * Serialize this tree in the V2 format.
+   */
+  folly::IOBuf serialize() const;
+
+  const ObjectId& getHash() const {
+    return hash_;
+  }
+
+  CaseSensitivity getCaseSensitivity() const {
+    return caseSensitive_;
+  }
+
+  size_t size() const {
+    return size_;
+  }
+
+  /**
+   * Find the entry with the given name, following the case sensitivity of
+   * this tree.
+   */
+  std::optional<Entry> find(PathComponentPiece name) const;
+
+  const_iterator begin() const {
+    return const_iterator{records(), pool()};
+  }
+
+  const_iterator end() const {
+    return const_iterator{records() + size_, pool()};
+  }
+
+  /**
+   * An estimate of the memory footprint of this tree, comparable to
+   * Tree::getSizeBytes().
+   */
+  size_t getSizeBytes() const;
+
+  /**
+   * Copy the entries back into a Tree.
+   */
+  std::unique_ptr<Tree> toTree() const;
+
+ private:
+  /**
+   * Fixed-width description of an entry. This is part of the V2 serialization
+   * format: fields may only be added in a new version.
+   */
+  struct Record {
+    uint32_t nameOffset;
+    uint16_t nameSize;
+    uint16_t hashSize;
+    uint32_t hashOffset;
+    TreeEntryType type;
+    uint8_t flags;
+    uint16_t padding;
+    uint64_t size;
+    uint8_t contentSha1[Hash20::RAW_SIZE];
+    uint32_t padding2;
+  };
+  static_assert(48 == sizeof(Record));
+
+  static constexpr uint8_t kHasSize = 1;
+  static constexpr uint8_t kHasContentSha1 = 2;
+  static constexpr uint8_t kKnownFlags = kHasSize | kHasContentSha1;
+
+  CompactTree(
+      ObjectId hash,
+      CaseSensitivity caseSensitive,
+      size_t size,
+      size_t poolSize);
+
+  static std::unique_ptr<CompactTree> tryDeserializeV1(
+      ObjectId hash,
+      folly::StringPiece data);
+  static std::unique_ptr<CompactTree> tryDeserializeV2(
+      ObjectId hash,
+      folly::StringPiece data);
+
+  Record* records() const {
+    return reinterpret_cast<Record*>(buffer_.get());
+  }
+
+  char* pool() const {
+    return buffer_.get() + poolOffset_;
+  }
+
+  /**
+   * Sort the records by name and drop the duplicate names, keeping the first
+   * occurrence like PathMap does.
+   */
+  void sortRecords();
+
+  ObjectId hash_;
+  CaseSensitivity caseSensitive_;
+  size_t size_;
+  size_t poolOffset_;
+  size_t bufferSize_;
+  std::unique_ptr<char[]> buffer_;
+};
+
+} // namespace facebook::eden
@@ -33,5 +33,7 @@ inline constexpr auto ENTRY_ATTRIBUTE_SIZE =
     EntryAttributeFlags::raw(FileAttributes::FILE_SIZE);
 inline constexpr auto ENTRY_ATTRIBUTE_SHA1 =
     EntryAttributeFlags::raw(FileAttributes::SHA1_HASH);
+inline constexpr auto ENTRY_ATTRIBUTE_OBJECT_ID =
+    EntryAttributeFlags::raw(FileAttributes::OBJECT_ID);
 
 } // namespace facebook::eden
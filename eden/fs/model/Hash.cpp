@@ -8,7 +8,6 @@
 #include "Hash.h"
 
 #include <folly/Conv.h>
-#include <folly/String.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
 #include <folly/ssl/OpenSSLHash.h>
@@ -31,8 +30,8 @@ folly::MutableByteRange Hash20::mutableBytes() {
 }
 
 std::string Hash20::toString() const {
-  std::string result;
-  folly::hexlify(bytes_, result);
+  std::string result(RAW_SIZE * 2, '\0');
+  encodeHex(getBytes(), result.data());
   return result;
 }
 
@@ -71,6 +70,27 @@ void Hash20::throwInvalidArgument(const char* message, size_t number) {
   throw std::invalid_argument(folly::to<std::string>(message, number));
 }
 
+void hashesToHex(HashRange hashes, char* out) noexcept {
+  for (const auto& hash : hashes) {
+    encodeHex(hash.getBytes(), out);
+    out += Hash20::RAW_SIZE * 2;
+  }
+}
+
+std::vector<Hash20> hashesFromHex(folly::StringPiece hex) {
+  constexpr size_t kHexSize = Hash20::RAW_SIZE * 2;
+  if (hex.size() % kHexSize != 0) {
+    throw std::invalid_argument(folly::to<std::string>(
+        "incorrect data size for hashes from string: ", hex.size()));
+  }
+  std::vector<Hash20> hashes;
+  hashes.reserve(hex.size() / kHexSize);
+  for (size_t offset = 0; offset < hex.size(); offset += kHexSize) {
+    hashes.emplace_back(hex.subpiece(offset, kHexSize));
+  }
+  return hashes;
+}
+
 std::ostream& operator<<(std::ostream& os, const Hash20& hash) {
   os << hash.toString();
   return os;
@@ -9,9 +9,13 @@
 
 #include <boost/operators.hpp>
 #include <folly/Range.h>
+#include <folly/Traits.h>
 #include <stdint.h>
 #include <array>
 #include <iosfwd>
+#include <string>
+#include <vector>
+#include "eden/fs/utils/Hex.h"
 
 namespace folly {
 class IOBuf;
@@ -95,6 +99,13 @@ class Hash20 : boost::totally_ordered<Hash20> {
       throwInvalidArgument(
           "incorrect data size for Hash constructor from string: ", hex.size());
     }
+    if (!folly::is_constant_evaluated_or(true)) {
+      Storage bytes{};
+      if (decodeHex(hex, bytes.data())) {
+        return bytes;
+      }
+      // Fall through to report the invalid digit.
+    }
     return {
         hexByteAt(hex, 0),  hexByteAt(hex, 1),  hexByteAt(hex, 2),
         hexByteAt(hex, 3),  hexByteAt(hex, 4),  hexByteAt(hex, 5),
@@ -131,6 +142,22 @@ class Hash20 : boost::totally_ordered<Hash20> {
 
 using HashRange = folly::Range<const Hash20*>;
 
+/**
+ * Write the 40-character hex representation of each hash to out, which must
+ * have room for 40 * hashes.size() characters.
+ *
+ * This avoids allocating a string per hash when encoding many of them.
+ */
+void hashesToHex(HashRange hashes, char* out) noexcept;
+
+/**
+ * Parse concatenated 40-character hex hashes.
+ *
+ * Throws std::invalid_argument, like the Hash20 constructor, if hex is not a
+ * sequence of valid hashes.
+ */
+std::vector<Hash20> hashesFromHex(folly::StringPiece hex);
+
 /** A hash object initialized to all zeroes */
 extern const Hash20 kZeroHash;
 
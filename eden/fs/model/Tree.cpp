@@ -7,6 +7,7 @@
 
 #include "Tree.h"
 #include <folly/io/IOBuf.h>
+#include "eden/fs/model/CompactTree.h"
 
 namespace facebook::eden {
 
@@ -28,22 +29,7 @@ size_t Tree::getSizeBytes() const {
 }
 
 IOBuf Tree::serialize() const {
-  size_t serialized_size = sizeof(uint32_t) + sizeof(uint32_t);
-  for (auto& entry : entries_) {
-    serialized_size += entry.second.serializedSize(entry.first);
-  }
-  IOBuf buf(IOBuf::CREATE, serialized_size);
-  Appender appender(&buf, 0);
-
-  XCHECK_LE(entries_.size(), std::numeric_limits<uint32_t>::max());
-  uint32_t numberOfEntries = static_cast<uint32_t>(entries_.size());
-
-  appender.write<uint32_t>(V1_VERSION);
-  appender.write<uint32_t>(numberOfEntries);
-  for (auto& entry : entries_) {
-    entry.second.serialize(entry.first, appender);
-  }
-  return buf;
+  return CompactTree{*this}.serialize();
 }
 
 std::unique_ptr<Tree> Tree::tryDeserialize(
@@ -55,6 +41,10 @@ std::unique_ptr<Tree> Tree::tryDeserialize(
   }
   uint32_t version;
   memcpy(&version, data.data(), sizeof(uint32_t));
+  if (version == V2_VERSION) {
+    auto tree = CompactTree::tryDeserialize(std::move(hash), data);
+    return tree ? tree->toTree() : nullptr;
+  }
   data.advance(sizeof(uint32_t));
   if (version != V1_VERSION) {
     return nullptr;
@@ -82,7 +82,7 @@ class Tree {
   }
 
   /**
-   * Serialize tree using custom format.
+   * Serialize tree using the V2 format, described in CompactTree.
    */
   folly::IOBuf serialize() const;
 
@@ -92,8 +92,9 @@ class Tree {
    *
    * First byte is used to identify serialization format.
    * Git tree starts with 'tree', so we can use any bytes other then 't' as a
-   * version identifier. Currently only V1_VERSION is supported, along with
-   * git tree format.
+   * version identifier. Currently V1_VERSION and V2_VERSION are supported,
+   * along with git tree format. Trees are no longer written in the V1 format,
+   * but stores written by older versions still contain them.
    */
   static std::unique_ptr<Tree> tryDeserialize(
       ObjectId hash,
@@ -101,11 +102,19 @@ class Tree {
 
  private:
   friend bool operator==(const Tree& tree1, const Tree& tree2);
+  friend class CompactTree;
 
   ObjectId hash_;
   container entries_;
 
   static constexpr uint32_t V1_VERSION = 1u;
+  static constexpr uint32_t V2_VERSION = 2u;
 };
 
+/**
+ * Trees are immutable once imported, so a single instance can be shared by
+ * every reader of the same object.
+ */
+using TreePtr = std::shared_ptr<const Tree>;
+
 } // namespace facebook::eden
@@ -26,10 +26,12 @@ using namespace folly::io;
 EntryAttributes::EntryAttributes(
     std::optional<folly::Try<Hash20>> contentsHash,
     std::optional<folly::Try<uint64_t>> fileLength,
-    std::optional<folly::Try<TreeEntryType>> fileType)
+    std::optional<folly::Try<TreeEntryType>> fileType,
+    std::optional<folly::Try<ObjectId>> sourceControlId)
     : sha1(std::move(contentsHash)),
       size(std::move(fileLength)),
-      type(std::move(fileType)) {}
+      type(std::move(fileType)),
+      objectId(std::move(sourceControlId)) {}
 
 template <typename T>
 bool checkValueEqual(
@@ -47,7 +49,8 @@ bool checkValueEqual(
 bool operator==(const EntryAttributes& lhs, const EntryAttributes& rhs) {
   return checkValueEqual(lhs.sha1, rhs.sha1) &&
       checkValueEqual(lhs.size, rhs.size) &&
-      checkValueEqual(lhs.type, rhs.type);
+      checkValueEqual(lhs.type, rhs.type) &&
+      checkValueEqual(lhs.objectId, rhs.objectId);
 }
 
 bool operator!=(const EntryAttributes& lhs, const EntryAttributes& rhs) {
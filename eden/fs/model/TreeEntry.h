@@ -39,11 +39,13 @@ class EntryAttributes {
   EntryAttributes(
       std::optional<folly::Try<Hash20>> contentsHash,
       std::optional<folly::Try<uint64_t>> fileLength,
-      std::optional<folly::Try<TreeEntryType>> fileType);
+      std::optional<folly::Try<TreeEntryType>> fileType,
+      std::optional<folly::Try<ObjectId>> sourceControlId = std::nullopt);
 
   std::optional<folly::Try<Hash20>> sha1;
   std::optional<folly::Try<uint64_t>> size;
   std::optional<folly::Try<TreeEntryType>> type;
+  std::optional<folly::Try<ObjectId>> objectId;
 };
 
 /**
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/model/git/BasenameGlobIndex.h"
+
+#include <folly/String.h>
+#include <algorithm>
+
+namespace facebook::eden {
+
+namespace {
+constexpr std::string_view kRecursivePrefix{"**/"};
+
+bool hasSpecials(std::string_view text) {
+  return text.find_first_of("*?[\\/") != std::string_view::npos;
+}
+} // namespace
+
+BasenameGlobIndex::BasenameGlobIndex(GlobOptions options)
+    : options_{options} {}
+
+std::string BasenameGlobIndex::normalize(std::string_view text) const {
+  std::string result{text};
+  if (options_ & GlobOptions::CASE_INSENSITIVE) {
+    folly::toLowerAscii(result);
+  }
+  return result;
+}
+
+bool BasenameGlobIndex::add(std::string_view pattern) {
+  if (pattern.substr(0, kRecursivePrefix.size()) != kRecursivePrefix) {
+    return false;
+  }
+  auto basename = pattern.substr(kRecursivePrefix.size());
+  bool isSuffix = !basename.empty() && basename.front() == '*';
+  if (isSuffix) {
+    basename.remove_prefix(1);
+  } else if (basename.empty()) {
+    return false;
+  }
+  if (hasSpecials(basename)) {
+    return false;
+  }
+
+  auto normalized = normalize(basename);
+  if (!isSuffix) {
+    names_.insert(std::move(normalized));
+    return true;
+  }
+
+  auto it = std::lower_bound(
+      suffixes_.begin(),
+      suffixes_.end(),
+      normalized.size(),
+      [](const auto& entry, size_t length) { return entry.first < length; });
+  if (it == suffixes_.end() || it->first != normalized.size()) {
+    it = suffixes_.emplace(
+        it, normalized.size(), folly::F14FastSet<std::string>{});
+  }
+  it->second.insert(std::move(normalized));
+  return true;
+}
+
+bool BasenameGlobIndex::match(std::string_view path) const {
+  auto slash = path.rfind('/');
+  auto basename =
+      slash == std::string_view::npos ? path : path.substr(slash + 1);
+  bool matchDotfiles = !(options_ & GlobOptions::IGNORE_DOTFILES);
+  if (!matchDotfiles && slash != std::string_view::npos) {
+    // "**/" doesn't match directories that start with a dot.
+    auto dirs = path.substr(0, slash);
+    if ((!dirs.empty() && dirs.front() == '.') ||
+        dirs.find("/.") != std::string_view::npos) {
+      return false;
+    }
+  }
+
+  std::string normalizedStorage;
+  auto normalized = basename;
+  if (options_ & GlobOptions::CASE_INSENSITIVE) {
+    normalizedStorage = normalize(basename);
+    normalized = normalizedStorage;
+  }
+
+  if (names_.find(normalized) != names_.end()) {
+    return true;
+  }
+  // Like "*", a suffix pattern doesn't match names that start with a dot.
+  if (!matchDotfiles && !basename.empty() && basename.front() == '.') {
+    return false;
+  }
+  for (const auto& [length, suffixes] : suffixes_) {
+    if (length > normalized.size()) {
+      break;
+    }
+    auto suffix = normalized.substr(normalized.size() - length);
+    if (suffixes.find(suffix) != suffixes.end()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace facebook::eden
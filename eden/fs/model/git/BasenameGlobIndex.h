@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/container/F14Set.h>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "eden/fs/model/git/GlobMatcher.h"
+
+namespace facebook::eden {
+
+/**
+ * Matches paths against many glob patterns of the forms "**\/NAME" and
+ * "**\/*SUFFIX" at once, where NAME and SUFFIX have no special characters.
+ *
+ * Each of these patterns only looks at the basename of a path, so rather than
+ * running one GlobMatcher per pattern, the basename is looked up in a hash
+ * table of names, and in one hash table of suffixes per suffix length. The
+ * cost of a match thus depends on the number of distinct suffix lengths
+ * rather than on the number of patterns, which makes a difference for the
+ * requests of build systems that glob for thousands of file names.
+ *
+ * A pattern matches the same paths as GlobMatcher::create(pattern, options)
+ * would.
+ */
+class BasenameGlobIndex {
+ public:
+  explicit BasenameGlobIndex(GlobOptions options = GlobOptions::DEFAULT);
+
+  /**
+   * Add a pattern to the index. Returns false, leaving the index unchanged,
+   * if the pattern isn't of a form the index supports.
+   */
+  bool add(std::string_view pattern);
+
+  bool empty() const {
+    return names_.empty() && suffixes_.empty();
+  }
+
+  /**
+   * Returns true if the path matches at least one of the patterns.
+   */
+  bool match(std::string_view path) const;
+
+ private:
+  std::string normalize(std::string_view text) const;
+
+  GlobOptions options_;
+  folly::F14FastSet<std::string> names_;
+  // Suffixes grouped by their length, sorted by length.
+  std::vector<std::pair<size_t, folly::F14FastSet<std::string>>> suffixes_;
+};
+
+} // namespace facebook::eden
@@ -67,20 +67,88 @@ void GitIgnore::loadFile(StringPiece contents) {
   // stop at the first match.
   std::reverse(newRules.begin(), newRules.end());
   std::swap(rules_, newRules);
+
+  literalBasenames_.clear();
+  literalPaths_.clear();
+  suffixes_.clear();
+  globs_.clear();
+  for (uint32_t index = 0; index < rules_.size(); ++index) {
+    const auto& pattern = rules_[index];
+    auto literal = std::string{pattern.getLiteral()};
+    switch (pattern.getKind()) {
+      case GitIgnorePattern::Kind::LITERAL_BASENAME:
+        literalBasenames_[literal].push_back(index);
+        break;
+      case GitIgnorePattern::Kind::LITERAL_PATH:
+        literalPaths_[literal].push_back(index);
+        break;
+      case GitIgnorePattern::Kind::BASENAME_SUFFIX: {
+        auto it = std::lower_bound(
+            suffixes_.begin(),
+            suffixes_.end(),
+            literal.size(),
+            [](const auto& group, size_t size) { return group.first < size; });
+        if (it == suffixes_.end() || it->first != literal.size()) {
+          it = suffixes_.emplace(it);
+          it->first = literal.size();
+        }
+        it->second[literal].push_back(index);
+        break;
+      }
+      case GitIgnorePattern::Kind::GLOB:
+        globs_.push_back(index);
+        break;
+    }
+  }
 }
 
 GitIgnore::MatchResult GitIgnore::match(
     RelativePathPiece path,
     PathComponentPiece basename,
     FileType fileType) const {
-  for (const auto& pattern : rules_) {
-    auto result = pattern.match(path, basename, fileType);
-    if (result != NO_MATCH) {
-      return result;
+  // Look for the matching pattern with the highest precedence, which is the
+  // one with the lowest index in rules_.
+  auto best = rules_.size();
+  auto bestResult = NO_MATCH;
+  auto tryRules = [&](const RuleIndices& indices) {
+    for (auto index : indices) {
+      if (index >= best) {
+        return;
+      }
+      auto result = rules_[index].match(path, basename, fileType);
+      if (result != NO_MATCH) {
+        best = index;
+        bestResult = result;
+        return;
+      }
+    }
+  };
+
+  if (!literalBasenames_.empty()) {
+    auto it = literalBasenames_.find(basename.view());
+    if (it != literalBasenames_.end()) {
+      tryRules(it->second);
+    }
+  }
+  if (!literalPaths_.empty()) {
+    auto it = literalPaths_.find(path.view());
+    if (it != literalPaths_.end()) {
+      tryRules(it->second);
+    }
+  }
+  auto name = basename.view();
+  for (const auto& [size, suffixes] : suffixes_) {
+    if (size > name.size()) {
+      break;
+    }
+    auto it = suffixes.find(name.substr(name.size() - size));
+    if (it != suffixes.end()) {
+      tryRules(it->second);
     }
   }
+  tryRules(globs_);
 
-  return NO_MATCH;
+  return bestResult;
 }
 
 string GitIgnore::matchString(MatchResult result) {
@@ -8,6 +8,9 @@
 #pragma once
 
 #include <folly/Range.h>
+#include <folly/container/F14Map.h>
+#include <string>
+#include <utility>
 #include <vector>
 #include "eden/fs/utils/PathFuncs.h"
 
@@ -179,6 +182,20 @@ class GitIgnore {
    * listed in the .gitignore file).
    */
   std::vector<GitIgnorePattern> rules_;
+
+  /*
+   * The positions in rules_ of the patterns that may match a path, by kind
+   * (see GitIgnorePattern::Kind), each in increasing order. match() looks up
+   * the literal patterns instead of trying each of them, and stops trying the
+   * globs once a pattern with a higher precedence matched.
+   */
+  using RuleIndices = std::vector<uint32_t>;
+  folly::F14FastMap<std::string, RuleIndices> literalBasenames_;
+  folly::F14FastMap<std::string, RuleIndices> literalPaths_;
+  // Suffix patterns grouped by the length of their suffix, sorted by length.
+  std::vector<std::pair<size_t, folly::F14FastMap<std::string, RuleIndices>>>
+      suffixes_;
+  RuleIndices globs_;
 };
 
 } // namespace facebook::eden
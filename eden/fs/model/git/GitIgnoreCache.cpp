@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/model/git/GitIgnoreCache.h"
+
+#include <algorithm>
+
+#include "eden/fs/model/Hash.h"
+#include "eden/fs/model/ObjectId.h"
+
+namespace facebook::eden {
+
+namespace {
+std::string blobKey(const ObjectId& blobId) {
+  auto bytes = blobId.getBytes();
+  std::string key;
+  key.reserve(bytes.size() + 1);
+  key.push_back('b');
+  key.append(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+  return key;
+}
+
+std::string contentsKey(folly::StringPiece contents) {
+  auto hash = Hash20::sha1(folly::ByteRange{contents});
+  auto bytes = hash.getBytes();
+  std::string key;
+  key.reserve(bytes.size() + 1);
+  key.push_back('c');
+  key.append(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+  return key;
+}
+} // namespace
+
+GitIgnoreCache::GitIgnoreCache(size_t maxEntries)
+    : state_{folly::in_place, std::max<size_t>(maxEntries, 1)} {}
+
+GitIgnoreCache::GitIgnorePtr GitIgnoreCache::parseContents(
+    folly::StringPiece contents) {
+  auto ignore = std::make_shared<GitIgnore>();
+  ignore->loadFile(contents);
+  return ignore;
+}
+
+GitIgnoreCache::GitIgnorePtr GitIgnoreCache::get(const ObjectId& blobId) {
+  auto state = state_.lock();
+  auto it = state->entries.find(blobKey(blobId));
+  if (it == state->entries.end()) {
+    ++state->stats.misses;
+    return nullptr;
+  }
+  ++state->stats.hits;
+  return it->second;
+}
+
+GitIgnoreCache::GitIgnorePtr GitIgnoreCache::insert(
+    const ObjectId& blobId,
+    folly::StringPiece contents) {
+  // Parse outside of the lock, as parsing is the expensive part.
+  auto ignore = parseContents(contents);
+  state_.lock()->entries.set(blobKey(blobId), ignore);
+  return ignore;
+}
+
+GitIgnoreCache::GitIgnorePtr GitIgnoreCache::parse(
+    folly::StringPiece contents) {
+  auto key = contentsKey(contents);
+  {
+    auto state = state_.lock();
+    auto it = state->entries.find(key);
+    if (it != state->entries.end()) {
+      ++state->stats.hits;
+      return it->second;
+    }
+    ++state->stats.misses;
+  }
+  auto ignore = parseContents(contents);
+  state_.lock()->entries.set(std::move(key), ignore);
+  return ignore;
+}
+
+GitIgnoreCache::Stats GitIgnoreCache::getStats() const {
+  return state_.lock()->stats;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "eden/fs/model/git/GitIgnore.h"
+
+namespace facebook::eden {
+
+class ObjectId;
+
+/**
+ * A cache of parsed .gitignore files, so that diffs don't read and parse the
+ * same files again on every status call.
+ *
+ * The contents of a .gitignore file unmodified since it was checked out are
+ * those of its blob, and are cached by the id of the blob. Those of a
+ * modified file are read anyway, but are cached by their hash, which is much
+ * cheaper to compute than parsing them.
+ *
+ * The cache is shared across mounts, and is thread safe.
+ */
+class GitIgnoreCache {
+ public:
+  using GitIgnorePtr = std::shared_ptr<const GitIgnore>;
+
+  struct Stats {
+    uint64_t hits{0};
+    uint64_t misses{0};
+  };
+
+  explicit GitIgnoreCache(size_t maxEntries);
+
+  /**
+   * Returns the parsed contents of a blob, or nullptr if they aren't cached.
+   */
+  GitIgnorePtr get(const ObjectId& blobId);
+
+  /**
+   * Parse the contents of a blob, and cache them.
+   */
+  GitIgnorePtr insert(const ObjectId& blobId, folly::StringPiece contents);
+
+  /**
+   * Parse contents that aren't known to be those of a blob, unless contents
+   * with the same hash are cached.
+   */
+  GitIgnorePtr parse(folly::StringPiece contents);
+
+  Stats getStats() const;
+
+ private:
+  static GitIgnorePtr parseContents(folly::StringPiece contents);
+
+  struct State {
+    explicit State(size_t maxEntries) : entries{maxEntries} {}
+
+    /**
+     * Keyed by the id of the blob prefixed by "b", or the hash of the
+     * contents prefixed by "c".
+     */
+    folly::EvictingCacheMap<std::string, GitIgnorePtr> entries;
+    Stats stats;
+  };
+
+  folly::Synchronized<State, std::mutex> state_;
+};
+
+} // namespace facebook::eden
@@ -137,11 +137,35 @@ optional<GitIgnorePattern> GitIgnorePattern::parseLine(StringPiece line) {
     return std::nullopt;
   }
 
-  return GitIgnorePattern(flags, std::move(matcher).value());
+  // Most patterns are plain names, paths, or "*.suffix", which don't need
+  // the GlobMatcher.
+  constexpr StringPiece kGlobSpecialChars{"*?[\\"};
+  auto kind = Kind::GLOB;
+  std::string literal;
+  if (line.find_first_of(kGlobSpecialChars) == StringPiece::npos) {
+    kind = (flags & FLAG_BASENAME_ONLY) ? Kind::LITERAL_BASENAME
+                                        : Kind::LITERAL_PATH;
+    literal = line.str();
+  } else if (
+      (flags & FLAG_BASENAME_ONLY) && line.size() > 1 && line[0] == '*' &&
+      line.subpiece(1).find_first_of(kGlobSpecialChars) == StringPiece::npos) {
+    kind = Kind::BASENAME_SUFFIX;
+    literal = line.subpiece(1).str();
+  }
+
+  return GitIgnorePattern(
+      flags, std::move(matcher).value(), kind, std::move(literal));
 }
 
-GitIgnorePattern::GitIgnorePattern(uint32_t flags, GlobMatcher&& matcher)
-    : flags_(flags), matcher_(std::move(matcher)) {}
+GitIgnorePattern::GitIgnorePattern(
+    uint32_t flags,
+    GlobMatcher&& matcher,
+    Kind kind,
+    std::string literal)
+    : flags_(flags),
+      matcher_(std::move(matcher)),
+      kind_(kind),
+      literal_(std::move(literal)) {}
 
 GitIgnorePattern::~GitIgnorePattern() {}
 
@@ -154,12 +178,25 @@ GitIgnore::MatchResult GitIgnorePattern::match(
   }
 
   bool isMatch = false;
-  if (flags_ & FLAG_BASENAME_ONLY) {
-    // Match only on the file basename.
-    isMatch = matcher_.match(basename.stringPiece());
-  } else {
-    // Match on full relative path to the file from this directory.
-    isMatch = matcher_.match(path.stringPiece());
+  switch (kind_) {
+    case Kind::LITERAL_BASENAME:
+      isMatch = basename.view() == literal_;
+      break;
+    case Kind::LITERAL_PATH:
+      isMatch = path.view() == literal_;
+      break;
+    case Kind::BASENAME_SUFFIX:
+      isMatch = basename.stringPiece().endsWith(literal_);
+      break;
+    case Kind::GLOB:
+      if (flags_ & FLAG_BASENAME_ONLY) {
+        // Match only on the file basename.
+        isMatch = matcher_.match(basename.stringPiece());
+      } else {
+        // Match on full relative path to the file from this directory.
+        isMatch = matcher_.match(path.stringPiece());
+      }
+      break;
   }
 
   if (isMatch) {
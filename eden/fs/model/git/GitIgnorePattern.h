@@ -9,6 +9,8 @@
 
 #include <folly/Range.h>
 #include <optional>
+#include <string>
+#include <string_view>
 #include "eden/fs/model/git/GitIgnore.h"
 #include "eden/fs/model/git/GlobMatcher.h"
 
@@ -69,6 +71,33 @@ class GitIgnorePattern {
       PathComponentPiece basename,
       GitIgnore::FileType fileType) const;
 
+  /**
+   * How a pattern can be matched without a GlobMatcher, which lets GitIgnore
+   * look up the patterns that may match a path instead of trying them all.
+   */
+  enum class Kind {
+    // A glob that must be matched with the GlobMatcher.
+    GLOB,
+    // The basename must be equal to getLiteral().
+    LITERAL_BASENAME,
+    // The path must be equal to getLiteral().
+    LITERAL_PATH,
+    // The basename must end with getLiteral(), for patterns like "*.o".
+    BASENAME_SUFFIX,
+  };
+
+  Kind getKind() const {
+    return kind_;
+  }
+
+  /**
+   * The name, path or suffix of the LITERAL_BASENAME, LITERAL_PATH and
+   * BASENAME_SUFFIX patterns.
+   */
+  std::string_view getLiteral() const {
+    return literal_;
+  }
+
  private:
   /**
    * Flag values that can be bitwise-ORed to create the flags_ value.
@@ -84,7 +113,11 @@ class GitIgnorePattern {
     FLAG_BASENAME_ONLY = 0x04,
   };
 
-  GitIgnorePattern(uint32_t flags, GlobMatcher&& matcher);
+  GitIgnorePattern(
+      uint32_t flags,
+      GlobMatcher&& matcher,
+      Kind kind,
+      std::string literal);
 
   /**
    * A bit set of the Flags defined above.
@@ -94,6 +127,8 @@ class GitIgnorePattern {
    * The GlobMatcher object for performing matching.
    */
   GlobMatcher matcher_;
+  Kind kind_{Kind::GLOB};
+  std::string literal_;
 };
 
 } // namespace facebook::eden
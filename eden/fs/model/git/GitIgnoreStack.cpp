@@ -47,8 +47,12 @@ GitIgnore::MatchResult GitIgnoreStack::match(
       ++suffixIter;
     }
 
-    const GitIgnore* ignore = &node->ignore_;
+    const GitIgnore* ignore = node->ignore_.get();
     node = node->parent_;
+    if (!ignore || ignore->empty()) {
+      // Most directories don't have a .gitignore file.
+      continue;
+    }
 
     const auto result = ignore->match(suffix, basename, fileType);
     if (result != GitIgnore::NO_MATCH) {
@@ -185,7 +185,9 @@ bool operator&(GlobOptions a, GlobOptions b) {
 }
 
 GlobMatcher::GlobMatcher(vector<uint8_t> pattern, CaseSensitivity caseSensitive)
-    : pattern_(std::move(pattern)), caseSensitive_(caseSensitive) {}
+    : pattern_(std::move(pattern)),
+      caseSensitive_(caseSensitive),
+      shape_(getShape(pattern_)) {}
 
 GlobMatcher::GlobMatcher() {}
 
@@ -607,7 +609,98 @@ bool GlobMatcher::addCharClass(
   return false;
 }
 
+GlobMatcher::Shape GlobMatcher::getShape(const vector<uint8_t>& pattern) {
+  // The layouts of the shapes, where LEN is followed by LEN bytes of literal
+  // data:
+  //   LITERAL:  GLOB_LITERAL LEN
+  //   PREFIX:   GLOB_LITERAL LEN GLOB_STAR BOOL
+  //   SUFFIX:   GLOB_ENDS_WITH BOOL LEN
+  //   CONTAINS: GLOB_STAR BOOL GLOB_LITERAL LEN GLOB_STAR GLOB_TRUE
+  auto size = pattern.size();
+  if (size < 2) {
+    return Shape::GENERAL;
+  }
+  if (pattern[0] == GLOB_LITERAL) {
+    auto end = size_t{2} + pattern[1];
+    if (size == end) {
+      return Shape::LITERAL;
+    }
+    if (size == end + 2 && pattern[end] == GLOB_STAR) {
+      return Shape::PREFIX;
+    }
+  } else if (pattern[0] == GLOB_ENDS_WITH) {
+    if (size >= 3 && size == size_t{3} + pattern[2]) {
+      return Shape::SUFFIX;
+    }
+  } else if (
+      pattern[0] == GLOB_STAR && size >= 4 && pattern[2] == GLOB_LITERAL) {
+    auto end = size_t{4} + pattern[3];
+    auto literalBegin = pattern.begin() + 4;
+    if (size == end + 2 && pattern[end] == GLOB_STAR &&
+        pattern[end + 1] == GLOB_TRUE &&
+        std::find(literalBegin, literalBegin + pattern[3], '/') ==
+            literalBegin + pattern[3]) {
+      return Shape::CONTAINS;
+    }
+  }
+  return Shape::GENERAL;
+}
+
 bool GlobMatcher::match(std::string_view text) const {
+  // These must behave exactly like tryMatchAt() on the same patterns.
+  auto noSlash = [](std::string_view piece) {
+    return memchr(piece.data(), '/', piece.size()) == nullptr;
+  };
+  auto startsWithBannedDot = [&](size_t boolIdx, size_t textIdx) {
+    return pattern_[boolIdx] != GLOB_TRUE && textIdx < text.size() &&
+        text[textIdx] == '.';
+  };
+
+  switch (shape_) {
+    case Shape::LITERAL: {
+      auto literal = getLiteral(1);
+      return text.size() == literal.size() &&
+          isStringPieceEqual(text, literal, caseSensitive_);
+    }
+    case Shape::PREFIX: {
+      auto literal = getLiteral(1);
+      return text.size() >= literal.size() &&
+          isStringPieceEqual(
+                 text.substr(0, literal.size()), literal, caseSensitive_) &&
+          !startsWithBannedDot(pattern_.size() - 1, literal.size()) &&
+          noSlash(text.substr(literal.size()));
+    }
+    case Shape::SUFFIX: {
+      auto literal = getLiteral(2);
+      return text.size() >= literal.size() && !startsWithBannedDot(1, 0) &&
+          isStringPieceEqual(
+                 text.substr(text.size() - literal.size()),
+                 literal,
+                 caseSensitive_) &&
+          noSlash(text.substr(0, text.size() - literal.size()));
+    }
+    case Shape::CONTAINS: {
+      // Neither '*' nor the literal can match a '/', so the literal can be
+      // anywhere in a text without one. getShape() checked that the second
+      // '*' may match a leading dot.
+      if (startsWithBannedDot(1, 0) || !noSlash(text)) {
+        return false;
+      }
+      auto literal = getLiteral(3);
+      auto found = caseSensitive_ == CaseSensitivity::Sensitive
+          ? qfind(
+                folly::StringPiece{text},
+                folly::StringPiece{literal},
+                folly::AsciiCaseSensitive{})
+          : qfind(
+                folly::StringPiece{text},
+                folly::StringPiece{literal},
+                folly::AsciiCaseInsensitive{});
+      return found != std::string_view::npos;
+    }
+    case Shape::GENERAL:
+      break;
+  }
   return tryMatchAt(text, 0, 0);
 }
 
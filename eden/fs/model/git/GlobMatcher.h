@@ -79,10 +79,39 @@ class GlobMatcher {
   bool match(std::string_view text) const;
 
  private:
+  /**
+   * The shapes of pattern buffers that match() handles without interpreting
+   * the opcodes. Most of our patterns are one of these.
+   */
+  enum class Shape : uint8_t {
+    // Any other pattern, which goes through tryMatchAt().
+    GENERAL,
+    // "literal"
+    LITERAL,
+    // "prefix*"
+    PREFIX,
+    // "*suffix", compiled as GLOB_ENDS_WITH.
+    SUFFIX,
+    // "*infix*", where infix has no '/'.
+    CONTAINS,
+  };
+
   explicit GlobMatcher(
       std::vector<uint8_t> pattern,
       CaseSensitivity caseSensitive);
 
+  static Shape getShape(const std::vector<uint8_t>& pattern);
+
+  /**
+   * The literal section of a pattern buffer, starting with its length byte
+   * at idx.
+   */
+  std::string_view getLiteral(size_t idx) const {
+    return std::string_view{
+        reinterpret_cast<const char*>(pattern_.data()) + idx + 1,
+        pattern_[idx]};
+  }
+
   static folly::Expected<size_t, std::string> parseBracketExpr(
       std::string_view glob,
       size_t idx,
@@ -127,6 +156,7 @@ class GlobMatcher {
   std::vector<uint8_t> pattern_;
 
   CaseSensitivity caseSensitive_;
+  Shape shape_{Shape::GENERAL};
 };
 
 } // namespace facebook::eden
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/model/git/BasenameGlobIndex.h"
+
+#include <folly/portability/GTest.h>
+#include <algorithm>
+
+namespace {
+
+using namespace facebook::eden;
+
+const std::vector<std::string_view> kPaths = {
+    "BUCK",
+    "foo/BUCK",
+    "foo/bar/Buck",
+    "foo/TARGETS.bzl",
+    "main.cpp",
+    ".cpp",
+    "foo/.hidden.cpp",
+    "foo/.cpp",
+    ".git/foo.cpp",
+    "foo/.eden/bar.h",
+    "foo/bar.hpp",
+    "foo/bar.h",
+    "foo/bar.H",
+    "foo/bar.cpp/baz",
+    ".gitignore",
+    "foo/.gitignore",
+};
+
+void expectSameAsGlobMatcher(
+    const std::vector<std::string_view>& patterns,
+    GlobOptions options) {
+  BasenameGlobIndex index{options};
+  std::vector<GlobMatcher> matchers;
+  for (auto pattern : patterns) {
+    ASSERT_TRUE(index.add(pattern)) << pattern;
+    matchers.push_back(GlobMatcher::create(pattern, options).value());
+  }
+
+  for (auto path : kPaths) {
+    bool expected = std::any_of(
+        matchers.begin(), matchers.end(), [&](const GlobMatcher& matcher) {
+          return matcher.match(path);
+        });
+    EXPECT_EQ(expected, index.match(path))
+        << path << " with options " << static_cast<uint32_t>(options);
+  }
+}
+
+TEST(BasenameGlobIndex, matchesLikeGlobMatcher) {
+  std::vector<std::string_view> patterns = {
+      "**/BUCK", "**/*.cpp", "**/*.h", "**/.gitignore", "**/*S.bzl", "**/*"};
+  for (auto options :
+       {GlobOptions::DEFAULT,
+        GlobOptions::IGNORE_DOTFILES,
+        GlobOptions::CASE_INSENSITIVE,
+        GlobOptions::IGNORE_DOTFILES | GlobOptions::CASE_INSENSITIVE}) {
+    // Without "**/*", which matches almost everything.
+    expectSameAsGlobMatcher(
+        {patterns.begin(), patterns.end() - 1}, options);
+    expectSameAsGlobMatcher(patterns, options);
+  }
+}
+
+TEST(BasenameGlobIndex, rejectsOtherPatterns) {
+  BasenameGlobIndex index;
+  EXPECT_FALSE(index.add("*.cpp"));
+  EXPECT_FALSE(index.add("foo/**/*.cpp"));
+  EXPECT_FALSE(index.add("**/foo/*.cpp"));
+  EXPECT_FALSE(index.add("**/*.c?p"));
+  EXPECT_FALSE(index.add("**/*.[ch]"));
+  EXPECT_FALSE(index.add("**/foo*"));
+  EXPECT_FALSE(index.add("**/"));
+  EXPECT_FALSE(index.add("**"));
+  EXPECT_TRUE(index.empty());
+  EXPECT_FALSE(index.match("foo.cpp"));
+}
+
+} // namespace
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/model/git/GitIgnoreCache.h"
+
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/model/ObjectId.h"
+
+using namespace facebook::eden;
+
+namespace {
+GitIgnore::MatchResult match(const GitIgnore& ignore, folly::StringPiece path) {
+  return ignore.match(RelativePath{path}, GitIgnore::TYPE_FILE);
+}
+} // namespace
+
+TEST(GitIgnoreCache, blobsAreCachedByTheirId) {
+  GitIgnoreCache cache{8};
+  auto blobId = ObjectId::sha1(std::string{"*.o\n"});
+  EXPECT_EQ(nullptr, cache.get(blobId));
+
+  auto inserted = cache.insert(blobId, "*.o\n");
+  auto cached = cache.get(blobId);
+  ASSERT_NE(nullptr, cached);
+  EXPECT_EQ(inserted, cached);
+  EXPECT_EQ(GitIgnore::EXCLUDE, match(*cached, "foo.o"));
+  EXPECT_EQ(GitIgnore::NO_MATCH, match(*cached, "foo.c"));
+
+  EXPECT_EQ(nullptr, cache.get(ObjectId::sha1(std::string{"other"})));
+
+  auto stats = cache.getStats();
+  EXPECT_EQ(1, stats.hits);
+  EXPECT_EQ(2, stats.misses);
+}
+
+TEST(GitIgnoreCache, contentsAreCachedByTheirHash) {
+  GitIgnoreCache cache{8};
+  auto first = cache.parse("build/\n");
+  auto second = cache.parse("build/\n");
+  EXPECT_EQ(first, second);
+  EXPECT_NE(first, cache.parse("dist/\n"));
+
+  // Contents are cached apart from blobs.
+  auto blobId = ObjectId::sha1(std::string{"build/\n"});
+  EXPECT_EQ(nullptr, cache.get(blobId));
+
+  auto stats = cache.getStats();
+  EXPECT_EQ(1, stats.hits);
+  EXPECT_EQ(3, stats.misses);
+}
+
+TEST(GitIgnoreCache, leastRecentlyUsedEntriesAreEvicted) {
+  GitIgnoreCache cache{2};
+  auto a = ObjectId::sha1(std::string{"a"});
+  auto b = ObjectId::sha1(std::string{"b"});
+  auto c = ObjectId::sha1(std::string{"c"});
+  cache.insert(a, "a\n");
+  cache.insert(b, "b\n");
+  EXPECT_NE(nullptr, cache.get(a));
+  cache.insert(c, "c\n");
+
+  EXPECT_NE(nullptr, cache.get(a));
+  EXPECT_EQ(nullptr, cache.get(b));
+  EXPECT_NE(nullptr, cache.get(c));
+}
@@ -668,3 +668,55 @@ TEST(GitIgnore, directory) {
   // path known to be a file.  It expects ignored directories earlier in the
   // path to have already been filtered out.
 }
+
+TEST(GitIgnore, mixedPatternKindsKeepPrecedence) {
+  // Literal names, literal paths, suffixes and globs are looked up
+  // separately, but the last matching line still wins.
+  GitIgnore ignore;
+  ignore.loadFile(
+      "*.o\n"
+      "!keep.o\n"
+      "buck-out/\n"
+      "/gen/out.txt\n"
+      "!gen/*.txt\n"
+      "k*.o\n"
+      "*.so\n"
+      "!lib.so\n"
+      "*.txt\n"
+      "!notes.txt\n");
+
+  EXPECT_IGNORE(ignore, EXCLUDE, "main.o");
+  EXPECT_IGNORE(ignore, EXCLUDE, "keep.o");
+  EXPECT_IGNORE(ignore, EXCLUDE, "src/keep.o");
+  EXPECT_IGNORE(ignore, EXCLUDE, "lib.so.so");
+  EXPECT_IGNORE(ignore, INCLUDE, "lib.so");
+  EXPECT_IGNORE(ignore, EXCLUDE, "a/b/lib.o");
+  EXPECT_IGNORE(ignore, NO_MATCH, "o");
+  EXPECT_IGNORE(ignore, NO_MATCH, ".so.o.x");
+
+  EXPECT_IGNORE_DIR(ignore, EXCLUDE, "buck-out");
+  EXPECT_IGNORE_DIR(ignore, EXCLUDE, "a/buck-out");
+  EXPECT_IGNORE(ignore, NO_MATCH, "buck-out");
+
+  EXPECT_IGNORE(ignore, EXCLUDE, "gen/out.txt");
+  EXPECT_IGNORE(ignore, INCLUDE, "notes.txt");
+  EXPECT_IGNORE(ignore, EXCLUDE, "a/gen/out.txt");
+}
+
+TEST(GitIgnore, literalPatternsBeforeGlobs) {
+  GitIgnore ignore;
+  ignore.loadFile(
+      "!TARGETS\n"
+      "T*\n"
+      "!/build\n"
+      "b*\n"
+      "*.py\n"
+      "!setup.py\n"
+      "set*\n");
+
+  EXPECT_IGNORE(ignore, EXCLUDE, "TARGETS");
+  EXPECT_IGNORE(ignore, EXCLUDE, "build");
+  EXPECT_IGNORE(ignore, EXCLUDE, "setup.py");
+  EXPECT_IGNORE(ignore, EXCLUDE, "main.py");
+  EXPECT_IGNORE(ignore, NO_MATCH, "main.pyc");
+}
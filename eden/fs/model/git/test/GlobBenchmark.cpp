@@ -6,8 +6,10 @@
  */
 
 #include <benchmark/benchmark.h>
+#include <fmt/format.h>
 #include <re2/re2.h>
 
+#include "eden/fs/model/git/BasenameGlobIndex.h"
 #include "eden/fs/model/git/GlobMatcher.h"
 #include "watchman/thirdparty/wildmatch/wildmatch.h"
 
@@ -353,4 +355,56 @@ GBENCHMARK(fullpath_re2_case_insensitive)(benchmark::State& state) {
       CaseSensitivity::Insensitive);
 }
 
+/**
+ * A large set of recursive basename globs, as a build system asking for
+ * every file of a few thousand target names and extensions would send.
+ */
+std::vector<std::string> makeRecursiveGlobs(size_t count) {
+  std::vector<std::string> globs;
+  globs.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    globs.push_back(
+        i % 2 == 0 ? fmt::format("**/TARGETS{}", i)
+                   : fmt::format("**/*.ext{}", i));
+  }
+  // Make sure that part of the corpus does match.
+  globs.push_back("**/README");
+  globs.push_back("**/*.c");
+  return globs;
+}
+
+GBENCHMARK(manyRecursiveGlobs_globmatch)(benchmark::State& state) {
+  std::vector<GlobMatcher> matchers;
+  for (const auto& glob : makeRecursiveGlobs(10000)) {
+    matchers.push_back(GlobMatcher::create(glob, GlobOptions::DEFAULT).value());
+  }
+
+  size_t idx = 0;
+  for (auto _ : state) {
+    bool ret = false;
+    for (const auto& matcher : matchers) {
+      if (matcher.match(fullnameCorpus[idx])) {
+        ret = true;
+        break;
+      }
+    }
+    benchmark::DoNotOptimize(ret);
+    idx = (idx + 1) % fullnameCorpus.size();
+  }
+}
+
+GBENCHMARK(manyRecursiveGlobs_basenameIndex)(benchmark::State& state) {
+  BasenameGlobIndex index;
+  for (const auto& glob : makeRecursiveGlobs(10000)) {
+    index.add(glob);
+  }
+
+  size_t idx = 0;
+  for (auto _ : state) {
+    auto ret = index.match(fullnameCorpus[idx]);
+    benchmark::DoNotOptimize(ret);
+    idx = (idx + 1) % fullnameCorpus.size();
+  }
+}
+
 BENCHMARK_MAIN();
@@ -433,6 +433,42 @@ TEST(Glob, testRangeMerging) {
   EXPECT_NOMATCH("A", "[b-ca-c]");
 }
 
+TEST(Glob, specializedShapes) {
+  // Literal, prefix, suffix and infix patterns skip the opcode interpreter.
+  EXPECT_MATCH("TARGETS", "TARGETS");
+  EXPECT_NOMATCH("TARGETS.v2", "TARGETS");
+  EXPECT_NOMATCH("TARGET", "TARGETS");
+  EXPECT_CASE_INSENSITIVE_MATCH("targets", "TARGETS");
+
+  EXPECT_MATCH("buck-out", "buck-*");
+  EXPECT_MATCH("buck-", "buck-*");
+  EXPECT_NOMATCH("buck-out/gen", "buck-*");
+  EXPECT_NOMATCH("buck", "buck-*");
+  EXPECT_MATCH("out/.hidden", "out/*");
+  EXPECT_IGNORE_DOTFILES_NOMATCH("out/.hidden", "out/*");
+  EXPECT_IGNORE_DOTFILES_MATCH("out/visible", "out/*");
+  EXPECT_IGNORE_DOTFILES_MATCH("a.b", "a*");
+  EXPECT_CASE_INSENSITIVE_MATCH("BUCK-OUT", "buck-*");
+
+  EXPECT_MATCH("foo.txt", "*.txt");
+  EXPECT_NOMATCH("dir/foo.txt", "*.txt");
+  EXPECT_NOMATCH("foo.txt.bak", "*.txt");
+  EXPECT_IGNORE_DOTFILES_NOMATCH(".foo.txt", "*.txt");
+  EXPECT_CASE_INSENSITIVE_MATCH("FOO.TXT", "*.txt");
+
+  EXPECT_MATCH("test_foo.py", "*foo*");
+  EXPECT_MATCH("foo", "*foo*");
+  EXPECT_NOMATCH("fo", "*foo*");
+  EXPECT_NOMATCH("a/foo", "*foo*");
+  EXPECT_NOMATCH("foo/a", "*foo*");
+  EXPECT_MATCH(".foo.", "*foo*");
+  EXPECT_IGNORE_DOTFILES_NOMATCH(".foo", "*foo*");
+  EXPECT_IGNORE_DOTFILES_MATCH("a.foo.", "*foo*");
+  EXPECT_CASE_INSENSITIVE_MATCH("xFOOx", "*foo*");
+  EXPECT_MATCH("a/b", "*a/*");
+  EXPECT_NOMATCH("x/a/b", "*a/*");
+}
+
 TEST(Glob, testCaseInsensitive) {
   EXPECT_CASE_INSENSITIVE_MATCH("a", "[A-Z]");
   EXPECT_CASE_INSENSITIVE_MATCH("A", "[a-z]");
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/model/CompactTree.h"
+
+#include <folly/Utility.h>
+#include <folly/io/Cursor.h>
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/model/Tree.h"
+
+using namespace facebook::eden;
+
+namespace {
+ObjectId makeId(const std::string& name) {
+  return ObjectId::sha1(name);
+}
+
+Tree makeTree(CaseSensitivity caseSensitive = kPathMapDefaultCaseSensitive) {
+  Tree::container entries{caseSensitive};
+  entries.emplace(
+      PathComponent{"README"},
+      makeId("README"),
+      TreeEntryType::REGULAR_FILE,
+      42,
+      Hash20::sha1(std::string{"readme contents"}));
+  entries.emplace(PathComponent{"bin"}, makeId("bin"), TreeEntryType::TREE);
+  entries.emplace(
+      PathComponent{"run.sh"},
+      makeId("run.sh"),
+      TreeEntryType::EXECUTABLE_FILE);
+  return Tree{std::move(entries), makeId("tree")};
+}
+
+std::string serializeV1(const Tree& tree) {
+  folly::IOBuf buf;
+  folly::io::Appender appender(&buf, 256);
+  appender.write<uint32_t>(1);
+  appender.write<uint32_t>(folly::to_narrow(tree.size()));
+  for (const auto& [name, entry] : tree) {
+    entry.serialize(name, appender);
+  }
+  return buf.moveToFbString().toStdString();
+}
+
+void expectSameEntries(const Tree& tree, const CompactTree& compact) {
+  ASSERT_EQ(tree.size(), compact.size());
+  auto it = compact.begin();
+  for (const auto& [name, entry] : tree) {
+    ASSERT_NE(compact.end(), it);
+    auto compactEntry = *it++;
+    EXPECT_EQ(name, compactEntry.getName());
+    EXPECT_EQ(entry.getHash(), compactEntry.getHash());
+    EXPECT_EQ(entry.getType(), compactEntry.getType());
+    EXPECT_EQ(entry.getSize(), compactEntry.getSize());
+    EXPECT_EQ(entry.getContentSha1(), compactEntry.getContentSha1());
+  }
+  EXPECT_EQ(compact.end(), it);
+}
+} // namespace
+
+TEST(CompactTree, copiesEntriesOfTree) {
+  auto tree = makeTree();
+  CompactTree compact{tree};
+  EXPECT_EQ(tree.getHash(), compact.getHash());
+  EXPECT_EQ(tree.getCaseSensitivity(), compact.getCaseSensitivity());
+  expectSameEntries(tree, compact);
+}
+
+TEST(CompactTree, find) {
+  CompactTree compact{makeTree(CaseSensitivity::Sensitive)};
+
+  auto entry = compact.find(PathComponentPiece{"run.sh"});
+  ASSERT_TRUE(entry.has_value());
+  EXPECT_EQ(PathComponentPiece{"run.sh"}, entry->getName());
+  EXPECT_EQ(TreeEntryType::EXECUTABLE_FILE, entry->getType());
+  EXPECT_FALSE(entry->isTree());
+  EXPECT_TRUE(compact.find(PathComponentPiece{"bin"})->isTree());
+
+  EXPECT_FALSE(compact.find(PathComponentPiece{"readme"}).has_value());
+  EXPECT_FALSE(compact.find(PathComponentPiece{"missing"}).has_value());
+}
+
+TEST(CompactTree, findIsCaseInsensitiveWhenTheTreeIs) {
+  CompactTree compact{makeTree(CaseSensitivity::Insensitive)};
+
+  auto entry = compact.find(PathComponentPiece{"readme"});
+  ASSERT_TRUE(entry.has_value());
+  EXPECT_EQ(PathComponentPiece{"README"}, entry->getName());
+  EXPECT_TRUE(compact.find(PathComponentPiece{"RUN.SH"}).has_value());
+}
+
+TEST(CompactTree, deserializesSerializedTree) {
+  auto tree = makeTree();
+  auto serialized = tree.serialize();
+  auto compact = CompactTree::tryDeserialize(
+      tree.getHash(),
+      folly::StringPiece{serialized.coalesce()});
+  ASSERT_NE(nullptr, compact);
+  EXPECT_EQ(tree.getHash(), compact->getHash());
+  expectSameEntries(tree, *compact);
+}
+
+TEST(CompactTree, deserializesEmptyTree) {
+  Tree tree{Tree::container{kPathMapDefaultCaseSensitive}, makeId("empty")};
+  auto serialized = tree.serialize();
+  auto compact = CompactTree::tryDeserialize(
+      tree.getHash(),
+      folly::StringPiece{serialized.coalesce()});
+  ASSERT_NE(nullptr, compact);
+  EXPECT_EQ(0, compact->size());
+  EXPECT_EQ(compact->end(), compact->begin());
+  EXPECT_FALSE(compact->find(PathComponentPiece{"a"}).has_value());
+}
+
+TEST(CompactTree, rejectsCorruptedData) {
+  auto tree = makeTree();
+  auto serialized = tree.serialize();
+  auto data = folly::StringPiece{serialized.coalesce()};
+
+  EXPECT_EQ(nullptr, CompactTree::tryDeserialize(tree.getHash(), ""));
+  for (size_t size : {size_t{4}, size_t{9}, data.size() - 1}) {
+    EXPECT_EQ(
+        nullptr,
+        CompactTree::tryDeserialize(
+            tree.getHash(), folly::StringPiece{data.data(), size}))
+        << "truncated to " << size << " bytes";
+  }
+
+  // The name of the first record points past the end of the data.
+  auto badOffset = data.str();
+  uint32_t offset = 1000;
+  memcpy(badOffset.data() + 2 * sizeof(uint32_t), &offset, sizeof(offset));
+  EXPECT_EQ(nullptr, CompactTree::tryDeserialize(tree.getHash(), badOffset));
+
+  auto unknownVersion = data.str();
+  unknownVersion[0] = 42;
+  EXPECT_EQ(
+      nullptr, CompactTree::tryDeserialize(tree.getHash(), unknownVersion));
+}
+
+TEST(CompactTree, deserializesV1Tree) {
+  auto tree = makeTree();
+  auto compact = CompactTree::tryDeserialize(tree.getHash(), serializeV1(tree));
+  ASSERT_NE(nullptr, compact);
+  expectSameEntries(tree, *compact);
+
+  auto extra = serializeV1(tree) + "x";
+  EXPECT_EQ(nullptr, CompactTree::tryDeserialize(tree.getHash(), extra));
+}
+
+TEST(CompactTree, v2SerializationRoundTrips) {
+  auto tree = makeTree();
+  CompactTree compact{tree};
+  auto serialized = compact.serialize();
+  auto data = folly::StringPiece{serialized.coalesce()};
+
+  uint32_t version;
+  memcpy(&version, data.data(), sizeof(version));
+  EXPECT_EQ(2, version);
+
+  auto decoded = CompactTree::tryDeserialize(tree.getHash(), data);
+  ASSERT_NE(nullptr, decoded);
+  expectSameEntries(tree, *decoded);
+  EXPECT_EQ(tree, *Tree::tryDeserialize(tree.getHash(), data));
+}
+
+TEST(CompactTree, isSmallerThanTree) {
+  Tree::container entries{kPathMapDefaultCaseSensitive};
+  for (int i = 0; i < 100; ++i) {
+    auto name = folly::to<std::string>("file", i);
+    entries.emplace(
+        PathComponent{name}, makeId(name), TreeEntryType::REGULAR_FILE);
+  }
+  Tree tree{std::move(entries), makeId("tree")};
+  CompactTree compact{tree};
+  EXPECT_LT(compact.getSizeBytes(), tree.getSizeBytes());
+}
+
+TEST(CompactTree, convertsBackToTree) {
+  auto tree = makeTree(CaseSensitivity::Insensitive);
+  auto roundTripped = CompactTree{tree}.toTree();
+  EXPECT_EQ(tree, *roundTripped);
+  EXPECT_EQ(CaseSensitivity::Insensitive, roundTripped->getCaseSensitivity());
+}
@@ -224,3 +224,30 @@ TEST(Hash20, formatting) {
   Hash20 h("0123456789abcdeffedcba987654321076543210");
   EXPECT_EQ("0123456789abcdeffedcba987654321076543210", fmt::to_string(h));
 }
+
+TEST(Hash20, hexConstructorAcceptsUppercase) {
+  EXPECT_EQ(testHash, Hash20("FACEB00CDEADBEEFC00010FF1BADB0028BADF00D"));
+}
+
+TEST(Hash20, ensureStringConstructorRejectsBadCharactersInTail) {
+  EXPECT_THROW(
+      Hash20("faceb00cdeadbeefc00010ff1badb0028badf00z"),
+      std::invalid_argument);
+}
+
+TEST(Hash20, hashesToHex) {
+  std::vector<Hash20> hashes{testHash, kZeroHash, kEmptySha1};
+  std::string hex(hashes.size() * 40, '\0');
+  hashesToHex(HashRange{hashes.data(), hashes.size()}, hex.data());
+  EXPECT_EQ(
+      testHash.toString() + kZeroHash.toString() + kEmptySha1.toString(), hex);
+  EXPECT_EQ(hashes, hashesFromHex(hex));
+}
+
+TEST(Hash20, hashesFromHexRejectsInvalidInput) {
+  EXPECT_TRUE(hashesFromHex("").empty());
+  EXPECT_THROW(hashesFromHex(testHashHex + "00"), std::invalid_argument);
+  EXPECT_THROW(
+      hashesFromHex(testHashHex + "faceb00cdeadbeefc00010ff1badb0028badf00Z"),
+      std::invalid_argument);
+}
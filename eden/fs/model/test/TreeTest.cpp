@@ -6,6 +6,8 @@
  */
 
 #include <folly/String.h>
+#include <folly/Utility.h>
+#include <folly/io/Cursor.h>
 #include <folly/portability/GTest.h>
 
 #include "eden/fs/model/Hash.h"
@@ -83,4 +85,36 @@ TEST(Tree, testSize) {
   EXPECT_LE(numEntries * entrySize + Hash20::RAW_SIZE, tree.getSizeBytes());
 }
 
+TEST(Tree, testDeserializeV1AndV2) {
+  Tree::container entries{kPathMapDefaultCaseSensitive};
+  entries.emplace(
+      PathComponent{"a_file"},
+      testHash,
+      TreeEntryType::REGULAR_FILE,
+      5,
+      Hash20::sha1(std::string{"hello"}));
+  entries.emplace(PathComponent{"a_dir"}, testHash, TreeEntryType::TREE);
+  Tree tree(std::move(entries), testHash);
+
+  // Trees stored by older versions use the V1 format.
+  folly::IOBuf v1;
+  folly::io::Appender appender(&v1, 256);
+  appender.write<uint32_t>(1);
+  appender.write<uint32_t>(folly::to_narrow(tree.size()));
+  for (const auto& [name, entry] : tree) {
+    entry.serialize(name, appender);
+  }
+  auto fromV1 =
+      Tree::tryDeserialize(testHash, folly::StringPiece{v1.coalesce()});
+  ASSERT_TRUE(fromV1);
+  EXPECT_EQ(tree, *fromV1);
+
+  auto v2 = tree.serialize();
+  auto fromV2 =
+      Tree::tryDeserialize(testHash, folly::StringPiece{v2.coalesce()});
+  ASSERT_TRUE(fromV2);
+  EXPECT_EQ(tree, *fromV2);
+  EXPECT_EQ(5, fromV2->find(PathComponentPiece{"a_file"})->second.getSize());
+}
+
 } // namespace facebook::eden
@@ -136,9 +136,18 @@ class SpawnedEdenInstance::StartupStatusChecker : private AsyncTimeout {
     // Save client_ as a member variable so that we can destroy it in
     // startupAborted() to cancel the pending thrift call.
     client_ = instance_->monitor_->createEdenThriftClient();
-    return client_->future_getStatus().thenTry([](Try<fb303_status> status) {
-      return status.hasValue() && (status.value() == fb303_status::ALIVE);
-    });
+    // During a graceful restart the previous EdenFS process answers on the
+    // socket until it hands it off, so check that we are talking to ours.
+    return client_->future_getPid()
+        .thenValue([this, pid = instance_->getPid()](int64_t daemonPid) {
+          if (daemonPid != pid) {
+            return folly::makeFuture<fb303_status>(fb303_status::STARTING);
+          }
+          return client_->future_getStatus();
+        })
+        .thenTry([](Try<fb303_status> status) {
+          return status.hasValue() && (status.value() == fb303_status::ALIVE);
+        });
   }
 
   folly::Promise<Unit> promise_;
@@ -149,12 +158,14 @@ class SpawnedEdenInstance::StartupStatusChecker : private AsyncTimeout {
 
 SpawnedEdenInstance::SpawnedEdenInstance(
     EdenMonitor* monitor,
-    std::shared_ptr<LogFile> log)
+    std::shared_ptr<LogFile> log,
+    bool gracefulRestart)
     : EdenInstance(monitor),
       EventHandler(monitor->getEventBase()),
       AsyncTimeout(monitor->getEventBase()),
       edenfsExe_(AbsolutePath(FLAGS_edenfs)),
-      log_(std::move(log)) {}
+      log_(std::move(log)),
+      gracefulRestart_(gracefulRestart) {}
 
 SpawnedEdenInstance::~SpawnedEdenInstance() {
   // If we are still waiting on the StartupStatusChecker, explicitly
@@ -183,6 +194,12 @@ Future<Unit> SpawnedEdenInstance::start() {
       "--startupLogPath",
       startupLog.value(),
   };
+  if (gracefulRestart_) {
+    // The new process starts its backing stores before it asks the running
+    // one to hand its mounts off, so that they are only unavailable for the
+    // handoff itself.
+    argv.push_back("--takeover");
+  }
   if (!FLAGS_edenfsctl.empty()) {
     argv.push_back("--edenfsctlPath");
     argv.push_back(FLAGS_edenfsctl);
@@ -277,10 +294,12 @@ void SpawnedEdenInstance::timeoutExpired() noexcept {
   // major problem in practice.
   SpawnedProcess::Options options;
   options.dup2(
-      FileDescriptor(::dup(log_->fd()), "dup", FileDescriptor::FDType::Generic),
+      FileDescriptor(
+          log_->dupFile().release(), "dup", FileDescriptor::FDType::Generic),
       STDOUT_FILENO);
   options.dup2(
-      FileDescriptor(::dup(log_->fd()), "dup", FileDescriptor::FDType::Generic),
+      FileDescriptor(
+          log_->dupFile().release(), "dup", FileDescriptor::FDType::Generic),
       STDERR_FILENO);
   options.dup2(logPipe_.duplicate(), STDIN_FILENO);
   options.executablePath(AbsolutePathPiece(FLAGS_cat_exe));
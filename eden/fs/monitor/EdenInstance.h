@@ -94,7 +94,14 @@ class SpawnedEdenInstance : public EdenInstance,
                             private folly::EventHandler,
                             private folly::AsyncTimeout {
  public:
-  SpawnedEdenInstance(EdenMonitor* monitor, std::shared_ptr<LogFile> log);
+  /**
+   * With gracefulRestart, the new process takes over the mounts of the
+   * running one rather than mounting them itself.
+   */
+  SpawnedEdenInstance(
+      EdenMonitor* monitor,
+      std::shared_ptr<LogFile> log,
+      bool gracefulRestart);
   ~SpawnedEdenInstance() override;
 
   FOLLY_NODISCARD folly::Future<folly::Unit> start() override;
@@ -129,6 +136,7 @@ class SpawnedEdenInstance : public EdenInstance,
   pid_t pid_{0};
   FileDescriptor logPipe_;
   std::shared_ptr<LogFile> log_;
+  bool gracefulRestart_{false};
   std::unique_ptr<StartupStatusChecker> startupChecker_;
 
   // EdenInstance objects are always allocated on the heap, so we just
@@ -85,9 +85,9 @@ EdenMonitor::EdenMonitor(
   signalHandler_->registerSignalHandler(SIGHUP);
   signalHandler_->registerSignalHandler(SIGINT);
   signalHandler_->registerSignalHandler(SIGTERM);
+  signalHandler_->registerSignalHandler(SIGUSR1);
   // Eventually we should register some other signals for additional actions.
   // Perhaps:
-  // - SIGUSR1: request a graceful restart when the system looks idle
   // - SIGUSR2: request a hard restart (exit) when the system looks idle
 
   auto logDir = edenDir_ + "logs"_relpath;
@@ -97,10 +97,15 @@ EdenMonitor::EdenMonitor(
   unique_ptr<LogRotationStrategy> rotationStrategy;
   if (maxLogSize > 0) {
     rotationStrategy = make_unique<TimestampLogRotation>(
-        config->maxRotatedLogFiles.getValue());
+        config->maxRotatedLogFiles.getValue(),
+        /*clock=*/nullptr,
+        config->compressRotatedLogs.getValue());
   }
   log_ = std::make_shared<LogFile>(
-      logDir + "edenfs.log"_relpath, maxLogSize, std::move(rotationStrategy));
+      logDir + "edenfs.log"_relpath,
+      maxLogSize,
+      std::move(rotationStrategy),
+      config->maxBufferedLogBytes.getValue());
 }
 
 EdenMonitor::~EdenMonitor() {}
@@ -137,7 +142,8 @@ Future<Unit> EdenMonitor::getEdenInstance() {
   if (FLAGS_restart && FLAGS_childEdenFSPid) {
     XLOG(INFO) << "taking over management of existing EdenFS daemon "
                << FLAGS_childEdenFSPid;
-    auto edenfs = std::make_unique<SpawnedEdenInstance>(this, log_);
+    auto edenfs = std::make_unique<SpawnedEdenInstance>(
+        this, log_, /*gracefulRestart=*/false);
     edenfs->takeover(FLAGS_childEdenFSPid, FLAGS_childEdenFSPipe);
     edenfs_ = std::move(edenfs);
     return folly::makeFuture();
@@ -157,7 +163,8 @@ Future<Unit> EdenMonitor::getEdenInstance() {
       edenfs_ = std::make_unique<ExistingEdenInstance>(this, pid.value());
       future = edenfs_->start();
     } else {
-      edenfs_ = std::make_unique<SpawnedEdenInstance>(this, log_);
+      edenfs_ = std::make_unique<SpawnedEdenInstance>(
+          this, log_, /*gracefulRestart=*/false);
       future = edenfs_->start();
       XLOG(INFO) << "starting new EdenFS process " << edenfs_->getPid();
     }
@@ -176,11 +183,87 @@ std::shared_ptr<EdenServiceAsyncClient> EdenMonitor::createEdenThriftClient() {
   return std::make_shared<EdenServiceAsyncClient>(std::move(channel));
 }
 
-void EdenMonitor::edenInstanceFinished(EdenInstance* /*instance*/) {
+void EdenMonitor::edenInstanceFinished(EdenInstance* instance) {
+  // The instance calls us from its own methods, so it is only destroyed once
+  // they return.
+  if (instance == gracefulRestartNewEdenfs_.get()) {
+    // The previous process is still serving the mounts.  Destroying the new
+    // instance fails its startup, which ends the graceful restart.
+    XLOG(ERR) << "new EdenFS process " << instance->getPid()
+              << " exited during graceful restart";
+    eventBase_.runInLoop([this] { gracefulRestartNewEdenfs_.reset(); });
+    return;
+  }
+  if (instance == gracefulRestartOldEdenfs_.get()) {
+    XLOG(DBG1) << "previous EdenFS process " << instance->getPid()
+               << " has exited";
+    eventBase_.runInLoop([this] { gracefulRestartOldEdenfs_.reset(); });
+    return;
+  }
+  if (instance == edenfs_.get() && gracefulRestartNewEdenfs_) {
+    // The previous process handed its mounts off and exited while the new one
+    // is finishing its startup: monitor the new one from now on.
+    XLOG(INFO) << "EdenFS process " << instance->getPid()
+               << " handed off to " << gracefulRestartNewEdenfs_->getPid();
+    gracefulRestartOldEdenfs_ = std::move(edenfs_);
+    edenfs_ = std::move(gracefulRestartNewEdenfs_);
+    eventBase_.runInLoop([this] { gracefulRestartOldEdenfs_.reset(); });
+    return;
+  }
+
   XLOG(DBG1) << "EdenFS has exited; terminating the monitor";
   eventBase_.terminateLoopSoon();
 }
 
+std::vector<EdenInstance*> EdenMonitor::getEdenInstances() const {
+  std::vector<EdenInstance*> instances;
+  for (const auto* edenfs :
+       {&edenfs_, &gracefulRestartNewEdenfs_, &gracefulRestartOldEdenfs_}) {
+    if (*edenfs) {
+      instances.push_back(edenfs->get());
+    }
+  }
+  return instances;
+}
+
+void EdenMonitor::performGracefulRestart() {
+  if (state_ != State::Running || gracefulRestartOldEdenfs_) {
+    XLOG(WARN) << "ignoring graceful restart request: "
+               << "EdenFS is still starting or restarting.";
+    return;
+  }
+
+  XLOG(INFO) << "Starting a new EdenFS process to take over from EdenFS pid "
+             << edenfs_->getPid();
+  state_ = State::Restarting;
+  gracefulRestartNewEdenfs_ = std::make_unique<SpawnedEdenInstance>(
+      this, log_, /*gracefulRestart=*/true);
+  folly::makeFutureWith([this] { return gracefulRestartNewEdenfs_->start(); })
+      .thenTry([this](Try<Unit> result) {
+        gracefulRestartFinished(std::move(result));
+      });
+}
+
+void EdenMonitor::gracefulRestartFinished(Try<Unit> result) {
+  state_ = State::Running;
+  if (result.hasException()) {
+    XLOG(ERR) << "graceful restart of EdenFS failed: " << result.exception();
+    if (gracefulRestartNewEdenfs_) {
+      eventBase_.runInLoop([this] { gracefulRestartNewEdenfs_.reset(); });
+    }
+    return;
+  }
+
+  // Unless we already noticed that the previous process exited, keep
+  // forwarding its output until it does.
+  if (gracefulRestartNewEdenfs_) {
+    gracefulRestartOldEdenfs_ = std::move(edenfs_);
+    edenfs_ = std::move(gracefulRestartNewEdenfs_);
+  }
+  XLOG(INFO) << "EdenFS pid " << edenfs_->getPid()
+             << " has finished a graceful restart";
+}
+
 void EdenMonitor::performSelfRestart() {
   // For now, ignore SIGHUP requests while EdenFS is still starting.
   // While we could have the new EdenFS daemon be aware that it still needs to
@@ -193,6 +276,12 @@ void EdenMonitor::performSelfRestart() {
         << "EdenFS is still starting.  Attempt this again once EdenFS has started.";
     return;
   }
+  // We only know how to pass a single EdenFS process to the new monitor.
+  if (state_ == State::Restarting || gracefulRestartOldEdenfs_) {
+    XLOG(WARN) << "ignoring self-restart request for the EdenFS monitor: "
+               << "EdenFS is performing a graceful restart.";
+    return;
+  }
 
   // Build a vector of extra arguments to pass along with information about
   // the EdenFS process we are currently monitoring.
@@ -252,21 +341,30 @@ void EdenMonitor::signalReceived(int sig) {
   switch (sig) {
     case SIGCHLD:
       XLOG(DBG2) << "got SIGCHLD";
-      edenfs_->checkLiveness();
+      // checkLiveness() may move the instances around, but they are only
+      // destroyed on the next loop iteration.
+      for (auto* instance : getEdenInstances()) {
+        instance->checkLiveness();
+      }
       return;
     case SIGHUP:
       performSelfRestart();
       return;
+    case SIGUSR1:
+      performGracefulRestart();
+      return;
     case SIGINT:
     case SIGTERM:
-      // Forward the signal to the edenfs instance
+      // Forward the signal to the edenfs instances
       XLOG(DBG1) << "received terminal signal " << sig;
-      auto pid = edenfs_->getPid();
-      XCHECK_GE(pid, 0);
-      auto rc = kill(pid, sig);
-      if (rc != 0) {
-        XLOG(WARN) << "error forwarding signal " << sig
-                   << " to EdenFS: " << folly::errnoStr(errno);
+      for (auto* instance : getEdenInstances()) {
+        auto pid = instance->getPid();
+        XCHECK_GE(pid, 0);
+        auto rc = kill(pid, sig);
+        if (rc != 0) {
+          XLOG(WARN) << "error forwarding signal " << sig
+                     << " to EdenFS: " << folly::errnoStr(errno);
+        }
       }
       return;
   }
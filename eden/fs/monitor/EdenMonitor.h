@@ -8,6 +8,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include <folly/Range.h>
 #include <folly/io/async/EventBase.h>
@@ -17,7 +18,10 @@
 namespace folly {
 template <typename T>
 class Future;
-}
+template <typename T>
+class Try;
+struct Unit;
+} // namespace folly
 
 namespace apache::thrift {
 template <class>
@@ -75,6 +79,14 @@ class EdenMonitor {
    */
   void performSelfRestart();
 
+  /**
+   * Start a new EdenFS process that takes over from the running one.
+   *
+   * The new process gets ready to serve the mounts while the running one
+   * keeps serving them, and only then asks for them to be handed off.
+   */
+  void performGracefulRestart();
+
   /**
    * edenInstanceFinished() should be called by the EdenInstance object when the
    * EdenFS process that it is monitoring has exited.
@@ -86,6 +98,7 @@ class EdenMonitor {
   enum class State {
     Starting,
     Running,
+    Restarting,
   };
 
   EdenMonitor(EdenMonitor const&) = delete;
@@ -93,6 +106,8 @@ class EdenMonitor {
 
   folly::Future<folly::Unit> start();
   folly::Future<folly::Unit> getEdenInstance();
+  void gracefulRestartFinished(folly::Try<folly::Unit> result);
+  std::vector<EdenInstance*> getEdenInstances() const;
 
   void signalReceived(int sig);
 
@@ -110,6 +125,10 @@ class EdenMonitor {
   // process that is starting and attempting to take over state from edenfs_.
   // Otherwise this variable will be null.
   std::unique_ptr<EdenInstance> gracefulRestartNewEdenfs_;
+
+  // The EdenFS process that handed off to edenfs_ in a graceful restart, until
+  // it exits.  We keep forwarding its log output until then.
+  std::unique_ptr<EdenInstance> gracefulRestartOldEdenfs_;
 };
 
 } // namespace facebook::eden
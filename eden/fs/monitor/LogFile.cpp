@@ -8,7 +8,10 @@
 #include "eden/fs/monitor/LogFile.h"
 
 #include <fcntl.h>
+#include <chrono>
+#include <utility>
 
+#include <fmt/format.h>
 #include <folly/FileUtil.h>
 #include <folly/String.h>
 #include <folly/logging/xlog.h>
@@ -39,24 +42,102 @@ namespace facebook::eden {
 LogFile::LogFile(
     const AbsolutePath& path,
     size_t maxSize,
-    std::unique_ptr<LogRotationStrategy> rotationStrategy)
+    std::unique_ptr<LogRotationStrategy> rotationStrategy,
+    size_t maxBufferedBytes)
     : path_{path},
       log_{path.c_str(), O_CREAT | O_WRONLY | O_APPEND | O_CLOEXEC, 0644},
       logSize_{getFileSize(path_, log_)},
       maxLogSize_{maxSize},
       rotationStrategy_{std::move(rotationStrategy)},
+      maxBufferedBytes_{maxBufferedBytes},
       rotationThread_{[this] { runRotateThread(); }} {
   if (rotationStrategy_) {
     rotationStrategy_->init(path_);
   }
+  if (maxBufferedBytes_ > 0) {
+    writeThread_ = std::thread{[this] { runWriteThread(); }};
+  }
 }
 
 LogFile::~LogFile() {
+  if (writeThread_.joinable()) {
+    // Let the write thread flush what is queued before it exits.
+    writeQueue_.lock()->stop = true;
+    writeCV_.notify_one();
+    writeThread_.join();
+  }
   triggerBackgroundRotation(std::nullopt);
   rotationThread_.join();
 }
 
 int LogFile::write(const void* buffer, size_t size) {
+  if (maxBufferedBytes_ == 0) {
+    return writeToFile(buffer, size);
+  }
+
+  {
+    auto queue = writeQueue_.lock();
+    if (queue->bytes + size > maxBufferedBytes_) {
+      queue->droppedBytes += size;
+      droppedBytes_.fetch_add(size, std::memory_order_relaxed);
+      return ENOBUFS;
+    }
+    queue->buffers.emplace_back(static_cast<const char*>(buffer), size);
+    queue->bytes += size;
+  }
+  writeCV_.notify_one();
+  return 0;
+}
+
+folly::File LogFile::dupFile() {
+  std::lock_guard<std::mutex> guard{logMutex_};
+  return log_.dup();
+}
+
+void LogFile::runWriteThread() {
+  while (true) {
+    std::deque<std::string> buffers;
+    size_t droppedBytes;
+    {
+      auto queue = writeQueue_.lock();
+      writeCV_.wait(queue.as_lock(), [&] {
+        return queue->stop || !queue->buffers.empty() ||
+            queue->droppedBytes != 0;
+      });
+      if (queue->buffers.empty() && queue->droppedBytes == 0) {
+        // stop was requested, and everything was written.
+        break;
+      }
+      buffers.swap(queue->buffers);
+      droppedBytes = std::exchange(queue->droppedBytes, 0);
+    }
+
+    size_t bytesWritten = 0;
+    for (const auto& buffer : buffers) {
+      auto errnum = writeToFile(buffer.data(), buffer.size());
+      if (errnum != 0) {
+        // Keep writing later buffers: e.g. when the disk is full, we want to
+        // get back to logging once some space is freed.
+        XLOG_EVERY_MS(ERR, std::chrono::seconds(60))
+            << "error writing EdenFS log output: " << folly::errnoStr(errnum);
+      }
+      bytesWritten += buffer.size();
+    }
+    if (droppedBytes != 0) {
+      // The dropped output came after what was queued, so note it after.
+      auto notice = fmt::format(
+          "edenfs_monitor: dropped {} bytes of EdenFS output because the "
+          "log file could not keep up\n",
+          droppedBytes);
+      writeToFile(notice.data(), notice.size());
+    }
+    writeQueue_.lock()->bytes -= bytesWritten;
+  }
+}
+
+int LogFile::writeToFile(const void* buffer, size_t size) {
+  std::lock_guard<std::mutex> guard{logMutex_};
+
   // Always write the full input buffer, even if it would exceed maxLogSize_.
   // This reduces the chances of us splitting the log in the middle of a message
   // (but doesn't guarantee we won't).
@@ -80,10 +161,8 @@ int LogFile::write(const void* buffer, size_t size) {
 }
 
 void LogFile::rotate() {
-  // Note: we currently do not need synchronization here since edenfs_monitor
-  // runs with a single main thread and performs all logging in this thread.
-  // If we ever changed to logging from multiple threads we would need to add
-  // synchronization here.  e.g., by putting our state in a folly::Synchronized.
+  // This is called with logMutex_ held, by the thread writing to the log:
+  // the main thread, or the write thread when writes are buffered.
   XLOG(DBG1) << "rotating log file " << path_;
 
   if (!rotationStrategy_) {
@@ -7,10 +7,12 @@
 
 #pragma once
 
+#include <atomic>
 #include <condition_variable>
 #include <deque>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <thread>
 
 #include <folly/File.h>
@@ -24,27 +26,54 @@ class LogRotationStrategy;
 
 class LogFile {
  public:
+  /**
+   * With a non-zero maxBufferedBytes, writes are queued and performed, along
+   * with the log rotations, by a background thread, so that a slow disk
+   * doesn't stall the reads of EdenFS's output.  Past maxBufferedBytes of
+   * queued data, writes are dropped.
+   */
   LogFile(
       const AbsolutePath& path,
       size_t maxSize,
-      std::unique_ptr<LogRotationStrategy> rotationStrategy);
+      std::unique_ptr<LogRotationStrategy> rotationStrategy,
+      size_t maxBufferedBytes = 0);
   ~LogFile();
 
   /**
    * Write data to the log file.
    *
-   * If the full buffer was successfully written 0 is returned.
-   * Returns an errno value on failure.
+   * If the full buffer was successfully written, or queued to be written, 0
+   * is returned.  Returns an errno value on failure, and ENOBUFS if the data
+   * was dropped because too much of it is already queued.
    */
   int write(const void* buffer, size_t size);
 
-  int fd() const {
-    return log_.fd();
+  /**
+   * Returns a new descriptor for the current log file.
+   */
+  folly::File dupFile();
+
+  /**
+   * The number of bytes dropped because too much data was queued.
+   */
+  uint64_t getDroppedBytes() const {
+    return droppedBytes_.load(std::memory_order_relaxed);
   }
 
  private:
   using RotateQueue = std::deque<std::optional<AbsolutePath>>;
 
+  struct WriteQueue {
+    std::deque<std::string> buffers;
+    // The bytes queued or being written.
+    size_t bytes{0};
+    // The bytes dropped since the last notice was written in the log.
+    size_t droppedBytes{0};
+    bool stop{false};
+  };
+
+  int writeToFile(const void* buffer, size_t size);
+  void runWriteThread();
   void rotate();
   folly::File mainThreadRotation();
   void triggerBackgroundRotation(std::optional<AbsolutePath>&& path);
@@ -56,6 +85,16 @@ class LogFile {
   size_t maxLogSize_{100 * 1024 * 1024};
   std::unique_ptr<LogRotationStrategy> const rotationStrategy_;
 
+  // Held while the log file is written or rotated, for dupFile() to get a
+  // consistent descriptor.
+  std::mutex logMutex_;
+
+  size_t const maxBufferedBytes_;
+  std::atomic<uint64_t> droppedBytes_{0};
+  std::condition_variable writeCV_;
+  folly::Synchronized<WriteQueue, std::mutex> writeQueue_;
+  std::thread writeThread_;
+
   std::condition_variable rotationCV_;
   folly::Synchronized<RotateQueue, std::mutex> rotationQueue_;
   std::thread rotationThread_;
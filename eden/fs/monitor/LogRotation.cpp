@@ -9,12 +9,18 @@
 
 #include <boost/filesystem.hpp>
 #include <fmt/format.h>
+#include <fcntl.h>
 #include <time.h>
+#include <zlib.h>
+#include <array>
 #include <chrono>
 #include <queue>
 
 #include <folly/Exception.h>
+#include <folly/File.h>
+#include <folly/FileUtil.h>
 #include <folly/Range.h>
+#include <folly/ScopeGuard.h>
 #include <folly/logging/xlog.h>
 #include <folly/portability/SysStat.h>
 
@@ -29,8 +35,11 @@ LogRotationStrategy::~LogRotationStrategy() {}
 
 TimestampLogRotation::TimestampLogRotation(
     size_t numFilesToKeep,
-    std::shared_ptr<Clock> clock)
-    : clock_(std::move(clock)), numFilesToKeep_{numFilesToKeep} {
+    std::shared_ptr<Clock> clock,
+    bool compress)
+    : clock_(std::move(clock)),
+      numFilesToKeep_{numFilesToKeep},
+      compress_{compress} {
   if (!clock_) {
     clock_ = std::make_shared<UnixClock>();
   }
@@ -151,20 +160,72 @@ std::string TimestampLogRotation::appendLogSuffix(
   }
 }
 
-void TimestampLogRotation::performRotation(const AbsolutePath&) {
-  // For now we simply prune old log files.
-  // In the future perhaps we could also compress the new log file.
+void TimestampLogRotation::performRotation(const AbsolutePath& path) {
+  if (compress_) {
+    try {
+      compressLogFile(path);
+    } catch (const std::exception& ex) {
+      // Keep the uncompressed file, and still prune old log files.
+      XLOG(ERR) << "error compressing rotated log file " << path << ": "
+                << folly::exceptionStr(ex);
+    }
+  }
   removeOldLogFiles();
 }
 
+void TimestampLogRotation::compressLogFile(const AbsolutePath& path) {
+  folly::File input(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+  // Write to a temporary name first, so that an interrupted compression
+  // doesn't leave a truncated file looking like a rotated log.
+  auto compressedPath = path.value() + kCompressedExtension.str();
+  auto tmpPath = compressedPath + ".tmp";
+  auto output = gzopen(tmpPath.c_str(), "wbe");
+  if (!output) {
+    folly::throwSystemError("failed to open ", tmpPath);
+  }
+  bool closed = false;
+  SCOPE_EXIT {
+    if (!closed) {
+      gzclose(output);
+      unlink(tmpPath.c_str());
+    }
+  };
+
+  std::array<char, 64 * 1024> buffer;
+  while (true) {
+    auto bytesRead = folly::readFull(input.fd(), buffer.data(), buffer.size());
+    folly::checkUnixError(bytesRead, "failed to read ", path);
+    if (bytesRead == 0) {
+      break;
+    }
+    auto written =
+        gzwrite(output, buffer.data(), static_cast<unsigned>(bytesRead));
+    if (written != bytesRead) {
+      throw std::runtime_error(
+          fmt::format("failed to write compressed log file {}", tmpPath));
+    }
+  }
+  closed = true;
+  if (gzclose(output) != Z_OK) {
+    unlink(tmpPath.c_str());
+    throw std::runtime_error(
+        fmt::format("failed to write compressed log file {}", tmpPath));
+  }
+
+  int rc = rename(tmpPath.c_str(), compressedPath.c_str());
+  folly::checkUnixError(rc, "rename failed");
+  rc = unlink(path.c_str());
+  folly::checkUnixError(rc, "failed to remove ", path);
+}
+
 void TimestampLogRotation::removeOldLogFiles() {
   // Clean up old log files so that we have at most numFilesToKeep_ old files.
   // Keep a priority queue of the newest numFilesToKeep_ rotated file names
-  std::priority_queue<
-      FileSuffix,
-      std::vector<FileSuffix>,
-      std::greater<FileSuffix>>
-      filesToKeep;
+  // Compressed files are kept along with their path, to remove them with
+  // their extension.
+  using File = std::pair<FileSuffix, std::string>;
+  std::priority_queue<File, std::vector<File>, std::greater<File>> filesToKeep;
 
   auto prefix = path_.value() + "-";
   fs::path dirname(folly::StringPiece{path_.dirname().value()});
@@ -177,17 +238,18 @@ void TimestampLogRotation::removeOldLogFiles() {
     }
 
     // Only match files that look like they have a valid timestamp suffix
-    auto suffix =
-        parseLogSuffix(StringPiece(entryPath).subpiece(prefix.size()));
+    auto suffixStr = StringPiece(entryPath).subpiece(prefix.size());
+    suffixStr.removeSuffix(kCompressedExtension);
+    auto suffix = parseLogSuffix(suffixStr);
     if (!suffix.has_value()) {
       continue;
     }
 
     XLOG(DBG9) << "log cleanup match: " << entry;
-    filesToKeep.emplace(suffix.value());
+    filesToKeep.emplace(suffix.value(), std::move(entryPath));
     if (filesToKeep.size() > numFilesToKeep_) {
       // delete the last file.
-      auto pathToRemove = appendLogSuffix(prefix, filesToKeep.top());
+      auto pathToRemove = filesToKeep.top().second;
       filesToKeep.pop();
       XLOG(DBG5) << "remove oldest: " << pathToRemove;
       int rc = unlink(pathToRemove.c_str());
@@ -21,7 +21,8 @@ class Clock;
  * Basic API for implementing various log rotation strategies.
  *
  * Log rotation is performed in two stages:
- * - In the main thread, we first rename the existing log file to a new name,
+ * - In the thread writing the log (the main thread, unless writes are
+ *   buffered), we first rename the existing log file to a new name,
  *   then open the log path again to create a new log file.  This should ideally
  *   be a relatively fast operation, and allow the main thread to quickly resume
  *   log forwarding.  The rest of the rotation work is then performed in a
@@ -52,8 +53,8 @@ class LogRotationStrategy {
   /**
    * Rename the main log file to an alternate name.
    *
-   * This will be called from the main thread.  This should be a relatively fast
-   * operation, so that the main thread can resume log forwarding as soon as
+   * This will be called from the thread writing the log.  This should be a
+   * relatively fast operation, so that log forwarding can resume as soon as
    * possible.
    */
   virtual AbsolutePath renameMainLogFile() = 0;
@@ -70,12 +71,16 @@ class LogRotationStrategy {
 
 /**
  * Rotate log files by appending a timestamp to each log file.
+ *
+ * With compress, rotated log files are then gzipped in the background, and
+ * get a .gz extension.
  */
 class TimestampLogRotation : public LogRotationStrategy {
  public:
   explicit TimestampLogRotation(
       size_t numFilesToKeep,
-      std::shared_ptr<Clock> clock = nullptr);
+      std::shared_ptr<Clock> clock = nullptr,
+      bool compress = false);
   ~TimestampLogRotation() override;
 
   void init(AbsolutePathPiece path) override;
@@ -86,22 +91,26 @@ class TimestampLogRotation : public LogRotationStrategy {
   FRIEND_TEST(TimestampLogRotation, parseLogSuffix);
   FRIEND_TEST(TimestampLogRotation, appendLogSuffix);
   FRIEND_TEST(TimestampLogRotation, removeOldLogFiles);
+  FRIEND_TEST(TimestampLogRotation, compressRotatedLogs);
 
   using FileSuffix = std::tuple<uint32_t, uint32_t, uint32_t>;
   // Our timestamp suffixes consist of a 8 byte date, a period, then a 6 byte
   // time-of-day.
   static constexpr size_t kTimestampLength = 8 + 1 + 6;
+  static constexpr folly::StringPiece kCompressedExtension{".gz"};
 
   static std::optional<FileSuffix> parseLogSuffix(folly::StringPiece str);
   static std::string appendLogSuffix(
       folly::StringPiece prefix,
       const FileSuffix& suffix);
   AbsolutePath computeNewPath();
+  void compressLogFile(const AbsolutePath& path);
   void removeOldLogFiles();
 
   AbsolutePath path_;
   std::shared_ptr<Clock> clock_;
   size_t numFilesToKeep_{5};
+  bool compress_{false};
 
   // In case we rotate files multiple times within the same second, we add a
   // numerical suffix to the filename.  Keep track of the last suffix we used
@@ -5,8 +5,10 @@
  * GNU General Public License version 2.
  */
 
+#include <zlib.h>
 #include <chrono>
 
+#include <folly/FileUtil.h>
 #include <folly/Range.h>
 #include <folly/logging/xlog.h>
 #include <folly/portability/GMock.h>
@@ -153,6 +155,83 @@ TEST(TimestampLogRotation, removeOldLogFiles) {
           "test.log", "test.log-20200306.010203", "test.log-20200306.101234"));
 }
 
+TEST(TimestampLogRotation, compressRotatedLogs) {
+  auto tempdir = makeTempDir();
+  auto dir = AbsolutePath(tempdir.path().native());
+  auto logPath = dir + "test.log"_pc;
+
+  auto writeFile = [&](StringPiece name, StringPiece contents) {
+    auto path = dir + PathComponent(name);
+    ASSERT_TRUE(folly::writeFile(contents, path.c_str()));
+    return path;
+  };
+
+  writeFile("test.log", "");
+  writeFile("test.log-20200305.235959", "older");
+  auto rotated = writeFile("test.log-20200306.010203", "rotated log\n");
+
+  auto rotater = make_unique<TimestampLogRotation>(
+      /*numFilesToKeep=*/1, /*clock=*/nullptr, /*compress=*/true);
+  rotater->init(logPath);
+  rotater->performRotation(rotated);
+  EXPECT_THAT(
+      listDir(tempdir.path()),
+      UnorderedElementsAre("test.log", "test.log-20200306.010203.gz"));
+
+  auto compressed = gzopen((rotated.value() + ".gz").c_str(), "rb");
+  ASSERT_NE(compressed, nullptr);
+  std::array<char, 64> buffer;
+  auto bytesRead = gzread(compressed, buffer.data(), buffer.size());
+  gzclose(compressed);
+  EXPECT_EQ("rotated log\n", string(buffer.data(), bytesRead));
+
+  // Compressed files count towards the files to keep.
+  rotated = writeFile("test.log-20200306.101234", "newer");
+  rotater->performRotation(rotated);
+  EXPECT_THAT(
+      listDir(tempdir.path()),
+      UnorderedElementsAre("test.log", "test.log-20200306.101234.gz"));
+}
+
+TEST(LogFile, bufferedWrites) {
+  auto tempdir = makeTempDir();
+  auto dir = AbsolutePath(tempdir.path().native());
+  auto logPath = dir + "test.log"_pc;
+
+  string expected;
+  {
+    LogFile log(logPath, 1024 * 1024, nullptr, /*maxBufferedBytes=*/4096);
+    // All of the messages fit in the queue, even if none was written yet.
+    for (size_t n = 0; n < 100; ++n) {
+      auto msg = folly::to<string>("msg ", n, "\n");
+      EXPECT_EQ(0, log.write(msg.data(), msg.size()));
+      expected += msg;
+    }
+  }
+  // The messages were flushed when the log was destroyed.
+
+  string contents;
+  ASSERT_TRUE(folly::readFile(logPath.c_str(), contents));
+  EXPECT_EQ(expected, contents);
+}
+
+TEST(LogFile, bufferedWritesDropWhenFull) {
+  auto tempdir = makeTempDir();
+  auto dir = AbsolutePath(tempdir.path().native());
+  auto logPath = dir + "test.log"_pc;
+
+  {
+    LogFile log(logPath, 1024 * 1024, nullptr, /*maxBufferedBytes=*/8);
+    string msg(16, 'a');
+    EXPECT_EQ(ENOBUFS, log.write(msg.data(), msg.size()));
+    EXPECT_EQ(16, log.getDroppedBytes());
+  }
+
+  string contents;
+  ASSERT_TRUE(folly::readFile(logPath.c_str(), contents));
+  EXPECT_THAT(contents, ::testing::HasSubstr("dropped 16 bytes"));
+}
+
 TEST(TimestampLogRotation, parseLogSuffix) {
   using FileSuffix = TimestampLogRotation::FileSuffix;
   EXPECT_EQ(
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/nfs/GatheredWrites.h"
+
+#include <folly/io/Cursor.h>
+#include <algorithm>
+#include <iterator>
+
+namespace facebook::eden {
+
+void GatheredWrites::add(
+    uint64_t offset,
+    std::unique_ptr<folly::IOBuf> data) {
+  auto length = data->computeChainDataLength();
+  if (length == 0) {
+    return;
+  }
+  auto end = offset + length;
+
+  // Find the extents that the write overlaps with or is adjacent to.
+  auto first = extents_.upper_bound(offset);
+  if (first != extents_.begin()) {
+    auto previous = std::prev(first);
+    if (previous->first + previous->second.length >= offset) {
+      first = previous;
+    }
+  }
+  auto last = first;
+  while (last != extents_.end() && last->first <= end) {
+    ++last;
+  }
+
+  if (first == last) {
+    extents_.emplace(offset, Buffer{std::move(data), length});
+    bufferedBytes_ += length;
+    return;
+  }
+
+  // Sequential writes, by far the most common, only extend an extent.
+  if (std::next(first) == last &&
+      first->first + first->second.length == offset) {
+    // Despite its name, this appends data at the end of the chain.
+    first->second.data->prependChain(std::move(data));
+    first->second.length += length;
+    bufferedBytes_ += length;
+    return;
+  }
+
+  auto start = std::min(offset, first->first);
+  auto lastExtent = std::prev(last);
+  auto mergedEnd =
+      std::max(end, lastExtent->first + lastExtent->second.length);
+  auto merged = folly::IOBuf::create(mergedEnd - start);
+  merged->append(mergedEnd - start);
+  for (auto it = first; it != last; ++it) {
+    folly::io::Cursor{it->second.data.get()}.pull(
+        merged->writableData() + (it->first - start), it->second.length);
+    bufferedBytes_ -= it->second.length;
+  }
+  // Copied last, as it overwrites the extents.
+  folly::io::Cursor{data.get()}.pull(
+      merged->writableData() + (offset - start), length);
+
+  extents_.erase(first, last);
+  extents_.emplace(start, Buffer{std::move(merged), mergedEnd - start});
+  bufferedBytes_ += mergedEnd - start;
+}
+
+uint64_t GatheredWrites::getEnd() const {
+  if (extents_.empty()) {
+    return 0;
+  }
+  const auto& [offset, buffer] = *extents_.rbegin();
+  return offset + buffer.length;
+}
+
+std::vector<GatheredWrites::Extent> GatheredWrites::extract() {
+  std::vector<Extent> extents;
+  extents.reserve(extents_.size());
+  for (auto& [offset, buffer] : extents_) {
+    extents.push_back(Extent{offset, std::move(buffer.data)});
+  }
+  extents_.clear();
+  bufferedBytes_ = 0;
+  return extents;
+}
+
+} // namespace facebook::eden
+
+#endif
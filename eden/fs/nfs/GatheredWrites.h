@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#ifndef _WIN32
+
+#include <folly/io/IOBuf.h>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace facebook::eden {
+
+/**
+ * The data of the UNSTABLE writes to a file that the NFS server has not
+ * applied yet, coalesced into as few extents as possible.
+ *
+ * Writes that extend an extent are chained to it without copying, while
+ * overlapping writes are merged into a new buffer, the last write winning.
+ *
+ * Not thread safe.
+ */
+class GatheredWrites {
+ public:
+  struct Extent {
+    uint64_t offset;
+    std::unique_ptr<folly::IOBuf> data;
+  };
+
+  /**
+   * Record data written at offset.
+   */
+  void add(uint64_t offset, std::unique_ptr<folly::IOBuf> data);
+
+  bool empty() const {
+    return extents_.empty();
+  }
+
+  /**
+   * Number of bytes buffered, counting overwritten bytes once.
+   */
+  uint64_t getBufferedBytes() const {
+    return bufferedBytes_;
+  }
+
+  /**
+   * The offset past the last byte written, 0 if nothing was.
+   */
+  uint64_t getEnd() const;
+
+  /**
+   * Returns the extents, ordered by offset, leaving this empty.
+   */
+  std::vector<Extent> extract();
+
+ private:
+  struct Buffer {
+    std::unique_ptr<folly::IOBuf> data;
+    uint64_t length;
+  };
+
+  /** Neither overlapping nor adjacent, by offset. */
+  std::map<uint64_t, Buffer> extents_;
+  uint64_t bufferedBytes_{0};
+};
+
+} // namespace facebook::eden
+
+#endif
@@ -216,12 +216,14 @@ void MountdServerProcessor::unregisterMount(AbsolutePathPiece path) {
 
 Mountd::Mountd(
     folly::EventBase* evb,
+    std::vector<folly::EventBase*> connectionEvbs,
     std::shared_ptr<folly::Executor> threadPool,
     const std::shared_ptr<StructuredLogger>& structuredLogger)
     : proc_(std::make_shared<MountdServerProcessor>()),
       server_(RpcServer::create(
           proc_,
           evb,
+          std::move(connectionEvbs),
           std::move(threadPool),
           structuredLogger)) {}
 
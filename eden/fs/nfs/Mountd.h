@@ -29,8 +29,9 @@ class Mountd {
   /**
    * Create a new RPC mountd program.
    *
-   * All the socket processing will be run on the EventBase passed in. This
-   * also must be called on that EventBase thread.
+   * The server socket is owned by the EventBase passed in, and this must be
+   * called on that EventBase thread. Connected clients are spread over
+   * connectionEvbs, see RpcServer::create.
    *
    * Note: at mount time, EdenFS will manually call mount.nfs with -o mountport
    * to manually specify the port on which this server is bound, so registering
@@ -38,6 +39,7 @@ class Mountd {
    */
   Mountd(
       folly::EventBase* evb,
+      std::vector<folly::EventBase*> connectionEvbs,
       std::shared_ptr<folly::Executor> threadPool,
       const std::shared_ptr<StructuredLogger>& structuredLogger);
 
@@ -12,7 +12,9 @@ namespace facebook::eden {
 
 namespace {
 
-class NfsObjectFetchContext : public FsObjectFetchContext {
+class NfsObjectFetchContext
+    : public FsObjectFetchContext,
+      public RecycledAllocation<NfsObjectFetchContext> {
  public:
   explicit NfsObjectFetchContext(std::string_view causeDetail)
       : causeDetail_{causeDetail} {}
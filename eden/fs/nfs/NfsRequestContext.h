@@ -8,10 +8,16 @@
 #pragma once
 
 #include "eden/fs/inodes/RequestContext.h"
+#include "eden/fs/utils/RecyclingAllocator.h"
 
 namespace facebook::eden {
 
-class NfsRequestContext : public RequestContext {
+/**
+ * Allocated and freed at every request, so its memory is recycled rather than
+ * returned to the allocator.
+ */
+class NfsRequestContext : public RequestContext,
+                          public RecycledAllocation<NfsRequestContext> {
  public:
   /**
    * Constructs a new NfsRequestContext. The context should live for the
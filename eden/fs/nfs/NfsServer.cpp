@@ -9,23 +9,49 @@
 
 #include "eden/fs/nfs/NfsServer.h"
 
+#include <folly/executors/IOThreadPoolExecutor.h>
 #include <folly/executors/thread_factory/NamedThreadFactory.h>
 #include "eden/fs/nfs/Nfsd3.h"
 #include "eden/fs/utils/EdenTaskQueue.h"
 
 namespace facebook::eden {
 
+namespace {
+std::vector<folly::EventBase*> getConnectionEvbs(
+    folly::EventBase* evb,
+    folly::IOThreadPoolExecutor* ioThreadPool) {
+  if (!ioThreadPool) {
+    return {evb};
+  }
+  std::vector<folly::EventBase*> evbs;
+  for (auto& ioEvb : ioThreadPool->getAllEventBases()) {
+    evbs.push_back(ioEvb.get());
+  }
+  return evbs;
+}
+} // namespace
+
 NfsServer::NfsServer(
     folly::EventBase* evb,
     uint64_t numServicingThreads,
     uint64_t maxInflightRequests,
+    uint64_t numIoThreads,
     const std::shared_ptr<StructuredLogger>& structuredLogger)
     : evb_(evb),
       threadPool_(std::make_shared<folly::CPUThreadPoolExecutor>(
           numServicingThreads,
           std::make_unique<EdenTaskQueue>(maxInflightRequests),
           std::make_unique<folly::NamedThreadFactory>("NfsThreadPool"))),
-      mountd_(evb_, threadPool_, structuredLogger) {}
+      ioThreadPool_(
+          numIoThreads == 0
+              ? nullptr
+              : std::make_unique<folly::IOThreadPoolExecutor>(
+                    numIoThreads,
+                    std::make_unique<folly::NamedThreadFactory>("NfsIo"))),
+      connectionEvbs_(getConnectionEvbs(evb_, ioThreadPool_.get())),
+      mountd_(evb_, connectionEvbs_, threadPool_, structuredLogger) {}
+
+NfsServer::~NfsServer() = default;
 
 void NfsServer::initialize(
     folly::SocketAddress addr,
@@ -49,10 +75,19 @@ NfsServer::NfsMountInfo NfsServer::registerMount(
     std::shared_ptr<Notifier> notifier,
     CaseSensitivity caseSensitive,
     uint32_t iosize,
-    size_t traceBusCapacity) {
+    uint64_t writeGatherMaxBytes,
+    bool enableNfsv41,
+    size_t traceBusCapacity,
+    FsChannelOverloadController::Config overloadConfig) {
+  evb_->dcheckIsInEventBaseThread();
+  auto* connectionEvb = connectionEvbs_[nextConnectionEvb_];
+  nextConnectionEvb_ = (nextConnectionEvb_ + 1) % connectionEvbs_.size();
+
   auto nfsd = std::make_unique<Nfsd3>(
       evb_,
+      connectionEvb,
       threadPool_,
+      path,
       std::move(dispatcher),
       straceLogger,
       std::move(processNameCache),
@@ -62,7 +97,10 @@ NfsServer::NfsMountInfo NfsServer::registerMount(
       std::move(notifier),
       caseSensitive,
       iosize,
-      traceBusCapacity);
+      writeGatherMaxBytes,
+      enableNfsv41,
+      traceBusCapacity,
+      overloadConfig);
   mountd_.registerMount(path, rootIno);
 
   return {std::move(nfsd), mountd_.getAddr()};
@@ -16,7 +16,8 @@
 
 namespace folly {
 class Executor;
-}
+class IOThreadPoolExecutor;
+} // namespace folly
 
 namespace facebook::eden {
 
@@ -33,6 +34,12 @@ class NfsServer {
    * blocking thread pool initialized with numServicingThreads and
    * maxInflightRequests.
    *
+   * When numIoThreads is non-zero, the connected sockets are read from and
+   * written to on that many dedicated EventBase threads instead of evb: each
+   * mount's nfsd connection is assigned one, round-robin, so that several
+   * busy mounts (or several mountd clients) do not all serialize on a single
+   * thread. The listening sockets always stay on evb.
+   *
    * One mountd program will be created per NfsServer, while one nfsd program
    * will be created per-mount point, this allows nfsd program to be only aware
    * of its own mount point which greatly simplifies it.
@@ -41,8 +48,11 @@ class NfsServer {
       folly::EventBase* evb,
       uint64_t numServicingThreads,
       uint64_t maxInflightRequests,
+      uint64_t numIoThreads,
       const std::shared_ptr<StructuredLogger>& structuredLogger);
 
+  ~NfsServer();
+
   /**
    * Bind the NfsServer to the passed in socket.
    *
@@ -80,7 +90,10 @@ class NfsServer {
       std::shared_ptr<Notifier> notifier,
       CaseSensitivity caseSensitive,
       uint32_t iosize,
-      size_t traceBusCapacity);
+      uint64_t writeGatherMaxBytes,
+      bool enableNfsv41,
+      size_t traceBusCapacity,
+      FsChannelOverloadController::Config overloadConfig);
 
   /**
    * Unregister the mount point matching the path.
@@ -107,6 +120,14 @@ class NfsServer {
  private:
   folly::EventBase* evb_;
   std::shared_ptr<folly::Executor> threadPool_;
+  // Only set when numIoThreads is non-zero.
+  std::unique_ptr<folly::IOThreadPoolExecutor> ioThreadPool_;
+  // The EventBases connected sockets are spread over, either all of
+  // ioThreadPool_'s or just evb_.
+  std::vector<folly::EventBase*> connectionEvbs_;
+  // Index in connectionEvbs_ of the next mount's connection. Only accessed
+  // on evb_.
+  size_t nextConnectionEvb_{0};
   Mountd mountd_;
 };
 
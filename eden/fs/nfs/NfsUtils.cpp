@@ -9,9 +9,82 @@
 
 #ifndef _WIN32
 
+#include <folly/Conv.h>
+#include <folly/futures/Future.h>
+#include <folly/io/IOBufQueue.h>
+#include <climits>
+#include <limits>
 #include <utility>
 
+#include "eden/fs/utils/StatTimes.h"
+#include "eden/fs/utils/SystemError.h"
+
+#ifndef __APPLE__
+#include <sys/sysmacros.h>
+#endif
+
 namespace facebook::eden {
+nfsstat3 exceptionToNfsError(const folly::exception_wrapper& ex) {
+  if (auto* err = ex.get_exception<std::system_error>()) {
+    if (!isErrnoError(*err)) {
+      return nfsstat3::NFS3ERR_SERVERFAULT;
+    }
+
+    switch (err->code().value()) {
+      case EPERM:
+        return nfsstat3::NFS3ERR_PERM;
+      case ENOENT:
+        return nfsstat3::NFS3ERR_NOENT;
+      case EIO:
+      case ETXTBSY:
+        return nfsstat3::NFS3ERR_IO;
+      case ENXIO:
+        return nfsstat3::NFS3ERR_NXIO;
+      case EACCES:
+        return nfsstat3::NFS3ERR_ACCES;
+      case EEXIST:
+        return nfsstat3::NFS3ERR_EXIST;
+      case EXDEV:
+        return nfsstat3::NFS3ERR_XDEV;
+      case ENODEV:
+        return nfsstat3::NFS3ERR_NODEV;
+      case ENOTDIR:
+        return nfsstat3::NFS3ERR_NOTDIR;
+      case EISDIR:
+        return nfsstat3::NFS3ERR_ISDIR;
+      case EINVAL:
+        return nfsstat3::NFS3ERR_INVAL;
+      case EFBIG:
+        return nfsstat3::NFS3ERR_FBIG;
+      case EROFS:
+        return nfsstat3::NFS3ERR_ROFS;
+      case EMLINK:
+        return nfsstat3::NFS3ERR_MLINK;
+      case ENAMETOOLONG:
+        return nfsstat3::NFS3ERR_NAMETOOLONG;
+      case ENOTEMPTY:
+        return nfsstat3::NFS3ERR_NOTEMPTY;
+      case EDQUOT:
+        return nfsstat3::NFS3ERR_DQUOT;
+      case ESTALE:
+        return nfsstat3::NFS3ERR_STALE;
+      case ETIMEDOUT:
+      case EAGAIN:
+      case ENOMEM:
+        return nfsstat3::NFS3ERR_JUKEBOX;
+      case ENOTSUP:
+        return nfsstat3::NFS3ERR_NOTSUPP;
+      case ENFILE:
+        return nfsstat3::NFS3ERR_SERVERFAULT;
+    }
+    return nfsstat3::NFS3ERR_SERVERFAULT;
+  } else if (ex.get_exception<folly::FutureTimeout>()) {
+    return nfsstat3::NFS3ERR_JUKEBOX;
+  } else {
+    return nfsstat3::NFS3ERR_SERVERFAULT;
+  }
+}
+
 uint32_t getEffectiveAccessRights(
     const struct stat& stat,
     uint32_t desiredAccess) {
@@ -50,5 +123,230 @@ uint32_t getEffectiveAccessRights(
   return desiredAccess & expandedAccessBits;
 }
 
+namespace {
+nfs_ftype4 modeToFtype4(mode_t mode) {
+  // The NFSv3 and NFSv4 file types have the same values.
+  return static_cast<nfs_ftype4>(modeToFtype3(mode));
+}
+
+nfstime4 timespecToNfsTime4(const struct timespec& time) {
+  return nfstime4{
+      time.tv_sec, folly::to_narrow(folly::to_unsigned(time.tv_nsec))};
+}
+
+template <typename T>
+void encodeFattr4(folly::io::QueueAppender& appender, const T& value) {
+  XdrTrait<T>::serialize(appender, value);
+}
+
+void addFattr4(bitmap4& bitmap, fattr4_attr attr) {
+  auto index = folly::to_underlying(attr);
+  if (bitmap.size() <= index / 32) {
+    bitmap.resize(index / 32 + 1);
+  }
+  bitmap[index / 32] |= uint32_t{1} << (index % 32);
+}
+} // namespace
+
+bool hasFattr4(const bitmap4& bitmap, fattr4_attr attr) {
+  auto index = folly::to_underlying(attr);
+  return index / 32 < bitmap.size() &&
+      (bitmap[index / 32] & (uint32_t{1} << (index % 32)));
+}
+
+const bitmap4& getSupportedFattr4() {
+  static const bitmap4 supported = [] {
+    bitmap4 bitmap;
+    for (auto attr : {
+             fattr4_attr::supported_attrs,
+             fattr4_attr::type,
+             fattr4_attr::fh_expire_type,
+             fattr4_attr::change,
+             fattr4_attr::size,
+             fattr4_attr::link_support,
+             fattr4_attr::symlink_support,
+             fattr4_attr::named_attr,
+             fattr4_attr::fsid,
+             fattr4_attr::unique_handles,
+             fattr4_attr::lease_time,
+             fattr4_attr::rdattr_error,
+             fattr4_attr::cansettime,
+             fattr4_attr::case_insensitive,
+             fattr4_attr::case_preserving,
+             fattr4_attr::chown_restricted,
+             fattr4_attr::filehandle,
+             fattr4_attr::fileid,
+             fattr4_attr::maxfilesize,
+             fattr4_attr::maxlink,
+             fattr4_attr::maxname,
+             fattr4_attr::maxread,
+             fattr4_attr::maxwrite,
+             fattr4_attr::mode,
+             fattr4_attr::numlinks,
+             fattr4_attr::owner,
+             fattr4_attr::owner_group,
+             fattr4_attr::rawdev,
+             fattr4_attr::space_used,
+             fattr4_attr::time_access,
+             fattr4_attr::time_delta,
+             fattr4_attr::time_metadata,
+             fattr4_attr::time_modify,
+             fattr4_attr::mounted_on_fileid,
+             fattr4_attr::suppattr_exclcreat,
+         }) {
+      addFattr4(bitmap, attr);
+    }
+    return bitmap;
+  }();
+  return supported;
+}
+
+fattr4 statToFattr4(
+    const struct stat& stat,
+    const bitmap4& requested,
+    const Nfs4FsProperties& properties) {
+  fattr4 attrs;
+  folly::IOBufQueue queue{folly::IOBufQueue::cacheChainLength()};
+  folly::io::QueueAppender appender{&queue, 256};
+
+  const auto& supported = getSupportedFattr4();
+  auto maxIndex =
+      static_cast<uint32_t>(std::min(requested.size(), supported.size()) * 32);
+  // Attributes are encoded by increasing attribute number.
+  for (uint32_t index = 0; index < maxIndex; ++index) {
+    auto attr = static_cast<fattr4_attr>(index);
+    if (!hasFattr4(requested, attr) || !hasFattr4(supported, attr)) {
+      continue;
+    }
+    addFattr4(attrs.attrmask, attr);
+
+    switch (attr) {
+      case fattr4_attr::supported_attrs:
+        encodeFattr4(appender, supported);
+        break;
+      case fattr4_attr::type:
+        encodeFattr4(appender, modeToFtype4(stat.st_mode));
+        break;
+      case fattr4_attr::fh_expire_type:
+        // FH4_PERSISTENT: inode numbers are never reused.
+        encodeFattr4(appender, uint32_t{0});
+        break;
+      case fattr4_attr::change: {
+        // Changes with the content and the metadata of the file alike.
+        auto ctime = stCtime(stat);
+        uint64_t change = static_cast<uint64_t>(ctime.tv_sec) * 1000000000u +
+            static_cast<uint64_t>(ctime.tv_nsec);
+        encodeFattr4(appender, change);
+        break;
+      }
+      case fattr4_attr::size:
+        encodeFattr4(appender, static_cast<uint64_t>(stat.st_size));
+        break;
+      case fattr4_attr::link_support:
+      case fattr4_attr::symlink_support:
+      case fattr4_attr::unique_handles:
+      case fattr4_attr::cansettime:
+      case fattr4_attr::case_preserving:
+      case fattr4_attr::chown_restricted:
+        encodeFattr4(appender, true);
+        break;
+      case fattr4_attr::named_attr:
+        encodeFattr4(appender, false);
+        break;
+      case fattr4_attr::fsid:
+        encodeFattr4(appender, fsid4{folly::to_unsigned(stat.st_dev), 0});
+        break;
+      case fattr4_attr::lease_time:
+        encodeFattr4(appender, properties.leaseTime);
+        break;
+      case fattr4_attr::rdattr_error:
+        encodeFattr4(appender, nfsstat4::NFS4_OK);
+        break;
+      case fattr4_attr::case_insensitive:
+        encodeFattr4(
+            appender,
+            properties.caseSensitive == CaseSensitivity::Insensitive);
+        break;
+      case fattr4_attr::filehandle:
+        encodeFattr4(appender, nfs_fh4{InodeNumber{stat.st_ino}});
+        break;
+      case fattr4_attr::fileid:
+      case fattr4_attr::mounted_on_fileid:
+        encodeFattr4(appender, static_cast<uint64_t>(stat.st_ino));
+        break;
+      case fattr4_attr::maxfilesize:
+        encodeFattr4(
+            appender, uint64_t{std::numeric_limits<int64_t>::max()});
+        break;
+      case fattr4_attr::maxlink:
+        encodeFattr4(appender, uint32_t{0});
+        break;
+      case fattr4_attr::maxname:
+        encodeFattr4(appender, uint32_t{NAME_MAX});
+        break;
+      case fattr4_attr::maxread:
+      case fattr4_attr::maxwrite:
+        encodeFattr4(appender, uint64_t{properties.iosize});
+        break;
+      case fattr4_attr::mode:
+        encodeFattr4(appender, modeToNfsMode(stat.st_mode));
+        break;
+      case fattr4_attr::numlinks:
+        encodeFattr4(appender, static_cast<uint32_t>(stat.st_nlink));
+        break;
+      case fattr4_attr::owner:
+        // Without an ID mapping domain, NFSv4 clients accept numeric ids.
+        encodeFattr4(appender, folly::to<std::string>(stat.st_uid));
+        break;
+      case fattr4_attr::owner_group:
+        encodeFattr4(appender, folly::to<std::string>(stat.st_gid));
+        break;
+      case fattr4_attr::rawdev:
+        encodeFattr4(
+            appender,
+            specdata4{
+                folly::to_narrow(major(stat.st_rdev)),
+                folly::to_narrow(minor(stat.st_rdev))});
+        break;
+      case fattr4_attr::space_used:
+        encodeFattr4(appender, static_cast<uint64_t>(stat.st_blocks) * 512u);
+        break;
+      case fattr4_attr::time_access:
+        encodeFattr4(appender, timespecToNfsTime4(stAtime(stat)));
+        break;
+      case fattr4_attr::time_delta:
+        encodeFattr4(appender, nfstime4{0, 1});
+        break;
+      case fattr4_attr::time_metadata:
+        encodeFattr4(appender, timespecToNfsTime4(stCtime(stat)));
+        break;
+      case fattr4_attr::time_modify:
+        encodeFattr4(appender, timespecToNfsTime4(stMtime(stat)));
+        break;
+      case fattr4_attr::suppattr_exclcreat:
+        // No exclusive creation, as no creation at all.
+        encodeFattr4(appender, bitmap4{});
+        break;
+    }
+  }
+
+  auto buf = queue.move();
+  if (buf) {
+    buf->coalesce();
+    attrs.attr_vals.assign(buf->data(), buf->data() + buf->length());
+  }
+  return attrs;
+}
+
+fattr4 rdattrErrorToFattr4(nfsstat4 error) {
+  fattr4 attrs;
+  addFattr4(attrs.attrmask, fattr4_attr::rdattr_error);
+  auto value = folly::to_underlying(error);
+  for (auto shift : {24, 16, 8, 0}) {
+    attrs.attr_vals.push_back(static_cast<uint8_t>(value >> shift));
+  }
+  return attrs;
+}
+
 } // namespace facebook::eden
 #endif
@@ -12,7 +12,9 @@
 #include <folly/Try.h>
 #include <folly/Utility.h>
 #include <sys/stat.h>
+#include "eden/fs/nfs/Nfsd4Rpc.h"
 #include "eden/fs/nfs/NfsdRpc.h"
+#include "eden/fs/utils/CaseSensitivity.h"
 #include "eden/fs/utils/Throw.h"
 
 namespace facebook::eden {
@@ -158,6 +160,11 @@ inline wcc_data statToWccData(
   };
 }
 
+/**
+ * Convert a exception to the appropriate NFS error value.
+ */
+nfsstat3 exceptionToNfsError(const folly::exception_wrapper& ex);
+
 inline post_op_attr statToPostOpAttr(const folly::Try<struct stat>& stat) {
   if (stat.hasException()) {
     return post_op_attr{};
@@ -192,5 +199,41 @@ uint32_t getEffectiveAccessRights(
     const struct stat& stat,
     uint32_t desiredAccess);
 
+/**
+ * Properties of the mount that some NFSv4 attributes report.
+ */
+struct Nfs4FsProperties {
+  uint32_t iosize;
+  CaseSensitivity caseSensitive;
+  uint32_t leaseTime;
+};
+
+/**
+ * Whether the bitmap has the attribute.
+ */
+bool hasFattr4(const bitmap4& bitmap, fattr4_attr attr);
+
+/**
+ * The attributes that statToFattr4 encodes.
+ */
+const bitmap4& getSupportedFattr4();
+
+/**
+ * Encode the attributes of the file that are requested. The unsupported ones
+ * are left out of the returned attrmask, as NFSv4 expects.
+ *
+ * rdattr_error is encoded as NFS4_OK: the attributes are there.
+ */
+fattr4 statToFattr4(
+    const struct stat& stat,
+    const bitmap4& requested,
+    const Nfs4FsProperties& properties);
+
+/**
+ * The attributes of a directory entry whose attributes can't be read: only
+ * rdattr_error, set to the error.
+ */
+fattr4 rdattrErrorToFattr4(nfsstat4 error);
+
 } // namespace facebook::eden
 #endif
@@ -8,23 +8,38 @@
 #ifndef _WIN32
 #include "eden/fs/nfs/Nfsd3.h"
 
+#include <algorithm>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
 
+#include <folly/Random.h>
+#include <folly/String.h>
+#include <folly/Synchronized.h>
 #include <folly/Utility.h>
+#include <folly/container/EvictingCacheMap.h>
 #include <folly/executors/SerialExecutor.h>
 #include <folly/futures/Future.h>
+#include <folly/futures/SharedPromise.h>
 
+#include "eden/fs/nfs/GatheredWrites.h"
 #include "eden/fs/nfs/NfsRequestContext.h"
 #include "eden/fs/nfs/NfsUtils.h"
+#include "eden/fs/nfs/Nfsd4.h"
 #include "eden/fs/nfs/NfsdRpc.h"
 #include "eden/fs/nfs/rpc/Server.h"
 #include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/telemetry/EdenStats.h"
+#include "eden/fs/telemetry/FsChannelLatencies.h"
 #include "eden/fs/telemetry/FsEventLogger.h"
 #include "eden/fs/telemetry/LogEvent.h"
 #include "eden/fs/telemetry/RequestMetricsScope.h"
 #include "eden/fs/telemetry/StructuredLogger.h"
+#include "eden/fs/utils/Bug.h"
 #include "eden/fs/utils/Clock.h"
 #include "eden/fs/utils/IDGen.h"
+#include "eden/fs/utils/StatTimes.h"
 #include "eden/fs/utils/StaticAssert.h"
 #include "eden/fs/utils/SystemError.h"
 #include "eden/fs/utils/Throw.h"
@@ -38,27 +53,49 @@ namespace facebook::eden {
 namespace {
 static_assert(CheckSize<NfsTraceEvent, 40>());
 
+std::vector<std::string> getNfsLatencyOpNames();
+
 class Nfsd3ServerProcessor final : public RpcServerProcessor {
  public:
   explicit Nfsd3ServerProcessor(
+      AbsolutePathPiece mountPath,
       std::unique_ptr<NfsDispatcher> dispatcher,
       const folly::Logger* straceLogger,
       const std::shared_ptr<StructuredLogger>& structuredLogger,
       CaseSensitivity caseSensitive,
       uint32_t iosize,
+      uint64_t writeGatherMaxBytes,
+      bool enableNfsv41,
       folly::Promise<Nfsd3::StopData>& stopPromise,
       ProcessAccessLog& processAccessLog,
       std::atomic<size_t>& traceDetailedArguments,
-      std::shared_ptr<TraceBus<NfsTraceEvent>>& traceBus)
+      std::shared_ptr<TraceBus<NfsTraceEvent>>& traceBus,
+      FsChannelOverloadController::Config overloadConfig)
       : dispatcher_(std::move(dispatcher)),
         straceLogger_(straceLogger),
         structuredLogger_(structuredLogger),
         caseSensitive_(caseSensitive),
         iosize_(iosize),
+        writeGatherMaxBytes_{writeGatherMaxBytes},
+        writeVerf_{folly::Random::rand64()},
         stopPromise_{stopPromise},
         processAccessLog_{processAccessLog},
         traceDetailedArguments_(traceDetailedArguments),
-        traceBus_(traceBus) {}
+        traceBus_(traceBus),
+        latencies_{std::make_shared<FsChannelLatencies>(
+            "nfs",
+            mountPath.asString(),
+            getNfsLatencyOpNames())},
+        overloadController_{
+            std::make_shared<FsChannelOverloadController>(overloadConfig)} {
+    if (auto* stats = dispatcher_->getStats()) {
+      stats->registerLatencies(latencies_);
+    }
+    if (enableNfsv41) {
+      nfsd4_ =
+          std::make_unique<Nfsd4>(dispatcher_.get(), caseSensitive, iosize);
+    }
+  }
 
   Nfsd3ServerProcessor(const Nfsd3ServerProcessor&) = delete;
   Nfsd3ServerProcessor(Nfsd3ServerProcessor&&) = delete;
@@ -76,6 +113,32 @@ class Nfsd3ServerProcessor final : public RpcServerProcessor {
   void onShutdown(RpcStopData stopData) override;
   void clientConnected() override;
 
+  /**
+   * Drop every cached READDIRPLUS listing. Called around every procedure
+   * that may modify the file system, including the SETATTR that
+   * Nfsd3::invalidate triggers.
+   */
+  void invalidateReaddirplusCache();
+
+  /**
+   * Replies NFS3ERR_JUKEBOX to a bulk request shed by overloadController_,
+   * which makes the client retry it a little later.
+   */
+  void serializeShedReply(
+      folly::io::QueueAppender& ser,
+      uint32_t xid,
+      uint32_t procNumber);
+
+  /**
+   * Hand an NFSv4 request to nfsd4_, once the gathered writes it could
+   * observe are applied.
+   */
+  ImmediateFuture<folly::Unit> dispatchNfsv4(
+      folly::io::Cursor deser,
+      folly::io::QueueAppender ser,
+      uint32_t xid,
+      uint32_t procNumber);
+
   ImmediateFuture<folly::Unit> null(
       folly::io::Cursor deser,
       folly::io::QueueAppender ser,
@@ -166,6 +229,73 @@ class Nfsd3ServerProcessor final : public RpcServerProcessor {
       NfsRequestContext& context);
 
  private:
+  struct GatheredFile {
+    GatheredWrites writes;
+    // The attributes of the file with the gathered writes applied, derived
+    // from those of the inode before the first of them. WRITE and GETATTR
+    // are answered from them until the writes are applied.
+    struct stat stat;
+  };
+
+  struct WriteGatherState {
+    std::unordered_map<InodeNumber, GatheredFile> files;
+    // Fulfilled once the writes being applied to a file are.
+    std::unordered_map<
+        InodeNumber,
+        std::shared_ptr<folly::SharedPromise<folly::Unit>>>
+        applying;
+  };
+
+  /**
+   * Buffer an UNSTABLE write in writeGather_ and reply to it, only applying
+   * it once the file has more than writeGatherMaxBytes_ buffered.
+   */
+  ImmediateFuture<folly::Unit> gatherWrite(
+      InodeNumber ino,
+      uint64_t offset,
+      std::unique_ptr<folly::IOBuf> data,
+      folly::io::QueueAppender ser,
+      NfsRequestContext& context);
+
+  /**
+   * Apply a write to the inode right away and reply to it.
+   */
+  ImmediateFuture<folly::Unit> applyWrite(
+      InodeNumber ino,
+      uint64_t offset,
+      std::unique_ptr<folly::IOBuf> data,
+      folly::io::QueueAppender ser,
+      NfsRequestContext& context);
+
+  /**
+   * Apply the gathered writes of a file, after those already being applied.
+   *
+   * Never fails: when a write can't be applied, writeVerf_ changes, which
+   * makes the client send again all the writes it did not see committed.
+   */
+  ImmediateFuture<folly::Unit> applyGatheredWrites(
+      InodeNumber ino,
+      const ObjectFetchContextPtr& context);
+
+  /**
+   * Apply the gathered writes of every file.
+   */
+  ImmediateFuture<folly::Unit> applyAllGatheredWrites(
+      const ObjectFetchContextPtr& context);
+
+  /**
+   * Apply the gathered writes that the procedure could observe.
+   */
+  ImmediateFuture<folly::Unit> applyGatheredWritesBefore(
+      uint32_t procNumber,
+      folly::io::Cursor deser,
+      const ObjectFetchContextPtr& context);
+
+  /**
+   * The attributes of a file with gathered writes, none if it has none.
+   */
+  std::optional<struct stat> getGatheredStat(InodeNumber ino);
+
   std::unique_ptr<NfsDispatcher> dispatcher_;
   // Logger that is used to observe NFS procedure calls in the EdenFS daemon.
   // All events are published here when we are in stace mode. This is a local
@@ -175,6 +305,13 @@ class Nfsd3ServerProcessor final : public RpcServerProcessor {
   const std::shared_ptr<StructuredLogger> structuredLogger_;
   CaseSensitivity caseSensitive_;
   uint32_t iosize_;
+  // Maximum number of bytes of UNSTABLE writes gathered per file, 0 to apply
+  // every write as it comes.
+  const uint64_t writeGatherMaxBytes_;
+  // Returned with every WRITE and COMMIT. Random so that a client notices
+  // that EdenFS restarted, and changed when gathered writes are lost.
+  std::atomic<writeverf3> writeVerf_;
+  folly::Synchronized<WriteGatherState, std::mutex> writeGather_;
   // This promise is owned by the nfs3d. The nfs3d owns an RPC server that owns
   // this server processor. This promise should only be used during the
   // lifetime of  nfs3d. The way we currently enforce this is by waiting for
@@ -184,72 +321,42 @@ class Nfsd3ServerProcessor final : public RpcServerProcessor {
   std::atomic_int32_t numberOfClients_;
   std::atomic<size_t>& traceDetailedArguments_;
   std::shared_ptr<TraceBus<NfsTraceEvent>>& traceBus_;
+  // Latency histograms of the procedures, indexed by procedure number.
+  std::shared_ptr<FsChannelLatencies> latencies_;
+  // NFS requests don't carry the pid of the process that made them: they are
+  // all admitted as coming from pid 0.
+  std::shared_ptr<FsChannelOverloadController> overloadController_;
+  // Serves NFSv4.1 on the same connection, when enabled.
+  std::unique_ptr<Nfsd4> nfsd4_;
+
+  /**
+   * Only bounds the number of directories listed concurrently, a listing of
+   * a large directory can reach several MB.
+   */
+  static constexpr size_t kMaxCachedReaddirplusListings = 8;
+
+  /**
+   * Complete READDIRPLUS listings, with attributes, of the directories that
+   * are being paginated through. A listing is built in full for the request
+   * with a cookie of 0, continuation requests are then served from it, and it
+   * is dropped once its last page was returned. The listings are keyed by
+   * directory only, as the cookie verifier never changes.
+   */
+  struct ReaddirplusCache {
+    using Listing = std::shared_ptr<const std::vector<entryplus3>>;
+
+    ReaddirplusCache() : listings{kMaxCachedReaddirplusListings} {}
+
+    folly::EvictingCacheMap<InodeNumber, Listing> listings;
+    /**
+     * Incremented on every invalidation, so that a listing built while the
+     * file system was being modified is not cached.
+     */
+    uint64_t generation{0};
+  };
+  folly::Synchronized<ReaddirplusCache> readdirplusCache_;
 };
 
-/**
- * Convert a exception to the appropriate NFS error value.
- */
-nfsstat3 exceptionToNfsError(const folly::exception_wrapper& ex) {
-  if (auto* err = ex.get_exception<std::system_error>()) {
-    if (!isErrnoError(*err)) {
-      return nfsstat3::NFS3ERR_SERVERFAULT;
-    }
-
-    switch (err->code().value()) {
-      case EPERM:
-        return nfsstat3::NFS3ERR_PERM;
-      case ENOENT:
-        return nfsstat3::NFS3ERR_NOENT;
-      case EIO:
-      case ETXTBSY:
-        return nfsstat3::NFS3ERR_IO;
-      case ENXIO:
-        return nfsstat3::NFS3ERR_NXIO;
-      case EACCES:
-        return nfsstat3::NFS3ERR_ACCES;
-      case EEXIST:
-        return nfsstat3::NFS3ERR_EXIST;
-      case EXDEV:
-        return nfsstat3::NFS3ERR_XDEV;
-      case ENODEV:
-        return nfsstat3::NFS3ERR_NODEV;
-      case ENOTDIR:
-        return nfsstat3::NFS3ERR_NOTDIR;
-      case EISDIR:
-        return nfsstat3::NFS3ERR_ISDIR;
-      case EINVAL:
-        return nfsstat3::NFS3ERR_INVAL;
-      case EFBIG:
-        return nfsstat3::NFS3ERR_FBIG;
-      case EROFS:
-        return nfsstat3::NFS3ERR_ROFS;
-      case EMLINK:
-        return nfsstat3::NFS3ERR_MLINK;
-      case ENAMETOOLONG:
-        return nfsstat3::NFS3ERR_NAMETOOLONG;
-      case ENOTEMPTY:
-        return nfsstat3::NFS3ERR_NOTEMPTY;
-      case EDQUOT:
-        return nfsstat3::NFS3ERR_DQUOT;
-      case ESTALE:
-        return nfsstat3::NFS3ERR_STALE;
-      case ETIMEDOUT:
-      case EAGAIN:
-      case ENOMEM:
-        return nfsstat3::NFS3ERR_JUKEBOX;
-      case ENOTSUP:
-        return nfsstat3::NFS3ERR_NOTSUPP;
-      case ENFILE:
-        return nfsstat3::NFS3ERR_SERVERFAULT;
-    }
-    return nfsstat3::NFS3ERR_SERVERFAULT;
-  } else if (ex.get_exception<folly::FutureTimeout>()) {
-    return nfsstat3::NFS3ERR_JUKEBOX;
-  } else {
-    return nfsstat3::NFS3ERR_SERVERFAULT;
-  }
-}
-
 ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::null(
     folly::io::Cursor /*deser*/,
     folly::io::QueueAppender ser,
@@ -282,6 +389,12 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::getattr(
 
   auto args = XdrTrait<GETATTR3args>::deserialize(deser);
 
+  if (auto stat = getGatheredStat(args.object.ino)) {
+    GETATTR3res res{{{nfsstat3::NFS3_OK, GETATTR3resok{statToFattr3(*stat)}}}};
+    XdrTrait<GETATTR3res>::serialize(ser, res);
+    return folly::unit;
+  }
+
   return dispatcher_->getattr(args.object.ino, context.getObjectFetchContext())
       .thenTry(
           [ser = std::move(ser)](const folly::Try<struct stat>& try_) mutable {
@@ -592,16 +705,6 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::read(
       });
 }
 
-/**
- * Generate a unique per-EdenFS instance write cookie.
- *
- * TODO(xavierd): Note that for now this will always be 0 as this is to handle
- * the case where the server restart while the client isn't aware.
- */
-writeverf3 makeWriteVerf() {
-  return 0;
-}
-
 ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::write(
     folly::io::Cursor deser,
     folly::io::QueueAppender ser,
@@ -615,13 +718,37 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::write(
   queue.append(std::move(args.data));
   auto data = queue.split(args.count);
 
+  if (args.stable == stable_how::UNSTABLE && writeGatherMaxBytes_ > 0) {
+    return gatherWrite(
+        args.file.ino, args.offset, std::move(data), std::move(ser), context);
+  }
+
+  // A stable write must land after the unstable ones that preceded it.
+  return applyGatheredWrites(args.file.ino, context.getObjectFetchContext())
+      .thenValue([this,
+                  ino = args.file.ino,
+                  offset = args.offset,
+                  data = std::move(data),
+                  ser = std::move(ser),
+                  &context](folly::Unit) mutable {
+        return applyWrite(
+            ino, offset, std::move(data), std::move(ser), context);
+      });
+}
+
+ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::applyWrite(
+    InodeNumber ino,
+    uint64_t offset,
+    std::unique_ptr<folly::IOBuf> data,
+    folly::io::QueueAppender ser,
+    NfsRequestContext& context) {
   return dispatcher_
       ->write(
-          args.file.ino,
+          ino,
           std::move(data),
-          args.offset,
+          folly::to_signed(offset),
           context.getObjectFetchContext())
-      .thenTry([ser = std::move(ser)](
+      .thenTry([this, ser = std::move(ser)](
                    folly::Try<NfsDispatcher::WriteRes> writeTry) mutable {
         if (writeTry.hasException()) {
           WRITE3res res{
@@ -648,15 +775,247 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::write(
                     // stable_how::UNSTABLE. For testing purpose, this is
                     // OK.
                     /*committed*/ stable_how::FILE_SYNC,
-                    /*verf*/ makeWriteVerf(),
+                    /*verf*/ writeVerf_.load(),
+                }}}};
+          XdrTrait<WRITE3res>::serialize(ser, res);
+        }
+
+        return folly::unit;
+      });
+}
+
+ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::gatherWrite(
+    InodeNumber ino,
+    uint64_t offset,
+    std::unique_ptr<folly::IOBuf> data,
+    folly::io::QueueAppender ser,
+    NfsRequestContext& context) {
+  auto length = data->computeChainDataLength();
+  // The attributes before and after the write, and whether the file has
+  // enough buffered to be applied.
+  struct Gathered {
+    struct stat preStat;
+    struct stat postStat;
+    bool full;
+  };
+  // Gather the write if the file has its attributes cached already, or
+  // baseStat is given to cache.
+  auto gather = [this, ino, offset, length](
+                    std::unique_ptr<folly::IOBuf>& data,
+                    const struct stat* baseStat) -> std::optional<Gathered> {
+    auto state = writeGather_.lock();
+    auto it = state->files.find(ino);
+    if (it == state->files.end()) {
+      if (!baseStat) {
+        return std::nullopt;
+      }
+      it = state->files.emplace(ino, GatheredFile{{}, *baseStat}).first;
+    }
+    auto& file = it->second;
+    auto preStat = file.stat;
+    file.writes.add(offset, std::move(data));
+    auto now = dispatcher_->getClock().getRealtime();
+    file.stat.st_size = std::max<off_t>(
+        file.stat.st_size, folly::to_signed(offset + length));
+    stMtime(file.stat, now);
+    stCtime(file.stat, now);
+    return Gathered{
+        preStat,
+        file.stat,
+        file.writes.getBufferedBytes() >= writeGatherMaxBytes_};
+  };
+  auto reply = [this, ino, length, &context](
+                   folly::io::QueueAppender ser,
+                   Gathered gathered) -> ImmediateFuture<folly::Unit> {
+    auto applied = gathered.full
+        ? applyGatheredWrites(ino, context.getObjectFetchContext())
+        : ImmediateFuture<folly::Unit>{folly::unit};
+    return std::move(applied).thenValue(
+        [this, ser = std::move(ser), length, gathered](folly::Unit) mutable {
+          WRITE3res res{
+              {{nfsstat3::NFS3_OK,
+                WRITE3resok{
+                    /*file_wcc*/ statToWccData(
+                        gathered.preStat, gathered.postStat),
+                    /*count*/ folly::to_narrow(length),
+                    /*committed*/ stable_how::UNSTABLE,
+                    /*verf*/ writeVerf_.load(),
                 }}}};
           XdrTrait<WRITE3res>::serialize(ser, res);
+          return folly::unit;
+        });
+  };
+
+  if (auto gathered = gather(data, nullptr)) {
+    return reply(std::move(ser), *gathered);
+  }
+
+  // The first write to the file since its writes were last applied: wait
+  // for these to be, so that the attributes of the inode include them.
+  std::optional<folly::SemiFuture<folly::Unit>> applying;
+  {
+    auto state = writeGather_.lock();
+    auto it = state->applying.find(ino);
+    if (it != state->applying.end()) {
+      applying = it->second->getSemiFuture();
+    }
+  }
+  auto ready = applying ? ImmediateFuture<folly::Unit>{std::move(*applying)}
+                        : ImmediateFuture<folly::Unit>{folly::unit};
+  return std::move(ready)
+      .thenValue([this, ino, &context](folly::Unit) {
+        return dispatcher_->getattr(ino, context.getObjectFetchContext());
+      })
+      .thenTry([this,
+                ino,
+                offset,
+                data = std::move(data),
+                ser = std::move(ser),
+                gather = std::move(gather),
+                reply = std::move(reply),
+                &context](folly::Try<struct stat> tryStat) mutable
+               -> ImmediateFuture<folly::Unit> {
+        // Let the write report why the inode can't be written to.
+        if (tryStat.hasException() || !S_ISREG(tryStat->st_mode)) {
+          return applyWrite(
+              ino, offset, std::move(data), std::move(ser), context);
         }
+        return reply(std::move(ser), *gather(data, &tryStat.value()));
+      });
+}
 
+ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::applyGatheredWrites(
+    InodeNumber ino,
+    const ObjectFetchContextPtr& context) {
+  std::vector<GatheredWrites::Extent> extents;
+  std::shared_ptr<folly::SharedPromise<folly::Unit>> previous;
+  auto applied = std::make_shared<folly::SharedPromise<folly::Unit>>();
+  {
+    auto state = writeGather_.lock();
+    auto file = state->files.find(ino);
+    auto applying = state->applying.find(ino);
+    if (file == state->files.end()) {
+      if (applying == state->applying.end()) {
         return folly::unit;
+      }
+      return ImmediateFuture<folly::Unit>{applying->second->getSemiFuture()};
+    }
+    extents = file->second.writes.extract();
+    state->files.erase(file);
+    if (applying != state->applying.end()) {
+      previous = std::exchange(applying->second, applied);
+    } else {
+      state->applying.emplace(ino, applied);
+    }
+  }
+
+  auto ready = previous
+      ? ImmediateFuture<folly::Unit>{previous->getSemiFuture()}
+      : ImmediateFuture<folly::Unit>{folly::unit};
+  return std::move(ready)
+      .thenValue([this,
+                  ino,
+                  extents = std::move(extents),
+                  context = context.copy()](folly::Unit) mutable {
+        std::vector<ImmediateFuture<NfsDispatcher::WriteRes>> writes;
+        writes.reserve(extents.size());
+        for (auto& extent : extents) {
+          writes.push_back(dispatcher_->write(
+              ino,
+              std::move(extent.data),
+              folly::to_signed(extent.offset),
+              context));
+        }
+        return collectAll(std::move(writes));
+      })
+      .thenValue([this, ino](
+                     std::vector<folly::Try<NfsDispatcher::WriteRes>> results) {
+        for (auto& result : results) {
+          if (result.hasException()) {
+            XLOG(WARN) << "Failed to apply the gathered writes of inode "
+                       << ino << ": " << result.exception().what();
+            writeVerf_.fetch_add(1);
+            break;
+          }
+        }
+      })
+      .ensure([this, ino, applied] {
+        applied->setValue();
+        auto state = writeGather_.lock();
+        auto it = state->applying.find(ino);
+        if (it != state->applying.end() && it->second == applied) {
+          state->applying.erase(it);
+        }
       });
 }
 
+ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::applyAllGatheredWrites(
+    const ObjectFetchContextPtr& context) {
+  std::vector<InodeNumber> inos;
+  {
+    auto state = writeGather_.lock();
+    for (const auto& [ino, file] : state->files) {
+      inos.push_back(ino);
+    }
+    for (const auto& [ino, promise] : state->applying) {
+      if (!state->files.count(ino)) {
+        inos.push_back(ino);
+      }
+    }
+  }
+  if (inos.empty()) {
+    return folly::unit;
+  }
+
+  std::vector<ImmediateFuture<folly::Unit>> applied;
+  applied.reserve(inos.size());
+  for (auto ino : inos) {
+    applied.push_back(applyGatheredWrites(ino, context));
+  }
+  return collectAllSafe(std::move(applied)).unit();
+}
+
+ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::applyGatheredWritesBefore(
+    uint32_t procNumber,
+    folly::io::Cursor deser,
+    const ObjectFetchContextPtr& context) {
+  switch (static_cast<nfsv3Procs>(procNumber)) {
+    case nfsv3Procs::read:
+    case nfsv3Procs::setattr:
+      // The arguments of every procedure start with the file handle.
+      return applyGatheredWrites(
+          XdrTrait<nfs_fh3>::deserialize(deser).ino, context);
+    case nfsv3Procs::lookup:
+    case nfsv3Procs::create:
+    case nfsv3Procs::mkdir:
+    case nfsv3Procs::symlink:
+    case nfsv3Procs::mknod:
+    case nfsv3Procs::remove:
+    case nfsv3Procs::rmdir:
+    case nfsv3Procs::rename:
+    case nfsv3Procs::link:
+    case nfsv3Procs::readdir:
+    case nfsv3Procs::readdirplus:
+      // These return, or change, the attributes of directory entries, which
+      // may be files with gathered writes.
+      return applyAllGatheredWrites(context);
+    default:
+      // GETATTR, WRITE and COMMIT handle the gathered writes themselves, and
+      // the others don't depend on the data of files.
+      return folly::unit;
+  }
+}
+
+std::optional<struct stat> Nfsd3ServerProcessor::getGatheredStat(
+    InodeNumber ino) {
+  auto state = writeGather_.lock();
+  auto it = state->files.find(ino);
+  if (it == state->files.end()) {
+    return std::nullopt;
+  }
+  return it->second.stat;
+}
+
 /**
  * Test if the exception was raised due to a EEXIST condition.
  */
@@ -1130,6 +1489,32 @@ uint64_t getReaddirCookieverf() {
   return 0;
 }
 
+/**
+ * Copy the entries of a complete READDIRPLUS listing that follow cookie and
+ * fit in dircount bytes.
+ */
+NfsDispatcher::ReaddirRes pageReaddirplusListing(
+    const std::vector<entryplus3>& listing,
+    uint64_t cookie,
+    uint32_t dircount) {
+  NfsDirList list{dircount, nfsv3Procs::readdirplus};
+  // Cookies are increasing, see TreeInode::readdirImpl.
+  auto it = std::upper_bound(
+      listing.begin(),
+      listing.end(),
+      cookie,
+      [](uint64_t cookie, const entryplus3& entry) {
+        return cookie < entry.cookie;
+      });
+  for (; it != listing.end(); ++it) {
+    if (!list.add(it->name, InodeNumber{it->fileid}, it->cookie)) {
+      break;
+    }
+    list.getListRef().back().name_attributes = it->name_attributes;
+  }
+  return NfsDispatcher::ReaddirRes{std::move(list), it == listing.end()};
+}
+
 ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::readdir(
     folly::io::Cursor deser,
     folly::io::QueueAppender ser,
@@ -1195,14 +1580,54 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::readdirplus(
   }
 
   // TODO(T107744453): Should probably acount for args.maxcount somewhere
-  return dispatcher_
-      ->readdirplus(
-          args.dir.ino,
-          args.cookie,
-          args.dircount,
-          context.getObjectFetchContext())
-      .thenTry([this, ino = args.dir.ino, ser = std::move(ser), &context](
-                   folly::Try<NfsDispatcher::ReaddirRes> try_) mutable {
+  auto listing = [&]() -> ImmediateFuture<NfsDispatcher::ReaddirRes> {
+    auto ino = args.dir.ino;
+    auto dircount = args.dircount;
+    if (args.cookie == 0) {
+      // Listing the whole directory at once stats every child concurrently,
+      // which lets the backing store batch their metadata fetches, and the
+      // following pages come from the cache instead of from
+      // TreeInode::readdirImpl, which re-sorts the directory every time.
+      auto generation = readdirplusCache_.rlock()->generation;
+      return dispatcher_
+          ->readdirplus(
+              ino,
+              0,
+              std::numeric_limits<uint32_t>::max(),
+              context.getObjectFetchContext())
+          .thenValue([this, ino, dircount, generation](
+                         NfsDispatcher::ReaddirRes&& full) {
+            auto entries = std::make_shared<const std::vector<entryplus3>>(
+                std::move(full.entries.getListRef()));
+            auto page = pageReaddirplusListing(*entries, 0, dircount);
+            if (!page.isEof) {
+              auto cache = readdirplusCache_.wlock();
+              if (cache->generation == generation) {
+                cache->listings.set(ino, std::move(entries));
+              }
+            }
+            return page;
+          });
+    }
+
+    {
+      auto cache = readdirplusCache_.wlock();
+      auto it = cache->listings.find(ino);
+      if (it != cache->listings.end()) {
+        auto page = pageReaddirplusListing(*it->second, args.cookie, dircount);
+        if (page.isEof) {
+          cache->listings.erase(ino);
+        }
+        return page;
+      }
+    }
+    return dispatcher_->readdirplus(
+        ino, args.cookie, dircount, context.getObjectFetchContext());
+  }();
+
+  return std::move(listing).thenTry(
+      [this, ino = args.dir.ino, ser = std::move(ser), &context](
+          folly::Try<NfsDispatcher::ReaddirRes> try_) mutable {
         return dispatcher_->getattr(ino, context.getObjectFetchContext())
             .thenTry([ser = std::move(ser), try_ = std::move(try_)](
                          const folly::Try<struct stat>& tryStat) mutable {
@@ -1338,11 +1763,38 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::pathconf(
 }
 
 ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::commit(
-    folly::io::Cursor /*deser*/,
+    folly::io::Cursor deser,
     folly::io::QueueAppender ser,
     NfsRequestContext& context) {
-  serializeReply(ser, accept_stat::PROC_UNAVAIL, context.getXid());
-  return folly::unit;
+  serializeReply(ser, accept_stat::SUCCESS, context.getXid());
+  auto args = XdrTrait<COMMIT3args>::deserialize(deser);
+
+  // The requested range is ignored: the gathered writes of a file are all
+  // applied together.
+  return applyGatheredWrites(args.file.ino, context.getObjectFetchContext())
+      .thenValue([this, ino = args.file.ino, &context](folly::Unit) {
+        return dispatcher_->getattr(ino, context.getObjectFetchContext());
+      })
+      .thenTry([this, ser = std::move(ser)](
+                   const folly::Try<struct stat>& tryStat) mutable {
+        if (tryStat.hasException()) {
+          COMMIT3res res{
+              {{exceptionToNfsError(tryStat.exception()), COMMIT3resfail{}}}};
+          XdrTrait<COMMIT3res>::serialize(ser, res);
+        } else {
+          COMMIT3res res{
+              {{nfsstat3::NFS3_OK,
+                COMMIT3resok{
+                    /*file_wcc*/ wcc_data{
+                        /*before*/ pre_op_attr{},
+                        /*after*/ statToPostOpAttr(tryStat),
+                    },
+                    /*verf*/ writeVerf_.load(),
+                }}}};
+          XdrTrait<COMMIT3res>::serialize(ser, res);
+        }
+        return folly::unit;
+      });
 }
 
 NfsArgsDetails formatNull(folly::io::Cursor /*deser*/) {
@@ -1619,9 +2071,15 @@ NfsArgsDetails formatPathconf(folly::io::Cursor deser) {
   return {fmt::format(FMT_STRING("ino={}"), args.object.ino), args.object.ino};
 }
 
-NfsArgsDetails formatCommit(folly::io::Cursor /*deser*/) {
-  // TODO(xavierd): Fill this in.
-  return {""};
+NfsArgsDetails formatCommit(folly::io::Cursor deser) {
+  auto args = XdrTrait<COMMIT3args>::deserialize(deser);
+  return {
+      fmt::format(
+          FMT_STRING("ino={}, offset={}, count={}"),
+          args.file.ino,
+          args.offset,
+          args.count),
+      args.file.ino};
 }
 
 using Handler = ImmediateFuture<folly::Unit> (Nfsd3ServerProcessor::*)(
@@ -1828,13 +2286,69 @@ struct LiveRequest {
   uint32_t procNumber_;
 };
 
+/**
+ * The lowercase names of the procedures that have a stat, indexed by
+ * procedure number, for FsChannelLatencies.
+ */
+std::vector<std::string> getNfsLatencyOpNames() {
+  std::vector<std::string> names(kNfs3dHandlers.size());
+  for (size_t procNumber = 0; procNumber < kNfs3dHandlers.size();
+       ++procNumber) {
+    const auto& handlerEntry = kNfs3dHandlers[procNumber];
+    if (handlerEntry.stat) {
+      names[procNumber] = folly::toLowerAscii(handlerEntry.name);
+    }
+  }
+  return names;
+}
+
 SamplingGroup nfsProcSamplingGroup(uint32_t procNumber) {
   XDCHECK(procNumber < kNfs3dHandlers.size())
       << "got invalid NFS procedure: " << procNumber;
   return kNfs3dHandlers[procNumber].samplingGroup;
 }
+
+FsChannelOverloadController::RequestKind nfsOverloadRequestKind(
+    uint32_t procNumber) {
+  switch (static_cast<nfsv3Procs>(procNumber)) {
+    case nfsv3Procs::read:
+    case nfsv3Procs::readdir:
+    case nfsv3Procs::readdirplus:
+      return FsChannelOverloadController::RequestKind::Bulk;
+    default:
+      return FsChannelOverloadController::RequestKind::Metadata;
+  }
+}
 } // namespace
 
+ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::dispatchNfsv4(
+    folly::io::Cursor deser,
+    folly::io::QueueAppender ser,
+    uint32_t xid,
+    uint32_t procNumber) {
+  FB_LOGF(*straceLogger_, DBG7, "NFSv4 procedure {}", procNumber);
+
+  std::shared_ptr<RequestMetricsScope::RequestWatchList> nullRequestWatch;
+  auto context =
+      std::make_unique<NfsRequestContext>(xid, "COMPOUND", processAccessLog_);
+  context->startRequest(
+      dispatcher_->getStats(), &NfsStats::nfsCompound, nullRequestWatch);
+
+  // The operations of a COMPOUND aren't known upfront, apply all the gathered
+  // writes like an NFSv3 READ would.
+  return applyAllGatheredWrites(context->getObjectFetchContext())
+      .thenValue([this,
+                  deser = std::move(deser),
+                  ser = std::move(ser),
+                  contextRef = context.get(),
+                  xid,
+                  procNumber](folly::Unit) mutable {
+        return nfsd4_->dispatchRpc(
+            std::move(deser), std::move(ser), xid, procNumber, *contextRef);
+      })
+      .ensure([context = std::move(context)]() {});
+}
+
 ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::dispatchRpc(
     folly::io::Cursor deser,
     folly::io::QueueAppender ser,
@@ -1847,10 +2361,17 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::dispatchRpc(
     return folly::unit;
   }
 
+  if (progVersion == kNfsd4ProgVersion && nfsd4_) {
+    return dispatchNfsv4(std::move(deser), std::move(ser), xid, procNumber);
+  }
+
   if (progVersion != kNfsd3ProgVersion) {
     serializeReply(ser, accept_stat::PROG_MISMATCH, xid);
     XdrTrait<mismatch_info>::serialize(
-        ser, mismatch_info{kNfsd3ProgVersion, kNfsd3ProgVersion});
+        ser,
+        mismatch_info{
+            kNfsd3ProgVersion,
+            nfsd4_ ? kNfsd4ProgVersion : kNfsd3ProgVersion});
     return folly::unit;
   }
 
@@ -1871,21 +2392,73 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::dispatchRpc(
   auto liveRequest = LiveRequest{
       traceBus_, traceDetailedArguments_, handlerEntry, deser, xid, procNumber};
 
+  // A cached listing must not survive a modification. Invalidate before the
+  // procedure runs, so that no listing can be cached meanwhile, and once it
+  // completed, to drop a listing that raced with it.
+  bool modifies = handlerEntry.accessType == AccessType::FsChannelWrite;
+  if (modifies) {
+    invalidateReaddirplusCache();
+  }
+
   // TODO: Add requestMetrics for NFS.
-  std::shared_ptr<RequestMetricsScope::LockedRequestWatchList> nullRequestWatch;
+  std::shared_ptr<RequestMetricsScope::RequestWatchList> nullRequestWatch;
   auto context = std::make_unique<NfsRequestContext>(
       xid, handlerEntry.name, processAccessLog_);
   context->startRequest(
       dispatcher_->getStats(), handlerEntry.stat, nullRequestWatch);
+  context->setLatencies(latencies_, procNumber);
+
+  auto* stats = dispatcher_->getStats();
+  auto admission =
+      overloadController_->admit(0, nfsOverloadRequestKind(procNumber));
+  bool deferred = !admission.isReady();
+  if (deferred && stats) {
+    stats->increment(&NfsStats::requestsDeferred);
+  }
 
   // The data that contextRef reference to is alive for the duration of the
   // handler function and is deleted when context unique_ptr goes out of the
   // scope at the `ensure` lambda.
-  return makeImmediateFutureWith([&] {
-           return (this->*handlerEntry.handler)(
-               std::move(deser), std::move(ser), *context);
-         })
-      .thenTry([&handlerEntry](folly::Try<folly::Unit>&& res) {
+  return std::move(admission)
+      .thenTry([this,
+                &handlerEntry,
+                deser = std::move(deser),
+                ser = std::move(ser),
+                contextRef = context.get(),
+                stats,
+                deferred,
+                xid,
+                procNumber](folly::Try<FsChannelOverloadController::Slot>&&
+                                slot) mutable -> ImmediateFuture<folly::Unit> {
+        if (slot.hasException()) {
+          if (stats) {
+            stats->increment(&NfsStats::requestsShed);
+          }
+          serializeShedReply(ser, xid, procNumber);
+          return folly::unit;
+        }
+        if (deferred && stats) {
+          stats->addDuration(
+              &NfsStats::requestQueueDelay, slot->getQueueDelay());
+        }
+        return makeImmediateFutureWith([&] {
+                 return applyGatheredWritesBefore(
+                     procNumber, deser, contextRef->getObjectFetchContext());
+               })
+            .thenValue([this,
+                        &handlerEntry,
+                        deser = std::move(deser),
+                        ser = std::move(ser),
+                        contextRef](folly::Unit) mutable {
+              return (this->*handlerEntry.handler)(
+                  std::move(deser), std::move(ser), *contextRef);
+            })
+            .ensure([slot = std::move(slot).value()] {});
+      })
+      .thenTry([this, &handlerEntry, modifies](folly::Try<folly::Unit>&& res) {
+        if (modifies) {
+          invalidateReaddirplusCache();
+        }
         if (res.hasException()) {
           if (auto* err = res.exception().get_exception<RpcParsingError>()) {
             err->setProcedureContext(std::string{handlerEntry.name});
@@ -1904,6 +2477,40 @@ void Nfsd3ServerProcessor::onShutdown(RpcStopData data) {
   stopPromise_.setValue(std::move(data));
 }
 
+void Nfsd3ServerProcessor::serializeShedReply(
+    folly::io::QueueAppender& ser,
+    uint32_t xid,
+    uint32_t procNumber) {
+  serializeReply(ser, accept_stat::SUCCESS, xid);
+  switch (static_cast<nfsv3Procs>(procNumber)) {
+    case nfsv3Procs::read: {
+      READ3res res{{{nfsstat3::NFS3ERR_JUKEBOX, READ3resfail{}}}};
+      XdrTrait<READ3res>::serialize(ser, res);
+      break;
+    }
+    case nfsv3Procs::readdir: {
+      READDIR3res res{{{nfsstat3::NFS3ERR_JUKEBOX, READDIR3resfail{}}}};
+      XdrTrait<READDIR3res>::serialize(ser, res);
+      break;
+    }
+    case nfsv3Procs::readdirplus: {
+      READDIRPLUS3res res{
+          {{nfsstat3::NFS3ERR_JUKEBOX, READDIRPLUS3resfail{}}}};
+      XdrTrait<READDIRPLUS3res>::serialize(ser, res);
+      break;
+    }
+    default:
+      EDEN_BUG() << "only bulk requests are shed, not procedure "
+                 << procNumber;
+  }
+}
+
+void Nfsd3ServerProcessor::invalidateReaddirplusCache() {
+  auto cache = readdirplusCache_.wlock();
+  ++cache->generation;
+  cache->listings.clear();
+}
+
 void Nfsd3ServerProcessor::clientConnected() {
   auto numberOfClients =
       numberOfClients_.fetch_add(1, std::memory_order_acq_rel);
@@ -1915,7 +2522,9 @@ void Nfsd3ServerProcessor::clientConnected() {
 
 Nfsd3::Nfsd3(
     folly::EventBase* evb,
+    folly::EventBase* connectionEvb,
     std::shared_ptr<folly::Executor> threadPool,
+    AbsolutePathPiece mountPath,
     std::unique_ptr<NfsDispatcher> dispatcher,
     const folly::Logger* straceLogger,
     std::shared_ptr<ProcessNameCache> processNameCache,
@@ -1925,19 +2534,27 @@ Nfsd3::Nfsd3(
     std::shared_ptr<Notifier> /*notifier*/,
     CaseSensitivity caseSensitive,
     uint32_t iosize,
-    size_t traceBusCapacity)
+    uint64_t writeGatherMaxBytes,
+    bool enableNfsv41,
+    size_t traceBusCapacity,
+    FsChannelOverloadController::Config overloadConfig)
     : server_(RpcServer::create(
           std::make_shared<Nfsd3ServerProcessor>(
+              mountPath,
               std::move(dispatcher),
               straceLogger,
               structuredLogger,
               caseSensitive,
               iosize,
+              writeGatherMaxBytes,
+              enableNfsv41,
               stopPromise_,
               processAccessLog_,
               traceDetailedArguments_,
-              traceBus_),
+              traceBus_,
+              overloadConfig),
           evb,
+          {connectionEvb},
           std::move(threadPool),
           structuredLogger)),
       processAccessLog_(std::move(processNameCache)),
@@ -16,6 +16,8 @@
 #include "eden/fs/nfs/rpc/Server.h"
 #include "eden/fs/telemetry/TraceBus.h"
 #include "eden/fs/utils/CaseSensitivity.h"
+#include "eden/fs/utils/FsChannelOverloadController.h"
+#include "eden/fs/utils/PathFuncs.h"
 #include "eden/fs/utils/ProcessAccessLog.h"
 
 namespace folly {
@@ -119,8 +121,10 @@ class Nfsd3 {
    * registered with rpcbind, and thus if a real NFS server is running on this
    * host, EdenFS won't be able to register itself.
    *
-   * All the socket processing will be run on the EventBase passed in. This
-   * also must be called on that EventBase thread.
+   * The server socket is owned by the EventBase passed in, and this must be
+   * called on that EventBase thread. The connection to the kernel is
+   * read from and written to on connectionEvb, which may be the same
+   * EventBase.
    *
    * Note: at mount time, EdenFS will manually call mount.nfs with -o port
    * to manually specify the port on which this server is bound, so registering
@@ -128,7 +132,9 @@ class Nfsd3 {
    */
   Nfsd3(
       folly::EventBase* evb,
+      folly::EventBase* connectionEvb,
       std::shared_ptr<folly::Executor> threadPool,
+      AbsolutePathPiece mountPath,
       std::unique_ptr<NfsDispatcher> dispatcher,
       const folly::Logger* straceLogger,
       std::shared_ptr<ProcessNameCache> processNameCache,
@@ -138,7 +144,10 @@ class Nfsd3 {
       std::shared_ptr<Notifier> notifications,
       CaseSensitivity caseSensitive,
       uint32_t iosize,
-      size_t traceBusCapacity);
+      uint64_t writeGatherMaxBytes,
+      bool enableNfsv41,
+      size_t traceBusCapacity,
+      FsChannelOverloadController::Config overloadConfig);
 
   /**
    * This is triggered when the kernel closes the socket. The socket is closed
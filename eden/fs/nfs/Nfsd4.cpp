@@ -0,0 +1,923 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/nfs/Nfsd4.h"
+
+#include <folly/Random.h>
+#include <folly/Utility.h>
+#include <folly/io/IOBufQueue.h>
+#include <folly/logging/xlog.h>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+#include "eden/fs/inodes/InodeNumber.h"
+#include "eden/fs/nfs/NfsDispatcher.h"
+#include "eden/fs/nfs/NfsRequestContext.h"
+#include "eden/fs/nfs/rpc/Rpc.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+namespace {
+
+/**
+ * Upper bound on the number of operations in a COMPOUND, and on the number of
+ * concurrent requests of a session.
+ */
+constexpr uint32_t kMaxOperations = 64;
+constexpr uint32_t kMaxSlots = 64;
+
+/**
+ * Nfsd4 keeps no state that needs to be reclaimed, the lease time is thus
+ * only used by the clients to decide how often to renew their lease.
+ */
+constexpr uint32_t kLeaseTime = 90;
+
+/**
+ * The ACCESS bits are the same as NFSv3's, all of which are supported.
+ */
+constexpr uint32_t kAccess4Supported = 0x3f;
+
+/**
+ * Size of a READDIR4res without any entry: the operation number, status,
+ * cookie verifier, list terminator and eof.
+ */
+constexpr size_t kReaddirBaseSize = 24;
+
+nfsstat4 exceptionToNfs4Error(const folly::exception_wrapper& ex) {
+  auto status = exceptionToNfsError(ex);
+  if (status == nfsstat3::NFS3ERR_NODEV) {
+    // NFSv4 has no NODEV.
+    return nfsstat4::NFS4ERR_NXIO;
+  }
+  return static_cast<nfsstat4>(status);
+}
+
+/**
+ * Operations that create or destroy the session the other operations run in,
+ * and can thus be sent alone in a COMPOUND without a SEQUENCE.
+ */
+bool isSessionlessOperation(nfs_opnum4 op) {
+  switch (op) {
+    case nfs_opnum4::exchange_id:
+    case nfs_opnum4::create_session:
+    case nfs_opnum4::destroy_session:
+    case nfs_opnum4::destroy_clientid:
+      return true;
+    default:
+      return false;
+  }
+}
+
+template <typename Res>
+nfsstat4
+serializeResult(folly::io::QueueAppender& ser, nfs_opnum4 op, const Res& res) {
+  XdrTrait<nfs_opnum4>::serialize(ser, op);
+  XdrTrait<Res>::serialize(ser, res);
+  return res.tag;
+}
+
+/**
+ * Serialize the result of an operation that failed, or whose result has no
+ * data.
+ */
+nfsstat4 serializeStatus(
+    folly::io::QueueAppender& ser,
+    nfs_opnum4 op,
+    nfsstat4 status) {
+  XdrTrait<nfs_opnum4>::serialize(ser, op);
+  XdrTrait<nfsstat4>::serialize(ser, status);
+  return status;
+}
+
+/**
+ * Without OPEN, the clients read with one of the special stateids.
+ */
+bool isAnonymousStateid(const stateid4& stateid) {
+  auto allEqual = [&](uint8_t value) {
+    return std::all_of(
+        stateid.other.begin(), stateid.other.end(), [value](uint8_t byte) {
+          return byte == value;
+        });
+  };
+  return (stateid.seqid == 0 && allEqual(0)) ||
+      (stateid.seqid == UINT32_MAX && allEqual(0xff));
+}
+
+/**
+ * Whether the requested attributes need the stat of the file, and not only
+ * its inode number.
+ */
+bool requiresStat(const bitmap4& requested) {
+  for (auto attr :
+       {fattr4_attr::type,
+        fattr4_attr::change,
+        fattr4_attr::size,
+        fattr4_attr::fsid,
+        fattr4_attr::mode,
+        fattr4_attr::numlinks,
+        fattr4_attr::owner,
+        fattr4_attr::owner_group,
+        fattr4_attr::rawdev,
+        fattr4_attr::space_used,
+        fattr4_attr::time_access,
+        fattr4_attr::time_metadata,
+        fattr4_attr::time_modify}) {
+    if (hasFattr4(requested, attr)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace
+
+/**
+ * State of a COMPOUND while its operations run, alive until the last one
+ * completes.
+ */
+struct Nfsd4::Compound {
+  Compound(
+      folly::io::Cursor deser,
+      uint32_t numOperations,
+      NfsRequestContext& context)
+      : deser{deser}, numOperations{numOperations}, context{context} {}
+
+  folly::io::Cursor deser;
+  const uint32_t numOperations;
+  uint32_t index{0};
+  NfsRequestContext& context;
+
+  std::optional<InodeNumber> currentFh;
+  std::optional<InodeNumber> savedFh;
+  // Set by SEQUENCE.
+  std::optional<uint64_t> clientId;
+
+  // The results are serialized here, as their number is only known once
+  // the COMPOUND stops.
+  folly::IOBufQueue results{folly::IOBufQueue::cacheChainLength()};
+  folly::io::QueueAppender ser{&results, 1024};
+  uint32_t numResults{0};
+  nfsstat4 status{nfsstat4::NFS4_OK};
+};
+
+Nfsd4::Nfsd4(
+    NfsDispatcher* dispatcher,
+    CaseSensitivity caseSensitive,
+    uint32_t iosize)
+    : dispatcher_{dispatcher},
+      properties_{iosize, caseSensitive, kLeaseTime},
+      serverOwner_{[] {
+        std::vector<uint8_t> owner(sizeof(uint64_t));
+        auto value = folly::Random::rand64();
+        memcpy(owner.data(), &value, sizeof(value));
+        return owner;
+      }()} {
+  state_.wlock()->nextClientId = folly::Random::rand64();
+}
+
+ImmediateFuture<folly::Unit> Nfsd4::dispatchRpc(
+    folly::io::Cursor deser,
+    folly::io::QueueAppender ser,
+    uint32_t xid,
+    uint32_t procNumber,
+    NfsRequestContext& context) {
+  switch (static_cast<nfsv4Procs>(procNumber)) {
+    case nfsv4Procs::null:
+      serializeReply(ser, accept_stat::SUCCESS, xid);
+      return folly::unit;
+    case nfsv4Procs::compound:
+      serializeReply(ser, accept_stat::SUCCESS, xid);
+      return compound(deser, std::move(ser), context);
+  }
+  serializeReply(ser, accept_stat::PROC_UNAVAIL, xid);
+  return folly::unit;
+}
+
+ImmediateFuture<folly::Unit> Nfsd4::compound(
+    folly::io::Cursor deser,
+    folly::io::QueueAppender ser,
+    NfsRequestContext& context) {
+  auto tag = XdrTrait<std::string>::deserialize(deser);
+  auto minorVersion = XdrTrait<uint32_t>::deserialize(deser);
+  auto numOperations = XdrTrait<uint32_t>::deserialize(deser);
+
+  if (minorVersion != kNfsd4MinorVersion) {
+    XdrTrait<nfsstat4>::serialize(
+        ser, nfsstat4::NFS4ERR_MINOR_VERS_MISMATCH);
+    XdrTrait<std::string>::serialize(ser, tag);
+    XdrTrait<uint32_t>::serialize(ser, 0);
+    return folly::unit;
+  }
+
+  auto state = std::make_shared<Compound>(deser, numOperations, context);
+  return runOperations(state).thenValue(
+      [ser = std::move(ser), tag = std::move(tag), state](
+          folly::Unit) mutable {
+        XdrTrait<nfsstat4>::serialize(ser, state->status);
+        XdrTrait<std::string>::serialize(ser, tag);
+        XdrTrait<uint32_t>::serialize(ser, state->numResults);
+        if (auto results = state->results.move()) {
+          ser.insert(std::move(results));
+        }
+        return folly::unit;
+      });
+}
+
+ImmediateFuture<folly::Unit> Nfsd4::runOperations(
+    std::shared_ptr<Compound> compound) {
+  while (compound->status == nfsstat4::NFS4_OK &&
+         compound->index < compound->numOperations) {
+    auto future = runOperation(*compound);
+    if (!future.isReady()) {
+      return std::move(future).thenValue(
+          [this, compound](nfsstat4 status) mutable {
+            compound->status = status;
+            compound->numResults++;
+            compound->index++;
+            return runOperations(std::move(compound));
+          });
+    }
+    compound->status = std::move(future).get();
+    compound->numResults++;
+    compound->index++;
+  }
+  return folly::unit;
+}
+
+ImmediateFuture<nfsstat4> Nfsd4::runOperation(Compound& compound) {
+  auto op = XdrTrait<nfs_opnum4>::deserialize(compound.deser);
+
+  if (op == nfs_opnum4::sequence) {
+    if (compound.index != 0) {
+      return serializeStatus(
+          compound.ser, op, nfsstat4::NFS4ERR_SEQUENCE_POS);
+    }
+  } else if (!compound.clientId.has_value()) {
+    if (!isSessionlessOperation(op)) {
+      return serializeStatus(
+          compound.ser, op, nfsstat4::NFS4ERR_OP_NOT_IN_SESSION);
+    }
+    if (compound.numOperations != 1) {
+      return serializeStatus(compound.ser, op, nfsstat4::NFS4ERR_NOT_ONLY_OP);
+    }
+  }
+
+  switch (op) {
+    case nfs_opnum4::access:
+      return access(compound);
+    case nfs_opnum4::getattr:
+      return getattr(compound);
+    case nfs_opnum4::getfh:
+      return getfh(compound);
+    case nfs_opnum4::lookup:
+      return lookup(compound);
+    case nfs_opnum4::lookupp:
+      return lookupp(compound);
+    case nfs_opnum4::putfh:
+      return putfh(compound);
+    case nfs_opnum4::putrootfh:
+      return putrootfh(compound);
+    case nfs_opnum4::read:
+      return read(compound);
+    case nfs_opnum4::readdir:
+      return readdir(compound);
+    case nfs_opnum4::readlink:
+      return readlink(compound);
+    case nfs_opnum4::restorefh:
+      return restorefh(compound);
+    case nfs_opnum4::savefh:
+      return savefh(compound);
+    case nfs_opnum4::exchange_id:
+      return exchangeId(compound);
+    case nfs_opnum4::create_session:
+      return createSession(compound);
+    case nfs_opnum4::destroy_session:
+      return destroySession(compound);
+    case nfs_opnum4::secinfo_no_name:
+      return secinfoNoName(compound);
+    case nfs_opnum4::sequence:
+      return sequence(compound);
+    case nfs_opnum4::destroy_clientid:
+      return destroyClientId(compound);
+    case nfs_opnum4::reclaim_complete:
+      return reclaimComplete(compound);
+    case nfs_opnum4::illegal:
+      break;
+  }
+
+  auto opnum = folly::to_underlying(op);
+  if (opnum >= kNfs4FirstOperation && opnum <= kNfs4LastOperation) {
+    // The arguments of the operation can't be skipped without parsing
+    // them, the COMPOUND stops here anyway.
+    XLOG(DBG7) << "Unsupported NFSv4 operation: " << opnum;
+    return serializeStatus(compound.ser, op, nfsstat4::NFS4ERR_NOTSUPP);
+  }
+  return serializeStatus(
+      compound.ser, nfs_opnum4::illegal, nfsstat4::NFS4ERR_OP_ILLEGAL);
+}
+
+ImmediateFuture<nfsstat4> Nfsd4::access(Compound& compound) {
+  auto args = XdrTrait<ACCESS4args>::deserialize(compound.deser);
+  if (!compound.currentFh) {
+    return serializeStatus(
+        compound.ser, nfs_opnum4::access, nfsstat4::NFS4ERR_NOFILEHANDLE);
+  }
+
+  return dispatcher_
+      ->getattr(*compound.currentFh, compound.context.getObjectFetchContext())
+      .thenTry([&compound, args](folly::Try<struct stat>&& try_) {
+        if (try_.hasException()) {
+          return serializeStatus(
+              compound.ser,
+              nfs_opnum4::access,
+              exceptionToNfs4Error(try_.exception()));
+        }
+        auto supported = args.access & kAccess4Supported;
+        return serializeResult(
+            compound.ser,
+            nfs_opnum4::access,
+            ACCESS4res{
+                {{nfsstat4::NFS4_OK,
+                  ACCESS4resok{
+                      supported,
+                      getEffectiveAccessRights(try_.value(), supported)}}}});
+      });
+}
+
+ImmediateFuture<nfsstat4> Nfsd4::getattr(Compound& compound) {
+  auto args = XdrTrait<GETATTR4args>::deserialize(compound.deser);
+  if (!compound.currentFh) {
+    return serializeStatus(
+        compound.ser, nfs_opnum4::getattr, nfsstat4::NFS4ERR_NOFILEHANDLE);
+  }
+
+  return dispatcher_
+      ->getattr(*compound.currentFh, compound.context.getObjectFetchContext())
+      .thenTry([this, &compound, args = std::move(args)](
+                   folly::Try<struct stat>&& try_) {
+        if (try_.hasException()) {
+          return serializeStatus(
+              compound.ser,
+              nfs_opnum4::getattr,
+              exceptionToNfs4Error(try_.exception()));
+        }
+        return serializeResult(
+            compound.ser,
+            nfs_opnum4::getattr,
+            GETATTR4res{
+                {{nfsstat4::NFS4_OK,
+                  GETATTR4resok{statToFattr4(
+                      try_.value(), args.attr_request, properties_)}}}});
+      });
+}
+
+nfsstat4 Nfsd4::getfh(Compound& compound) {
+  if (!compound.currentFh) {
+    return serializeStatus(
+        compound.ser, nfs_opnum4::getfh, nfsstat4::NFS4ERR_NOFILEHANDLE);
+  }
+  return serializeResult(
+      compound.ser,
+      nfs_opnum4::getfh,
+      GETFH4res{
+          {{nfsstat4::NFS4_OK, GETFH4resok{nfs_fh4{*compound.currentFh}}}}});
+}
+
+ImmediateFuture<nfsstat4> Nfsd4::lookup(Compound& compound) {
+  auto args = XdrTrait<LOOKUP4args>::deserialize(compound.deser);
+  if (!compound.currentFh) {
+    return serializeStatus(
+        compound.ser, nfs_opnum4::lookup, nfsstat4::NFS4ERR_NOFILEHANDLE);
+  }
+  if (args.objname.empty()) {
+    return serializeStatus(
+        compound.ser, nfs_opnum4::lookup, nfsstat4::NFS4ERR_INVAL);
+  }
+  if (args.objname.length() > NAME_MAX) {
+    return serializeStatus(
+        compound.ser, nfs_opnum4::lookup, nfsstat4::NFS4ERR_NAMETOOLONG);
+  }
+
+  std::optional<PathComponent> name;
+  // Unlike NFSv3, "." and ".." aren't names: the parent is found with
+  // LOOKUPP.
+  if (args.objname != "." && args.objname != "..") {
+    try {
+      name.emplace(std::move(args.objname));
+    } catch (const PathComponentValidationError&) {
+    }
+  }
+  if (!name) {
+    return serializeStatus(
+        compound.ser, nfs_opnum4::lookup, nfsstat4::NFS4ERR_BADNAME);
+  }
+
+  return dispatcher_
+      ->lookup(
+          *compound.currentFh,
+          std::move(*name),
+          compound.context.getObjectFetchContext())
+      .thenTry(
+          [&compound](
+              folly::Try<std::tuple<InodeNumber, struct stat>>&& try_) {
+            if (try_.hasException()) {
+              return serializeStatus(
+                  compound.ser,
+                  nfs_opnum4::lookup,
+                  exceptionToNfs4Error(try_.exception()));
+            }
+            compound.currentFh = std::get<InodeNumber>(try_.value());
+            return serializeStatus(
+                compound.ser, nfs_opnum4::lookup, nfsstat4::NFS4_OK);
+          });
+}
+
+ImmediateFuture<nfsstat4> Nfsd4::lookupp(Compound& compound) {
+  if (!compound.currentFh) {
+    return serializeStatus(
+        compound.ser, nfs_opnum4::lookupp, nfsstat4::NFS4ERR_NOFILEHANDLE);
+  }
+  if (*compound.currentFh == kRootNodeId) {
+    return serializeStatus(
+        compound.ser, nfs_opnum4::lookupp, nfsstat4::NFS4ERR_NOENT);
+  }
+
+  return dispatcher_
+      ->getParent(
+          *compound.currentFh, compound.context.getObjectFetchContext())
+      .thenTry([&compound](folly::Try<InodeNumber>&& try_) {
+        if (try_.hasException()) {
+          return serializeStatus(
+              compound.ser,
+              nfs_opnum4::lookupp,
+              exceptionToNfs4Error(try_.exception()));
+        }
+        compound.currentFh = try_.value();
+        return serializeStatus(
+            compound.ser, nfs_opnum4::lookupp, nfsstat4::NFS4_OK);
+      });
+}
+
+nfsstat4 Nfsd4::putfh(Compound& compound) {
+  auto args = XdrTrait<PUTFH4args>::deserialize(compound.deser);
+  compound.currentFh = args.object.ino;
+  return serializeStatus(compound.ser, nfs_opnum4::putfh, nfsstat4::NFS4_OK);
+}
+
+nfsstat4 Nfsd4::putrootfh(Compound& compound) {
+  compound.currentFh = kRootNodeId;
+  return serializeStatus(
+      compound.ser, nfs_opnum4::putrootfh, nfsstat4::NFS4_OK);
+}
+
+ImmediateFuture<nfsstat4> Nfsd4::read(Compound& compound) {
+  auto args = XdrTrait<READ4args>::deserialize(compound.deser);
+  if (!compound.currentFh) {
+    return serializeStatus(
+        compound.ser, nfs_opnum4::read, nfsstat4::NFS4ERR_NOFILEHANDLE);
+  }
+  if (!isAnonymousStateid(args.stateid)) {
+    // No stateid is ever handed out as OPEN isn't supported.
+    return serializeStatus(
+        compound.ser, nfs_opnum4::read, nfsstat4::NFS4ERR_BAD_STATEID);
+  }
+
+  return dispatcher_
+      ->read(
+          *compound.currentFh,
+          std::min(args.count, properties_.iosize),
+          folly::to_signed(args.offset),
+          compound.context.getObjectFetchContext())
+      .thenTry([&compound](folly::Try<NfsDispatcher::ReadRes>&& try_) {
+        if (try_.hasException()) {
+          return serializeStatus(
+              compound.ser,
+              nfs_opnum4::read,
+              exceptionToNfs4Error(try_.exception()));
+        }
+        auto& res = try_.value();
+        return serializeResult(
+            compound.ser,
+            nfs_opnum4::read,
+            READ4res{
+                {{nfsstat4::NFS4_OK,
+                  READ4resok{res.isEof, std::move(res.data)}}}});
+      });
+}
+
+ImmediateFuture<nfsstat4> Nfsd4::readdir(Compound& compound) {
+  auto args = XdrTrait<READDIR4args>::deserialize(compound.deser);
+  if (!compound.currentFh) {
+    return serializeStatus(
+        compound.ser, nfs_opnum4::readdir, nfsstat4::NFS4ERR_NOFILEHANDLE);
+  }
+  if (args.cookie == 1 || args.cookie == 2) {
+    // Reserved by the protocol, these are the cookies of "." and "..",
+    // which are never returned.
+    return serializeStatus(
+        compound.ser, nfs_opnum4::readdir, nfsstat4::NFS4ERR_BAD_COOKIE);
+  }
+
+  auto dir = *compound.currentFh;
+  return dispatcher_
+      ->readdir(
+          dir,
+          folly::to_signed(args.cookie),
+          args.maxcount,
+          compound.context.getObjectFetchContext())
+      .thenValue([this, &compound, args = std::move(args)](
+                     NfsDispatcher::ReaddirRes&& res) mutable {
+        std::vector<entry3> entries;
+        for (auto& entry : res.entries.extractList<entry3>().list) {
+          if (entry.name != "." && entry.name != "..") {
+            entries.push_back(std::move(entry));
+          }
+        }
+
+        bool needsStat = requiresStat(args.attr_request);
+        bool reportErrors =
+            hasFattr4(args.attr_request, fattr4_attr::rdattr_error);
+        std::vector<ImmediateFuture<fattr4>> attrs;
+        attrs.reserve(entries.size());
+        for (const auto& entry : entries) {
+          if (!needsStat) {
+            struct stat stat {};
+            stat.st_ino = entry.fileid;
+            attrs.emplace_back(
+                statToFattr4(stat, args.attr_request, properties_));
+            continue;
+          }
+          attrs.push_back(
+              makeImmediateFutureWith([&] {
+                return dispatcher_->lookup(
+                    *compound.currentFh,
+                    PathComponent{entry.name},
+                    compound.context.getObjectFetchContext());
+              })
+                  .thenTry(
+                      [this, attrRequest = args.attr_request, reportErrors](
+                          folly::Try<std::tuple<InodeNumber, struct stat>>&&
+                              try_) {
+                        if (try_.hasException()) {
+                          if (!reportErrors) {
+                            try_.exception().throw_exception();
+                          }
+                          return rdattrErrorToFattr4(
+                              exceptionToNfs4Error(try_.exception()));
+                        }
+                        return statToFattr4(
+                            std::get<struct stat>(try_.value()),
+                            attrRequest,
+                            properties_);
+                      }));
+        }
+
+        return collectAllSafe(std::move(attrs))
+            .thenValue([entries = std::move(entries),
+                        maxcount = args.maxcount,
+                        isEof = res.isEof](std::vector<fattr4>&& attrs) {
+              READDIR4resok resok{};
+              size_t size = kReaddirBaseSize;
+              bool complete = true;
+              for (size_t i = 0; i < entries.size(); i++) {
+                entry4 entry{
+                    entries[i].cookie,
+                    std::move(entries[i].name),
+                    std::move(attrs[i])};
+                auto entrySize = XdrTrait<bool>::serializedSize(true) +
+                    XdrTrait<entry4>::serializedSize(entry);
+                if (size + entrySize > maxcount) {
+                  complete = false;
+                  break;
+                }
+                size += entrySize;
+                resok.reply.entries.list.push_back(std::move(entry));
+              }
+              resok.reply.eof = complete && isEof;
+              return resok;
+            });
+      })
+      .thenTry([&compound](folly::Try<READDIR4resok>&& try_) {
+        if (try_.hasException()) {
+          return serializeStatus(
+              compound.ser,
+              nfs_opnum4::readdir,
+              exceptionToNfs4Error(try_.exception()));
+        }
+        auto& resok = try_.value();
+        if (resok.reply.entries.list.empty() && !resok.reply.eof) {
+          return serializeStatus(
+              compound.ser, nfs_opnum4::readdir, nfsstat4::NFS4ERR_TOOSMALL);
+        }
+        return serializeResult(
+            compound.ser,
+            nfs_opnum4::readdir,
+            READDIR4res{{{nfsstat4::NFS4_OK, std::move(resok)}}});
+      });
+}
+
+ImmediateFuture<nfsstat4> Nfsd4::readlink(Compound& compound) {
+  if (!compound.currentFh) {
+    return serializeStatus(
+        compound.ser, nfs_opnum4::readlink, nfsstat4::NFS4ERR_NOFILEHANDLE);
+  }
+
+  return dispatcher_
+      ->readlink(
+          *compound.currentFh, compound.context.getObjectFetchContext())
+      .thenTry([&compound](folly::Try<std::string>&& try_) {
+        if (try_.hasException()) {
+          return serializeStatus(
+              compound.ser,
+              nfs_opnum4::readlink,
+              exceptionToNfs4Error(try_.exception()));
+        }
+        return serializeResult(
+            compound.ser,
+            nfs_opnum4::readlink,
+            READLINK4res{
+                {{nfsstat4::NFS4_OK,
+                  READLINK4resok{std::move(try_.value())}}}});
+      });
+}
+
+nfsstat4 Nfsd4::restorefh(Compound& compound) {
+  if (!compound.savedFh) {
+    return serializeStatus(
+        compound.ser, nfs_opnum4::restorefh, nfsstat4::NFS4ERR_RESTOREFH);
+  }
+  compound.currentFh = compound.savedFh;
+  return serializeStatus(
+      compound.ser, nfs_opnum4::restorefh, nfsstat4::NFS4_OK);
+}
+
+nfsstat4 Nfsd4::savefh(Compound& compound) {
+  if (!compound.currentFh) {
+    return serializeStatus(
+        compound.ser, nfs_opnum4::savefh, nfsstat4::NFS4ERR_NOFILEHANDLE);
+  }
+  compound.savedFh = compound.currentFh;
+  return serializeStatus(compound.ser, nfs_opnum4::savefh, nfsstat4::NFS4_OK);
+}
+
+void Nfsd4::removeClient(State& state, uint64_t clientId) {
+  auto it = state.clients.find(clientId);
+  if (it == state.clients.end()) {
+    return;
+  }
+  state.owners.erase(it->second.owner);
+  state.clients.erase(it);
+  for (auto session = state.sessions.begin();
+       session != state.sessions.end();) {
+    if (session->second.clientId == clientId) {
+      session = state.sessions.erase(session);
+    } else {
+      ++session;
+    }
+  }
+}
+
+nfsstat4 Nfsd4::exchangeId(Compound& compound) {
+  auto args = XdrTrait<EXCHANGE_ID4args>::deserialize(compound.deser);
+  if (args.state_protect.tag != state_protect_how4::SP4_NONE) {
+    return serializeStatus(
+        compound.ser, nfs_opnum4::exchange_id, nfsstat4::NFS4ERR_NOTSUPP);
+  }
+
+  auto& owner = args.clientowner.co_ownerid;
+  auto state = state_.lock();
+  auto existing = state->owners.find(owner);
+  if (existing != state->owners.end() &&
+      state->clients.at(existing->second).verifier !=
+          args.clientowner.co_verifier) {
+    // The client rebooted, its previous incarnation is gone.
+    removeClient(*state, existing->second);
+    existing = state->owners.end();
+  }
+
+  uint64_t clientId;
+  if (existing != state->owners.end()) {
+    clientId = existing->second;
+  } else {
+    clientId = state->nextClientId++;
+    state->owners.emplace(owner, clientId);
+    state->clients.emplace(
+        clientId, Client{args.clientowner.co_verifier, owner});
+  }
+  const auto& client = state->clients.at(clientId);
+
+  auto flags = EXCHGID4_FLAG_USE_NON_PNFS;
+  if (client.confirmed) {
+    flags |= EXCHGID4_FLAG_CONFIRMED_R;
+  }
+  return serializeResult(
+      compound.ser,
+      nfs_opnum4::exchange_id,
+      EXCHANGE_ID4res{
+          {{nfsstat4::NFS4_OK,
+            EXCHANGE_ID4resok{
+                clientId,
+                client.sequenceId,
+                flags,
+                state_protect_how4::SP4_NONE,
+                server_owner4{0, serverOwner_},
+                serverOwner_,
+                {}}}}});
+}
+
+nfsstat4 Nfsd4::createSession(Compound& compound) {
+  auto args = XdrTrait<CREATE_SESSION4args>::deserialize(compound.deser);
+
+  auto state = state_.lock();
+  auto client = state->clients.find(args.clientid);
+  if (client == state->clients.end()) {
+    return serializeStatus(
+        compound.ser,
+        nfs_opnum4::create_session,
+        nfsstat4::NFS4ERR_STALE_CLIENTID);
+  }
+  if (args.sequence != client->second.sequenceId) {
+    return serializeStatus(
+        compound.ser,
+        nfs_opnum4::create_session,
+        nfsstat4::NFS4ERR_SEQ_MISORDERED);
+  }
+  client->second.sequenceId++;
+  client->second.confirmed = true;
+
+  // Requests and replies carry at most a READ or READDIR worth of data,
+  // plus the headers.
+  uint32_t maxMessageSize = properties_.iosize + 64 * 1024;
+  const auto& fore = args.fore_chan_attrs;
+  channel_attrs4 foreChannel{
+      0,
+      std::min(fore.maxrequestsize, maxMessageSize),
+      std::min(fore.maxresponsesize, maxMessageSize),
+      std::min(fore.maxresponsesize_cached, maxMessageSize),
+      std::min(fore.maxoperations, kMaxOperations),
+      std::clamp(fore.maxrequests, uint32_t{1}, kMaxSlots),
+      {}};
+  // Nfsd4 never uses the backchannel, its attributes don't matter.
+  channel_attrs4 backChannel = args.back_chan_attrs;
+  backChannel.rdma_ird.clear();
+
+  sessionid4 sessionId{};
+  uint64_t sessionCounter = state->nextSessionId++;
+  memcpy(sessionId.data(), &args.clientid, sizeof(args.clientid));
+  memcpy(
+      sessionId.data() + sizeof(args.clientid),
+      &sessionCounter,
+      sizeof(sessionCounter));
+  state->sessions.emplace(
+      sessionId,
+      Session{
+          args.clientid,
+          foreChannel.maxoperations,
+          std::vector<uint32_t>(foreChannel.maxrequests, 0)});
+
+  return serializeResult(
+      compound.ser,
+      nfs_opnum4::create_session,
+      CREATE_SESSION4res{
+          {{nfsstat4::NFS4_OK,
+            CREATE_SESSION4resok{
+                sessionId,
+                args.sequence,
+                0,
+                std::move(foreChannel),
+                std::move(backChannel)}}}});
+}
+
+nfsstat4 Nfsd4::destroySession(Compound& compound) {
+  auto args = XdrTrait<DESTROY_SESSION4args>::deserialize(compound.deser);
+  auto erased = state_.lock()->sessions.erase(args.sessionid);
+  return serializeStatus(
+      compound.ser,
+      nfs_opnum4::destroy_session,
+      erased ? nfsstat4::NFS4_OK : nfsstat4::NFS4ERR_BADSESSION);
+}
+
+nfsstat4 Nfsd4::secinfoNoName(Compound& compound) {
+  XdrTrait<secinfo_style4>::deserialize(compound.deser);
+  if (!compound.currentFh) {
+    return serializeStatus(
+        compound.ser,
+        nfs_opnum4::secinfo_no_name,
+        nfsstat4::NFS4ERR_NOFILEHANDLE);
+  }
+  // As required by RFC8881, SECINFO_NO_NAME consumes the current file
+  // handle.
+  compound.currentFh.reset();
+  return serializeResult(
+      compound.ser,
+      nfs_opnum4::secinfo_no_name,
+      SECINFO_NO_NAME4res{
+          {{nfsstat4::NFS4_OK,
+            SECINFO4resok{auth_flavor::AUTH_SYS, auth_flavor::AUTH_NONE}}}});
+}
+
+nfsstat4 Nfsd4::sequence(Compound& compound) {
+  auto args = XdrTrait<SEQUENCE4args>::deserialize(compound.deser);
+
+  auto state = state_.lock();
+  auto session = state->sessions.find(args.sessionid);
+  if (session == state->sessions.end()) {
+    return serializeStatus(
+        compound.ser, nfs_opnum4::sequence, nfsstat4::NFS4ERR_BADSESSION);
+  }
+  if (compound.numOperations > session->second.maxOperations) {
+    return serializeStatus(
+        compound.ser, nfs_opnum4::sequence, nfsstat4::NFS4ERR_TOO_MANY_OPS);
+  }
+  auto& slots = session->second.slots;
+  if (args.slotid >= slots.size()) {
+    return serializeStatus(
+        compound.ser, nfs_opnum4::sequence, nfsstat4::NFS4ERR_BADSLOT);
+  }
+
+  auto& slot = slots[args.slotid];
+  if (args.sequenceid == slot + 1) {
+    slot = args.sequenceid;
+  } else if (args.sequenceid != slot || slot == 0) {
+    return serializeStatus(
+        compound.ser, nfs_opnum4::sequence, nfsstat4::NFS4ERR_SEQ_MISORDERED);
+  }
+  // Otherwise, the client is retrying the last request of the slot. Replies
+  // aren't cached, but as the supported operations don't modify the file
+  // system, running it again is equivalent.
+
+  compound.clientId = session->second.clientId;
+  uint32_t highestSlotId = slots.size() - 1;
+  return serializeResult(
+      compound.ser,
+      nfs_opnum4::sequence,
+      SEQUENCE4res{
+          {{nfsstat4::NFS4_OK,
+            SEQUENCE4resok{
+                args.sessionid,
+                args.sequenceid,
+                args.slotid,
+                highestSlotId,
+                highestSlotId,
+                0}}}});
+}
+
+nfsstat4 Nfsd4::destroyClientId(Compound& compound) {
+  auto args = XdrTrait<DESTROY_CLIENTID4args>::deserialize(compound.deser);
+
+  auto state = state_.lock();
+  if (!state->clients.count(args.clientid)) {
+    return serializeStatus(
+        compound.ser,
+        nfs_opnum4::destroy_clientid,
+        nfsstat4::NFS4ERR_STALE_CLIENTID);
+  }
+  for (const auto& [id, session] : state->sessions) {
+    if (session.clientId == args.clientid) {
+      return serializeStatus(
+          compound.ser,
+          nfs_opnum4::destroy_clientid,
+          nfsstat4::NFS4ERR_CLIENTID_BUSY);
+    }
+  }
+  removeClient(*state, args.clientid);
+  return serializeStatus(
+      compound.ser, nfs_opnum4::destroy_clientid, nfsstat4::NFS4_OK);
+}
+
+nfsstat4 Nfsd4::reclaimComplete(Compound& compound) {
+  auto args = XdrTrait<RECLAIM_COMPLETE4args>::deserialize(compound.deser);
+
+  auto state = state_.lock();
+  auto client = state->clients.find(*compound.clientId);
+  if (client == state->clients.end()) {
+    // Removed by an EXCHANGE_ID since the SEQUENCE of this COMPOUND.
+    return serializeStatus(
+        compound.ser,
+        nfs_opnum4::reclaim_complete,
+        nfsstat4::NFS4ERR_STALE_CLIENTID);
+  }
+  if (!args.one_fs) {
+    if (client->second.reclaimComplete) {
+      return serializeStatus(
+          compound.ser,
+          nfs_opnum4::reclaim_complete,
+          nfsstat4::NFS4ERR_COMPLETE_ALREADY);
+    }
+    client->second.reclaimComplete = true;
+  }
+  return serializeStatus(
+      compound.ser, nfs_opnum4::reclaim_complete, nfsstat4::NFS4_OK);
+}
+
+} // namespace facebook::eden
+
+#endif
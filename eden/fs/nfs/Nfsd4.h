@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#ifndef _WIN32
+
+#include <folly/Synchronized.h>
+#include <folly/io/Cursor.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "eden/fs/nfs/NfsUtils.h"
+#include "eden/fs/nfs/Nfsd4Rpc.h"
+#include "eden/fs/utils/ImmediateFuture.h"
+
+namespace facebook::eden {
+
+class NfsDispatcher;
+class NfsRequestContext;
+
+/**
+ * NFSv4.1 program, served next to NFSv3 on the connection of an Nfsd3, and
+ * backed by the same NfsDispatcher.
+ *
+ * Every NFSv4 request is a COMPOUND of operations that share a current file
+ * handle. This lets a client resolve a path and fetch the attributes of a
+ * file, or list a directory with only the attributes it needs, in a single
+ * round trip where NFSv3 needs one per LOOKUP, GETATTR and ACCESS.
+ *
+ * Clients establish a session first (EXCHANGE_ID, CREATE_SESSION), and then
+ * start every COMPOUND with a SEQUENCE on one of its slots.
+ *
+ * Only the operations reading the file system are supported: OPEN, locking,
+ * delegations and the operations modifying the file system fail with
+ * NFS4ERR_NOTSUPP.
+ */
+class Nfsd4 {
+ public:
+  Nfsd4(
+      NfsDispatcher* dispatcher,
+      CaseSensitivity caseSensitive,
+      uint32_t iosize);
+
+  Nfsd4(const Nfsd4&) = delete;
+  Nfsd4(Nfsd4&&) = delete;
+  Nfsd4& operator=(const Nfsd4&) = delete;
+  Nfsd4& operator=(Nfsd4&&) = delete;
+
+  /**
+   * Handle an NFSv4 procedure, serializing the RPC reply to ser.
+   */
+  ImmediateFuture<folly::Unit> dispatchRpc(
+      folly::io::Cursor deser,
+      folly::io::QueueAppender ser,
+      uint32_t xid,
+      uint32_t procNumber,
+      NfsRequestContext& context);
+
+ private:
+  struct Compound;
+
+  struct Client {
+    verifier4 verifier;
+    std::vector<uint8_t> owner;
+    // The sequence of the next CREATE_SESSION.
+    uint32_t sequenceId{1};
+    bool confirmed{false};
+    bool reclaimComplete{false};
+  };
+
+  struct Session {
+    uint64_t clientId;
+    uint32_t maxOperations;
+    // The sequence of the last request on each slot.
+    std::vector<uint32_t> slots;
+  };
+
+  struct State {
+    uint64_t nextClientId;
+    uint64_t nextSessionId{0};
+    std::unordered_map<uint64_t, Client> clients;
+    // Client ids, by owner.
+    std::map<std::vector<uint8_t>, uint64_t> owners;
+    std::map<sessionid4, Session> sessions;
+  };
+
+  ImmediateFuture<folly::Unit> compound(
+      folly::io::Cursor deser,
+      folly::io::QueueAppender ser,
+      NfsRequestContext& context);
+
+  /**
+   * Run the operations left in the compound, until one of them fails.
+   */
+  ImmediateFuture<folly::Unit> runOperations(
+      std::shared_ptr<Compound> compound);
+
+  /**
+   * Run the next operation of the compound, serializing its result, and
+   * return its status.
+   */
+  ImmediateFuture<nfsstat4> runOperation(Compound& compound);
+
+  ImmediateFuture<nfsstat4> access(Compound& compound);
+  ImmediateFuture<nfsstat4> getattr(Compound& compound);
+  nfsstat4 getfh(Compound& compound);
+  ImmediateFuture<nfsstat4> lookup(Compound& compound);
+  ImmediateFuture<nfsstat4> lookupp(Compound& compound);
+  nfsstat4 putfh(Compound& compound);
+  nfsstat4 putrootfh(Compound& compound);
+  ImmediateFuture<nfsstat4> read(Compound& compound);
+  ImmediateFuture<nfsstat4> readdir(Compound& compound);
+  ImmediateFuture<nfsstat4> readlink(Compound& compound);
+  nfsstat4 restorefh(Compound& compound);
+  nfsstat4 savefh(Compound& compound);
+  nfsstat4 exchangeId(Compound& compound);
+  nfsstat4 createSession(Compound& compound);
+  nfsstat4 destroySession(Compound& compound);
+  nfsstat4 secinfoNoName(Compound& compound);
+  nfsstat4 sequence(Compound& compound);
+  nfsstat4 destroyClientId(Compound& compound);
+  nfsstat4 reclaimComplete(Compound& compound);
+
+  /**
+   * Forget about the client and its sessions.
+   */
+  static void removeClient(State& state, uint64_t clientId);
+
+  NfsDispatcher* const dispatcher_;
+  const Nfs4FsProperties properties_;
+  // Identifies this server to clients, which would otherwise consider the
+  // servers of different mounts as one.
+  const std::vector<uint8_t> serverOwner_;
+  folly::Synchronized<State, std::mutex> state_;
+};
+
+} // namespace facebook::eden
+
+#endif
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/nfs/Nfsd4Rpc.h"
+
+namespace facebook::eden {
+EDEN_XDR_SERDE_IMPL(nfstime4, seconds, nseconds);
+EDEN_XDR_SERDE_IMPL(fsid4, major, minor);
+EDEN_XDR_SERDE_IMPL(specdata4, specdata1, specdata2);
+EDEN_XDR_SERDE_IMPL(fattr4, attrmask, attr_vals);
+EDEN_XDR_SERDE_IMPL(stateid4, seqid, other);
+EDEN_XDR_SERDE_IMPL(ACCESS4args, access);
+EDEN_XDR_SERDE_IMPL(ACCESS4resok, supported, access);
+EDEN_XDR_SERDE_IMPL(GETATTR4args, attr_request);
+EDEN_XDR_SERDE_IMPL(GETATTR4resok, obj_attributes);
+EDEN_XDR_SERDE_IMPL(GETFH4resok, object);
+EDEN_XDR_SERDE_IMPL(LOOKUP4args, objname);
+EDEN_XDR_SERDE_IMPL(PUTFH4args, object);
+EDEN_XDR_SERDE_IMPL(READ4args, stateid, offset, count);
+EDEN_XDR_SERDE_IMPL(READ4resok, eof, data);
+EDEN_XDR_SERDE_IMPL(
+    READDIR4args,
+    cookie,
+    cookieverf,
+    dircount,
+    maxcount,
+    attr_request);
+EDEN_XDR_SERDE_IMPL(entry4, cookie, name, attrs);
+EDEN_XDR_SERDE_IMPL(dirlist4, entries, eof);
+EDEN_XDR_SERDE_IMPL(READDIR4resok, cookieverf, reply);
+EDEN_XDR_SERDE_IMPL(READLINK4resok, link);
+EDEN_XDR_SERDE_IMPL(client_owner4, co_verifier, co_ownerid);
+EDEN_XDR_SERDE_IMPL(nfs_impl_id4, nii_domain, nii_name, nii_date);
+EDEN_XDR_SERDE_IMPL(state_protect_ops4, spo_must_enforce, spo_must_allow);
+EDEN_XDR_SERDE_IMPL(
+    EXCHANGE_ID4args,
+    clientowner,
+    flags,
+    state_protect,
+    client_impl_id);
+EDEN_XDR_SERDE_IMPL(server_owner4, so_minor_id, so_major_id);
+EDEN_XDR_SERDE_IMPL(
+    EXCHANGE_ID4resok,
+    clientid,
+    sequenceid,
+    flags,
+    state_protect,
+    server_owner,
+    server_scope,
+    server_impl_id);
+EDEN_XDR_SERDE_IMPL(
+    channel_attrs4,
+    headerpadsize,
+    maxrequestsize,
+    maxresponsesize,
+    maxresponsesize_cached,
+    maxoperations,
+    maxrequests,
+    rdma_ird);
+EDEN_XDR_SERDE_IMPL(
+    CREATE_SESSION4args,
+    clientid,
+    sequence,
+    flags,
+    fore_chan_attrs,
+    back_chan_attrs,
+    cb_program,
+    sec_parms);
+EDEN_XDR_SERDE_IMPL(
+    CREATE_SESSION4resok,
+    sessionid,
+    sequence,
+    flags,
+    fore_chan_attrs,
+    back_chan_attrs);
+EDEN_XDR_SERDE_IMPL(DESTROY_SESSION4args, sessionid);
+EDEN_XDR_SERDE_IMPL(
+    SEQUENCE4args,
+    sessionid,
+    sequenceid,
+    slotid,
+    highest_slotid,
+    cachethis);
+EDEN_XDR_SERDE_IMPL(
+    SEQUENCE4resok,
+    sessionid,
+    sequenceid,
+    slotid,
+    highest_slotid,
+    target_highest_slotid,
+    status_flags);
+EDEN_XDR_SERDE_IMPL(DESTROY_CLIENTID4args, clientid);
+EDEN_XDR_SERDE_IMPL(RECLAIM_COMPLETE4args, one_fs);
+} // namespace facebook::eden
+
+#endif
@@ -0,0 +1,614 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#ifndef _WIN32
+
+#include "eden/fs/nfs/NfsdRpc.h"
+
+/*
+ * NFSv4.1 protocol described in RFC8881:
+ * https://tools.ietf.org/html/rfc8881
+ *
+ * Only the subset of the protocol that Nfsd4 implements is described here.
+ */
+
+namespace facebook::eden {
+
+constexpr uint32_t kNfsd4ProgVersion = 4;
+constexpr uint32_t kNfsd4MinorVersion = 1;
+
+/**
+ * Procedure values: everything but NULL is sent as a COMPOUND.
+ */
+enum class nfsv4Procs : uint32_t {
+  null = 0,
+  compound = 1,
+};
+
+/**
+ * Operations that a COMPOUND is made of. Operations from ACCESS to
+ * kNfs4LastOperation that are not listed here exist but are not supported.
+ */
+enum class nfs_opnum4 : uint32_t {
+  access = 3,
+  getattr = 9,
+  getfh = 10,
+  lookup = 15,
+  lookupp = 16,
+  putfh = 22,
+  putrootfh = 24,
+  read = 25,
+  readdir = 26,
+  readlink = 27,
+  restorefh = 31,
+  savefh = 32,
+  exchange_id = 42,
+  create_session = 43,
+  destroy_session = 44,
+  secinfo_no_name = 52,
+  sequence = 53,
+  destroy_clientid = 57,
+  reclaim_complete = 58,
+  illegal = 10044,
+};
+
+constexpr uint32_t kNfs4FirstOperation = 3;
+constexpr uint32_t kNfs4LastOperation = 58;
+
+/**
+ * The error values shared with NFSv3 have the same value, an nfsstat3 can
+ * thus be cast to an nfsstat4.
+ */
+enum class nfsstat4 : uint32_t {
+  NFS4_OK = 0,
+  NFS4ERR_PERM = 1,
+  NFS4ERR_NOENT = 2,
+  NFS4ERR_IO = 5,
+  NFS4ERR_NXIO = 6,
+  NFS4ERR_ACCESS = 13,
+  NFS4ERR_EXIST = 17,
+  NFS4ERR_XDEV = 18,
+  NFS4ERR_NOTDIR = 20,
+  NFS4ERR_ISDIR = 21,
+  NFS4ERR_INVAL = 22,
+  NFS4ERR_FBIG = 27,
+  NFS4ERR_NOSPC = 28,
+  NFS4ERR_ROFS = 30,
+  NFS4ERR_MLINK = 31,
+  NFS4ERR_NAMETOOLONG = 63,
+  NFS4ERR_NOTEMPTY = 66,
+  NFS4ERR_DQUOT = 69,
+  NFS4ERR_STALE = 70,
+  NFS4ERR_BADHANDLE = 10001,
+  NFS4ERR_BAD_COOKIE = 10003,
+  NFS4ERR_NOTSUPP = 10004,
+  NFS4ERR_TOOSMALL = 10005,
+  NFS4ERR_SERVERFAULT = 10006,
+  NFS4ERR_BADTYPE = 10007,
+  NFS4ERR_DELAY = 10008,
+  NFS4ERR_NOFILEHANDLE = 10020,
+  NFS4ERR_MINOR_VERS_MISMATCH = 10021,
+  NFS4ERR_STALE_CLIENTID = 10022,
+  NFS4ERR_BAD_STATEID = 10025,
+  NFS4ERR_NOT_SAME = 10027,
+  NFS4ERR_SYMLINK = 10029,
+  NFS4ERR_RESTOREFH = 10030,
+  NFS4ERR_BADNAME = 10041,
+  NFS4ERR_OP_ILLEGAL = 10044,
+  NFS4ERR_BADSESSION = 10052,
+  NFS4ERR_BADSLOT = 10053,
+  NFS4ERR_COMPLETE_ALREADY = 10054,
+  NFS4ERR_SEQ_MISORDERED = 10063,
+  NFS4ERR_SEQUENCE_POS = 10064,
+  NFS4ERR_TOO_MANY_OPS = 10070,
+  NFS4ERR_OP_NOT_IN_SESSION = 10071,
+  NFS4ERR_CLIENTID_BUSY = 10074,
+  NFS4ERR_NOT_ONLY_OP = 10081,
+  NFS4ERR_WRONG_TYPE = 10083,
+};
+
+namespace detail {
+
+/**
+ * Shorthand struct to inherit from for variant over nfsstat4, similar to
+ * Nfsstat3Variant. The results of NFSv4 operations have no data on failure.
+ */
+template <typename ResOkT>
+struct Nfsstat4Variant : public XdrVariant<nfsstat4, ResOkT> {
+  using ResOk = ResOkT;
+};
+
+} // namespace detail
+
+template <typename T>
+struct XdrTrait<
+    T,
+    std::enable_if_t<
+        std::is_base_of_v<detail::Nfsstat4Variant<typename T::ResOk>, T>>>
+    : public XdrTrait<typename T::Base> {
+  static T deserialize(folly::io::Cursor& cursor) {
+    T ret;
+    ret.tag = XdrTrait<nfsstat4>::deserialize(cursor);
+    if (ret.tag == nfsstat4::NFS4_OK) {
+      ret.v = XdrTrait<typename T::ResOk>::deserialize(cursor);
+    }
+    return ret;
+  }
+};
+
+/**
+ * File handles are the same as the NFSv3 ones: the inode number.
+ */
+using nfs_fh4 = nfs_fh3;
+
+constexpr inline size_t NFS4_VERIFIER_SIZE = 8;
+using verifier4 = std::array<uint8_t, NFS4_VERIFIER_SIZE>;
+
+constexpr inline size_t NFS4_SESSIONID_SIZE = 16;
+using sessionid4 = std::array<uint8_t, NFS4_SESSIONID_SIZE>;
+
+/**
+ * Set of attributes, bit N of word N / 32 standing for attribute N.
+ */
+using bitmap4 = std::vector<uint32_t>;
+
+enum class nfs_ftype4 : uint32_t {
+  NF4REG = 1,
+  NF4DIR = 2,
+  NF4BLK = 3,
+  NF4CHR = 4,
+  NF4LNK = 5,
+  NF4SOCK = 6,
+  NF4FIFO = 7,
+};
+
+/**
+ * Attribute numbers.
+ */
+enum class fattr4_attr : uint32_t {
+  supported_attrs = 0,
+  type = 1,
+  fh_expire_type = 2,
+  change = 3,
+  size = 4,
+  link_support = 5,
+  symlink_support = 6,
+  named_attr = 7,
+  fsid = 8,
+  unique_handles = 9,
+  lease_time = 10,
+  rdattr_error = 11,
+  cansettime = 15,
+  case_insensitive = 16,
+  case_preserving = 17,
+  chown_restricted = 18,
+  filehandle = 19,
+  fileid = 20,
+  maxfilesize = 27,
+  maxlink = 28,
+  maxname = 29,
+  maxread = 30,
+  maxwrite = 31,
+  mode = 33,
+  numlinks = 35,
+  owner = 36,
+  owner_group = 37,
+  rawdev = 41,
+  space_used = 45,
+  time_access = 47,
+  time_delta = 51,
+  time_metadata = 52,
+  time_modify = 53,
+  mounted_on_fileid = 55,
+  suppattr_exclcreat = 75,
+};
+
+struct nfstime4 {
+  int64_t seconds;
+  uint32_t nseconds;
+};
+EDEN_XDR_SERDE_DECL(nfstime4, seconds, nseconds);
+
+struct fsid4 {
+  uint64_t major;
+  uint64_t minor;
+};
+EDEN_XDR_SERDE_DECL(fsid4, major, minor);
+
+struct specdata4 {
+  uint32_t specdata1;
+  uint32_t specdata2;
+};
+EDEN_XDR_SERDE_DECL(specdata4, specdata1, specdata2);
+
+/**
+ * The attributes in attrmask, XDR encoded one after the other by increasing
+ * attribute number in attr_vals.
+ */
+struct fattr4 {
+  bitmap4 attrmask;
+  std::vector<uint8_t> attr_vals;
+};
+EDEN_XDR_SERDE_DECL(fattr4, attrmask, attr_vals);
+
+struct stateid4 {
+  uint32_t seqid;
+  std::array<uint8_t, 12> other;
+};
+EDEN_XDR_SERDE_DECL(stateid4, seqid, other);
+
+// ACCESS Operation:
+
+struct ACCESS4args {
+  uint32_t access;
+};
+EDEN_XDR_SERDE_DECL(ACCESS4args, access);
+
+struct ACCESS4resok {
+  uint32_t supported;
+  uint32_t access;
+};
+EDEN_XDR_SERDE_DECL(ACCESS4resok, supported, access);
+
+struct ACCESS4res : public detail::Nfsstat4Variant<ACCESS4resok> {};
+
+// GETATTR Operation:
+
+struct GETATTR4args {
+  bitmap4 attr_request;
+};
+EDEN_XDR_SERDE_DECL(GETATTR4args, attr_request);
+
+struct GETATTR4resok {
+  fattr4 obj_attributes;
+};
+EDEN_XDR_SERDE_DECL(GETATTR4resok, obj_attributes);
+
+struct GETATTR4res : public detail::Nfsstat4Variant<GETATTR4resok> {};
+
+// GETFH Operation:
+
+struct GETFH4resok {
+  nfs_fh4 object;
+};
+EDEN_XDR_SERDE_DECL(GETFH4resok, object);
+
+struct GETFH4res : public detail::Nfsstat4Variant<GETFH4resok> {};
+
+// LOOKUP Operation:
+
+struct LOOKUP4args {
+  std::string objname;
+};
+EDEN_XDR_SERDE_DECL(LOOKUP4args, objname);
+
+// PUTFH Operation:
+
+struct PUTFH4args {
+  nfs_fh4 object;
+};
+EDEN_XDR_SERDE_DECL(PUTFH4args, object);
+
+// READ Operation:
+
+struct READ4args {
+  stateid4 stateid;
+  uint64_t offset;
+  uint32_t count;
+};
+EDEN_XDR_SERDE_DECL(READ4args, stateid, offset, count);
+
+struct READ4resok {
+  bool eof;
+  std::unique_ptr<folly::IOBuf> data;
+};
+EDEN_XDR_SERDE_DECL(READ4resok, eof, data);
+
+struct READ4res : public detail::Nfsstat4Variant<READ4resok> {};
+
+// READDIR Operation:
+
+struct READDIR4args {
+  uint64_t cookie;
+  verifier4 cookieverf;
+  uint32_t dircount;
+  uint32_t maxcount;
+  bitmap4 attr_request;
+};
+EDEN_XDR_SERDE_DECL(
+    READDIR4args,
+    cookie,
+    cookieverf,
+    dircount,
+    maxcount,
+    attr_request);
+
+struct entry4 {
+  uint64_t cookie;
+  std::string name;
+  fattr4 attrs;
+};
+EDEN_XDR_SERDE_DECL(entry4, cookie, name, attrs);
+
+struct dirlist4 {
+  XdrList<entry4> entries;
+  bool eof;
+};
+EDEN_XDR_SERDE_DECL(dirlist4, entries, eof);
+
+struct READDIR4resok {
+  verifier4 cookieverf;
+  dirlist4 reply;
+};
+EDEN_XDR_SERDE_DECL(READDIR4resok, cookieverf, reply);
+
+struct READDIR4res : public detail::Nfsstat4Variant<READDIR4resok> {};
+
+// READLINK Operation:
+
+struct READLINK4resok {
+  std::string link;
+};
+EDEN_XDR_SERDE_DECL(READLINK4resok, link);
+
+struct READLINK4res : public detail::Nfsstat4Variant<READLINK4resok> {};
+
+// EXCHANGE_ID Operation:
+
+struct client_owner4 {
+  verifier4 co_verifier;
+  std::vector<uint8_t> co_ownerid;
+};
+EDEN_XDR_SERDE_DECL(client_owner4, co_verifier, co_ownerid);
+
+enum class state_protect_how4 : uint32_t {
+  SP4_NONE = 0,
+  SP4_MACH_CRED = 1,
+  SP4_SSV = 2,
+};
+
+struct nfs_impl_id4 {
+  std::string nii_domain;
+  std::string nii_name;
+  nfstime4 nii_date;
+};
+EDEN_XDR_SERDE_DECL(nfs_impl_id4, nii_domain, nii_name, nii_date);
+
+struct state_protect_ops4 {
+  bitmap4 spo_must_enforce;
+  bitmap4 spo_must_allow;
+};
+EDEN_XDR_SERDE_DECL(state_protect_ops4, spo_must_enforce, spo_must_allow);
+
+/**
+ * SP4_SSV can't be deserialized, Nfsd4 only accepts SP4_NONE anyway.
+ */
+struct state_protect4_a
+    : public XdrVariant<state_protect_how4, state_protect_ops4> {};
+
+template <>
+struct XdrTrait<state_protect4_a> : public XdrTrait<state_protect4_a::Base> {
+  static state_protect4_a deserialize(folly::io::Cursor& cursor) {
+    state_protect4_a ret;
+    ret.tag = XdrTrait<state_protect_how4>::deserialize(cursor);
+    switch (ret.tag) {
+      case state_protect_how4::SP4_NONE:
+        break;
+      case state_protect_how4::SP4_MACH_CRED:
+        ret.v = XdrTrait<state_protect_ops4>::deserialize(cursor);
+        break;
+      case state_protect_how4::SP4_SSV:
+        throw RpcParsingError{"Unsupported SP4_SSV state protection"};
+    }
+    return ret;
+  }
+};
+
+struct EXCHANGE_ID4args {
+  client_owner4 clientowner;
+  uint32_t flags;
+  state_protect4_a state_protect;
+  std::vector<nfs_impl_id4> client_impl_id;
+};
+EDEN_XDR_SERDE_DECL(
+    EXCHANGE_ID4args,
+    clientowner,
+    flags,
+    state_protect,
+    client_impl_id);
+
+constexpr uint32_t EXCHGID4_FLAG_SUPP_MOVED_REFER = 0x00000001;
+constexpr uint32_t EXCHGID4_FLAG_USE_NON_PNFS = 0x00010000;
+constexpr uint32_t EXCHGID4_FLAG_CONFIRMED_R = 0x80000000;
+
+struct server_owner4 {
+  uint64_t so_minor_id;
+  std::vector<uint8_t> so_major_id;
+};
+EDEN_XDR_SERDE_DECL(server_owner4, so_minor_id, so_major_id);
+
+struct EXCHANGE_ID4resok {
+  uint64_t clientid;
+  uint32_t sequenceid;
+  uint32_t flags;
+  // Always SP4_NONE, the only state_protect4_r without data.
+  state_protect_how4 state_protect;
+  server_owner4 server_owner;
+  std::vector<uint8_t> server_scope;
+  std::vector<nfs_impl_id4> server_impl_id;
+};
+EDEN_XDR_SERDE_DECL(
+    EXCHANGE_ID4resok,
+    clientid,
+    sequenceid,
+    flags,
+    state_protect,
+    server_owner,
+    server_scope,
+    server_impl_id);
+
+struct EXCHANGE_ID4res : public detail::Nfsstat4Variant<EXCHANGE_ID4resok> {};
+
+// CREATE_SESSION Operation:
+
+struct channel_attrs4 {
+  uint32_t headerpadsize;
+  uint32_t maxrequestsize;
+  uint32_t maxresponsesize;
+  uint32_t maxresponsesize_cached;
+  uint32_t maxoperations;
+  uint32_t maxrequests;
+  std::vector<uint32_t> rdma_ird;
+};
+EDEN_XDR_SERDE_DECL(
+    channel_attrs4,
+    headerpadsize,
+    maxrequestsize,
+    maxresponsesize,
+    maxresponsesize_cached,
+    maxoperations,
+    maxrequests,
+    rdma_ird);
+
+/**
+ * The credentials of the backchannel, which Nfsd4 doesn't have. RPCSEC_GSS
+ * isn't supported.
+ */
+struct callback_sec_parms4 : public XdrVariant<auth_flavor, authsys_parms> {};
+
+template <>
+struct XdrTrait<callback_sec_parms4>
+    : public XdrTrait<callback_sec_parms4::Base> {
+  static callback_sec_parms4 deserialize(folly::io::Cursor& cursor) {
+    callback_sec_parms4 ret;
+    ret.tag = XdrTrait<auth_flavor>::deserialize(cursor);
+    switch (ret.tag) {
+      case auth_flavor::AUTH_NONE:
+        break;
+      case auth_flavor::AUTH_SYS:
+        ret.v = XdrTrait<authsys_parms>::deserialize(cursor);
+        break;
+      default:
+        throw RpcParsingError{"Unsupported callback security flavor"};
+    }
+    return ret;
+  }
+};
+
+struct CREATE_SESSION4args {
+  uint64_t clientid;
+  uint32_t sequence;
+  uint32_t flags;
+  channel_attrs4 fore_chan_attrs;
+  channel_attrs4 back_chan_attrs;
+  uint32_t cb_program;
+  std::vector<callback_sec_parms4> sec_parms;
+};
+EDEN_XDR_SERDE_DECL(
+    CREATE_SESSION4args,
+    clientid,
+    sequence,
+    flags,
+    fore_chan_attrs,
+    back_chan_attrs,
+    cb_program,
+    sec_parms);
+
+struct CREATE_SESSION4resok {
+  sessionid4 sessionid;
+  uint32_t sequence;
+  uint32_t flags;
+  channel_attrs4 fore_chan_attrs;
+  channel_attrs4 back_chan_attrs;
+};
+EDEN_XDR_SERDE_DECL(
+    CREATE_SESSION4resok,
+    sessionid,
+    sequence,
+    flags,
+    fore_chan_attrs,
+    back_chan_attrs);
+
+struct CREATE_SESSION4res
+    : public detail::Nfsstat4Variant<CREATE_SESSION4resok> {};
+
+// DESTROY_SESSION Operation:
+
+struct DESTROY_SESSION4args {
+  sessionid4 sessionid;
+};
+EDEN_XDR_SERDE_DECL(DESTROY_SESSION4args, sessionid);
+
+// SECINFO_NO_NAME Operation:
+
+enum class secinfo_style4 : uint32_t {
+  SECINFO_STYLE4_CURRENT_FH = 0,
+  SECINFO_STYLE4_PARENT = 1,
+};
+
+/**
+ * Only the flavors without data, RPCSEC_GSS isn't offered.
+ */
+using SECINFO4resok = std::vector<auth_flavor>;
+
+struct SECINFO_NO_NAME4res : public detail::Nfsstat4Variant<SECINFO4resok> {};
+
+// SEQUENCE Operation:
+
+struct SEQUENCE4args {
+  sessionid4 sessionid;
+  uint32_t sequenceid;
+  uint32_t slotid;
+  uint32_t highest_slotid;
+  bool cachethis;
+};
+EDEN_XDR_SERDE_DECL(
+    SEQUENCE4args,
+    sessionid,
+    sequenceid,
+    slotid,
+    highest_slotid,
+    cachethis);
+
+struct SEQUENCE4resok {
+  sessionid4 sessionid;
+  uint32_t sequenceid;
+  uint32_t slotid;
+  uint32_t highest_slotid;
+  uint32_t target_highest_slotid;
+  uint32_t status_flags;
+};
+EDEN_XDR_SERDE_DECL(
+    SEQUENCE4resok,
+    sessionid,
+    sequenceid,
+    slotid,
+    highest_slotid,
+    target_highest_slotid,
+    status_flags);
+
+struct SEQUENCE4res : public detail::Nfsstat4Variant<SEQUENCE4resok> {};
+
+// DESTROY_CLIENTID Operation:
+
+struct DESTROY_CLIENTID4args {
+  uint64_t clientid;
+};
+EDEN_XDR_SERDE_DECL(DESTROY_CLIENTID4args, clientid);
+
+// RECLAIM_COMPLETE Operation:
+
+struct RECLAIM_COMPLETE4args {
+  bool one_fs;
+};
+EDEN_XDR_SERDE_DECL(RECLAIM_COMPLETE4args, one_fs);
+
+} // namespace facebook::eden
+
+#endif
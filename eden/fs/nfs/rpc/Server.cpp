@@ -9,6 +9,7 @@
 
 #include "eden/fs/nfs/rpc/Server.h"
 
+#include <algorithm>
 #include <tuple>
 
 #include <folly/Exception.h>
@@ -30,20 +31,35 @@ using folly::SocketAddress;
 
 namespace facebook::eden {
 
+namespace {
+constexpr size_t kTcpMaxReadSize = 64 * 1024;
+// A unix socket read is a memory copy: reading whole WRITE requests, and
+// many pipelined requests at once, saves wakeups of the EventBase.
+constexpr size_t kUnixSocketMaxReadSize = 1024 * 1024;
+// Large enough for the client to pipeline many requests, and for the
+// replies to a batch of READs, without blocking on the socket.
+constexpr size_t kUnixSocketBufferSize = 4 * 1024 * 1024;
+} // namespace
+
 RpcTcpHandler::Reader::Reader(RpcTcpHandler* handler)
     : handler_(handler), guard_(handler_) {}
 
 void RpcTcpHandler::Reader::getReadBuffer(void** bufP, size_t* lenP) {
   // TODO(xavierd): Should maxSize be configured to be at least the
   // configured NFS iosize?
-  constexpr size_t maxSize = 64 * 1024;
+  const size_t maxSize =
+      handler_->isUnixSocket_ ? kUnixSocketMaxReadSize : kTcpMaxReadSize;
   constexpr size_t minReadSize = 4 * 1024;
 
   // We want to issue a recv(2) of at least minReadSize, and bound it to
   // the available writable size of the readBuf_ to minimize allocation
   // cost. This guarantees reading large buffers, and minimize the number
-  // of calls to tryConsumeReadBuffer.
-  auto minSize = std::max(handler_->readBuf_.tailroom(), minReadSize);
+  // of calls to tryConsumeReadBuffer. When the end of a partial request is
+  // known to be further away, read up to it at once.
+  auto minSize = std::max(
+      {handler_->readBuf_.tailroom(),
+       minReadSize,
+       std::min(handler_->missingRequestBytes_, maxSize)});
 
   auto [buf, len] = handler_->readBuf_.preallocate(minSize, maxSize);
   *lenP = len;
@@ -103,6 +119,10 @@ void RpcTcpHandler::Writer::writeErr(
   XLOG(ERR) << "Error while writing: " << folly::exceptionStr(ex);
 }
 
+void RpcTcpHandler::ReplyFlusher::runLoopCallback() noexcept {
+  handler_->flushReplies();
+}
+
 RpcTcpHandler::RpcTcpHandler(
     std::shared_ptr<RpcServerProcessor> proc,
     AsyncSocket::UniquePtr&& socket,
@@ -116,6 +136,21 @@ RpcTcpHandler::RpcTcpHandler(
       reader_(std::make_unique<Reader>(this)),
       state_(sock_->getEventBase()),
       owningServer_(std::move(owningServer)) {
+  folly::SocketAddress localAddr;
+  try {
+    sock_->getLocalAddress(&localAddr);
+    isUnixSocket_ = localAddr.getFamily() == AF_UNIX;
+  } catch (const std::exception& ex) {
+    XLOG(DBG3) << "Unable to get the socket address: "
+               << folly::exceptionStr(ex);
+  }
+  if (isUnixSocket_) {
+    // Best effort: the defaults still work, only slower.
+    if (sock_->setSendBufSize(kUnixSocketBufferSize) != 0 ||
+        sock_->setRecvBufSize(kUnixSocketBufferSize) != 0) {
+      XLOG(DBG3) << "Unable to grow the unix socket buffers";
+    }
+  }
   sock_->setReadCB(reader_.get());
   proc_->clientConnected();
 }
@@ -198,6 +233,10 @@ folly::SemiFuture<folly::Unit> RpcTcpHandler::resetReader(
           owningServer->unregisterRpcHandler(this);
         }
 
+        // Replies corked in this loop iteration must reach the client
+        // before the socket is handed over.
+        this->flushReplies();
+
         RpcStopData data{};
         data.reason = stopReason;
         if (stopReason == RpcStopReason::TAKEOVER) {
@@ -269,6 +308,7 @@ void RpcTcpHandler::tryConsumeReadBuffer() noexcept {
 }
 
 std::unique_ptr<folly::IOBuf> RpcTcpHandler::readOneRequest() noexcept {
+  missingRequestBytes_ = 0;
   if (!readBuf_.front()) {
     return nullptr;
   }
@@ -283,6 +323,7 @@ std::unique_ptr<folly::IOBuf> RpcTcpHandler::readOneRequest() noexcept {
     bool isLast = (fragmentHeader & 0x80000000) != 0;
     if (!c.canAdvance(len)) {
       // we don't have a complete request, so try again later
+      missingRequestBytes_ = len - c.totalLength();
       return nullptr;
     }
     c.skip(len);
@@ -293,6 +334,20 @@ std::unique_ptr<folly::IOBuf> RpcTcpHandler::readOneRequest() noexcept {
   return readBuf_.split(c.getCurrentPosition());
 }
 
+void RpcTcpHandler::queueReply(std::unique_ptr<folly::IOBuf> reply) {
+  pendingReplies_.append(std::move(reply));
+  if (!replyFlusher_.isLoopCallbackScheduled()) {
+    sock_->getEventBase()->runInLoop(&replyFlusher_);
+  }
+}
+
+void RpcTcpHandler::flushReplies() {
+  replyFlusher_.cancelLoopCallback();
+  if (auto replies = pendingReplies_.move()) {
+    sock_->writeChain(&writer_, std::move(replies));
+  }
+}
+
 namespace {
 void serializeRpcMismatch(folly::io::QueueAppender& ser, uint32_t xid) {
   rpc_msg_reply reply{
@@ -451,8 +506,8 @@ void RpcTcpHandler::dispatchAndReply(
           // XXX: This should never happen.
         } else {
           auto resultBuffer = std::move(result).value();
-          XLOG(DBG7) << "About to write to the socket.";
-          sock_->writeChain(&writer_, std::move(resultBuffer));
+          XLOG(DBG7) << "Queueing the reply.";
+          queueReply(std::move(resultBuffer));
         }
       })
       .ensure([this, guard = std::move(guard)]() {
@@ -529,71 +584,90 @@ void RpcServerProcessor::clientConnected() {}
 std::shared_ptr<RpcServer> RpcServer::create(
     std::shared_ptr<RpcServerProcessor> proc,
     folly::EventBase* evb,
+    std::vector<folly::EventBase*> connectionEvbs,
     std::shared_ptr<folly::Executor> threadPool,
     const std::shared_ptr<StructuredLogger>& structuredLogger) {
   return std::shared_ptr<RpcServer>{new RpcServer{
-      std::move(proc), evb, std::move(threadPool), structuredLogger}};
+      std::move(proc),
+      evb,
+      std::move(connectionEvbs),
+      std::move(threadPool),
+      structuredLogger}};
 }
 
 RpcServer::RpcServer(
     std::shared_ptr<RpcServerProcessor> proc,
     folly::EventBase* evb,
+    std::vector<folly::EventBase*> connectionEvbs,
     std::shared_ptr<folly::Executor> threadPool,
     const std::shared_ptr<StructuredLogger>& structuredLogger)
     : evb_(evb),
+      connectionEvbs_(std::move(connectionEvbs)),
       threadPool_(threadPool),
       structuredLogger_(structuredLogger),
-      acceptCb_(nullptr),
+      acceptCbs_{},
       serverSocket_(new AsyncServerSocket(evb_)),
       proc_(std::move(proc)),
-      rpcTcpHandlers_{} {}
+      rpcTcpHandlers_{} {
+  if (connectionEvbs_.empty()) {
+    connectionEvbs_.push_back(evb_);
+  }
+}
 
-void RpcServer::initialize(folly::SocketAddress addr) {
-  acceptCb_.reset(new RpcServer::RpcAcceptCallback{
-      proc_,
-      evb_,
-      threadPool_,
-      structuredLogger_,
-      std::weak_ptr<RpcServer>{shared_from_this()}});
+void RpcServer::startAccepting() {
+  for (auto* connectionEvb : connectionEvbs_) {
+    acceptCbs_.emplace_back(new RpcServer::RpcAcceptCallback{
+        proc_,
+        connectionEvb,
+        threadPool_,
+        structuredLogger_,
+        std::weak_ptr<RpcServer>{shared_from_this()}});
+    // Connections accepted by this callback are delivered on connectionEvb,
+    // so their AsyncSocket is created and driven there rather than on evb_.
+    serverSocket_->addAcceptCallback(acceptCbs_.back().get(), connectionEvb);
+  }
+  serverSocket_->startAccepting();
+}
 
+void RpcServer::initialize(folly::SocketAddress addr) {
   // Ask kernel to assign us a port on the loopback interface
   serverSocket_->bind(addr);
   serverSocket_->listen(1024);
 
-  serverSocket_->addAcceptCallback(acceptCb_.get(), evb_);
-  serverSocket_->startAccepting();
+  startAccepting();
 }
 
 void RpcServer::initialize(folly::File&& socket, InitialSocketType type) {
   switch (type) {
-    case InitialSocketType::CONNECTED_SOCKET:
+    case InitialSocketType::CONNECTED_SOCKET: {
       XLOG(DBG7) << "Initializing server from connected socket: "
                  << socket.fd();
       // Note we don't initialize the accepting socket in this case. This is
       // meant for server that only ever has one connected socket (nfsd3). Since
       // we already have the one connected socket, we will not need the
       // accepting socket to make any more connections.
-      rpcTcpHandlers_.wlock()->emplace_back(RpcTcpHandler::create(
-          proc_,
-          AsyncSocket::newSocket(
-              evb_, folly::NetworkSocket::fromFd(socket.release())),
-          threadPool_,
-          structuredLogger_,
-          shared_from_this()));
+      //
+      // The socket must be created and have its read callback installed on
+      // the EventBase it will live on.
+      auto* connectionEvb = connectionEvbs_.front();
+      auto fd = folly::NetworkSocket::fromFd(socket.release());
+      connectionEvb->runImmediatelyOrRunInEventBaseThreadAndWait(
+          [this, connectionEvb, fd] {
+            rpcTcpHandlers_.wlock()->emplace_back(RpcTcpHandler::create(
+                proc_,
+                AsyncSocket::newSocket(connectionEvb, fd),
+                threadPool_,
+                structuredLogger_,
+                shared_from_this()));
+          });
       return;
+    }
     case InitialSocketType::SERVER_SOCKET:
       XLOG(DBG7) << "Initializing server from server socket: " << socket.fd();
-      acceptCb_.reset(new RpcServer::RpcAcceptCallback{
-          proc_,
-          evb_,
-          threadPool_,
-          structuredLogger_,
-          std::weak_ptr<RpcServer>{shared_from_this()}});
       serverSocket_->useExistingSocket(
           folly::NetworkSocket::fromFd(socket.release()));
 
-      serverSocket_->addAcceptCallback(acceptCb_.get(), evb_);
-      serverSocket_->startAccepting();
+      startAccepting();
       return;
   }
   throw std::runtime_error("Impossible socket type.");
@@ -618,9 +692,10 @@ void RpcServer::unregisterRpcHandler(RpcTcpHandler* handlerToErase) {
 folly::SemiFuture<folly::File> RpcServer::takeoverStop() {
   evb_->dcheckIsInEventBaseThread();
 
-  XLOG(DBG7) << "Removing accept callback";
-  if (acceptCb_) {
-    serverSocket_->removeAcceptCallback(acceptCb_.get(), evb_);
+  XLOG(DBG7) << "Removing accept callbacks";
+  for (size_t i = 0; i < acceptCbs_.size(); ++i) {
+    serverSocket_->removeAcceptCallback(
+        acceptCbs_[i].get(), connectionEvbs_[i]);
   }
   // implicitly pauses accepting on the socket.
   // not more connections will be made after this point.
@@ -637,7 +712,13 @@ folly::SemiFuture<folly::File> RpcServer::takeoverStop() {
   std::vector<folly::SemiFuture<folly::Unit>> futures{};
   futures.reserve(handlers.size());
   for (auto& handler : handlers) {
-    futures.emplace_back(handler->takeoverStop());
+    // Handlers may live on any of the connection EventBases, and must be
+    // stopped on theirs. The handler is released there too, once it is done.
+    auto* handlerEvb = handler->getEventBase();
+    futures.emplace_back(folly::via(
+        handlerEvb, [handler = std::move(handler)]() mutable {
+          return handler->takeoverStop();
+        }));
   }
   return collectAll(futures)
       .via(evb_) // make sure we are running on the eventbase to do some more
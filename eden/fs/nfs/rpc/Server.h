@@ -14,6 +14,7 @@
 #include <folly/SocketAddress.h>
 #include <folly/io/async/AsyncServerSocket.h>
 #include <folly/io/async/AsyncSocket.h>
+#include <folly/io/async/EventBase.h>
 #include <folly/net/NetworkSocket.h>
 
 #include "eden/fs/nfs/portmap/PortmapClient.h"
@@ -100,6 +101,13 @@ class RpcTcpHandler : public folly::DelayedDestruction {
    */
   folly::SemiFuture<folly::Unit> takeoverStop();
 
+  /**
+   * Return the EventBase that the socket, and thus this handler, lives on.
+   */
+  folly::EventBase* getEventBase() const {
+    return sock_->getEventBase();
+  }
+
  private:
   RpcTcpHandler(
       std::shared_ptr<RpcServerProcessor> proc,
@@ -150,6 +158,20 @@ class RpcTcpHandler : public folly::DelayedDestruction {
         const folly::AsyncSocketException& ex) noexcept override;
   };
 
+  /**
+   * Writes the replies queued during an EventBase loop iteration at its end,
+   * with a single write.
+   */
+  class ReplyFlusher : public folly::EventBase::LoopCallback {
+   public:
+    explicit ReplyFlusher(RpcTcpHandler* handler) : handler_(handler) {}
+
+   private:
+    void runLoopCallback() noexcept override;
+
+    RpcTcpHandler* handler_;
+  };
+
   /**
    * Parse the buffer that was just read from the socket. Complete RPC buffers
    * will be dispatched to the RpcServerProcessor.
@@ -173,6 +195,25 @@ class RpcTcpHandler : public folly::DelayedDestruction {
    */
   std::unique_ptr<folly::IOBuf> readOneRequest() noexcept;
 
+  /**
+   * Queue a reply to be written to the socket.
+   *
+   * Replies that complete during the same EventBase loop iteration are
+   * corked together and written with one writev(2), instead of one write
+   * each: a client sending many concurrent LOOKUPs gets their replies in a
+   * handful of system calls.
+   *
+   * This must be called on the main event base of the socket.
+   */
+  void queueReply(std::unique_ptr<folly::IOBuf> reply);
+
+  /**
+   * Write all the queued replies to the socket.
+   *
+   * This must be called on the main event base of the socket.
+   */
+  void flushReplies();
+
   /**
    * Dispatch the RPC request contained in the input buffer to the
    * RpcServerProcessor.
@@ -235,8 +276,27 @@ class RpcTcpHandler : public folly::DelayedDestruction {
    */
   Writer writer_{};
 
+  /**
+   * Replies waiting for replyFlusher_ to write them.
+   */
+  folly::IOBufQueue pendingReplies_{folly::IOBufQueue::cacheChainLength()};
+  ReplyFlusher replyFlusher_{this};
+
   folly::IOBufQueue readBuf_{folly::IOBufQueue::cacheChainLength()};
 
+  /**
+   * Number of bytes still missing from the partial request at the end of
+   * readBuf_, 0 when unknown. Used to read large requests, like WRITEs, in
+   * as few reads as possible.
+   */
+  size_t missingRequestBytes_{0};
+
+  /**
+   * Unix sockets are only used by local clients, and can afford larger
+   * reads and socket buffers than TCP ones.
+   */
+  bool isUnixSocket_{false};
+
   /**
    * Status for the rpc connection. The State may only be accessed from the
    * socket's eventbase thread. We use this invariant so that we don't have to
@@ -296,12 +356,17 @@ class RpcServer : public std::enable_shared_from_this<RpcServer> {
   /**
    * Create an RPC server.
    *
-   * Request will be received on the passed EventBase and dispatched to the
-   * RpcServerProcessor on the passed in threadPool.
+   * The server socket is owned by, and connections are accepted on, the
+   * passed EventBase. Each connected socket is then handed to one of the
+   * connectionEvbs, round-robin, which reads and frames its requests and
+   * writes its replies; an empty connectionEvbs keeps every connection on
+   * evb. Requests are decoded and dispatched to the RpcServerProcessor on
+   * the passed in threadPool.
    */
   static std::shared_ptr<RpcServer> create(
       std::shared_ptr<RpcServerProcessor> proc,
       folly::EventBase* evb,
+      std::vector<folly::EventBase*> connectionEvbs,
       std::shared_ptr<folly::Executor> threadPool,
       const std::shared_ptr<StructuredLogger>& structuredLogger);
 
@@ -355,9 +420,16 @@ class RpcServer : public std::enable_shared_from_this<RpcServer> {
   RpcServer(
       std::shared_ptr<RpcServerProcessor> proc,
       folly::EventBase* evb,
+      std::vector<folly::EventBase*> connectionEvbs,
       std::shared_ptr<folly::Executor> threadPool,
       const std::shared_ptr<StructuredLogger>& structuredLogger);
 
+  /**
+   * Register one RpcAcceptCallback per connection EventBase with the server
+   * socket and start accepting. Must be called on evb_.
+   */
+  void startAccepting();
+
   class RpcAcceptCallback : public folly::AsyncServerSocket::AcceptCallback,
                             public folly::DelayedDestruction {
    public:
@@ -407,14 +479,20 @@ class RpcServer : public std::enable_shared_from_this<RpcServer> {
   // on the socket.
   folly::EventBase* evb_;
 
+  // event bases that connected sockets are spread over. Never empty: it
+  // defaults to just evb_.
+  std::vector<folly::EventBase*> connectionEvbs_;
+
   // Threadpool for processing requests off the main event base.
   std::shared_ptr<folly::Executor> threadPool_;
 
   // Logger for logging anomalous things to Scuba
   std::shared_ptr<StructuredLogger> structuredLogger_;
 
-  // will be called when clients connect to the server socket.
-  RpcAcceptCallback::UniquePtr acceptCb_;
+  // will be called when clients connect to the server socket, one per entry
+  // in connectionEvbs_. The AsyncServerSocket distributes accepted
+  // connections round-robin over them.
+  std::vector<RpcAcceptCallback::UniquePtr> acceptCbs_;
 
   // listening socket for this server.
   folly::AsyncServerSocket::UniquePtr serverSocket_;
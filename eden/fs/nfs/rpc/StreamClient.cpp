@@ -11,6 +11,7 @@
 
 #include <folly/Exception.h>
 #include <folly/logging/xlog.h>
+#include <algorithm>
 #include "eden/fs/nfs/rpc/Rpc.h"
 
 using folly::IOBuf;
@@ -26,7 +27,9 @@ void StreamClient::connect() {
   sockaddr_storage socketAddress;
   auto len = addr_.getAddress(&socketAddress);
 
-  s_ = folly::netops::socket(addr_.getFamily(), SOCK_STREAM, IPPROTO_TCP);
+  // Unix sockets have no protocol to pick.
+  auto protocol = addr_.getFamily() == AF_UNIX ? 0 : IPPROTO_TCP;
+  s_ = folly::netops::socket(addr_.getFamily(), SOCK_STREAM, protocol);
   folly::checkUnixError(
       folly::netops::connect(s_, (sockaddr*)&socketAddress, len), "connect");
 }
@@ -110,7 +113,8 @@ StreamClient::receiveChunk() {
     while (fragLen > 0) {
       auto [buf, bufLen] = readBuf_.preallocate(fragLen, 4096, 8192);
 
-      len = folly::netops::recv(s_, buf, bufLen, 0);
+      // Don't read past the fragment, it may be followed by another reply.
+      len = folly::netops::recv(s_, buf, std::min<size_t>(bufLen, fragLen), 0);
       folly::checkUnixError(len, "recv failed");
       readBuf_.postallocate(len);
       fragLen -= len;
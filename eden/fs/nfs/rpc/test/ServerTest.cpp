@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/nfs/rpc/Server.h"
+
+#include <folly/Synchronized.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/portability/GTest.h>
+#include <folly/testing/TestUtil.h>
+#include <set>
+
+#include "eden/fs/nfs/rpc/StreamClient.h"
+#include "eden/fs/telemetry/NullStructuredLogger.h"
+
+namespace facebook::eden {
+namespace {
+
+constexpr uint32_t kTestProgNumber = 0x20000000;
+constexpr uint32_t kTestProgVersion = 1;
+
+/**
+ * Replies successfully to every call with an empty result, and remembers
+ * which EventBase each client connection was set up on.
+ */
+class RecordingProcessor : public RpcServerProcessor {
+ public:
+  ImmediateFuture<folly::Unit> dispatchRpc(
+      folly::io::Cursor /*deser*/,
+      folly::io::QueueAppender ser,
+      uint32_t xid,
+      uint32_t /*progNumber*/,
+      uint32_t /*progVersion*/,
+      uint32_t /*procNumber*/) override {
+    serializeReply(ser, accept_stat::SUCCESS, xid);
+    return folly::unit;
+  }
+
+  void clientConnected() override {
+    connectionEvbs.wlock()->push_back(
+        folly::EventBase::getCurrentEventBase());
+  }
+
+  folly::Synchronized<std::vector<folly::EventBase*>> connectionEvbs;
+};
+
+} // namespace
+
+TEST(RpcServerTest, connectionsAreSpreadOverEventBases) {
+  folly::ScopedEventBaseThread mainThread;
+  folly::ScopedEventBaseThread ioThread1;
+  folly::ScopedEventBaseThread ioThread2;
+  auto* mainEvb = mainThread.getEventBase();
+
+  auto proc = std::make_shared<RecordingProcessor>();
+  auto server = RpcServer::create(
+      proc,
+      mainEvb,
+      {ioThread1.getEventBase(), ioThread2.getEventBase()},
+      std::make_shared<folly::CPUThreadPoolExecutor>(2),
+      std::make_shared<NullStructuredLogger>());
+  mainEvb->runInEventBaseThreadAndWait(
+      [&] { server->initialize(folly::SocketAddress{"127.0.0.1", 0}); });
+
+  std::vector<std::unique_ptr<StreamClient>> clients;
+  for (int i = 0; i < 2; ++i) {
+    clients.push_back(std::make_unique<StreamClient>(server->getAddr()));
+    clients.back()->connect();
+  }
+  // A round trip guarantees that the server set up the connection.
+  for (auto& client : clients) {
+    auto [call, appender] =
+        client->serializeCallHeader(kTestProgNumber, kTestProgVersion, 0);
+    auto xid = client->fillFrameAndSend(std::move(call));
+    auto [reply, cursor, gotXid] = client->receiveChunk();
+    EXPECT_EQ(xid, gotXid);
+  }
+
+  auto evbs = proc->connectionEvbs.copy();
+  ASSERT_EQ(2u, evbs.size());
+  EXPECT_NE(evbs[0], evbs[1]);
+  for (auto* evb : evbs) {
+    EXPECT_TRUE(
+        evb == ioThread1.getEventBase() || evb == ioThread2.getEventBase());
+  }
+
+  auto stopFuture = folly::makeSemiFuture(folly::File{});
+  mainEvb->runInEventBaseThreadAndWait(
+      [&] { stopFuture = server->takeoverStop(); });
+  auto serverSocket = std::move(stopFuture).via(mainEvb).get();
+  // The server still owns the descriptor, don't close it twice.
+  EXPECT_NE(-1, serverSocket.release());
+
+  mainEvb->runInEventBaseThreadAndWait([&] { server.reset(); });
+}
+
+TEST(RpcServerTest, pipelinedCallsOnUnixSocketAreAllAnswered) {
+  folly::ScopedEventBaseThread mainThread;
+  auto* mainEvb = mainThread.getEventBase();
+  folly::test::TemporaryDirectory tempDir;
+
+  auto server = RpcServer::create(
+      std::make_shared<RecordingProcessor>(),
+      mainEvb,
+      {},
+      std::make_shared<folly::CPUThreadPoolExecutor>(4),
+      std::make_shared<NullStructuredLogger>());
+  auto addr = folly::SocketAddress::makeFromPath(
+      (tempDir.path() / "rpc.socket").string());
+  mainEvb->runInEventBaseThreadAndWait([&] { server->initialize(addr); });
+
+  StreamClient client{server->getAddr()};
+  client.connect();
+
+  // Sent before reading any reply: the replies are corked together.
+  constexpr size_t kNumCalls = 100;
+  std::set<uint32_t> xids;
+  for (size_t i = 0; i < kNumCalls; ++i) {
+    auto [call, appender] =
+        client.serializeCallHeader(kTestProgNumber, kTestProgVersion, 0);
+    xids.insert(client.fillFrameAndSend(std::move(call)));
+  }
+  std::set<uint32_t> gotXids;
+  for (size_t i = 0; i < kNumCalls; ++i) {
+    auto [reply, cursor, gotXid] = client.receiveChunk();
+    gotXids.insert(gotXid);
+  }
+  EXPECT_EQ(xids, gotXids);
+
+  auto stopFuture = folly::makeSemiFuture(folly::File{});
+  mainEvb->runInEventBaseThreadAndWait(
+      [&] { stopFuture = server->takeoverStop(); });
+  auto serverSocket = std::move(stopFuture).via(mainEvb).get();
+  EXPECT_NE(-1, serverSocket.release());
+
+  mainEvb->runInEventBaseThreadAndWait([&] { server.reset(); });
+}
+
+} // namespace facebook::eden
+
+#endif
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/nfs/GatheredWrites.h"
+
+#include <folly/portability/GTest.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace facebook::eden {
+
+namespace {
+void add(GatheredWrites& writes, uint64_t offset, folly::StringPiece data) {
+  writes.add(offset, folly::IOBuf::copyBuffer(data));
+}
+
+std::vector<std::pair<uint64_t, std::string>> extract(GatheredWrites& writes) {
+  std::vector<std::pair<uint64_t, std::string>> extents;
+  for (auto& extent : writes.extract()) {
+    extents.emplace_back(
+        extent.offset, extent.data->moveToFbString().toStdString());
+  }
+  return extents;
+}
+} // namespace
+
+TEST(GatheredWritesTest, coalescesSequentialWrites) {
+  GatheredWrites writes;
+  EXPECT_TRUE(writes.empty());
+  add(writes, 10, "abc");
+  add(writes, 13, "def");
+  add(writes, 16, "g");
+  EXPECT_EQ(7, writes.getBufferedBytes());
+  EXPECT_EQ(17, writes.getEnd());
+
+  std::vector<std::pair<uint64_t, std::string>> expected{{10, "abcdefg"}};
+  EXPECT_EQ(expected, extract(writes));
+  EXPECT_TRUE(writes.empty());
+  EXPECT_EQ(0, writes.getBufferedBytes());
+}
+
+TEST(GatheredWritesTest, keepsDisjointWritesApart) {
+  GatheredWrites writes;
+  add(writes, 20, "late");
+  add(writes, 0, "early");
+  EXPECT_EQ(9, writes.getBufferedBytes());
+  EXPECT_EQ(24, writes.getEnd());
+
+  std::vector<std::pair<uint64_t, std::string>> expected{
+      {0, "early"}, {20, "late"}};
+  EXPECT_EQ(expected, extract(writes));
+}
+
+TEST(GatheredWritesTest, lastOverlappingWriteWins) {
+  GatheredWrites writes;
+  add(writes, 0, "aaaa");
+  add(writes, 6, "bbbb");
+  // Fills the gap, overwriting the end of the first extent and the start of
+  // the second.
+  add(writes, 2, "XXXXXX");
+  EXPECT_EQ(10, writes.getBufferedBytes());
+
+  // Entirely within an extent.
+  add(writes, 4, "Y");
+  // Ignored.
+  add(writes, 0, "");
+  add(writes, 10, "c");
+
+  std::vector<std::pair<uint64_t, std::string>> expected{{0, "aaXXYXXXbbc"}};
+  EXPECT_EQ(expected, extract(writes));
+}
+
+} // namespace facebook::eden
+
+#endif
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/nfs/Nfsd4Rpc.h"
+#include <folly/io/Cursor.h>
+#include <folly/portability/GTest.h>
+#include <sys/stat.h>
+#include "eden/fs/nfs/NfsUtils.h"
+#include "eden/fs/nfs/testharness/XdrTestUtils.h"
+
+namespace facebook::eden {
+
+struct Res4Ok {
+  int a;
+};
+EDEN_XDR_SERDE_DECL(Res4Ok, a);
+EDEN_XDR_SERDE_IMPL(Res4Ok, a);
+
+struct Res4Variant : public detail::Nfsstat4Variant<Res4Ok> {};
+
+TEST(Nfsd4RpcTest, variant) {
+  Res4Variant var1{{{nfsstat4::NFS4_OK, Res4Ok{42}}}};
+  roundtrip(var1);
+
+  Res4Variant var2{{{nfsstat4::NFS4ERR_BADSESSION, std::monostate{}}}};
+  roundtrip(var2);
+}
+
+TEST(Nfsd4RpcTest, sequence) {
+  SEQUENCE4args args{{1, 2, 3, 4, 5, 6, 7, 8, 9, 10}, 42, 3, 7, true};
+  roundtrip(args);
+}
+
+TEST(Nfsd4RpcTest, fattr4OnlyHoldsRequestedAndSupportedAttributes) {
+  struct stat st {};
+  st.st_mode = S_IFREG | 0644;
+  st.st_size = 1234;
+  st.st_ino = 42;
+
+  // type, size, fileid and hidden, which isn't supported.
+  bitmap4 requested{(1u << 1) | (1u << 4) | (1u << 13) | (1u << 20)};
+
+  auto attrs = statToFattr4(
+      st, requested, Nfs4FsProperties{1024, CaseSensitivity::Sensitive, 90});
+
+  bitmap4 expectedMask{(1u << 1) | (1u << 4) | (1u << 20)};
+  EXPECT_EQ(expectedMask, attrs.attrmask);
+
+  // The values are in the order of the attribute numbers.
+  auto buf = folly::IOBuf::wrapBuffer(
+      attrs.attr_vals.data(), attrs.attr_vals.size());
+  folly::io::Cursor cursor{buf.get()};
+  EXPECT_EQ(nfs_ftype4::NF4REG, XdrTrait<nfs_ftype4>::deserialize(cursor));
+  EXPECT_EQ(1234u, XdrTrait<uint64_t>::deserialize(cursor));
+  EXPECT_EQ(42u, XdrTrait<uint64_t>::deserialize(cursor));
+  EXPECT_TRUE(cursor.isAtEnd());
+}
+
+TEST(Nfsd4RpcTest, rdattrError) {
+  auto attrs = rdattrErrorToFattr4(nfsstat4::NFS4ERR_NOENT);
+  EXPECT_TRUE(hasFattr4(attrs.attrmask, fattr4_attr::rdattr_error));
+  EXPECT_FALSE(hasFattr4(attrs.attrmask, fattr4_attr::type));
+
+  auto buf = folly::IOBuf::wrapBuffer(
+      attrs.attr_vals.data(), attrs.attr_vals.size());
+  folly::io::Cursor cursor{buf.get()};
+  EXPECT_EQ(nfsstat4::NFS4ERR_NOENT, XdrTrait<nfsstat4>::deserialize(cursor));
+  EXPECT_TRUE(cursor.isAtEnd());
+}
+
+} // namespace facebook::eden
+
+#endif
@@ -204,6 +204,11 @@ void serialize_variable(
 /**
  * Serialize an IOBuf chain. This is serialized like a variable sized array,
  * ie: size first, followed by the content and aligned on a 4-byte boundary.
+ *
+ * The content is not copied: the chain is cloned, sharing its buffers, and
+ * appended to the output queue, which the RPC server then hands to the
+ * socket as a single gather-write. Only buffers small enough (up to 4KB) to
+ * fit in the tailroom of the previous buffer are packed into it instead.
  */
 void serialize_iobuf(
     folly::io::QueueAppender& appender,
@@ -139,6 +139,27 @@ TEST(XdrSerialize, iobuf) {
   roundtrip(std::move(buf));
 }
 
+TEST(XdrSerialize, largeIOBufIsReferencedNotCopied) {
+  constexpr size_t kSize = 64 * 1024;
+  auto data = folly::IOBuf::create(kSize);
+  memset(data->writableData(), 'a', kSize);
+  data->append(kSize);
+
+  folly::IOBufQueue queue;
+  folly::io::QueueAppender appender(&queue, 1024);
+  XdrTrait<std::unique_ptr<folly::IOBuf>>::serialize(appender, data);
+  auto encoded = queue.move();
+
+  // One of the buffers of the encoded chain must be the original data.
+  bool found = false;
+  for (const auto& chunk : *encoded) {
+    found = found || chunk.data() == data->data();
+  }
+  EXPECT_TRUE(found);
+  EXPECT_TRUE(data->isShared());
+  EXPECT_EQ(sizeof(uint32_t) + kSize, encoded->computeChainDataLength());
+}
+
 struct ListElement {
   uint32_t value;
 };
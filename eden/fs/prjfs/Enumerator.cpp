@@ -67,9 +67,10 @@ void Enumerator::advanceEnumeration() {
 }
 
 std::vector<ImmediateFuture<PrjfsDirEntry::Ready>>
-Enumerator::getPendingDirEntries() {
+Enumerator::getPendingDirEntries(size_t maxEntries) {
   std::vector<ImmediateFuture<PrjfsDirEntry::Ready>> ret;
-  for (auto it = iter_; it != metadataList_.end(); it++) {
+  for (auto it = iter_; it != metadataList_.end() && ret.size() < maxEntries;
+       it++) {
     if (it->matchPattern(searchExpression_)) {
       ret.push_back(it->getFuture());
     }
@@ -79,7 +79,12 @@ class Enumerator {
 
   explicit Enumerator() = delete;
 
-  std::vector<ImmediateFuture<PrjfsDirEntry::Ready>> getPendingDirEntries();
+  /**
+   * Return the next maxEntries entries matching the search expression that
+   * were not sent to ProjectedFS yet.
+   */
+  std::vector<ImmediateFuture<PrjfsDirEntry::Ready>> getPendingDirEntries(
+      size_t maxEntries);
 
   void advanceEnumeration();
 
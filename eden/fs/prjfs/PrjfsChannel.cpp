@@ -161,8 +161,10 @@ HRESULT runCallback(
     }
 
     auto channelPtr = channel.get();
-    auto context = std::make_shared<PrjfsRequestContext>(
-        std::move(channel), *callbackData);
+    auto context = std::allocate_shared<PrjfsRequestContext>(
+        RecyclingAllocator<PrjfsRequestContext>{},
+        std::move(channel),
+        *callbackData);
     auto liveRequest = std::make_unique<detail::PrjfsLiveRequest>(
         channelPtr->getTraceBusPtr(),
         channelPtr->getTraceDetailedArguments(),
@@ -307,8 +309,10 @@ HRESULT notification(
     }
 
     auto channelPtr = channel.get();
-    auto context = std::make_shared<PrjfsRequestContext>(
-        std::move(channel), *callbackData);
+    auto context = std::allocate_shared<PrjfsRequestContext>(
+        RecyclingAllocator<PrjfsRequestContext>{},
+        std::move(channel),
+        *callbackData);
     auto typeIt = notificationTypeMap.find(notificationType);
     auto nType = PrjfsTraceCallType::INVALID;
     if (typeIt != notificationTypeMap.end()) {
@@ -348,9 +352,27 @@ void detachAndCompleteCallback(
   }
 }
 
+/**
+ * The operations of the latency histograms of PrjfsChannelInner. The
+ * notifications, which are rare, share a histogram.
+ */
+enum PrjfsLatencyOp : size_t {
+  kOpenDirLatency,
+  kReadDirLatency,
+  kLookupLatency,
+  kAccessLatency,
+  kReadLatency,
+  kNotificationLatency,
+};
+
+std::vector<std::string> getPrjfsLatencyOpNames() {
+  return {"opendir", "readdir", "lookup", "access", "read", "notification"};
+}
+
 } // namespace
 
 PrjfsChannelInner::PrjfsChannelInner(
+    AbsolutePathPiece mountPath,
     std::unique_ptr<PrjfsDispatcher> dispatcher,
     const folly::Logger* straceLogger,
     ProcessAccessLog& processAccessLog,
@@ -360,10 +382,17 @@ PrjfsChannelInner::PrjfsChannelInner(
       straceLogger_(straceLogger),
       notifier_(std::move(notifier)),
       processAccessLog_(processAccessLog),
+      latencies_(std::make_shared<FsChannelLatencies>(
+          "prjfs",
+          mountPath.asString(),
+          getPrjfsLatencyOpNames())),
       deletedPromise_(std::move(deletedPromise)),
       traceDetailedArguments_(std::atomic<size_t>(0)),
       traceBus_(
           TraceBus<PrjfsTraceEvent>::create("PrjfsTrace", kTraceBusCapacity)) {
+  if (auto* stats = dispatcher_->getStats()) {
+    stats->registerLatencies(latencies_);
+  }
   traceSubscriptionHandles_.push_back(traceBus_->subscribeFunction(
       "PrjFS request tracking", [this](const PrjfsTraceEvent& event) {
         switch (event.getType()) {
@@ -404,9 +433,10 @@ HRESULT PrjfsChannelInner::startEnumeration(
                                       guid = std::move(guid),
                                       path = std::move(path)]() mutable {
     auto requestWatch =
-        std::shared_ptr<RequestMetricsScope::LockedRequestWatchList>(nullptr);
+        std::shared_ptr<RequestMetricsScope::RequestWatchList>(nullptr);
     auto stat = &PrjfsStats::openDir;
     context->startRequest(dispatcher_->getStats(), stat, requestWatch);
+    context->setLatencies(latencies_, kOpenDirLatency);
 
     FB_LOGF(
         getStraceLogger(), DBG7, "opendir({}, guid={})", path, guid.toString());
@@ -438,6 +468,81 @@ HRESULT PrjfsChannelInner::endEnumeration(
   return S_OK;
 }
 
+namespace {
+/**
+ * How many entries to wait for at once while filling an enumeration buffer.
+ *
+ * A buffer only holds a few hundred entries, so waiting for every remaining
+ * entry of a large directory on each call would make enumerating it
+ * quadratic, and would hold the first entries back until the slowest size
+ * of the whole directory is known.
+ */
+constexpr size_t kEnumerationBatchSize = 256;
+
+/**
+ * Add entries to the buffer, one batch at a time, until either the buffer
+ * is full or the enumeration is complete.
+ *
+ * added tells whether a previous batch already added an entry to this
+ * buffer.
+ */
+ImmediateFuture<folly::Unit> fillDirEntryBuffer(
+    std::shared_ptr<Enumerator> enumerator,
+    PRJ_DIR_ENTRY_BUFFER_HANDLE buffer,
+    bool added) {
+  auto pendingDirEntries =
+      enumerator->getPendingDirEntries(kEnumerationBatchSize);
+  auto batchSize = pendingDirEntries.size();
+  return collectAll(std::move(pendingDirEntries))
+      .thenValue([enumerator = std::move(enumerator), buffer, added, batchSize](
+                     std::vector<folly::Try<PrjfsDirEntry::Ready>> entries)
+                     mutable -> ImmediateFuture<folly::Unit> {
+        for (auto& try_ : entries) {
+          if (try_.hasException()) {
+            return makeImmediateFuture<folly::Unit>(try_.exception());
+          }
+          auto& entry = try_.value();
+
+          auto fileInfo = PRJ_FILE_BASIC_INFO();
+          fileInfo.IsDirectory = entry.isDir;
+          fileInfo.FileSize = entry.size;
+
+          XLOGF(
+              DBG6,
+              "Directory entry: {}, {}, size={}",
+              fileInfo.IsDirectory ? "Dir" : "File",
+              PathComponent(entry.name),
+              fileInfo.FileSize);
+
+          auto result =
+              PrjFillDirEntryBuffer(entry.name.c_str(), &fileInfo, buffer);
+          if (FAILED(result)) {
+            if (result == HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER) &&
+                added) {
+              // We are out of buffer space. This entry didn't make it. Return
+              // without increment.
+              return folly::unit;
+            } else {
+              return makeImmediateFuture<folly::Unit>(makeHResultErrorExplicit(
+                  result,
+                  fmt::format(
+                      FMT_STRING("Adding directory entry {}"),
+                      PathComponent(entry.name))));
+            }
+          }
+          added = true;
+          enumerator->advanceEnumeration();
+        }
+
+        if (batchSize < kEnumerationBatchSize) {
+          // That was the last batch, the enumeration is complete.
+          return folly::unit;
+        }
+        return fillDirEntryBuffer(std::move(enumerator), buffer, added);
+      });
+}
+} // namespace
+
 HRESULT PrjfsChannelInner::getEnumerationData(
     std::shared_ptr<PrjfsRequestContext> context,
     const PRJ_CALLBACK_DATA* callbackData,
@@ -482,61 +587,14 @@ HRESULT PrjfsChannelInner::getEnumerationData(
                                       enumerator = std::move(enumerator),
                                       buffer = dirEntryBufferHandle] {
     auto requestWatch =
-        std::shared_ptr<RequestMetricsScope::LockedRequestWatchList>(nullptr);
+        std::shared_ptr<RequestMetricsScope::RequestWatchList>(nullptr);
     auto stat = &PrjfsStats::readDir;
     context->startRequest(dispatcher_->getStats(), stat, requestWatch);
+    context->setLatencies(latencies_, kReadDirLatency);
 
-    // TODO(xavierd): there is a potential quadratic cost to the following code
-    // in the case where the buffer can only hold a single entry. The linear
-    // getPendingDirEntries would thus be called for as many entries, causing
-    // the quadratic complexity. In practice, ProjectedFS doesn't do this and
-    // thus we can afford a bit of redundant work.
-    auto pendingDirEntries = enumerator->getPendingDirEntries();
-    return collectAll(std::move(pendingDirEntries))
-        .thenValue([enumerator = std::move(enumerator),
-                    buffer,
-                    context = std::move(context)](
-                       std::vector<folly::Try<PrjfsDirEntry::Ready>> entries) {
-          bool added = false;
-          for (auto& try_ : entries) {
-            if (try_.hasException()) {
-              return folly::Try<folly::Unit>{try_.exception()};
-            }
-            auto& entry = try_.value();
-
-            auto fileInfo = PRJ_FILE_BASIC_INFO();
-            fileInfo.IsDirectory = entry.isDir;
-            fileInfo.FileSize = entry.size;
-
-            XLOGF(
-                DBG6,
-                "Directory entry: {}, {}, size={}",
-                fileInfo.IsDirectory ? "Dir" : "File",
-                PathComponent(entry.name),
-                fileInfo.FileSize);
-
-            auto result =
-                PrjFillDirEntryBuffer(entry.name.c_str(), &fileInfo, buffer);
-            if (FAILED(result)) {
-              if (result == HRESULT_FROM_WIN32(ERROR_INSUFFICIENT_BUFFER) &&
-                  added) {
-                // We are out of buffer space. This entry didn't make it. Return
-                // without increment.
-                break;
-              } else {
-                return folly::Try<folly::Unit>{makeHResultErrorExplicit(
-                    result,
-                    fmt::format(
-                        FMT_STRING("Adding directory entry {}"),
-                        PathComponent(entry.name)))};
-              }
-            }
-            added = true;
-            enumerator->advanceEnumeration();
-          }
-
+    return fillDirEntryBuffer(enumerator, buffer, /*added=*/false)
+        .thenValue([buffer, context = std::move(context)](folly::Unit) {
           context->sendEnumerationSuccess(buffer);
-          return folly::Try{folly::unit};
         });
   });
 
@@ -558,9 +616,10 @@ HRESULT PrjfsChannelInner::getPlaceholderInfo(
                                       path = std::move(path),
                                       virtualizationContext]() mutable {
     auto requestWatch =
-        std::shared_ptr<RequestMetricsScope::LockedRequestWatchList>(nullptr);
+        std::shared_ptr<RequestMetricsScope::RequestWatchList>(nullptr);
     auto stat = &PrjfsStats::lookup;
     context->startRequest(dispatcher_->getStats(), stat, requestWatch);
+    context->setLatencies(latencies_, kLookupLatency);
 
     FB_LOGF(getStraceLogger(), DBG7, "lookup({})", path);
     return dispatcher_
@@ -617,9 +676,10 @@ HRESULT PrjfsChannelInner::queryFileName(
                                       context,
                                       path = std::move(path)]() mutable {
     auto requestWatch =
-        std::shared_ptr<RequestMetricsScope::LockedRequestWatchList>(nullptr);
+        std::shared_ptr<RequestMetricsScope::RequestWatchList>(nullptr);
     auto stat = &PrjfsStats::access;
     context->startRequest(dispatcher_->getStats(), stat, requestWatch);
+    context->setLatencies(latencies_, kAccessLatency);
     FB_LOGF(getStraceLogger(), DBG7, "access({})", path);
     return dispatcher_
         ->access(std::move(path), context->getObjectFetchContext())
@@ -734,10 +794,11 @@ HRESULT PrjfsChannelInner::getFileData(
        byteOffset,
        length]() mutable {
         auto requestWatch =
-            std::shared_ptr<RequestMetricsScope::LockedRequestWatchList>(
+            std::shared_ptr<RequestMetricsScope::RequestWatchList>(
                 nullptr);
         auto stat = &PrjfsStats::read;
         context->startRequest(dispatcher_->getStats(), stat, requestWatch);
+        context->setLatencies(latencies_, kReadLatency);
 
         FB_LOGF(
             getStraceLogger(),
@@ -1108,8 +1169,9 @@ HRESULT PrjfsChannelInner::notification(
     }
 
     auto requestWatch =
-        std::shared_ptr<RequestMetricsScope::LockedRequestWatchList>(nullptr);
+        std::shared_ptr<RequestMetricsScope::RequestWatchList>(nullptr);
     context->startRequest(dispatcher_->getStats(), stat, requestWatch);
+    context->setLatencies(latencies_, kNotificationLatency);
 
     FB_LOG(getStraceLogger(), DBG7, renderer(relPath, destPath, isDirectory));
     auto fut = (this->*handler)(
@@ -1162,6 +1224,7 @@ PrjfsChannel::PrjfsChannel(
       folly::makePromiseContract<folly::Unit>();
   innerDeleted_ = std::move(innerDeletedFuture);
   inner_.store(std::make_shared<PrjfsChannelInner>(
+      mountPath,
       std::move(dispatcher),
       straceLogger,
       processAccessLog_,
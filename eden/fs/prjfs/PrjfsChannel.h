@@ -14,6 +14,7 @@
 #include "eden/fs/prjfs/Enumerator.h"
 #include "eden/fs/prjfs/PrjfsDispatcher.h"
 #include "eden/fs/service/gen-cpp2/eden_types.h"
+#include "eden/fs/telemetry/FsChannelLatencies.h"
 #include "eden/fs/telemetry/TraceBus.h"
 #include "eden/fs/utils/Guid.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -129,6 +130,7 @@ struct PrjfsTraceEvent : TraceEventBase {
 class PrjfsChannelInner {
  public:
   PrjfsChannelInner(
+      AbsolutePathPiece mountPath,
       std::unique_ptr<PrjfsDispatcher> dispatcher,
       const folly::Logger* straceLogger,
       ProcessAccessLog& processAccessLog,
@@ -387,6 +389,9 @@ class PrjfsChannelInner {
   // its lifetime be longer than that of PrjfsChannelInner.
   ProcessAccessLog& processAccessLog_;
 
+  // Latency histograms of the callbacks, indexed by PrjfsLatencyOp.
+  std::shared_ptr<FsChannelLatencies> latencies_;
+
   // Set of currently active directory enumerations.
   folly::Synchronized<folly::F14FastMap<Guid, std::shared_ptr<Enumerator>>>
       enumSessions_;
@@ -12,10 +12,13 @@
 #include "eden/fs/prjfs/PrjfsChannel.h"
 #include "eden/fs/utils/ImmediateFuture.h"
 #include "eden/fs/utils/PathFuncs.h"
+#include "eden/fs/utils/RecyclingAllocator.h"
 
 namespace facebook::eden {
 
-class PrjfsObjectFetchContext : public FsObjectFetchContext {
+class PrjfsObjectFetchContext
+    : public FsObjectFetchContext,
+      public RecycledAllocation<PrjfsObjectFetchContext> {
  public:
   PrjfsObjectFetchContext(pid_t pid) : pid_{pid} {}
 
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/service/ChangesSinceFilter.h"
+
+#include <folly/String.h>
+#include <algorithm>
+
+#include "eden/fs/model/git/TopLevelIgnores.h"
+#include "eden/fs/service/gen-cpp2/streamingeden_types.h"
+#include "eden/fs/utils/EdenError.h"
+
+namespace facebook::eden {
+
+namespace {
+bool isExcluded(GitIgnore::MatchResult result) {
+  return result == GitIgnore::EXCLUDE || result == GitIgnore::HIDDEN;
+}
+} // namespace
+
+ChangesSinceFilter::ChangesSinceFilter(
+    const StreamChangesSinceParams& params,
+    std::unique_ptr<TopLevelIgnores> ignores,
+    CaseSensitivity caseSensitive)
+    : ignores_{std::move(ignores)}, caseSensitive_{caseSensitive} {
+  for (const auto& root : *params.includedRoots()) {
+    if (root.empty() || root == ".") {
+      // The whole mount is included.
+      includedRoots_.clear();
+      break;
+    }
+    includedRoots_.emplace_back(root);
+  }
+
+  auto options = GlobOptions::DEFAULT;
+  if (caseSensitive == CaseSensitivity::Insensitive) {
+    options |= GlobOptions::CASE_INSENSITIVE;
+  }
+  for (const auto& glob : *params.globs()) {
+    auto matcher = GlobMatcher::create(glob, options);
+    if (matcher.hasError()) {
+      throw newEdenError(
+          EINVAL,
+          EdenErrorType::ARGUMENT_ERROR,
+          "invalid glob `",
+          glob,
+          "`: ",
+          matcher.error());
+    }
+    globs_.push_back(std::move(matcher).value());
+  }
+}
+
+ChangesSinceFilter::~ChangesSinceFilter() = default;
+
+bool ChangesSinceFilter::matchesAll() const {
+  return includedRoots_.empty() && globs_.empty() &&
+      (!ignores_ || !ignores_->getStack());
+}
+
+bool ChangesSinceFilter::matches(RelativePathPiece path) const {
+  if (!includedRoots_.empty() && !isInIncludedRoot(path)) {
+    return false;
+  }
+  if (!globs_.empty() &&
+      std::none_of(globs_.begin(), globs_.end(), [&](const auto& glob) {
+        return glob.match(path.view());
+      })) {
+    return false;
+  }
+  return !ignores_ || !isIgnored(path);
+}
+
+bool ChangesSinceFilter::isInIncludedRoot(RelativePathPiece path) const {
+  auto text = path.stringPiece();
+  for (const auto& root : includedRoots_) {
+    auto rootText = root.stringPiece();
+    if (text.size() < rootText.size() ||
+        (text.size() > rootText.size() &&
+         text[rootText.size()] != kDirSeparator)) {
+      continue;
+    }
+    auto prefix = text.subpiece(0, rootText.size());
+    if (caseSensitive_ == CaseSensitivity::Sensitive
+            ? prefix == rootText
+            : prefix.equals(rootText, folly::AsciiCaseInsensitive{})) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ChangesSinceFilter::isIgnored(RelativePathPiece path) const {
+  const auto* stack = ignores_->getStack();
+  if (!stack) {
+    return false;
+  }
+  // As in a diff, nothing inside an ignored directory can be unignored.
+  for (auto dir : path.dirname().paths()) {
+    if (isExcluded(stack->match(dir, GitIgnore::TYPE_DIR))) {
+      return true;
+    }
+  }
+  return isExcluded(stack->match(path, GitIgnore::TYPE_FILE));
+}
+
+} // namespace facebook::eden
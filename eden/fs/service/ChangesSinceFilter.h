@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "eden/fs/model/git/GlobMatcher.h"
+#include "eden/fs/utils/CaseSensitivity.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+class StreamChangesSinceParams;
+class TopLevelIgnores;
+
+/**
+ * Decides which of the changed paths streamChangesSince returns, according to
+ * the filters of its StreamChangesSinceParams.
+ *
+ * A path is returned when it is inside one of the included roots, matches one
+ * of the globs, and isn't ignored. Empty lists of roots or globs accept every
+ * path.
+ */
+class ChangesSinceFilter {
+ public:
+  /**
+   * ignores holds the rules ignored paths are rejected by, and is null when
+   * ignored paths are returned.
+   *
+   * Throws an EdenError if one of the globs is invalid.
+   */
+  ChangesSinceFilter(
+      const StreamChangesSinceParams& params,
+      std::unique_ptr<TopLevelIgnores> ignores,
+      CaseSensitivity caseSensitive);
+  ~ChangesSinceFilter();
+
+  ChangesSinceFilter(const ChangesSinceFilter&) = delete;
+  ChangesSinceFilter& operator=(const ChangesSinceFilter&) = delete;
+
+  /**
+   * Whether every path is accepted, in which case callers don't need to call
+   * matches().
+   */
+  bool matchesAll() const;
+
+  bool matches(RelativePathPiece path) const;
+
+ private:
+  bool isInIncludedRoot(RelativePathPiece path) const;
+  bool isIgnored(RelativePathPiece path) const;
+
+  std::vector<RelativePath> includedRoots_;
+  std::vector<GlobMatcher> globs_;
+  std::unique_ptr<TopLevelIgnores> ignores_;
+  CaseSensitivity caseSensitive_;
+};
+
+} // namespace facebook::eden
@@ -8,12 +8,15 @@
 #include "eden/fs/service/EdenCPUThreadPool.h"
 
 #include <folly/portability/GFlags.h>
+#include "eden/fs/utils/WorkStealingExecutor.h"
 
 DEFINE_int32(num_eden_threads, 12, "the number of eden CPU worker threads");
 
 namespace facebook::eden {
 
 EdenCPUThreadPool::EdenCPUThreadPool()
-    : UnboundedQueueExecutor(FLAGS_num_eden_threads, "EdenCPUThread") {}
+    : UnboundedQueueExecutor(std::make_shared<WorkStealingExecutor>(
+          FLAGS_num_eden_threads,
+          "EdenCPUThread")) {}
 
 } // namespace facebook::eden
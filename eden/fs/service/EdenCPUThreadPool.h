@@ -12,6 +12,8 @@
 namespace facebook::eden {
 
 // The Eden CPU thread pool is intended for miscellaneous background tasks.
+// It is a WorkStealingExecutor, so the continuations a worker schedules stay
+// on that worker, and priorities are honored.
 class EdenCPUThreadPool : public UnboundedQueueExecutor {
  public:
   explicit EdenCPUThreadPool();
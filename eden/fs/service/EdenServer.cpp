@@ -11,10 +11,12 @@
 #include <chrono>
 
 #include <sys/stat.h>
+#include <algorithm>
 #include <atomic>
 #include <fstream>
 #include <functional>
 #include <memory>
+#include <numeric>
 #include <sstream>
 #include <string>
 
@@ -53,19 +55,28 @@
 #include "eden/fs/service/gen-cpp2/eden_types.h"
 #include "eden/fs/store/BackingStoreLogger.h"
 #include "eden/fs/store/BlobCache.h"
+#include "eden/fs/store/CacheSnapshot.h"
+#include "eden/fs/store/BlobHasher.h"
+#include "eden/fs/store/BlobFileCache.h"
+#include "eden/fs/store/BlobMetadataIndex.h"
 #include "eden/fs/store/EmptyBackingStore.h"
+#include "eden/fs/store/FilteredBackingStore.h"
 #include "eden/fs/store/LocalStore.h"
 #include "eden/fs/store/LocalStoreCachedBackingStore.h"
 #include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/store/ObjectMetadataCache.h"
 #include "eden/fs/store/ObjectStore.h"
 #include "eden/fs/store/RocksDbLocalStore.h"
 #include "eden/fs/store/SqliteLocalStore.h"
+#include "eden/fs/store/TieredLocalStore.h"
 #include "eden/fs/store/TreeCache.h"
 #include "eden/fs/store/hg/HgBackingStore.h"
 #include "eden/fs/store/hg/HgQueuedBackingStore.h"
 #include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/telemetry/IHiveLogger.h"
+#include "eden/fs/telemetry/LockContention.h"
 #include "eden/fs/telemetry/RequestMetricsScope.h"
+#include "eden/fs/telemetry/RequestSampler.h"
 #include "eden/fs/telemetry/SessionInfo.h"
 #include "eden/fs/telemetry/StructuredLogger.h"
 #include "eden/fs/telemetry/StructuredLoggerFactory.h"
@@ -74,6 +85,7 @@
 #include "eden/fs/utils/EnumValue.h"
 #include "eden/fs/utils/FileUtils.h"
 #include "eden/fs/utils/FsChannelTypes.h"
+#include "eden/fs/utils/Memory.h"
 #include "eden/fs/utils/NfsSocket.h"
 #include "eden/fs/utils/NotImplemented.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -141,6 +153,12 @@ DEFINE_uint64(
     minimumBlobCacheEntryCount,
     16,
     "The minimum number of recent blobs to keep cached. Trumps maximumBlobCacheSize");
+DEFINE_uint64(
+    blobCacheShardCount,
+    1,
+    "Number of independently locked shards the blob cache is split into. "
+    "maximumBlobCacheSize and minimumBlobCacheEntryCount are divided between "
+    "the shards");
 
 using apache::thrift::ThriftServer;
 using folly::Future;
@@ -187,11 +205,14 @@ std::shared_ptr<Notifier> getPlatformNotifier(
 
 constexpr StringPiece kRocksDBPath{"storage/rocks-db"};
 constexpr StringPiece kSqlitePath{"storage/sqlite.db"};
+constexpr StringPiece kBlobMetadataIndexPath{"storage/blobmeta-index"};
+constexpr StringPiece kBlobFileCachePath{"storage/blob-files"};
 constexpr StringPiece kHgStorePrefix{"store.hg"};
 #ifndef _WIN32
 constexpr StringPiece kFuseRequestPrefix{"fuse"};
 #endif
 constexpr StringPiece kStateConfig{"config.toml"};
+constexpr StringPiece kCacheSnapshotPath{"cache-snapshot"};
 
 std::optional<std::string> getUnixDomainSocketPath(
     const folly::SocketAddress& address) {
@@ -330,7 +351,13 @@ class EdenServer::ThriftServerEventHandler
   folly::Promise<Unit> runningPromise_;
 };
 
-static constexpr folly::StringPiece kBlobCacheMemory{"blob_cache.memory"};
+static constexpr std::string_view kBlobCacheMemory{"blob_cache.memory"};
+static constexpr std::string_view kImportQueueClients{
+    "store.hg.import_queue.clients"};
+static constexpr std::string_view kImportQueueMaxClientDepth{
+    "store.hg.import_queue.max_client_depth"};
+static constexpr std::string_view kImportQueueMaxClientWait{
+    "store.hg.import_queue.max_client_wait_ms"};
 
 EdenServer::EdenServer(
     std::vector<std::string> originalCommandLine,
@@ -348,7 +375,9 @@ EdenServer::EdenServer(
       backingStoreFactory_{backingStoreFactory},
       blobCache_{BlobCache::create(
           FLAGS_maximumBlobCacheSize,
-          FLAGS_minimumBlobCacheEntryCount)},
+          FLAGS_minimumBlobCacheEntryCount,
+          FLAGS_blobCacheShardCount,
+          edenConfig->blobCacheEvictionPolicy.getValue())},
       config_{std::make_shared<ReloadableConfig>(edenConfig)},
       mountPoints_{std::make_shared<folly::Synchronized<MountMap>>(
           MountMap{kPathMapDefaultCaseSensitive})},
@@ -373,49 +402,90 @@ EdenServer::EdenServer(
       progressManager_{std::make_unique<
           folly::Synchronized<EdenServer::ProgressManager>>()} {
   treeCache_ = TreeCache::create(serverState_->getReloadableConfig());
-  auto counters = fb303::ServiceData::get()->getDynamicCounters();
-  counters->registerCallback(kBlobCacheMemory, [this] {
+  if (auto blobHashingThreads = edenConfig->blobHashingThreads.getValue()) {
+    blobHasher_ = std::make_shared<BlobHasher>(blobHashingThreads);
+  }
+  cachedCounters_.registerCallback(std::string{kBlobCacheMemory}, [this] {
     return this->getBlobCache()->getStats().totalSizeInBytes;
   });
 
   registerInodePopulationReportsCallback();
 
+  // How the pending imports are spread between the processes they are for,
+  // summed or maxed over the repositories.
+  cachedCounters_.registerCallback(std::string{kImportQueueClients}, [this] {
+    auto counters = collectHgQueuedBackingStoreCounters(
+        [](const HgQueuedBackingStore& store) {
+          return store.getImportQueueClientStats().clients;
+        });
+    return std::accumulate(counters.begin(), counters.end(), size_t{0});
+  });
+  cachedCounters_.registerCallback(
+      std::string{kImportQueueMaxClientDepth}, [this] {
+        auto counters = collectHgQueuedBackingStoreCounters(
+            [](const HgQueuedBackingStore& store) {
+              return store.getImportQueueClientStats().maxDepth;
+            });
+        return counters.empty()
+            ? size_t{0}
+            : *std::max_element(counters.begin(), counters.end());
+      });
+  cachedCounters_.registerCallback(
+      std::string{kImportQueueMaxClientWait}, [this] {
+        auto counters = collectHgQueuedBackingStoreCounters(
+            [](const HgQueuedBackingStore& store) {
+              return static_cast<size_t>(
+                  std::chrono::duration_cast<std::chrono::milliseconds>(
+                      store.getImportQueueClientStats().maxWait)
+                      .count());
+            });
+        return counters.empty()
+            ? size_t{0}
+            : *std::max_element(counters.begin(), counters.end());
+      });
+
   for (auto stage : RequestMetricsScope::requestStages) {
     for (auto metric : RequestMetricsScope::requestMetrics) {
       for (auto object : HgBackingStore::hgImportObjects) {
         auto counterName = getCounterNameForImportMetric(stage, metric, object);
-        counters->registerCallback(counterName, [this, stage, object, metric] {
-          auto individual_counters = this->collectHgQueuedBackingStoreCounters(
-              [stage, object, metric](const HgQueuedBackingStore& store) {
-                return store.getImportMetric(stage, object, metric);
-              });
-          return RequestMetricsScope::aggregateMetricCounters(
-              metric, individual_counters);
-        });
+        cachedCounters_.registerCallback(
+            counterName, [this, stage, object, metric] {
+              auto individual_counters =
+                  this->collectHgQueuedBackingStoreCounters(
+                      [stage, object, metric](
+                          const HgQueuedBackingStore& store) {
+                        return store.getImportMetric(stage, object, metric);
+                      });
+              return RequestMetricsScope::aggregateMetricCounters(
+                  metric, individual_counters);
+            });
       }
       auto summaryCounterName = getCounterNameForImportMetric(stage, metric);
-      counters->registerCallback(summaryCounterName, [this, stage, metric] {
-        std::vector<size_t> individual_counters;
-        for (auto object : HgBackingStore::hgImportObjects) {
-          auto more_counters = this->collectHgQueuedBackingStoreCounters(
-              [stage, object, metric](const HgQueuedBackingStore& store) {
-                return store.getImportMetric(stage, object, metric);
-              });
-          individual_counters.insert(
-              individual_counters.end(),
-              more_counters.begin(),
-              more_counters.end());
-        }
-        return RequestMetricsScope::aggregateMetricCounters(
-            metric, individual_counters);
-      });
+      cachedCounters_.registerCallback(
+          summaryCounterName, [this, stage, metric] {
+            std::vector<size_t> individual_counters;
+            for (auto object : HgBackingStore::hgImportObjects) {
+              auto more_counters = this->collectHgQueuedBackingStoreCounters(
+                  [stage, object, metric](const HgQueuedBackingStore& store) {
+                    return store.getImportMetric(stage, object, metric);
+                  });
+              individual_counters.insert(
+                  individual_counters.end(),
+                  more_counters.begin(),
+                  more_counters.end());
+            }
+            return RequestMetricsScope::aggregateMetricCounters(
+                metric, individual_counters);
+          });
     }
   }
 }
 
 EdenServer::~EdenServer() {
-  auto counters = fb303::ServiceData::get()->getDynamicCounters();
-  counters->unregisterCallback(kBlobCacheMemory);
+  cachedCounters_.unregisterCallback(kBlobCacheMemory);
+  cachedCounters_.unregisterCallback(kImportQueueClients);
+  cachedCounters_.unregisterCallback(kImportQueueMaxClientDepth);
+  cachedCounters_.unregisterCallback(kImportQueueMaxClientWait);
 
   unregisterInodePopulationReportsCallback();
 
@@ -423,10 +493,10 @@ EdenServer::~EdenServer() {
     for (auto metric : RequestMetricsScope::requestMetrics) {
       for (auto object : HgBackingStore::hgImportObjects) {
         auto counterName = getCounterNameForImportMetric(stage, metric, object);
-        counters->unregisterCallback(counterName);
+        cachedCounters_.unregisterCallback(counterName);
       }
       auto summaryCounterName = getCounterNameForImportMetric(stage, metric);
-      counters->unregisterCallback(summaryCounterName);
+      cachedCounters_.unregisterCallback(summaryCounterName);
     }
   }
 }
@@ -707,6 +777,26 @@ void EdenServer::updatePeriodicTaskIntervals(const EdenConfig& config) {
   localStoreTask_.updateInterval(
       std::chrono::duration_cast<std::chrono::milliseconds>(
           config.localStoreManagementInterval.getValue()));
+
+#ifndef _WIN32
+  memoryPressureUnloadTask_.updateInterval(
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          config.memoryPressureUnloadInterval.getValue()));
+#endif
+
+  auto requestSampleInterval =
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          config.requestSampleInterval.getValue());
+  getRequestSampler().setEnabled(requestSampleInterval.count() > 0);
+  requestSampleTask_.updateInterval(requestSampleInterval);
+
+  auto cachedCountersInterval =
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          config.cachedCountersInterval.getValue());
+  cachedCounters_.setEnabled(cachedCountersInterval.count() > 0);
+  cachedCountersTask_.updateInterval(cachedCountersInterval);
+
+  LockSite::setEnabled(config.lockContentionStats.getValue());
 }
 
 void EdenServer::scheduleCallbackOnMainEventBase(
@@ -841,13 +931,18 @@ void EdenServer::serve() const {
 }
 
 Future<Unit> EdenServer::prepare(std::shared_ptr<StartupLogger> logger) {
-  return prepareImpl(std::move(logger))
-      .ensure(
-          // Mark the server state as RUNNING once we finish setting up the
-          // mount points. Even if an error occurs we still transition to the
-          // running state. The prepare() code will log an error with more
-          // details if we do fail to set up some of the mount points.
-          [this] { runningState_.wlock()->state = RunState::RUNNING; });
+  auto phase = std::make_shared<StartupProfiler::Phase>(
+      startupProfiler_.startPhase("prepare"));
+  return prepareImpl(logger).ensure(
+      // Mark the server state as RUNNING once we finish setting up the
+      // mount points. Even if an error occurs we still transition to the
+      // running state. The prepare() code will log an error with more
+      // details if we do fail to set up some of the mount points.
+      [this, logger, phase] {
+        runningState_.wlock()->state = RunState::RUNNING;
+        phase->end();
+        startupProfiler_.report(*logger);
+      });
 }
 
 Future<Unit> EdenServer::prepareImpl(std::shared_ptr<StartupLogger> logger) {
@@ -874,6 +969,17 @@ Future<Unit> EdenServer::prepareImpl(std::shared_ptr<StartupLogger> logger) {
 
   startPeriodicTasks();
 
+  // TODO: The "state config" only has one configuration knob now. When
+  // another is required, introduce an EdenStateConfig class to manage
+  // defaults and save on update.
+  auto configPhase = startupProfiler_.startPhase("state_config");
+  auto config = parseConfig();
+  bool shouldSaveConfig = createStorageEngine(*config);
+  if (shouldSaveConfig) {
+    saveConfig(*config);
+  }
+  configPhase.end();
+
 #ifndef _WIN32
   // If we are gracefully taking over from an existing edenfs process,
   // receive its lock, thrift socket, and mount points now.
@@ -883,10 +989,16 @@ Future<Unit> EdenServer::prepareImpl(std::shared_ptr<StartupLogger> logger) {
 #endif
   if (doingTakeover) {
 #ifndef _WIN32
+    // The local store and the overlays stay locked by the existing process
+    // until it hands them off, but the backing stores can start now.
+    prestartBackingStores(*logger);
+
     logger->log(
         "Requesting existing edenfs process to gracefully "
         "transfer its mount points...");
+    auto takeoverPhase = startupProfiler_.startPhase("takeover_receive");
     takeoverData = takeoverMounts(takeoverPath);
+    takeoverPhase.end();
     logger->log(
         "Received takeover information for ",
         takeoverData.mountPoints.size(),
@@ -921,15 +1033,6 @@ Future<Unit> EdenServer::prepareImpl(std::shared_ptr<StartupLogger> logger) {
   }
 #endif
 
-  // TODO: The "state config" only has one configuration knob now. When
-  // another is required, introduce an EdenStateConfig class to manage
-  // defaults and save on update.
-  auto config = parseConfig();
-  bool shouldSaveConfig = createStorageEngine(*config);
-  if (shouldSaveConfig) {
-    saveConfig(*config);
-  }
-
 #ifndef _WIN32
   // Start listening for graceful takeover requests
   takeoverServer_.reset(new TakeoverServer(
@@ -949,8 +1052,33 @@ Future<Unit> EdenServer::prepareImpl(std::shared_ptr<StartupLogger> logger) {
        takeoverData = std::move(takeoverData),
 #endif
        thriftRunningFuture = std::move(thriftRunningFuture)]() mutable {
-        openStorageEngine(*logger);
+        auto cacheSnapshotPath =
+            edenDir_.getPath() + RelativePathPiece{kCacheSnapshotPath};
+#ifndef _WIN32
+        if (takeoverData.cacheSnapshotPath) {
+          cacheSnapshotPath = *takeoverData.cacheSnapshotPath;
+        }
+#endif
+
+        // Opening the local store can take a while, and the mounts only need
+        // it once their overlays are initialized, so it is opened meanwhile.
+        auto localStoreOpened =
+            via(serverState_->getThreadPool().get(),
+                [this, logger] {
+                  auto phase = startupProfiler_.startPhase("local_store_open");
+                  openStorageEngine(*logger);
+                })
+                .thenTry([this, path = std::move(cacheSnapshotPath)](
+                             folly::Try<Unit>&& result) mutable {
+                  if (result.hasValue()) {
+                    warmCachesFromSnapshot(std::move(path));
+                  }
+                  localStoreOpened_.setTry(folly::Try<Unit>{result});
+                  result.throwUnlessValue();
+                });
 
+        auto mountsPhase = std::make_shared<StartupProfiler::Phase>(
+            startupProfiler_.startPhase("mounts"));
         std::vector<Future<Unit>> mountFutures;
         if (doingTakeover) {
 #ifndef _WIN32
@@ -963,10 +1091,20 @@ Future<Unit> EdenServer::prepareImpl(std::shared_ptr<StartupLogger> logger) {
           mountFutures = prepareMounts(logger);
         }
 
+        auto mountsStarted =
+            folly::collectAllUnsafe(std::move(mountFutures))
+                .ensure([mountsPhase = std::move(mountsPhase)] {
+                  mountsPhase->end();
+                });
+
         // Return a future that will complete only when all mount points have
-        // started and the thrift server is also running.
-        mountFutures.emplace_back(std::move(thriftRunningFuture));
-        return folly::collectAllUnsafe(std::move(mountFutures)).unit();
+        // started, the local store is open and the thrift server is also
+        // running.
+        std::vector<Future<Unit>> futures;
+        futures.emplace_back(std::move(mountsStarted).unit());
+        futures.emplace_back(std::move(localStoreOpened));
+        futures.emplace_back(std::move(thriftRunningFuture));
+        return folly::collectAllUnsafe(std::move(futures)).unit();
       });
 }
 
@@ -1019,7 +1157,12 @@ bool EdenServer::createStorageEngine(cpptoml::table& config) {
     ensureDirectoryExists(parentDir);
     XLOG(DBG2) << "Creating local SQLite store " << path << "...";
     folly::stop_watch<std::chrono::milliseconds> watch;
-    localStore_ = make_shared<SqliteLocalStore>(path);
+    auto edenConfig = serverState_->getEdenConfig();
+    SqliteDatabase::Options options;
+    options.readConnections = edenConfig->sqliteReadConnections.getValue();
+    options.mmapSize = edenConfig->sqliteMmapSize.getValue();
+    options.cacheSizeKB = edenConfig->sqliteCacheSizeKB.getValue();
+    localStore_ = make_shared<SqliteLocalStore>(path, options);
     XLOG(DBG2) << "Opened SQLite store in " << watch.elapsed().count() / 1000.0
                << " seconds.";
   } else if (storageEngine == "rocksdb") {
@@ -1030,7 +1173,9 @@ bool EdenServer::createStorageEngine(cpptoml::table& config) {
     localStore_ = make_shared<RocksDbLocalStore>(
         rocksPath,
         serverState_->getStructuredLogger(),
-        &serverState_->getFaultInjector());
+        &serverState_->getFaultInjector(),
+        RocksDBOpenMode::ReadWrite,
+        RocksDbTuning::fromConfig(*serverState_->getEdenConfig()));
     localStore_->enableBlobCaching.store(
         serverState_->getEdenConfig()->enableBlobCaching.getValue(),
         std::memory_order_relaxed);
@@ -1041,6 +1186,19 @@ bool EdenServer::createStorageEngine(cpptoml::table& config) {
         folly::to<string>("invalid storage engine: ", storageEngine));
   }
 
+  auto hotTierEntries =
+      serverState_->getEdenConfig()->localStoreHotTierEntries.getValue();
+  if (storageEngine != "memory" && hotTierEntries > 0) {
+    auto enableBlobCaching =
+        localStore_->enableBlobCaching.load(std::memory_order_relaxed);
+    localStore_ = make_shared<TieredLocalStore>(
+        std::move(localStore_),
+        hotTierEntries,
+        serverState_->getEdenConfig()->localStoreWriteBackBatchSize.getValue());
+    localStore_->enableBlobCaching.store(
+        enableBlobCaching, std::memory_order_relaxed);
+  }
+
   return configUpdated;
 }
 
@@ -1050,6 +1208,47 @@ void EdenServer::openStorageEngine(StartupLogger& logger) {
   localStore_->open();
   logger.log(
       "Opened local store in ", watch.elapsed().count() / 1000.0, " seconds.");
+
+#ifndef _WIN32
+  auto indexEntries =
+      serverState_->getEdenConfig()->blobMetadataIndexEntries.getValue();
+  if (indexEntries > 0) {
+    const auto indexPath =
+        edenDir_.getPath() + RelativePathPiece{kBlobMetadataIndexPath};
+    localStore_->setBlobMetadataIndex(
+        BlobMetadataIndex::open(indexPath.view(), indexEntries));
+  }
+
+  auto blobFileMinSize =
+      serverState_->getEdenConfig()->blobFileCacheMinSize.getValue();
+  if (blobFileMinSize > 0) {
+    const auto cachePath =
+        edenDir_.getPath() + RelativePathPiece{kBlobFileCachePath};
+    localStore_->setBlobFileCache(
+        BlobFileCache::open(
+            cachePath,
+            serverState_->getEdenConfig()->blobFileCacheMaxSize.getValue()),
+        blobFileMinSize);
+  }
+#endif
+
+  auto writeQueueBytes =
+      serverState_->getEdenConfig()->localStoreWriteQueueBytes.getValue();
+  if (writeQueueBytes > 0) {
+    localStore_->startWriteQueue(writeQueueBytes, getSharedStats());
+  }
+
+  localStore_->setChunkedBlobMinSize(
+      serverState_->getEdenConfig()->localStoreChunkedBlobMinSize.getValue());
+
+  auto missingFilterBits =
+      serverState_->getEdenConfig()->localStoreMissingFilterBits.getValue();
+  if (missingFilterBits > 0) {
+    localStore_->enableMissingObjectFilters(
+        missingFilterBits,
+        serverState_->getEdenConfig()
+            ->localStoreMissingObjectEntries.getValue());
+  }
 }
 
 std::vector<Future<Unit>> EdenServer::prepareMountsTakeover(
@@ -1178,9 +1377,56 @@ void EdenServer::closeStorage() {
   // destroyed. We want to ensure that it is really closed and no subsequent
   // I/O can happen to it after the EdenServer is shut down and the main Eden
   // lock is released.
+  localStore_->stopWriteQueue();
   localStore_->close();
 }
 
+std::optional<AbsolutePath> EdenServer::saveCacheSnapshot() {
+  auto maxEntries =
+      serverState_->getEdenConfig()->cacheSnapshotEntries.getValue();
+  if (maxEntries == 0) {
+    return std::nullopt;
+  }
+
+  auto path = edenDir_.getPath() + RelativePathPiece{kCacheSnapshotPath};
+  try {
+    folly::stop_watch<std::chrono::milliseconds> watch;
+    auto snapshot =
+        CacheSnapshot::capture(*treeCache_, *blobCache_, maxEntries);
+    snapshot.save(path);
+    XLOG(DBG2) << "Saved " << snapshot.trees.size() << " trees and "
+               << snapshot.blobs.size() << " blobs to the cache snapshot in "
+               << watch.elapsed().count() << "ms";
+    return path;
+  } catch (const std::exception& ex) {
+    // A cold start is slower, but not worth failing the shutdown for.
+    XLOG(ERR) << "Failed to save the cache snapshot: " << ex.what();
+    return std::nullopt;
+  }
+}
+
+void EdenServer::warmCachesFromSnapshot(AbsolutePath path) {
+  if (serverState_->getEdenConfig()->cacheSnapshotEntries.getValue() == 0) {
+    return;
+  }
+
+  serverState_->getThreadPool()->add(
+      [path = std::move(path),
+       localStore = localStore_,
+       treeCache = treeCache_,
+       blobCache = blobCache_] {
+        auto snapshot = CacheSnapshot::load(path);
+        if (!snapshot) {
+          return;
+        }
+        folly::stop_watch<std::chrono::milliseconds> watch;
+        auto loaded = snapshot->warm(*localStore, *treeCache, *blobCache);
+        XLOG(DBG2) << "Reloaded " << loaded
+                   << " objects from the cache snapshot in "
+                   << watch.elapsed().count() << "ms";
+      });
+}
+
 bool EdenServer::performCleanup() {
   bool takeover = false;
 #ifndef _WIN32
@@ -1238,6 +1484,9 @@ bool EdenServer::performCleanup() {
   }
 #endif
 
+  if (!takeover) {
+    saveCacheSnapshot();
+  }
   closeStorage();
   // Stop the privhelper process.
   shutdownPrivhelper();
@@ -1288,53 +1537,69 @@ void EdenServer::addToMountPoints(std::shared_ptr<EdenMount> edenMount) {
 }
 
 void EdenServer::registerStats(std::shared_ptr<EdenMount> edenMount) {
-  auto counters = fb303::ServiceData::get()->getDynamicCounters();
-  counters->registerCallback(
+  cachedCounters_.registerCallback(
       edenMount->getCounterName(CounterName::INODEMAP_LOADED), [edenMount] {
         auto counts = edenMount->getInodeMap()->getInodeCounts();
         return counts.fileCount + counts.treeCount;
       });
-  counters->registerCallback(
+  cachedCounters_.registerCallback(
       edenMount->getCounterName(CounterName::INODEMAP_UNLOADED), [edenMount] {
         return edenMount->getInodeMap()->getInodeCounts().unloadedInodeCount;
       });
-  counters->registerCallback(
+  cachedCounters_.registerCallback(
       edenMount->getCounterName(CounterName::PERIODIC_INODE_UNLOAD),
       [edenMount] {
         return edenMount->getInodeMap()
             ->getInodeCounts()
             .periodicLinkedUnloadInodeCount;
       });
-  counters->registerCallback(
+  cachedCounters_.registerCallback(
       edenMount->getCounterName(CounterName::PERIODIC_UNLINKED_INODE_UNLOAD),
       [edenMount] {
         return edenMount->getInodeMap()
             ->getInodeCounts()
             .periodicUnlinkedUnloadInodeCount;
       });
-  counters->registerCallback(
+  cachedCounters_.registerCallback(
       edenMount->getCounterName(CounterName::JOURNAL_MEMORY),
       [edenMount] { return edenMount->getJournal().estimateMemoryUsage(); });
-  counters->registerCallback(
+  cachedCounters_.registerCallback(
+      edenMount->getCounterName(CounterName::METADATA_CACHE_ENTRIES),
+      [edenMount] {
+        return edenMount->getObjectStore()
+            ->getMetadataCacheAccount()
+            .getChargedEntries();
+      });
+  cachedCounters_.registerCallback(
+      edenMount->getCounterName(CounterName::METADATA_CACHE_SHARED_HITS),
+      [edenMount] {
+        return edenMount->getObjectStore()
+            ->getMetadataCacheAccount()
+            .getSharedHits();
+      });
+  cachedCounters_.registerCallback(
       edenMount->getCounterName(CounterName::JOURNAL_ENTRIES), [edenMount] {
         auto stats = edenMount->getJournal().getStats();
         return stats ? stats->entryCount : 0;
       });
-  counters->registerCallback(
+  cachedCounters_.registerCallback(
       edenMount->getCounterName(CounterName::JOURNAL_DURATION), [edenMount] {
         auto stats = edenMount->getJournal().getStats();
         return stats ? stats->getDurationInSeconds() : 0;
       });
-  counters->registerCallback(
+  cachedCounters_.registerCallback(
       edenMount->getCounterName(CounterName::JOURNAL_MAX_FILES_ACCUMULATED),
       [edenMount] {
         auto stats = edenMount->getJournal().getStats();
         return stats ? stats->maxFilesAccumulated : 0;
       });
+  cachedCounters_.registerCallback(
+      edenMount->getCounterName(CounterName::OVERLAY_GC_BACKLOG),
+      [edenMount] { return edenMount->getOverlay()->getGCBacklog(); });
 #ifndef _WIN32
   if (auto* channel = edenMount->getFuseChannel()) {
     for (auto metric : RequestMetricsScope::requestMetrics) {
-      counters->registerCallback(
+      cachedCounters_.registerCallback(
           getCounterNameForFuseRequests(
               RequestMetricsScope::RequestStage::LIVE, metric, edenMount.get()),
           [edenMount, metric, channel] {
@@ -1347,7 +1612,7 @@ void EdenServer::registerStats(std::shared_ptr<EdenMount> edenMount) {
 #endif
 #ifdef __linux__
   if (edenMount->getFuseChannel()) {
-    counters->registerCallback(
+    cachedCounters_.registerCallback(
         getCounterNameForFuseRequests(
             RequestMetricsScope::RequestStage::PENDING,
             RequestMetricsScope::RequestMetric::COUNT,
@@ -1364,27 +1629,32 @@ void EdenServer::registerStats(std::shared_ptr<EdenMount> edenMount) {
 }
 
 void EdenServer::unregisterStats(EdenMount* edenMount) {
-  auto counters = fb303::ServiceData::get()->getDynamicCounters();
-  counters->unregisterCallback(
+  cachedCounters_.unregisterCallback(
       edenMount->getCounterName(CounterName::INODEMAP_LOADED));
-  counters->unregisterCallback(
+  cachedCounters_.unregisterCallback(
       edenMount->getCounterName(CounterName::INODEMAP_UNLOADED));
-  counters->unregisterCallback(
+  cachedCounters_.unregisterCallback(
       edenMount->getCounterName(CounterName::PERIODIC_INODE_UNLOAD));
-  counters->unregisterCallback(
+  cachedCounters_.unregisterCallback(
       edenMount->getCounterName(CounterName::PERIODIC_UNLINKED_INODE_UNLOAD));
-  counters->unregisterCallback(
+  cachedCounters_.unregisterCallback(
       edenMount->getCounterName(CounterName::JOURNAL_MEMORY));
-  counters->unregisterCallback(
+  cachedCounters_.unregisterCallback(
+      edenMount->getCounterName(CounterName::METADATA_CACHE_ENTRIES));
+  cachedCounters_.unregisterCallback(
+      edenMount->getCounterName(CounterName::METADATA_CACHE_SHARED_HITS));
+  cachedCounters_.unregisterCallback(
       edenMount->getCounterName(CounterName::JOURNAL_ENTRIES));
-  counters->unregisterCallback(
+  cachedCounters_.unregisterCallback(
       edenMount->getCounterName(CounterName::JOURNAL_DURATION));
-  counters->unregisterCallback(
+  cachedCounters_.unregisterCallback(
       edenMount->getCounterName(CounterName::JOURNAL_MAX_FILES_ACCUMULATED));
+  cachedCounters_.unregisterCallback(
+      edenMount->getCounterName(CounterName::OVERLAY_GC_BACKLOG));
 #ifndef _WIN32
   if (edenMount->getFuseChannel()) {
     for (auto metric : RequestMetricsScope::requestMetrics) {
-      counters->unregisterCallback(getCounterNameForFuseRequests(
+      cachedCounters_.unregisterCallback(getCounterNameForFuseRequests(
           RequestMetricsScope::RequestStage::LIVE, metric, edenMount));
     }
   } else if (edenMount->getNfsdChannel()) {
@@ -1393,7 +1663,7 @@ void EdenServer::unregisterStats(EdenMount* edenMount) {
 #endif
 #ifdef __linux__
   if (edenMount->getFuseChannel()) {
-    counters->unregisterCallback(getCounterNameForFuseRequests(
+    cachedCounters_.unregisterCallback(getCounterNameForFuseRequests(
         RequestMetricsScope::RequestStage::PENDING,
         RequestMetricsScope::RequestMetric::COUNT,
         edenMount));
@@ -1493,6 +1763,39 @@ BackingStoreType toBackingStoreType(const std::string& type) {
   }
 }
 
+void EdenServer::prestartBackingStores(StartupLogger& logger) {
+  folly::dynamic dirs = folly::dynamic::object();
+  try {
+    dirs = CheckoutConfig::loadClientDirectoryMap(edenDir_.getPath());
+  } catch (const std::exception& ex) {
+    XLOG(WARN) << "not starting backing stores before takeover: "
+               << folly::exceptionStr(ex);
+    return;
+  }
+
+  folly::stop_watch<std::chrono::milliseconds> watch;
+  for (const auto& client : dirs.items()) {
+    try {
+      auto mountPath = canonicalPath(client.first.stringPiece());
+      auto config = CheckoutConfig::loadFromClientDirectory(
+          mountPath, edenDir_.getCheckoutStateDir(client.second.stringPiece()));
+      getBackingStore(
+          toBackingStoreType(config->getRepoType()), config->getRepoSource());
+    } catch (const std::exception& ex) {
+      // The mount will try again, and report the error, once taken over.
+      XLOG(WARN) << "failed to start the backing store of "
+                 << client.first.stringPiece()
+                 << " before takeover: " << folly::exceptionStr(ex);
+    }
+  }
+  logger.log(
+      "Started backing stores for ",
+      dirs.size(),
+      " mount points in ",
+      watch.elapsed().count() / 1000.0,
+      " seconds.");
+}
+
 folly::Future<std::shared_ptr<EdenMount>> EdenServer::mount(
     std::unique_ptr<CheckoutConfig> initialConfig,
     bool readOnly,
@@ -1504,6 +1807,19 @@ folly::Future<std::shared_ptr<EdenMount>> EdenServer::mount(
       toBackingStoreType(initialConfig->getRepoType()),
       initialConfig->getRepoSource());
 
+  // Blob ids aren't filtered, so filtered and unfiltered mounts of a
+  // repository share its metadata cache.
+  auto metadataCache = getMetadataCache(backingStore);
+
+  const bool filtered = initialConfig->getEnableFilter();
+  if (filtered) {
+    auto filteredStore = std::make_shared<FilteredBackingStore>(
+        std::move(backingStore), initialConfig->getFiltersDir());
+    filteredStore->setFilter(
+        FilteredBackingStore::loadFilterFile(initialConfig->getFilterPath()));
+    backingStore = std::move(filteredStore);
+  }
+
   auto objectStore = ObjectStore::create(
       getLocalStore(),
       backingStore,
@@ -1512,8 +1828,17 @@ folly::Future<std::shared_ptr<EdenMount>> EdenServer::mount(
       serverState_->getProcessNameCache(),
       serverState_->getStructuredLogger(),
       serverState_->getReloadableConfig()->getEdenConfig(),
-      initialConfig->getCaseSensitive());
-  auto journal = std::make_unique<Journal>(getSharedStats());
+      initialConfig->getCaseSensitive(),
+      std::move(metadataCache));
+  if (blobHasher_) {
+    objectStore->setBlobHasher(blobHasher_);
+  }
+  auto journalNotificationInterval =
+      serverState_->getEdenConfig()->journalNotificationInterval.getValue();
+  auto journal = std::make_unique<Journal>(
+      getSharedStats(),
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          journalNotificationInterval));
 
   // Create the EdenMount object and insert the mount into the mountPoints_ map.
   auto edenMount = EdenMount::create(
@@ -1531,13 +1856,15 @@ folly::Future<std::shared_ptr<EdenMount>> EdenServer::mount(
   auto initFuture = edenMount->initialize(
       std::move(progressCallback),
       doTakeover ? std::make_optional(optionalTakeover->inodeMap)
-                 : std::nullopt);
+                 : std::nullopt,
+      localStoreOpened_.getSemiFuture());
 
   // Now actually begin starting the mount point
   return std::move(initFuture)
       .thenTry([this,
                 doTakeover,
                 readOnly,
+                filtered,
                 edenMount,
                 mountStopWatch,
                 optionalTakeover = std::move(optionalTakeover)](
@@ -1552,7 +1879,7 @@ folly::Future<std::shared_ptr<EdenMount>> EdenServer::mount(
         return (optionalTakeover ? performTakeoverStart(
                                        edenMount, std::move(*optionalTakeover))
                                  : performFreshStart(edenMount, readOnly))
-            .thenTry([edenMount, doTakeover, this](
+            .thenTry([edenMount, doTakeover, filtered, this](
                          folly::Try<Unit>&& result) mutable {
               // Call mountFinished() if an error occurred during FUSE
               // initialization.
@@ -1564,6 +1891,21 @@ folly::Future<std::shared_ptr<EdenMount>> EdenServer::mount(
 
               registerStats(edenMount);
 
+              if (filtered) {
+                // The filter file may have changed while the mount was
+                // unmounted, check out the commit with its current contents.
+                folly::futures::detachOn(
+                    getServerState()->getThreadPool().get(),
+                    edenMount->applyFilter(std::nullopt, "mount")
+                        .semi()
+                        .deferError([edenMount](folly::exception_wrapper ew) {
+                          XLOG(ERR) << "Failed to apply the filter of "
+                                    << edenMount->getPath() << ": "
+                                    << folly::exceptionStr(ew);
+                          return CheckoutResult{};
+                        }));
+              }
+
               // Now that we've started the workers, arrange to call
               // mountFinished once the pool is torn down.
               auto finishFuture =
@@ -1858,6 +2200,22 @@ shared_ptr<BackingStore> EdenServer::getBackingStore(
   return store;
 }
 
+std::shared_ptr<ObjectMetadataCache> EdenServer::getMetadataCache(
+    const std::shared_ptr<BackingStore>& backingStore) {
+  auto budget = serverState_->getEdenConfig()->metadataCacheEntries.getValue();
+  auto lockedCaches = metadataCaches_.wlock();
+  auto& cache = (*lockedCaches)[backingStore.get()];
+  if (!cache) {
+    cache = ObjectMetadataCache::create(budget);
+    // Another repository shrinks the share of each of them.
+    auto share = std::max<size_t>(budget / lockedCaches->size(), 1);
+    for (auto& [_, repoCache] : *lockedCaches) {
+      repoCache->setMaxEntries(share);
+    }
+  }
+  return cache;
+}
+
 std::unordered_set<std::shared_ptr<BackingStore>>
 EdenServer::getBackingStores() {
   std::unordered_set<std::shared_ptr<BackingStore>> backingStores{};
@@ -2076,6 +2434,9 @@ folly::Future<TakeoverData> EdenServer::startTakeoverShutdown() {
       })
       .thenValue([this, socket = std::move(thriftSocket)](
                      TakeoverData&& takeover) mutable {
+        // The mounts are stopped, so the caches won't change anymore. Save
+        // them before the new process starts loading its own.
+        takeover.cacheSnapshotPath = saveCacheSnapshot();
         takeover.lockFile = edenDir_.extractLock();
 
         takeover.thriftSocket = std::move(socket);
@@ -2128,6 +2489,53 @@ void EdenServer::flushStatsNow() {
   serverState_->getStats().flush();
 }
 
+std::vector<LabeledLatencyHistogram> EdenServer::getLatencyHistograms() {
+  return serverState_->getStats().getLatencyHistograms();
+}
+
+std::map<std::string, int64_t> EdenServer::getMemoryBreakdown() {
+  std::map<std::string, int64_t> breakdown;
+  int64_t inodes = 0;
+  int64_t journal = 0;
+  for (const auto& mount : getMountPoints()) {
+    inodes += mount->getInodeMap()->estimateMemoryUsage();
+    journal += mount->getJournal().estimateMemoryUsage();
+  }
+  breakdown["inodes"] = inodes;
+  breakdown["journal"] = journal;
+  breakdown["blob_cache"] = getBlobCache()->getStats().totalSizeInBytes;
+  breakdown["tree_cache"] = treeCache_->getStats().totalSizeInBytes;
+  for (const auto& [kind, bytes] : localStore_->getMemoryUsage()) {
+    breakdown[folly::to<std::string>("local_store.", kind)] = bytes;
+  }
+
+  if (auto allocator = getAllocatorStats()) {
+    breakdown["malloc.allocated"] = allocator->allocated;
+    breakdown["malloc.active"] = allocator->active;
+    breakdown["malloc.metadata"] = allocator->metadata;
+    breakdown["malloc.resident"] = allocator->resident;
+  }
+  if (auto memoryStats = facebook::eden::proc_util::readMemoryStats()) {
+    breakdown["rss"] = memoryStats->resident;
+  }
+  return breakdown;
+}
+
+std::string EdenServer::getRequestSamples() {
+  return getRequestSampler().getFoldedStacks();
+}
+
+void EdenServer::sampleRequests() {
+  getRequestSampler().sample();
+}
+
+void EdenServer::refreshCachedCounters() {
+  auto filter = serverState_->getReloadableConfig()
+                    ->getEdenConfig()
+                    ->cachedCountersFilter.getValue();
+  cachedCounters_.refresh(filter ? filter->get() : nullptr);
+}
+
 void EdenServer::reportMemoryStats() {
   constexpr folly::StringPiece kRssBytes{"memory_vm_rss_bytes"};
 
@@ -2144,12 +2552,79 @@ void EdenServer::reportMemoryStats() {
     fb303::ServiceData::get()->addStatValue(
         kRssBytes, memoryStats->resident, fb303::AVG);
   }
+
+  for (const auto& [name, bytes] : getMemoryBreakdown()) {
+    fb303::ServiceData::get()->setCounter(
+        folly::to<std::string>("memory.", name), bytes);
+  }
+}
+
+void EdenServer::unloadInodesUnderMemoryPressure() {
+#ifndef _WIN32
+  auto config = serverState_->getReloadableConfig()->getEdenConfig(
+      ConfigReloadBehavior::NoReload);
+  auto highWaterMark = config->memoryPressureUnloadRssBytes.getValue();
+  if (highWaterMark == 0) {
+    return;
+  }
+  auto memoryStats = facebook::eden::proc_util::readMemoryStats();
+  if (!memoryStats) {
+    return;
+  }
+  if (memoryStats->resident <= highWaterMark) {
+    memoryPressureUnloadAge_.reset();
+    return;
+  }
+  // A checkout loads the inodes it touches; unloading them underneath it
+  // would only make it reload them.
+  if (enumerateInProgressCheckouts() > 0) {
+    return;
+  }
+
+  // Start with the coldest inodes and only move on to more recently used
+  // ones if memory is still above the mark on the next run.
+  auto minAge = config->memoryPressureUnloadMinAge.getValue();
+  auto age = memoryPressureUnloadAge_
+      ? std::max(*memoryPressureUnloadAge_ / 2, minAge)
+      : std::max(config->memoryPressureUnloadMaxAge.getValue(), minAge);
+  memoryPressureUnloadAge_ = age;
+
+  std::vector<shared_ptr<EdenMount>> mounts;
+  {
+    const auto mountPoints = mountPoints_->rlock();
+    for (const auto& entry : *mountPoints) {
+      mounts.push_back(entry.second.edenMount);
+    }
+  }
+
+  auto cutoff = folly::to<timespec>(
+      std::chrono::system_clock::now() -
+      std::chrono::duration_cast<std::chrono::system_clock::duration>(age));
+  size_t totalUnloaded = 0;
+  for (const auto& mount : mounts) {
+    auto unloaded =
+        mount->getRootInode()->unloadChildrenLastAccessedBefore(cutoff);
+    mount->getInodeMap()->recordPeriodicInodeUnload(unloaded);
+    totalUnloaded += unloaded;
+  }
+  XLOG(INFO) << "Resident memory is " << memoryStats->resident
+             << " bytes, above the limit of " << highWaterMark
+             << " bytes: unloaded " << totalUnloaded
+             << " inodes not accessed in the last "
+             << std::chrono::duration_cast<std::chrono::seconds>(age).count()
+             << " seconds";
+#endif
 }
 
 void EdenServer::manageLocalStore() {
+  // The local store is opened concurrently with the startup of the mounts.
+  if (!localStoreOpened_.isFulfilled()) {
+    return;
+  }
   auto config = serverState_->getReloadableConfig()->getEdenConfig(
       ConfigReloadBehavior::NoReload);
   localStore_->periodicManagementTask(*config);
+  localStore_->refreshMissingObjectFilters();
 }
 
 void EdenServer::refreshBackingStore() {
@@ -9,6 +9,7 @@
 
 #include <chrono>
 #include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
 #include <optional>
@@ -32,9 +33,11 @@
 #include "eden/fs/service/EdenStateDir.h"
 #include "eden/fs/service/PeriodicTask.h"
 #include "eden/fs/service/StartupLogger.h"
+#include "eden/fs/service/StartupProfiler.h"
 #include "eden/fs/store/BackingStore.h"
 #include "eden/fs/takeover/TakeoverData.h"
 #include "eden/fs/takeover/TakeoverHandler.h"
+#include "eden/fs/telemetry/CachedCounters.h"
 #include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/telemetry/IActivityRecorder.h"
 #include "eden/fs/telemetry/RequestMetricsScope.h"
@@ -64,11 +67,13 @@ class BackingStore;
 class HgQueuedBackingStore;
 class IHiveLogger;
 class BlobCache;
+class BlobHasher;
 class TreeCache;
 class Dirstate;
 class EdenServiceHandler;
 class LocalStore;
 class MountInfo;
+class ObjectMetadataCache;
 struct SessionInfo;
 class StartupLogger;
 class UserInfo;
@@ -340,6 +345,14 @@ class EdenServer : private TakeoverHandler {
       BackingStoreType type,
       folly::StringPiece name);
 
+  /**
+   * Look up the metadata cache shared by the ObjectStores of the mounts that
+   * use backingStore, creating it the first time. The
+   * store:metadata-cache-entries budget is split evenly between the caches.
+   */
+  std::shared_ptr<ObjectMetadataCache> getMetadataCache(
+      const std::shared_ptr<BackingStore>& backingStore);
+
   AbsolutePathPiece getEdenDir() const {
     return edenDir_.getPath();
   }
@@ -386,6 +399,24 @@ class EdenServer : private TakeoverHandler {
    */
   void flushStatsNow();
 
+  /**
+   * The latency histograms of every mounted filesystem channel.
+   */
+  std::vector<LabeledLatencyHistogram> getLatencyHistograms();
+
+  /**
+   * Estimates of the bytes used by each part of EdenFS, like "inodes" or
+   * "tree_cache", along with the state of the allocator ("malloc.*") and the
+   * resident set size ("rss"), to tell their growth from fragmentation.
+   */
+  std::map<std::string, int64_t> getMemoryBreakdown();
+
+  /**
+   * The recent samples of the phases of the filesystem requests, as folded
+   * stacks.
+   */
+  std::string getRequestSamples();
+
   /**
    * Reload the configuration files from disk.
    *
@@ -484,6 +515,9 @@ class EdenServer : private TakeoverHandler {
   using BackingStoreKey = std::pair<BackingStoreType, std::string>;
   using BackingStoreMap =
       std::unordered_map<BackingStoreKey, std::shared_ptr<BackingStore>>;
+  using MetadataCacheMap = std::unordered_map<
+      const BackingStore*,
+      std::shared_ptr<ObjectMetadataCache>>;
   using MountMap = PathMap<struct EdenMountInfo, AbsolutePath>;
   class ThriftServerEventHandler;
 
@@ -523,6 +557,14 @@ class EdenServer : private TakeoverHandler {
       std::shared_ptr<StartupLogger> logger);
   static void incrementStartupMountFailures();
 
+  /**
+   * Creates the backing stores of the configured checkouts ahead of a
+   * graceful takeover, while the previous process keeps serving them. The
+   * mounts then reuse them once the previous process hands them off, instead
+   * of starting their importers while the mounts are unavailable.
+   */
+  void prestartBackingStores(StartupLogger& logger);
+
 #ifndef _WIN32
   /**
    * recoverImpl() contains the bulk of the implementation of recover()
@@ -547,6 +589,18 @@ class EdenServer : private TakeoverHandler {
   bool createStorageEngine(cpptoml::table& config);
   void openStorageEngine(StartupLogger& logger);
 
+  /**
+   * Saves the ids of the hottest objects of the in-memory caches, when
+   * store:cache-snapshot-entries is set. Returns where they were saved.
+   */
+  std::optional<AbsolutePath> saveCacheSnapshot();
+
+  /**
+   * Reloads the objects of the snapshot at path into the in-memory caches, in
+   * the background.
+   */
+  void warmCachesFromSnapshot(AbsolutePath path);
+
   // Called when a mount has been unmounted and has stopped.
   void mountFinished(
       EdenMount* mountPoint,
@@ -594,9 +648,20 @@ class EdenServer : private TakeoverHandler {
   void registerInodePopulationReportsCallback();
   void unregisterInodePopulationReportsCallback();
 
-  // Report memory usage statistics to ServiceData.
+  // Report memory usage statistics, including getMemoryBreakdown() as
+  // "memory.*" counters, to ServiceData.
   void reportMemoryStats();
 
+  // Unload inodes that were not accessed recently while the resident memory
+  // is above mount:memory-pressure-unload-rss-bytes.
+  void unloadInodesUnderMemoryPressure();
+
+  // Sample the phases of the in-flight filesystem requests.
+  void sampleRequests();
+
+  // Recompute the counters that scrapes read from cachedCounters_.
+  void refreshCachedCounters();
+
   // Compute stats for the local store and perform garbage collection if
   // necessary
   void manageLocalStore();
@@ -642,8 +707,14 @@ class EdenServer : private TakeoverHandler {
 
   std::shared_ptr<LocalStore> localStore_;
   folly::Synchronized<BackingStoreMap> backingStores_;
+  folly::Synchronized<MetadataCacheMap> metadataCaches_;
   const std::shared_ptr<BlobCache> blobCache_;
   std::shared_ptr<TreeCache> treeCache_;
+  /**
+   * Shared by the ObjectStores of all mounts, null when blobs are hashed on
+   * the threads that fetch them.
+   */
+  std::shared_ptr<BlobHasher> blobHasher_;
   std::shared_ptr<ReloadableConfig> config_;
 
   std::shared_ptr<folly::Synchronized<MountMap>> mountPoints_;
@@ -676,6 +747,15 @@ class EdenServer : private TakeoverHandler {
   };
   folly::Synchronized<RunStateData> runningState_;
 
+  StartupProfiler startupProfiler_;
+
+  /**
+   * Fulfilled once the local store is opened during prepare(). The mounts
+   * initialize their overlays meanwhile, but wait for it before reading their
+   * root tree.
+   */
+  folly::SharedPromise<folly::Unit> localStoreOpened_;
+
   /**
    * The EventBase driving the main thread loop.
    *
@@ -757,6 +837,12 @@ class EdenServer : private TakeoverHandler {
 
   const std::unique_ptr<folly::Synchronized<ProgressManager>> progressManager_;
 
+  /**
+   * The expensive fb303 counters, computed by cachedCountersTask_ rather
+   * than on every scrape.
+   */
+  CachedCounters cachedCounters_;
+
   PeriodicFnTask<&EdenServer::reloadConfig> reloadConfigTask_{
       this,
       "reload_config"};
@@ -773,5 +859,20 @@ class EdenServer : private TakeoverHandler {
       this,
       "backing_store"};
   PeriodicFnTask<&EdenServer::manageOverlay> overlayTask_{this, "overlay"};
+  PeriodicFnTask<&EdenServer::unloadInodesUnderMemoryPressure>
+      memoryPressureUnloadTask_{this, "memory_pressure_unload"};
+  PeriodicFnTask<&EdenServer::sampleRequests> requestSampleTask_{
+      this,
+      "request_sample"};
+  PeriodicFnTask<&EdenServer::refreshCachedCounters> cachedCountersTask_{
+      this,
+      "cached_counters"};
+
+  /**
+   * The access age used by the last unload pass while above the memory
+   * high-water mark, or nullopt if memory was below it. Only accessed from
+   * the main event base thread, like the periodic tasks themselves.
+   */
+  std::optional<std::chrono::nanoseconds> memoryPressureUnloadAge_;
 };
 } // namespace facebook::eden
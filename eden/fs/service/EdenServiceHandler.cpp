@@ -9,6 +9,7 @@
 
 #include <sys/types.h>
 #include <algorithm>
+#include <limits>
 #include <optional>
 #include <typeinfo>
 
@@ -16,21 +17,30 @@
 #include <fmt/core.h>
 #include <folly/Conv.h>
 #include <folly/FileUtil.h>
+#include <folly/Function.h>
 #include <folly/Portability.h>
+#include <folly/ScopeGuard.h>
 #include <folly/String.h>
 #include <folly/chrono/Conv.h>
 #include <folly/container/Access.h>
 #include <folly/futures/Future.h>
+#include <folly/io/async/fdsock/SocketFds.h>
 #include <folly/logging/Logger.h>
 #include <folly/logging/LoggerDB.h>
 #include <folly/logging/xlog.h>
 #include <folly/stop_watch.h>
 #include <folly/system/Shell.h>
 #include <thrift/lib/cpp/util/EnumUtils.h>
+#if FOLLY_HAS_COROUTINES
+#include <folly/experimental/coro/AsyncGenerator.h>
+#include <folly/experimental/coro/Invoke.h>
+#endif
 
 #include "eden/common/utils/ProcessNameCache.h"
 #include "eden/fs/config/CheckoutConfig.h"
 #include "eden/fs/fuse/FuseChannel.h"
+#include "eden/fs/inodes/CheckoutPlanner.h"
+#include "eden/fs/inodes/DirectoryPreloader.h"
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/FileInode.h"
 #include "eden/fs/inodes/GlobNode.h"
@@ -49,6 +59,7 @@
 #include "eden/fs/model/TreeEntry.h"
 #include "eden/fs/nfs/Nfsd3.h"
 #include "eden/fs/prjfs/PrjfsChannel.h"
+#include "eden/fs/service/ChangesSinceFilter.h"
 #include "eden/fs/service/EdenServer.h"
 #include "eden/fs/service/ThriftGlobImpl.h"
 #include "eden/fs/service/ThriftPermissionChecker.h"
@@ -58,12 +69,14 @@
 #include "eden/fs/service/gen-cpp2/streamingeden_constants.h"
 #include "eden/fs/store/BackingStore.h"
 #include "eden/fs/store/Diff.h"
+#include "eden/fs/store/FilteredBackingStore.h"
 #include "eden/fs/store/LocalStore.h"
 #include "eden/fs/store/LocalStoreCachedBackingStore.h"
 #include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/store/ObjectStore.h"
 #include "eden/fs/store/PathLoader.h"
 #include "eden/fs/store/ScmStatusDiffCallback.h"
+#include "eden/fs/store/StreamingScmStatusDiffCallback.h"
 #include "eden/fs/store/hg/HgQueuedBackingStore.h"
 #include "eden/fs/telemetry/SessionInfo.h"
 #include "eden/fs/telemetry/Tracing.h"
@@ -71,8 +84,10 @@
 #include "eden/fs/utils/Clock.h"
 #include "eden/fs/utils/EdenError.h"
 #include "eden/fs/utils/FaultInjector.h"
+#include "eden/fs/utils/FsChannelOverloadController.h"
 #include "eden/fs/utils/NotImplemented.h"
 #include "eden/fs/utils/ProcUtil.h"
+#include "eden/fs/utils/SealedMemfd.h"
 #include "eden/fs/utils/SourceLocation.h"
 #include "eden/fs/utils/StatTimes.h"
 #include "eden/fs/utils/String.h"
@@ -322,6 +337,34 @@ ImmediateFuture<ReturnType> wrapImmediateFuture(
   return std::move(f).ensure([logHelper = std::move(logHelper)]() {});
 }
 
+/**
+ * Waits for an expensive request to be admitted by the controller, and
+ * records how long it was queued. The request must hold on to the returned
+ * Slot until it completes.
+ */
+ImmediateFuture<FsChannelOverloadController::Slot> admitExpensiveRequest(
+    FsChannelOverloadController& controller,
+    ThriftRequestScope& helper,
+    std::shared_ptr<EdenStats> stats,
+    ThriftStats::DurationPtr queueDelayStat) {
+  auto admission = controller.admit(
+      helper.getThriftFetchContext().getClientPid().value_or(0),
+      FsChannelOverloadController::RequestKind::Bulk);
+  if (!admission.isReady()) {
+    stats->increment(&ThriftStats::expensiveRequestsDeferred);
+  }
+  return std::move(admission).thenTry(
+      [stats = std::move(stats),
+       queueDelayStat](folly::Try<FsChannelOverloadController::Slot>&& slot) {
+        if (slot.hasException()) {
+          stats->increment(&ThriftStats::expensiveRequestsShed);
+        } else {
+          stats->addDuration(queueDelayStat, slot->getQueueDelay());
+        }
+        return std::move(slot);
+      });
+}
+
 #undef EDEN_MICRO
 
 RelativePath relpathFromUserPath(StringPiece userPath) {
@@ -448,6 +491,19 @@ EdenServiceHandler::EdenServiceHandler(
       thriftRequestTraceBus_(TraceBus<ThriftRequestTraceEvent>::create(
           "ThriftRequestTrace",
           kTraceBusCapacity)) {
+  {
+    auto config = server_->getServerState()->getEdenConfig();
+    FsChannelOverloadController::Config controllerConfig;
+    controllerConfig.maxInFlight =
+        config->thriftMaxExpensiveRequests.getValue();
+    controllerConfig.maxQueuedBulk =
+        config->thriftMaxQueuedExpensiveRequests.getValue();
+    controllerConfig.maxBulkInFlightPerPid =
+        config->thriftMaxExpensiveRequestsPerPid.getValue();
+    expensiveRequests_ =
+        std::make_shared<FsChannelOverloadController>(controllerConfig);
+  }
+
   struct HistConfig {
     int64_t bucketSize{250};
     int64_t min{0};
@@ -459,6 +515,9 @@ EdenServiceHandler::EdenServiceHandler(
       {"resetParentCommits", {20, 0, 1000}},
       {"getCurrentJournalPosition", {20, 0, 1000}},
       {"flushStatsNow", {20, 0, 1000}},
+      {"getLatencyHistograms", {20, 0, 1000}},
+      {"debugMemoryBreakdown", {20, 0, 1000}},
+      {"getRequestSamples", {20, 0, 1000}},
       {"reloadConfig", {200, 0, 10000}},
   };
 
@@ -605,6 +664,30 @@ EdenServiceHandler::semifuture_checkOutRevision(
       .semi();
 }
 
+folly::SemiFuture<std::unique_ptr<std::vector<CheckoutConflict>>>
+EdenServiceHandler::semifuture_applyMountFilter(
+    std::unique_ptr<std::string> mountPoint) {
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG1, *mountPoint);
+
+  auto mountPath = absolutePathFromThrift(*mountPoint);
+  auto edenMount = server_->getMount(mountPath);
+  auto applyFuture = ImmediateFuture{
+      edenMount
+          ->applyFilter(
+              helper->getFetchContext()->getClientPid(),
+              helper->getFunctionName())
+          .semi()};
+
+  return wrapImmediateFuture(
+             std::move(helper),
+             std::move(applyFuture)
+                 .thenValue([edenMount](CheckoutResult&& result) {
+                   return std::make_unique<std::vector<CheckoutConflict>>(
+                       std::move(result.conflicts));
+                 }))
+      .semi();
+}
+
 folly::SemiFuture<folly::Unit>
 EdenServiceHandler::semifuture_resetParentCommits(
     std::unique_ptr<std::string> mountPoint,
@@ -683,6 +766,38 @@ EdenServiceHandler::semifuture_synchronizeWorkingCopy(
       .semi();
 }
 
+namespace {
+/**
+ * Converts Thrift paths to RelativePaths. The error of each empty or invalid
+ * path is put at its index in results. Returns the valid paths and their
+ * indices.
+ */
+template <typename T>
+std::pair<std::vector<RelativePath>, std::vector<size_t>> parseThriftPaths(
+    const std::vector<std::string>& paths,
+    std::vector<folly::Try<T>>& results) {
+  std::vector<RelativePath> validPaths;
+  std::vector<size_t> validIndices;
+  for (size_t i = 0; i < paths.size(); ++i) {
+    if (paths[i].empty()) {
+      results[i] = folly::Try<T>{newEdenError(
+          EINVAL,
+          EdenErrorType::ARGUMENT_ERROR,
+          "path cannot be the empty string")};
+      continue;
+    }
+    try {
+      validPaths.emplace_back(paths[i]);
+      validIndices.push_back(i);
+    } catch (const std::exception& e) {
+      results[i] = folly::Try<T>{
+          newEdenError(EINVAL, EdenErrorType::ARGUMENT_ERROR, e.what())};
+    }
+  }
+  return {std::move(validPaths), std::move(validIndices)};
+}
+} // namespace
+
 folly::SemiFuture<std::unique_ptr<std::vector<SHA1Result>>>
 EdenServiceHandler::semifuture_getSHA1(
     std::unique_ptr<string> mountPoint,
@@ -699,22 +814,48 @@ EdenServiceHandler::semifuture_getSHA1(
   return wrapImmediateFuture(
              std::move(helper),
              std::move(notificationFuture)
-                 .thenValue([this,
-                             mount = std::move(mount),
+                 .thenValue([mount = std::move(mount),
                              paths = std::move(paths),
                              fetchContext =
                                  fetchContext.copy()](auto&&) mutable {
-                   std::vector<ImmediateFuture<Hash20>> futures;
-                   futures.reserve(paths->size());
-                   for (auto& path : *paths) {
-                     futures.push_back(makeImmediateFutureWith([&]() mutable {
-                       return getSHA1ForPath(
-                           *mount, RelativePath{std::move(path)}, fetchContext);
-                     }));
-                   }
-
-                   return collectAll(std::move(futures))
-                       .ensure([mount = std::move(mount)] {});
+                   // The paths are resolved together so that the
+                   // directories they share are only looked up once.
+                   std::vector<folly::Try<Hash20>> results(paths->size());
+                   auto [validPaths, validIndices] =
+                       parseThriftPaths(*paths, results);
+                   auto inodesFuture =
+                       mount->getVirtualInodes(validPaths, fetchContext);
+                   return std::move(inodesFuture)
+                       .thenValue([mount,
+                                   validPaths = std::move(validPaths),
+                                   fetchContext = fetchContext.copy()](
+                                      std::vector<folly::Try<VirtualInode>>&&
+                                          inodes) {
+                         std::vector<ImmediateFuture<Hash20>> futures;
+                         futures.reserve(inodes.size());
+                         for (size_t i = 0; i < inodes.size(); ++i) {
+                           if (inodes[i].hasException()) {
+                             futures.emplace_back(folly::Try<Hash20>{
+                                 std::move(inodes[i]).exception()});
+                             continue;
+                           }
+                           futures.emplace_back(inodes[i]->getSHA1(
+                               validPaths[i],
+                               mount->getObjectStore(),
+                               fetchContext));
+                         }
+                         return collectAll(std::move(futures));
+                       })
+                       .thenValue([results = std::move(results),
+                                   validIndices = std::move(validIndices)](
+                                      std::vector<folly::Try<Hash20>>&&
+                                          sha1s) mutable {
+                         XDCHECK_EQ(sha1s.size(), validIndices.size());
+                         for (size_t i = 0; i < sha1s.size(); ++i) {
+                           results[validIndices[i]] = std::move(sha1s[i]);
+                         }
+                         return std::move(results);
+                       });
                  })
                  .thenValue([](std::vector<folly::Try<Hash20>> results) {
                    auto out = std::make_unique<std::vector<SHA1Result>>();
@@ -734,58 +875,6 @@ EdenServiceHandler::semifuture_getSHA1(
       .semi();
 }
 
-ImmediateFuture<Hash20> EdenServiceHandler::getSHA1ForPath(
-    const EdenMount& edenMount,
-    RelativePath path,
-    const ObjectFetchContextPtr& fetchContext) {
-  if (path.empty()) {
-    return ImmediateFuture<Hash20>(newEdenError(
-        EINVAL,
-        EdenErrorType::ARGUMENT_ERROR,
-        "path cannot be the empty string"));
-  }
-
-  auto* objectStore = edenMount.getObjectStore();
-  auto inodeFut = edenMount.getVirtualInode(path, fetchContext);
-  return std::move(inodeFut).thenValue(
-      [path = std::move(path), objectStore, fetchContext = fetchContext.copy()](
-          const VirtualInode& virtualInode) {
-        return virtualInode.getSHA1(path, objectStore, fetchContext);
-      });
-}
-
-ImmediateFuture<EntryAttributes> EdenServiceHandler::getEntryAttributesForPath(
-    EntryAttributeFlags reqBitmask,
-    AbsolutePathPiece mountPoint,
-    StringPiece path,
-    const ObjectFetchContextPtr& fetchContext) {
-  if (path.empty()) {
-    return ImmediateFuture<EntryAttributes>(newEdenError(
-        EINVAL,
-        EdenErrorType::ARGUMENT_ERROR,
-        "path cannot be the empty string"));
-  }
-
-  try {
-    auto edenMount = server_->getMount(mountPoint);
-    auto objectStore = edenMount->getObjectStore();
-    auto relativePath = RelativePathPiece{path};
-
-    return edenMount->getVirtualInode(relativePath, fetchContext)
-        .thenValue([reqBitmask,
-                    relativePath,
-                    objectStore,
-                    fetchContext =
-                        fetchContext.copy()](const VirtualInode& virtualInode) {
-          return virtualInode.getEntryAttributes(
-              reqBitmask, relativePath, objectStore, fetchContext);
-        });
-  } catch (const std::exception& e) {
-    return ImmediateFuture<EntryAttributes>(
-        newEdenError(EINVAL, EdenErrorType::ARGUMENT_ERROR, e.what()));
-  }
-}
-
 void EdenServiceHandler::addBindMount(
     FOLLY_MAYBE_UNUSED std::unique_ptr<std::string> mountPoint,
     FOLLY_MAYBE_UNUSED std::unique_ptr<std::string> repoPath,
@@ -1301,13 +1390,21 @@ std::shared_ptr<HgQueuedBackingStore> castToHgQueuedBackingStore(
   std::shared_ptr<HgQueuedBackingStore> hgBackingStore{nullptr};
 
   // TODO: remove these dynamic casts in favor of a QueryInterface method
+  // FilteredBackingStore -> BackingStore
+  auto unfilteredBackingStore = backingStore;
+  if (auto filteredBackingStore =
+          std::dynamic_pointer_cast<FilteredBackingStore>(backingStore)) {
+    unfilteredBackingStore = filteredBackingStore->getBackingStore();
+  }
+
   // BackingStore -> LocalStoreCachedBackingStore
   auto localStoreCachedBackingStore =
-      std::dynamic_pointer_cast<LocalStoreCachedBackingStore>(backingStore);
+      std::dynamic_pointer_cast<LocalStoreCachedBackingStore>(
+          unfilteredBackingStore);
   if (!localStoreCachedBackingStore) {
     // BackingStore -> HgQueuedBackingStore
     hgBackingStore =
-        std::dynamic_pointer_cast<HgQueuedBackingStore>(backingStore);
+        std::dynamic_pointer_cast<HgQueuedBackingStore>(unfilteredBackingStore);
   } else {
     // LocalStoreCachedBackingStore -> HgQueuedBackingStore
     hgBackingStore = std::dynamic_pointer_cast<HgQueuedBackingStore>(
@@ -1328,6 +1425,20 @@ std::shared_ptr<HgQueuedBackingStore> castToHgQueuedBackingStore(
   return hgBackingStore;
 }
 
+HgImportCause thriftImportCause(ObjectFetchContext::Cause cause) {
+  switch (cause) {
+    case ObjectFetchContext::Cause::Unknown:
+      return HgImportCause::UNKNOWN;
+    case ObjectFetchContext::Cause::Fs:
+      return HgImportCause::FS;
+    case ObjectFetchContext::Cause::Thrift:
+      return HgImportCause::THRIFT;
+    case ObjectFetchContext::Cause::Prefetch:
+      return HgImportCause::PREFETCH;
+  }
+  return HgImportCause::UNKNOWN;
+}
+
 /**
  * Helper function to convert an HgImportTraceEvent to a thrift HgEvent type.
  * Used in EdenServiceHandler::traceHgEvents and
@@ -1370,22 +1481,10 @@ void convertHgImportTraceEventToHgEvent(
       break;
   }
 
-  switch (event.importCause) {
-    case ObjectFetchContext::Cause::Unknown:
-      te.importCause_ref() = HgImportCause::UNKNOWN;
-      break;
-    case ObjectFetchContext::Cause::Fs:
-      te.importCause_ref() = HgImportCause::FS;
-      break;
-    case ObjectFetchContext::Cause::Thrift:
-      te.importCause_ref() = HgImportCause::THRIFT;
-      break;
-    case ObjectFetchContext::Cause::Prefetch:
-      te.importCause_ref() = HgImportCause::PREFETCH;
-      break;
-  }
+  te.importCause_ref() = thriftImportCause(event.importCause);
 
   te.unique_ref() = event.unique;
+  te.traceId_ref() = event.traceId;
 
   te.manifestNodeId_ref() = event.manifestNodeId.toString();
   te.path_ref() = event.getPath();
@@ -1516,24 +1615,25 @@ void publishFile(
 
 class StreamingDiffCallback : public DiffCallback {
  public:
-  explicit StreamingDiffCallback(
+  StreamingDiffCallback(
       std::shared_ptr<
           folly::Synchronized<ThriftStreamPublisherOwner<ChangedFileResult>>>
-          publisher)
-      : publisher_{std::move(publisher)} {}
+          publisher,
+      std::shared_ptr<const ChangesSinceFilter> filter)
+      : publisher_{std::move(publisher)}, filter_{std::move(filter)} {}
 
   void ignoredPath(RelativePathPiece, dtype_t) override {}
 
   void addedPath(RelativePathPiece path, dtype_t type) override {
-    publishFile(*publisher_, path.stringPiece(), ScmFileStatus::ADDED, type);
+    publish(path, ScmFileStatus::ADDED, type);
   }
 
   void removedPath(RelativePathPiece path, dtype_t type) override {
-    publishFile(*publisher_, path.stringPiece(), ScmFileStatus::REMOVED, type);
+    publish(path, ScmFileStatus::REMOVED, type);
   }
 
   void modifiedPath(RelativePathPiece path, dtype_t type) override {
-    publishFile(*publisher_, path.stringPiece(), ScmFileStatus::MODIFIED, type);
+    publish(path, ScmFileStatus::MODIFIED, type);
   }
 
   void diffError(RelativePathPiece /*path*/, const folly::exception_wrapper& ew)
@@ -1543,9 +1643,16 @@ class StreamingDiffCallback : public DiffCallback {
   }
 
  private:
+  void publish(RelativePathPiece path, ScmFileStatus status, dtype_t type) {
+    if (filter_->matchesAll() || filter_->matches(path)) {
+      publishFile(*publisher_, path.stringPiece(), status, type);
+    }
+  }
+
   std::shared_ptr<
       folly::Synchronized<ThriftStreamPublisherOwner<ChangedFileResult>>>
       publisher_;
+  std::shared_ptr<const ChangesSinceFilter> filter_;
 };
 
 } // namespace
@@ -1573,11 +1680,26 @@ EdenServiceHandler::streamChangesSince(
 
   checkMountGeneration(fromPosition, edenMount, "fromPosition"sv);
 
+  auto filter = std::make_shared<const ChangesSinceFilter>(
+      *params,
+      *params->includeIgnored()
+          ? nullptr
+          : server_->getServerState()->getTopLevelIgnores(),
+      edenMount->getCheckoutConfig()->getCaseSensitive());
+  // Filter while accumulating, so that the rejected paths are neither
+  // accumulated nor serialized.
+  Journal::PathFilter pathFilter;
+  if (!filter->matchesAll()) {
+    pathFilter = [filter](RelativePathPiece path) {
+      return filter->matches(path);
+    };
+  }
+
   // The +1 is because the core merge stops at the item prior to
   // its limitSequence parameter and we want the changes *since*
   // the provided sequence number.
   auto summed = edenMount->getJournal().accumulateRange(
-      *fromPosition.sequenceNumber_ref() + 1);
+      *fromPosition.sequenceNumber_ref() + 1, pathFilter);
 
   ChangesSinceResult result;
   if (!summed) {
@@ -1638,7 +1760,8 @@ EdenServiceHandler::streamChangesSince(
   }
 
   if (summed->snapshotTransitions.size() > 1) {
-    auto callback = std::make_shared<StreamingDiffCallback>(sharedPublisher);
+    auto callback =
+        std::make_shared<StreamingDiffCallback>(sharedPublisher, filter);
 
     std::vector<ImmediateFuture<folly::Unit>> futures;
     for (auto rootIt = summed->snapshotTransitions.begin();
@@ -1996,6 +2119,7 @@ bool fillErrorRef(
 }
 
 FileAttributeDataOrErrorV2 serializeEntryAttributes(
+    const ObjectStore& objectStore,
     folly::StringPiece entryPath,
     const folly::Try<EntryAttributes>& attributes,
     EntryAttributeFlags requestedAttributes) {
@@ -2032,12 +2156,23 @@ FileAttributeDataOrErrorV2 serializeEntryAttributes(
       }
       fileData.sourceControlType() = std::move(type);
     }
+
+    if (requestedAttributes.contains(ENTRY_ATTRIBUTE_OBJECT_ID)) {
+      ObjectIdOrError objectId;
+      if (!fillErrorRef<ObjectIdOrError, ObjectId>(
+              objectId, attributes->objectId, entryPath, "objectId")) {
+        objectId.objectId_ref() =
+            objectStore.renderObjectId(attributes->objectId.value().value());
+      }
+      fileData.objectId() = std::move(objectId);
+    }
     fileResult.fileAttributeData_ref() = fileData;
   }
   return fileResult;
 }
 
 DirListAttributeDataOrError serializeEntryAttributes(
+    const ObjectStore& objectStore,
     const folly::Try<std::vector<
         std::pair<PathComponent, folly::Try<EntryAttributes>>>>& entries,
     EntryAttributeFlags requestedAttributes) {
@@ -2051,6 +2186,7 @@ DirListAttributeDataOrError serializeEntryAttributes(
     thriftEntryResult.emplace(
         entry.first.asString(),
         serializeEntryAttributes(
+            objectStore,
             entry.first.piece().stringPiece(),
             entry.second,
             requestedAttributes));
@@ -2096,13 +2232,15 @@ EdenServiceHandler::semifuture_readdir(std::unique_ptr<ReaddirParams> params) {
                                  *edenMount,
                                  std::move(path),
                                  fetchContext)
-                                 .thenTry([requestedAttributes](
+                                 .thenTry([requestedAttributes, edenMount](
                                               folly::Try<std::vector<std::pair<
                                                   PathComponent,
                                                   folly::Try<EntryAttributes>>>>
                                                   entries) {
                                    return serializeEntryAttributes(
-                                       entries, requestedAttributes);
+                                       *edenMount->getObjectStore(),
+                                       entries,
+                                       requestedAttributes);
                                  })
 
                          );
@@ -2134,20 +2272,83 @@ EdenServiceHandler::getEntryAttributes(
     EntryAttributeFlags reqBitmask,
     SyncBehavior sync,
     const ObjectFetchContextPtr& fetchContext) {
-  return waitForPendingNotifications(*server_->getMount(mountPath), sync)
-      .thenValue([this,
+  auto edenMount = server_->getMount(mountPath);
+  auto notificationsFuture = waitForPendingNotifications(*edenMount, sync);
+  return std::move(notificationsFuture)
+      .thenValue([edenMount = std::move(edenMount),
                   &paths,
                   fetchContext = fetchContext.copy(),
-                  mountPath = mountPath.copy(),
                   reqBitmask](auto&&) mutable {
-        vector<ImmediateFuture<EntryAttributes>> futures;
-        for (const auto& p : paths) {
-          futures.emplace_back(getEntryAttributesForPath(
-              reqBitmask, mountPath, p, fetchContext));
-        }
-
-        // Collect all futures into a single tuple
-        return facebook::eden::collectAll(std::move(futures));
+        // Invalid paths are answered right away, the others are resolved
+        // together so that the directories they share are only looked up
+        // once.
+        std::vector<folly::Try<EntryAttributes>> results(paths.size());
+        auto [validPaths, validIndices] = parseThriftPaths(paths, results);
+
+        auto inodesFuture =
+            edenMount->getVirtualInodes(validPaths, fetchContext);
+        return std::move(inodesFuture)
+            .thenValue([edenMount,
+                        validPaths = std::move(validPaths),
+                        fetchContext = fetchContext.copy(),
+                        reqBitmask](
+                           std::vector<folly::Try<VirtualInode>>&& inodes) {
+              auto* objectStore = edenMount->getObjectStore();
+              // The metadata of the entries that are still source control
+              // objects is fetched as one batch ahead of the per-entry
+              // lookups, which then find it in memory.
+              std::vector<ObjectId> blobIds;
+              if (reqBitmask.containsAnyOf(
+                      ENTRY_ATTRIBUTE_SIZE | ENTRY_ATTRIBUTE_SHA1)) {
+                for (const auto& inode : inodes) {
+                  if (inode.hasValue() &&
+                      inode->getDtype() == dtype_t::Regular) {
+                    if (auto id = inode->getObjectId()) {
+                      blobIds.push_back(std::move(*id));
+                    }
+                  }
+                }
+              }
+              auto prefetch = blobIds.empty()
+                  ? ImmediateFuture<folly::Unit>{folly::unit}
+                  : objectStore->getBlobMetadataBatch(blobIds, fetchContext)
+                        .thenValue([](auto&&) {});
+
+              return std::move(prefetch).thenTry(
+                  [validPaths = std::move(validPaths),
+                   inodes = std::move(inodes),
+                   objectStore,
+                   fetchContext = fetchContext.copy(),
+                   reqBitmask](folly::Try<folly::Unit>&&) {
+                    // Errors of the batch are reported by the lookups of the
+                    // entries they affect.
+                    std::vector<ImmediateFuture<EntryAttributes>> futures;
+                    futures.reserve(inodes.size());
+                    for (size_t i = 0; i < inodes.size(); ++i) {
+                      if (inodes[i].hasException()) {
+                        futures.emplace_back(folly::Try<EntryAttributes>{
+                            std::move(inodes[i]).exception()});
+                        continue;
+                      }
+                      futures.emplace_back(inodes[i]->getEntryAttributes(
+                          reqBitmask,
+                          validPaths[i],
+                          objectStore,
+                          fetchContext));
+                    }
+                    return collectAll(std::move(futures));
+                  });
+            })
+            .thenValue([results = std::move(results),
+                        validIndices = std::move(validIndices)](
+                           std::vector<folly::Try<EntryAttributes>>&&
+                               attributes) mutable {
+              XDCHECK_EQ(attributes.size(), validIndices.size());
+              for (size_t i = 0; i < attributes.size(); ++i) {
+                results[validIndices[i]] = std::move(attributes[i]);
+              }
+              return std::move(results);
+            });
       });
 }
 
@@ -2265,6 +2466,7 @@ EdenServiceHandler::semifuture_getAttributesFromFilesV2(
       DBG3, mountPoint, getSyncTimeout(*params->sync()), toLogArg(paths));
   auto& fetchContext = helper->getFetchContext();
 
+  auto edenMount = server_->getMount(mountPath);
   auto entryAttributesFuture = getEntryAttributes(
       mountPath, paths, reqBitmask, *params->sync(), fetchContext);
 
@@ -2272,13 +2474,14 @@ EdenServiceHandler::semifuture_getAttributesFromFilesV2(
              std::move(helper),
              std::move(entryAttributesFuture)
                  .thenValue(
-                     [reqBitmask, &paths](
+                     [reqBitmask, &paths, edenMount = std::move(edenMount)](
                          std::vector<folly::Try<EntryAttributes>>&& allRes) {
                        auto res =
                            std::make_unique<GetAttributesFromFilesResultV2>();
                        size_t index = 0;
                        for (const auto& tryAttributes : allRes) {
                          res->res_ref()->emplace_back(serializeEntryAttributes(
+                             *edenMount->getObjectStore(),
                              basename(paths.at(index)),
                              tryAttributes,
                              reqBitmask));
@@ -2363,20 +2566,29 @@ folly::SemiFuture<folly::Unit> EdenServiceHandler::semifuture_removeRecursively(
   auto edenMount = server_->getMount(mountPath);
 
   auto relativePath = RelativePath{repoPath};
+  if (relativePath.empty()) {
+    throw newEdenError(
+        EINVAL,
+        EdenErrorType::ARGUMENT_ERROR,
+        "cannot remove the root of the mount");
+  }
   auto& fetchContext = helper->getFetchContext();
 
+  // Only the parent is loaded: when the removed entry isn't, it is detached
+  // without loading anything below it.
   return wrapImmediateFuture(
              std::move(helper),
              waitForPendingNotifications(*edenMount, *params->sync())
                  .thenValue([edenMount,
                              relativePath,
                              fetchContext = fetchContext.copy()](folly::Unit) {
-                   return edenMount->getInodeSlow(relativePath, fetchContext);
+                   return edenMount->getInodeSlow(
+                       relativePath.dirname(), fetchContext);
                  })
                  .thenValue(
                      [relativePath = std::move(relativePath),
-                      fetchContext = fetchContext.copy()](InodePtr inode) {
-                       return inode->getParentRacy()->removeRecursively(
+                      fetchContext = fetchContext.copy()](InodePtr parent) {
+                       return parent.asTreePtr()->removeRecursively(
                            relativePath.basename(),
                            InvalidationRequired::Yes,
                            fetchContext);
@@ -2384,6 +2596,24 @@ folly::SemiFuture<folly::Unit> EdenServiceHandler::semifuture_removeRecursively(
       .semi();
 }
 
+folly::SemiFuture<folly::Unit> EdenServiceHandler::semifuture_cloneDirectory(
+    std::unique_ptr<CloneDirectoryParams> params) {
+  auto mountPoint = *params->mountPoint();
+  auto helper = INSTRUMENT_THRIFT_CALL(
+      DBG2, mountPoint, *params->source(), *params->destination());
+  auto edenMount = server_->getMount(absolutePathFromThrift(mountPoint));
+
+  auto cloneFuture = edenMount->cloneDirectory(
+      RelativePath{*params->source()},
+      RelativePath{*params->destination()},
+      helper->getFetchContext());
+  return wrapImmediateFuture(
+             std::move(helper),
+             std::move(cloneFuture)
+                 .ensure([edenMount = std::move(edenMount)] {}))
+      .semi();
+}
+
 namespace {
 ImmediateFuture<std::unique_ptr<Glob>> detachIfBackgrounded(
     ImmediateFuture<std::unique_ptr<Glob>> globFuture,
@@ -2450,11 +2680,78 @@ void maybeLogExpensiveGlob(
 
 #ifndef _WIN32
 namespace {
+/**
+ * The state shared by the materializations of an ensureMaterialized call.
+ */
+struct EnsureMaterializedWalk {
+  // Bounds how many files fetch their blob and write it to the overlay at
+  // once.
+  std::shared_ptr<FsChannelOverloadController> files;
+  std::shared_ptr<EdenStats> stats;
+  bool followSymlink;
+  std::atomic<uint64_t> fileCount{0};
+  std::atomic<uint64_t> byteCount{0};
+};
+
+/**
+ * Materializes inode, and everything below it if it is a directory. The
+ * directories are walked as soon as their trees are loaded, while the files
+ * wait for a slot to materialize.
+ */
+ImmediateFuture<folly::Unit> ensureMaterializedInode(
+    InodePtr inode,
+    std::shared_ptr<EnsureMaterializedWalk> walk,
+    const ObjectFetchContextPtr& fetchContext) {
+  if (auto tree = inode.asTreePtrOrNull()) {
+    std::vector<PathComponent> names;
+    {
+      auto contents = tree->getContents().rlock();
+      names.reserve(contents->entries.size());
+      for (auto& entry : contents->entries) {
+        names.emplace_back(entry.first);
+      }
+    }
+
+    std::vector<ImmediateFuture<folly::Unit>> childFutures;
+    childFutures.reserve(names.size());
+    for (auto& name : names) {
+      childFutures.emplace_back(
+          tree->getOrLoadChild(name, fetchContext)
+              .thenValue([walk, fetchContext = fetchContext.copy()](
+                             InodePtr child) mutable {
+                return ensureMaterializedInode(
+                    std::move(child), std::move(walk), fetchContext);
+              }));
+    }
+    return collectAll(std::move(childFutures)).unit();
+  }
+
+  return walk->files->admit(0, FsChannelOverloadController::RequestKind::Bulk)
+      .thenValue([inode = std::move(inode),
+                  walk,
+                  fetchContext = fetchContext.copy()](
+                     FsChannelOverloadController::Slot&& slot) {
+        return inode->ensureMaterialized(fetchContext, walk->followSymlink)
+            .thenValue([inode, fetchContext = fetchContext.copy()](auto&&) {
+              return inode->stat(fetchContext);
+            })
+            .thenValue([walk](struct stat&& st) {
+              walk->fileCount.fetch_add(1, std::memory_order_relaxed);
+              auto size = static_cast<uint64_t>(st.st_size);
+              walk->byteCount.fetch_add(size, std::memory_order_relaxed);
+              walk->stats->increment(&ThriftStats::ensureMaterializedFiles);
+              walk->stats->increment(
+                  &ThriftStats::ensureMaterializedBytes, size);
+            })
+            .ensure([slot = std::move(slot)] {});
+      });
+}
+
 ImmediateFuture<folly::Unit> ensureMaterializedImpl(
     std::shared_ptr<EdenMount> edenMount,
     const std::vector<std::string>& repoPaths,
     std::unique_ptr<ThriftRequestScope> helper,
-    bool followSymlink) {
+    std::shared_ptr<EnsureMaterializedWalk> walk) {
   std::vector<ImmediateFuture<folly::Unit>> futures;
   futures.reserve(repoPaths.size());
 
@@ -2468,15 +2765,35 @@ ImmediateFuture<folly::Unit> ensureMaterializedImpl(
                         fetchContext = fetchContext.copy()](auto&&) {
               return edenMount->getInodeSlow(path, fetchContext);
             })
-            .thenValue([fetchContext = fetchContext.copy(),
-                        followSymlink](InodePtr inode) {
-              return inode->ensureMaterialized(fetchContext, followSymlink)
-                  .ensure([inode]() {});
+            .thenValue([walk, fetchContext = fetchContext.copy()](
+                           InodePtr inode) mutable {
+              return ensureMaterializedInode(
+                  std::move(inode), std::move(walk), fetchContext);
             }));
   }
 
+  folly::stop_watch<std::chrono::milliseconds> timer;
   return wrapImmediateFuture(
-      std::move(helper), collectAll(std::move(futures)).unit());
+      std::move(helper),
+      collectAll(std::move(futures))
+          .unit()
+          .ensure([walk = std::move(walk), timer] {
+            auto seconds =
+                std::chrono::duration<double>{timer.elapsed()}.count();
+            auto files = walk->fileCount.load(std::memory_order_relaxed);
+            auto megabytes = static_cast<double>(walk->byteCount.load(
+                                 std::memory_order_relaxed)) /
+                (1024 * 1024);
+            XLOGF(
+                DBG2,
+                "ensureMaterialized: {} files, {:.1f} MB in {:.3f}s "
+                "({:.0f} files/s, {:.1f} MB/s)",
+                files,
+                megabytes,
+                seconds,
+                seconds > 0 ? files / seconds : 0.0,
+                seconds > 0 ? megabytes / seconds : 0.0);
+          }));
 }
 } // namespace
 #endif
@@ -2498,18 +2815,28 @@ EdenServiceHandler::semifuture_ensureMaterialized(
   // execution starting by read large files on the background.
   bool background = *params->background();
 
+  FsChannelOverloadController::Config filesConfig;
+  filesConfig.maxInFlight = server_->getServerState()
+                                ->getEdenConfig()
+                                ->ensureMaterializedMaxInFlightFiles.getValue();
+  auto walk = std::make_shared<EnsureMaterializedWalk>();
+  walk->files = std::make_shared<FsChannelOverloadController>(filesConfig);
+  walk->stats = server_->getSharedStats();
+
   auto waitForPendingNotificationsFuture =
       waitForPendingNotifications(*edenMount, *params->sync());
   auto ensureMaterializedFuture =
       std::move(waitForPendingNotificationsFuture)
           .thenValue([params = std::move(params),
                       edenMount = std::move(edenMount),
-                      helper = std::move(helper)](auto&&) mutable {
+                      helper = std::move(helper),
+                      walk = std::move(walk)](auto&&) mutable {
+            walk->followSymlink = *params->followSymlink();
             return ensureMaterializedImpl(
                 std::move(edenMount),
                 (*params->paths()),
                 std::move(helper),
-                (*params->followSymlink()));
+                std::move(walk));
           })
           .semi();
 
@@ -2589,6 +2916,11 @@ EdenServiceHandler::semifuture_predictiveGlobFiles(
 
   auto& fetchContext = helper->getPrefetchFetchContext();
   bool background = *params->background();
+  auto admission = admitExpensiveRequest(
+      *expensiveRequests_,
+      *helper,
+      server_->getSharedStats(),
+      &ThriftStats::predictiveGlobFilesQueueDelay);
 
   auto future =
       ImmediateFuture{spServiceEndpoint_
@@ -2604,9 +2936,20 @@ EdenServiceHandler::semifuture_predictiveGlobFiles(
           .thenValue([globber = std::move(globber),
                       edenMount = std::move(edenMount),
                       serverState,
-                      fetchContext = fetchContext.copy()](
+                      fetchContext = fetchContext.copy(),
+                      admission = std::move(admission)](
                          std::vector<std::string>&& globs) mutable {
-            return globber.glob(edenMount, serverState, globs, fetchContext);
+            return std::move(admission).thenValue(
+                [globber = std::move(globber),
+                 edenMount = std::move(edenMount),
+                 serverState = std::move(serverState),
+                 fetchContext = std::move(fetchContext),
+                 globs = std::move(globs)](
+                    FsChannelOverloadController::Slot&& slot) mutable {
+                  return globber
+                      .glob(edenMount, serverState, globs, fetchContext)
+                      .ensure([slot = std::move(slot)] {});
+                });
           })
           .thenTry([params = std::move(params), helper = std::move(helper)](
                        folly::Try<std::unique_ptr<Glob>> tryGlob) {
@@ -2648,15 +2991,26 @@ EdenServiceHandler::semifuture_globFiles(std::unique_ptr<GlobParams> params) {
       context,
       server_->getServerState());
 
+  auto admission = admitExpensiveRequest(
+      *expensiveRequests_,
+      *helper,
+      server_->getSharedStats(),
+      &ThriftStats::globFilesQueueDelay);
+
   auto globFut =
       std::move(backgroundFuture)
+          .thenValue([admission = std::move(admission)](auto&&) mutable {
+            return std::move(admission);
+          })
           .thenValue([mount = server_->getMount(
                           absolutePathFromThrift(*params->mountPoint())),
                       serverState = server_->getServerState(),
                       globs = std::move(*params->globs()),
                       globber = std::move(globber),
-                      &context](auto&&) mutable {
-            return globber.glob(mount, serverState, std::move(globs), context);
+                      &context](
+                         FsChannelOverloadController::Slot&& slot) mutable {
+            return globber.glob(mount, serverState, std::move(globs), context)
+                .ensure([slot = std::move(slot)] {});
           });
   globFut = std::move(globFut).ensure(
       [helper = std::move(helper), params = std::move(params)] {});
@@ -2665,6 +3019,78 @@ EdenServiceHandler::semifuture_globFiles(std::unique_ptr<GlobParams> params) {
       .semi();
 }
 
+apache::thrift::ServerStream<GlobFileResult>
+EdenServiceHandler::streamGlobFiles(std::unique_ptr<GlobParams> params) {
+  ThriftGlobImpl globber{*params};
+  auto helper = INSTRUMENT_THRIFT_CALL(
+      DBG3,
+      *params->mountPoint_ref(),
+      toLogArg(*params->globs_ref()),
+      globber.logString());
+  auto& context = helper->getFetchContext();
+  auto edenMount =
+      server_->getMount(absolutePathFromThrift(*params->mountPoint()));
+
+  maybeLogExpensiveGlob(
+      *params->globs(),
+      *params->searchRoot_ref(),
+      globber,
+      context,
+      server_->getServerState());
+
+  auto [serverStream, publisher] =
+      apache::thrift::ServerStream<GlobFileResult>::createPublisher([] {});
+  auto sharedPublisher = std::make_shared<
+      folly::Synchronized<ThriftStreamPublisherOwner<GlobFileResult>>>(
+      ThriftStreamPublisherOwner{std::move(publisher)});
+
+  // Evaluate the glob on a background thread, publishing the files while
+  // the rest of the tree is being fetched.
+  auto globFuture = makeNotReadyImmediateFuture().thenValue(
+      [edenMount,
+       serverState = server_->getServerState(),
+       globs = std::move(*params->globs()),
+       globber = std::move(globber),
+       &context,
+       sharedPublisher](auto&&) mutable {
+        return globber.streamGlob(
+            edenMount,
+            serverState,
+            std::move(globs),
+            context,
+            [edenMount, sharedPublisher](
+                RelativePathPiece name,
+                dtype_t dtype,
+                const RootId& originRootId) {
+              GlobFileResult result;
+              result.name() = name.asString();
+              result.dtype() = static_cast<OsDtype>(dtype);
+              result.originHash() =
+                  edenMount->getObjectStore()->renderRootId(originRootId);
+              sharedPublisher->rlock()->next(std::move(result));
+            });
+      });
+
+  folly::futures::detachOn(
+      server_->getServerState()->getThreadPool().get(),
+      std::move(globFuture)
+          // The stream completes once the last reference to the publisher
+          // is dropped.
+          .thenTry([sharedPublisher,
+                    helper = std::move(helper),
+                    params = std::move(params)](
+                       folly::Try<folly::Unit>&& result) mutable {
+            if (result.hasException()) {
+              auto publisher = std::move(*sharedPublisher->wlock());
+              std::move(publisher).next(
+                  newEdenError(std::move(result).exception()));
+            }
+          })
+          .semi());
+
+  return std::move(serverStream);
+}
+
 folly::SemiFuture<folly::Unit> EdenServiceHandler::semifuture_prefetchFiles(
     std::unique_ptr<PrefetchParams> params) {
   ThriftGlobImpl globber{*params};
@@ -2688,16 +3114,26 @@ folly::SemiFuture<folly::Unit> EdenServiceHandler::semifuture_prefetchFiles(
       context,
       server_->getServerState());
 
+  auto admission = admitExpensiveRequest(
+      *expensiveRequests_,
+      *helper,
+      server_->getSharedStats(),
+      &ThriftStats::prefetchFilesQueueDelay);
+
   auto globFut =
       std::move(backgroundFuture)
+          .thenValue([admission = std::move(admission)](auto&&) mutable {
+            return std::move(admission);
+          })
           .thenValue([mount = server_->getMount(
                           absolutePathFromThrift(*params->mountPoint())),
                       serverState = server_->getServerState(),
                       globs = std::move(*params->globs()),
                       globber = std::move(globber),
                       context = helper->getPrefetchFetchContext().copy()](
-                         auto&&) mutable {
-            return globber.glob(mount, serverState, std::move(globs), context);
+                         FsChannelOverloadController::Slot&& slot) mutable {
+            return globber.glob(mount, serverState, std::move(globs), context)
+                .ensure([slot = std::move(slot)] {});
           })
           .thenValue([](std::unique_ptr<Glob>) { return folly::unit; });
   globFut = std::move(globFut).ensure(
@@ -2738,14 +3174,25 @@ EdenServiceHandler::semifuture_getScmStatusV2(
                                    ->getReloadableConfig()
                                    ->getEdenConfig()
                                    ->enforceParents.getValue();
+  auto admission = admitExpensiveRequest(
+      *expensiveRequests_,
+      *helper,
+      server_->getSharedStats(),
+      &ThriftStats::getScmStatusV2QueueDelay);
   return wrapImmediateFuture(
              std::move(helper),
-             mount
-                 ->diff(
-                     rootId,
-                     context->getConnectionContext()->getCancellationToken(),
-                     *params->listIgnored_ref(),
-                     enforceParents)
+             std::move(admission)
+                 .thenValue([mount,
+                             rootId = std::move(rootId),
+                             token = context->getConnectionContext()
+                                         ->getCancellationToken(),
+                             listIgnored = *params->listIgnored_ref(),
+                             enforceParents](
+                                FsChannelOverloadController::Slot&& slot) {
+                   return mount
+                       ->diff(rootId, token, listIgnored, enforceParents)
+                       .ensure([slot = std::move(slot)] {});
+                 })
                  .thenValue([this, mount](std::unique_ptr<ScmStatus>&& status) {
                    auto result = std::make_unique<GetScmStatusResult>();
                    result->status_ref() = std::move(*status);
@@ -2774,13 +3221,27 @@ EdenServiceHandler::semifuture_getScmStatus(
   auto mountPath = absolutePathFromThrift(*mountPoint);
   auto mount = server_->getMount(mountPath);
   auto hash = mount->getObjectStore()->parseRootId(*commitHash);
+  auto admission = admitExpensiveRequest(
+      *expensiveRequests_,
+      *helper,
+      server_->getSharedStats(),
+      &ThriftStats::getScmStatusQueueDelay);
   return wrapImmediateFuture(
              std::move(helper),
-             mount->diff(
-                 hash,
-                 context->getConnectionContext()->getCancellationToken(),
-                 listIgnored,
-                 /*enforceCurrentParent=*/false))
+             std::move(admission).thenValue(
+                 [mount,
+                  hash = std::move(hash),
+                  token =
+                      context->getConnectionContext()->getCancellationToken(),
+                  listIgnored](FsChannelOverloadController::Slot&& slot) {
+                   return mount
+                       ->diff(
+                           hash,
+                           token,
+                           listIgnored,
+                           /*enforceCurrentParent=*/false)
+                       .ensure([slot = std::move(slot)] {});
+                 }))
       .semi();
 }
 
@@ -2814,23 +3275,19 @@ EdenServiceHandler::semifuture_getScmStatusBetweenRevisions(
       .semi();
 }
 
-void EdenServiceHandler::debugGetScmTree(
-    vector<ScmTreeEntry>& entries,
-    unique_ptr<string> mountPoint,
-    unique_ptr<string> idStr,
-    bool localStoreOnly) {
-  auto helper = INSTRUMENT_THRIFT_CALL(DBG2, *mountPoint, logHash(*idStr));
-  auto mountPath = absolutePathFromThrift(*mountPoint);
-  auto edenMount = server_->getMount(mountPath);
-  auto id = edenMount->getObjectStore()->parseObjectId(*idStr);
+namespace {
 
+std::shared_ptr<const Tree> loadScmTree(
+    ObjectStore& store,
+    const ObjectId& id,
+    bool localStoreOnly,
+    const ObjectFetchContextPtr& fetchContext) {
   std::shared_ptr<const Tree> tree;
-  auto store = edenMount->getObjectStore();
   if (localStoreOnly) {
-    auto localStore = store->getLocalStore();
+    auto localStore = store.getLocalStore();
     tree = localStore->getTree(id).get();
   } else {
-    tree = store->getTree(id, helper->getFetchContext()).get();
+    tree = store.getTree(id, fetchContext).get();
   }
 
   if (!tree) {
@@ -2838,37 +3295,498 @@ void EdenServiceHandler::debugGetScmTree(
         ENOENT,
         EdenErrorType::POSIX_ERROR,
         "no tree found for id ",
-        edenMount->getObjectStore()->renderObjectId(id));
+        store.renderObjectId(id));
   }
+  return tree;
+}
 
-  for (const auto& entry : *tree) {
+std::vector<ScmTreeEntry> serializeScmTree(
+    const ObjectStore& store,
+    const Tree& tree) {
+  std::vector<ScmTreeEntry> entries;
+  entries.reserve(tree.size());
+  for (const auto& entry : tree) {
     const auto& [name, treeEntry] = entry;
     entries.emplace_back();
     auto& out = entries.back();
     out.name_ref() = name.asString();
     out.mode_ref() = modeFromTreeEntryType(treeEntry.getType());
-    out.id_ref() =
-        edenMount->getObjectStore()->renderObjectId(treeEntry.getHash());
+    out.id_ref() = store.renderObjectId(treeEntry.getHash());
   }
+  return entries;
 }
 
-void EdenServiceHandler::debugGetScmBlob(
-    string& data,
+/**
+ * The bounds of a streaming debug walk: those requested by the client,
+ * capped by the configured ones.
+ */
+struct WalkLimits {
+  WalkLimits(const DebugWalkLimits& requested, const EdenConfig& config) {
+    auto resolve = [](int64_t value, size_t limit) {
+      return value <= 0 ? limit : std::min(static_cast<size_t>(value), limit);
+    };
+    maxDepth = resolve(
+        *requested.maxDepth(), config.thriftDebugWalkMaxDepth.getValue());
+    maxEntries = resolve(
+        *requested.maxEntries(), config.thriftDebugWalkMaxEntries.getValue());
+  }
+
+  size_t maxDepth;
+  size_t maxEntries;
+};
+
+EdenError walkTruncatedError(size_t maxEntries) {
+  return newEdenError(
+      EdenErrorType::GENERIC_ERROR,
+      "walk stopped after ",
+      maxEntries,
+      " entries");
+}
+
+/**
+ * Publish the tree id, found at path, and its subtrees, depth-first.
+ *
+ * Returns false if the walk stopped because of the entry limit.
+ */
+bool walkScmTree(
+    ObjectStore& store,
+    const ObjectId& id,
+    RelativePathPiece path,
+    size_t depth,
+    const WalkLimits& limits,
+    size_t& entryCount,
+    bool localStoreOnly,
+    const ObjectFetchContextPtr& fetchContext,
+    folly::FunctionRef<void(ScmTreeChunk&&)> publish) {
+  auto tree = loadScmTree(store, id, localStoreOnly, fetchContext);
+  if (entryCount + tree->size() > limits.maxEntries) {
+    return false;
+  }
+  entryCount += tree->size();
+
+  ScmTreeChunk chunk;
+  chunk.path() = path.asString();
+  chunk.id() = store.renderObjectId(id);
+  chunk.entries() = serializeScmTree(store, *tree);
+  publish(std::move(chunk));
+
+  if (depth >= limits.maxDepth) {
+    return true;
+  }
+  for (const auto& [name, entry] : *tree) {
+    if (entry.isTree() &&
+        !walkScmTree(
+            store,
+            entry.getHash(),
+            path + name,
+            depth + 1,
+            limits,
+            entryCount,
+            localStoreOnly,
+            fetchContext,
+            publish)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+void EdenServiceHandler::debugGetScmTree(
+    vector<ScmTreeEntry>& entries,
     unique_ptr<string> mountPoint,
     unique_ptr<string> idStr,
     bool localStoreOnly) {
   auto helper = INSTRUMENT_THRIFT_CALL(DBG2, *mountPoint, logHash(*idStr));
   auto mountPath = absolutePathFromThrift(*mountPoint);
   auto edenMount = server_->getMount(mountPath);
-  auto id = edenMount->getObjectStore()->parseObjectId(*idStr);
+  auto store = edenMount->getObjectStore();
+  auto id = store->parseObjectId(*idStr);
+
+  auto tree =
+      loadScmTree(*store, id, localStoreOnly, helper->getFetchContext());
+  entries = serializeScmTree(*store, *tree);
+}
+
+apache::thrift::ServerStream<ScmTreeChunk> EdenServiceHandler::streamScmTree(
+    std::unique_ptr<StreamScmTreeParams> params) {
+  auto helper = INSTRUMENT_THRIFT_CALL(
+      DBG2, *params->mountPoint(), logHash(*params->id()));
+  auto edenMount =
+      server_->getMount(absolutePathFromThrift(*params->mountPoint()));
+  auto id = edenMount->getObjectStore()->parseObjectId(*params->id());
+  WalkLimits limits{
+      *params->limits(), *server_->getServerState()->getEdenConfig()};
+
+  auto [serverStream, publisher] =
+      apache::thrift::ServerStream<ScmTreeChunk>::createPublisher([] {});
+  auto sharedPublisher = std::make_shared<
+      folly::Synchronized<ThriftStreamPublisherOwner<ScmTreeChunk>>>(
+      ThriftStreamPublisherOwner{std::move(publisher)});
+
+  // Walk on a background thread, each tree being published as soon as it is
+  // loaded rather than the whole walk being held in memory.
+  auto walkFuture = makeNotReadyImmediateFuture().thenValue(
+      [edenMount,
+       id = std::move(id),
+       limits,
+       localStoreOnly = *params->localStoreOnly(),
+       &fetchContext = helper->getFetchContext(),
+       sharedPublisher](auto&&) {
+        size_t entryCount = 0;
+        if (!walkScmTree(
+                *edenMount->getObjectStore(),
+                id,
+                RelativePathPiece{},
+                0,
+                limits,
+                entryCount,
+                localStoreOnly,
+                fetchContext,
+                [&](ScmTreeChunk&& chunk) {
+                  sharedPublisher->rlock()->next(std::move(chunk));
+                })) {
+          throw walkTruncatedError(limits.maxEntries);
+        }
+      });
 
+  folly::futures::detachOn(
+      server_->getServerState()->getThreadPool().get(),
+      std::move(walkFuture)
+          // The stream completes once the last reference to the publisher
+          // is dropped.
+          .thenTry([sharedPublisher,
+                    helper = std::move(helper),
+                    params = std::move(params)](
+                       folly::Try<folly::Unit>&& result) mutable {
+            if (result.hasException()) {
+              auto publisher = std::move(*sharedPublisher->wlock());
+              std::move(publisher).next(
+                  newEdenError(std::move(result).exception()));
+            }
+          })
+          .semi());
+
+  return std::move(serverStream);
+}
+
+apache::thrift::ServerStream<ScmStatusChunk>
+EdenServiceHandler::streamScmStatus(
+    std::unique_ptr<StreamScmStatusParams> params) {
+#if FOLLY_HAS_COROUTINES
+  auto helper = INSTRUMENT_THRIFT_CALL(
+      DBG2,
+      *params->mountPoint(),
+      folly::to<string>("commitHash=", logHash(*params->commit())),
+      folly::to<string>("listIgnored=", *params->listIgnored()));
+  auto mount = server_->getMount(absolutePathFromThrift(*params->mountPoint()));
+  auto rootId = mount->getObjectStore()->parseRootId(*params->commit());
+  auto config = server_->getServerState()->getEdenConfig();
+  auto callback = std::make_shared<StreamingScmStatusDiffCallback>(
+      config->thriftStatusStreamChunkSize.getValue(),
+      config->thriftStatusStreamMaxPendingChunks.getValue());
+  folly::CancellationSource cancellation;
+
+  auto admission = admitExpensiveRequest(
+      *expensiveRequests_,
+      *helper,
+      server_->getSharedStats(),
+      &ThriftStats::getScmStatusV2QueueDelay);
+  auto* threadPool = server_->getServerState()->getThreadPool().get();
+  // The diff threads block while the client is behind, so the diff must not
+  // start on the thread that serves the stream.
+  auto diffFuture =
+      std::move(admission)
+          .semi()
+          .via(threadPool)
+          .thenValue([mount,
+                      rootId = std::move(rootId),
+                      listIgnored = *params->listIgnored(),
+                      enforceParents = config->enforceParents.getValue(),
+                      token = cancellation.getToken(),
+                      callback](FsChannelOverloadController::Slot&& slot) {
+            return mount
+                ->diff(
+                    callback.get(), rootId, listIgnored, enforceParents, token)
+                .ensure([slot = std::move(slot)] {})
+                .semi();
+          })
+          .thenTry([callback, mount](folly::Try<folly::Unit>&& result) {
+            callback->finish(
+                result.hasException()
+                    ? folly::exception_wrapper{newEdenError(
+                          std::move(result).exception())}
+                    : folly::exception_wrapper{});
+          });
+  folly::futures::detachOn(threadPool, std::move(diffFuture).semi());
+
+  // Chunks are only produced as fast as the client requests them.
+  return folly::coro::co_invoke(
+      [callback,
+       cancellation = std::move(cancellation),
+       helper = std::move(helper),
+       params = std::move(params)]() mutable
+      -> folly::coro::AsyncGenerator<ScmStatusChunk&&> {
+        // Stop the diff if the client goes away before the stream completes.
+        SCOPE_EXIT {
+          cancellation.requestCancellation();
+          callback->cancel();
+        };
+        while (auto chunk = co_await callback->next()) {
+          co_yield std::move(*chunk);
+        }
+      });
+#else
+  (void)params;
+  NOT_IMPLEMENTED();
+#endif
+}
+
+apache::thrift::ServerStream<PreloadDirectoriesProgress>
+EdenServiceHandler::preloadDirectories(
+    std::unique_ptr<PreloadDirectoriesParams> params) {
+  auto helper = INSTRUMENT_THRIFT_CALL(
+      DBG2, *params->mountPoint(), params->directories()->size());
+  auto edenMount =
+      server_->getMount(absolutePathFromThrift(*params->mountPoint()));
+
+  std::vector<DirectoryPreloadRequest> directories;
+  directories.reserve(params->directories()->size());
+  for (const auto& directory : *params->directories()) {
+    auto depth = *directory.depth();
+    directories.push_back(DirectoryPreloadRequest{
+        relpathFromUserPath(*directory.path()),
+        depth < 0 ? std::numeric_limits<size_t>::max()
+                  : static_cast<size_t>(depth)});
+  }
+
+  auto config = server_->getServerState()->getEdenConfig();
+  DirectoryPreloadOptions options;
+  options.loadInodes = *params->loadInodes();
+  options.batchSize = config->thriftPreloadBatchSize.getValue();
+  options.maxTrees = config->thriftPreloadMaxTrees.getValue();
+
+  auto [serverStream, publisher] =
+      apache::thrift::ServerStream<PreloadDirectoriesProgress>::createPublisher(
+          [] {});
+  auto sharedPublisher = std::make_shared<folly::Synchronized<
+      ThriftStreamPublisherOwner<PreloadDirectoriesProgress>>>(
+      ThriftStreamPublisherOwner{std::move(publisher)});
+
+  // Preload on a background thread, which blocks on each batch of fetches.
+  auto preloadFuture = makeNotReadyImmediateFuture().thenValue(
+      [edenMount,
+       directories = std::move(directories),
+       options,
+       &fetchContext = helper->getFetchContext(),
+       sharedPublisher](auto&&) {
+        // Qualified, as the method shadows it.
+        facebook::eden::preloadDirectories(
+            *edenMount,
+            directories,
+            options,
+            fetchContext,
+            [&](const DirectoryPreloadProgress& progress) {
+              PreloadDirectoriesProgress out;
+              out.depth() = progress.depth;
+              out.treesFetched() = progress.treesFetched;
+              out.inodesLoaded() = progress.inodesLoaded;
+              out.pendingDirectories() = progress.pendingDirectories;
+              sharedPublisher->rlock()->next(std::move(out));
+            });
+      });
+
+  folly::futures::detachOn(
+      server_->getServerState()->getThreadPool().get(),
+      std::move(preloadFuture)
+          // The stream completes once the last reference to the publisher
+          // is dropped.
+          .thenTry([sharedPublisher,
+                    helper = std::move(helper),
+                    params = std::move(params)](
+                       folly::Try<folly::Unit>&& result) mutable {
+            if (result.hasException()) {
+              auto publisher = std::move(*sharedPublisher->wlock());
+              std::move(publisher).next(
+                  newEdenError(std::move(result).exception()));
+            }
+          })
+          .semi());
+
+  return std::move(serverStream);
+}
+
+apache::thrift::ServerStream<PlannedCheckoutChunk>
+EdenServiceHandler::planCheckout(std::unique_ptr<PlanCheckoutParams> params) {
+  auto* context = getRequestContext();
+  auto helper = INSTRUMENT_THRIFT_CALL(
+      DBG2, *params->mountPoint(), logHash(*params->snapshotHash()));
+  auto edenMount =
+      server_->getMount(absolutePathFromThrift(*params->mountPoint()));
+  auto toRoot =
+      edenMount->getObjectStore()->parseRootId(*params->snapshotHash());
+
+  auto [serverStream, publisher] =
+      apache::thrift::ServerStream<PlannedCheckoutChunk>::createPublisher(
+          [] {});
+  auto sharedPublisher = std::make_shared<
+      folly::Synchronized<ThriftStreamPublisherOwner<PlannedCheckoutChunk>>>(
+      ThriftStreamPublisherOwner{std::move(publisher)});
+
+  // Qualified, as the method shadows it.
+  auto planFuture = facebook::eden::planCheckout(
+      edenMount,
+      std::move(toRoot),
+      *params->prefetch(),
+      context->getConnectionContext()->getCancellationToken(),
+      helper->getFetchContext(),
+      [sharedPublisher](const CheckoutPlanEntry& entry) {
+        PlannedCheckoutEntry out;
+        out.path() = entry.path.asString();
+        out.dtype() = static_cast<Dtype>(entry.type);
+        switch (entry.change) {
+          case CheckoutPlanEntry::Change::Added:
+            out.status() = ScmFileStatus::ADDED;
+            break;
+          case CheckoutPlanEntry::Change::Removed:
+            out.status() = ScmFileStatus::REMOVED;
+            break;
+          case CheckoutPlanEntry::Change::Modified:
+            out.status() = ScmFileStatus::MODIFIED;
+            break;
+        }
+        out.conflict() = entry.conflict;
+        PlannedCheckoutChunk chunk;
+        chunk.entry_ref() = std::move(out);
+        sharedPublisher->rlock()->next(std::move(chunk));
+      });
+
+  folly::futures::detachOn(
+      server_->getServerState()->getThreadPool().get(),
+      std::move(planFuture)
+          // The stream completes once the last reference to the publisher
+          // is dropped.
+          .thenTry([sharedPublisher,
+                    helper = std::move(helper),
+                    params = std::move(params)](
+                       folly::Try<CheckoutPlan>&& result) mutable {
+            auto publisher = std::move(*sharedPublisher->wlock());
+            if (result.hasException()) {
+              std::move(publisher).next(
+                  newEdenError(std::move(result).exception()));
+              return;
+            }
+            const auto& plan = result.value();
+            PlannedCheckoutSummary summary;
+            summary.treesToFetch() = plan.treesToFetch;
+            summary.blobsToFetch() = plan.blobsToFetch;
+            summary.conflicts() = plan.conflicts;
+            summary.inodesInvalidated() = plan.inodesInvalidated;
+            PlannedCheckoutChunk chunk;
+            chunk.summary_ref() = std::move(summary);
+            publisher.next(std::move(chunk));
+          })
+          .semi());
+
+  return std::move(serverStream);
+}
+
+namespace {
+/**
+ * Publishes the progress of the checkout of the mount every interval, until
+ * the checkout completes or the client goes away.
+ */
+void publishCheckoutProgress(
+    std::shared_ptr<EdenMount> edenMount,
+    std::shared_ptr<ThriftStreamPublisherOwner<CheckoutProgressInfo>>
+        publisher,
+    std::shared_ptr<std::atomic<bool>> disconnected,
+    folly::Executor::KeepAlive<> executor,
+    std::chrono::nanoseconds interval) {
+  auto progress = edenMount->getCheckoutProgress();
+  if (!progress || disconnected->load(std::memory_order_acquire)) {
+    // Dropping the last reference to the publisher completes the stream.
+    return;
+  }
+
+  CheckoutProgressInfo info;
+  info.directoriesStarted() = progress->directoriesStarted;
+  info.directoriesFinished() = progress->directoriesFinished;
+  info.directoriesResumed() = progress->directoriesResumed;
+  info.entriesUpdated() = progress->entriesUpdated;
+  info.treesFetched() = progress->treesFetched;
+  info.blobsFetched() = progress->blobsFetched;
+  info.blobMetadataFetched() = progress->blobMetadataFetched;
+  info.elapsedMs() =
+      std::chrono::duration_cast<std::chrono::milliseconds>(progress->elapsed)
+          .count();
+  if (progress->estimatedRemaining) {
+    info.estimatedRemainingMs() =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            *progress->estimatedRemaining)
+            .count();
+  }
+  publisher->next(std::move(info));
+
+  folly::futures::detachOn(
+      executor,
+      folly::futures::sleep(
+          std::chrono::duration_cast<folly::HighResDuration>(interval))
+          .deferValue([edenMount = std::move(edenMount),
+                       publisher = std::move(publisher),
+                       disconnected = std::move(disconnected),
+                       executor,
+                       interval](folly::Unit) mutable {
+            publishCheckoutProgress(
+                std::move(edenMount),
+                std::move(publisher),
+                std::move(disconnected),
+                std::move(executor),
+                interval);
+          }));
+}
+} // namespace
+
+apache::thrift::ServerStream<CheckoutProgressInfo>
+EdenServiceHandler::streamCheckoutProgress(
+    std::unique_ptr<std::string> mountPoint) {
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG3, *mountPoint);
+  auto edenMount = server_->getMount(absolutePathFromThrift(*mountPoint));
+
+  auto disconnected = std::make_shared<std::atomic<bool>>(false);
+  auto [serverStream, publisher] =
+      apache::thrift::ServerStream<CheckoutProgressInfo>::createPublisher(
+          [disconnected] {
+            disconnected->store(true, std::memory_order_release);
+          });
+
+  publishCheckoutProgress(
+      std::move(edenMount),
+      std::make_shared<ThriftStreamPublisherOwner<CheckoutProgressInfo>>(
+          std::move(publisher)),
+      std::move(disconnected),
+      server_->getServerState()->getThreadPool().get(),
+      server_->getServerState()
+          ->getEdenConfig()
+          ->thriftCheckoutProgressInterval.getValue());
+
+  return std::move(serverStream);
+}
+
+namespace {
+std::shared_ptr<const Blob> getScmBlob(
+    const EdenMount& edenMount,
+    const ObjectId& id,
+    bool localStoreOnly,
+    const ObjectFetchContextPtr& fetchContext) {
   std::shared_ptr<const Blob> blob;
-  auto store = edenMount->getObjectStore();
+  auto store = edenMount.getObjectStore();
   if (localStoreOnly) {
     auto localStore = store->getLocalStore();
     blob = localStore->getBlob(id).get();
   } else {
-    blob = store->getBlob(id, helper->getFetchContext()).get();
+    blob = store->getBlob(id, fetchContext).get();
   }
 
   if (!blob) {
@@ -2876,12 +3794,53 @@ void EdenServiceHandler::debugGetScmBlob(
         ENOENT,
         EdenErrorType::POSIX_ERROR,
         "no blob found for id ",
-        edenMount->getObjectStore()->renderObjectId(id));
+        store->renderObjectId(id));
   }
+  return blob;
+}
+} // namespace
+
+void EdenServiceHandler::debugGetScmBlob(
+    string& data,
+    unique_ptr<string> mountPoint,
+    unique_ptr<string> idStr,
+    bool localStoreOnly) {
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG2, *mountPoint, logHash(*idStr));
+  auto mountPath = absolutePathFromThrift(*mountPoint);
+  auto edenMount = server_->getMount(mountPath);
+  auto id = edenMount->getObjectStore()->parseObjectId(*idStr);
+
+  auto blob =
+      getScmBlob(*edenMount, id, localStoreOnly, helper->getFetchContext());
   auto dataBuf = blob->getContents().cloneCoalescedAsValue();
   data.assign(reinterpret_cast<const char*>(dataBuf.data()), dataBuf.length());
 }
 
+int64_t EdenServiceHandler::debugGetScmBlobFd(
+    FOLLY_MAYBE_UNUSED unique_ptr<string> mountPoint,
+    FOLLY_MAYBE_UNUSED unique_ptr<string> idStr,
+    FOLLY_MAYBE_UNUSED bool localStoreOnly) {
+#ifdef __linux__
+  auto* context = getRequestContext();
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG2, *mountPoint, logHash(*idStr));
+  auto mountPath = absolutePathFromThrift(*mountPoint);
+  auto edenMount = server_->getMount(mountPath);
+  auto id = edenMount->getObjectStore()->parseObjectId(*idStr);
+
+  auto blob =
+      getScmBlob(*edenMount, id, localStoreOnly, helper->getFetchContext());
+  auto file = blob->getFile();
+  if (!file) {
+    file = makeSealedMemfd("edenfs-blob", blob->getContents()).file;
+  }
+  context->getHeader()->fds =
+      folly::SocketFds{folly::SocketFds::ToSend{std::move(file)}};
+  return static_cast<int64_t>(blob->getSize());
+#else
+  NOT_IMPLEMENTED();
+#endif
+}
+
 void EdenServiceHandler::debugGetScmBlobMetadata(
     ScmBlobMetadata& result,
     unique_ptr<string> mountPoint,
@@ -3035,6 +3994,7 @@ class InodeStatusCallbacks : public TraversalCallbacks {
                             }));
     }
     collectAll(std::move(futures)).get();
+    requestedSizes_.clear();
   }
 
  private:
@@ -3050,6 +4010,70 @@ class InodeStatusCallbacks : public TraversalCallbacks {
   std::vector<RequestedSize> requestedSizes_;
 };
 
+/**
+ * Publishes the information of each directory as soon as it is visited,
+ * within the limits of the walk.
+ */
+class StreamingInodeStatusCallbacks : public TraversalCallbacks {
+ public:
+  StreamingInodeStatusCallbacks(
+      EdenMount* mount,
+      int64_t flags,
+      const WalkLimits& limits,
+      const ObjectFetchContextPtr& fetchContext,
+      folly::FunctionRef<void(TreeInodeDebugInfo&&)> publish)
+      : limits_{limits},
+        fetchContext_{fetchContext},
+        publish_{publish},
+        inner_{mount, flags, chunk_} {}
+
+  void visitTreeInode(
+      RelativePathPiece path,
+      InodeNumber ino,
+      const std::optional<ObjectId>& hash,
+      uint64_t fsRefcount,
+      const std::vector<ChildEntry>& entries) override {
+    ++depth_;
+    if (truncated_ || entryCount_ + entries.size() > limits_.maxEntries) {
+      truncated_ = true;
+      return;
+    }
+    entryCount_ += entries.size();
+
+    inner_.visitTreeInode(path, ino, hash, fsRefcount, entries);
+    inner_.fillBlobSizes(fetchContext_);
+    for (auto& info : chunk_) {
+      publish_(std::move(info));
+    }
+    chunk_.clear();
+  }
+
+  bool shouldRecurse(const ChildEntry& entry) override {
+    // depth_ is the depth of the directory containing entry, 1 being the
+    // root of the walk.
+    return !truncated_ && depth_ <= limits_.maxDepth &&
+        inner_.shouldRecurse(entry);
+  }
+
+  void leaveTreeInode(RelativePathPiece /*path*/) override {
+    --depth_;
+  }
+
+  bool isTruncated() const {
+    return truncated_;
+  }
+
+ private:
+  const WalkLimits limits_;
+  const ObjectFetchContextPtr& fetchContext_;
+  folly::FunctionRef<void(TreeInodeDebugInfo&&)> publish_;
+  size_t depth_{0};
+  size_t entryCount_{0};
+  bool truncated_{false};
+  std::vector<TreeInodeDebugInfo> chunk_;
+  InodeStatusCallbacks inner_;
+};
+
 } // namespace
 
 void EdenServiceHandler::debugInodeStatus(
@@ -3082,6 +4106,83 @@ void EdenServiceHandler::debugInodeStatus(
       .get();
 }
 
+apache::thrift::ServerStream<TreeInodeDebugInfo>
+EdenServiceHandler::streamInodeStatus(
+    std::unique_ptr<StreamInodeStatusParams> params) {
+  auto flags = *params->flags();
+  if (0 == flags) {
+    flags = eden_constants::DIS_REQUIRE_LOADED_ |
+        eden_constants::DIS_COMPUTE_BLOB_SIZES_;
+  }
+
+  auto helper = INSTRUMENT_THRIFT_CALL(
+      DBG2,
+      *params->mountPoint(),
+      *params->path(),
+      flags,
+      getSyncTimeout(*params->sync()));
+  auto edenMount =
+      server_->getMount(absolutePathFromThrift(*params->mountPoint()));
+  WalkLimits limits{
+      *params->limits(), *server_->getServerState()->getEdenConfig()};
+
+  auto [serverStream, publisher] =
+      apache::thrift::ServerStream<TreeInodeDebugInfo>::createPublisher([] {});
+  auto sharedPublisher = std::make_shared<
+      folly::Synchronized<ThriftStreamPublisherOwner<TreeInodeDebugInfo>>>(
+      ThriftStreamPublisherOwner{std::move(publisher)});
+
+  // Walk on a background thread, each directory being published as soon as
+  // it is visited rather than the whole walk being held in memory.
+  auto walkFuture =
+      makeNotReadyImmediateFuture()
+          .thenValue([edenMount, sync = *params->sync()](auto&&) {
+            return waitForPendingNotifications(*edenMount, sync);
+          })
+          .thenValue([edenMount,
+                      &path = *params->path(),
+                      flags,
+                      limits,
+                      &fetchContext = helper->getFetchContext(),
+                      sharedPublisher](auto&&) {
+            auto inode =
+                inodeFromUserPath(*edenMount, path, fetchContext).asTreePtr();
+            auto inodePath = inode->getPath().value();
+
+            StreamingInodeStatusCallbacks callbacks{
+                edenMount.get(),
+                flags,
+                limits,
+                fetchContext,
+                [&](TreeInodeDebugInfo&& info) {
+                  sharedPublisher->rlock()->next(std::move(info));
+                }};
+            traverseObservedInodes(*inode, inodePath, callbacks);
+            if (callbacks.isTruncated()) {
+              throw walkTruncatedError(limits.maxEntries);
+            }
+          });
+
+  folly::futures::detachOn(
+      server_->getServerState()->getThreadPool().get(),
+      std::move(walkFuture)
+          // The stream completes once the last reference to the publisher
+          // is dropped.
+          .thenTry([sharedPublisher,
+                    helper = std::move(helper),
+                    params = std::move(params)](
+                       folly::Try<folly::Unit>&& result) mutable {
+            if (result.hasException()) {
+              auto publisher = std::move(*sharedPublisher->wlock());
+              std::move(publisher).next(
+                  newEdenError(std::move(result).exception()));
+            }
+          })
+          .semi());
+
+  return std::move(serverStream);
+}
+
 void EdenServiceHandler::debugOutstandingFuseCalls(
     FOLLY_MAYBE_UNUSED std::vector<FuseCall>& outstandingCalls,
     FOLLY_MAYBE_UNUSED std::unique_ptr<std::string> mountPoint) {
@@ -3296,14 +4397,26 @@ void EdenServiceHandler::stopRecordingBackingStoreFetch(
   }
 } // namespace eden
 
+namespace {
+void addAccessCounts(AccessCounts& total, const AccessCounts& counts) {
+  *total.fsChannelTotal_ref() += *counts.fsChannelTotal_ref();
+  *total.fsChannelReads_ref() += *counts.fsChannelReads_ref();
+  *total.fsChannelWrites_ref() += *counts.fsChannelWrites_ref();
+  *total.fsChannelBackingStoreImports_ref() +=
+      *counts.fsChannelBackingStoreImports_ref();
+  *total.fsChannelDurationNs_ref() += *counts.fsChannelDurationNs_ref();
+  *total.fsChannelMemoryCacheImports_ref() +=
+      *counts.fsChannelMemoryCacheImports_ref();
+  *total.fsChannelDiskCacheImports_ref() +=
+      *counts.fsChannelDiskCacheImports_ref();
+}
+} // namespace
+
 void EdenServiceHandler::getAccessCounts(
     GetAccessCountsResult& result,
     int64_t duration) {
   auto helper = INSTRUMENT_THRIFT_CALL(DBG3);
 
-  result.cmdsByPid_ref() =
-      server_->getServerState()->getProcessNameCache()->getAllProcessNames();
-
   auto seconds = std::chrono::seconds{duration};
 
   for (auto& mount : server_->getMountPoints()) {
@@ -3322,6 +4435,49 @@ void EdenServiceHandler::getAccessCounts(
       ma.fetchCountsByPid_ref()[pid] = fetchCount;
     }
   }
+
+  // Read after the access logs, which hand their queued pids to the
+  // ProcessNameCache.
+  result.cmdsByPid_ref() =
+      server_->getServerState()->getProcessNameCache()->getAllProcessNames();
+  const auto& cmdsByPid = *result.cmdsByPid_ref();
+
+  for (auto& [mountStr, ma] : *result.accessesByMount_ref()) {
+    for (const auto& [pid, accessCounts] : *ma.accessCountsByPid_ref()) {
+      auto cmd = cmdsByPid.find(pid);
+      auto& total = ma.accessCountsByCmd_ref()
+                        [cmd != cmdsByPid.end() ? cmd->second : std::string{}];
+      addAccessCounts(total, accessCounts);
+    }
+  }
+}
+
+void EdenServiceHandler::getHeavyFetchers(
+    GetHeavyFetchersResult& result,
+    std::unique_ptr<GetHeavyFetchersParams> params) {
+  auto mountPoint = *params->mountPoint();
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG3, mountPoint);
+  auto edenMount = server_->getMount(absolutePathFromThrift(mountPoint));
+  auto& processNameCache = *server_->getServerState()->getProcessNameCache();
+
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+  std::vector<HeavyFetcher> fetchers;
+  for (const auto& stats :
+       edenMount->getObjectStore()->getHeavyFetcherStats()) {
+    HeavyFetcher fetcher;
+    fetcher.pid() = stats.pid;
+    fetcher.processName().from_optional(
+        processNameCache.getProcessName(stats.pid));
+    fetcher.recentFetches() = stats.recentFetches;
+    fetcher.heavy() = stats.heavy;
+    fetcher.deprioritizedFetches() = stats.deprioritizedFetches;
+    fetcher.delayedFetches() = stats.delayedFetches;
+    fetcher.totalDelayUs() =
+        duration_cast<microseconds>(stats.totalDelay).count();
+    fetchers.push_back(std::move(fetcher));
+  }
+  result.fetchers() = std::move(fetchers);
 }
 
 void EdenServiceHandler::clearAndCompactLocalStore() {
@@ -3485,6 +4641,43 @@ void EdenServiceHandler::flushStatsNow() {
   server_->flushStatsNow();
 }
 
+void EdenServiceHandler::getLatencyHistograms(
+    std::vector<LatencyHistogramInfo>& result) {
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG3);
+  for (const auto& labeled : server_->getLatencyHistograms()) {
+    const auto& histogram = labeled.histogram;
+    LatencyHistogramInfo info;
+    for (const auto& [name, value] : labeled.labels) {
+      info.labels_ref()->emplace(name, value);
+    }
+    info.count_ref() = histogram.getCount();
+    info.p50_ref() = histogram.getPercentile(50);
+    info.p90_ref() = histogram.getPercentile(90);
+    info.p99_ref() = histogram.getPercentile(99);
+    info.p999_ref() = histogram.getPercentile(99.9);
+    info.p9999_ref() = histogram.getPercentile(99.99);
+    info.max_ref() = histogram.getMax();
+    for (size_t i = 0; i < LatencyHistogram::kBucketCount; ++i) {
+      if (auto count = histogram.getBucketCount(i)) {
+        info.buckets_ref()->emplace(
+            LatencyHistogram::bucketLowerBound(i), count);
+      }
+    }
+    result.push_back(std::move(info));
+  }
+}
+
+void EdenServiceHandler::debugMemoryBreakdown(
+    std::map<std::string, int64_t>& result) {
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG3);
+  result = server_->getMemoryBreakdown();
+}
+
+void EdenServiceHandler::getRequestSamples(std::string& result) {
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG3);
+  result = server_->getRequestSamples();
+}
+
 folly::SemiFuture<Unit>
 EdenServiceHandler::semifuture_invalidateKernelInodeCache(
     FOLLY_MAYBE_UNUSED std::unique_ptr<std::string> mountPoint,
@@ -3665,6 +4858,54 @@ void EdenServiceHandler::getRetroactiveHgEvents(
   result.events() = std::move(thriftEvents);
 }
 
+void EdenServiceHandler::getHgImportTimelines(
+    GetHgImportTimelinesResult& result,
+    std::unique_ptr<GetHgImportTimelinesParams> params) {
+  auto mountPoint = *params->mountPoint();
+  auto mountPath = absolutePathFromThrift(mountPoint);
+  auto edenMount = server_->getMount(mountPath);
+  auto backingStore = edenMount->getObjectStore()->getBackingStore();
+  std::shared_ptr<HgQueuedBackingStore> hgBackingStore =
+      castToHgQueuedBackingStore(backingStore, mountPath);
+
+  auto& importTimelines = hgBackingStore->getImportTimelines();
+  if (!importTimelines.has_value()) {
+    throw newEdenError(
+        ENOTSUP,
+        EdenErrorType::POSIX_ERROR,
+        "ActivityBuffer not initialized in HgQueuedBackingStore.");
+  }
+
+  using std::chrono::duration_cast;
+  using std::chrono::nanoseconds;
+  std::vector<HgImportTimeline> thriftTimelines;
+  auto timelines = importTimelines->getAllEvents();
+  thriftTimelines.reserve(timelines.size());
+  for (const auto& timeline : timelines) {
+    HgImportTimeline thriftTimeline;
+    thriftTimeline.unique() = timeline.unique;
+    thriftTimeline.traceId() = timeline.traceId;
+    thriftTimeline.resourceType() =
+        timeline.resourceType == HgImportTraceEvent::BLOB
+        ? HgResourceType::BLOB
+        : HgResourceType::TREE;
+    thriftTimeline.importCause() = thriftImportCause(timeline.importCause);
+    thriftTimeline.path() = timeline.path;
+    thriftTimeline.manifestNodeId() = timeline.manifestNodeId.toString();
+    thriftTimeline.startTime() =
+        duration_cast<nanoseconds>(timeline.startTime.time_since_epoch())
+            .count();
+    thriftTimeline.lookupDurationUs() = timeline.lookupDuration.count();
+    thriftTimeline.queueDurationUs() = timeline.queueDuration.count();
+    thriftTimeline.batchDurationUs() = timeline.batchDuration.count();
+    thriftTimeline.importerDurationUs() = timeline.importerDuration.count();
+    thriftTimeline.deduplicated() = timeline.deduplicated;
+    thriftTimelines.push_back(std::move(thriftTimeline));
+  }
+
+  result.timelines() = std::move(thriftTimelines);
+}
+
 void EdenServiceHandler::getRetroactiveInodeEvents(
     GetRetroactiveInodeEventsResult& result,
     std::unique_ptr<GetRetroactiveInodeEventsParams> params) {
@@ -3692,6 +4933,23 @@ void EdenServiceHandler::getRetroactiveInodeEvents(
   result.events() = std::move(thriftEvents);
 }
 
+void EdenServiceHandler::getRetroactiveInodeEventsSnapshot(
+    std::string& result,
+    std::unique_ptr<GetRetroactiveInodeEventsParams> params) {
+  auto mountPoint = *params->mountPoint();
+  auto mountPath = absolutePathFromThrift(mountPoint);
+  auto edenMount = server_->getMount(mountPath);
+
+  if (!edenMount->getActivityBuffer().has_value()) {
+    throw newEdenError(
+        ENOTSUP,
+        EdenErrorType::POSIX_ERROR,
+        "ActivityBuffer not initialized in EdenFS mount.");
+  }
+
+  result = serializeInodeTraceEvents(*edenMount->getActivityBuffer());
+}
+
 namespace {
 std::optional<folly::exception_wrapper> getFaultError(
     apache::thrift::optional_field_ref<std::string&> errorType,
@@ -36,6 +36,7 @@ class ObjectFetchContext;
 using ObjectFetchContextPtr = RefPtr<ObjectFetchContext>;
 class EntryAttributes;
 struct EntryAttributeFlags;
+class FsChannelOverloadController;
 template <typename T>
 class ImmediateFuture;
 
@@ -116,6 +117,9 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
       CheckoutMode checkoutMode,
       std::unique_ptr<CheckOutRevisionParams> params) override;
 
+  folly::SemiFuture<std::unique_ptr<std::vector<CheckoutConflict>>>
+  semifuture_applyMountFilter(std::unique_ptr<std::string> mountPoint) override;
+
   folly::SemiFuture<folly::Unit> semifuture_resetParentCommits(
       std::unique_ptr<std::string> mountPoint,
       std::unique_ptr<WorkingDirectoryParents> parents,
@@ -139,13 +143,8 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
       std::unique_ptr<std::vector<std::string>> paths,
       std::unique_ptr<SyncBehavior> sync) override;
 
-  // the caller should ensure the relativePath is valid until the returned
-  // futures complete.
-  ImmediateFuture<EntryAttributes> getEntryAttributesForPath(
-      EntryAttributeFlags reqBitmask,
-      AbsolutePathPiece mountPoint,
-      folly::StringPiece path,
-      const ObjectFetchContextPtr& fetchContext);
+  // The caller should ensure paths remain valid until the returned future
+  // completes.
   ImmediateFuture<std::vector<folly::Try<EntryAttributes>>> getEntryAttributes(
       AbsolutePathPiece mountPath,
       std::vector<std::string>& paths,
@@ -235,6 +234,27 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
   apache::thrift::ResponseAndServerStream<ChangesSinceResult, ChangedFileResult>
   streamChangesSince(std::unique_ptr<StreamChangesSinceParams> params) override;
 
+  apache::thrift::ServerStream<GlobFileResult> streamGlobFiles(
+      std::unique_ptr<GlobParams> params) override;
+
+  apache::thrift::ServerStream<TreeInodeDebugInfo> streamInodeStatus(
+      std::unique_ptr<StreamInodeStatusParams> params) override;
+
+  apache::thrift::ServerStream<ScmTreeChunk> streamScmTree(
+      std::unique_ptr<StreamScmTreeParams> params) override;
+
+  apache::thrift::ServerStream<ScmStatusChunk> streamScmStatus(
+      std::unique_ptr<StreamScmStatusParams> params) override;
+
+  apache::thrift::ServerStream<PreloadDirectoriesProgress> preloadDirectories(
+      std::unique_ptr<PreloadDirectoriesParams> params) override;
+
+  apache::thrift::ServerStream<PlannedCheckoutChunk> planCheckout(
+      std::unique_ptr<PlanCheckoutParams> params) override;
+
+  apache::thrift::ServerStream<CheckoutProgressInfo> streamCheckoutProgress(
+      std::unique_ptr<std::string> mountPoint) override;
+
   folly::SemiFuture<std::unique_ptr<ScmStatus>> semifuture_getScmStatus(
       std::unique_ptr<std::string> mountPoint,
       bool listIgnored,
@@ -258,6 +278,11 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
       std::unique_ptr<std::string> id,
       bool localStoreOnly) override;
 
+  int64_t debugGetScmBlobFd(
+      std::unique_ptr<std::string> mountPoint,
+      std::unique_ptr<std::string> id,
+      bool localStoreOnly) override;
+
   void debugGetScmBlobMetadata(
       ScmBlobMetadata& metadata,
       std::unique_ptr<std::string> mountPoint,
@@ -312,6 +337,10 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
   void getAccessCounts(GetAccessCountsResult& result, int64_t duration)
       override;
 
+  void getHeavyFetchers(
+      GetHeavyFetchersResult& result,
+      std::unique_ptr<GetHeavyFetchersParams> params) override;
+
   void clearAndCompactLocalStore() override;
 
   void debugClearLocalStoreCaches() override;
@@ -327,6 +356,12 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
 
   void flushStatsNow() override;
 
+  void getLatencyHistograms(std::vector<LatencyHistogramInfo>& result) override;
+
+  void debugMemoryBreakdown(std::map<std::string, int64_t>& result) override;
+
+  void getRequestSamples(std::string& result) override;
+
   folly::SemiFuture<folly::Unit> semifuture_invalidateKernelInodeCache(
       std::unique_ptr<std::string> mountPoint,
       std::unique_ptr<std::string> path) override;
@@ -346,10 +381,18 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
       GetRetroactiveHgEventsResult& result,
       std::unique_ptr<GetRetroactiveHgEventsParams> params) override;
 
+  void getHgImportTimelines(
+      GetHgImportTimelinesResult& result,
+      std::unique_ptr<GetHgImportTimelinesParams> params) override;
+
   void getRetroactiveInodeEvents(
       GetRetroactiveInodeEventsResult& result,
       std::unique_ptr<GetRetroactiveInodeEventsParams> params) override;
 
+  void getRetroactiveInodeEventsSnapshot(
+      std::string& result,
+      std::unique_ptr<GetRetroactiveInodeEventsParams> params) override;
+
   void injectFault(std::unique_ptr<FaultDefinition> fault) override;
   bool removeFault(std::unique_ptr<RemoveFaultArg> fault) override;
   int64_t unblockFault(std::unique_ptr<UnblockFaultArg> info) override;
@@ -361,6 +404,9 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
   folly::SemiFuture<folly::Unit> semifuture_removeRecursively(
       std::unique_ptr<RemoveRecursivelyParams> params) override;
 
+  folly::SemiFuture<folly::Unit> semifuture_cloneDirectory(
+      std::unique_ptr<CloneDirectoryParams> params) override;
+
   folly::SemiFuture<folly::Unit> semifuture_ensureMaterialized(
       std::unique_ptr<EnsureMaterializedParams> params) override;
 
@@ -407,11 +453,6 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
   std::optional<pid_t> getAndRegisterClientPid();
 
  private:
-  ImmediateFuture<Hash20> getSHA1ForPath(
-      const EdenMount& edenMount,
-      RelativePath path,
-      const ObjectFetchContextPtr& fetchContext);
-
   folly::Synchronized<std::unordered_map<uint64_t, ThriftRequestTraceEvent>>
       outstandingThriftRequests_;
 #ifdef EDEN_HAVE_USAGE_SERVICE
@@ -433,5 +474,8 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
   std::shared_ptr<ThriftRequestTraceHandle> thriftRequestTraceHandle_;
 
   std::shared_ptr<TraceBus<ThriftRequestTraceEvent>> thriftRequestTraceBus_;
+
+  // Bounds how many expensive requests, like globs and status, run at once.
+  std::shared_ptr<FsChannelOverloadController> expensiveRequests_;
 };
 } // namespace facebook::eden
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/service/StartupProfiler.h"
+
+#include <fb303/ServiceData.h>
+#include <fmt/format.h>
+#include <algorithm>
+#include <utility>
+
+#include "eden/fs/service/StartupLogger.h"
+
+namespace facebook::eden {
+
+namespace {
+int64_t toMilliseconds(StartupProfiler::Clock::duration duration) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(duration)
+      .count();
+}
+} // namespace
+
+StartupProfiler::Phase::Phase(StartupProfiler& profiler, std::string name)
+    : profiler_{&profiler}, name_{std::move(name)}, start_{Clock::now()} {}
+
+StartupProfiler::Phase::Phase(Phase&& other) noexcept
+    : profiler_{std::exchange(other.profiler_, nullptr)},
+      name_{std::move(other.name_)},
+      start_{other.start_} {}
+
+StartupProfiler::Phase::~Phase() {
+  end();
+}
+
+void StartupProfiler::Phase::end() {
+  if (profiler_) {
+    std::exchange(profiler_, nullptr)->record(std::move(name_), start_);
+  }
+}
+
+StartupProfiler::StartupProfiler() : created_{Clock::now()} {}
+
+void StartupProfiler::record(std::string name, Clock::time_point start) {
+  auto end = Clock::now();
+  phases_.wlock()->push_back(
+      PhaseTiming{std::move(name), start - created_, end - start});
+}
+
+std::vector<StartupProfiler::PhaseTiming> StartupProfiler::getPhases() const {
+  auto phases = *phases_.rlock();
+  std::stable_sort(
+      phases.begin(), phases.end(), [](const auto& left, const auto& right) {
+        return left.start < right.start;
+      });
+  return phases;
+}
+
+void StartupProfiler::report(StartupLogger& logger) const {
+  for (const auto& phase : getPhases()) {
+    logger.log(fmt::format(
+        "Startup phase {} took {}ms, starting at {}ms",
+        phase.name,
+        toMilliseconds(phase.duration),
+        toMilliseconds(phase.start)));
+    fb303::ServiceData::get()->setCounter(
+        fmt::format("startup.{}_ms", phase.name),
+        toMilliseconds(phase.duration));
+  }
+}
+
+} // namespace facebook::eden
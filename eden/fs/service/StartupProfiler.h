@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace facebook::eden {
+
+class StartupLogger;
+
+/**
+ * Records how long each phase of the startup of edenfs takes, so that a slow
+ * startup can be attributed to the phase responsible for it.
+ *
+ * Phases may overlap, as independent ones run concurrently, and may be
+ * recorded from any thread.
+ */
+class StartupProfiler {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct PhaseTiming {
+    std::string name;
+    /** When the phase started, relative to the creation of the profiler. */
+    Clock::duration start;
+    Clock::duration duration;
+  };
+
+  /**
+   * A phase in progress, recorded when end() is called or when it is
+   * destroyed.
+   */
+  class Phase {
+   public:
+    Phase(StartupProfiler& profiler, std::string name);
+    ~Phase();
+
+    Phase(Phase&& other) noexcept;
+    Phase& operator=(Phase&&) = delete;
+    Phase(const Phase&) = delete;
+    Phase& operator=(const Phase&) = delete;
+
+    void end();
+
+   private:
+    StartupProfiler* profiler_;
+    std::string name_;
+    Clock::time_point start_;
+  };
+
+  StartupProfiler();
+
+  Phase startPhase(std::string name) {
+    return Phase{*this, std::move(name)};
+  }
+
+  /** The phases ended so far, in the order they started. */
+  std::vector<PhaseTiming> getPhases() const;
+
+  /**
+   * Log the phases ended so far, and publish their durations as the
+   * startup.<phase>_ms counters.
+   */
+  void report(StartupLogger& logger) const;
+
+ private:
+  void record(std::string name, Clock::time_point start);
+
+  const Clock::time_point created_;
+  folly::Synchronized<std::vector<PhaseTiming>> phases_;
+};
+
+} // namespace facebook::eden
@@ -38,14 +38,31 @@ ThriftGlobImpl::ThriftGlobImpl(const PrefetchParams& params)
       rootHashes_{*params.revisions_ref()},
       searchRootUser_{*params.searchRoot_ref()} {}
 
-ImmediateFuture<std::unique_ptr<Glob>> ThriftGlobImpl::glob(
-    std::shared_ptr<EdenMount> edenMount,
-    std::shared_ptr<ServerState> serverState,
-    std::vector<std::string> globs,
-    const ObjectFetchContextPtr& fetchContext) {
+namespace {
+
+/**
+ * Evaluate globs against rootHashes, or against the working copy when there
+ * are none, adding the matches to results and, when fileBlobsToPrefetch is
+ * set, the hashes of their blobs to it.
+ *
+ * The results reference the RootIds appended to originRootIds, which must
+ * thus outlive them. The returned tries hold the outcome of the evaluation of
+ * each root.
+ */
+ImmediateFuture<std::vector<folly::Try<folly::Unit>>> evaluateGlobs(
+    const std::shared_ptr<EdenMount>& edenMount,
+    const std::shared_ptr<ServerState>& serverState,
+    const std::vector<std::string>& globs,
+    bool includeDotfiles,
+    const std::vector<std::string>& rootHashes,
+    folly::StringPiece searchRootUser,
+    const ObjectFetchContextPtr& fetchContext,
+    std::vector<RootId>& originRootIds,
+    std::shared_ptr<GlobNode::ResultSink> globResults,
+    std::shared_ptr<GlobNode::PrefetchList> fileBlobsToPrefetch) {
   // Compile the list of globs into a tree
   auto globRoot = std::make_shared<GlobNode>(
-      includeDotfiles_,
+      includeDotfiles,
       serverState->getEdenConfig()->globUseMountCaseSensitivity.getValue()
           ? edenMount->getCheckoutConfig()->getCaseSensitive()
           : CaseSensitivity::Sensitive);
@@ -66,30 +83,22 @@ ImmediateFuture<std::unique_ptr<Glob>> ThriftGlobImpl::glob(
     throw newEdenError(exc);
   }
 
-  auto fileBlobsToPrefetch =
-      prefetchFiles_ ? std::make_shared<GlobNode::PrefetchList>() : nullptr;
-
-  // These hashes must outlive the GlobResult created by evaluate as the
-  // GlobResults will hold on to references to these hashes
-  auto originRootIds = std::make_unique<std::vector<RootId>>();
-
   // Globs will be evaluated against the specified commits or the current commit
-  // if none are specified. The results will be collected here.
+  // if none are specified.
   std::vector<ImmediateFuture<folly::Unit>> globFutures{};
-  auto globResults = std::make_shared<GlobNode::ResultList>();
 
   RelativePath searchRoot;
-  if (!(searchRootUser_.empty() || searchRootUser_ == ".")) {
-    searchRoot = RelativePath{searchRootUser_};
+  if (!(searchRootUser.empty() || searchRootUser == ".")) {
+    searchRoot = RelativePath{searchRootUser};
   }
 
-  if (!rootHashes_.empty()) {
+  if (!rootHashes.empty()) {
     // Note that we MUST reserve here, otherwise while emplacing we might
     // invalidate the earlier commitHash refrences
-    globFutures.reserve(rootHashes_.size());
-    originRootIds->reserve(rootHashes_.size());
-    for (auto& rootHash : rootHashes_) {
-      const RootId& originRootId = originRootIds->emplace_back(
+    globFutures.reserve(rootHashes.size());
+    originRootIds.reserve(rootHashes.size());
+    for (auto& rootHash : rootHashes) {
+      const RootId& originRootId = originRootIds.emplace_back(
           edenMount->getObjectStore()->parseRootId(rootHash));
 
       globFutures.emplace_back(
@@ -124,7 +133,7 @@ ImmediateFuture<std::unique_ptr<Glob>> ThriftGlobImpl::glob(
     }
   } else {
     const RootId& originRootId =
-        originRootIds->emplace_back(edenMount->getCheckedOutRootId());
+        originRootIds.emplace_back(edenMount->getCheckedOutRootId());
     globFutures.emplace_back(
         edenMount->getInodeSlow(searchRoot, fetchContext)
             .thenValue([fetchContext = fetchContext.copy(),
@@ -144,15 +153,117 @@ ImmediateFuture<std::unique_ptr<Glob>> ThriftGlobImpl::glob(
             }));
   }
 
+  return collectAll(std::move(globFutures)).ensure([globRoot, globResults] {
+    // keep globRoot and globResults alive until the end
+  });
+}
+
+/**
+ * Fetch the blobs globbed into fileBlobsToPrefetch.
+ */
+ImmediateFuture<folly::Unit> prefetchGlobbedBlobs(
+    const std::shared_ptr<EdenMount>& edenMount,
+    std::shared_ptr<GlobNode::PrefetchList> fileBlobsToPrefetch,
+    const ObjectFetchContextPtr& fetchContext) {
+  std::vector<ImmediateFuture<folly::Unit>> futures;
+
+  auto store = edenMount->getObjectStore();
+  auto blobs = fileBlobsToPrefetch->rlock();
+  auto range = folly::Range{blobs->data(), blobs->size()};
+
+  while (range.size() > 20480) {
+    auto curRange = range.subpiece(0, 20480);
+    range.advance(20480);
+    futures.emplace_back(store->prefetchBlobs(curRange, fetchContext));
+  }
+  if (!range.empty()) {
+    futures.emplace_back(store->prefetchBlobs(range, fetchContext));
+  }
+
+  return collectAll(std::move(futures))
+      .thenValue([fileBlobsToPrefetch](auto&&) { return folly::unit; });
+}
+
+/**
+ * fileBlobsToPrefetch is deduplicated as an optimization. The BackingStore
+ * layer does not deduplicate fetches, so lets avoid causing too many
+ * duplicates here.
+ */
+void deduplicateGlobbedBlobs(GlobNode::PrefetchList& fileBlobsToPrefetch) {
+  auto fileBlobsToPrefetchLocked = fileBlobsToPrefetch.wlock();
+  std::sort(
+      fileBlobsToPrefetchLocked->begin(),
+      fileBlobsToPrefetchLocked->end(),
+      std::less<ObjectId>{});
+  auto fileBlobsToPrefetchNewEnd = std::unique(
+      fileBlobsToPrefetchLocked->begin(),
+      fileBlobsToPrefetchLocked->end(),
+      std::equal_to<ObjectId>());
+  fileBlobsToPrefetchLocked->erase(
+      fileBlobsToPrefetchNewEnd, fileBlobsToPrefetchLocked->end());
+}
+
+class ResultListSink : public GlobNode::ResultSink {
+ public:
+  void add(GlobNode::GlobResult&& result) override {
+    results.wlock()->push_back(std::move(result));
+  }
+
+  GlobNode::ResultList results;
+};
+
+class CallbackSink : public GlobNode::ResultSink {
+ public:
+  CallbackSink(ThriftGlobImpl::ResultCallback callback, bool listOnlyFiles)
+      : callback_{std::move(callback)}, listOnlyFiles_{listOnlyFiles} {}
+
+  void add(GlobNode::GlobResult&& result) override {
+    if (!listOnlyFiles_ || result.dtype != dtype_t::Dir) {
+      callback_(result.name, result.dtype, *result.originHash);
+    }
+  }
+
+ private:
+  ThriftGlobImpl::ResultCallback callback_;
+  bool listOnlyFiles_;
+};
+
+} // namespace
+
+ImmediateFuture<std::unique_ptr<Glob>> ThriftGlobImpl::glob(
+    std::shared_ptr<EdenMount> edenMount,
+    std::shared_ptr<ServerState> serverState,
+    std::vector<std::string> globs,
+    const ObjectFetchContextPtr& fetchContext) {
+  auto fileBlobsToPrefetch =
+      prefetchFiles_ ? std::make_shared<GlobNode::PrefetchList>() : nullptr;
+
+  // These hashes must outlive the GlobResult created by evaluate as the
+  // GlobResults will hold on to references to these hashes
+  auto originRootIds = std::make_unique<std::vector<RootId>>();
+
+  // The results of the evaluation of every root are collected here.
+  auto globResults = std::make_shared<ResultListSink>();
+
   auto prefetchFuture =
-      collectAll(std::move(globFutures))
+      evaluateGlobs(
+          edenMount,
+          serverState,
+          globs,
+          includeDotfiles_,
+          rootHashes_,
+          searchRootUser_,
+          fetchContext,
+          *originRootIds,
+          globResults,
+          fileBlobsToPrefetch)
           .thenValue([fileBlobsToPrefetch,
                       globResults = std::move(globResults),
                       suppressFileList = suppressFileList_](
                          std::vector<folly::Try<folly::Unit>>&& tries) {
             std::vector<GlobNode::GlobResult> sortedResults;
             if (!suppressFileList) {
-              std::swap(sortedResults, *globResults->wlock());
+              std::swap(sortedResults, *globResults->results.wlock());
               for (auto& try_ : tries) {
                 try_.throwUnlessValue();
               }
@@ -162,21 +273,8 @@ ImmediateFuture<std::unique_ptr<Glob>> ThriftGlobImpl::glob(
               sortedResults.erase(resultsNewEnd, sortedResults.end());
             }
 
-            // fileBlobsToPrefetch is deduplicated as an optimization.
-            // The BackingStore layer does not deduplicate fetches, so lets
-            // avoid causing too many duplicates here.
             if (fileBlobsToPrefetch) {
-              auto fileBlobsToPrefetchLocked = fileBlobsToPrefetch->wlock();
-              std::sort(
-                  fileBlobsToPrefetchLocked->begin(),
-                  fileBlobsToPrefetchLocked->end(),
-                  std::less<ObjectId>{});
-              auto fileBlobsToPrefetchNewEnd = std::unique(
-                  fileBlobsToPrefetchLocked->begin(),
-                  fileBlobsToPrefetchLocked->end(),
-                  std::equal_to<ObjectId>());
-              fileBlobsToPrefetchLocked->erase(
-                  fileBlobsToPrefetchNewEnd, fileBlobsToPrefetchLocked->end());
+              deduplicateGlobbedBlobs(*fileBlobsToPrefetch);
             }
 
             return sortedResults;
@@ -212,38 +310,64 @@ ImmediateFuture<std::unique_ptr<Glob>> ThriftGlobImpl::glob(
                   }
                 }
                 if (fileBlobsToPrefetch) {
-                  std::vector<ImmediateFuture<folly::Unit>> futures;
-
-                  auto store = edenMount->getObjectStore();
-                  auto blobs = fileBlobsToPrefetch->rlock();
-                  auto range = folly::Range{blobs->data(), blobs->size()};
-
-                  while (range.size() > 20480) {
-                    auto curRange = range.subpiece(0, 20480);
-                    range.advance(20480);
-                    futures.emplace_back(
-                        store->prefetchBlobs(curRange, fetchContext));
-                  }
-                  if (!range.empty()) {
-                    futures.emplace_back(
-                        store->prefetchBlobs(range, fetchContext));
-                  }
-
-                  return collectAll(std::move(futures))
-                      .thenValue([glob = std::move(out),
-                                  fileBlobsToPrefetch](auto&&) mutable {
+                  return prefetchGlobbedBlobs(
+                             edenMount, fileBlobsToPrefetch, fetchContext)
+                      .thenValue([glob = std::move(out)](auto&&) mutable {
                         return std::move(glob);
                       });
                 }
                 return std::move(out);
               })
-          .ensure([globRoot, originRootIds = std::move(originRootIds)]() {
-            // keep globRoot and originRootIds alive until the end
+          .ensure([originRootIds = std::move(originRootIds)]() {
+            // keep originRootIds alive until the end
           });
 
   return prefetchFuture;
 }
 
+ImmediateFuture<folly::Unit> ThriftGlobImpl::streamGlob(
+    std::shared_ptr<EdenMount> edenMount,
+    std::shared_ptr<ServerState> serverState,
+    std::vector<std::string> globs,
+    const ObjectFetchContextPtr& fetchContext,
+    ResultCallback resultCallback) {
+  auto fileBlobsToPrefetch =
+      prefetchFiles_ ? std::make_shared<GlobNode::PrefetchList>() : nullptr;
+  // The results are passed on as soon as they are found, the RootIds they
+  // reference thus only need to outlive the evaluation.
+  auto originRootIds = std::make_unique<std::vector<RootId>>();
+
+  return evaluateGlobs(
+             edenMount,
+             serverState,
+             globs,
+             includeDotfiles_,
+             rootHashes_,
+             searchRootUser_,
+             fetchContext,
+             *originRootIds,
+             std::make_shared<CallbackSink>(
+                 std::move(resultCallback), listOnlyFiles_),
+             fileBlobsToPrefetch)
+      .thenValue(
+          [edenMount,
+           fileBlobsToPrefetch,
+           fetchContext = fetchContext.copy(),
+           originRootIds = std::move(originRootIds)](
+              std::vector<folly::Try<folly::Unit>>&& tries) mutable
+          -> ImmediateFuture<folly::Unit> {
+            for (auto& try_ : tries) {
+              try_.throwUnlessValue();
+            }
+            if (!fileBlobsToPrefetch) {
+              return folly::unit;
+            }
+            deduplicateGlobbedBlobs(*fileBlobsToPrefetch);
+            return prefetchGlobbedBlobs(
+                edenMount, fileBlobsToPrefetch, fetchContext);
+          });
+}
+
 std::string ThriftGlobImpl::logString() {
   return fmt::format(
       "ThriftGlobImpl {{ includeDotFiles={}, prefetchFiles={}, suppressFileList={}, wantDtype={}, listOnlyFiles={}, rootHashes={}, searchRootUser={} }}",
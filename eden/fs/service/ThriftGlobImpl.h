@@ -7,12 +7,16 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include <folly/Range.h>
+#include "eden/fs/model/RootId.h"
+#include "eden/fs/utils/DirType.h"
 #include "eden/fs/utils/ImmediateFuture.h"
+#include "eden/fs/utils/PathFuncs.h"
 #include "eden/fs/utils/RefPtr.h"
 
 namespace facebook::eden {
@@ -36,6 +40,26 @@ class ThriftGlobImpl {
       std::vector<std::string> globs,
       const ObjectFetchContextPtr& fetchContext);
 
+  using ResultCallback = std::function<
+      void(RelativePathPiece name, dtype_t dtype, const RootId& originRootId)>;
+
+  /**
+   * Evaluate the globs like glob(), but pass each matching file to
+   * resultCallback as soon as it is found rather than returning them all
+   * once the evaluation completes. The files are neither sorted nor
+   * deduplicated, and resultCallback may be called concurrently from several
+   * threads.
+   *
+   * When prefetching files, the returned future completes once their blobs
+   * are fetched.
+   */
+  ImmediateFuture<folly::Unit> streamGlob(
+      std::shared_ptr<EdenMount> edenMount,
+      std::shared_ptr<ServerState> serverState,
+      std::vector<std::string> globs,
+      const ObjectFetchContextPtr& fetchContext,
+      ResultCallback resultCallback);
+
   std::string logString();
   std::string logString(const std::vector<std::string>& globs) const;
 
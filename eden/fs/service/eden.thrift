@@ -287,6 +287,7 @@ enum FileAttributes {
   SHA1_HASH = 1,
   FILE_SIZE = 2,
   SOURCE_CONTROL_TYPE = 4,
+  OBJECT_ID = 8,
 /* NEXT_ATTR = 2^x */
 } (cpp2.enum_type = 'uint64_t')
 
@@ -329,6 +330,15 @@ union SourceControlTypeOrError {
   2: EdenError error;
 }
 
+/**
+ * Materialized files and directories have no source control object, an error
+ * is returned for them.
+ */
+union ObjectIdOrError {
+  1: ThriftObjectId objectId;
+  2: EdenError error;
+}
+
 /**
  * Subset of attributes for a single file returned by getAttributesFromFiles()
  *
@@ -340,6 +350,7 @@ struct FileAttributeDataV2 {
   1: optional Sha1OrError sha1;
   2: optional SizeOrError size;
   3: optional SourceControlTypeOrError sourceControlType;
+  4: optional ObjectIdOrError objectId;
 }
 
 /**
@@ -785,6 +796,33 @@ struct CacheStats {
   6: i64 dropCount;
 }
 
+/**
+ * The latencies of one operation of a filesystem channel, in microseconds,
+ * since the channel started. The percentiles and max are the lower bounds of
+ * their buckets, which are within 1/8th of the true values.
+ */
+struct LatencyHistogramInfo {
+  /**
+   * The channel ("fuse", "nfs" or "prjfs"), mount, op, process and pid. For
+   * the instrumented locks, when telemetry:lock-contention-stats is set, the
+   * lock and the kind, "wait" or "hold", instead.
+   */
+  1: map<string, string> labels;
+  2: i64 count;
+  3: i64 p50;
+  4: i64 p90;
+  5: i64 p99;
+  6: i64 p999;
+  7: i64 p9999;
+  8: i64 max;
+  /**
+   * The number of durations in each non-empty bucket, by the lower bound of
+   * the bucket. As the counts only grow, the histogram of a time window is
+   * the difference of two calls.
+   */
+  9: map<i64, i64> buckets;
+}
+
 /*
  * Bits that control the stats returned from  getStatInfo
  */
@@ -933,6 +971,10 @@ struct HgEvent {
   7: optional RequestInfo requestInfo;
   8: HgImportPriority importPriority;
   9: HgImportCause importCause;
+
+  // Shared by all the imports done on behalf of the same filesystem or thrift
+  // request. Zero if unknown.
+  10: i64 traceId;
 }
 
 /**
@@ -949,6 +991,50 @@ struct GetRetroactiveHgEventsResult {
   1: list<HgEvent> events;
 }
 
+/**
+ * Where the time of one hg import went. The stages are consecutive, and the
+ * ones the import skipped last zero microseconds.
+ */
+struct HgImportTimeline {
+  1: i64 unique;
+  // See HgEvent.traceId.
+  2: i64 traceId;
+  3: HgResourceType resourceType;
+  4: HgImportCause importCause;
+  5: binary path;
+  // HG manifest node ID as 40-character hex string.
+  6: string manifestNodeId;
+  // When the backing store was asked for the object, in nanoseconds since
+  // the epoch.
+  7: i64 startTime;
+
+  // Looking the object up in hgcache before queueing the import.
+  8: i64 lookupDurationUs;
+  // Waiting for a worker to dequeue the import.
+  9: i64 queueDurationUs;
+  // The batch fetch from hgcache and then the server.
+  10: i64 batchDurationUs;
+  // The fallback to the hg importer when the batch fetch failed.
+  11: i64 importerDurationUs;
+  // The import joined one of the same object that was already queued or in
+  // progress: it only waited in the queue.
+  12: bool deduplicated;
+}
+
+/**
+ * Parameters for the getHgImportTimelines() function.
+ */
+struct GetHgImportTimelinesParams {
+  1: PathString mountPoint;
+}
+
+/**
+ * Return value for the getHgImportTimelines() function.
+ */
+struct GetHgImportTimelinesResult {
+  1: list<HgImportTimeline> timelines;
+}
+
 enum InodeType {
   TREE = 0,
   FILE = 1,
@@ -1204,6 +1290,13 @@ struct AccessCounts {
 struct MountAccesses {
   1: map<pid_t, AccessCounts> accessCountsByPid;
   2: map<pid_t, i64> fetchCountsByPid;
+  /**
+   * accessCountsByPid summed by command line, as in cmdsByPid, for the
+   * many short-lived processes running the same command, such as compilers.
+   * Processes whose command line is unknown are summed under the empty
+   * command line.
+   */
+  3: map<binary, AccessCounts> accessCountsByCmd;
 }
 
 struct GetAccessCountsResult {
@@ -1213,6 +1306,40 @@ struct GetAccessCountsResult {
 // 3: map<pid_t, AccessCount> thriftAccesses
 }
 
+/**
+ * How the fetches of a process that recently fetched from the backing store
+ * were treated, see the store:fetch-heavy-* configs.
+ */
+struct HeavyFetcher {
+  1: pid_t pid;
+  2: optional string processName;
+  // The estimated number of backing store fetches within the last
+  // store:fetch-heavy-window.
+  3: i64 recentFetches;
+  // Whether recentFetches is above store:fetch-heavy-window-threshold.
+  4: bool heavy;
+  // The fetches imported with the lowest priority class.
+  5: i64 deprioritizedFetches;
+  // The fetches delayed by store:fetch-heavy-rate-limit, and for how long in
+  // total.
+  6: i64 delayedFetches;
+  7: i64 totalDelayUs;
+}
+
+/**
+ * Parameters for the getHeavyFetchers() function.
+ */
+struct GetHeavyFetchersParams {
+  1: PathString mountPoint;
+}
+
+/**
+ * Return value for the getHeavyFetchers() function.
+ */
+struct GetHeavyFetchersResult {
+  1: list<HeavyFetcher> fetchers;
+}
+
 enum TracePointEvent {
   // Start of a new block
   START = 0,
@@ -1373,6 +1500,12 @@ struct RemoveRecursivelyParams {
   3: SyncBehavior sync;
 }
 
+struct CloneDirectoryParams {
+  1: PathString mountPoint;
+  2: PathString source;
+  3: PathString destination;
+}
+
 struct SynchronizeWorkingCopyParams {
   1: SyncBehavior sync;
 }
@@ -1423,6 +1556,18 @@ service EdenService extends fb303_core.BaseService {
     4: CheckOutRevisionParams params,
   ) throws (1: EdenError ex);
 
+  /**
+   * Reload the filter file of a mount cloned with a filter, and update the
+   * working directory to hide and show the paths it changed. The commit that
+   * is checked out and the working directory parent don't change.
+   *
+   * Like checkOutRevision() in NORMAL mode, paths with conflicts are left
+   * unmodified and reported.
+   */
+  list<CheckoutConflict> applyMountFilter(1: PathString mountPoint) throws (
+    1: EdenError ex,
+  );
+
   /**
    * Reset the working directory's parent commits, without changing the working
    * directory contents.
@@ -1800,6 +1945,22 @@ service EdenService extends fb303_core.BaseService {
     3: bool localStoreOnly,
   ) throws (1: EdenError ex);
 
+  /**
+   * Like debugGetScmBlob(), but rather than copying the contents into the
+   * reply, send a sealed memfd holding them along with it, which the client
+   * can map. Returns the size of the blob.
+   *
+   * The memfd is passed in the reply header, so this is only available to
+   * clients connected over the unix socket, and only on Linux. Blobs that are
+   * not already held in a memfd (see store:memfd-blob-min-size) are copied
+   * into one.
+   */
+  i64 debugGetScmBlobFd(
+    1: PathString mountPoint,
+    2: ThriftObjectId id,
+    3: bool localStoreOnly,
+  ) throws (1: EdenError ex);
+
   /**
    * Get the metadata about a source control Blob.
    *
@@ -1935,6 +2096,15 @@ service EdenService extends fb303_core.BaseService {
     1: EdenError ex,
   );
 
+  /**
+   * Gets the processes that recently fetched from the backing store of a
+   * mount, and whether their fetches were deprioritized or rate limited for
+   * being heavy.
+   */
+  GetHeavyFetchersResult getHeavyFetchers(
+    1: GetHeavyFetchersParams params,
+  ) throws (1: EdenError ex);
+
   /**
    * Start recording paths of the files fetched from the backing store.
    *
@@ -2008,6 +2178,33 @@ service EdenService extends fb303_core.BaseService {
    */
   void flushStatsNow() throws (1: EdenError ex);
 
+  /**
+   * Get the latency histograms of the operations of every mounted
+   * filesystem channel, with the durations recorded by all the threads up to
+   * now.
+   */
+  list<LatencyHistogramInfo> getLatencyHistograms() throws (1: EdenError ex);
+
+  /**
+   * Get estimates of the bytes used by each part of EdenFS: "inodes",
+   * "journal", "blob_cache", "tree_cache" and the "local_store.*" memtables,
+   * table readers and block caches; along with the "malloc.*" statistics of
+   * the allocator, when it is jemalloc, and the "rss" of the process.
+   *
+   * The difference between malloc.active and malloc.allocated is
+   * fragmentation, and the difference between the allocated bytes and the sum
+   * of the estimates the memory this doesn't account for.
+   */
+  map<string, i64> debugMemoryBreakdown() throws (1: EdenError ex);
+
+  /**
+   * Get the recent samples of the phases of the in-flight filesystem
+   * requests, like "fuse;lookup;objectstore;hgimportqueue 42", as folded
+   * stacks that flamegraph.pl can render. The sampling rate is set by
+   * telemetry:request-sample-interval.
+   */
+  string getRequestSamples() throws (1: EdenError ex);
+
   /**
   * Invalidate kernel cache for inode.
   */
@@ -2043,6 +2240,15 @@ service EdenService extends fb303_core.BaseService {
     1: GetRetroactiveHgEventsParams params,
   ) throws (1: EdenError ex);
 
+  /**
+   * Gets the timelines of the most recent hg imports of a mount, stored
+   * alongside the Hg ActivityBuffer: their traceId links them to the hg
+   * events of the same fetches.
+   */
+  GetHgImportTimelinesResult getHgImportTimelines(
+    1: GetHgImportTimelinesParams params,
+  ) throws (1: EdenError ex);
+
   /**
    * Gets a list of inode events stored in a specified EdenMount's
    * ActivityBuffer. Used for retroactive debugging by the `eden trace inode
@@ -2052,6 +2258,26 @@ service EdenService extends fb303_core.BaseService {
     1: GetRetroactiveInodeEventsParams params,
   ) throws (1: EdenError ex);
 
+  /**
+   * Like getRetroactiveInodeEvents, but returns the events as a compact binary
+   * snapshot that is much cheaper to produce and transfer for large
+   * ActivityBuffers.
+   *
+   * All the integers are little-endian. The snapshot starts with a u32 format
+   * version, currently 1, followed by one record per event, oldest first:
+   *   i64 timestamp, in nanoseconds since the epoch
+   *   i64 monotonic_time_ns
+   *   u64 ino
+   *   u8 InodeType
+   *   u8 InodeEventType
+   *   u8 InodeEventProgress
+   *   i64 duration, in microseconds
+   *   u32 length of the path, followed by the path
+   */
+  binary getRetroactiveInodeEventsSnapshot(
+    1: GetRetroactiveInodeEventsParams params,
+  ) throws (1: EdenError ex);
+
   /**
    * Configure a new fault in Eden's fault injection framework.
    *
@@ -2093,6 +2319,19 @@ service EdenService extends fb303_core.BaseService {
     1: EdenError ex,
   );
 
+  /**
+   * Make destination a copy of the directory at source in constant time, by
+   * pointing it at the source control tree source matches. Neither copy
+   * shares materialized data with the other: each is materialized on its own
+   * as it is modified.
+   *
+   * Fails if source is materialized, as it then matches no source control
+   * tree, or if destination conflicts with existing files.
+   */
+  void cloneDirectory(1: CloneDirectoryParams params) throws (
+    1: EdenError ex,
+  );
+
   /**
    * Eagerly materialize a list of paths, which can improve the latency of random reads.
    * If the path is a file, materialize the file.
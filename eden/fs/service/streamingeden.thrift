@@ -88,6 +88,204 @@ struct ChangesSinceResult {
 struct StreamChangesSinceParams {
   1: eden.PathString mountPoint;
   2: eden.JournalPosition fromPosition;
+  /**
+   * When not empty, only the paths inside one of these directories, relative
+   * to the mount, are returned.
+   */
+  3: list<eden.PathString> includedRoots;
+  /**
+   * When not empty, only the paths matching one of these globs are returned.
+   */
+  4: list<string> globs;
+  /**
+   * Whether to return the paths ignored by the user and system ignore files.
+   */
+  5: bool includeIgnored = true;
+}
+
+/**
+ * A file matched by streamGlobFiles.
+ */
+struct GlobFileResult {
+  1: eden.PathString name;
+  2: eden.OsDtype dtype;
+  /**
+   * The revision the file was matched in, or the working copy's parent when
+   * no revision was given.
+   */
+  3: eden.ThriftRootId originHash;
+}
+
+/**
+ * Bounds of the walks of streamInodeStatus and streamScmTree. A value of 0
+ * uses the limit configured on the server, which also caps larger values.
+ */
+struct DebugWalkLimits {
+  /**
+   * Number of directory levels below the starting one that are walked.
+   */
+  1: i64 maxDepth;
+  /**
+   * Number of directory entries after which the walk stops. The stream then
+   * completes with an error, to distinguish a truncated walk from a complete
+   * one.
+   */
+  2: i64 maxEntries;
+}
+
+struct StreamInodeStatusParams {
+  1: eden.PathString mountPoint;
+  2: eden.PathString path;
+  /**
+   * See the DIS_* flags of debugInodeStatus.
+   */
+  3: i64 flags;
+  4: eden.SyncBehavior sync;
+  5: DebugWalkLimits limits;
+}
+
+struct StreamScmTreeParams {
+  1: eden.PathString mountPoint;
+  2: eden.ThriftObjectId id;
+  3: bool localStoreOnly;
+  4: DebugWalkLimits limits;
+}
+
+/**
+ * The entries of one of the trees walked by streamScmTree.
+ */
+struct ScmTreeChunk {
+  /**
+   * The path of the tree, relative to the starting one.
+   */
+  1: eden.PathString path;
+  2: eden.ThriftObjectId id;
+  3: list<eden.ScmTreeEntry> entries;
+}
+
+struct StreamScmStatusParams {
+  1: eden.PathString mountPoint;
+  /**
+   * As in GetScmStatusParams, the current parent commit of the mount.
+   */
+  2: eden.ThriftRootId commit;
+  3: bool listIgnored = false;
+}
+
+/**
+ * A part of the status streamed by streamScmStatus, with the fields of
+ * eden.ScmStatus. Each path is in a single chunk.
+ */
+struct ScmStatusChunk {
+  1: map<eden.PathString, eden.ScmFileStatus> entries;
+  2: map<eden.PathString, string> errors;
+}
+
+struct PreloadDirectory {
+  1: eden.PathString path;
+  /**
+   * Number of directory levels below path to preload. 0 only preloads the
+   * directory itself, a negative value preloads all of them.
+   */
+  2: i64 depth;
+}
+
+struct PreloadDirectoriesParams {
+  1: eden.PathString mountPoint;
+  2: list<PreloadDirectory> directories;
+  /**
+   * Also load the inodes of the directories, so that the first lookups in
+   * them don't have to.
+   */
+  3: bool loadInodes;
+}
+
+struct PreloadDirectoriesProgress {
+  /**
+   * The directory level being preloaded, relative to the requested
+   * directories.
+   */
+  1: i64 depth;
+  2: i64 treesFetched;
+  3: i64 inodesLoaded;
+  /**
+   * Directories of the current level whose subdirectories are not fetched
+   * yet.
+   */
+  4: i64 pendingDirectories;
+}
+
+struct PlanCheckoutParams {
+  1: eden.PathString mountPoint;
+  2: eden.ThriftRootId snapshotHash;
+  /**
+   * Also fetch the contents of the files that the checkout would update,
+   * once the plan is complete. The trees are fetched by the planning itself.
+   */
+  3: bool prefetch;
+}
+
+/**
+ * A path that checking out the snapshot would update. ADDED, MODIFIED and
+ * REMOVED are relative to the currently checked out snapshot.
+ */
+struct PlannedCheckoutEntry {
+  1: eden.PathString path;
+  /**
+   * The type of the entry in the destination snapshot, or in the current one
+   * for removals.
+   */
+  2: eden.Dtype dtype;
+  3: eden.ScmFileStatus status;
+  /**
+   * The file was changed in the working copy too.
+   */
+  4: bool conflict;
+}
+
+struct PlannedCheckoutSummary {
+  /**
+   * Trees and blobs of the destination snapshot that the checkout reads.
+   */
+  1: i64 treesToFetch;
+  2: i64 blobsToFetch;
+  3: i64 conflicts;
+  4: i64 inodesInvalidated;
+}
+
+union PlannedCheckoutChunk {
+  1: PlannedCheckoutEntry entry;
+  2: PlannedCheckoutSummary summary;
+}
+
+/**
+ * How far along the checkout of a mount is.
+ */
+struct CheckoutProgressInfo {
+  /**
+   * Directories whose update started, including those finished, and
+   * directories skipped because the interrupted checkout being resumed
+   * already updated them.
+   */
+  1: i64 directoriesStarted;
+  2: i64 directoriesFinished;
+  3: i64 directoriesResumed;
+  /**
+   * Files and directories replaced, added or removed so far.
+   */
+  4: i64 entriesUpdated;
+  /**
+   * Objects fetched from the network so far.
+   */
+  5: i64 treesFetched;
+  6: i64 blobsFetched;
+  7: i64 blobMetadataFetched;
+  8: i64 elapsedMs;
+  /**
+   * A rough estimate, extrapolated from the time the directories finished so
+   * far took. Unset until a directory is finished.
+   */
+  9: optional i64 estimatedRemainingMs;
 }
 
 /**
@@ -177,4 +375,91 @@ service StreamingEdenService extends eden.EdenService {
   > streamChangesSince(1: StreamChangesSinceParams params) throws (
     1: eden.EdenError ex,
   );
+
+  /**
+   * Has the same behavior as globFiles, but streams the matching files as
+   * soon as they are found, rather than returning them all at once when the
+   * whole glob has been evaluated.
+   *
+   * Files are streamed in no particular order and may be streamed several
+   * times, for instance when several globs match them. suppressFileList and
+   * wantDtype are ignored: every file is streamed with its dtype.
+   */
+  stream<GlobFileResult throws (1: eden.EdenError ex)> streamGlobFiles(
+    1: eden.GlobParams params,
+  ) throws (1: eden.EdenError ex);
+
+  /**
+   * Has the same behavior as debugInodeStatus, but streams the information
+   * of each directory as the walk reaches it, rather than building the whole
+   * list in memory first.
+   */
+  stream<
+    eden.TreeInodeDebugInfo throws (1: eden.EdenError ex)
+  > streamInodeStatus(1: StreamInodeStatusParams params) throws (
+    1: eden.EdenError ex,
+  );
+
+  /**
+   * Streams the contents of a source control tree and of its subtrees, one
+   * tree at a time in depth-first order. Each tree is loaded as
+   * debugGetScmTree would.
+   */
+  stream<ScmTreeChunk throws (1: eden.EdenError ex)> streamScmTree(
+    1: StreamScmTreeParams params,
+  ) throws (1: eden.EdenError ex);
+
+  /**
+   * Has the same behavior as getScmStatusV2, but streams the status in chunks
+   * of up to thrift:status-stream-chunk-size paths as the diff finds them,
+   * rather than returning it all at once when the diff completes.
+   *
+   * The diff is paused while thrift:status-stream-max-pending-chunks chunks
+   * wait to be sent, so that a slow client doesn't make the server hold the
+   * whole status in memory. Chunks are streamed in no particular order.
+   */
+  stream<ScmStatusChunk throws (1: eden.EdenError ex)> streamScmStatus(
+    1: StreamScmStatusParams params,
+  ) throws (1: eden.EdenError ex);
+
+  /**
+   * Fetches the trees of the given directories, and of their subdirectories
+   * up to the requested depth, ahead of a workload that is known to access
+   * them, like a build. The trees of a directory level are fetched together
+   * so that they are imported in batches. File contents are not fetched.
+   *
+   * The progress is streamed as the directories are preloaded. The stream
+   * completes with an error if a directory doesn't exist or if more trees
+   * than thrift:preload-max-trees would be fetched.
+   */
+  stream<
+    PreloadDirectoriesProgress throws (1: eden.EdenError ex)
+  > preloadDirectories(1: PreloadDirectoriesParams params) throws (
+    1: eden.EdenError ex,
+  );
+
+  /**
+   * Estimates the cost of checkOutRevision to the given snapshot without
+   * checking it out, from the source control trees of the current and
+   * destination snapshots: no inode is loaded. Conflicts are the files to
+   * update that the working copy changed, which makes them an estimate of
+   * those of a NORMAL checkout.
+   *
+   * Each path to update is streamed as it is found, followed by a summary
+   * once the plan is complete.
+   */
+  stream<PlannedCheckoutChunk throws (1: eden.EdenError ex)> planCheckout(
+    1: PlanCheckoutParams params,
+  ) throws (1: eden.EdenError ex);
+
+  /**
+   * Reports the progress of the checkout of the mount every
+   * thrift:checkout-progress-interval. The stream completes once the
+   * checkout does, immediately if none is in progress.
+   */
+  stream<
+    CheckoutProgressInfo throws (1: eden.EdenError ex)
+  > streamCheckoutProgress(1: eden.PathString mountPoint) throws (
+    1: eden.EdenError ex,
+  );
 }
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/service/ChangesSinceFilter.h"
+
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/model/git/TopLevelIgnores.h"
+#include "eden/fs/service/gen-cpp2/streamingeden_types.h"
+
+using namespace facebook::eden;
+using namespace facebook::eden::path_literals;
+
+namespace {
+StreamChangesSinceParams makeParams(
+    std::vector<std::string> includedRoots,
+    std::vector<std::string> globs) {
+  StreamChangesSinceParams params;
+  params.includedRoots() = std::move(includedRoots);
+  params.globs() = std::move(globs);
+  return params;
+}
+} // namespace
+
+TEST(ChangesSinceFilterTest, emptyFiltersMatchEverything) {
+  ChangesSinceFilter filter{
+      makeParams({}, {}), nullptr, CaseSensitivity::Sensitive};
+  EXPECT_TRUE(filter.matchesAll());
+  EXPECT_TRUE(filter.matches("foo/bar"_relpath));
+}
+
+TEST(ChangesSinceFilterTest, includedRootsMatchTheirSubtrees) {
+  ChangesSinceFilter filter{
+      makeParams({"fbcode/foo", "www"}, {}),
+      nullptr,
+      CaseSensitivity::Sensitive};
+  EXPECT_FALSE(filter.matchesAll());
+  EXPECT_TRUE(filter.matches("fbcode/foo"_relpath));
+  EXPECT_TRUE(filter.matches("fbcode/foo/bar.cpp"_relpath));
+  EXPECT_TRUE(filter.matches("www/index.php"_relpath));
+  EXPECT_FALSE(filter.matches("fbcode/foobar/baz.cpp"_relpath));
+  EXPECT_FALSE(filter.matches("fbcode"_relpath));
+  EXPECT_FALSE(filter.matches("FBCODE/foo/bar.cpp"_relpath));
+}
+
+TEST(ChangesSinceFilterTest, includedRootsFollowCaseSensitivity) {
+  ChangesSinceFilter filter{
+      makeParams({"fbcode/foo"}, {}), nullptr, CaseSensitivity::Insensitive};
+  EXPECT_TRUE(filter.matches("FBCODE/Foo/bar.cpp"_relpath));
+}
+
+TEST(ChangesSinceFilterTest, mountRootIncludesEverything) {
+  ChangesSinceFilter filter{
+      makeParams({"fbcode", ""}, {}), nullptr, CaseSensitivity::Sensitive};
+  EXPECT_TRUE(filter.matchesAll());
+}
+
+TEST(ChangesSinceFilterTest, globsMustMatchTheWholePath) {
+  ChangesSinceFilter filter{
+      makeParams({}, {"fbcode/foo/**", "*.py"}),
+      nullptr,
+      CaseSensitivity::Sensitive};
+  EXPECT_TRUE(filter.matches("fbcode/foo/bar/baz.cpp"_relpath));
+  EXPECT_TRUE(filter.matches("setup.py"_relpath));
+  EXPECT_FALSE(filter.matches("fbcode/bar/baz.cpp"_relpath));
+}
+
+TEST(ChangesSinceFilterTest, invalidGlobsThrow) {
+  EXPECT_THROW(
+      ChangesSinceFilter(
+          makeParams({}, {"foo/[a"}), nullptr, CaseSensitivity::Sensitive),
+      EdenError);
+}
+
+TEST(ChangesSinceFilterTest, ignoredPathsAreRejected) {
+  ChangesSinceFilter filter{
+      makeParams({}, {}),
+      std::make_unique<TopLevelIgnores>("*.o\n", "build/\n!keep.o\n"),
+      CaseSensitivity::Sensitive};
+  EXPECT_FALSE(filter.matchesAll());
+  EXPECT_TRUE(filter.matches("src/main.cpp"_relpath));
+  EXPECT_FALSE(filter.matches("src/main.o"_relpath));
+  EXPECT_TRUE(filter.matches("src/keep.o"_relpath));
+  // Files inside ignored directories can't be unignored.
+  EXPECT_FALSE(filter.matches("build/keep.o"_relpath));
+  EXPECT_FALSE(filter.matches("src/build/out.txt"_relpath));
+}
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/service/StartupProfiler.h"
+
+#include <folly/portability/GTest.h>
+#include <thread>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+TEST(StartupProfiler, phasesAreRecordedInTheOrderTheyStarted) {
+  StartupProfiler profiler;
+  auto outer = profiler.startPhase("outer");
+  {
+    auto inner = profiler.startPhase("inner");
+    std::this_thread::sleep_for(1ms);
+  }
+  outer.end();
+
+  auto phases = profiler.getPhases();
+  ASSERT_EQ(2, phases.size());
+  EXPECT_EQ("outer", phases[0].name);
+  EXPECT_EQ("inner", phases[1].name);
+  EXPECT_LE(phases[0].start, phases[1].start);
+  EXPECT_GE(phases[0].duration, phases[1].duration);
+  EXPECT_GE(phases[1].duration, 1ms);
+}
+
+TEST(StartupProfiler, phasesAreRecordedOnce) {
+  StartupProfiler profiler;
+  {
+    auto phase = profiler.startPhase("moved");
+    auto moved = std::move(phase);
+    moved.end();
+    moved.end();
+  }
+  ASSERT_EQ(1, profiler.getPhases().size());
+}
+
+TEST(StartupProfiler, phasesFromManyThreads) {
+  StartupProfiler profiler;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back([&] { profiler.startPhase("thread"); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(8, profiler.getPhases().size());
+}
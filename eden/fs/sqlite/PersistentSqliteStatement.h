@@ -7,6 +7,9 @@
 
 #pragma once
 
+#include <memory>
+#include <string>
+
 #include "eden/fs/sqlite/SqliteConnection.h"
 #include "eden/fs/sqlite/SqliteStatement.h"
 
@@ -84,6 +87,22 @@ class PersistentSqliteStatement {
     return Guard{stmt_};
   }
 
+  /**
+   * Obtain the statement described by `sql` on the locked connection,
+   * preparing it the first time it runs there. Unlike a
+   * PersistentSqliteStatement, which is bound to the connection it was
+   * prepared on, this works with whichever connection of a SqliteDatabase the
+   * caller holds, such as one returned by `SqliteDatabase::lockRead()`.
+   */
+  static Guard getCached(LockedSqliteConnection& db, std::string sql) {
+    auto it = db->statements.find(sql);
+    if (it == db->statements.end()) {
+      auto stmt = std::make_shared<SqliteStatement>(db, sql);
+      it = db->statements.emplace(std::move(sql), std::move(stmt)).first;
+    }
+    return Guard{*it->second};
+  }
+
  private:
   SqliteStatement stmt_;
 };
@@ -10,14 +10,26 @@
 #include <sqlite3.h>
 
 #include <folly/Synchronized.h>
+#include <memory>
+#include <string>
+#include <unordered_map>
 
 namespace facebook::eden {
 
+class SqliteStatement;
+
 enum class SqliteDbStatus { NOT_YET_OPENED, FAILED_TO_OPEN, OPEN, CLOSED };
 
 struct SqliteConnection {
   sqlite3* db{nullptr};
   SqliteDbStatus status{SqliteDbStatus::NOT_YET_OPENED};
+
+  /**
+   * The statements prepared on this connection by
+   * PersistentSqliteStatement::getCached(), keyed by their query. They must
+   * be cleared before the connection is closed.
+   */
+  std::unordered_map<std::string, std::shared_ptr<SqliteStatement>> statements;
 };
 
 using LockedSqliteConnection = folly::Synchronized<SqliteConnection>::LockedPtr;
@@ -8,6 +8,8 @@
 #include "eden/fs/sqlite/SqliteDatabase.h"
 
 #include <folly/logging/xlog.h>
+#include <chrono>
+#include <thread>
 #include "eden/fs/sqlite/PersistentSqliteStatement.h"
 
 namespace facebook::eden {
@@ -22,6 +24,43 @@ struct SqliteDatabase::StatementCache {
   PersistentSqliteStatement rollbackTransaction;
 };
 
+namespace {
+/**
+ * How long a read connection waits for the writer to release the database,
+ * for the brief moments when WAL readers can still be blocked.
+ */
+constexpr int kReadBusyTimeoutMs = 5000;
+
+constexpr folly::StringPiece kInMemoryPath{":memory:"};
+
+void checkOpen(const SqliteConnection& conn) {
+  switch (conn.status) {
+    case SqliteDbStatus::OPEN:
+      break;
+    case SqliteDbStatus::NOT_YET_OPENED:
+      throw std::runtime_error(
+          "the SqliteDatabase database has not yet been opened");
+    case SqliteDbStatus::FAILED_TO_OPEN:
+      throw std::runtime_error(
+          "the SqliteDatabase database failed to be opened");
+    case SqliteDbStatus::CLOSED:
+      throw std::runtime_error(
+          "the SqliteDatabase database has already been closed");
+  }
+}
+
+void closeConnection(SqliteConnection& conn) {
+  conn.status = SqliteDbStatus::CLOSED;
+  // Like other statement caches, the statements must be finalized before the
+  // connection is closed.
+  conn.statements.clear();
+  if (conn.db) {
+    sqlite3_close(conn.db);
+    conn.db = nullptr;
+  }
+}
+} // namespace
+
 void checkSqliteResult(sqlite3* db, int result) {
   if (result == SQLITE_OK) {
     return;
@@ -45,7 +84,16 @@ void checkSqliteResult(sqlite3* db, int result) {
 }
 
 SqliteDatabase::SqliteDatabase(AbsolutePathPiece path, DelayOpeningDB)
-    : dbPath_(path.copy().value()), db_{}, cache_{nullptr} {}
+    : SqliteDatabase(path, DelayOpeningDB{}, Options{}) {}
+
+SqliteDatabase::SqliteDatabase(
+    AbsolutePathPiece path,
+    DelayOpeningDB,
+    Options options)
+    : dbPath_(path.copy().value()),
+      options_(options),
+      db_{},
+      cache_{nullptr} {}
 
 SqliteDatabase::SqliteDatabase(std::string addr)
     : dbPath_(std::move(addr)), db_{} {
@@ -78,19 +126,68 @@ void SqliteDatabase::openDb() {
   lockedState->db = db;
 
   cache_ = std::make_unique<StatementCache>(lockedState);
+
+  configureConnection(lockedState);
+  if (options_.readConnections > 0 && dbPath_ != kInMemoryPath) {
+    openReadConnections(lockedState);
+  }
+}
+
+void SqliteDatabase::configureConnection(LockedSqliteConnection& conn) {
+  if (options_.mmapSize > 0) {
+    SqliteStatement(conn, "PRAGMA mmap_size=", options_.mmapSize).step();
+  }
+  if (options_.cacheSizeKB > 0) {
+    // Negative sizes are in KiB rather than in pages.
+    SqliteStatement(conn, "PRAGMA cache_size=-", options_.cacheSizeKB).step();
+  }
+}
+
+void SqliteDatabase::openReadConnections(LockedSqliteConnection& writer) {
+  // Readers only run concurrently with the writer in WAL mode.
+  SqliteStatement(writer, "PRAGMA journal_mode=WAL").step();
+
+  for (size_t i = 0; i < options_.readConnections; ++i) {
+    sqlite3* db = nullptr;
+    auto result =
+        sqlite3_open_v2(dbPath_.c_str(), &db, SQLITE_OPEN_READONLY, nullptr);
+    if (result != SQLITE_OK) {
+      // Reads are served by the connections opened so far, or by the writer.
+      XLOGF(
+          WARN,
+          "unable to open sqlite read connection to {}: {}",
+          dbPath_,
+          sqlite3_errstr(result));
+      // @lint-ignore CLANGTIDY
+      sqlite3_close(db);
+      break;
+    }
+    sqlite3_busy_timeout(db, kReadBusyTimeoutMs);
+
+    auto reader = std::make_unique<folly::Synchronized<SqliteConnection>>();
+    {
+      auto conn = reader->wlock();
+      conn->db = db;
+      conn->status = SqliteDbStatus::OPEN;
+      configureConnection(conn);
+    }
+    readers_.push_back(std::move(reader));
+  }
 }
 
 void SqliteDatabase::close() {
+  // Close the readers first, so that the writer is the last connection and
+  // checkpoints the WAL as it closes.
+  for (auto& reader : readers_) {
+    closeConnection(*reader->wlock());
+  }
+
   auto db = db_.wlock();
-  db->status = SqliteDbStatus::CLOSED;
   // We must clear the cached statement before closing the database. Otherwise
   // `sqlite3_close` will fail with `SQLITE_BUSY`. This rule applies to any
   // statement cache elsewhere too.
   cache_.reset();
-  if (db->db) {
-    sqlite3_close(db->db);
-    db->db = nullptr;
-  }
+  closeConnection(*db);
 }
 
 SqliteDatabase::~SqliteDatabase() {
@@ -99,22 +196,33 @@ SqliteDatabase::~SqliteDatabase() {
 
 LockedSqliteConnection SqliteDatabase::lock() {
   auto db = db_.wlock();
-  switch (db->status) {
-    case SqliteDbStatus::OPEN:
-      break;
-    case SqliteDbStatus::NOT_YET_OPENED:
-      throw std::runtime_error(
-          "the SqliteDatabase database has not yet been opened");
-    case SqliteDbStatus::FAILED_TO_OPEN:
-      throw std::runtime_error(
-          "the SqliteDatabase database failed to be opened");
-    case SqliteDbStatus::CLOSED:
-      throw std::runtime_error(
-          "the SqliteDatabase database has already been closed");
-  }
+  checkOpen(*db);
   return db;
 }
 
+LockedSqliteConnection SqliteDatabase::lockRead() {
+  if (readers_.empty()) {
+    return lock();
+  }
+
+  // Prefer an idle connection, starting from one picked by the thread so that
+  // concurrent readers don't all try the same connections first.
+  auto numReaders = readers_.size();
+  auto start =
+      std::hash<std::thread::id>{}(std::this_thread::get_id()) % numReaders;
+  for (size_t i = 0; i < numReaders; ++i) {
+    // A zero timeout tries the lock, and returns the same type as lock().
+    if (auto conn = readers_[(start + i) % numReaders]->wlock(
+            std::chrono::milliseconds::zero())) {
+      checkOpen(*conn);
+      return conn;
+    }
+  }
+  auto conn = readers_[start]->wlock();
+  checkOpen(*conn);
+  return conn;
+}
+
 void SqliteDatabase::transaction(
     const std::function<void(LockedSqliteConnection&)>& func) {
   auto conn = lock();
@@ -9,6 +9,8 @@
 
 #include <folly/Synchronized.h>
 #include <sqlite3.h>
+#include <memory>
+#include <vector>
 
 #include "eden/fs/sqlite/SqliteConnection.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -26,6 +28,28 @@ class SqliteDatabase {
   constexpr static struct InMemory {
   } inMemory{};
 
+  struct Options {
+    /**
+     * Number of read-only connections serving `lockRead()`, so that readers
+     * don't wait on each other nor on the writer. The database is switched to
+     * WAL mode when there are any. In-memory databases have none, as their
+     * connections can't share them.
+     */
+    size_t readConnections{0};
+
+    /**
+     * Maximum number of bytes of the database file accessed through
+     * memory-mapped I/O by each connection, or 0 for the sqlite default.
+     */
+    uint64_t mmapSize{0};
+
+    /**
+     * Size of the page cache of each connection in KiB, or 0 for the sqlite
+     * default.
+     */
+    uint64_t cacheSizeKB{0};
+  };
+
   /** Open a handle to the database at the specified path.
    * Will throw an exception if the database fails to open.
    * The database will be created if it didn't already exist.
@@ -38,6 +62,8 @@ class SqliteDatabase {
    */
   SqliteDatabase(AbsolutePathPiece path, DelayOpeningDB);
 
+  SqliteDatabase(AbsolutePathPiece path, DelayOpeningDB, Options options);
+
   /**
    * Create a SQLite database in memory. It will throw an exception if the
    * database fails to open. This should be only used in testing.
@@ -70,6 +96,14 @@ class SqliteDatabase {
    * to the SqliteStatement class. */
   LockedSqliteConnection lock();
 
+  /**
+   * Obtain a locked database pointer for queries that don't write. It is one
+   * of the read connections when there are any, whose statements must be
+   * cached with `PersistentSqliteStatement::getCached()`, and the same as
+   * `lock()` otherwise.
+   */
+  LockedSqliteConnection lockRead();
+
   /**
    * Executes a SQLite transaction. If the lambda body throws any error, the
    * transaction will be rolled back. This function returns a boolean to
@@ -93,10 +127,18 @@ class SqliteDatabase {
 
   explicit SqliteDatabase(std::string address);
 
+  void configureConnection(LockedSqliteConnection& conn);
+  void openReadConnections(LockedSqliteConnection& writer);
+
   std::string dbPath_;
+  Options options_;
 
   folly::Synchronized<SqliteConnection> db_;
 
+  /** Only created by openDb(), and not resized afterwards. */
+  std::vector<std::unique_ptr<folly::Synchronized<SqliteConnection>>>
+      readers_;
+
   std::unique_ptr<StatementCache> cache_;
 };
 } // namespace facebook::eden
@@ -6,9 +6,12 @@
  */
 
 #include <folly/portability/GTest.h>
+#include <folly/testing/TestUtil.h>
 #include <cstddef>
 #include <memory>
 #include <stdexcept>
+#include <thread>
+#include <vector>
 
 #include "eden/fs/sqlite/PersistentSqliteStatement.h"
 #include "eden/fs/sqlite/SqliteDatabase.h"
@@ -81,4 +84,61 @@ TEST_F(SqliteTest, testPersistentSqliteStatement) {
     exec->step();
   }
 }
+
+TEST(SqliteDatabaseTest, readConnectionsSeeCommittedWrites) {
+  folly::test::TemporaryDirectory dir;
+  SqliteDatabase::Options options;
+  options.readConnections = 2;
+  options.mmapSize = 1024 * 1024;
+  options.cacheSizeKB = 1024;
+  SqliteDatabase db{
+      canonicalPath(dir.path().string()) + "test.db"_pc,
+      SqliteDatabase::DelayOpeningDB{},
+      options};
+  db.openDb();
+
+  {
+    auto conn = db.lock();
+    SqliteStatement(conn, "CREATE TABLE test (id INTEGER NOT NULL)").step();
+    SqliteStatement(conn, "INSERT INTO test (id) VALUES (1), (2)").step();
+  }
+
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; ++i) {
+    readers.emplace_back([&] {
+      for (int j = 0; j < 100; ++j) {
+        auto conn = db.lockRead();
+        auto stmt = PersistentSqliteStatement::getCached(
+            conn, "SELECT COUNT(*) FROM test");
+        ASSERT_TRUE(stmt->step());
+        EXPECT_EQ(2, stmt->columnUint64(0));
+      }
+    });
+  }
+  for (auto& reader : readers) {
+    reader.join();
+  }
+
+  // Read connections can't write.
+  auto conn = db.lockRead();
+  EXPECT_THROW(
+      SqliteStatement(conn, "INSERT INTO test (id) VALUES (3)").step(),
+      std::runtime_error);
+}
+
+TEST_F(SqliteTest, cachedStatementsArePreparedOncePerConnection) {
+  auto conn = db.lock();
+  SqliteStatement* first = nullptr;
+  {
+    auto stmt = PersistentSqliteStatement::getCached(conn, "SELECT ?");
+    first = &*stmt;
+    stmt->bind(1, static_cast<int64_t>(1));
+    ASSERT_TRUE(stmt->step());
+  }
+  auto stmt = PersistentSqliteStatement::getCached(conn, "SELECT ?");
+  EXPECT_EQ(first, &*stmt);
+  // The statement was reset, along with its bindings.
+  ASSERT_TRUE(stmt->step());
+  EXPECT_EQ(0, stmt->columnUint64(0));
+}
 } // namespace facebook::eden
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/AccessModelStore.h"
+
+#include <fmt/format.h>
+#include <folly/Utility.h>
+#include <folly/container/F14Map.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBufQueue.h>
+#include <folly/logging/xlog.h>
+#include <algorithm>
+
+#include "eden/fs/store/LocalStore.h"
+#include "eden/fs/store/StoreResult.h"
+
+namespace facebook::eden {
+
+namespace {
+/**
+ * The serialized models are stored as:
+ * - version (1 byte)
+ * - number of sessions (4 bytes, big endian)
+ * - number of followers (4 bytes, big endian)
+ * - for each follower:
+ *   - path length (2 bytes, big endian), then path
+ *   - number of sessions (4 bytes, big endian)
+ */
+constexpr uint8_t kFormatVersion = 1;
+
+AccessModel deserialize(folly::ByteRange bytes) {
+  folly::IOBuf buf{folly::IOBuf::WRAP_BUFFER, bytes};
+  folly::io::Cursor cursor{&buf};
+  auto version = cursor.read<uint8_t>();
+  if (version != kFormatVersion) {
+    throw std::invalid_argument(
+        fmt::format("unknown access model format version {}", version));
+  }
+
+  AccessModel model;
+  model.sessions = cursor.readBE<uint32_t>();
+  auto count = cursor.readBE<uint32_t>();
+  model.followers.reserve(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    auto path = cursor.readFixedString(cursor.readBE<uint16_t>());
+    auto sessions = cursor.readBE<uint32_t>();
+    model.followers.push_back(
+        AccessModel::Follower{RelativePath{std::move(path)}, sessions});
+  }
+  return model;
+}
+} // namespace
+
+void AccessModel::learn(
+    const std::vector<RelativePath>& readFiles,
+    size_t maxFollowers) {
+  ++sessions;
+
+  // The index points into the paths of the followers, which must not move.
+  followers.reserve(followers.size() + readFiles.size());
+  folly::F14FastMap<RelativePathPiece, size_t> indexes;
+  indexes.reserve(followers.size());
+  for (size_t i = 0; i < followers.size(); ++i) {
+    indexes.emplace(followers[i].path, i);
+  }
+  for (const auto& path : readFiles) {
+    auto it = indexes.find(path);
+    if (it != indexes.end()) {
+      ++followers[it->second].sessions;
+    } else {
+      indexes.emplace(path, followers.size());
+      followers.push_back(Follower{path, 1});
+    }
+  }
+
+  // The stable sort keeps the files read earliest first among equally
+  // frequent ones.
+  std::stable_sort(
+      followers.begin(), followers.end(), [](const auto& a, const auto& b) {
+        return a.sessions > b.sessions;
+      });
+  if (followers.size() > maxFollowers) {
+    followers.resize(maxFollowers);
+  }
+}
+
+AccessModelStore::AccessModelStore(std::shared_ptr<LocalStore> localStore)
+    : localStore_{std::move(localStore)} {}
+
+std::optional<AccessModel> AccessModelStore::get(const Hash20& key) const {
+  auto result = localStore_->get(KeySpace::AccessModelFamily, key.getBytes());
+  if (!result.isValid()) {
+    return std::nullopt;
+  }
+  try {
+    return deserialize(result.bytes());
+  } catch (const std::exception& ex) {
+    XLOG(WARN) << "Ignoring unreadable access model " << key << ": "
+               << ex.what();
+    return std::nullopt;
+  }
+}
+
+void AccessModelStore::put(const Hash20& key, const AccessModel& model) const {
+  folly::IOBufQueue queue{folly::IOBufQueue::cacheChainLength()};
+  folly::io::QueueAppender appender{&queue, 4096};
+  appender.write<uint8_t>(kFormatVersion);
+  appender.writeBE<uint32_t>(model.sessions);
+
+  // Paths too long for the format are not worth prefetching.
+  std::vector<const AccessModel::Follower*> followers;
+  followers.reserve(model.followers.size());
+  for (const auto& follower : model.followers) {
+    if (follower.path.view().size() <= UINT16_MAX) {
+      followers.push_back(&follower);
+    }
+  }
+  appender.writeBE<uint32_t>(folly::to_narrow(followers.size()));
+  for (const auto* follower : followers) {
+    auto path = follower->path.view();
+    appender.writeBE<uint16_t>(folly::to_narrow(path.size()));
+    appender.push(folly::StringPiece{path});
+    appender.writeBE<uint32_t>(follower->sessions);
+  }
+
+  auto buf = queue.move();
+  buf->coalesce();
+  localStore_->put(
+      KeySpace::AccessModelFamily,
+      key.getBytes(),
+      folly::ByteRange{buf->data(), buf->length()});
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "eden/fs/model/Hash.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+class LocalStore;
+
+/**
+ * What a process read after reading a given file, learned over several
+ * sessions. See AccessPrefetcher.
+ */
+struct AccessModel {
+  struct Follower {
+    RelativePath path;
+    // The number of sessions in which this file was read.
+    uint32_t sessions;
+  };
+
+  // The number of sessions learned from.
+  uint32_t sessions{0};
+  // Sorted by decreasing number of sessions.
+  std::vector<Follower> followers;
+
+  /**
+   * Learns from one more session, in which the given files were read after
+   * the trigger. Keeps at most maxFollowers followers, the least frequent
+   * ones being dropped first.
+   */
+  void learn(const std::vector<RelativePath>& readFiles, size_t maxFollowers);
+};
+
+/**
+ * Stores AccessModels in the LocalStore. Models are only hints: an
+ * unreadable one is treated like a missing one.
+ */
+class AccessModelStore {
+ public:
+  explicit AccessModelStore(std::shared_ptr<LocalStore> localStore);
+
+  std::optional<AccessModel> get(const Hash20& key) const;
+
+  void put(const Hash20& key, const AccessModel& model) const;
+
+ private:
+  std::shared_ptr<LocalStore> localStore_;
+};
+
+} // namespace facebook::eden
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/AccessSketch.h"
+
+#include <folly/hash/SpookyHashV2.h>
+#include <folly/lang/Bits.h>
+#include <algorithm>
+
+namespace facebook::eden {
+
+namespace {
+constexpr size_t kMinimumBits = 64;
+} // namespace
+
+AccessSketch::AccessSketch(size_t bitsPerEpoch)
+    : words_{folly::nextPowTwo(std::max(bitsPerEpoch, kMinimumBits)) / 64},
+      mask_{words_ * 64 - 1},
+      bits_{new std::atomic<uint64_t>[kEpochs * words_]} {
+  for (size_t i = 0; i < kEpochs * words_; ++i) {
+    bits_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+std::atomic<uint64_t>* AccessSketch::epochWords(size_t epoch) const noexcept {
+  return &bits_[(epoch % kEpochs) * words_];
+}
+
+void AccessSketch::record(folly::ByteRange key) noexcept {
+  auto bit = folly::hash::SpookyHashV2::Hash64(key.data(), key.size(), 0) &
+      mask_;
+  auto& word = epochWords(current_.load(std::memory_order_relaxed))[bit / 64];
+  uint64_t flag = uint64_t{1} << (bit % 64);
+  // Most accesses are to keys that were already recorded, don't make their
+  // cache line bounce between cores.
+  if ((word.load(std::memory_order_relaxed) & flag) == 0) {
+    word.fetch_or(flag, std::memory_order_relaxed);
+  }
+}
+
+bool AccessSketch::mayHaveBeenAccessed(folly::ByteRange key) const noexcept {
+  auto bit = folly::hash::SpookyHashV2::Hash64(key.data(), key.size(), 0) &
+      mask_;
+  uint64_t flag = uint64_t{1} << (bit % 64);
+  for (size_t epoch = 0; epoch < kEpochs; ++epoch) {
+    if (epochWords(epoch)[bit / 64].load(std::memory_order_relaxed) & flag) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void AccessSketch::startEpoch() noexcept {
+  auto next = current_.load(std::memory_order_relaxed) + 1;
+  auto* words = epochWords(next);
+  for (size_t i = 0; i < words_; ++i) {
+    words[i].store(0, std::memory_order_relaxed);
+  }
+  current_.store(next, std::memory_order_relaxed);
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace facebook::eden {
+
+/**
+ * A bitmap of the keys that have been accessed during the current and the
+ * previous epochs, used by the local store garbage collection to keep the
+ * recently used entries of a key space and evict the others.
+ *
+ * Keys are hashed to a single bit, so a key that was never accessed may be
+ * reported as accessed, but an accessed key is never reported as not
+ * accessed. Collisions thus only make the garbage collection keep more than
+ * it could.
+ *
+ * This class is thread safe.
+ */
+class AccessSketch {
+ public:
+  /**
+   * Each epoch is tracked in a bitmap of bitsPerEpoch bits, rounded up to a
+   * power of two.
+   */
+  explicit AccessSketch(size_t bitsPerEpoch);
+
+  /**
+   * Record an access to the given key during the current epoch.
+   */
+  void record(folly::ByteRange key) noexcept;
+
+  /**
+   * Return whether the key may have been accessed during the current or the
+   * previous epoch.
+   */
+  bool mayHaveBeenAccessed(folly::ByteRange key) const noexcept;
+
+  /**
+   * Start a new epoch, forgetting the accesses recorded before the current
+   * one.
+   */
+  void startEpoch() noexcept;
+
+ private:
+  static constexpr size_t kEpochs = 2;
+
+  std::atomic<uint64_t>* epochWords(size_t epoch) const noexcept;
+
+  size_t words_;
+  size_t mask_;
+  std::unique_ptr<std::atomic<uint64_t>[]> bits_;
+  std::atomic<size_t> current_{0};
+};
+
+} // namespace facebook::eden
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/BackendHealthTracker.h"
+
+#include <folly/logging/xlog.h>
+
+namespace facebook::eden {
+
+bool BackendHealthTracker::allowRemoteFetch(
+    const Options& options,
+    Clock::time_point now) {
+  if (options.failureThreshold == 0) {
+    return true;
+  }
+
+  auto state = state_.wlock();
+  switch (state->state) {
+    case State::Healthy:
+      return true;
+    case State::Degraded:
+    case State::Probing:
+      // A probe whose result never came is retried after another cooldown.
+      if (now - state->since < options.cooldown) {
+        return false;
+      }
+      state->state = State::Probing;
+      state->since = now;
+      return true;
+  }
+  return true;
+}
+
+void BackendHealthTracker::recordFetch(
+    bool succeeded,
+    Clock::duration latency,
+    const Options& options,
+    Clock::time_point now) {
+  if (options.failureThreshold == 0) {
+    *state_.wlock() = TrackerState{};
+    return;
+  }
+
+  bool failed = !succeeded || latency > options.slowThreshold;
+  auto state = state_.wlock();
+  if (!failed) {
+    if (state->state != State::Healthy) {
+      XLOG(INFO) << "backing store recovered, resuming remote fetches";
+    }
+    *state = TrackerState{};
+    return;
+  }
+
+  switch (state->state) {
+    case State::Healthy:
+      if (++state->consecutiveFailures >= options.failureThreshold) {
+        XLOG(WARN) << "backing store degraded after "
+                   << state->consecutiveFailures
+                   << " failed or slow fetches, serving local data only";
+        state->state = State::Degraded;
+        state->since = now;
+      }
+      break;
+    case State::Probing:
+      state->state = State::Degraded;
+      state->since = now;
+      break;
+    case State::Degraded:
+      // Fetches that started before the backend was degraded.
+      break;
+  }
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <chrono>
+#include <cstdint>
+
+namespace facebook::eden {
+
+/**
+ * A circuit breaker for the remote fetches of a BackingStore.
+ *
+ * Once failureThreshold fetches in a row failed or took longer than
+ * slowThreshold, the backend is considered degraded: allowRemoteFetch
+ * returns false, so that the callers serve what is available locally and
+ * fail the rest fast rather than stacking up on a backend that is down.
+ *
+ * After cooldown, a single fetch is let through as a probe. The backend is
+ * healthy again if the probe succeeds, and stays degraded for another
+ * cooldown otherwise.
+ */
+class BackendHealthTracker {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Options {
+    /**
+     * 0 disables the tracker: remote fetches are always allowed.
+     */
+    uint32_t failureThreshold{0};
+    Clock::duration slowThreshold{Clock::duration::max()};
+    Clock::duration cooldown{Clock::duration::zero()};
+  };
+
+  enum class State : uint8_t {
+    Healthy,
+    Degraded,
+    Probing,
+  };
+
+  /**
+   * Whether a fetch that missed the local caches should go to the backend.
+   * While degraded, this returns true once per cooldown, and the fetch that
+   * is let through must record its result.
+   */
+  bool allowRemoteFetch(const Options& options, Clock::time_point now);
+
+  /**
+   * Records the outcome of a batch of remote fetches.
+   */
+  void recordFetch(
+      bool succeeded,
+      Clock::duration latency,
+      const Options& options,
+      Clock::time_point now);
+
+  State getState() const {
+    return state_.rlock()->state;
+  }
+
+ private:
+  struct TrackerState {
+    State state{State::Healthy};
+    uint32_t consecutiveFailures{0};
+    /**
+     * When the backend became degraded, or when the last probe started.
+     */
+    Clock::time_point since;
+  };
+
+  folly::Synchronized<TrackerState> state_;
+};
+
+} // namespace facebook::eden
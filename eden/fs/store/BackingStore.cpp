@@ -0,0 +1,25 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/BackingStore.h"
+
+#include "eden/fs/model/Tree.h"
+
+namespace facebook::eden {
+
+ImmediateFuture<std::vector<std::unique_ptr<Tree>>> BackingStore::getRootTrees(
+    const std::vector<RootId>& rootIds,
+    const ObjectFetchContextPtr& context) {
+  std::vector<ImmediateFuture<std::unique_ptr<Tree>>> futures;
+  futures.reserve(rootIds.size());
+  for (const auto& rootId : rootIds) {
+    futures.push_back(getRootTree(rootId, context));
+  }
+  return collectAllSafe(std::move(futures));
+}
+
+} // namespace facebook::eden
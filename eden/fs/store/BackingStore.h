@@ -10,6 +10,7 @@
 #include <folly/Range.h>
 #include <folly/futures/Future.h>
 #include <memory>
+#include <vector>
 
 #include "eden/fs/model/BlobMetadata.h"
 #include "eden/fs/model/ObjectId.h"
@@ -77,6 +78,19 @@ class BackingStore : public RootIdCodec, public ObjectIdCodec {
       const RootId& rootId,
       const ObjectFetchContextPtr& context) = 0;
 
+  /**
+   * Return the root Trees corresponding to the passed in RootIds, in the same
+   * order, for callers that need several commits at once, like a status
+   * across a stack of commits.
+   *
+   * By default this calls getRootTree for all the RootIds concurrently.
+   * Backing stores that can share the work of resolving the commits override
+   * it.
+   */
+  virtual ImmediateFuture<std::vector<std::unique_ptr<Tree>>> getRootTrees(
+      const std::vector<RootId>& rootIds,
+      const ObjectFetchContextPtr& context);
+
   virtual ImmediateFuture<std::unique_ptr<TreeEntry>> getTreeEntryForObjectId(
       const ObjectId& objectId,
       TreeEntryType treeEntryType,
@@ -87,7 +101,7 @@ class BackingStore : public RootIdCodec, public ObjectIdCodec {
    */
   struct GetTreeResult {
     /** The retrieved tree. */
-    std::unique_ptr<Tree> tree;
+    std::shared_ptr<const Tree> tree;
     /** The fetch origin of the tree. */
     ObjectFetchContext::Origin origin;
   };
@@ -106,7 +120,7 @@ class BackingStore : public RootIdCodec, public ObjectIdCodec {
    */
   struct GetBlobResult {
     /** The retrieved blob. */
-    std::unique_ptr<Blob> blob;
+    std::shared_ptr<const Blob> blob;
     /** The fetch origin of the tree. */
     ObjectFetchContext::Origin origin;
   };
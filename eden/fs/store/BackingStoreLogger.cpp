@@ -84,7 +84,8 @@ void BackingStoreLogger::logImport(
       pid,
       std::move(cmdline),
       std::move(importPathString),
-      std::move(typeString)});
+      std::move(typeString),
+      context.getTraceId()});
 }
 
 } // namespace facebook::eden
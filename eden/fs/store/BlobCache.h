@@ -14,7 +14,7 @@ namespace facebook::eden {
 using BlobInterestHandle = ObjectInterestHandle<Blob>;
 
 /**
- * An in-memory LRU cache for loaded blobs. It is parameterized by both a
+ * An in-memory cache for loaded blobs. It is parameterized by both a
  * maximum cache size and a minimum entry count. The cache tries to evict
  * entries when the total number of loaded blobs exceeds the maximum cache size,
  * except that it always keeps the minimum entry count around.
@@ -23,17 +23,25 @@ using BlobInterestHandle = ObjectInterestHandle<Blob>;
  * frequently-accessed large blobs when they are larger than the maximum cache
  * size.
  *
+ * When shardCount is greater than one, the cache is split into that many
+ * independently locked shards. The evictionPolicy decides which blobs get
+ * evicted. See ObjectCache.
+ *
  * It is safe to use this object from arbitrary threads.
  */
 class BlobCache : public ObjectCache<Blob, ObjectCacheFlavor::InterestHandle> {
  public:
   static std::shared_ptr<BlobCache> create(
       size_t maximumCacheSizeBytes,
-      size_t minimumEntryCount) {
+      size_t minimumEntryCount,
+      size_t shardCount = 1,
+      CacheEvictionPolicy evictionPolicy = CacheEvictionPolicy::LRU) {
     struct BC : BlobCache {
-      BC(size_t x, size_t y) : BlobCache{x, y} {}
+      BC(size_t x, size_t y, size_t z, CacheEvictionPolicy p)
+          : BlobCache{x, y, z, p} {}
     };
-    return std::make_shared<BC>(maximumCacheSizeBytes, minimumEntryCount);
+    return std::make_shared<BC>(
+        maximumCacheSizeBytes, minimumEntryCount, shardCount, evictionPolicy);
   }
   ~BlobCache() = default;
 
@@ -70,10 +78,16 @@ class BlobCache : public ObjectCache<Blob, ObjectCacheFlavor::InterestHandle> {
   }
 
  private:
-  explicit BlobCache(size_t maximumCacheSizeBytes, size_t minimumEntryCount)
+  explicit BlobCache(
+      size_t maximumCacheSizeBytes,
+      size_t minimumEntryCount,
+      size_t shardCount,
+      CacheEvictionPolicy evictionPolicy)
       : ObjectCache<Blob, ObjectCacheFlavor::InterestHandle>{
             maximumCacheSizeBytes,
-            minimumEntryCount} {}
+            minimumEntryCount,
+            shardCount,
+            evictionPolicy} {}
 };
 
 } // namespace facebook::eden
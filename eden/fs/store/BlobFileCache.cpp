@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/store/BlobFileCache.h"
+
+#include <folly/Conv.h>
+#include <folly/Exception.h>
+#include <folly/File.h>
+#include <folly/FileUtil.h>
+#include <folly/logging/xlog.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+#include "eden/fs/utils/FileUtils.h"
+#include "eden/fs/utils/StatTimes.h"
+
+namespace facebook::eden {
+
+namespace {
+constexpr folly::StringPiece kMarkerPrefix{"file "};
+
+void unmapContents(void* buf, void* userData) {
+  ::munmap(buf, reinterpret_cast<size_t>(userData));
+}
+} // namespace
+
+std::unique_ptr<BlobFileCache> BlobFileCache::open(
+    AbsolutePathPiece path,
+    uint64_t maxSize) {
+  ensureDirectoryExists(path);
+  std::unique_ptr<BlobFileCache> cache{
+      new BlobFileCache{path.copy(), maxSize}};
+  cache->load();
+  return cache;
+}
+
+BlobFileCache::BlobFileCache(AbsolutePath path, uint64_t maxSize)
+    : path_{std::move(path)}, maxSize_{maxSize} {}
+
+void BlobFileCache::load() {
+  std::vector<std::tuple<timespec, ObjectId, uint64_t>> files;
+  auto shards = getAllDirectoryEntryNames(path_).value();
+  for (const auto& shard : shards) {
+    auto shardPath = path_ + shard;
+    auto names = getAllDirectoryEntryNames(shardPath);
+    if (names.hasException()) {
+      continue;
+    }
+    for (const auto& name : names.value()) {
+      auto filePath = shardPath + name;
+      struct stat st;
+      if (::stat(filePath.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        continue;
+      }
+      try {
+        auto id = ObjectId::fromHex(name.view());
+        if (pathFor(id) == filePath) {
+          files.emplace_back(stMtime(st), std::move(id), st.st_size);
+          continue;
+        }
+      } catch (const std::exception&) {
+      }
+      // The temporary file of a put() interrupted by a crash.
+      XLOG(DBG3) << "Removing stray file " << filePath;
+      ::unlink(filePath.c_str());
+    }
+  }
+
+  std::sort(files.begin(), files.end(), [](const auto& a, const auto& b) {
+    const auto& ta = std::get<0>(a);
+    const auto& tb = std::get<0>(b);
+    return std::tie(ta.tv_sec, ta.tv_nsec) < std::tie(tb.tv_sec, tb.tv_nsec);
+  });
+
+  auto state = state_.lock();
+  for (auto& [mtime, id, size] : files) {
+    state->lru.push_back(Entry{id, size});
+    state->entries.emplace(std::move(id), std::prev(state->lru.end()));
+    state->totalSize += size;
+  }
+  XLOG(DBG2) << "Opened blob file cache " << path_ << " holding "
+             << state->entries.size() << " blobs, " << state->totalSize
+             << " bytes";
+  evict(*state);
+}
+
+AbsolutePath BlobFileCache::pathFor(const ObjectId& id) const {
+  auto hex = id.asHexString();
+  // Spread the files over 256 directories, to keep them small.
+  auto shard = hex.size() >= 2 ? hex.substr(0, 2) : std::string{"00"};
+  return path_ + PathComponentPiece{shard} + PathComponentPiece{hex};
+}
+
+std::optional<folly::IOBuf> BlobFileCache::get(
+    const ObjectId& id,
+    uint64_t size) {
+  auto path = pathFor(id);
+  int fd = folly::openNoInt(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    if (errno != ENOENT) {
+      XLOG(WARN) << "Unable to open cached blob " << path << ": "
+                 << folly::errnoStr(errno);
+    }
+    auto state = state_.lock();
+    auto it = state->entries.find(id);
+    if (it != state->entries.end()) {
+      state->totalSize -= it->second->size;
+      state->lru.erase(it->second);
+      state->entries.erase(it);
+    }
+    return std::nullopt;
+  }
+  folly::File file{fd, /*ownsFd=*/true};
+
+  struct stat st;
+  folly::checkUnixError(::fstat(file.fd(), &st), "fstat ", path);
+  if (static_cast<uint64_t>(st.st_size) != size || size == 0) {
+    XLOG(WARN) << "Cached blob " << path << " holds " << st.st_size
+               << " bytes rather than " << size;
+    return std::nullopt;
+  }
+
+  void* addr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, file.fd(), 0);
+  if (addr == MAP_FAILED) {
+    folly::throwSystemError("mmap ", path);
+  }
+
+  {
+    auto state = state_.lock();
+    auto it = state->entries.find(id);
+    if (it != state->entries.end()) {
+      state->lru.splice(state->lru.end(), state->lru, it->second);
+    }
+  }
+
+  return folly::IOBuf{
+      folly::IOBuf::TAKE_OWNERSHIP,
+      addr,
+      size,
+      unmapContents,
+      reinterpret_cast<void*>(static_cast<size_t>(size))};
+}
+
+void BlobFileCache::put(const ObjectId& id, const folly::IOBuf& contents) {
+  auto path = pathFor(id);
+  ensureDirectoryExists(path.dirname());
+
+  // Write the contents to a temporary file, sync it, and rename it into
+  // place, so that the file is either missing or complete after a crash.
+  auto iov = contents.getIov();
+  if (auto err = folly::writeFileAtomicNoThrow(
+          path.view(), iov.data(), static_cast<int>(iov.size()))) {
+    folly::throwSystemErrorExplicit(err, "unable to write ", path);
+  }
+
+  auto size = contents.computeChainDataLength();
+  auto state = state_.lock();
+  auto it = state->entries.find(id);
+  if (it != state->entries.end()) {
+    state->totalSize -= it->second->size;
+    it->second->size = size;
+    state->lru.splice(state->lru.end(), state->lru, it->second);
+  } else {
+    state->lru.push_back(Entry{id, size});
+    state->entries.emplace(id, std::prev(state->lru.end()));
+  }
+  state->totalSize += size;
+  evict(*state);
+}
+
+void BlobFileCache::evict(State& state) {
+  while (state.totalSize > maxSize_ && !state.lru.empty()) {
+    auto& entry = state.lru.front();
+    auto path = pathFor(entry.id);
+    if (::unlink(path.c_str()) != 0 && errno != ENOENT) {
+      XLOG(WARN) << "Unable to evict cached blob " << path << ": "
+                 << folly::errnoStr(errno);
+    }
+    state.totalSize -= entry.size;
+    state.entries.erase(entry.id);
+    state.lru.pop_front();
+  }
+}
+
+void BlobFileCache::clear() {
+  auto state = state_.lock();
+  for (const auto& entry : state->lru) {
+    ::unlink(pathFor(entry.id).c_str());
+  }
+  state->lru.clear();
+  state->entries.clear();
+  state->totalSize = 0;
+}
+
+uint64_t BlobFileCache::getTotalSize() const {
+  return state_.lock()->totalSize;
+}
+
+std::string BlobFileCache::makeMarker(uint64_t size) {
+  auto marker = folly::to<std::string>(kMarkerPrefix, size);
+  marker.push_back('\0');
+  return marker;
+}
+
+std::optional<uint64_t> BlobFileCache::parseMarker(folly::ByteRange value) {
+  folly::StringPiece str{value};
+  if (!str.startsWith(kMarkerPrefix) || str.back() != '\0') {
+    return std::nullopt;
+  }
+  str.advance(kMarkerPrefix.size());
+  str.pop_back();
+  auto size = folly::tryTo<uint64_t>(str);
+  if (!size.hasValue()) {
+    return std::nullopt;
+  }
+  return size.value();
+}
+
+} // namespace facebook::eden
+
+#endif
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#ifndef _WIN32
+
+#include <folly/Range.h>
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <folly/io/IOBuf.h>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include "eden/fs/model/ObjectId.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/**
+ * A directory holding the contents of large blobs, one file per blob named
+ * after its ObjectId, next to the LocalStore.
+ *
+ * The LocalStore keeps a small BlobFileCache marker in the BlobFamily entry
+ * of such a blob instead of its contents, so large blobs never go through
+ * RocksDB. Reading a cached blob maps its file: the contents are served from
+ * the kernel page cache, and only the pages that are read are faulted in.
+ *
+ * Files are written to a temporary name, synced, and renamed into place, so
+ * a file under a blob's name always holds its full contents. When the files
+ * exceed the maximum size, the least recently used ones are removed. Files
+ * are only ever unlinked, never truncated, so mappings of evicted files stay
+ * valid.
+ *
+ * The recency of the files is tracked in memory; when the cache is opened,
+ * the files are ordered by their modification time.
+ *
+ * This class is thread-safe.
+ */
+class BlobFileCache {
+ public:
+  /**
+   * Open the cache stored in the directory at path, creating it if needed,
+   * and evict files until it holds at most maxSize bytes.
+   */
+  static std::unique_ptr<BlobFileCache> open(
+      AbsolutePathPiece path,
+      uint64_t maxSize);
+
+  BlobFileCache(const BlobFileCache&) = delete;
+  BlobFileCache& operator=(const BlobFileCache&) = delete;
+
+  /**
+   * The contents of the blob, mapped from its file, or std::nullopt if the
+   * blob was evicted or its file does not hold size bytes.
+   */
+  std::optional<folly::IOBuf> get(const ObjectId& id, uint64_t size);
+
+  /**
+   * Store the contents of the blob, then evict the least recently used files
+   * if the cache is over its maximum size. Throws on I/O errors.
+   */
+  void put(const ObjectId& id, const folly::IOBuf& contents);
+
+  /**
+   * Remove every file from the cache.
+   */
+  void clear();
+
+  /**
+   * Total size of the cached files, in bytes.
+   */
+  uint64_t getTotalSize() const;
+
+  /**
+   * The BlobFamily value of a blob stored in the cache: "file <size>\0".
+   */
+  static std::string makeMarker(uint64_t size);
+
+  /**
+   * The size recorded by a marker, or std::nullopt if the BlobFamily value
+   * is not one.
+   */
+  static std::optional<uint64_t> parseMarker(folly::ByteRange value);
+
+ private:
+  struct Entry {
+    ObjectId id;
+    uint64_t size;
+  };
+
+  struct State {
+    uint64_t totalSize{0};
+    // Least recently used first.
+    std::list<Entry> lru;
+    folly::F14FastMap<ObjectId, std::list<Entry>::iterator> entries;
+  };
+
+  BlobFileCache(AbsolutePath path, uint64_t maxSize);
+
+  /**
+   * Index the files found in the directory, oldest first.
+   */
+  void load();
+
+  AbsolutePath pathFor(const ObjectId& id) const;
+
+  /**
+   * Remove the least recently used files until the cache holds at most
+   * maxSize_ bytes.
+   */
+  void evict(State& state);
+
+  const AbsolutePath path_;
+  const uint64_t maxSize_;
+  folly::Synchronized<State, std::mutex> state_;
+};
+
+} // namespace facebook::eden
+
+#endif
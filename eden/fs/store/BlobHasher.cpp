@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/BlobHasher.h"
+
+#include "eden/fs/utils/UnboundedQueueExecutor.h"
+
+namespace facebook::eden {
+
+BlobHasher::BlobHasher(size_t threadCount)
+    : executor_{std::make_unique<UnboundedQueueExecutor>(
+          threadCount,
+          "BlobHasher")} {}
+
+BlobHasher::~BlobHasher() = default;
+
+BlobMetadata BlobHasher::computeMetadata(const Blob& blob) {
+  return BlobMetadata{Hash20::sha1(blob.getContents()), blob.getSize()};
+}
+
+folly::SemiFuture<BlobMetadata> BlobHasher::hash(BlobPtr blob) {
+  return folly::via(executor_.get(), [blob = std::move(blob)] {
+           return computeMetadata(*blob);
+         })
+      .semi();
+}
+
+void BlobHasher::hashInBackground(
+    BlobPtr blob,
+    folly::Function<void(const BlobMetadata&)> onMetadata) {
+  executor_->add(
+      [blob = std::move(blob), onMetadata = std::move(onMetadata)]() mutable {
+        onMetadata(computeMetadata(*blob));
+      });
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/futures/Future.h>
+#include <memory>
+
+#include "eden/fs/model/Blob.h"
+#include "eden/fs/model/BlobMetadata.h"
+
+namespace facebook::eden {
+
+class UnboundedQueueExecutor;
+
+/**
+ * Computes the metadata of blobs on a dedicated pool of threads.
+ *
+ * Blobs fetched from the backing store are otherwise hashed on the thread
+ * that imported them, one after the other. When a request asks for the SHA-1
+ * of thousands of files at once, handing the hashing over to this pool lets
+ * it use several cores while the import threads keep fetching.
+ */
+class BlobHasher {
+ public:
+  explicit BlobHasher(size_t threadCount);
+  ~BlobHasher();
+
+  BlobHasher(const BlobHasher&) = delete;
+  BlobHasher& operator=(const BlobHasher&) = delete;
+
+  /**
+   * Compute the metadata of a blob on the calling thread.
+   */
+  static BlobMetadata computeMetadata(const Blob& blob);
+
+  /**
+   * Compute the metadata of a blob on one of the hashing threads.
+   */
+  folly::SemiFuture<BlobMetadata> hash(BlobPtr blob);
+
+  /**
+   * Like hash(), but call onMetadata on the hashing thread instead of
+   * returning a future, for callers that do not wait for the result.
+   */
+  void hashInBackground(
+      BlobPtr blob,
+      folly::Function<void(const BlobMetadata&)> onMetadata);
+
+ private:
+  std::unique_ptr<UnboundedQueueExecutor> executor_;
+};
+
+} // namespace facebook::eden
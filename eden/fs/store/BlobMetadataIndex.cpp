@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/store/BlobMetadataIndex.h"
+
+#include <folly/hash/SpookyHashV2.h>
+#include <folly/lang/Bits.h>
+#include <folly/logging/xlog.h>
+#include <cstddef>
+#include <cstring>
+
+namespace facebook::eden {
+
+std::unique_ptr<BlobMetadataIndex> BlobMetadataIndex::open(
+    folly::StringPiece path,
+    size_t capacity) {
+  capacity = folly::nextPowTwo(std::max<size_t>(capacity, kMaxProbes));
+
+  std::optional<MappedDiskVector<Slot>> slots;
+  try {
+    slots.emplace(MappedDiskVector<Slot>::open(path));
+    if (slots->size() != capacity) {
+      if (slots->size() != 0) {
+        XLOG(INFO) << "Resizing blob metadata index " << path << " from "
+                   << slots->size() << " to " << capacity << " entries";
+      }
+      // Release the lock on the file before truncating it.
+      slots.reset();
+    }
+  } catch (const std::exception& ex) {
+    XLOG(WARN) << "Recreating unreadable blob metadata index " << path << ": "
+               << folly::exceptionStr(ex);
+    slots.reset();
+  }
+
+  if (!slots) {
+    slots.emplace(MappedDiskVector<Slot>::createOrOverwrite(path));
+    for (size_t i = 0; i < capacity; ++i) {
+      slots->emplace_back();
+    }
+  }
+
+  return std::unique_ptr<BlobMetadataIndex>{
+      new BlobMetadataIndex{std::move(*slots), capacity}};
+}
+
+BlobMetadataIndex::BlobMetadataIndex(
+    MappedDiskVector<Slot> slots,
+    size_t capacity)
+    : capacity_{capacity}, slots_{std::in_place, std::move(slots)} {}
+
+uint64_t BlobMetadataIndex::hashKey(folly::ByteRange key) noexcept {
+  return folly::hash::SpookyHashV2::Hash64(key.data(), key.size(), 0);
+}
+
+uint32_t BlobMetadataIndex::computeChecksum(const Slot& slot) noexcept {
+  constexpr size_t begin = offsetof(Slot, keySize);
+  return folly::hash::SpookyHashV2::Hash32(
+      reinterpret_cast<const char*>(&slot) + begin,
+      sizeof(Slot) - begin,
+      static_cast<uint32_t>(slot.keyHash));
+}
+
+std::optional<BlobMetadata> BlobMetadataIndex::get(const ObjectId& id) const {
+  auto key = id.getBytes();
+  if (key.empty() || key.size() > kMaxKeySize) {
+    return std::nullopt;
+  }
+  auto keyHash = hashKey(key);
+
+  auto slots = slots_.rlock();
+  for (size_t i = 0; i < kMaxProbes; ++i) {
+    const auto& slot = (*slots)[(keyHash + i) & (capacity_ - 1)];
+    if (slot.keySize == 0) {
+      return std::nullopt;
+    }
+    if (slot.keyHash != keyHash || slot.keySize != key.size() ||
+        std::memcmp(slot.key, key.data(), key.size()) != 0) {
+      continue;
+    }
+    if (slot.checksum != computeChecksum(slot)) {
+      return std::nullopt;
+    }
+    return BlobMetadata{
+        Hash20{folly::ByteRange{slot.sha1, Hash20::RAW_SIZE}}, slot.size};
+  }
+  return std::nullopt;
+}
+
+void BlobMetadataIndex::put(const ObjectId& id, const BlobMetadata& metadata) {
+  auto key = id.getBytes();
+  if (key.empty() || key.size() > kMaxKeySize) {
+    return;
+  }
+
+  Slot entry{};
+  entry.keyHash = hashKey(key);
+  entry.keySize = static_cast<uint8_t>(key.size());
+  std::memcpy(entry.key, key.data(), key.size());
+  auto sha1 = metadata.sha1.getBytes();
+  std::memcpy(entry.sha1, sha1.data(), sha1.size());
+  entry.size = metadata.size;
+  entry.checksum = computeChecksum(entry);
+
+  auto slots = slots_.wlock();
+  // Reuse the slot of this key or the first empty one, and otherwise evict
+  // the entry in the first slot.
+  size_t index = entry.keyHash & (capacity_ - 1);
+  for (size_t i = 0; i < kMaxProbes; ++i) {
+    auto probe = (entry.keyHash + i) & (capacity_ - 1);
+    const auto& slot = (*slots)[probe];
+    if (slot.keySize == 0 ||
+        (slot.keyHash == entry.keyHash && slot.keySize == entry.keySize &&
+         std::memcmp(slot.key, entry.key, entry.keySize) == 0)) {
+      index = probe;
+      break;
+    }
+  }
+  (*slots)[index] = entry;
+}
+
+void BlobMetadataIndex::clear() {
+  auto slots = slots_.wlock();
+  for (size_t i = 0; i < capacity_; ++i) {
+    (*slots)[i] = Slot{};
+  }
+}
+
+} // namespace facebook::eden
+
+#endif
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#ifndef _WIN32
+
+#include <folly/Range.h>
+#include <folly/SharedMutex.h>
+#include <folly/Synchronized.h>
+#include <memory>
+#include <optional>
+
+#include "eden/fs/model/BlobMetadata.h"
+#include "eden/fs/model/ObjectId.h"
+#include "eden/fs/utils/MappedDiskVector.h"
+
+namespace facebook::eden {
+
+/**
+ * A persistent, fixed-capacity hash table from ObjectId to BlobMetadata,
+ * stored in a memory-mapped file next to the LocalStore.
+ *
+ * A lookup hashes the ObjectId and probes a few adjacent slots of the mapping,
+ * which is much cheaper than a RocksDB point lookup followed by the decoding
+ * of the SerializedBlobMetadata. Since the file survives restarts, warm stat
+ * calls are served without touching the LocalStore at all.
+ *
+ * Blob metadata never changes for a given ObjectId, so the index behaves like
+ * a cache: when all the slots that an ObjectId may occupy are used, inserting
+ * it overwrites an older entry. Entries are checksummed so that a slot torn by
+ * a crash reads as missing rather than as wrong metadata. ObjectIds longer
+ * than kMaxKeySize bytes are not indexed.
+ *
+ * This class is thread-safe.
+ */
+class BlobMetadataIndex {
+ public:
+  static constexpr size_t kMaxKeySize = 40;
+
+  /**
+   * Open the index stored at path, or create it if it does not exist, is not
+   * readable, or was created with a different capacity. The capacity is
+   * rounded up to a power of two.
+   */
+  static std::unique_ptr<BlobMetadataIndex> open(
+      folly::StringPiece path,
+      size_t capacity);
+
+  BlobMetadataIndex(const BlobMetadataIndex&) = delete;
+  BlobMetadataIndex& operator=(const BlobMetadataIndex&) = delete;
+
+  /**
+   * Returns std::nullopt if the ObjectId is not in the index.
+   */
+  std::optional<BlobMetadata> get(const ObjectId& id) const;
+
+  void put(const ObjectId& id, const BlobMetadata& metadata);
+
+  /**
+   * Remove every entry from the index.
+   */
+  void clear();
+
+  size_t capacity() const noexcept {
+    return capacity_;
+  }
+
+ private:
+  // This is the on-disk format of the index. Do not change the order, set,
+  // or types of fields without bumping VERSION.
+  struct Slot {
+    static constexpr uint32_t VERSION = 1;
+
+    /// Hash of the key, used to pick the slot and to skip over other keys.
+    uint64_t keyHash;
+    /// Checksum of all the fields that follow it.
+    uint32_t checksum;
+    /// 0 for an empty slot.
+    uint8_t keySize;
+    uint8_t padding1[3];
+    uint8_t key[kMaxKeySize];
+    uint8_t sha1[Hash20::RAW_SIZE];
+    uint8_t padding2[4];
+    uint64_t size;
+  };
+  static_assert(88 == sizeof(Slot), "changing the size invalidates the index");
+
+  /**
+   * Maximum number of slots examined by lookups and insertions. Lookups stop
+   * at the first empty slot.
+   */
+  static constexpr size_t kMaxProbes = 8;
+
+  BlobMetadataIndex(MappedDiskVector<Slot> slots, size_t capacity);
+
+  static uint64_t hashKey(folly::ByteRange key) noexcept;
+  static uint32_t computeChecksum(const Slot& slot) noexcept;
+
+  const size_t capacity_;
+  folly::Synchronized<MappedDiskVector<Slot>, folly::SharedMutex> slots_;
+};
+
+} // namespace facebook::eden
+
+#endif
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/CacheSnapshot.h"
+
+#include <fmt/format.h>
+#include <folly/Utility.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBufQueue.h>
+#include <folly/logging/xlog.h>
+#include <algorithm>
+
+#include "eden/fs/model/Blob.h"
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/BlobCache.h"
+#include "eden/fs/store/LocalStore.h"
+#include "eden/fs/store/TreeCache.h"
+#include "eden/fs/utils/FileUtils.h"
+
+namespace facebook::eden {
+
+namespace {
+/**
+ * Snapshots are stored as:
+ * - version (1 byte)
+ * - number of trees (4 bytes, big endian)
+ * - number of blobs (4 bytes, big endian)
+ * - for each tree, then each blob: id length (1 byte), then id
+ */
+constexpr uint8_t kFormatVersion = 1;
+
+void writeIds(
+    folly::io::QueueAppender& appender,
+    const std::vector<ObjectId>& ids) {
+  for (const auto& id : ids) {
+    auto bytes = id.getBytes();
+    appender.write<uint8_t>(folly::to_narrow(bytes.size()));
+    appender.push(bytes);
+  }
+}
+
+std::vector<ObjectId> readIds(folly::io::Cursor& cursor, uint32_t count) {
+  std::vector<ObjectId> ids;
+  ids.reserve(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    auto bytes = cursor.readFixedString(cursor.read<uint8_t>());
+    ids.emplace_back(folly::ByteRange{folly::StringPiece{bytes}});
+  }
+  return ids;
+}
+
+// Ids longer than this can't be snapshotted. No backing store uses them.
+constexpr size_t kMaxIdSize = UINT8_MAX;
+
+std::vector<ObjectId> withoutLongIds(std::vector<ObjectId> ids) {
+  ids.erase(
+      std::remove_if(
+          ids.begin(),
+          ids.end(),
+          [](const ObjectId& id) { return id.size() > kMaxIdSize; }),
+      ids.end());
+  return ids;
+}
+} // namespace
+
+CacheSnapshot CacheSnapshot::capture(
+    const TreeCache& treeCache,
+    const BlobCache& blobCache,
+    size_t maxEntries) {
+  CacheSnapshot snapshot;
+  snapshot.trees = withoutLongIds(treeCache.getHotObjectIds(maxEntries));
+  snapshot.blobs = withoutLongIds(blobCache.getHotObjectIds(maxEntries));
+  return snapshot;
+}
+
+folly::IOBuf CacheSnapshot::serialize() const {
+  folly::IOBufQueue queue{folly::IOBufQueue::cacheChainLength()};
+  folly::io::QueueAppender appender{&queue, 4096};
+  appender.write<uint8_t>(kFormatVersion);
+  appender.writeBE<uint32_t>(folly::to_narrow(trees.size()));
+  appender.writeBE<uint32_t>(folly::to_narrow(blobs.size()));
+  writeIds(appender, trees);
+  writeIds(appender, blobs);
+  return std::move(*queue.move());
+}
+
+CacheSnapshot CacheSnapshot::deserialize(folly::ByteRange data) {
+  folly::IOBuf buf{folly::IOBuf::WRAP_BUFFER, data};
+  folly::io::Cursor cursor{&buf};
+  auto version = cursor.read<uint8_t>();
+  if (version != kFormatVersion) {
+    throw std::invalid_argument(
+        fmt::format("unknown cache snapshot format version {}", version));
+  }
+
+  auto treeCount = cursor.readBE<uint32_t>();
+  auto blobCount = cursor.readBE<uint32_t>();
+  CacheSnapshot snapshot;
+  snapshot.trees = readIds(cursor, treeCount);
+  snapshot.blobs = readIds(cursor, blobCount);
+  return snapshot;
+}
+
+void CacheSnapshot::save(AbsolutePathPiece path) const {
+  auto buf = serialize();
+  buf.coalesce();
+  writeFileAtomic(path, folly::ByteRange{buf.data(), buf.length()}).value();
+}
+
+std::optional<CacheSnapshot> CacheSnapshot::load(AbsolutePathPiece path) {
+  auto contents = readFile(path);
+  if (contents.hasException()) {
+    auto* error = contents.tryGetExceptionObject<std::system_error>();
+    if (!error || error->code() != std::errc::no_such_file_or_directory) {
+      XLOG(WARN) << "Failed to read the cache snapshot " << path << ": "
+                 << contents.exception().what();
+    }
+    return std::nullopt;
+  }
+
+  try {
+    return deserialize(folly::StringPiece{contents.value()});
+  } catch (const std::exception& ex) {
+    XLOG(WARN) << "Ignoring unreadable cache snapshot " << path << ": "
+               << ex.what();
+    return std::nullopt;
+  }
+}
+
+size_t CacheSnapshot::warm(
+    LocalStore& localStore,
+    TreeCache& treeCache,
+    BlobCache& blobCache) const {
+  size_t loaded = 0;
+  for (const auto& id : trees) {
+    try {
+      if (auto tree = localStore.getTree(id).get()) {
+        treeCache.insert(std::move(tree));
+        ++loaded;
+      }
+    } catch (const std::exception& ex) {
+      XLOG(DBG3) << "Not reloading tree " << id << ": " << ex.what();
+    }
+  }
+  for (const auto& id : blobs) {
+    try {
+      if (auto blob = localStore.getBlob(id).get()) {
+        blobCache.insert(std::move(blob));
+        ++loaded;
+      }
+    } catch (const std::exception& ex) {
+      XLOG(DBG3) << "Not reloading blob " << id << ": " << ex.what();
+    }
+  }
+  return loaded;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <folly/io/IOBuf.h>
+#include <optional>
+#include <vector>
+
+#include "eden/fs/model/ObjectId.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+class BlobCache;
+class LocalStore;
+class TreeCache;
+
+/**
+ * The ids of the hottest objects of the in-memory caches, saved when EdenFS
+ * shuts down or hands its mounts over to a new process, so that the next
+ * process starts with warm caches.
+ *
+ * Only the ids are saved: the objects are reloaded from the LocalStore, and
+ * the ones that aren't in it anymore are skipped.
+ */
+struct CacheSnapshot {
+  // Hottest first.
+  std::vector<ObjectId> trees;
+  std::vector<ObjectId> blobs;
+
+  /**
+   * Takes up to maxEntries of the hottest trees, and as many blobs.
+   */
+  static CacheSnapshot capture(
+      const TreeCache& treeCache,
+      const BlobCache& blobCache,
+      size_t maxEntries);
+
+  folly::IOBuf serialize() const;
+
+  /**
+   * Throws if the data isn't a snapshot written by a compatible version.
+   */
+  static CacheSnapshot deserialize(folly::ByteRange data);
+
+  /**
+   * Atomically replaces the snapshot at path. Throws on error.
+   */
+  void save(AbsolutePathPiece path) const;
+
+  /**
+   * Returns std::nullopt if there is no readable snapshot at path.
+   */
+  static std::optional<CacheSnapshot> load(AbsolutePathPiece path);
+
+  /**
+   * Synchronously reloads the snapshotted objects from the LocalStore into
+   * the caches, trees first, hottest first. Never fetches from the backing
+   * store. Returns the number of objects reloaded.
+   */
+  size_t warm(
+      LocalStore& localStore,
+      TreeCache& treeCache,
+      BlobCache& blobCache) const;
+};
+
+} // namespace facebook::eden
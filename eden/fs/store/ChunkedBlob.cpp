@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/ChunkedBlob.h"
+
+#include <folly/Conv.h>
+#include <stdexcept>
+
+#include "eden/fs/model/Blob.h"
+#include "eden/fs/store/FastCdcChunker.h"
+
+namespace facebook::eden {
+
+namespace {
+constexpr folly::StringPiece kManifestPrefix{"chunked "};
+} // namespace
+
+ChunkedBlob chunkBlob(const Blob& blob, const FastCdcChunker& chunker) {
+  // Only copies the contents if they are chained.
+  auto contents = blob.getContents().cloneCoalescedAsValue();
+  folly::ByteRange data{contents.data(), contents.length()};
+
+  ChunkedBlob result;
+  result.manifest = folly::to<std::string>(kManifestPrefix, data.size());
+  result.manifest.push_back('\0');
+  size_t offset = 0;
+  for (auto length : chunker.chunkLengths(data)) {
+    auto chunk = contents.cloneOneAsValue();
+    chunk.trimStart(offset);
+    chunk.trimEnd(data.size() - offset - length);
+    auto key = Hash20::sha1(folly::ByteRange{chunk.data(), chunk.length()});
+    result.manifest.append(
+        reinterpret_cast<const char*>(key.getBytes().data()), Hash20::RAW_SIZE);
+    result.chunks.push_back(ChunkedBlob::Chunk{key, std::move(chunk)});
+    offset += length;
+  }
+  return result;
+}
+
+bool isChunkedBlobManifest(folly::ByteRange value) {
+  return folly::StringPiece{value}.startsWith(kManifestPrefix);
+}
+
+ChunkedBlobManifest parseChunkedBlobManifest(folly::ByteRange value) {
+  folly::StringPiece rest{value};
+  if (!rest.removePrefix(kManifestPrefix)) {
+    throw std::invalid_argument("not a chunked blob manifest");
+  }
+  auto end = rest.find('\0');
+  if (end == folly::StringPiece::npos) {
+    throw std::invalid_argument("unterminated chunked blob manifest header");
+  }
+  ChunkedBlobManifest manifest;
+  manifest.size = folly::to<uint64_t>(rest.subpiece(0, end));
+  rest.advance(end + 1);
+  if (rest.size() % Hash20::RAW_SIZE != 0) {
+    throw std::invalid_argument("truncated chunked blob manifest");
+  }
+  manifest.chunkKeys.reserve(rest.size() / Hash20::RAW_SIZE);
+  for (; !rest.empty(); rest.advance(Hash20::RAW_SIZE)) {
+    manifest.chunkKeys.emplace_back(
+        folly::ByteRange{rest.subpiece(0, Hash20::RAW_SIZE)});
+  }
+  return manifest;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <folly/io/IOBuf.h>
+#include <string>
+#include <vector>
+
+#include "eden/fs/model/Hash.h"
+
+namespace facebook::eden {
+
+class Blob;
+class FastCdcChunker;
+
+/**
+ * The local store format of a large blob: its contents are split into
+ * content-defined chunks, each stored in the BlobChunkFamily key space under
+ * the SHA-1 of its contents, and the BlobFamily entry of the blob is a
+ * manifest listing the chunks. Blobs that share chunks, like versions of a
+ * file that differ by a few bytes, thus share their storage.
+ *
+ * A manifest is "chunked <size>\0" followed by the 20-byte keys of the
+ * chunks, in order. Whole blobs start with "blob " instead.
+ */
+struct ChunkedBlob {
+  struct Chunk {
+    Hash20 key;
+    // Shares the buffer of the blob's contents.
+    folly::IOBuf contents;
+  };
+
+  std::string manifest;
+  std::vector<Chunk> chunks;
+};
+
+ChunkedBlob chunkBlob(const Blob& blob, const FastCdcChunker& chunker);
+
+struct ChunkedBlobManifest {
+  uint64_t size;
+  std::vector<Hash20> chunkKeys;
+};
+
+/**
+ * Whether the BlobFamily value is a chunked blob manifest.
+ */
+bool isChunkedBlobManifest(folly::ByteRange value);
+
+/**
+ * Throws std::invalid_argument if the manifest is malformed.
+ */
+ChunkedBlobManifest parseChunkedBlobManifest(folly::ByteRange value);
+
+} // namespace facebook::eden
@@ -10,6 +10,7 @@
 #include <folly/Portability.h>
 #include <folly/Synchronized.h>
 #include <folly/logging/xlog.h>
+#include <atomic>
 #include <memory>
 #include <vector>
 
@@ -39,14 +40,39 @@ namespace facebook::eden {
  */
 namespace {
 
+/**
+ * Starts the diff of a subtree, given its path.
+ */
+using SubtreeDiff = folly::Function<ImmediateFuture<Unit>(RelativePathPiece)>;
+
 struct ChildFutures {
   void add(RelativePath&& path, ImmediateFuture<Unit>&& future) {
     paths.emplace_back(std::move(path));
     futures.emplace_back(std::move(future));
   }
 
+  /**
+   * Subtree diffs are only started by waitOnResults(), which bounds how many
+   * of them run concurrently.
+   */
+  void addSubtree(RelativePath&& path, SubtreeDiff&& diff) {
+    subtrees.emplace_back(std::move(path), std::move(diff));
+  }
+
   vector<RelativePath> paths;
   vector<ImmediateFuture<Unit>> futures;
+  vector<std::pair<RelativePath, SubtreeDiff>> subtrees;
+};
+
+/**
+ * The subtree diffs of a directory that are started as others complete.
+ */
+struct SubtreeQueue {
+  explicit SubtreeQueue(vector<std::pair<RelativePath, SubtreeDiff>> subtrees)
+      : subtrees{std::move(subtrees)} {}
+
+  vector<std::pair<RelativePath, SubtreeDiff>> subtrees;
+  std::atomic<size_t> next{0};
 };
 
 static constexpr PathComponentPiece kIgnoreFilename{".gitignore"};
@@ -68,10 +94,11 @@ void processRemovedSide(
   if (!scmEntry.second.isTree()) {
     return;
   }
-  auto entryPath = currentPath + scmEntry.first;
-  auto childFuture =
-      diffRemovedTree(context, entryPath, scmEntry.second.getHash());
-  childFutures.add(std::move(entryPath), std::move(childFuture));
+  childFutures.addSubtree(
+      currentPath + scmEntry.first,
+      [context, hash = scmEntry.second.getHash()](RelativePathPiece path) {
+        return diffRemovedTree(context, path, hash);
+      });
 }
 
 /**
@@ -113,9 +140,12 @@ void processAddedSide(
 
   if (wdEntry.second.isTree()) {
     if (!entryIgnored || context->listIgnored) {
-      auto childFuture = diffAddedTree(
-          context, entryPath, wdEntry.second.getHash(), ignore, entryIgnored);
-      childFutures.add(std::move(entryPath), std::move(childFuture));
+      childFutures.addSubtree(
+          std::move(entryPath),
+          [context, hash = wdEntry.second.getHash(), ignore, entryIgnored](
+              RelativePathPiece path) {
+            return diffAddedTree(context, path, hash, ignore, entryIgnored);
+          });
     }
   }
 }
@@ -159,19 +189,21 @@ void processBothPresent(
     if (isTreeWD) {
       // tree-to-tree diff
       XDCHECK_EQ(scmEntry.second.getType(), wdEntry.second.getType());
-      if (context->store->areObjectsKnownIdentical(
+      if (context->store->areTreesKnownEquivalent(
               scmEntry.second.getHash(), wdEntry.second.getHash())) {
         return;
       }
       context->callback->modifiedPath(entryPath, wdEntry.second.getDtype());
-      auto childFuture = diffTrees(
-          context,
-          entryPath,
-          scmEntry.second.getHash(),
-          wdEntry.second.getHash(),
-          ignore,
-          entryIgnored);
-      childFutures.add(std::move(entryPath), std::move(childFuture));
+      childFutures.addSubtree(
+          std::move(entryPath),
+          [context,
+           scmHash = scmEntry.second.getHash(),
+           wdHash = wdEntry.second.getHash(),
+           ignore,
+           entryIgnored](RelativePathPiece path) {
+            return diffTrees(
+                context, path, scmHash, wdHash, ignore, entryIgnored);
+          });
     } else {
       // tree-to-file
       // Add a ADDED entry for this path and a removal of the directory
@@ -185,9 +217,11 @@ void processBothPresent(
 
       // Report everything in scmTree as REMOVED
       context->callback->removedPath(entryPath, scmEntry.second.getDtype());
-      auto childFuture =
-          diffRemovedTree(context, entryPath, scmEntry.second.getHash());
-      childFutures.add(std::move(entryPath), std::move(childFuture));
+      childFutures.addSubtree(
+          std::move(entryPath),
+          [context, hash = scmEntry.second.getHash()](RelativePathPiece path) {
+            return diffRemovedTree(context, path, hash);
+          });
     }
   } else {
     if (isTreeWD) {
@@ -197,9 +231,12 @@ void processBothPresent(
 
       // Report everything in wdEntry as ADDED
       context->callback->addedPath(entryPath, wdEntry.second.getDtype());
-      auto childFuture = diffAddedTree(
-          context, entryPath, wdEntry.second.getHash(), ignore, entryIgnored);
-      childFutures.add(std::move(entryPath), std::move(childFuture));
+      childFutures.addSubtree(
+          std::move(entryPath),
+          [context, hash = wdEntry.second.getHash(), ignore, entryIgnored](
+              RelativePathPiece path) {
+            return diffAddedTree(context, path, hash, ignore, entryIgnored);
+          });
     } else {
       // file-to-file diff
       // Even if blobs have different hashes, they could have the same contents.
@@ -236,23 +273,80 @@ void processBothPresent(
   }
 }
 
+void reportDiffError(
+    DiffContext* context,
+    RelativePathPiece path,
+    const folly::exception_wrapper& ew) {
+  XLOG(ERR) << "error computing SCM diff for " << path;
+  context->callback->diffError(path, ew);
+}
+
+/**
+ * Run the diffs of queue one after another, until none are left to start.
+ */
+FOLLY_NODISCARD ImmediateFuture<Unit> runSubtreeDiffs(
+    DiffContext* context,
+    std::shared_ptr<SubtreeQueue> queue) {
+  while (true) {
+    auto index = queue->next++;
+    if (index >= queue->subtrees.size()) {
+      return folly::unit;
+    }
+    auto future =
+        makeImmediateFutureWith([&] {
+          auto& [path, diff] = queue->subtrees[index];
+          return diff(path);
+        }).thenTry([context, queue, index](Try<Unit>&& result) {
+          if (result.hasException()) {
+            reportDiffError(
+                context, queue->subtrees[index].first, result.exception());
+          }
+        });
+    // Diffs that complete immediately are followed by the next one on this
+    // thread, rather than by recursing.
+    if (!future.isReady()) {
+      return std::move(future).thenValue(
+          [context, queue = std::move(queue)](Unit) mutable {
+            return runSubtreeDiffs(context, std::move(queue));
+          });
+    }
+  }
+}
+
 FOLLY_NODISCARD ImmediateFuture<Unit> waitOnResults(
     DiffContext* context,
     ChildFutures&& childFutures) {
+  vector<ImmediateFuture<Unit>> subtreeRunners;
+  auto fanout = context->maxSubtreeFanout;
+  if (fanout == 0 || childFutures.subtrees.size() <= fanout) {
+    for (auto& [path, diff] : childFutures.subtrees) {
+      auto future = diff(path);
+      childFutures.add(std::move(path), std::move(future));
+    }
+  } else {
+    auto queue =
+        std::make_shared<SubtreeQueue>(std::move(childFutures.subtrees));
+    // The runners report the errors of their diffs themselves.
+    for (size_t i = 0; i < fanout; ++i) {
+      subtreeRunners.push_back(runSubtreeDiffs(context, queue));
+    }
+  }
+
   XDCHECK_EQ(childFutures.paths.size(), childFutures.futures.size());
-  return collectAll(std::move(childFutures.futures))
-      .thenValue([context, paths = std::move(childFutures.paths)](
-                     vector<Try<Unit>>&& results) {
-        XDCHECK_EQ(paths.size(), results.size());
-        for (size_t idx = 0; idx < results.size(); ++idx) {
-          const auto& result = results[idx];
-          if (!result.hasException()) {
-            continue;
-          }
-          XLOG(ERR) << "error computing SCM diff for " << paths.at(idx);
-          context->callback->diffError(paths.at(idx), result.exception());
-        }
-      });
+  subtreeRunners.push_back(
+      collectAll(std::move(childFutures.futures))
+          .thenValue([context, paths = std::move(childFutures.paths)](
+                         vector<Try<Unit>>&& results) {
+            XDCHECK_EQ(paths.size(), results.size());
+            for (size_t idx = 0; idx < results.size(); ++idx) {
+              const auto& result = results[idx];
+              if (result.hasException()) {
+                reportDiffError(context, paths.at(idx), result.exception());
+              }
+            }
+          }));
+  return collectAll(std::move(subtreeRunners))
+      .thenValue([](vector<Try<Unit>>&&) {});
 }
 
 /**
@@ -331,9 +425,10 @@ FOLLY_NODISCARD ImmediateFuture<Unit> computeTreeDiff(
 }
 
 /**
- * Load the content of the .gitignore file and return it.
+ * Load the .gitignore file and return its parsed contents, or nullptr if it
+ * can't be loaded.
  */
-ImmediateFuture<std::string> loadGitIgnore(
+ImmediateFuture<std::shared_ptr<const GitIgnore>> loadGitIgnore(
     DiffContext* context,
     const TreeEntry& treeEntry,
     RelativePath gitIgnorePath) {
@@ -342,12 +437,16 @@ ImmediateFuture<std::string> loadGitIgnore(
       type != TreeEntryType::EXECUTABLE_FILE) {
     XLOG(WARN) << "error loading gitignore at " << gitIgnorePath
                << ": not a regular file";
-    return std::string{};
+    return std::shared_ptr<const GitIgnore>{};
   } else {
     const auto& hash = treeEntry.getHash();
+    if (auto cached = context->getCachedGitIgnore(hash)) {
+      return cached;
+    }
     return context->store->getBlob(hash, context->getFetchContext())
-        .thenTry([entryPath = std::move(gitIgnorePath)](
-                     folly::Try<std::shared_ptr<const Blob>> blobTry) {
+        .thenTry([context, hash, entryPath = std::move(gitIgnorePath)](
+                     folly::Try<std::shared_ptr<const Blob>> blobTry)
+                     -> std::shared_ptr<const GitIgnore> {
           if (blobTry.hasException()) {
             // TODO: add an API to DiffCallback to report user
             // errors like this (errors that do not indicate a
@@ -356,11 +455,13 @@ ImmediateFuture<std::string> loadGitIgnore(
             XLOG(WARN) << "error loading gitignore at " << entryPath << ": "
                        << folly::exceptionStr(blobTry.exception());
 
-            return std::string{};
+            return nullptr;
           }
           const auto& contentsBuf = blobTry.value()->getContents();
           folly::io::Cursor cursor(&contentsBuf);
-          return cursor.readFixedString(contentsBuf.computeChainDataLength());
+          return context->parseGitIgnore(
+              cursor.readFixedString(contentsBuf.computeChainDataLength()),
+              &hash);
         });
   }
 }
@@ -396,7 +497,8 @@ FOLLY_NODISCARD ImmediateFuture<Unit> diffTrees(
         isIgnored);
   }
 
-  ImmediateFuture<std::string> gitIgnore{};
+  ImmediateFuture<std::shared_ptr<const GitIgnore>> gitIgnore{
+      std::shared_ptr<const GitIgnore>{}};
   if (wdTree) {
     // If this directory has a .gitignore file, load it first.
     const auto it = wdTree->find(kIgnoreFilename);
@@ -411,9 +513,9 @@ FOLLY_NODISCARD ImmediateFuture<Unit> diffTrees(
        scmTree = std::move(scmTree),
        wdTree = std::move(wdTree),
        parentIgnore,
-       isIgnored](std::string gitIgnore) mutable {
-        auto gitIgnoreStack =
-            std::make_unique<GitIgnoreStack>(parentIgnore, gitIgnore);
+       isIgnored](std::shared_ptr<const GitIgnore> gitIgnore) mutable {
+        auto gitIgnoreStack = std::make_unique<GitIgnoreStack>(
+            parentIgnore, std::move(gitIgnore));
         return computeTreeDiff(
             context,
             currentPath,
@@ -454,7 +556,7 @@ FOLLY_NODISCARD ImmediateFuture<Unit> diffTrees(
             // calls getScmStatusBetweenRevisions() with the same hash in
             // order to check if a commit hash is valid.
             if (scmTree && wdTree &&
-                context->store->areObjectsKnownIdentical(
+                context->store->areTreesKnownEquivalent(
                     scmTree->getHash(), wdTree->getHash())) {
               return folly::unit;
             }
@@ -463,12 +565,21 @@ FOLLY_NODISCARD ImmediateFuture<Unit> diffTrees(
                 ? copiedCurrentPath->piece()
                 : currentPath;
             return diffTrees(
-                context,
-                pathPiece,
-                std::move(scmTree),
-                std::move(wdTree),
-                ignore,
-                isIgnored);
+                       context, pathPiece, scmTree, wdTree, ignore, isIgnored)
+                .thenValue([context,
+                            scmTree = std::move(scmTree),
+                            wdTree = std::move(wdTree)](Unit) {
+                  // The digests of the subtrees were computed as their
+                  // diffs completed, those of these trees may now be.
+                  if (!context->isCancelled()) {
+                    if (scmTree) {
+                      context->store->computeTreeDigest(*scmTree);
+                    }
+                    if (wdTree) {
+                      context->store->computeTreeDigest(*wdTree);
+                    }
+                  }
+                });
           });
 }
 
@@ -476,15 +587,17 @@ FOLLY_NODISCARD ImmediateFuture<Unit> diffTrees(
 
 ImmediateFuture<Unit>
 diffRoots(DiffContext* context, const RootId& root1, const RootId& root2) {
-  auto future1 = context->store->getRootTree(root1, context->getFetchContext());
-  auto future2 = context->store->getRootTree(root2, context->getFetchContext());
-  return diffTrees(
-      context,
-      RelativePathPiece{},
-      std::move(future1),
-      std::move(future2),
-      nullptr,
-      false);
+  return context->store
+      ->getRootTrees({root1, root2}, context->getFetchContext())
+      .thenValue([context](std::vector<std::shared_ptr<const Tree>> trees) {
+        return diffTrees(
+            context,
+            RelativePathPiece{},
+            ImmediateFuture{std::move(trees[0])},
+            ImmediateFuture{std::move(trees[1])},
+            nullptr,
+            false);
+      });
 }
 
 ImmediateFuture<Unit> diffTrees(
@@ -7,6 +7,7 @@
 
 #include "eden/fs/store/DiffContext.h"
 
+#include "eden/fs/model/git/GitIgnoreCache.h"
 #include "eden/fs/model/git/GitIgnoreStack.h"
 #include "eden/fs/model/git/TopLevelIgnores.h"
 #include "eden/fs/store/IObjectStore.h"
@@ -19,13 +20,20 @@ DiffContext::DiffContext(
     bool listIgnored,
     CaseSensitivity caseSensitive,
     const ObjectStore* os,
-    std::unique_ptr<TopLevelIgnores> topLevelIgnores)
+    std::unique_ptr<TopLevelIgnores> topLevelIgnores,
+    size_t maxSubtreeFanout,
+    GitIgnoreCache* gitIgnoreCache)
     : callback{cb},
       store{os},
       listIgnored{listIgnored},
+      maxSubtreeFanout{maxSubtreeFanout},
       topLevelIgnores_(std::move(topLevelIgnores)),
       cancellation_{std::move(cancellation)},
-      caseSensitive_{caseSensitive} {}
+      gitIgnoreCache_{gitIgnoreCache},
+      caseSensitive_{caseSensitive} {
+  // Drop the imports that only this diff waits on once it is cancelled.
+  statsContext_->setCancellationToken(cancellation_);
+}
 
 DiffContext::~DiffContext() = default;
 
@@ -37,4 +45,21 @@ bool DiffContext::isCancelled() const {
   return cancellation_.isCancellationRequested();
 }
 
+std::shared_ptr<const GitIgnore> DiffContext::getCachedGitIgnore(
+    const ObjectId& blobId) {
+  return gitIgnoreCache_ ? gitIgnoreCache_->get(blobId) : nullptr;
+}
+
+std::shared_ptr<const GitIgnore> DiffContext::parseGitIgnore(
+    folly::StringPiece contents,
+    const ObjectId* blobId) {
+  if (!gitIgnoreCache_) {
+    auto ignore = std::make_shared<GitIgnore>();
+    ignore->loadFile(contents);
+    return ignore;
+  }
+  return blobId ? gitIgnoreCache_->insert(*blobId, contents)
+                : gitIgnoreCache_->parse(contents);
+}
+
 } // namespace facebook::eden
@@ -18,7 +18,10 @@ namespace facebook::eden {
 template <typename T>
 class ImmediateFuture;
 class DiffCallback;
+class GitIgnore;
+class GitIgnoreCache;
 class GitIgnoreStack;
+class ObjectId;
 class ObjectStore;
 class UserInfo;
 class TopLevelIgnores;
@@ -41,7 +44,9 @@ class DiffContext {
       bool listIgnored,
       CaseSensitivity caseSensitive,
       const ObjectStore* os,
-      std::unique_ptr<TopLevelIgnores> topLevelIgnores);
+      std::unique_ptr<TopLevelIgnores> topLevelIgnores,
+      size_t maxSubtreeFanout = 0,
+      GitIgnoreCache* gitIgnoreCache = nullptr);
 
   DiffContext(const DiffContext&) = delete;
   DiffContext& operator=(const DiffContext&) = delete;
@@ -58,10 +63,29 @@ class DiffContext {
    * it can completely omit processing ignored subdirectories.
    */
   bool const listIgnored;
+  /**
+   * Maximum number of subtrees of a source control tree that are compared
+   * concurrently, or 0 for no limit.
+   */
+  size_t const maxSubtreeFanout;
 
   const GitIgnoreStack* getToplevelIgnore() const;
   bool isCancelled() const;
 
+  /**
+   * The parsed contents of a .gitignore blob, or nullptr if they must be
+   * loaded and passed to parseGitIgnore().
+   */
+  std::shared_ptr<const GitIgnore> getCachedGitIgnore(const ObjectId& blobId);
+
+  /**
+   * Parse the contents of a .gitignore file, which are those of blobId when
+   * it is set, caching them for the following diffs.
+   */
+  std::shared_ptr<const GitIgnore> parseGitIgnore(
+      folly::StringPiece contents,
+      const ObjectId* blobId);
+
   const StatsFetchContext& getStatsContext() {
     return *statsContext_;
   }
@@ -78,6 +102,8 @@ class DiffContext {
  private:
   std::unique_ptr<TopLevelIgnores> topLevelIgnores_;
   const folly::CancellationToken cancellation_;
+  /** Null to parse the .gitignore files every time. */
+  GitIgnoreCache* const gitIgnoreCache_;
 
   // TODO: We could populate pid and cause here.
   StatsFetchContextPtr statsContext_ = makeRefPtr<StatsFetchContext>();
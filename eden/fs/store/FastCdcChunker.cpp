@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/FastCdcChunker.h"
+
+#include <folly/lang/Bits.h>
+#include <algorithm>
+#include <array>
+
+namespace facebook::eden {
+
+namespace {
+
+/**
+ * 256 pseudo-random values, from a fixed splitmix64 sequence so that they
+ * are the same on every build.
+ */
+constexpr std::array<uint64_t, 256> makeGearTable() {
+  std::array<uint64_t, 256> table{};
+  uint64_t state = 0x4544454e43444300; // "EDENCDC"
+  for (auto& value : table) {
+    state += 0x9e3779b97f4a7c15;
+    uint64_t z = state;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    value = z ^ (z >> 31);
+  }
+  return table;
+}
+
+constexpr auto kGear = makeGearTable();
+
+/**
+ * A mask of the given number of the high bits, which depend on the last 64
+ * bytes rather than only on the last few ones.
+ */
+constexpr uint64_t highBitsMask(size_t bits) {
+  return bits == 0 ? 0 : ~uint64_t{0} << (64 - bits);
+}
+
+} // namespace
+
+FastCdcChunker::FastCdcChunker(
+    size_t minSize,
+    size_t averageSize,
+    size_t maxSize)
+    : minSize_{minSize},
+      averageSize_{folly::prevPowTwo(std::max(averageSize, size_t{4}))},
+      maxSize_{std::max(maxSize, minSize)} {
+  auto bits = static_cast<size_t>(folly::findLastSet(averageSize_) - 1);
+  smallMask_ = highBitsMask(std::min<size_t>(bits + 2, 63));
+  largeMask_ = highBitsMask(bits - 2);
+}
+
+size_t FastCdcChunker::nextChunkLength(folly::ByteRange data) const noexcept {
+  auto length = std::min(data.size(), maxSize_);
+  if (length <= minSize_) {
+    return length;
+  }
+  auto normalSize = std::min(averageSize_, length);
+  uint64_t hash = 0;
+  size_t i = minSize_;
+  for (; i < normalSize; ++i) {
+    hash = (hash << 1) + kGear[data[i]];
+    if ((hash & smallMask_) == 0) {
+      return i + 1;
+    }
+  }
+  for (; i < length; ++i) {
+    hash = (hash << 1) + kGear[data[i]];
+    if ((hash & largeMask_) == 0) {
+      return i + 1;
+    }
+  }
+  return length;
+}
+
+std::vector<size_t> FastCdcChunker::chunkLengths(folly::ByteRange data) const {
+  std::vector<size_t> lengths;
+  while (!data.empty()) {
+    auto length = nextChunkLength(data);
+    lengths.push_back(length);
+    data.advance(length);
+  }
+  return lengths;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace facebook::eden {
+
+/**
+ * Splits data into content-defined chunks with FastCDC: a chunk ends where a
+ * rolling gear hash of the last bytes matches a mask, so that an edit only
+ * changes the chunks around it and the others can be shared between
+ * versions of a file.
+ *
+ * The boundaries are part of the on-disk format of chunked blobs: changing
+ * the gear table or the sizes doesn't break reading them, but prevents the
+ * new chunks from being deduplicated with the old ones.
+ */
+class FastCdcChunker {
+ public:
+  static constexpr size_t kDefaultMinSize = 16 * 1024;
+  static constexpr size_t kDefaultAverageSize = 64 * 1024;
+  static constexpr size_t kDefaultMaxSize = 256 * 1024;
+
+  /**
+   * averageSize is rounded down to a power of two.
+   */
+  FastCdcChunker(
+      size_t minSize = kDefaultMinSize,
+      size_t averageSize = kDefaultAverageSize,
+      size_t maxSize = kDefaultMaxSize);
+
+  /**
+   * Length of the chunk starting at the beginning of data.
+   */
+  size_t nextChunkLength(folly::ByteRange data) const noexcept;
+
+  /**
+   * Lengths of the chunks of data, in order.
+   */
+  std::vector<size_t> chunkLengths(folly::ByteRange data) const;
+
+ private:
+  size_t minSize_;
+  size_t averageSize_;
+  size_t maxSize_;
+  // Normalized chunking: boundaries are harder to hit before averageSize_
+  // and easier after, which narrows the distribution of chunk sizes.
+  uint64_t smallMask_;
+  uint64_t largeMask_;
+};
+
+} // namespace facebook::eden
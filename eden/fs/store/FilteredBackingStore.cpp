@@ -0,0 +1,386 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/FilteredBackingStore.h"
+
+#include <fmt/format.h>
+#include <folly/Conv.h>
+#include <folly/String.h>
+#include <folly/lang/Bits.h>
+#include <folly/logging/xlog.h>
+
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/model/TreeEntry.h"
+#include "eden/fs/utils/FileUtils.h"
+#include "eden/fs/utils/SystemError.h"
+
+namespace facebook::eden {
+
+namespace {
+/**
+ * Filtered tree ids are laid out as:
+ * - kFilteredTreeIdType (1 byte)
+ * - the unfiltered id, first so that the bytes ObjectId hashes vary
+ * - the path
+ * - the filter id (8 bytes)
+ * - the sizes of the unfiltered id and of the path (4 bytes each, big endian)
+ *
+ * Filtered RootIds are the unfiltered RootId, a NUL byte, and the hex filter
+ * id.
+ */
+constexpr uint8_t kFilteredTreeIdType = 0x10;
+constexpr size_t kFilterIdSize = 8;
+constexpr size_t kTrailerSize = kFilterIdSize + 2 * sizeof(uint32_t);
+constexpr char kRootIdSeparator = '\0';
+constexpr folly::StringPiece kRenderedTreeIdPrefix{"filtered:"};
+} // namespace
+
+FilteredBackingStore::FilteredBackingStore(
+    std::shared_ptr<BackingStore> backingStore,
+    AbsolutePath filterDir)
+    : backingStore_{std::move(backingStore)}, filterDir_{std::move(filterDir)} {
+  ensureDirectoryExists(filterDir_);
+  auto names = getAllDirectoryEntryNames(filterDir_);
+  if (names.hasException()) {
+    XLOG(WARN) << "Failed to list the filters in " << filterDir_ << ": "
+               << names.exception().what();
+    return;
+  }
+
+  auto state = state_.wlock();
+  for (const auto& name : names.value()) {
+    auto path = filterDir_ + name;
+    try {
+      auto filter = std::make_shared<const PathFilter>(
+          PathFilter::parse(readFile(path).value()));
+      if (folly::hexlify(filter->getId()) != name.value()) {
+        XLOG(WARN) << "Ignoring filter " << path << " whose id doesn't match";
+        continue;
+      }
+      state->filters.emplace(filter->getId(), std::move(filter));
+    } catch (const std::exception& ex) {
+      XLOG(WARN) << "Ignoring unreadable filter " << path << ": " << ex.what();
+    }
+  }
+}
+
+FilteredBackingStore::~FilteredBackingStore() {}
+
+void FilteredBackingStore::setFilter(const PathFilter& filter) {
+  if (filter.empty()) {
+    state_.wlock()->current = nullptr;
+    return;
+  }
+
+  auto known = state_.withRLock([&](const State& state) {
+    auto it = state.filters.find(filter.getId());
+    return it == state.filters.end() ? nullptr : it->second;
+  });
+  if (!known) {
+    // Persist the filter before any id refers to it.
+    auto serialized = filter.serialize();
+    writeFileAtomic(
+        filterDir_ + PathComponent{folly::hexlify(filter.getId())},
+        folly::StringPiece{serialized})
+        .value();
+    known = std::make_shared<const PathFilter>(filter);
+  }
+
+  auto state = state_.wlock();
+  state->filters.emplace(filter.getId(), known);
+  state->current = std::move(known);
+}
+
+PathFilter FilteredBackingStore::loadFilterFile(AbsolutePathPiece path) {
+  auto contents = readFile(path);
+  if (contents.hasException()) {
+    auto* err = contents.tryGetExceptionObject<std::system_error>();
+    if (err && isEnoent(*err)) {
+      return PathFilter{};
+    }
+    contents.throwUnlessValue();
+  }
+  return PathFilter::parse(contents.value());
+}
+
+RootId FilteredBackingStore::withCurrentFilter(const RootId& rootId) {
+  auto unfiltered = decodeRootId(rootId).first;
+  auto current = state_.rlock()->current;
+  if (!current) {
+    return unfiltered;
+  }
+  return RootId{folly::to<std::string>(
+      unfiltered.value(),
+      kRootIdSeparator,
+      folly::hexlify(current->getId()))};
+}
+
+std::pair<RootId, std::shared_ptr<const PathFilter>>
+FilteredBackingStore::decodeRootId(const RootId& rootId) const {
+  const auto& value = rootId.value();
+  auto separator = value.rfind(kRootIdSeparator);
+  if (separator == std::string::npos) {
+    return {rootId, nullptr};
+  }
+
+  std::string filterId;
+  if (!folly::unhexlify(value.substr(separator + 1), filterId)) {
+    throw std::domain_error(
+        fmt::format("invalid filter in root id {}", folly::hexlify(value)));
+  }
+  auto state = state_.rlock();
+  auto it = state->filters.find(filterId);
+  if (it == state->filters.end()) {
+    throw std::domain_error(fmt::format(
+        "unknown filter {} in root id {}",
+        folly::hexlify(filterId),
+        value.substr(0, separator)));
+  }
+  return {RootId{value.substr(0, separator)}, it->second};
+}
+
+ObjectId FilteredBackingStore::makeFilteredTreeId(
+    folly::StringPiece filterId,
+    RelativePathPiece path,
+    const ObjectId& unfiltered) {
+  XDCHECK_EQ(kFilterIdSize, filterId.size());
+  auto unfilteredBytes = unfiltered.getBytes();
+  auto pathBytes = path.stringPiece();
+
+  ObjectId::Storage bytes;
+  bytes.reserve(1 + unfilteredBytes.size() + pathBytes.size() + kTrailerSize);
+  bytes.push_back(static_cast<char>(kFilteredTreeIdType));
+  bytes.append(
+      reinterpret_cast<const char*>(unfilteredBytes.data()),
+      unfilteredBytes.size());
+  bytes.append(pathBytes.data(), pathBytes.size());
+  bytes.append(filterId.data(), filterId.size());
+  for (auto size : {unfilteredBytes.size(), pathBytes.size()}) {
+    auto bigEndian = folly::Endian::big(static_cast<uint32_t>(size));
+    bytes.append(reinterpret_cast<const char*>(&bigEndian), sizeof(bigEndian));
+  }
+  return ObjectId{std::move(bytes)};
+}
+
+std::optional<FilteredBackingStore::FilteredTreeId>
+FilteredBackingStore::decodeTreeId(const ObjectId& id) const {
+  auto bytes = id.getBytes();
+  if (bytes.size() < 1 + kTrailerSize || bytes[0] != kFilteredTreeIdType) {
+    return std::nullopt;
+  }
+
+  auto trailer = bytes.subpiece(bytes.size() - kTrailerSize);
+  auto readSize = [&](size_t offset) -> size_t {
+    uint32_t bigEndian;
+    memcpy(
+        &bigEndian,
+        trailer.data() + kFilterIdSize + offset,
+        sizeof(bigEndian));
+    return folly::Endian::big(bigEndian);
+  };
+  auto unfilteredSize = readSize(0);
+  auto pathSize = readSize(sizeof(uint32_t));
+  if (1 + unfilteredSize + pathSize + kTrailerSize != bytes.size()) {
+    return std::nullopt;
+  }
+
+  std::string filterId{
+      reinterpret_cast<const char*>(trailer.data()), kFilterIdSize};
+  auto filter = state_.withRLock(
+      [&](const State& state) -> std::shared_ptr<const PathFilter> {
+        auto it = state.filters.find(filterId);
+        return it == state.filters.end() ? nullptr : it->second;
+      });
+  if (!filter) {
+    return std::nullopt;
+  }
+
+  auto unfiltered = bytes.subpiece(1, unfilteredSize);
+  folly::StringPiece path{bytes.subpiece(1 + unfilteredSize, pathSize)};
+  try {
+    return FilteredTreeId{
+        std::move(filter), RelativePath{path}, ObjectId{unfiltered}};
+  } catch (const std::exception&) {
+    return std::nullopt;
+  }
+}
+
+std::unique_ptr<Tree> FilteredBackingStore::filterTree(
+    const Tree& tree,
+    RelativePathPiece dir,
+    const PathFilter& filter,
+    ObjectId id) {
+  Tree::container entries{tree.getCaseSensitivity()};
+  entries.reserve(tree.size());
+  for (const auto& [name, entry] : tree) {
+    auto path = dir + name;
+    if (filter.isHidden(path)) {
+      continue;
+    }
+    if (entry.isTree() && filter.mayHideUnder(path)) {
+      entries.emplace(
+          name,
+          makeFilteredTreeId(filter.getId(), path, entry.getHash()),
+          TreeEntryType::TREE);
+    } else {
+      entries.emplace(name, entry);
+    }
+  }
+  return std::make_unique<Tree>(std::move(entries), std::move(id));
+}
+
+ObjectComparison FilteredBackingStore::compareObjectsById(
+    const ObjectId& one,
+    const ObjectId& two) {
+  if (one.bytesEqual(two)) {
+    return ObjectComparison::Identical;
+  }
+  auto filteredOne = decodeTreeId(one);
+  auto filteredTwo = decodeTreeId(two);
+  if (!filteredOne && !filteredTwo) {
+    return backingStore_->compareObjectsById(one, two);
+  }
+  if (filteredOne && filteredTwo &&
+      filteredOne->filter == filteredTwo->filter &&
+      filteredOne->path == filteredTwo->path) {
+    return backingStore_->compareObjectsById(
+        filteredOne->unfiltered, filteredTwo->unfiltered);
+  }
+  // Differently filtered trees may still have the same visible contents.
+  return ObjectComparison::Unknown;
+}
+
+ImmediateFuture<std::unique_ptr<Tree>> FilteredBackingStore::getRootTree(
+    const RootId& rootId,
+    const ObjectFetchContextPtr& context) {
+  auto [unfiltered, filter] = decodeRootId(rootId);
+  return backingStore_->getRootTree(unfiltered, context)
+      .thenValue([filter = std::move(filter)](
+                     std::unique_ptr<Tree> tree) -> std::unique_ptr<Tree> {
+        if (!tree || !filter) {
+          return tree;
+        }
+        auto id = makeFilteredTreeId(
+            filter->getId(), RelativePathPiece{}, tree->getHash());
+        return filterTree(*tree, RelativePathPiece{}, *filter, std::move(id));
+      });
+}
+
+ImmediateFuture<std::unique_ptr<TreeEntry>>
+FilteredBackingStore::getTreeEntryForObjectId(
+    const ObjectId& objectId,
+    TreeEntryType treeEntryType,
+    const ObjectFetchContextPtr& context) {
+  auto filtered = treeEntryType == TreeEntryType::TREE
+      ? decodeTreeId(objectId)
+      : std::nullopt;
+  if (!filtered) {
+    return backingStore_->getTreeEntryForObjectId(
+        objectId, treeEntryType, context);
+  }
+  return backingStore_
+      ->getTreeEntryForObjectId(filtered->unfiltered, treeEntryType, context)
+      .thenValue([objectId](std::unique_ptr<TreeEntry> entry) {
+        return entry
+            ? std::make_unique<TreeEntry>(objectId, entry->getType())
+            : nullptr;
+      });
+}
+
+folly::SemiFuture<BackingStore::GetTreeResult> FilteredBackingStore::getTree(
+    const ObjectId& id,
+    const ObjectFetchContextPtr& context) {
+  auto filtered = decodeTreeId(id);
+  if (!filtered) {
+    return backingStore_->getTree(id, context);
+  }
+  auto unfiltered = filtered->unfiltered;
+  return backingStore_->getTree(unfiltered, context)
+      .deferValue([id, filtered = std::move(filtered)](GetTreeResult result) {
+        if (result.tree) {
+          result.tree =
+              filterTree(*result.tree, filtered->path, *filtered->filter, id);
+        }
+        return result;
+      });
+}
+
+folly::SemiFuture<BackingStore::GetBlobResult> FilteredBackingStore::getBlob(
+    const ObjectId& id,
+    const ObjectFetchContextPtr& context) {
+  return backingStore_->getBlob(id, context);
+}
+
+std::unique_ptr<BlobMetadata> FilteredBackingStore::getLocalBlobMetadata(
+    const ObjectId& id,
+    const ObjectFetchContextPtr& context) {
+  return backingStore_->getLocalBlobMetadata(id, context);
+}
+
+folly::SemiFuture<folly::Unit> FilteredBackingStore::prefetchBlobs(
+    ObjectIdRange ids,
+    const ObjectFetchContextPtr& context) {
+  return backingStore_->prefetchBlobs(ids, context);
+}
+
+void FilteredBackingStore::periodicManagementTask() {
+  backingStore_->periodicManagementTask();
+}
+
+void FilteredBackingStore::startRecordingFetch() {
+  backingStore_->startRecordingFetch();
+}
+
+std::unordered_set<std::string> FilteredBackingStore::stopRecordingFetch() {
+  return backingStore_->stopRecordingFetch();
+}
+
+folly::SemiFuture<folly::Unit> FilteredBackingStore::importManifestForRoot(
+    const RootId& rootId,
+    const Hash20& manifest) {
+  return backingStore_->importManifestForRoot(
+      decodeRootId(rootId).first, manifest);
+}
+
+RootId FilteredBackingStore::parseRootId(folly::StringPiece rootId) {
+  return withCurrentFilter(backingStore_->parseRootId(rootId));
+}
+
+std::string FilteredBackingStore::renderRootId(const RootId& rootId) {
+  return backingStore_->renderRootId(decodeRootId(rootId).first);
+}
+
+ObjectId FilteredBackingStore::parseObjectId(folly::StringPiece objectId) {
+  if (objectId.startsWith(kRenderedTreeIdPrefix)) {
+    std::string bytes;
+    if (!folly::unhexlify(
+            objectId.subpiece(kRenderedTreeIdPrefix.size()), bytes)) {
+      throw std::invalid_argument(
+          fmt::format("invalid filtered object id {}", objectId.str()));
+    }
+    return ObjectId{folly::ByteRange{folly::StringPiece{bytes}}};
+  }
+  return backingStore_->parseObjectId(objectId);
+}
+
+std::string FilteredBackingStore::renderObjectId(const ObjectId& objectId) {
+  if (decodeTreeId(objectId)) {
+    return folly::to<std::string>(
+        kRenderedTreeIdPrefix, folly::hexlify(objectId.getBytes()));
+  }
+  return backingStore_->renderObjectId(objectId);
+}
+
+std::optional<folly::StringPiece> FilteredBackingStore::getRepoName() {
+  return backingStore_->getRepoName();
+}
+
+int64_t FilteredBackingStore::dropAllPendingRequestsFromQueue() {
+  return backingStore_->dropAllPendingRequestsFromQueue();
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "eden/fs/store/BackingStore.h"
+#include "eden/fs/store/PathFilter.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/**
+ * A BackingStore for a filtered mount: the trees it returns don't contain the
+ * paths that the mount's PathFilter hides, so they are never loaded, listed
+ * or fetched.
+ *
+ * Since the same tree can be filtered differently depending on its path and
+ * on the filter, the ids of the trees the filter may change encode the
+ * filter, the path, and the id of the unfiltered tree. Trees that the filter
+ * can't change keep the id of the unfiltered tree. As a result, changing the
+ * filter is a checkout between two root trees that only differ in the
+ * subtrees the old or the new filter affects, and unaffected subtrees are
+ * skipped by their ids.
+ *
+ * The filter is part of the RootId as well, and rootIds parsed from clients,
+ * which don't know about filters, get the current filter. Blob ids are not
+ * changed.
+ *
+ * Tree ids that were not produced by this store, for instance those stored
+ * in the overlay before the mount was filtered, are passed through
+ * unfiltered.
+ */
+class FilteredBackingStore final : public BackingStore {
+ public:
+  /**
+   * filterDir holds the definition of every filter the mount used, so that
+   * the ids that were produced with them can be read after a restart.
+   */
+  FilteredBackingStore(
+      std::shared_ptr<BackingStore> backingStore,
+      AbsolutePath filterDir);
+  ~FilteredBackingStore() override;
+
+  /**
+   * Persists filter, and makes it the filter of the RootIds that
+   * parseRootId() and withCurrentFilter() return. Throws if filter can't be
+   * persisted.
+   */
+  void setFilter(const PathFilter& filter);
+
+  /**
+   * Reads and parses the filter file of a mount, which shows everything when
+   * it doesn't exist.
+   */
+  static PathFilter loadFilterFile(AbsolutePathPiece path);
+
+  /**
+   * Returns the RootId of the same commit as rootId, with the current filter.
+   */
+  RootId withCurrentFilter(const RootId& rootId);
+
+  ObjectComparison compareObjectsById(const ObjectId& one, const ObjectId& two)
+      override;
+
+  ImmediateFuture<std::unique_ptr<Tree>> getRootTree(
+      const RootId& rootId,
+      const ObjectFetchContextPtr& context) override;
+
+  ImmediateFuture<std::unique_ptr<TreeEntry>> getTreeEntryForObjectId(
+      const ObjectId& objectId,
+      TreeEntryType treeEntryType,
+      const ObjectFetchContextPtr& context) override;
+  folly::SemiFuture<GetTreeResult> getTree(
+      const ObjectId& id,
+      const ObjectFetchContextPtr& context) override;
+  folly::SemiFuture<GetBlobResult> getBlob(
+      const ObjectId& id,
+      const ObjectFetchContextPtr& context) override;
+
+  std::unique_ptr<BlobMetadata> getLocalBlobMetadata(
+      const ObjectId& id,
+      const ObjectFetchContextPtr& context) override;
+
+  FOLLY_NODISCARD folly::SemiFuture<folly::Unit> prefetchBlobs(
+      ObjectIdRange ids,
+      const ObjectFetchContextPtr& context) override;
+
+  void periodicManagementTask() override;
+
+  void startRecordingFetch() override;
+  std::unordered_set<std::string> stopRecordingFetch() override;
+
+  folly::SemiFuture<folly::Unit> importManifestForRoot(
+      const RootId& rootId,
+      const Hash20& manifest) override;
+
+  RootId parseRootId(folly::StringPiece rootId) override;
+  std::string renderRootId(const RootId& rootId) override;
+  ObjectId parseObjectId(folly::StringPiece objectId) override;
+  std::string renderObjectId(const ObjectId& objectId) override;
+
+  std::optional<folly::StringPiece> getRepoName() override;
+
+  int64_t dropAllPendingRequestsFromQueue() override;
+
+  /**
+   * Get the underlying BackingStore. This should only be used for operations
+   * that need to be made directly on the BackingStore, like getting a TraceBus
+   */
+  const std::shared_ptr<BackingStore>& getBackingStore() {
+    return backingStore_;
+  }
+
+  /**
+   * Returns the tree with the entries that filter hides under dir removed,
+   * and the ids of the subtrees that filter may change replaced. The result
+   * has the id id.
+   */
+  static std::unique_ptr<Tree> filterTree(
+      const Tree& tree,
+      RelativePathPiece dir,
+      const PathFilter& filter,
+      ObjectId id);
+
+  /**
+   * The id of the tree unfiltered at path, filtered with the filter whose id
+   * is filterId.
+   */
+  static ObjectId makeFilteredTreeId(
+      folly::StringPiece filterId,
+      RelativePathPiece path,
+      const ObjectId& unfiltered);
+
+ private:
+  struct FilteredTreeId {
+    std::shared_ptr<const PathFilter> filter;
+    RelativePath path;
+    ObjectId unfiltered;
+  };
+
+  struct State {
+    // Every known filter, by id.
+    std::unordered_map<std::string, std::shared_ptr<const PathFilter>> filters;
+    std::shared_ptr<const PathFilter> current;
+  };
+
+  /**
+   * Returns std::nullopt if id was not produced by makeFilteredTreeId() with a
+   * known filter.
+   */
+  std::optional<FilteredTreeId> decodeTreeId(const ObjectId& id) const;
+
+  /**
+   * Returns the unfiltered RootId and the filter of rootId, nullptr if it
+   * isn't filtered. Throws std::domain_error if the filter is unknown.
+   */
+  std::pair<RootId, std::shared_ptr<const PathFilter>> decodeRootId(
+      const RootId& rootId) const;
+
+  std::shared_ptr<BackingStore> backingStore_;
+  AbsolutePath filterDir_;
+  folly::Synchronized<State> state_;
+};
+
+} // namespace facebook::eden
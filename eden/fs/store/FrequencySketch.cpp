@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/FrequencySketch.h"
+
+#include <folly/hash/Hash.h>
+#include <folly/lang/Bits.h>
+#include <algorithm>
+
+namespace facebook::eden {
+
+namespace {
+constexpr size_t kMinimumWidth = 64;
+constexpr uint64_t kRowSeeds[] = {
+    0xc3a5c85c97cb3127ULL,
+    0xb492b66fbe98f273ULL,
+    0x9ae16a3b2f90404fULL,
+    0xcbf29ce484222325ULL,
+};
+} // namespace
+
+FrequencySketch::FrequencySketch(size_t expectedEntries)
+    : width_{folly::nextPowTwo(std::max(expectedEntries, kMinimumWidth))},
+      sampleSize_{10 * std::max(expectedEntries, kMinimumWidth)} {
+  table_.resize(kDepth * width_);
+}
+
+size_t FrequencySketch::indexOf(size_t row, uint64_t hash) const noexcept {
+  auto mixed = folly::hash::twang_mix64(hash ^ kRowSeeds[row]);
+  return row * width_ + (mixed & (width_ - 1));
+}
+
+void FrequencySketch::increment(const ObjectId& id) noexcept {
+  if (table_.empty()) {
+    return;
+  }
+
+  auto hash = id.getHashCode();
+  bool added = false;
+  for (size_t row = 0; row < kDepth; ++row) {
+    auto& counter = table_[indexOf(row, hash)];
+    if (counter < kMaxCount) {
+      ++counter;
+      added = true;
+    }
+  }
+
+  if (added && ++additions_ >= sampleSize_) {
+    reset();
+  }
+}
+
+uint8_t FrequencySketch::estimate(const ObjectId& id) const noexcept {
+  if (table_.empty()) {
+    return 0;
+  }
+
+  auto hash = id.getHashCode();
+  uint8_t result = kMaxCount;
+  for (size_t row = 0; row < kDepth; ++row) {
+    result = std::min(result, table_[indexOf(row, hash)]);
+  }
+  return result;
+}
+
+void FrequencySketch::reset() noexcept {
+  for (auto& counter : table_) {
+    counter >>= 1;
+  }
+  additions_ /= 2;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "eden/fs/model/ObjectId.h"
+
+namespace facebook::eden {
+
+/**
+ * A count-min sketch of 4-bit saturating counters estimating how often an
+ * ObjectId has been accessed recently. Used as the admission filter of the
+ * TinyLFU cache eviction policy.
+ *
+ * To keep the estimates biased towards recent history, all the counters are
+ * halved once the number of recorded accesses reaches ten times the expected
+ * number of entries.
+ *
+ * A default constructed sketch is disabled: increment() is a no-op and
+ * estimate() always returns 0.
+ *
+ * This class is not thread safe.
+ */
+class FrequencySketch {
+ public:
+  FrequencySketch() = default;
+
+  /**
+   * expectedEntries is the number of objects the owning cache is expected to
+   * hold. The sketch uses roughly 4 bytes per expected entry.
+   */
+  explicit FrequencySketch(size_t expectedEntries);
+
+  /**
+   * Record an access to the given object.
+   */
+  void increment(const ObjectId& id) noexcept;
+
+  /**
+   * Return the estimated number of recent accesses to the given object,
+   * saturating at kMaxCount.
+   */
+  uint8_t estimate(const ObjectId& id) const noexcept;
+
+  static constexpr uint8_t kMaxCount = 15;
+
+ private:
+  static constexpr size_t kDepth = 4;
+
+  size_t indexOf(size_t row, uint64_t hash) const noexcept;
+  void reset() noexcept;
+
+  /// kDepth rows of width_ counters, stored row after row.
+  std::vector<uint8_t> table_;
+  size_t width_{0};
+  size_t additions_{0};
+  size_t sampleSize_{0};
+};
+
+} // namespace facebook::eden
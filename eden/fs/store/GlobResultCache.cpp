@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/GlobResultCache.h"
+
+#include <fmt/format.h>
+#include <folly/Utility.h>
+#include <folly/io/Cursor.h>
+#include <folly/io/IOBufQueue.h>
+#include <folly/logging/xlog.h>
+
+#include "eden/fs/store/LocalStore.h"
+#include "eden/fs/store/StoreResult.h"
+#include "eden/fs/telemetry/EdenStats.h"
+
+namespace facebook::eden {
+
+namespace {
+/**
+ * The serialized entries are stored as:
+ * - version (1 byte)
+ * - number of entries (4 bytes, big endian)
+ * - for each entry:
+ *   - name length (4 bytes, big endian), then name
+ *   - dtype (1 byte)
+ *   - id length (4 bytes, big endian), then id
+ */
+constexpr uint8_t kFormatVersion = 1;
+
+std::vector<GlobResultCache::Entry> deserialize(folly::ByteRange bytes) {
+  folly::IOBuf buf{folly::IOBuf::WRAP_BUFFER, bytes};
+  folly::io::Cursor cursor{&buf};
+  auto version = cursor.read<uint8_t>();
+  if (version != kFormatVersion) {
+    throw std::invalid_argument(
+        fmt::format("unknown glob result format version {}", version));
+  }
+
+  std::vector<GlobResultCache::Entry> entries;
+  auto count = cursor.readBE<uint32_t>();
+  entries.reserve(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    auto name = cursor.readFixedString(cursor.readBE<uint32_t>());
+    auto dtype = static_cast<dtype_t>(cursor.read<uint8_t>());
+    auto id = cursor.readFixedString(cursor.readBE<uint32_t>());
+    entries.push_back(GlobResultCache::Entry{
+        RelativePath{std::move(name)},
+        dtype,
+        ObjectId{folly::ByteRange{folly::StringPiece{id}}}});
+  }
+  return entries;
+}
+} // namespace
+
+GlobResultCache::GlobResultCache(
+    std::shared_ptr<LocalStore> localStore,
+    std::shared_ptr<EdenStats> stats)
+    : localStore_{std::move(localStore)}, stats_{std::move(stats)} {}
+
+std::optional<std::vector<GlobResultCache::Entry>> GlobResultCache::get(
+    const Hash20& key) const {
+  auto result = localStore_->get(KeySpace::GlobResultFamily, key.getBytes());
+  if (result.isValid()) {
+    try {
+      auto entries = deserialize(result.bytes());
+      stats_->increment(&ObjectStoreStats::globResultCacheHit);
+      return entries;
+    } catch (const std::exception& ex) {
+      // A corrupt entry is treated like a missing one, and is overwritten
+      // once the glob has been evaluated again.
+      XLOG(WARN) << "Ignoring unreadable glob results " << key << ": "
+                 << ex.what();
+    }
+  }
+  stats_->increment(&ObjectStoreStats::globResultCacheMiss);
+  return std::nullopt;
+}
+
+void GlobResultCache::put(
+    const Hash20& key,
+    const std::vector<Entry>& entries) const {
+  folly::IOBufQueue queue{folly::IOBufQueue::cacheChainLength()};
+  folly::io::QueueAppender appender{&queue, 4096};
+  appender.write<uint8_t>(kFormatVersion);
+  appender.writeBE<uint32_t>(folly::to_narrow(entries.size()));
+  for (const auto& entry : entries) {
+    auto name = entry.name.view();
+    appender.writeBE<uint32_t>(folly::to_narrow(name.size()));
+    appender.push(folly::StringPiece{name});
+    appender.write<uint8_t>(static_cast<uint8_t>(entry.dtype));
+    auto id = entry.id.getBytes();
+    appender.writeBE<uint32_t>(folly::to_narrow(id.size()));
+    appender.push(id);
+  }
+
+  auto buf = queue.move();
+  buf->coalesce();
+  localStore_->put(
+      KeySpace::GlobResultFamily,
+      key.getBytes(),
+      folly::ByteRange{buf->data(), buf->length()});
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "eden/fs/model/Hash.h"
+#include "eden/fs/model/ObjectId.h"
+#include "eden/fs/utils/DirType.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+class EdenStats;
+class LocalStore;
+
+/**
+ * Remembers the results of globs against source control trees in the
+ * LocalStore.
+ *
+ * A tree being immutable, the files that a given set of patterns matches
+ * under it never change. The caller is responsible for computing a key that
+ * covers both the tree and everything the evaluation depends on.
+ */
+class GlobResultCache {
+ public:
+  struct Entry {
+    // The path of the match, relative to the directory the glob was
+    // evaluated against.
+    RelativePath name;
+    dtype_t dtype;
+    ObjectId id;
+  };
+
+  GlobResultCache(
+      std::shared_ptr<LocalStore> localStore,
+      std::shared_ptr<EdenStats> stats);
+
+  /**
+   * Return the entries stored for key, or std::nullopt if there are none.
+   */
+  std::optional<std::vector<Entry>> get(const Hash20& key) const;
+
+  void put(const Hash20& key, const std::vector<Entry>& entries) const;
+
+ private:
+  std::shared_ptr<LocalStore> localStore_;
+  std::shared_ptr<EdenStats> stats_;
+};
+
+} // namespace facebook::eden
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/HeavyFetcherPolicy.h"
+
+#include <algorithm>
+
+namespace facebook::eden {
+
+void HeavyFetcherPolicy::advanceWindow(
+    Process& process,
+    std::chrono::nanoseconds window,
+    std::chrono::steady_clock::time_point now) {
+  auto elapsed = now - process.windowStart;
+  if (elapsed < window) {
+    return;
+  }
+  if (elapsed < 2 * window) {
+    process.previousWindowFetches = process.windowFetches;
+    process.windowStart += window;
+  } else {
+    process.previousWindowFetches = 0;
+    process.windowStart = now;
+  }
+  process.windowFetches = 0;
+}
+
+uint64_t HeavyFetcherPolicy::getRecentFetches(
+    const Process& process,
+    std::chrono::nanoseconds window,
+    std::chrono::steady_clock::time_point now) {
+  auto elapsed = now - process.windowStart;
+  uint64_t previous = process.previousWindowFetches;
+  uint64_t current = process.windowFetches;
+  if (elapsed >= 2 * window) {
+    return 0;
+  }
+  if (elapsed >= window) {
+    // The current window is over, and becomes the previous one.
+    previous = current;
+    current = 0;
+    elapsed -= window;
+  }
+  // The part of the previous window still in the sliding one.
+  auto remaining = static_cast<double>((window - elapsed).count()) /
+      static_cast<double>(window.count());
+  return current + static_cast<uint64_t>(previous * remaining);
+}
+
+HeavyFetcherPolicy::Decision HeavyFetcherPolicy::recordFetch(
+    pid_t pid,
+    const Config& config,
+    std::chrono::steady_clock::time_point now) {
+  Decision decision;
+  if (config.heavyFetchCount == 0 || config.window.count() <= 0) {
+    return decision;
+  }
+
+  auto state = state_.lock();
+  if (++state->fetchesSincePrune >= kPruneInterval) {
+    state->fetchesSincePrune = 0;
+    auto& processes = state->processes;
+    for (auto it = processes.begin(); it != processes.end();) {
+      if (now - it->second.windowStart >= 2 * config.window &&
+          it->second.nextFetchTime <= now) {
+        it = processes.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  auto [it, inserted] = state->processes.try_emplace(pid);
+  auto& process = it->second;
+  if (inserted) {
+    process.windowStart = now;
+  }
+  advanceWindow(process, config.window, now);
+  ++process.windowFetches;
+
+  if (getRecentFetches(process, config.window, now) <=
+      config.heavyFetchCount) {
+    return decision;
+  }
+
+  decision.heavy = true;
+  if (config.deprioritize) {
+    decision.deprioritize = true;
+    ++process.deprioritizedFetches;
+  }
+  if (config.rateLimit) {
+    auto interval = std::chrono::nanoseconds{std::chrono::seconds{1}} /
+        static_cast<int64_t>(config.rateLimit);
+    auto start = std::max(process.nextFetchTime, now);
+    process.nextFetchTime = start + interval;
+    decision.delay = start - now;
+    if (decision.delay.count() > 0) {
+      ++process.delayedFetches;
+      process.totalDelay += decision.delay;
+    }
+  }
+  return decision;
+}
+
+std::vector<HeavyFetcherPolicy::ProcessStats> HeavyFetcherPolicy::getStats(
+    const Config& config,
+    std::chrono::steady_clock::time_point now) const {
+  std::vector<ProcessStats> stats;
+  if (config.window.count() <= 0) {
+    return stats;
+  }
+
+  auto state = state_.lock();
+  stats.reserve(state->processes.size());
+  for (const auto& [pid, process] : state->processes) {
+    if (now - process.windowStart >= 2 * config.window) {
+      continue;
+    }
+    auto recentFetches = getRecentFetches(process, config.window, now);
+    stats.push_back(ProcessStats{
+        pid,
+        recentFetches,
+        config.heavyFetchCount != 0 && recentFetches > config.heavyFetchCount,
+        process.deprioritizedFetches,
+        process.delayedFetches,
+        process.totalDelay});
+  }
+  return stats;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <folly/portability/SysTypes.h>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace facebook::eden {
+
+/**
+ * Tracks the rate at which every process fetches objects from the backing
+ * store, and decides how to treat the fetches of the heaviest ones so that
+ * scanners like indexers, antivirus or `find /` don't saturate the import
+ * queue at the expense of interactive commands.
+ *
+ * The rate of a process is estimated over a sliding window, by weighting the
+ * fetches of the previous fixed window by how much of it is still in the
+ * sliding one.
+ */
+class HeavyFetcherPolicy {
+ public:
+  struct Config {
+    /**
+     * The number of fetches within the window above which a process is
+     * heavy. Zero disables the policy.
+     */
+    uint64_t heavyFetchCount{0};
+    std::chrono::nanoseconds window{std::chrono::seconds{10}};
+    /**
+     * Whether the fetches of heavy processes are lowered to the Low import
+     * priority class.
+     */
+    bool deprioritize{false};
+    /**
+     * The maximum number of fetches per second of a heavy process, the
+     * others being delayed. Zero for no limit.
+     */
+    uint64_t rateLimit{0};
+  };
+
+  struct Decision {
+    bool heavy{false};
+    bool deprioritize{false};
+    // How long to wait before starting the fetch.
+    std::chrono::nanoseconds delay{0};
+  };
+
+  struct ProcessStats {
+    pid_t pid;
+    // The estimated number of fetches within the last window.
+    uint64_t recentFetches;
+    bool heavy;
+    uint64_t deprioritizedFetches;
+    uint64_t delayedFetches;
+    std::chrono::nanoseconds totalDelay;
+  };
+
+  /**
+   * Accounts for a fetch of the process about to go to the backing store
+   * and returns how to treat it.
+   */
+  Decision recordFetch(
+      pid_t pid,
+      const Config& config,
+      std::chrono::steady_clock::time_point now =
+          std::chrono::steady_clock::now());
+
+  /**
+   * The processes that fetched within the last two windows.
+   */
+  std::vector<ProcessStats> getStats(
+      const Config& config,
+      std::chrono::steady_clock::time_point now =
+          std::chrono::steady_clock::now()) const;
+
+ private:
+  struct Process {
+    std::chrono::steady_clock::time_point windowStart;
+    uint64_t windowFetches{0};
+    uint64_t previousWindowFetches{0};
+    // The earliest time the next fetch can start when rate limited.
+    std::chrono::steady_clock::time_point nextFetchTime;
+    uint64_t deprioritizedFetches{0};
+    uint64_t delayedFetches{0};
+    std::chrono::nanoseconds totalDelay{0};
+  };
+
+  // Processes that haven't fetched for this many fetches of the others are
+  // considered for pruning.
+  static constexpr uint64_t kPruneInterval = 10000;
+
+  struct State {
+    folly::F14FastMap<pid_t, Process> processes;
+    uint64_t fetchesSincePrune{0};
+  };
+
+  static void advanceWindow(
+      Process& process,
+      std::chrono::nanoseconds window,
+      std::chrono::steady_clock::time_point now);
+
+  static uint64_t getRecentFetches(
+      const Process& process,
+      std::chrono::nanoseconds window,
+      std::chrono::steady_clock::time_point now);
+
+  folly::Synchronized<State, std::mutex> state_;
+};
+
+} // namespace facebook::eden
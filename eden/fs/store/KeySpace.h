@@ -33,6 +33,19 @@ struct Deprecated {};
 
 using Persistence = std::variant<Ephemeral, Persistent, Deprecated>;
 
+/**
+ * The shape of the values of a key space, which decides how the
+ * RocksDbLocalStore lays out its column family.
+ */
+enum class StorageProfile : uint8_t {
+  Default,
+  // Values of a few dozen bytes, only ever looked up by their full key.
+  SmallValues,
+  // Values large enough that rewriting them on every compaction dominates
+  // the cost of storing them.
+  LargeValues,
+};
+
 /**
  * Which key space (and thus column family for the RocksDbLocalStore) should be
  * used to store a specific key.  The `name` value must be stable across builds
@@ -43,6 +56,7 @@ struct KeySpaceRecord {
   uint8_t index;
   folly::StringPiece name;
   Persistence persistence;
+  StorageProfile profile{StorageProfile::Default};
 
   constexpr bool isEphemeral() const noexcept {
     return std::holds_alternative<Ephemeral>(persistence);
@@ -69,11 +83,13 @@ class KeySpace {
   static constexpr KeySpaceRecord BlobFamily{
       0,
       "blob",
-      Ephemeral{&EdenConfig::localStoreBlobSizeLimit}};
+      Ephemeral{&EdenConfig::localStoreBlobSizeLimit},
+      StorageProfile::LargeValues};
   static constexpr KeySpaceRecord BlobMetaDataFamily{
       1,
       "blobmeta",
-      Ephemeral{&EdenConfig::localStoreBlobMetaSizeLimit}};
+      Ephemeral{&EdenConfig::localStoreBlobMetaSizeLimit},
+      StorageProfile::SmallValues};
   static constexpr KeySpaceRecord TreeFamily{
       2,
       "tree",
@@ -83,11 +99,13 @@ class KeySpace {
   static constexpr KeySpaceRecord HgProxyHashFamily{
       3,
       "hgproxyhash",
-      Persistent{}};
+      Persistent{},
+      StorageProfile::SmallValues};
   static constexpr KeySpaceRecord HgCommitToTreeFamily{
       4,
       "hgcommit2tree",
-      Ephemeral{&EdenConfig::localStoreHgCommit2TreeSizeLimit}};
+      Ephemeral{&EdenConfig::localStoreHgCommit2TreeSizeLimit},
+      StorageProfile::SmallValues};
   static constexpr KeySpaceRecord BlobSizeFamily{5, "blobsize", Deprecated{}};
 
   static constexpr KeySpaceRecord ScsProxyHashFamily{
@@ -102,6 +120,26 @@ class KeySpace {
       8,
       "recasdigestproxyhash",
       Deprecated{}};
+  static constexpr KeySpaceRecord GlobResultFamily{
+      9,
+      "globresult",
+      Ephemeral{&EdenConfig::localStoreGlobResultSizeLimit}};
+  static constexpr KeySpaceRecord TreeDigestFamily{
+      10,
+      "treedigest",
+      Ephemeral{&EdenConfig::localStoreTreeDigestSizeLimit},
+      StorageProfile::SmallValues};
+  // The chunks of the chunked blobs, keyed by the SHA-1 of their contents.
+  static constexpr KeySpaceRecord BlobChunkFamily{
+      11,
+      "blobchunk",
+      Ephemeral{&EdenConfig::localStoreBlobChunkSizeLimit},
+      StorageProfile::LargeValues};
+  // The models AccessPrefetcher learns, keyed by mount and trigger file.
+  static constexpr KeySpaceRecord AccessModelFamily{
+      12,
+      "accessmodel",
+      Ephemeral{&EdenConfig::localStoreAccessModelSizeLimit}};
 
   static constexpr const KeySpaceRecord* kAll[] = {
       &BlobFamily,
@@ -112,7 +150,11 @@ class KeySpace {
       &BlobSizeFamily,
       &ScsProxyHashFamily,
       &TreeMetaDataFamily,
-      &ReCasDigestProxyHashFamily};
+      &ReCasDigestProxyHashFamily,
+      &GlobResultFamily,
+      &TreeDigestFamily,
+      &BlobChunkFamily,
+      &AccessModelFamily};
   static constexpr size_t kTotalCount = std::size(kAll);
 
  private:
@@ -13,12 +13,19 @@
 #include <folly/io/IOBuf.h>
 #include <folly/lang/Bits.h>
 #include <folly/logging/xlog.h>
+#include <folly/stop_watch.h>
 #include <array>
 
 #include "eden/fs/model/Blob.h"
 #include "eden/fs/model/Tree.h"
 #include "eden/fs/model/git/GitBlob.h"
 #include "eden/fs/model/git/GitTree.h"
+#include "eden/fs/store/BlobFileCache.h"
+#include "eden/fs/store/BlobMetadataIndex.h"
+#include "eden/fs/store/ChunkedBlob.h"
+#include "eden/fs/store/FastCdcChunker.h"
+#include "eden/fs/store/LocalStoreWriteQueue.h"
+#include "eden/fs/store/MissingObjectFilter.h"
 #include "eden/fs/store/SerializedBlobMetadata.h"
 #include "eden/fs/store/StoreResult.h"
 #include "eden/fs/store/TreeMetadata.h"
@@ -32,6 +39,8 @@ using std::string;
 
 namespace facebook::eden {
 
+LocalStore::~LocalStore() = default;
+
 void LocalStore::clearDeprecatedKeySpaces() {
   for (auto& ks : KeySpace::kAll) {
     if (ks->isDeprecated()) {
@@ -48,6 +57,7 @@ void LocalStore::clearCachesAndCompactAll() {
     }
     compactKeySpace(ks);
   }
+  clearBlobMetadataIndex();
 }
 
 void LocalStore::clearCaches() {
@@ -56,6 +66,18 @@ void LocalStore::clearCaches() {
       clearKeySpace(ks);
     }
   }
+  clearBlobMetadataIndex();
+}
+
+void LocalStore::clearBlobMetadataIndex() {
+#ifndef _WIN32
+  if (blobMetadataIndex_) {
+    blobMetadataIndex_->clear();
+  }
+  if (blobFileCache_) {
+    blobFileCache_->clear();
+  }
+#endif
 }
 
 void LocalStore::compactStorage() {
@@ -111,24 +133,169 @@ ImmediateFuture<std::unique_ptr<Blob>> LocalStore::getBlob(
   }
 
   return getImmediateFuture(KeySpace::BlobFamily, id)
-      .thenValue([id](StoreResult&& data) {
+      .thenValue([id, this](StoreResult&& data) {
         if (!data.isValid()) {
           return std::unique_ptr<Blob>(nullptr);
         }
+        if (isChunkedBlobManifest(data.bytes())) {
+          return loadChunkedBlob(id, data.bytes());
+        }
+#ifndef _WIN32
+        if (auto size = BlobFileCache::parseMarker(data.bytes())) {
+          return loadBlobFile(id, *size);
+        }
+#endif
         auto buf = data.extractIOBuf();
         return deserializeGitBlob(id, &buf);
       });
 }
 
+std::unique_ptr<Blob> LocalStore::loadChunkedBlob(
+    const ObjectId& id,
+    folly::ByteRange manifestData) const {
+  auto manifest = parseChunkedBlobManifest(manifestData);
+  IOBuf contents;
+  for (const auto& key : manifest.chunkKeys) {
+    auto chunk = get(KeySpace::BlobChunkFamily, key.getBytes());
+    if (!chunk.isValid()) {
+      XLOG(DBG3) << "chunk " << key << " of blob " << id << " was evicted";
+      return nullptr;
+    }
+    if (contents.empty()) {
+      contents = chunk.extractIOBuf();
+    } else {
+      contents.prependChain(std::make_unique<IOBuf>(chunk.extractIOBuf()));
+    }
+  }
+  auto size = contents.computeChainDataLength();
+  if (size != manifest.size) {
+    throw std::invalid_argument(folly::to<string>(
+        "chunks of blob ",
+        id.toLogString(),
+        " hold ",
+        size,
+        " bytes rather than ",
+        manifest.size));
+  }
+  return std::make_unique<Blob>(id, std::move(contents));
+}
+
+bool LocalStore::shouldChunk(const Blob& blob) const {
+  return chunkedBlobMinSize_ > 0 && blob.getSize() >= chunkedBlobMinSize_;
+}
+
+std::optional<string> LocalStore::putBlobFile(
+    const ObjectId& id,
+    const Blob& blob) {
+#ifndef _WIN32
+  if (!blobFileCache_ || blob.getSize() < blobFileMinSize_) {
+    return std::nullopt;
+  }
+  try {
+    blobFileCache_->put(id, blob.getContents());
+  } catch (const std::exception& ex) {
+    XLOG(WARN) << "Storing blob " << id << " in the local store rather than "
+               << "in the blob file cache: " << folly::exceptionStr(ex);
+    return std::nullopt;
+  }
+  return BlobFileCache::makeMarker(blob.getSize());
+#else
+  (void)id;
+  (void)blob;
+  return std::nullopt;
+#endif
+}
+
+std::unique_ptr<Blob> LocalStore::loadBlobFile(
+    const ObjectId& id,
+    uint64_t size) const {
+#ifndef _WIN32
+  if (blobFileCache_) {
+    if (auto contents = blobFileCache_->get(id, size)) {
+      return std::make_unique<Blob>(id, std::move(*contents));
+    }
+  }
+#else
+  (void)size;
+#endif
+  XLOG(DBG3) << "file of blob " << id << " was evicted";
+  return nullptr;
+}
+
 ImmediateFuture<optional<BlobMetadata>> LocalStore::getBlobMetadata(
     const ObjectId& id) const {
+#ifndef _WIN32
+  if (blobMetadataIndex_) {
+    if (auto metadata = blobMetadataIndex_->get(id)) {
+      return metadata;
+    }
+  }
+#endif
+
   return getImmediateFuture(KeySpace::BlobMetaDataFamily, id)
-      .thenValue([id](StoreResult&& data) -> optional<BlobMetadata> {
+      .thenValue([id, index = blobMetadataIndex_](
+                     StoreResult&& data) -> optional<BlobMetadata> {
         if (!data.isValid()) {
           return std::nullopt;
-        } else {
-          return SerializedBlobMetadata::parse(id, data);
         }
+        auto metadata = SerializedBlobMetadata::parse(id, data);
+#ifndef _WIN32
+        if (index) {
+          // Populate the index with the metadata stored before it existed.
+          index->put(id, metadata);
+        }
+#endif
+        return metadata;
+      });
+}
+
+ImmediateFuture<std::vector<optional<BlobMetadata>>>
+LocalStore::getBlobMetadataBatch(const std::vector<ObjectId>& ids) const {
+  std::vector<optional<BlobMetadata>> results(ids.size());
+  std::vector<size_t> missing;
+  for (size_t i = 0; i < ids.size(); ++i) {
+#ifndef _WIN32
+    if (blobMetadataIndex_) {
+      results[i] = blobMetadataIndex_->get(ids[i]);
+    }
+#endif
+    if (!results[i]) {
+      missing.push_back(i);
+    }
+  }
+  if (missing.empty()) {
+    return results;
+  }
+
+  std::vector<ObjectId> missingIds;
+  std::vector<ByteRange> keys;
+  missingIds.reserve(missing.size());
+  keys.reserve(missing.size());
+  for (auto index : missing) {
+    missingIds.push_back(ids[index]);
+    keys.push_back(missingIds.back().getBytes());
+  }
+  return ImmediateFuture<std::vector<StoreResult>>{
+      getBatch(KeySpace::BlobMetaDataFamily, keys).semi()}
+      .thenValue([results = std::move(results),
+                  missing = std::move(missing),
+                  missingIds = std::move(missingIds),
+                  index = blobMetadataIndex_](
+                     std::vector<StoreResult>&& data) mutable {
+        XCHECK_EQ(data.size(), missing.size());
+        for (size_t i = 0; i < data.size(); ++i) {
+          if (!data[i].isValid()) {
+            continue;
+          }
+          auto metadata = SerializedBlobMetadata::parse(missingIds[i], data[i]);
+#ifndef _WIN32
+          if (index) {
+            index->put(missingIds[i], metadata);
+          }
+#endif
+          results[missing[i]] = metadata;
+        }
+        return std::move(results);
       });
 }
 
@@ -140,7 +307,20 @@ bool LocalStore::hasKey(KeySpace keySpace, const ObjectId& id) const {
   return hasKey(keySpace, id.getBytes());
 }
 
+bool LocalStore::forEachKey(
+    KeySpace /* keySpace */,
+    folly::FunctionRef<void(folly::ByteRange key)> /* fn */) const {
+  return false;
+}
+
+void LocalStore::recordStored(KeySpace keySpace, const ObjectId& id) {
+  if (auto* filter = getMissingObjectFilter(keySpace)) {
+    filter->recordStored(id.getBytes());
+  }
+}
+
 void LocalStore::putTree(const Tree& tree) {
+  recordStored(KeySpace::TreeFamily, tree.getHash());
   auto serialized = LocalStore::serializeTree(tree);
   ByteRange treeData = serialized.coalesce();
 
@@ -164,12 +344,123 @@ void LocalStore::putBlob(const ObjectId& id, const Blob* blob) {
     // Pre-allocate a buffer of approximately the right size; it
     // needs to hold the blob content plus have room for a couple of
     // hashes for the keys, plus some padding.
+    recordStored(KeySpace::BlobFamily, id);
+    if (auto marker = putBlobFile(id, *blob)) {
+      put(KeySpace::BlobFamily, id, StringPiece{*marker});
+      return;
+    }
     auto batch = beginWrite(blob->getSize() + 64);
-    batch->putBlob(id, blob);
+    if (shouldChunk(*blob)) {
+      auto chunked = chunkBlob(*blob, FastCdcChunker{});
+      for (const auto& chunk : chunked.chunks) {
+        batch->put(
+            KeySpace::BlobChunkFamily,
+            chunk.key.getBytes(),
+            ByteRange{chunk.contents.data(), chunk.contents.length()});
+      }
+      batch->put(KeySpace::BlobFamily, id, StringPiece{chunked.manifest});
+    } else {
+      batch->putBlob(id, blob);
+    }
     batch->flush();
   }
 }
 
+void LocalStore::queueTree(const Tree& tree) {
+  recordStored(KeySpace::TreeFamily, tree.getHash());
+  if (!writeQueue_ ||
+      !writeQueue_->put(
+          KeySpace::TreeFamily,
+          tree.getHash().getBytes(),
+          LocalStore::serializeTree(tree))) {
+    putTree(tree);
+  }
+}
+
+void LocalStore::queueBlob(const ObjectId& id, const Blob* blob) {
+  if (!writeQueue_ || !enableBlobCaching) {
+    putBlob(id, blob);
+    return;
+  }
+
+  // Same git-style blob prefix as WriteBatch::putBlob. The contents are
+  // shared with the blob rather than copied.
+  recordStored(KeySpace::BlobFamily, id);
+  // The file is written inline and only the marker is queued: the contents
+  // skip the queue, whose memory they would take up.
+  if (auto marker = putBlobFile(id, *blob)) {
+    if (!writeQueue_->put(
+            KeySpace::BlobFamily,
+            id.getBytes(),
+            IOBuf{IOBuf::COPY_BUFFER, *marker})) {
+      put(KeySpace::BlobFamily, id, StringPiece{*marker});
+    }
+    return;
+  }
+  if (shouldChunk(*blob)) {
+    // The manifest is queued last: a reader that finds it finds the chunks,
+    // unless the queue dropped them, in which case the blob is a miss.
+    auto chunked = chunkBlob(*blob, FastCdcChunker{});
+    for (auto& chunk : chunked.chunks) {
+      if (!writeQueue_->put(
+              KeySpace::BlobChunkFamily,
+              chunk.key.getBytes(),
+              std::move(chunk.contents))) {
+        putBlob(id, blob);
+        return;
+      }
+    }
+    if (!writeQueue_->put(
+            KeySpace::BlobFamily,
+            id.getBytes(),
+            IOBuf{IOBuf::COPY_BUFFER, chunked.manifest})) {
+      putBlob(id, blob);
+    }
+    return;
+  }
+
+  auto prefix = folly::to<string>("blob ", blob->getSize());
+  prefix.push_back('\0');
+  IOBuf value{IOBuf::COPY_BUFFER, prefix};
+  value.prependChain(blob->getContents().clone());
+  if (!writeQueue_->put(
+          KeySpace::BlobFamily, id.getBytes(), std::move(value))) {
+    putBlob(id, blob);
+  }
+}
+
+void LocalStore::queuePut(
+    KeySpace keySpace,
+    const ObjectId& id,
+    folly::ByteRange value) {
+  XCHECK(keySpace->isEphemeral())
+      << "Queued write to non-ephemeral keyspace " << keySpace->name;
+  if (!writeQueue_ ||
+      !writeQueue_->put(
+          keySpace, id.getBytes(), IOBuf{IOBuf::COPY_BUFFER, value})) {
+    put(keySpace, id, value);
+  }
+}
+
+void LocalStore::startWriteQueue(
+    size_t maxPendingBytes,
+    std::shared_ptr<EdenStats> stats) {
+  writeQueue_ = std::make_unique<LocalStoreWriteQueue>(
+      *this, maxPendingBytes, std::move(stats));
+}
+
+void LocalStore::stopWriteQueue() {
+  if (writeQueue_) {
+    writeQueue_->stop();
+  }
+}
+
+void LocalStore::flushWriteQueue() {
+  if (writeQueue_) {
+    writeQueue_->flush();
+  }
+}
+
 void LocalStore::putBlobMetadata(
     const ObjectId& id,
     const BlobMetadata& metadata) {
@@ -177,6 +468,11 @@ void LocalStore::putBlobMetadata(
   SerializedBlobMetadata metadataBytes(metadata);
 
   put(KeySpace::BlobMetaDataFamily, hashBytes, metadataBytes.slice());
+#ifndef _WIN32
+  if (blobMetadataIndex_) {
+    blobMetadataIndex_->put(id, metadata);
+  }
+#endif
 }
 
 void LocalStore::put(
@@ -221,6 +517,34 @@ void LocalStore::WriteBatch::putBlob(const ObjectId& id, const Blob* blob) {
   put(KeySpace::BlobFamily, hashSlice, bodySlices);
 }
 
+void LocalStore::enableMissingObjectFilters(
+    size_t bloomBits,
+    size_t missingEntries) {
+  for (const auto& keySpace : {KeySpace::TreeFamily, KeySpace::BlobFamily}) {
+    missingObjectFilters_[keySpace.index] =
+        std::make_unique<MissingObjectFilter>(bloomBits, missingEntries);
+  }
+}
+
+void LocalStore::refreshMissingObjectFilters() {
+  auto collections = getGarbageCollectionCount();
+  for (auto& ks : KeySpace::kAll) {
+    auto* filter = getMissingObjectFilter(ks);
+    if (!filter ||
+        (filter->isBuilt() &&
+         collections == missingFilterCollections_.load())) {
+      continue;
+    }
+    folly::stop_watch<std::chrono::milliseconds> watch;
+    filter->rebuild([&](folly::FunctionRef<void(ByteRange)> add) {
+      return forEachKey(ks, add);
+    });
+    XLOG(DBG2) << "built the missing object filter of " << ks->name << " in "
+               << watch.elapsed().count() << "ms";
+  }
+  missingFilterCollections_.store(collections);
+}
+
 LocalStore::WriteBatch::~WriteBatch() {}
 
 void LocalStore::periodicManagementTask(const EdenConfig& /* config */) {
@@ -7,10 +7,14 @@
 
 #pragma once
 
+#include <folly/Function.h>
 #include <folly/Range.h>
+#include <array>
 #include <atomic>
+#include <map>
 #include <memory>
 #include <optional>
+#include <string>
 #include "eden/fs/model/BlobMetadata.h"
 #include "eden/fs/model/ObjectId.h"
 #include "eden/fs/store/KeySpace.h"
@@ -25,7 +29,12 @@ class Future;
 namespace facebook::eden {
 
 class Blob;
+class BlobFileCache;
+class BlobMetadataIndex;
 class EdenConfig;
+class EdenStats;
+class LocalStoreWriteQueue;
+class MissingObjectFilter;
 class StoreResult;
 class Tree;
 class TreeMetadata;
@@ -50,7 +59,7 @@ class TreeMetadata;
 class LocalStore : public std::enable_shared_from_this<LocalStore> {
  public:
   LocalStore() = default;
-  virtual ~LocalStore() = default;
+  virtual ~LocalStore();
 
   /**
    * Open the underlying store. This must be called before calling any other
@@ -153,12 +162,44 @@ class LocalStore : public std::enable_shared_from_this<LocalStore> {
   ImmediateFuture<std::optional<BlobMetadata>> getBlobMetadata(
       const ObjectId& id) const;
 
+  /**
+   * Get the metadata of several blobs at once, ids missing from the store
+   * having std::nullopt at their position. The lookups that aren't served by
+   * the metadata index are done as a single getBatch().
+   */
+  ImmediateFuture<std::vector<std::optional<BlobMetadata>>>
+  getBlobMetadataBatch(const std::vector<ObjectId>& ids) const;
+
   /**
    * Test whether the key is stored.
    */
   virtual bool hasKey(KeySpace keySpace, folly::ByteRange key) const = 0;
   bool hasKey(KeySpace keySpace, const ObjectId& id) const;
 
+  /**
+   * Call fn with every key of the key space. Returns false, without calling
+   * fn, if the store can't enumerate its keys.
+   */
+  virtual bool forEachKey(
+      KeySpace keySpace,
+      folly::FunctionRef<void(folly::ByteRange key)> fn) const;
+
+  /**
+   * Number of garbage collections that finished, which may have evicted
+   * entries of the ephemeral key spaces.
+   */
+  virtual uint64_t getGarbageCollectionCount() const {
+    return 0;
+  }
+
+  /**
+   * The memory the store uses, in bytes, by kind, like "memtables". Empty if
+   * the store doesn't track it.
+   */
+  virtual std::map<std::string, uint64_t> getMemoryUsage() const {
+    return {};
+  }
+
   /**
    * Store a Tree into the TreeFamily KeySpace.
    */
@@ -174,6 +215,12 @@ class LocalStore : public std::enable_shared_from_this<LocalStore> {
    */
   void putBlobMetadata(const ObjectId& id, const BlobMetadata& metadata);
 
+  /**
+   * Store the blob metadata of every entry of a tree, in a single write
+   * batch. The metadata must be indexed by hash.
+   */
+  void putTreeMetadata(const TreeMetadata& metadata);
+
   /**
    * Put arbitrary data in the store.
    */
@@ -181,6 +228,37 @@ class LocalStore : public std::enable_shared_from_this<LocalStore> {
   put(KeySpace keySpace, folly::ByteRange key, folly::ByteRange value) = 0;
   void put(KeySpace keySpace, const ObjectId& id, folly::ByteRange value);
 
+  /**
+   * Like putTree(), putBlob() and put(), except that the value is written on
+   * the write queue's thread when one is started, and these return as soon
+   * as it is queued. Queued writes may be dropped or lost, they must thus
+   * only go to ephemeral key spaces.
+   */
+  void queueTree(const Tree& tree);
+  void queueBlob(const ObjectId& id, const Blob* blob);
+  void queuePut(KeySpace keySpace, const ObjectId& id, folly::ByteRange value);
+
+  /**
+   * Start a write queue holding up to maxPendingBytes bytes for the queue*
+   * methods. Until then, these write inline.
+   *
+   * Must be called before the LocalStore is used from multiple threads.
+   */
+  void startWriteQueue(
+      size_t maxPendingBytes,
+      std::shared_ptr<EdenStats> stats);
+
+  /**
+   * Commit the queued writes and have the queue* methods write inline from
+   * then on. Must be called before the LocalStore is closed.
+   */
+  void stopWriteQueue();
+
+  /**
+   * Return once the writes queued before the call are committed.
+   */
+  void flushWriteQueue();
+
   /*
    * WriteBatch is a helper class for facilitating a bulk store operation.
    *
@@ -254,6 +332,64 @@ class LocalStore : public std::enable_shared_from_this<LocalStore> {
 
   virtual void periodicManagementTask(const EdenConfig& config);
 
+  /**
+   * Track which trees and blobs are missing from the store, see
+   * getMissingObjectFilter(). The filters are built by the first
+   * refreshMissingObjectFilters() call.
+   *
+   * Must be called before the LocalStore is used from multiple threads.
+   */
+  void enableMissingObjectFilters(size_t bloomBits, size_t missingEntries);
+
+  /**
+   * The filter of the keys known to be missing from the key space, which the
+   * tree and blob writes of this LocalStore keep up to date. Null if the key
+   * space has none.
+   */
+  MissingObjectFilter* getMissingObjectFilter(KeySpace keySpace) const {
+    return missingObjectFilters_[keySpace->index].get();
+  }
+
+  /**
+   * Build the missing object filters if they weren't yet, or rebuild them if
+   * a garbage collection finished since, which scans the key spaces. Meant
+   * to be called periodically.
+   */
+  void refreshMissingObjectFilters();
+
+  /**
+   * Store the blobs of at least minSize bytes as content-defined chunks,
+   * see ChunkedBlob. Zero, the default, stores all blobs whole. Chunked
+   * blobs are read whatever the setting.
+   *
+   * Must be called before the LocalStore is used from multiple threads.
+   */
+  void setChunkedBlobMinSize(size_t minSize) {
+    chunkedBlobMinSize_ = minSize;
+  }
+
+  /**
+   * Store the blobs of at least minSize bytes as files of the given cache,
+   * keeping only a marker for them in the store, so that reading them maps
+   * their file instead of copying them out of the store.
+   *
+   * Must be called before the LocalStore is used from multiple threads.
+   */
+  void setBlobFileCache(std::shared_ptr<BlobFileCache> cache, size_t minSize) {
+    blobFileCache_ = std::move(cache);
+    blobFileMinSize_ = minSize;
+  }
+
+  /**
+   * Serve getBlobMetadata() from the given memory-mapped index before
+   * querying the store, and record all the blob metadata in it.
+   *
+   * Must be called before the LocalStore is used from multiple threads.
+   */
+  void setBlobMetadataIndex(std::shared_ptr<BlobMetadataIndex> index) {
+    blobMetadataIndex_ = std::move(index);
+  }
+
   /*
    * We keep this field to avoid making `LocalStore` holding a reference to
    * `EdenConfig`, which will require us to change all the subclasses. We update
@@ -272,6 +408,48 @@ class LocalStore : public std::enable_shared_from_this<LocalStore> {
    * two phase import.
    */
   static folly::IOBuf serializeTree(const Tree& tree);
+
+  void clearBlobMetadataIndex();
+
+  bool shouldChunk(const Blob& blob) const;
+
+  /**
+   * Write the blob to the blob file cache if it is large enough, and return
+   * the marker to store in its place. Returns std::nullopt if the blob must
+   * be stored as usual.
+   */
+  std::optional<std::string> putBlobFile(const ObjectId& id, const Blob& blob);
+
+  /**
+   * Map the blob of the given size from the blob file cache. Returns nullptr
+   * if it was evicted.
+   */
+  std::unique_ptr<Blob> loadBlobFile(const ObjectId& id, uint64_t size) const;
+
+  /**
+   * Assemble the blob from the chunks its manifest lists. Returns nullptr if
+   * some of them were evicted.
+   */
+  std::unique_ptr<Blob> loadChunkedBlob(
+      const ObjectId& id,
+      folly::ByteRange manifest) const;
+
+  /**
+   * Record in the key space's missing object filter, if any, that the id is
+   * about to be stored.
+   */
+  void recordStored(KeySpace keySpace, const ObjectId& id);
+
+  std::shared_ptr<BlobMetadataIndex> blobMetadataIndex_;
+  std::shared_ptr<BlobFileCache> blobFileCache_;
+  size_t blobFileMinSize_{0};
+  std::unique_ptr<LocalStoreWriteQueue> writeQueue_;
+  size_t chunkedBlobMinSize_{0};
+  // Indexed by key space, null for the key spaces without a filter.
+  std::array<std::unique_ptr<MissingObjectFilter>, KeySpace::kTotalCount>
+      missingObjectFilters_;
+  // getGarbageCollectionCount() when the filters were last built.
+  std::atomic<uint64_t> missingFilterCollections_{0};
 };
 
 } // namespace facebook::eden
@@ -9,6 +9,7 @@
 #include "eden/fs/model/Blob.h"
 #include "eden/fs/model/Tree.h"
 #include "eden/fs/store/LocalStore.h"
+#include "eden/fs/store/MissingObjectFilter.h"
 #include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/utils/ImmediateFuture.h"
 
@@ -39,12 +40,28 @@ LocalStoreCachedBackingStore::getRootTree(
         // TODO: perhaps this callback should use toUnsafeFuture() to ensure the
         // tree is cached whether or not the caller consumes the future.
         if (tree) {
-          localStore->putTree(*tree);
+          localStore->queueTree(*tree);
         }
         return tree;
       });
 }
 
+ImmediateFuture<std::vector<std::unique_ptr<Tree>>>
+LocalStoreCachedBackingStore::getRootTrees(
+    const std::vector<RootId>& rootIds,
+    const ObjectFetchContextPtr& context) {
+  return backingStore_->getRootTrees(rootIds, context)
+      .thenValue([localStore = localStore_](
+                     std::vector<std::unique_ptr<Tree>> trees) {
+        for (const auto& tree : trees) {
+          if (tree) {
+            localStore->queueTree(*tree);
+          }
+        }
+        return trees;
+      });
+}
+
 ImmediateFuture<std::unique_ptr<TreeEntry>>
 LocalStoreCachedBackingStore::getTreeEntryForObjectId(
     const ObjectId& objectId,
@@ -54,33 +71,78 @@ LocalStoreCachedBackingStore::getTreeEntryForObjectId(
       objectId, treeEntryType, context);
 }
 
+bool LocalStoreCachedBackingStore::isKnownMissing(
+    MissingObjectFilter* filter,
+    const ObjectId& id) const {
+  if (filter && filter->isKnownMissing(id.getBytes())) {
+    stats_->increment(&ObjectStoreStats::localStoreKnownMissing);
+    return true;
+  }
+  return false;
+}
+
+void LocalStoreCachedBackingStore::recordMissing(
+    MissingObjectFilter* filter,
+    EdenStats& stats,
+    const ObjectId& id) {
+  if (!filter) {
+    return;
+  }
+  if (filter->isBuilt()) {
+    stats.increment(&ObjectStoreStats::localStoreMissingFalsePositive);
+  }
+  // This may race with a concurrent import of the same object, leaving it
+  // known missing. Its next lookup then fetches and stores it again, which
+  // clears it.
+  filter->recordMissing(id.getBytes());
+}
+
+folly::SemiFuture<BackingStore::GetTreeResult>
+LocalStoreCachedBackingStore::fetchTree(
+    std::shared_ptr<BackingStore> backingStore,
+    std::shared_ptr<LocalStore> localStore,
+    const ObjectId& id,
+    const ObjectFetchContextPtr& context) {
+  return backingStore
+      ->getTree(id, context)
+      // TODO: This is a good use for toUnsafeFuture to ensure the tree is
+      // cached even if the resulting future is never consumed.
+      .deferValue([localStore = std::move(localStore)](GetTreeResult result) {
+        if (result.tree) {
+          localStore->queueTree(*result.tree);
+        }
+
+        return result;
+      });
+}
+
 folly::SemiFuture<BackingStore::GetTreeResult>
 LocalStoreCachedBackingStore::getTree(
     const ObjectId& id,
     const ObjectFetchContextPtr& context) {
+  auto* filter = localStore_->getMissingObjectFilter(KeySpace::TreeFamily);
+  if (isKnownMissing(filter, id)) {
+    return fetchTree(backingStore_, localStore_, id, context);
+  }
+
+  RequestPhaseScope phaseScope{context, RequestPhase::LocalStore};
   return localStore_->getTree(id)
       .thenValue([id = id,
                   context = context.copy(),
+                  phaseScope = std::move(phaseScope),
                   localStore = localStore_,
-                  backingStore =
-                      backingStore_](std::unique_ptr<Tree> tree) mutable {
+                  backingStore = backingStore_,
+                  stats = stats_,
+                  filter](std::unique_ptr<Tree> tree) mutable {
         if (tree) {
           return folly::makeSemiFuture(GetTreeResult{
               std::move(tree), ObjectFetchContext::FromDiskCache});
         }
 
-        return backingStore
-            ->getTree(id, context)
-            // TODO: This is a good use for toUnsafeFuture to ensure the tree is
-            // cached even if the resulting future is never consumed.
-            .deferValue(
-                [localStore = std::move(localStore)](GetTreeResult result) {
-                  if (result.tree) {
-                    localStore->putTree(*result.tree);
-                  }
-
-                  return result;
-                });
+        recordMissing(filter, *stats, id);
+        { auto localStoreDone = std::move(phaseScope); }
+        return fetchTree(
+            std::move(backingStore), std::move(localStore), id, context);
       })
       .semi();
 }
@@ -92,35 +154,60 @@ LocalStoreCachedBackingStore::getLocalBlobMetadata(
   return backingStore_->getLocalBlobMetadata(id, context);
 }
 
+folly::SemiFuture<BackingStore::GetBlobResult>
+LocalStoreCachedBackingStore::fetchBlob(
+    std::shared_ptr<BackingStore> backingStore,
+    std::shared_ptr<LocalStore> localStore,
+    std::shared_ptr<EdenStats> stats,
+    const ObjectId& id,
+    const ObjectFetchContextPtr& context) {
+  return backingStore
+      ->getBlob(id, context)
+      // TODO: This is a good use for toUnsafeFuture to ensure the tree is
+      // cached even if the resulting future is never consumed.
+      .deferValue([localStore = std::move(localStore),
+                   stats = std::move(stats),
+                   id](GetBlobResult result) {
+        if (result.blob) {
+          localStore->queueBlob(id, result.blob.get());
+          stats->increment(&ObjectStoreStats::getBlobFromBackingStore);
+        }
+        return result;
+      });
+}
+
 folly::SemiFuture<BackingStore::GetBlobResult>
 LocalStoreCachedBackingStore::getBlob(
     const ObjectId& id,
     const ObjectFetchContextPtr& context) {
+  auto* filter = localStore_->getMissingObjectFilter(KeySpace::BlobFamily);
+  if (isKnownMissing(filter, id)) {
+    return fetchBlob(backingStore_, localStore_, stats_, id, context);
+  }
+
+  RequestPhaseScope phaseScope{context, RequestPhase::LocalStore};
   return localStore_->getBlob(id)
       .thenValue([id = id,
                   context = context.copy(),
+                  phaseScope = std::move(phaseScope),
                   localStore = localStore_,
                   backingStore = backingStore_,
-                  stats = stats_](std::unique_ptr<Blob> blob) mutable {
+                  stats = stats_,
+                  filter](std::unique_ptr<Blob> blob) mutable {
         if (blob) {
           stats->increment(&ObjectStoreStats::getBlobFromLocalStore);
           return folly::makeSemiFuture(GetBlobResult{
               std::move(blob), ObjectFetchContext::FromDiskCache});
         }
 
-        return backingStore
-            ->getBlob(id, context)
-            // TODO: This is a good use for toUnsafeFuture to ensure the tree is
-            // cached even if the resulting future is never consumed.
-            .deferValue([localStore = std::move(localStore),
-                         stats = std::move(stats),
-                         id](GetBlobResult result) {
-              if (result.blob) {
-                localStore->putBlob(id, result.blob.get());
-                stats->increment(&ObjectStoreStats::getBlobFromBackingStore);
-              }
-              return result;
-            });
+        recordMissing(filter, *stats, id);
+        { auto localStoreDone = std::move(phaseScope); }
+        return fetchBlob(
+            std::move(backingStore),
+            std::move(localStore),
+            std::move(stats),
+            id,
+            context);
       })
       .semi();
 }
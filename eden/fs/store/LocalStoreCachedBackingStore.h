@@ -14,6 +14,7 @@ namespace facebook::eden {
 class BackingStore;
 class LocalStore;
 class EdenStats;
+class MissingObjectFilter;
 
 /**
  * Implementation of a BackingStore that caches the returned data from another
@@ -22,6 +23,9 @@ class EdenStats;
  * Reads will first attempt to read from the LocalStore, and will only read
  * from the underlying BackingStore if the data wasn't found in the LocalStore.
  *
+ * Objects that the LocalStore's MissingObjectFilter knows are missing are
+ * read from the underlying BackingStore right away.
+ *
  * This should be used for BackingStores that either do not have local caching
  * builtin, or when reading from this cache is significantly slower than
  * reading from the LocalStore.
@@ -41,6 +45,10 @@ class LocalStoreCachedBackingStore : public BackingStore {
       const RootId& rootId,
       const ObjectFetchContextPtr& context) override;
 
+  ImmediateFuture<std::vector<std::unique_ptr<Tree>>> getRootTrees(
+      const std::vector<RootId>& rootIds,
+      const ObjectFetchContextPtr& context) override;
+
   ImmediateFuture<std::unique_ptr<TreeEntry>> getTreeEntryForObjectId(
       const ObjectId& objectId,
       TreeEntryType treeEntryType,
@@ -93,6 +101,32 @@ class LocalStoreCachedBackingStore : public BackingStore {
   }
 
  private:
+  /**
+   * Whether the LocalStore lookup can be skipped, counting the skips.
+   */
+  bool isKnownMissing(MissingObjectFilter* filter, const ObjectId& id) const;
+
+  /**
+   * Record that the LocalStore lookup of id missed.
+   */
+  static void recordMissing(
+      MissingObjectFilter* filter,
+      EdenStats& stats,
+      const ObjectId& id);
+
+  static folly::SemiFuture<GetTreeResult> fetchTree(
+      std::shared_ptr<BackingStore> backingStore,
+      std::shared_ptr<LocalStore> localStore,
+      const ObjectId& id,
+      const ObjectFetchContextPtr& context);
+
+  static folly::SemiFuture<GetBlobResult> fetchBlob(
+      std::shared_ptr<BackingStore> backingStore,
+      std::shared_ptr<LocalStore> localStore,
+      std::shared_ptr<EdenStats> stats,
+      const ObjectId& id,
+      const ObjectFetchContextPtr& context);
+
   std::shared_ptr<BackingStore> backingStore_;
   std::shared_ptr<LocalStore> localStore_;
   std::shared_ptr<EdenStats> stats_;
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/LocalStoreWriteQueue.h"
+
+#include <folly/logging/xlog.h>
+#include <folly/system/ThreadName.h>
+
+#include "eden/fs/store/LocalStore.h"
+#include "eden/fs/telemetry/EdenStats.h"
+
+namespace facebook::eden {
+
+namespace {
+size_t writeSize(folly::ByteRange key, const folly::IOBuf& value) {
+  return key.size() + value.computeChainDataLength();
+}
+} // namespace
+
+LocalStoreWriteQueue::LocalStoreWriteQueue(
+    LocalStore& store,
+    size_t maxPendingBytes,
+    std::shared_ptr<EdenStats> stats)
+    : store_{store},
+      maxPendingBytes_{maxPendingBytes},
+      stats_{std::move(stats)} {
+  writerThread_ = std::thread{[this] {
+    folly::setThreadName("LocalStoreWrite");
+    writerLoop();
+  }};
+}
+
+LocalStoreWriteQueue::~LocalStoreWriteQueue() {
+  stop();
+}
+
+bool LocalStoreWriteQueue::put(
+    KeySpace keySpace,
+    folly::ByteRange key,
+    folly::IOBuf value) {
+  auto size = writeSize(key, value);
+  {
+    auto state = state_.lock();
+    if (state->stopRequested) {
+      return false;
+    }
+    if (state->pendingBytes + size > maxPendingBytes_) {
+      state.unlock();
+      droppedCount_.fetch_add(1, std::memory_order_relaxed);
+      stats_->increment(&ObjectStoreStats::localStoreWriteDropped);
+      XLOG(DBG4) << "Dropping a write to " << keySpace->name
+                 << ": the local store write queue is full";
+      return true;
+    }
+    state->writes.push_back(
+        Write{keySpace, std::string{key.begin(), key.end()}, std::move(value)});
+    state->pendingBytes += size;
+  }
+  workCV_.notify_one();
+  return true;
+}
+
+void LocalStoreWriteQueue::flush() {
+  auto state = state_.lock();
+  // The writes queued now are committed with the group after the one being
+  // committed, if any.
+  auto target = state->committedGroups + (state->committing ? 1 : 0) +
+      (state->writes.empty() ? 0 : 1);
+  committedCV_.wait(
+      state.as_lock(), [&] { return state->committedGroups >= target; });
+}
+
+void LocalStoreWriteQueue::stop() {
+  {
+    auto state = state_.lock();
+    if (state->stopRequested) {
+      return;
+    }
+    state->stopRequested = true;
+  }
+  workCV_.notify_one();
+  writerThread_.join();
+}
+
+size_t LocalStoreWriteQueue::getPendingBytes() const {
+  return state_.lock()->pendingBytes;
+}
+
+void LocalStoreWriteQueue::writerLoop() {
+  std::vector<Write> group;
+  for (;;) {
+    {
+      auto state = state_.lock();
+      workCV_.wait(state.as_lock(), [&] {
+        return !state->writes.empty() || state->stopRequested;
+      });
+      // The writes queued before the stop request are still committed.
+      if (state->writes.empty()) {
+        return;
+      }
+      group.swap(state->writes);
+      state->committing = true;
+    }
+
+    size_t groupBytes = 0;
+    for (const auto& write : group) {
+      groupBytes += writeSize(
+          folly::ByteRange{folly::StringPiece{write.key}}, write.value);
+    }
+    commit(group);
+    group.clear();
+
+    {
+      auto state = state_.lock();
+      state->pendingBytes -= groupBytes;
+      state->committing = false;
+      ++state->committedGroups;
+    }
+    committedCV_.notify_all();
+  }
+}
+
+void LocalStoreWriteQueue::commit(std::vector<Write>& group) {
+  try {
+    auto batch = store_.beginWrite();
+    for (auto& write : group) {
+      std::vector<folly::ByteRange> slices;
+      for (auto slice : write.value) {
+        slices.push_back(slice);
+      }
+      batch->put(
+          write.keySpace,
+          folly::ByteRange{folly::StringPiece{write.key}},
+          std::move(slices));
+    }
+    batch->flush();
+  } catch (const std::exception& ex) {
+    XLOG(ERR) << "Failed to write " << group.size()
+              << " values to the local store: " << folly::exceptionStr(ex);
+  }
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <folly/Synchronized.h>
+#include <folly/io/IOBuf.h>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "eden/fs/store/KeySpace.h"
+
+namespace facebook::eden {
+
+class EdenStats;
+class LocalStore;
+
+/**
+ * Writes values to a LocalStore on a dedicated thread, so that the threads
+ * importing objects can return them without waiting for the disk.
+ *
+ * All the writes that queue up while the writer thread is busy are
+ * committed together, in one WriteBatch. The queued values are bounded in
+ * bytes: a write that doesn't fit is dropped rather than waited for, and
+ * counted. Queued writes are only meant for data that can be fetched again,
+ * as they are lost if EdenFS dies before they are committed.
+ */
+class LocalStoreWriteQueue {
+ public:
+  LocalStoreWriteQueue(
+      LocalStore& store,
+      size_t maxPendingBytes,
+      std::shared_ptr<EdenStats> stats);
+  ~LocalStoreWriteQueue();
+
+  LocalStoreWriteQueue(const LocalStoreWriteQueue&) = delete;
+  LocalStoreWriteQueue& operator=(const LocalStoreWriteQueue&) = delete;
+  LocalStoreWriteQueue(LocalStoreWriteQueue&&) = delete;
+  LocalStoreWriteQueue& operator=(LocalStoreWriteQueue&&) = delete;
+
+  /**
+   * Queue a write of value, which may be a chain, under key.
+   *
+   * A write that doesn't fit in the queue is dropped and counted. Returns
+   * false only when the queue is stopped, in which case the caller is
+   * expected to write inline.
+   */
+  bool put(KeySpace keySpace, folly::ByteRange key, folly::IOBuf value);
+
+  /**
+   * Return once all the writes queued before the call are committed.
+   */
+  void flush();
+
+  /**
+   * Commit the queued writes and stop the writer thread. Later writes are
+   * refused. This must be called before the LocalStore is closed.
+   */
+  void stop();
+
+  /**
+   * Number of bytes of the writes that are not yet committed.
+   */
+  size_t getPendingBytes() const;
+
+  /**
+   * Number of writes dropped because the queue was full.
+   */
+  uint64_t getDroppedCount() const {
+    return droppedCount_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Write {
+    KeySpace keySpace;
+    std::string key;
+    folly::IOBuf value;
+  };
+
+  struct State {
+    std::vector<Write> writes;
+    // Bytes of the queued writes and of the ones being committed.
+    size_t pendingBytes{0};
+    // Incremented every time the writer thread committed a group of writes.
+    uint64_t committedGroups{0};
+    bool committing{false};
+    bool stopRequested{false};
+  };
+
+  void writerLoop();
+
+  /**
+   * Write the group in a single WriteBatch. Errors are logged and the group
+   * dropped: the values will be fetched again.
+   */
+  void commit(std::vector<Write>& group);
+
+  LocalStore& store_;
+  const size_t maxPendingBytes_;
+  const std::shared_ptr<EdenStats> stats_;
+  std::atomic<uint64_t> droppedCount_{0};
+
+  folly::Synchronized<State, std::mutex> state_;
+  // Encodes the condition !state_.writes.empty() || state_.stopRequested
+  std::condition_variable workCV_;
+  // Notified every time a group of writes is committed.
+  std::condition_variable committedCV_;
+  std::thread writerThread_;
+};
+
+} // namespace facebook::eden
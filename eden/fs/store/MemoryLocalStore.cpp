@@ -7,6 +7,7 @@
 
 #include "eden/fs/store/MemoryLocalStore.h"
 #include <folly/String.h>
+#include <folly/io/IOBuf.h>
 #include "eden/fs/store/StoreResult.h"
 
 namespace facebook::eden {
@@ -71,7 +72,8 @@ StoreResult MemoryLocalStore::get(KeySpace keySpace, folly::ByteRange key)
   if (it == (*store)[keySpace->index].end()) {
     return StoreResult::missing(keySpace, key);
   }
-  return StoreResult(std::string(it->second));
+  // Clones share the stored buffer rather than copying it.
+  return StoreResult(it->second);
 }
 
 bool MemoryLocalStore::hasKey(KeySpace keySpace, folly::ByteRange key) const {
@@ -80,12 +82,22 @@ bool MemoryLocalStore::hasKey(KeySpace keySpace, folly::ByteRange key) const {
   return it != (*store)[keySpace->index].end();
 }
 
+bool MemoryLocalStore::forEachKey(
+    KeySpace keySpace,
+    folly::FunctionRef<void(folly::ByteRange key)> fn) const {
+  auto store = storage_.rlock();
+  for (const auto& entry : (*store)[keySpace->index]) {
+    fn(StringPiece{entry.first});
+  }
+  return true;
+}
+
 void MemoryLocalStore::put(
     KeySpace keySpace,
     folly::ByteRange key,
     folly::ByteRange value) {
-  (*storage_.wlock())[keySpace->index][StringPiece(key)] =
-      StringPiece(value).str();
+  folly::IOBuf buf{folly::IOBuf::COPY_BUFFER, value};
+  (*storage_.wlock())[keySpace->index][StringPiece(key)] = std::move(buf);
 }
 
 std::unique_ptr<LocalStore::WriteBatch> MemoryLocalStore::beginWrite(size_t) {
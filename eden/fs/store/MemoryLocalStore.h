@@ -8,6 +8,7 @@
 #pragma once
 #include <folly/Synchronized.h>
 #include <folly/experimental/StringKeyedUnorderedMap.h>
+#include <folly/io/IOBuf.h>
 #include "eden/fs/store/LocalStore.h"
 
 namespace facebook::eden {
@@ -27,13 +28,17 @@ class MemoryLocalStore final : public LocalStore {
   void compactKeySpace(KeySpace keySpace) override;
   StoreResult get(KeySpace keySpace, folly::ByteRange key) const override;
   bool hasKey(KeySpace keySpace, folly::ByteRange key) const override;
+  bool forEachKey(
+      KeySpace keySpace,
+      folly::FunctionRef<void(folly::ByteRange key)> fn) const override;
   void put(KeySpace keySpace, folly::ByteRange key, folly::ByteRange value)
       override;
   std::unique_ptr<LocalStore::WriteBatch> beginWrite(
       size_t bufSize = 0) override;
 
  private:
-  folly::Synchronized<std::vector<folly::StringKeyedUnorderedMap<std::string>>>
+  /** Values are shared with the StoreResults returned by get(). */
+  folly::Synchronized<std::vector<folly::StringKeyedUnorderedMap<folly::IOBuf>>>
       storage_;
 };
 
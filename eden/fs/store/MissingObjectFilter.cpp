@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/MissingObjectFilter.h"
+
+#include <folly/hash/SpookyHashV2.h>
+#include <folly/lang/Bits.h>
+#include <algorithm>
+
+namespace facebook::eden {
+
+namespace {
+constexpr size_t kMinimumBits = 64;
+// About 2% of false positives with 8 bits per stored key.
+constexpr size_t kProbes = 4;
+} // namespace
+
+MissingObjectFilter::Bloom::Bloom(size_t bits)
+    : mask_{folly::nextPowTwo(std::max(bits, kMinimumBits)) - 1},
+      words_{new std::atomic<uint64_t>[(mask_ + 1) / 64]} {
+  for (size_t i = 0; i < (mask_ + 1) / 64; ++i) {
+    words_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+void MissingObjectFilter::Bloom::add(folly::ByteRange key) noexcept {
+  uint64_t h1 = 0;
+  uint64_t h2 = 0;
+  folly::hash::SpookyHashV2::Hash128(key.data(), key.size(), &h1, &h2);
+  for (size_t i = 0; i < kProbes; ++i) {
+    auto bit = (h1 + i * h2) & mask_;
+    auto& word = words_[bit / 64];
+    uint64_t flag = uint64_t{1} << (bit % 64);
+    if ((word.load(std::memory_order_relaxed) & flag) == 0) {
+      word.fetch_or(flag, std::memory_order_relaxed);
+    }
+  }
+}
+
+bool MissingObjectFilter::Bloom::mayContain(
+    folly::ByteRange key) const noexcept {
+  uint64_t h1 = 0;
+  uint64_t h2 = 0;
+  folly::hash::SpookyHashV2::Hash128(key.data(), key.size(), &h1, &h2);
+  for (size_t i = 0; i < kProbes; ++i) {
+    auto bit = (h1 + i * h2) & mask_;
+    uint64_t flag = uint64_t{1} << (bit % 64);
+    if ((words_[bit / 64].load(std::memory_order_relaxed) & flag) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+MissingObjectFilter::MissingObjectFilter(
+    size_t bloomBits,
+    size_t missingEntries)
+    : bloomBits_{bloomBits}, missing_{folly::in_place, missingEntries} {}
+
+bool MissingObjectFilter::isKnownMissing(folly::ByteRange key) const {
+  {
+    auto bloom = bloom_.rlock();
+    if (bloom->current && !bloom->current->mayContain(key)) {
+      return true;
+    }
+  }
+  auto missing = missing_.lock();
+  return missing->find(std::string{folly::StringPiece{key}}) != missing->end();
+}
+
+bool MissingObjectFilter::isBuilt() const {
+  return bloom_.rlock()->current != nullptr;
+}
+
+void MissingObjectFilter::recordStored(folly::ByteRange key) {
+  {
+    auto bloom = bloom_.rlock();
+    if (bloom->current) {
+      bloom->current->add(key);
+    }
+    if (bloom->next) {
+      bloom->next->add(key);
+    }
+  }
+  missing_.lock()->erase(std::string{folly::StringPiece{key}});
+}
+
+void MissingObjectFilter::recordMissing(folly::ByteRange key) {
+  missing_.lock()->set(std::string{folly::StringPiece{key}}, true);
+}
+
+void MissingObjectFilter::rebuild(
+    folly::FunctionRef<bool(folly::FunctionRef<void(folly::ByteRange)>)>
+        scan) {
+  Bloom* next = nullptr;
+  {
+    auto bloom = bloom_.wlock();
+    if (bloom->next) {
+      // Another rebuild is in progress.
+      return;
+    }
+    bloom->next = std::make_unique<Bloom>(bloomBits_);
+    next = bloom->next.get();
+  }
+
+  // Only this rebuild replaces bloom_->next, the pointer stays valid.
+  bool scanned = false;
+  try {
+    scanned = scan([next](folly::ByteRange key) { next->add(key); });
+  } catch (...) {
+    bloom_.wlock()->next.reset();
+    throw;
+  }
+
+  auto bloom = bloom_.wlock();
+  if (scanned) {
+    bloom->current = std::move(bloom->next);
+  } else {
+    bloom->next.reset();
+  }
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Function.h>
+#include <folly/Range.h>
+#include <folly/SharedMutex.h>
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace facebook::eden {
+
+/**
+ * Tells whether a key of one LocalStore key space is known not to be stored,
+ * so that lookups of missing objects don't have to probe the store.
+ *
+ * Two structures answer the question:
+ * - a bloom filter of the keys that are stored, which rules out most of the
+ *   keys that aren't. It is only usable once built from a scan of the key
+ *   space, and rebuilt after garbage collections, as the evicted keys keep
+ *   their bits until then.
+ * - a small LRU of the keys that were recently looked up and missing, which
+ *   catches the repeated lookups of an object that can't be fetched even
+ *   when the bloom filter can't rule it out.
+ *
+ * Every write to the key space must be recorded with recordStored() before
+ * it is visible in the store. Missing a write would make its key look
+ * missing.
+ *
+ * This class is thread safe.
+ */
+class MissingObjectFilter {
+ public:
+  /**
+   * The bloom filter has bloomBits bits, rounded up to a power of two, and
+   * the LRU holds up to missingEntries keys.
+   */
+  MissingObjectFilter(size_t bloomBits, size_t missingEntries);
+
+  MissingObjectFilter(const MissingObjectFilter&) = delete;
+  MissingObjectFilter& operator=(const MissingObjectFilter&) = delete;
+
+  /**
+   * Return whether the key is known not to be stored.
+   */
+  bool isKnownMissing(folly::ByteRange key) const;
+
+  /**
+   * Return whether the bloom filter was built. Until then, only the keys
+   * recorded as missing are known to be missing.
+   */
+  bool isBuilt() const;
+
+  /**
+   * Record that the key is about to be stored.
+   */
+  void recordStored(folly::ByteRange key);
+
+  /**
+   * Record that a lookup of the key found nothing.
+   */
+  void recordMissing(folly::ByteRange key);
+
+  /**
+   * Build a new bloom filter of the keys that scan passes to its argument,
+   * and of the ones recorded as stored meanwhile. Keeps the current filter
+   * if scan returns false.
+   */
+  void rebuild(
+      folly::FunctionRef<bool(folly::FunctionRef<void(folly::ByteRange)>)>
+          scan);
+
+ private:
+  class Bloom {
+   public:
+    explicit Bloom(size_t bits);
+
+    void add(folly::ByteRange key) noexcept;
+    bool mayContain(folly::ByteRange key) const noexcept;
+
+   private:
+    size_t mask_;
+    std::unique_ptr<std::atomic<uint64_t>[]> words_;
+  };
+
+  using MissingKeys = folly::EvictingCacheMap<std::string, bool>;
+
+  struct BloomState {
+    // Null until the first build.
+    std::unique_ptr<Bloom> current;
+    // The filter being built, which also gets the concurrent writes.
+    std::unique_ptr<Bloom> next;
+  };
+
+  const size_t bloomBits_;
+  // Bits are set under a read lock, the blooms are only swapped under the
+  // write lock.
+  folly::Synchronized<BloomState, folly::SharedMutex> bloom_;
+  // The lookups reorder the LRU list, they thus need an exclusive lock.
+  mutable folly::Synchronized<MissingKeys, std::mutex> missing_;
+};
+
+} // namespace facebook::eden
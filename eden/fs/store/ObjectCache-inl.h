@@ -6,7 +6,9 @@
  */
 
 #include <folly/MapUtil.h>
+#include <folly/lang/Assume.h>
 #include <folly/logging/xlog.h>
+#include <algorithm>
 #include <utility>
 
 #include "eden/fs/store/ObjectCache.h"
@@ -61,20 +63,73 @@ template <typename ObjectType, ObjectCacheFlavor Flavor>
 std::shared_ptr<ObjectCache<ObjectType, Flavor>>
 ObjectCache<ObjectType, Flavor>::create(
     size_t maximumCacheSizeBytes,
-    size_t minimumEntryCount) {
+    size_t minimumEntryCount,
+    size_t shardCount,
+    CacheEvictionPolicy evictionPolicy) {
   // Allow make_shared with private constructor.
   struct OC : ObjectCache<ObjectType, Flavor> {
-    OC(size_t x, size_t y) : ObjectCache<ObjectType, Flavor>{x, y} {}
+    OC(size_t x, size_t y, size_t z, CacheEvictionPolicy p)
+        : ObjectCache<ObjectType, Flavor>{x, y, z, p} {}
   };
-  return std::make_shared<OC>(maximumCacheSizeBytes, minimumEntryCount);
+  return std::make_shared<OC>(
+      maximumCacheSizeBytes, minimumEntryCount, shardCount, evictionPolicy);
 }
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 ObjectCache<ObjectType, Flavor>::ObjectCache(
     size_t maximumCacheSizeBytes,
-    size_t minimumEntryCount)
+    size_t minimumEntryCount,
+    size_t shardCount,
+    CacheEvictionPolicy evictionPolicy)
     : maximumCacheSizeBytes_{maximumCacheSizeBytes},
-      minimumEntryCount_{minimumEntryCount} {}
+      minimumEntryCount_{minimumEntryCount},
+      shardCount_{std::max<size_t>(shardCount, 1)},
+      evictionPolicy_{evictionPolicy},
+      shards_{std::make_unique<Shard[]>(shardCount_)} {
+  // The byte budgets of all the shards add up to maximumCacheSizeBytes. The
+  // minimum entry count is rounded up per shard so that a cache configured to
+  // always keep at least one (possibly oversized) object keeps doing so
+  // regardless of which shard that object lands in.
+  const auto bytesPerShard = maximumCacheSizeBytes_ / shardCount_;
+  const auto bytesRemainder = maximumCacheSizeBytes_ % shardCount_;
+  const auto minimumEntriesPerShard =
+      (minimumEntryCount_ + shardCount_ - 1) / shardCount_;
+  for (size_t i = 0; i < shardCount_; ++i) {
+    auto state = shards_[i].state.lock();
+    state->evictionPolicy = evictionPolicy_;
+    state->maximumSizeBytes = bytesPerShard + (i < bytesRemainder ? 1 : 0);
+    state->minimumEntryCount = minimumEntriesPerShard;
+
+    switch (evictionPolicy_) {
+      case CacheEvictionPolicy::LRU:
+        state->windowMaximumSizeBytes = state->maximumSizeBytes;
+        break;
+      case CacheEvictionPolicy::SLRU:
+        state->protectedMaximumSizeBytes = state->maximumSizeBytes / 5 * 4;
+        break;
+      case CacheEvictionPolicy::TinyLFU: {
+        // As recommended by the W-TinyLFU paper: a 1% admission window, and
+        // 80% of the remaining space for the protected segment.
+        state->windowMaximumSizeBytes = state->maximumSizeBytes / 100;
+        auto mainSize = state->maximumSizeBytes - state->windowMaximumSizeBytes;
+        state->protectedMaximumSizeBytes = mainSize / 5 * 4;
+        state->frequencySketch = FrequencySketch{std::max(
+            state->maximumSizeBytes / kFrequencySketchBytesPerEntry,
+            state->minimumEntryCount)};
+        break;
+      }
+    }
+  }
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+typename ObjectCache<ObjectType, Flavor>::Shard&
+ObjectCache<ObjectType, Flavor>::getShard(const ObjectId& hash) const noexcept {
+  if (shardCount_ == 1) {
+    return shards_[0];
+  }
+  return shards_[hash.getHashCode() % shardCount_];
+}
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 template <ObjectCacheFlavor F>
@@ -90,7 +145,7 @@ ObjectCache<ObjectType, Flavor>::getInterestHandle(
   // runs after the lock is released.
   ObjectInterestHandle<ObjectType> interestHandle;
 
-  auto state = state_.lock();
+  auto state = getShard(hash).state.lock();
 
   auto item = getImpl(hash, *state);
   if (!item) {
@@ -129,7 +184,7 @@ typename std::enable_if_t<
     typename ObjectCache<ObjectType, Flavor>::ObjectPtr>
 ObjectCache<ObjectType, Flavor>::getSimple(const ObjectId& hash) {
   XLOG(DBG6) << "BlobCache::getSimple " << hash;
-  auto state = state_.lock();
+  auto state = getShard(hash).state.lock();
 
   if (auto item = getImpl(hash, *state)) {
     return item->object;
@@ -141,6 +196,10 @@ template <typename ObjectType, ObjectCacheFlavor Flavor>
 typename ObjectCache<ObjectType, Flavor>::CacheItem*
 ObjectCache<ObjectType, Flavor>::getImpl(const ObjectId& hash, State& state) {
   XLOG(DBG6) << "ObjectCache::getImpl " << hash;
+  // Misses count towards the frequency too: the object is likely to be
+  // inserted right after being fetched.
+  state.frequencySketch.increment(hash);
+
   auto* item = folly::get_ptr(state.items, hash);
   if (!item) {
     XLOG(DBG6) << "ObjectCache::getImpl missed";
@@ -151,10 +210,7 @@ ObjectCache<ObjectType, Flavor>::getImpl(const ObjectId& hash, State& state) {
 
     // TODO: Should we avoid promoting if interest is UnlikelyNeededAgain?
     // For now, we'll try not to be too clever.
-    state.evictionQueue.splice(
-        state.evictionQueue.end(),
-        state.evictionQueue,
-        state.evictionQueue.iterator_to(*item));
+    touch(state, *item);
     ++state.hitCount;
   }
 
@@ -190,7 +246,7 @@ ObjectCache<ObjectType, Flavor>::insertInterestHandle(
 
   XLOG(DBG6) << "  creating entry with generation=" << cacheItemGeneration;
 
-  auto state = state_.lock();
+  auto state = getShard(object->getHash()).state.lock();
   auto [item, inserted] = insertImpl(std::move(object), *state);
   switch (interest) {
     case Interest::UnlikelyNeededAgain:
@@ -219,7 +275,7 @@ typename std::enable_if_t<F == ObjectCacheFlavor::Simple, void>
 ObjectCache<ObjectType, Flavor>::insertSimple(
     ObjectCache<ObjectType, Flavor>::ObjectPtr object) {
   XLOG(DBG6) << "ObjectCache::insertSimple " << object->getHash();
-  auto state = state_.lock();
+  auto state = getShard(object->getHash()).state.lock();
   insertImpl(std::move(object), *state);
 }
 
@@ -238,8 +294,12 @@ ObjectCache<ObjectType, Flavor>::insertImpl(ObjectPtr object, State& state) {
 
   auto* itemPtr = &iter->second;
   if (inserted) {
+    // SLRU has no window: new objects start on probation.
+    auto segment = state.evictionPolicy == CacheEvictionPolicy::SLRU
+        ? Segment::Probation
+        : Segment::Window;
     try {
-      state.evictionQueue.push_back(*itemPtr);
+      link(state, *itemPtr, segment);
     } catch (const std::exception&) {
       state.items.erase(iter);
       throw;
@@ -247,49 +307,113 @@ ObjectCache<ObjectType, Flavor>::insertImpl(ObjectPtr object, State& state) {
     state.totalSize += size;
     evictUntilFits(state);
   } else {
-    state.evictionQueue.splice(
-        state.evictionQueue.end(),
-        state.evictionQueue,
-        state.evictionQueue.iterator_to(*itemPtr));
+    touch(state, *itemPtr);
   }
   return std::make_pair(itemPtr, inserted);
 }
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 bool ObjectCache<ObjectType, Flavor>::contains(const ObjectId& hash) const {
-  auto state = state_.lock();
+  auto state = getShard(hash).state.lock();
   return 1 == state->items.count(hash);
 }
 
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+bool ObjectCache<ObjectType, Flavor>::remove(const ObjectId& hash) {
+  XLOG(DBG6) << "ObjectCache::remove " << hash;
+  auto state = getShard(hash).state.lock();
+  auto* item = folly::get_ptr(state->items, hash);
+  if (!item) {
+    return false;
+  }
+  ++state->dropCount;
+  evictItem(*state, *item);
+  return true;
+}
+
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 void ObjectCache<ObjectType, Flavor>::clear() {
   XLOG(DBG6) << "ObjectCache::clear";
-  auto state = state_.lock();
-  state->totalSize = 0;
-  state->evictionQueue.clear();
-  state->items.clear();
+  for (size_t i = 0; i < shardCount_; ++i) {
+    auto state = shards_[i].state.lock();
+    state->totalSize = 0;
+    state->windowSize = 0;
+    state->probationSize = 0;
+    state->protectedSize = 0;
+    state->evictionQueue.clear();
+    state->probationQueue.clear();
+    state->protectedQueue.clear();
+    state->items.clear();
+  }
 }
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 typename ObjectCache<ObjectType, Flavor>::Stats
 ObjectCache<ObjectType, Flavor>::getStats() const {
-  auto state = state_.lock();
   Stats stats;
-  stats.objectCount = state->items.size();
-  stats.totalSizeInBytes = state->totalSize;
-  stats.hitCount = state->hitCount;
-  stats.missCount = state->missCount;
-  stats.evictionCount = state->evictionCount;
-  stats.dropCount = state->dropCount;
+  stats.shards.reserve(shardCount_);
+  for (size_t i = 0; i < shardCount_; ++i) {
+    auto state = shards_[i].state.lock();
+    ShardStats shardStats;
+    shardStats.objectCount = state->items.size();
+    shardStats.totalSizeInBytes = state->totalSize;
+    shardStats.evictionCount = state->evictionCount;
+    shardStats.dropCount = state->dropCount;
+
+    stats.objectCount += shardStats.objectCount;
+    stats.totalSizeInBytes += shardStats.totalSizeInBytes;
+    stats.hitCount += state->hitCount;
+    stats.missCount += state->missCount;
+    stats.evictionCount += shardStats.evictionCount;
+    stats.dropCount += shardStats.dropCount;
+    stats.shards.push_back(shardStats);
+  }
   return stats;
 }
 
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+std::vector<ObjectId> ObjectCache<ObjectType, Flavor>::getHotObjectIds(
+    size_t maxCount) const {
+  std::vector<std::vector<ObjectId>> shardIds;
+  shardIds.reserve(shardCount_);
+  for (size_t i = 0; i < shardCount_; ++i) {
+    auto state = shards_[i].state.lock();
+    auto& ids = shardIds.emplace_back();
+    ids.reserve(std::min(maxCount, state->items.size()));
+    for (const auto* queue :
+         {&state->protectedQueue,
+          &state->evictionQueue,
+          &state->probationQueue}) {
+      for (auto it = queue->rbegin();
+           it != queue->rend() && ids.size() < maxCount;
+           ++it) {
+        ids.push_back(it->object->getHash());
+      }
+    }
+  }
+
+  std::vector<ObjectId> result;
+  for (size_t rank = 0; result.size() < maxCount; ++rank) {
+    bool found = false;
+    for (const auto& ids : shardIds) {
+      if (rank < ids.size() && result.size() < maxCount) {
+        result.push_back(ids[rank]);
+        found = true;
+      }
+    }
+    if (!found) {
+      break;
+    }
+  }
+  return result;
+}
+
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 void ObjectCache<ObjectType, Flavor>::dropInterestHandle(
     const ObjectId& hash,
     uint64_t generation) noexcept {
   XLOG(DBG6) << "dropInterestHandle " << hash << " generation=" << generation;
-  auto state = state_.lock();
+  auto state = getShard(hash).state.lock();
 
   auto* item = folly::get_ptr(state->items, hash);
   if (!item) {
@@ -311,40 +435,158 @@ void ObjectCache<ObjectType, Flavor>::dropInterestHandle(
   }
 
   if (--item->referenceCount == 0) {
-    state->evictionQueue.erase(state->evictionQueue.iterator_to(*item));
     ++state->dropCount;
     evictItem(*state, *item);
   }
 }
 
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+typename ObjectCache<ObjectType, Flavor>::Queue&
+ObjectCache<ObjectType, Flavor>::getQueue(
+    State& state,
+    Segment segment) noexcept {
+  switch (segment) {
+    case Segment::Window:
+      return state.evictionQueue;
+    case Segment::Probation:
+      return state.probationQueue;
+    case Segment::Protected:
+      return state.protectedQueue;
+  }
+  folly::assume_unreachable();
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+size_t& ObjectCache<ObjectType, Flavor>::getSegmentSize(
+    State& state,
+    Segment segment) noexcept {
+  switch (segment) {
+    case Segment::Window:
+      return state.windowSize;
+    case Segment::Probation:
+      return state.probationSize;
+    case Segment::Protected:
+      return state.protectedSize;
+  }
+  folly::assume_unreachable();
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+void ObjectCache<ObjectType, Flavor>::link(
+    State& state,
+    CacheItem& item,
+    Segment segment) noexcept {
+  item.segment = segment;
+  getQueue(state, segment).push_back(item);
+  getSegmentSize(state, segment) += item.object->getSizeBytes();
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+void ObjectCache<ObjectType, Flavor>::unlink(
+    State& state,
+    CacheItem& item) noexcept {
+  auto& queue = getQueue(state, item.segment);
+  queue.erase(queue.iterator_to(item));
+  getSegmentSize(state, item.segment) -= item.object->getSizeBytes();
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+void ObjectCache<ObjectType, Flavor>::touch(
+    State& state,
+    CacheItem& item) noexcept {
+  switch (item.segment) {
+    case Segment::Window:
+    case Segment::Protected: {
+      auto& queue = getQueue(state, item.segment);
+      queue.splice(queue.end(), queue, queue.iterator_to(item));
+      break;
+    }
+    case Segment::Probation:
+      // A second access promotes the object. Demote the least recently used
+      // protected objects to make room, but never the promoted object itself.
+      unlink(state, item);
+      link(state, item, Segment::Protected);
+      while (state.protectedSize > state.protectedMaximumSizeBytes &&
+             state.protectedQueue.size() > 1) {
+        auto& demoted = state.protectedQueue.front();
+        unlink(state, demoted);
+        link(state, demoted, Segment::Probation);
+      }
+      break;
+  }
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+void ObjectCache<ObjectType, Flavor>::admitFromWindow(State& state) noexcept {
+  const auto mainMaximumSizeBytes =
+      state.maximumSizeBytes - state.windowMaximumSizeBytes;
+  // Never consider the most recently inserted object, which is at the back of
+  // the window: the caller still holds a pointer to it.
+  while (state.windowSize > state.windowMaximumSizeBytes &&
+         state.evictionQueue.size() > 1) {
+    auto& candidate = state.evictionQueue.front();
+    auto candidateSize = candidate.object->getSizeBytes();
+
+    CacheItem* victim = nullptr;
+    if (!state.probationQueue.empty()) {
+      victim = &state.probationQueue.front();
+    } else if (!state.protectedQueue.empty()) {
+      victim = &state.protectedQueue.front();
+    }
+
+    bool admit = victim == nullptr ||
+        state.probationSize + state.protectedSize + candidateSize <=
+            mainMaximumSizeBytes ||
+        state.items.size() <= state.minimumEntryCount ||
+        state.frequencySketch.estimate(candidate.object->getHash()) >
+            state.frequencySketch.estimate(victim->object->getHash());
+    if (admit) {
+      // If the main segment overflows, evictUntilFits will evict the victim.
+      unlink(state, candidate);
+      link(state, candidate, Segment::Probation);
+    } else {
+      ++state.evictionCount;
+      evictItem(state, candidate);
+    }
+  }
+}
+
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 void ObjectCache<ObjectType, Flavor>::evictUntilFits(State& state) noexcept {
   XLOG(DBG6) << "ObjectCache::evictUntilFits "
              << "state.totalSize=" << state.totalSize
-             << ", maximumCacheSizeBytes_=" << maximumCacheSizeBytes_
+             << ", state.maximumSizeBytes=" << state.maximumSizeBytes
              << ", evictionQueue.size()=" << state.evictionQueue.size()
-             << ", minimumEntryCount_=" << minimumEntryCount_;
-  while (state.totalSize > maximumCacheSizeBytes_ &&
-         state.evictionQueue.size() > minimumEntryCount_) {
+             << ", state.minimumEntryCount=" << state.minimumEntryCount;
+  if (state.evictionPolicy == CacheEvictionPolicy::TinyLFU) {
+    admitFromWindow(state);
+  }
+  while (state.totalSize > state.maximumSizeBytes &&
+         state.items.size() > state.minimumEntryCount) {
     evictOne(state);
   }
 }
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 void ObjectCache<ObjectType, Flavor>::evictOne(State& state) noexcept {
-  const auto& front = state.evictionQueue.front();
-  state.evictionQueue.pop_front();
+  Queue* queue = &state.evictionQueue;
+  if (!state.probationQueue.empty()) {
+    queue = &state.probationQueue;
+  } else if (!state.protectedQueue.empty()) {
+    queue = &state.protectedQueue;
+  }
   ++state.evictionCount;
-  evictItem(state, front);
+  evictItem(state, queue->front());
 }
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 void ObjectCache<ObjectType, Flavor>::evictItem(
     State& state,
-    const CacheItem& item) noexcept {
+    CacheItem& item) noexcept {
   XLOG(DBG6) << "ObjectCache::evictItem "
              << "evicting " << item.object->getHash()
              << " generation=" << item.generation;
+  unlink(state, item);
   auto size = item.object->getSizeBytes();
   // TODO: Releasing this ObjectPtr here can run arbitrary deleters which
   // could, in theory, try to reacquire the ObjectCache's lock. The object
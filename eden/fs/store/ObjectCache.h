@@ -10,16 +10,24 @@
 #include <folly/IntrusiveList.h>
 #include <folly/Synchronized.h>
 #include <folly/container/F14Map.h>
+#include <folly/lang/Align.h>
 #include <folly/synchronization/DistributedMutex.h>
 #include <list>
+#include <memory>
 #include <mutex>
+#include <vector>
 
+#include "eden/fs/config/CacheEvictionPolicy.h"
 #include "eden/fs/model/ObjectId.h"
+#include "eden/fs/store/FrequencySketch.h"
+#include "eden/fs/telemetry/LockContention.h"
 
 namespace facebook::eden {
 
 enum class ObjectCacheFlavor { Simple, InterestHandle };
 
+inline constexpr char kObjectCacheLockSite[] = "object_cache";
+
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 class ObjectCache;
 
@@ -78,7 +86,7 @@ class ObjectInterestHandle {
 };
 
 /**
- * An in-memory LRU cache for loaded objects. It is parameterized by both a
+ * An in-memory cache for loaded objects. It is parameterized by both a
  * maximum cache size and a minimum entry count. The cache tries to evict
  * entries when the total number of loaded objects exceeds the maximum cache
  * size, except that it always keeps the minimum entry count around.
@@ -97,10 +105,21 @@ class ObjectInterestHandle {
  * handles do not prevent entries from being evicted from the cache, but a lack
  * of InterestHandles for an object can mean it is evicted early.
  *
+ * Which entries are evicted is decided by a CacheEvictionPolicy. The default
+ * is a plain LRU; the SLRU and TinyLFU policies protect frequently used
+ * objects from being flushed out by a scan of objects that are only read once.
+ *
  * This class is not intended to be used directly, instead child classes should
  * be used that only allow clients to use one flavor of get and insert. See
  * BlobCache and TreeCache for examples of each flavor.
  *
+ * The cache may optionally be split into a number of independent shards, each
+ * with its own lock, LRU and index. Objects are assigned to a shard based on
+ * the hash of their ObjectId, and the maximum cache size and minimum entry
+ * count are divided between the shards. Sharding reduces lock contention when
+ * many threads hit the cache concurrently, at the cost of the LRU ordering
+ * being per-shard rather than global.
+ *
  * It is safe to use this object from arbitrary threads.
  */
 template <typename ObjectType, ObjectCacheFlavor Flavor>
@@ -138,6 +157,13 @@ class ObjectCache
     ObjectInterestHandle<ObjectType> interestHandle;
   };
 
+  struct ShardStats {
+    size_t objectCount{0};
+    size_t totalSizeInBytes{0};
+    uint64_t evictionCount{0};
+    uint64_t dropCount{0};
+  };
+
   struct Stats {
     size_t objectCount{0};
     size_t totalSizeInBytes{0};
@@ -145,11 +171,21 @@ class ObjectCache
     uint64_t missCount{0};
     uint64_t evictionCount{0};
     uint64_t dropCount{0};
+
+    /// One entry per shard, in shard order. The totals above are the sum of
+    /// these.
+    std::vector<ShardStats> shards;
   };
 
+  /**
+   * Create an ObjectCache. shardCount is clamped to at least 1; a single shard
+   * behaves as one global cache.
+   */
   static std::shared_ptr<ObjectCache<ObjectType, Flavor>> create(
       size_t maximumCacheSizeBytes,
-      size_t minimumEntryCount);
+      size_t minimumEntryCount,
+      size_t shardCount = 1,
+      CacheEvictionPolicy evictionPolicy = CacheEvictionPolicy::LRU);
   ~ObjectCache() {
     clear();
   }
@@ -214,6 +250,13 @@ class ObjectCache
    */
   bool contains(const ObjectId& hash) const;
 
+  /**
+   * Evicts the object for the given hash, whatever its reference count, and
+   * returns whether it was cached. Dropping the interest handles on it then
+   * does nothing.
+   */
+  bool remove(const ObjectId& hash);
+
   /**
    * Evicts everything from cache.
    */
@@ -225,8 +268,26 @@ class ObjectCache
    */
   Stats getStats() const;
 
+  /**
+   * Returns the ids of up to maxCount cached objects, hottest first: the
+   * protected ones, then the most recently used. The shards are interleaved.
+   */
+  std::vector<ObjectId> getHotObjectIds(size_t maxCount) const;
+
+  size_t getShardCount() const {
+    return shardCount_;
+  }
+
+  CacheEvictionPolicy getEvictionPolicy() const {
+    return evictionPolicy_;
+  }
+
  protected:
-  explicit ObjectCache(size_t maximumCacheSizeBytes, size_t minimumEntryCount);
+  explicit ObjectCache(
+      size_t maximumCacheSizeBytes,
+      size_t minimumEntryCount,
+      size_t shardCount = 1,
+      CacheEvictionPolicy evictionPolicy = CacheEvictionPolicy::LRU);
 
  private:
   /*
@@ -240,6 +301,12 @@ class ObjectCache
    * could be smaller than a pointer.
    */
 
+  /**
+   * The queue a CacheItem currently lives in. With the LRU policy every item
+   * is in the Window.
+   */
+  enum class Segment : uint8_t { Window, Probation, Protected };
+
   struct CacheItem {
     // WARNING: leaves index unset. Since the items map and evictionQueue are
     // circular, initialization of index must happen after the CacheItem is
@@ -264,14 +331,37 @@ class ObjectCache
     /// Given a unique value upon allocation. Used to verify InterestHandle
     /// matches this specific item.
     uint64_t generation{std::numeric_limits<uint64_t>::max()};
+
+    Segment segment{Segment::Window};
   };
 
+  using Queue = folly::CountedIntrusiveList<CacheItem, &CacheItem::hook>;
+
   struct State {
+    /// The byte budgets and minimum entry count of the shard owning this
+    /// state. Set once at construction.
+    CacheEvictionPolicy evictionPolicy{CacheEvictionPolicy::LRU};
+    size_t maximumSizeBytes{0};
+    size_t minimumEntryCount{0};
+    size_t windowMaximumSizeBytes{0};
+    size_t protectedMaximumSizeBytes{0};
+
     size_t totalSize{0};
+    size_t windowSize{0};
+    size_t probationSize{0};
+    size_t protectedSize{0};
     folly::F14NodeMap<ObjectId, CacheItem> items;
 
-    /// Entries are evicted from the front of the queue.
-    folly::CountedIntrusiveList<CacheItem, &CacheItem::hook> evictionQueue;
+    /// Entries are evicted from the front of the queues. When the cache is
+    /// full, probation entries are evicted first, then protected ones and
+    /// finally window entries. With the LRU policy, only evictionQueue (the
+    /// window) is used.
+    Queue evictionQueue;
+    Queue probationQueue;
+    Queue protectedQueue;
+
+    /// Only populated with the TinyLFU policy.
+    FrequencySketch frequencySketch;
 
     uint64_t hitCount{0};
     uint64_t missCount{0};
@@ -279,6 +369,19 @@ class ObjectCache
     uint64_t dropCount{0};
   };
 
+  /**
+   * Each shard lives on its own cache line so that threads hitting different
+   * shards do not contend on the same line.
+   */
+  struct alignas(folly::hardware_destructive_interference_size) Shard {
+    folly::Synchronized<
+        State,
+        InstrumentedMutex<folly::DistributedMutex, kObjectCacheLockSite>>
+        state;
+  };
+
+  Shard& getShard(const ObjectId& hash) const noexcept;
+
   /**
    * If an object for the given hash is in cache, return it. If the object is
    * not in cache, return nullptr (and an empty interest handle).
@@ -300,13 +403,47 @@ class ObjectCache
 
   void dropInterestHandle(const ObjectId& hash, uint64_t generation) noexcept;
 
+  static Queue& getQueue(State& state, Segment segment) noexcept;
+  static size_t& getSegmentSize(State& state, Segment segment) noexcept;
+
+  /**
+   * Append the item to the back of the given segment's queue.
+   */
+  static void link(State& state, CacheItem& item, Segment segment) noexcept;
+
+  /**
+   * Remove the item from the queue it is currently in.
+   */
+  static void unlink(State& state, CacheItem& item) noexcept;
+
+  /**
+   * Record a hit on an item already in the cache, moving it to the back of its
+   * queue or promoting it to the protected segment.
+   */
+  void touch(State& state, CacheItem& item) noexcept;
+
+  /**
+   * With the TinyLFU policy, move objects that overflow the admission window
+   * into the main segment if they are estimated to be accessed more often
+   * than the object they would displace. Otherwise, evict them.
+   */
+  void admitFromWindow(State& state) noexcept;
+
   void evictUntilFits(State& state) noexcept;
   void evictOne(State& state) noexcept;
-  void evictItem(State&, const CacheItem& item) noexcept;
+  void evictItem(State&, CacheItem& item) noexcept;
+
+  /**
+   * Used to estimate the number of entries a TinyLFU shard will hold when
+   * sizing its frequency sketch.
+   */
+  static constexpr size_t kFrequencySketchBytesPerEntry = 4096;
 
   const size_t maximumCacheSizeBytes_;
   const size_t minimumEntryCount_;
-  folly::Synchronized<State, folly::DistributedMutex> state_;
+  const size_t shardCount_;
+  const CacheEvictionPolicy evictionPolicy_;
+  std::unique_ptr<Shard[]> shards_;
 
   friend class ObjectInterestHandle<ObjectType>;
 };
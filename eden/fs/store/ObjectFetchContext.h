@@ -11,9 +11,12 @@
 #include <string_view>
 #include <unordered_map>
 
+#include <folly/CancellationToken.h>
 #include <folly/portability/SysTypes.h>
 
 #include "eden/fs/store/ImportPriority.h"
+#include "eden/fs/telemetry/RequestSampler.h"
+#include "eden/fs/utils/IDGen.h"
 #include "eden/fs/utils/RefPtr.h"
 
 namespace facebook::eden {
@@ -102,6 +105,44 @@ class ObjectFetchContext : public RefCounted {
    */
   virtual void deprioritize(uint64_t) {}
 
+  /**
+   * Lowers the priority of the fetches of this context to at most the given
+   * one, including its class, unlike deprioritize. Used to get the fetches of
+   * heavy processes out of the way of the interactive ones, see
+   * HeavyFetcherPolicy.
+   */
+  virtual void lowerPriority(ImportPriority) {}
+
+  /**
+   * Cancelled when the operation fetching these objects gave up on them. The
+   * import queues drop the requests that every waiting fetch gave up on,
+   * before fetching them. Never cancelled by default.
+   */
+  virtual folly::CancellationToken getCancellationToken() const {
+    return {};
+  }
+
+  /**
+   * The phases of the filesystem request this context is for, if any, see
+   * RequestPhaseScope.
+   */
+  virtual RequestPhases* getRequestPhases() {
+    return nullptr;
+  }
+
+  /**
+   * Identifies the operation this context fetches objects for in the layers
+   * below the ObjectStore, like the import requests and their trace events,
+   * so that all the work done on behalf of one filesystem or thrift request
+   * can be put back together. Never zero.
+   *
+   * The null contexts are shared by unrelated fetches, and so are their
+   * trace IDs.
+   */
+  uint64_t getTraceId() const noexcept {
+    return traceId_;
+  }
+
   /**
    * Return a no-op fetch context suitable when no tracking is desired.
    */
@@ -122,6 +163,41 @@ class ObjectFetchContext : public RefCounted {
  private:
   ObjectFetchContext(const ObjectFetchContext&) = delete;
   ObjectFetchContext& operator=(const ObjectFetchContext&) = delete;
+
+  uint64_t traceId_ = generateUniqueID();
+};
+
+/**
+ * Marks the request of a context as being in a phase until destroyed. Like
+ * DurationScope, move it into the continuation of an asynchronous operation
+ * to cover all of it.
+ */
+class RequestPhaseScope {
+ public:
+  RequestPhaseScope(const ObjectFetchContextPtr& context, RequestPhase phase)
+      : phase_{phase} {
+    if (auto* phases = context->getRequestPhases()) {
+      phases->enter(phase);
+      context_ = context.copy();
+    }
+  }
+
+  ~RequestPhaseScope() noexcept {
+    if (context_) {
+      context_->getRequestPhases()->leave(phase_);
+    }
+  }
+
+  RequestPhaseScope(RequestPhaseScope&& that) = default;
+  RequestPhaseScope& operator=(RequestPhaseScope&& that) = delete;
+
+  RequestPhaseScope(const RequestPhaseScope&) = delete;
+  RequestPhaseScope& operator=(const RequestPhaseScope&) = delete;
+
+ private:
+  // Only set when the context has phases, and keeps them alive.
+  ObjectFetchContextPtr context_;
+  RequestPhase phase_;
 };
 
 } // namespace facebook::eden
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/ObjectMetadataCache.h"
+
+namespace facebook::eden {
+
+std::shared_ptr<ObjectMetadataCache> ObjectMetadataCache::create(
+    size_t maxEntries) {
+  return std::shared_ptr<ObjectMetadataCache>{
+      new ObjectMetadataCache{maxEntries}};
+}
+
+ObjectMetadataCache::ObjectMetadataCache(size_t maxEntries)
+    : state_{folly::in_place, maxEntries} {}
+
+ObjectMetadataCache::Account::~Account() {
+  cache_->removeAccount(id_);
+}
+
+size_t ObjectMetadataCache::Account::getChargedEntries() const {
+  auto state = cache_->state_.lock();
+  auto it = state->accounts.find(id_);
+  return it == state->accounts.end() ? 0 : it->second.chargedEntries;
+}
+
+uint64_t ObjectMetadataCache::Account::getSharedHits() const {
+  auto state = cache_->state_.lock();
+  auto it = state->accounts.find(id_);
+  return it == state->accounts.end() ? 0 : it->second.sharedHits;
+}
+
+std::unique_ptr<ObjectMetadataCache::Account>
+ObjectMetadataCache::addAccount() {
+  auto state = state_.lock();
+  auto id = state->nextAccountId++;
+  state->accounts.emplace(id, AccountUsage{});
+  return std::unique_ptr<Account>{new Account{shared_from_this(), id}};
+}
+
+void ObjectMetadataCache::removeAccount(uint32_t id) {
+  state_.lock()->accounts.erase(id);
+}
+
+template <typename T>
+std::optional<T> ObjectMetadataCache::lookup(
+    State& state,
+    Lru<T>& lru,
+    const ObjectId& id,
+    uint32_t account) {
+  auto it = lru.find(id);
+  if (it == lru.end()) {
+    return std::nullopt;
+  }
+  if (it->second.owner != account) {
+    auto usage = state.accounts.find(account);
+    if (usage != state.accounts.end()) {
+      ++usage->second.sharedHits;
+    }
+  }
+  return it->second.value;
+}
+
+template <typename T>
+void ObjectMetadataCache::insert(
+    State& state,
+    Lru<T>& lru,
+    const ObjectId& id,
+    const T& value,
+    uint32_t account) {
+  // The values are immutable, an entry that is already cached stays charged
+  // to the account that inserted it first.
+  if (lru.find(id) != lru.end()) {
+    return;
+  }
+  auto usage = state.accounts.find(account);
+  if (usage != state.accounts.end()) {
+    ++usage->second.chargedEntries;
+  }
+  lru.set(id, Entry<T>{value, account}, true, [&state](auto, auto&& evicted) {
+    uncharge(state, evicted.owner);
+  });
+}
+
+void ObjectMetadataCache::uncharge(State& state, uint32_t owner) {
+  auto usage = state.accounts.find(owner);
+  if (usage != state.accounts.end()) {
+    --usage->second.chargedEntries;
+  }
+}
+
+std::optional<BlobMetadata> ObjectMetadataCache::getBlobMetadata(
+    const ObjectId& id,
+    const Account& account) {
+  auto state = state_.lock();
+  return lookup(*state, state->blobMetadata, id, account.id_);
+}
+
+std::vector<std::optional<BlobMetadata>>
+ObjectMetadataCache::getBlobMetadataBatch(
+    const std::vector<ObjectId>& ids,
+    const Account& account) {
+  std::vector<std::optional<BlobMetadata>> results;
+  results.reserve(ids.size());
+  auto state = state_.lock();
+  for (const auto& id : ids) {
+    results.push_back(lookup(*state, state->blobMetadata, id, account.id_));
+  }
+  return results;
+}
+
+bool ObjectMetadataCache::hasBlobMetadata(const ObjectId& id) const {
+  return state_.lock()->blobMetadata.exists(id);
+}
+
+void ObjectMetadataCache::putBlobMetadata(
+    const ObjectId& id,
+    const BlobMetadata& metadata,
+    const Account& account) {
+  auto state = state_.lock();
+  insert(*state, state->blobMetadata, id, metadata, account.id_);
+}
+
+std::optional<Hash20> ObjectMetadataCache::getTreeDigest(
+    const ObjectId& id,
+    const Account& account) {
+  auto state = state_.lock();
+  return lookup(*state, state->treeDigests, id, account.id_);
+}
+
+void ObjectMetadataCache::putTreeDigest(
+    const ObjectId& id,
+    const Hash20& digest,
+    const Account& account) {
+  auto state = state_.lock();
+  insert(*state, state->treeDigests, id, digest, account.id_);
+}
+
+void ObjectMetadataCache::setMaxEntries(size_t maxEntries) {
+  auto state = state_.lock();
+  auto onEvict = [&state = *state](auto, auto&& evicted) {
+    uncharge(state, evicted.owner);
+  };
+  state->blobMetadata.setMaxSize(maxEntries, onEvict);
+  state->treeDigests.setMaxSize(maxEntries, onEvict);
+}
+
+size_t ObjectMetadataCache::getMaxEntries() const {
+  return state_.lock()->blobMetadata.getMaxSize();
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <folly/container/F14Map.h>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "eden/fs/model/BlobMetadata.h"
+#include "eden/fs/model/Hash.h"
+#include "eden/fs/model/ObjectId.h"
+
+namespace facebook::eden {
+
+/**
+ * The in-memory blob metadata and tree digest caches of the ObjectStores
+ * that share a BackingStore, that is, of all the mounts of one repository.
+ * A checkout thus benefits from the metadata computed for the others.
+ *
+ * Each cache holds at most getMaxEntries() entries, evicting the least
+ * recently used ones. Every entry is charged to the Account of the
+ * ObjectStore that inserted it, which lets per-mount usage be reported even
+ * though the entries are shared.
+ *
+ * It is safe to use this object from arbitrary threads.
+ */
+class ObjectMetadataCache
+    : public std::enable_shared_from_this<ObjectMetadataCache> {
+ public:
+  static std::shared_ptr<ObjectMetadataCache> create(size_t maxEntries);
+
+  ObjectMetadataCache(const ObjectMetadataCache&) = delete;
+  ObjectMetadataCache& operator=(const ObjectMetadataCache&) = delete;
+
+  /**
+   * One user of the cache, typically one mount. The entries it charged stay
+   * cached after the Account is destroyed, they are just no longer charged.
+   */
+  class Account {
+   public:
+    ~Account();
+
+    Account(const Account&) = delete;
+    Account& operator=(const Account&) = delete;
+
+    /**
+     * Number of cached entries that were inserted through this Account.
+     */
+    size_t getChargedEntries() const;
+
+    /**
+     * Number of lookups through this Account that found an entry charged to
+     * another one.
+     */
+    uint64_t getSharedHits() const;
+
+   private:
+    friend class ObjectMetadataCache;
+
+    Account(std::shared_ptr<ObjectMetadataCache> cache, uint32_t id)
+        : cache_{std::move(cache)}, id_{id} {}
+
+    const std::shared_ptr<ObjectMetadataCache> cache_;
+    const uint32_t id_;
+  };
+
+  std::unique_ptr<Account> addAccount();
+
+  std::optional<BlobMetadata> getBlobMetadata(
+      const ObjectId& id,
+      const Account& account);
+
+  /**
+   * Look up all the ids at once, returning the results in the same order.
+   */
+  std::vector<std::optional<BlobMetadata>> getBlobMetadataBatch(
+      const std::vector<ObjectId>& ids,
+      const Account& account);
+
+  /**
+   * Unlike getBlobMetadata(), this doesn't mark the entry as recently used.
+   */
+  bool hasBlobMetadata(const ObjectId& id) const;
+
+  void putBlobMetadata(
+      const ObjectId& id,
+      const BlobMetadata& metadata,
+      const Account& account);
+
+  std::optional<Hash20> getTreeDigest(
+      const ObjectId& id,
+      const Account& account);
+
+  void putTreeDigest(
+      const ObjectId& id,
+      const Hash20& digest,
+      const Account& account);
+
+  /**
+   * Change the maximum number of entries of each cache, evicting the least
+   * recently used ones if needed.
+   */
+  void setMaxEntries(size_t maxEntries);
+  size_t getMaxEntries() const;
+
+ private:
+  template <typename T>
+  struct Entry {
+    T value;
+    uint32_t owner;
+  };
+
+  template <typename T>
+  using Lru = folly::EvictingCacheMap<ObjectId, Entry<T>>;
+
+  struct AccountUsage {
+    size_t chargedEntries{0};
+    uint64_t sharedHits{0};
+  };
+
+  struct State {
+    explicit State(size_t maxEntries)
+        : blobMetadata{maxEntries}, treeDigests{maxEntries} {}
+
+    Lru<BlobMetadata> blobMetadata;
+    Lru<Hash20> treeDigests;
+    folly::F14FastMap<uint32_t, AccountUsage> accounts;
+    uint32_t nextAccountId{0};
+  };
+
+  explicit ObjectMetadataCache(size_t maxEntries);
+
+  template <typename T>
+  static std::optional<T>
+  lookup(State& state, Lru<T>& lru, const ObjectId& id, uint32_t account);
+
+  template <typename T>
+  static void insert(
+      State& state,
+      Lru<T>& lru,
+      const ObjectId& id,
+      const T& value,
+      uint32_t account);
+
+  static void uncharge(State& state, uint32_t owner);
+
+  void removeAccount(uint32_t id);
+
+  // EvictingCacheMap lookups reorder the LRU list, even reads thus need an
+  // exclusive lock.
+  mutable folly::Synchronized<State, std::mutex> state_;
+};
+
+} // namespace facebook::eden
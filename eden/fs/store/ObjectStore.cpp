@@ -16,10 +16,12 @@
 #include "eden/fs/model/Blob.h"
 #include "eden/fs/model/Tree.h"
 #include "eden/fs/store/BackingStore.h"
+#include "eden/fs/store/BlobHasher.h"
 #include "eden/fs/store/LocalStore.h"
 #include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/utils/ImmediateFuture.h"
+#include "eden/fs/utils/SealedMemfd.h"
 #include "eden/fs/utils/Throw.h"
 
 using folly::Future;
@@ -32,8 +34,63 @@ namespace facebook::eden {
 
 namespace {
 constexpr uint64_t kImportPriorityDeprioritizeAmount = 1;
+
+/**
+ * Fetch from the backing store, after the delay the HeavyFetcherPolicy
+ * imposed on the process, if any.
+ */
+folly::SemiFuture<BackingStore::GetTreeResult> getTreeAfter(
+    std::chrono::nanoseconds delay,
+    const std::shared_ptr<BackingStore>& backingStore,
+    const ObjectId& id,
+    const ObjectFetchContextPtr& context) {
+  if (delay.count() <= 0) {
+    return backingStore->getTree(id, context);
+  }
+  return folly::futures::sleep(delay).deferValue(
+      [backingStore, id, context = context.copy()](folly::Unit) {
+        return backingStore->getTree(id, context);
+      });
+}
+
+folly::SemiFuture<BackingStore::GetBlobResult> getBlobAfter(
+    std::chrono::nanoseconds delay,
+    const std::shared_ptr<BackingStore>& backingStore,
+    const ObjectId& id,
+    const ObjectFetchContextPtr& context) {
+  if (delay.count() <= 0) {
+    return backingStore->getBlob(id, context);
+  }
+  return folly::futures::sleep(delay).deferValue(
+      [backingStore, id, context = context.copy()](folly::Unit) {
+        return backingStore->getBlob(id, context);
+      });
 }
 
+/**
+ * Move the contents of blob into a sealed memfd if it holds at least minSize
+ * bytes, so that they can be handed to other processes without a copy.
+ */
+std::shared_ptr<const Blob> maybeSealBlob(
+    std::shared_ptr<const Blob> blob,
+    FOLLY_MAYBE_UNUSED uint64_t minSize) {
+#ifdef __linux__
+  if (minSize == 0 || blob->getSize() < minSize || blob->getFile()) {
+    return blob;
+  }
+  try {
+    auto memfd = makeSealedMemfd("edenfs-blob", blob->getContents());
+    return std::make_shared<Blob>(
+        blob->getHash(), std::move(memfd.contents), std::move(memfd.file));
+  } catch (const std::exception& ex) {
+    XLOG(WARN) << "unable to move blob " << blob->getHash()
+               << " into a memfd: " << folly::exceptionStr(ex);
+  }
+#endif
+  return blob;
+}
+} // namespace
+
 std::shared_ptr<ObjectStore> ObjectStore::create(
     shared_ptr<LocalStore> localStore,
     shared_ptr<BackingStore> backingStore,
@@ -42,7 +99,11 @@ std::shared_ptr<ObjectStore> ObjectStore::create(
     std::shared_ptr<ProcessNameCache> processNameCache,
     std::shared_ptr<StructuredLogger> structuredLogger,
     std::shared_ptr<const EdenConfig> edenConfig,
-    CaseSensitivity caseSensitive) {
+    CaseSensitivity caseSensitive,
+    std::shared_ptr<ObjectMetadataCache> metadataCache) {
+  if (!metadataCache) {
+    metadataCache = ObjectMetadataCache::create(kCacheSize);
+  }
   return std::shared_ptr<ObjectStore>{new ObjectStore{
       std::move(localStore),
       std::move(backingStore),
@@ -51,7 +112,8 @@ std::shared_ptr<ObjectStore> ObjectStore::create(
       processNameCache,
       structuredLogger,
       edenConfig,
-      caseSensitive}};
+      caseSensitive,
+      std::move(metadataCache)}};
 }
 
 ObjectStore::ObjectStore(
@@ -62,11 +124,14 @@ ObjectStore::ObjectStore(
     std::shared_ptr<ProcessNameCache> processNameCache,
     std::shared_ptr<StructuredLogger> structuredLogger,
     std::shared_ptr<const EdenConfig> edenConfig,
-    CaseSensitivity caseSensitive)
-    : metadataCache_{folly::in_place, kCacheSize},
+    CaseSensitivity caseSensitive,
+    std::shared_ptr<ObjectMetadataCache> metadataCache)
+    : metadataCache_{std::move(metadataCache)},
+      metadataAccount_{metadataCache_->addAccount()},
       treeCache_{std::move(treeCache)},
       localStore_{std::move(localStore)},
       backingStore_{std::move(backingStore)},
+      globResultCache_{localStore_, stats},
       stats_{std::move(stats)},
       pidFetchCounts_{std::make_unique<PidFetchCounts>()},
       processNameCache_(processNameCache),
@@ -106,16 +171,38 @@ void ObjectStore::sendFetchHeavyEvent(pid_t pid, uint64_t fetch_count) const {
   }
 }
 
-void ObjectStore::deprioritizeWhenFetchHeavy(
+std::chrono::nanoseconds ObjectStore::applyFetchHeavyPolicy(
     ObjectFetchContext& context) const {
   auto pid = context.getClientPid();
-  if (pid.has_value()) {
-    auto fetch_count = pidFetchCounts_->getCountByPid(pid.value());
-    auto threshold = edenConfig_->fetchHeavyThreshold.getValue();
-    if (threshold && fetch_count >= threshold) {
-      context.deprioritize(kImportPriorityDeprioritizeAmount);
-    }
+  if (!pid.has_value()) {
+    return std::chrono::nanoseconds{0};
+  }
+
+  auto fetch_count = pidFetchCounts_->getCountByPid(pid.value());
+  auto threshold = edenConfig_->fetchHeavyThreshold.getValue();
+  if (threshold && fetch_count >= threshold) {
+    context.deprioritize(kImportPriorityDeprioritizeAmount);
   }
+
+  auto decision = heavyFetchers_.recordFetch(*pid, getHeavyFetcherConfig());
+  if (decision.deprioritize) {
+    context.lowerPriority(ImportPriority{ImportPriority::Class::Low});
+  }
+  return decision.delay;
+}
+
+HeavyFetcherPolicy::Config ObjectStore::getHeavyFetcherConfig() const {
+  HeavyFetcherPolicy::Config config;
+  config.heavyFetchCount = edenConfig_->fetchHeavyWindowThreshold.getValue();
+  config.window = edenConfig_->fetchHeavyWindow.getValue();
+  config.deprioritize = edenConfig_->fetchHeavyDeprioritize.getValue();
+  config.rateLimit = edenConfig_->fetchHeavyRateLimit.getValue();
+  return config;
+}
+
+std::vector<HeavyFetcherPolicy::ProcessStats>
+ObjectStore::getHeavyFetcherStats() const {
+  return heavyFetchers_.getStats(getHeavyFetcherConfig());
 }
 
 RootId ObjectStore::parseRootId(folly::StringPiece rootId) {
@@ -160,10 +247,6 @@ std::shared_ptr<const Tree> changeCaseSensitivity(
   }
 }
 
-BlobMetadata computeBlobMetadata(const Blob& blob) {
-  return BlobMetadata{Hash20::sha1(blob.getContents()), blob.getSize()};
-}
-
 } // namespace
 
 ImmediateFuture<shared_ptr<const Tree>> ObjectStore::getRootTree(
@@ -183,6 +266,30 @@ ImmediateFuture<shared_ptr<const Tree>> ObjectStore::getRootTree(
       });
 }
 
+ImmediateFuture<std::vector<shared_ptr<const Tree>>> ObjectStore::getRootTrees(
+    const std::vector<RootId>& rootIds,
+    const ObjectFetchContextPtr& context) const {
+  XLOG(DBG3) << "getRootTrees(" << rootIds.size() << " roots)";
+  return backingStore_->getRootTrees(rootIds, context)
+      .thenValue([treeCache = treeCache_,
+                  rootIds,
+                  caseSensitive = caseSensitive_](
+                     std::vector<std::unique_ptr<Tree>> trees) {
+        std::vector<shared_ptr<const Tree>> result;
+        result.reserve(trees.size());
+        for (size_t i = 0; i < trees.size(); ++i) {
+          if (!trees[i]) {
+            throw_<std::domain_error>("unable to import root ", rootIds[i]);
+          }
+          shared_ptr<const Tree> tree = std::move(trees[i]);
+          treeCache->insert(tree);
+          result.push_back(
+              changeCaseSensitivity(std::move(tree), caseSensitive));
+        }
+        return result;
+      });
+}
+
 ImmediateFuture<std::shared_ptr<TreeEntry>>
 ObjectStore::getTreeEntryForObjectId(
     const ObjectId& objectId,
@@ -223,13 +330,16 @@ ImmediateFuture<shared_ptr<const Tree>> ObjectStore::getTree(
     return changeCaseSensitivity(maybeTree, caseSensitive_);
   }
 
-  deprioritizeWhenFetchHeavy(*fetchContext);
+  auto delay = applyFetchHeavyPolicy(*fetchContext);
 
-  return ImmediateFuture{backingStore_->getTree(id, fetchContext)}.thenValue(
-      [self = shared_from_this(),
-       statScope = std::move(statScope),
-       id,
-       fetchContext = fetchContext.copy()](BackingStore::GetTreeResult result) {
+  RequestPhaseScope phaseScope{fetchContext, RequestPhase::ObjectStore};
+  return ImmediateFuture{getTreeAfter(delay, backingStore_, id, fetchContext)}
+      .thenValue([self = shared_from_this(),
+                  statScope = std::move(statScope),
+                  phaseScope = std::move(phaseScope),
+                  id,
+                  fetchContext = fetchContext.copy()](
+                     BackingStore::GetTreeResult result) {
         if (!result.tree) {
           // TODO: Perhaps we should do some short-term negative
           // caching?
@@ -237,8 +347,7 @@ ImmediateFuture<shared_ptr<const Tree>> ObjectStore::getTree(
           throwf<std::domain_error>("tree {} not found", id);
         }
 
-        // promote to shared_ptr so we can store in the cache and return
-        auto sharedTree = std::shared_ptr<const Tree>(std::move(result.tree));
+        auto sharedTree = std::move(result.tree);
         self->treeCache_->insert(sharedTree);
         fetchContext->didFetch(ObjectFetchContext::Tree, id, result.origin);
         self->updateProcessFetch(*fetchContext);
@@ -268,12 +377,14 @@ ImmediateFuture<shared_ptr<const Blob>> ObjectStore::getBlob(
     const ObjectFetchContextPtr& fetchContext) const {
   DurationScope statScope{stats_, &ObjectStoreStats::getBlob};
 
-  deprioritizeWhenFetchHeavy(*fetchContext);
+  auto delay = applyFetchHeavyPolicy(*fetchContext);
+  RequestPhaseScope phaseScope{fetchContext, RequestPhase::ObjectStore};
   return ImmediateFuture<BackingStore::GetBlobResult>{
-      backingStore_->getBlob(id, fetchContext)}
+      getBlobAfter(delay, backingStore_, id, fetchContext)}
       .thenValue(
           [self = shared_from_this(),
            statScope = std::move(statScope),
+           phaseScope = std::move(phaseScope),
            id,
            fetchContext =
                fetchContext.copy()](BackingStore::GetBlobResult result)
@@ -283,16 +394,26 @@ ImmediateFuture<shared_ptr<const Blob>> ObjectStore::getBlob(
               XLOG(DBG2) << "unable to find blob " << id;
               throwf<std::domain_error>("blob {} not found", id);
             }
+            result.blob = maybeSealBlob(
+                std::move(result.blob),
+                self->edenConfig_->memfdBlobMinSize.getValue());
             // Quick check in-memory cache first, before doing expensive
             // calculations. If metadata is present in cache, it most certainly
             // exists in local store too.
             // We always cache metadata in LocalStore because it's faster to
             // query than the BackingStore, and metadata is very small (~28
             // bytes per blob).
-            if (!self->metadataCache_.rlock()->exists(id)) {
-              auto metadata = computeBlobMetadata(*result.blob);
-              self->localStore_->putBlobMetadata(id, metadata);
-              self->metadataCache_.wlock()->set(id, metadata);
+            if (!self->metadataCache_->hasBlobMetadata(id)) {
+              if (self->blobHasher_) {
+                // The caller only needs the blob, don't wait for its hash.
+                self->blobHasher_->hashInBackground(
+                    result.blob, [self, id](const BlobMetadata& metadata) {
+                      self->storeBlobMetadata(id, metadata);
+                    });
+              } else {
+                self->storeBlobMetadata(
+                    id, BlobHasher::computeMetadata(*result.blob));
+              }
             }
             self->updateProcessFetch(*fetchContext);
             fetchContext->didFetch(ObjectFetchContext::Blob, id, result.origin);
@@ -306,19 +427,15 @@ ImmediateFuture<BlobMetadata> ObjectStore::getBlobMetadata(
   DurationScope statScope{stats_, &ObjectStoreStats::getBlobMetadata};
 
   // Check in-memory cache
-  {
-    auto metadataCache = metadataCache_.wlock();
-    auto cacheIter = metadataCache->find(id);
-    if (cacheIter != metadataCache->end()) {
-      stats_->increment(&ObjectStoreStats::getBlobMetadataFromMemory);
-      context->didFetch(
-          ObjectFetchContext::BlobMetadata,
-          id,
-          ObjectFetchContext::FromMemoryCache);
-
-      updateProcessFetch(*context);
-      return cacheIter->second;
-    }
+  if (auto cached = metadataCache_->getBlobMetadata(id, *metadataAccount_)) {
+    stats_->increment(&ObjectStoreStats::getBlobMetadataFromMemory);
+    context->didFetch(
+        ObjectFetchContext::BlobMetadata,
+        id,
+        ObjectFetchContext::FromMemoryCache);
+
+    updateProcessFetch(*context);
+    return *cached;
   }
 
   auto self = shared_from_this();
@@ -335,7 +452,8 @@ ImmediateFuture<BlobMetadata> ObjectStore::getBlobMetadata(
             if (metadata) {
               self->stats_->increment(
                   &ObjectStoreStats::getBlobMetadataFromLocalStore);
-              self->metadataCache_.wlock()->set(id, *metadata);
+              self->metadataCache_->putBlobMetadata(
+                  id, *metadata, *self->metadataAccount_);
               context->didFetch(
                   ObjectFetchContext::BlobMetadata,
                   id,
@@ -345,71 +463,180 @@ ImmediateFuture<BlobMetadata> ObjectStore::getBlobMetadata(
               return *metadata;
             }
 
-            self->deprioritizeWhenFetchHeavy(*context);
+            return self->getBlobMetadataFromBackingStore(
+                id, std::move(statScope), context);
+          })
+      .semi();
+}
 
-            auto localMetadata =
-                self->backingStore_->getLocalBlobMetadata(id, context);
-            if (localMetadata) {
-              self->stats_->increment(
-                  &ObjectStoreStats::getLocalBlobMetadataFromBackingStore);
-              self->metadataCache_.wlock()->set(id, *localMetadata);
-              self->localStore_->putBlobMetadata(id, *localMetadata);
-              context->didFetch(
-                  ObjectFetchContext::BlobMetadata,
-                  id,
-                  ObjectFetchContext::FromDiskCache);
-              self->updateProcessFetch(*context);
-              return *localMetadata;
-            }
+#if FOLLY_HAS_COROUTINES
+folly::coro::Task<std::shared_ptr<const Tree>> ObjectStore::co_getTree(
+    ObjectId id,
+    ObjectFetchContextPtr context) const {
+  auto self = shared_from_this();
+  co_return co_await self->getTree(id, context);
+}
+
+folly::coro::Task<std::shared_ptr<const Blob>> ObjectStore::co_getBlob(
+    ObjectId id,
+    ObjectFetchContextPtr context) const {
+  auto self = shared_from_this();
+  co_return co_await self->getBlob(id, context);
+}
+
+folly::coro::Task<BlobMetadata> ObjectStore::co_getBlobMetadata(
+    ObjectId id,
+    ObjectFetchContextPtr context) const {
+  auto self = shared_from_this();
+  co_return co_await self->getBlobMetadata(id, context);
+}
+#endif
 
-            // Check backing store
-            //
-            // TODO: It would be nice to add a smarter API to the BackingStore
-            // so that we can query it just for the blob metadata if it supports
-            // getting that without retrieving the full blob data.
-            //
-            // TODO: This should probably check the LocalStore for the blob
-            // first, especially when we begin to expire entries in RocksDB.
-            return self->backingStore_
-                ->getBlob(id, context)
-                // Non-blocking statistics and cache updates should happen ASAP
-                // rather than waiting for callbacks to be scheduled on the
-                // consuming thread.
+ImmediateFuture<std::vector<folly::Try<BlobMetadata>>>
+ObjectStore::getBlobMetadataBatch(
+    const std::vector<ObjectId>& ids,
+    const ObjectFetchContextPtr& context) const {
+  auto results = metadataCache_->getBlobMetadataBatch(ids, *metadataAccount_);
+  std::vector<ObjectId> missingIds;
+  for (size_t i = 0; i < ids.size(); ++i) {
+    if (!results[i]) {
+      missingIds.push_back(ids[i]);
+    } else {
+      stats_->increment(&ObjectStoreStats::getBlobMetadataFromMemory);
+      context->didFetch(
+          ObjectFetchContext::BlobMetadata,
+          ids[i],
+          ObjectFetchContext::FromMemoryCache);
+      updateProcessFetch(*context);
+    }
+  }
+
+  auto storedFuture = localStore_->getBlobMetadataBatch(missingIds);
+  return std::move(storedFuture)
+      .thenValue([self = shared_from_this(),
+                  results = std::move(results),
+                  missingIds = std::move(missingIds),
+                  context = context.copy()](auto&& stored) mutable {
+        std::vector<ImmediateFuture<BlobMetadata>> futures;
+        futures.reserve(results.size());
+        size_t next = 0;
+        for (auto& result : results) {
+          if (result) {
+            futures.emplace_back(std::move(*result));
+            continue;
+          }
+          const auto& id = missingIds[next];
+          auto& metadata = stored[next];
+          ++next;
+          if (!metadata) {
+            futures.emplace_back(self->getBlobMetadataFromBackingStore(
+                id,
+                DurationScope{self->stats_, &ObjectStoreStats::getBlobMetadata},
+                context));
+            continue;
+          }
+          self->stats_->increment(
+              &ObjectStoreStats::getBlobMetadataFromLocalStore);
+          self->metadataCache_->putBlobMetadata(
+              id, *metadata, *self->metadataAccount_);
+          context->didFetch(
+              ObjectFetchContext::BlobMetadata,
+              id,
+              ObjectFetchContext::FromDiskCache);
+          self->updateProcessFetch(*context);
+          futures.emplace_back(std::move(*metadata));
+        }
+        return collectAll(std::move(futures));
+      });
+}
+
+ImmediateFuture<BlobMetadata> ObjectStore::getBlobMetadataFromBackingStore(
+    const ObjectId& id,
+    DurationScope statScope,
+    const ObjectFetchContextPtr& context) const {
+  auto delay = applyFetchHeavyPolicy(*context);
+
+  auto localMetadata = backingStore_->getLocalBlobMetadata(id, context);
+  if (localMetadata) {
+    stats_->increment(&ObjectStoreStats::getLocalBlobMetadataFromBackingStore);
+    metadataCache_->putBlobMetadata(id, *localMetadata, *metadataAccount_);
+    localStore_->putBlobMetadata(id, *localMetadata);
+    context->didFetch(
+        ObjectFetchContext::BlobMetadata,
+        id,
+        ObjectFetchContext::FromDiskCache);
+    updateProcessFetch(*context);
+    return *localMetadata;
+  }
+
+  // Check backing store
+  //
+  // TODO: It would be nice to add a smarter API to the BackingStore
+  // so that we can query it just for the blob metadata if it supports
+  // getting that without retrieving the full blob data.
+  //
+  // TODO: This should probably check the LocalStore for the blob
+  // first, especially when we begin to expire entries in RocksDB.
+  auto self = shared_from_this();
+  RequestPhaseScope phaseScope{context, RequestPhase::ObjectStore};
+  return getBlobAfter(delay, backingStore_, id, context)
+      // Non-blocking statistics and cache updates should happen ASAP
+      // rather than waiting for callbacks to be scheduled on the
+      // consuming thread.
+      .toUnsafeFuture()
+      .thenValue([self,
+                  statScope = std::move(statScope),
+                  phaseScope = std::move(phaseScope),
+                  id,
+                  context = context.copy()](
+                     BackingStore::GetBlobResult result) mutable {
+        if (result.blob) {
+          self->stats_->increment(
+              &ObjectStoreStats::getBlobMetadataFromBackingStore);
+          // we retrieved the full blob data
+          self->stats_->increment(
+              &ObjectStoreStats::getBlobFromBackingStore);
+          self->localStore_->putBlob(id, result.blob.get());
+          auto recordMetadata =
+              [self,
+               statScope = std::move(statScope),
+               id,
+               context = std::move(context),
+               origin = result.origin](BlobMetadata metadata) {
+                self->storeBlobMetadata(id, metadata);
+                // I could see an argument for recording this fetch
+                // with type Blob instead of BlobMetadata, but it's
+                // probably more useful in context to know how many
+                // metadata fetches occurred. Also, since backing
+                // stores don't directly support fetching metadata,
+                // it should be clear.
+                context->didFetch(
+                    ObjectFetchContext::BlobMetadata, id, origin);
+
+                self->updateProcessFetch(*context);
+                return metadata;
+              };
+          if (self->blobHasher_) {
+            return self->blobHasher_->hash(std::move(result.blob))
                 .toUnsafeFuture()
-                .thenValue([self,
-                            statScope = std::move(statScope),
-                            id,
-                            context = context.copy()](
-                               BackingStore::GetBlobResult result) {
-                  if (result.blob) {
-                    self->stats_->increment(
-                        &ObjectStoreStats::getBlobMetadataFromBackingStore);
-                    // we retrieved the full blob data
-                    self->stats_->increment(
-                        &ObjectStoreStats::getBlobFromBackingStore);
-                    self->localStore_->putBlob(id, result.blob.get());
-                    auto metadata = computeBlobMetadata(*result.blob);
-                    self->localStore_->putBlobMetadata(id, metadata);
-                    self->metadataCache_.wlock()->set(id, metadata);
-                    // I could see an argument for recording this fetch with
-                    // type Blob instead of BlobMetadata, but it's probably more
-                    // useful in context to know how many metadata fetches
-                    // occurred. Also, since backing stores don't directly
-                    // support fetching metadata, it should be clear.
-                    context->didFetch(
-                        ObjectFetchContext::BlobMetadata, id, result.origin);
-
-                    self->updateProcessFetch(*context);
-                    return makeFuture(metadata);
-                  }
-
-                  throwf<std::domain_error>("blob {} not found", id);
-                })
-                .semi();
-          })
+                .thenValue(std::move(recordMetadata));
+          }
+          return makeFuture(recordMetadata(
+              BlobHasher::computeMetadata(*result.blob)));
+        }
+
+        throwf<std::domain_error>("blob {} not found", id);
+      })
       .semi();
 }
 
+void ObjectStore::storeBlobMetadata(
+    const ObjectId& id,
+    const BlobMetadata& metadata) const {
+  localStore_->putBlobMetadata(id, metadata);
+  metadataCache_->putBlobMetadata(id, metadata, *metadataAccount_);
+}
+
 ImmediateFuture<uint64_t> ObjectStore::getBlobSize(
     const ObjectId& id,
     const ObjectFetchContextPtr& context) const {
@@ -437,4 +664,72 @@ bool ObjectStore::areObjectsKnownIdentical(
       ObjectComparison::Identical;
 }
 
+bool ObjectStore::areTreesKnownEquivalent(
+    const ObjectId& one,
+    const ObjectId& two) const {
+  if (areObjectsKnownIdentical(one, two)) {
+    return true;
+  }
+  auto oneDigest = getKnownTreeDigest(one);
+  if (!oneDigest) {
+    return false;
+  }
+  auto twoDigest = getKnownTreeDigest(two);
+  return twoDigest && *oneDigest == *twoDigest;
+}
+
+std::optional<Hash20> ObjectStore::getKnownTreeDigest(
+    const ObjectId& id) const {
+  if (auto cached = metadataCache_->getTreeDigest(id, *metadataAccount_)) {
+    return cached;
+  }
+
+  auto result = localStore_->get(KeySpace::TreeDigestFamily, id);
+  if (!result.isValid() || result.bytes().size() != Hash20::RAW_SIZE) {
+    return std::nullopt;
+  }
+  Hash20 digest{result.bytes()};
+  metadataCache_->putTreeDigest(id, digest, *metadataAccount_);
+  return digest;
+}
+
+std::optional<Hash20> ObjectStore::computeTreeDigest(const Tree& tree) const {
+  if (auto known = getKnownTreeDigest(tree.getHash())) {
+    return known;
+  }
+
+  // Each entry is its name, its type and the digest of its contents, the
+  // name being NUL-terminated since it can't contain NUL bytes.
+  std::string data{"treedigest v1\n"};
+  for (const auto& [name, entry] : tree) {
+    std::optional<Hash20> contents;
+    if (entry.isTree()) {
+      contents = getKnownTreeDigest(entry.getHash());
+    } else if (entry.getContentSha1()) {
+      contents = entry.getContentSha1();
+    } else {
+      auto metadata =
+          metadataCache_->getBlobMetadata(entry.getHash(), *metadataAccount_);
+      if (metadata) {
+        contents = metadata->sha1;
+      }
+    }
+    if (!contents) {
+      return std::nullopt;
+    }
+
+    data.append(name.view());
+    data.push_back('\0');
+    data.push_back(static_cast<char>(entry.getType()));
+    auto bytes = contents->getBytes();
+    data.append(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+  }
+
+  auto digest = Hash20::sha1(data);
+  metadataCache_->putTreeDigest(tree.getHash(), digest, *metadataAccount_);
+  localStore_->put(
+      KeySpace::TreeDigestFamily, tree.getHash(), digest.getBytes());
+  return digest;
+}
+
 } // namespace facebook::eden
@@ -10,7 +10,11 @@
 #include <folly/Synchronized.h>
 #include <folly/container/EvictingCacheMap.h>
 #include <memory>
+#include <optional>
 #include <unordered_map>
+#if FOLLY_HAS_COROUTINES
+#include <folly/experimental/coro/Task.h>
+#endif
 
 #include <folly/logging/xlog.h>
 #include "eden/common/utils/ProcessNameCache.h"
@@ -18,9 +22,12 @@
 #include "eden/fs/model/BlobMetadata.h"
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/model/RootId.h"
+#include "eden/fs/store/GlobResultCache.h"
+#include "eden/fs/store/HeavyFetcherPolicy.h"
 #include "eden/fs/store/IObjectStore.h"
 #include "eden/fs/store/ImportPriority.h"
 #include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/store/ObjectMetadataCache.h"
 #include "eden/fs/store/TreeCache.h"
 #include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/telemetry/StructuredLogger.h"
@@ -29,6 +36,7 @@ namespace facebook::eden {
 
 class BackingStore;
 class Blob;
+class BlobHasher;
 class LocalStore;
 class Tree;
 enum class ObjectComparison : uint8_t;
@@ -72,6 +80,10 @@ class ObjectStore : public IObjectStore,
                     public ObjectIdCodec,
                     public std::enable_shared_from_this<ObjectStore> {
  public:
+  /**
+   * The metadata cache is typically shared with the other ObjectStores of
+   * the repository. When null, the ObjectStore gets its own.
+   */
   static std::shared_ptr<ObjectStore> create(
       std::shared_ptr<LocalStore> localStore,
       std::shared_ptr<BackingStore> backingStore,
@@ -80,7 +92,8 @@ class ObjectStore : public IObjectStore,
       std::shared_ptr<ProcessNameCache> processNameCache,
       std::shared_ptr<StructuredLogger> structuredLogger,
       std::shared_ptr<const EdenConfig> edenConfig,
-      CaseSensitivity caseSensitive);
+      CaseSensitivity caseSensitive,
+      std::shared_ptr<ObjectMetadataCache> metadataCache = nullptr);
   ~ObjectStore() override;
 
   /**
@@ -101,12 +114,23 @@ class ObjectStore : public IObjectStore,
    * the fetchContext in BackingStore. if fetchHeavyThreshold in edenConfig_ is
    * exceeded, deprioritize the fetchContext by 1.
    *
+   * Then apply the HeavyFetcherPolicy: when the process fetches faster than
+   * the configured rate, lower the priority class of the fetchContext and
+   * return how long to delay its fetch.
+   *
    * Note: Normally, one fetchContext is created for only one fetch request,
    * so deprioritize() should only be called once by one thread, but that is
    * not strictly guaranteed. See comments before deprioritize() for more
    * information
    */
-  void deprioritizeWhenFetchHeavy(ObjectFetchContext& context) const;
+  std::chrono::nanoseconds applyFetchHeavyPolicy(
+      ObjectFetchContext& context) const;
+
+  /**
+   * The fetch rates of the processes that recently fetched from the backing
+   * store, and how the HeavyFetcherPolicy treated them.
+   */
+  std::vector<HeavyFetcherPolicy::ProcessStats> getHeavyFetcherStats() const;
 
   /**
    * Each BackingStore implementation defines its interpretation of root IDs.
@@ -145,6 +169,14 @@ class ObjectStore : public IObjectStore,
       const RootId& rootId,
       const ObjectFetchContextPtr& context) const override;
 
+  /**
+   * Get the root Trees of several commits, in the same order, sharing the
+   * work of resolving the commits in the BackingStore.
+   */
+  ImmediateFuture<std::vector<std::shared_ptr<const Tree>>> getRootTrees(
+      const std::vector<RootId>& rootIds,
+      const ObjectFetchContextPtr& context) const;
+
   /**
    * Get a TreeEntry by ID
    *
@@ -200,6 +232,38 @@ class ObjectStore : public IObjectStore,
       const ObjectId& id,
       const ObjectFetchContextPtr& context) const;
 
+#if FOLLY_HAS_COROUTINES
+  /**
+   * Coroutine versions of getTree(), getBlob() and getBlobMetadata().
+   *
+   * folly::coro::Tasks are lazy, so these take their arguments by value and
+   * keep this ObjectStore alive until they complete. Objects already in the
+   * memory caches are returned without suspending.
+   */
+  folly::coro::Task<std::shared_ptr<const Tree>> co_getTree(
+      ObjectId id,
+      ObjectFetchContextPtr context) const;
+
+  folly::coro::Task<std::shared_ptr<const Blob>> co_getBlob(
+      ObjectId id,
+      ObjectFetchContextPtr context) const;
+
+  folly::coro::Task<BlobMetadata> co_getBlobMetadata(
+      ObjectId id,
+      ObjectFetchContextPtr context) const;
+#endif
+
+  /**
+   * Get the metadata of several blobs, in the order of ids.
+   *
+   * The in-memory cache is consulted once for all of them and the LocalStore
+   * with a single batched lookup, only the remaining blobs being fetched
+   * from the BackingStore.
+   */
+  ImmediateFuture<std::vector<folly::Try<BlobMetadata>>> getBlobMetadataBatch(
+      const std::vector<ObjectId>& ids,
+      const ObjectFetchContextPtr& context) const;
+
   /**
    * Returns the size of the contents of the blob with the given ID.
    */
@@ -214,6 +278,16 @@ class ObjectStore : public IObjectStore,
       const ObjectId& id,
       const ObjectFetchContextPtr& context) const;
 
+  /**
+   * Hash the contents of the blobs fetched from the BackingStore on the
+   * threads of blobHasher rather than on the threads that fetched them.
+   *
+   * Must be called before this ObjectStore is used.
+   */
+  void setBlobHasher(std::shared_ptr<BlobHasher> blobHasher) {
+    blobHasher_ = std::move(blobHasher);
+  }
+
   /**
    * Get the LocalStore used by this ObjectStore
    */
@@ -221,6 +295,15 @@ class ObjectStore : public IObjectStore,
     return localStore_;
   }
 
+  /**
+   * Get the cache of glob results against source control trees, or nullptr
+   * when glob results should not be cached.
+   */
+  const GlobResultCache* getGlobResultCache() const {
+    return edenConfig_->globUseResultCache.getValue() ? &globResultCache_
+                                                      : nullptr;
+  }
+
   /**
    * Get the BackingStore used by this ObjectStore
    */
@@ -228,6 +311,13 @@ class ObjectStore : public IObjectStore,
     return backingStore_;
   }
 
+  /**
+   * The usage of the shared metadata cache charged to this ObjectStore.
+   */
+  const ObjectMetadataCache::Account& getMetadataCacheAccount() const {
+    return *metadataAccount_;
+  }
+
   /**
    * Convenience wrapper around BackingStore::compareObjectsById.  See
    * `BackingStorecompareObjectsById`'s documentation for more details.
@@ -247,6 +337,26 @@ class ObjectStore : public IObjectStore,
    */
   bool areObjectsKnownIdentical(const ObjectId& one, const ObjectId& two) const;
 
+  /**
+   * Like areObjectsKnownIdentical(), for trees, which are also known
+   * identical when their content digests are known and equal. The digests
+   * don't depend on the format of the ids, nor on the history of the trees.
+   *
+   * This never fetches anything, the digests must have already been computed
+   * by computeTreeDigest().
+   */
+  bool areTreesKnownEquivalent(const ObjectId& one, const ObjectId& two) const;
+
+  /**
+   * Compute and remember the content digest of tree, which covers the names,
+   * types and contents of all the files under it.
+   *
+   * Nothing is fetched: std::nullopt is returned unless the content hashes
+   * of all the files of the tree and the digests of all its subtrees are
+   * already known.
+   */
+  std::optional<Hash20> computeTreeDigest(const Tree& tree) const;
+
   folly::Synchronized<std::unordered_map<pid_t, uint64_t>>& getPidFetches() {
     return pidFetchCounts_->map_;
   }
@@ -265,29 +375,45 @@ class ObjectStore : public IObjectStore,
       std::shared_ptr<ProcessNameCache> processNameCache,
       std::shared_ptr<StructuredLogger> structuredLogger,
       std::shared_ptr<const EdenConfig> edenConfig,
-      CaseSensitivity caseSensitive);
+      CaseSensitivity caseSensitive,
+      std::shared_ptr<ObjectMetadataCache> metadataCache);
   // Forbidden copy constructor and assignment operator
   ObjectStore(ObjectStore const&) = delete;
   ObjectStore& operator=(ObjectStore const&) = delete;
 
   static constexpr size_t kCacheSize = 1000000;
 
+  /**
+   * Record the metadata of a blob in the LocalStore and the in-memory cache.
+   */
+  void storeBlobMetadata(const ObjectId& id, const BlobMetadata& metadata)
+      const;
+
+  HeavyFetcherPolicy::Config getHeavyFetcherConfig() const;
+
+  /**
+   * Fetch the metadata of a blob missing from the caches.
+   */
+  ImmediateFuture<BlobMetadata> getBlobMetadataFromBackingStore(
+      const ObjectId& id,
+      DurationScope statScope,
+      const ObjectFetchContextPtr& context) const;
+
+  /**
+   * Return the content digest of the tree id if it was already computed.
+   */
+  std::optional<Hash20> getKnownTreeDigest(const ObjectId& id) const;
+
   /**
    * During status and checkout, it's common to look up the SHA-1 for a given
    * blob ID. To avoid needing to hit RocksDB, keep a bounded in-memory cache of
-   * the sizes and SHA-1s of blobs we've seen. Each node is somewhere around 50
-   * bytes (20+28 + LRU overhead) and we store kMetadataCacheSize entries, which
-   * EvictingCacheMap divides in two for some reason. At the time of this
-   * comment, EvictingCacheMap does not store its nodes densely, so there may
-   * also be some jemalloc tracking overhead and some internal fragmentation
-   * depending on whether the node fits cleanly into one of jemalloc's size
-   * classes.
-   *
-   * TODO: It never makes sense to rlock an LRU cache, since cache hits mutate
-   * the data structure. Thus, should we use a more appropriate type of lock?
+   * the sizes and SHA-1s of blobs we've seen, and of the content digests of
+   * trees, which are also stored in the LocalStore. It is shared by the
+   * ObjectStores of all the mounts of a repository, metadataAccount_ tracks
+   * the entries this one inserted.
    */
-  mutable folly::Synchronized<folly::EvictingCacheMap<ObjectId, BlobMetadata>>
-      metadataCache_;
+  const std::shared_ptr<ObjectMetadataCache> metadataCache_;
+  const std::unique_ptr<ObjectMetadataCache::Account> metadataAccount_;
 
   /**
    * During glob, we need to read a lot of trees, but we avoid loading inodes,
@@ -316,12 +442,22 @@ class ObjectStore : public IObjectStore,
    */
   std::shared_ptr<BackingStore> backingStore_;
 
+  /**
+   * Computes the metadata of fetched blobs. When null, blobs are hashed on the
+   * thread that fetched them.
+   */
+  std::shared_ptr<BlobHasher> blobHasher_;
+
+  GlobResultCache globResultCache_;
+
   std::shared_ptr<EdenStats> const stats_;
 
   /* number of fetches for each process collected
    * from the beginning of the eden daemon progress */
   std::unique_ptr<PidFetchCounts> pidFetchCounts_;
 
+  mutable HeavyFetcherPolicy heavyFetchers_;
+
   /* process name cache and structured logger used for
    * sending fetch heavy events, set to nullptr if not
    * initialized by create()
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/PathFilter.h"
+
+#include <fmt/format.h>
+#include <folly/Conv.h>
+#include <folly/String.h>
+#include <algorithm>
+#include <stdexcept>
+
+#include "eden/fs/model/Hash.h"
+
+namespace facebook::eden {
+
+namespace {
+constexpr folly::StringPiece kIncludeSection{"[include]"};
+constexpr folly::StringPiece kExcludeSection{"[exclude]"};
+constexpr folly::StringPiece kGlobPrefix{"glob:"};
+
+// Long enough to tell the filters of a mount apart.
+constexpr size_t kIdSize = 8;
+} // namespace
+
+PathFilter::Rule PathFilter::parseRule(folly::StringPiece line) {
+  Rule rule;
+  rule.pattern = line.str();
+  if (line.startsWith(kGlobPrefix)) {
+    auto glob = line.subpiece(kGlobPrefix.size());
+    auto matcher = GlobMatcher::create(
+        std::string_view{glob.data(), glob.size()}, GlobOptions::DEFAULT);
+    if (matcher.hasError()) {
+      throw std::invalid_argument(
+          fmt::format(
+              "invalid filter glob \"{}\": {}", glob.str(), matcher.error()));
+    }
+    rule.glob = std::move(matcher).value();
+    auto wildcard = glob.find_first_of("*?[\\");
+    rule.literalPrefix =
+        glob.subpiece(0, std::min(wildcard, glob.size())).str();
+  } else {
+    try {
+      rule.literalPrefix = RelativePath{line}.value();
+    } catch (const std::exception& ex) {
+      throw std::invalid_argument(
+          fmt::format(
+              "invalid filter path \"{}\": {}", line.str(), ex.what()));
+    }
+    if (rule.literalPrefix.empty()) {
+      throw std::invalid_argument("filter paths must not be empty");
+    }
+  }
+  return rule;
+}
+
+PathFilter PathFilter::parse(folly::StringPiece contents) {
+  std::vector<folly::StringPiece> lines;
+  folly::split('\n', contents, lines);
+
+  PathFilter filter;
+  auto* rules = &filter.excludes_;
+  for (auto line : lines) {
+    line = folly::trimWhitespace(line);
+    if (line.empty() || line.startsWith('#')) {
+      continue;
+    }
+    if (line == kIncludeSection) {
+      rules = &filter.includes_;
+    } else if (line == kExcludeSection) {
+      rules = &filter.excludes_;
+    } else {
+      rules->push_back(parseRule(line));
+    }
+  }
+
+  for (auto* section : {&filter.includes_, &filter.excludes_}) {
+    std::sort(
+        section->begin(), section->end(), [](const Rule& a, const Rule& b) {
+          return a.pattern < b.pattern;
+        });
+    auto last = std::unique(
+        section->begin(), section->end(), [](const Rule& a, const Rule& b) {
+          return a.pattern == b.pattern;
+        });
+    section->erase(last, section->end());
+  }
+
+  if (!filter.empty()) {
+    auto hash = Hash20::sha1(filter.serialize());
+    filter.id_ = std::string{
+        reinterpret_cast<const char*>(hash.getBytes().data()), kIdSize};
+  }
+  return filter;
+}
+
+std::string PathFilter::serialize() const {
+  std::string out;
+  if (!includes_.empty()) {
+    out += kIncludeSection;
+    out += '\n';
+    for (const auto& rule : includes_) {
+      out += rule.pattern;
+      out += '\n';
+    }
+  }
+  if (!excludes_.empty()) {
+    out += kExcludeSection;
+    out += '\n';
+    for (const auto& rule : excludes_) {
+      out += rule.pattern;
+      out += '\n';
+    }
+  }
+  return out;
+}
+
+bool PathFilter::matches(const Rule& rule, RelativePathPiece path) {
+  if (rule.glob) {
+    for (auto parent : path.paths()) {
+      if (rule.glob->match(parent.view())) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  auto str = path.stringPiece();
+  auto& pattern = rule.literalPrefix;
+  return str.startsWith(pattern) &&
+      (str.size() == pattern.size() || str[pattern.size()] == '/');
+}
+
+bool PathFilter::mayMatchUnder(const Rule& rule, RelativePathPiece dir) {
+  if (dir.empty()) {
+    return true;
+  }
+  auto dirPrefix = folly::to<std::string>(dir.stringPiece(), "/");
+  folly::StringPiece literalPrefix{rule.literalPrefix};
+  return literalPrefix.startsWith(dirPrefix) ||
+      (rule.glob && folly::StringPiece{dirPrefix}.startsWith(literalPrefix));
+}
+
+bool PathFilter::isHidden(RelativePathPiece path) const {
+  for (const auto& rule : excludes_) {
+    if (matches(rule, path)) {
+      return true;
+    }
+  }
+  if (includes_.empty()) {
+    return false;
+  }
+  for (const auto& rule : includes_) {
+    // Included, or a parent directory of what is included.
+    if (matches(rule, path) || mayMatchUnder(rule, path)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool PathFilter::mayHideUnder(RelativePathPiece dir) const {
+  for (const auto& rule : excludes_) {
+    if (mayMatchUnder(rule, dir)) {
+      return true;
+    }
+  }
+  if (includes_.empty()) {
+    return false;
+  }
+  for (const auto& rule : includes_) {
+    if (!dir.empty() && matches(rule, dir)) {
+      // Everything under dir is included.
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "eden/fs/model/git/GlobMatcher.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/**
+ * Decides which paths of a filtered mount are visible, in the spirit of a
+ * Mercurial sparse profile:
+ *
+ *   # Comments and blank lines are ignored.
+ *   [include]
+ *   fbcode/eden
+ *   glob:fbcode/*.bzl
+ *   [exclude]
+ *   fbcode/eden/website
+ *
+ * Rules are path prefixes, matching a file or a directory with everything
+ * under it, or gitignore-style globs when prefixed with "glob:". Rules before
+ * any section are excludes. A path is visible if it is not excluded and, when
+ * there are includes, if it or one of its parents is included, or if it is a
+ * parent directory of an include.
+ *
+ * A default-constructed PathFilter shows everything.
+ */
+class PathFilter {
+ public:
+  PathFilter() = default;
+
+  /**
+   * Parses the format above. Throws std::invalid_argument on invalid rules.
+   */
+  static PathFilter parse(folly::StringPiece contents);
+
+  /**
+   * Returns the filter in the format parse() accepts, with its rules sorted,
+   * so that equivalent filters serialize identically.
+   */
+  std::string serialize() const;
+
+  /**
+   * A short binary identifier of the rules, empty for a filter that shows
+   * everything.
+   */
+  const std::string& getId() const {
+    return id_;
+  }
+
+  bool empty() const {
+    return includes_.empty() && excludes_.empty();
+  }
+
+  /**
+   * Whether path, whose parent directory is visible, is hidden.
+   */
+  bool isHidden(RelativePathPiece path) const;
+
+  /**
+   * Whether this filter may hide anything under the visible directory dir.
+   * This errs on the side of returning true.
+   */
+  bool mayHideUnder(RelativePathPiece dir) const;
+
+ private:
+  struct Rule {
+    std::string pattern;
+    // Set for globs.
+    std::optional<GlobMatcher> glob;
+    // The pattern up to its first wildcard.
+    std::string literalPrefix;
+  };
+
+  static Rule parseRule(folly::StringPiece line);
+
+  /**
+   * Whether rule matches path or one of its parents.
+   */
+  static bool matches(const Rule& rule, RelativePathPiece path);
+
+  /**
+   * Whether rule may match a path strictly under dir.
+   */
+  static bool mayMatchUnder(const Rule& rule, RelativePathPiece dir);
+
+  std::vector<Rule> includes_;
+  std::vector<Rule> excludes_;
+  std::string id_;
+};
+
+} // namespace facebook::eden
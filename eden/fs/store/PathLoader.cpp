@@ -6,6 +6,7 @@
  */
 
 #include "eden/fs/store/PathLoader.h"
+#include <folly/container/F14Map.h>
 #include <vector>
 #include "eden/fs/model/Tree.h"
 #include "eden/fs/service/gen-cpp2/eden_constants.h"
@@ -58,6 +59,94 @@ ImmediateFuture<std::shared_ptr<const Tree>> resolveTree(
       });
 }
 
+struct ResolveEntriesContext {
+  explicit ResolveEntriesContext(const std::vector<RelativePath>& paths)
+      : results(paths.size()) {
+    components.reserve(paths.size());
+    for (const auto& path : paths) {
+      auto& pathComponents = components.emplace_back();
+      for (auto c : path.components()) {
+        pathComponents.emplace_back(c);
+      }
+    }
+  }
+
+  std::vector<std::vector<PathComponent>> components;
+  std::vector<folly::Try<TreeEntry>> results;
+};
+
+// The trees of one level of the walk, each with the indices of the paths that
+// go through it.
+using TreeLevel =
+    std::vector<std::pair<std::shared_ptr<const Tree>, std::vector<size_t>>>;
+
+ImmediateFuture<folly::Unit> resolveTreeEntries(
+    std::shared_ptr<ResolveEntriesContext> ctx,
+    ObjectStore& objectStore,
+    const ObjectFetchContextPtr& fetchContext,
+    TreeLevel level,
+    size_t depth) {
+  // The subtrees to fetch for the next level. Paths going through identical
+  // directories share their fetch.
+  folly::F14NodeMap<ObjectId, std::vector<size_t>> subtrees;
+  for (auto& [tree, indices] : level) {
+    for (auto index : indices) {
+      const auto& name = ctx->components[index][depth];
+      auto child = tree->find(name);
+      if (child == tree->end()) {
+        ctx->results[index] = folly::Try<TreeEntry>{newEdenError(
+            ENOENT, EdenErrorType::POSIX_ERROR, "no child with name ", name)};
+      } else if (depth + 1 == ctx->components[index].size()) {
+        ctx->results[index] = folly::Try<TreeEntry>{child->second};
+      } else if (!child->second.isTree()) {
+        ctx->results[index] = folly::Try<TreeEntry>{newEdenError(
+            ENOTDIR, EdenErrorType::POSIX_ERROR, "child is not tree ", name)};
+      } else {
+        subtrees[child->second.getHash()].push_back(index);
+      }
+    }
+  }
+  if (subtrees.empty()) {
+    return folly::unit;
+  }
+
+  std::vector<std::vector<size_t>> subtreeIndices;
+  std::vector<ImmediateFuture<std::shared_ptr<const Tree>>> futures;
+  subtreeIndices.reserve(subtrees.size());
+  futures.reserve(subtrees.size());
+  for (auto& [id, indices] : subtrees) {
+    futures.push_back(objectStore.getTree(id, fetchContext));
+    subtreeIndices.push_back(std::move(indices));
+  }
+
+  return collectAll(std::move(futures))
+      .thenValue([ctx = std::move(ctx),
+                  &objectStore,
+                  fetchContext = fetchContext.copy(),
+                  subtreeIndices = std::move(subtreeIndices),
+                  depth](std::vector<folly::Try<std::shared_ptr<const Tree>>>&&
+                             trees) mutable {
+        TreeLevel nextLevel;
+        for (size_t i = 0; i < trees.size(); ++i) {
+          if (trees[i].hasException()) {
+            for (auto index : subtreeIndices[i]) {
+              ctx->results[index] =
+                  folly::Try<TreeEntry>{trees[i].exception()};
+            }
+            continue;
+          }
+          nextLevel.emplace_back(
+              std::move(trees[i]).value(), std::move(subtreeIndices[i]));
+        }
+        return resolveTreeEntries(
+            std::move(ctx),
+            objectStore,
+            fetchContext,
+            std::move(nextLevel),
+            depth + 1);
+      });
+}
+
 } // namespace
 
 ImmediateFuture<std::shared_ptr<const Tree>> resolveTree(
@@ -76,4 +165,29 @@ ImmediateFuture<std::shared_ptr<const Tree>> resolveTree(
       std::move(ctx), objectStore, fetchContext, std::move(root), 0);
 }
 
+ImmediateFuture<std::vector<folly::Try<TreeEntry>>> resolveTreeEntries(
+    ObjectStore& objectStore,
+    const ObjectFetchContextPtr& fetchContext,
+    std::shared_ptr<const Tree> root,
+    const std::vector<RelativePath>& paths) {
+  auto ctx = std::make_shared<ResolveEntriesContext>(paths);
+  std::vector<size_t> indices;
+  for (size_t i = 0; i < paths.size(); ++i) {
+    if (paths[i].empty()) {
+      ctx->results[i] = folly::Try<TreeEntry>{newEdenError(
+          EINVAL,
+          EdenErrorType::ARGUMENT_ERROR,
+          "the root tree has no entry")};
+    } else {
+      indices.push_back(i);
+    }
+  }
+
+  TreeLevel level;
+  level.emplace_back(std::move(root), std::move(indices));
+  return resolveTreeEntries(
+             ctx, objectStore, fetchContext, std::move(level), 0)
+      .thenValue([ctx](folly::Unit) { return std::move(ctx->results); });
+}
+
 } // namespace facebook::eden
@@ -7,6 +7,11 @@
 
 #pragma once
 
+#include <folly/Try.h>
+#include <memory>
+#include <vector>
+
+#include "eden/fs/model/TreeEntry.h"
 #include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/utils/ImmediateFuture.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -22,4 +27,19 @@ ImmediateFuture<std::shared_ptr<const Tree>> resolveTree(
     std::shared_ptr<const Tree> root,
     RelativePathPiece path);
 
+/**
+ * Looks up the TreeEntry of each of paths under root.
+ *
+ * The paths are walked as a trie, one level at a time: a tree is fetched once
+ * per level however many of the paths go through it, and the trees of a level
+ * are fetched concurrently. The results are in the order of paths. A path
+ * fails with ENOENT if one of its components is missing, with ENOTDIR if one
+ * of its parents is not a tree, and with EINVAL if it is empty.
+ */
+ImmediateFuture<std::vector<folly::Try<TreeEntry>>> resolveTreeEntries(
+    ObjectStore& objectStore,
+    const ObjectFetchContextPtr& fetchContext,
+    std::shared_ptr<const Tree> root,
+    const std::vector<RelativePath>& paths);
+
 } // namespace facebook::eden
@@ -7,24 +7,35 @@
 
 #include "eden/fs/store/RocksDbLocalStore.h"
 
+#include <algorithm>
 #include <array>
 #include <atomic>
+#include <numeric>
+#include <thread>
+#include <unordered_set>
 
 #include <fb303/ServiceData.h>
+#include <folly/ScopeGuard.h>
 #include <folly/String.h>
+#include <folly/Utility.h>
 #include <folly/futures/Future.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
 #include <folly/lang/Bits.h>
 #include <folly/logging/xlog.h>
+#include <rocksdb/cache.h>
+#include <rocksdb/compaction_filter.h>
 #include <rocksdb/convenience.h>
 #include <rocksdb/db.h>
 #include <rocksdb/filter_policy.h>
 #include <rocksdb/table.h>
+#include <rocksdb/utilities/memory_util.h>
+#include <rocksdb/version.h>
 
 #include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/rocksdb/RocksException.h"
 #include "eden/fs/rocksdb/RocksHandles.h"
+#include "eden/fs/store/AccessSketch.h"
 #include "eden/fs/store/KeySpace.h"
 #include "eden/fs/store/StoreResult.h"
 #include "eden/fs/telemetry/StructuredLogger.h"
@@ -44,31 +55,158 @@ using std::chrono::duration_cast;
 namespace {
 using namespace facebook::eden;
 
-rocksdb::ColumnFamilyOptions makeColumnOptions(uint64_t LRUblockCacheSizeMB) {
+void freePinnableSlice(void* /* buffer */, void* userData) {
+  delete static_cast<rocksdb::PinnableSlice*>(userData);
+}
+
+/**
+ * Hand a value read from RocksDB over to a StoreResult.
+ *
+ * Values that RocksDB read into the buffer of the PinnableSlice, such as
+ * those of blob files or memtables, are taken over without copying them.
+ * Values pinned in the block cache are copied once: the pin must neither
+ * outlive the database nor keep long-lived values, such as blobs, in the
+ * cache.
+ */
+StoreResult toStoreResult(rocksdb::PinnableSlice&& value) {
+  if (value.IsPinned()) {
+    return StoreResult{
+        folly::IOBuf{folly::IOBuf::COPY_BUFFER, value.data(), value.size()}};
+  }
+  auto slice = std::make_unique<rocksdb::PinnableSlice>(std::move(value));
+  // Extract the data and size before releasing the slice to the IOBuf, as
+  // arguments are evaluated in an arbitrary order.
+  auto data = const_cast<char*>(slice->data());
+  auto size = slice->size();
+  return StoreResult{folly::IOBuf{
+      folly::IOBuf::TAKE_OWNERSHIP,
+      data,
+      size,
+      freePinnableSlice,
+      slice.release()}};
+}
+
+rocksdb::CompressionType toRocksDbCompression(
+    LocalStoreCompression compression) {
+  switch (compression) {
+    case LocalStoreCompression::None:
+      return rocksdb::kNoCompression;
+    case LocalStoreCompression::Snappy:
+      return rocksdb::kSnappyCompression;
+    case LocalStoreCompression::Zlib:
+      return rocksdb::kZlibCompression;
+    case LocalStoreCompression::LZ4:
+      return rocksdb::kLZ4Compression;
+    case LocalStoreCompression::Zstd:
+      return rocksdb::kZSTD;
+  }
+  EDEN_BUG() << "unknown local store compression "
+             << folly::to_underlying(compression);
+}
+
+rocksdb::ColumnFamilyOptions makeColumnOptions(
+    std::shared_ptr<rocksdb::Cache> blockCache,
+    std::shared_ptr<const rocksdb::FilterPolicy> filterPolicy) {
   rocksdb::ColumnFamilyOptions options;
 
   // We'll never perform range scans on any of the keys that we store.
-  // This enables bloom filters and a hash policy that improves our
-  // get/put performance.
-  options.OptimizeForPointLookup(LRUblockCacheSizeMB);
+  // This is what OptimizeForPointLookup() sets up, a hash index in each data
+  // block and whole key filters, except that it doesn't let us share its
+  // block cache or pick its filter.
+  rocksdb::BlockBasedTableOptions tableOptions;
+  tableOptions.data_block_index_type =
+      rocksdb::BlockBasedTableOptions::kDataBlockBinaryAndHash;
+  tableOptions.data_block_hash_table_util_ratio = 0.75;
+  tableOptions.filter_policy = std::move(filterPolicy);
+  tableOptions.block_cache = std::move(blockCache);
+  options.table_factory.reset(rocksdb::NewBlockBasedTableFactory(tableOptions));
+  options.memtable_prefix_bloom_size_ratio = 0.02;
+  options.memtable_whole_key_filtering = true;
 
   options.OptimizeLevelStyleCompaction();
   return options;
 }
 
+std::shared_ptr<rocksdb::Cache> makeBlockCache(uint64_t sizeMB) {
+  return rocksdb::NewLRUCache(static_cast<size_t>(sizeMB * 1024 * 1024));
+}
+
+std::shared_ptr<const rocksdb::FilterPolicy> makeBloomFilter() {
+  return std::shared_ptr<const rocksdb::FilterPolicy>{
+      rocksdb::NewBloomFilterPolicy(10)};
+}
+
+/**
+ * The column family options of each StorageProfile.
+ */
+struct ColumnOptions {
+  explicit ColumnOptions(const RocksDbTuning& tuning) {
+    // Most of the column families will share the same cache.  We
+    // want the blob data to live in its own smaller cache; the assumption
+    // is that the vfs cache will compensate for that, together with the
+    // idea that we shouldn't need to materialize a great many files.
+    auto sharedCache = makeBlockCache(64);
+
+    defaultOptions = makeColumnOptions(sharedCache, makeBloomFilter());
+
+    // Ribbon filters take about 30% less memory than bloom filters for the
+    // same false positive rate, which matters for key spaces with many small
+    // entries.
+    auto smallValueFilter = tuning.smallValueFilterBitsPerKey > 0
+        ? std::shared_ptr<const rocksdb::FilterPolicy>{
+              rocksdb::NewRibbonFilterPolicy(
+                  tuning.smallValueFilterBitsPerKey)}
+        : makeBloomFilter();
+    smallValueOptions =
+        makeColumnOptions(sharedCache, std::move(smallValueFilter));
+    smallValueOptions.compression =
+        toRocksDbCompression(tuning.smallValueCompression);
+
+    largeValueOptions = makeColumnOptions(makeBlockCache(8), makeBloomFilter());
+    // Keeping large values in blob files means compactions only rewrite
+    // their keys and the offset of their values, instead of the values
+    // themselves. The blob files are garbage collected as compactions drop
+    // the values they hold.
+    largeValueOptions.enable_blob_files = tuning.enableBlobFiles;
+    largeValueOptions.min_blob_size = tuning.minBlobSize;
+    largeValueOptions.blob_compression_type =
+        toRocksDbCompression(tuning.blobCompression);
+    largeValueOptions.enable_blob_garbage_collection = true;
+  }
+
+  const rocksdb::ColumnFamilyOptions& forProfile(StorageProfile profile) const {
+    switch (profile) {
+      case StorageProfile::Default:
+        return defaultOptions;
+      case StorageProfile::SmallValues:
+        return smallValueOptions;
+      case StorageProfile::LargeValues:
+        return largeValueOptions;
+    }
+    EDEN_BUG() << "unknown storage profile " << folly::to_underlying(profile);
+  }
+
+  rocksdb::ColumnFamilyOptions defaultOptions;
+  rocksdb::ColumnFamilyOptions smallValueOptions;
+  rocksdb::ColumnFamilyOptions largeValueOptions;
+};
+
+/**
+ * Indexed by key space.
+ */
+using CompactionFilterFactories =
+    std::vector<std::shared_ptr<rocksdb::CompactionFilterFactory>>;
+
 /**
  * The different key spaces that we desire.
  * The ordering is coupled with the values of the KeySpace enum.
  */
 const std::vector<rocksdb::ColumnFamilyDescriptor> columnFamilies(
     const rocksdb::DBOptions& db_options,
-    const std::string& name) {
-  // Most of the column families will share the same cache.  We
-  // want the blob data to live in its own smaller cache; the assumption
-  // is that the vfs cache will compensate for that, together with the
-  // idea that we shouldn't need to materialize a great many files.
-  auto options = makeColumnOptions(64);
-  auto blobOptions = makeColumnOptions(8);
+    const std::string& name,
+    const RocksDbTuning& tuning,
+    const CompactionFilterFactories& filters) {
+  ColumnOptions options{tuning};
 
   // We have to open all column families that currenly exists in our RocksDb.
   // Else we will get "Invalid argument: You have to open all column
@@ -81,9 +219,11 @@ const std::vector<rocksdb::ColumnFamilyDescriptor> columnFamilies(
 
   std::vector<rocksdb::ColumnFamilyDescriptor> families;
   for (auto& ks : KeySpace::kAll) {
-    families.emplace_back(
-        ks->name.str(),
-        (ks->index == KeySpace::BlobFamily.index) ? blobOptions : options);
+    auto familyOptions = options.forProfile(ks->profile);
+    if (ks->index < filters.size()) {
+      familyOptions.compaction_filter_factory = filters[ks->index];
+    }
+    families.emplace_back(ks->name.str(), std::move(familyOptions));
     auto oldFamily = find(
         oldUnopenedColumnFamilies.begin(),
         oldUnopenedColumnFamilies.end(),
@@ -95,7 +235,8 @@ const std::vector<rocksdb::ColumnFamilyDescriptor> columnFamilies(
   // Put the default column family after the defined KeySpace values.
   // This way the KeySpace enum values can be used directly as indexes
   // into our column family vectors.
-  families.emplace_back(rocksdb::kDefaultColumnFamilyName, options);
+  families.emplace_back(
+      rocksdb::kDefaultColumnFamilyName, options.defaultOptions);
   auto oldFamily = find(
       oldUnopenedColumnFamilies.begin(),
       oldUnopenedColumnFamilies.end(),
@@ -107,7 +248,7 @@ const std::vector<rocksdb::ColumnFamilyDescriptor> columnFamilies(
   // add any column families we missed with our default options;
   // we have to open them but otherwise we don't care about them
   for (auto& family : oldUnopenedColumnFamilies) {
-    families.emplace_back(family, options);
+    families.emplace_back(family, options.defaultOptions);
   }
 
   return families;
@@ -135,6 +276,53 @@ rocksdb::Slice _createSlice(folly::ByteRange bytes) {
   return Slice(reinterpret_cast<const char*>(bytes.data()), bytes.size());
 }
 
+folly::ByteRange toByteRange(const Slice& slice) {
+  return folly::ByteRange{
+      reinterpret_cast<const unsigned char*>(slice.data()), slice.size()};
+}
+
+/**
+ * Drops the entries that were not accessed recently.
+ */
+class AccessCompactionFilter : public rocksdb::CompactionFilter {
+ public:
+  explicit AccessCompactionFilter(const AccessSketch& sketch)
+      : sketch_{sketch} {}
+
+  bool Filter(
+      int /*level*/,
+      const Slice& key,
+      const Slice& /*existingValue*/,
+      std::string* /*newValue*/,
+      bool* /*valueChanged*/) const override {
+    return !sketch_.mayHaveBeenAccessed(toByteRange(key));
+  }
+
+  // Decide on the key alone, so that values kept in blob files are not read.
+  Decision FilterBlobByKey(
+      int /*level*/,
+      const Slice& key,
+      std::string* /*newValue*/,
+      std::string* /*skipUntil*/) const override {
+    return sketch_.mayHaveBeenAccessed(toByteRange(key)) ? Decision::kKeep
+                                                         : Decision::kRemove;
+  }
+
+  const char* Name() const override {
+    return "AccessCompactionFilter";
+  }
+
+ private:
+  const AccessSketch& sketch_;
+};
+
+/**
+ * Keys are hashes, which are spread evenly over their first byte. The
+ * garbage collection compacts key spaces one kGcSliceCount-th of that range
+ * at a time.
+ */
+constexpr size_t kGcSliceCount = 16;
+
 class RocksDbWriteBatch : public LocalStore::WriteBatch {
  public:
   void put(KeySpace keySpace, folly::ByteRange key, folly::ByteRange value)
@@ -147,11 +335,13 @@ class RocksDbWriteBatch : public LocalStore::WriteBatch {
   ~RocksDbWriteBatch() override;
   // Use LocalStore::beginWrite() to create a write batch
   RocksDbWriteBatch(
+      const RocksDbLocalStore& store,
       Synchronized<RocksDbLocalStore::RockDBState>::ConstRLockedPtr&& dbHandles,
       size_t bufferSize);
 
   void flushIfNeeded();
 
+  const RocksDbLocalStore& store_;
   folly::Synchronized<RocksDbLocalStore::RockDBState>::ConstRLockedPtr
       lockedDB_;
   rocksdb::WriteBatch writeBatch_;
@@ -187,9 +377,11 @@ void RocksDbWriteBatch::flushIfNeeded() {
 }
 
 RocksDbWriteBatch::RocksDbWriteBatch(
+    const RocksDbLocalStore& store,
     Synchronized<RocksDbLocalStore::RockDBState>::ConstRLockedPtr&& dbHandles,
     size_t bufSize)
     : LocalStore::WriteBatch(),
+      store_(store),
       lockedDB_(std::move(dbHandles)),
       writeBatch_(bufSize),
       bufSize_(bufSize) {}
@@ -205,6 +397,7 @@ void RocksDbWriteBatch::put(
     KeySpace keySpace,
     folly::ByteRange key,
     folly::ByteRange value) {
+  store_.recordAccess(keySpace, key);
   writeBatch_.Put(
       lockedDB_->handles->columns[keySpace->index].get(),
       _createSlice(key),
@@ -223,6 +416,7 @@ void RocksDbWriteBatch::put(
     slices.emplace_back(_createSlice(valueSlice));
   }
 
+  store_.recordAccess(keySpace, key);
   auto keySlice = _createSlice(key);
   SliceParts keyParts(&keySlice, 1);
   writeBatch_.Put(
@@ -249,10 +443,14 @@ rocksdb::Options getRocksdbOptions() {
   return options;
 }
 
-RocksHandles openDB(AbsolutePathPiece path, RocksDBOpenMode mode) {
+RocksHandles openDB(
+    AbsolutePathPiece path,
+    RocksDBOpenMode mode,
+    const RocksDbTuning& tuning,
+    const CompactionFilterFactories& filters) {
   auto options = getRocksdbOptions();
-  const auto columnDescriptors =
-      columnFamilies(rocksdb::DBOptions{options}, path.stringWithoutUNC());
+  const auto columnDescriptors = columnFamilies(
+      rocksdb::DBOptions{options}, path.stringWithoutUNC(), tuning, filters);
   try {
     return RocksHandles(
         path.viewWithoutUNC(), mode, options, columnDescriptors);
@@ -266,7 +464,7 @@ RocksHandles openDB(AbsolutePathPiece path, RocksDBOpenMode mode) {
     // Fall through and attempt to repair the DB
   }
 
-  RocksDbLocalStore::repairDB(path);
+  RocksDbLocalStore::repairDB(path, tuning);
 
   // Now try opening the DB again.
   return RocksHandles(path.viewWithoutUNC(), mode, options, columnDescriptors);
@@ -276,6 +474,35 @@ RocksHandles openDB(AbsolutePathPiece path, RocksDBOpenMode mode) {
 
 namespace facebook::eden {
 
+/**
+ * Tracks the accesses to the entries of an ephemeral key space, and filters
+ * out the ones that were not accessed recently from the manual compactions
+ * of its garbage collection.
+ */
+class RocksDbLocalStore::AccessFilterFactory
+    : public rocksdb::CompactionFilterFactory {
+ public:
+  explicit AccessFilterFactory(size_t sketchBits) : sketch{sketchBits} {}
+
+  std::unique_ptr<rocksdb::CompactionFilter> CreateCompactionFilter(
+      const rocksdb::CompactionFilter::Context& context) override {
+    if (!context.is_manual_compaction ||
+        !collecting.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+    return std::make_unique<AccessCompactionFilter>(sketch);
+  }
+
+  const char* Name() const override {
+    return "AccessFilterFactory";
+  }
+
+  AccessSketch sketch;
+  std::atomic<bool> collecting{false};
+  // Only used by the garbage collection, which never runs concurrently.
+  size_t nextSlice{0};
+};
+
 RocksDbLocalStore::RockDBState::RockDBState() {
   XLOG(DBG2) << "Making a new RockDB localstore ( " << this
              << " ). debug information for T136469251.";
@@ -285,12 +512,23 @@ RocksDbLocalStore::RocksDbLocalStore(
     AbsolutePathPiece pathToRocksDb,
     std::shared_ptr<StructuredLogger> structuredLogger,
     FaultInjector* faultInjector,
-    RocksDBOpenMode mode)
+    RocksDBOpenMode mode,
+    RocksDbTuning tuning)
     : structuredLogger_{std::move(structuredLogger)},
       faultInjector_(*faultInjector),
       ioPool_(12, "RocksLocalStore"),
       pathToDb_{pathToRocksDb.copy()},
-      mode_{mode} {
+      mode_{mode},
+      tuning_{std::move(tuning)} {
+  if (tuning_.accessSketchBits > 0) {
+    accessFilters_.resize(KeySpace::kTotalCount);
+    for (auto& ks : KeySpace::kAll) {
+      if (ks->isEphemeral()) {
+        accessFilters_[ks->index] =
+            std::make_shared<AccessFilterFactory>(tuning_.accessSketchBits);
+      }
+    }
+  }
   XLOG(DBG2) << "Making a new RockDB localstore ( " << this
              << " ) . debug information for T136469251.";
 }
@@ -310,8 +548,10 @@ void RocksDbLocalStore::open() {
       case RockDbHandleStatus::NOT_YET_OPENED:
         break;
     }
-    handles->handles =
-        std::make_unique<RocksHandles>(openDB(pathToDb_.piece(), mode_));
+    CompactionFilterFactories filters{
+        accessFilters_.begin(), accessFilters_.end()};
+    handles->handles = std::make_unique<RocksHandles>(
+        openDB(pathToDb_.piece(), mode_, tuning_, filters));
     handles->status = RockDbHandleStatus::OPEN;
   }
   // Publish fb303 stats once when we first open the DB.
@@ -361,7 +601,22 @@ RocksDbLocalStore::getHandles() const {
   return handles;
 }
 
-void RocksDbLocalStore::repairDB(AbsolutePathPiece path) {
+RocksDbTuning RocksDbTuning::fromConfig(const EdenConfig& config) {
+  RocksDbTuning tuning;
+  tuning.enableBlobFiles = config.rocksDbEnableBlobFiles.getValue();
+  tuning.minBlobSize = config.rocksDbMinBlobSize.getValue();
+  tuning.blobCompression = config.rocksDbBlobCompression.getValue();
+  tuning.smallValueFilterBitsPerKey =
+      config.rocksDbSmallValueFilterBitsPerKey.getValue();
+  tuning.smallValueCompression =
+      config.rocksDbSmallValueCompression.getValue();
+  tuning.accessSketchBits = config.localStoreGcAccessSketchBits.getValue();
+  return tuning;
+}
+
+void RocksDbLocalStore::repairDB(
+    AbsolutePathPiece path,
+    const RocksDbTuning& tuning) {
   XLOG(ERR) << "Attempting to repair RocksDB " << path;
   rocksdb::ColumnFamilyOptions unknownColumFamilyOptions;
   unknownColumFamilyOptions.OptimizeForPointLookup(8);
@@ -371,7 +626,7 @@ void RocksDbLocalStore::repairDB(AbsolutePathPiece path) {
   rocksdb::DBOptions dbOptions(getRocksdbOptions());
 
   const auto columnDescriptors =
-      columnFamilies(dbOptions, path.stringWithoutUNC());
+      columnFamilies(dbOptions, path.stringWithoutUNC(), tuning, {});
 
   auto status = RepairDB(
       dbPathStr, dbOptions, columnDescriptors, unknownColumFamilyOptions);
@@ -437,10 +692,37 @@ void RocksDbLocalStore::compactKeySpace(KeySpace keySpace) {
   }
 }
 
+void RocksDbLocalStore::forEachEntry(
+    KeySpace keySpace,
+    folly::FunctionRef<void(ByteRange key, ByteRange value)> fn) const {
+  auto handlesLock = getHandles();
+  auto& handles = handlesLock->handles;
+  ReadOptions options;
+  options.fill_cache = false;
+  std::unique_ptr<rocksdb::Iterator> it{handles->db->NewIterator(
+      options, handles->columns[keySpace->index].get())};
+  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+    auto key = it->key();
+    auto value = it->value();
+    fn(ByteRange{reinterpret_cast<const uint8_t*>(key.data()), key.size()},
+       ByteRange{reinterpret_cast<const uint8_t*>(value.data()), value.size()});
+  }
+  RocksException::check(
+      it->status(), "failed to scan the ", keySpace->name, " key space");
+}
+
+bool RocksDbLocalStore::forEachKey(
+    KeySpace keySpace,
+    folly::FunctionRef<void(ByteRange key)> fn) const {
+  forEachEntry(keySpace, [&](ByteRange key, ByteRange) { fn(key); });
+  return true;
+}
+
 StoreResult RocksDbLocalStore::get(KeySpace keySpace, ByteRange key) const {
+  recordAccess(keySpace, key);
   auto handlesLock = getHandles();
   auto& handles = handlesLock->handles;
-  string value;
+  rocksdb::PinnableSlice value;
   auto status = handles->db->Get(
       ReadOptions(),
       handles->columns[keySpace->index].get(),
@@ -460,7 +742,7 @@ StoreResult RocksDbLocalStore::get(KeySpace keySpace, ByteRange key) const {
     throw RocksException::build(
         status, "failed to get ", folly::hexlify(key), " from local store");
   }
-  return StoreResult(std::move(value));
+  return toStoreResult(std::move(value));
 }
 
 FOLLY_NODISCARD folly::Future<std::vector<StoreResult>>
@@ -473,6 +755,7 @@ RocksDbLocalStore::getBatch(
   batches.emplace_back(std::make_shared<std::vector<std::string>>());
 
   for (auto& key : keys) {
+    recordAccess(keySpace, key);
     if (batches.back()->size() >= 2048) {
       batches.emplace_back(std::make_shared<std::vector<std::string>>());
     }
@@ -490,19 +773,45 @@ RocksDbLocalStore::getBatch(
               XLOG(DBG3) << __func__ << " starting to actually do work";
               auto handlesLock = store->getHandles();
               auto& handles = handlesLock->handles;
+
+              // Give the keys to MultiGet in the column family order so it
+              // can look them up as one sorted batch without sorting them
+              // again, and remember where each of them was requested.
+              std::vector<size_t> order(keys->size());
+              std::iota(order.begin(), order.end(), size_t{0});
+              std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+                return (*keys)[a] < (*keys)[b];
+              });
+              std::vector<size_t> positions(keys->size());
               std::vector<Slice> keySlices;
-              std::vector<std::string> values;
-              std::vector<rocksdb::ColumnFamilyHandle*> columns;
-              for (auto& key : *keys) {
-                keySlices.emplace_back(key);
-                columns.emplace_back(handles->columns[keySpace->index].get());
+              keySlices.reserve(keys->size());
+              for (size_t i = 0; i < order.size(); ++i) {
+                positions[order[i]] = i;
+                keySlices.emplace_back((*keys)[order[i]]);
               }
-              auto statuses = handles->db->MultiGet(
-                  ReadOptions(), columns, keySlices, &values);
+
+              std::vector<rocksdb::PinnableSlice> values(keys->size());
+              std::vector<rocksdb::Status> statuses(keys->size());
+              ReadOptions options;
+#if ROCKSDB_MAJOR >= 7
+              // Let RocksDB read the data blocks of the batch concurrently
+              // when it was built with support for it, otherwise this is
+              // ignored.
+              options.async_io = true;
+#endif
+              handles->db->MultiGet(
+                  options,
+                  handles->columns[keySpace->index].get(),
+                  keySlices.size(),
+                  keySlices.data(),
+                  values.data(),
+                  statuses.data(),
+                  /*sorted_input=*/true);
 
               std::vector<StoreResult> results;
+              results.reserve(keys->size());
               for (size_t i = 0; i < keys->size(); ++i) {
-                auto& status = statuses[i];
+                auto& status = statuses[positions[i]];
                 if (!status.ok()) {
                   if (status.IsNotFound()) {
                     // Return an empty StoreResult
@@ -525,7 +834,8 @@ RocksDbLocalStore::getBatch(
                       folly::hexlify(keys->at(i)),
                       " from local store");
                 }
-                results.emplace_back(std::move(values[i]));
+                results.push_back(
+                    toStoreResult(std::move(values[positions[i]])));
               }
               return results;
             }));
@@ -545,6 +855,7 @@ RocksDbLocalStore::getBatch(
 }
 
 bool RocksDbLocalStore::hasKey(KeySpace keySpace, folly::ByteRange key) const {
+  recordAccess(keySpace, key);
   string value;
   auto handlesLock = getHandles();
   auto& handles = handlesLock->handles;
@@ -571,13 +882,14 @@ bool RocksDbLocalStore::hasKey(KeySpace keySpace, folly::ByteRange key) const {
 
 std::unique_ptr<LocalStore::WriteBatch> RocksDbLocalStore::beginWrite(
     size_t bufSize) {
-  return std::make_unique<RocksDbWriteBatch>(getHandles(), bufSize);
+  return std::make_unique<RocksDbWriteBatch>(*this, getHandles(), bufSize);
 }
 
 void RocksDbLocalStore::put(
     KeySpace keySpace,
     folly::ByteRange key,
     folly::ByteRange value) {
+  recordAccess(keySpace, key);
   auto handlesLock = getHandles();
   auto& handles = handlesLock->handles;
   handles->db->Put(
@@ -587,6 +899,41 @@ void RocksDbLocalStore::put(
       _createSlice(value));
 }
 
+std::map<std::string, uint64_t> RocksDbLocalStore::getMemoryUsage() const {
+  auto handlesLock = dbHandles_.rlock();
+  if (handlesLock->status != RockDbHandleStatus::OPEN) {
+    return {};
+  }
+  auto& handles = handlesLock->handles;
+
+  // The column families share some of their block caches.
+  std::unordered_set<const rocksdb::Cache*> caches;
+  for (const auto& column : handles->columns) {
+    auto options = handles->db->GetOptions(column.get());
+    if (auto* tableOptions =
+            options.table_factory
+                ->GetOptions<rocksdb::BlockBasedTableOptions>()) {
+      if (tableOptions->block_cache) {
+        caches.insert(tableOptions->block_cache.get());
+      }
+    }
+  }
+
+  std::map<rocksdb::MemoryUtil::UsageType, uint64_t> usage;
+  auto status = rocksdb::MemoryUtil::GetApproximateMemoryUsageByType(
+      {handles->db.get()}, caches, &usage);
+  if (!status.ok()) {
+    XLOG(WARN) << "unable to retrieve memory usage from RocksDB: "
+               << status.ToString();
+    return {};
+  }
+  return {
+      {"memtables", usage[rocksdb::MemoryUtil::kMemTableTotal]},
+      {"table_readers", usage[rocksdb::MemoryUtil::kTableReadersTotal]},
+      {"block_caches", usage[rocksdb::MemoryUtil::kCacheTotal]},
+  };
+}
+
 uint64_t RocksDbLocalStore::getApproximateSize(KeySpace keySpace) const {
   auto handlesLock = getHandles();
   auto& handles = handlesLock->handles;
@@ -609,6 +956,19 @@ uint64_t RocksDbLocalStore::getApproximateSize(KeySpace keySpace) const {
                << handles->columns[keySpace->index]->GetName();
   }
 
+  // Values kept in blob files are not part of the SST files.
+  uint64_t blobFilesSize;
+  result = handles->db->GetIntProperty(
+      handles->columns[keySpace->index].get(),
+      rocksdb::DB::Properties::kLiveBlobFileSize,
+      &blobFilesSize);
+  if (result) {
+    size += blobFilesSize;
+  } else {
+    XLOG(WARN) << "unable to retrieve blob file size from RocksDB for key "
+               << "space " << handles->columns[keySpace->index]->GetName();
+  }
+
   // kSizeAllMemTables reports the size of the memtables.
   // This is the in-memory space for tracking the data in *.log files that have
   // not yet been compacted into a .sst file.
@@ -656,7 +1016,7 @@ void RocksDbLocalStore::periodicManagementTask(const EdenConfig& config) {
                << "ephemeral data sizes of columns " << keySpaceNames
                << " exceed their limits; total ephemeral size = "
                << before.ephemeral;
-    triggerAutoGC(before);
+    triggerAutoGC(before, config);
   }
 }
 
@@ -701,7 +1061,92 @@ RocksDbLocalStore::SizeSummary RocksDbLocalStore::computeStats(
 // code, but the gc operation can take a significant amount of time, and it
 // seems unfortunate to tie up one of the main pool threads for potentially
 // multiple minutes.
-void RocksDbLocalStore::triggerAutoGC(SizeSummary before) {
+void RocksDbLocalStore::recordAccess(
+    KeySpace keySpace,
+    folly::ByteRange key) const {
+  if (keySpace->index < accessFilters_.size()) {
+    if (auto& filter = accessFilters_[keySpace->index]) {
+      filter->sketch.record(key);
+    }
+  }
+}
+
+void RocksDbLocalStore::collectKeySpace(
+    KeySpace keySpace,
+    uint64_t limit,
+    std::chrono::nanoseconds sliceInterval) {
+  auto size = getApproximateSize(keySpace);
+  auto* filter = keySpace->index < accessFilters_.size()
+      ? accessFilters_[keySpace->index].get()
+      : nullptr;
+  // Evicting the entries that were not accessed recently can't be expected
+  // to bring the key space back under its limit when it is this far over.
+  if (!filter || size / 2 > limit) {
+    XLOG(INFO) << "clearing local store key space " << keySpace->name
+               << ": size = " << size << ", limit = " << limit;
+    clearKeySpace(keySpace);
+    compactKeySpace(keySpace);
+    return;
+  }
+
+  // Everything that was accessed since the previous collection is kept, and
+  // will be tracked for one more.
+  filter->sketch.startEpoch();
+  filter->collecting.store(true, std::memory_order_release);
+  SCOPE_EXIT {
+    filter->collecting.store(false, std::memory_order_release);
+  };
+
+  auto handlesLock = getHandles();
+  auto& handles = handlesLock->handles;
+  auto* column = handles->columns[keySpace->index].get();
+  rocksdb::CompactRangeOptions options;
+  // The bottommost level holds most of the data, and would not be rewritten
+  // otherwise.
+  options.bottommost_level_compaction =
+      rocksdb::BottommostLevelCompaction::kForce;
+
+  size_t slices = 0;
+  while (slices < kGcSliceCount && size > limit) {
+    // Start where the previous collection stopped, to not always evict from
+    // the same part of the key space.
+    auto slice = filter->nextSlice;
+    filter->nextSlice = (filter->nextSlice + 1) % kGcSliceCount;
+    ++slices;
+
+    std::string beginStorage(1, static_cast<char>(slice * 256 / kGcSliceCount));
+    std::string endStorage(
+        1, static_cast<char>((slice + 1) * 256 / kGcSliceCount));
+    Slice begin{beginStorage};
+    Slice end{endStorage};
+    auto status = handles->db->CompactRange(
+        options,
+        column,
+        slice == 0 ? nullptr : &begin,
+        slice + 1 == kGcSliceCount ? nullptr : &end);
+    if (!status.ok()) {
+      throw RocksException::build(
+          status,
+          "error collecting \"",
+          column->GetName(),
+          "\" column family");
+    }
+
+    size = getApproximateSize(keySpace);
+    if (size > limit && slices < kGcSliceCount) {
+      // Leave room for the other users of the disk.
+      /* sleep override */ std::this_thread::sleep_for(sliceInterval);
+    }
+  }
+
+  XLOG(INFO) << "collected " << slices << "/" << kGcSliceCount
+             << " of local store key space " << keySpace->name
+             << ": size = " << size << ", limit = " << limit;
+}
+
+void RocksDbLocalStore::triggerAutoGC(
+    SizeSummary before,
+    const EdenConfig& config) {
   {
     auto state = autoGCState_.wlock();
     if (state->inProgress_) {
@@ -720,12 +1165,19 @@ void RocksDbLocalStore::triggerAutoGC(SizeSummary before) {
     state->inProgress_ = true;
   }
 
-  ioPool_.add([store = getSharedFromThis(), before] {
+  std::array<uint64_t, KeySpace::kTotalCount> limits{};
+  for (auto& ks : KeySpace::kAll) {
+    if (auto* ephemeral = std::get_if<Ephemeral>(&ks->persistence)) {
+      limits[ks->index] = (config.*(ephemeral->cacheLimit)).getValue();
+    }
+  }
+  auto sliceInterval = config.localStoreGcSliceInterval.getValue();
+
+  ioPool_.add([store = getSharedFromThis(), before, limits, sliceInterval] {
     try {
       for (auto& ks : KeySpace::kAll) {
         if (before.excessiveKeySpaces.test(ks->index)) {
-          store->clearKeySpace(ks);
-          store->compactKeySpace(ks);
+          store->collectKeySpace(ks, limits[ks->index], sliceInterval);
         }
       }
     } catch (const std::exception& ex) {
@@ -744,6 +1196,7 @@ void RocksDbLocalStore::autoGCFinished(
   auto ephemeralSizeAfter =
       computeStats(/*publish=*/false, /*config=*/nullptr).ephemeral;
 
+  gcCount_.fetch_add(1, std::memory_order_release);
   auto state = autoGCState_.wlock();
   state->inProgress_ = false;
 
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <folly/CppAttributes.h>
+#include <folly/Function.h>
 #include <folly/Synchronized.h>
 #include <bitset>
 
@@ -20,6 +21,27 @@ namespace facebook::eden {
 class FaultInjector;
 class StructuredLogger;
 
+/**
+ * How the column families of a RocksDbLocalStore are laid out, depending on
+ * the StorageProfile of their key space.
+ */
+struct RocksDbTuning {
+  static RocksDbTuning fromConfig(const EdenConfig& config);
+
+  // Values of LargeValues key spaces of at least minBlobSize bytes are kept
+  // in blob files, out of the LSM tree.
+  bool enableBlobFiles{true};
+  uint64_t minBlobSize{4096};
+  LocalStoreCompression blobCompression{LocalStoreCompression::LZ4};
+  // Zero uses bloom filters, like the other key spaces.
+  double smallValueFilterBitsPerKey{10.0};
+  LocalStoreCompression smallValueCompression{LocalStoreCompression::None};
+  // Bits of the sketch tracking the recent accesses to each ephemeral key
+  // space, per epoch. Zero makes the garbage collection clear whole key
+  // spaces rather than evict their entries that were not recently accessed.
+  uint64_t accessSketchBits{8 * 1024 * 1024};
+};
+
 /** An implementation of LocalStore that uses RocksDB for the underlying
  * storage.
  */
@@ -33,7 +55,8 @@ class RocksDbLocalStore final : public LocalStore {
       AbsolutePathPiece pathToRocksDb,
       std::shared_ptr<StructuredLogger> structuredLogger,
       FaultInjector* FOLLY_NONNULL faultInjector,
-      RocksDBOpenMode mode = RocksDBOpenMode::ReadWrite);
+      RocksDBOpenMode mode = RocksDBOpenMode::ReadWrite,
+      RocksDbTuning tuning = RocksDbTuning{});
   void open() override;
   ~RocksDbLocalStore();
   void close() override;
@@ -49,14 +72,46 @@ class RocksDbLocalStore final : public LocalStore {
   std::unique_ptr<WriteBatch> beginWrite(size_t bufSize = 0) override;
 
   // Call RocksDB's RepairDB() function on the DB at the specified location
-  static void repairDB(AbsolutePathPiece path);
+  static void repairDB(
+      AbsolutePathPiece path,
+      const RocksDbTuning& tuning = RocksDbTuning{});
 
   // Get the approximate number of bytes stored on disk for the
   // specified key space.
   uint64_t getApproximateSize(KeySpace keySpace) const;
 
+  /**
+   * Call fn with every entry of the key space, in key order. This reads the
+   * whole key space without polluting the block cache, and is meant for
+   * offline analysis rather than for serving requests.
+   */
+  void forEachEntry(
+      KeySpace keySpace,
+      folly::FunctionRef<void(folly::ByteRange key, folly::ByteRange value)>
+          fn) const;
+
+  bool forEachKey(
+      KeySpace keySpace,
+      folly::FunctionRef<void(folly::ByteRange key)> fn) const override;
+
+  uint64_t getGarbageCollectionCount() const override {
+    return gcCount_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * The memtables, the table readers (indexes and filters) and the block
+   * caches.
+   */
+  std::map<std::string, uint64_t> getMemoryUsage() const override;
+
   void periodicManagementTask(const EdenConfig& config) override;
 
+  /**
+   * Record that the given key was read or written, so that the garbage
+   * collection keeps it.
+   */
+  void recordAccess(KeySpace keySpace, folly::ByteRange key) const;
+
   enum class RockDbHandleStatus { NOT_YET_OPENED, OPEN, CLOSED };
 
   struct RockDBState {
@@ -117,7 +172,19 @@ class RocksDbLocalStore final : public LocalStore {
    */
   SizeSummary computeStats(bool publish, const EdenConfig* config);
 
-  void triggerAutoGC(SizeSummary before);
+  void triggerAutoGC(SizeSummary before, const EdenConfig& config);
+
+  /**
+   * Bring the key space under limit, evicting the entries that were not
+   * accessed since the previous collection, a slice of the key space at a
+   * time and pausing for sliceInterval in between. Clear the whole key space
+   * instead if it's not tracking accesses or is more than twice over its
+   * limit.
+   */
+  void collectKeySpace(
+      KeySpace keySpace,
+      uint64_t limit,
+      std::chrono::nanoseconds sliceInterval);
   void autoGCFinished(bool successful, uint64_t ephemeralSizeBefore);
 
   std::shared_ptr<StructuredLogger> structuredLogger_;
@@ -125,8 +192,14 @@ class RocksDbLocalStore final : public LocalStore {
   FaultInjector& faultInjector_;
   mutable UnboundedQueueExecutor ioPool_;
   folly::Synchronized<AutoGCState> autoGCState_;
+  std::atomic<uint64_t> gcCount_{0};
   AbsolutePath pathToDb_;
   RocksDBOpenMode mode_;
+  const RocksDbTuning tuning_;
+  class AccessFilterFactory;
+  // Indexed by key space, null for the key spaces that are not ephemeral.
+  // Empty if accesses are not tracked.
+  std::vector<std::shared_ptr<AccessFilterFactory>> accessFilters_;
   folly::Synchronized<RockDBState> dbHandles_;
 };
 
@@ -11,6 +11,7 @@
 #include <folly/container/Array.h>
 #include <folly/logging/xlog.h>
 
+#include "eden/fs/sqlite/PersistentSqliteStatement.h"
 #include "eden/fs/sqlite/SqliteStatement.h"
 #include "eden/fs/store/StoreResult.h"
 
@@ -101,7 +102,12 @@ class SqliteWriteBatch : public LocalStore::WriteBatch {
 } // namespace
 
 SqliteLocalStore::SqliteLocalStore(AbsolutePathPiece pathToDb)
-    : db_(pathToDb, SqliteDatabase::DelayOpeningDB{}) {}
+    : SqliteLocalStore(pathToDb, SqliteDatabase::Options{}) {}
+
+SqliteLocalStore::SqliteLocalStore(
+    AbsolutePathPiece pathToDb,
+    SqliteDatabase::Options options)
+    : db_(pathToDb, SqliteDatabase::DelayOpeningDB{}, options) {}
 
 void SqliteLocalStore::open() {
   db_.openDb();
@@ -143,17 +149,19 @@ void SqliteLocalStore::clearKeySpace(KeySpace keySpace) {
 void SqliteLocalStore::compactKeySpace(KeySpace) {}
 
 StoreResult SqliteLocalStore::get(KeySpace keySpace, ByteRange key) const {
-  auto db = db_.lock();
+  auto db = db_.lockRead();
 
-  SqliteStatement stmt(
-      db, "select value from ", keySpace->name, " where key = ?");
+  auto stmt = PersistentSqliteStatement::getCached(
+      db,
+      folly::to<std::string>(
+          "select value from ", keySpace->name, " where key = ?"));
 
   // Bind the key; parameters are 1-based
-  stmt.bind(1, key);
+  stmt->bind(1, key);
 
-  if (stmt.step()) {
+  if (stmt->step()) {
     // Return the result; columns are 0-based!
-    return StoreResult(stmt.columnBlob(0).str());
+    return StoreResult(stmt->columnBlob(0).str());
   }
 
   // the key does not exist
@@ -161,12 +169,15 @@ StoreResult SqliteLocalStore::get(KeySpace keySpace, ByteRange key) const {
 }
 
 bool SqliteLocalStore::hasKey(KeySpace keySpace, ByteRange key) const {
-  auto db = db_.lock();
+  auto db = db_.lockRead();
 
-  SqliteStatement stmt(db, "select 1 from ", keySpace->name, " where key = ?");
+  auto stmt = PersistentSqliteStatement::getCached(
+      db,
+      folly::to<std::string>(
+          "select 1 from ", keySpace->name, " where key = ?"));
 
-  stmt.bind(1, key);
-  return stmt.step();
+  stmt->bind(1, key);
+  return stmt->step();
 }
 
 void SqliteLocalStore::put(KeySpace keySpace, ByteRange key, ByteRange value) {
@@ -19,6 +19,7 @@ namespace facebook::eden {
 class SqliteLocalStore final : public LocalStore {
  public:
   explicit SqliteLocalStore(AbsolutePathPiece pathToDb);
+  SqliteLocalStore(AbsolutePathPiece pathToDb, SqliteDatabase::Options options);
   void open() override;
   void close() override;
   void clearKeySpace(KeySpace keySpace) override;
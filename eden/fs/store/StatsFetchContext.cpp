@@ -25,7 +25,8 @@ StatsFetchContext::StatsFetchContext(const StatsFetchContext& other)
     : clientPid_{other.clientPid_},
       cause_{other.cause_},
       causeDetail_{other.causeDetail_},
-      requestInfo_{other.requestInfo_} {
+      requestInfo_{other.requestInfo_},
+      cancellation_{other.cancellation_} {
   for (size_t y = 0; y < ObjectFetchContext::kObjectTypeEnumMax; ++y) {
     for (size_t x = 0; x < ObjectFetchContext::kOriginEnumMax; ++x) {
       // This could almost certainly use a more relaxed memory ordering.
@@ -38,7 +39,8 @@ StatsFetchContext::StatsFetchContext(StatsFetchContext&& other) noexcept
     : clientPid_{other.clientPid_},
       cause_{other.cause_},
       causeDetail_{other.causeDetail_},
-      requestInfo_{std::move(other.requestInfo_)} {
+      requestInfo_{std::move(other.requestInfo_)},
+      cancellation_{std::move(other.cancellation_)} {
   for (size_t y = 0; y < ObjectFetchContext::kObjectTypeEnumMax; ++y) {
     for (size_t x = 0; x < ObjectFetchContext::kOriginEnumMax; ++x) {
       // This could almost certainly use a more relaxed memory ordering.
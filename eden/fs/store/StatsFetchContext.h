@@ -74,6 +74,17 @@ class StatsFetchContext : public ObjectFetchContext {
     return &requestInfo_;
   }
 
+  folly::CancellationToken getCancellationToken() const override {
+    return cancellation_;
+  }
+
+  /**
+   * Must be set before the context is used to fetch.
+   */
+  void setCancellationToken(folly::CancellationToken cancellation) {
+    cancellation_ = std::move(cancellation);
+  }
+
  private:
   std::atomic<uint64_t> counts_[ObjectFetchContext::kObjectTypeEnumMax]
                                [ObjectFetchContext::kOriginEnumMax] = {};
@@ -81,6 +92,7 @@ class StatsFetchContext : public ObjectFetchContext {
   Cause cause_ = Cause::Unknown;
   std::string_view causeDetail_;
   std::unordered_map<std::string, std::string> requestInfo_;
+  folly::CancellationToken cancellation_;
 };
 
 using StatsFetchContextPtr = RefPtr<StatsFetchContext>;
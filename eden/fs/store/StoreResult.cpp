@@ -31,13 +31,33 @@ StoreResult StoreResult::missing(KeySpace keySpace, folly::ByteRange key) {
           keySpace->name)};
 }
 
+StoreResult::StoreResult(folly::IOBuf data) : valid_{true} {
+  data.coalesce();
+  buf_ = std::move(data);
+}
+
 IOBuf StoreResult::iobufWrapper() const {
   ensureValid();
   return IOBuf{IOBuf::WRAP_BUFFER, bytes()};
 }
 
+std::string StoreResult::extractValue() {
+  ensureValid();
+  valid_ = false;
+  if (buf_) {
+    std::string value{
+        reinterpret_cast<const char*>(buf_->data()), buf_->length()};
+    buf_.reset();
+    return value;
+  }
+  return std::move(data_);
+}
+
 folly::IOBuf StoreResult::extractIOBuf() {
   ensureValid();
+  if (buf_) {
+    return std::exchange(buf_, std::nullopt).value();
+  }
 
   // Unfortunately RocksDB returns data to us in a std::string.  This makes it
   // difficult for us to control the lifetime.  We end up having to allocate a
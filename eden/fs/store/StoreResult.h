@@ -8,13 +8,11 @@
 #pragma once
 
 #include <folly/Range.h>
+#include <folly/io/IOBuf.h>
+#include <optional>
 #include <string>
 #include <utility>
 
-namespace folly {
-class IOBuf;
-}
-
 namespace facebook::eden {
 
 class KeySpace;
@@ -22,15 +20,16 @@ class KeySpace;
 /*
  * StoreResult contains the result of a LocalStore lookup.
  *
- * RocksDB returns the data in a std::string (which is somewhat unfortunate,
- * since it gives us relatively poor memory management control).
+ * The data is either a std::string, or an IOBuf when the store can hand out
+ * its memory without copying it, such as a RocksDB read buffer or a value
+ * shared with an in-memory store.
  *
- * This class is a wrapper around the returned string, with a few benefits:
+ * This class is a wrapper around the returned data, with a few benefits:
  * - It can also represent a "not found" result, so we can efficiently handle
  *   key lookups that are not present, without throwing an exception.
  * - It is move-only, so prevents us from ever unintentionally copying the
- *   string data.
- * - It provides APIs for creating IOBuf objects around the string result.
+ *   data.
+ * - It provides APIs for creating IOBuf objects around the result.
  */
 class StoreResult {
  public:
@@ -44,10 +43,17 @@ class StoreResult {
    */
   explicit StoreResult(std::string data) : StoreResult{true, std::move(data)} {}
 
+  /**
+   * Construct a StoreResult from payload data held in an IOBuf, without
+   * copying it unless it is chained, in which case it is coalesced.
+   */
+  explicit StoreResult(folly::IOBuf data);
+
   StoreResult(StoreResult&& that) noexcept
       : valid_{false}, data_{"moved-from"} {
     std::swap(valid_, that.valid_);
     std::swap(data_, that.data_);
+    std::swap(buf_, that.buf_);
   }
 
   StoreResult& operator=(StoreResult&& that) noexcept {
@@ -55,6 +61,7 @@ class StoreResult {
     // Allocate the new std::string before performing the no-except swaps.
     valid_ = std::exchange(that.valid_, false);
     data_ = std::exchange(that.data_, std::move(data));
+    buf_ = std::exchange(that.buf_, std::nullopt);
     return *this;
   }
 
@@ -66,16 +73,6 @@ class StoreResult {
     return valid_;
   }
 
-  /**
-   * Get a reference to the std::string result.
-   *
-   * Throws std::domain_error if the key was not present in the store.
-   */
-  const std::string& asString() const {
-    ensureValid();
-    return data_;
-  }
-
   /**
    * Get a ByteRange pointing to the result.
    *
@@ -83,6 +80,9 @@ class StoreResult {
    */
   folly::ByteRange bytes() const {
     ensureValid();
+    if (buf_) {
+      return folly::ByteRange{buf_->data(), buf_->length()};
+    }
     return folly::StringPiece{data_};
   }
 
@@ -92,8 +92,7 @@ class StoreResult {
    * Throws std::domain_error if the key was not present in the store.
    */
   folly::StringPiece piece() const {
-    ensureValid();
-    return folly::StringPiece{data_};
+    return folly::StringPiece{bytes()};
   }
 
   /**
@@ -106,13 +105,10 @@ class StoreResult {
   folly::IOBuf iobufWrapper() const;
 
   /**
-   * Extract the std::string contained in this StoreResult.
+   * Extract the data as a std::string. This copies the data when it is held
+   * in an IOBuf.
    */
-  std::string extractValue() {
-    ensureValid();
-    valid_ = false;
-    return std::move(data_);
-  }
+  std::string extractValue();
 
   /**
    * Extract the data as an IOBuf.
@@ -120,9 +116,9 @@ class StoreResult {
    * This will return a managed IOBuf, which will free the result data when
    * the last IOBuf clone is destroyed.
    *
-   * This does require a memory allocation to move the stored std::string onto
-   * the heap (but it just does a small allocation for the string object
-   * itself, and not the string data).
+   * When the data is a std::string, this does require a memory allocation to
+   * move it onto the heap (but it just does a small allocation for the string
+   * object itself, and not the string data).
    */
   folly::IOBuf extractIOBuf();
 
@@ -147,12 +143,14 @@ class StoreResult {
   [[noreturn]] void throwInvalidError() const;
 
   /**
-   * If true, data_ contains the payload from the store.
-   * If false, it contains an error message that includes context about what was
-   * looked up.
+   * If true, data_ or buf_ contains the payload from the store.
+   * If false, data_ contains an error message that includes context about what
+   * was looked up.
    */
   bool valid_{false};
   std::string data_;
+  /** A single, unchained buffer. */
+  std::optional<folly::IOBuf> buf_;
 };
 
 } // namespace facebook::eden
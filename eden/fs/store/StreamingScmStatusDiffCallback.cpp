@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/StreamingScmStatusDiffCallback.h"
+
+#include <algorithm>
+#include <utility>
+
+#include <folly/logging/xlog.h>
+
+namespace facebook::eden {
+
+StreamingScmStatusDiffCallback::StreamingScmStatusDiffCallback(
+    size_t chunkSize,
+    size_t maxPendingChunks)
+    : chunkSize_{std::max<size_t>(chunkSize, 1)},
+      maxPendingChunks_{std::max<size_t>(maxPendingChunks, 1)} {}
+
+void StreamingScmStatusDiffCallback::ignoredPath(
+    RelativePathPiece path,
+    dtype_t type) {
+  if (type != dtype_t::Dir) {
+    addEntry(path, ScmFileStatus::IGNORED);
+  }
+}
+
+void StreamingScmStatusDiffCallback::addedPath(
+    RelativePathPiece path,
+    dtype_t type) {
+  if (type != dtype_t::Dir) {
+    addEntry(path, ScmFileStatus::ADDED);
+  }
+}
+
+void StreamingScmStatusDiffCallback::removedPath(
+    RelativePathPiece path,
+    dtype_t type) {
+  if (type != dtype_t::Dir) {
+    addEntry(path, ScmFileStatus::REMOVED);
+  }
+}
+
+void StreamingScmStatusDiffCallback::modifiedPath(
+    RelativePathPiece path,
+    dtype_t type) {
+  if (type != dtype_t::Dir) {
+    addEntry(path, ScmFileStatus::MODIFIED);
+  }
+}
+
+void StreamingScmStatusDiffCallback::diffError(
+    RelativePathPiece path,
+    const folly::exception_wrapper& ew) {
+  XLOG(WARNING) << "error computing status data for " << path << ": "
+                << folly::exceptionStr(ew);
+  addError(path, folly::exceptionStr(ew).toStdString());
+}
+
+void StreamingScmStatusDiffCallback::addEntry(
+    RelativePathPiece path,
+    ScmFileStatus status) {
+  std::unique_lock lock{mutex_};
+  if (cancelled_) {
+    return;
+  }
+  current_.entries()->emplace(path.asString(), status);
+  if (++currentSize_ >= chunkSize_) {
+    flushLocked(lock);
+  }
+}
+
+void StreamingScmStatusDiffCallback::addError(
+    RelativePathPiece path,
+    std::string message) {
+  std::unique_lock lock{mutex_};
+  if (cancelled_) {
+    return;
+  }
+  current_.errors()->emplace(path.asString(), std::move(message));
+  if (++currentSize_ >= chunkSize_) {
+    flushLocked(lock);
+  }
+}
+
+void StreamingScmStatusDiffCallback::flushLocked(
+    std::unique_lock<std::mutex>& lock) {
+  auto chunk = std::exchange(current_, ScmStatusChunk{});
+  currentSize_ = 0;
+
+  if (waiter_) {
+    // Chunks are only queued while no consumer waits, so this one is next.
+    auto waiter = std::move(*waiter_);
+    waiter_.reset();
+    // The consumer may ask for the next chunk from the continuation.
+    lock.unlock();
+    waiter.setValue(std::move(chunk));
+    lock.lock();
+    return;
+  }
+
+  pending_.push_back(std::move(chunk));
+  roomAvailable_.wait(lock, [this] {
+    return cancelled_ || pending_.size() < maxPendingChunks_;
+  });
+}
+
+void StreamingScmStatusDiffCallback::finish(folly::exception_wrapper error) {
+  std::unique_lock lock{mutex_};
+  finished_ = true;
+  error_ = std::move(error);
+  if (!waiter_) {
+    return;
+  }
+
+  auto waiter = std::move(*waiter_);
+  waiter_.reset();
+  if (currentSize_ > 0) {
+    auto chunk = std::exchange(current_, ScmStatusChunk{});
+    currentSize_ = 0;
+    lock.unlock();
+    waiter.setValue(std::move(chunk));
+  } else if (error_) {
+    auto ew = error_;
+    lock.unlock();
+    waiter.setException(std::move(ew));
+  } else {
+    lock.unlock();
+    waiter.setValue(std::nullopt);
+  }
+}
+
+void StreamingScmStatusDiffCallback::cancel() {
+  std::optional<folly::Promise<std::optional<ScmStatusChunk>>> waiter;
+  {
+    std::lock_guard lock{mutex_};
+    cancelled_ = true;
+    pending_.clear();
+    current_ = ScmStatusChunk{};
+    currentSize_ = 0;
+    waiter = std::exchange(waiter_, std::nullopt);
+  }
+  roomAvailable_.notify_all();
+  if (waiter) {
+    waiter->setValue(std::nullopt);
+  }
+}
+
+folly::SemiFuture<std::optional<ScmStatusChunk>>
+StreamingScmStatusDiffCallback::next() {
+  std::unique_lock lock{mutex_};
+  if (!pending_.empty()) {
+    auto chunk = std::move(pending_.front());
+    pending_.pop_front();
+    lock.unlock();
+    roomAvailable_.notify_all();
+    return std::optional<ScmStatusChunk>{std::move(chunk)};
+  }
+  if (cancelled_) {
+    return std::optional<ScmStatusChunk>{};
+  }
+  if (finished_) {
+    if (currentSize_ > 0) {
+      currentSize_ = 0;
+      return std::optional<ScmStatusChunk>{
+          std::exchange(current_, ScmStatusChunk{})};
+    }
+    if (error_) {
+      return folly::SemiFuture<std::optional<ScmStatusChunk>>{error_};
+    }
+    return std::optional<ScmStatusChunk>{};
+  }
+
+  auto [promise, future] =
+      folly::makePromiseContract<std::optional<ScmStatusChunk>>();
+  waiter_ = std::move(promise);
+  return std::move(future);
+}
+
+} // namespace facebook::eden
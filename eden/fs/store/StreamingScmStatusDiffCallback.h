@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+#include <folly/ExceptionWrapper.h>
+#include <folly/futures/Future.h>
+
+#include "eden/fs/service/gen-cpp2/streamingeden_types.h"
+#include "eden/fs/store/DiffCallback.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/**
+ * A DiffCallback that hands out the status in chunks as the diff finds them,
+ * rather than accumulating all of it like ScmStatusDiffCallback does.
+ *
+ * Chunks hold up to chunkSize entries and errors. Once maxPendingChunks
+ * chunks are waiting to be consumed, the diff threads reporting more
+ * differences block until the consumer catches up or cancels, which bounds
+ * the memory of the status to that of these chunks.
+ */
+class StreamingScmStatusDiffCallback : public DiffCallback {
+ public:
+  StreamingScmStatusDiffCallback(size_t chunkSize, size_t maxPendingChunks);
+
+  void ignoredPath(RelativePathPiece path, dtype_t type) override;
+  void addedPath(RelativePathPiece path, dtype_t type) override;
+  void removedPath(RelativePathPiece path, dtype_t type) override;
+  void modifiedPath(RelativePathPiece path, dtype_t type) override;
+
+  void diffError(RelativePathPiece path, const folly::exception_wrapper& ew)
+      override;
+
+  /**
+   * Signal that the diff completed, with the error that failed it if any.
+   * The last partial chunk is then handed out, followed by the error.
+   */
+  void finish(folly::exception_wrapper error = {});
+
+  /**
+   * Stop handing out chunks, and unblock the diff threads. Differences found
+   * afterwards are dropped.
+   */
+  void cancel();
+
+  /**
+   * Returns the next chunk once one is complete, or std::nullopt once the
+   * diff finished and all of its chunks were consumed. The future fails with
+   * the error of the diff if it failed.
+   *
+   * Must not be called again before the previously returned future completes.
+   */
+  folly::SemiFuture<std::optional<ScmStatusChunk>> next();
+
+ private:
+  void addEntry(RelativePathPiece path, ScmFileStatus status);
+  void addError(RelativePathPiece path, std::string message);
+
+  /**
+   * Hand the current chunk to the waiting consumer, or queue it and wait for
+   * room in the queue. Called with the lock held, which is released while
+   * waiting and while fulfilling the consumer.
+   */
+  void flushLocked(std::unique_lock<std::mutex>& lock);
+
+  const size_t chunkSize_;
+  const size_t maxPendingChunks_;
+
+  std::mutex mutex_;
+  std::condition_variable roomAvailable_;
+  ScmStatusChunk current_;
+  size_t currentSize_{0};
+  std::deque<ScmStatusChunk> pending_;
+  std::optional<folly::Promise<std::optional<ScmStatusChunk>>> waiter_;
+  bool finished_{false};
+  bool cancelled_{false};
+  folly::exception_wrapper error_;
+};
+
+} // namespace facebook::eden
@@ -0,0 +1,354 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/TieredLocalStore.h"
+
+#include <folly/String.h>
+#include <folly/futures/Future.h>
+#include <folly/hash/Hash.h>
+#include <folly/logging/xlog.h>
+
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/store/StoreResult.h"
+
+namespace facebook::eden {
+
+namespace {
+constexpr size_t kShardCount = 16;
+} // namespace
+
+/**
+ * Sends the writes of the tiered key spaces through the TieredLocalStore,
+ * and the others to a write batch of the on-disk store.
+ */
+class TieredWriteBatch : public LocalStore::WriteBatch {
+ public:
+  TieredWriteBatch(
+      TieredLocalStore& store,
+      std::unique_ptr<LocalStore::WriteBatch> diskBatch)
+      : store_{store}, diskBatch_{std::move(diskBatch)} {}
+
+  void put(KeySpace keySpace, folly::ByteRange key, folly::ByteRange value)
+      override {
+    if (TieredLocalStore::isTiered(keySpace) && keySpace->isEphemeral()) {
+      store_.put(keySpace, key, value);
+      return;
+    }
+    if (TieredLocalStore::isTiered(keySpace)) {
+      store_.insertHot(
+          TieredLocalStore::makeHotKey(keySpace, key),
+          folly::StringPiece{value}.str());
+    }
+    diskBatch_->put(keySpace, key, value);
+  }
+
+  void put(
+      KeySpace keySpace,
+      folly::ByteRange key,
+      std::vector<folly::ByteRange> valueSlices) override {
+    if (!TieredLocalStore::isTiered(keySpace)) {
+      diskBatch_->put(keySpace, key, std::move(valueSlices));
+      return;
+    }
+    std::string value;
+    for (const auto& slice : valueSlices) {
+      value.append(reinterpret_cast<const char*>(slice.data()), slice.size());
+    }
+    put(keySpace, key, folly::StringPiece{value});
+  }
+
+  void flush() override {
+    diskBatch_->flush();
+  }
+
+ private:
+  TieredLocalStore& store_;
+  std::unique_ptr<LocalStore::WriteBatch> diskBatch_;
+};
+
+TieredLocalStore::TieredLocalStore(
+    std::shared_ptr<LocalStore> diskStore,
+    size_t hotEntries,
+    size_t writeBackBatchSize)
+    : diskStore_{std::move(diskStore)},
+      writeBackBatchSize_{writeBackBatchSize},
+      writeBackPool_{1, "TieredLocalStore"} {
+  auto entriesPerShard = std::max<size_t>(hotEntries / kShardCount, 1);
+  shards_.reserve(kShardCount);
+  for (size_t i = 0; i < kShardCount; ++i) {
+    shards_.push_back(std::make_unique<folly::Synchronized<HotTier>>(
+        folly::in_place, entriesPerShard));
+  }
+}
+
+TieredLocalStore::~TieredLocalStore() = default;
+
+bool TieredLocalStore::isTiered(KeySpace keySpace) {
+  return keySpace->profile == StorageProfile::SmallValues;
+}
+
+std::string TieredLocalStore::makeHotKey(
+    KeySpace keySpace,
+    folly::ByteRange key) {
+  std::string hotKey;
+  hotKey.reserve(key.size() + 1);
+  hotKey.push_back(static_cast<char>(keySpace->index));
+  hotKey.append(reinterpret_cast<const char*>(key.data()), key.size());
+  return hotKey;
+}
+
+folly::Synchronized<TieredLocalStore::HotTier>& TieredLocalStore::shardOf(
+    const std::string& hotKey) const {
+  return *shards_[folly::hash::fnv64(hotKey) % kShardCount];
+}
+
+std::optional<std::string> TieredLocalStore::findInMemory(
+    const std::string& hotKey) const {
+  {
+    // Hits reorder the LRU list, even a lookup needs the write lock.
+    auto shard = shardOf(hotKey).wlock();
+    auto it = shard->find(hotKey);
+    if (it != shard->end()) {
+      return it->second;
+    }
+  }
+  auto pending = pending_.rlock();
+  auto it = pending->values.find(hotKey);
+  if (it != pending->values.end()) {
+    return it->second;
+  }
+  return std::nullopt;
+}
+
+void TieredLocalStore::insertHot(std::string hotKey, std::string value)
+    const {
+  auto& shard = shardOf(hotKey);
+  shard.wlock()->set(std::move(hotKey), std::move(value));
+}
+
+void TieredLocalStore::open() {
+  diskStore_->open();
+}
+
+void TieredLocalStore::close() {
+  flushPendingWrites();
+  diskStore_->close();
+}
+
+void TieredLocalStore::clearKeySpace(KeySpace keySpace) {
+  if (isTiered(keySpace)) {
+    auto prefix = static_cast<char>(keySpace->index);
+    for (auto& shard : shards_) {
+      auto locked = shard->wlock();
+      std::vector<std::string> keys;
+      for (const auto& [hotKey, value] : *locked) {
+        if (hotKey.front() == prefix) {
+          keys.push_back(hotKey);
+        }
+      }
+      for (const auto& hotKey : keys) {
+        locked->erase(hotKey);
+      }
+    }
+    auto pending = pending_.wlock();
+    for (auto it = pending->values.begin(); it != pending->values.end();) {
+      if (it->first.front() == prefix) {
+        it = pending->values.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  diskStore_->clearKeySpace(keySpace);
+}
+
+void TieredLocalStore::compactKeySpace(KeySpace keySpace) {
+  diskStore_->compactKeySpace(keySpace);
+}
+
+StoreResult TieredLocalStore::get(KeySpace keySpace, folly::ByteRange key)
+    const {
+  if (!isTiered(keySpace)) {
+    return diskStore_->get(keySpace, key);
+  }
+
+  auto hotKey = makeHotKey(keySpace, key);
+  if (auto value = findInMemory(hotKey)) {
+    return StoreResult{std::move(*value)};
+  }
+  auto result = diskStore_->get(keySpace, key);
+  if (result.isValid()) {
+    insertHot(std::move(hotKey), result.piece().str());
+  }
+  return result;
+}
+
+folly::Future<std::vector<StoreResult>> TieredLocalStore::getBatch(
+    KeySpace keySpace,
+    const std::vector<folly::ByteRange>& keys) const {
+  if (!isTiered(keySpace)) {
+    return diskStore_->getBatch(keySpace, keys);
+  }
+
+  // Only the keys that are not in memory are looked up on disk, the results
+  // being merged back in the order of keys.
+  std::vector<std::optional<std::string>> inMemory;
+  inMemory.reserve(keys.size());
+  std::vector<folly::ByteRange> missingKeys;
+  for (const auto& key : keys) {
+    inMemory.push_back(findInMemory(makeHotKey(keySpace, key)));
+    if (!inMemory.back()) {
+      missingKeys.push_back(key);
+    }
+  }
+
+  if (missingKeys.empty()) {
+    std::vector<StoreResult> results;
+    results.reserve(inMemory.size());
+    for (auto& value : inMemory) {
+      results.emplace_back(std::move(*value));
+    }
+    return folly::makeFuture(std::move(results));
+  }
+
+  std::vector<std::string> hotKeys;
+  hotKeys.reserve(missingKeys.size());
+  for (const auto& key : missingKeys) {
+    hotKeys.push_back(makeHotKey(keySpace, key));
+  }
+  return diskStore_->getBatch(keySpace, missingKeys)
+      .thenValue([inMemory = std::move(inMemory),
+                  hotKeys = std::move(hotKeys),
+                  store = std::static_pointer_cast<const TieredLocalStore>(
+                      shared_from_this())](
+                     std::vector<StoreResult>&& loaded) mutable {
+        std::vector<StoreResult> results;
+        results.reserve(inMemory.size());
+        size_t next = 0;
+        for (auto& value : inMemory) {
+          if (value) {
+            results.emplace_back(std::move(*value));
+            continue;
+          }
+          auto& result = loaded[next];
+          if (result.isValid()) {
+            store->insertHot(std::move(hotKeys[next]), result.piece().str());
+          }
+          results.push_back(std::move(result));
+          ++next;
+        }
+        return results;
+      });
+}
+
+bool TieredLocalStore::forEachKey(
+    KeySpace keySpace,
+    folly::FunctionRef<void(folly::ByteRange key)> fn) const {
+  // The pending writes of the tiered key spaces are not on disk yet.
+  if (isTiered(keySpace)) {
+    return false;
+  }
+  return diskStore_->forEachKey(keySpace, fn);
+}
+
+bool TieredLocalStore::hasKey(KeySpace keySpace, folly::ByteRange key) const {
+  if (isTiered(keySpace) && findInMemory(makeHotKey(keySpace, key))) {
+    return true;
+  }
+  return diskStore_->hasKey(keySpace, key);
+}
+
+void TieredLocalStore::put(
+    KeySpace keySpace,
+    folly::ByteRange key,
+    folly::ByteRange value) {
+  if (!isTiered(keySpace)) {
+    diskStore_->put(keySpace, key, value);
+    return;
+  }
+
+  auto hotKey = makeHotKey(keySpace, key);
+  auto valueStr = folly::StringPiece{value}.str();
+  if (!keySpace->isEphemeral()) {
+    diskStore_->put(keySpace, key, value);
+    insertHot(std::move(hotKey), std::move(valueStr));
+    return;
+  }
+
+  insertHot(hotKey, valueStr);
+  pending_.wlock()->values.insert_or_assign(
+      std::move(hotKey), std::move(valueStr));
+  maybeScheduleFlush();
+}
+
+std::unique_ptr<LocalStore::WriteBatch> TieredLocalStore::beginWrite(
+    size_t bufSize) {
+  return std::make_unique<TieredWriteBatch>(
+      *this, diskStore_->beginWrite(bufSize));
+}
+
+void TieredLocalStore::periodicManagementTask(const EdenConfig& config) {
+  enableBlobCaching.store(
+      config.enableBlobCaching.getValue(), std::memory_order_relaxed);
+  flushPendingWrites();
+  diskStore_->periodicManagementTask(config);
+}
+
+void TieredLocalStore::maybeScheduleFlush() {
+  {
+    auto pending = pending_.wlock();
+    if (pending->flushScheduled ||
+        pending->values.size() < writeBackBatchSize_) {
+      return;
+    }
+    pending->flushScheduled = true;
+  }
+
+  writeBackPool_.add([weakStore = weak_from_this()] {
+    if (auto store = weakStore.lock()) {
+      try {
+        static_cast<TieredLocalStore&>(*store).flushPendingWrites();
+      } catch (const std::exception& ex) {
+        XLOG(ERR) << "error writing back to the local store: "
+                  << folly::exceptionStr(ex);
+      }
+    }
+  });
+}
+
+void TieredLocalStore::flushPendingWrites() {
+  folly::F14NodeMap<std::string, std::string> values;
+  {
+    auto pending = pending_.wlock();
+    values.swap(pending->values);
+    pending->flushScheduled = false;
+  }
+  if (values.empty()) {
+    return;
+  }
+
+  XLOG(DBG4) << "writing back " << values.size() << " local store entries";
+  // The entries being written are no longer pending but still in the hot
+  // tier, unless they were evicted from it, in which case they are reported
+  // missing until the batch is flushed. These are caches, losing an entry
+  // only costs fetching it again.
+  auto batch = diskStore_->beginWrite();
+  for (const auto& [hotKey, value] : values) {
+    auto* keySpace = KeySpace::kAll[static_cast<uint8_t>(hotKey.front())];
+    batch->put(
+        keySpace,
+        folly::StringPiece{hotKey}.subpiece(1),
+        folly::StringPiece{value});
+  }
+  batch->flush();
+}
+
+size_t TieredLocalStore::getPendingWriteCount() const {
+  return pending_.rlock()->values.size();
+}
+
+} // namespace facebook::eden
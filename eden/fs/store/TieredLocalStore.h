@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <folly/container/F14Map.h>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "eden/fs/store/LocalStore.h"
+#include "eden/fs/utils/UnboundedQueueExecutor.h"
+
+namespace facebook::eden {
+
+/**
+ * A LocalStore that keeps the recently used values of the SmallValues key
+ * spaces in a bounded in-memory hot tier, in front of an on-disk LocalStore.
+ * The other key spaces go straight to the on-disk store.
+ *
+ * Writes to ephemeral SmallValues key spaces are written back: they are
+ * served from memory right away and written to the on-disk store in large
+ * batches, in the background, once enough of them have accumulated, at each
+ * periodicManagementTask() and on close(). They may thus be lost if the
+ * process dies in between, which is fine for data that can be fetched again.
+ * Writes to persistent key spaces are written through, as losing them isn't.
+ *
+ * TieredLocalStore is thread safe.
+ */
+class TieredLocalStore final : public LocalStore {
+ public:
+  /**
+   * The hot tier holds up to hotEntries values, and pending writes are
+   * flushed in the background once there are writeBackBatchSize of them.
+   */
+  TieredLocalStore(
+      std::shared_ptr<LocalStore> diskStore,
+      size_t hotEntries,
+      size_t writeBackBatchSize);
+  ~TieredLocalStore() override;
+
+  void open() override;
+  void close() override;
+  void clearKeySpace(KeySpace keySpace) override;
+  bool forEachKey(
+      KeySpace keySpace,
+      folly::FunctionRef<void(folly::ByteRange key)> fn) const override;
+  uint64_t getGarbageCollectionCount() const override {
+    return diskStore_->getGarbageCollectionCount();
+  }
+  void compactKeySpace(KeySpace keySpace) override;
+  StoreResult get(KeySpace keySpace, folly::ByteRange key) const override;
+  FOLLY_NODISCARD folly::Future<std::vector<StoreResult>> getBatch(
+      KeySpace keySpace,
+      const std::vector<folly::ByteRange>& keys) const override;
+  bool hasKey(KeySpace keySpace, folly::ByteRange key) const override;
+  void put(KeySpace keySpace, folly::ByteRange key, folly::ByteRange value)
+      override;
+  std::unique_ptr<LocalStore::WriteBatch> beginWrite(
+      size_t bufSize = 0) override;
+  void periodicManagementTask(const EdenConfig& config) override;
+
+  /**
+   * Write all the pending writes to the on-disk store.
+   */
+  void flushPendingWrites();
+
+  /**
+   * Number of writes that were not yet written to the on-disk store.
+   */
+  size_t getPendingWriteCount() const;
+
+ private:
+  using HotTier = folly::EvictingCacheMap<std::string, std::string>;
+
+  struct PendingWrites {
+    // Keyed like the hot tier.
+    folly::F14NodeMap<std::string, std::string> values;
+    bool flushScheduled{false};
+  };
+
+  static bool isTiered(KeySpace keySpace);
+  static std::string makeHotKey(KeySpace keySpace, folly::ByteRange key);
+
+  folly::Synchronized<HotTier>& shardOf(const std::string& hotKey) const;
+
+  /**
+   * Look for the value in the hot tier, then in the pending writes.
+   */
+  std::optional<std::string> findInMemory(const std::string& hotKey) const;
+
+  void insertHot(std::string hotKey, std::string value) const;
+
+  /**
+   * Flush the pending writes in the background if there are enough of them.
+   */
+  void maybeScheduleFlush();
+
+  friend class TieredWriteBatch;
+
+  std::shared_ptr<LocalStore> diskStore_;
+  const size_t writeBackBatchSize_;
+  std::vector<std::unique_ptr<folly::Synchronized<HotTier>>> shards_;
+  folly::Synchronized<PendingWrites> pending_;
+  UnboundedQueueExecutor writeBackPool_;
+};
+
+} // namespace facebook::eden
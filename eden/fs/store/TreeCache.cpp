@@ -26,7 +26,10 @@ void TreeCache::insert(std::shared_ptr<const Tree> tree) {
 TreeCache::TreeCache(std::shared_ptr<ReloadableConfig> config)
       : ObjectCache<Tree, ObjectCacheFlavor::Simple>{
             config->getEdenConfig()->inMemoryTreeCacheSize.getValue(),
-            config->getEdenConfig()->inMemoryTreeCacheMinElements.getValue()},
+            config->getEdenConfig()->inMemoryTreeCacheMinElements.getValue(),
+            config->getEdenConfig()->inMemoryTreeCacheShardCount.getValue(),
+            config->getEdenConfig()
+                ->inMemoryTreeCacheEvictionPolicy.getValue()},
         config_{config} {}
 
 } // namespace facebook::eden
@@ -6,16 +6,26 @@
  */
 
 #include <sysexits.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <fstream>
 #include <memory>
 #include <optional>
+#include <random>
+#include <thread>
+#include <vector>
 
+#include <fmt/core.h>
 #include <folly/Range.h>
 #include <folly/String.h>
 #include <folly/container/Array.h>
 #include <folly/container/Enumerate.h>
 #include <folly/init/Init.h>
+#include <folly/lang/Bits.h>
 #include <folly/logging/Init.h>
 #include <folly/logging/xlog.h>
+#include <folly/portability/GFlags.h>
 #include <folly/stop_watch.h>
 
 #include "eden/fs/config/EdenConfig.h"
@@ -24,6 +34,7 @@
 #include "eden/fs/service/EdenStateDir.h"
 #include "eden/fs/store/KeySpace.h"
 #include "eden/fs/store/RocksDbLocalStore.h"
+#include "eden/fs/store/StoreResult.h"
 #include "eden/fs/telemetry/NullStructuredLogger.h"
 #include "eden/fs/utils/FaultInjector.h"
 #include "eden/fs/utils/UserInfo.h"
@@ -37,6 +48,29 @@ using std::optional;
 FOLLY_INIT_LOGGING_CONFIG("eden=DBG2; default:async=true");
 
 DEFINE_string(keySpace, "", "operate on just a single key space");
+DEFINE_string(
+    fetchLog,
+    "",
+    "replay: file with one \"<key space> <hex key>\" lookup per line");
+DEFINE_uint32(threads, 4, "replay, bench_read: number of reading threads");
+DEFINE_uint64(reads, 1'000'000, "bench_read: number of reads per thread");
+DEFINE_uint64(
+    sampleKeys,
+    100'000,
+    "bench_read: number of keys of the key space that are read at random");
+DEFINE_bool(
+    enableBlobFiles,
+    true,
+    "Keep the large values in blob files. Defaults to the EdenFS config");
+DEFINE_uint64(
+    minBlobSize,
+    4096,
+    "Size from which values go to blob files. Defaults to the EdenFS config");
+DEFINE_double(
+    filterBitsPerKey,
+    10.0,
+    "Ribbon filter bits per key of the small-value key spaces, 0 for bloom "
+    "filters. Defaults to the EdenFS config");
 
 namespace {
 
@@ -57,6 +91,123 @@ optional<KeySpace> getKeySpace() {
   return stringToKeySpace(FLAGS_keySpace);
 }
 
+bool isFlagSet(const char* name) {
+  return !gflags::GetCommandLineFlagInfoOrDie(name).is_default;
+}
+
+/**
+ * Counts sizes in power of two buckets.
+ */
+class SizeHistogram {
+ public:
+  void add(size_t size) {
+    ++buckets_[size == 0 ? 0 : folly::findLastSet(size)];
+    ++count_;
+    total_ += size;
+    max_ = std::max(max_, size);
+  }
+
+  void print(StringPiece label) const {
+    fmt::print(
+        "  {}: count {}, average {:.1f}, max {}\n",
+        label,
+        count_,
+        count_ ? static_cast<double>(total_) / count_ : 0.0,
+        max_);
+    for (size_t i = 0; i < buckets_.size(); ++i) {
+      if (buckets_[i] == 0) {
+        continue;
+      }
+      // Bucket i holds the sizes in [2^(i-1), 2^i), bucket 0 holds zero.
+      uint64_t low = i == 0 ? 0 : uint64_t{1} << (i - 1);
+      uint64_t high = i == 0 ? 1 : low * 2;
+      fmt::print(
+          "    [{}, {}): {} ({:.2f}%)\n",
+          low,
+          high,
+          buckets_[i],
+          100.0 * buckets_[i] / count_);
+    }
+  }
+
+ private:
+  std::array<uint64_t, 65> buckets_{};
+  uint64_t count_{0};
+  uint64_t total_{0};
+  size_t max_{0};
+};
+
+/**
+ * Read latencies of several threads, in nanoseconds.
+ */
+class LatencyRecorder {
+ public:
+  explicit LatencyRecorder(size_t threads) : perThread_(threads) {}
+
+  std::vector<uint64_t>& forThread(size_t thread) {
+    return perThread_[thread];
+  }
+
+  void print(std::chrono::duration<double> elapsed) {
+    std::vector<uint64_t> all;
+    for (auto& latencies : perThread_) {
+      all.insert(all.end(), latencies.begin(), latencies.end());
+    }
+    if (all.empty()) {
+      fmt::print("no reads\n");
+      return;
+    }
+    std::sort(all.begin(), all.end());
+    auto percentile = [&](double p) {
+      return all[std::min(
+          all.size() - 1, static_cast<size_t>(p / 100 * all.size()))];
+    };
+    fmt::print(
+        "{} reads in {:.3f}s: {:.0f} reads/s\n",
+        all.size(),
+        elapsed.count(),
+        all.size() / elapsed.count());
+    fmt::print(
+        "latency (ns): p50 {}, p90 {}, p99 {}, p99.9 {}, max {}\n",
+        percentile(50),
+        percentile(90),
+        percentile(99),
+        percentile(99.9),
+        all.back());
+  }
+
+ private:
+  std::vector<std::vector<uint64_t>> perThread_;
+};
+
+/**
+ * Run fn(thread) on FLAGS_threads threads and return how long they took.
+ */
+template <typename Fn>
+std::chrono::duration<double> runOnThreads(Fn&& fn) {
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  threads.reserve(FLAGS_threads);
+  for (size_t i = 0; i < FLAGS_threads; ++i) {
+    threads.emplace_back([&fn, i] { fn(i); });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  return std::chrono::steady_clock::now() - start;
+}
+
+uint64_t timeRead(
+    const RocksDbLocalStore& localStore,
+    KeySpace keySpace,
+    folly::ByteRange key) {
+  auto start = std::chrono::steady_clock::now();
+  localStore.get(keySpace, key);
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
 class Command {
  public:
   Command()
@@ -81,6 +232,24 @@ class Command {
     return edenDir_.getPath() + "storage/rocks-db"_relpath;
   }
 
+  /**
+   * The EdenFS configuration of the RocksDB options, overridden by the
+   * flags that are set.
+   */
+  RocksDbTuning getTuning() const {
+    auto tuning = RocksDbTuning::fromConfig(*config_);
+    if (isFlagSet("enableBlobFiles")) {
+      tuning.enableBlobFiles = FLAGS_enableBlobFiles;
+    }
+    if (isFlagSet("minBlobSize")) {
+      tuning.minBlobSize = FLAGS_minBlobSize;
+    }
+    if (isFlagSet("filterBitsPerKey")) {
+      tuning.smallValueFilterBitsPerKey = FLAGS_filterBitsPerKey;
+    }
+    return tuning;
+  }
+
   std::unique_ptr<RocksDbLocalStore> openLocalStore(RocksDBOpenMode mode) {
     folly::stop_watch<std::chrono::milliseconds> watch;
     const auto rocksPath = getLocalStorePath();
@@ -89,7 +258,8 @@ class Command {
         rocksPath,
         std::make_shared<NullStructuredLogger>(),
         &faultInjector_,
-        mode);
+        mode,
+        getTuning());
     localStore->open();
     XLOG(INFO) << "Opened RocksDB store in "
                << (mode == RocksDBOpenMode::ReadOnly ? "read-only"
@@ -206,13 +376,141 @@ class ShowSizesCommand : public Command {
   }
 };
 
+class ScanSizesCommand : public Command {
+ public:
+  static constexpr auto name = StringPiece("scan_sizes");
+  static constexpr auto help = StringPiece(
+      "Report histograms of the key and value sizes of each key space.");
+
+  void run() override {
+    auto keySpace = getKeySpace();
+    auto localStore = openLocalStore(RocksDBOpenMode::ReadOnly);
+
+    for (const auto& ks : KeySpace::kAll) {
+      if (ks->isDeprecated() || (keySpace && (*keySpace)->index != ks->index)) {
+        continue;
+      }
+      SizeHistogram keySizes;
+      SizeHistogram valueSizes;
+      localStore->forEachEntry(
+          ks, [&](folly::ByteRange key, folly::ByteRange value) {
+            keySizes.add(key.size());
+            valueSizes.add(value.size());
+          });
+      fmt::print("Key space \"{}\":\n", ks->name);
+      keySizes.print("keys");
+      valueSizes.print("values");
+    }
+  }
+};
+
+class ReplayCommand : public Command {
+ public:
+  static constexpr auto name = StringPiece("replay");
+  static constexpr auto help = StringPiece(
+      "Replay the lookups of --fetchLog and report their throughput and "
+      "latency. The RocksDB options can be changed with the flags.");
+
+  void run() override {
+    if (FLAGS_fetchLog.empty()) {
+      throw ArgumentError("replay requires --fetchLog");
+    }
+    auto lookups = readFetchLog();
+    auto localStore = openLocalStore(RocksDBOpenMode::ReadOnly);
+
+    // Thread i replays the lookups i, i + threads, i + 2 * threads, ...
+    LatencyRecorder latencies{FLAGS_threads};
+    auto elapsed = runOnThreads([&](size_t thread) {
+      auto& recorded = latencies.forThread(thread);
+      for (size_t i = thread; i < lookups.size(); i += FLAGS_threads) {
+        const auto& [keySpace, key] = lookups[i];
+        recorded.push_back(
+            timeRead(*localStore, keySpace, StringPiece{key}));
+      }
+    });
+    latencies.print(elapsed);
+  }
+
+ private:
+  std::vector<std::pair<KeySpace, std::string>> readFetchLog() const {
+    std::ifstream log{FLAGS_fetchLog};
+    if (!log) {
+      throw ArgumentError(
+          fmt::format(FMT_STRING("cannot open \"{}\""), FLAGS_fetchLog));
+    }
+    std::vector<std::pair<KeySpace, std::string>> lookups;
+    std::string keySpace;
+    std::string hexKey;
+    while (log >> keySpace >> hexKey) {
+      std::string key;
+      if (!folly::unhexlify(hexKey, key)) {
+        throw ArgumentError(
+            fmt::format(FMT_STRING("invalid hex key \"{}\""), hexKey));
+      }
+      lookups.emplace_back(stringToKeySpace(keySpace), std::move(key));
+    }
+    return lookups;
+  }
+};
+
+class BenchReadCommand : public Command {
+ public:
+  static constexpr auto name = StringPiece("bench_read");
+  static constexpr auto help = StringPiece(
+      "Read random keys of --keySpace (blob by default) on --threads threads "
+      "and report their throughput and latency.");
+
+  void run() override {
+    auto keySpace = getKeySpace().value_or(KeySpace::BlobFamily);
+    auto localStore = openLocalStore(RocksDBOpenMode::ReadOnly);
+
+    // Reservoir sampling, so that the keys are spread over the key space.
+    std::vector<std::string> keys;
+    std::mt19937_64 rng{std::random_device{}()};
+    uint64_t seen = 0;
+    localStore->forEachEntry(
+        keySpace, [&](folly::ByteRange key, folly::ByteRange) {
+          ++seen;
+          if (keys.size() < FLAGS_sampleKeys) {
+            keys.emplace_back(StringPiece{key});
+          } else if (auto slot = rng() % seen; slot < FLAGS_sampleKeys) {
+            keys[slot] = std::string{StringPiece{key}};
+          }
+        });
+    if (keys.empty()) {
+      throw ArgumentError(fmt::format(
+          FMT_STRING("key space \"{}\" is empty"), keySpace->name));
+    }
+    fmt::print(
+        "reading {} of the {} keys of \"{}\"\n",
+        keys.size(),
+        seen,
+        keySpace->name);
+
+    LatencyRecorder latencies{FLAGS_threads};
+    auto elapsed = runOnThreads([&](size_t thread) {
+      std::mt19937_64 threadRng{thread};
+      auto& recorded = latencies.forThread(thread);
+      recorded.reserve(FLAGS_reads);
+      for (uint64_t i = 0; i < FLAGS_reads; ++i) {
+        const auto& key = keys[threadRng() % keys.size()];
+        recorded.push_back(timeRead(*localStore, keySpace, StringPiece{key}));
+      }
+    });
+    latencies.print(elapsed);
+  }
+};
+
 std::unique_ptr<Command> createCommand(StringPiece name) {
   auto commands = make_array<std::unique_ptr<CommandFactory>>(
       make_unique<CommandFactoryT<GcCommand>>(),
       make_unique<CommandFactoryT<ClearCommand>>(),
       make_unique<CommandFactoryT<CompactCommand>>(),
       make_unique<CommandFactoryT<RepairCommand>>(),
-      make_unique<CommandFactoryT<ShowSizesCommand>>());
+      make_unique<CommandFactoryT<ShowSizesCommand>>(),
+      make_unique<CommandFactoryT<ScanSizesCommand>>(),
+      make_unique<CommandFactoryT<ReplayCommand>>(),
+      make_unique<CommandFactoryT<BenchReadCommand>>());
 
   std::unique_ptr<Command> command;
   for (const auto& factory : commands) {
@@ -8,11 +8,15 @@
 #include "GitBackingStore.h"
 
 #include <folly/Conv.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
 #include <folly/futures/Future.h>
 #include <folly/logging/xlog.h>
+#include <folly/portability/GFlags.h>
 #include <git2.h>
 
 #include "eden/fs/model/Blob.h"
+#include "eden/fs/model/BlobMetadata.h"
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/model/Tree.h"
 #include "eden/fs/model/TreeEntry.h"
@@ -32,10 +36,31 @@ using std::make_unique;
 using std::string;
 using std::unique_ptr;
 
+DEFINE_int32(
+    num_git_import_threads,
+    8,
+    "the number of git import threads per repo");
+DEFINE_uint64(
+    git_pack_window_mb,
+    32,
+    "the size of the windows libgit2 maps packfiles through");
+DEFINE_uint64(
+    git_pack_mapped_limit_mb,
+    8192,
+    "the total size of the packfile windows libgit2 keeps mapped");
+DEFINE_uint64(
+    git_object_cache_mb,
+    256,
+    "the size of the libgit2 cache of parsed objects");
+
 namespace facebook::eden {
 
 namespace {
 
+// Large enough to amortize scheduling, small enough to spread a prefetch
+// over all the import threads.
+constexpr size_t kPrefetchBatchSize = 256;
+
 template <typename... Args>
 void gitCheckError(int error, Args&&... args) {
   if (error) {
@@ -52,25 +77,82 @@ void freeBlobIOBufData(void* /*blobData*/, void* blobObject) {
 
 } // namespace
 
-GitBackingStore::GitBackingStore(AbsolutePathPiece repository) {
+GitBackingStore::GitBackingStore(AbsolutePathPiece repository)
+    : repository_{repository} {
   // Make sure libgit2 is initialized.
   // (git_libgit2_init() is safe to call multiple times if multiple
   // GitBackingStore objects are created.  git_libgit2_shutdown() should be
   // called once for each call to git_libgit2_init().)
   git_libgit2_init();
+  configureLibgit2();
 
-  auto error =
-      git_repository_open(&repo_, std::string{repository.value()}.c_str());
-  gitCheckError(error, "error opening git repository", repository);
+  auto repo = openRepository();
+  path_ = git_repository_path(repo.get());
+  idleRepositories_.wlock()->push_back(std::move(repo));
+
+  importThreadPool_ = make_unique<folly::CPUThreadPoolExecutor>(
+      FLAGS_num_git_import_threads,
+      std::make_shared<folly::NamedThreadFactory>("GitImport"));
 }
 
 GitBackingStore::~GitBackingStore() {
-  git_repository_free(repo_);
+  // The repositories must be freed before libgit2 shuts down, and after the
+  // import threads stopped using them.
+  importThreadPool_.reset();
+  idleRepositories_.wlock()->clear();
   git_libgit2_shutdown();
 }
 
+void GitBackingStore::configureLibgit2() {
+  // These are process-wide, and only take effect for the packfiles opened
+  // afterwards: set them before opening any repository. Packfiles are read
+  // through mmaped windows, so mapping large windows of large packs avoids
+  // remapping while the deltas of a checkout are resolved.
+  constexpr size_t kMB = 1024 * 1024;
+  git_libgit2_opts(
+      GIT_OPT_SET_MWINDOW_SIZE,
+      static_cast<size_t>(FLAGS_git_pack_window_mb * kMB));
+  git_libgit2_opts(
+      GIT_OPT_SET_MWINDOW_MAPPED_LIMIT,
+      static_cast<size_t>(FLAGS_git_pack_mapped_limit_mb * kMB));
+  git_libgit2_opts(
+      GIT_OPT_SET_CACHE_MAX_SIZE,
+      static_cast<ssize_t>(FLAGS_git_object_cache_mb * kMB));
+}
+
+void GitBackingStore::RepositoryDeleter::operator()(
+    git_repository* repo) const {
+  git_repository_free(repo);
+}
+
+GitBackingStore::RepositoryPtr GitBackingStore::openRepository() const {
+  git_repository* repo = nullptr;
+  auto error = git_repository_open(&repo, repository_.c_str());
+  gitCheckError(error, "error opening git repository", repository_);
+  return RepositoryPtr{repo};
+}
+
+template <typename Fn>
+auto GitBackingStore::withRepository(Fn&& fn) {
+  RepositoryPtr repo;
+  {
+    auto idle = idleRepositories_.wlock();
+    if (!idle->empty()) {
+      repo = std::move(idle->back());
+      idle->pop_back();
+    }
+  }
+  if (!repo) {
+    repo = openRepository();
+  }
+  SCOPE_EXIT {
+    idleRepositories_.wlock()->push_back(std::move(repo));
+  };
+  return fn(repo.get());
+}
+
 const char* GitBackingStore::getPath() const {
-  return git_repository_path(repo_);
+  return path_.c_str();
 }
 
 RootId GitBackingStore::parseRootId(folly::StringPiece rootId) {
@@ -94,44 +176,58 @@ std::string GitBackingStore::renderObjectId(const ObjectId& objectId) {
 ImmediateFuture<unique_ptr<Tree>> GitBackingStore::getRootTree(
     const RootId& rootId,
     const ObjectFetchContextPtr& /*context*/) {
-  // TODO: Use a separate thread pool to do the git I/O
-  XLOG(DBG4) << "resolving tree for commit " << rootId;
-
-  // Look up the commit info
-  git_oid commitOID = root2Oid(rootId);
-  git_commit* commit = nullptr;
-  auto error = git_commit_lookup(&commit, repo_, &commitOID);
-  gitCheckError(
-      error,
-      "unable to find git commit ",
-      rootId,
-      " in repository ",
-      getPath());
-  SCOPE_EXIT {
-    git_commit_free(commit);
-  };
-
-  // Get the tree ID for this commit.
-  ObjectId treeID = oid2Hash(git_commit_tree_id(commit));
-
-  // Now get the specified tree.
-  return getTreeImpl(treeID);
+  return folly::via(
+             importThreadPool_.get(),
+             [this, rootId] {
+               XLOG(DBG4) << "resolving tree for commit " << rootId;
+               return withRepository([&](git_repository* repo) {
+                 // Look up the commit info
+                 git_oid commitOID = root2Oid(rootId);
+                 git_commit* commit = nullptr;
+                 auto error = git_commit_lookup(&commit, repo, &commitOID);
+                 gitCheckError(
+                     error,
+                     "unable to find git commit ",
+                     rootId,
+                     " in repository ",
+                     getPath());
+                 SCOPE_EXIT {
+                   git_commit_free(commit);
+                 };
+
+                 // Get the tree ID for this commit.
+                 ObjectId treeID = oid2Hash(git_commit_tree_id(commit));
+
+                 // Now get the specified tree.
+                 return getTreeImpl(repo, treeID);
+               });
+             })
+      .semi();
 }
 
 SemiFuture<BackingStore::GetTreeResult> GitBackingStore::getTree(
     const ObjectId& id,
     const ObjectFetchContextPtr& /*context*/) {
-  // TODO: Use a separate thread pool to do the git I/O
-  return makeSemiFuture(BackingStore::GetTreeResult{
-      getTreeImpl(id), ObjectFetchContext::Origin::FromDiskCache});
+  return folly::via(
+             importThreadPool_.get(),
+             [this, id] {
+               return BackingStore::GetTreeResult{
+                   withRepository([&](git_repository* repo) {
+                     return getTreeImpl(repo, id);
+                   }),
+                   ObjectFetchContext::Origin::FromDiskCache};
+             })
+      .semi();
 }
 
-unique_ptr<Tree> GitBackingStore::getTreeImpl(const ObjectId& id) {
+unique_ptr<Tree> GitBackingStore::getTreeImpl(
+    git_repository* repo,
+    const ObjectId& id) {
   XLOG(DBG4) << "importing tree " << id;
 
   git_oid treeOID = hash2Oid(id);
   git_tree* gitTree = nullptr;
-  auto error = git_tree_lookup(&gitTree, repo_, &treeOID);
+  auto error = git_tree_lookup(&gitTree, repo, &treeOID);
   gitCheckError(
       error, "unable to find git tree ", id, " in repository ", getPath());
   SCOPE_EXIT {
@@ -173,17 +269,84 @@ unique_ptr<Tree> GitBackingStore::getTreeImpl(const ObjectId& id) {
 SemiFuture<BackingStore::GetBlobResult> GitBackingStore::getBlob(
     const ObjectId& id,
     const ObjectFetchContextPtr& /*context*/) {
-  // TODO: Use a separate thread pool to do the git I/O
-  return makeSemiFuture(BackingStore::GetBlobResult{
-      getBlobImpl(id), ObjectFetchContext::Origin::FromDiskCache});
+  return folly::via(
+             importThreadPool_.get(),
+             [this, id] {
+               return BackingStore::GetBlobResult{
+                   withRepository([&](git_repository* repo) {
+                     return getBlobImpl(repo, id);
+                   }),
+                   ObjectFetchContext::Origin::FromDiskCache};
+             })
+      .semi();
+}
+
+SemiFuture<folly::Unit> GitBackingStore::prefetchBlobs(
+    ObjectIdRange ids,
+    const ObjectFetchContextPtr& /*context*/) {
+  std::vector<folly::SemiFuture<folly::Unit>> batches;
+  for (size_t start = 0; start < ids.size(); start += kPrefetchBatchSize) {
+    std::vector<git_oid> batch;
+    for (const auto& id : ids.subpiece(start, kPrefetchBatchSize)) {
+      batch.push_back(hash2Oid(id));
+    }
+    batches.push_back(
+        folly::via(
+            importThreadPool_.get(),
+            [this, batch = std::move(batch)] {
+              withRepository([&](git_repository* repo) {
+                git_odb* odb = nullptr;
+                gitCheckError(
+                    git_repository_odb(&odb, repo),
+                    "unable to open the object database of ",
+                    getPath());
+                SCOPE_EXIT {
+                  git_odb_free(odb);
+                };
+                for (const auto& oid : batch) {
+                  git_odb_object* object = nullptr;
+                  // Missing objects fail when they are actually read.
+                  if (git_odb_read(&object, odb, &oid) == 0) {
+                    git_odb_object_free(object);
+                  }
+                }
+              });
+            })
+            .semi());
+  }
+  return folly::collectAll(std::move(batches)).unit();
+}
+
+unique_ptr<BlobMetadata> GitBackingStore::getLocalBlobMetadata(
+    const ObjectId& id,
+    const ObjectFetchContextPtr& /*context*/) {
+  return withRepository([&](git_repository* repo) {
+    auto blobOID = hash2Oid(id);
+    git_blob* blob = nullptr;
+    if (git_blob_lookup(&blob, repo, &blobOID) != 0) {
+      // Let the regular fetch report the error.
+      return unique_ptr<BlobMetadata>{};
+    }
+    SCOPE_EXIT {
+      git_blob_free(blob);
+    };
+    auto size = git_blob_rawsize(blob);
+    ByteRange contents{
+        static_cast<const uint8_t*>(git_blob_rawcontent(blob)),
+        static_cast<size_t>(size)};
+    return make_unique<BlobMetadata>(
+        Hash20::sha1(contents), static_cast<uint64_t>(size));
+  });
 }
 
-unique_ptr<Blob> GitBackingStore::getBlobImpl(const ObjectId& id) {
+unique_ptr<Blob> GitBackingStore::getBlobImpl(
+    git_repository* repo,
+    const ObjectId& id) {
   XLOG(DBG5) << "importing blob " << id;
 
   auto blobOID = hash2Oid(id);
   git_blob* blob = nullptr;
-  int error = git_blob_lookup(&blob, repo_, &blobOID);
+  int error = git_blob_lookup(&blob, repo, &blobOID);
   gitCheckError(
       error, "unable to find git blob ", id, " in repository ", getPath());
 
@@ -8,6 +8,10 @@
 #pragma once
 
 #include <folly/Range.h>
+#include <folly/Synchronized.h>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include "eden/fs/store/BackingStore.h"
 #include "eden/fs/store/ObjectFetchContext.h"
@@ -16,10 +20,19 @@
 struct git_oid;
 struct git_repository;
 
+namespace folly {
+class Executor;
+} // namespace folly
+
 namespace facebook::eden {
 
 /**
  * A BackingStore implementation that loads data out of a git repository.
+ *
+ * libgit2 serializes the uses of a git_repository, so the objects are read
+ * on a pool of import threads, each with a git_repository of its own taken
+ * from a pool of open repositories. The repositories share libgit2's cache of
+ * pack files, and with it the cache of the delta bases.
  */
 class GitBackingStore final : public BijectiveBackingStore {
  public:
@@ -61,11 +74,23 @@ class GitBackingStore final : public BijectiveBackingStore {
       const ObjectId& id,
       const ObjectFetchContextPtr& context) override;
 
+  /**
+   * Reads the blobs in batches on the import threads, which pages in the
+   * parts of the pack files that hold them and caches their delta bases, so
+   * that the following getBlob calls don't wait on the disk.
+   */
+  FOLLY_NODISCARD folly::SemiFuture<folly::Unit> prefetchBlobs(
+      ObjectIdRange ids,
+      const ObjectFetchContextPtr& context) override;
+
+  /**
+   * All the objects of a git repository are local, so this reads the blob
+   * from the object database and hashes it on the calling thread, rather
+   * than going through the import threads.
+   */
   std::unique_ptr<BlobMetadata> getLocalBlobMetadata(
-      const ObjectId& /*id*/,
-      const ObjectFetchContextPtr& /*context*/) override {
-    return nullptr;
-  }
+      const ObjectId& id,
+      const ObjectFetchContextPtr& context) override;
 
   // TODO(T119221752): Implement for all BackingStore subclasses
   int64_t dropAllPendingRequestsFromQueue() override {
@@ -79,15 +104,38 @@ class GitBackingStore final : public BijectiveBackingStore {
   GitBackingStore(GitBackingStore const&) = delete;
   GitBackingStore& operator=(GitBackingStore const&) = delete;
 
-  std::unique_ptr<Tree> getTreeImpl(const ObjectId& id);
-  std::unique_ptr<Blob> getBlobImpl(const ObjectId& id);
+  struct RepositoryDeleter {
+    void operator()(git_repository* repo) const;
+  };
+  using RepositoryPtr = std::unique_ptr<git_repository, RepositoryDeleter>;
+
+  /**
+   * Sizes the packfile windows and the object cache of libgit2.
+   */
+  static void configureLibgit2();
+
+  RepositoryPtr openRepository() const;
+
+  /**
+   * Calls fn with a repository that no other thread uses meanwhile.
+   */
+  template <typename Fn>
+  auto withRepository(Fn&& fn);
+
+  std::unique_ptr<Tree> getTreeImpl(git_repository* repo, const ObjectId& id);
+  std::unique_ptr<Blob> getBlobImpl(git_repository* repo, const ObjectId& id);
 
   static git_oid root2Oid(const RootId& rootId);
 
   static git_oid hash2Oid(const ObjectId& hash);
   static ObjectId oid2Hash(const git_oid* oid);
 
-  git_repository* repo_{nullptr};
+  AbsolutePath repository_;
+  // The path of the .git directory.
+  std::string path_;
+  // The repositories that no thread is using.
+  folly::Synchronized<std::vector<RepositoryPtr>> idleRepositories_;
+  std::unique_ptr<folly::Executor> importThreadPool_;
 };
 
 } // namespace facebook::eden
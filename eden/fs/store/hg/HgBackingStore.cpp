@@ -62,6 +62,11 @@ DEFINE_int32(
     // Note that this number would benefit from occasional revisiting.
     8,
     "the number of hg import threads per repo");
+DEFINE_int32(
+    num_hg_import_spares,
+    1,
+    "the number of hg import helpers per repo started ahead of time, to "
+    "replace the helpers of the import threads without waiting for hg");
 DEFINE_bool(
     hg_fetch_missing_trees,
     true,
@@ -97,14 +102,17 @@ class HgImporterThreadFactory : public folly::ThreadFactory {
  public:
   HgImporterThreadFactory(
       AbsolutePathPiece repository,
-      std::shared_ptr<EdenStats> stats)
+      std::shared_ptr<EdenStats> stats,
+      std::shared_ptr<HgImporterSpares> spares)
       : delegate_("HgImporter"),
         repository_(repository),
-        stats_(std::move(stats)) {}
+        stats_(std::move(stats)),
+        spares_(std::move(spares)) {}
 
   std::thread newThread(folly::Func&& func) override {
     return delegate_.newThread([this, func = std::move(func)]() mutable {
-      threadLocalImporter.reset(new HgImporterManager(repository_, stats_));
+      threadLocalImporter.reset(new HgImporterManager(
+          repository_, stats_, /*importHelperScript=*/std::nullopt, spares_));
       SCOPE_EXIT {
         if (folly::kIsWindows) {
           // TODO(T125334969): On Windows, the ThreadLocalPtr doesn't appear to
@@ -121,6 +129,7 @@ class HgImporterThreadFactory : public folly::ThreadFactory {
   folly::NamedThreadFactory delegate_;
   AbsolutePath repository_;
   std::shared_ptr<EdenStats> stats_;
+  std::shared_ptr<HgImporterSpares> spares_;
 };
 
 /**
@@ -146,7 +155,8 @@ class HgImporterTestExecutor : public folly::InlineExecutor {
 
 HgDatapackStore::Options computeOptions(const EdenConfig& config) {
   HgDatapackStore::Options options{};
-  options.aux_data = config.useAuxMetadata.getValue();
+  options.aux_data = config.useAuxMetadata.getValue() ||
+      config.persistTreeAuxMetadata.getValue();
   options.allow_retries = false;
   return options;
 }
@@ -169,6 +179,11 @@ HgBackingStore::HgBackingStore(
     std::shared_ptr<StructuredLogger> logger)
     : localStore_(std::move(localStore)),
       stats_(stats),
+      importerSpares_(
+          FLAGS_num_hg_import_spares > 0
+              ? std::make_shared<HgImporterSpares>(
+                    repository, stats, FLAGS_num_hg_import_spares)
+              : nullptr),
       importThreadPool_(make_unique<folly::CPUThreadPoolExecutor>(
           FLAGS_num_hg_import_threads,
           /* Eden performance will degrade when, for example, a status operation
@@ -185,7 +200,8 @@ HgBackingStore::HgBackingStore(
            */
           make_unique<folly::UnboundedBlockingQueue<
               folly::CPUThreadPoolExecutor::CPUTask>>(),
-          std::make_shared<HgImporterThreadFactory>(repository, stats))),
+          std::make_shared<HgImporterThreadFactory>(
+              repository, stats, importerSpares_))),
       config_(config),
       serverThreadPool_(serverThreadPool),
       datapackStore_(
@@ -193,9 +209,12 @@ HgBackingStore::HgBackingStore(
           computeOptions(*config->getEdenConfig()),
           config),
       logger_(logger) {
-  HgImporter importer(repository, stats);
-  const auto& options = importer.getOptions();
-  repoName_ = options.repoName;
+  auto importer = make_unique<HgImporter>(repository, stats);
+  repoName_ = importer->getOptions().repoName;
+  // Rather than stopping it, keep it for the first import thread.
+  if (importerSpares_) {
+    importerSpares_->add(std::move(importer));
+  }
 }
 
 /**
@@ -228,39 +247,71 @@ ImmediateFuture<unique_ptr<Tree>> HgBackingStore::getRootTree(
 
   return localStore_
       ->getImmediateFuture(KeySpace::HgCommitToTreeFamily, commitId)
-      .thenValue(
-          [this, commitId](
-              StoreResult result) -> folly::SemiFuture<unique_ptr<Tree>> {
-            if (!result.isValid()) {
-              return importTreeManifest(commitId).thenValue(
-                  [this, commitId](std::unique_ptr<Tree> rootTree) {
-                    XLOG(DBG1) << "imported mercurial commit " << commitId
-                               << " as tree " << rootTree->getHash();
-
-                    localStore_->put(
-                        KeySpace::HgCommitToTreeFamily,
-                        commitId,
-                        rootTree->getHash().getBytes());
-                    return rootTree;
-                  });
-            }
+      .thenValue([this, commitId](StoreResult result) {
+        return getRootTreeFromMapping(commitId, result);
+      });
+}
 
-            auto rootTreeHash = HgProxyHash::load(
-                localStore_.get(),
-                ObjectId{result.bytes()},
-                "getRootTree",
-                *stats_);
-            return importTreeManifestImpl(rootTreeHash.revHash());
-          });
+ImmediateFuture<std::vector<unique_ptr<Tree>>> HgBackingStore::getRootTrees(
+    const std::vector<RootId>& rootIds) {
+  std::vector<ObjectId> commitIds;
+  commitIds.reserve(rootIds.size());
+  for (const auto& rootId : rootIds) {
+    commitIds.push_back(hashFromRootId(rootId));
+  }
+  std::vector<folly::ByteRange> keys;
+  keys.reserve(commitIds.size());
+  for (const auto& commitId : commitIds) {
+    keys.push_back(commitId.getBytes());
+  }
+
+  // Look up all the commit to tree mappings at once, then resolve the
+  // commits that weren't imported yet concurrently on the import threads.
+  auto mappings =
+      localStore_->getBatch(KeySpace::HgCommitToTreeFamily, keys).semi();
+  return ImmediateFuture{std::move(mappings)}.thenValue(
+      [this, commitIds = std::move(commitIds)](
+          std::vector<StoreResult> results) {
+        std::vector<ImmediateFuture<unique_ptr<Tree>>> futures;
+        futures.reserve(results.size());
+        for (size_t i = 0; i < results.size(); ++i) {
+          futures.emplace_back(
+              getRootTreeFromMapping(commitIds[i], results[i]));
+        }
+        return collectAllSafe(std::move(futures));
+      });
+}
+
+folly::SemiFuture<unique_ptr<Tree>> HgBackingStore::getRootTreeFromMapping(
+    const ObjectId& commitId,
+    const StoreResult& mapping) {
+  if (!mapping.isValid()) {
+    return importTreeManifest(commitId).thenValue(
+        [this, commitId](std::unique_ptr<Tree> rootTree) {
+          XLOG(DBG1) << "imported mercurial commit " << commitId << " as tree "
+                     << rootTree->getHash();
+
+          localStore_->queuePut(
+              KeySpace::HgCommitToTreeFamily,
+              commitId,
+              rootTree->getHash().getBytes());
+          return rootTree;
+        });
+  }
+
+  auto rootTreeHash = HgProxyHash::load(
+      localStore_.get(), ObjectId{mapping.bytes()}, "getRootTree", *stats_);
+  return importTreeManifestImpl(rootTreeHash.revHash());
 }
 
-SemiFuture<unique_ptr<Tree>> HgBackingStore::getTree(
+SemiFuture<TreePtr> HgBackingStore::getTree(
     const std::shared_ptr<HgImportRequest>& request) {
   auto* treeImport = request->getRequest<HgImportRequest::TreeImport>();
   return importTreeImpl(
-      treeImport->proxyHash.revHash(), // this is really the manifest node
-      treeImport->hash,
-      treeImport->proxyHash.path());
+             treeImport->proxyHash.revHash(), // really the manifest node
+             treeImport->hash,
+             treeImport->proxyHash.path())
+      .thenValue([](std::unique_ptr<Tree> tree) -> TreePtr { return tree; });
 }
 
 Future<unique_ptr<Tree>> HgBackingStore::importTreeImpl(
@@ -516,7 +567,7 @@ folly::Future<folly::Unit> HgBackingStore::importTreeManifestForRoot(
                              << " with manifest " << manifestId << " as tree "
                              << rootTree->getHash();
 
-                  localStore_->put(
+                  localStore_->queuePut(
                       KeySpace::HgCommitToTreeFamily,
                       commitId,
                       rootTree->getHash().getBytes());
@@ -561,14 +612,14 @@ folly::Future<std::unique_ptr<Tree>> HgBackingStore::importTreeManifestImpl(
   return importTreeImpl(manifestNode, objectId, path);
 }
 
-SemiFuture<std::unique_ptr<Blob>> HgBackingStore::fetchBlobFromHgImporter(
+SemiFuture<BlobPtr> HgBackingStore::fetchBlobFromHgImporter(
     HgProxyHash hgInfo) {
   return folly::via(
       importThreadPool_.get(),
       [this,
        stats = stats_,
        hgInfo = std::move(hgInfo),
-       &liveImportBlobWatches = liveImportBlobWatches_] {
+       &liveImportBlobWatches = liveImportBlobWatches_]() -> BlobPtr {
         Importer& importer = getThreadLocalImporter();
         folly::stop_watch<std::chrono::milliseconds> watch;
         RequestMetricsScope queueTracker{&liveImportBlobWatches};
@@ -604,7 +655,7 @@ folly::StringPiece HgBackingStore::stringOfHgImportObject(
   EDEN_BUG() << "unknown hg import object " << enumValue(object);
 }
 
-RequestMetricsScope::LockedRequestWatchList&
+RequestMetricsScope::RequestWatchList&
 HgBackingStore::getLiveImportWatches(HgImportObject object) const {
   switch (object) {
     case HgImportObject::BLOB:
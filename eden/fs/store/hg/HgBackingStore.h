@@ -25,6 +25,7 @@
 namespace facebook::eden {
 
 class HgImporter;
+class HgImporterSpares;
 struct ImporterOptions;
 class EdenStats;
 class LocalStore;
@@ -65,7 +66,13 @@ class HgBackingStore {
   ~HgBackingStore();
 
   ImmediateFuture<std::unique_ptr<Tree>> getRootTree(const RootId& rootId);
-  folly::SemiFuture<std::unique_ptr<Tree>> getTree(
+  /**
+   * Looks up the root trees of all the commits that were already imported in
+   * one LocalStore batch.
+   */
+  ImmediateFuture<std::vector<std::unique_ptr<Tree>>> getRootTrees(
+      const std::vector<RootId>& rootIds);
+  folly::SemiFuture<std::shared_ptr<const Tree>> getTree(
       const std::shared_ptr<HgImportRequest>& request);
 
   void periodicManagementTask();
@@ -107,12 +114,12 @@ class HgBackingStore {
    *        )
    *    gets the watches timing live blob imports
    */
-  RequestMetricsScope::LockedRequestWatchList& getLiveImportWatches(
+  RequestMetricsScope::RequestWatchList& getLiveImportWatches(
       HgImportObject object) const;
 
   // Get blob step functions
 
-  folly::SemiFuture<std::unique_ptr<Blob>> fetchBlobFromHgImporter(
+  folly::SemiFuture<std::shared_ptr<const Blob>> fetchBlobFromHgImporter(
       HgProxyHash hgInfo);
 
   HgDatapackStore& getDatapackStore() {
@@ -124,6 +131,14 @@ class HgBackingStore {
   }
 
  private:
+  /**
+   * Imports the root tree of commitId given its HgCommitToTreeFamily entry,
+   * which is invalid when the commit wasn't imported yet.
+   */
+  folly::SemiFuture<std::unique_ptr<Tree>> getRootTreeFromMapping(
+      const ObjectId& commitId,
+      const StoreResult& mapping);
+
   // Forbidden copy constructor and assignment operator
   HgBackingStore(HgBackingStore const&) = delete;
   HgBackingStore& operator=(HgBackingStore const&) = delete;
@@ -154,6 +169,9 @@ class HgBackingStore {
 
   std::shared_ptr<LocalStore> localStore_;
   std::shared_ptr<EdenStats> stats_;
+  // Importers started ahead of time for the import threads, null if none are
+  // kept. Declared before the pool so that it outlives the import threads.
+  std::shared_ptr<HgImporterSpares> importerSpares_;
   // A set of threads owning HgImporter instances
   std::unique_ptr<folly::Executor> importThreadPool_;
   std::shared_ptr<ReloadableConfig> config_;
@@ -170,10 +188,9 @@ class HgBackingStore {
   std::shared_ptr<StructuredLogger> logger_;
 
   // Track metrics for imports currently fetching data from hg
-  mutable RequestMetricsScope::LockedRequestWatchList liveImportBlobWatches_;
-  mutable RequestMetricsScope::LockedRequestWatchList liveImportTreeWatches_;
-  mutable RequestMetricsScope::LockedRequestWatchList
-      liveImportPrefetchWatches_;
+  mutable RequestMetricsScope::RequestWatchList liveImportBlobWatches_;
+  mutable RequestMetricsScope::RequestWatchList liveImportTreeWatches_;
+  mutable RequestMetricsScope::RequestWatchList liveImportPrefetchWatches_;
 };
 
 } // namespace facebook::eden
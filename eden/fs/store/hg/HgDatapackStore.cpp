@@ -58,8 +58,7 @@ Tree::value_type fromRawTreeEntry(
   auto name = PathComponent(folly::StringPiece{entry.name.asByteRange()});
   auto hash = Hash20{entry.hash};
 
-  auto fullPath = path + name;
-  auto proxyHash = HgProxyHash::store(fullPath, hash, hgObjectIdFormat);
+  auto proxyHash = HgProxyHash::store(path, name, hash, hgObjectIdFormat);
 
   auto treeEntry = TreeEntry{
       proxyHash, fromRawTreeEntryType(entry.ttype), size, contentSha1};
@@ -73,11 +72,13 @@ std::unique_ptr<Tree> fromRawTree(
     HgObjectIdFormat hgObjectIdFormat) {
   Tree::container entries{kPathMapDefaultCaseSensitive};
 
+  // The manifest entries are sorted, so each one is moved to the end of the
+  // container without a search or a copy of its name.
   entries.reserve(tree->length);
   for (uintptr_t i = 0; i < tree->length; i++) {
     try {
-      auto entry = fromRawTreeEntry(tree->entries[i], path, hgObjectIdFormat);
-      entries.emplace(entry.first, std::move(entry.second));
+      entries.insert(
+          fromRawTreeEntry(tree->entries[i], path, hgObjectIdFormat));
     } catch (const PathComponentContainsDirectorySeparator& ex) {
       XLOG(WARN) << "Ignoring directory entry: " << ex.what();
     }
@@ -146,8 +147,10 @@ void HgDatapackStore::getBlobBatch(
         auto& importRequest = importRequests[index];
         auto* blobRequest =
             importRequest->getRequest<HgImportRequest::BlobImport>();
-        auto blob = std::make_unique<Blob>(blobRequest->hash, *content);
-        importRequest->getPromise<std::unique_ptr<Blob>>()->setValue(
+        auto blob =
+            std::make_unique<Blob>(blobRequest->hash, std::move(*content));
+        importRequest->getPromise<HgImportRequest::BlobImport::Response>()
+            ->setValue(
             std::move(blob));
 
         // Make sure that we're stopping this watch.
@@ -198,7 +201,8 @@ void HgDatapackStore::getTreeBatch(
             treeRequest->proxyHash.path(),
             hgObjectIdFormat);
 
-        importRequest->getPromise<std::unique_ptr<Tree>>()->setValue(
+        importRequest->getPromise<HgImportRequest::TreeImport::Response>()
+            ->setValue(
             std::move(tree));
 
         // Make sure that we're stopping this watch.
@@ -206,6 +210,38 @@ void HgDatapackStore::getTreeBatch(
       });
 }
 
+void HgDatapackStore::getBlobMetadataBatch(
+    const std::vector<std::shared_ptr<HgImportRequest>>& importRequests) {
+  std::vector<std::pair<folly::ByteRange, folly::ByteRange>> requests;
+  requests.reserve(importRequests.size());
+
+  for (const auto& importRequest : importRequests) {
+    auto& proxyHash =
+        importRequest->getRequest<HgImportRequest::BlobMetadataImport>()
+            ->proxyHash;
+    requests.emplace_back(
+        folly::ByteRange{proxyHash.path().stringPiece()}, proxyHash.byteHash());
+  }
+
+  store_.getBlobMetadataBatch(
+      requests,
+      false,
+      // store_.getBlobMetadataBatch is blocking, hence we can take these by
+      // reference.
+      [&importRequests, &requests](
+          size_t index, std::shared_ptr<RustFileAuxData> metadata) {
+        XLOGF(
+            DBG9,
+            "Imported metadata name={} node={}",
+            folly::StringPiece{requests[index].first},
+            folly::hexlify(requests[index].second));
+        importRequests[index]
+            ->getPromise<HgImportRequest::BlobMetadataImport::Response>()
+            ->setValue(std::make_shared<BlobMetadata>(
+                Hash20{metadata->content_sha1}, metadata->total_size));
+      });
+}
+
 std::unique_ptr<Tree> HgDatapackStore::getTree(
     const RelativePath& path,
     const Hash20& manifestId,
@@ -62,6 +62,14 @@ class HgDatapackStore {
   void getTreeBatch(
       const std::vector<std::shared_ptr<HgImportRequest>>& requests);
 
+  /**
+   * Import the metadata of multiple blobs at once, without fetching their
+   * contents. As with getBlobBatch, the promises of the requests that could
+   * not be imported are left untouched.
+   */
+  void getBlobMetadataBatch(
+      const std::vector<std::shared_ptr<HgImportRequest>>& requests);
+
   std::unique_ptr<Tree> getTree(
       const RelativePath& path,
       const Hash20& manifestId,
@@ -83,7 +91,7 @@ class HgDatapackStore {
   /**
    * Get the metrics tracking the number of live batched blobs.
    */
-  RequestMetricsScope::LockedRequestWatchList& getLiveBatchedBlobWatches()
+  RequestMetricsScope::RequestWatchList& getLiveBatchedBlobWatches()
       const {
     return liveBatchedBlobWatches_;
   }
@@ -91,7 +99,7 @@ class HgDatapackStore {
   /**
    * Get the metrics tracking the number of live batched trees.
    */
-  RequestMetricsScope::LockedRequestWatchList& getLiveBatchedTreeWatches()
+  RequestMetricsScope::RequestWatchList& getLiveBatchedTreeWatches()
       const {
     return liveBatchedTreeWatches_;
   }
@@ -100,8 +108,8 @@ class HgDatapackStore {
   HgNativeBackingStore store_;
   std::shared_ptr<ReloadableConfig> config_;
 
-  mutable RequestMetricsScope::LockedRequestWatchList liveBatchedBlobWatches_;
-  mutable RequestMetricsScope::LockedRequestWatchList liveBatchedTreeWatches_;
+  mutable RequestMetricsScope::RequestWatchList liveBatchedBlobWatches_;
+  mutable RequestMetricsScope::RequestWatchList liveBatchedTreeWatches_;
 };
 
 } // namespace facebook::eden
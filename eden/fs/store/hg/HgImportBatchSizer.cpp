@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/hg/HgImportBatchSizer.h"
+
+#include <algorithm>
+
+namespace facebook::eden {
+
+size_t HgImportBatchSizer::getBatchSize(
+    size_t maxBatchSize,
+    std::chrono::nanoseconds targetLatency) const noexcept {
+  if (targetLatency.count() <= 0) {
+    return maxBatchSize;
+  }
+  return std::clamp<size_t>(limit_, 1, std::max<size_t>(maxBatchSize, 1));
+}
+
+void HgImportBatchSizer::recordBatch(
+    size_t batchSize,
+    std::chrono::nanoseconds latency,
+    size_t maxBatchSize,
+    std::chrono::nanoseconds targetLatency) noexcept {
+  if (targetLatency.count() <= 0 || batchSize == 0) {
+    return;
+  }
+
+  if (latency > targetLatency) {
+    limit_ = std::max<size_t>(batchSize / 2, 1);
+  } else if (batchSize >= limit_) {
+    // A full batch means that the queue was at least as deep as the limit.
+    limit_ = std::min(limit_ * 2, std::max<size_t>(maxBatchSize, 1));
+  }
+}
+
+} // namespace facebook::eden
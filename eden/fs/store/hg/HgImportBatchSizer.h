@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+namespace facebook::eden {
+
+/**
+ * Chooses how many import requests are handed to an import thread at once.
+ *
+ * Small batches keep the latency of individual requests low when the queue is
+ * shallow, while large batches amortize the per-batch overhead when the queue
+ * is deep. The limit grows multiplicatively while batches come back full and
+ * within the target latency, and shrinks multiplicatively when a batch is
+ * slower than the target.
+ *
+ * Not thread safe: HgImportRequestQueue holds one per request type under its
+ * lock.
+ */
+class HgImportBatchSizer {
+ public:
+  /**
+   * Return the number of requests to dequeue at most. A zero targetLatency
+   * disables the adaptation and always returns maxBatchSize.
+   */
+  size_t getBatchSize(
+      size_t maxBatchSize,
+      std::chrono::nanoseconds targetLatency) const noexcept;
+
+  /**
+   * Record that importing a batch of batchSize requests took latency.
+   */
+  void recordBatch(
+      size_t batchSize,
+      std::chrono::nanoseconds latency,
+      size_t maxBatchSize,
+      std::chrono::nanoseconds targetLatency) noexcept;
+
+ private:
+  size_t limit_{1};
+};
+
+} // namespace facebook::eden
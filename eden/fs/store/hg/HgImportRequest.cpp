@@ -10,6 +10,7 @@
 #include <folly/Try.h>
 #include <folly/futures/Future.h>
 #include <folly/futures/Promise.h>
+#include <algorithm>
 
 #include "eden/fs/telemetry/RequestMetricsScope.h"
 
@@ -20,22 +21,26 @@ HgImportRequest::HgImportRequest(
     RequestType request,
     ImportPriority priority,
     ObjectFetchContext::Cause cause,
+    uint64_t traceId,
     folly::Promise<typename RequestType::Response>&& promise)
     : request_(std::move(request)),
       priority_(priority),
       cause_(cause),
-      promise_(std::move(promise)) {}
+      promise_(std::move(promise)),
+      traceId_(traceId) {}
 
 template <typename RequestType, typename... Input>
 std::shared_ptr<HgImportRequest> HgImportRequest::makeRequest(
     ImportPriority priority,
     ObjectFetchContext::Cause cause,
+    uint64_t traceId,
     Input&&... input) {
   auto promise = folly::Promise<typename RequestType::Response>{};
   return std::make_shared<HgImportRequest>(
       RequestType{std::forward<Input>(input)...},
       priority,
       cause,
+      traceId,
       std::move(promise));
 }
 
@@ -43,16 +48,62 @@ std::shared_ptr<HgImportRequest> HgImportRequest::makeBlobImportRequest(
     ObjectId hash,
     HgProxyHash proxyHash,
     ImportPriority priority,
-    ObjectFetchContext::Cause cause) {
-  return makeRequest<BlobImport>(priority, cause, hash, std::move(proxyHash));
+    ObjectFetchContext::Cause cause,
+    uint64_t traceId) {
+  return makeRequest<BlobImport>(
+      priority, cause, traceId, hash, std::move(proxyHash));
 }
 
 std::shared_ptr<HgImportRequest> HgImportRequest::makeTreeImportRequest(
     ObjectId hash,
     HgProxyHash proxyHash,
     ImportPriority priority,
-    ObjectFetchContext::Cause cause) {
-  return makeRequest<TreeImport>(priority, cause, hash, std::move(proxyHash));
+    ObjectFetchContext::Cause cause,
+    uint64_t traceId) {
+  return makeRequest<TreeImport>(
+      priority, cause, traceId, hash, std::move(proxyHash));
+}
+
+std::shared_ptr<HgImportRequest>
+HgImportRequest::makeBlobMetadataImportRequest(
+    ObjectId hash,
+    HgProxyHash proxyHash,
+    ImportPriority priority,
+    ObjectFetchContext::Cause cause,
+    uint64_t traceId) {
+  return makeRequest<BlobMetadataImport>(
+      priority, cause, traceId, hash, std::move(proxyHash));
+}
+
+void HgImportRequest::addCancellationToken(folly::CancellationToken token) {
+  if (token.canBeCancelled()) {
+    cancellationTokens_.push_back(std::move(token));
+  } else {
+    uncancellable_ = true;
+  }
+}
+
+void HgImportRequest::addFetchersOf(const HgImportRequest& other) {
+  if (other.uncancellable_ || other.cancellationTokens_.empty()) {
+    uncancellable_ = true;
+    return;
+  }
+  cancellationTokens_.insert(
+      cancellationTokens_.end(),
+      other.cancellationTokens_.begin(),
+      other.cancellationTokens_.end());
+}
+
+bool HgImportRequest::isCancelled() const {
+  if (uncancellable_ || cancellationTokens_.empty()) {
+    return false;
+  }
+  return std::all_of(
+      cancellationTokens_.begin(),
+      cancellationTokens_.end(),
+      [](const folly::CancellationToken& token) {
+        return token.isCancellationRequested();
+      });
 }
 
 } // namespace facebook::eden
@@ -7,11 +7,16 @@
 
 #pragma once
 
+#include <folly/CancellationToken.h>
 #include <folly/futures/Promise.h>
+#include <limits>
+#include <optional>
 #include <utility>
 #include <variant>
+#include <vector>
 
 #include "eden/fs/model/Blob.h"
+#include "eden/fs/model/BlobMetadata.h"
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/model/Tree.h"
 #include "eden/fs/store/ImportPriority.h"
@@ -32,7 +37,7 @@ namespace facebook::eden {
 class HgImportRequest {
  public:
   struct BlobImport {
-    using Response = std::unique_ptr<Blob>;
+    using Response = BlobPtr;
     BlobImport(ObjectId hash, HgProxyHash proxyHash)
         : hash(hash), proxyHash(proxyHash) {}
 
@@ -45,7 +50,7 @@ class HgImportRequest {
   };
 
   struct TreeImport {
-    using Response = std::unique_ptr<Tree>;
+    using Response = TreePtr;
     TreeImport(ObjectId hash, HgProxyHash proxyHash)
         : hash(hash), proxyHash(proxyHash) {}
 
@@ -56,23 +61,54 @@ class HgImportRequest {
     std::vector<folly::Promise<Response>> promises;
   };
 
+  struct BlobMetadataImport {
+    using Response = BlobMetadataPtr;
+    BlobMetadataImport(ObjectId hash, HgProxyHash proxyHash)
+        : hash(hash), proxyHash(proxyHash) {}
+
+    ObjectId hash;
+    HgProxyHash proxyHash;
+
+    // See the comment above for BlobImport::promises
+    std::vector<folly::Promise<Response>> promises;
+  };
+
   /**
    * Allocate a blob request.
+   *
+   * traceId is the trace ID of the fetch context the import is for, zero if
+   * there is none.
    */
   static std::shared_ptr<HgImportRequest> makeBlobImportRequest(
       ObjectId hash,
       HgProxyHash proxyHash,
       ImportPriority priority,
-      ObjectFetchContext::Cause cause);
+      ObjectFetchContext::Cause cause,
+      uint64_t traceId = 0);
 
   /**
    * Allocate a tree request.
+   *
+   * traceId is the trace ID of the fetch context the import is for, zero if
+   * there is none.
    */
   static std::shared_ptr<HgImportRequest> makeTreeImportRequest(
       ObjectId hash,
       HgProxyHash proxyHash,
       ImportPriority priority,
-      ObjectFetchContext::Cause cause);
+      ObjectFetchContext::Cause cause,
+      uint64_t traceId = 0);
+
+  /**
+   * Allocate a request for the size and SHA-1 of a blob, without its
+   * contents.
+   */
+  static std::shared_ptr<HgImportRequest> makeBlobMetadataImportRequest(
+      ObjectId hash,
+      HgProxyHash proxyHash,
+      ImportPriority priority,
+      ObjectFetchContext::Cause cause,
+      uint64_t traceId = 0);
 
   /**
    * Implementation detail of the make*Request functions from above. Do not use
@@ -83,6 +119,7 @@ class HgImportRequest {
       RequestType request,
       ImportPriority priority,
       ObjectFetchContext::Cause cause,
+      uint64_t traceId,
       folly::Promise<typename RequestType::Response>&& promise);
 
   ~HgImportRequest() = default;
@@ -130,10 +167,62 @@ class HgImportRequest {
     return unique_;
   }
 
+  uint64_t getTraceId() const {
+    return traceId_;
+  }
+
   std::chrono::steady_clock::time_point getRequestTime() const {
     return requestTime_;
   }
 
+  /**
+   * When a worker dequeued the request and started the batch fetch, from
+   * hgcache and then the server, that it is part of. Unset for a request
+   * that was deduplicated with one already in the queue.
+   *
+   * Set by the worker before it fulfills the promise, and so visible to the
+   * promise's callbacks.
+   */
+  std::chrono::steady_clock::time_point getBatchStartTime() const {
+    return batchStartTime_;
+  }
+
+  void setBatchStartTime(std::chrono::steady_clock::time_point time) {
+    batchStartTime_ = time;
+  }
+
+  /**
+   * When the batch fetch failed to find the object and the worker fell back
+   * to the hg importer. Unset if the batch fetch found it.
+   */
+  std::chrono::steady_clock::time_point getImporterStartTime() const {
+    return importerStartTime_;
+  }
+
+  void setImporterStartTime(std::chrono::steady_clock::time_point time) {
+    importerStartTime_ = time;
+  }
+
+  /**
+   * Records the cancellation token of the fetch this request is for, see
+   * ObjectFetchContext::getCancellationToken. Must be called before the
+   * request is enqueued.
+   */
+  void addCancellationToken(folly::CancellationToken token);
+
+  /**
+   * The process this request is fetched for, if known. The queue shares its
+   * workers fairly between clients. Must be set before the request is
+   * enqueued.
+   */
+  std::optional<pid_t> getClientPid() const noexcept {
+    return clientPid_;
+  }
+
+  void setClientPid(std::optional<pid_t> clientPid) noexcept {
+    clientPid_ = clientPid;
+  }
+
  private:
   /**
    * Implementation detail of the various make*Request functions.
@@ -142,23 +231,64 @@ class HgImportRequest {
   static std::shared_ptr<HgImportRequest> makeRequest(
       ImportPriority priority,
       ObjectFetchContext::Cause cause,
+      uint64_t traceId,
       Input&&... input);
 
   HgImportRequest(const HgImportRequest&) = delete;
   HgImportRequest& operator=(const HgImportRequest&) = delete;
 
-  using Request = std::variant<BlobImport, TreeImport>;
+  /**
+   * Makes this request wait on behalf of the fetches of other too, which was
+   * deduplicated with it.
+   */
+  void addFetchersOf(const HgImportRequest& other);
+
+  /**
+   * Whether every fetch waiting on this request was cancelled.
+   */
+  bool isCancelled() const;
+
+  using Request = std::variant<BlobImport, TreeImport, BlobMetadataImport>;
   using Response = std::variant<
-      folly::Promise<std::unique_ptr<Blob>>,
-      folly::Promise<std::unique_ptr<Tree>>>;
+      folly::Promise<BlobImport::Response>,
+      folly::Promise<TreeImport::Response>,
+      folly::Promise<BlobMetadataImport::Response>>;
 
   Request request_;
   ImportPriority priority_;
   ObjectFetchContext::Cause cause_;
   Response promise_;
   uint64_t unique_ = generateUniqueID();
+  uint64_t traceId_;
   std::chrono::steady_clock::time_point requestTime_ =
       std::chrono::steady_clock::now();
+  std::chrono::steady_clock::time_point batchStartTime_;
+  std::chrono::steady_clock::time_point importerStartTime_;
+  std::optional<pid_t> clientPid_;
+
+  /**
+   * Position of this request in its HgImportRequestQueue, or kNotQueued when
+   * it is not in a queue. Only accessed by the HgImportRequestQueue, under its
+   * lock.
+   */
+  static constexpr size_t kNotQueued = std::numeric_limits<size_t>::max();
+  size_t queueIndex_ = kNotQueued;
+
+  /**
+   * The client whose share of the queue this request is served from. Set by
+   * the HgImportRequestQueue when the request is enqueued.
+   */
+  uint64_t flowKey_ = 0;
+
+  /**
+   * The cancellation tokens of the fetches waiting on this request, and
+   * whether one of them can't be cancelled. Only accessed by the
+   * HgImportRequestQueue, under its lock, once the request is enqueued.
+   */
+  std::vector<folly::CancellationToken> cancellationTokens_;
+  bool uncancellable_ = false;
+
+  friend class HgImportRequestQueue;
 
   friend bool operator<(
       const HgImportRequest& lhs,
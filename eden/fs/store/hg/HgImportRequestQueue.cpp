@@ -6,12 +6,251 @@
  */
 
 #include "eden/fs/store/hg/HgImportRequestQueue.h"
+#include <folly/Utility.h>
 #include <folly/futures/Future.h>
+#include <folly/logging/xlog.h>
 #include <algorithm>
 #include "eden/fs/config/ReloadableConfig.h"
 
 namespace facebook::eden {
 
+size_t HgImportRequestQueue::RequestQueue::levelOf(
+    ImportPriority priority) noexcept {
+  return folly::to_underlying(priority.getClass());
+}
+
+double HgImportRequestQueue::RequestQueue::score(
+    const HgImportRequest& request,
+    std::chrono::nanoseconds agingInterval) noexcept {
+  auto score = static_cast<double>(request.getPriority().getAdjustment());
+  if (agingInterval.count() > 0) {
+    // A request that waited for one more agingInterval than another one
+    // compares as if it had one more unit of adjustment. Since all the
+    // requests age at the same rate, the ordering only depends on the time
+    // they were created at, and the heaps never need to be re-sorted.
+    auto requestTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        request.getRequestTime().time_since_epoch());
+    score -= static_cast<double>(requestTime.count()) /
+        static_cast<double>(agingInterval.count());
+  }
+  return score;
+}
+
+bool HgImportRequestQueue::RequestQueue::higher(
+    const Entry& lhs,
+    const Entry& rhs) noexcept {
+  if (lhs.score != rhs.score) {
+    return lhs.score > rhs.score;
+  }
+  // Unique IDs are allocated in increasing order: serve older requests first.
+  return lhs.unique < rhs.unique;
+}
+
+const HgImportRequestQueue::RequestQueue::Entry&
+HgImportRequestQueue::RequestQueue::head(const Level& level) noexcept {
+  return level.flows.find(level.order.front())->second.heap.front();
+}
+
+void HgImportRequestQueue::RequestQueue::place(
+    Heap& heap,
+    size_t index,
+    Entry entry) noexcept {
+  entry.request->queueIndex_ = index;
+  heap[index] = std::move(entry);
+}
+
+void HgImportRequestQueue::RequestQueue::siftUp(
+    Heap& heap,
+    size_t index) noexcept {
+  auto entry = std::move(heap[index]);
+  while (index > 0) {
+    auto parent = (index - 1) / 2;
+    if (!higher(entry, heap[parent])) {
+      break;
+    }
+    place(heap, index, std::move(heap[parent]));
+    index = parent;
+  }
+  place(heap, index, std::move(entry));
+}
+
+void HgImportRequestQueue::RequestQueue::siftDown(
+    Heap& heap,
+    size_t index) noexcept {
+  auto entry = std::move(heap[index]);
+  auto size = heap.size();
+  while (true) {
+    auto child = 2 * index + 1;
+    if (child >= size) {
+      break;
+    }
+    if (child + 1 < size && higher(heap[child + 1], heap[child])) {
+      ++child;
+    }
+    if (!higher(heap[child], entry)) {
+      break;
+    }
+    place(heap, index, std::move(heap[child]));
+    index = child;
+  }
+  place(heap, index, std::move(entry));
+}
+
+std::shared_ptr<HgImportRequest> HgImportRequestQueue::RequestQueue::removeAt(
+    size_t levelIndex,
+    uint64_t flowKey,
+    size_t index) {
+  auto& level = levels_[levelIndex];
+  auto flow = level.flows.find(flowKey);
+  auto& heap = flow->second.heap;
+  auto request = std::move(heap[index].request);
+  request->queueIndex_ = HgImportRequest::kNotQueued;
+
+  auto last = heap.size() - 1;
+  if (index != last) {
+    place(heap, index, std::move(heap[last]));
+    heap.pop_back();
+    siftDown(heap, index);
+    siftUp(heap, index);
+  } else {
+    heap.pop_back();
+  }
+  --level.size;
+  --size_;
+
+  if (heap.empty()) {
+    level.flows.erase(flow);
+    level.order.erase(
+        std::find(level.order.begin(), level.order.end(), flowKey));
+  }
+  return request;
+}
+
+void HgImportRequestQueue::RequestQueue::push(
+    std::shared_ptr<HgImportRequest> request,
+    std::chrono::nanoseconds agingInterval) {
+  auto& level = levels_[levelOf(request->getPriority())];
+  auto [flow, inserted] = level.flows.try_emplace(request->flowKey_);
+  if (inserted) {
+    level.order.push_back(request->flowKey_);
+  }
+  auto& heap = flow->second.heap;
+  auto entryScore = score(*request, agingInterval);
+  auto unique = request->getUnique();
+  heap.push_back(Entry{entryScore, unique, std::move(request)});
+  ++level.size;
+  ++size_;
+  siftUp(heap, heap.size() - 1);
+}
+
+void HgImportRequestQueue::RequestQueue::raisePriority(
+    HgImportRequest& request,
+    ImportPriority priority,
+    std::chrono::nanoseconds agingInterval) {
+  auto oldLevel = levelOf(request.getPriority());
+  auto index = request.queueIndex_;
+  request.setPriority(priority);
+
+  if (levelOf(priority) == oldLevel) {
+    auto& heap = levels_[oldLevel].flows.find(request.flowKey_)->second.heap;
+    heap[index].score = score(request, agingInterval);
+    siftUp(heap, index);
+  } else {
+    push(removeAt(oldLevel, request.flowKey_, index), agingInterval);
+  }
+}
+
+HgImportRequestQueue::RequestQueue::Front
+HgImportRequestQueue::RequestQueue::front(
+    std::chrono::steady_clock::time_point now,
+    std::chrono::nanoseconds starvationThreshold) const {
+  Front result;
+  size_t highest = kLevelCount;
+  for (size_t i = kLevelCount; i > 0; --i) {
+    if (levels_[i - 1].size != 0) {
+      highest = i - 1;
+      break;
+    }
+  }
+  if (highest == kLevelCount) {
+    return result;
+  }
+
+  result.level = highest;
+  if (starvationThreshold.count() > 0) {
+    // Serve the oldest starving head of the lower classes first.
+    auto oldest = now - starvationThreshold;
+    for (size_t i = 0; i < highest; ++i) {
+      const auto& level = levels_[i];
+      if (level.size == 0) {
+        continue;
+      }
+      auto requestTime = head(level).request->getRequestTime();
+      if (requestTime < oldest) {
+        oldest = requestTime;
+        result.level = i;
+        result.starving = true;
+      }
+    }
+  }
+
+  const auto& entry = head(levels_[result.level]);
+  result.request = entry.request.get();
+  result.score = entry.score;
+  return result;
+}
+
+std::shared_ptr<HgImportRequest> HgImportRequestQueue::RequestQueue::pop(
+    std::chrono::steady_clock::time_point now,
+    std::chrono::nanoseconds starvationThreshold,
+    uint32_t quantum) {
+  auto next = front(now, starvationThreshold);
+  if (!next.request) {
+    return nullptr;
+  }
+
+  auto& level = levels_[next.level];
+  auto flowKey = level.order.front();
+  auto& flow = level.flows.find(flowKey)->second;
+  if (flow.deficit == 0) {
+    // A new turn.
+    flow.deficit = std::max(quantum, uint32_t{1});
+  }
+  --flow.deficit;
+  if (flow.deficit == 0 && flow.heap.size() > 1) {
+    level.order.pop_front();
+    level.order.push_back(flowKey);
+  }
+  return removeAt(next.level, flowKey, 0);
+}
+
+bool HgImportRequestQueue::RequestQueue::hasRequestAtLeast(
+    ImportPriority::Class cls) const noexcept {
+  for (size_t i = folly::to_underlying(cls); i < kLevelCount; ++i) {
+    if (levels_[i].size != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void HgImportRequestQueue::RequestQueue::drainInto(
+    std::vector<std::shared_ptr<HgImportRequest>>& result) {
+  result.reserve(result.size() + size_);
+  for (auto& level : levels_) {
+    for (auto& [key, flow] : level.flows) {
+      for (auto& entry : flow.heap) {
+        entry.request->queueIndex_ = HgImportRequest::kNotQueued;
+        result.emplace_back(std::move(entry.request));
+      }
+    }
+    level.flows.clear();
+    level.order.clear();
+    level.size = 0;
+  }
+  size_ = 0;
+}
+
 void HgImportRequestQueue::stop() {
   auto state = state_.lock();
   if (state->running) {
@@ -20,132 +259,300 @@ void HgImportRequestQueue::stop() {
   }
 }
 
-folly::Future<std::unique_ptr<Blob>> HgImportRequestQueue::enqueueBlob(
+folly::Future<BlobPtr> HgImportRequestQueue::enqueueBlob(
     std::shared_ptr<HgImportRequest> request) {
-  return enqueue<std::unique_ptr<Blob>, HgImportRequest::BlobImport>(
-      std::move(request));
+  return enqueue<BlobPtr, HgImportRequest::BlobImport>(std::move(request));
 }
 
-folly::Future<std::unique_ptr<Tree>> HgImportRequestQueue::enqueueTree(
+folly::Future<TreePtr> HgImportRequestQueue::enqueueTree(
     std::shared_ptr<HgImportRequest> request) {
-  return enqueue<std::unique_ptr<Tree>, HgImportRequest::TreeImport>(
+  return enqueue<TreePtr, HgImportRequest::TreeImport>(std::move(request));
+}
+
+folly::Future<BlobMetadataPtr> HgImportRequestQueue::enqueueBlobMetadata(
+    std::shared_ptr<HgImportRequest> request) {
+  return enqueue<BlobMetadataPtr, HgImportRequest::BlobMetadataImport>(
       std::move(request));
 }
 
+uint64_t HgImportRequestQueue::flowKeyOf(
+    const HgImportRequest& request) noexcept {
+  if (auto pid = request.getClientPid()) {
+    return static_cast<uint32_t>(*pid);
+  }
+  return (uint64_t{1} << 32) | folly::to_underlying(request.getCause());
+}
+
 template <typename Ret, typename ImportType>
 folly::Future<Ret> HgImportRequestQueue::enqueue(
     std::shared_ptr<HgImportRequest> request) {
+  auto config = config_->getEdenConfig();
+  auto agingInterval = config->importRequestAgingInterval.getValue();
+  if (config->importFairShareQuantum.getValue() > 0) {
+    request->flowKey_ = flowKeyOf(*request);
+  }
+
   auto state = state_.lock();
 
-  std::vector<std::shared_ptr<HgImportRequest>>* queue;
+  RequestQueue* queue;
+  auto* tracker = &state->requestTracker;
   if constexpr (std::is_same_v<ImportType, HgImportRequest::BlobImport>) {
     queue = &state->blobQueue;
+  } else if constexpr (std::is_same_v<
+                           ImportType,
+                           HgImportRequest::BlobMetadataImport>) {
+    queue = &state->blobMetadataQueue;
+    tracker = &state->metadataTracker;
   } else {
     static_assert(std::is_same_v<ImportType, HgImportRequest::TreeImport>);
     queue = &state->treeQueue;
   }
 
   const auto& hash = request->getRequest<ImportType>()->hash;
-  if (auto* existingRequestPtr = folly::get_ptr(state->requestTracker, hash)) {
+  auto* existingRequestPtr = folly::get_ptr(*tracker, hash);
+  if (existingRequestPtr &&
+      (*existingRequestPtr)->queueIndex_ == HgImportRequest::kNotQueued &&
+      (*existingRequestPtr)->isCancelled()) {
+    // The existing request is being, or about to be, failed as cancelled:
+    // fetch again without tracking this request, so that the completion of
+    // one can't be mistaken for the other's.
+    auto promise = request->getPromise<Ret>();
+    queue->push(std::move(request), agingInterval);
+    queueCV_.notify_one();
+    return promise->getFuture();
+  }
+  if (existingRequestPtr) {
     auto& existingRequest = *existingRequestPtr;
+    existingRequest->addFetchersOf(*request);
     auto* trackedImport = existingRequest->template getRequest<ImportType>();
 
     auto [promise, future] = folly::makePromiseContract<Ret>();
     trackedImport->promises.emplace_back(std::move(promise));
 
     if (existingRequest->getPriority() < request->getPriority()) {
-      existingRequest->setPriority(request->getPriority());
-
-      // Since the new request has a higher priority than the already present
-      // one, we need to re-order the heap.
-      //
-      // TODO(xavierd): this has a O(n) complexity, and enqueing tons of
-      // duplicated requests will thus lead to a quadratic complexity.
-      std::make_heap(
-          queue->begin(),
-          queue->end(),
-          [](const std::shared_ptr<HgImportRequest>& lhs,
-             const std::shared_ptr<HgImportRequest>& rhs) {
-            return (*lhs) < (*rhs);
-          });
+      if (existingRequest->queueIndex_ != HgImportRequest::kNotQueued) {
+        queue->raisePriority(
+            *existingRequest, request->getPriority(), agingInterval);
+      } else {
+        // Already dequeued and being imported.
+        existingRequest->setPriority(request->getPriority());
+      }
     }
 
     return std::move(future).toUnsafeFuture();
   }
 
-  queue->emplace_back(request);
   auto promise = request->getPromise<Ret>();
-
-  state->requestTracker.emplace(hash, std::move(request));
-
-  std::push_heap(
-      queue->begin(),
-      queue->end(),
-      [](const std::shared_ptr<HgImportRequest>& lhs,
-         const std::shared_ptr<HgImportRequest>& rhs) {
-        return (*lhs) < (*rhs);
-      });
+  tracker->emplace(hash, request);
+  queue->push(std::move(request), agingInterval);
 
   queueCV_.notify_one();
 
   return promise->getFuture();
 }
 
+void HgImportRequestQueue::recordBlobBatch(
+    size_t batchSize,
+    std::chrono::nanoseconds latency) {
+  auto config = config_->getEdenConfig();
+  state_.lock()->blobBatchSizer.recordBatch(
+      batchSize,
+      latency,
+      config->importBatchSize.getValue(),
+      config->importBatchTargetLatency.getValue());
+}
+
+void HgImportRequestQueue::recordTreeBatch(
+    size_t batchSize,
+    std::chrono::nanoseconds latency) {
+  auto config = config_->getEdenConfig();
+  state_.lock()->treeBatchSizer.recordBatch(
+      batchSize,
+      latency,
+      config->importBatchSizeTree.getValue(),
+      config->importBatchTargetLatency.getValue());
+}
+
+void HgImportRequestQueue::recordBlobMetadataBatch(
+    size_t batchSize,
+    std::chrono::nanoseconds latency) {
+  auto config = config_->getEdenConfig();
+  state_.lock()->blobMetadataBatchSizer.recordBatch(
+      batchSize,
+      latency,
+      config->importBatchSize.getValue(),
+      config->importBatchTargetLatency.getValue());
+}
+
+HgImportRequestQueue::ClientStats HgImportRequestQueue::getClientStats()
+    const {
+  struct Client {
+    size_t depth{0};
+    std::chrono::steady_clock::time_point oldest{
+        std::chrono::steady_clock::time_point::max()};
+  };
+  folly::F14FastMap<uint64_t, Client> clients;
+  auto record = [&](const HgImportRequest& request) {
+    auto& client = clients[flowKeyOf(request)];
+    ++client.depth;
+    client.oldest = std::min(client.oldest, request.getRequestTime());
+  };
+
+  {
+    auto state = state_.lock();
+    state->treeQueue.forEach(record);
+    state->blobQueue.forEach(record);
+    state->blobMetadataQueue.forEach(record);
+  }
+
+  ClientStats stats;
+  stats.clients = clients.size();
+  auto now = std::chrono::steady_clock::now();
+  for (const auto& [key, client] : clients) {
+    stats.maxDepth = std::max(stats.maxDepth, client.depth);
+    stats.maxWait = std::max<std::chrono::nanoseconds>(
+        stats.maxWait, now - client.oldest);
+  }
+  return stats;
+}
+
 std::vector<std::shared_ptr<HgImportRequest>>
 HgImportRequestQueue::combineAndClearRequestQueues() {
   auto state = state_.lock();
   auto treeQSz = state->treeQueue.size();
   auto blobQSz = state->blobQueue.size();
+  auto metaQSz = state->blobMetadataQueue.size();
   XLOGF(
       DBG5,
-      "combineAndClearRequestQueues: tree queue size = {}, blob queue size = {}",
+      "combineAndClearRequestQueues: tree queue size = {}, blob queue size = {}"
+      ", blob metadata queue size = {}",
       treeQSz,
-      blobQSz);
-  auto res = std::move(state->treeQueue);
-  res.insert(
-      res.end(),
-      std::make_move_iterator(state->blobQueue.begin()),
-      std::make_move_iterator(state->blobQueue.end()));
-  state->treeQueue.clear();
-  state->blobQueue.clear();
-  XCHECK_EQ(res.size(), treeQSz + blobQSz);
+      blobQSz,
+      metaQSz);
+  std::vector<std::shared_ptr<HgImportRequest>> res;
+  state->treeQueue.drainInto(res);
+  state->blobQueue.drainInto(res);
+  state->blobMetadataQueue.drainInto(res);
+  XCHECK_EQ(res.size(), treeQSz + blobQSz + metaQSz);
   return res;
 }
 
 std::vector<std::shared_ptr<HgImportRequest>> HgImportRequestQueue::dequeue() {
+  while (true) {
+    std::vector<std::shared_ptr<HgImportRequest>> cancelled;
+    auto requests = dequeueBatch(cancelled);
+
+    for (auto& request : cancelled) {
+      XLOG(DBG4) << "dropping cancelled import request "
+                 << request->getUnique();
+      // This runs the callbacks of the request, which fail the deduplicated
+      // fetches as well.
+      if (request->isType<HgImportRequest::BlobImport>()) {
+        request->getPromise<HgImportRequest::BlobImport::Response>()
+            ->setException(folly::OperationCancelled{});
+      } else if (request->isType<HgImportRequest::BlobMetadataImport>()) {
+        request->getPromise<HgImportRequest::BlobMetadataImport::Response>()
+            ->setException(folly::OperationCancelled{});
+      } else {
+        request->getPromise<HgImportRequest::TreeImport::Response>()
+            ->setException(folly::OperationCancelled{});
+      }
+    }
+
+    // An empty batch without cancelled requests means the queue stopped.
+    if (!requests.empty() || cancelled.empty()) {
+      return requests;
+    }
+  }
+}
+
+std::vector<std::shared_ptr<HgImportRequest>>
+HgImportRequestQueue::dequeueBatch(
+    std::vector<std::shared_ptr<HgImportRequest>>& cancelled) {
   size_t count;
-  std::vector<std::shared_ptr<HgImportRequest>>* queue = nullptr;
+  RequestQueue* queue = nullptr;
+  std::chrono::steady_clock::time_point now;
+  std::chrono::nanoseconds starvationThreshold;
+  uint32_t quantum = 0;
+  bool lingered = false;
 
   auto state = state_.lock();
   while (true) {
     if (!state->running) {
-      state->treeQueue.clear();
-      state->blobQueue.clear();
+      std::vector<std::shared_ptr<HgImportRequest>> discarded;
+      state->treeQueue.drainInto(discarded);
+      state->blobQueue.drainInto(discarded);
+      state->blobMetadataQueue.drainInto(discarded);
       return std::vector<std::shared_ptr<HgImportRequest>>();
     }
 
-    auto highestPriority = ImportPriority::minimumValue();
+    auto config = config_->getEdenConfig();
+    starvationThreshold = config->importRequestStarvationThreshold.getValue();
+    quantum = config->importFairShareQuantum.getValue();
+    now = std::chrono::steady_clock::now();
+    auto treeFront = state->treeQueue.front(now, starvationThreshold);
+    auto blobFront = state->blobQueue.front(now, starvationThreshold);
+    auto metadataFront =
+        state->blobMetadataQueue.front(now, starvationThreshold);
 
-    // Trees have a higher priority than blobs, thus check the queues in that
-    // order.  The reason for trees having a higher priority is due to trees
-    // allowing a higher fan-out and thus increasing concurrency of fetches
-    // which translate onto a higher overall throughput.
-    if (!state->treeQueue.empty()) {
-      count = config_->getEdenConfig()->importBatchSizeTree.getValue();
-      highestPriority = state->treeQueue.front()->getPriority();
-      queue = &state->treeQueue;
+    // Trees have a higher priority than blobs, thus blobs are only picked when
+    // strictly more important.  The reason for trees having a higher priority
+    // is due to trees allowing a higher fan-out and thus increasing
+    // concurrency of fetches which translate onto a higher overall
+    // throughput. Blob metadata comes last for the same reason.
+    auto moreImportant = [](const RequestQueue::Front& lhs,
+                            const RequestQueue::Front& rhs) {
+      if (!rhs.request) {
+        return true;
+      }
+      if (lhs.starving != rhs.starving) {
+        return lhs.starving;
+      }
+      if (lhs.level != rhs.level) {
+        return lhs.level > rhs.level;
+      }
+      return lhs.score > rhs.score;
+    };
+
+    const RequestQueue::Front* front = &treeFront;
+    queue = &state->treeQueue;
+    if (blobFront.request && moreImportant(blobFront, *front)) {
+      front = &blobFront;
+      queue = &state->blobQueue;
+    }
+    if (metadataFront.request && moreImportant(metadataFront, *front)) {
+      front = &metadataFront;
+      queue = &state->blobMetadataQueue;
     }
 
-    if (!state->blobQueue.empty()) {
-      auto priority = state->blobQueue.front()->getPriority();
-      if (!queue || priority > highestPriority) {
-        queue = &state->blobQueue;
-        count = config_->getEdenConfig()->importBatchSize.getValue();
-        highestPriority = priority;
+    if (front->request) {
+      auto targetLatency = config->importBatchTargetLatency.getValue();
+      if (queue == &state->blobQueue) {
+        count = state->blobBatchSizer.getBatchSize(
+            config->importBatchSize.getValue(), targetLatency);
+      } else if (queue == &state->blobMetadataQueue) {
+        count = state->blobMetadataBatchSizer.getBatchSize(
+            config->importBatchSize.getValue(), targetLatency);
+      } else {
+        count = state->treeBatchSizer.getBatchSize(
+            config->importBatchSizeTree.getValue(), targetLatency);
       }
-    }
 
-    if (queue) {
+      // Wait once for near-simultaneous requests to fill the batch, unless
+      // an interactive request is, or becomes, ready to be served.
+      auto linger = config->importBatchLinger.getValue();
+      auto interactive = ImportPriority::Class::High;
+      if (!lingered && linger.count() > 0 && queue->size() < count &&
+          front->request->getPriority().getClass() < interactive) {
+        lingered = true;
+        queueCV_.wait_until(state.as_lock(), now + linger, [&] {
+          return !state->running || queue->size() >= count ||
+              state->treeQueue.hasRequestAtLeast(interactive) ||
+              state->blobQueue.hasRequestAtLeast(interactive) ||
+              state->blobMetadataQueue.hasRequestAtLeast(interactive);
+        });
+        continue;
+      }
       break;
     } else {
       queueCV_.wait(state.as_lock());
@@ -156,16 +563,12 @@ std::vector<std::shared_ptr<HgImportRequest>> HgImportRequestQueue::dequeue() {
   std::vector<std::shared_ptr<HgImportRequest>> result;
   result.reserve(count);
   for (size_t i = 0; i < count; i++) {
-    std::pop_heap(
-        queue->begin(),
-        queue->end(),
-        [](const std::shared_ptr<HgImportRequest>& lhs,
-           const std::shared_ptr<HgImportRequest>& rhs) {
-          return (*lhs) < (*rhs);
-        });
-
-    result.emplace_back(std::move(queue->back()));
-    queue->pop_back();
+    auto request = queue->pop(now, starvationThreshold, quantum);
+    if (request->isCancelled()) {
+      cancelled.push_back(std::move(request));
+    } else {
+      result.push_back(std::move(request));
+    }
   }
 
   return result;
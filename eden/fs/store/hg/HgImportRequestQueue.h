@@ -10,17 +10,47 @@
 #include <folly/Synchronized.h>
 #include <folly/Try.h>
 #include <folly/container/F14Map.h>
+#include <array>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <mutex>
 #include <vector>
 #include "eden/fs/model/Hash.h"
+#include "eden/fs/store/hg/HgImportBatchSizer.h"
 #include "eden/fs/store/hg/HgImportRequest.h"
+#include "eden/fs/telemetry/LockContention.h"
 #include "folly/futures/Future.h"
 
 namespace facebook::eden {
 
 class ReloadableConfig;
 
+inline constexpr char kHgImportRequestQueueLockSite[] =
+    "hg_import_request_queue";
+
+/**
+ * Queue of pending Mercurial import requests. Trees, blobs and blob metadata
+ * are queued separately, and each is organized as one heap per
+ * ImportPriority::Class so that an interactive request is never ordered
+ * against a large backlog of prefetches.
+ *
+ * Within a class, requests are ordered by priority adjustment, and ties are
+ * served in FIFO order. Requests age: they gain one unit of adjustment per
+ * `hg:import-request-aging-interval` spent in the queue, and a request that
+ * waited longer than `hg:import-request-starvation-threshold` is served before
+ * requests of higher classes.
+ *
+ * When `hg:import-fair-share-quantum` is set, the requests of a class are
+ * further split by the process they are fetched for, and these clients are
+ * served in deficit round-robin so that one of them can't monopolize the
+ * import threads.
+ *
+ * Batches adapt their size to the import latency reported through
+ * recordBlobBatch(), recordTreeBatch() and recordBlobMetadataBatch() when
+ * `hg:import-batch-target-latency` is set, and may linger for
+ * `hg:import-batch-linger` to let near-simultaneous requests join them.
+ */
 class HgImportRequestQueue {
  public:
   explicit HgImportRequestQueue(std::shared_ptr<ReloadableConfig> config)
@@ -31,7 +61,7 @@ class HgImportRequestQueue {
    *
    * Return a future that will complete when the blob request completes.
    */
-  folly::Future<std::unique_ptr<Blob>> enqueueBlob(
+  folly::Future<BlobPtr> enqueueBlob(
       std::shared_ptr<HgImportRequest> request);
 
   /**
@@ -39,7 +69,15 @@ class HgImportRequestQueue {
    *
    * Return a future that will complete when the blob request completes.
    */
-  folly::Future<std::unique_ptr<Tree>> enqueueTree(
+  folly::Future<TreePtr> enqueueTree(
+      std::shared_ptr<HgImportRequest> request);
+
+  /**
+   * Enqueue a blob metadata request to the queue.
+   *
+   * Return a future that will complete when the metadata request completes.
+   */
+  folly::Future<BlobMetadataPtr> enqueueBlobMetadata(
       std::shared_ptr<HgImportRequest> request);
 
   /**
@@ -50,9 +88,37 @@ class HgImportRequestQueue {
    * All requests in the vector are guaranteed to be the same type.
    * The number of the returned requests is controlled by `import-batch-size*`
    * options in the config. It may have fewer requests than configured.
+   *
+   * The requests that every waiting fetch cancelled are failed with
+   * folly::OperationCancelled instead of being returned.
    */
   std::vector<std::shared_ptr<HgImportRequest>> dequeue();
 
+  /**
+   * Report how long it took to import a batch of requests returned by
+   * dequeue().
+   */
+  void recordBlobBatch(size_t batchSize, std::chrono::nanoseconds latency);
+  void recordTreeBatch(size_t batchSize, std::chrono::nanoseconds latency);
+  void recordBlobMetadataBatch(
+      size_t batchSize,
+      std::chrono::nanoseconds latency);
+
+  struct ClientStats {
+    /// Number of clients that have requests in the queue.
+    size_t clients{0};
+    /// The most requests queued for a single client.
+    size_t maxDepth{0};
+    /// How long the oldest queued request has been waiting.
+    std::chrono::nanoseconds maxWait{0};
+  };
+
+  /**
+   * Summarizes how the queued requests are spread between their clients.
+   * This walks the whole queue.
+   */
+  ClientStats getClientStats() const;
+
   /**
    * Destroy the queue.
    *
@@ -66,15 +132,18 @@ class HgImportRequestQueue {
   template <typename T>
   void markImportAsFinished(
       const ObjectId& id,
-      folly::Try<std::unique_ptr<T>>& importTry) {
+      const folly::Try<std::shared_ptr<const T>>& importTry) {
     std::shared_ptr<HgImportRequest> import;
     {
       auto state = state_.lock();
 
-      auto importReq = state->requestTracker.find(id);
-      if (importReq != state->requestTracker.end()) {
+      auto& tracker = std::is_same_v<T, BlobMetadata>
+          ? state->metadataTracker
+          : state->requestTracker;
+      auto importReq = tracker.find(id);
+      if (importReq != tracker.end()) {
         import = std::move(importReq->second);
-        state->requestTracker.erase(importReq);
+        tracker.erase(importReq);
       }
     }
 
@@ -82,25 +151,30 @@ class HgImportRequestQueue {
       return;
     }
 
-    std::vector<folly::Promise<std::unique_ptr<T>>>* promises;
+    std::vector<folly::Promise<std::shared_ptr<const T>>>* promises;
 
     if constexpr (std::is_same_v<T, Tree>) {
       auto* treeImport = import->getRequest<HgImportRequest::TreeImport>();
       promises = &treeImport->promises;
+    } else if constexpr (std::is_same_v<T, BlobMetadata>) {
+      auto* metadataImport =
+          import->getRequest<HgImportRequest::BlobMetadataImport>();
+      promises = &metadataImport->promises;
     } else {
       static_assert(
           std::is_same_v<T, Blob>,
-          "markImportAsFinished can only be called with Tree or Blob types");
+          "markImportAsFinished can only be called with Tree, Blob or "
+          "BlobMetadata types");
       auto* blobImport = import->getRequest<HgImportRequest::BlobImport>();
       promises = &blobImport->promises;
     }
 
     if (importTry.hasValue()) {
       // If we find the id in the map, loop through all of the associated
-      // Promises and fulfill them with the obj. We need to construct a
-      // deep copy of the unique_ptr to fulfill the Promises
+      // Promises and fulfill them with the obj. The object is immutable, so
+      // all the duplicate requests share the same instance.
       for (auto& promise : (*promises)) {
-        promise.setValue(std::make_unique<T>(*(importTry.value())));
+        promise.setValue(importTry.value());
       }
     } else {
       // If we find the id in the map, loop through all of the associated
@@ -123,13 +197,151 @@ class HgImportRequestQueue {
   template <typename Ret, typename ImportType>
   folly::Future<Ret> enqueue(std::shared_ptr<HgImportRequest> request);
 
+  /**
+   * The flow a request is queued in: one per client process, or per fetch
+   * cause for the requests whose process isn't known.
+   */
+  static uint64_t flowKeyOf(const HgImportRequest& request) noexcept;
+
+  /**
+   * Implementation of dequeue: returns the next batch, minus its cancelled
+   * requests, which are moved to cancelled so that they can be failed once
+   * the lock is released.
+   */
+  std::vector<std::shared_ptr<HgImportRequest>> dequeueBatch(
+      std::vector<std::shared_ptr<HgImportRequest>>& cancelled);
+
   HgImportRequestQueue(HgImportRequestQueue&&) = delete;
   HgImportRequestQueue& operator=(HgImportRequestQueue&&) = delete;
 
+  /**
+   * The queued requests of one type. Each priority class has one binary
+   * max-heap per flow, and every request records its index in its heap so
+   * that its priority can be raised in O(log n) when a duplicate request
+   * arrives. The flows of a class take turns in round-robin order, and each
+   * turn serves up to a quantum of requests.
+   *
+   * Since newer requests never sort before older requests of the same
+   * priority, enqueuing a request whose priority is not higher than the
+   * already queued ones is O(1).
+   */
+  class RequestQueue {
+   public:
+    bool empty() const noexcept {
+      return size_ == 0;
+    }
+
+    size_t size() const noexcept {
+      return size_;
+    }
+
+    void push(
+        std::shared_ptr<HgImportRequest> request,
+        std::chrono::nanoseconds agingInterval);
+
+    /**
+     * Raise the priority of a request that is currently in this queue.
+     */
+    void raisePriority(
+        HgImportRequest& request,
+        ImportPriority priority,
+        std::chrono::nanoseconds agingInterval);
+
+    struct Front {
+      HgImportRequest* request{nullptr};
+      /// Selected because it waited longer than the starvation threshold.
+      bool starving{false};
+      size_t level{0};
+      double score{0};
+    };
+
+    /**
+     * Return the request that pop() would return, or a null request if the
+     * queue is empty.
+     */
+    Front front(
+        std::chrono::steady_clock::time_point now,
+        std::chrono::nanoseconds starvationThreshold) const;
+
+    std::shared_ptr<HgImportRequest> pop(
+        std::chrono::steady_clock::time_point now,
+        std::chrono::nanoseconds starvationThreshold,
+        uint32_t quantum);
+
+    /**
+     * Whether a request of at least the given priority class is queued.
+     */
+    bool hasRequestAtLeast(ImportPriority::Class cls) const noexcept;
+
+    /**
+     * Remove all the requests from the queue, appending them to result.
+     */
+    void drainInto(std::vector<std::shared_ptr<HgImportRequest>>& result);
+
+    /**
+     * Calls fn with every queued request.
+     */
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+      for (const auto& level : levels_) {
+        for (const auto& [key, flow] : level.flows) {
+          for (const auto& entry : flow.heap) {
+            fn(*entry.request);
+          }
+        }
+      }
+    }
+
+   private:
+    struct Entry {
+      double score;
+      uint64_t unique;
+      std::shared_ptr<HgImportRequest> request;
+    };
+    using Heap = std::vector<Entry>;
+
+    struct Flow {
+      Heap heap;
+      /// How many more requests this flow may be served in its current turn.
+      uint32_t deficit{0};
+    };
+
+    struct Level {
+      folly::F14FastMap<uint64_t, Flow> flows;
+      /// The keys of the flows, the front one is the one being served.
+      std::deque<uint64_t> order;
+      size_t size{0};
+    };
+
+    /// ImportPriority::Class fits in a nibble.
+    static constexpr size_t kLevelCount = 16;
+
+    static size_t levelOf(ImportPriority priority) noexcept;
+    static double score(
+        const HgImportRequest& request,
+        std::chrono::nanoseconds agingInterval) noexcept;
+    static bool higher(const Entry& lhs, const Entry& rhs) noexcept;
+
+    static const Entry& head(const Level& level) noexcept;
+
+    void place(Heap& heap, size_t index, Entry entry) noexcept;
+    void siftUp(Heap& heap, size_t index) noexcept;
+    void siftDown(Heap& heap, size_t index) noexcept;
+    std::shared_ptr<HgImportRequest>
+    removeAt(size_t levelIndex, uint64_t flowKey, size_t index);
+
+    std::array<Level, kLevelCount> levels_;
+    size_t size_{0};
+  };
+
   struct State {
     bool running = true;
-    std::vector<std::shared_ptr<HgImportRequest>> treeQueue;
-    std::vector<std::shared_ptr<HgImportRequest>> blobQueue;
+    RequestQueue treeQueue;
+    RequestQueue blobQueue;
+    RequestQueue blobMetadataQueue;
+    HgImportBatchSizer treeBatchSizer;
+    HgImportBatchSizer blobBatchSizer;
+    HgImportBatchSizer blobMetadataBatchSizer;
 
     /**
      * Map of a ObjectId to an element in the queue. Any changes to this type
@@ -140,10 +352,22 @@ class HgImportRequestQueue {
      */
     folly::F14FastMap<ObjectId, std::shared_ptr<HgImportRequest>>
         requestTracker;
+
+    /**
+     * Same as requestTracker, for the blob metadata requests: they share
+     * their ObjectId with the import of the blob itself.
+     */
+    folly::F14FastMap<ObjectId, std::shared_ptr<HgImportRequest>>
+        metadataTracker;
   };
   std::shared_ptr<ReloadableConfig> config_;
-  folly::Synchronized<State, std::mutex> state_;
-  std::condition_variable queueCV_;
+  folly::Synchronized<
+      State,
+      InstrumentedMutex<std::mutex, kHgImportRequestQueueLockSite>>
+      state_;
+  // Waits with the instrumented lock of state_, which std::condition_variable
+  // doesn't support.
+  std::condition_variable_any queueCV_;
 };
 
 } // namespace facebook::eden
@@ -14,6 +14,8 @@
 #include <folly/Utility.h>
 #include <folly/container/Array.h>
 #include <folly/dynamic.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
 #include <folly/experimental/EnvUtil.h>
 #include <folly/futures/Future.h>
 #include <folly/io/Cursor.h>
@@ -245,6 +247,10 @@ ProcessStatus HgImporter::debugStopHelperProcess() {
   return helper_.wait();
 }
 
+bool HgImporter::isHelperRunning() {
+  return !helper_.terminated();
+}
+
 void HgImporter::stopHelperProcess() {
   if (!helper_.terminated()) {
     helperIn_.close();
@@ -588,13 +594,70 @@ const ImporterOptions& HgImporter::getOptions() const {
   return options_;
 }
 
+HgImporterSpares::HgImporterSpares(
+    AbsolutePathPiece repoPath,
+    std::shared_ptr<EdenStats> stats,
+    size_t count)
+    : repoPath_{repoPath},
+      stats_{std::move(stats)},
+      count_{count},
+      executor_{make_unique<folly::CPUThreadPoolExecutor>(
+          1,
+          std::make_shared<folly::NamedThreadFactory>("HgImporterSpare"))} {}
+
+HgImporterSpares::~HgImporterSpares() {
+  // Wait for the replacements being started before destroying the spares.
+  executor_.reset();
+}
+
+void HgImporterSpares::add(unique_ptr<HgImporter> importer) {
+  auto spares = spares_.wlock();
+  if (spares->size() < count_) {
+    spares->push_back(std::move(importer));
+  }
+}
+
+unique_ptr<HgImporter> HgImporterSpares::take() {
+  while (true) {
+    unique_ptr<HgImporter> importer;
+    {
+      auto spares = spares_.wlock();
+      if (spares->empty()) {
+        return nullptr;
+      }
+      importer = std::move(spares->back());
+      spares->pop_back();
+    }
+    startReplacement();
+    if (importer->isHelperRunning()) {
+      return importer;
+    }
+    XLOG(WARN) << "discarding a spare debugedenimporthelper that exited";
+  }
+}
+
+void HgImporterSpares::startReplacement() {
+  executor_->add([this] {
+    try {
+      add(make_unique<HgImporter>(repoPath_, stats_));
+    } catch (const std::exception& ex) {
+      // The next import that needs an importer starts one itself, and
+      // reports the error.
+      XLOG(WARN) << "failed to start a spare debugedenimporthelper: "
+                 << ex.what();
+    }
+  });
+}
+
 HgImporterManager::HgImporterManager(
     AbsolutePathPiece repoPath,
     std::shared_ptr<EdenStats> stats,
-    std::optional<AbsolutePath> importHelperScript)
+    std::optional<AbsolutePath> importHelperScript,
+    std::shared_ptr<HgImporterSpares> spares)
     : repoPath_{repoPath},
       stats_{std::move(stats)},
-      importHelperScript_{importHelperScript} {}
+      importHelperScript_{importHelperScript},
+      spares_{std::move(spares)} {}
 
 template <typename Fn>
 auto HgImporterManager::retryOnError(Fn&& fn) {
@@ -650,6 +713,14 @@ std::unique_ptr<IOBuf> HgImporterManager::fetchTree(
 }
 
 HgImporter* HgImporterManager::getImporter() {
+  if (importer_ && !importer_->isHelperRunning()) {
+    // Replace it now rather than failing the request and retrying it.
+    XLOG(WARN) << "debugedenimporthelper exited, restarting it";
+    importer_.reset();
+  }
+  if (!importer_ && spares_) {
+    importer_ = spares_->take();
+  }
   if (!importer_) {
     importer_ = make_unique<HgImporter>(repoPath_, stats_, importHelperScript_);
   }
@@ -8,9 +8,12 @@
 #pragma once
 
 #include <folly/Range.h>
+#include <folly/Synchronized.h>
 #include <folly/portability/GFlags.h>
 #include <folly/portability/IOVec.h>
+#include <memory>
 #include <optional>
+#include <vector>
 
 #include "eden/fs/eden-config.h"
 #include "eden/fs/telemetry/EdenStats.h"
@@ -21,6 +24,7 @@ DECLARE_string(hgPath);
 DECLARE_string(hgPythonPath);
 
 namespace folly {
+class Executor;
 class IOBuf;
 } // namespace folly
 
@@ -122,6 +126,13 @@ class HgImporter : public Importer {
 
   ProcessStatus debugStopHelperProcess();
 
+  /**
+   * Whether the helper process is still running, without communicating with
+   * it. A helper that exited, like after being killed while idle, fails the
+   * next request sent to it.
+   */
+  bool isHelperRunning();
+
   Hash20 resolveManifestNode(folly::StringPiece revName) override;
   std::unique_ptr<Blob> importFileContents(
       RelativePathPiece path,
@@ -282,6 +293,49 @@ class HgImporterError : public std::exception {
   std::string message_;
 };
 
+/**
+ * HgImporters started ahead of time, so that an HgImporterManager that needs
+ * a new one, for its first import or after its helper failed, doesn't wait
+ * for hg to start. Every importer handed out is replaced in the background.
+ *
+ * An HgImporter is only handed out before it is used, so it is still only
+ * used by one thread at a time.
+ */
+class HgImporterSpares {
+ public:
+  HgImporterSpares(
+      AbsolutePathPiece repoPath,
+      std::shared_ptr<EdenStats> stats,
+      size_t count);
+
+  ~HgImporterSpares();
+
+  HgImporterSpares(const HgImporterSpares&) = delete;
+  HgImporterSpares& operator=(const HgImporterSpares&) = delete;
+
+  /**
+   * Adds an importer that was already started, if fewer than count are
+   * kept.
+   */
+  void add(std::unique_ptr<HgImporter> importer);
+
+  /**
+   * Returns a started importer whose helper is still running and starts its
+   * replacement, or returns nullptr if there is none.
+   */
+  std::unique_ptr<HgImporter> take();
+
+ private:
+  void startReplacement();
+
+  const AbsolutePath repoPath_;
+  std::shared_ptr<EdenStats> const stats_;
+  const size_t count_;
+  folly::Synchronized<std::vector<std::unique_ptr<HgImporter>>> spares_;
+  // A single thread that starts the replacements.
+  std::unique_ptr<folly::Executor> executor_;
+};
+
 /**
  * A helper class that manages an HgImporter and recreates it after any error
  * communicating with hg debugedenimporthelper.
@@ -293,7 +347,8 @@ class HgImporterManager : public Importer {
   HgImporterManager(
       AbsolutePathPiece repoPath,
       std::shared_ptr<EdenStats>,
-      std::optional<AbsolutePath> importHelperScript = std::nullopt);
+      std::optional<AbsolutePath> importHelperScript = std::nullopt,
+      std::shared_ptr<HgImporterSpares> spares = nullptr);
 
   Hash20 resolveManifestNode(folly::StringPiece revName) override;
 
@@ -316,6 +371,7 @@ class HgImporterManager : public Importer {
   const AbsolutePath repoPath_;
   std::shared_ptr<EdenStats> const stats_;
   const std::optional<AbsolutePath> importHelperScript_;
+  std::shared_ptr<HgImporterSpares> const spares_;
 };
 
 } // namespace facebook::eden
@@ -14,6 +14,7 @@
 
 #include "eden/fs/store/LocalStore.h"
 #include "eden/fs/store/StoreResult.h"
+#include "eden/fs/store/hg/HgProxyHashCache.h"
 #include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/utils/Bug.h"
 #include "eden/fs/utils/Throw.h"
@@ -69,31 +70,48 @@ std::optional<HgProxyHash> HgProxyHash::tryParseEmbeddedProxyHash(
 folly::Future<std::vector<HgProxyHash>> HgProxyHash::getBatch(
     LocalStore* store,
     ObjectIdRange blobHashes,
-    EdenStats& edenStats) {
-  std::vector<HgProxyHash> embedded_results;
+    EdenStats& edenStats,
+    HgProxyHashCache* cache) {
+  // The results are in the order of blobHashes, the ones that are neither
+  // embedded nor cached being filled in once loaded.
+  std::vector<HgProxyHash> results(blobHashes.size());
+  std::vector<size_t> loadedIndices;
   std::vector<ByteRange> byteRanges;
-  for (const auto& hash : blobHashes) {
-    if (auto embedded = tryParseEmbeddedProxyHash(hash)) {
-      embedded_results.push_back(*embedded);
+  size_t cacheHits = 0;
+  for (size_t i = 0; i < blobHashes.size(); ++i) {
+    if (auto embedded = tryParseEmbeddedProxyHash(blobHashes[i])) {
+      results[i] = std::move(*embedded);
+    } else if (auto cached = cache ? cache->get(blobHashes[i]) : std::nullopt) {
+      results[i] = std::move(*cached);
+      ++cacheHits;
     } else {
-      byteRanges.push_back(hash.getBytes());
+      loadedIndices.push_back(i);
+      byteRanges.push_back(blobHashes[i].getBytes());
     }
   }
+  if (cacheHits > 0) {
+    edenStats.increment(
+        &HgBackingStoreStats::loadProxyHashFromMemory, cacheHits);
+  }
   if (byteRanges.empty()) {
-    return folly::Future<std::vector<HgProxyHash>>{std::move(embedded_results)};
+    return folly::Future<std::vector<HgProxyHash>>{std::move(results)};
   }
   edenStats.increment(&HgBackingStoreStats::loadProxyHash, byteRanges.size());
   return store->getBatch(KeySpace::HgProxyHashFamily, byteRanges)
-      .thenValue([embedded_results,
-                  byteRanges](std::vector<StoreResult>&& data) {
-        std::vector<HgProxyHash> results{embedded_results};
-
+      .thenValue([results = std::move(results),
+                  loadedIndices = std::move(loadedIndices),
+                  byteRanges,
+                  cache](std::vector<StoreResult>&& data) mutable {
         for (size_t i = 0; i < byteRanges.size(); ++i) {
-          results.emplace_back(HgProxyHash{
-              ObjectId{byteRanges.at(i)}, data[i], "prefetchFiles getBatch"});
+          ObjectId id{byteRanges.at(i)};
+          auto& result = results[loadedIndices[i]];
+          result = HgProxyHash{id, data[i], "prefetchFiles getBatch"};
+          if (cache) {
+            cache->insert(id, result);
+          }
         }
 
-        return results;
+        return std::move(results);
       });
 }
 
@@ -101,10 +119,17 @@ HgProxyHash HgProxyHash::load(
     LocalStore* store,
     const ObjectId& edenObjectId,
     StringPiece context,
-    EdenStats& edenStats) {
+    EdenStats& edenStats,
+    HgProxyHashCache* cache) {
   if (auto embedded = tryParseEmbeddedProxyHash(edenObjectId)) {
     return *embedded;
   }
+  if (cache) {
+    if (auto cached = cache->get(edenObjectId)) {
+      edenStats.increment(&HgBackingStoreStats::loadProxyHashFromMemory);
+      return std::move(*cached);
+    }
+  }
   edenStats.increment(&HgBackingStoreStats::loadProxyHash);
   // Read the path name and file rev hash
   auto infoResult = store->get(KeySpace::HgProxyHashFamily, edenObjectId);
@@ -114,7 +139,11 @@ HgProxyHash HgProxyHash::load(
     // Fall through and let infoResult.extractValue() throw
   }
 
-  return HgProxyHash{edenObjectId, infoResult.extractValue()};
+  HgProxyHash proxyHash{edenObjectId, infoResult.extractValue()};
+  if (cache) {
+    cache->insert(edenObjectId, proxyHash);
+  }
+  return proxyHash;
 }
 
 ObjectId HgProxyHash::store(
@@ -130,6 +159,32 @@ ObjectId HgProxyHash::store(
   EDEN_BUG() << "Unsupported hgObjectIdFormat: " << hgObjectIdFormat;
 }
 
+ObjectId HgProxyHash::store(
+    RelativePathPiece dir,
+    PathComponentPiece name,
+    const Hash20& hgRevHash,
+    HgObjectIdFormat hgObjectIdFormat) {
+  if (hgObjectIdFormat != HgObjectIdFormat::WithPath) {
+    return store(RelativePathPiece{}, hgRevHash, hgObjectIdFormat);
+  }
+
+  folly::StringPiece hashPiece{hgRevHash.getBytes()};
+  folly::StringPiece dirPiece{dir};
+  folly::StringPiece namePiece{name};
+
+  // Same layout as makeEmbeddedProxyHash1(hgRevHash, dir + name).
+  folly::fbstring str;
+  str.reserve(22 + dirPiece.size() + namePiece.size());
+  str.push_back(TYPE_HG_ID_WITH_PATH);
+  str.append(hashPiece.data(), hashPiece.size());
+  if (!dirPiece.empty()) {
+    str.append(dirPiece.data(), dirPiece.size());
+    str.push_back(kDirSeparator);
+  }
+  str.append(namePiece.data(), namePiece.size());
+  return ObjectId{std::move(str)};
+}
+
 ObjectId HgProxyHash::makeEmbeddedProxyHash1(
     const Hash20& hgRevHash,
     RelativePathPiece path) {
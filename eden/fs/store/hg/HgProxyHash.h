@@ -22,6 +22,7 @@ class Future;
 namespace facebook::eden {
 
 class EdenStats;
+class HgProxyHashCache;
 
 /**
  * HgProxyHash is a derived index allowing us to map EdenFS's fixed-size hashes
@@ -114,17 +115,24 @@ class HgProxyHash {
    * The caller is responsible for keeping the ObjectIdRange alive for the
    * duration of the future.
    */
-  static folly::Future<std::vector<HgProxyHash>>
-  getBatch(LocalStore* store, ObjectIdRange blobHashes, EdenStats& stats);
+  static folly::Future<std::vector<HgProxyHash>> getBatch(
+      LocalStore* store,
+      ObjectIdRange blobHashes,
+      EdenStats& stats,
+      HgProxyHashCache* cache = nullptr);
 
   /**
    * Load HgProxyHash data for the given eden blob hash from the LocalStore.
+   *
+   * When a cache is given, the proxy hashes that must be looked up in the
+   * LocalStore are first looked for in it, and added to it once loaded.
    */
   static HgProxyHash load(
       LocalStore* store,
       const ObjectId& edenObjectId,
       folly::StringPiece context,
-      EdenStats& stats);
+      EdenStats& stats,
+      HgProxyHashCache* cache = nullptr);
 
   /**
    * Encode an ObjectId from path, manifest ID, and format.
@@ -134,6 +142,16 @@ class HgProxyHash {
       const Hash20& hgRevHash,
       HgObjectIdFormat hgObjectIdFormat);
 
+  /**
+   * Encode the ObjectId of the entry name of the directory dir, without
+   * building the full path of the entry first.
+   */
+  static ObjectId store(
+      RelativePathPiece dir,
+      PathComponentPiece name,
+      const Hash20& hgRevHash,
+      HgObjectIdFormat hgObjectIdFormat);
+
   /**
    * Generate an ObjectId that contains both the hgRevHash and a path.
    */
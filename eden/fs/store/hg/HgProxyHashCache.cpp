@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/hg/HgProxyHashCache.h"
+
+#include <algorithm>
+
+namespace facebook::eden {
+
+namespace {
+constexpr size_t kShardCount = 16;
+}
+
+HgProxyHashCache::HgProxyHashCache(size_t maxEntries) {
+  auto entriesPerShard = std::max<size_t>(maxEntries / kShardCount, 1);
+  shards_.reserve(kShardCount);
+  for (size_t i = 0; i < kShardCount; ++i) {
+    shards_.push_back(std::make_unique<folly::Synchronized<Lru>>(
+        folly::in_place, entriesPerShard));
+  }
+}
+
+folly::Synchronized<HgProxyHashCache::Lru>& HgProxyHashCache::shardOf(
+    const ObjectId& id) {
+  return *shards_[std::hash<ObjectId>{}(id) % kShardCount];
+}
+
+std::optional<HgProxyHash> HgProxyHashCache::get(const ObjectId& id) {
+  auto shard = shardOf(id).wlock();
+  auto it = shard->find(id);
+  if (it == shard->end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+void HgProxyHashCache::insert(
+    const ObjectId& id,
+    const HgProxyHash& proxyHash) {
+  shardOf(id).wlock()->set(id, proxyHash);
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,50 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "eden/fs/model/ObjectId.h"
+#include "eden/fs/store/hg/HgProxyHash.h"
+
+namespace facebook::eden {
+
+/**
+ * A bounded in-memory LRU of the proxy hashes recently loaded from the
+ * HgProxyHashFamily key space, which legacy 20-byte object IDs must be
+ * looked up in. Object IDs embedding their proxy hash are decoded without a
+ * lookup and don't need to be cached.
+ *
+ * It is safe to use this object from arbitrary threads.
+ */
+class HgProxyHashCache {
+ public:
+  explicit HgProxyHashCache(size_t maxEntries);
+
+  HgProxyHashCache(const HgProxyHashCache&) = delete;
+  HgProxyHashCache& operator=(const HgProxyHashCache&) = delete;
+
+  std::optional<HgProxyHash> get(const ObjectId& id);
+
+  void insert(const ObjectId& id, const HgProxyHash& proxyHash);
+
+ private:
+  using Lru = folly::EvictingCacheMap<ObjectId, HgProxyHash>;
+
+  folly::Synchronized<Lru>& shardOf(const ObjectId& id);
+
+  // Lookups reorder the LRU list and thus need an exclusive lock, this
+  // avoids contending on a single one.
+  std::vector<std::unique_ptr<folly::Synchronized<Lru>>> shards_;
+};
+
+} // namespace facebook::eden
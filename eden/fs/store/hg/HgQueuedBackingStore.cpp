@@ -19,14 +19,17 @@
 #include <folly/futures/Future.h>
 #include <folly/logging/xlog.h>
 #include <folly/portability/GFlags.h>
+#include <folly/stop_watch.h>
 #include <folly/system/ThreadName.h>
 
 #include "eden/fs/config/ReloadableConfig.h"
 #include "eden/fs/model/Blob.h"
+#include "eden/fs/model/Tree.h"
 #include "eden/fs/service/ThriftUtil.h"
 #include "eden/fs/store/BackingStoreLogger.h"
 #include "eden/fs/store/LocalStore.h"
 #include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/store/TreeMetadata.h"
 #include "eden/fs/store/hg/HgBackingStore.h"
 #include "eden/fs/store/hg/HgImportRequest.h"
 #include "eden/fs/store/hg/HgProxyHash.h"
@@ -36,6 +39,7 @@
 #include "eden/fs/utils/Bug.h"
 #include "eden/fs/utils/EnumValue.h"
 #include "eden/fs/utils/IDGen.h"
+#include "eden/fs/utils/NumaTopology.h"
 #include "eden/fs/utils/PathFuncs.h"
 #include "eden/fs/utils/StaticAssert.h"
 #include "eden/fs/utils/Throw.h"
@@ -45,21 +49,33 @@ namespace facebook::eden {
 namespace {
 // 100,000 hg object fetches in a short term is plausible.
 constexpr size_t kTraceBusCapacity = 100000;
-static_assert(CheckSize<HgImportTraceEvent, 64>());
-// TraceBus is double-buffered, so the following capacity should be doubled.
+static_assert(CheckSize<HgImportTraceEvent, 72>());
+// TraceBus rounds the capacity up to a power of two and adds a sequence number
+// to every slot, so the following capacity should be increased by about 40%.
 // 10 MB overhead per backing repo is tolerable.
 static_assert(
-    CheckEqual<6400000, kTraceBusCapacity * sizeof(HgImportTraceEvent)>());
+    CheckEqual<7200000, kTraceBusCapacity * sizeof(HgImportTraceEvent)>());
+
+folly::exception_wrapper makeDegradedBackendError(const HgProxyHash& hash) {
+  return folly::make_exception_wrapper<std::system_error>(
+      EAGAIN,
+      std::generic_category(),
+      fmt::format(
+          "not fetching {} from the backing store, which is degraded",
+          hash.path()));
+}
 } // namespace
 
 HgImportTraceEvent::HgImportTraceEvent(
     uint64_t unique,
+    uint64_t traceId,
     EventType eventType,
     ResourceType resourceType,
     const HgProxyHash& proxyHash,
     ImportPriority::Class priority,
     ObjectFetchContext::Cause cause)
     : unique{unique},
+      traceId{traceId},
       manifestNodeId{proxyHash.revHash()},
       eventType{eventType},
       resourceType{resourceType},
@@ -81,6 +97,8 @@ HgQueuedBackingStore::HgQueuedBackingStore(
     : localStore_(std::move(localStore)),
       stats_(std::move(stats)),
       config_(config),
+      proxyHashCache_{
+          config_->getEdenConfig()->hgProxyHashCacheEntries.getValue()},
       backingStore_(std::move(backingStore)),
       queue_(std::move(config)),
       structuredLogger_{std::move(structuredLogger)},
@@ -94,9 +112,19 @@ HgQueuedBackingStore::HgQueuedBackingStore(
         << "HgQueuedBackingStore configured to use 0 threads. Invalid, using one thread instead";
     numberThreads = 1;
   }
+  if (config_->getEdenConfig()->enableActivityBuffer.getValue()) {
+    importTimelines_.emplace(
+        config_->getEdenConfig()->ActivityBufferMaxEvents.getValue());
+  }
+  bool pinThreads = config_->getEdenConfig()->numaPinThreads.getValue();
   threads_.reserve(numberThreads);
   for (uint16_t i = 0; i < numberThreads; i++) {
-    threads_.emplace_back(&HgQueuedBackingStore::processRequest, this);
+    threads_.emplace_back([this, i, pinThreads] {
+      if (pinThreads) {
+        NumaTopology::get().pinCurrentThread(i);
+      }
+      processRequest();
+    });
   }
   subscribeActivityBuffer();
 }
@@ -137,14 +165,18 @@ void HgQueuedBackingStore::subscribeActivityBuffer() {
 void HgQueuedBackingStore::processBlobImportRequests(
     std::vector<std::shared_ptr<HgImportRequest>>&& requests) {
   folly::stop_watch<std::chrono::milliseconds> watch;
+  auto batchSize = requests.size();
 
-  XLOG(DBG4) << "Processing blob import batch size=" << requests.size();
+  XLOG(DBG4) << "Processing blob import batch size=" << batchSize;
 
+  auto batchStart = std::chrono::steady_clock::now();
   for (auto& request : requests) {
     auto* blobImport = request->getRequest<HgImportRequest::BlobImport>();
 
+    request->setBatchStartTime(batchStart);
     traceBus_->publish(HgImportTraceEvent::start(
         request->getUnique(),
+        request->getTraceId(),
         HgImportTraceEvent::BLOB,
         blobImport->proxyHash,
         request->getPriority().getClass(),
@@ -155,12 +187,16 @@ void HgQueuedBackingStore::processBlobImportRequests(
 
   backingStore_->getDatapackStore().getBlobBatch(requests);
 
+  // Whether any of the objects could not be fetched. Only written by the
+  // futures below, which complete before the batch does.
+  bool failed = false;
   {
     std::vector<folly::SemiFuture<folly::Unit>> futures;
     futures.reserve(requests.size());
 
     for (auto& request : requests) {
-      auto* promise = request->getPromise<std::unique_ptr<Blob>>();
+      auto* promise =
+          request->getPromise<HgImportRequest::BlobImport::Response>();
       if (promise->isFulfilled()) {
         stats_->addDuration(&HgBackingStoreStats::getBlob, watch.elapsed());
         continue;
@@ -169,12 +205,16 @@ void HgQueuedBackingStore::processBlobImportRequests(
       // The blobs were either not found locally, or, when EdenAPI is enabled,
       // not found on the server. Let's import the blob through the hg importer.
       // TODO(xavierd): remove when EdenAPI has been rolled out everywhere.
+      request->setImporterStartTime(std::chrono::steady_clock::now());
       auto fetchSemiFuture = backingStore_->fetchBlobFromHgImporter(
           request->getRequest<HgImportRequest::BlobImport>()->proxyHash);
       futures.emplace_back(
           std::move(fetchSemiFuture)
-              .defer([request = std::move(request), watch, stats = stats_](
-                         auto&& result) mutable {
+              .defer([request = std::move(request),
+                      watch,
+                      stats = stats_,
+                      &failed](auto&& result) mutable {
+                failed |= result.hasException();
                 XLOG(DBG4)
                     << "Imported blob from HgImporter for "
                     << request->getRequest<HgImportRequest::BlobImport>()->hash;
@@ -187,17 +227,28 @@ void HgQueuedBackingStore::processBlobImportRequests(
 
     folly::collectAll(futures).wait();
   }
+
+  health_.recordFetch(
+      !failed,
+      watch.elapsed(),
+      getHealthOptions(),
+      std::chrono::steady_clock::now());
+  queue_.recordBlobBatch(batchSize, watch.elapsed());
 }
 
 void HgQueuedBackingStore::processTreeImportRequests(
     std::vector<std::shared_ptr<HgImportRequest>>&& requests) {
   folly::stop_watch<std::chrono::milliseconds> watch;
+  auto batchSize = requests.size();
 
+  auto batchStart = std::chrono::steady_clock::now();
   for (auto& request : requests) {
     auto* treeImport = request->getRequest<HgImportRequest::TreeImport>();
 
+    request->setBatchStartTime(batchStart);
     traceBus_->publish(HgImportTraceEvent::start(
         request->getUnique(),
+        request->getTraceId(),
         HgImportTraceEvent::TREE,
         treeImport->proxyHash,
         request->getPriority().getClass(),
@@ -208,12 +259,16 @@ void HgQueuedBackingStore::processTreeImportRequests(
 
   backingStore_->getDatapackStore().getTreeBatch(requests);
 
+  // Whether any of the objects could not be fetched. Only written by the
+  // futures below, which complete before the batch does.
+  bool failed = false;
   {
     std::vector<folly::SemiFuture<folly::Unit>> futures;
     futures.reserve(requests.size());
 
     for (auto& request : requests) {
-      auto* promise = request->getPromise<std::unique_ptr<Tree>>();
+      auto* promise =
+          request->getPromise<HgImportRequest::TreeImport::Response>();
       if (promise->isFulfilled()) {
         stats_->addDuration(&HgBackingStoreStats::getTree, watch.elapsed());
         continue;
@@ -223,11 +278,15 @@ void HgQueuedBackingStore::processTreeImportRequests(
       // not found on the server. Let's import the trees through the hg
       // importer.
       // TODO(xavierd): remove when EdenAPI has been rolled out everywhere.
+      request->setImporterStartTime(std::chrono::steady_clock::now());
       auto treeSemiFuture = backingStore_->getTree(request);
       futures.emplace_back(
           std::move(treeSemiFuture)
-              .defer([request = std::move(request), watch, stats = stats_](
-                         auto&& result) mutable {
+              .defer([request = std::move(request),
+                      watch,
+                      stats = stats_,
+                      &failed](auto&& result) mutable {
+                failed |= result.hasException();
                 XLOG(DBG4)
                     << "Imported tree from HgImporter for "
                     << request->getRequest<HgImportRequest::TreeImport>()->hash;
@@ -240,6 +299,70 @@ void HgQueuedBackingStore::processTreeImportRequests(
 
     folly::collectAll(futures).wait();
   }
+
+  health_.recordFetch(
+      !failed,
+      watch.elapsed(),
+      getHealthOptions(),
+      std::chrono::steady_clock::now());
+  queue_.recordTreeBatch(batchSize, watch.elapsed());
+}
+
+void HgQueuedBackingStore::processBlobMetadataImportRequests(
+    std::vector<std::shared_ptr<HgImportRequest>>&& requests) {
+  folly::stop_watch<std::chrono::milliseconds> watch;
+  auto batchSize = requests.size();
+
+  XLOG(DBG4) << "Processing blob metadata import batch size=" << batchSize;
+
+  backingStore_->getDatapackStore().getBlobMetadataBatch(requests);
+
+  // Unlike blobs and trees, there is no fallback to the hg importer: the
+  // metadata will be computed from the blob when it is fetched.
+  bool failed = false;
+  for (auto& request : requests) {
+    auto* promise =
+        request->getPromise<HgImportRequest::BlobMetadataImport::Response>();
+    if (!promise->isFulfilled()) {
+      failed = true;
+      promise->setException(std::runtime_error(fmt::format(
+          "no metadata found for {}",
+          request->getRequest<HgImportRequest::BlobMetadataImport>()->hash)));
+    }
+  }
+
+  health_.recordFetch(
+      !failed,
+      watch.elapsed(),
+      getHealthOptions(),
+      std::chrono::steady_clock::now());
+  queue_.recordBlobMetadataBatch(batchSize, watch.elapsed());
+}
+
+BackendHealthTracker::Options HgQueuedBackingStore::getHealthOptions() const {
+  if (!config_) {
+    return BackendHealthTracker::Options{};
+  }
+  auto config = config_->getEdenConfig();
+  return BackendHealthTracker::Options{
+      config->degradedBackendFailureThreshold.getValue(),
+      std::chrono::duration_cast<BackendHealthTracker::Clock::duration>(
+          config->degradedBackendSlowFetch.getValue()),
+      std::chrono::duration_cast<BackendHealthTracker::Clock::duration>(
+          config->degradedBackendCooldown.getValue())};
+}
+
+std::optional<ImportPriority> HgQueuedBackingStore::getRemoteFetchPriority(
+    const ObjectFetchContext& context) {
+  if (health_.allowRemoteFetch(
+          getHealthOptions(), std::chrono::steady_clock::now())) {
+    return context.getPriority();
+  }
+  if (config_->getEdenConfig()->degradedBackendFailFast.getValue()) {
+    stats_->increment(&HgBackingStoreStats::degradedBackendFailure);
+    return std::nullopt;
+  }
+  return ImportPriority{ImportPriority::Class::Low};
 }
 
 void HgQueuedBackingStore::processRequest() {
@@ -257,6 +380,8 @@ void HgQueuedBackingStore::processRequest() {
       processBlobImportRequests(std::move(requests));
     } else if (first->isType<HgImportRequest::TreeImport>()) {
       processTreeImportRequests(std::move(requests));
+    } else if (first->isType<HgImportRequest::BlobMetadataImport>()) {
+      processBlobMetadataImportRequests(std::move(requests));
     }
   }
 }
@@ -277,9 +402,17 @@ ObjectComparison HgQueuedBackingStore::compareObjectsById(
 
   // Now parse the object IDs and read their rev hashes.
   auto oneProxy = HgProxyHash::load(
-      localStore_.get(), one, "areObjectIdsEquivalent", *stats_);
+      localStore_.get(),
+      one,
+      "areObjectIdsEquivalent",
+      *stats_,
+      &proxyHashCache_);
   auto twoProxy = HgProxyHash::load(
-      localStore_.get(), two, "areObjectIdsEquivalent", *stats_);
+      localStore_.get(),
+      two,
+      "areObjectIdsEquivalent",
+      *stats_,
+      &proxyHashCache_);
 
   // If the rev hashes are the same, we know the contents are the same.
   if (oneProxy.revHash() == twoProxy.revHash()) {
@@ -357,9 +490,11 @@ std::string HgQueuedBackingStore::staticRenderObjectId(
 folly::SemiFuture<BackingStore::GetTreeResult> HgQueuedBackingStore::getTree(
     const ObjectId& id,
     const ObjectFetchContextPtr& context) {
+  auto fetchStart = std::chrono::steady_clock::now();
   HgProxyHash proxyHash;
   try {
-    proxyHash = HgProxyHash::load(localStore_.get(), id, "getTree", *stats_);
+    proxyHash = HgProxyHash::load(
+        localStore_.get(), id, "getTree", *stats_, &proxyHashCache_);
   } catch (const std::exception&) {
     logMissingProxyHash();
     throw;
@@ -370,15 +505,18 @@ folly::SemiFuture<BackingStore::GetTreeResult> HgQueuedBackingStore::getTree(
       folly::Range{&proxyHash, 1},
       ObjectFetchContext::ObjectType::Tree);
 
-  if (auto tree =
-          backingStore_->getDatapackStore().getTreeLocal(id, proxyHash)) {
-    XLOG(DBG5) << "imported tree of '" << proxyHash.path() << "', "
-               << proxyHash.revHash().toString() << " from hgcache";
-    return folly::makeSemiFuture(GetTreeResult{
-        std::move(tree), ObjectFetchContext::Origin::FromDiskCache});
+  {
+    RequestPhaseScope datapackScope{context, RequestPhase::Datapack};
+    if (auto tree =
+            backingStore_->getDatapackStore().getTreeLocal(id, proxyHash)) {
+      XLOG(DBG5) << "imported tree of '" << proxyHash.path() << "', "
+                 << proxyHash.revHash().toString() << " from hgcache";
+      return folly::makeSemiFuture(GetTreeResult{
+          std::move(tree), ObjectFetchContext::Origin::FromDiskCache});
+    }
   }
 
-  return getTreeImpl(id, proxyHash, context);
+  return getTreeImpl(id, proxyHash, context, fetchStart);
 }
 
 std::unique_ptr<BlobMetadata> HgQueuedBackingStore::getLocalBlobMetadata(
@@ -389,7 +527,11 @@ std::unique_ptr<BlobMetadata> HgQueuedBackingStore::getLocalBlobMetadata(
   HgProxyHash proxyHash;
   try {
     proxyHash = HgProxyHash::load(
-        localStore_.get(), id, "getLocalBlobMetadata", *stats_);
+        localStore_.get(),
+        id,
+        "getLocalBlobMetadata",
+        *stats_,
+        &proxyHashCache_);
   } catch (const std::exception&) {
     logMissingProxyHash();
     throw;
@@ -407,51 +549,148 @@ folly::SemiFuture<BackingStore::GetTreeResult>
 HgQueuedBackingStore::getTreeImpl(
     const ObjectId& id,
     const HgProxyHash& proxyHash,
-    const ObjectFetchContextPtr& context) {
+    const ObjectFetchContextPtr& context,
+    std::chrono::steady_clock::time_point fetchStart) {
+  auto priority = getRemoteFetchPriority(*context);
+  if (!priority) {
+    return folly::makeSemiFuture<GetTreeResult>(
+        makeDegradedBackendError(proxyHash));
+  }
+
   auto getTreeFuture = folly::makeFutureWith([&] {
     auto request = HgImportRequest::makeTreeImportRequest(
-        id, proxyHash, context->getPriority(), context->getCause());
+        id,
+        proxyHash,
+        *priority,
+        context->getCause(),
+        context->getTraceId());
+    request->addCancellationToken(context->getCancellationToken());
+    request->setClientPid(context->getClientPid());
     uint64_t unique = request->getUnique();
 
     auto importTracker =
         std::make_unique<RequestMetricsScope>(&pendingImportTreeWatches_);
     traceBus_->publish(HgImportTraceEvent::queue(
         unique,
+        context->getTraceId(),
         HgImportTraceEvent::TREE,
         proxyHash,
-        context->getPriority().getClass(),
+        priority->getClass(),
         context->getCause()));
 
-    return queue_.enqueueTree(std::move(request))
+    RequestPhaseScope phaseScope{context, RequestPhase::HgImportQueue};
+    return queue_.enqueueTree(request)
         .ensure([this,
-                 unique,
+                 request,
+                 fetchStart,
                  proxyHash,
+                 priorityClass = priority->getClass(),
                  context = context.copy(),
-                 importTracker = std::move(importTracker)]() {
+                 importTracker = std::move(importTracker),
+                 phaseScope = std::move(phaseScope)]() {
           traceBus_->publish(HgImportTraceEvent::finish(
-              unique,
+              request->getUnique(),
+              context->getTraceId(),
               HgImportTraceEvent::TREE,
               proxyHash,
-              context->getPriority().getClass(),
+              priorityClass,
               context->getCause()));
+          recordImportTimeline(
+              *request, HgImportTraceEvent::TREE, proxyHash, fetchStart);
         });
   });
 
   return std::move(getTreeFuture)
-      .thenTry([this, id](folly::Try<std::unique_ptr<Tree>>&& result) {
+      .thenTry([this, id, clientPid = context->getClientPid()](
+                   folly::Try<TreePtr>&& result) {
         this->queue_.markImportAsFinished<Tree>(id, result);
         auto tree = std::move(result).value();
+        auto config = config_->getEdenConfig();
+        if (config->persistTreeAuxMetadata.getValue()) {
+          persistTreeAuxMetadata(*tree);
+        }
+        if (config->prefetchAuxMetadata.getValue()) {
+          prefetchBlobAuxMetadata(*tree, clientPid);
+        }
         return GetTreeResult{
             std::move(tree), ObjectFetchContext::Origin::FromNetworkFetch};
       });
 }
 
+void HgQueuedBackingStore::persistTreeAuxMetadata(const Tree& tree) {
+  TreeMetadata::HashIndexedEntryMetadata entries;
+  for (const auto& [name, entry] : tree) {
+    const auto& size = entry.getSize();
+    const auto& contentSha1 = entry.getContentSha1();
+    if (entry.isTree() || !size || !contentSha1) {
+      continue;
+    }
+    entries.emplace_back(entry.getHash(), BlobMetadata{*contentSha1, *size});
+  }
+
+  try {
+    localStore_->putTreeMetadata(TreeMetadata{std::move(entries)});
+  } catch (const std::exception& ex) {
+    // The metadata will be fetched again when needed.
+    XLOG(WARN) << "failed to persist the file metadata of tree "
+               << tree.getHash() << ": " << ex.what();
+  }
+}
+
+void HgQueuedBackingStore::prefetchBlobAuxMetadata(
+    const Tree& tree,
+    std::optional<pid_t> clientPid) {
+  // Don't add to the load of a backend that already can't keep up.
+  if (health_.getState() != BackendHealthTracker::State::Healthy) {
+    return;
+  }
+
+  for (const auto& [name, entry] : tree) {
+    if (entry.isTree() || (entry.getSize() && entry.getContentSha1())) {
+      continue;
+    }
+    // Blobs whose proxy hash lives in the LocalStore would need a read per
+    // file to be queued, which defeats the purpose.
+    const auto& id = entry.getHash();
+    auto proxyHash = HgProxyHash::tryParseEmbeddedProxyHash(id);
+    if (!proxyHash) {
+      continue;
+    }
+
+    auto request = HgImportRequest::makeBlobMetadataImportRequest(
+        id,
+        std::move(*proxyHash),
+        ImportPriority{ImportPriority::Class::Low},
+        ObjectFetchContext::Cause::Prefetch);
+    request->setClientPid(clientPid);
+    // Requests for the same blob are deduplicated by the queue, and only the
+    // first one persists the result.
+    queue_.enqueueBlobMetadata(std::move(request))
+        .thenTry([this, id](folly::Try<BlobMetadataPtr>&& result) {
+          queue_.markImportAsFinished<BlobMetadata>(id, result);
+          if (result.hasException()) {
+            XLOG(DBG4) << "failed to prefetch the metadata of " << id << ": "
+                       << result.exception().what();
+            return;
+          }
+          try {
+            localStore_->putBlobMetadata(id, *result.value());
+          } catch (const std::exception& ex) {
+            XLOG(WARN) << "failed to persist the metadata of " << id << ": "
+                       << ex.what();
+          }
+        });
+  }
+}
+
 folly::SemiFuture<BackingStore::GetBlobResult> HgQueuedBackingStore::getBlob(
     const ObjectId& id,
     const ObjectFetchContextPtr& context) {
+  auto fetchStart = std::chrono::steady_clock::now();
   HgProxyHash proxyHash;
   try {
-    proxyHash = HgProxyHash::load(localStore_.get(), id, "getBlob", *stats_);
+    proxyHash = HgProxyHash::load(
+        localStore_.get(), id, "getBlob", *stats_, &proxyHashCache_);
   } catch (const std::exception&) {
     logMissingProxyHash();
     throw;
@@ -462,54 +701,78 @@ folly::SemiFuture<BackingStore::GetBlobResult> HgQueuedBackingStore::getBlob(
       folly::Range{&proxyHash, 1},
       ObjectFetchContext::ObjectType::Blob);
 
-  if (auto blob =
-          backingStore_->getDatapackStore().getBlobLocal(id, proxyHash)) {
-    return folly::makeSemiFuture(GetBlobResult{
-        std::move(blob), ObjectFetchContext::Origin::FromDiskCache});
+  {
+    RequestPhaseScope datapackScope{context, RequestPhase::Datapack};
+    if (auto blob =
+            backingStore_->getDatapackStore().getBlobLocal(id, proxyHash)) {
+      return folly::makeSemiFuture(GetBlobResult{
+          std::move(blob), ObjectFetchContext::Origin::FromDiskCache});
+    }
   }
 
-  return getBlobImpl(id, proxyHash, context);
+  return getBlobImpl(id, proxyHash, context, fetchStart);
 }
 
 folly::SemiFuture<BackingStore::GetBlobResult>
 HgQueuedBackingStore::getBlobImpl(
     const ObjectId& id,
     const HgProxyHash& proxyHash,
-    const ObjectFetchContextPtr& context) {
+    const ObjectFetchContextPtr& context,
+    std::chrono::steady_clock::time_point fetchStart) {
+  auto priority = getRemoteFetchPriority(*context);
+  if (!priority) {
+    return folly::makeSemiFuture<GetBlobResult>(
+        makeDegradedBackendError(proxyHash));
+  }
+
   auto getBlobFuture = folly::makeFutureWith([&] {
     XLOG(DBG4) << "make blob import request for " << proxyHash.path()
                << ", hash is:" << id;
 
     auto request = HgImportRequest::makeBlobImportRequest(
-        id, proxyHash, context->getPriority(), context->getCause());
+        id,
+        proxyHash,
+        *priority,
+        context->getCause(),
+        context->getTraceId());
+    request->addCancellationToken(context->getCancellationToken());
+    request->setClientPid(context->getClientPid());
     auto unique = request->getUnique();
 
     auto importTracker =
         std::make_unique<RequestMetricsScope>(&pendingImportBlobWatches_);
     traceBus_->publish(HgImportTraceEvent::queue(
         unique,
+        context->getTraceId(),
         HgImportTraceEvent::BLOB,
         proxyHash,
-        context->getPriority().getClass(),
+        priority->getClass(),
         context->getCause()));
 
-    return queue_.enqueueBlob(std::move(request))
+    RequestPhaseScope phaseScope{context, RequestPhase::HgImportQueue};
+    return queue_.enqueueBlob(request)
         .ensure([this,
-                 unique,
+                 request,
+                 fetchStart,
                  proxyHash,
+                 priorityClass = priority->getClass(),
                  context = context.copy(),
-                 importTracker = std::move(importTracker)]() {
+                 importTracker = std::move(importTracker),
+                 phaseScope = std::move(phaseScope)]() {
           traceBus_->publish(HgImportTraceEvent::finish(
-              unique,
+              request->getUnique(),
+              context->getTraceId(),
               HgImportTraceEvent::BLOB,
               proxyHash,
-              context->getPriority().getClass(),
+              priorityClass,
               context->getCause()));
+          recordImportTimeline(
+              *request, HgImportTraceEvent::BLOB, proxyHash, fetchStart);
         });
   });
 
   return std::move(getBlobFuture)
-      .thenTry([this, id](folly::Try<std::unique_ptr<Blob>>&& result) {
+      .thenTry([this, id](folly::Try<BlobPtr>&& result) {
         this->queue_.markImportAsFinished<Blob>(id, result);
         auto blob = std::move(result).value();
         return GetBlobResult{
@@ -517,16 +780,68 @@ HgQueuedBackingStore::getBlobImpl(
       });
 }
 
+void HgQueuedBackingStore::recordImportTimeline(
+    const HgImportRequest& request,
+    HgImportTraceEvent::ResourceType resourceType,
+    const HgProxyHash& proxyHash,
+    std::chrono::steady_clock::time_point fetchStart) {
+  if (!importTimelines_.has_value()) {
+    return;
+  }
+
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+  auto now = std::chrono::steady_clock::now();
+  auto queued = request.getRequestTime();
+  auto batchStart = request.getBatchStartTime();
+  auto importerStart = request.getImporterStartTime();
+  std::chrono::steady_clock::time_point unset;
+
+  HgImportTimeline timeline;
+  timeline.unique = request.getUnique();
+  timeline.traceId = request.getTraceId();
+  timeline.resourceType = resourceType;
+  timeline.importCause = request.getCause();
+  timeline.path = proxyHash.path().asString();
+  timeline.manifestNodeId = proxyHash.revHash();
+  timeline.startTime = std::chrono::system_clock::now() -
+      duration_cast<std::chrono::system_clock::duration>(now - fetchStart);
+  timeline.lookupDuration = duration_cast<microseconds>(queued - fetchStart);
+  if (batchStart == unset) {
+    timeline.deduplicated = true;
+    timeline.queueDuration = duration_cast<microseconds>(now - queued);
+  } else {
+    timeline.queueDuration = duration_cast<microseconds>(batchStart - queued);
+    if (importerStart == unset) {
+      timeline.batchDuration = duration_cast<microseconds>(now - batchStart);
+    } else {
+      timeline.batchDuration =
+          duration_cast<microseconds>(importerStart - batchStart);
+      timeline.importerDuration =
+          duration_cast<microseconds>(now - importerStart);
+    }
+  }
+  importTimelines_->addEvent(std::move(timeline));
+}
+
 ImmediateFuture<std::unique_ptr<Tree>> HgQueuedBackingStore::getRootTree(
     const RootId& rootId,
     const ObjectFetchContextPtr& /*context*/) {
   return backingStore_->getRootTree(rootId);
 }
 
+ImmediateFuture<std::vector<std::unique_ptr<Tree>>>
+HgQueuedBackingStore::getRootTrees(
+    const std::vector<RootId>& rootIds,
+    const ObjectFetchContextPtr& /*context*/) {
+  return backingStore_->getRootTrees(rootIds);
+}
+
 folly::SemiFuture<folly::Unit> HgQueuedBackingStore::prefetchBlobs(
     ObjectIdRange ids,
     const ObjectFetchContextPtr& context) {
-  return HgProxyHash::getBatch(localStore_.get(), ids, *stats_)
+  return HgProxyHash::getBatch(
+             localStore_.get(), ids, *stats_, &proxyHashCache_)
       // The caller guarantees that ids will live at least longer than this
       // future, thus we don't need to deep-copy it.
       .thenTry([context = context.copy(), this, ids](
@@ -553,7 +868,8 @@ folly::SemiFuture<folly::Unit> HgQueuedBackingStore::prefetchBlobs(
           const auto& id = ids[i];
           const auto& proxyHash = proxyHashes[i];
 
-          futures.emplace_back(getBlobImpl(id, proxyHash, context));
+          futures.emplace_back(getBlobImpl(
+              id, proxyHash, context, std::chrono::steady_clock::now()));
         }
 
         return folly::collectAll(futures).deferValue([](const auto& tries) {
@@ -621,8 +937,7 @@ size_t HgQueuedBackingStore::getImportMetric(
       metric, getImportWatches(stage, object));
 }
 
-RequestMetricsScope::LockedRequestWatchList&
-HgQueuedBackingStore::getImportWatches(
+RequestMetricsScope::RequestWatchList& HgQueuedBackingStore::getImportWatches(
     RequestMetricsScope::RequestStage stage,
     HgBackingStore::HgImportObject object) const {
   switch (stage) {
@@ -634,7 +949,7 @@ HgQueuedBackingStore::getImportWatches(
   EDEN_BUG() << "unknown hg import stage " << enumValue(stage);
 }
 
-RequestMetricsScope::LockedRequestWatchList&
+RequestMetricsScope::RequestWatchList&
 HgQueuedBackingStore::getPendingImportWatches(
     HgBackingStore::HgImportObject object) const {
   switch (object) {
@@ -681,7 +996,7 @@ void HgQueuedBackingStore::periodicManagementTask() {
 
 namespace {
 void dropBlobImportRequest(std::shared_ptr<HgImportRequest>& request) {
-  auto* promise = request->getPromise<std::unique_ptr<Blob>>();
+  auto* promise = request->getPromise<HgImportRequest::BlobImport::Response>();
   if (promise != nullptr) {
     if (!promise->isFulfilled()) {
       promise->setException(std::runtime_error("Request forcibly dropped"));
@@ -690,7 +1005,17 @@ void dropBlobImportRequest(std::shared_ptr<HgImportRequest>& request) {
 }
 
 void dropTreeImportRequest(std::shared_ptr<HgImportRequest>& request) {
-  auto* promise = request->getPromise<std::unique_ptr<Tree>>();
+  auto* promise = request->getPromise<HgImportRequest::TreeImport::Response>();
+  if (promise != nullptr) {
+    if (!promise->isFulfilled()) {
+      promise->setException(std::runtime_error("Request forcibly dropped"));
+    }
+  }
+}
+
+void dropBlobMetadataImportRequest(std::shared_ptr<HgImportRequest>& request) {
+  auto* promise =
+      request->getPromise<HgImportRequest::BlobMetadataImport::Response>();
   if (promise != nullptr) {
     if (!promise->isFulfilled()) {
       promise->setException(std::runtime_error("Request forcibly dropped"));
@@ -708,6 +1033,9 @@ int64_t HgQueuedBackingStore::dropAllPendingRequestsFromQueue() {
     } else if (request->isType<HgImportRequest::TreeImport>()) {
       XLOG(DBG7, "Dropping tree request");
       dropTreeImportRequest(request);
+    } else if (request->isType<HgImportRequest::BlobMetadataImport>()) {
+      XLOG(DBG7, "Dropping blob metadata request");
+      dropBlobMetadataImportRequest(request);
     }
   }
   return requestVec.size();
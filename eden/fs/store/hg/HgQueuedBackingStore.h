@@ -11,15 +11,20 @@
 #include <folly/Synchronized.h>
 #include <sys/types.h>
 #include <atomic>
+#include <chrono>
 #include <memory>
+#include <optional>
+#include <string>
 #include <vector>
 
 #include "eden/fs/model/Hash.h"
+#include "eden/fs/store/BackendHealthTracker.h"
 #include "eden/fs/store/BackingStore.h"
 #include "eden/fs/store/ImportPriority.h"
 #include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/store/hg/HgBackingStore.h"
 #include "eden/fs/store/hg/HgImportRequestQueue.h"
+#include "eden/fs/store/hg/HgProxyHashCache.h"
 #include "eden/fs/telemetry/ActivityBuffer.h"
 #include "eden/fs/telemetry/RequestMetricsScope.h"
 #include "eden/fs/telemetry/TraceBus.h"
@@ -48,36 +53,40 @@ struct HgImportTraceEvent : TraceEventBase {
 
   static HgImportTraceEvent queue(
       uint64_t unique,
+      uint64_t traceId,
       ResourceType resourceType,
       const HgProxyHash& proxyHash,
       ImportPriority::Class priority,
       ObjectFetchContext::Cause cause) {
     return HgImportTraceEvent{
-        unique, QUEUE, resourceType, proxyHash, priority, cause};
+        unique, traceId, QUEUE, resourceType, proxyHash, priority, cause};
   }
 
   static HgImportTraceEvent start(
       uint64_t unique,
+      uint64_t traceId,
       ResourceType resourceType,
       const HgProxyHash& proxyHash,
       ImportPriority::Class priority,
       ObjectFetchContext::Cause cause) {
     return HgImportTraceEvent{
-        unique, START, resourceType, proxyHash, priority, cause};
+        unique, traceId, START, resourceType, proxyHash, priority, cause};
   }
 
   static HgImportTraceEvent finish(
       uint64_t unique,
+      uint64_t traceId,
       ResourceType resourceType,
       const HgProxyHash& proxyHash,
       ImportPriority::Class priority,
       ObjectFetchContext::Cause cause) {
     return HgImportTraceEvent{
-        unique, FINISH, resourceType, proxyHash, priority, cause};
+        unique, traceId, FINISH, resourceType, proxyHash, priority, cause};
   }
 
   HgImportTraceEvent(
       uint64_t unique,
+      uint64_t traceId,
       EventType eventType,
       ResourceType resourceType,
       const HgProxyHash& proxyHash,
@@ -92,6 +101,9 @@ struct HgImportTraceEvent : TraceEventBase {
   // Unique per request, but is consistent across the three stages of an import:
   // queue, start, and finish. Used to correlate events to a request.
   uint64_t unique;
+  // The trace ID of the fetch context the import is for, see
+  // ObjectFetchContext::getTraceId. Zero if there is none.
+  uint64_t traceId;
   // Always null-terminated, and saves space in the trace event structure.
   std::shared_ptr<char[]> path;
   // The HG manifest node ID.
@@ -102,6 +114,36 @@ struct HgImportTraceEvent : TraceEventBase {
   ObjectFetchContext::Cause importCause;
 };
 
+/**
+ * Where the time of one queued import went, from the moment the backing store
+ * was asked for the object to the moment its import finished. The stages are
+ * consecutive, and the ones the import skipped last zero microseconds.
+ */
+struct HgImportTimeline {
+  uint64_t unique;
+  // See ObjectFetchContext::getTraceId.
+  uint64_t traceId;
+  HgImportTraceEvent::ResourceType resourceType;
+  ObjectFetchContext::Cause importCause;
+  std::string path;
+  Hash20 manifestNodeId;
+  std::chrono::system_clock::time_point startTime;
+
+  // Looking the object up in hgcache before queueing the import. Prefetches
+  // skip it.
+  std::chrono::microseconds lookupDuration{0};
+  // Waiting for a worker to dequeue the import.
+  std::chrono::microseconds queueDuration{0};
+  // The batch fetch from hgcache and then the server.
+  std::chrono::microseconds batchDuration{0};
+  // The fallback to the hg importer when the batch fetch failed.
+  std::chrono::microseconds importerDuration{0};
+  // The import was deduplicated with one of the same object that was already
+  // queued or in progress, whose timeline has the stages after the lookup:
+  // this one only waited in the queue.
+  bool deduplicated{false};
+};
+
 /**
  * An Hg backing store implementation that will put incoming blob/tree import
  * requests into a job queue, then a pool of workers will work on fulfilling
@@ -140,6 +182,14 @@ class HgQueuedBackingStore final : public BackingStore {
     return *traceBus_;
   }
 
+  /**
+   * The timelines of the most recent imports, only recorded when
+   * ActivityBuffers are enabled.
+   */
+  std::optional<ActivityBuffer<HgImportTimeline>>& getImportTimelines() {
+    return importTimelines_;
+  }
+
   ObjectComparison compareObjectsById(const ObjectId& one, const ObjectId& two)
       override;
 
@@ -158,6 +208,9 @@ class HgQueuedBackingStore final : public BackingStore {
   ImmediateFuture<std::unique_ptr<Tree>> getRootTree(
       const RootId& rootId,
       const ObjectFetchContextPtr& context) override;
+  ImmediateFuture<std::vector<std::unique_ptr<Tree>>> getRootTrees(
+      const std::vector<RootId>& rootIds,
+      const ObjectFetchContextPtr& context) override;
   ImmediateFuture<std::unique_ptr<TreeEntry>> getTreeEntryForObjectId(
       const ObjectId& /* objectId */,
       TreeEntryType /* treeEntryType */,
@@ -189,6 +242,13 @@ class HgQueuedBackingStore final : public BackingStore {
       HgBackingStore::HgImportObject object,
       RequestMetricsScope::RequestMetric metric) const;
 
+  /**
+   * How the queued imports are spread between the processes they are for.
+   */
+  HgImportRequestQueue::ClientStats getImportQueueClientStats() const {
+    return queue_.getClientStats();
+  }
+
   void startRecordingFetch() override;
   std::unordered_set<std::string> stopRecordingFetch() override;
 
@@ -217,6 +277,8 @@ class HgQueuedBackingStore final : public BackingStore {
       std::vector<std::shared_ptr<HgImportRequest>>&& requests);
   void processTreeImportRequests(
       std::vector<std::shared_ptr<HgImportRequest>>&& requests);
+  void processBlobMetadataImportRequests(
+      std::vector<std::shared_ptr<HgImportRequest>>&& requests);
   void processPrefetchRequests(
       std::vector<std::shared_ptr<HgImportRequest>>&& requests);
 
@@ -227,6 +289,16 @@ class HgQueuedBackingStore final : public BackingStore {
 
   void logMissingProxyHash();
 
+  BackendHealthTracker::Options getHealthOptions() const;
+
+  /**
+   * The priority to fetch an object missing from the local caches with, or
+   * std::nullopt if the fetch should fail right away because the backend is
+   * degraded. See hg:degraded-backend-fail-fast.
+   */
+  std::optional<ImportPriority> getRemoteFetchPriority(
+      const ObjectFetchContext& context);
+
   /**
    * Fetch a blob from Mercurial.
    *
@@ -237,7 +309,8 @@ class HgQueuedBackingStore final : public BackingStore {
   folly::SemiFuture<GetBlobResult> getBlobImpl(
       const ObjectId& id,
       const HgProxyHash& proxyHash,
-      const ObjectFetchContextPtr& context);
+      const ObjectFetchContextPtr& context,
+      std::chrono::steady_clock::time_point fetchStart);
 
   std::unique_ptr<BlobMetadata> getLocalBlobMetadata(
       const ObjectId& id,
@@ -253,7 +326,33 @@ class HgQueuedBackingStore final : public BackingStore {
   folly::SemiFuture<GetTreeResult> getTreeImpl(
       const ObjectId& id,
       const HgProxyHash& proxyHash,
-      const ObjectFetchContextPtr& context);
+      const ObjectFetchContextPtr& context,
+      std::chrono::steady_clock::time_point fetchStart);
+
+  /**
+   * Persists the size and SHA-1 of the files of an imported tree, when they
+   * were fetched along with it.
+   */
+  void persistTreeAuxMetadata(const Tree& tree);
+
+  /**
+   * Queues a low priority fetch of the metadata of the files of an imported
+   * tree that don't carry their size and SHA-1, on behalf of the client that
+   * fetched the tree. The fetched metadata is persisted in the LocalStore.
+   */
+  void prefetchBlobAuxMetadata(
+      const Tree& tree,
+      std::optional<pid_t> clientPid);
+
+  /**
+   * Called when the import of the request finished, successfully or not.
+   * fetchStart is when the backing store was asked for the object.
+   */
+  void recordImportTimeline(
+      const HgImportRequest& request,
+      HgImportTraceEvent::ResourceType resourceType,
+      const HgProxyHash& proxyHash,
+      std::chrono::steady_clock::time_point fetchStart);
 
   /**
    * Logs a backing store fetch to scuba if the path being fetched is in the
@@ -272,7 +371,7 @@ class HgQueuedBackingStore final : public BackingStore {
    *        )
    *    gets the watches timing blob imports that are pending
    */
-  RequestMetricsScope::LockedRequestWatchList& getImportWatches(
+  RequestMetricsScope::RequestWatchList& getImportWatches(
       RequestMetricsScope::RequestStage stage,
       HgBackingStore::HgImportObject object) const;
 
@@ -283,7 +382,7 @@ class HgQueuedBackingStore final : public BackingStore {
    *        )
    *    gets the watches timing pending blob imports
    */
-  RequestMetricsScope::LockedRequestWatchList& getPendingImportWatches(
+  RequestMetricsScope::RequestWatchList& getPendingImportWatches(
       HgBackingStore::HgImportObject object) const;
 
   /**
@@ -305,6 +404,12 @@ class HgQueuedBackingStore final : public BackingStore {
    */
   std::shared_ptr<ReloadableConfig> config_;
 
+  /**
+   * The proxy hashes of legacy object IDs recently loaded from the
+   * LocalStore.
+   */
+  HgProxyHashCache proxyHashCache_;
+
   std::unique_ptr<HgBackingStore> backingStore_;
 
   /**
@@ -313,6 +418,12 @@ class HgQueuedBackingStore final : public BackingStore {
    */
   HgImportRequestQueue queue_;
 
+  /**
+   * Tracks the outcome of the import batches, to stop waiting on the remote
+   * while it is degraded.
+   */
+  BackendHealthTracker health_;
+
   /**
    * The worker thread pool. These threads will be running `processRequest`
    * forever to process incoming import requests
@@ -332,13 +443,14 @@ class HgQueuedBackingStore final : public BackingStore {
       lastMissingProxyHashLog_;
 
   // Track metrics for queued imports
-  mutable RequestMetricsScope::LockedRequestWatchList pendingImportBlobWatches_;
-  mutable RequestMetricsScope::LockedRequestWatchList pendingImportTreeWatches_;
-  mutable RequestMetricsScope::LockedRequestWatchList
-      pendingImportPrefetchWatches_;
+  mutable RequestMetricsScope::RequestWatchList pendingImportBlobWatches_;
+  mutable RequestMetricsScope::RequestWatchList pendingImportTreeWatches_;
+  mutable RequestMetricsScope::RequestWatchList pendingImportPrefetchWatches_;
 
   std::optional<ActivityBuffer<HgImportTraceEvent>> activityBuffer_;
 
+  std::optional<ActivityBuffer<HgImportTimeline>> importTimelines_;
+
   // The traceBus_ and hgTraceHandle_ should be last so any internal subscribers
   // can capture [this].
   std::shared_ptr<TraceBus<HgImportTraceEvent>> traceBus_;
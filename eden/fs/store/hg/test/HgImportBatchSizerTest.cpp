@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/hg/HgImportBatchSizer.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+TEST(HgImportBatchSizerTest, disabledUsesMaximum) {
+  HgImportBatchSizer sizer;
+  EXPECT_EQ(32, sizer.getBatchSize(32, 0ns));
+
+  sizer.recordBatch(32, 1s, 32, 0ns);
+  EXPECT_EQ(32, sizer.getBatchSize(32, 0ns));
+}
+
+TEST(HgImportBatchSizerTest, growsWhileBatchesAreFullAndFast) {
+  HgImportBatchSizer sizer;
+  EXPECT_EQ(1, sizer.getBatchSize(32, 100ms));
+
+  for (size_t expected : {2, 4, 8, 16, 32, 32}) {
+    sizer.recordBatch(sizer.getBatchSize(32, 100ms), 10ms, 32, 100ms);
+    EXPECT_EQ(expected, sizer.getBatchSize(32, 100ms));
+  }
+}
+
+TEST(HgImportBatchSizerTest, partialBatchesDoNotGrow) {
+  HgImportBatchSizer sizer;
+  sizer.recordBatch(1, 10ms, 32, 100ms);
+  sizer.recordBatch(2, 10ms, 32, 100ms);
+  ASSERT_EQ(4, sizer.getBatchSize(32, 100ms));
+
+  sizer.recordBatch(3, 10ms, 32, 100ms);
+  EXPECT_EQ(4, sizer.getBatchSize(32, 100ms));
+}
+
+TEST(HgImportBatchSizerTest, shrinksWhenSlow) {
+  HgImportBatchSizer sizer;
+  for (size_t i = 0; i < 5; ++i) {
+    sizer.recordBatch(sizer.getBatchSize(32, 100ms), 10ms, 32, 100ms);
+  }
+  ASSERT_EQ(32, sizer.getBatchSize(32, 100ms));
+
+  sizer.recordBatch(32, 200ms, 32, 100ms);
+  EXPECT_EQ(16, sizer.getBatchSize(32, 100ms));
+
+  sizer.recordBatch(1, 200ms, 32, 100ms);
+  EXPECT_EQ(1, sizer.getBatchSize(32, 100ms));
+}
+
+TEST(HgImportBatchSizerTest, limitFollowsLoweredMaximum) {
+  HgImportBatchSizer sizer;
+  for (size_t i = 0; i < 5; ++i) {
+    sizer.recordBatch(sizer.getBatchSize(32, 100ms), 10ms, 32, 100ms);
+  }
+  EXPECT_EQ(8, sizer.getBatchSize(8, 100ms));
+}
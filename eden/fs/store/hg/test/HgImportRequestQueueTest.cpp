@@ -5,13 +5,16 @@
  * GNU General Public License version 2.
  */
 
+#include <folly/CancellationToken.h>
 #include <folly/Try.h>
 #include <folly/logging/xlog.h>
 #include <folly/portability/GTest.h>
 #include <array>
 #include <memory>
+#include <thread>
 
 #include "eden/fs/config/ReloadableConfig.h"
+#include "eden/fs/model/BlobMetadata.h"
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/model/TestOps.h"
 #include "eden/fs/model/Tree.h"
@@ -130,8 +133,8 @@ TEST_F(HgImportRequestQueueTest, getRequestByPriority) {
     EXPECT_EQ(
         expected, request->getRequest<HgImportRequest::BlobImport>()->hash);
 
-    folly::Try<std::unique_ptr<Blob>> blob = folly::makeTryWith([expected]() {
-      return std::make_unique<Blob>(expected, folly::IOBuf{});
+    folly::Try<BlobPtr> blob = folly::makeTryWith([expected]() {
+      return std::make_shared<const Blob>(expected, folly::IOBuf{});
     });
 
     queue.markImportAsFinished<Blob>(
@@ -143,9 +146,9 @@ TEST_F(HgImportRequestQueueTest, getRequestByPriority) {
       smallHash,
       smallRequestDequeue->getRequest<HgImportRequest::BlobImport>()->hash);
 
-  folly::Try<std::unique_ptr<Blob>> smallBlob =
+  folly::Try<BlobPtr> smallBlob =
       folly::makeTryWith([smallHash = smallHash]() {
-        return std::make_unique<Blob>(smallHash, folly::IOBuf{});
+        return std::make_shared<const Blob>(smallHash, folly::IOBuf{});
       });
 
   queue.markImportAsFinished<Blob>(
@@ -175,9 +178,9 @@ TEST_F(HgImportRequestQueueTest, getRequestByPriorityReverse) {
       largeHash,
       largeHashDequeue->getRequest<HgImportRequest::BlobImport>()->hash);
 
-  folly::Try<std::unique_ptr<Blob>> largeBlob =
+  folly::Try<BlobPtr> largeBlob =
       folly::makeTryWith([largeHash = largeHash]() {
-        return std::make_unique<Blob>(largeHash, folly::IOBuf{});
+        return std::make_shared<const Blob>(largeHash, folly::IOBuf{});
       });
   queue.markImportAsFinished<Blob>(
       largeHashDequeue->getRequest<HgImportRequest::BlobImport>()->hash,
@@ -192,8 +195,8 @@ TEST_F(HgImportRequestQueueTest, getRequestByPriorityReverse) {
     EXPECT_EQ(
         expected, request->getRequest<HgImportRequest::BlobImport>()->hash);
 
-    folly::Try<std::unique_ptr<Blob>> blob = folly::makeTryWith([expected]() {
-      return std::make_unique<Blob>(expected, folly::IOBuf{});
+    folly::Try<BlobPtr> blob = folly::makeTryWith([expected]() {
+      return std::make_shared<const Blob>(expected, folly::IOBuf{});
     });
     queue.markImportAsFinished<Blob>(
         request->getRequest<HgImportRequest::BlobImport>()->hash, blob);
@@ -235,10 +238,10 @@ TEST_F(HgImportRequestQueueTest, mixedPriority) {
         ImportPriority(ImportPriority::Class::Normal, 10 - i)
             .value()); // assert tree requests of priority 10 and 9
 
-    folly::Try<std::unique_ptr<Tree>> tree = folly::makeTryWith(
+    folly::Try<TreePtr> tree = folly::makeTryWith(
         [hash = dequeuedRequest->getRequest<HgImportRequest::TreeImport>()
                     ->hash]() {
-          return std::make_unique<Tree>(
+          return std::make_shared<const Tree>(
               Tree::container{kPathMapDefaultCaseSensitive}, hash);
         });
     queue.markImportAsFinished<Tree>(
@@ -260,10 +263,10 @@ TEST_F(HgImportRequestQueueTest, mixedPriority) {
         ImportPriority(ImportPriority::Class::Normal, 9 - i)
             .value()); // assert blob requests of priority 9, 8, and 7
 
-    folly::Try<std::unique_ptr<Blob>> blob = folly::makeTryWith(
+    folly::Try<BlobPtr> blob = folly::makeTryWith(
         [hash = dequeuedRequest->getRequest<HgImportRequest::BlobImport>()
                     ->hash]() {
-          return std::make_unique<Blob>(hash, folly::IOBuf{});
+          return std::make_shared<const Blob>(hash, folly::IOBuf{});
         });
     queue.markImportAsFinished<Blob>(
         dequeuedRequest->getRequest<HgImportRequest::BlobImport>()->hash, blob);
@@ -298,10 +301,10 @@ TEST_F(HgImportRequestQueueTest, getMultipleRequests) {
             dequeuedRequest->getRequest<HgImportRequest::TreeImport>()->hash) !=
         enqueued_tree.end());
 
-    folly::Try<std::unique_ptr<Tree>> tree = folly::makeTryWith(
+    folly::Try<TreePtr> tree = folly::makeTryWith(
         [hash = dequeuedRequest->getRequest<HgImportRequest::TreeImport>()
                     ->hash]() {
-          return std::make_unique<Tree>(
+          return std::make_shared<const Tree>(
               Tree::container{kPathMapDefaultCaseSensitive}, hash);
         });
     queue.markImportAsFinished<Tree>(
@@ -319,10 +322,10 @@ TEST_F(HgImportRequestQueueTest, getMultipleRequests) {
             dequeuedRequest->getRequest<HgImportRequest::BlobImport>()->hash) !=
         enqueued_blob.end());
 
-    folly::Try<std::unique_ptr<Blob>> blob = folly::makeTryWith(
+    folly::Try<BlobPtr> blob = folly::makeTryWith(
         [hash = dequeuedRequest->getRequest<HgImportRequest::BlobImport>()
                     ->hash]() {
-          return std::make_unique<Blob>(hash, folly::IOBuf{});
+          return std::make_shared<const Blob>(hash, folly::IOBuf{});
         });
     queue.markImportAsFinished<Blob>(
         dequeuedRequest->getRequest<HgImportRequest::BlobImport>()->hash, blob);
@@ -357,9 +360,9 @@ TEST_F(HgImportRequestQueueTest, duplicateRequestAfterEnqueue) {
       expected,
       dequeuedRequest->getRequest<HgImportRequest::BlobImport>()->hash);
 
-  folly::Try<std::unique_ptr<Blob>> blob =
+  folly::Try<BlobPtr> blob =
       folly::makeTryWith([hash = proxyHash.sha1()]() {
-        return std::make_unique<Blob>(hash, folly::IOBuf{});
+        return std::make_shared<const Blob>(hash, folly::IOBuf{});
       });
   queue.markImportAsFinished<Blob>(
       dequeuedRequest->getRequest<HgImportRequest::BlobImport>()->hash, blob);
@@ -395,9 +398,9 @@ TEST_F(HgImportRequestQueueTest, duplicateRequestAfterDequeue) {
       dequeuedRequest->getRequest<HgImportRequest::BlobImport>()
           ->promises.size());
 
-  folly::Try<std::unique_ptr<Blob>> blob =
+  folly::Try<BlobPtr> blob =
       folly::makeTryWith([hash = proxyHash.sha1()]() {
-        return std::make_unique<Blob>(hash, folly::IOBuf{});
+        return std::make_shared<const Blob>(hash, folly::IOBuf{});
       });
   queue.markImportAsFinished<Blob>(
       dequeuedRequest->getRequest<HgImportRequest::BlobImport>()->hash, blob);
@@ -430,9 +433,9 @@ TEST_F(HgImportRequestQueueTest, duplicateRequestAfterMarkedDone) {
       expected,
       dequeuedRequest->getRequest<HgImportRequest::BlobImport>()->hash);
 
-  folly::Try<std::unique_ptr<Blob>> blob =
+  folly::Try<BlobPtr> blob =
       folly::makeTryWith([hash = proxyHash.sha1()]() {
-        return std::make_unique<Blob>(hash, folly::IOBuf{});
+        return std::make_shared<const Blob>(hash, folly::IOBuf{});
       });
   queue.markImportAsFinished<Blob>(
       dequeuedRequest->getRequest<HgImportRequest::BlobImport>()->hash, blob);
@@ -476,9 +479,9 @@ TEST_F(HgImportRequestQueueTest, multipleDuplicateRequests) {
       dequeuedRequest->getRequest<HgImportRequest::BlobImport>()
           ->promises.size());
 
-  folly::Try<std::unique_ptr<Blob>> blob =
+  folly::Try<BlobPtr> blob =
       folly::makeTryWith([hash = proxyHash.sha1()]() {
-        return std::make_unique<Blob>(hash, folly::IOBuf{});
+        return std::make_shared<const Blob>(hash, folly::IOBuf{});
       });
   queue.markImportAsFinished<Blob>(
       dequeuedRequest->getRequest<HgImportRequest::BlobImport>()->hash, blob);
@@ -532,8 +535,8 @@ TEST_F(HgImportRequestQueueTest, twoDuplicateRequestsDifferentPriority) {
     EXPECT_EQ(
         expected, request->getRequest<HgImportRequest::BlobImport>()->hash);
 
-    folly::Try<std::unique_ptr<Blob>> blob = folly::makeTryWith([expected]() {
-      return std::make_unique<Blob>(expected, folly::IOBuf{});
+    folly::Try<BlobPtr> blob = folly::makeTryWith([expected]() {
+      return std::make_shared<const Blob>(expected, folly::IOBuf{});
     });
     queue.markImportAsFinished<Blob>(
         request->getRequest<HgImportRequest::BlobImport>()->hash, blob);
@@ -544,9 +547,9 @@ TEST_F(HgImportRequestQueueTest, twoDuplicateRequestsDifferentPriority) {
   EXPECT_EQ(
       lowPriHash, expLowPri->getRequest<HgImportRequest::BlobImport>()->hash);
 
-  folly::Try<std::unique_ptr<Blob>> blob =
+  folly::Try<BlobPtr> blob =
       folly::makeTryWith([lowPriHash = lowPriHash]() {
-        return std::make_unique<Blob>(lowPriHash, folly::IOBuf{});
+        return std::make_shared<const Blob>(lowPriHash, folly::IOBuf{});
       });
   queue.markImportAsFinished<Blob>(
       expLowPri->getRequest<HgImportRequest::BlobImport>()->hash, blob);
@@ -560,11 +563,341 @@ TEST_F(HgImportRequestQueueTest, twoDuplicateRequestsDifferentPriority) {
     EXPECT_EQ(
         expected, request->getRequest<HgImportRequest::BlobImport>()->hash);
 
-    folly::Try<std::unique_ptr<Blob>> expBlob =
+    folly::Try<BlobPtr> expBlob =
         folly::makeTryWith([expected]() {
-          return std::make_unique<Blob>(expected, folly::IOBuf{});
+          return std::make_shared<const Blob>(expected, folly::IOBuf{});
         });
     queue.markImportAsFinished<Blob>(
         request->getRequest<HgImportRequest::BlobImport>()->hash, expBlob);
   }
 }
+
+TEST_F(HgImportRequestQueueTest, samePriorityIsFifo) {
+  auto queue = HgImportRequestQueue{edenConfig};
+  std::vector<ObjectId> enqueued;
+
+  for (int i = 0; i < 10; i++) {
+    enqueued.push_back(insertBlobImportRequest(
+        queue, ImportPriority{ImportPriority::Class::Normal}));
+  }
+
+  for (const auto& expected : enqueued) {
+    auto request = queue.dequeue().at(0);
+    EXPECT_EQ(
+        expected, request->getRequest<HgImportRequest::BlobImport>()->hash);
+
+    folly::Try<BlobPtr> blob = folly::makeTryWith([expected]() {
+      return std::make_shared<const Blob>(expected, folly::IOBuf{});
+    });
+    queue.markImportAsFinished<Blob>(
+        request->getRequest<HgImportRequest::BlobImport>()->hash, blob);
+  }
+}
+
+TEST_F(HgImportRequestQueueTest, duplicateRequestRaisesPriorityClass) {
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  auto proxyHash = HgProxyHash{RelativePath{"some_blob"}, uniqueHash()};
+  auto [lowHash, lowRequest] = makeBlobImportRequestWithHash(
+      ImportPriority{ImportPriority::Class::Low}, proxyHash);
+  auto [highHash, highRequest] = makeBlobImportRequestWithHash(
+      ImportPriority{ImportPriority::Class::High}, proxyHash);
+
+  queue.enqueueBlob(std::move(lowRequest));
+  auto normalHash = insertBlobImportRequest(
+      queue, ImportPriority{ImportPriority::Class::Normal});
+
+  // The duplicate moves the queued low priority request to the high class.
+  queue.enqueueBlob(std::move(highRequest));
+
+  auto first = queue.dequeue().at(0);
+  EXPECT_EQ(lowHash, first->getRequest<HgImportRequest::BlobImport>()->hash);
+  EXPECT_EQ(ImportPriority::Class::High, first->getPriority().getClass());
+  EXPECT_EQ(
+      1, first->getRequest<HgImportRequest::BlobImport>()->promises.size());
+
+  auto second = queue.dequeue().at(0);
+  EXPECT_EQ(
+      normalHash, second->getRequest<HgImportRequest::BlobImport>()->hash);
+
+  for (auto& request : {first, second}) {
+    auto hash = request->getRequest<HgImportRequest::BlobImport>()->hash;
+    folly::Try<BlobPtr> blob = folly::makeTryWith([hash]() {
+      return std::make_shared<const Blob>(hash, folly::IOBuf{});
+    });
+    queue.markImportAsFinished<Blob>(hash, blob);
+  }
+}
+
+TEST_F(HgImportRequestQueueTest, starvingRequestIsServedFirst) {
+  rawEdenConfig->importRequestStarvationThreshold.setValue(
+      std::chrono::nanoseconds{1}, ConfigSource::Default, true);
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  auto lowHash = insertBlobImportRequest(
+      queue, ImportPriority{ImportPriority::Class::Low});
+  auto highHash = insertBlobImportRequest(
+      queue, ImportPriority{ImportPriority::Class::High});
+
+  // Both requests are starving by the time they are dequeued, so the oldest
+  // one is served first regardless of its class.
+  auto first = queue.dequeue().at(0);
+  EXPECT_EQ(lowHash, first->getRequest<HgImportRequest::BlobImport>()->hash);
+  auto second = queue.dequeue().at(0);
+  EXPECT_EQ(highHash, second->getRequest<HgImportRequest::BlobImport>()->hash);
+
+  for (auto& request : {first, second}) {
+    auto hash = request->getRequest<HgImportRequest::BlobImport>()->hash;
+    folly::Try<BlobPtr> blob = folly::makeTryWith([hash]() {
+      return std::make_shared<const Blob>(hash, folly::IOBuf{});
+    });
+    queue.markImportAsFinished<Blob>(hash, blob);
+  }
+}
+
+TEST_F(HgImportRequestQueueTest, duplicateRequestsShareImportedObject) {
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  auto proxyHash = HgProxyHash{RelativePath{"some_blob"}, uniqueHash()};
+  auto [hash, request] = makeBlobImportRequestWithHash(
+      ImportPriority{ImportPriority::Class::Normal}, proxyHash);
+  auto [hash2, request2] = makeBlobImportRequestWithHash(
+      ImportPriority{ImportPriority::Class::Normal}, proxyHash);
+
+  auto future = queue.enqueueBlob(std::move(request));
+  auto future2 = queue.enqueueBlob(std::move(request2));
+
+  auto dequeued = queue.dequeue().at(0);
+  folly::Try<BlobPtr> blob = folly::makeTryWith([hash = hash]() {
+    return std::make_shared<const Blob>(hash, folly::IOBuf{});
+  });
+  dequeued->getPromise<HgImportRequest::BlobImport::Response>()->setValue(
+      blob.value());
+  queue.markImportAsFinished<Blob>(hash, blob);
+
+  EXPECT_EQ(blob.value().get(), std::move(future).get().get());
+  EXPECT_EQ(blob.value().get(), std::move(future2).get().get());
+}
+
+TEST_F(HgImportRequestQueueTest, adaptiveBatchSizeGrowsWithFastBatches) {
+  rawEdenConfig->importBatchSize.setValue(8, ConfigSource::UserConfig, true);
+  rawEdenConfig->importBatchTargetLatency.setValue(
+      std::chrono::seconds{1}, ConfigSource::UserConfig, true);
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  for (int i = 0; i < 10; i++) {
+    insertBlobImportRequest(queue, ImportPriority{ImportPriority::Class::Low});
+  }
+
+  auto first = queue.dequeue();
+  EXPECT_EQ(1, first.size());
+  queue.recordBlobBatch(first.size(), std::chrono::milliseconds{1});
+
+  auto second = queue.dequeue();
+  EXPECT_EQ(2, second.size());
+  queue.recordBlobBatch(second.size(), std::chrono::seconds{2});
+
+  EXPECT_EQ(1, queue.dequeue().size());
+}
+
+TEST_F(HgImportRequestQueueTest, lingerCoalescesRequests) {
+  rawEdenConfig->importBatchSize.setValue(2, ConfigSource::UserConfig, true);
+  rawEdenConfig->importBatchLinger.setValue(
+      std::chrono::minutes{10}, ConfigSource::UserConfig, true);
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  insertBlobImportRequest(queue, ImportPriority{ImportPriority::Class::Low});
+  std::thread producer{[&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    insertBlobImportRequest(queue, ImportPriority{ImportPriority::Class::Low});
+  }};
+
+  // The batch is only returned once full, well before the linger expires.
+  EXPECT_EQ(2, queue.dequeue().size());
+  producer.join();
+}
+
+TEST_F(HgImportRequestQueueTest, interactiveRequestsDoNotLinger) {
+  rawEdenConfig->importBatchSize.setValue(2, ConfigSource::UserConfig, true);
+  rawEdenConfig->importBatchLinger.setValue(
+      std::chrono::minutes{10}, ConfigSource::UserConfig, true);
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  auto hash = insertBlobImportRequest(
+      queue, ImportPriority{ImportPriority::Class::High});
+
+  auto dequeued = queue.dequeue();
+  ASSERT_EQ(1, dequeued.size());
+  EXPECT_EQ(hash, dequeued[0]->getRequest<HgImportRequest::BlobImport>()->hash);
+}
+
+TEST_F(HgImportRequestQueueTest, cancelledRequestsAreDropped) {
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  folly::CancellationSource source;
+  auto [cancelledHash, cancelled] =
+      makeBlobImportRequest(ImportPriority{ImportPriority::Class::High});
+  cancelled->addCancellationToken(source.getToken());
+  auto cancelledFuture = queue.enqueueBlob(std::move(cancelled));
+  auto hash = insertBlobImportRequest(
+      queue, ImportPriority{ImportPriority::Class::Low});
+
+  source.requestCancellation();
+
+  auto dequeued = queue.dequeue();
+  ASSERT_EQ(1, dequeued.size());
+  EXPECT_EQ(hash, dequeued[0]->getRequest<HgImportRequest::BlobImport>()->hash);
+  EXPECT_THROW(std::move(cancelledFuture).get(), folly::OperationCancelled);
+}
+
+TEST_F(HgImportRequestQueueTest, requestIsKeptWhileAFetchStillWaits) {
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  folly::CancellationSource source;
+  auto proxyHash = HgProxyHash{RelativePath{"some_blob"}, uniqueHash()};
+  auto [hash, request] = makeBlobImportRequestWithHash(
+      ImportPriority{ImportPriority::Class::Normal}, proxyHash);
+  request->addCancellationToken(source.getToken());
+  auto [hash2, request2] = makeBlobImportRequestWithHash(
+      ImportPriority{ImportPriority::Class::Normal}, proxyHash);
+  request2->addCancellationToken(folly::CancellationToken{});
+
+  auto future = queue.enqueueBlob(std::move(request));
+  auto future2 = queue.enqueueBlob(std::move(request2));
+
+  source.requestCancellation();
+
+  auto dequeued = queue.dequeue();
+  ASSERT_EQ(1, dequeued.size());
+  EXPECT_EQ(hash, dequeued[0]->getRequest<HgImportRequest::BlobImport>()->hash);
+}
+
+TEST_F(HgImportRequestQueueTest, blobMetadataIsTrackedApartFromBlobs) {
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  auto proxyHash = HgProxyHash{RelativePath{"some_blob"}, uniqueHash()};
+  auto [hash, blobRequest] = makeBlobImportRequestWithHash(
+      ImportPriority{ImportPriority::Class::Normal}, proxyHash);
+  auto blobFuture = queue.enqueueBlob(std::move(blobRequest));
+  auto metadataFuture =
+      queue.enqueueBlobMetadata(HgImportRequest::makeBlobMetadataImportRequest(
+          hash,
+          proxyHash,
+          ImportPriority{ImportPriority::Class::Low},
+          ObjectFetchContext::Cause::Prefetch));
+  auto duplicateFuture =
+      queue.enqueueBlobMetadata(HgImportRequest::makeBlobMetadataImportRequest(
+          hash,
+          proxyHash,
+          ImportPriority{ImportPriority::Class::Low},
+          ObjectFetchContext::Cause::Prefetch));
+
+  // Blobs come first, and the metadata requests were merged together but
+  // not with the blob.
+  auto blobBatch = queue.dequeue();
+  ASSERT_EQ(1, blobBatch.size());
+  EXPECT_TRUE(blobBatch[0]->isType<HgImportRequest::BlobImport>());
+  auto metadataBatch = queue.dequeue();
+  ASSERT_EQ(1, metadataBatch.size());
+  auto* metadataImport =
+      metadataBatch[0]->getRequest<HgImportRequest::BlobMetadataImport>();
+  ASSERT_NE(nullptr, metadataImport);
+  EXPECT_EQ(hash, metadataImport->hash);
+  EXPECT_EQ(1, metadataImport->promises.size());
+
+  auto metadata = std::make_shared<const BlobMetadata>(uniqueHash(), 42);
+  metadataBatch[0]
+      ->getPromise<HgImportRequest::BlobMetadataImport::Response>()
+      ->setValue(metadata);
+  queue.markImportAsFinished<BlobMetadata>(
+      hash, folly::Try<BlobMetadataPtr>{metadata});
+  EXPECT_EQ(metadata, std::move(metadataFuture).get());
+  EXPECT_EQ(metadata, std::move(duplicateFuture).get());
+  EXPECT_FALSE(blobFuture.isReady());
+}
+
+namespace {
+
+ObjectId insertBlobImportRequestFor(
+    HgImportRequestQueue& queue,
+    pid_t clientPid,
+    ImportPriority priority = ImportPriority{ImportPriority::Class::Normal}) {
+  auto [hash, request] = makeBlobImportRequest(priority);
+  request->setClientPid(clientPid);
+  queue.enqueueBlob(std::move(request));
+  return hash;
+}
+
+ObjectId dequeueBlob(HgImportRequestQueue& queue) {
+  auto dequeued = queue.dequeue();
+  EXPECT_EQ(1, dequeued.size());
+  return dequeued.at(0)->getRequest<HgImportRequest::BlobImport>()->hash;
+}
+
+} // namespace
+
+TEST_F(HgImportRequestQueueTest, clientsAreServedInTurn) {
+  rawEdenConfig->importFairShareQuantum.setValue(
+      2, ConfigSource::Default, true);
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  std::vector<ObjectId> busy;
+  for (int i = 0; i < 5; i++) {
+    busy.push_back(insertBlobImportRequestFor(queue, 100));
+  }
+  auto quiet = insertBlobImportRequestFor(queue, 200);
+
+  EXPECT_EQ(busy[0], dequeueBlob(queue));
+  EXPECT_EQ(busy[1], dequeueBlob(queue));
+  EXPECT_EQ(quiet, dequeueBlob(queue));
+  EXPECT_EQ(busy[2], dequeueBlob(queue));
+  EXPECT_EQ(busy[3], dequeueBlob(queue));
+  EXPECT_EQ(busy[4], dequeueBlob(queue));
+}
+
+TEST_F(HgImportRequestQueueTest, priorityOrdersRequestsWithinAClient) {
+  rawEdenConfig->importFairShareQuantum.setValue(
+      1, ConfigSource::Default, true);
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  auto first = insertBlobImportRequestFor(queue, 100);
+  auto urgent = insertBlobImportRequestFor(
+      queue, 100, ImportPriority{ImportPriority::Class::Normal, 10});
+  auto other = insertBlobImportRequestFor(queue, 200);
+
+  // Another class is not subject to the turns.
+  auto high = insertBlobImportRequestFor(
+      queue, 100, ImportPriority{ImportPriority::Class::High});
+
+  EXPECT_EQ(high, dequeueBlob(queue));
+  EXPECT_EQ(urgent, dequeueBlob(queue));
+  EXPECT_EQ(other, dequeueBlob(queue));
+  EXPECT_EQ(first, dequeueBlob(queue));
+}
+
+TEST_F(HgImportRequestQueueTest, disabledFairShareFollowsPriority) {
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  auto first = insertBlobImportRequestFor(queue, 100);
+  auto second = insertBlobImportRequestFor(queue, 100);
+  auto other = insertBlobImportRequestFor(queue, 200);
+
+  EXPECT_EQ(first, dequeueBlob(queue));
+  EXPECT_EQ(second, dequeueBlob(queue));
+  EXPECT_EQ(other, dequeueBlob(queue));
+}
+
+TEST_F(HgImportRequestQueueTest, clientStats) {
+  auto queue = HgImportRequestQueue{edenConfig};
+  EXPECT_EQ(0, queue.getClientStats().clients);
+
+  insertBlobImportRequestFor(queue, 100);
+  insertBlobImportRequestFor(queue, 100);
+  insertBlobImportRequestFor(queue, 200);
+  insertTreeImportRequest(queue, ImportPriority{ImportPriority::Class::Low});
+
+  auto stats = queue.getClientStats();
+  EXPECT_EQ(3, stats.clients);
+  EXPECT_EQ(2, stats.maxDepth);
+  EXPECT_GE(stats.maxWait.count(), 0);
+}
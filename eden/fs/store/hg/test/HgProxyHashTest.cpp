@@ -12,7 +12,9 @@
 
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/model/TestOps.h"
+#include "eden/fs/store/MemoryLocalStore.h"
 #include "eden/fs/store/hg/HgProxyHash.h"
+#include "eden/fs/store/hg/HgProxyHashCache.h"
 #include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/utils/IDGen.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -61,6 +63,24 @@ TEST(HgProxyHashTest, round_trip_version_1) {
   }
 }
 
+TEST(HgProxyHashTest, store_entry_of_directory_matches_full_path) {
+  Hash20 hash{folly::StringPiece{"0123456789abcdef0123456789abcdef01234567"}};
+
+  for (auto format : {HgObjectIdFormat::WithPath, HgObjectIdFormat::HashOnly}) {
+    EXPECT_EQ(
+        HgProxyHash::store(RelativePathPiece{"file"}, hash, format),
+        HgProxyHash::store(
+            RelativePathPiece{}, PathComponentPiece{"file"}, hash, format));
+    EXPECT_EQ(
+        HgProxyHash::store(RelativePathPiece{"some/dir/file"}, hash, format),
+        HgProxyHash::store(
+            RelativePathPiece{"some/dir"},
+            PathComponentPiece{"file"},
+            hash,
+            format));
+  }
+}
+
 TEST(HgProxyHashTest, round_trip_version_2) {
   EdenStats stats;
   Hash20 hash{folly::StringPiece{"0123456789abcdef0123456789abcdef01234567"}};
@@ -70,3 +90,30 @@ TEST(HgProxyHashTest, round_trip_version_2) {
   EXPECT_EQ(hash, proxy.revHash());
   EXPECT_EQ(RelativePathPiece{}, proxy.path());
 }
+
+TEST(HgProxyHashTest, cached_legacy_proxy_hashes_skip_the_local_store) {
+  auto stats = std::make_shared<EdenStats>();
+  MemoryLocalStore store;
+  HgProxyHashCache cache{16};
+  Hash20 hash{folly::StringPiece{"0123456789abcdef0123456789abcdef01234567"}};
+  HgProxyHash proxy{RelativePathPiece{"some/path"}, hash};
+  auto id = proxy.sha1();
+  store.put(
+      KeySpace::HgProxyHashFamily,
+      id,
+      folly::ByteRange{folly::StringPiece{proxy.getValue()}});
+
+  EXPECT_EQ(proxy, HgProxyHash::load(&store, id, "test", *stats, &cache));
+
+  // Once cached, the proxy hash is no longer read from the LocalStore.
+  store.clearKeySpace(KeySpace::HgProxyHashFamily);
+  EXPECT_EQ(proxy, HgProxyHash::load(&store, id, "test", *stats, &cache));
+  std::vector<ObjectId> ids{id};
+  ObjectIdRange range{ids.data(), ids.size()};
+  auto batch = HgProxyHash::getBatch(&store, range, *stats, &cache).get();
+  ASSERT_EQ(1, batch.size());
+  EXPECT_EQ(proxy, batch[0]);
+
+  EXPECT_THROW(
+      HgProxyHash::load(&store, id, "test", *stats), std::domain_error);
+}
@@ -120,6 +120,31 @@ TEST_F(HgQueuedBackingStoreTest, getBlob) {
   }
 }
 
+TEST_F(HgQueuedBackingStoreTest, prefetchRecordsImportTimelines) {
+  auto queuedStore = makeQueuedStore();
+  auto context = ObjectFetchContext::getNullContext();
+  auto tree = queuedStore->getRootTree(commit1, context).get(kTestTimeout);
+
+  std::vector<ObjectId> ids;
+  for (auto& entry : *tree) {
+    if (!entry.second.isTree()) {
+      ids.push_back(entry.second.getHash());
+    }
+  }
+  queuedStore->prefetchBlobs(ids, context).get(kTestTimeout);
+
+  ASSERT_TRUE(queuedStore->getImportTimelines().has_value());
+  auto timelines = queuedStore->getImportTimelines()->getAllEvents();
+  ASSERT_EQ(ids.size(), timelines.size());
+  for (const auto& timeline : timelines) {
+    EXPECT_EQ(context->getTraceId(), timeline.traceId);
+    EXPECT_EQ(HgImportTraceEvent::BLOB, timeline.resourceType);
+    EXPECT_FALSE(timeline.deduplicated);
+    EXPECT_GE(timeline.queueDuration.count(), 0);
+    EXPECT_GE(timeline.batchDuration.count(), 0);
+  }
+}
+
 TEST(HgQueuedBackingStore_ObjectId, round_trip_object_IDs) {
   Hash20 testHash{
       folly::StringPiece{"0123456789abcdef0123456789abcdef01234567"}};
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/AccessModelStore.h"
+
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/store/MemoryLocalStore.h"
+
+using namespace facebook::eden;
+using namespace facebook::eden::path_literals;
+using namespace folly::string_piece_literals;
+
+namespace {
+std::vector<RelativePath> paths(std::initializer_list<RelativePathPiece> list) {
+  std::vector<RelativePath> result;
+  for (auto path : list) {
+    result.push_back(path.copy());
+  }
+  return result;
+}
+
+struct AccessModelStoreTest : ::testing::Test {
+  AccessModelStoreTest() {
+    localStore->open();
+  }
+
+  std::shared_ptr<MemoryLocalStore> localStore =
+      std::make_shared<MemoryLocalStore>();
+  AccessModelStore store{localStore};
+};
+} // namespace
+
+TEST(AccessModel, learnCountsSessions) {
+  AccessModel model;
+  model.learn(paths({"a"_relpath, "b"_relpath}), 10);
+  model.learn(paths({"b"_relpath, "c"_relpath}), 10);
+
+  EXPECT_EQ(2, model.sessions);
+  ASSERT_EQ(3, model.followers.size());
+  EXPECT_EQ("b"_relpath, model.followers[0].path);
+  EXPECT_EQ(2, model.followers[0].sessions);
+  // Equally frequent files keep the order in which they were first read.
+  EXPECT_EQ("a"_relpath, model.followers[1].path);
+  EXPECT_EQ(1, model.followers[1].sessions);
+  EXPECT_EQ("c"_relpath, model.followers[2].path);
+  EXPECT_EQ(1, model.followers[2].sessions);
+}
+
+TEST(AccessModel, learnDropsLeastFrequentFollowers) {
+  AccessModel model;
+  model.learn(paths({"a"_relpath, "b"_relpath}), 2);
+  model.learn(paths({"c"_relpath, "b"_relpath}), 2);
+
+  ASSERT_EQ(2, model.followers.size());
+  EXPECT_EQ("b"_relpath, model.followers[0].path);
+  EXPECT_EQ("a"_relpath, model.followers[1].path);
+}
+
+TEST_F(AccessModelStoreTest, missingModelsAreNotFound) {
+  EXPECT_FALSE(store.get(Hash20::sha1("trigger")).has_value());
+}
+
+TEST_F(AccessModelStoreTest, modelsRoundTrip) {
+  AccessModel model;
+  model.learn(paths({"dir/a.h"_relpath, "dir/b.h"_relpath}), 10);
+  model.learn(paths({"dir/b.h"_relpath}), 10);
+
+  auto key = Hash20::sha1("trigger");
+  store.put(key, model);
+
+  auto loaded = store.get(key);
+  ASSERT_TRUE(loaded.has_value());
+  EXPECT_EQ(2, loaded->sessions);
+  ASSERT_EQ(2, loaded->followers.size());
+  EXPECT_EQ("dir/b.h"_relpath, loaded->followers[0].path);
+  EXPECT_EQ(2, loaded->followers[0].sessions);
+  EXPECT_EQ("dir/a.h"_relpath, loaded->followers[1].path);
+  EXPECT_EQ(1, loaded->followers[1].sessions);
+}
+
+TEST_F(AccessModelStoreTest, unreadableModelsAreIgnored) {
+  auto key = Hash20::sha1("trigger");
+  // An unknown version.
+  localStore->put(
+      KeySpace::AccessModelFamily,
+      key.getBytes(),
+      folly::ByteRange{"\xff"_sp});
+  EXPECT_FALSE(store.get(key).has_value());
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/AccessSketch.h"
+#include <gtest/gtest.h>
+
+using namespace facebook::eden;
+using namespace folly::string_piece_literals;
+
+TEST(AccessSketch, records_accesses) {
+  AccessSketch sketch{1 << 16};
+  EXPECT_FALSE(sketch.mayHaveBeenAccessed("key0"_sp));
+  sketch.record("key0"_sp);
+  EXPECT_TRUE(sketch.mayHaveBeenAccessed("key0"_sp));
+  EXPECT_FALSE(sketch.mayHaveBeenAccessed("key1"_sp));
+}
+
+TEST(AccessSketch, accesses_are_kept_for_one_more_epoch) {
+  AccessSketch sketch{1 << 16};
+  sketch.record("key0"_sp);
+  sketch.startEpoch();
+  sketch.record("key1"_sp);
+  EXPECT_TRUE(sketch.mayHaveBeenAccessed("key0"_sp));
+  EXPECT_TRUE(sketch.mayHaveBeenAccessed("key1"_sp));
+
+  sketch.startEpoch();
+  EXPECT_FALSE(sketch.mayHaveBeenAccessed("key0"_sp));
+  EXPECT_TRUE(sketch.mayHaveBeenAccessed("key1"_sp));
+
+  sketch.startEpoch();
+  EXPECT_FALSE(sketch.mayHaveBeenAccessed("key1"_sp));
+}
+
+TEST(AccessSketch, collisions_only_keep_more) {
+  // With a single word, every key maps to one of 64 bits.
+  AccessSketch sketch{1};
+  for (int i = 0; i < 1000; ++i) {
+    sketch.record(folly::StringPiece{std::to_string(i)});
+  }
+  for (int i = 0; i < 1000; ++i) {
+    auto key = std::to_string(i);
+    EXPECT_TRUE(sketch.mayHaveBeenAccessed(folly::StringPiece{key}));
+  }
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/BackendHealthTracker.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+using State = BackendHealthTracker::State;
+
+namespace {
+
+const BackendHealthTracker::Options kOptions{3, 10s, 30s};
+
+void fail(
+    BackendHealthTracker& tracker,
+    BackendHealthTracker::Clock::time_point now) {
+  tracker.recordFetch(false, 1ms, kOptions, now);
+}
+
+} // namespace
+
+TEST(BackendHealthTracker, degradesAfterConsecutiveFailures) {
+  BackendHealthTracker tracker;
+  auto now = BackendHealthTracker::Clock::now();
+
+  fail(tracker, now);
+  fail(tracker, now);
+  tracker.recordFetch(true, 1ms, kOptions, now);
+  fail(tracker, now);
+  fail(tracker, now);
+  EXPECT_EQ(State::Healthy, tracker.getState());
+  EXPECT_TRUE(tracker.allowRemoteFetch(kOptions, now));
+
+  // Slow fetches count as failures.
+  tracker.recordFetch(true, 11s, kOptions, now);
+  EXPECT_EQ(State::Degraded, tracker.getState());
+  EXPECT_FALSE(tracker.allowRemoteFetch(kOptions, now + 29s));
+}
+
+TEST(BackendHealthTracker, probesAfterCooldown) {
+  BackendHealthTracker tracker;
+  auto now = BackendHealthTracker::Clock::now();
+  for (int i = 0; i < 3; ++i) {
+    fail(tracker, now);
+  }
+
+  // A single probe is let through.
+  EXPECT_TRUE(tracker.allowRemoteFetch(kOptions, now + 30s));
+  EXPECT_EQ(State::Probing, tracker.getState());
+  EXPECT_FALSE(tracker.allowRemoteFetch(kOptions, now + 31s));
+
+  // A failed probe starts another cooldown.
+  fail(tracker, now + 32s);
+  EXPECT_EQ(State::Degraded, tracker.getState());
+  EXPECT_FALSE(tracker.allowRemoteFetch(kOptions, now + 61s));
+  EXPECT_TRUE(tracker.allowRemoteFetch(kOptions, now + 62s));
+
+  // A successful one goes back to normal.
+  tracker.recordFetch(true, 1ms, kOptions, now + 63s);
+  EXPECT_EQ(State::Healthy, tracker.getState());
+  EXPECT_TRUE(tracker.allowRemoteFetch(kOptions, now + 63s));
+}
+
+TEST(BackendHealthTracker, lostProbeIsRetried) {
+  BackendHealthTracker tracker;
+  auto now = BackendHealthTracker::Clock::now();
+  for (int i = 0; i < 3; ++i) {
+    fail(tracker, now);
+  }
+  EXPECT_TRUE(tracker.allowRemoteFetch(kOptions, now + 30s));
+  EXPECT_FALSE(tracker.allowRemoteFetch(kOptions, now + 59s));
+  EXPECT_TRUE(tracker.allowRemoteFetch(kOptions, now + 60s));
+}
+
+TEST(BackendHealthTracker, zeroThresholdDisablesTracking) {
+  BackendHealthTracker tracker;
+  BackendHealthTracker::Options disabled;
+  auto now = BackendHealthTracker::Clock::now();
+  for (int i = 0; i < 10; ++i) {
+    tracker.recordFetch(false, 1ms, disabled, now);
+  }
+  EXPECT_EQ(State::Healthy, tracker.getState());
+  EXPECT_TRUE(tracker.allowRemoteFetch(disabled, now));
+}
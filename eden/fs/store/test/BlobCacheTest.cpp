@@ -92,6 +92,27 @@ TEST(BlobCache, can_forget_cached_entries) {
   EXPECT_FALSE(cache->get(hash4).object);
 }
 
+TEST(BlobCache, remove_evicts_blobs_still_referenced) {
+  auto cache = BlobCache::create(100, 0);
+  auto handle = cache->insert(
+      std::make_shared<Blob>(hash3, "blob3"_sp),
+      BlobCache::Interest::WantHandle);
+  // LikelyNeededAgain keeps the blob cached after the handle is dropped.
+  EXPECT_TRUE(cache->get(hash3, BlobCache::Interest::LikelyNeededAgain).object);
+
+  EXPECT_TRUE(cache->remove(hash3));
+  EXPECT_FALSE(cache->contains(hash3));
+  EXPECT_FALSE(cache->remove(hash3));
+  EXPECT_EQ(0, cache->getStats().totalSizeInBytes);
+
+  // Dropping the handle of the removed blob does not affect a new insertion.
+  cache->insert(
+      std::make_shared<Blob>(hash3, "blob3"_sp),
+      BlobCache::Interest::LikelyNeededAgain);
+  handle.reset();
+  EXPECT_TRUE(cache->contains(hash3));
+}
+
 TEST(BlobCache, does_not_forget_blob_until_last_handle_is_forgotten) {
   auto cache = BlobCache::create(100, 0);
   auto blob = std::make_shared<Blob>(hash6, "newblob"_sp);
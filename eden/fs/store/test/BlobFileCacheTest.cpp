@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/store/BlobFileCache.h"
+
+#include <folly/experimental/TestUtil.h>
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/model/Blob.h"
+#include "eden/fs/store/MemoryLocalStore.h"
+
+using namespace facebook::eden;
+using folly::test::TemporaryDirectory;
+
+namespace {
+struct BlobFileCacheTest : ::testing::Test {
+  BlobFileCacheTest()
+      : tmpDir{"eden_blob_file_cache_"},
+        cachePath{canonicalPath(tmpDir.path().string()) + "blob-files"_pc} {}
+
+  TemporaryDirectory tmpDir;
+  AbsolutePath cachePath;
+};
+
+ObjectId makeId(uint64_t n) {
+  return ObjectId::sha1(folly::to<std::string>("blob ", n));
+}
+
+std::string readContents(const folly::IOBuf& buf) {
+  return buf.cloneAsValue().moveToFbString().toStdString();
+}
+} // namespace
+
+TEST_F(BlobFileCacheTest, missingIdsAreNotFound) {
+  auto cache = BlobFileCache::open(cachePath, 1024);
+  EXPECT_EQ(std::nullopt, cache->get(makeId(1), 5));
+}
+
+TEST_F(BlobFileCacheTest, putThenGet) {
+  auto cache = BlobFileCache::open(cachePath, 1024);
+  cache->put(makeId(1), folly::IOBuf{folly::IOBuf::COPY_BUFFER, "hello"});
+
+  auto contents = cache->get(makeId(1), 5);
+  ASSERT_TRUE(contents.has_value());
+  EXPECT_EQ("hello", readContents(*contents));
+  EXPECT_EQ(5, cache->getTotalSize());
+
+  // A size mismatch reads as missing.
+  EXPECT_EQ(std::nullopt, cache->get(makeId(1), 6));
+}
+
+TEST_F(BlobFileCacheTest, leastRecentlyUsedFilesAreEvicted) {
+  auto cache = BlobFileCache::open(cachePath, 10);
+  cache->put(makeId(1), folly::IOBuf{folly::IOBuf::COPY_BUFFER, "aaaa"});
+  cache->put(makeId(2), folly::IOBuf{folly::IOBuf::COPY_BUFFER, "bbbb"});
+  // Reading the first blob makes the second one the least recently used.
+  auto first = cache->get(makeId(1), 4);
+  ASSERT_TRUE(first.has_value());
+  cache->put(makeId(3), folly::IOBuf{folly::IOBuf::COPY_BUFFER, "cccc"});
+
+  EXPECT_EQ(8, cache->getTotalSize());
+  EXPECT_EQ(std::nullopt, cache->get(makeId(2), 4));
+  EXPECT_TRUE(cache->get(makeId(3), 4).has_value());
+  // The mapping of an evicted file stays readable.
+  EXPECT_EQ("aaaa", readContents(*first));
+}
+
+TEST_F(BlobFileCacheTest, filesSurviveReopening) {
+  BlobFileCache::open(cachePath, 1024)->put(
+      makeId(1), folly::IOBuf{folly::IOBuf::COPY_BUFFER, "hello"});
+
+  auto cache = BlobFileCache::open(cachePath, 1024);
+  EXPECT_EQ(5, cache->getTotalSize());
+  auto contents = cache->get(makeId(1), 5);
+  ASSERT_TRUE(contents.has_value());
+  EXPECT_EQ("hello", readContents(*contents));
+
+  cache->clear();
+  EXPECT_EQ(0, cache->getTotalSize());
+  EXPECT_EQ(std::nullopt, cache->get(makeId(1), 5));
+}
+
+TEST_F(BlobFileCacheTest, markersRoundTrip) {
+  auto marker = BlobFileCache::makeMarker(1234);
+  EXPECT_EQ(
+      std::optional<uint64_t>{1234},
+      BlobFileCache::parseMarker(folly::StringPiece{marker}));
+  EXPECT_EQ(
+      std::nullopt,
+      BlobFileCache::parseMarker(folly::StringPiece{"blob 4\0abcd", 11}));
+}
+
+TEST_F(BlobFileCacheTest, localStoreKeepsLargeBlobsInFiles) {
+  std::shared_ptr<BlobFileCache> cache = BlobFileCache::open(cachePath, 1024);
+  auto store = std::make_shared<MemoryLocalStore>();
+  store->setBlobFileCache(cache, 4);
+
+  auto smallId = makeId(1);
+  auto small = Blob{smallId, folly::StringPiece{"abc"}};
+  store->putBlob(smallId, &small);
+  auto largeId = makeId(2);
+  auto large = Blob{largeId, folly::StringPiece{"large contents"}};
+  store->putBlob(largeId, &large);
+
+  EXPECT_EQ(14, cache->getTotalSize());
+  auto largeValue = store->get(KeySpace::BlobFamily, largeId);
+  EXPECT_EQ(
+      std::optional<uint64_t>{14},
+      BlobFileCache::parseMarker(largeValue.bytes()));
+
+  auto outSmall = store->getBlob(smallId).get();
+  ASSERT_TRUE(outSmall);
+  EXPECT_EQ("abc", readContents(outSmall->getContents()));
+  auto outLarge = store->getBlob(largeId).get();
+  ASSERT_TRUE(outLarge);
+  EXPECT_EQ("large contents", readContents(outLarge->getContents()));
+
+  // A blob whose file was evicted is missing.
+  cache->clear();
+  EXPECT_EQ(nullptr, store->getBlob(largeId).get());
+}
+
+#endif
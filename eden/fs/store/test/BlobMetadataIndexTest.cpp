@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/store/BlobMetadataIndex.h"
+
+#include <folly/experimental/TestUtil.h>
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/store/MemoryLocalStore.h"
+
+using namespace facebook::eden;
+using folly::test::TemporaryDirectory;
+
+namespace {
+struct BlobMetadataIndexTest : ::testing::Test {
+  BlobMetadataIndexTest()
+      : tmpDir{"eden_blobmeta_index_"},
+        indexPath{(tmpDir.path() / "blobmeta-index").string()} {}
+
+  TemporaryDirectory tmpDir;
+  std::string indexPath;
+};
+
+ObjectId makeId(uint64_t n) {
+  return ObjectId::sha1(folly::to<std::string>("blob ", n));
+}
+
+BlobMetadata makeMetadata(uint64_t n) {
+  return BlobMetadata{Hash20::sha1(folly::to<std::string>("contents ", n)), n};
+}
+} // namespace
+
+TEST_F(BlobMetadataIndexTest, missingIdsAreNotFound) {
+  auto index = BlobMetadataIndex::open(indexPath, 64);
+  EXPECT_EQ(std::nullopt, index->get(makeId(1)));
+}
+
+TEST_F(BlobMetadataIndexTest, putThenGet) {
+  auto index = BlobMetadataIndex::open(indexPath, 64);
+  index->put(makeId(1), makeMetadata(1));
+  index->put(makeId(2), makeMetadata(2));
+
+  auto metadata = index->get(makeId(1));
+  ASSERT_TRUE(metadata.has_value());
+  EXPECT_EQ(makeMetadata(1).sha1, metadata->sha1);
+  EXPECT_EQ(1, metadata->size);
+  EXPECT_EQ(2, index->get(makeId(2))->size);
+}
+
+TEST_F(BlobMetadataIndexTest, capacityIsRoundedUpToPowerOfTwo) {
+  EXPECT_EQ(128, BlobMetadataIndex::open(indexPath, 100)->capacity());
+}
+
+TEST_F(BlobMetadataIndexTest, entriesSurviveReopening) {
+  BlobMetadataIndex::open(indexPath, 64)->put(makeId(1), makeMetadata(1));
+
+  auto index = BlobMetadataIndex::open(indexPath, 64);
+  ASSERT_TRUE(index->get(makeId(1)).has_value());
+  EXPECT_EQ(1, index->get(makeId(1))->size);
+}
+
+TEST_F(BlobMetadataIndexTest, changingCapacityDropsEntries) {
+  BlobMetadataIndex::open(indexPath, 64)->put(makeId(1), makeMetadata(1));
+
+  auto index = BlobMetadataIndex::open(indexPath, 256);
+  EXPECT_EQ(256, index->capacity());
+  EXPECT_EQ(std::nullopt, index->get(makeId(1)));
+}
+
+TEST_F(BlobMetadataIndexTest, fullIndexEvictsButNeverReturnsWrongData) {
+  auto index = BlobMetadataIndex::open(indexPath, 16);
+  for (uint64_t i = 0; i < 1000; ++i) {
+    index->put(makeId(i), makeMetadata(i));
+  }
+
+  size_t found = 0;
+  for (uint64_t i = 0; i < 1000; ++i) {
+    if (auto metadata = index->get(makeId(i))) {
+      EXPECT_EQ(makeMetadata(i).sha1, metadata->sha1);
+      EXPECT_EQ(i, metadata->size);
+      ++found;
+    }
+  }
+  EXPECT_GT(found, 0);
+  EXPECT_LE(found, 16);
+  EXPECT_EQ(999, index->get(makeId(999))->size);
+}
+
+TEST_F(BlobMetadataIndexTest, longIdsAreNotIndexed) {
+  auto index = BlobMetadataIndex::open(indexPath, 64);
+  ObjectId id{folly::fbstring(BlobMetadataIndex::kMaxKeySize + 1, 'x')};
+  index->put(id, makeMetadata(1));
+  EXPECT_EQ(std::nullopt, index->get(id));
+}
+
+TEST_F(BlobMetadataIndexTest, clearRemovesEntries) {
+  auto index = BlobMetadataIndex::open(indexPath, 64);
+  index->put(makeId(1), makeMetadata(1));
+  index->clear();
+  EXPECT_EQ(std::nullopt, index->get(makeId(1)));
+}
+
+TEST_F(BlobMetadataIndexTest, localStoreIsPopulatedAndServedByTheIndex) {
+  std::shared_ptr<BlobMetadataIndex> index =
+      BlobMetadataIndex::open(indexPath, 64);
+  auto store = std::make_shared<MemoryLocalStore>();
+  store->open();
+  store->setBlobMetadataIndex(index);
+
+  store->putBlobMetadata(makeId(1), makeMetadata(1));
+  EXPECT_EQ(1, index->get(makeId(1))->size);
+
+  // Entries found only in the index are served without reaching the store.
+  index->put(makeId(2), makeMetadata(2));
+  auto metadata = store->getBlobMetadata(makeId(2)).get();
+  ASSERT_TRUE(metadata.has_value());
+  EXPECT_EQ(2, metadata->size);
+
+  store->clearCaches();
+  EXPECT_EQ(std::nullopt, index->get(makeId(1)));
+}
+
+#endif
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/CacheSnapshot.h"
+
+#include <folly/experimental/TestUtil.h>
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/config/ReloadableConfig.h"
+#include "eden/fs/model/Blob.h"
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/BlobCache.h"
+#include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/store/TreeCache.h"
+#include "eden/fs/utils/FileUtils.h"
+
+using namespace facebook::eden;
+using namespace folly::string_piece_literals;
+using folly::test::TemporaryDirectory;
+
+namespace {
+struct CacheSnapshotTest : ::testing::Test {
+  CacheSnapshotTest() {
+    localStore->open();
+  }
+
+  std::shared_ptr<TreeCache> makeTreeCache() {
+    std::shared_ptr<EdenConfig> config{EdenConfig::createTestEdenConfig()};
+    return TreeCache::create(std::make_shared<ReloadableConfig>(
+        config, ConfigReloadBehavior::NoReload));
+  }
+
+  std::shared_ptr<MemoryLocalStore> localStore =
+      std::make_shared<MemoryLocalStore>();
+};
+
+std::shared_ptr<const Tree> makeTree(folly::StringPiece name) {
+  auto blobId = ObjectId::sha1(folly::to<std::string>("blob ", name));
+  return std::make_shared<const Tree>(
+      Tree::container{
+          {{PathComponent{name},
+            TreeEntry{blobId, TreeEntryType::REGULAR_FILE}}},
+          kPathMapDefaultCaseSensitive},
+      ObjectId::sha1(folly::to<std::string>("tree ", name)));
+}
+} // namespace
+
+TEST_F(CacheSnapshotTest, roundTrip) {
+  CacheSnapshot snapshot;
+  snapshot.trees = {
+      ObjectId::sha1("a"), ObjectId{folly::ByteRange{"proxy:a/b"_sp}}};
+  snapshot.blobs = {ObjectId::sha1("b")};
+
+  auto buf = snapshot.serialize();
+  buf.coalesce();
+  auto loaded =
+      CacheSnapshot::deserialize(folly::ByteRange{buf.data(), buf.length()});
+  EXPECT_EQ(snapshot.trees, loaded.trees);
+  EXPECT_EQ(snapshot.blobs, loaded.blobs);
+}
+
+TEST_F(CacheSnapshotTest, missingOrUnreadableSnapshotsAreIgnored) {
+  TemporaryDirectory tmpDir{"eden_cache_snapshot_"};
+  AbsolutePath path{(tmpDir.path() / "cache-snapshot").string()};
+  EXPECT_FALSE(CacheSnapshot::load(path).has_value());
+
+  CacheSnapshot{}.save(path);
+  EXPECT_TRUE(CacheSnapshot::load(path).has_value());
+
+  writeFileAtomic(path, "\xff"_sp).value();
+  EXPECT_FALSE(CacheSnapshot::load(path).has_value());
+}
+
+TEST_F(CacheSnapshotTest, warmReloadsHotObjectsFromTheLocalStore) {
+  auto tree = makeTree("a");
+  auto blob = std::make_shared<const Blob>(ObjectId::sha1("blob"), "blob"_sp);
+  localStore->putTree(*tree);
+  localStore->putBlob(blob->getHash(), blob.get());
+
+  auto treeCache = makeTreeCache();
+  auto blobCache = BlobCache::create(1000, 0);
+  treeCache->insert(tree);
+  // Not in the LocalStore, so it can't be reloaded.
+  treeCache->insert(makeTree("b"));
+  blobCache->insert(blob);
+
+  auto snapshot = CacheSnapshot::capture(*treeCache, *blobCache, 10);
+  EXPECT_EQ(2, snapshot.trees.size());
+  EXPECT_EQ(1, snapshot.blobs.size());
+
+  auto newTreeCache = makeTreeCache();
+  auto newBlobCache = BlobCache::create(1000, 0);
+  EXPECT_EQ(2, snapshot.warm(*localStore, *newTreeCache, *newBlobCache));
+  EXPECT_TRUE(newTreeCache->contains(tree->getHash()));
+  EXPECT_FALSE(newTreeCache->contains(makeTree("b")->getHash()));
+  EXPECT_TRUE(newBlobCache->contains(blob->getHash()));
+}
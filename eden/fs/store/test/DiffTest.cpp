@@ -7,6 +7,7 @@
 
 #include "eden/fs/store/Diff.h"
 
+#include <fmt/format.h>
 #include <folly/executors/QueuedImmediateExecutor.h>
 #include <folly/portability/GMock.h>
 #include <folly/portability/GTest.h>
@@ -29,6 +30,7 @@
 #include "eden/fs/utils/PathFuncs.h"
 
 using namespace facebook::eden;
+using namespace facebook::eden::path_literals;
 using namespace std::chrono_literals;
 using folly::Future;
 using folly::StringPiece;
@@ -90,14 +92,16 @@ class DiffTest : public ::testing::Test {
       DiffCallback* callback,
       std::unique_ptr<TopLevelIgnores> topLevelIgnores,
       bool listIgnored = true,
-      CaseSensitivity caseSensitive = kPathMapDefaultCaseSensitive) {
+      CaseSensitivity caseSensitive = kPathMapDefaultCaseSensitive,
+      size_t maxSubtreeFanout = 0) {
     return std::make_unique<DiffContext>(
         callback,
         folly::CancellationToken{},
         listIgnored,
         caseSensitive,
         store_.get(),
-        std::move(topLevelIgnores));
+        std::move(topLevelIgnores),
+        maxSubtreeFanout);
   }
 
   Future<ScmStatus> diffCommitsFuture(
@@ -1385,3 +1389,97 @@ TEST_F(DiffTest, directoryDiff) {
   // TODO(xavierd): Are we missing a change to the root whenever a file to the
   // root is created/removed?
 }
+
+TEST_F(DiffTest, equivalentTreesArePrunedOnceTheirDigestsAreKnown) {
+  FakeTreeBuilder builder1;
+  builder1.setFile("a/x.txt"_relpath, "x", false, makeTestHash("1"));
+  builder1.setFile("b.txt", "b");
+  builder1.finalize(backingStore_, /* setReady */ true);
+  backingStore_->putCommit("1", builder1)->setReady();
+
+  // Same contents under a, but a blob ID that makes the trees differ.
+  FakeTreeBuilder builder2;
+  builder2.setFile("a/x.txt"_relpath, "x", false, makeTestHash("2"));
+  builder2.setFile("b.txt", "b2");
+  builder2.finalize(backingStore_, /* setReady */ true);
+  backingStore_->putCommit("2", builder2)->setReady();
+
+  auto tree1 = builder1.getStoredTree("a"_relpath)->get().getHash();
+  auto tree2 = builder2.getStoredTree("a"_relpath)->get().getHash();
+  ASSERT_NE(tree1, tree2);
+  EXPECT_FALSE(store_->areTreesKnownEquivalent(tree1, tree2));
+
+  for (const auto& id : {makeTestHash("1"), makeTestHash("2")}) {
+    store_->getBlobMetadata(id, ObjectFetchContext::getNullContext()).get();
+  }
+
+  auto result = diffCommits("1", "2").get(100ms);
+  EXPECT_THAT(*result.errors_ref(), UnorderedElementsAre());
+  EXPECT_THAT(
+      *result.entries_ref(),
+      UnorderedElementsAre(Pair("b.txt", ScmFileStatus::MODIFIED)));
+
+  // The digests were computed as the diff of a completed.
+  EXPECT_TRUE(store_->areTreesKnownEquivalent(tree1, tree2));
+  result = diffCommits("1", "2").get(100ms);
+  EXPECT_THAT(
+      *result.entries_ref(),
+      UnorderedElementsAre(Pair("b.txt", ScmFileStatus::MODIFIED)));
+}
+
+TEST_F(DiffTest, boundedSubtreeFanout) {
+  FakeTreeBuilder builder1;
+  for (int i = 0; i < 10; ++i) {
+    builder1.setFile(fmt::format("dir{}/file.txt", i), "1");
+  }
+  builder1.finalize(backingStore_, /* setReady */ false);
+  backingStore_->putCommit("1", builder1)->setReady();
+
+  auto builder2 = builder1.clone();
+  for (int i = 0; i < 10; ++i) {
+    builder2.replaceFile(fmt::format("dir{}/file.txt", i), "2");
+  }
+  builder2.finalize(backingStore_, /* setReady */ false);
+  backingStore_->putCommit("2", builder2)->setReady();
+
+  auto callback = std::make_unique<ScmStatusDiffCallback>();
+  auto topLevelIgnores = std::make_unique<TopLevelIgnores>("", "");
+  auto gitIgnoreStack = topLevelIgnores->getStack();
+  auto diffContext = makeDiffContext(
+      callback.get(),
+      std::move(topLevelIgnores),
+      /* listIgnored */ true,
+      kPathMapDefaultCaseSensitive,
+      /* maxSubtreeFanout */ 3);
+
+  auto future = diffTrees(
+                    diffContext.get(),
+                    RelativePathPiece{},
+                    builder1.getRoot()->get().getHash(),
+                    builder2.getRoot()->get().getHash(),
+                    gitIgnoreStack,
+                    false)
+                    .semi()
+                    .via(&folly::QueuedImmediateExecutor::instance());
+
+  builder1.setReady("");
+  builder2.setReady("");
+  // Only as many subtrees as the fan-out allows were requested.
+  size_t requested = 0;
+  for (int i = 0; i < 10; ++i) {
+    auto path = RelativePath{fmt::format("dir{}", i)};
+    if (backingStore_->getAccessCount(
+            builder2.getStoredTree(path)->get().getHash()) > 0) {
+      ++requested;
+    }
+  }
+  EXPECT_EQ(3u, requested);
+  EXPECT_FALSE(future.isReady());
+
+  builder1.setAllReady();
+  builder2.setAllReady();
+  std::move(future).get(100ms);
+  auto result = callback->extractStatus();
+  EXPECT_THAT(*result.errors_ref(), UnorderedElementsAre());
+  EXPECT_EQ(10u, result.entries_ref()->size());
+}
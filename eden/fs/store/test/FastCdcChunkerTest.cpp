@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/FastCdcChunker.h"
+
+#include <folly/portability/GTest.h>
+#include <numeric>
+#include <random>
+#include <set>
+#include <string>
+
+namespace {
+
+using namespace facebook::eden;
+
+std::string randomBytes(size_t size, uint32_t seed) {
+  std::mt19937 rng{seed};
+  std::string bytes(size, '\0');
+  for (auto& c : bytes) {
+    c = static_cast<char>(rng());
+  }
+  return bytes;
+}
+
+std::set<std::string> chunksOf(
+    const FastCdcChunker& chunker,
+    const std::string& data) {
+  std::set<std::string> chunks;
+  size_t offset = 0;
+  for (auto length : chunker.chunkLengths(folly::StringPiece{data})) {
+    chunks.insert(data.substr(offset, length));
+    offset += length;
+  }
+  return chunks;
+}
+
+TEST(FastCdcChunker, chunksCoverTheDataWithinTheSizeBounds) {
+  FastCdcChunker chunker{1024, 4096, 16384};
+  auto data = randomBytes(1024 * 1024, 1);
+  auto lengths = chunker.chunkLengths(folly::StringPiece{data});
+
+  EXPECT_EQ(
+      data.size(), std::accumulate(lengths.begin(), lengths.end(), size_t{0}));
+  for (size_t i = 0; i + 1 < lengths.size(); ++i) {
+    EXPECT_GE(lengths[i], 1024);
+    EXPECT_LE(lengths[i], 16384);
+  }
+  // The chunks average around 4KiB.
+  EXPECT_GT(lengths.size(), data.size() / 16384);
+  EXPECT_LT(lengths.size(), data.size() / 1024);
+}
+
+TEST(FastCdcChunker, smallDataIsASingleChunk) {
+  FastCdcChunker chunker;
+  auto data = randomBytes(100, 2);
+  EXPECT_EQ(
+      std::vector<size_t>{100}, chunker.chunkLengths(folly::StringPiece{data}));
+  EXPECT_TRUE(chunker.chunkLengths(folly::ByteRange{}).empty());
+}
+
+TEST(FastCdcChunker, anEditOnlyChangesTheChunksAroundIt) {
+  FastCdcChunker chunker{1024, 4096, 16384};
+  auto data = randomBytes(1024 * 1024, 3);
+  auto edited = data;
+  edited.insert(edited.size() / 2, "a few inserted bytes");
+
+  auto before = chunksOf(chunker, data);
+  auto after = chunksOf(chunker, edited);
+  size_t shared = 0;
+  for (const auto& chunk : after) {
+    shared += before.count(chunk);
+  }
+  EXPECT_GE(shared + 3, before.size());
+}
+
+} // namespace
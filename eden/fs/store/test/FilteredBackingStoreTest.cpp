@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/FilteredBackingStore.h"
+
+#include <folly/experimental/TestUtil.h>
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/testharness/FakeBackingStore.h"
+#include "eden/fs/utils/FileUtils.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+using namespace facebook::eden;
+using namespace facebook::eden::path_literals;
+using namespace folly::string_piece_literals;
+using folly::test::TemporaryDirectory;
+
+namespace {
+
+class FilteredBackingStoreTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    fakeBackingStore_ = std::make_shared<FakeBackingStore>();
+    filterDir_ = canonicalPath(tempDir_.path().string()) + "filters"_pc;
+
+    auto* blob = fakeBackingStore_->putBlob("contents"_sp);
+    blob->setReady();
+    auto* docs = fakeBackingStore_->putTree({{"README.md", blob}});
+    docs->setReady();
+    auto* images = fakeBackingStore_->putTree({{"logo.png", blob}});
+    images->setReady();
+    auto* src = fakeBackingStore_->putTree({
+        {"main.cpp", blob},
+        {"images", images},
+    });
+    src->setReady();
+    auto* root = fakeBackingStore_->putTree({
+        {"docs", docs},
+        {"src", src},
+        {"README.md", blob},
+    });
+    root->setReady();
+    fakeBackingStore_->putCommit(RootId{"1"}, root)->setReady();
+
+    docsId_ = docs->get().getHash();
+    srcId_ = src->get().getHash();
+  }
+
+  std::unique_ptr<FilteredBackingStore> makeStore() {
+    return std::make_unique<FilteredBackingStore>(
+        fakeBackingStore_, filterDir_);
+  }
+
+  std::unique_ptr<Tree> getRootTree(BackingStore& store, const RootId& id) {
+    return store.getRootTree(id, ObjectFetchContext::getNullContext()).get();
+  }
+
+  std::shared_ptr<const Tree> getTree(BackingStore& store, const ObjectId& id) {
+    return store.getTree(id, ObjectFetchContext::getNullContext()).get().tree;
+  }
+
+  TemporaryDirectory tempDir_{"eden_filtered_backing_store_test_"};
+  AbsolutePath filterDir_;
+  std::shared_ptr<FakeBackingStore> fakeBackingStore_;
+  ObjectId docsId_;
+  ObjectId srcId_;
+};
+
+} // namespace
+
+TEST_F(FilteredBackingStoreTest, emptyFilterChangesNothing) {
+  auto store = makeStore();
+  auto rootId = store->parseRootId("1"_sp);
+  EXPECT_EQ(RootId{"1"}, rootId);
+
+  auto root = getRootTree(*store, rootId);
+  EXPECT_EQ(3, root->size());
+  EXPECT_EQ(srcId_, root->find("src"_pc)->second.getHash());
+}
+
+TEST_F(FilteredBackingStoreTest, filterHidesPathsAndKeepsUnaffectedIds) {
+  auto store = makeStore();
+  store->setFilter(
+      PathFilter::parse("[exclude]\ndocs\nglob:src/images/*.png\n"_sp));
+
+  auto rootId = store->parseRootId("1"_sp);
+  EXPECT_NE(RootId{"1"}, rootId);
+  EXPECT_EQ("1", store->renderRootId(rootId));
+
+  auto root = getRootTree(*store, rootId);
+  EXPECT_EQ(2, root->size());
+  EXPECT_EQ(root->end(), root->find("docs"_pc));
+
+  // src may lose entries, so its id encodes the filter.
+  auto srcId = root->find("src"_pc)->second.getHash();
+  EXPECT_NE(srcId_, srcId);
+  auto src = getTree(*store, srcId);
+  EXPECT_EQ(srcId, src->getHash());
+  EXPECT_EQ(2, src->size());
+
+  auto images = getTree(*store, src->find("images"_pc)->second.getHash());
+  EXPECT_EQ(0, images->size());
+
+  EXPECT_EQ(
+      ObjectComparison::Identical,
+      store->compareObjectsById(srcId, ObjectId{srcId.getBytes()}));
+  EXPECT_EQ(srcId, store->parseObjectId(store->renderObjectId(srcId)));
+}
+
+TEST_F(FilteredBackingStoreTest, changingTheFilterChangesTheRootId) {
+  auto store = makeStore();
+  store->setFilter(PathFilter::parse("[exclude]\ndocs\n"_sp));
+  auto first = store->parseRootId("1"_sp);
+
+  store->setFilter(PathFilter::parse("[include]\ndocs\n"_sp));
+  auto second = store->withCurrentFilter(first);
+  EXPECT_NE(first, second);
+  auto root = getRootTree(*store, second);
+  ASSERT_EQ(1, root->size());
+  // Nothing is hidden under an included directory.
+  EXPECT_EQ(docsId_, root->find("docs"_pc)->second.getHash());
+
+  // The previous root is still readable with its own filter.
+  EXPECT_EQ(2, getRootTree(*store, first)->size());
+
+  store->setFilter(PathFilter{});
+  EXPECT_EQ(RootId{"1"}, store->withCurrentFilter(second));
+}
+
+TEST_F(FilteredBackingStoreTest, filtersArePersisted) {
+  RootId rootId;
+  ObjectId srcId;
+  {
+    auto store = makeStore();
+    store->setFilter(PathFilter::parse("[exclude]\nsrc/main.cpp\n"_sp));
+    rootId = store->parseRootId("1"_sp);
+    srcId = getRootTree(*store, rootId)->find("src"_pc)->second.getHash();
+  }
+
+  auto store = makeStore();
+  EXPECT_EQ(2, getRootTree(*store, rootId)->size());
+  auto src = getTree(*store, srcId);
+  ASSERT_EQ(1, src->size());
+  EXPECT_NE(src->end(), src->find("images"_pc));
+}
+
+TEST_F(FilteredBackingStoreTest, loadFilterFile) {
+  auto path = canonicalPath(tempDir_.path().string()) + "filter"_pc;
+  EXPECT_TRUE(FilteredBackingStore::loadFilterFile(path).empty());
+
+  writeFile(path, "[include]\nsrc\n"_sp).value();
+  EXPECT_EQ(
+      PathFilter::parse("[include]\nsrc\n"_sp).getId(),
+      FilteredBackingStore::loadFilterFile(path).getId());
+}
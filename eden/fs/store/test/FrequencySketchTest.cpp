@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/FrequencySketch.h"
+#include <gtest/gtest.h>
+
+using namespace facebook::eden;
+
+namespace {
+const auto hash0 = ObjectId::sha1(std::string{"0"});
+const auto hash1 = ObjectId::sha1(std::string{"1"});
+} // namespace
+
+TEST(FrequencySketch, default_constructed_sketch_is_disabled) {
+  FrequencySketch sketch;
+  sketch.increment(hash0);
+  EXPECT_EQ(0, sketch.estimate(hash0));
+}
+
+TEST(FrequencySketch, counts_accesses) {
+  FrequencySketch sketch{1024};
+  EXPECT_EQ(0, sketch.estimate(hash0));
+  for (int i = 0; i < 3; ++i) {
+    sketch.increment(hash0);
+  }
+  sketch.increment(hash1);
+  EXPECT_EQ(3, sketch.estimate(hash0));
+  EXPECT_EQ(1, sketch.estimate(hash1));
+}
+
+TEST(FrequencySketch, counters_saturate) {
+  FrequencySketch sketch{1024};
+  for (int i = 0; i < 100; ++i) {
+    sketch.increment(hash0);
+  }
+  EXPECT_EQ(FrequencySketch::kMaxCount, sketch.estimate(hash0));
+}
+
+TEST(FrequencySketch, counters_age) {
+  FrequencySketch sketch{64};
+  for (int i = 0; i < 8; ++i) {
+    sketch.increment(hash0);
+  }
+  EXPECT_EQ(8, sketch.estimate(hash0));
+
+  // The sketch halves every counter after 10 * 64 recorded accesses.
+  for (int i = 0; i < 10 * 64; ++i) {
+    sketch.increment(ObjectId::sha1(std::to_string(i + 2)));
+  }
+  EXPECT_LT(sketch.estimate(hash0), 8);
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/GlobResultCache.h"
+
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/telemetry/EdenStats.h"
+
+using namespace facebook::eden;
+using namespace facebook::eden::path_literals;
+using namespace folly::string_piece_literals;
+
+namespace {
+struct GlobResultCacheTest : ::testing::Test {
+  GlobResultCacheTest() {
+    localStore->open();
+  }
+
+  std::shared_ptr<MemoryLocalStore> localStore =
+      std::make_shared<MemoryLocalStore>();
+  GlobResultCache cache{localStore, std::make_shared<EdenStats>()};
+};
+} // namespace
+
+TEST_F(GlobResultCacheTest, missingKeysAreNotFound) {
+  EXPECT_FALSE(cache.get(Hash20::sha1("key")).has_value());
+}
+
+TEST_F(GlobResultCacheTest, entriesRoundTrip) {
+  std::vector<GlobResultCache::Entry> entries{
+      {"dir/a.txt"_relpath.copy(), dtype_t::Regular, ObjectId::sha1("a")},
+      {"dir/sub"_relpath.copy(),
+       dtype_t::Dir,
+       ObjectId{folly::ByteRange{"tree:dir/sub"_sp}}},
+  };
+  cache.put(Hash20::sha1("key"), entries);
+  cache.put(Hash20::sha1("empty"), {});
+
+  auto stored = cache.get(Hash20::sha1("key"));
+  ASSERT_TRUE(stored.has_value());
+  ASSERT_EQ(2, stored->size());
+  for (size_t i = 0; i < entries.size(); ++i) {
+    EXPECT_EQ(entries[i].name, (*stored)[i].name);
+    EXPECT_EQ(entries[i].dtype, (*stored)[i].dtype);
+    EXPECT_EQ(entries[i].id, (*stored)[i].id);
+  }
+
+  auto empty = cache.get(Hash20::sha1("empty"));
+  ASSERT_TRUE(empty.has_value());
+  EXPECT_TRUE(empty->empty());
+}
+
+TEST_F(GlobResultCacheTest, unreadableEntriesAreNotFound) {
+  auto key = Hash20::sha1("key");
+  // Only the version byte.
+  localStore->put(
+      KeySpace::GlobResultFamily,
+      key.getBytes(),
+      folly::ByteRange{"\x01"_sp});
+  EXPECT_FALSE(cache.get(key).has_value());
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/HeavyFetcherPolicy.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+HeavyFetcherPolicy::Config makeConfig(uint64_t heavyFetchCount) {
+  HeavyFetcherPolicy::Config config;
+  config.heavyFetchCount = heavyFetchCount;
+  config.window = 10s;
+  config.deprioritize = true;
+  return config;
+}
+} // namespace
+
+TEST(HeavyFetcherPolicy, disabled_by_default) {
+  HeavyFetcherPolicy policy;
+  HeavyFetcherPolicy::Config config;
+  auto now = std::chrono::steady_clock::now();
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_FALSE(policy.recordFetch(1, config, now).heavy);
+  }
+  EXPECT_TRUE(policy.getStats(config, now).empty());
+}
+
+TEST(HeavyFetcherPolicy, deprioritizes_above_threshold) {
+  HeavyFetcherPolicy policy;
+  auto config = makeConfig(3);
+  auto now = std::chrono::steady_clock::now();
+  for (int i = 0; i < 3; ++i) {
+    auto decision = policy.recordFetch(1, config, now);
+    EXPECT_FALSE(decision.heavy);
+    EXPECT_FALSE(decision.deprioritize);
+  }
+  auto decision = policy.recordFetch(1, config, now);
+  EXPECT_TRUE(decision.heavy);
+  EXPECT_TRUE(decision.deprioritize);
+  EXPECT_EQ(0ns, decision.delay);
+
+  // Other processes are unaffected.
+  EXPECT_FALSE(policy.recordFetch(2, config, now).heavy);
+
+  auto stats = policy.getStats(config, now);
+  ASSERT_EQ(2, stats.size());
+  std::sort(stats.begin(), stats.end(), [](const auto& a, const auto& b) {
+    return a.pid < b.pid;
+  });
+  EXPECT_EQ(1, stats[0].pid);
+  EXPECT_EQ(4, stats[0].recentFetches);
+  EXPECT_TRUE(stats[0].heavy);
+  EXPECT_EQ(1, stats[0].deprioritizedFetches);
+  EXPECT_EQ(2, stats[1].pid);
+  EXPECT_FALSE(stats[1].heavy);
+}
+
+TEST(HeavyFetcherPolicy, previous_window_decays) {
+  HeavyFetcherPolicy policy;
+  auto config = makeConfig(10);
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < 10; ++i) {
+    policy.recordFetch(1, config, start);
+  }
+
+  // Halfway through the next window, half of the previous one still counts.
+  auto stats = policy.getStats(config, start + 15s);
+  ASSERT_EQ(1, stats.size());
+  EXPECT_EQ(5, stats[0].recentFetches);
+
+  // After two windows the process is forgotten.
+  EXPECT_TRUE(policy.getStats(config, start + 20s).empty());
+  EXPECT_FALSE(policy.recordFetch(1, config, start + 20s).heavy);
+}
+
+TEST(HeavyFetcherPolicy, rate_limits_heavy_fetchers) {
+  HeavyFetcherPolicy policy;
+  auto config = makeConfig(1);
+  config.deprioritize = false;
+  config.rateLimit = 10;
+  auto now = std::chrono::steady_clock::now();
+
+  EXPECT_EQ(0ns, policy.recordFetch(1, config, now).delay);
+  auto decision = policy.recordFetch(1, config, now);
+  EXPECT_TRUE(decision.heavy);
+  EXPECT_FALSE(decision.deprioritize);
+  EXPECT_EQ(0ns, decision.delay);
+  EXPECT_EQ(100ms, policy.recordFetch(1, config, now).delay);
+  EXPECT_EQ(200ms, policy.recordFetch(1, config, now).delay);
+
+  auto stats = policy.getStats(config, now);
+  ASSERT_EQ(1, stats.size());
+  EXPECT_EQ(2, stats[0].delayedFetches);
+  EXPECT_EQ(300ms, stats[0].totalDelay);
+}
@@ -8,6 +8,7 @@
 #include "eden/fs/store/test/LocalStoreTest.h"
 #include "eden/fs/store/MemoryLocalStore.h"
 #include "eden/fs/store/SqliteLocalStore.h"
+#include "eden/fs/store/TreeMetadata.h"
 
 namespace {
 
@@ -77,6 +78,41 @@ TEST_P(LocalStoreTest, testReadAndWriteBlob) {
   }
 }
 
+std::string makeLargeContents(size_t size) {
+  std::string contents(size, '\0');
+  uint64_t state = 1;
+  for (auto& c : contents) {
+    state = state * 6364136223846793005 + 1442695040888963407;
+    c = static_cast<char>(state >> 56);
+  }
+  return contents;
+}
+
+TEST_P(LocalStoreTest, chunkedBlobsAreReadBackWhole) {
+  store_->setChunkedBlobMinSize(1024);
+  auto contents = makeLargeContents(1024 * 1024);
+  auto hash = ObjectId::sha1(contents);
+  auto inBlob = Blob{hash, folly::StringPiece{contents}};
+  store_->putBlob(hash, &inBlob);
+
+  auto outBlob = store_->getBlob(hash).get(10s);
+  ASSERT_TRUE(outBlob);
+  EXPECT_TRUE(outBlob->getContents().isChained());
+  EXPECT_EQ(
+      contents, outBlob->getContents().clone()->moveToFbString().toStdString());
+}
+
+TEST_P(LocalStoreTest, chunkedBlobWithEvictedChunksIsMissing) {
+  store_->setChunkedBlobMinSize(1024);
+  auto contents = makeLargeContents(1024 * 1024);
+  auto hash = ObjectId::sha1(contents);
+  auto inBlob = Blob{hash, folly::StringPiece{contents}};
+  store_->putBlob(hash, &inBlob);
+  store_->clearKeySpace(KeySpace::BlobChunkFamily);
+
+  EXPECT_FALSE(store_->getBlob(hash).get(10s));
+}
+
 TEST_P(LocalStoreTest, testReadAndWriteMetadata) {
   ObjectId id = ObjectId::fromHex("3a8f8eb91101860fd8484154885838bf322964d0");
   auto sha1 = Hash20::sha1("foobar");
@@ -91,6 +127,25 @@ TEST_P(LocalStoreTest, testReadAndWriteMetadata) {
   EXPECT_EQ(size, retrievedMetadata.value().size);
 }
 
+TEST_P(LocalStoreTest, testWriteTreeMetadata) {
+  ObjectId id1 = ObjectId::fromHex("3a8f8eb91101860fd8484154885838bf322964d0");
+  ObjectId id2 = ObjectId::fromHex("8e073e366ed82de6465d1209d3f07da7eebabb93");
+  TreeMetadata::HashIndexedEntryMetadata entries{
+      {id1, BlobMetadata{Hash20::sha1("foo"), 3}},
+      {id2, BlobMetadata{Hash20::sha1("foobar"), 6}}};
+  store_->putTreeMetadata(TreeMetadata{std::move(entries)});
+
+  auto metadata1 = store_->getBlobMetadata(id1).get(10s);
+  ASSERT_TRUE(metadata1.has_value());
+  EXPECT_EQ(Hash20::sha1("foo"), metadata1->sha1);
+  EXPECT_EQ(3, metadata1->size);
+
+  auto metadata2 = store_->getBlobMetadata(id2).get(10s);
+  ASSERT_TRUE(metadata2.has_value());
+  EXPECT_EQ(Hash20::sha1("foobar"), metadata2->sha1);
+  EXPECT_EQ(6, metadata2->size);
+}
+
 TEST_P(LocalStoreTest, testReadNonexistent) {
   using namespace std::chrono_literals;
 
@@ -176,11 +231,25 @@ TEST_P(LocalStoreTest, testGetResult) {
   EXPECT_THROW(result2.piece(), std::domain_error);
 }
 
+TEST_P(LocalStoreTest, getBatchReturnsResultsInRequestOrder) {
+  store_->put(KeySpace::BlobFamily, "b"_sp, "value b"_sp);
+  store_->put(KeySpace::BlobFamily, "c"_sp, "value c"_sp);
+  store_->put(KeySpace::BlobFamily, "a"_sp, "value a"_sp);
+
+  std::vector<folly::ByteRange> keys{"c"_sp, "missing"_sp, "a"_sp, "b"_sp};
+  auto results = store_->getBatch(KeySpace::BlobFamily, keys).get();
+  ASSERT_EQ(4, results.size());
+  EXPECT_EQ("value c", results[0].piece());
+  EXPECT_FALSE(results[1].isValid());
+  EXPECT_EQ("value a", results[2].piece());
+  EXPECT_EQ("value b", results[3].piece());
+}
+
 TEST_P(LocalStoreTest, StoreResult_contains_keyspace_name_and_key) {
   auto key = ObjectId{kEmptySha1.getBytes()};
   auto result = store_->get(KeySpace::BlobFamily, key);
   try {
-    result.asString();
+    result.piece();
     FAIL();
   } catch (std::domain_error& e) {
     EXPECT_EQ(
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/LocalStoreWriteQueue.h"
+
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/model/Blob.h"
+#include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/store/StoreResult.h"
+#include "eden/fs/telemetry/EdenStats.h"
+
+namespace {
+
+using namespace facebook::eden;
+using namespace folly::string_piece_literals;
+using namespace std::chrono_literals;
+
+folly::IOBuf makeValue(folly::StringPiece value) {
+  return folly::IOBuf{folly::IOBuf::COPY_BUFFER, value};
+}
+
+class LocalStoreWriteQueueTest : public ::testing::Test {
+ protected:
+  MemoryLocalStore store_;
+  LocalStoreWriteQueue queue_{store_, 64, std::make_shared<EdenStats>()};
+};
+
+TEST_F(LocalStoreWriteQueueTest, queuedWritesAreCommitted) {
+  EXPECT_TRUE(queue_.put(KeySpace::TreeFamily, "a"_sp, makeValue("one"_sp)));
+  EXPECT_TRUE(queue_.put(KeySpace::TreeFamily, "b"_sp, makeValue("two"_sp)));
+  queue_.flush();
+
+  EXPECT_EQ(0, queue_.getPendingBytes());
+  EXPECT_EQ("one", store_.get(KeySpace::TreeFamily, "a"_sp).piece());
+  EXPECT_EQ("two", store_.get(KeySpace::TreeFamily, "b"_sp).piece());
+}
+
+TEST_F(LocalStoreWriteQueueTest, chainedValuesAreWrittenWhole) {
+  auto value = makeValue("head "_sp);
+  value.prependChain(folly::IOBuf::copyBuffer("tail"_sp));
+  queue_.put(KeySpace::BlobFamily, "key"_sp, std::move(value));
+  queue_.flush();
+
+  EXPECT_EQ("head tail", store_.get(KeySpace::BlobFamily, "key"_sp).piece());
+}
+
+TEST_F(LocalStoreWriteQueueTest, writesThatDoNotFitAreDropped) {
+  std::string large(100, 'x');
+  EXPECT_TRUE(queue_.put(
+      KeySpace::BlobFamily, "large"_sp, makeValue(folly::StringPiece{large})));
+  queue_.flush();
+
+  EXPECT_EQ(1, queue_.getDroppedCount());
+  EXPECT_FALSE(store_.hasKey(KeySpace::BlobFamily, "large"_sp));
+}
+
+TEST_F(LocalStoreWriteQueueTest, stoppedQueueRefusesWrites) {
+  queue_.put(KeySpace::TreeFamily, "before"_sp, makeValue("value"_sp));
+  queue_.stop();
+
+  EXPECT_TRUE(store_.hasKey(KeySpace::TreeFamily, "before"_sp));
+  EXPECT_FALSE(
+      queue_.put(KeySpace::TreeFamily, "after"_sp, makeValue("value"_sp)));
+  EXPECT_EQ(0, queue_.getDroppedCount());
+}
+
+TEST(LocalStoreQueuedWrites, queuedBlobsCanBeReadBack) {
+  MemoryLocalStore store;
+  store.startWriteQueue(1024, std::make_shared<EdenStats>());
+
+  auto id = ObjectId::fromHex("3a8f8eb91101860fd8484154885838bf322964d0");
+  Blob blob{id, "contents"_sp};
+  store.queueBlob(id, &blob);
+  store.flushWriteQueue();
+  store.stopWriteQueue();
+
+  auto stored = store.getBlob(id).get(10s);
+  ASSERT_TRUE(stored);
+  EXPECT_EQ(
+      "contents",
+      stored->getContents().clone()->moveToFbString().toStdString());
+}
+
+TEST(LocalStoreQueuedWrites, writesInlineWithoutQueue) {
+  MemoryLocalStore store;
+  auto id = ObjectId::fromHex("0000000000000000000000000000000000000001");
+  store.queuePut(KeySpace::HgCommitToTreeFamily, id, "tree"_sp);
+
+  EXPECT_TRUE(store.hasKey(KeySpace::HgCommitToTreeFamily, id));
+}
+
+} // namespace
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/MissingObjectFilter.h"
+
+#include <folly/Conv.h>
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/model/Blob.h"
+#include "eden/fs/store/MemoryLocalStore.h"
+
+namespace {
+
+using namespace facebook::eden;
+using namespace folly::string_piece_literals;
+
+bool scanKeys(
+    const std::vector<std::string>& keys,
+    folly::FunctionRef<void(folly::ByteRange)> add) {
+  for (const auto& key : keys) {
+    add(folly::StringPiece{key});
+  }
+  return true;
+}
+
+TEST(MissingObjectFilter, nothingIsKnownMissingBeforeTheFirstBuild) {
+  MissingObjectFilter filter{1024, 16};
+  EXPECT_FALSE(filter.isBuilt());
+  EXPECT_FALSE(filter.isKnownMissing("key"_sp));
+}
+
+TEST(MissingObjectFilter, recordedMissesAreKnownUntilStored) {
+  MissingObjectFilter filter{1024, 16};
+  filter.recordMissing("key"_sp);
+  EXPECT_TRUE(filter.isKnownMissing("key"_sp));
+
+  filter.recordStored("key"_sp);
+  EXPECT_FALSE(filter.isKnownMissing("key"_sp));
+}
+
+TEST(MissingObjectFilter, builtFilterRulesOutUnstoredKeys) {
+  MissingObjectFilter filter{1 << 16, 16};
+  std::vector<std::string> stored;
+  for (int i = 0; i < 100; ++i) {
+    stored.push_back(folly::to<std::string>("stored", i));
+  }
+  filter.rebuild([&](auto add) { return scanKeys(stored, add); });
+  ASSERT_TRUE(filter.isBuilt());
+
+  for (const auto& key : stored) {
+    EXPECT_FALSE(filter.isKnownMissing(folly::StringPiece{key}));
+  }
+  size_t knownMissing = 0;
+  for (int i = 0; i < 100; ++i) {
+    knownMissing += filter.isKnownMissing(
+        folly::StringPiece{folly::to<std::string>("missing", i)});
+  }
+  EXPECT_GT(knownMissing, 90);
+
+  filter.recordStored("new"_sp);
+  EXPECT_FALSE(filter.isKnownMissing("new"_sp));
+}
+
+TEST(MissingObjectFilter, failedScanKeepsTheCurrentFilter) {
+  MissingObjectFilter filter{1024, 16};
+  filter.rebuild([](auto) { return false; });
+  EXPECT_FALSE(filter.isBuilt());
+
+  filter.rebuild([](auto) { return true; });
+  EXPECT_TRUE(filter.isBuilt());
+  EXPECT_TRUE(filter.isKnownMissing("key"_sp));
+  filter.rebuild([](auto) { return false; });
+  EXPECT_TRUE(filter.isBuilt());
+}
+
+TEST(MissingObjectFilter, localStoreRecordsItsWrites) {
+  MemoryLocalStore store;
+  store.enableMissingObjectFilters(1024, 16);
+  auto stored = ObjectId::fromHex("0000000000000000000000000000000000000001");
+  store.putBlob(stored, std::make_unique<Blob>(stored, "a"_sp).get());
+  store.refreshMissingObjectFilters();
+
+  auto* filter = store.getMissingObjectFilter(KeySpace::BlobFamily);
+  ASSERT_TRUE(filter);
+  EXPECT_TRUE(filter->isBuilt());
+  EXPECT_FALSE(filter->isKnownMissing(stored.getBytes()));
+
+  auto added = ObjectId::fromHex("0000000000000000000000000000000000000002");
+  store.queueBlob(added, std::make_unique<Blob>(added, "b"_sp).get());
+  EXPECT_FALSE(filter->isKnownMissing(added.getBytes()));
+  EXPECT_FALSE(store.getMissingObjectFilter(KeySpace::BlobMetaDataFamily));
+}
+
+} // namespace
@@ -5,9 +5,29 @@
  * GNU General Public License version 2.
  */
 
+#include <folly/FileUtil.h>
+#include <folly/String.h>
+#include <folly/Utility.h>
+#include <gflags/gflags.h>
+#include <random>
 #include "eden/common/utils/benchharness/Bench.h"
 #include "eden/fs/store/ObjectCache.h"
 
+DEFINE_string(
+    fetch_trace,
+    "",
+    "Path to a file listing fetched paths, one per line, as written by "
+    "`eden prefetch-profile finish`. When empty, a synthetic working set is "
+    "used instead");
+DEFINE_uint64(
+    trace_object_size,
+    4096,
+    "Size in bytes assumed for every object of the replayed trace");
+DEFINE_uint64(
+    trace_cache_size,
+    40 * 1024 * 1024,
+    "Size in bytes of the cache the trace is replayed against");
+
 namespace facebook::eden {
 
 namespace {
@@ -85,6 +105,112 @@ void insertSimple(benchmark::State& st) {
 
 BENCHMARK(insertSimple)->UseManualTime();
 
+class SizedObject {
+ public:
+  SizedObject(ObjectId hash, size_t size)
+      : hash_{std::move(hash)}, size_{size} {}
+
+  const ObjectId& getHash() const {
+    return hash_;
+  }
+
+  size_t getSizeBytes() const {
+    return size_;
+  }
+
+ private:
+  ObjectId hash_;
+  size_t size_;
+};
+
+using SizedObjectCache = ObjectCache<SizedObject, ObjectCacheFlavor::Simple>;
+
+std::vector<std::string> loadFetchTrace() {
+  std::vector<std::string> paths;
+  if (FLAGS_fetch_trace.empty()) {
+    for (auto i = 0u; i < 20000u; i++) {
+      paths.push_back(fmt::format("synthetic/file{}", i));
+    }
+    return paths;
+  }
+
+  std::string contents;
+  if (!folly::readFile(FLAGS_fetch_trace.c_str(), contents)) {
+    throw std::runtime_error(
+        fmt::format("unable to read fetch trace {}", FLAGS_fetch_trace));
+  }
+  folly::split('\n', contents, paths, /*ignoreEmpty=*/true);
+  return paths;
+}
+
+/**
+ * Replay the fetched paths of a recorded trace against an ObjectCache
+ * configured with the eviction policy given as the benchmark argument.
+ *
+ * The recorded paths are the working set: they are read with a skewed
+ * (Zipf-like) distribution, as the headers a compiler rereads are. Every so
+ * often, a burst of one-shot objects, the size of the cache, streams through
+ * the cache to simulate a glob or grep over the repository. The hit ratio is
+ * reported as a counter.
+ */
+void replayFetchTrace(benchmark::State& st) {
+  auto policy = static_cast<CacheEvictionPolicy>(st.range(0));
+  auto paths = loadFetchTrace();
+  std::vector<std::shared_ptr<SizedObject>> workingSet;
+  workingSet.reserve(paths.size());
+  for (const auto& path : paths) {
+    workingSet.push_back(std::make_shared<SizedObject>(
+        ObjectId::sha1(path), FLAGS_trace_object_size));
+  }
+
+  auto scanLength =
+      std::max<uint64_t>(FLAGS_trace_cache_size / FLAGS_trace_object_size, 1);
+  constexpr auto kAccessesBetweenScans = 100000u;
+
+  // Rank i is drawn with a probability proportional to 1 / (i + 1).
+  std::vector<double> weights;
+  weights.reserve(workingSet.size());
+  for (size_t i = 0; i < workingSet.size(); i++) {
+    weights.push_back(1.0 / static_cast<double>(i + 1));
+  }
+  std::discrete_distribution<size_t> zipf{weights.begin(), weights.end()};
+  std::mt19937_64 rng{0};
+
+  uint64_t hits = 0;
+  uint64_t accesses = 0;
+  uint64_t scanned = 0;
+  auto cache = SizedObjectCache::create(FLAGS_trace_cache_size, 1, 1, policy);
+  auto access = [&](const std::shared_ptr<SizedObject>& object) {
+    if (cache->getSimple(object->getHash())) {
+      return true;
+    }
+    cache->insertSimple(object);
+    return false;
+  };
+
+  for (auto _ : st) {
+    for (auto i = 0u; i < kAccessesBetweenScans; i++) {
+      hits += access(workingSet[zipf(rng)]);
+      accesses++;
+    }
+    for (auto i = 0u; i < scanLength; i++) {
+      access(std::make_shared<SizedObject>(
+          ObjectId::sha1(fmt::format("scan/{}", scanned++)),
+          FLAGS_trace_object_size));
+    }
+  }
+
+  st.counters["hit_ratio"] =
+      accesses ? static_cast<double>(hits) / static_cast<double>(accesses) : 0;
+}
+
+BENCHMARK(replayFetchTrace)
+    ->ArgName("policy")
+    ->Arg(folly::to_underlying(CacheEvictionPolicy::LRU))
+    ->Arg(folly::to_underlying(CacheEvictionPolicy::SLRU))
+    ->Arg(folly::to_underlying(CacheEvictionPolicy::TinyLFU))
+    ->Unit(benchmark::kMillisecond);
+
 } // namespace
 } // namespace facebook::eden
 
@@ -534,3 +534,276 @@ TEST(
   handle3.reset();
   EXPECT_TRUE(cache->contains(hash3));
 }
+
+/**
+ * sharded cache test cases
+ */
+
+TEST(ObjectCache, sharded_cache_finds_objects_in_every_shard) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(100, 0, 4);
+  EXPECT_EQ(4, cache->getShardCount());
+
+  for (const auto& object :
+       {object3, object3a, object3b, object3c, object4, object5, object6}) {
+    cache->insertSimple(object);
+  }
+  for (const auto& object :
+       {object3, object3a, object3b, object3c, object4, object5, object6}) {
+    EXPECT_TRUE(cache->contains(object->getHash()));
+    EXPECT_EQ(object, cache->getSimple(object->getHash()));
+  }
+
+  auto stats = cache->getStats();
+  EXPECT_EQ(7, stats.objectCount);
+  EXPECT_EQ(27, stats.totalSizeInBytes);
+  EXPECT_EQ(7, stats.hitCount);
+  ASSERT_EQ(4, stats.shards.size());
+
+  size_t shardObjectCount = 0;
+  size_t shardTotalSize = 0;
+  for (const auto& shard : stats.shards) {
+    shardObjectCount += shard.objectCount;
+    shardTotalSize += shard.totalSizeInBytes;
+  }
+  EXPECT_EQ(stats.objectCount, shardObjectCount);
+  EXPECT_EQ(stats.totalSizeInBytes, shardTotalSize);
+}
+
+TEST(ObjectCache, sharded_cache_evicts_within_shard_budget) {
+  // Each of the two shards gets a 5 byte budget.
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(10, 0, 2);
+
+  for (const auto& object :
+       {object3, object3a, object3b, object3c, object4, object5}) {
+    cache->insertSimple(object);
+  }
+
+  auto stats = cache->getStats();
+  ASSERT_EQ(2, stats.shards.size());
+  uint64_t shardEvictionCount = 0;
+  for (const auto& shard : stats.shards) {
+    EXPECT_LE(shard.totalSizeInBytes, 5);
+    shardEvictionCount += shard.evictionCount;
+  }
+  EXPECT_LE(stats.totalSizeInBytes, 10);
+  EXPECT_EQ(stats.evictionCount, shardEvictionCount);
+  EXPECT_GT(stats.evictionCount, 0);
+}
+
+TEST(ObjectCache, sharded_cache_keeps_minimum_entry_in_each_shard) {
+  // The minimum entry count is rounded up per shard, so an object larger than
+  // the whole cache can still be cached no matter which shard it lands in.
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(10, 1, 4);
+  cache->insertSimple(object11);
+  EXPECT_TRUE(cache->contains(hash11));
+}
+
+TEST(ObjectCache, sharded_cache_interest_handle_drop_evicts) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::InterestHandle>::create(
+          100, 0, 4);
+  auto handle3 = cache->insertInterestHandle(
+      object3,
+      ObjectCache<CacheObject, ObjectCacheFlavor::InterestHandle>::Interest::
+          WantHandle);
+  cache->insertInterestHandle(object4);
+  EXPECT_TRUE(cache->contains(hash3));
+  handle3.reset();
+  EXPECT_FALSE(cache->contains(hash3));
+  EXPECT_TRUE(cache->contains(hash4));
+  EXPECT_EQ(1, cache->getStats().dropCount);
+}
+
+TEST(ObjectCache, sharded_cache_clear_empties_all_shards) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(100, 0, 4);
+  for (const auto& object : {object3, object3a, object3b, object3c}) {
+    cache->insertSimple(object);
+  }
+  cache->clear();
+  auto stats = cache->getStats();
+  EXPECT_EQ(0, stats.objectCount);
+  EXPECT_EQ(0, stats.totalSizeInBytes);
+  for (const auto& shard : stats.shards) {
+    EXPECT_EQ(0, shard.objectCount);
+  }
+}
+
+/**
+ * eviction policy test cases
+ */
+
+namespace {
+using PolicyCache = ObjectCache<CacheObject, ObjectCacheFlavor::Simple>;
+
+std::vector<std::shared_ptr<CacheObject>> makeObjects(
+    const std::string& prefix,
+    size_t count,
+    size_t size) {
+  std::vector<std::shared_ptr<CacheObject>> objects;
+  for (size_t i = 0; i < count; ++i) {
+    objects.push_back(std::make_shared<CacheObject>(
+        ObjectId::sha1(prefix + std::to_string(i)), size));
+  }
+  return objects;
+}
+
+/**
+ * Mimic ObjectStore: look the object up, and insert it after a miss.
+ */
+void access(PolicyCache& cache, const std::shared_ptr<CacheObject>& object) {
+  if (!cache.getSimple(object->getHash())) {
+    cache.insertSimple(object);
+  }
+}
+
+/**
+ * Access a hot working set a few times, then scan through many objects that
+ * are only read once. Returns how many of the hot objects are still cached.
+ */
+size_t hotObjectsSurvivingScan(CacheEvictionPolicy policy) {
+  auto cache = PolicyCache::create(100, 0, 1, policy);
+  auto hot = makeObjects("hot", 5, 10);
+  auto scan = makeObjects("scan", 50, 10);
+
+  for (int round = 0; round < 3; ++round) {
+    for (const auto& object : hot) {
+      access(*cache, object);
+    }
+  }
+  for (const auto& object : scan) {
+    access(*cache, object);
+  }
+
+  size_t surviving = 0;
+  for (const auto& object : hot) {
+    if (cache->contains(object->getHash())) {
+      ++surviving;
+    }
+  }
+  return surviving;
+}
+} // namespace
+
+TEST(ObjectCache, lru_policy_is_flushed_by_scan) {
+  EXPECT_EQ(0, hotObjectsSurvivingScan(CacheEvictionPolicy::LRU));
+}
+
+TEST(ObjectCache, slru_policy_protects_hot_objects_from_scan) {
+  EXPECT_EQ(5, hotObjectsSurvivingScan(CacheEvictionPolicy::SLRU));
+}
+
+TEST(ObjectCache, tinylfu_policy_protects_hot_objects_from_scan) {
+  EXPECT_EQ(5, hotObjectsSurvivingScan(CacheEvictionPolicy::TinyLFU));
+}
+
+TEST(ObjectCache, slru_policy_evicts_probation_before_protected) {
+  auto cache = PolicyCache::create(10, 0, 1, CacheEvictionPolicy::SLRU);
+  cache->insertSimple(object3);
+  // A hit promotes object3 to the protected segment.
+  EXPECT_EQ(object3, cache->getSimple(hash3));
+
+  cache->insertSimple(object3a);
+  cache->insertSimple(object3b);
+  cache->insertSimple(object3c);
+  cache->insertSimple(object4);
+
+  EXPECT_TRUE(cache->contains(hash3));
+  EXPECT_FALSE(cache->contains(hash3a));
+  EXPECT_FALSE(cache->contains(hash3b));
+  EXPECT_TRUE(cache->contains(hash3c));
+  EXPECT_TRUE(cache->contains(hash4));
+  EXPECT_LE(cache->getStats().totalSizeInBytes, 10);
+}
+
+TEST(ObjectCache, tinylfu_policy_keeps_size_bounded) {
+  auto cache = PolicyCache::create(100, 0, 1, CacheEvictionPolicy::TinyLFU);
+  for (const auto& object : makeObjects("object", 200, 7)) {
+    access(*cache, object);
+    EXPECT_LE(cache->getStats().totalSizeInBytes, 100);
+  }
+  EXPECT_GT(cache->getStats().evictionCount, 0);
+}
+
+TEST(ObjectCache, tinylfu_policy_keeps_newly_inserted_object) {
+  auto cache = PolicyCache::create(100, 0, 1, CacheEvictionPolicy::TinyLFU);
+  auto hot = makeObjects("hot", 10, 10);
+  for (int round = 0; round < 3; ++round) {
+    for (const auto& object : hot) {
+      access(*cache, object);
+    }
+  }
+
+  // Even though the cache is full of frequently accessed objects, the object
+  // that was just inserted can be read back.
+  cache->insertSimple(object9);
+  EXPECT_EQ(object9, cache->getSimple(hash9));
+}
+
+TEST(ObjectCache, policies_work_with_interest_handles) {
+  for (auto policy :
+       {CacheEvictionPolicy::LRU,
+        CacheEvictionPolicy::SLRU,
+        CacheEvictionPolicy::TinyLFU}) {
+    auto cache =
+        ObjectCache<CacheObject, ObjectCacheFlavor::InterestHandle>::create(
+            100, 0, 1, policy);
+    auto handle3 = cache->insertInterestHandle(
+        object3,
+        ObjectCache<CacheObject, ObjectCacheFlavor::InterestHandle>::Interest::
+            WantHandle);
+    cache->insertInterestHandle(object4);
+    // Promote object3 out of the window/probation segment before dropping.
+    EXPECT_EQ(object3, cache->getInterestHandle(hash3).object);
+    handle3.reset();
+    EXPECT_TRUE(cache->contains(hash3))
+        << "the LikelyNeededAgain lookup holds a reference";
+
+    auto handle5 = cache->insertInterestHandle(
+        object5,
+        ObjectCache<CacheObject, ObjectCacheFlavor::InterestHandle>::Interest::
+            WantHandle);
+    handle5.reset();
+    EXPECT_FALSE(cache->contains(hash5));
+    EXPECT_EQ(7, cache->getStats().totalSizeInBytes);
+  }
+}
+
+TEST(ObjectCache, hot_object_ids_are_most_recently_used_first) {
+  auto cache = PolicyCache::create(100, 0, 1, CacheEvictionPolicy::LRU);
+  cache->insertSimple(object3);
+  cache->insertSimple(object4);
+  cache->insertSimple(object5);
+  EXPECT_EQ(object3, cache->getSimple(hash3));
+
+  EXPECT_EQ(
+      (std::vector<ObjectId>{hash3, hash5, hash4}),
+      cache->getHotObjectIds(10));
+  EXPECT_EQ((std::vector<ObjectId>{hash3}), cache->getHotObjectIds(1));
+}
+
+TEST(ObjectCache, hot_object_ids_start_with_protected_objects) {
+  auto cache = PolicyCache::create(100, 0, 1, CacheEvictionPolicy::SLRU);
+  cache->insertSimple(object3);
+  cache->insertSimple(object4);
+  // A hit promotes object3 to the protected segment.
+  EXPECT_EQ(object3, cache->getSimple(hash3));
+  cache->insertSimple(object5);
+
+  EXPECT_EQ(hash3, cache->getHotObjectIds(10).at(0));
+}
+
+TEST(ObjectCache, hot_object_ids_interleave_shards) {
+  auto cache = PolicyCache::create(1000, 0, 4, CacheEvictionPolicy::LRU);
+  auto objects = makeObjects("object", 20, 1);
+  for (const auto& object : objects) {
+    cache->insertSimple(object);
+  }
+
+  auto ids = cache->getHotObjectIds(100);
+  EXPECT_EQ(20, ids.size());
+  EXPECT_EQ(5, cache->getHotObjectIds(5).size());
+}
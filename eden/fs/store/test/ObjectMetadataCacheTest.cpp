@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/ObjectMetadataCache.h"
+
+#include <folly/Conv.h>
+#include <folly/portability/GTest.h>
+#include <array>
+
+using namespace facebook::eden;
+
+namespace {
+
+ObjectId makeId(uint8_t n) {
+  std::array<uint8_t, Hash20::RAW_SIZE> bytes{};
+  bytes[0] = n;
+  return ObjectId{folly::ByteRange{bytes}};
+}
+
+BlobMetadata makeMetadata(uint64_t size) {
+  return BlobMetadata{Hash20::sha1(folly::to<std::string>(size)), size};
+}
+
+} // namespace
+
+TEST(ObjectMetadataCache, entriesAreSharedBetweenAccounts) {
+  auto cache = ObjectMetadataCache::create(16);
+  auto first = cache->addAccount();
+  auto second = cache->addAccount();
+
+  cache->putBlobMetadata(makeId(1), makeMetadata(10), *first);
+  auto found = cache->getBlobMetadata(makeId(1), *second);
+  ASSERT_TRUE(found);
+  EXPECT_EQ(10, found->size);
+
+  EXPECT_EQ(1, first->getChargedEntries());
+  EXPECT_EQ(0, second->getChargedEntries());
+  EXPECT_EQ(1, second->getSharedHits());
+  // Hits on its own entries aren't shared ones.
+  cache->getBlobMetadata(makeId(1), *first);
+  EXPECT_EQ(0, first->getSharedHits());
+}
+
+TEST(ObjectMetadataCache, cachedEntriesStayChargedToTheirFirstInserter) {
+  auto cache = ObjectMetadataCache::create(16);
+  auto first = cache->addAccount();
+  auto second = cache->addAccount();
+
+  auto digest = Hash20::sha1(folly::StringPiece{"tree"});
+  cache->putTreeDigest(makeId(1), digest, *first);
+  cache->putTreeDigest(makeId(1), digest, *second);
+
+  EXPECT_EQ(1, first->getChargedEntries());
+  EXPECT_EQ(0, second->getChargedEntries());
+  EXPECT_EQ(digest, cache->getTreeDigest(makeId(1), *second));
+}
+
+TEST(ObjectMetadataCache, evictionsUnchargeTheirOwner) {
+  auto cache = ObjectMetadataCache::create(2);
+  auto first = cache->addAccount();
+  auto second = cache->addAccount();
+
+  cache->putBlobMetadata(makeId(1), makeMetadata(1), *first);
+  cache->putBlobMetadata(makeId(2), makeMetadata(2), *first);
+  cache->putBlobMetadata(makeId(3), makeMetadata(3), *second);
+
+  EXPECT_FALSE(cache->hasBlobMetadata(makeId(1)));
+  EXPECT_EQ(1, first->getChargedEntries());
+  EXPECT_EQ(1, second->getChargedEntries());
+
+  cache->setMaxEntries(1);
+  EXPECT_EQ(1, cache->getMaxEntries());
+  EXPECT_EQ(0, first->getChargedEntries());
+  EXPECT_TRUE(cache->hasBlobMetadata(makeId(3)));
+}
+
+TEST(ObjectMetadataCache, batchLookupsKeepTheRequestOrder) {
+  auto cache = ObjectMetadataCache::create(16);
+  auto account = cache->addAccount();
+  cache->putBlobMetadata(makeId(2), makeMetadata(2), *account);
+
+  auto results =
+      cache->getBlobMetadataBatch({makeId(1), makeId(2), makeId(3)}, *account);
+  ASSERT_EQ(3, results.size());
+  EXPECT_FALSE(results[0]);
+  ASSERT_TRUE(results[1]);
+  EXPECT_EQ(2, results[1]->size);
+  EXPECT_FALSE(results[2]);
+}
+
+TEST(ObjectMetadataCache, entriesOutliveTheirAccount) {
+  auto cache = ObjectMetadataCache::create(16);
+  auto first = cache->addAccount();
+  cache->putBlobMetadata(makeId(1), makeMetadata(1), *first);
+  first.reset();
+
+  auto second = cache->addAccount();
+  EXPECT_TRUE(cache->getBlobMetadata(makeId(1), *second));
+  EXPECT_EQ(1, second->getSharedHits());
+}
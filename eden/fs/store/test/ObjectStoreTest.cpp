@@ -7,8 +7,10 @@
 
 #include <folly/portability/GTest.h>
 #include <folly/test/TestUtils.h>
+#include <thread>
 
 #include "eden/fs/model/TestOps.h"
+#include "eden/fs/store/BlobHasher.h"
 #include "eden/fs/store/LocalStoreCachedBackingStore.h"
 #include "eden/fs/store/MemoryLocalStore.h"
 #include "eden/fs/store/ObjectFetchContext.h"
@@ -139,6 +141,22 @@ TEST_F(ObjectStoreTest, getTree_tracks_second_read_from_local_store) {
   EXPECT_EQ(ObjectFetchContext::FromDiskCache, request.origin);
 }
 
+TEST_F(ObjectStoreTest, getRootTrees_returns_the_trees_in_order) {
+  auto* tree1 = fakeBackingStore->putTree({{"a", readyBlobId}});
+  auto* tree2 = fakeBackingStore->putTree({{"b", readyBlobId}});
+  tree1->setReady();
+  tree2->setReady();
+  fakeBackingStore->putCommit(RootId{"1"}, tree1)->setReady();
+  fakeBackingStore->putCommit(RootId{"2"}, tree2)->setReady();
+
+  std::vector<RootId> rootIds{RootId{"2"}, RootId{"1"}, RootId{"2"}};
+  auto trees = objectStore->getRootTrees(rootIds, context).get(0ms);
+  ASSERT_EQ(3, trees.size());
+  EXPECT_EQ(tree2->get().getHash(), trees[0]->getHash());
+  EXPECT_EQ(tree1->get().getHash(), trees[1]->getHash());
+  EXPECT_EQ(tree2->get().getHash(), trees[2]->getHash());
+}
+
 TEST_F(ObjectStoreTest, getBlobSize_tracks_backing_store_read) {
   objectStore->getBlobSize(readyBlobId, context).get(0ms);
   ASSERT_EQ(1, loggingContext->requests.size());
@@ -180,6 +198,33 @@ TEST_F(ObjectStoreTest, getBlobSizeFromLocalStore) {
   EXPECT_EQ(expectedSize, size);
 }
 
+#ifdef __linux__
+TEST_F(ObjectStoreTest, getBlob_moves_large_blobs_into_memfds) {
+  auto config = EdenConfig::createTestEdenConfig();
+  config->memfdBlobMinSize.setValue(8, ConfigSource::Default, true);
+  objectStore = ObjectStore::create(
+      localStore,
+      backingStore,
+      treeCache,
+      stats,
+      std::make_shared<ProcessNameCache>(),
+      std::make_shared<NullStructuredLogger>(),
+      std::move(config),
+      kPathMapDefaultCaseSensitive);
+
+  auto small = objectStore->getBlob(putReadyBlob("small"), context).get(0ms);
+  EXPECT_EQ(nullptr, small->getFile());
+
+  auto largeId = putReadyBlob("large contents");
+  auto large = objectStore->getBlob(largeId, context).get(0ms);
+  ASSERT_NE(nullptr, large->getFile());
+  EXPECT_EQ(largeId, large->getHash());
+  EXPECT_EQ(
+      "large contents",
+      large->getContents().cloneAsValue().moveToFbString().toStdString());
+}
+#endif
+
 TEST_F(ObjectStoreTest, getBlobSizeFromBackingStore) {
   auto data = "A"_sp;
   ObjectId id = putReadyBlob(data);
@@ -223,6 +268,59 @@ TEST_F(ObjectStoreTest, get_size_and_sha1_only_imports_blob_once) {
   EXPECT_EQ(1, fakeBackingStore->getAccessCount(readyBlobId));
 }
 
+TEST_F(ObjectStoreTest, getBlobMetadataBatch) {
+  auto cachedId = putReadyBlob("cached");
+  auto storedId = putReadyBlob("stored");
+  auto fetchedId = putReadyBlob("fetched");
+  objectStore->getBlobMetadata(cachedId, context).get(0ms);
+  localStore->putBlobMetadata(
+      storedId, BlobMetadata{Hash20::sha1("stored"_sp), 6});
+
+  auto results =
+      objectStore
+          ->getBlobMetadataBatch(
+              {fetchedId, ObjectId{}, storedId, cachedId}, context)
+          .get(0ms);
+  ASSERT_EQ(4, results.size());
+  EXPECT_EQ(Hash20::sha1("fetched"_sp), results[0].value().sha1);
+  EXPECT_THROW_RE(results[1].value(), std::domain_error, "blob .* not found");
+  EXPECT_EQ(Hash20::sha1("stored"_sp), results[2].value().sha1);
+  EXPECT_EQ(6, results[3].value().size);
+
+  // The blob with metadata in the LocalStore wasn't imported.
+  EXPECT_EQ(0, fakeBackingStore->getAccessCount(storedId));
+  EXPECT_EQ(1, fakeBackingStore->getAccessCount(cachedId));
+}
+
+TEST_F(ObjectStoreTest, getBlobSha1HashedByBlobHasher) {
+  objectStore->setBlobHasher(std::make_shared<BlobHasher>(2));
+  auto data = "A"_sp;
+  ObjectId id = putReadyBlob(data);
+
+  EXPECT_EQ(Hash20::sha1(data), objectStore->getBlobSha1(id, context).get());
+  EXPECT_EQ(1, objectStore->getBlobSize(id, context).get(0ms));
+  EXPECT_EQ(1, fakeBackingStore->getAccessCount(id));
+}
+
+TEST_F(ObjectStoreTest, getBlobHashesInBackgroundWithBlobHasher) {
+  objectStore->setBlobHasher(std::make_shared<BlobHasher>(1));
+  auto data = "background"_sp;
+  ObjectId id = putReadyBlob(data);
+
+  objectStore->getBlob(id, context).get(0ms);
+
+  std::optional<BlobMetadata> metadata;
+  for (int i = 0; i < 10000 && !metadata; ++i) {
+    metadata = localStore->getBlobMetadata(id).get();
+    if (!metadata) {
+      std::this_thread::sleep_for(1ms);
+    }
+  }
+  ASSERT_TRUE(metadata.has_value());
+  EXPECT_EQ(Hash20::sha1(data), metadata->sha1);
+  EXPECT_EQ(data.size(), metadata->size);
+}
+
 class PidFetchContext final : public ObjectFetchContext {
  public:
   PidFetchContext(pid_t pid) : ObjectFetchContext{}, pid_{pid} {}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/PathFilter.h"
+
+#include <folly/portability/GTest.h>
+#include <stdexcept>
+
+using namespace facebook::eden;
+using namespace facebook::eden::path_literals;
+using namespace folly::string_piece_literals;
+
+TEST(PathFilter, emptyFilterShowsEverything) {
+  auto filter = PathFilter::parse("# nothing\n\n"_sp);
+  EXPECT_TRUE(filter.empty());
+  EXPECT_EQ("", filter.getId());
+  EXPECT_FALSE(filter.isHidden("a/b"_relpath));
+  EXPECT_FALSE(filter.mayHideUnder(""_relpath));
+}
+
+TEST(PathFilter, excludesHidePathsAndEverythingUnderThem) {
+  auto filter = PathFilter::parse("[exclude]\nfoo/bar\n"_sp);
+  EXPECT_TRUE(filter.isHidden("foo/bar"_relpath));
+  EXPECT_TRUE(filter.isHidden("foo/bar/baz"_relpath));
+  EXPECT_FALSE(filter.isHidden("foo/barn"_relpath));
+  EXPECT_FALSE(filter.isHidden("foo"_relpath));
+
+  EXPECT_TRUE(filter.mayHideUnder(""_relpath));
+  EXPECT_TRUE(filter.mayHideUnder("foo"_relpath));
+  EXPECT_FALSE(filter.mayHideUnder("other"_relpath));
+}
+
+TEST(PathFilter, rulesBeforeAnySectionAreExcludes) {
+  EXPECT_EQ(
+      PathFilter::parse("foo\n"_sp).getId(),
+      PathFilter::parse("[exclude]\nfoo\n"_sp).getId());
+}
+
+TEST(PathFilter, includesHideEverythingElse) {
+  auto filter = PathFilter::parse(
+      "[include]\nfbcode/eden\n[exclude]\nfbcode/eden/website\n"_sp);
+  EXPECT_FALSE(filter.isHidden("fbcode"_relpath));
+  EXPECT_FALSE(filter.isHidden("fbcode/eden"_relpath));
+  EXPECT_FALSE(filter.isHidden("fbcode/eden/fs/main.cpp"_relpath));
+  EXPECT_TRUE(filter.isHidden("fbcode/folly"_relpath));
+  EXPECT_TRUE(filter.isHidden("www"_relpath));
+  EXPECT_TRUE(filter.isHidden("fbcode/eden/website"_relpath));
+
+  EXPECT_TRUE(filter.mayHideUnder("fbcode"_relpath));
+  EXPECT_TRUE(filter.mayHideUnder("fbcode/eden"_relpath));
+  EXPECT_FALSE(filter.mayHideUnder("fbcode/eden/fs"_relpath));
+}
+
+TEST(PathFilter, globs) {
+  auto filter = PathFilter::parse("[exclude]\nglob:**/*.png\n"_sp);
+  EXPECT_TRUE(filter.isHidden("a/b/logo.png"_relpath));
+  EXPECT_FALSE(filter.isHidden("a/b/logo.svg"_relpath));
+  EXPECT_TRUE(filter.mayHideUnder("a/b"_relpath));
+
+  auto scoped = PathFilter::parse("[exclude]\nglob:docs/*.md\n"_sp);
+  EXPECT_TRUE(scoped.isHidden("docs/README.md"_relpath));
+  EXPECT_FALSE(scoped.isHidden("README.md"_relpath));
+  EXPECT_TRUE(scoped.mayHideUnder("docs"_relpath));
+  EXPECT_FALSE(scoped.mayHideUnder("src"_relpath));
+}
+
+TEST(PathFilter, equivalentFiltersHaveTheSameId) {
+  auto one = PathFilter::parse("[include]\nb\na\n# comment\n"_sp);
+  auto two = PathFilter::parse("[include]\n a \nb\nb\n"_sp);
+  EXPECT_EQ(8, one.getId().size());
+  EXPECT_EQ(one.getId(), two.getId());
+  EXPECT_EQ(one.serialize(), two.serialize());
+  EXPECT_EQ(one.getId(), PathFilter::parse(one.serialize()).getId());
+
+  EXPECT_NE(one.getId(), PathFilter::parse("[exclude]\nb\na\n"_sp).getId());
+}
+
+TEST(PathFilter, invalidRulesAreRejected) {
+  EXPECT_THROW(
+      PathFilter::parse("[exclude]\n/abs\n"_sp), std::invalid_argument);
+  EXPECT_THROW(
+      PathFilter::parse("[exclude]\na/../b\n"_sp), std::invalid_argument);
+  EXPECT_THROW(
+      PathFilter::parse("[include]\nglob:[\n"_sp), std::invalid_argument);
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/PathLoader.h"
+
+#include <folly/portability/GTest.h>
+#include <algorithm>
+
+#include "eden/common/utils/ProcessNameCache.h"
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/store/TreeCache.h"
+#include "eden/fs/telemetry/NullStructuredLogger.h"
+#include "eden/fs/testharness/FakeBackingStore.h"
+#include "eden/fs/testharness/FakeTreeBuilder.h"
+#include "eden/fs/testharness/LoggingFetchContext.h"
+
+using namespace facebook::eden;
+using namespace facebook::eden::path_literals;
+using namespace std::chrono_literals;
+
+namespace {
+
+struct PathLoaderTest : ::testing::Test {
+  void SetUp() override {
+    auto edenConfig = std::make_shared<ReloadableConfig>(
+        EdenConfig::createTestEdenConfig(), ConfigReloadBehavior::NoReload);
+    backingStore = std::make_shared<FakeBackingStore>();
+    objectStore = ObjectStore::create(
+        std::make_shared<MemoryLocalStore>(),
+        backingStore,
+        TreeCache::create(edenConfig),
+        std::make_shared<EdenStats>(),
+        std::make_shared<ProcessNameCache>(),
+        std::make_shared<NullStructuredLogger>(),
+        EdenConfig::createTestEdenConfig(),
+        kPathMapDefaultCaseSensitive);
+  }
+
+  size_t countTreeFetches(const ObjectId& id) const {
+    return std::count_if(
+        loggingContext->requests.begin(),
+        loggingContext->requests.end(),
+        [&](const auto& request) {
+          return request.type == ObjectFetchContext::Tree &&
+              request.hash == id;
+        });
+  }
+
+  RefPtr<LoggingFetchContext> loggingContext =
+      makeRefPtr<LoggingFetchContext>();
+  const ObjectFetchContextPtr& context =
+      loggingContext.as<ObjectFetchContext>();
+  std::shared_ptr<FakeBackingStore> backingStore;
+  std::shared_ptr<ObjectStore> objectStore;
+};
+
+} // namespace
+
+TEST_F(PathLoaderTest, resolveTreeEntriesWalksSharedDirectoriesOnce) {
+  FakeTreeBuilder builder;
+  builder.setFile("dir/sub/a.txt", "a");
+  builder.setFile("dir/sub/b.txt", "b");
+  builder.setFile("dir/c.txt", "c");
+  auto* root = builder.finalize(backingStore, true);
+  auto dirId = builder.getStoredTree("dir"_relpath)->get().getHash();
+  auto subId = builder.getStoredTree("dir/sub"_relpath)->get().getHash();
+
+  std::vector<RelativePath> paths{
+      RelativePath{"dir/sub/a.txt"},
+      RelativePath{"dir/sub/b.txt"},
+      RelativePath{"dir/c.txt"},
+      RelativePath{"dir/sub"},
+      RelativePath{"dir/missing.txt"},
+      RelativePath{"dir/c.txt/d.txt"},
+      RelativePath{}};
+  auto results = resolveTreeEntries(
+                     *objectStore,
+                     context,
+                     std::make_shared<const Tree>(root->get()),
+                     paths)
+                     .get(0ms);
+
+  ASSERT_EQ(paths.size(), results.size());
+  EXPECT_EQ(TreeEntryType::REGULAR_FILE, results[0].value().getType());
+  EXPECT_EQ(TreeEntryType::REGULAR_FILE, results[1].value().getType());
+  EXPECT_EQ(TreeEntryType::REGULAR_FILE, results[2].value().getType());
+  EXPECT_EQ(subId, results[3].value().getHash());
+  EXPECT_TRUE(results[4].hasException());
+  EXPECT_TRUE(results[5].hasException());
+  EXPECT_TRUE(results[6].hasException());
+
+  EXPECT_EQ(1, countTreeFetches(dirId));
+  EXPECT_EQ(1, countTreeFetches(subId));
+}
@@ -12,6 +12,7 @@
 namespace {
 
 using namespace facebook::eden;
+using namespace folly::string_piece_literals;
 
 LocalStoreImplResult makeRocksDbLocalStore(FaultInjector* faultInjector) {
   auto tempDir = makeTempDir();
@@ -22,6 +23,41 @@ LocalStoreImplResult makeRocksDbLocalStore(FaultInjector* faultInjector) {
   return {std::move(tempDir), std::move(store)};
 }
 
+LocalStoreImplResult makeUntunedRocksDbLocalStore(
+    FaultInjector* faultInjector) {
+  RocksDbTuning tuning;
+  tuning.enableBlobFiles = false;
+  tuning.smallValueFilterBitsPerKey = 0;
+  tuning.smallValueCompression = LocalStoreCompression::Snappy;
+  auto tempDir = makeTempDir();
+  auto store = std::make_unique<RocksDbLocalStore>(
+      canonicalPath(tempDir.path().string()),
+      std::make_shared<NullStructuredLogger>(),
+      faultInjector,
+      RocksDBOpenMode::ReadWrite,
+      tuning);
+  return {std::move(tempDir), std::move(store)};
+}
+
+TEST(RocksDbLocalStoreTest, largeValuesRoundTripThroughBlobFiles) {
+  FaultInjector faultInjector{/*enabled=*/false};
+  auto tempDir = makeTempDir();
+  auto store = std::make_shared<RocksDbLocalStore>(
+      canonicalPath(tempDir.path().string()),
+      std::make_shared<NullStructuredLogger>(),
+      &faultInjector);
+  store->open();
+
+  std::string large(64 * 1024, 'x');
+  store->put(KeySpace::BlobFamily, "large"_sp, folly::StringPiece{large});
+  store->put(KeySpace::BlobFamily, "small"_sp, "small"_sp);
+  // Make RocksDB write the values out of the memtable.
+  store->compactKeySpace(KeySpace::BlobFamily);
+
+  EXPECT_EQ(large, store->get(KeySpace::BlobFamily, "large"_sp).piece());
+  EXPECT_EQ("small", store->get(KeySpace::BlobFamily, "small"_sp).piece());
+}
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wdeprecated-declarations"
 INSTANTIATE_TEST_CASE_P(
@@ -29,6 +65,11 @@ INSTANTIATE_TEST_CASE_P(
     LocalStoreTest,
     ::testing::Values(makeRocksDbLocalStore));
 
+INSTANTIATE_TEST_CASE_P(
+    UntunedRocksDB,
+    LocalStoreTest,
+    ::testing::Values(makeUntunedRocksDbLocalStore));
+
 INSTANTIATE_TEST_CASE_P(
     RocksDB,
     OpenCloseLocalStoreTest,
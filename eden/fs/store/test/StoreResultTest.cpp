@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/StoreResult.h"
+
+#include <folly/io/IOBuf.h>
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/model/Hash.h"
+#include "eden/fs/store/KeySpace.h"
+
+using namespace facebook::eden;
+using folly::IOBuf;
+
+TEST(StoreResult, iobufDataIsNotCopied) {
+  auto buf = IOBuf::copyBuffer("payload");
+  const auto* data = buf->data();
+  StoreResult result{std::move(*buf)};
+
+  ASSERT_TRUE(result.isValid());
+  EXPECT_EQ("payload", result.piece());
+  EXPECT_EQ(data, result.bytes().data());
+
+  auto extracted = result.extractIOBuf();
+  EXPECT_EQ(data, extracted.data());
+  EXPECT_EQ(7, extracted.length());
+}
+
+TEST(StoreResult, chainedIOBufIsCoalesced) {
+  auto buf = IOBuf::copyBuffer("pay");
+  buf->prependChain(IOBuf::copyBuffer("load"));
+  StoreResult result{std::move(*buf)};
+  EXPECT_EQ("payload", result.piece());
+}
+
+TEST(StoreResult, iobufResultsCanBeExtractedAsStrings) {
+  StoreResult result{std::move(*IOBuf::copyBuffer("payload"))};
+  EXPECT_EQ("payload", result.extractValue());
+  EXPECT_FALSE(result.isValid());
+}
+
+TEST(StoreResult, movingIOBufResults) {
+  StoreResult result{std::move(*IOBuf::copyBuffer("payload"))};
+  StoreResult moved{std::move(result)};
+  EXPECT_FALSE(result.isValid());
+  EXPECT_EQ("payload", moved.piece());
+
+  auto missing =
+      StoreResult::missing(KeySpace::BlobFamily, kEmptySha1.getBytes());
+  missing = std::move(moved);
+  EXPECT_EQ("payload", missing.piece());
+}
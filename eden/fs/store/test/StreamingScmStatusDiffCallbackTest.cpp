@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/StreamingScmStatusDiffCallback.h"
+
+#include <atomic>
+#include <thread>
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+RelativePathPiece path(folly::StringPiece p) {
+  return RelativePathPiece{p};
+}
+} // namespace
+
+TEST(StreamingScmStatusDiffCallback, entriesAreHandedOutInChunks) {
+  StreamingScmStatusDiffCallback callback{2, 8};
+  callback.addedPath(path("a"), dtype_t::Regular);
+  callback.addedPath(path("dir"), dtype_t::Dir);
+  callback.modifiedPath(path("b"), dtype_t::Regular);
+  callback.removedPath(path("c"), dtype_t::Symlink);
+
+  auto first = callback.next();
+  ASSERT_TRUE(first.isReady());
+  auto chunk = std::move(first).get();
+  ASSERT_TRUE(chunk.has_value());
+  EXPECT_EQ(2, chunk->entries()->size());
+  EXPECT_EQ(ScmFileStatus::ADDED, chunk->entries()->at("a"));
+  EXPECT_EQ(ScmFileStatus::MODIFIED, chunk->entries()->at("b"));
+
+  // The partial chunk is only handed out once the diff finished.
+  auto second = callback.next();
+  EXPECT_FALSE(second.isReady());
+  callback.finish();
+  ASSERT_TRUE(second.isReady());
+  chunk = std::move(second).get();
+  ASSERT_TRUE(chunk.has_value());
+  EXPECT_EQ(ScmFileStatus::REMOVED, chunk->entries()->at("c"));
+
+  EXPECT_FALSE(callback.next().get().has_value());
+}
+
+TEST(StreamingScmStatusDiffCallback, errorsAreReported) {
+  StreamingScmStatusDiffCallback callback{16, 8};
+  callback.diffError(
+      path("x"), folly::make_exception_wrapper<std::runtime_error>("oops"));
+  callback.finish(folly::make_exception_wrapper<std::runtime_error>("failed"));
+
+  auto chunk = callback.next().get();
+  ASSERT_TRUE(chunk.has_value());
+  EXPECT_EQ(1, chunk->errors()->size());
+  EXPECT_THROW(callback.next().get(), std::runtime_error);
+}
+
+TEST(StreamingScmStatusDiffCallback, diffBlocksWhileChunksArePending) {
+  StreamingScmStatusDiffCallback callback{1, 2};
+  std::atomic<size_t> reported{0};
+  std::thread diff{[&] {
+    for (auto name : {"a", "b", "c", "d"}) {
+      callback.addedPath(path(name), dtype_t::Regular);
+      ++reported;
+    }
+    callback.finish();
+  }};
+
+  // The diff waits once two chunks are queued.
+  std::this_thread::sleep_for(100ms);
+  EXPECT_EQ(1, reported.load());
+
+  size_t chunks = 0;
+  while (auto chunk = callback.next().get()) {
+    ++chunks;
+  }
+  diff.join();
+  EXPECT_EQ(4, chunks);
+  EXPECT_EQ(4, reported.load());
+}
+
+TEST(StreamingScmStatusDiffCallback, cancelUnblocksTheDiff) {
+  StreamingScmStatusDiffCallback callback{1, 1};
+  std::thread diff{[&] {
+    for (auto name : {"a", "b", "c"}) {
+      callback.addedPath(path(name), dtype_t::Regular);
+    }
+  }};
+  std::this_thread::sleep_for(50ms);
+  callback.cancel();
+  diff.join();
+  EXPECT_FALSE(callback.next().get().has_value());
+}
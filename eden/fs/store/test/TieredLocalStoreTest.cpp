@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/TieredLocalStore.h"
+#include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/store/StoreResult.h"
+#include "eden/fs/store/test/LocalStoreTest.h"
+
+namespace {
+
+using namespace facebook::eden;
+using namespace folly::string_piece_literals;
+
+LocalStoreImplResult makeTieredLocalStore(FaultInjector*) {
+  return {
+      std::nullopt,
+      std::make_shared<TieredLocalStore>(
+          std::make_shared<MemoryLocalStore>(), 1024, 16)};
+}
+
+class TieredLocalStoreTest : public ::testing::Test {
+ protected:
+  std::shared_ptr<MemoryLocalStore> disk_{
+      std::make_shared<MemoryLocalStore>()};
+  std::shared_ptr<TieredLocalStore> store_{
+      std::make_shared<TieredLocalStore>(disk_, 1024, 1000)};
+};
+
+TEST_F(TieredLocalStoreTest, ephemeralSmallValuesAreWrittenBack) {
+  store_->put(KeySpace::BlobMetaDataFamily, "key"_sp, "metadata"_sp);
+  EXPECT_EQ(1, store_->getPendingWriteCount());
+  EXPECT_FALSE(disk_->hasKey(KeySpace::BlobMetaDataFamily, "key"_sp));
+  EXPECT_EQ(
+      "metadata",
+      store_->get(KeySpace::BlobMetaDataFamily, "key"_sp).piece());
+
+  store_->flushPendingWrites();
+  EXPECT_EQ(0, store_->getPendingWriteCount());
+  EXPECT_EQ(
+      "metadata", disk_->get(KeySpace::BlobMetaDataFamily, "key"_sp).piece());
+}
+
+TEST_F(TieredLocalStoreTest, persistentValuesAreWrittenThrough) {
+  store_->put(KeySpace::HgProxyHashFamily, "key"_sp, "proxy"_sp);
+  EXPECT_EQ(0, store_->getPendingWriteCount());
+  EXPECT_EQ(
+      "proxy", disk_->get(KeySpace::HgProxyHashFamily, "key"_sp).piece());
+
+  auto batch = store_->beginWrite();
+  batch->put(KeySpace::HgProxyHashFamily, "batched"_sp, "proxy"_sp);
+  batch->flush();
+  EXPECT_TRUE(disk_->hasKey(KeySpace::HgProxyHashFamily, "batched"_sp));
+}
+
+TEST_F(TieredLocalStoreTest, hotValuesAreServedFromMemory) {
+  disk_->put(KeySpace::HgProxyHashFamily, "key"_sp, "proxy"_sp);
+  EXPECT_EQ(
+      "proxy", store_->get(KeySpace::HgProxyHashFamily, "key"_sp).piece());
+
+  // The value was loaded in the hot tier, the on-disk store isn't consulted.
+  disk_->clearKeySpace(KeySpace::HgProxyHashFamily);
+  EXPECT_EQ(
+      "proxy", store_->get(KeySpace::HgProxyHashFamily, "key"_sp).piece());
+  auto results =
+      store_->getBatch(KeySpace::HgProxyHashFamily, {"key"_sp, "missing"_sp})
+          .get();
+  ASSERT_EQ(2, results.size());
+  EXPECT_EQ("proxy", results[0].piece());
+  EXPECT_FALSE(results[1].isValid());
+}
+
+TEST_F(TieredLocalStoreTest, otherKeySpacesBypassTheHotTier) {
+  store_->put(KeySpace::BlobFamily, "key"_sp, "contents"_sp);
+  EXPECT_EQ(0, store_->getPendingWriteCount());
+  disk_->clearKeySpace(KeySpace::BlobFamily);
+  EXPECT_FALSE(store_->hasKey(KeySpace::BlobFamily, "key"_sp));
+}
+
+TEST_F(TieredLocalStoreTest, pendingWritesAreFlushedInTheBackground) {
+  auto store = std::make_shared<TieredLocalStore>(disk_, 1024, 2);
+  store->put(KeySpace::BlobMetaDataFamily, "key1"_sp, "metadata"_sp);
+  store->put(KeySpace::BlobMetaDataFamily, "key2"_sp, "metadata"_sp);
+  // close() waits for the writes that were not written back yet.
+  store->close();
+  EXPECT_TRUE(disk_->hasKey(KeySpace::BlobMetaDataFamily, "key1"_sp));
+  EXPECT_TRUE(disk_->hasKey(KeySpace::BlobMetaDataFamily, "key2"_sp));
+}
+
+TEST_F(TieredLocalStoreTest, clearKeySpaceDropsHotAndPendingValues) {
+  store_->put(KeySpace::BlobMetaDataFamily, "key"_sp, "metadata"_sp);
+  store_->put(KeySpace::TreeDigestFamily, "key"_sp, "digest"_sp);
+  store_->clearKeySpace(KeySpace::BlobMetaDataFamily);
+  EXPECT_FALSE(store_->hasKey(KeySpace::BlobMetaDataFamily, "key"_sp));
+  EXPECT_TRUE(store_->hasKey(KeySpace::TreeDigestFamily, "key"_sp));
+  EXPECT_EQ(1, store_->getPendingWriteCount());
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+INSTANTIATE_TEST_CASE_P(
+    Tiered,
+    LocalStoreTest,
+    ::testing::Values(makeTieredLocalStore));
+
+INSTANTIATE_TEST_CASE_P(
+    Tiered,
+    OpenCloseLocalStoreTest,
+    ::testing::Values(makeTieredLocalStore));
+#pragma clang diagnostic pop
+
+} // namespace
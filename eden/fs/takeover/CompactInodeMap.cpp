@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/takeover/CompactInodeMap.h"
+
+#include <folly/Varint.h>
+#include <algorithm>
+#include <stdexcept>
+
+#include "eden/fs/utils/Throw.h"
+
+namespace facebook::eden {
+
+namespace {
+/**
+ * The unloaded inodes are encoded as:
+ * - number of entries (varint)
+ * - for each entry:
+ *   - inode number, parent inode number (zigzag varints)
+ *   - name length (varint), then name
+ *   - flags (1 byte), a combination of the values below
+ *   - number of FS references, mode (zigzag varints)
+ *   - if kHasHash is set: hash length (varint), then hash
+ */
+constexpr uint8_t kIsUnlinked = 1 << 0;
+constexpr uint8_t kHasHash = 1 << 1;
+
+// Rough size of an entry, excluding its name and hash.
+constexpr size_t kEntrySizeEstimate = 16;
+
+void appendVarint(std::string& out, uint64_t value) {
+  uint8_t buf[folly::kMaxVarintLength64];
+  auto size = folly::encodeVarint(value, buf);
+  out.append(reinterpret_cast<const char*>(buf), size);
+}
+
+void appendBytes(std::string& out, folly::StringPiece bytes) {
+  appendVarint(out, bytes.size());
+  out.append(bytes.data(), bytes.size());
+}
+
+uint64_t readVarint(folly::ByteRange& data) {
+  auto value = folly::tryDecodeVarint(data);
+  if (value.hasError()) {
+    throw std::runtime_error("truncated or malformed compact inode map");
+  }
+  return value.value();
+}
+
+int64_t readSignedVarint(folly::ByteRange& data) {
+  return folly::decodeZigZag(readVarint(data));
+}
+
+std::string readBytes(folly::ByteRange& data) {
+  auto size = readVarint(data);
+  if (size > data.size()) {
+    throwf<std::runtime_error>(
+        "compact inode map truncated: expected {} bytes, {} left",
+        size,
+        data.size());
+  }
+  std::string bytes{reinterpret_cast<const char*>(data.data()), size};
+  data.advance(size);
+  return bytes;
+}
+} // namespace
+
+std::string encodeUnloadedInodes(
+    const std::vector<SerializedInodeMapEntry>& entries) {
+  size_t sizeEstimate = folly::kMaxVarintLength64;
+  for (const auto& entry : entries) {
+    sizeEstimate += kEntrySizeEstimate + entry.name_ref()->size();
+    if (entry.hash_ref().has_value()) {
+      sizeEstimate += entry.hash_ref()->size();
+    }
+  }
+
+  std::string out;
+  out.reserve(sizeEstimate);
+  appendVarint(out, entries.size());
+  for (const auto& entry : entries) {
+    appendVarint(out, folly::encodeZigZag(*entry.inodeNumber_ref()));
+    appendVarint(out, folly::encodeZigZag(*entry.parentInode_ref()));
+    appendBytes(out, *entry.name_ref());
+
+    uint8_t flags = 0;
+    if (*entry.isUnlinked_ref()) {
+      flags |= kIsUnlinked;
+    }
+    if (entry.hash_ref().has_value()) {
+      flags |= kHasHash;
+    }
+    out.push_back(static_cast<char>(flags));
+
+    appendVarint(out, folly::encodeZigZag(*entry.numFsReferences_ref()));
+    appendVarint(out, folly::encodeZigZag(*entry.mode_ref()));
+    if (entry.hash_ref().has_value()) {
+      appendBytes(out, *entry.hash_ref());
+    }
+  }
+  return out;
+}
+
+std::vector<SerializedInodeMapEntry> decodeUnloadedInodes(
+    folly::ByteRange data) {
+  auto count = readVarint(data);
+  std::vector<SerializedInodeMapEntry> entries;
+  // Every entry takes at least 6 bytes, don't trust larger counts.
+  entries.reserve(std::min<uint64_t>(count, data.size() / 6));
+  for (uint64_t i = 0; i < count; ++i) {
+    SerializedInodeMapEntry entry;
+    entry.inodeNumber_ref() = readSignedVarint(data);
+    entry.parentInode_ref() = readSignedVarint(data);
+    entry.name_ref() = readBytes(data);
+
+    if (data.empty()) {
+      throw std::runtime_error("truncated compact inode map");
+    }
+    auto flags = data.front();
+    data.advance(1);
+    entry.isUnlinked_ref() = (flags & kIsUnlinked) != 0;
+
+    entry.numFsReferences_ref() = readSignedVarint(data);
+    entry.mode_ref() = static_cast<int32_t>(readSignedVarint(data));
+    if (flags & kHasHash) {
+      entry.hash_ref() = readBytes(data);
+    }
+    entries.push_back(std::move(entry));
+  }
+  if (!data.empty()) {
+    throwf<std::runtime_error>(
+        "{} unexpected trailing bytes in compact inode map", data.size());
+  }
+  return entries;
+}
+
+} // namespace facebook::eden
+
+#endif
@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <string>
+#include <vector>
+
+#include "eden/fs/takeover/gen-cpp2/takeover_types.h"
+
+namespace facebook::eden {
+
+/**
+ * Encodes the unloaded inodes of a SerializedInodeMap much more densely than
+ * the thrift list, and much faster: every integer is a varint and every entry
+ * is a few bytes plus its name and hash.
+ *
+ * This is what is sent during a graceful takeover when both processes
+ * support TakeoverCapabilities::COMPACT_INODE_MAP, as mounts with millions of
+ * unloaded inodes would otherwise spend seconds in thrift serialization while
+ * the filesystem is unavailable.
+ */
+std::string encodeUnloadedInodes(
+    const std::vector<SerializedInodeMapEntry>& entries);
+
+/**
+ * Decodes the output of encodeUnloadedInodes(). Throws std::runtime_error if
+ * the data is truncated or malformed.
+ */
+std::vector<SerializedInodeMapEntry> decodeUnloadedInodes(
+    folly::ByteRange data);
+
+} // namespace facebook::eden
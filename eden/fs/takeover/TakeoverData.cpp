@@ -9,17 +9,21 @@
 
 #include "eden/fs/takeover/TakeoverData.h"
 
+#include <atomic>
 #include <memory>
 #include <stdexcept>
+#include <thread>
 #include <variant>
 
 #include <fmt/format.h>
+#include <folly/Function.h>
 #include <folly/io/IOBuf.h>
 #include <folly/logging/xlog.h>
 #include "folly/Likely.h"
 
 #include <thrift/lib/cpp2/protocol/Serializer.h>
 
+#include "eden/fs/takeover/CompactInodeMap.h"
 #include "eden/fs/utils/Bug.h"
 #include "eden/fs/utils/Throw.h"
 #include "eden/fs/utils/UnixSocket.h"
@@ -48,6 +52,50 @@ TakeoverMountProtocol getMountProtocol(
       mountInfo.mountPath);
 }
 
+/**
+ * Calls fn with each index in [0, count), spread over as many threads as
+ * there are cores, and rethrows the first exception thrown by fn.
+ *
+ * The inode maps of the mounts are independent, with millions of inodes
+ * each they take long enough to encode and decode that it is worth doing so
+ * concurrently while the filesystem is unavailable.
+ */
+void parallelFor(size_t count, folly::FunctionRef<void(size_t)> fn) {
+  size_t numThreads = std::min<size_t>(
+      count, std::max<size_t>(std::thread::hardware_concurrency(), 1));
+  if (numThreads == 0) {
+    return;
+  }
+
+  std::atomic<size_t> next{0};
+  std::vector<folly::exception_wrapper> errors(numThreads);
+  auto work = [&](size_t thread) {
+    try {
+      for (size_t index = next++; index < count; index = next++) {
+        fn(index);
+      }
+    } catch (...) {
+      errors[thread] = folly::exception_wrapper{std::current_exception()};
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(numThreads - 1);
+  for (size_t thread = 1; thread < numThreads; ++thread) {
+    threads.emplace_back(work, thread);
+  }
+  work(0);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (auto& error : errors) {
+    if (error) {
+      error.throw_exception();
+    }
+  }
+}
+
 } // namespace
 
 const std::set<int32_t> kSupportedTakeoverVersions{
@@ -63,7 +111,8 @@ const uint64_t kSupportedCapabilities = TakeoverCapabilities::FUSE |
     TakeoverCapabilities::RESULT_TYPE_SERIALIZATION |
     TakeoverCapabilities::ORDERED_FDS | TakeoverCapabilities::OPTIONAL_MOUNTD |
     TakeoverCapabilities::CAPABILITY_MATCHING |
-    TakeoverCapabilities::INCLUDE_HEADER_SIZE;
+    TakeoverCapabilities::INCLUDE_HEADER_SIZE |
+    TakeoverCapabilities::COMPACT_INODE_MAP;
 
 std::optional<int32_t> TakeoverData::computeCompatibleVersion(
     const std::set<int32_t>& versions,
@@ -184,7 +233,9 @@ int32_t TakeoverData::capabilitesToVersion(uint64_t capabilities) {
     return kTakeoverProtocolVersionSix;
   }
 
-  if (capabilities ==
+  // Capabilities added after version seven are sent in its header, they
+  // don't need a version of their own.
+  if ((capabilities & ~TakeoverCapabilities::COMPACT_INODE_MAP) ==
       (TakeoverCapabilities::FUSE | TakeoverCapabilities::MOUNT_TYPES |
        TakeoverCapabilities::PING | TakeoverCapabilities::THRIFT_SERIALIZATION |
        TakeoverCapabilities::NFS |
@@ -543,13 +594,30 @@ IOBuf TakeoverData::serializeThrift(uint64_t protocolCapabilities) {
           sizeof(fuseChannelInfo->connInfo)};
     }
 
-    *serializedMount.inodeMap_ref() = mount.inodeMap;
+    if (!(protocolCapabilities & TakeoverCapabilities::COMPACT_INODE_MAP)) {
+      *serializedMount.inodeMap_ref() = mount.inodeMap;
+    }
 
     serializedMount.mountProtocol_ref() = mountProtocol;
 
     serializedMounts.emplace_back(std::move(serializedMount));
   }
 
+  if (protocolCapabilities & TakeoverCapabilities::COMPACT_INODE_MAP) {
+    std::vector<size_t> mountsWithInodes;
+    for (size_t index = 0; index < mountPoints.size(); ++index) {
+      if (!mountPoints[index].inodeMap.unloadedInodes_ref()->empty()) {
+        mountsWithInodes.push_back(index);
+      }
+    }
+    parallelFor(mountsWithInodes.size(), [&](size_t n) {
+      auto index = mountsWithInodes[n];
+      serializedMounts[index].inodeMap_ref()->compactUnloadedInodes_ref() =
+          encodeUnloadedInodes(
+              *mountPoints[index].inodeMap.unloadedInodes_ref());
+    });
+  }
+
   if (protocolCapabilities & TakeoverCapabilities::RESULT_TYPE_SERIALIZATION) {
     // depending on if RESULT_TYPE_SERIALIZATION is set we might use either of
     // these types to serialize.
@@ -559,6 +627,9 @@ IOBuf TakeoverData::serializeThrift(uint64_t protocolCapabilities) {
     if (protocolCapabilities & TakeoverCapabilities::ORDERED_FDS) {
       serialized.fileDescriptors_ref() = generalFDOrder;
     }
+    if (cacheSnapshotPath) {
+      serialized.cacheSnapshotPath_ref() = cacheSnapshotPath->asString();
+    }
     SerializedTakeoverResult result;
     result.takeoverData_ref() = serialized;
 
@@ -621,6 +692,11 @@ TakeoverData TakeoverData::deserializeThrift(
           takeoverData.generalFDOrder =
               *(serialized.takeoverData_ref()->fileDescriptors_ref());
         }
+        auto cacheSnapshotPath =
+            serialized.takeoverData_ref()->cacheSnapshotPath_ref();
+        if (cacheSnapshotPath.has_value()) {
+          takeoverData.cacheSnapshotPath = AbsolutePath{*cacheSnapshotPath};
+        }
         return takeoverData;
       }
       case SerializedTakeoverResult::Type::__EMPTY__:
@@ -700,6 +776,24 @@ TakeoverData TakeoverData::deserializeThriftMounts(
             "impossible enum variant for TakeoverMountProtocol");
     }
   }
+
+  // The compact inode maps are only sent with COMPACT_INODE_MAP, but they are
+  // unambiguous, so there is no need to check the capabilities here.
+  std::vector<size_t> compactMounts;
+  for (size_t index = 0; index < data.mountPoints.size(); ++index) {
+    if (data.mountPoints[index]
+            .inodeMap.compactUnloadedInodes_ref()
+            .has_value()) {
+      compactMounts.push_back(index);
+    }
+  }
+  parallelFor(compactMounts.size(), [&](size_t n) {
+    auto& inodeMap = data.mountPoints[compactMounts[n]].inodeMap;
+    auto compact = inodeMap.compactUnloadedInodes_ref();
+    inodeMap.unloadedInodes_ref() =
+        decodeUnloadedInodes(folly::ByteRange{folly::StringPiece{*compact}});
+    compact.reset();
+  });
   return data;
 }
 
@@ -109,6 +109,12 @@ class TakeoverCapabilities {
     // Indicates that we include the size of the header in the header itself.
     // This will allow us to more safely evolve the header in the future.
     INCLUDE_HEADER_SIZE = 1 << 10,
+
+    // Indicates that the unloaded inodes of each mount are sent in the compact
+    // encoding of CompactInodeMap.h rather than as a thrift list, and that
+    // the mounts are encoded and decoded concurrently.
+    // This capability requires CAPABILITY_MATCHING, it has no version number.
+    COMPACT_INODE_MAP = 1 << 11,
   };
 };
 
@@ -184,7 +190,8 @@ class TakeoverData {
 
   /**
    * Converts a valid set of capabilities into the takeover version that
-   * supports exactly those capabilities. This is used to "serialize" the
+   * supports exactly those capabilities, or for capabilities added after
+   * CAPABILITY_MATCHING, the last version. This is used to "serialize" the
    * capabilities. Older versions of the protocol were version based instead of
    * capability based. So we "serialize" the capabilities as a version number.
    * Eventually we will migrate off versions, then we can get rid of this.
@@ -357,6 +364,12 @@ class TakeoverData {
    */
   std::vector<MountInfo> mountPoints;
 
+  /**
+   * The snapshot of the in-memory caches of the old process, to be reloaded
+   * by the new one. Only sent with RESULT_TYPE_SERIALIZATION.
+   */
+  std::optional<AbsolutePath> cacheSnapshotPath;
+
   /**
    * The takeoverComplete promise will be fulfilled by the TakeoverServer code
    * once the TakeoverData has been sent to the remote process.
@@ -34,6 +34,9 @@ struct SerializedInodeMapEntry {
 
 struct SerializedInodeMap {
   2: list<SerializedInodeMapEntry> unloadedInodes;
+  // With COMPACT_INODE_MAP, unloadedInodes is left empty and the entries are
+  // sent in the much denser encoding of CompactInodeMap.h instead.
+  3: optional binary compactUnloadedInodes;
 }
 
 struct SerializedFileHandleMap {}
@@ -88,6 +91,9 @@ enum FileDescriptorType {
 struct SerializedTakeoverInfo {
   1: list<SerializedMountInfo> mounts;
   2: list<FileDescriptorType> fileDescriptors;
+  // Where the old process saved the ids of the hottest objects of its
+  // in-memory caches. Ignored by the versions that don't know about it.
+  3: optional string cacheSnapshotPath;
 }
 
 // This is the highlevel structure we use to send takeover data between the
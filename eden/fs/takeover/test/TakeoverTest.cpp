@@ -14,6 +14,7 @@
 #include <folly/test/TestUtils.h>
 
 #include <eden/fs/takeover/gen-cpp2/takeover_types.h>
+#include "eden/fs/takeover/CompactInodeMap.h"
 #include "eden/fs/takeover/TakeoverClient.h"
 #include "eden/fs/takeover/TakeoverData.h"
 #include "eden/fs/takeover/TakeoverHandler.h"
@@ -497,6 +498,139 @@ TEST(Takeover, noMounts) {
   EXPECT_EQ(0, clientData.mountPoints.size());
 }
 
+TEST(Takeover, cacheSnapshotPath) {
+  TemporaryDirectory tmpDir("eden_takeover_test");
+  AbsolutePathPiece tmpDirPath{tmpDir.path().string()};
+
+  TakeoverData serverData;
+  auto lockFilePath = tmpDirPath + "lock"_pc;
+  serverData.lockFile =
+      folly::File{lockFilePath.stringPiece(), O_RDWR | O_CREAT};
+  auto thriftSocketPath = tmpDirPath + "thrift"_pc;
+  serverData.thriftSocket =
+      folly::File{thriftSocketPath.stringPiece(), O_RDWR | O_CREAT};
+  auto mountdSocketPath = tmpDirPath + "mountd"_pc;
+  serverData.mountdServerSocket =
+      folly::File{mountdSocketPath.stringPiece(), O_RDWR | O_CREAT};
+  auto cacheSnapshotPath = tmpDirPath + "cache-snapshot"_pc;
+  serverData.cacheSnapshotPath = cacheSnapshotPath;
+
+  auto serverSendFuture = serverData.takeoverComplete.getFuture();
+  TestHandler handler{std::move(serverData)};
+  auto result = runTakeover(tmpDir, &handler);
+  ASSERT_TRUE(serverSendFuture.hasValue());
+  ASSERT_TRUE(result.hasValue());
+  EXPECT_EQ(cacheSnapshotPath, result.value().cacheSnapshotPath);
+}
+
+SerializedInodeMap makeInodeMap(size_t numInodes) {
+  SerializedInodeMap inodeMap;
+  for (size_t n = 0; n < numInodes; ++n) {
+    SerializedInodeMapEntry entry;
+    entry.inodeNumber_ref() = n + 2;
+    entry.parentInode_ref() = n / 10 + 1;
+    entry.name_ref() = folly::to<string>("file", n);
+    entry.isUnlinked_ref() = n % 7 == 0;
+    entry.numFsReferences_ref() = n % 3;
+    // Every third inode is materialized.
+    if (n % 3 != 0) {
+      entry.hash_ref() = folly::to<string>("hash", n);
+    }
+    entry.mode_ref() = n % 2 ? 0100644 : 040755;
+    inodeMap.unloadedInodes_ref()->push_back(std::move(entry));
+  }
+  return inodeMap;
+}
+
+TEST(Takeover, compactInodeMapRoundTrip) {
+  auto entries = *makeInodeMap(1000).unloadedInodes_ref();
+  auto encoded = encodeUnloadedInodes(entries);
+  EXPECT_EQ(
+      entries,
+      decodeUnloadedInodes(folly::ByteRange{folly::StringPiece{encoded}}));
+
+  // Truncated and padded data are rejected.
+  EXPECT_THROW(
+      decodeUnloadedInodes(folly::ByteRange{
+          folly::StringPiece{encoded}.subpiece(0, encoded.size() - 1)}),
+      std::runtime_error);
+  encoded.push_back('\0');
+  EXPECT_THROW(
+      decodeUnloadedInodes(folly::ByteRange{folly::StringPiece{encoded}}),
+      std::runtime_error);
+}
+
+TEST(Takeover, compactInodeMapKeepsVersionSeven) {
+  EXPECT_EQ(
+      TakeoverData::kTakeoverProtocolVersionSeven,
+      TakeoverData::capabilitesToVersion(
+          TakeoverData::versionToCapabilites(
+              TakeoverData::kTakeoverProtocolVersionSeven) |
+          TakeoverCapabilities::COMPACT_INODE_MAP));
+}
+
+void inodeMapTestImpl(uint64_t clientCapabilities) {
+  TemporaryDirectory tmpDir("eden_takeover_test");
+  AbsolutePathPiece tmpDirPath{tmpDir.path().string()};
+
+  TakeoverData serverData;
+  auto lockFilePath = tmpDirPath + "lock"_pc;
+  serverData.lockFile =
+      folly::File{lockFilePath.stringPiece(), O_RDWR | O_CREAT};
+  auto thriftSocketPath = tmpDirPath + "thrift"_pc;
+  serverData.thriftSocket =
+      folly::File{thriftSocketPath.stringPiece(), O_RDWR | O_CREAT};
+  auto mountdSocketPath = tmpDirPath + "mountd"_pc;
+  serverData.mountdServerSocket =
+      folly::File{mountdSocketPath.stringPiece(), O_RDWR | O_CREAT};
+
+  // Mounts with and without unloaded inodes.
+  constexpr size_t numMounts = 4;
+  for (size_t n = 0; n < numMounts; ++n) {
+    auto fusePath =
+        tmpDirPath + PathComponentPiece{folly::to<string>("fuse", n)};
+    serverData.mountPoints.emplace_back(
+        tmpDirPath + PathComponentPiece{folly::to<string>("mount", n)},
+        tmpDirPath + PathComponentPiece{folly::to<string>("client", n)},
+        std::vector<AbsolutePath>{},
+        FuseChannelData{
+            folly::File{fusePath.stringPiece(), O_RDWR | O_CREAT},
+            fuse_init_out{}},
+        makeInodeMap(n * 1000));
+  }
+
+  auto serverSendFuture = serverData.takeoverComplete.getFuture();
+  TestHandler handler{std::move(serverData)};
+  auto result = runTakeover(
+      tmpDir,
+      &handler,
+      kSupportedTakeoverVersions,
+      kSupportedTakeoverVersions,
+      clientCapabilities,
+      kSupportedCapabilities);
+  ASSERT_TRUE(serverSendFuture.hasValue());
+  ASSERT_TRUE(result.hasValue());
+  const auto& clientData = result.value();
+
+  ASSERT_EQ(numMounts, clientData.mountPoints.size());
+  for (size_t n = 0; n < numMounts; ++n) {
+    const auto& inodeMap = clientData.mountPoints[n].inodeMap;
+    EXPECT_EQ(
+        *makeInodeMap(n * 1000).unloadedInodes_ref(),
+        *inodeMap.unloadedInodes_ref());
+    EXPECT_FALSE(inodeMap.compactUnloadedInodes_ref().has_value());
+  }
+}
+
+TEST(Takeover, compactInodeMap) {
+  inodeMapTestImpl(kSupportedCapabilities);
+}
+
+TEST(Takeover, inodeMapWithoutCompactInodeMap) {
+  inodeMapTestImpl(
+      kSupportedCapabilities & ~TakeoverCapabilities::COMPACT_INODE_MAP);
+}
+
 TEST(Takeover, manyMounts) {
   TemporaryDirectory tmpDir("eden_takeover_test");
   AbsolutePathPiece tmpDirPath{tmpDir.path().string()};
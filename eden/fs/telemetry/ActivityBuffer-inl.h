@@ -5,26 +5,78 @@
  * GNU General Public License version 2.
  */
 
-#include <folly/logging/xlog.h>
+#include <algorithm>
+#include <thread>
 
 namespace facebook::eden {
 
 template <typename TraceEvent>
 ActivityBuffer<TraceEvent>::ActivityBuffer(uint32_t maxEvents)
-    : maxEvents_(maxEvents) {}
+    : maxEvents_(maxEvents), slots_(std::make_unique<Slot[]>(maxEvents)) {}
+
+template <typename TraceEvent>
+uint64_t ActivityBuffer<TraceEvent>::lockSlot(const Slot& slot) {
+  auto state = slot.state.load(std::memory_order_relaxed);
+  while (true) {
+    if (state & 1) {
+      std::this_thread::yield();
+      state = slot.state.load(std::memory_order_relaxed);
+    } else if (slot.state.compare_exchange_weak(
+                   state,
+                   state | 1,
+                   std::memory_order_acquire,
+                   std::memory_order_relaxed)) {
+      return state;
+    }
+  }
+}
 
 template <typename TraceEvent>
 void ActivityBuffer<TraceEvent>::addEvent(TraceEvent event) {
-  auto events = events_.wlock();
-  events->push_back(std::move(event));
-  if (events->size() > maxEvents_) {
-    events->pop_front();
+  if (maxEvents_ == 0) {
+    return;
+  }
+  auto position = head_.fetch_add(1, std::memory_order_acq_rel);
+  auto& slot = slots_[position % maxEvents_];
+  auto state = lockSlot(slot);
+  auto newState = 2 * (position + 1);
+  if (state > newState) {
+    // A writer that claimed its slot after this one, a whole ring later, got
+    // there first: this event was already evicted.
+    slot.state.store(state, std::memory_order_release);
+    return;
+  }
+  slot.event.emplace(std::move(event));
+  slot.state.store(newState, std::memory_order_release);
+}
+
+template <typename TraceEvent>
+template <typename Fn>
+void ActivityBuffer<TraceEvent>::forEachEvent(Fn&& fn) const {
+  if (maxEvents_ == 0) {
+    return;
+  }
+  auto end = head_.load(std::memory_order_acquire);
+  auto begin = end > maxEvents_ ? end - maxEvents_ : 0;
+  for (auto position = begin; position < end; ++position) {
+    const auto& slot = slots_[position % maxEvents_];
+    auto state = lockSlot(slot);
+    // Skip the events that are claimed but not written yet, and the ones
+    // that were evicted since loading head_.
+    if (state == 2 * (position + 1)) {
+      fn(*slot.event);
+    }
+    slot.state.store(state, std::memory_order_release);
   }
 }
 
 template <typename TraceEvent>
-std::deque<TraceEvent> ActivityBuffer<TraceEvent>::getAllEvents() const {
-  return *events_.rlock();
+std::vector<TraceEvent> ActivityBuffer<TraceEvent>::getAllEvents() const {
+  std::vector<TraceEvent> events;
+  events.reserve(std::min<uint64_t>(
+      maxEvents_, head_.load(std::memory_order_relaxed)));
+  forEachEvent([&](const TraceEvent& event) { events.push_back(event); });
+  return events;
 }
 
 } // namespace facebook::eden
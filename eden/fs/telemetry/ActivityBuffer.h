@@ -7,9 +7,11 @@
 
 #pragma once
 
-#include <deque>
-
-#include <folly/Synchronized.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
 
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/service/gen-cpp2/eden_types.h"
@@ -29,6 +31,12 @@ namespace facebook::eden {
  * With the ActivityBuffer, we enable functionality for retroactive debugging of
  * expensive events in EdenFS by storing past event changes that users will be
  * able view at any time through retroactive versions of Eden's tracing CLI.
+ *
+ * The events are stored in a ring of maxEvents slots allocated upfront. An
+ * append claims its slot with a single atomic increment and then only waits
+ * on a reader, or on a writer that lapped the whole ring, of that same slot,
+ * so that a large buffer can be kept without slowing down the code that
+ * records the events.
  */
 template <typename TraceEvent>
 class ActivityBuffer {
@@ -48,14 +56,38 @@ class ActivityBuffer {
   void addEvent(TraceEvent event);
 
   /**
-   * Returns an std::deque containing all TraceEvents stored in the
-   * ActivityBuffer.
+   * Returns a copy of all TraceEvents stored in the ActivityBuffer, oldest
+   * first.
+   */
+  std::vector<TraceEvent> getAllEvents() const;
+
+  /**
+   * Calls fn with every TraceEvent stored in the ActivityBuffer, oldest first,
+   * without copying them. fn is called with the slot of the event locked, so
+   * it must be quick and must not add events to this buffer.
+   *
+   * Events added while iterating may or may not be visited.
    */
-  std::deque<TraceEvent> getAllEvents() const;
+  template <typename Fn>
+  void forEachEvent(Fn&& fn) const;
 
  private:
+  struct Slot {
+    // Twice the position of the stored event plus one, zero while empty. The
+    // low bit is set while a reader or a writer holds the slot.
+    mutable std::atomic<uint64_t> state{0};
+    std::optional<TraceEvent> event;
+  };
+
+  /**
+   * Waits for the slot to be free and locks it, returning its state.
+   */
+  static uint64_t lockSlot(const Slot& slot);
+
   uint32_t maxEvents_;
-  folly::Synchronized<std::deque<TraceEvent>> events_;
+  std::unique_ptr<Slot[]> slots_;
+  // The position the next event will be stored at.
+  std::atomic<uint64_t> head_{0};
 };
 
 } // namespace facebook::eden
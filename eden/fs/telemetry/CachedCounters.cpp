@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/CachedCounters.h"
+
+#include <fb303/ServiceData.h>
+#include <re2/re2.h>
+#include <utility>
+#include <vector>
+
+namespace facebook::eden {
+
+CachedCounters::CachedCounters()
+    : snapshot_{std::make_shared<const Snapshot>()} {}
+
+CachedCounters::~CachedCounters() {
+  auto counters = fb303::ServiceData::get()->getDynamicCounters();
+  auto callbacks = std::move(*callbacks_.wlock());
+  for (const auto& [name, callback] : callbacks) {
+    counters->unregisterCallback(name);
+  }
+}
+
+void CachedCounters::registerCallback(std::string name, Callback callback) {
+  callbacks_.wlock()->insert_or_assign(
+      name, std::make_shared<const Callback>(std::move(callback)));
+  fb303::ServiceData::get()->getDynamicCounters()->registerCallback(
+      name, [this, name] { return getValue(name).value_or(0); });
+}
+
+void CachedCounters::unregisterCallback(std::string_view name) {
+  fb303::ServiceData::get()->getDynamicCounters()->unregisterCallback(name);
+  callbacks_.wlock()->erase(name);
+}
+
+void CachedCounters::refresh(const re2::RE2* filter) {
+  // Compute the counters outside of the lock, so that mounts can register
+  // theirs meanwhile.
+  std::vector<std::pair<std::string, std::shared_ptr<const Callback>>> todo;
+  {
+    auto callbacks = callbacks_.rlock();
+    todo.reserve(callbacks->size());
+    for (const auto& [name, callback] : *callbacks) {
+      if (!filter || re2::RE2::PartialMatch(name, *filter)) {
+        todo.emplace_back(name, callback);
+      }
+    }
+  }
+
+  auto snapshot = std::make_shared<Snapshot>();
+  snapshot->reserve(todo.size());
+  for (auto& [name, callback] : todo) {
+    auto value = (*callback)();
+    snapshot->emplace(std::move(name), value);
+  }
+  *snapshot_.wlock() = std::move(snapshot);
+}
+
+std::optional<int64_t> CachedCounters::getValue(std::string_view name) const {
+  if (!enabled_.load(std::memory_order_relaxed)) {
+    std::shared_ptr<const Callback> callback;
+    {
+      auto callbacks = callbacks_.rlock();
+      auto it = callbacks->find(name);
+      if (it == callbacks->end()) {
+        return std::nullopt;
+      }
+      callback = it->second;
+    }
+    return (*callback)();
+  }
+
+  auto snapshot = getSnapshot();
+  auto it = snapshot->find(name);
+  if (it == snapshot->end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+} // namespace facebook::eden
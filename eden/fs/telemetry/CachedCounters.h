@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace re2 {
+class RE2;
+} // namespace re2
+
+namespace facebook::eden {
+
+/**
+ * fb303 counters that are too expensive to compute on every scrape, like
+ * the ones that take the locks of the InodeMap or of the Journal.
+ *
+ * The counters are computed together by refresh, which EdenServer calls
+ * periodically, into an immutable snapshot. The fb303 callbacks registered
+ * for them only read that snapshot, so scrapes never wait on the locks of
+ * the subsystems, however often they come.
+ */
+class CachedCounters {
+ public:
+  using Callback = std::function<int64_t()>;
+  using Snapshot = folly::F14FastMap<std::string, int64_t>;
+
+  CachedCounters();
+  ~CachedCounters();
+
+  CachedCounters(const CachedCounters&) = delete;
+  CachedCounters& operator=(const CachedCounters&) = delete;
+
+  /**
+   * Registers an fb303 counter which reads the value the last refresh
+   * computed with callback, or 0 until then.
+   */
+  void registerCallback(std::string name, Callback callback);
+
+  void unregisterCallback(std::string_view name);
+
+  /**
+   * Computes every registered counter whose name matches filter, if any,
+   * into a new snapshot. Counters the filter excludes read as 0.
+   */
+  void refresh(const re2::RE2* filter = nullptr);
+
+  /**
+   * When disabled, the fb303 counters call their callbacks on every scrape
+   * again, and refresh is not needed. Enabled by default.
+   */
+  void setEnabled(bool enabled) noexcept {
+    enabled_.store(enabled, std::memory_order_relaxed);
+  }
+
+  /**
+   * The value of the counter, as scrapes see it.
+   */
+  std::optional<int64_t> getValue(std::string_view name) const;
+
+  std::shared_ptr<const Snapshot> getSnapshot() const {
+    return snapshot_.copy();
+  }
+
+ private:
+  using Callbacks =
+      folly::F14NodeMap<std::string, std::shared_ptr<const Callback>>;
+
+  std::atomic<bool> enabled_{true};
+  folly::Synchronized<Callbacks> callbacks_;
+  folly::Synchronized<std::shared_ptr<const Snapshot>> snapshot_;
+};
+
+} // namespace facebook::eden
@@ -9,8 +9,12 @@
 
 #include <folly/logging/xlog.h>
 #include <chrono>
+#include <iterator>
 #include <memory>
 
+#include "eden/fs/telemetry/FsChannelLatencies.h"
+#include "eden/fs/telemetry/LockContention.h"
+
 namespace facebook::eden {
 
 void EdenStats::flush() {
@@ -19,6 +23,49 @@ void EdenStats::flush() {
   // quantile stat based, flushing the quantile stat map is sufficient for that
   // use case.
   fb303::ServiceData::get()->getQuantileStatMap()->flushAll();
+
+  for (auto& latencies : getLiveLatencies()) {
+    latencies->collect();
+  }
+}
+
+void EdenStats::registerLatencies(std::weak_ptr<FsChannelLatencies> latencies) {
+  latencies_.wlock()->push_back(std::move(latencies));
+}
+
+std::vector<std::shared_ptr<FsChannelLatencies>>
+EdenStats::getLiveLatencies() {
+  std::vector<std::shared_ptr<FsChannelLatencies>> live;
+  auto registered = latencies_.wlock();
+  auto it = registered->begin();
+  while (it != registered->end()) {
+    if (auto latencies = it->lock()) {
+      live.push_back(std::move(latencies));
+      ++it;
+    } else {
+      it = registered->erase(it);
+    }
+  }
+  return live;
+}
+
+std::vector<LabeledLatencyHistogram> EdenStats::getLatencyHistograms() {
+  std::vector<LabeledLatencyHistogram> histograms;
+  for (auto& latencies : getLiveLatencies()) {
+    // Collect first, so the result doesn't lag behind by a flush interval.
+    latencies->collect();
+    auto snapshots = latencies->getSnapshots();
+    histograms.insert(
+        histograms.end(),
+        std::make_move_iterator(snapshots.begin()),
+        std::make_move_iterator(snapshots.end()));
+  }
+  auto locks = LockSite::getHistograms();
+  histograms.insert(
+      histograms.end(),
+      std::make_move_iterator(locks.begin()),
+      std::make_move_iterator(locks.end()));
+  return histograms;
 }
 
 StatsGroupBase::Counter::Counter(std::string_view name)
@@ -51,6 +98,16 @@ void StatsGroupBase::Duration::addDuration(std::chrono::microseconds elapsed) {
   addValue(elapsed.count());
 }
 
+void StatsGroupBase::Histogram::collect(LatencyHistogram& into) noexcept {
+  for (size_t i = 0; i < LatencyHistogram::kBucketCount; ++i) {
+    auto recorded = recorded_[i].load(std::memory_order_relaxed);
+    if (recorded != collected_[i]) {
+      into.addToBucket(i, recorded - collected_[i]);
+      collected_[i] = recorded;
+    }
+  }
+}
+
 DurationScope::~DurationScope() noexcept {
   if (edenStats_ && updateScope_) {
     try {
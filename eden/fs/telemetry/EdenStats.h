@@ -7,13 +7,19 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <memory>
+#include <vector>
 
 #include <fb303/detail/QuantileStatWrappers.h>
+#include <folly/Synchronized.h>
 #include <folly/ThreadLocal.h>
 #include <folly/stop_watch.h>
 
 #include "eden/fs/eden-config.h"
+#include "eden/fs/telemetry/LatencyHistogram.h"
 
 namespace facebook::eden {
 
@@ -25,6 +31,10 @@ struct HgBackingStoreStats;
 struct HgImporterStats;
 struct JournalStats;
 struct ThriftStats;
+struct TreeInodeStats;
+struct FileInodeStats;
+struct AccessPrefetcherStats;
+class FsChannelLatencies;
 
 /**
  * StatsGroupBase is a base class for a group of thread-local stats
@@ -73,6 +83,37 @@ class StatsGroupBase {
 
     void addDuration(std::chrono::microseconds elapsed);
   };
+
+  /**
+   * Histogram records durations in microseconds into the buckets of a
+   * LatencyHistogram, for the tail percentiles the QuantileStatWrapper
+   * sliding windows can't give at every scale.
+   *
+   * Only one thread may call addDuration: each bucket is then updated with a
+   * plain load and store, without a read-modify-write. collect can be called
+   * from any other thread, but not concurrently with itself, and doesn't
+   * block the writer.
+   */
+  class Histogram {
+   public:
+    void addDuration(std::chrono::microseconds elapsed) noexcept {
+      auto& bucket = recorded_[LatencyHistogram::bucketOf(
+          static_cast<uint64_t>(std::max<int64_t>(elapsed.count(), 0)))];
+      bucket.store(
+          bucket.load(std::memory_order_relaxed) + 1,
+          std::memory_order_relaxed);
+    }
+
+    /**
+     * Adds the durations recorded since the previous collect to into.
+     */
+    void collect(LatencyHistogram& into) noexcept;
+
+   private:
+    std::array<std::atomic<uint64_t>, LatencyHistogram::kBucketCount>
+        recorded_{};
+    std::array<uint64_t, LatencyHistogram::kBucketCount> collected_{};
+  };
 };
 
 class EdenStats {
@@ -94,12 +135,26 @@ class EdenStats {
   }
 
   /**
-   * Aggregates thread-locals into fb303's ServiceData.
+   * Aggregates thread-locals into fb303's ServiceData, and the latency
+   * histograms of the registered channels into their per-mount totals.
    *
    * This function can be called on any thread.
    */
   void flush();
 
+  /**
+   * Registers the latency histograms of a channel, to be collected by flush
+   * until the channel is destroyed.
+   */
+  void registerLatencies(std::weak_ptr<FsChannelLatencies> latencies);
+
+  /**
+   * The latency histograms of every live channel and operation, with the
+   * durations recorded since the channel started, followed by the wait and
+   * hold times of the instrumented locks.
+   */
+  std::vector<LabeledLatencyHistogram> getLatencyHistograms();
+
   template <typename T>
   T& getStatsForCurrentThread() = delete;
 
@@ -117,6 +172,17 @@ class EdenStats {
   ThreadLocal<HgImporterStats> hgImporterStats_;
   ThreadLocal<JournalStats> journalStats_;
   ThreadLocal<ThriftStats> thriftStats_;
+  ThreadLocal<TreeInodeStats> treeInodeStats_;
+  ThreadLocal<FileInodeStats> fileInodeStats_;
+  ThreadLocal<AccessPrefetcherStats> accessPrefetcherStats_;
+
+  /**
+   * The registered channels that are still alive. Prunes the others.
+   */
+  std::vector<std::shared_ptr<FsChannelLatencies>> getLiveLatencies();
+
+  folly::Synchronized<std::vector<std::weak_ptr<FsChannelLatencies>>>
+      latencies_;
 };
 
 template <>
@@ -161,6 +227,22 @@ inline ThriftStats& EdenStats::getStatsForCurrentThread<ThriftStats>() {
   return *thriftStats_.get();
 }
 
+template <>
+inline TreeInodeStats& EdenStats::getStatsForCurrentThread<TreeInodeStats>() {
+  return *treeInodeStats_.get();
+}
+
+template <>
+inline FileInodeStats& EdenStats::getStatsForCurrentThread<FileInodeStats>() {
+  return *fileInodeStats_.get();
+}
+
+template <>
+inline AccessPrefetcherStats&
+EdenStats::getStatsForCurrentThread<AccessPrefetcherStats>() {
+  return *accessPrefetcherStats_.get();
+}
+
 template <typename T>
 class StatsGroup : public StatsGroupBase {
  public:
@@ -194,6 +276,7 @@ struct FuseStats : StatsGroup<FuseStats> {
   Duration fsync{"fuse.fsync_us"};
   Duration opendir{"fuse.opendir_us"};
   Duration readdir{"fuse.readdir_us"};
+  Duration readdirplus{"fuse.readdirplus_us"};
   Duration releasedir{"fuse.releasedir_us"};
   Duration fsyncdir{"fuse.fsyncdir_us"};
   Duration statfs{"fuse.statfs_us"};
@@ -208,6 +291,17 @@ struct FuseStats : StatsGroup<FuseStats> {
   Duration poll{"fuse.poll_us"};
   Duration forgetmulti{"fuse.forgetmulti_us"};
   Duration fallocate{"fuse.fallocate_us"};
+
+  // Invalidations sent to the kernel, and those dropped as duplicates.
+  Duration invalidateInode{"fuse.invalidate_inode_us"};
+  Duration invalidateEntry{"fuse.invalidate_entry_us"};
+  Counter invalidationsCoalesced{"fuse.invalidations_coalesced"};
+
+  // Requests the overload controller queued or shed, and how long the queued
+  // ones waited.
+  Counter requestsDeferred{"fuse.requests_deferred"};
+  Counter requestsShed{"fuse.requests_shed"};
+  Duration requestQueueDelay{"fuse.request_queue_delay_us"};
 };
 
 struct NfsStats : StatsGroup<NfsStats> {
@@ -233,11 +327,21 @@ struct NfsStats : StatsGroup<NfsStats> {
   Duration nfsFsinfo{"nfs.fsinfo_us"};
   Duration nfsPathconf{"nfs.pathconf_us"};
   Duration nfsCommit{"nfs.commit_us"};
+  Duration nfsCompound{"nfs.compound_us"};
+
+  // Requests the overload controller queued or shed, and how long the queued
+  // ones waited.
+  Counter requestsDeferred{"nfs.requests_deferred"};
+  Counter requestsShed{"nfs.requests_shed"};
+  Duration requestQueueDelay{"nfs.request_queue_delay_us"};
 };
 
 struct PrjfsStats : StatsGroup<PrjfsStats> {
   Counter outOfOrderCreate{"prjfs.out_of_order_create"};
   Duration queuedFileNotification{"prjfs.queued_file_notification_us"};
+  // Sampled each time a notification is received: the number of earlier
+  // notifications that are still queued or being handled.
+  Counter pendingFileNotifications{"prjfs.pending_file_notifications"};
 
   Duration newFileCreated{"prjfs.newFileCreated_us"};
   Duration fileOverwritten{"prjfs.fileOverwritten_us"};
@@ -278,6 +382,18 @@ struct ObjectStoreStats : StatsGroup<ObjectStoreStats> {
   Counter getBlobSizeFromLocalStore{"object_store.get_blob_size.local_store"};
   Counter getBlobSizeFromBackingStore{
       "object_store.get_blob_size.backing_store"};
+
+  Counter globResultCacheHit{"object_store.glob_result_cache.hit"};
+  Counter globResultCacheMiss{"object_store.glob_result_cache.miss"};
+
+  Counter localStoreWriteDropped{"object_store.local_store_write.dropped"};
+
+  // Lookups that skipped the local store, the object being known missing.
+  Counter localStoreKnownMissing{"object_store.local_store.known_missing"};
+  // Lookups that missed in the local store although its missing object filter
+  // was built.
+  Counter localStoreMissingFalsePositive{
+      "object_store.local_store.missing_false_positive"};
 };
 
 /**
@@ -290,7 +406,9 @@ struct HgBackingStoreStats : StatsGroup<HgBackingStoreStats> {
   Duration importTree{"store.hg.import_tree_us"};
   Duration getBlobMetadata{"store.hg.get_blob_metadata_us"};
   Counter loadProxyHash{"store.hg.load_proxy_hash"};
+  Counter loadProxyHashFromMemory{"store.hg.load_proxy_hash.memory"};
   Counter auxMetadataMiss{"store.hg.aux_metadata_miss"};
+  Counter degradedBackendFailure{"store.hg.degraded_backend_failure"};
 };
 
 /**
@@ -308,11 +426,76 @@ struct HgImporterStats : StatsGroup<HgImporterStats> {
 struct JournalStats : StatsGroup<JournalStats> {
   Counter truncatedReads{"journal.truncated_reads"};
   Counter filesAccumulated{"journal.files_accumulated"};
+  /**
+   * Time from a change being recorded to its subscribers being notified.
+   */
+  Duration notificationLag{"journal.notification_lag_us"};
 };
 
 struct ThriftStats : StatsGroup<ThriftStats> {
   Duration streamChangesSince{
       "thrift.StreamingEdenService.streamChangesSince.streaming_time_us"};
+
+  /**
+   * Time the expensive requests waited to run, under
+   * thrift:max-expensive-requests. Cheap requests never wait.
+   */
+  Duration globFilesQueueDelay{"thrift.EdenService.globFiles.queue_delay_us"};
+  Duration predictiveGlobFilesQueueDelay{
+      "thrift.EdenService.predictiveGlobFiles.queue_delay_us"};
+  Duration prefetchFilesQueueDelay{
+      "thrift.EdenService.prefetchFiles.queue_delay_us"};
+  Duration getScmStatusV2QueueDelay{
+      "thrift.EdenService.getScmStatusV2.queue_delay_us"};
+  Duration getScmStatusQueueDelay{
+      "thrift.EdenService.getScmStatus.queue_delay_us"};
+  // Expensive requests that had to queue, and those that were shed.
+  Counter expensiveRequestsDeferred{"thrift.expensive_requests_deferred"};
+  Counter expensiveRequestsShed{"thrift.expensive_requests_shed"};
+  // The files materialized by ensureMaterialized, and their size.
+  Counter ensureMaterializedFiles{"thrift.ensure_materialized.files"};
+  Counter ensureMaterializedBytes{"thrift.ensure_materialized.bytes"};
+};
+
+/**
+ * @see TreeInode
+ */
+struct TreeInodeStats : StatsGroup<TreeInodeStats> {
+  /**
+   * Bytes used by the entries of TreeInodes loaded from source control
+   * Trees, and the size of those Trees. Comparing the two shows how much of
+   * the memory of loaded directories duplicates the tree cache.
+   */
+  Counter dirContentsFromTreeBytes{"tree_inode.dir_contents_from_tree_bytes"};
+  Counter sourceTreeBytes{"tree_inode.source_tree_bytes"};
+};
+
+/**
+ * @see FileInode
+ */
+struct FileInodeStats : StatsGroup<FileInodeStats> {
+  /**
+   * Time from the start of a read to its reply, for reads that had to wait
+   * for the file's blob to be fetched. This is the time to first byte of a
+   * cold file.
+   */
+  Duration readBlobWait{"file_inode.read_blob_wait_us"};
+};
+
+/**
+ * @see AccessPrefetcher
+ */
+struct AccessPrefetcherStats : StatsGroup<AccessPrefetcherStats> {
+  Counter modelsLearned{"access_prefetcher.models_learned"};
+  Counter prefetches{"access_prefetcher.prefetches"};
+  Counter prefetchedBlobs{"access_prefetcher.prefetched_blobs"};
+  /**
+   * Prefetched blobs that the process then read, and those it didn't read
+   * before pausing, with their total size when known.
+   */
+  Counter hits{"access_prefetcher.hits"};
+  Counter wastedBlobs{"access_prefetcher.wasted_blobs"};
+  Counter wastedBytes{"access_prefetcher.wasted_bytes"};
 };
 
 /**
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/FsChannelLatencies.h"
+
+#include <folly/portability/Unistd.h>
+
+namespace facebook::eden {
+
+FsChannelLatencies::ThreadHistograms::ThreadHistograms(
+    FsChannelLatencies& latencies)
+    : latencies_{latencies}, histograms_(latencies.opNames_.size()) {}
+
+FsChannelLatencies::ThreadHistograms::~ThreadHistograms() {
+  // Don't lose the durations recorded since the last collect.
+  collect(*latencies_.totals_.wlock());
+  for (auto& histogram : histograms_) {
+    delete histogram.load(std::memory_order_relaxed);
+  }
+}
+
+StatsGroupBase::Histogram& FsChannelLatencies::ThreadHistograms::get(
+    size_t op) {
+  auto* histogram = histograms_[op].load(std::memory_order_relaxed);
+  if (!histogram) {
+    histogram = new Histogram{};
+    histograms_[op].store(histogram, std::memory_order_release);
+  }
+  return *histogram;
+}
+
+void FsChannelLatencies::ThreadHistograms::collect(
+    std::vector<LatencyHistogram>& totals) {
+  for (size_t op = 0; op < histograms_.size(); ++op) {
+    if (auto* histogram = histograms_[op].load(std::memory_order_acquire)) {
+      histogram->collect(totals[op]);
+    }
+  }
+}
+
+FsChannelLatencies::FsChannelLatencies(
+    std::string channel,
+    std::string mountPath,
+    std::vector<std::string> opNames)
+    : channel_{std::move(channel)},
+      mountPath_{std::move(mountPath)},
+      opNames_{std::move(opNames)},
+      totals_{std::vector<LatencyHistogram>(opNames_.size())},
+      threadHistograms_{[this] { return new ThreadHistograms{*this}; }} {}
+
+const std::string& FsChannelLatencies::getOpName(size_t op) const {
+  static const std::string kUnrecorded;
+  return op < opNames_.size() ? opNames_[op] : kUnrecorded;
+}
+
+void FsChannelLatencies::addDuration(
+    size_t op,
+    std::chrono::microseconds elapsed) {
+  if (getOpName(op).empty()) {
+    return;
+  }
+  threadHistograms_->get(op).addDuration(elapsed);
+}
+
+void FsChannelLatencies::collect() {
+  // The accessor keeps the threads from exiting, and the lock of the totals
+  // keeps concurrent collects from reading the same histograms.
+  auto threads = threadHistograms_.accessAllThreads();
+  auto totals = totals_.wlock();
+  for (auto& thread : threads) {
+    thread.collect(*totals);
+  }
+}
+
+std::vector<LabeledLatencyHistogram> FsChannelLatencies::getSnapshots() const {
+  auto pid = std::to_string(getpid());
+  std::vector<LabeledLatencyHistogram> snapshots;
+  auto totals = totals_.rlock();
+  for (size_t op = 0; op < totals->size(); ++op) {
+    if ((*totals)[op].getCount() == 0) {
+      continue;
+    }
+    snapshots.push_back(LabeledLatencyHistogram{
+        {
+            {"channel", channel_},
+            {"mount", mountPath_},
+            {"op", opNames_[op]},
+            {"process", "edenfs"},
+            {"pid", pid},
+        },
+        (*totals)[op]});
+  }
+  return snapshots;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/ThreadLocal.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "eden/fs/telemetry/EdenStats.h"
+#include "eden/fs/telemetry/LatencyHistogram.h"
+
+namespace facebook::eden {
+
+/**
+ * The latency histograms of the operations of one FsChannel, in one mount.
+ *
+ * Each thread records into its own StatsGroupBase::Histogram per operation,
+ * created the first time the thread handles the operation, so that a request
+ * only pays for a couple of relaxed atomic operations. collect, called by
+ * EdenStats::flush, adds the new values of every thread to the per-mount
+ * totals without stopping the threads.
+ */
+class FsChannelLatencies {
+ public:
+  /**
+   * channel is the name of the FsChannel, like "fuse", and opNames the names
+   * of its operations, indexed like the op argument of addDuration. The
+   * empty names are for the operations that aren't recorded.
+   */
+  FsChannelLatencies(
+      std::string channel,
+      std::string mountPath,
+      std::vector<std::string> opNames);
+
+  FsChannelLatencies(const FsChannelLatencies&) = delete;
+  FsChannelLatencies& operator=(const FsChannelLatencies&) = delete;
+
+  void addDuration(size_t op, std::chrono::microseconds elapsed);
+
+  const std::string& getChannel() const {
+    return channel_;
+  }
+
+  /**
+   * Empty if the operation isn't recorded.
+   */
+  const std::string& getOpName(size_t op) const;
+
+  /**
+   * Adds the durations recorded by every thread since the previous collect
+   * to the totals.
+   */
+  void collect();
+
+  /**
+   * The totals of the operations that recorded at least one duration, with
+   * the channel, mount, op and process labels.
+   */
+  std::vector<LabeledLatencyHistogram> getSnapshots() const;
+
+ private:
+  using Histogram = StatsGroupBase::Histogram;
+
+  class ThreadHistograms {
+   public:
+    explicit ThreadHistograms(FsChannelLatencies& latencies);
+    ~ThreadHistograms();
+
+    ThreadHistograms(const ThreadHistograms&) = delete;
+    ThreadHistograms& operator=(const ThreadHistograms&) = delete;
+
+    Histogram& get(size_t op);
+
+    /**
+     * Must be called with the lock of totals held.
+     */
+    void collect(std::vector<LatencyHistogram>& totals);
+
+   private:
+    FsChannelLatencies& latencies_;
+    // Published to the collecting thread once created, and only freed by the
+    // destructor, once the thread exited or the FsChannelLatencies is being
+    // destroyed.
+    std::vector<std::atomic<Histogram*>> histograms_;
+  };
+
+  class ThreadLocalTag {};
+
+  const std::string channel_;
+  const std::string mountPath_;
+  const std::vector<std::string> opNames_;
+
+  // Declared before threadHistograms_, which adds to it when destroyed.
+  folly::Synchronized<std::vector<LatencyHistogram>> totals_;
+  folly::ThreadLocal<ThreadHistograms, ThreadLocalTag> threadHistograms_;
+};
+
+} // namespace facebook::eden
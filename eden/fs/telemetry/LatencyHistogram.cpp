@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/LatencyHistogram.h"
+
+#include <folly/lang/Bits.h>
+#include <algorithm>
+#include <cmath>
+
+namespace facebook::eden {
+
+size_t LatencyHistogram::bucketOf(uint64_t value) noexcept {
+  // The values below kSubBuckets each have their own bucket.
+  if (value < kSubBuckets) {
+    return value;
+  }
+  if (value >= uint64_t{1} << kMaxBits) {
+    return kBucketCount - 1;
+  }
+  size_t exponent = folly::findLastSet(value) - 1;
+  size_t subBucket = (value >> (exponent - kSubBucketBits)) & (kSubBuckets - 1);
+  return kSubBuckets * (exponent - kSubBucketBits + 1) + subBucket;
+}
+
+uint64_t LatencyHistogram::bucketLowerBound(size_t bucket) noexcept {
+  if (bucket < kSubBuckets) {
+    return bucket;
+  }
+  size_t group = bucket / kSubBuckets;
+  uint64_t subBucket = bucket % kSubBuckets;
+  return (kSubBuckets + subBucket) << (group - 1);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) noexcept {
+  for (size_t i = 0; i < kBucketCount; ++i) {
+    buckets_[i] += other.buckets_[i];
+  }
+  count_ += other.count_;
+}
+
+uint64_t LatencyHistogram::getPercentile(double percentile) const noexcept {
+  if (count_ == 0) {
+    return 0;
+  }
+  // The rank of the value, starting at 1.
+  auto rank = std::max<uint64_t>(
+      1,
+      static_cast<uint64_t>(
+          std::ceil(std::clamp(percentile, 0.0, 100.0) / 100.0 * count_)));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kBucketCount; ++i) {
+    seen += buckets_[i];
+    if (seen >= rank) {
+      return bucketLowerBound(i);
+    }
+  }
+  return getMax();
+}
+
+uint64_t LatencyHistogram::getMax() const noexcept {
+  for (size_t i = kBucketCount; i > 0; --i) {
+    if (buckets_[i - 1] != 0) {
+      return bucketLowerBound(i - 1);
+    }
+  }
+  return 0;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace facebook::eden {
+
+/**
+ * A log-linear histogram of latencies in microseconds: every power of two is
+ * split in kSubBuckets linear buckets, so that a percentile is within 1 /
+ * kSubBuckets of the true value at any scale, from microseconds to hours,
+ * in a fixed amount of memory.
+ *
+ * This class is not thread safe, see StatsGroupBase::Histogram for the
+ * thread-local recorder that feeds it.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr size_t kSubBucketBits = 3;
+  static constexpr size_t kSubBuckets = size_t{1} << kSubBucketBits;
+  // Values of 2^kMaxBits microseconds, about 19 hours, and more all go to
+  // the last bucket.
+  static constexpr size_t kMaxBits = 36;
+  static constexpr size_t kBucketCount =
+      kSubBuckets * (kMaxBits - kSubBucketBits + 1);
+
+  static size_t bucketOf(uint64_t value) noexcept;
+
+  /**
+   * The smallest value that goes to the bucket.
+   */
+  static uint64_t bucketLowerBound(size_t bucket) noexcept;
+
+  void record(uint64_t value) noexcept {
+    addToBucket(bucketOf(value), 1);
+  }
+
+  void addToBucket(size_t bucket, uint64_t count) noexcept {
+    buckets_[bucket] += count;
+    count_ += count;
+  }
+
+  void merge(const LatencyHistogram& other) noexcept;
+
+  uint64_t getCount() const noexcept {
+    return count_;
+  }
+
+  uint64_t getBucketCount(size_t bucket) const noexcept {
+    return buckets_[bucket];
+  }
+
+  /**
+   * The value below which the given percentage of the values fall, rounded
+   * down to the lower bound of its bucket. Zero if the histogram is empty.
+   */
+  uint64_t getPercentile(double percentile) const noexcept;
+
+  /**
+   * The lower bound of the highest non-empty bucket.
+   */
+  uint64_t getMax() const noexcept;
+
+ private:
+  std::array<uint64_t, kBucketCount> buckets_{};
+  uint64_t count_{0};
+};
+
+/**
+ * A histogram with the labels, like the mount and the operation, that
+ * identify what it measures.
+ */
+struct LabeledLatencyHistogram {
+  std::vector<std::pair<std::string, std::string>> labels;
+  LatencyHistogram histogram;
+};
+
+} // namespace facebook::eden
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/LockContention.h"
+
+#include <fb303/ServiceData.h>
+#include <fmt/format.h>
+#include <folly/Synchronized.h>
+
+namespace facebook::eden {
+
+namespace {
+using Sites = folly::Synchronized<std::vector<const LockSite*>>;
+
+Sites& getSites() {
+  static folly::Indestructible<Sites> sites;
+  return *sites;
+}
+} // namespace
+
+std::atomic<bool> LockSite::enabled_{false};
+
+LockSite::LockSite(std::string_view name) : name_{name} {
+  getSites().wlock()->push_back(this);
+  registerCounters();
+}
+
+LatencyHistogram LockSite::snapshot(const Buckets& buckets) {
+  LatencyHistogram histogram;
+  for (size_t i = 0; i < buckets.size(); ++i) {
+    if (auto count = buckets[i].load(std::memory_order_relaxed)) {
+      histogram.addToBucket(i, count);
+    }
+  }
+  return histogram;
+}
+
+void LockSite::registerCounters() {
+  auto counters = fb303::ServiceData::get()->getDynamicCounters();
+  counters->registerCallback(
+      fmt::format("lock.{}.acquisitions", name_),
+      [this] { return static_cast<int64_t>(snapshot(wait_).getCount()); });
+  for (auto [kind, buckets] :
+       {std::make_pair("wait", &wait_), std::make_pair("hold", &hold_)}) {
+    for (auto [suffix, percentile] :
+         {std::make_pair("p50", 50.0),
+          std::make_pair("p99", 99.0),
+          std::make_pair("p999", 99.9)}) {
+      counters->registerCallback(
+          fmt::format("lock.{}.{}_us.{}", name_, kind, suffix),
+          [buckets = buckets, percentile = percentile] {
+            return static_cast<int64_t>(
+                snapshot(*buckets).getPercentile(percentile));
+          });
+    }
+    counters->registerCallback(
+        fmt::format("lock.{}.{}_us.max", name_, kind),
+        [buckets = buckets] {
+          return static_cast<int64_t>(snapshot(*buckets).getMax());
+        });
+  }
+}
+
+std::vector<LabeledLatencyHistogram> LockSite::getHistograms() {
+  std::vector<LabeledLatencyHistogram> histograms;
+  for (const auto* site : *getSites().rlock()) {
+    for (auto [kind, buckets] :
+         {std::make_pair("wait", &site->wait_),
+          std::make_pair("hold", &site->hold_)}) {
+      auto histogram = snapshot(*buckets);
+      if (histogram.getCount() == 0) {
+        continue;
+      }
+      histograms.push_back(LabeledLatencyHistogram{
+          {{"lock", site->name_}, {"kind", kind}}, std::move(histogram)});
+    }
+  }
+  return histograms;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Indestructible.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "eden/fs/telemetry/LatencyHistogram.h"
+
+namespace facebook::eden {
+
+/**
+ * The wait and hold times of one lock site: a mutex member of a class, over
+ * every instance of the class, like the contents lock of all the TreeInodes.
+ *
+ * Recording is off by default, see setEnabled. The sites are exported as
+ * fb303 counters named "lock.<site>.wait_us.p99" and so on, and as latency
+ * histograms labeled with the lock and "wait" or "hold".
+ */
+class LockSite {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  /**
+   * Registers the site, which must live until the end of the process.
+   */
+  explicit LockSite(std::string_view name);
+
+  LockSite(const LockSite&) = delete;
+  LockSite& operator=(const LockSite&) = delete;
+
+  /**
+   * Whether the InstrumentedMutexes record their wait and hold times. When
+   * they don't, locking and unlocking costs one relaxed load more.
+   */
+  static bool isEnabled() noexcept {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  static void setEnabled(bool enabled) noexcept {
+    enabled_.store(enabled, std::memory_order_relaxed);
+  }
+
+  void addWait(Clock::duration elapsed) noexcept {
+    record(wait_, elapsed);
+  }
+
+  void addHold(Clock::duration elapsed) noexcept {
+    record(hold_, elapsed);
+  }
+
+  const std::string& getName() const {
+    return name_;
+  }
+
+  /**
+   * The wait and hold histograms of every site that recorded a lock, since
+   * the process started.
+   */
+  static std::vector<LabeledLatencyHistogram> getHistograms();
+
+ private:
+  using Buckets =
+      std::array<std::atomic<uint64_t>, LatencyHistogram::kBucketCount>;
+
+  static void record(Buckets& buckets, Clock::duration elapsed) noexcept {
+    auto us =
+        std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    buckets[LatencyHistogram::bucketOf(static_cast<uint64_t>(
+                std::max<decltype(us)>(us, 0)))]
+        .fetch_add(1, std::memory_order_relaxed);
+  }
+
+  static LatencyHistogram snapshot(const Buckets& buckets);
+
+  void registerCounters();
+
+  static std::atomic<bool> enabled_;
+
+  const std::string name_;
+  Buckets wait_{};
+  Buckets hold_{};
+};
+
+/**
+ * A mutex that records how long threads wait for it, and how long they hold
+ * it exclusively, in the LockSite named Name, when LockSite::isEnabled().
+ * It can be used as the mutex of a folly::Synchronized, and forwards the
+ * shared operations of mutexes that have them; shared holds are not timed,
+ * as a single timestamp can't track several holders.
+ *
+ * The returned values of lock and try_lock are passed back to unlock, so
+ * that mutexes like folly::DistributedMutex can be wrapped as well.
+ */
+template <typename Mutex, const char* Name>
+class InstrumentedMutex {
+ public:
+  auto lock() {
+    if (!LockSite::isEnabled()) {
+      return mutex_.lock();
+    }
+    return timedLock([this] { return mutex_.lock(); });
+  }
+
+  auto try_lock() {
+    auto locked = mutex_.try_lock();
+    if (locked && LockSite::isEnabled()) {
+      site().addWait({});
+      lockedAt_ = LockSite::Clock::now();
+    }
+    return locked;
+  }
+
+  template <typename... Args>
+  void unlock(Args&&... args) {
+    if (lockedAt_ != LockSite::Clock::time_point{}) {
+      site().addHold(LockSite::Clock::now() - lockedAt_);
+      lockedAt_ = {};
+    }
+    mutex_.unlock(std::forward<Args>(args)...);
+  }
+
+  template <typename M = Mutex>
+  auto lock_shared() -> decltype(std::declval<M&>().lock_shared()) {
+    if (!LockSite::isEnabled()) {
+      return mutex_.lock_shared();
+    }
+    auto start = LockSite::Clock::now();
+    mutex_.lock_shared();
+    site().addWait(LockSite::Clock::now() - start);
+  }
+
+  template <typename M = Mutex>
+  auto try_lock_shared() -> decltype(std::declval<M&>().try_lock_shared()) {
+    return mutex_.try_lock_shared();
+  }
+
+  template <typename M = Mutex>
+  auto unlock_shared() -> decltype(std::declval<M&>().unlock_shared()) {
+    return mutex_.unlock_shared();
+  }
+
+ private:
+  static LockSite& site() {
+    static folly::Indestructible<LockSite> site{Name};
+    return *site;
+  }
+
+  template <typename Lock>
+  auto timedLock(Lock&& lock) {
+    auto start = LockSite::Clock::now();
+    if constexpr (std::is_void_v<decltype(lock())>) {
+      lock();
+      lockedAt_ = LockSite::Clock::now();
+      site().addWait(lockedAt_ - start);
+    } else {
+      auto state = lock();
+      lockedAt_ = LockSite::Clock::now();
+      site().addWait(lockedAt_ - start);
+      return state;
+    }
+  }
+
+  Mutex mutex_;
+  // When the exclusive holder acquired the lock, if it was recorded. Only
+  // accessed by the exclusive holder.
+  LockSite::Clock::time_point lockedAt_{};
+};
+
+} // namespace facebook::eden
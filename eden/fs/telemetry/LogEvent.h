@@ -243,6 +243,7 @@ struct ServerDataFetch {
   std::optional<std::string> client_cmdline;
   std::string fetched_path;
   std::string fetched_object_type;
+  uint64_t trace_id;
 
   void populate(DynamicEvent& event) const {
     event.addString("interface", cause);
@@ -254,6 +255,7 @@ struct ServerDataFetch {
     }
     event.addString("fetched_path", fetched_path);
     event.addString("fetched_object_type", fetched_object_type);
+    event.addInt("trace_id", trace_id);
   }
 };
 
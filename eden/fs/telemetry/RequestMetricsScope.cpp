@@ -8,27 +8,93 @@
 #include "RequestMetricsScope.h"
 
 #include <algorithm>
+#include <limits>
 #include <numeric>
 
 #include <folly/String.h>
 
 #include "eden/fs/utils/Bug.h"
+#include "eden/fs/utils/CoarseClock.h"
 #include "eden/fs/utils/EnumValue.h"
 
 namespace facebook::eden {
 
-RequestMetricsScope::RequestMetricsScope() : pendingRequestWatches_{nullptr} {}
+namespace {
+// Ticks of steady_clock, plus one so that no request starts at zero. The
+// durations are reported in microseconds, but only matter when requests are
+// stuck, so the coarse time is precise enough.
+uint64_t startTime() {
+  return static_cast<uint64_t>(coarseSteadyNow().time_since_epoch().count()) +
+      1;
+}
 
-RequestMetricsScope::RequestMetricsScope(
-    LockedRequestWatchList* pendingRequestWatches)
-    : pendingRequestWatches_{pendingRequestWatches} {
-  folly::stop_watch<> watch;
-  {
-    auto startTimes = pendingRequestWatches_->wlock();
-    requestWatch_ = startTimes->insert(startTimes->end(), watch);
+// About eight cache lines of slots, and coprime with the number of slots so
+// that threads beyond the 128th start at distinct slots too.
+constexpr size_t kThreadSlotStride = 67;
+} // namespace
+
+size_t RequestMetricsScope::RequestWatchList::add() {
+  static std::atomic<size_t> nextThread{0};
+  static thread_local size_t firstSlot =
+      nextThread.fetch_add(1, std::memory_order_relaxed) * kThreadSlotStride %
+      kSlots;
+
+  auto start = startTime();
+  for (size_t i = 0; i < kSlots; ++i) {
+    auto slot = (firstSlot + i) % kSlots;
+    uint64_t expected = 0;
+    if (starts_[slot].load(std::memory_order_relaxed) == 0 &&
+        starts_[slot].compare_exchange_strong(
+            expected, start, std::memory_order_relaxed)) {
+      return slot;
+    }
+  }
+  overflowCount_.fetch_add(1, std::memory_order_relaxed);
+  return kOverflow;
+}
+
+void RequestMetricsScope::RequestWatchList::remove(size_t slot) {
+  if (slot == kOverflow) {
+    overflowCount_.fetch_sub(1, std::memory_order_relaxed);
+  } else {
+    starts_[slot].store(0, std::memory_order_relaxed);
+  }
+}
+
+size_t RequestMetricsScope::RequestWatchList::count() const {
+  size_t count = overflowCount_.load(std::memory_order_relaxed);
+  for (const auto& start : starts_) {
+    if (start.load(std::memory_order_relaxed) != 0) {
+      ++count;
+    }
   }
+  return count;
 }
 
+RequestMetricsScope::DefaultRequestDuration
+RequestMetricsScope::RequestWatchList::getMaxDuration() const {
+  auto oldest = std::numeric_limits<uint64_t>::max();
+  for (const auto& start : starts_) {
+    auto value = start.load(std::memory_order_relaxed);
+    if (value != 0) {
+      oldest = std::min(oldest, value);
+    }
+  }
+  auto now = startTime();
+  if (oldest >= now) {
+    return DefaultRequestDuration{0};
+  }
+  return DefaultRequestDuration{
+      static_cast<DefaultRequestDuration::rep>(now - oldest)};
+}
+
+RequestMetricsScope::RequestMetricsScope() : pendingRequestWatches_{nullptr} {}
+
+RequestMetricsScope::RequestMetricsScope(
+    RequestWatchList* pendingRequestWatches)
+    : pendingRequestWatches_{pendingRequestWatches},
+      requestWatch_{pendingRequestWatches_->add()} {}
+
 RequestMetricsScope::RequestMetricsScope(RequestMetricsScope&& that) noexcept
     : pendingRequestWatches_{std::exchange(
           that.pendingRequestWatches_,
@@ -37,6 +103,7 @@ RequestMetricsScope::RequestMetricsScope(RequestMetricsScope&& that) noexcept
 
 RequestMetricsScope& RequestMetricsScope::operator=(
     RequestMetricsScope&& that) noexcept {
+  reset();
   pendingRequestWatches_ = std::exchange(that.pendingRequestWatches_, nullptr);
   requestWatch_ = that.requestWatch_;
   return *this;
@@ -44,15 +111,13 @@ RequestMetricsScope& RequestMetricsScope::operator=(
 
 RequestMetricsScope::~RequestMetricsScope() {
   if (pendingRequestWatches_) {
-    auto startTimes = pendingRequestWatches_->wlock();
-    startTimes->erase(requestWatch_);
+    pendingRequestWatches_->remove(requestWatch_);
   }
 }
 
 void RequestMetricsScope::reset() {
   if (pendingRequestWatches_) {
-    auto startTimes = pendingRequestWatches_->wlock();
-    startTimes->erase(requestWatch_);
+    pendingRequestWatches_->remove(requestWatch_);
     pendingRequestWatches_ = nullptr;
   }
 }
@@ -105,10 +170,10 @@ size_t RequestMetricsScope::aggregateMetricCounters(
 
 size_t RequestMetricsScope::getMetricFromWatches(
     RequestMetric metric,
-    const LockedRequestWatchList& watches) {
+    const RequestWatchList& watches) {
   switch (metric) {
     case COUNT:
-      return watches.rlock()->size();
+      return watches.count();
     case MAX_DURATION_US:
       return static_cast<size_t>(
           std::chrono::duration_cast<std::chrono::microseconds>(
@@ -119,18 +184,8 @@ size_t RequestMetricsScope::getMetricFromWatches(
 }
 
 RequestMetricsScope::DefaultRequestDuration RequestMetricsScope::getMaxDuration(
-    const LockedRequestWatchList& watches) {
-  {
-    auto lockedWatches = watches.rlock();
-    if (lockedWatches->empty()) {
-      return RequestMetricsScope::DefaultRequestDuration{0};
-    }
-
-    // By virtue of enqueing new watches at the end of the list, the front will
-    // always be the watch that has been in the list the longest, ie: the one
-    // with the max duration.
-    return lockedWatches->front().elapsed();
-  }
+    const RequestWatchList& watches) {
+  return watches.getMaxDuration();
 }
 
 } // namespace facebook::eden
@@ -7,13 +7,13 @@
 
 #pragma once
 
-#include <list>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <memory>
 #include <string>
 
 #include <folly/String.h>
-#include <folly/Synchronized.h>
-#include <folly/stop_watch.h>
 
 namespace facebook::eden {
 
@@ -27,13 +27,55 @@ namespace facebook::eden {
  */
 class RequestMetricsScope {
  public:
-  using RequestWatchList = std::list<folly::stop_watch<>>;
-  using LockedRequestWatchList = folly::Synchronized<RequestWatchList>;
   using DefaultRequestDuration =
       std::chrono::steady_clock::steady_clock::duration;
 
+  /**
+   * The start times of the requests in flight, which are only read when
+   * collecting stats.
+   *
+   * Tracking a request must be cheap, as it's done for every import and
+   * filesystem request, so the list is a fixed array of slots rather than a
+   * locked container: a request claims a free slot with a compare-and-swap
+   * and clears it when it's done, and each thread starts looking for a free
+   * slot at a different index, so that threads don't contend on the same
+   * cache lines. Requests started while every slot is taken are only counted,
+   * and don't contribute to the maximum duration, which is the duration of
+   * an older request anyway.
+   */
+  class RequestWatchList {
+   public:
+    static constexpr size_t kSlots = 1024;
+    static constexpr size_t kOverflow = kSlots;
+
+    RequestWatchList() = default;
+    RequestWatchList(const RequestWatchList&) = delete;
+    RequestWatchList& operator=(const RequestWatchList&) = delete;
+
+    /**
+     * Records the start of a request, and returns the slot to pass to
+     * remove() when it's done.
+     */
+    size_t add();
+    void remove(size_t slot);
+
+    size_t count() const;
+
+    /**
+     * The time elapsed since the start of the oldest request, or zero if
+     * there are none.
+     */
+    DefaultRequestDuration getMaxDuration() const;
+
+   private:
+    // Start times in steady_clock ticks, plus one so that zero marks a free
+    // slot.
+    std::atomic<uint64_t> starts_[kSlots]{};
+    std::atomic<size_t> overflowCount_{0};
+  };
+
   RequestMetricsScope();
-  explicit RequestMetricsScope(LockedRequestWatchList* pendingRequestWatches);
+  explicit RequestMetricsScope(RequestWatchList* pendingRequestWatches);
   RequestMetricsScope(const RequestMetricsScope&) = delete;
   RequestMetricsScope& operator=(const RequestMetricsScope&) = delete;
   RequestMetricsScope(RequestMetricsScope&&) noexcept;
@@ -96,17 +138,17 @@ class RequestMetricsScope {
    */
   static size_t getMetricFromWatches(
       RequestMetric metric,
-      const LockedRequestWatchList& watches);
+      const RequestWatchList& watches);
 
   /**
    * finds the watch in `watches` for which the time that has elapsed
    * is the greatest and returns the duration of time that has elapsed
    */
   static DefaultRequestDuration getMaxDuration(
-      const LockedRequestWatchList& watches);
+      const RequestWatchList& watches);
 
  private:
-  LockedRequestWatchList* pendingRequestWatches_;
-  RequestWatchList::iterator requestWatch_;
+  RequestWatchList* pendingRequestWatches_;
+  size_t requestWatch_{0};
 }; // namespace eden
 } // namespace facebook::eden
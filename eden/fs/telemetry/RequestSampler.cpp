@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/RequestSampler.h"
+
+#include <fmt/format.h>
+#include <folly/container/F14Map.h>
+#include <folly/hash/Hash.h>
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+namespace facebook::eden {
+
+namespace {
+
+constexpr std::array<std::string_view, kRequestPhaseCount> kPhaseNames = {
+    "objectstore",
+    "localstore",
+    "datapack",
+    "hgimportqueue",
+};
+
+} // namespace
+
+std::string RequestPhases::getFoldedStack() const {
+  std::string stack;
+  stack.reserve(64);
+  stack.append(channel_);
+  stack.push_back(';');
+  stack.append(op_);
+  for (size_t phase = 0; phase < kRequestPhaseCount; ++phase) {
+    if (active_[phase].load(std::memory_order_relaxed) != 0) {
+      stack.push_back(';');
+      stack.append(kPhaseNames[phase]);
+    }
+  }
+  return stack;
+}
+
+RequestSampler::RequestSampler() : samples_{kMaxSamples} {}
+
+RequestSampler::Shard& RequestSampler::getShard(const RequestPhases& request) {
+  return inFlight_[folly::hash::twang_mix64(
+                       reinterpret_cast<uintptr_t>(&request)) %
+                   kShards];
+}
+
+void RequestSampler::add(RequestPhases& request) {
+  getShard(request).lock()->insert(&request);
+}
+
+void RequestSampler::remove(RequestPhases& request) {
+  getShard(request).lock()->erase(&request);
+}
+
+void RequestSampler::sample() {
+  std::vector<std::string> stacks;
+  for (auto& shard : inFlight_) {
+    auto requests = shard.lock();
+    for (const auto* request : *requests) {
+      stacks.push_back(request->getFoldedStack());
+    }
+  }
+  // Outside of the locks, so that the requests don't wait on the buffer.
+  for (auto& stack : stacks) {
+    samples_.addEvent(std::move(stack));
+  }
+}
+
+std::string RequestSampler::getFoldedStacks() const {
+  folly::F14FastMap<std::string, uint64_t> counts;
+  for (auto& stack : samples_.getAllEvents()) {
+    ++counts[std::move(stack)];
+  }
+  std::vector<std::pair<std::string, uint64_t>> sorted{
+      counts.begin(), counts.end()};
+  std::sort(sorted.begin(), sorted.end());
+
+  std::string folded;
+  for (const auto& [stack, count] : sorted) {
+    fmt::format_to(std::back_inserter(folded), "{} {}\n", stack, count);
+  }
+  return folded;
+}
+
+RequestSampler& getRequestSampler() {
+  static RequestSampler sampler;
+  return sampler;
+}
+
+} // namespace facebook::eden
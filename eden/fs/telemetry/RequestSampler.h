@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/F14Set.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include "eden/fs/telemetry/ActivityBuffer.h"
+
+namespace facebook::eden {
+
+/**
+ * The layers below the filesystem channels that a request can wait on, in
+ * the order they call each other.
+ */
+enum class RequestPhase : uint8_t {
+  ObjectStore,
+  LocalStore,
+  Datapack,
+  HgImportQueue,
+};
+
+constexpr size_t kRequestPhaseCount = 4;
+
+/**
+ * The phases an in-flight filesystem request is currently in.
+ *
+ * A request can wait on several objects at once, in different layers, so
+ * every phase counts how many of its operations are active rather than
+ * maintaining a stack. Entering and leaving a phase is an uncontended
+ * relaxed atomic operation.
+ */
+class RequestPhases {
+ public:
+  /**
+   * The names must outlive the registration of the request with the
+   * RequestSampler.
+   */
+  void setName(std::string_view channel, std::string_view op) noexcept {
+    channel_ = channel;
+    op_ = op;
+  }
+
+  void enter(RequestPhase phase) noexcept {
+    active_[static_cast<size_t>(phase)].fetch_add(
+        1, std::memory_order_relaxed);
+  }
+
+  void leave(RequestPhase phase) noexcept {
+    active_[static_cast<size_t>(phase)].fetch_sub(
+        1, std::memory_order_relaxed);
+  }
+
+  /**
+   * The channel, the op and the active phases, outermost first, separated by
+   * semicolons like a frame of a folded stack.
+   */
+  std::string getFoldedStack() const;
+
+ private:
+  std::string_view channel_;
+  std::string_view op_;
+  std::array<std::atomic<uint32_t>, kRequestPhaseCount> active_{};
+};
+
+/**
+ * Periodically samples the phases of every in-flight filesystem request into
+ * a ring buffer, to see where the wall time of the requests goes without
+ * attaching a profiler: a phase that shows up in many samples is one the
+ * requests spend a lot of time in.
+ */
+class RequestSampler {
+ public:
+  static constexpr uint32_t kMaxSamples = 64 * 1024;
+
+  RequestSampler();
+
+  RequestSampler(const RequestSampler&) = delete;
+  RequestSampler& operator=(const RequestSampler&) = delete;
+
+  /**
+   * While disabled, the requests are not registered.
+   */
+  bool isEnabled() const noexcept {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  void setEnabled(bool enabled) noexcept {
+    enabled_.store(enabled, std::memory_order_relaxed);
+  }
+
+  void add(RequestPhases& request);
+  void remove(RequestPhases& request);
+
+  /**
+   * Records one sample of every registered request.
+   */
+  void sample();
+
+  /**
+   * Aggregates the samples in the ring buffer as folded stacks: one
+   * "channel;op;phase... count" line per distinct stack, the input format of
+   * flamegraph.pl.
+   */
+  std::string getFoldedStacks() const;
+
+ private:
+  static constexpr size_t kShards = 16;
+
+  using Shard = folly::Synchronized<
+      folly::F14FastSet<const RequestPhases*>,
+      std::mutex>;
+
+  Shard& getShard(const RequestPhases& request);
+
+  std::atomic<bool> enabled_{false};
+  std::array<Shard, kShards> inFlight_;
+  ActivityBuffer<std::string> samples_;
+};
+
+/**
+ * The RequestSampler of the process, which all filesystem requests register
+ * with.
+ */
+RequestSampler& getRequestSampler();
+
+} // namespace facebook::eden
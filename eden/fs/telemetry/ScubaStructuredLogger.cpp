@@ -9,6 +9,7 @@
 
 #include <folly/json.h>
 #include <folly/logging/xlog.h>
+#include <folly/system/ThreadName.h>
 #include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/telemetry/SubprocessScribeLogger.h"
 
@@ -25,15 +26,129 @@ folly::dynamic dynamicMap(const std::unordered_map<Key, Value>& map) {
   return o;
 }
 
+/**
+ * The columns of the given kind of value of the events, each one holding a
+ * value per event, or null.
+ */
+template <typename GetMap>
+folly::dynamic dynamicColumns(
+    const std::vector<DynamicEvent>& events,
+    GetMap getMap) {
+  folly::dynamic o = folly::dynamic::object;
+  for (size_t row = 0; row < events.size(); ++row) {
+    for (const auto& [key, value] : getMap(events[row])) {
+      auto& column = o.setDefault(key, folly::dynamic::array());
+      while (column.size() < row) {
+        column.push_back(nullptr);
+      }
+      column.push_back(value);
+    }
+  }
+  for (auto& column : o.values()) {
+    while (column.size() < events.size()) {
+      column.push_back(nullptr);
+    }
+  }
+  return o;
+}
+
 } // namespace
 
 ScubaStructuredLogger::ScubaStructuredLogger(
     std::shared_ptr<ScribeLogger> scribeLogger,
-    SessionInfo sessionInfo)
+    SessionInfo sessionInfo,
+    BatchOptions batchOptions)
     : StructuredLogger{true, std::move(sessionInfo)},
-      scribeLogger_{std::move(scribeLogger)} {}
+      scribeLogger_{std::move(scribeLogger)},
+      batchOptions_{batchOptions},
+      threadBatches_{[this] { return new ThreadBatch{*this}; }} {
+  if (batchOptions_.maxEvents > 1) {
+    flusher_ = std::thread{[this] {
+      folly::setThreadName("ScubaBatchFlusher");
+      flusherThread();
+    }};
+  }
+}
+
+ScubaStructuredLogger::~ScubaStructuredLogger() {
+  if (flusher_.joinable()) {
+    *stopping_.lock() = true;
+    stop_.notify_one();
+    flusher_.join();
+  }
+  flush();
+}
+
+ScubaStructuredLogger::ThreadBatch::~ThreadBatch() {
+  flush();
+}
+
+void ScubaStructuredLogger::ThreadBatch::add(DynamicEvent event) {
+  std::vector<DynamicEvent> full;
+  {
+    auto events = events_.lock();
+    events->push_back(std::move(event));
+    if (events->size() < logger_.batchOptions_.maxEvents) {
+      return;
+    }
+    full.swap(*events);
+  }
+  logger_.writeBatch(full);
+}
+
+void ScubaStructuredLogger::ThreadBatch::flush() {
+  std::vector<DynamicEvent> events;
+  events_.lock()->swap(events);
+  if (!events.empty()) {
+    logger_.writeBatch(events);
+  }
+}
+
+void ScubaStructuredLogger::flush() {
+  for (auto& batch : threadBatches_.accessAllThreads()) {
+    batch.flush();
+  }
+}
+
+void ScubaStructuredLogger::flusherThread() {
+  auto stopping = stopping_.lock();
+  while (!*stopping) {
+    stop_.wait_for(
+        stopping.as_lock(), batchOptions_.maxDelay, [&] { return *stopping; });
+    if (*stopping) {
+      return;
+    }
+    stopping.unlock();
+    flush();
+    stopping = stopping_.lock();
+  }
+}
+
+void ScubaStructuredLogger::writeBatch(
+    const std::vector<DynamicEvent>& events) {
+  folly::dynamic document = folly::dynamic::object;
+  document["rows"] = events.size();
+  document["int"] = dynamicColumns(
+      events, [](const DynamicEvent& event) -> const DynamicEvent::IntMap& {
+        return event.getIntMap();
+      });
+  document["normal"] = dynamicColumns(
+      events, [](const DynamicEvent& event) -> const DynamicEvent::StringMap& {
+        return event.getStringMap();
+      });
+  document["double"] = dynamicColumns(
+      events, [](const DynamicEvent& event) -> const DynamicEvent::DoubleMap& {
+        return event.getDoubleMap();
+      });
+  scribeLogger_->log(folly::toJson(document));
+}
 
 void ScubaStructuredLogger::logDynamicEvent(DynamicEvent event) {
+  if (batchOptions_.maxEvents > 1) {
+    threadBatches_->add(std::move(event));
+    return;
+  }
+
   folly::dynamic document = folly::dynamic::object;
 
   const auto& intMap = event.getIntMap();
@@ -7,7 +7,13 @@
 
 #pragma once
 
+#include <folly/Synchronized.h>
+#include <folly/ThreadLocal.h>
+#include <chrono>
+#include <condition_variable>
 #include <memory>
+#include <thread>
+#include <vector>
 #include "eden/fs/telemetry/StructuredLogger.h"
 
 namespace facebook::eden {
@@ -17,14 +23,70 @@ class ScribeLogger;
 
 class ScubaStructuredLogger final : public StructuredLogger {
  public:
+  struct BatchOptions {
+    /**
+     * The maximum number of events of a batch. 0 or 1 disables batching:
+     * every event is written as its own JSON document.
+     */
+    size_t maxEvents{0};
+    /**
+     * The maximum time an event waits in a batch before it is written.
+     */
+    std::chrono::nanoseconds maxDelay{std::chrono::seconds{1}};
+  };
+
   ScubaStructuredLogger(
       std::shared_ptr<ScribeLogger> scribeLogger,
-      SessionInfo sessionInfo);
+      SessionInfo sessionInfo,
+      BatchOptions batchOptions = {});
+
+  ~ScubaStructuredLogger() override;
+
+  /**
+   * Writes the events batched by every thread.
+   */
+  void flush();
 
  private:
+  /**
+   * The events logged by one thread and not written yet. Only contended when
+   * flushed by another thread.
+   */
+  class ThreadBatch {
+   public:
+    explicit ThreadBatch(ScubaStructuredLogger& logger) : logger_{logger} {}
+    ~ThreadBatch();
+
+    void add(DynamicEvent event);
+    void flush();
+
+   private:
+    ScubaStructuredLogger& logger_;
+    folly::Synchronized<std::vector<DynamicEvent>, std::mutex> events_;
+  };
+
+  class ThreadLocalTag {};
+
   void logDynamicEvent(DynamicEvent event) override;
 
+  /**
+   * Writes the events as a single JSON document whose columns hold the
+   * values of every event, or null where an event doesn't have the column.
+   */
+  void writeBatch(const std::vector<DynamicEvent>& events);
+
+  void flusherThread();
+
   std::shared_ptr<ScribeLogger> scribeLogger_;
+  const BatchOptions batchOptions_;
+
+  folly::Synchronized<bool, std::mutex> stopping_{false};
+  std::condition_variable stop_;
+  std::thread flusher_;
+
+  // Declared last, so that it is destroyed first: the ThreadBatches write
+  // their remaining events when destroyed.
+  folly::ThreadLocal<ThreadBatch, ThreadLocalTag> threadBatches_;
 };
 
 } // namespace facebook::eden
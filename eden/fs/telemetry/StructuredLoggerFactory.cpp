@@ -36,8 +36,11 @@ std::unique_ptr<StructuredLogger> makeDefaultStructuredLogger(
 #ifndef _WIN32
   auto logger =
       std::make_unique<SubprocessScribeLogger>(binary.c_str(), category);
+  ScubaStructuredLogger::BatchOptions batchOptions;
+  batchOptions.maxEvents = config.scribeBatchSize.getValue();
+  batchOptions.maxDelay = config.scribeBatchInterval.getValue();
   return std::make_unique<ScubaStructuredLogger>(
-      std::move(logger), std::move(sessionInfo));
+      std::move(logger), std::move(sessionInfo), batchOptions);
 #else
   (void)sessionInfo;
   return std::make_unique<NullStructuredLogger>();
@@ -5,33 +5,43 @@
  * GNU General Public License version 2.
  */
 
+#include <folly/lang/Bits.h>
 #include <folly/logging/xlog.h>
 #include <folly/system/ThreadName.h>
+#include <algorithm>
+#include <new>
 
 namespace facebook::eden {
 
 template <typename TraceEvent>
 std::shared_ptr<TraceBus<TraceEvent>> TraceBus<TraceEvent>::create(
     std::string name,
-    size_t bufferCapacity) {
+    size_t bufferCapacity,
+    OverflowPolicy overflowPolicy) {
   return std::make_shared<TraceBus<TraceEvent>>(
-      PrivateConstructorTag{}, std::move(name), bufferCapacity);
+      PrivateConstructorTag{}, std::move(name), bufferCapacity, overflowPolicy);
 }
 
 template <typename TraceEvent>
 TraceBus<TraceEvent>::TraceBus(
     PrivateConstructorTag,
     std::string name,
-    size_t bufferCapacity)
-    : name_{std::move(name)}, bufferCapacity_{bufferCapacity} {
-  XCHECK_GT(bufferCapacity_, 0u) << "Buffer capacity must not be zero";
+    size_t bufferCapacity,
+    OverflowPolicy overflowPolicy)
+    : name_{std::move(name)},
+      bufferCapacity_{folly::nextPowTwo(std::max<size_t>(bufferCapacity, 2))},
+      overflowPolicy_{overflowPolicy},
+      ring_{std::make_unique<Slot[]>(bufferCapacity_)} {
+  XCHECK_GT(bufferCapacity, 0u) << "Buffer capacity must not be zero";
 
-  state_.unsafeGetUnlocked().writeBuffer.reserve(bufferCapacity_);
+  for (size_t i = 0; i < bufferCapacity_; ++i) {
+    ring_[i].sequence.store(i, std::memory_order_relaxed);
+  }
 
   // Allocate the backbuffer here rather than in the thread so std::bad_alloc
   // can be caught.
   std::vector<TraceEvent> readBuffer;
-  readBuffer.reserve(bufferCapacity);
+  readBuffer.reserve(bufferCapacity_);
 
   std::string threadName = "tracebus-" + name_;
 
@@ -67,29 +77,61 @@ void TraceBus<TraceEvent>::publish(const TraceEvent& event) noexcept {
 template <typename TraceEvent>
 void TraceBus<TraceEvent>::publish(TraceEvent&& event) noexcept {
   static_assert(std::is_nothrow_move_constructible_v<TraceEvent>);
+  static_assert(std::is_nothrow_destructible_v<TraceEvent>);
 
-  bool wake;
-  {
-    auto state = state_.lock();
-    XCHECK(!state->done) << "Illegal to publish concurrently with destruction";
-    if (state->writeBuffer.size() == bufferCapacity_) {
-      // If the buffer is full then the capacity is potentially set too low. Log
-      // an appropriate warning and then block until we have room to append the
-      // current event.
+  const uint64_t mask = bufferCapacity_ - 1;
+  uint64_t ticket = tail_.load(std::memory_order_relaxed);
+  Slot* slot;
+  while (true) {
+    slot = &ring_[ticket & mask];
+    auto sequence = slot->sequence.load(std::memory_order_acquire);
+    if (sequence == ticket) {
+      // The slot is free: claim it. On failure, ticket is reloaded.
+      if (tail_.compare_exchange_weak(
+              ticket, ticket + 1, std::memory_order_seq_cst)) {
+        break;
+      }
+    } else if (sequence < ticket) {
+      // The slot still holds the event published bufferCapacity_ tickets
+      // ago: the buffer is full. If it is then the capacity is potentially set
+      // too low. Log an appropriate warning and then either drop the event or
+      // block until we have room to append it.
       logFullOnce();
-      fullCV_.wait(state.as_lock(), [&] {
-        return state->writeBuffer.size() < bufferCapacity_;
-      });
+      if (overflowPolicy_ == OverflowPolicy::Drop) {
+        droppedEvents_.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+      waitForSlot(ticket);
+      ticket = tail_.load(std::memory_order_relaxed);
+    } else {
+      // Another publisher claimed the ticket first.
+      ticket = tail_.load(std::memory_order_relaxed);
     }
-    wake = state->writeBuffer.empty();
-    state->writeBuffer.push_back(std::move(event));
-    state->sequenceNumber++;
   }
-  if (wake) {
+
+  new (slot->storage) TraceEvent{std::move(event)};
+  slot->sequence.store(ticket + 1, std::memory_order_release);
+
+  // Pairs with the store of consumerWaiting_ and the load of tail_ in
+  // threadLoop: either it sees the claimed ticket, or this sees it waiting.
+  if (consumerWaiting_.load(std::memory_order_seq_cst)) {
+    auto state = state_.lock();
+    XCHECK(!state->done) << "Illegal to publish concurrently with destruction";
     emptyCV_.notify_one();
   }
 }
 
+template <typename TraceEvent>
+void TraceBus<TraceEvent>::waitForSlot(uint64_t ticket) noexcept {
+  auto& slot = ring_[ticket & (bufferCapacity_ - 1)];
+  auto state = state_.lock();
+  waitingPublishers_.fetch_add(1, std::memory_order_seq_cst);
+  fullCV_.wait(state.as_lock(), [&] {
+    return slot.sequence.load(std::memory_order_seq_cst) >= ticket;
+  });
+  waitingPublishers_.fetch_sub(1, std::memory_order_relaxed);
+}
+
 template <typename TraceEvent>
 TraceSubscriptionHandle<TraceEvent> TraceBus<TraceEvent>::subscribe(
     std::shared_ptr<Subscriber> subscriber) {
@@ -108,7 +150,7 @@ void TraceBus<TraceEvent>::unsubscribe(void* subscription) noexcept {
 
   auto state = state_.lock();
   // Signal to threadLoop that `sub` should be deleted.
-  sub->unsubscribe = state->sequenceNumber;
+  sub->unsubscribe = tail_.load(std::memory_order_acquire) + 1;
 
   // At this point, the memory referenced by `sub` must not be accessed as it
   // may be deleted at any moment.
@@ -118,8 +160,10 @@ template <typename TraceEvent>
 void TraceBus<TraceEvent>::logFullOnce() noexcept {
   folly::call_once(logIfFullFlag_, [&]() noexcept {
     try {
-      XLOG(WARN) << "TraceBus(" << name_ << ") is full; blocking. Is capacity "
-                 << bufferCapacity_ << " sufficient?";
+      XLOG(WARN) << "TraceBus(" << name_ << ") is full; "
+                 << (overflowPolicy_ == OverflowPolicy::Drop ? "dropping"
+                                                             : "blocking")
+                 << ". Is capacity " << bufferCapacity_ << " sufficient?";
     } catch (std::exception& e) {
       fprintf(
           stderr,
@@ -134,18 +178,49 @@ void TraceBus<TraceEvent>::logFullOnce() noexcept {
   });
 }
 
+template <typename TraceEvent>
+uint64_t TraceBus<TraceEvent>::drain(
+    uint64_t head,
+    std::vector<TraceEvent>& readBuffer) noexcept {
+  const uint64_t mask = bufferCapacity_ - 1;
+  while (readBuffer.size() < bufferCapacity_) {
+    auto& slot = ring_[head & mask];
+    // Stop at the first slot that was claimed but not written yet, to keep
+    // the events in order.
+    if (slot.sequence.load(std::memory_order_acquire) != head + 1) {
+      break;
+    }
+    readBuffer.push_back(std::move(*slot.event()));
+    slot.event()->~TraceEvent();
+    slot.sequence.store(head + bufferCapacity_, std::memory_order_release);
+    ++head;
+  }
+
+  // Pairs with the increment of waitingPublishers_ in waitForSlot: either it
+  // sees the drained slots, or this sees it waiting.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!readBuffer.empty() &&
+      waitingPublishers_.load(std::memory_order_relaxed) != 0) {
+    auto state = state_.lock();
+    fullCV_.notify_all();
+  }
+  return head;
+}
+
 template <typename TraceEvent>
 void TraceBus<TraceEvent>::threadLoop(
     std::vector<TraceEvent>& readBuffer) noexcept {
   // This function does no allocation and throws no exceptions.
 
+  // The ticket of the next event to observe. Every event before it has been
+  // observed by all the subscriptions.
+  uint64_t head = 0;
   bool done = false;
-  uint64_t lastObservedSequenceNumber = 0;
   while (!done) {
     XCHECK(readBuffer.empty())
         << "Avoid waiting while holding references to things";
 
-    Subscription* head;
+    Subscription* subscriptions;
     {
       auto state = state_.lock();
 
@@ -159,7 +234,7 @@ void TraceBus<TraceEvent>::threadLoop(
       while (p) {
         Subscription** nlink = &p->next;
         Subscription* next = *nlink;
-        if (p->unsubscribe && p->unsubscribe <= lastObservedSequenceNumber) {
+        if (p->unsubscribe && p->unsubscribe <= head + 1) {
           // Here, we know this subscription has seen events up to (and possibly
           // beyond) its unsubscription request, so unlink it.
           *plink = *nlink;
@@ -173,32 +248,37 @@ void TraceBus<TraceEvent>::threadLoop(
         p = next;
       }
 
-      // TODO: If it were safe to access Subscription::unsubscribe when the lock
-      // weren't held, it would be possible to check the unsubscribe sequence
-      // number in the event iteration loop below and short-circuit observation
-      // of events published after unsubscription.
-      //
-      // This probably isn't important.
-      lastObservedSequenceNumber = state->sequenceNumber;
-
-      // If no events are buffered, sleep until events are delivered or we are
-      // signaled to terminate.
+      // If no events are published, sleep until events are delivered or we
+      // are signaled to terminate. The predicate runs with the lock held, so
+      // a publisher that sees consumerWaiting_ can't notify before the wait.
+      consumerWaiting_.store(true, std::memory_order_seq_cst);
       emptyCV_.wait(state.as_lock(), [&] {
-        return state->done || !state->writeBuffer.empty();
+        return state->done || tail_.load(std::memory_order_seq_cst) != head;
       });
-      std::swap(state->writeBuffer, readBuffer);
+      consumerWaiting_.store(false, std::memory_order_relaxed);
+      // Publishing concurrently with destruction is illegal, so once done is
+      // set, the events left are the last ones.
       done = state->done;
 
-      head = state->subscriptions;
+      subscriptions = state->subscriptions;
     }
 
-    // If the publish buffer filled, it's possible a publisher is waiting for
-    // space, so wake them.
-    if (readBuffer.size() == bufferCapacity_) {
-      fullCV_.notify_all();
+    // A publisher may have claimed a slot without having written the event
+    // yet. It will shortly, wait for it rather than sleeping.
+    auto published = tail_.load(std::memory_order_acquire);
+    while (true) {
+      head = drain(head, readBuffer);
+      if (!readBuffer.empty() || head == published) {
+        break;
+      }
+      std::this_thread::yield();
+    }
+    if (done && head != tail_.load(std::memory_order_acquire)) {
+      // Observe the rest on the next iteration.
+      done = false;
     }
 
-    for (auto* sub = head; sub; sub = sub->next) {
+    for (auto* sub = subscriptions; sub; sub = sub->next) {
       if (sub->hasThrownException) {
         continue;
       }
@@ -10,10 +10,13 @@
 #include <folly/Synchronized.h>
 #include <folly/synchronization/CallOnce.h>
 #include <stdint.h>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <memory>
 #include <thread>
 #include <utility>
+#include <vector>
 
 namespace facebook::eden {
 
@@ -137,10 +140,18 @@ class TraceSubscriptionHandle {
 };
 
 /**
- * TraceBus is a reliable, fixed-capacity event trace that runs subscription
- * callbacks on a background thread. It is intended for lightweight telemetry
- * computation: if the subscriptions perform heavy computation and events are
- * submitted more frequently than they're processed, publish() will block.
+ * TraceBus is a fixed-capacity event trace that runs subscription callbacks on
+ * a background thread. It is intended for lightweight telemetry computation:
+ * if the subscriptions perform heavy computation and events are submitted more
+ * frequently than they're processed, publish() will block, or drop the event
+ * if the TraceBus was created with OverflowPolicy::Drop.
+ *
+ * Publishing doesn't take a lock: the events go to a ring buffer in which a
+ * publisher claims a slot with a single compare-and-swap of the tail index,
+ * and the background thread drains them in batches, in the order of the
+ * slots. Unlike per-thread buffers, this keeps the events of different
+ * threads in the order they were published, which the subscribers that match
+ * the start and the end of a request rely on.
  *
  * Note: this blocking behavior then waits for subscribers to finish processing
  * events, and if any locks are held that are subsequently attempted to be
@@ -148,11 +159,11 @@ class TraceSubscriptionHandle {
  * rule one should try to avoid publishing to tracebus while holding any locks
  * and should be very careful when subscribers attempt to acquire locks.
  *
- * The capacity should be selected based on the expected usage in context.
- * Memory usage will be capacity * sizeof(TraceEvent) * 2, but a capacity too
- * small will block publishers. The buffer is not intended to prevent all
- * publishers from blocking, but to absorb latency in the case that subscribers
- * briefly cannot keep up.
+ * The capacity should be selected based on the expected usage in context. It
+ * is rounded up to a power of two, and memory usage will be about capacity *
+ * sizeof(TraceEvent) * 2, but a capacity too small will block publishers. The
+ * buffer is not intended to prevent all publishers from blocking, but to
+ * absorb latency in the case that subscribers briefly cannot keep up.
  *
  * Ideally, capacity would be dynamically determined with algorithms similar to
  * network protocols, but a small fixed-size buffer should be sufficient.
@@ -165,6 +176,17 @@ class TraceBus : public std::enable_shared_from_this<TraceBus<TraceEvent>> {
   using Subscriber = TraceEventSubscriber<TraceEvent>;
   using SubscriptionHandle = TraceSubscriptionHandle<TraceEvent>;
 
+  /**
+   * What publish() does when the buffer is full.
+   */
+  enum class OverflowPolicy {
+    // Wait for the background thread to make room. No event is lost.
+    Block,
+    // Drop the event and count it, for the buses whose subscribers can
+    // tolerate missing events, so that tracing never slows the publishers.
+    Drop,
+  };
+
   /**
    * Creates a TraceBus. Returns a shared_ptr because the implementation relies
    * on weak_ptr, but in reality the strong reference count will stay at one,
@@ -174,7 +196,8 @@ class TraceBus : public std::enable_shared_from_this<TraceBus<TraceEvent>> {
    */
   static std::shared_ptr<TraceBus> create(
       std::string name,
-      size_t bufferCapacity);
+      size_t bufferCapacity,
+      OverflowPolicy overflowPolicy = OverflowPolicy::Block);
 
   /**
    * Use `create` instead. TraceBus must be managed by shared_ptr.
@@ -182,7 +205,8 @@ class TraceBus : public std::enable_shared_from_this<TraceBus<TraceEvent>> {
   TraceBus(
       PrivateConstructorTag,
       std::string threadName,
-      size_t bufferCapacity);
+      size_t bufferCapacity,
+      OverflowPolicy overflowPolicy);
 
   /**
    * Blocks until all published events have been observed by all registered
@@ -233,6 +257,14 @@ class TraceBus : public std::enable_shared_from_this<TraceBus<TraceEvent>> {
         std::move(name), std::forward<Fn>(fn)));
   };
 
+  /**
+   * The number of events dropped because the buffer was full. Always zero
+   * with OverflowPolicy::Block.
+   */
+  uint64_t getDroppedEventCount() const noexcept {
+    return droppedEvents_.load(std::memory_order_relaxed);
+  }
+
   TraceBus(TraceBus&&) = delete;
   TraceBus(const TraceBus&) = delete;
   TraceBus& operator=(TraceBus&&) = delete;
@@ -249,7 +281,18 @@ class TraceBus : public std::enable_shared_from_this<TraceBus<TraceEvent>> {
 
   void logFullOnce() noexcept;
 
-  void threadLoop(std::vector<TraceEvent>& readbuffer) noexcept;
+  void threadLoop(std::vector<TraceEvent>& readBuffer) noexcept;
+
+  /**
+   * Moves the events that are ready, in order, from the ring buffer to
+   * readBuffer, up to its capacity. Returns the index of the next event.
+   */
+  uint64_t drain(uint64_t head, std::vector<TraceEvent>& readBuffer) noexcept;
+
+  /**
+   * Blocks the publisher of ticket until its slot was drained.
+   */
+  void waitForSlot(uint64_t ticket) noexcept;
 
   struct Subscription {
     const std::shared_ptr<Subscriber> subscriber;
@@ -257,9 +300,8 @@ class TraceBus : public std::enable_shared_from_this<TraceBus<TraceEvent>> {
     // Accessed only on background thread. Set if the subscriber throws.
     bool hasThrownException = false;
 
-    // If nonzero, unsubscription has been requested after the corresponding
-    // sequenceNumber events have been observed. Only written or read while the
-    // lock is held.
+    // If nonzero, unsubscription has been requested once unsubscribe - 1
+    // events had been published. Only written or read while the lock is held.
     uint64_t unsubscribe = 0;
 
     // Subscriptions form a linked list. Subscriptions insert to the head of the
@@ -270,21 +312,44 @@ class TraceBus : public std::enable_shared_from_this<TraceBus<TraceEvent>> {
     Subscription* next = nullptr;
   };
 
+  /**
+   * A slot of the ring buffer. The sequence number tells the state of the
+   * slot: it is free for the publisher of ticket N when equal to N, and holds
+   * the event of ticket N, ready to be drained, when equal to N + 1.
+   */
+  struct Slot {
+    std::atomic<uint64_t> sequence;
+    alignas(TraceEvent) unsigned char storage[sizeof(TraceEvent)];
+
+    TraceEvent* event() noexcept {
+      return reinterpret_cast<TraceEvent*>(storage);
+    }
+  };
+
   struct State {
     bool done = false;
     Subscription* subscriptions = nullptr;
-    std::vector<TraceEvent> writeBuffer;
-    // Incremented every publish()
-    uint64_t sequenceNumber = 1;
   };
 
   const std::string name_;
+  // A power of two, at least 2 for the sequence numbers to be unambiguous.
   const size_t bufferCapacity_;
+  const OverflowPolicy overflowPolicy_;
+  const std::unique_ptr<Slot[]> ring_;
+
+  // The next ticket a publisher will claim.
+  std::atomic<uint64_t> tail_{0};
+  std::atomic<uint64_t> droppedEvents_{0};
+  // Set while the background thread waits for events.
+  std::atomic<bool> consumerWaiting_{false};
+  // The number of publishers blocked on a full buffer.
+  std::atomic<size_t> waitingPublishers_{0};
 
   folly::Synchronized<State, std::mutex> state_;
-  // Encodes the condition done || !writeBuffer.empty()
+  // Signaled when events are published while consumerWaiting_ is set, or
+  // when done is set.
   std::condition_variable emptyCV_;
-  // Encodes the condition writeBuffer.size() < bufferCapacity_
+  // Signaled when slots are drained while waitingPublishers_ is nonzero.
   std::condition_variable fullCV_;
   folly::once_flag logIfFullFlag_;
   std::thread thread_;
@@ -7,6 +7,9 @@
 
 #include "eden/fs/telemetry/ActivityBuffer.h"
 #include <folly/portability/GTest.h>
+#include <memory>
+#include <thread>
+#include <vector>
 
 using namespace facebook::eden;
 namespace {
@@ -63,3 +66,50 @@ TEST(ActivityBufferTest, add_exceed_capacity) {
     EXPECT_TRUE(buffer_contains_int(buff, i));
   }
 }
+
+TEST(ActivityBufferTest, events_are_returned_oldest_first) {
+  ActivityBuffer<int> buff(kMaxBufLength);
+  for (int i = 1; i <= 25; i++) {
+    buff.addEvent(i);
+  }
+
+  auto events = buff.getAllEvents();
+  ASSERT_EQ(kMaxBufLength, events.size());
+  for (int i = 0; i < static_cast<int>(kMaxBufLength); i++) {
+    EXPECT_EQ(16 + i, events[i]);
+  }
+}
+
+TEST(ActivityBufferTest, evicted_events_are_destroyed) {
+  ActivityBuffer<std::shared_ptr<int>> buff(1);
+  auto first = std::make_shared<int>(1);
+  buff.addEvent(first);
+  EXPECT_EQ(2, first.use_count());
+  buff.addEvent(std::make_shared<int>(2));
+  EXPECT_EQ(1, first.use_count());
+}
+
+TEST(ActivityBufferTest, concurrent_writers_and_readers) {
+  constexpr int kWriters = 4;
+  constexpr int kEventsPerWriter = 10000;
+  ActivityBuffer<std::shared_ptr<int>> buff(kMaxBufLength);
+
+  std::vector<std::thread> writers;
+  for (int writer = 0; writer < kWriters; writer++) {
+    writers.emplace_back([&buff] {
+      for (int i = 0; i < kEventsPerWriter; i++) {
+        buff.addEvent(std::make_shared<int>(i));
+      }
+    });
+  }
+  for (int i = 0; i < 1000; i++) {
+    for (const auto& event : buff.getAllEvents()) {
+      EXPECT_LT(*event, kEventsPerWriter);
+    }
+  }
+  for (auto& writer : writers) {
+    writer.join();
+  }
+
+  EXPECT_EQ(kMaxBufLength, buff.getAllEvents().size());
+}
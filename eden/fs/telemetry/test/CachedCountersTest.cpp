@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/CachedCounters.h"
+
+#include <fb303/ServiceData.h>
+#include <folly/portability/GTest.h>
+#include <re2/re2.h>
+
+using namespace facebook::eden;
+
+namespace {
+
+int64_t scrape(const std::string& name) {
+  auto counters = facebook::fb303::ServiceData::get()->getCounters();
+  auto it = counters.find(name);
+  return it == counters.end() ? -1 : it->second;
+}
+
+} // namespace
+
+TEST(CachedCounters, scrapesReadTheLastRefresh) {
+  CachedCounters cached;
+  int64_t calls = 0;
+  cached.registerCallback("test.cached.calls", [&] { return ++calls; });
+
+  EXPECT_EQ(0, scrape("test.cached.calls"));
+  EXPECT_EQ(0, calls);
+
+  cached.refresh();
+  EXPECT_EQ(1, calls);
+  EXPECT_EQ(1, scrape("test.cached.calls"));
+  EXPECT_EQ(1, scrape("test.cached.calls"));
+  EXPECT_EQ(1, calls);
+
+  cached.refresh();
+  EXPECT_EQ(2, scrape("test.cached.calls"));
+}
+
+TEST(CachedCounters, filterSkipsCounters) {
+  CachedCounters cached;
+  int64_t calls = 0;
+  cached.registerCallback("test.cached.kept", [] { return 7; });
+  cached.registerCallback("test.cached.skipped", [&] { return ++calls; });
+
+  re2::RE2 filter{"kept$"};
+  cached.refresh(&filter);
+  EXPECT_EQ(7, cached.getValue("test.cached.kept"));
+  EXPECT_EQ(std::nullopt, cached.getValue("test.cached.skipped"));
+  EXPECT_EQ(0, scrape("test.cached.skipped"));
+  EXPECT_EQ(0, calls);
+}
+
+TEST(CachedCounters, disabledCachingComputesOnScrape) {
+  CachedCounters cached;
+  int64_t calls = 0;
+  cached.registerCallback("test.cached.direct", [&] { return ++calls; });
+  cached.setEnabled(false);
+
+  EXPECT_EQ(1, scrape("test.cached.direct"));
+  EXPECT_EQ(2, scrape("test.cached.direct"));
+}
+
+TEST(CachedCounters, unregisteredCountersAreNotExported) {
+  {
+    CachedCounters cached;
+    cached.registerCallback("test.cached.gone", [] { return 1; });
+    cached.registerCallback("test.cached.destroyed", [] { return 1; });
+    cached.refresh();
+    cached.unregisterCallback("test.cached.gone");
+    EXPECT_EQ(-1, scrape("test.cached.gone"));
+    EXPECT_EQ(1, scrape("test.cached.destroyed"));
+  }
+  EXPECT_EQ(-1, scrape("test.cached.destroyed"));
+}
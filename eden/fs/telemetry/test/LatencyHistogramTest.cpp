@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/LatencyHistogram.h"
+
+#include <folly/portability/GTest.h>
+#include <algorithm>
+#include <thread>
+
+#include "eden/fs/telemetry/FsChannelLatencies.h"
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+TEST(LatencyHistogram, bucketsAreWithinAnEighthOfTheirValues) {
+  for (uint64_t value : {0, 1, 7, 8, 9, 15, 16, 100, 12345, 999999999}) {
+    auto bucket = LatencyHistogram::bucketOf(value);
+    auto lowerBound = LatencyHistogram::bucketLowerBound(bucket);
+    EXPECT_LE(lowerBound, value);
+    EXPECT_LE(value - lowerBound, value / LatencyHistogram::kSubBuckets);
+    EXPECT_GT(LatencyHistogram::bucketLowerBound(bucket + 1), value);
+  }
+  EXPECT_EQ(
+      LatencyHistogram::kBucketCount - 1,
+      LatencyHistogram::bucketOf(~uint64_t{0}));
+}
+
+TEST(LatencyHistogram, percentiles) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(0, histogram.getPercentile(50));
+  for (uint64_t i = 1; i <= 1000; ++i) {
+    histogram.record(i);
+  }
+  EXPECT_EQ(1000, histogram.getCount());
+  EXPECT_NEAR(500, histogram.getPercentile(50), 500 / 8);
+  EXPECT_NEAR(990, histogram.getPercentile(99), 990 / 8);
+  EXPECT_NEAR(1000, histogram.getMax(), 1000 / 8);
+  EXPECT_EQ(1, histogram.getPercentile(0));
+}
+
+TEST(LatencyHistogram, collectOnlyAddsTheNewDurations) {
+  StatsGroupBase::Histogram recorder;
+  LatencyHistogram histogram;
+  recorder.addDuration(10us);
+  recorder.addDuration(20us);
+  recorder.collect(histogram);
+  recorder.addDuration(30us);
+  recorder.collect(histogram);
+  recorder.collect(histogram);
+  EXPECT_EQ(3, histogram.getCount());
+  EXPECT_EQ(1, histogram.getBucketCount(LatencyHistogram::bucketOf(30)));
+}
+
+TEST(FsChannelLatencies, collectsEveryThreadPerOp) {
+  FsChannelLatencies latencies{"fuse", "/mnt", {"lookup", "", "read"}};
+  std::thread{[&] {
+    latencies.addDuration(0, 100us);
+    latencies.addDuration(2, 200us);
+  }}.join();
+  latencies.addDuration(0, 300us);
+  // Ops without a name and out of range are ignored.
+  latencies.addDuration(1, 300us);
+  latencies.addDuration(3, 300us);
+  latencies.collect();
+
+  auto snapshots = latencies.getSnapshots();
+  ASSERT_EQ(2, snapshots.size());
+  EXPECT_EQ(2, snapshots[0].histogram.getCount());
+  EXPECT_EQ(1, snapshots[1].histogram.getCount());
+  auto hasLabel = [](const auto& labels, const auto& name, const auto& value) {
+    return std::find(
+               labels.begin(),
+               labels.end(),
+               std::pair<std::string, std::string>{name, value}) !=
+        labels.end();
+  };
+  EXPECT_TRUE(hasLabel(snapshots[0].labels, "op", "lookup"));
+  EXPECT_TRUE(hasLabel(snapshots[0].labels, "mount", "/mnt"));
+  EXPECT_TRUE(hasLabel(snapshots[1].labels, "op", "read"));
+}
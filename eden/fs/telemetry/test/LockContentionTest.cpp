@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/LockContention.h"
+
+#include <fb303/ServiceData.h>
+#include <folly/SharedMutex.h>
+#include <folly/Synchronized.h>
+#include <folly/portability/GTest.h>
+#include <folly/synchronization/DistributedMutex.h>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+
+constexpr char kExclusiveSite[] = "test_exclusive";
+constexpr char kSharedSite[] = "test_shared";
+constexpr char kDistributedSite[] = "test_distributed";
+constexpr char kDisabledSite[] = "test_disabled";
+
+std::optional<LabeledLatencyHistogram> findHistogram(
+    std::string_view lock,
+    std::string_view kind) {
+  for (auto& histogram : LockSite::getHistograms()) {
+    std::vector<std::pair<std::string, std::string>> labels{
+        {"lock", std::string{lock}}, {"kind", std::string{kind}}};
+    if (histogram.labels == labels) {
+      return histogram;
+    }
+  }
+  return std::nullopt;
+}
+
+class LockContentionTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    LockSite::setEnabled(true);
+  }
+
+  void TearDown() override {
+    LockSite::setEnabled(false);
+  }
+};
+
+} // namespace
+
+TEST_F(LockContentionTest, recordsWaitAndHoldTimes) {
+  folly::Synchronized<int, InstrumentedMutex<std::mutex, kExclusiveSite>> value{
+      0};
+  {
+    auto locked = value.lock();
+    std::thread waiter{[&] { ++*value.lock(); }};
+    std::this_thread::sleep_for(20ms);
+    ++*locked;
+    locked.unlock();
+    waiter.join();
+  }
+  EXPECT_EQ(2, *value.lock());
+
+  auto wait = findHistogram(kExclusiveSite, "wait");
+  auto hold = findHistogram(kExclusiveSite, "hold");
+  ASSERT_TRUE(wait);
+  ASSERT_TRUE(hold);
+  EXPECT_EQ(3, wait->histogram.getCount());
+  EXPECT_EQ(3, hold->histogram.getCount());
+  // The waiter waited for the first holder to sleep.
+  EXPECT_GE(wait->histogram.getMax(), 10000);
+  EXPECT_GE(hold->histogram.getMax(), 10000);
+
+  auto counters = facebook::fb303::ServiceData::get()->getCounters();
+  EXPECT_EQ(3, counters.at("lock.test_exclusive.acquisitions"));
+  EXPECT_GE(counters.at("lock.test_exclusive.wait_us.max"), 10000);
+}
+
+TEST_F(LockContentionTest, sharedLocksOnlyRecordWaits) {
+  folly::Synchronized<int, InstrumentedMutex<folly::SharedMutex, kSharedSite>>
+      value{0};
+  EXPECT_EQ(0, *value.rlock());
+  EXPECT_EQ(0, *value.rlock());
+  *value.wlock() = 1;
+
+  EXPECT_EQ(3, findHistogram(kSharedSite, "wait")->histogram.getCount());
+  EXPECT_EQ(1, findHistogram(kSharedSite, "hold")->histogram.getCount());
+}
+
+TEST_F(LockContentionTest, wrapsDistributedMutex) {
+  folly::Synchronized<
+      int,
+      InstrumentedMutex<folly::DistributedMutex, kDistributedSite>>
+      value{0};
+  ++*value.lock();
+  ++*value.lock();
+  EXPECT_EQ(2, *value.lock());
+  EXPECT_EQ(3, findHistogram(kDistributedSite, "hold")->histogram.getCount());
+}
+
+TEST_F(LockContentionTest, nothingIsRecordedWhenDisabled) {
+  LockSite::setEnabled(false);
+  folly::Synchronized<int, InstrumentedMutex<std::mutex, kDisabledSite>> value{
+      0};
+  ++*value.lock();
+  EXPECT_FALSE(findHistogram(kDisabledSite, "wait"));
+  EXPECT_FALSE(findHistogram(kDisabledSite, "hold"));
+}
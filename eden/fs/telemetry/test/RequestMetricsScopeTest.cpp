@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/RequestMetricsScope.h"
+
+#include <folly/portability/GTest.h>
+#include <optional>
+#include <thread>
+#include <vector>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+using RequestWatchList = RequestMetricsScope::RequestWatchList;
+
+TEST(RequestMetricsScope, scopesAreCountedWhileAlive) {
+  RequestWatchList watches;
+  EXPECT_EQ(
+      0,
+      RequestMetricsScope::getMetricFromWatches(
+          RequestMetricsScope::COUNT, watches));
+  {
+    RequestMetricsScope first{&watches};
+    RequestMetricsScope second{&watches};
+    EXPECT_EQ(
+        2,
+        RequestMetricsScope::getMetricFromWatches(
+            RequestMetricsScope::COUNT, watches));
+
+    second.reset();
+    EXPECT_EQ(1, watches.count());
+
+    RequestMetricsScope moved{std::move(first)};
+    EXPECT_EQ(1, watches.count());
+  }
+  EXPECT_EQ(0, watches.count());
+}
+
+TEST(RequestMetricsScope, maxDurationIsTheAgeOfTheOldestScope) {
+  RequestWatchList watches;
+  EXPECT_EQ(
+      RequestMetricsScope::DefaultRequestDuration{0},
+      RequestMetricsScope::getMaxDuration(watches));
+
+  std::optional<RequestMetricsScope> oldest{std::in_place, &watches};
+  // Start times are only precise to a timer tick.
+  std::this_thread::sleep_for(50ms);
+  RequestMetricsScope newest{&watches};
+  EXPECT_GE(RequestMetricsScope::getMaxDuration(watches), 30ms);
+
+  oldest.reset();
+  EXPECT_LT(RequestMetricsScope::getMaxDuration(watches), 30ms);
+}
+
+TEST(RequestMetricsScope, scopesBeyondTheSlotsAreStillCounted) {
+  RequestWatchList watches;
+  std::vector<RequestMetricsScope> scopes;
+  for (size_t i = 0; i < RequestWatchList::kSlots + 10; ++i) {
+    scopes.emplace_back(&watches);
+  }
+  EXPECT_EQ(RequestWatchList::kSlots + 10, watches.count());
+  scopes.clear();
+  EXPECT_EQ(0, watches.count());
+}
+
+TEST(RequestMetricsScope, scopesFromManyThreads) {
+  RequestWatchList watches;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < 10000; ++i) {
+        RequestMetricsScope scope{&watches};
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, watches.count());
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/RequestSampler.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+
+TEST(RequestSampler, foldedStacksListTheActivePhasesInLayerOrder) {
+  RequestSampler sampler;
+  RequestPhases lookup;
+  lookup.setName("fuse", "lookup");
+  lookup.enter(RequestPhase::HgImportQueue);
+  lookup.enter(RequestPhase::ObjectStore);
+  RequestPhases read;
+  read.setName("fuse", "read");
+
+  sampler.add(lookup);
+  sampler.add(read);
+  sampler.sample();
+  sampler.sample();
+  lookup.leave(RequestPhase::HgImportQueue);
+  sampler.sample();
+  sampler.remove(read);
+  sampler.sample();
+
+  EXPECT_EQ(
+      "fuse;lookup;objectstore 2\n"
+      "fuse;lookup;objectstore;hgimportqueue 2\n"
+      "fuse;read 3\n",
+      sampler.getFoldedStacks());
+}
+
+TEST(RequestSampler, nestedPhasesAreCounted) {
+  RequestPhases phases;
+  phases.setName("nfs", "getattr");
+  phases.enter(RequestPhase::LocalStore);
+  phases.enter(RequestPhase::LocalStore);
+  phases.leave(RequestPhase::LocalStore);
+  EXPECT_EQ("nfs;getattr;localstore", phases.getFoldedStack());
+  phases.leave(RequestPhase::LocalStore);
+  EXPECT_EQ("nfs;getattr", phases.getFoldedStack());
+}
@@ -94,3 +94,30 @@ TEST_F(ScubaStructuredLoggerTest, json_contains_types_at_top_level_and_values) {
           "str", "user", "host", "type", "os", "osver", "edenver"));
 #endif
 }
+
+TEST(ScubaStructuredLoggerBatchTest, events_are_written_in_columnar_batches) {
+  auto scribe = std::make_shared<TestScribeLogger>();
+  ScubaStructuredLogger::BatchOptions batchOptions;
+  batchOptions.maxEvents = 2;
+  batchOptions.maxDelay = std::chrono::hours{1};
+  ScubaStructuredLogger logger{scribe, SessionInfo{}, batchOptions};
+
+  logger.logEvent(TestLogEvent{"first", 1});
+  EXPECT_EQ(0, scribe->lines.size());
+  logger.logEvent(TestLogEvent{"second", 2});
+  ASSERT_EQ(1, scribe->lines.size());
+
+  auto doc = folly::parseJson(scribe->lines[0]);
+  EXPECT_EQ(2, doc["rows"].asInt());
+  EXPECT_EQ(folly::dynamic::array(1, 2), doc["int"]["number"]);
+  EXPECT_EQ(folly::dynamic::array("first", "second"), doc["normal"]["str"]);
+  EXPECT_EQ(
+      folly::dynamic::array("test_event", "test_event"), doc["normal"]["type"]);
+
+  logger.logEvent(TestLogEvent{"third", 3});
+  logger.flush();
+  ASSERT_EQ(2, scribe->lines.size());
+  doc = folly::parseJson(scribe->lines[1]);
+  EXPECT_EQ(1, doc["rows"].asInt());
+  EXPECT_EQ(folly::dynamic::array(3), doc["int"]["number"]);
+}
@@ -8,6 +8,8 @@
 #include "eden/fs/telemetry/TraceBus.h"
 #include <folly/futures/Promise.h>
 #include <folly/portability/GTest.h>
+#include <folly/synchronization/Baton.h>
+#include <thread>
 
 using namespace std::literals;
 using namespace facebook::eden;
@@ -100,3 +102,64 @@ TEST(TraceBusTest, unsubscribe_before_publish) {
   // of events.
   XCHECK(1 == i || i == 3) << i << " must be 1 or 3";
 }
+
+TEST(TraceBusTest, events_of_each_thread_stay_in_order) {
+  constexpr int kThreads = 4;
+  constexpr int kEventsPerThread = 10000;
+  std::vector<int> last(kThreads, -1);
+  bool inOrder = true;
+  {
+    auto bus = TraceBus<std::pair<int, int>>::create("bus", 64);
+    auto handle =
+        bus->subscribeFunction("sub", [&](const std::pair<int, int>& event) {
+          inOrder = inOrder && event.second == last[event.first] + 1;
+          last[event.first] = event.second;
+        });
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+      threads.emplace_back([&, t] {
+        for (int i = 0; i < kEventsPerThread; ++i) {
+          bus->publish(std::make_pair(t, i));
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  EXPECT_TRUE(inOrder);
+  for (int t = 0; t < kThreads; ++t) {
+    EXPECT_EQ(kEventsPerThread - 1, last[t]);
+  }
+}
+
+TEST(TraceBusTest, drops_events_when_full) {
+  folly::Baton<> blocked;
+  folly::Baton<> unblock;
+  int observed = 0;
+  uint64_t dropped = 0;
+  {
+    auto bus = TraceBus<int>::create(
+        "bus", 4, TraceBus<int>::OverflowPolicy::Drop);
+    auto handle = bus->subscribeFunction("sub", [&](int) {
+      if (observed++ == 0) {
+        blocked.post();
+        unblock.wait();
+      }
+    });
+
+    bus->publish(0);
+    blocked.wait();
+    // The subscriber is blocked, so only 4 of these fit in the buffer.
+    for (int i = 1; i <= 10; ++i) {
+      bus->publish(i);
+    }
+    dropped = bus->getDroppedEventCount();
+    unblock.post();
+  }
+
+  EXPECT_EQ(6, dropped);
+  EXPECT_EQ(5, observed);
+}
@@ -10,8 +10,10 @@
 #include <fmt/format.h>
 #include <folly/MapUtil.h>
 #include <folly/futures/Future.h>
+#include <folly/futures/Sleep.h>
 #include <folly/logging/xlog.h>
 #include <folly/ssl/OpenSSLHash.h>
+#include <cmath>
 
 #include "eden/fs/model/Blob.h"
 #include "eden/fs/model/Hash.h"
@@ -107,10 +109,16 @@ SemiFuture<BackingStore::GetTreeResult> FakeBackingStore::getTree(
     throw std::domain_error(fmt::format("tree {} not found", id));
   }
 
-  return it->second->getFuture().thenValue([](std::unique_ptr<Tree> tree) {
-    return GetTreeResult{
-        std::move(tree), ObjectFetchContext::Origin::FromNetworkFetch};
-  });
+  auto future =
+      it->second->getFuture().thenValue([](std::unique_ptr<Tree> tree) {
+        return GetTreeResult{
+            std::move(tree), ObjectFetchContext::Origin::FromNetworkFetch};
+      });
+  data.unlock();
+  return simulateFetch<GetTreeResult>(
+      std::move(future).semi(), 1, [](const GetTreeResult& result) {
+        return result.tree->getSizeBytes();
+      });
 }
 
 SemiFuture<BackingStore::GetBlobResult> FakeBackingStore::getBlob(
@@ -124,10 +132,100 @@ SemiFuture<BackingStore::GetBlobResult> FakeBackingStore::getBlob(
     throw std::domain_error(fmt::format("blob {} not found", id));
   }
 
-  return it->second->getFuture().thenValue([](std::unique_ptr<Blob> blob) {
-    return GetBlobResult{
-        std::move(blob), ObjectFetchContext::Origin::FromNetworkFetch};
-  });
+  auto future =
+      it->second->getFuture().thenValue([](std::unique_ptr<Blob> blob) {
+        return GetBlobResult{
+            std::move(blob), ObjectFetchContext::Origin::FromNetworkFetch};
+      });
+  data.unlock();
+  return simulateFetch<GetBlobResult>(
+      std::move(future).semi(), 1, [](const GetBlobResult& result) {
+        return result.blob->getSize();
+      });
+}
+
+SemiFuture<folly::Unit> FakeBackingStore::prefetchBlobs(
+    ObjectIdRange ids,
+    const ObjectFetchContextPtr& /*context*/) {
+  size_t bytes = 0;
+  {
+    auto data = data_.wlock();
+    for (const auto& id : ids) {
+      ++data->prefetchCounts[id];
+      auto it = data->blobs.find(id);
+      if (it != data->blobs.end()) {
+        bytes += it->second->get().getSize();
+      }
+    }
+  }
+  return simulateFetch<folly::Unit>(
+      folly::makeSemiFuture(folly::unit),
+      ids.size(),
+      [bytes](const folly::Unit&) { return bytes; });
+}
+
+void FakeBackingStore::setFetchSimulation(
+    std::optional<FetchSimulation> simulation) {
+  auto state = simulation_.wlock();
+  if (simulation) {
+    state->emplace(*simulation);
+  } else {
+    state->reset();
+  }
+}
+
+template <typename T>
+SemiFuture<T> FakeBackingStore::simulateFetch(
+    SemiFuture<T> future,
+    size_t objects,
+    folly::Function<size_t(const T&)> bytes) {
+  if (!simulation_.rlock()->has_value()) {
+    return future;
+  }
+  return std::move(future).deferValue(
+      [this, objects, bytes = std::move(bytes)](T&& result) mutable {
+        std::chrono::microseconds delay{0};
+        bool fails = false;
+        {
+          auto state = simulation_.wlock();
+          if (*state) {
+            auto& params = (*state)->params;
+            if (params.medianLatency.count() > 0) {
+              // The 99th percentile of the standard normal distribution.
+              constexpr double kZ99 = 2.3263;
+              auto mu = std::log(double(params.medianLatency.count()));
+              auto sigma = std::max(
+                  0.0,
+                  (std::log(double(params.p99Latency.count())) - mu) / kZ99);
+              std::lognormal_distribution<double> latency{mu, sigma};
+              delay += std::chrono::microseconds{
+                  static_cast<int64_t>(latency((*state)->random))};
+            }
+            delay += params.perObjectCost * objects;
+            if (params.bytesPerSecond > 0) {
+              auto now = std::chrono::steady_clock::now();
+              auto transfer = std::chrono::duration_cast<
+                  std::chrono::steady_clock::duration>(
+                  std::chrono::duration<double>(
+                      double(bytes(result)) / params.bytesPerSecond));
+              auto start = std::max(now, (*state)->linkFreeAt);
+              (*state)->linkFreeAt = start + transfer;
+              delay += std::chrono::duration_cast<std::chrono::microseconds>(
+                  (*state)->linkFreeAt - now);
+            }
+            fails = std::bernoulli_distribution{params.failureRate}(
+                (*state)->random);
+          }
+        }
+        return folly::futures::sleep(delay).deferValue(
+            [fails, objects, result = std::move(result)](auto&&) mutable {
+              if (fails) {
+                throw std::runtime_error(fmt::format(
+                    "simulated failure of a fetch of {} objects", objects));
+              }
+              return std::move(result);
+            });
+      });
 }
 
 Blob FakeBackingStore::makeBlob(folly::StringPiece contents) {
@@ -386,4 +484,16 @@ void FakeBackingStore::discardOutstandingRequests() {
 size_t FakeBackingStore::getAccessCount(const ObjectId& hash) const {
   return folly::get_default(data_.rlock()->accessCounts, hash, 0);
 }
+
+size_t FakeBackingStore::getPrefetchCount(const ObjectId& hash) const {
+  return folly::get_default(data_.rlock()->prefetchCounts, hash, 0);
+}
+
+size_t FakeBackingStore::getTotalAccessCount() const {
+  size_t total = 0;
+  for (const auto& [hash, count] : data_.rlock()->accessCounts) {
+    total += count;
+  }
+  return total;
+}
 } // namespace facebook::eden
@@ -7,8 +7,11 @@
 
 #pragma once
 
+#include <chrono>
 #include <initializer_list>
 #include <memory>
+#include <optional>
+#include <random>
 #include <unordered_map>
 #include "eden/fs/model/Blob.h"
 #include "eden/fs/model/Hash.h"
@@ -72,6 +75,10 @@ class FakeBackingStore final : public BackingStore {
     return nullptr;
   }
 
+  folly::SemiFuture<folly::Unit> prefetchBlobs(
+      ObjectIdRange ids,
+      const ObjectFetchContextPtr& context) override;
+
   /**
    * Add a Blob to the backing store
    *
@@ -165,6 +172,55 @@ class FakeBackingStore final : public BackingStore {
    */
   size_t getAccessCount(const ObjectId& hash) const;
 
+  /**
+   * Returns the number of times this hash has been passed to prefetchBlobs.
+   */
+  size_t getPrefetchCount(const ObjectId& hash) const;
+
+  /**
+   * Returns the number of times any tree or blob has been queried, which is
+   * the number of fetches a real backing store would have done.
+   */
+  size_t getTotalAccessCount() const;
+
+  /**
+   * Makes fetches cost what they would cost from a remote store, so that
+   * tests and benchmarks can check prefetching, batching and priorities under
+   * production-like conditions.
+   */
+  struct FetchSimulation {
+    /**
+     * The latency of each fetch is drawn from a log-normal distribution with
+     * this median and 99th percentile. A zero median means no latency.
+     */
+    std::chrono::microseconds medianLatency{0};
+    std::chrono::microseconds p99Latency{0};
+    /**
+     * Added to the latency of a fetch for each object it fetches: batches
+     * cost more than a single fetch, but much less than fetching each of
+     * their objects separately.
+     */
+    std::chrono::microseconds perObjectCost{0};
+    /**
+     * Shared by the concurrent fetches, whose transfers thus queue behind
+     * each other. Zero means unlimited.
+     */
+    uint64_t bytesPerSecond{0};
+    /** The probability, between 0 and 1, that a fetch fails. */
+    double failureRate{0};
+    /** Seeds the random draws, for reproducible runs. */
+    uint32_t seed{0};
+  };
+
+  /**
+   * Simulate the cost of getTree(), getBlob() and prefetchBlobs(), or stop
+   * simulating it with std::nullopt.
+   *
+   * The cost is only incurred once the objects are ready, so setReady() and
+   * trigger() still control when fetches can complete.
+   */
+  void setFetchSimulation(std::optional<FetchSimulation> simulation);
+
   // TODO(T119221752): Implement for all BackingStore subclasses
   int64_t dropAllPendingRequestsFromQueue() override {
     XLOG(
@@ -181,8 +237,29 @@ class FakeBackingStore final : public BackingStore {
 
     std::unordered_map<RootId, size_t> commitAccessCounts;
     std::unordered_map<ObjectId, size_t> accessCounts;
+    std::unordered_map<ObjectId, size_t> prefetchCounts;
   };
 
+  struct SimulationState {
+    explicit SimulationState(const FetchSimulation& params)
+        : params{params}, random{params.seed} {}
+
+    FetchSimulation params;
+    std::mt19937 random;
+    /** When the transfers already started will be done. */
+    std::chrono::steady_clock::time_point linkFreeAt;
+  };
+
+  /**
+   * Delays the result of a fetch of objects totalling the given bytes by its
+   * simulated cost, if any, or fails it.
+   */
+  template <typename T>
+  folly::SemiFuture<T> simulateFetch(
+      folly::SemiFuture<T> future,
+      size_t objects,
+      folly::Function<size_t(const T&)> bytes);
+
   static Tree::container buildTreeEntries(
       const std::initializer_list<TreeEntryData>& entryArgs);
   static ObjectId computeTreeHash(const Tree::container& sortedEntries);
@@ -192,6 +269,7 @@ class FakeBackingStore final : public BackingStore {
       Tree::container&& sortedEntries);
 
   folly::Synchronized<Data> data_;
+  folly::Synchronized<std::optional<SimulationState>> simulation_;
 };
 
 enum class FakeBlobType {
@@ -59,8 +59,16 @@ void FakeFuse::setTimeout(std::chrono::milliseconds timeout) {
 }
 
 uint32_t FakeFuse::sendRequest(uint32_t opcode, uint64_t inode, ByteRange arg) {
-  auto requestID = requestID_;
-  ++requestID_;
+  auto requestID = allocateRequestID();
+  sendRequestWithID(requestID, opcode, inode, arg);
+  return requestID;
+}
+
+void FakeFuse::sendRequestWithID(
+    uint32_t requestID,
+    uint32_t opcode,
+    uint64_t inode,
+    ByteRange arg) {
   XLOG(DBG5) << "injecting FUSE request ID " << requestID
              << ": opcode= " << opcode;
 
@@ -79,7 +87,6 @@ uint32_t FakeFuse::sendRequest(uint32_t opcode, uint64_t inode, ByteRange arg) {
   folly::checkUnixError(
       folly::writevFull(conn_.fd(), iov.data(), iov.size()),
       "failed to send FUSE request ");
-  return requestID;
 }
 
 FakeFuse::Response FakeFuse::recvResponse() {
@@ -9,6 +9,7 @@
 
 #include <folly/File.h>
 #include <folly/Range.h>
+#include <atomic>
 #include <chrono>
 #include <vector>
 
@@ -62,7 +63,8 @@ class FakeFuse {
   /**
    * Send a new request on the FUSE channel.
    *
-   * Returns the newly allocated request ID.
+   * Returns the newly allocated request ID. Requests may be sent from several
+   * threads concurrently.
    */
   template <typename ArgType>
   uint32_t sendRequest(uint32_t opcode, uint64_t inode, const ArgType& arg) {
@@ -72,6 +74,20 @@ class FakeFuse {
   }
   uint32_t sendRequest(uint32_t opcode, uint64_t inode, folly::ByteRange arg);
 
+  /**
+   * Allocate a request ID, for callers that need to know the ID of a request
+   * before sending it with sendRequestWithID(), e.g. to match its response
+   * received by another thread.
+   */
+  uint32_t allocateRequestID() {
+    return requestID_.fetch_add(1, std::memory_order_relaxed);
+  }
+  void sendRequestWithID(
+      uint32_t requestID,
+      uint32_t opcode,
+      uint64_t inode,
+      folly::ByteRange arg);
+
   Response recvResponse();
 
   /**
@@ -107,7 +123,7 @@ class FakeFuse {
    * The next request ID to use when sending requests.
    * We increment this for each request we send.
    */
-  uint32_t requestID_{0};
+  std::atomic<uint32_t> requestID_{0};
 };
 
 } // namespace facebook::eden
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/testharness/SyntheticRepo.h"
+
+#include <fmt/format.h>
+#include <array>
+#include <random>
+#include <string>
+
+#include "eden/fs/testharness/FakeTreeBuilder.h"
+
+namespace facebook::eden {
+
+namespace {
+constexpr std::array<const char*, 6> kExtensions{
+    ".cpp",
+    ".h",
+    ".py",
+    ".rs",
+    ".thrift",
+    ".md",
+};
+
+void addDirectory(
+    FakeTreeBuilder& builder,
+    const SyntheticRepoShape& shape,
+    std::mt19937_64& rng,
+    const RelativePath& dir,
+    size_t level,
+    std::vector<RelativePath>& paths) {
+  auto addFile = [&](RelativePath path) {
+    // Most source files are small, a few are much larger.
+    std::exponential_distribution<double> sizes{
+        1.0 / static_cast<double>(shape.fileSize)};
+    std::string contents(static_cast<size_t>(sizes(rng)), 'x');
+    // Make every file distinct, like real sources.
+    contents += path.view();
+    builder.setFile(path, contents);
+    paths.push_back(std::move(path));
+  };
+
+  if (level > 0) {
+    addFile(dir + PathComponentPiece{"BUCK"});
+  }
+  for (size_t i = 0; i < shape.filesPerDir; ++i) {
+    addFile(
+        dir +
+        PathComponent{fmt::format(
+            "file{}{}", i, kExtensions[rng() % kExtensions.size()])});
+  }
+  if (level == shape.depth) {
+    return;
+  }
+  for (size_t i = 0; i < shape.dirsPerDir; ++i) {
+    addDirectory(
+        builder,
+        shape,
+        rng,
+        dir + PathComponent{fmt::format("dir{}", i)},
+        level + 1,
+        paths);
+  }
+}
+} // namespace
+
+std::vector<RelativePath> buildSyntheticRepo(
+    FakeTreeBuilder& builder,
+    const SyntheticRepoShape& shape) {
+  std::mt19937_64 rng{shape.seed};
+  std::vector<RelativePath> paths;
+  addDirectory(builder, shape, rng, RelativePath{}, 0, paths);
+  return paths;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+class FakeTreeBuilder;
+
+/**
+ * The shape of a synthetic repository, loosely modeled on a monorepo: a few
+ * wide top-level directories, deep project directories with a build file
+ * each, and source files whose sizes vary around fileSize.
+ */
+struct SyntheticRepoShape {
+  // Number of directory levels below the root.
+  size_t depth{3};
+  // Subdirectories of each directory above the last level.
+  size_t dirsPerDir{8};
+  // Files in each directory, besides its build file.
+  size_t filesPerDir{16};
+  // Average file size in bytes.
+  size_t fileSize{512};
+  // The repository only depends on the shape and on the seed.
+  uint64_t seed{0};
+};
+
+/**
+ * Adds the files of a repository of the given shape to builder, and returns
+ * their paths.
+ */
+std::vector<RelativePath> buildSyntheticRepo(
+    FakeTreeBuilder& builder,
+    const SyntheticRepoShape& shape);
+
+} // namespace facebook::eden
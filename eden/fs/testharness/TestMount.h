@@ -226,6 +226,10 @@ class TestMount {
     return treeCache_;
   }
 
+  const std::shared_ptr<EdenConfig>& getEdenConfig() const {
+    return edenConfig_;
+  }
+
 #ifndef _WIN32
   FuseDispatcher* getDispatcher() const;
 #endif // !_WIN32
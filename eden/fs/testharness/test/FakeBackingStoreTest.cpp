@@ -300,3 +300,69 @@ TEST_F(FakeBackingStoreTest, maybePutTree) {
   EXPECT_FALSE(dir2.second);
   EXPECT_EQ(dir1.first, dir2.first);
 }
+
+TEST_F(FakeBackingStoreTest, simulatedLatencyDelaysFetches) {
+  auto hash = makeTestHash("1");
+  store_->putBlob(hash, "foobar")->setReady();
+  FakeBackingStore::FetchSimulation simulation;
+  simulation.medianLatency = 20ms;
+  simulation.p99Latency = 20ms;
+  store_->setFetchSimulation(simulation);
+
+  auto start = std::chrono::steady_clock::now();
+  auto result = store_->getBlob(hash, ObjectFetchContext::getNullContext())
+                    .via(&folly::QueuedImmediateExecutor::instance())
+                    .get(10s);
+  EXPECT_EQ("foobar", blobContents(*result.blob));
+  EXPECT_GE(std::chrono::steady_clock::now() - start, 20ms);
+
+  // Not simulating anymore.
+  store_->setFetchSimulation(std::nullopt);
+  EXPECT_TRUE(
+      store_->getBlob(hash, ObjectFetchContext::getNullContext()).isReady());
+}
+
+TEST_F(FakeBackingStoreTest, simulatedBandwidthIsShared) {
+  std::string contents(2000, 'a');
+  auto hash1 = makeTestHash("1");
+  auto hash2 = makeTestHash("2");
+  store_->putBlob(hash1, contents)->setReady();
+  store_->putBlob(hash2, contents)->setReady();
+  FakeBackingStore::FetchSimulation simulation;
+  simulation.bytesPerSecond = 100000;
+  store_->setFetchSimulation(simulation);
+
+  // Each transfer takes 20ms, and the second one waits for the first one.
+  auto start = std::chrono::steady_clock::now();
+  auto* executor = &folly::QueuedImmediateExecutor::instance();
+  auto future1 = store_->getBlob(hash1, ObjectFetchContext::getNullContext())
+                     .via(executor);
+  auto future2 = store_->getBlob(hash2, ObjectFetchContext::getNullContext())
+                     .via(executor);
+  std::move(future1).get(10s);
+  std::move(future2).get(10s);
+  EXPECT_GE(std::chrono::steady_clock::now() - start, 40ms);
+}
+
+TEST_F(FakeBackingStoreTest, simulatedFailures) {
+  auto hash = makeTestHash("1");
+  store_->putBlob(hash, "foobar")->setReady();
+  FakeBackingStore::FetchSimulation simulation;
+  simulation.failureRate = 1;
+  store_->setFetchSimulation(simulation);
+
+  EXPECT_THROW_RE(
+      store_->getBlob(hash, ObjectFetchContext::getNullContext())
+          .via(&folly::QueuedImmediateExecutor::instance())
+          .get(10s),
+      std::runtime_error,
+      "simulated failure");
+  EXPECT_THROW_RE(
+      store_
+          ->prefetchBlobs(
+              ObjectIdRange{&hash, 1}, ObjectFetchContext::getNullContext())
+          .via(&folly::QueuedImmediateExecutor::instance())
+          .get(10s),
+      std::runtime_error,
+      "simulated failure of a fetch of 1 objects");
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <chrono>
+
+#ifdef __linux__
+#include <time.h>
+#endif
+
+namespace facebook::eden {
+
+/**
+ * Coarse counterparts of std::chrono::steady_clock::now() and
+ * std::chrono::system_clock::now(), for timestamps taken at every request
+ * that don't need to be more precise than a few milliseconds, such as the
+ * age of the oldest pending request or the time of a journal entry.
+ *
+ * On Linux, they return the time of the last timer tick, which the vDSO
+ * reads without looking at the hardware clock, and which is several times
+ * cheaper than the precise time. Elsewhere, they return the precise time.
+ *
+ * They return time points of the standard clocks, so a use site can switch
+ * between the precise and the coarse time without changing its types, and
+ * compare coarse and precise times, keeping in mind that a coarse time can
+ * lag the precise time by up to a tick.
+ */
+inline std::chrono::steady_clock::time_point coarseSteadyNow() noexcept {
+#ifdef __linux__
+  // steady_clock is CLOCK_MONOTONIC, whose coarse variant shares its epoch.
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+  return std::chrono::steady_clock::time_point{
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+          std::chrono::seconds{ts.tv_sec} +
+          std::chrono::nanoseconds{ts.tv_nsec})};
+#else
+  return std::chrono::steady_clock::now();
+#endif
+}
+
+inline std::chrono::system_clock::time_point coarseSystemNow() noexcept {
+#ifdef __linux__
+  timespec ts;
+  clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+  return std::chrono::system_clock::time_point{
+      std::chrono::duration_cast<std::chrono::system_clock::duration>(
+          std::chrono::seconds{ts.tv_sec} +
+          std::chrono::nanoseconds{ts.tv_nsec})};
+#else
+  return std::chrono::system_clock::now();
+#endif
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/FsChannelOverloadController.h"
+
+#include <cerrno>
+#include <limits>
+#include <optional>
+#include <system_error>
+#include <utility>
+
+namespace facebook::eden {
+
+namespace {
+folly::exception_wrapper makeShedError() {
+  return folly::make_exception_wrapper<std::system_error>(
+      EAGAIN,
+      std::generic_category(),
+      "request shed by the filesystem channel overload controller");
+}
+} // namespace
+
+FsChannelOverloadController::Slot::Slot(Slot&& other) noexcept
+    : controller_{std::move(other.controller_)},
+      pid_{other.pid_},
+      kind_{other.kind_},
+      queueDelay_{other.queueDelay_} {}
+
+FsChannelOverloadController::Slot&
+FsChannelOverloadController::Slot::operator=(Slot&& other) noexcept {
+  if (this != &other) {
+    release();
+    controller_ = std::move(other.controller_);
+    pid_ = other.pid_;
+    kind_ = other.kind_;
+    queueDelay_ = other.queueDelay_;
+  }
+  return *this;
+}
+
+FsChannelOverloadController::Slot::~Slot() {
+  release();
+}
+
+void FsChannelOverloadController::Slot::release() noexcept {
+  if (auto controller = std::move(controller_)) {
+    controller->release(pid_, kind_);
+  }
+}
+
+FsChannelOverloadController::FsChannelOverloadController(Config config)
+    : config_{config} {}
+
+ImmediateFuture<FsChannelOverloadController::Slot>
+FsChannelOverloadController::admit(pid_t pid, RequestKind kind) {
+  if (config_.maxInFlight == 0) {
+    return Slot{nullptr, pid, kind, {}};
+  }
+
+  std::optional<folly::Promise<Slot>> shedPromise;
+  folly::SemiFuture<Slot> future = folly::SemiFuture<Slot>::makeEmpty();
+  {
+    auto state = state_.lock();
+    if (state->inFlight < config_.maxInFlight &&
+        !(kind == RequestKind::Bulk && bulkLimited(*state, pid))) {
+      ++state->inFlight;
+      admitted(*state, pid, kind);
+      return Slot{shared_from_this(), pid, kind, {}};
+    }
+
+    if (kind == RequestKind::Bulk && config_.maxQueuedBulk != 0 &&
+        state->queuedBulk >= config_.maxQueuedBulk) {
+      // Shed from the process with the most queued bulk requests, counting
+      // this one, which loses ties.
+      auto heaviest = state->bulk.end();
+      size_t heaviestQueued = 0;
+      if (auto it = state->bulk.find(pid); it != state->bulk.end()) {
+        heaviestQueued = it->second.size();
+      }
+      ++heaviestQueued;
+      for (auto it = state->bulk.begin(); it != state->bulk.end(); ++it) {
+        if (it->second.size() > heaviestQueued) {
+          heaviest = it;
+          heaviestQueued = it->second.size();
+        }
+      }
+      ++state->shed;
+      if (heaviest == state->bulk.end()) {
+        return ImmediateFuture<Slot>{folly::Try<Slot>{makeShedError()}};
+      }
+      shedPromise = std::move(heaviest->second.back().promise);
+      heaviest->second.pop_back();
+      if (heaviest->second.empty()) {
+        state->bulk.erase(heaviest);
+      }
+      --state->queuedBulk;
+    }
+
+    Waiter waiter{pid, kind, std::chrono::steady_clock::now(), {}};
+    future = waiter.promise.getSemiFuture();
+    ++state->deferred;
+    if (kind == RequestKind::Metadata) {
+      state->metadata.push_back(std::move(waiter));
+    } else {
+      state->bulk[pid].push_back(std::move(waiter));
+      ++state->queuedBulk;
+    }
+  }
+
+  if (shedPromise) {
+    shedPromise->setException(makeShedError());
+  }
+  return std::move(future);
+}
+
+bool FsChannelOverloadController::bulkLimited(const State& state, pid_t pid)
+    const {
+  if (config_.maxBulkInFlightPerPid == 0) {
+    return false;
+  }
+  auto it = state.bulkInFlightByPid.find(pid);
+  return it != state.bulkInFlightByPid.end() &&
+      it->second >= config_.maxBulkInFlightPerPid;
+}
+
+void FsChannelOverloadController::admitted(
+    State& state,
+    pid_t pid,
+    RequestKind kind) {
+  ++state.inFlightByPid[pid];
+  if (kind == RequestKind::Bulk) {
+    ++state.bulkInFlightByPid[pid];
+  }
+}
+
+void FsChannelOverloadController::release(
+    pid_t pid,
+    RequestKind kind) noexcept {
+  std::optional<Waiter> next;
+  {
+    auto state = state_.lock();
+    auto it = state->inFlightByPid.find(pid);
+    if (--it->second == 0) {
+      state->inFlightByPid.erase(it);
+    }
+    if (kind == RequestKind::Bulk) {
+      auto bulkIt = state->bulkInFlightByPid.find(pid);
+      if (--bulkIt->second == 0) {
+        state->bulkInFlightByPid.erase(bulkIt);
+      }
+    }
+
+    if (!state->metadata.empty()) {
+      next = std::move(state->metadata.front());
+      state->metadata.pop_front();
+    } else if (state->queuedBulk != 0) {
+      // The process with the fewest requests in flight goes first, among
+      // those below their limit. If they are all at their limit, the slot is
+      // freed until one of them releases one.
+      auto lightest = state->bulk.end();
+      size_t lightestInFlight = std::numeric_limits<size_t>::max();
+      for (auto bulk = state->bulk.begin(); bulk != state->bulk.end();
+           ++bulk) {
+        if (bulkLimited(*state, bulk->first)) {
+          continue;
+        }
+        auto inFlight = state->inFlightByPid.find(bulk->first);
+        size_t count =
+            inFlight == state->inFlightByPid.end() ? 0 : inFlight->second;
+        if (count < lightestInFlight) {
+          lightest = bulk;
+          lightestInFlight = count;
+        }
+      }
+      if (lightest != state->bulk.end()) {
+        next = std::move(lightest->second.front());
+        lightest->second.pop_front();
+        if (lightest->second.empty()) {
+          state->bulk.erase(lightest);
+        }
+        --state->queuedBulk;
+      }
+    }
+
+    if (next) {
+      admitted(*state, next->pid, next->kind);
+    } else {
+      --state->inFlight;
+    }
+  }
+
+  if (next) {
+    next->promise.setValue(Slot{
+        shared_from_this(),
+        next->pid,
+        next->kind,
+        std::chrono::steady_clock::now() - next->queuedAt});
+  }
+}
+
+FsChannelOverloadController::Stats FsChannelOverloadController::getStats()
+    const {
+  auto state = state_.lock();
+  return Stats{
+      state->inFlight,
+      state->metadata.size(),
+      state->queuedBulk,
+      state->deferred,
+      state->shed};
+}
+
+} // namespace facebook::eden
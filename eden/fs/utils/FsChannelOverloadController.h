@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <folly/futures/Promise.h>
+#include <folly/portability/SysTypes.h>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+#include "eden/fs/utils/ImmediateFuture.h"
+
+namespace facebook::eden {
+
+/**
+ * Bounds the number of requests a filesystem channel handles at once, so that
+ * under a backlog of imports requests wait in EdenFS, in a chosen order,
+ * instead of all piling up on the import queue until they time out.
+ *
+ * When every slot is taken, requests queue. Metadata requests, like lookup
+ * and getattr, go before bulk ones, like reads and directory listings: they
+ * are cheap once their trees are loaded and every command walking the
+ * checkout blocks on them. Bulk requests go to the process with the fewest
+ * requests in flight first, so that a scanner reading the whole checkout
+ * waits behind everyone else, and a process may be limited in how many bulk
+ * requests it has in flight. Past a number of queued bulk requests, the
+ * newest one of the process with the most queued is failed with EAGAIN.
+ *
+ * The Thrift server also uses it, for its expensive methods.
+ */
+class FsChannelOverloadController
+    : public std::enable_shared_from_this<FsChannelOverloadController> {
+ public:
+  enum class RequestKind { Metadata, Bulk };
+
+  struct Config {
+    /**
+     * The number of requests handled at once before the others queue. Zero
+     * disables the controller.
+     */
+    uint32_t maxInFlight{0};
+    /**
+     * The number of queued bulk requests above which they are shed. Zero to
+     * never shed them.
+     */
+    uint32_t maxQueuedBulk{0};
+    /**
+     * The number of bulk requests a process may have in flight before its
+     * other ones queue, even if slots are free. Zero for no limit.
+     */
+    uint32_t maxBulkInFlightPerPid{0};
+  };
+
+  struct Stats {
+    size_t inFlight;
+    size_t queuedMetadata;
+    size_t queuedBulk;
+    // The requests that had to queue, and those that were shed.
+    uint64_t deferred;
+    uint64_t shed;
+  };
+
+  /**
+   * The right of an admitted request to run, given to a queued request when
+   * destroyed.
+   */
+  class Slot {
+   public:
+    Slot(Slot&& other) noexcept;
+    Slot& operator=(Slot&& other) noexcept;
+    ~Slot();
+
+    /**
+     * How long the request was queued before being admitted.
+     */
+    std::chrono::steady_clock::duration getQueueDelay() const {
+      return queueDelay_;
+    }
+
+   private:
+    friend class FsChannelOverloadController;
+
+    Slot(
+        std::shared_ptr<FsChannelOverloadController> controller,
+        pid_t pid,
+        RequestKind kind,
+        std::chrono::steady_clock::duration queueDelay) noexcept
+        : controller_{std::move(controller)},
+          pid_{pid},
+          kind_{kind},
+          queueDelay_{queueDelay} {}
+
+    void release() noexcept;
+
+    // Null once released, or when the controller is disabled.
+    std::shared_ptr<FsChannelOverloadController> controller_;
+    pid_t pid_;
+    RequestKind kind_;
+    std::chrono::steady_clock::duration queueDelay_;
+  };
+
+  explicit FsChannelOverloadController(Config config);
+
+  FsChannelOverloadController(const FsChannelOverloadController&) = delete;
+  FsChannelOverloadController& operator=(const FsChannelOverloadController&) =
+      delete;
+
+  /**
+   * Admits a request of the process pid once it may run. The returned future
+   * is ready unless the request queued, and fails with an EAGAIN
+   * std::system_error if the request is shed.
+   *
+   * The controller must be managed by a std::shared_ptr, which its Slots
+   * hold on to.
+   */
+  ImmediateFuture<Slot> admit(pid_t pid, RequestKind kind);
+
+  Stats getStats() const;
+
+ private:
+  struct Waiter {
+    pid_t pid;
+    RequestKind kind;
+    std::chrono::steady_clock::time_point queuedAt;
+    folly::Promise<Slot> promise;
+  };
+
+  struct State {
+    // The number of admitted requests, in total and by process, and the
+    // number of admitted bulk requests by process.
+    size_t inFlight{0};
+    folly::F14FastMap<pid_t, size_t> inFlightByPid;
+    folly::F14FastMap<pid_t, size_t> bulkInFlightByPid;
+    std::deque<Waiter> metadata;
+    folly::F14FastMap<pid_t, std::deque<Waiter>> bulk;
+    size_t queuedBulk{0};
+    uint64_t deferred{0};
+    uint64_t shed{0};
+  };
+
+  bool bulkLimited(const State& state, pid_t pid) const;
+  static void admitted(State& state, pid_t pid, RequestKind kind);
+  void release(pid_t pid, RequestKind kind) noexcept;
+
+  const Config config_;
+  folly::Synchronized<State, std::mutex> state_;
+};
+
+} // namespace facebook::eden
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/Hex.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define EDEN_HEX_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define EDEN_HEX_NEON 1
+#endif
+
+namespace facebook::eden {
+
+namespace {
+
+constexpr char kHexDigits[] = "0123456789abcdef";
+
+/**
+ * Return the value of a hex digit, or a value larger than 15 if c is not a
+ * hex digit.
+ */
+uint8_t hexValue(char c) {
+  auto digit = static_cast<uint8_t>(c - '0');
+  if (digit < 10) {
+    return digit;
+  }
+  auto alpha = static_cast<uint8_t>((c | 0x20) - 'a');
+  if (alpha < 6) {
+    return alpha + 10;
+  }
+  return 0xff;
+}
+
+#if EDEN_HEX_SSE2
+
+__m128i nibblesToHex(__m128i nibbles) {
+  // '0' + n for digits, 'a' + n - 10 for letters.
+  auto letters = _mm_cmpgt_epi8(nibbles, _mm_set1_epi8(9));
+  return _mm_add_epi8(
+      _mm_add_epi8(nibbles, _mm_set1_epi8('0')),
+      _mm_and_si128(letters, _mm_set1_epi8('a' - '0' - 10)));
+}
+
+/**
+ * Encode 16 bytes into 32 hex characters.
+ */
+void encodeBlock(const uint8_t* in, char* out) {
+  auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+  auto mask = _mm_set1_epi8(0x0f);
+  auto high = _mm_and_si128(_mm_srli_epi16(bytes, 4), mask);
+  auto low = _mm_and_si128(bytes, mask);
+  _mm_storeu_si128(
+      reinterpret_cast<__m128i*>(out),
+      nibblesToHex(_mm_unpacklo_epi8(high, low)));
+  _mm_storeu_si128(
+      reinterpret_cast<__m128i*>(out + 16),
+      nibblesToHex(_mm_unpackhi_epi8(high, low)));
+}
+
+/**
+ * Convert 16 hex characters into their values, clearing bits of valid for
+ * the characters that are not hex digits.
+ */
+__m128i hexToNibbles(__m128i chars, __m128i& valid) {
+  auto digit = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+  auto isDigit =
+      _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+  auto alpha = _mm_sub_epi8(
+      _mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+  auto isAlpha =
+      _mm_cmpeq_epi8(_mm_min_epu8(alpha, _mm_set1_epi8(5)), alpha);
+  valid = _mm_and_si128(valid, _mm_or_si128(isDigit, isAlpha));
+  return _mm_or_si128(
+      _mm_and_si128(digit, isDigit),
+      _mm_and_si128(_mm_add_epi8(alpha, _mm_set1_epi8(10)), isAlpha));
+}
+
+/**
+ * Combine pairs of nibbles into eight 16-bit lanes holding one byte each.
+ */
+__m128i combineNibbles(__m128i nibbles) {
+  // On little endian, each lane holds the high nibble in its low byte.
+  return _mm_or_si128(
+      _mm_and_si128(_mm_slli_epi16(nibbles, 4), _mm_set1_epi16(0x00f0)),
+      _mm_srli_epi16(nibbles, 8));
+}
+
+/**
+ * Decode 32 hex characters into 16 bytes.
+ */
+bool decodeBlock(const char* in, uint8_t* out) {
+  auto valid = _mm_set1_epi8(-1);
+  auto first = hexToNibbles(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(in)), valid);
+  auto second = hexToNibbles(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 16)), valid);
+  _mm_storeu_si128(
+      reinterpret_cast<__m128i*>(out),
+      _mm_packus_epi16(combineNibbles(first), combineNibbles(second)));
+  return _mm_movemask_epi8(valid) == 0xffff;
+}
+
+#elif EDEN_HEX_NEON
+
+uint8x16_t nibblesToHex(uint8x16_t nibbles) {
+  // '0' + n for digits, 'a' + n - 10 for letters.
+  auto letters = vcgtq_u8(nibbles, vdupq_n_u8(9));
+  return vaddq_u8(
+      vaddq_u8(nibbles, vdupq_n_u8('0')),
+      vandq_u8(letters, vdupq_n_u8('a' - '0' - 10)));
+}
+
+/**
+ * Encode 16 bytes into 32 hex characters.
+ */
+void encodeBlock(const uint8_t* in, char* out) {
+  auto bytes = vld1q_u8(in);
+  auto nibbles =
+      vzipq_u8(vshrq_n_u8(bytes, 4), vandq_u8(bytes, vdupq_n_u8(0x0f)));
+  vst1q_u8(reinterpret_cast<uint8_t*>(out), nibblesToHex(nibbles.val[0]));
+  vst1q_u8(
+      reinterpret_cast<uint8_t*>(out + 16), nibblesToHex(nibbles.val[1]));
+}
+
+/**
+ * Convert 16 hex characters into their values, clearing bits of valid for
+ * the characters that are not hex digits.
+ */
+uint8x16_t hexToNibbles(uint8x16_t chars, uint8x16_t& valid) {
+  auto digit = vsubq_u8(chars, vdupq_n_u8('0'));
+  auto isDigit = vcleq_u8(digit, vdupq_n_u8(9));
+  auto alpha =
+      vsubq_u8(vorrq_u8(chars, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+  auto isAlpha = vcleq_u8(alpha, vdupq_n_u8(5));
+  valid = vandq_u8(valid, vorrq_u8(isDigit, isAlpha));
+  return vorrq_u8(
+      vandq_u8(digit, isDigit),
+      vandq_u8(vaddq_u8(alpha, vdupq_n_u8(10)), isAlpha));
+}
+
+/**
+ * Decode 32 hex characters into 16 bytes.
+ */
+bool decodeBlock(const char* in, uint8_t* out) {
+  auto valid = vdupq_n_u8(0xff);
+  auto chars = reinterpret_cast<const uint8_t*>(in);
+  auto first = hexToNibbles(vld1q_u8(chars), valid);
+  auto second = hexToNibbles(vld1q_u8(chars + 16), valid);
+  auto nibbles = vuzpq_u8(first, second);
+  vst1q_u8(
+      out, vorrq_u8(vshlq_n_u8(nibbles.val[0], 4), nibbles.val[1]));
+  return vminvq_u8(valid) == 0xff;
+}
+
+#endif
+
+} // namespace
+
+void encodeHex(folly::ByteRange bytes, char* out) noexcept {
+  auto* in = bytes.data();
+  auto* end = in + bytes.size();
+#if EDEN_HEX_SSE2 || EDEN_HEX_NEON
+  for (; end - in >= 16; in += 16, out += 32) {
+    encodeBlock(in, out);
+  }
+#endif
+  for (; in != end; ++in) {
+    *out++ = kHexDigits[*in >> 4];
+    *out++ = kHexDigits[*in & 0x0f];
+  }
+}
+
+bool decodeHex(folly::StringPiece hex, uint8_t* out) noexcept {
+  if (hex.size() % 2 != 0) {
+    return false;
+  }
+  auto* in = hex.data();
+  auto* end = in + hex.size();
+#if EDEN_HEX_SSE2 || EDEN_HEX_NEON
+  for (; end - in >= 32; in += 32, out += 16) {
+    if (!decodeBlock(in, out)) {
+      return false;
+    }
+  }
+#endif
+  for (; in != end; in += 2) {
+    auto high = hexValue(in[0]);
+    auto low = hexValue(in[1]);
+    if ((high | low) > 0x0f) {
+      return false;
+    }
+    *out++ = (high << 4) | low;
+  }
+  return true;
+}
+
+} // namespace facebook::eden
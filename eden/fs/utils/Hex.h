@@ -0,0 +1,31 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+
+namespace facebook::eden {
+
+/**
+ * Write the lowercase hex representation of bytes to out, which must have
+ * room for 2 * bytes.size() characters.
+ *
+ * Uses SSE2 or NEON when available, which processes 16 bytes at a time.
+ */
+void encodeHex(folly::ByteRange bytes, char* out) noexcept;
+
+/**
+ * Decode the hex digits of hex, in either case, into out, which must have room
+ * for hex.size() / 2 bytes.
+ *
+ * Returns false if hex has an odd size or contains a character that is not a
+ * hex digit. The content of out is unspecified in that case.
+ */
+bool decodeHex(folly::StringPiece hex, uint8_t* out) noexcept;
+
+} // namespace facebook::eden
@@ -299,6 +299,39 @@ folly::SemiFuture<T> ImmediateFuture<T>::semi() && {
   folly::assume_unreachable();
 }
 
+#if FOLLY_HAS_COROUTINES
+template <typename T>
+detail::ImmediateFutureAwaiter<T> ImmediateFuture<T>::operator co_await() &&
+    noexcept {
+  return detail::ImmediateFutureAwaiter<T>{std::move(*this)};
+}
+
+namespace detail {
+template <typename T>
+void ImmediateFutureAwaiter<T>::await_suspend(
+    folly::coro::coroutine_handle<> continuation) {
+  // The callback may run inline, and the coroutine frame holding this
+  // awaiter may be destroyed as soon as it resumes: keep the future alive on
+  // the stack until setCallback_ returns.
+  auto future = std::move(future_).semi().toUnsafeFuture();
+  future.setCallback_(
+      [this, continuation](
+          folly::Executor::KeepAlive<>&&, folly::Try<T>&& result) mutable {
+        result_.emplace(std::move(result));
+        continuation.resume();
+      });
+}
+
+template <typename T>
+T ImmediateFutureAwaiter<T>::await_resume() {
+  if (result_) {
+    return std::move(*result_).value();
+  }
+  return std::move(future_).get();
+}
+} // namespace detail
+#endif
+
 template <typename T, typename E>
 typename std::
     enable_if_t<std::is_base_of<std::exception, E>::value, ImmediateFuture<T>>
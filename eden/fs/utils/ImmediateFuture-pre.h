@@ -16,6 +16,11 @@ template <typename T>
 class ImmediateFuture;
 
 namespace detail {
+#if FOLLY_HAS_COROUTINES
+template <typename T>
+class ImmediateFutureAwaiter;
+#endif
+
 template <typename T>
 struct isImmediateFuture : std::false_type {};
 
@@ -8,8 +8,13 @@
 #pragma once
 
 #include <folly/futures/Future.h>
+#include <optional>
 #include "eden/fs/utils/ImmediateFuture-pre.h"
 
+#if FOLLY_HAS_COROUTINES
+#include <folly/experimental/coro/Coroutine.h>
+#endif
+
 namespace facebook::eden {
 
 /**
@@ -230,6 +235,21 @@ class ImmediateFuture {
    */
   folly::Try<T> getTry(folly::HighResDuration timeout) &&;
 
+#if FOLLY_HAS_COROUTINES
+  /**
+   * Make this ImmediateFuture awaitable from a coroutine, like a
+   * folly::coro::Task:
+   *
+   *   auto tree = co_await objectStore->getTree(id, context);
+   *
+   * When this ImmediateFuture is ready, the coroutine resumes inline without
+   * allocating anything. Otherwise, it is suspended until the underlying
+   * SemiFuture completes, and a folly::coro::Task then resumes on its
+   * executor.
+   */
+  detail::ImmediateFutureAwaiter<T> operator co_await() && noexcept;
+#endif
+
  private:
   /**
    * Define the behavior of the SemiFuture constructor and continuation when
@@ -289,6 +309,30 @@ class ImmediateFuture {
   Kind kind_;
 };
 
+#if FOLLY_HAS_COROUTINES
+namespace detail {
+template <typename T>
+class ImmediateFutureAwaiter {
+ public:
+  explicit ImmediateFutureAwaiter(ImmediateFuture<T>&& future) noexcept
+      : future_{std::move(future)} {}
+
+  bool await_ready() const {
+    return future_.isReady();
+  }
+
+  void await_suspend(folly::coro::coroutine_handle<> continuation);
+
+  T await_resume();
+
+ private:
+  ImmediateFuture<T> future_;
+  // Only set when the coroutine was suspended.
+  std::optional<folly::Try<T>> result_;
+};
+} // namespace detail
+#endif
+
 /**
  * Exception thrown if the ImmediateFuture is used after being destroyed.
  */
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/InternedString.h"
+
+#include <folly/Indestructible.h>
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <folly/hash/SpookyHashV2.h>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+
+namespace facebook::eden {
+
+namespace {
+uint64_t hashString(const char* data, size_t size) {
+  return folly::hash::SpookyHashV2::Hash64(data, size, 0);
+}
+
+struct Table {
+  static constexpr size_t kShardCount = 64;
+
+  // The entries of a shard, keyed by their own string.
+  using Shard = folly::Synchronized<
+      folly::F14FastMap<std::string_view, void*>,
+      std::mutex>;
+
+  Shard& getShard(uint64_t hash) {
+    // F14 uses the low bits of the hash, select shards with the high ones.
+    return shards[(hash >> 58) % kShardCount];
+  }
+
+  std::array<Shard, kShardCount> shards;
+};
+
+Table& getTable() {
+  static folly::Indestructible<Table> table;
+  return *table;
+}
+} // namespace
+
+InternedString::InternedString(const char* data, size_t size) {
+  if (size == 0) {
+    return;
+  }
+  if (size > std::numeric_limits<uint32_t>::max()) {
+    throw std::length_error("string too long to intern");
+  }
+
+  auto hash = hashString(data, size);
+  auto shard = getTable().getShard(hash).lock();
+  auto it = shard->find(std::string_view{data, size});
+  if (it != shard->end()) {
+    entry_ = static_cast<Entry*>(it->second);
+    // Entries are only freed with the shard locked, so this entry is still
+    // referenced.
+    entry_->refCount.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  auto* memory = std::malloc(sizeof(Entry) + size);
+  if (!memory) {
+    throw std::bad_alloc();
+  }
+  entry_ = new (memory) Entry{{1}, static_cast<uint32_t>(size), hash};
+  std::memcpy(const_cast<char*>(entry_->data()), data, size);
+  shard->emplace(std::string_view{entry_->data(), size}, entry_);
+}
+
+uint64_t InternedString::hash() const {
+  return entry_ ? entry_->hash : hashString("", 0);
+}
+
+void InternedString::release(Entry* entry) noexcept {
+  auto count = entry->refCount.load(std::memory_order_relaxed);
+  while (count > 1) {
+    if (entry->refCount.compare_exchange_weak(
+            count, count - 1, std::memory_order_acq_rel)) {
+      return;
+    }
+  }
+
+  // This may be the last reference. Only drop it with the shard locked, so
+  // that a concurrent lookup either sees the entry with a reference or
+  // doesn't see it at all.
+  auto shard = getTable().getShard(entry->hash).lock();
+  if (entry->refCount.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+    return;
+  }
+  shard->erase(std::string_view{entry->data(), entry->size});
+  entry->~Entry();
+  std::free(entry);
+}
+
+size_t InternedString::getInternedCount() {
+  size_t count = 0;
+  for (auto& shard : getTable().shards) {
+    count += shard.lock()->size();
+  }
+  return count;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string_view>
+
+namespace facebook::eden {
+
+/**
+ * An immutable string whose contents are shared with every other equal
+ * InternedString: the strings are hash-consed in a global, sharded and
+ * reference counted table, and an entry is freed when its last
+ * InternedString is destroyed.
+ *
+ * Creating an InternedString costs a hash and a lookup under a shard lock,
+ * copying one an atomic increment. In return, equal strings cost a single
+ * allocation, and comparing two InternedStrings for equality compares
+ * pointers. This pays off for the small set of names that are repeated
+ * millions of times across a repository, like directory and build file
+ * names.
+ *
+ * This is the storage of InternedPathComponent.
+ */
+class InternedString {
+ public:
+  /** The empty string, which doesn't use the table. */
+  InternedString() noexcept = default;
+
+  InternedString(const char* data, size_t size);
+  explicit InternedString(std::string_view str)
+      : InternedString{str.data(), str.size()} {}
+
+  InternedString(const InternedString& other) noexcept : entry_{other.entry_} {
+    if (entry_) {
+      entry_->refCount.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  InternedString(InternedString&& other) noexcept : entry_{other.entry_} {
+    other.entry_ = nullptr;
+  }
+  InternedString& operator=(const InternedString& other) noexcept {
+    InternedString copy{other};
+    std::swap(entry_, copy.entry_);
+    return *this;
+  }
+  InternedString& operator=(InternedString&& other) noexcept {
+    std::swap(entry_, other.entry_);
+    return *this;
+  }
+  ~InternedString() {
+    if (entry_) {
+      release(entry_);
+    }
+  }
+
+  const char* data() const {
+    return entry_ ? entry_->data() : "";
+  }
+  size_t size() const {
+    return entry_ ? entry_->size : 0;
+  }
+  bool empty() const {
+    return !entry_;
+  }
+
+  /**
+   * The SpookyHashV2 64 bit hash of the string with a seed of 0, computed
+   * once when it was interned.
+   */
+  uint64_t hash() const;
+
+  /* implicit */ operator std::string_view() const {
+    return std::string_view{data(), size()};
+  }
+
+  /**
+   * Equal strings are the same entry, so comparing them is comparing
+   * pointers.
+   */
+  friend bool operator==(const InternedString& a, const InternedString& b) {
+    return a.entry_ == b.entry_;
+  }
+  friend bool operator!=(const InternedString& a, const InternedString& b) {
+    return a.entry_ != b.entry_;
+  }
+
+  /**
+   * The number of distinct strings currently interned.
+   */
+  static size_t getInternedCount();
+
+ private:
+  struct Entry {
+    std::atomic<uint32_t> refCount;
+    uint32_t size;
+    uint64_t hash;
+
+    // The string follows the entry.
+    const char* data() const {
+      return reinterpret_cast<const char*>(this + 1);
+    }
+  };
+
+  static void release(Entry* entry) noexcept;
+
+  Entry* entry_{nullptr};
+};
+
+} // namespace facebook::eden
@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/IoUring.h"
+
+#include <folly/Exception.h>
+#include <folly/String.h>
+#include <folly/logging/xlog.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace facebook::eden {
+
+#ifdef __linux__
+
+namespace {
+#ifdef IORING_OP_UNLINKAT
+constexpr uint8_t kOpUnlinkAt = IORING_OP_UNLINKAT;
+#else
+// Older kernel headers predate IORING_OP_UNLINKAT (Linux 5.11); the kernel
+// rejects it with -EINVAL if it does not know about it either.
+constexpr uint8_t kOpUnlinkAt = 36;
+#endif
+
+int ioUringSetup(uint32_t entries, io_uring_params* params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int ioUringEnter(int fd, uint32_t toSubmit, uint32_t minComplete) {
+  return static_cast<int>(syscall(
+      __NR_io_uring_enter,
+      fd,
+      toSubmit,
+      minComplete,
+      IORING_ENTER_GETEVENTS,
+      nullptr,
+      0));
+}
+
+template <typename T>
+T loadAcquire(const T* ptr) {
+  return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+template <typename T>
+void storeRelease(T* ptr, T value) {
+  __atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+
+struct Mapping {
+  Mapping() = default;
+  Mapping(const Mapping&) = delete;
+  Mapping& operator=(const Mapping&) = delete;
+
+  ~Mapping() {
+    if (addr != MAP_FAILED) {
+      munmap(addr, size);
+    }
+  }
+
+  bool map(int fd, size_t length, off_t offset) {
+    addr = mmap(
+        nullptr,
+        length,
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE,
+        fd,
+        offset);
+    size = length;
+    return addr != MAP_FAILED;
+  }
+
+  template <typename T>
+  T* at(uint32_t offset) const {
+    return reinterpret_cast<T*>(static_cast<char*>(addr) + offset);
+  }
+
+  void* addr{MAP_FAILED};
+  size_t size{0};
+};
+} // namespace
+
+struct IoUring::Rings {
+  ~Rings() {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+
+  int fd{-1};
+  uint32_t entries{0};
+
+  Mapping sqRing;
+  // Unused if the kernel maps both rings with a single mmap.
+  Mapping cqRing;
+  Mapping sqeMapping;
+
+  uint32_t* sqTail{nullptr};
+  uint32_t* sqMask{nullptr};
+  uint32_t* sqArray{nullptr};
+  io_uring_sqe* sqes{nullptr};
+
+  uint32_t* cqHead{nullptr};
+  uint32_t* cqTail{nullptr};
+  uint32_t* cqMask{nullptr};
+  io_uring_cqe* cqes{nullptr};
+};
+
+std::unique_ptr<IoUring> IoUring::tryCreate(uint32_t entries) {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  auto rings = std::make_unique<Rings>();
+  rings->fd = ioUringSetup(entries, &params);
+  if (rings->fd < 0) {
+    XLOG(DBG2) << "io_uring is not available: " << folly::errnoStr(errno);
+    return nullptr;
+  }
+  rings->entries = params.sq_entries;
+
+  size_t sqRingSize =
+      params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  size_t cqRingSize =
+      params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (singleMmap) {
+    sqRingSize = std::max(sqRingSize, cqRingSize);
+  }
+
+  if (!rings->sqRing.map(rings->fd, sqRingSize, IORING_OFF_SQ_RING) ||
+      (!singleMmap &&
+       !rings->cqRing.map(rings->fd, cqRingSize, IORING_OFF_CQ_RING)) ||
+      !rings->sqeMapping.map(
+          rings->fd,
+          params.sq_entries * sizeof(io_uring_sqe),
+          IORING_OFF_SQES)) {
+    XLOG(WARN) << "failed to map io_uring rings: " << folly::errnoStr(errno);
+    return nullptr;
+  }
+
+  const auto& sqRing = rings->sqRing;
+  const auto& cqRing = singleMmap ? rings->sqRing : rings->cqRing;
+  rings->sqTail = sqRing.at<uint32_t>(params.sq_off.tail);
+  rings->sqMask = sqRing.at<uint32_t>(params.sq_off.ring_mask);
+  rings->sqArray = sqRing.at<uint32_t>(params.sq_off.array);
+  rings->sqes = rings->sqeMapping.at<io_uring_sqe>(0);
+  rings->cqHead = cqRing.at<uint32_t>(params.cq_off.head);
+  rings->cqTail = cqRing.at<uint32_t>(params.cq_off.tail);
+  rings->cqMask = cqRing.at<uint32_t>(params.cq_off.ring_mask);
+  rings->cqes = cqRing.at<io_uring_cqe>(params.cq_off.cqes);
+
+  return std::unique_ptr<IoUring>{new IoUring{std::move(rings)}};
+}
+
+std::vector<int> IoUring::submitAndWait(folly::Range<const Op*> ops) {
+  auto& rings = *rings_;
+  std::vector<int> results(ops.size());
+
+  size_t next = 0;
+  while (next < ops.size()) {
+    auto batch = static_cast<uint32_t>(
+        std::min<size_t>(ops.size() - next, rings.entries));
+
+    // Only this thread produces submissions, so the tail can be read without
+    // synchronization; publishing it must not be reordered before the
+    // entries are filled in.
+    uint32_t tail = *rings.sqTail;
+    for (uint32_t i = 0; i < batch; ++i) {
+      const auto& op = ops[next + i];
+      uint32_t index = tail & *rings.sqMask;
+      auto* sqe = &rings.sqes[index];
+      memset(sqe, 0, sizeof(*sqe));
+      sqe->fd = op.fd;
+      sqe->user_data = next + i;
+      switch (op.kind) {
+        case Op::Kind::UnlinkAt:
+          sqe->opcode = kOpUnlinkAt;
+          sqe->addr = reinterpret_cast<uint64_t>(op.path);
+          break;
+        case Op::Kind::Fsync:
+          sqe->opcode = IORING_OP_FSYNC;
+          break;
+        case Op::Kind::Fdatasync:
+          sqe->opcode = IORING_OP_FSYNC;
+          sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+          break;
+      }
+      rings.sqArray[index] = index;
+      ++tail;
+    }
+    storeRelease(rings.sqTail, tail);
+
+    uint32_t unsubmitted = batch;
+    uint32_t outstanding = batch;
+    while (outstanding > 0) {
+      int rc = ioUringEnter(rings.fd, unsubmitted, outstanding);
+      if (rc < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        folly::throwSystemError("io_uring_enter failed");
+      }
+      unsubmitted -= std::min<uint32_t>(unsubmitted, rc);
+
+      uint32_t head = *rings.cqHead;
+      uint32_t cqTail = loadAcquire(rings.cqTail);
+      while (head != cqTail) {
+        const auto& cqe = rings.cqes[head & *rings.cqMask];
+        results[cqe.user_data] = cqe.res;
+        ++head;
+        --outstanding;
+      }
+      storeRelease(rings.cqHead, head);
+    }
+    next += batch;
+  }
+  return results;
+}
+
+#else
+
+struct IoUring::Rings {};
+
+std::unique_ptr<IoUring> IoUring::tryCreate(uint32_t /*entries*/) {
+  return nullptr;
+}
+
+std::vector<int> IoUring::submitAndWait(folly::Range<const Op*> /*ops*/) {
+  throw std::logic_error("io_uring is only supported on Linux");
+}
+
+#endif
+
+IoUring::IoUring(std::unique_ptr<Rings> rings) : rings_{std::move(rings)} {}
+
+IoUring::~IoUring() = default;
+
+} // namespace facebook::eden
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace facebook::eden {
+
+/**
+ * A minimal io_uring instance that submits a batch of filesystem operations
+ * with a single system call and waits for all of them to complete.
+ *
+ * This talks to the kernel through the raw io_uring system calls, and only
+ * supports the handful of operations the overlay needs. An IoUring is not
+ * thread-safe: callers must serialize calls to submitAndWait().
+ */
+class IoUring {
+ public:
+  struct Op {
+    enum class Kind : uint8_t {
+      UnlinkAt,
+      Fsync,
+      Fdatasync,
+    };
+
+    static Op unlinkAt(int dirfd, const char* path) {
+      return Op{Kind::UnlinkAt, dirfd, path};
+    }
+    static Op fsync(int fd) {
+      return Op{Kind::Fsync, fd, nullptr};
+    }
+    static Op fdatasync(int fd) {
+      return Op{Kind::Fdatasync, fd, nullptr};
+    }
+
+    Kind kind;
+    int fd;
+    /**
+     * Only used by UnlinkAt. Must stay valid until submitAndWait() returns.
+     */
+    const char* path;
+  };
+
+  /**
+   * Set up an io_uring with room for `entries` operations per submission.
+   *
+   * Returns nullptr if io_uring is not available, either because this is not
+   * Linux or because the kernel does not support or allow it.
+   */
+  static std::unique_ptr<IoUring> tryCreate(uint32_t entries);
+
+  ~IoUring();
+
+  IoUring(const IoUring&) = delete;
+  IoUring& operator=(const IoUring&) = delete;
+
+  /**
+   * Run every operation in `ops` and return their results, in order: zero
+   * on success or a negated errno value on failure, like the raw system
+   * calls. Batches larger than the ring are submitted in several rounds.
+   *
+   * Kernels that predate an operation report -EINVAL for it, in which case
+   * callers should fall back to the blocking system call.
+   *
+   * Throws std::system_error if the ring itself fails.
+   */
+  std::vector<int> submitAndWait(folly::Range<const Op*> ops);
+
+ private:
+  struct Rings;
+
+  explicit IoUring(std::unique_ptr<Rings> rings);
+
+  std::unique_ptr<Rings> rings_;
+};
+
+} // namespace facebook::eden
@@ -6,72 +6,224 @@
  */
 
 #pragma once
+
+#include <folly/Synchronized.h>
 #include <folly/container/EvictingCacheMap.h>
-#include <folly/futures/Future.h>
 #include <folly/futures/SharedPromise.h>
+#include <folly/lang/Align.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "eden/fs/utils/ImmediateFuture.h"
 
 namespace facebook::eden {
 
+/**
+ * A single-flight cache: the first get() of a key fetches its value, the
+ * concurrent get() of the same key wait for that fetch instead of starting
+ * their own, and the following ones are served from the cache until the
+ * value expires or is evicted.
+ *
+ * Keys are spread over shards, each with its own lock and its own share of
+ * maxSize in least recently used order, so that lookups of different keys
+ * rarely contend. Failed fetches are not cached: the next get() of the key
+ * fetches it again.
+ *
+ * A fetch completing immediately is returned immediately, without going
+ * through a SemiFuture. The cache must outlive the fetches it started.
+ */
 template <typename KEY, typename VAL, typename HASH = std::hash<KEY>>
 class LeaseCache {
  public:
   using ValuePtr = std::shared_ptr<VAL>;
-  using FutureType = folly::Future<ValuePtr>;
-  using SharedPromiseType = std::shared_ptr<folly::SharedPromise<ValuePtr>>;
+  using FutureType = ImmediateFuture<ValuePtr>;
   using FetchFunc = std::function<FutureType(const KEY& key)>;
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr size_t kDefaultShards = 16;
+
+  struct Stats {
+    /** get() served from a cached value. */
+    uint64_t hits{0};
+    /** get() starting a fetch. */
+    uint64_t misses{0};
+    /** get() waiting for a fetch started by another one. */
+    uint64_t joins{0};
+    /** Misses due to an expired value. */
+    uint64_t expirations{0};
+    /** Entries evicted to stay under maxSize. */
+    uint64_t evictions{0};
+  };
+
+  /**
+   * A ttl of zero keeps the values until they are evicted or erased.
+   */
+  LeaseCache(
+      size_t maxSize,
+      FetchFunc fetcher,
+      Clock::duration ttl = Clock::duration::zero(),
+      size_t numShards = kDefaultShards)
+      : fetcher_{std::move(fetcher)}, ttl_{ttl}, shards_(numShards) {
+    for (auto& shard : shards_) {
+      auto state = shard.state.lock();
+      state->entries.setPruneHook(
+          [stats = &state->stats](const KEY&, Entry&&) { ++stats->evictions; });
+    }
+    setMaxSize(maxSize);
+  }
 
- private:
-  std::mutex lock_;
-  folly::EvictingCacheMap<KEY, SharedPromiseType, HASH> cache_;
-  FetchFunc fetcher_;
+  LeaseCache(const LeaseCache&) = delete;
+  LeaseCache& operator=(const LeaseCache&) = delete;
 
- public:
-  LeaseCache(size_t maxSize, FetchFunc fetcher, size_t clearSize = 1)
-      : cache_(maxSize, clearSize), fetcher_(fetcher) {}
+  FutureType get(const KEY& key) {
+    auto& shard = shardFor(key);
+    auto promise = std::make_shared<folly::SharedPromise<ValuePtr>>();
+    {
+      auto state = shard.state.lock();
+      auto it = state->entries.find(key);
+      if (it != state->entries.end()) {
+        auto& entry = it->second;
+        if (entry.pending) {
+          ++state->stats.joins;
+          return entry.pending->getSemiFuture();
+        }
+        if (!isExpired(entry)) {
+          ++state->stats.hits;
+          return entry.value;
+        }
+        ++state->stats.expirations;
+      }
+      ++state->stats.misses;
+      state->entries.set(key, Entry{nullptr, promise, {}});
+    }
 
+    auto future = fetcher_(key);
+    if (future.isReady()) {
+      return std::move(future).thenTry(
+          [this, key, promise = std::move(promise)](
+              folly::Try<ValuePtr>&& result) {
+            complete(key, promise, result);
+            return std::move(result);
+          });
+    }
+    // Complete the fetch eagerly, so that the get() joining it don't depend
+    // on this caller waiting for its future.
+    auto shared = promise->getSemiFuture();
+    std::move(future).semi().toUnsafeFuture().thenTry(
+        [this, key, promise = std::move(promise)](
+            folly::Try<ValuePtr>&& result) {
+          complete(key, promise, result);
+        });
+    return shared;
+  }
+
+  /**
+   * Cache a value, which a fetch of the key in flight won't replace.
+   */
   void set(const KEY& key, ValuePtr val) {
-    std::lock_guard<std::mutex> g(lock_);
-    auto entry = std::make_shared<typename SharedPromiseType::element_type>();
-    entry->setValue(val);
-    cache_.set(key, entry);
+    auto state = shardFor(key).state.lock();
+    state->entries.set(key, Entry{std::move(val), nullptr, expiryFromNow()});
   }
 
+  /**
+   * Forget the value of a key. A fetch of the key in flight still completes
+   * its waiters, but its value isn't cached.
+   */
   void erase(const KEY& key) {
-    std::lock_guard<std::mutex> g(lock_);
-    cache_.erase(key);
+    shardFor(key).state.lock()->entries.erase(key);
   }
 
   void setMaxSize(size_t size) {
-    cache_.setMaxSize(size);
+    auto perShard = (size + shards_.size() - 1) / shards_.size();
+    for (auto& shard : shards_) {
+      shard.state.lock()->entries.setMaxSize(std::max<size_t>(perShard, 1));
+    }
   }
 
-  FutureType get(const KEY& key) {
-    SharedPromiseType entry;
-
-    {
-      std::lock_guard<std::mutex> g(lock_);
-
-      auto it = cache_.find(key);
-      if (it != cache_.end()) {
-        entry = it->second;
-        return entry->getFuture();
-      }
+  /**
+   * Whether the key has an unexpired value or a fetch in flight.
+   */
+  bool exists(const KEY& key) {
+    auto state = shardFor(key).state.lock();
+    auto it = state->entries.findWithoutPromotion(key);
+    return it != state->entries.end() &&
+        (it->second.pending || !isExpired(it->second));
+  }
 
-      entry = std::make_shared<typename SharedPromiseType::element_type>();
-      cache_.set(key, entry);
+  Stats getStats() const {
+    Stats total;
+    for (const auto& shard : shards_) {
+      auto state = shard.state.lock();
+      total.hits += state->stats.hits;
+      total.misses += state->stats.misses;
+      total.joins += state->stats.joins;
+      total.expirations += state->stats.expirations;
+      total.evictions += state->stats.evictions;
     }
+    return total;
+  }
 
-    auto future = entry->getFuture();
+ private:
+  struct Entry {
+    /** Set once the fetch succeeded, or by set(). */
+    ValuePtr value;
+    /** Set while the fetch is in flight, for the get() joining it. */
+    std::shared_ptr<folly::SharedPromise<ValuePtr>> pending;
+    Clock::time_point expiry;
+  };
+
+  struct State {
+    // EvictingCacheMap isn't default constructible; the shards are sized by
+    // setMaxSize() once constructed.
+    folly::EvictingCacheMap<KEY, Entry, HASH> entries{1};
+    Stats stats;
+  };
+
+  struct alignas(folly::hardware_destructive_interference_size) Shard {
+    folly::Synchronized<State, std::mutex> state;
+  };
+
+  Shard& shardFor(const KEY& key) {
+    return shards_[HASH{}(key) % shards_.size()];
+  }
 
-    fetcher_(key).thenTry(
-        [entry](folly::Try<ValuePtr>&& t) { entry->setTry(std::move(t)); });
+  Clock::time_point expiryFromNow() const {
+    return ttl_ == Clock::duration::zero() ? Clock::time_point::max()
+                                           : Clock::now() + ttl_;
+  }
 
-    return future;
+  static bool isExpired(const Entry& entry) {
+    return entry.expiry != Clock::time_point::max() &&
+        Clock::now() >= entry.expiry;
   }
 
-  bool exists(const KEY& key) {
-    return cache_.exists(key);
+  void complete(
+      const KEY& key,
+      const std::shared_ptr<folly::SharedPromise<ValuePtr>>& promise,
+      const folly::Try<ValuePtr>& result) {
+    {
+      auto state = shardFor(key).state.lock();
+      auto it = state->entries.findWithoutPromotion(key);
+      // The entry may have been evicted, erased or set in the meantime.
+      if (it != state->entries.end() && it->second.pending == promise) {
+        if (result.hasValue()) {
+          it->second = Entry{result.value(), nullptr, expiryFromNow()};
+        } else {
+          state->entries.erase(it);
+        }
+      }
+    }
+    // Outside of the lock, as the waiters' callbacks may run inline.
+    promise->setTry(folly::Try<ValuePtr>{result});
   }
+
+  const FetchFunc fetcher_;
+  const Clock::duration ttl_;
+  std::vector<Shard> shards_;
 };
 
 } // namespace facebook::eden
@@ -15,6 +15,7 @@
 #include <folly/File.h>
 #include <folly/FileUtil.h>
 #include <folly/Range.h>
+#include <folly/String.h>
 #include <folly/logging/xlog.h>
 
 #ifndef _WIN32
@@ -122,11 +123,19 @@ class MappedDiskVector {
    * OldVersions are tried sequentially. If one succeeds, the entries are
    * converted one-by-one into the new format and the new table replaces the
    * old.
+   *
+   * If shouldPopulate is set, every page of the file is read in up front, for
+   * callers that are about to traverse every record. If useHugePages is set,
+   * the kernel is asked to back the mapping with transparent huge pages,
+   * which reduces TLB misses when accessing large files randomly. This is
+   * only a hint: most filesystems don't support huge pages for shared file
+   * mappings, in which case regular pages are used.
    */
   template <typename... OldVersions>
   static MappedDiskVector open(
       folly::StringPiece path,
-      bool shouldPopulate = false) {
+      bool shouldPopulate = false,
+      bool useHugePages = false) {
     folly::File file{path, O_RDWR | O_CREAT | O_CLOEXEC, 0600};
 
     if (!file.try_lock()) {
@@ -138,7 +147,11 @@ class MappedDiskVector {
         fstat(file.fd(), &st), "fstat failed on MappedDiskVector path ", path);
 
     if (st.st_size == 0) {
-      return initializeFromScratch(std::move(file));
+      auto mdv = initializeFromScratch(std::move(file));
+      if (useHugePages) {
+        mdv.adviseHugePages();
+      }
+      return mdv;
     }
 
     Header header;
@@ -184,8 +197,12 @@ class MappedDiskVector {
             " but file has ",
             header.recordSize));
       }
-      return MappedDiskVector{
+      MappedDiskVector mdv{
           std::move(file), st.st_size, header.entryCount, shouldPopulate};
+      if (useHugePages) {
+        mdv.adviseHugePages();
+      }
+      return mdv;
     }
 
     // Try to migrate from an old record format if any match.
@@ -201,13 +218,17 @@ class MappedDiskVector {
               " but file has ",
               header.recordSize));
         }
-        return detail::Migrator<T, OldVersions...>::migrateFrom(
+        auto mdv = detail::Migrator<T, OldVersions...>::migrateFrom(
             path,
             std::move(file),
             st.st_size,
             header.entryCount,
             i,
             [](const auto& from) { return T{from}; });
+        if (useHugePages) {
+          mdv.adviseHugePages();
+        }
+        return mdv;
       }
     }
 
@@ -439,9 +460,6 @@ class MappedDiskVector {
       }
     }
 
-    // Call readahead() here?  Offer it as optional functionality?
-    // InodeTable needs to traverse every record immediately after opening.
-
     auto map = mmap(
         0,
         desiredSize,
@@ -458,7 +476,11 @@ class MappedDiskVector {
     }
 
 #ifndef MAP_POPULATE
-    (void)populate;
+    // Without MAP_POPULATE, at least start reading the file in the background
+    // so that the first traversal doesn't fault in one page at a time.
+    if (populate && madvise(map, desiredSize, MADV_WILLNEED) != 0) {
+      XLOG(DBG3) << "madvise(MADV_WILLNEED) failed: " << folly::errnoStr(errno);
+    }
 #endif
 
     // Throw no exceptions between assigning the fields.
@@ -477,6 +499,19 @@ class MappedDiskVector {
         static_cast<char*>(map_) + mapSizeInBytes_);
   }
 
+  /**
+   * The advice is a property of the mapping, so it survives mremap() when the
+   * file grows. This does nothing on platforms without transparent huge
+   * pages, such as macOS.
+   */
+  void adviseHugePages() {
+#ifdef MADV_HUGEPAGE
+    if (madvise(map_, mapSizeInBytes_, MADV_HUGEPAGE) != 0) {
+      XLOG(DBG3) << "madvise(MADV_HUGEPAGE) failed: " << folly::errnoStr(errno);
+    }
+#endif
+  }
+
   bool hasRoom(size_t amount) const {
     // Technically, the expression (end_ + amount) is constructing a pointer
     // past the end of the "object" (mmap) and is thus UB.  But hopefully no
@@ -7,11 +7,42 @@
 
 #include "eden/fs/utils/Memory.h"
 
+#include <folly/memory/MallctlHelper.h>
+#include <folly/memory/Malloc.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdexcept>
 
 namespace facebook::eden {
 
+namespace {
+uint64_t readMallctl(const char* name) {
+  size_t value = 0;
+  folly::mallctlRead(name, &value);
+  return value;
+}
+} // namespace
+
+std::optional<AllocatorStats> getAllocatorStats() {
+  if (!folly::usingJEMalloc()) {
+    return std::nullopt;
+  }
+  try {
+    // jemalloc caches its statistics until the epoch is advanced.
+    folly::mallctlWrite<uint64_t>("epoch", 1);
+
+    AllocatorStats stats;
+    stats.allocated = readMallctl("stats.allocated");
+    stats.active = readMallctl("stats.active");
+    stats.metadata = readMallctl("stats.metadata");
+    stats.resident = readMallctl("stats.resident");
+    return stats;
+  } catch (const std::runtime_error&) {
+    // jemalloc was built without statistics.
+    return std::nullopt;
+  }
+}
+
 void assertZeroBits(const void* memory, size_t size) {
   if (0 == size) {
     return;
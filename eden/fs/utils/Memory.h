@@ -7,11 +7,36 @@
 
 #pragma once
 #include <folly/FBString.h>
+#include <cstdint>
 #include <map>
+#include <optional>
 #include <string>
 
 namespace facebook::eden {
 
+/**
+ * The state of the heap, from the allocator. The difference between active
+ * and allocated is the fragmentation inside of the allocator's pages, and the
+ * difference between resident and active the memory that was freed but not
+ * yet returned to the system, plus the allocator's own metadata.
+ */
+struct AllocatorStats {
+  // Bytes allocated by the application.
+  uint64_t allocated{0};
+  // Bytes in the pages that hold allocations.
+  uint64_t active{0};
+  // Bytes of the allocator's own data structures.
+  uint64_t metadata{0};
+  // Bytes of physical memory mapped by the allocator.
+  uint64_t resident{0};
+};
+
+/**
+ * Returns std::nullopt if the allocator is not jemalloc, which is the only
+ * one that reports its state.
+ */
+std::optional<AllocatorStats> getAllocatorStats();
+
 /**
  * Asserts the specified memory consists entirely of zeroes, and aborts the
  * process if not.
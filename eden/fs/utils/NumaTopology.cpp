@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/NumaTopology.h"
+
+#include <folly/Conv.h>
+#include <folly/FileUtil.h>
+#include <folly/ExceptionString.h>
+#include <folly/String.h>
+#include <folly/logging/xlog.h>
+#include <stdexcept>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace facebook::eden {
+
+namespace {
+NumaTopology detectTopology() {
+  std::vector<std::vector<size_t>> nodeCpus;
+#ifdef __linux__
+  try {
+    std::string online;
+    if (!folly::readFile("/sys/devices/system/node/online", online)) {
+      return NumaTopology{{}};
+    }
+    for (auto node :
+         NumaTopology::parseCpuList(folly::trimWhitespace(online))) {
+      std::string cpuList;
+      auto path = folly::to<std::string>(
+          "/sys/devices/system/node/node", node, "/cpulist");
+      if (!folly::readFile(path.c_str(), cpuList)) {
+        continue;
+      }
+      auto cpus = NumaTopology::parseCpuList(folly::trimWhitespace(cpuList));
+      // Memory-only nodes have no CPU to pin threads to.
+      if (!cpus.empty()) {
+        nodeCpus.push_back(std::move(cpus));
+      }
+    }
+  } catch (const std::exception& ex) {
+    XLOG(WARN) << "Unable to detect the NUMA topology: "
+               << folly::exceptionStr(ex);
+    nodeCpus.clear();
+  }
+  if (nodeCpus.size() < 2) {
+    nodeCpus.clear();
+  }
+#endif
+  return NumaTopology{std::move(nodeCpus)};
+}
+} // namespace
+
+const NumaTopology& NumaTopology::get() {
+  static const NumaTopology topology = detectTopology();
+  return topology;
+}
+
+std::vector<size_t> NumaTopology::parseCpuList(folly::StringPiece list) {
+  std::vector<size_t> cpus;
+  if (list.empty()) {
+    return cpus;
+  }
+  std::vector<folly::StringPiece> ranges;
+  folly::split(',', list, ranges);
+  for (auto range : ranges) {
+    folly::StringPiece first, last;
+    if (folly::split('-', range, first, last)) {
+      auto begin = folly::to<size_t>(first);
+      auto end = folly::to<size_t>(last);
+      if (end < begin) {
+        throw std::invalid_argument(
+            folly::to<std::string>("invalid CPU range: ", range));
+      }
+      for (auto cpu = begin; cpu <= end; ++cpu) {
+        cpus.push_back(cpu);
+      }
+    } else {
+      cpus.push_back(folly::to<size_t>(range));
+    }
+  }
+  return cpus;
+}
+
+bool NumaTopology::pinCurrentThread(size_t threadIndex) const {
+#ifdef __linux__
+  if (nodeCpus_.empty()) {
+    return false;
+  }
+  cpu_set_t cpuSet;
+  CPU_ZERO(&cpuSet);
+  for (auto cpu : nodeCpus_[getNodeForThread(threadIndex)]) {
+    if (cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &cpuSet);
+    }
+  }
+  if (sched_setaffinity(0, sizeof(cpuSet), &cpuSet) != 0) {
+    XLOG(WARN) << "Unable to pin thread to NUMA node "
+               << getNodeForThread(threadIndex) << ": "
+               << folly::errnoStr(errno);
+    return false;
+  }
+  return true;
+#else
+  (void)threadIndex;
+  return false;
+#endif
+}
+
+} // namespace facebook::eden
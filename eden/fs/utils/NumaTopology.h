@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <cstddef>
+#include <vector>
+
+namespace facebook::eden {
+
+/**
+ * The NUMA nodes of the host and their CPUs, as reported by
+ * /sys/devices/system/node on Linux. Other platforms, and hosts with a
+ * single node, are treated as having no NUMA topology.
+ */
+class NumaTopology {
+ public:
+  /**
+   * Builds a topology from the CPUs of every node.
+   */
+  explicit NumaTopology(std::vector<std::vector<size_t>> nodeCpus)
+      : nodeCpus_{std::move(nodeCpus)} {}
+
+  /**
+   * The topology of this host, detected on first use.
+   */
+  static const NumaTopology& get();
+
+  /**
+   * Parses a sysfs CPU or node list, like "0-3,8-11". Throws
+   * std::invalid_argument on malformed input.
+   */
+  static std::vector<size_t> parseCpuList(folly::StringPiece list);
+
+  size_t getNodeCount() const {
+    return nodeCpus_.size();
+  }
+
+  /**
+   * The node threads with the given index are spread to: consecutive
+   * indexes go to consecutive nodes, so that the threads of a pool are
+   * balanced across them.
+   */
+  size_t getNodeForThread(size_t threadIndex) const {
+    return nodeCpus_.empty() ? 0 : threadIndex % nodeCpus_.size();
+  }
+
+  const std::vector<size_t>& getCpus(size_t node) const {
+    return nodeCpus_.at(node);
+  }
+
+  /**
+   * Restricts the calling thread to the CPUs of the node of the thread with
+   * the given index, see getNodeForThread. Memory it then allocates and
+   * touches first is local to that node.
+   *
+   * Does nothing without NUMA topology. Returns whether the thread was
+   * pinned.
+   */
+  bool pinCurrentThread(size_t threadIndex) const;
+
+ private:
+  std::vector<std::vector<size_t>> nodeCpus_;
+};
+
+} // namespace facebook::eden
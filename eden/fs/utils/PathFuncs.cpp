@@ -21,11 +21,60 @@
 #include <mach-o/dyld.h> // @manual
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define EDEN_PATH_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define EDEN_PATH_NEON 1
+#endif
+
 using folly::Expected;
 using folly::StringPiece;
 
 namespace facebook::eden {
 
+bool detail::containsSeparatorOrNul(StringPiece str) {
+  const char* p = str.begin();
+  const char* const end = str.end();
+#if EDEN_PATH_SSE2
+  auto separator = _mm_set1_epi8(kDirSeparator);
+  auto winSeparator = _mm_set1_epi8(
+      folly::kIsWindows ? kWinDirSeparator : static_cast<char>(kDirSeparator));
+  auto nul = _mm_setzero_si128();
+  for (; end - p >= 16; p += 16) {
+    auto chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    auto found = _mm_or_si128(
+        _mm_or_si128(
+            _mm_cmpeq_epi8(chars, separator),
+            _mm_cmpeq_epi8(chars, winSeparator)),
+        _mm_cmpeq_epi8(chars, nul));
+    if (_mm_movemask_epi8(found)) {
+      return true;
+    }
+  }
+#elif EDEN_PATH_NEON
+  auto separator = vdupq_n_u8(kDirSeparator);
+  auto winSeparator = vdupq_n_u8(
+      folly::kIsWindows ? kWinDirSeparator : static_cast<char>(kDirSeparator));
+  for (; end - p >= 16; p += 16) {
+    auto chars = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+    auto found = vorrq_u8(
+        vorrq_u8(vceqq_u8(chars, separator), vceqq_u8(chars, winSeparator)),
+        vceqzq_u8(chars));
+    if (vmaxvq_u8(found)) {
+      return true;
+    }
+  }
+#endif
+  for (; p != end; ++p) {
+    if (isDirSeparator(*p) || *p == '\0') {
+      return true;
+    }
+  }
+  return false;
+}
+
 StringPiece dirname(StringPiece path) {
   auto dirSeparator = detail::rfindPathSeparator(path);
 
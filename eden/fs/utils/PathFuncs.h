@@ -15,6 +15,7 @@
 #include <folly/FBString.h>
 #include <folly/FBVector.h>
 #include <folly/String.h>
+#include <folly/Traits.h>
 #include <folly/hash/Hash.h>
 #include <folly/logging/xlog.h>
 #include <iterator>
@@ -23,6 +24,7 @@
 
 #include "eden/common/utils/StringConv.h"
 #include "eden/fs/utils/CaseSensitivity.h"
+#include "eden/fs/utils/InternedString.h"
 #include "eden/fs/utils/Throw.h"
 #include "eden/fs/utils/Utf8.h"
 
@@ -83,6 +85,12 @@ inline size_t findPathSeparator(folly::StringPiece str, size_t start = 0) {
   return index;
 }
 
+/**
+ * Returns whether str contains a directory separator or a nul byte. This
+ * scans 16 bytes at a time with SIMD instructions.
+ */
+bool containsSeparatorOrNul(folly::StringPiece str);
+
 inline size_t rfindPathSeparator(folly::StringPiece str) {
   auto index = str.rfind(kDirSeparator);
   if (folly::kIsWindows) {
@@ -227,6 +235,10 @@ class PathComponentNotUtf8 : public PathComponentValidationError {
 // is 32 bytes adds up.
 using PathComponent = detail::PathComponentBase<folly::fbstring>;
 using PathComponentPiece = detail::PathComponentBase<std::string_view>;
+// A PathComponent whose storage is shared with every equal
+// InternedPathComponent, for the containers that hold many copies of the same
+// names. See InternedString.
+using InternedPathComponent = detail::PathComponentBase<InternedString>;
 
 using RelativePath = detail::RelativePathBase<std::string>;
 using RelativePathPiece = detail::RelativePathBase<std::string_view>;
@@ -690,22 +702,41 @@ class PathBase :
 /// Asserts that val is a well formed path component
 struct PathComponentSanityCheck {
   constexpr void operator()(folly::StringPiece val) const {
-    for (auto c : val) {
-      if (isDirSeparator(c)) {
-        throw_<PathComponentContainsDirectorySeparator>(
-            "attempt to construct a PathComponent from a string containing a "
-            "directory separator: ",
-            val);
-      }
+    // At runtime, only look for the offending character once a vectorized
+    // scan found one.
+    if (folly::is_constant_evaluated_or(true) ||
+        detail::containsSeparatorOrNul(val)) {
+      for (auto c : val) {
+        if (isDirSeparator(c)) {
+          throw_<PathComponentContainsDirectorySeparator>(
+              "attempt to construct a PathComponent from a string containing "
+              "a directory separator: ",
+              val);
+        }
 
-      if (c == '\0') {
-        throw_<PathComponentValidationError>(
-            "attempt to construct a PathComponent from a string containing a "
-            "nul byte: ",
-            val);
+        if (c == '\0') {
+          throw_<PathComponentValidationError>(
+              "attempt to construct a PathComponent from a string containing "
+              "a nul byte: ",
+              val);
+        }
       }
     }
 
+    checkName(val);
+
+    if (!isValidUtf8(val)) {
+      throw_<PathComponentNotUtf8>(
+          "attempt to construct a PathComponent from non valid UTF8 data: ",
+          val);
+    }
+  }
+
+  /**
+   * Check the parts of a PathComponent's validity that don't depend on its
+   * individual characters.
+   */
+  static constexpr void checkName(folly::StringPiece val) {
     switch (val.size()) {
       case 0:
         throw PathComponentValidationError(
@@ -721,12 +752,6 @@ struct PathComponentSanityCheck {
         }
         break;
     }
-
-    if (!isValidUtf8(val)) {
-      throw_<PathComponentNotUtf8>(
-          "attempt to construct a PathComponent from non valid UTF8 data: ",
-          val);
-    }
   }
 };
 
@@ -754,6 +779,18 @@ class PathComponentBase
   explicit PathComponentBase() = delete;
 };
 
+// Equal InternedPathComponents share their storage.
+inline bool operator==(
+    const InternedPathComponent& a,
+    const InternedPathComponent& b) {
+  return a.value() == b.value();
+}
+inline bool operator!=(
+    const InternedPathComponent& a,
+    const InternedPathComponent& b) {
+  return a.value() != b.value();
+}
+
 /**
  * An iterator over prefixes of a composed path
  *
@@ -1238,6 +1275,11 @@ struct ComposedPathSanityCheck {
   constexpr void operator()(
       folly::StringPiece val,
       std::optional<char> pathSeparator = std::nullopt) const {
+    if (!folly::is_constant_evaluated_or(true) &&
+        checkWithoutNulOrInvalidUtf8(val, pathSeparator)) {
+      return;
+    }
+
     size_t start = 0;
     while (true) {
       auto next = nextSeparator(val, start, pathSeparator);
@@ -1254,6 +1296,40 @@ struct ComposedPathSanityCheck {
     PathComponentSanityCheck()(
         folly::StringPiece{val.begin() + start, val.end()});
   }
+
+ private:
+  /**
+   * The runtime fast path: when val has no nul byte and is valid UTF-8 as a
+   * whole, which memchr and a vectorized scan tell, its components only need
+   * their names checked. Returns false, for the caller to find the invalid
+   * component, if val isn't in that case.
+   */
+  static bool checkWithoutNulOrInvalidUtf8(
+      folly::StringPiece val,
+      std::optional<char> pathSeparator) {
+    // Components may contain some separators on Windows.
+    if (folly::kIsWindows ||
+        (pathSeparator && *pathSeparator != kDirSeparator)) {
+      return false;
+    }
+    if (val.find('\0') != folly::StringPiece::npos || !isValidUtf8(val)) {
+      return false;
+    }
+
+    size_t start = 0;
+    while (true) {
+      auto next = val.find(kDirSeparator, start);
+      if (next == folly::StringPiece::npos) {
+        break;
+      }
+      PathComponentSanityCheck::checkName(
+          folly::StringPiece{val.begin() + start, next - start});
+      start = next + 1;
+    }
+    PathComponentSanityCheck::checkName(
+        folly::StringPiece{val.begin() + start, val.end()});
+    return true;
+  }
 };
 
 /// Asserts that val is well formed relative path
@@ -1915,6 +1991,11 @@ size_t hash_value(const detail::PathComponentBase<A>& path) {
   return folly::hash::SpookyHashV2::Hash64(s.begin(), s.size(), 0);
 }
 
+// The same hash, computed once when the name was interned.
+inline size_t hash_value(const InternedPathComponent& path) {
+  return path.value().hash();
+}
+
 template <
     typename Storage,
     typename SanityChecker,
@@ -8,9 +8,12 @@
 #pragma once
 #include <folly/FBVector.h>
 #include <folly/Portability.h>
+#include <folly/hash/Hash.h>
 #include <algorithm>
+#include <atomic>
 #include <functional>
 #include <iterator>
+#include <memory>
 #include <utility>
 #include "eden/fs/utils/CaseSensitivity.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -31,6 +34,12 @@ namespace facebook::eden {
  *   it is better to pre-sort the data to be inserted.
  * - Since insert and erase operations move the vector contents around,
  *   those operations invalidate iterators.
+ * - Lookups in large maps go through a hash index of the keys (case folded
+ *   in case insensitive maps), built on the first such lookup and kept up to
+ *   date by inserts and erases. Finding a key is then a hash probe instead of
+ *   a binary search, which is cache unfriendly for large directories, and
+ *   which case folds every key it compares in case insensitive maps.
+ *   Iteration stays in sorted order.
  */
 template <typename Value, typename Key = PathComponent>
 class PathMap : private folly::fbvector<std::pair<Key, Value>> {
@@ -77,9 +86,218 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
     CaseSensitivity caseSensitive_{kPathMapDefaultCaseSensitive};
   };
 
+  /**
+   * An open addressing hash table from the keys, case folded for case
+   * insensitive maps, to their position in the vector.
+   */
+  class HashIndex {
+   public:
+    HashIndex(const Vector& vector, CaseSensitivity caseSensitive)
+        : caseSensitive_{caseSensitive} {
+      size_t capacity = 2;
+      while (capacity < vector.size() * 2) {
+        capacity *= 2;
+      }
+      slots_ = std::make_unique<Slot[]>(capacity);
+      mask_ = capacity - 1;
+      for (size_t i = 0; i < vector.size(); ++i) {
+        place(hashKey(Piece(vector[i].first)), i);
+      }
+    }
+
+    /** Returns the position of key in vector, or vector.size(). */
+    size_t find(const Vector& vector, Piece key) const {
+      auto hash = hashKey(key);
+      for (auto pos = hash & mask_; slots_[pos].position != 0;
+           pos = (pos + 1) & mask_) {
+        const auto& slot = slots_[pos];
+        if (slot.hash == hash &&
+            isPathPieceEqual(
+                Piece(vector[slot.position - 1].first), key, caseSensitive_)) {
+          return slot.position - 1;
+        }
+      }
+      return vector.size();
+    }
+
+    /**
+     * Whether one more key can be inserted without making the probes too
+     * long.
+     */
+    bool canInsert(size_t size) const {
+      return (size + 1) * 2 <= mask_ + 1;
+    }
+
+    /**
+     * Records that key was inserted at position, before the entries that
+     * followed it.
+     */
+    void inserted(Piece key, size_t position) {
+      for (size_t i = 0; i <= mask_; ++i) {
+        if (slots_[i].position > position) {
+          ++slots_[i].position;
+        }
+      }
+      place(hashKey(key), position);
+    }
+
+    /** Records that key, at position, is about to be erased. */
+    void erasing(Piece key, size_t position) {
+      auto pos = hashKey(key) & mask_;
+      while (slots_[pos].position != position + 1) {
+        pos = (pos + 1) & mask_;
+      }
+
+      // Move the following slots of the probe sequence back, so that they
+      // stay reachable from their home slot.
+      auto hole = pos;
+      for (pos = (pos + 1) & mask_; slots_[pos].position != 0;
+           pos = (pos + 1) & mask_) {
+        auto home = slots_[pos].hash & mask_;
+        if (((pos - home) & mask_) >= ((pos - hole) & mask_)) {
+          slots_[hole] = slots_[pos];
+          hole = pos;
+        }
+      }
+      slots_[hole] = Slot{};
+
+      for (size_t i = 0; i <= mask_; ++i) {
+        if (slots_[i].position > position + 1) {
+          --slots_[i].position;
+        }
+      }
+    }
+
+   private:
+    struct Slot {
+      // The low bits select the home slot, the others skip most key
+      // comparisons.
+      uint32_t hash{0};
+      // The position in the vector plus one, 0 for empty slots.
+      uint32_t position{0};
+    };
+
+    void place(uint32_t hash, size_t position) {
+      auto pos = hash & mask_;
+      while (slots_[pos].position != 0) {
+        pos = (pos + 1) & mask_;
+      }
+      slots_[pos] = Slot{hash, static_cast<uint32_t>(position + 1)};
+    }
+
+    uint32_t hashKey(Piece key) const {
+      // FNV-1a, folding ASCII bytes on the fly for case insensitive maps
+      // rather than into a temporary string.
+      uint64_t hash = 0xcbf29ce484222325ULL;
+      for (auto c : key.view()) {
+        if (caseSensitive_ == CaseSensitivity::Insensitive && c >= 'A' &&
+            c <= 'Z') {
+          c += 'a' - 'A';
+        }
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 0x100000001b3ULL;
+      }
+      // FNV mixes the low bits poorly for short keys.
+      return static_cast<uint32_t>(folly::hash::twang_mix64(hash));
+    }
+
+    std::unique_ptr<Slot[]> slots_;
+    size_t mask_;
+    CaseSensitivity caseSensitive_;
+  };
+
+  // Below these sizes, a binary search is about as fast as a hash probe.
+  // Case insensitive comparisons are more expensive, so the index pays off
+  // sooner for them.
+  static constexpr size_t kHashIndexMinSize = 1024;
+  static constexpr size_t kCaseInsensitiveHashIndexMinSize = 64;
+
   // Hold an instance of the comparator.
   Compare compare_;
 
+  /**
+   * Built lazily by const lookups, possibly concurrently, so it's published
+   * atomically. Mutations, which require exclusive access, update it or
+   * reset it.
+   */
+  mutable std::atomic<HashIndex*> hashIndex_{nullptr};
+
+  /** See getGeneration(). */
+  uint64_t generation_{0};
+
+  const HashIndex* getHashIndex() const {
+    auto* index = hashIndex_.load(std::memory_order_acquire);
+    if (index) {
+      return index;
+    }
+    auto built = std::make_unique<HashIndex>(*this, compare_.caseSensitive_);
+    if (hashIndex_.compare_exchange_strong(
+            index,
+            built.get(),
+            std::memory_order_acq_rel,
+            std::memory_order_acquire)) {
+      return built.release();
+    }
+    // Another thread published its index first.
+    return index;
+  }
+
+  void resetHashIndex() {
+    delete hashIndex_.exchange(nullptr, std::memory_order_relaxed);
+  }
+
+  bool useHashIndex() const {
+    return size() >=
+        (compare_.caseSensitive_ == CaseSensitivity::Insensitive
+             ? kCaseInsensitiveHashIndexMinSize
+             : kHashIndexMinSize);
+  }
+
+  /**
+   * Keeps the index, if any, up to date with an insert at iter. Shifting the
+   * positions costs about as much as the vector insert itself, and is much
+   * cheaper than hashing every key again.
+   */
+  void indexInserted(const_iterator iter) {
+    ++generation_;
+    auto* index = hashIndex_.load(std::memory_order_relaxed);
+    if (!index) {
+      return;
+    }
+    // size() includes the new key.
+    if (!index->canInsert(size() - 1)) {
+      // Let the next lookup build a larger one.
+      resetHashIndex();
+      return;
+    }
+    index->inserted(Piece(iter->first), iter - cbegin());
+  }
+
+  void indexErasing(const_iterator first, const_iterator last) {
+    ++generation_;
+    auto* index = hashIndex_.load(std::memory_order_relaxed);
+    if (!index) {
+      return;
+    }
+    if (last - first != 1) {
+      resetHashIndex();
+      return;
+    }
+    index->erasing(Piece(first->first), first - cbegin());
+  }
+
+  size_t findPosition(Piece key) const {
+    if (useHashIndex()) {
+      return getHashIndex()->find(*this, key);
+    }
+    auto iter = lower_bound(key);
+    if (iter != end() && !compare_(key, iter->first)) {
+      // Found it
+      return iter - begin();
+    }
+    return size();
+  }
+
  public:
   // Various type aliases to satisfy container concepts.
   using key_type = Key;
@@ -131,23 +349,28 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
 
   // inherit Move construction.
   PathMap(PathMap&& other) noexcept
-      : Vector(std::move(other)), compare_(other.compare_) {}
+      : Vector(std::move(other)),
+        compare_(other.compare_),
+        hashIndex_(
+            other.hashIndex_.exchange(nullptr, std::memory_order_relaxed)) {}
   PathMap& operator=(PathMap&& other) {
     other.swap(*this);
     return *this;
   }
 
+  ~PathMap() {
+    resetHashIndex();
+  }
+
   // inherit these methods from the underlying vector.
   using Vector::begin;
   using Vector::capacity;
   using Vector::cbegin;
   using Vector::cend;
-  using Vector::clear;
   using Vector::crbegin;
   using Vector::crend;
   using Vector::empty;
   using Vector::end;
-  using Vector::erase;
   using Vector::max_size;
   using Vector::rbegin;
   using Vector::rend;
@@ -158,6 +381,31 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
   void swap(PathMap& other) noexcept {
     Vector::swap(other);
     std::swap(compare_, other.compare_);
+    auto* index = hashIndex_.load(std::memory_order_relaxed);
+    hashIndex_.store(
+        other.hashIndex_.load(std::memory_order_relaxed),
+        std::memory_order_relaxed);
+    other.hashIndex_.store(index, std::memory_order_relaxed);
+    // Each map keeps its own generation, as positions cached along with it
+    // don't follow the contents.
+    ++generation_;
+    ++other.generation_;
+  }
+
+  void clear() noexcept {
+    resetHashIndex();
+    Vector::clear();
+    ++generation_;
+  }
+
+  iterator erase(const_iterator position) {
+    indexErasing(position, position + 1);
+    return Vector::erase(position);
+  }
+
+  iterator erase(const_iterator first, const_iterator last) {
+    indexErasing(first, last);
+    return Vector::erase(first, last);
   }
 
   /**
@@ -179,24 +427,14 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
    * Does not allocate a copy of the key string.
    */
   iterator find(Piece key) {
-    auto iter = lower_bound(key);
-    if (iter != end() && !compare_(key, iter->first)) {
-      // Found it
-      return iter;
-    }
-    return end();
+    return begin() + findPosition(key);
   }
 
   /** Find using the Piece representation of a key.
    * Does not allocate a copy of the key string.
    */
   const_iterator find(Piece key) const {
-    auto iter = lower_bound(key);
-    if (iter != end() && !compare_(key, iter->first)) {
-      // Found it
-      return iter;
-    }
-    return end();
+    return begin() + findPosition(key);
   }
 
   /** Insert a new key-value pair.
@@ -212,7 +450,27 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
     }
 
     // Otherwise, iter is the insertion point
-    return std::make_pair(Vector::insert(iter, val), true);
+    iter = Vector::insert(iter, val);
+    indexInserted(iter);
+    return std::make_pair(iter, true);
+  }
+
+  /** Insert a new key-value pair, moving it in.
+   * Keys inserted in sorted order are appended without a binary search,
+   * which makes populating a map from sorted data linear. */
+  std::pair<iterator, bool> insert(value_type&& val) {
+    auto iter = Vector::empty() || compare_(Vector::back().first, val.first)
+        ? end()
+        : lower_bound(val.first);
+
+    if (iter != end() && !compare_(val.first, iter->first)) {
+      // Found it; leave it alone
+      return std::make_pair(iter, false);
+    }
+
+    iter = Vector::insert(iter, std::move(val));
+    indexInserted(iter);
+    return std::make_pair(iter, true);
   }
 
   /** Emplace a new key-value pair by constructing it in-place.
@@ -233,6 +491,7 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
     // Otherwise, iter is the insertion point
     iter = Vector::emplace(
         iter, std::make_pair(Key(key), Value(std::forward<Args>(args)...)));
+    indexInserted(iter);
     return std::make_pair(iter, true);
   }
 
@@ -248,6 +507,7 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
 
     // Not yet present, make a new one at the insertion point
     iter = Vector::insert(iter, std::make_pair(Key(key), mapped_type()));
+    indexInserted(iter);
     return iter->second;
   }
 
@@ -301,6 +561,16 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
     return compare_.caseSensitive_;
   }
 
+  /**
+   * Incremented whenever entries are inserted or removed, and thus whenever
+   * the positions of the entries may change. Positions computed for a given
+   * generation remain valid while it is current. Assigning a value in place
+   * doesn't change the generation.
+   */
+  uint64_t getGeneration() const {
+    return generation_;
+  }
+
   /// Equality operator.
   template <typename V, typename K>
   friend bool operator==(const PathMap<V, K>& lhs, const PathMap<V, K>& rhs);
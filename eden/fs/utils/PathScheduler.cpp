@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/PathScheduler.h"
+
+#include <folly/Synchronized.h>
+#include <folly/logging/xlog.h>
+#include <deque>
+#include <vector>
+
+#include "eden/fs/utils/PathMap.h"
+#include "eden/fs/utils/UnboundedQueueExecutor.h"
+
+namespace facebook::eden {
+
+struct PathScheduler::Task {
+  Task(RelativePath path, folly::Func func)
+      : path{std::move(path)}, func{std::move(func)} {}
+
+  RelativePath path;
+  folly::Func func;
+  // Number of earlier tasks that must return before this one can start.
+  size_t blockers{0};
+  // Later tasks that wait for this one to return.
+  std::vector<std::shared_ptr<Task>> blocked;
+};
+
+/**
+ * A node of the tree of paths that have tasks, either for themselves or for
+ * one of their descendants. Nodes are removed as soon as they have neither.
+ */
+struct PathScheduler::Node {
+  explicit Node(CaseSensitivity caseSensitive) : children{caseSensitive} {}
+
+  // The tasks added for exactly this path, oldest first. Each of them waits
+  // for the ones before it, they thus return in that order.
+  std::deque<std::shared_ptr<Task>> tasks;
+  PathMap<std::unique_ptr<Node>> children;
+};
+
+struct PathScheduler::State {
+  struct Queue {
+    explicit Queue(CaseSensitivity caseSensitive) : root{caseSensitive} {}
+
+    Node root;
+    size_t pending{0};
+  };
+
+  State(folly::Executor::KeepAlive<> executor, CaseSensitivity caseSensitive)
+      : executor{std::move(executor)},
+        caseSensitive{caseSensitive},
+        queue{folly::in_place, caseSensitive} {}
+
+  /**
+   * Make task wait for all the tasks of node. Since these return in order,
+   * waiting for the most recent one is enough.
+   */
+  static void blockOnNode(const Node& node, const std::shared_ptr<Task>& task) {
+    if (!node.tasks.empty()) {
+      node.tasks.back()->blocked.push_back(task);
+      ++task->blockers;
+    }
+  }
+
+  static void blockOnSubtree(
+      const Node& node,
+      const std::shared_ptr<Task>& task) {
+    for (const auto& [name, child] : node.children) {
+      blockOnNode(*child, task);
+      blockOnSubtree(*child, task);
+    }
+  }
+
+  static folly::Func makeRunner(
+      const std::shared_ptr<State>& state,
+      std::shared_ptr<Task> task) {
+    return [state, task = std::move(task)] {
+      task->func();
+      complete(state, task);
+    };
+  }
+
+  static void schedule(
+      const std::shared_ptr<State>& state,
+      std::shared_ptr<Task> task) {
+    state->executor->add(makeRunner(state, std::move(task)));
+  }
+
+  /**
+   * A task on a directory may unblock the tasks of all of its children at
+   * once, which are then queued in bulk when the executor supports it.
+   */
+  static void scheduleAll(
+      const std::shared_ptr<State>& state,
+      std::vector<std::shared_ptr<Task>> tasks) {
+    auto* unbounded =
+        dynamic_cast<UnboundedQueueExecutor*>(state->executor.get());
+    if (!unbounded || tasks.size() < 2) {
+      for (auto& task : tasks) {
+        schedule(state, std::move(task));
+      }
+      return;
+    }
+    std::vector<folly::Func> funcs;
+    funcs.reserve(tasks.size());
+    for (auto& task : tasks) {
+      funcs.push_back(makeRunner(state, std::move(task)));
+    }
+    unbounded->addBulk(std::move(funcs));
+  }
+
+  static void complete(
+      const std::shared_ptr<State>& state,
+      const std::shared_ptr<Task>& task) {
+    std::vector<std::shared_ptr<Task>> ready;
+    {
+      auto lockedQueue = state->queue.wlock();
+
+      std::vector<std::pair<PathComponentPiece, Node*>> chain;
+      auto* node = &lockedQueue->root;
+      for (auto component : task->path.components()) {
+        node = node->children.at(component).get();
+        chain.emplace_back(component, node);
+      }
+
+      XDCHECK(node->tasks.front() == task);
+      node->tasks.pop_front();
+      --lockedQueue->pending;
+
+      // Drop the nodes that no longer lead to any task.
+      while (!chain.empty() && chain.back().second->tasks.empty() &&
+             chain.back().second->children.empty()) {
+        auto name = chain.back().first;
+        chain.pop_back();
+        auto* parent = chain.empty() ? &lockedQueue->root : chain.back().second;
+        parent->children.erase(name);
+      }
+
+      for (auto& blocked : task->blocked) {
+        if (--blocked->blockers == 0) {
+          ready.push_back(std::move(blocked));
+        }
+      }
+    }
+
+    scheduleAll(state, std::move(ready));
+  }
+
+  folly::Executor::KeepAlive<> executor;
+  const CaseSensitivity caseSensitive;
+  folly::Synchronized<Queue> queue;
+};
+
+PathScheduler::PathScheduler(
+    folly::Executor::KeepAlive<> executor,
+    CaseSensitivity caseSensitive)
+    : state_{std::make_shared<State>(std::move(executor), caseSensitive)} {}
+
+PathScheduler::~PathScheduler() = default;
+
+folly::SemiFuture<folly::Unit> PathScheduler::add(
+    RelativePathPiece path,
+    folly::Func func) {
+  auto [promise, future] = folly::makePromiseContract<folly::Unit>();
+  auto task = std::make_shared<Task>(
+      path.copy(),
+      [func = std::move(func), promise = std::move(promise)]() mutable {
+        promise.setWith(std::move(func));
+      });
+
+  bool ready;
+  {
+    auto lockedQueue = state_->queue.wlock();
+
+    auto* node = &lockedQueue->root;
+    State::blockOnNode(*node, task);
+    for (auto component : path.components()) {
+      auto& child = node->children[component];
+      if (!child) {
+        child = std::make_unique<Node>(state_->caseSensitive);
+      }
+      node = child.get();
+      State::blockOnNode(*node, task);
+    }
+    State::blockOnSubtree(*node, task);
+
+    node->tasks.push_back(task);
+    ++lockedQueue->pending;
+    // Once the lock is released, the tasks it waits for may complete and
+    // schedule it, it must thus be checked here.
+    ready = task->blockers == 0;
+  }
+
+  if (ready) {
+    State::schedule(state_, std::move(task));
+  }
+  return std::move(future);
+}
+
+size_t PathScheduler::getPendingCount() const {
+  return state_->queue.rlock()->pending;
+}
+
+} // namespace facebook::eden
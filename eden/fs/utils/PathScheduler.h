@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Executor.h>
+#include <folly/futures/Future.h>
+#include <memory>
+
+#include "eden/fs/utils/CaseSensitivity.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/**
+ * Runs functions on an executor, one at a time for any given path and its
+ * ancestors and descendants, while functions on unrelated paths may run
+ * concurrently.
+ *
+ * A function added for a path only starts once every function that was
+ * previously added for the same path, one of its ancestors or one of its
+ * descendants has returned. The root path being the ancestor of every path,
+ * a function added for it waits for all the functions added before it and
+ * holds back all the functions added after it.
+ *
+ * Functions are allowed to block, and must only return once the work they
+ * are ordered for is complete.
+ */
+class PathScheduler {
+ public:
+  PathScheduler(
+      folly::Executor::KeepAlive<> executor,
+      CaseSensitivity caseSensitive);
+  ~PathScheduler();
+
+  PathScheduler(const PathScheduler&) = delete;
+  PathScheduler& operator=(const PathScheduler&) = delete;
+  PathScheduler(PathScheduler&&) = delete;
+  PathScheduler& operator=(PathScheduler&&) = delete;
+
+  /**
+   * Run func on the executor once the functions it is ordered after have
+   * returned. The returned future completes when func returns, with the
+   * exception it threw if any.
+   */
+  folly::SemiFuture<folly::Unit> add(RelativePathPiece path, folly::Func func);
+
+  /**
+   * Number of functions that were added and did not return yet, whether
+   * they are running or waiting on others.
+   */
+  size_t getPendingCount() const;
+
+ private:
+  struct Task;
+  struct Node;
+  struct State;
+
+  // The state is shared with the functions queued on the executor, which
+  // may outlive this object.
+  std::shared_ptr<State> state_;
+};
+
+} // namespace facebook::eden
@@ -11,6 +11,8 @@
 #include <folly/MapUtil.h>
 #include <folly/MicroLock.h>
 #include <folly/ThreadLocal.h>
+#include <folly/system/ThreadName.h>
+#include <algorithm>
 
 #include "eden/common/utils/ProcessNameCache.h"
 
@@ -134,14 +136,56 @@ ProcessAccessLog::ProcessAccessLog(
     std::shared_ptr<ProcessNameCache> processNameCache)
     : processNameCache_{std::move(processNameCache)} {
   XCHECK(processNameCache_) << "Process name cache is mandatory";
+  resolverThread_ = std::thread{[this] {
+    folly::setThreadName("ProcessNames");
+    runResolverThread();
+  }};
 }
 
 ProcessAccessLog::~ProcessAccessLog() {
+  newPids_.enqueue(kStopResolver);
+  resolverThread_.join();
   for (auto& tlb : threadLocalBucketPtr.accessAllThreads()) {
     tlb.clearOwnerIfMe(this);
   }
 }
 
+void ProcessAccessLog::addNewPid(pid_t pid) {
+  // Sometimes we receive requests from pid 0. Record the access,
+  // but don't try to look up a name.
+  if (pid != 0) {
+    newPids_.enqueue(pid);
+  }
+}
+
+void ProcessAccessLog::runResolverThread() {
+  std::vector<pid_t> batch;
+  batch.reserve(kMaxResolveBatch);
+  while (true) {
+    batch.push_back(newPids_.dequeue());
+    pid_t pid;
+    while (batch.size() < kMaxResolveBatch && newPids_.try_dequeue(pid)) {
+      batch.push_back(pid);
+    }
+    // Several threads commonly see the same new pid in the same second.
+    std::sort(batch.begin(), batch.end());
+    batch.erase(std::unique(batch.begin(), batch.end()), batch.end());
+
+    bool stop = false;
+    for (auto newPid : batch) {
+      if (newPid == kStopResolver) {
+        stop = true;
+      } else {
+        processNameCache_->add(newPid);
+      }
+    }
+    if (stop) {
+      return;
+    }
+    batch.clear();
+  }
+}
+
 ThreadLocalBucket* ProcessAccessLog::getTlb() {
   auto tlb = threadLocalBucketPtr.get();
   if (!tlb) {
@@ -166,21 +210,12 @@ void ProcessAccessLog::recordAccess(
   // calling thread dies or when the data must be read.
   bool isNewPid = getTlb()->add(getSecondsSinceEpoch(), pid, type);
 
-  // Many processes are short-lived, so grab the executable name during the
-  // access. We could potentially get away with grabbing executable names a
-  // bit later on another thread, but we'll only readlink() once per pid.
-
-  // Sometimes we receive requests from pid 0. Record the access,
-  // but don't try to look up a name.
-  if (pid != 0) {
-    // Since recordAccess is called a lot by latency- and throughput-sensitive
-    // code, only try to lookup and cache the process name if we haven't seen
-    // it this thread-second.
-    if (isNewPid) {
-      // It's a bit unfortunate that ProcessNameCache maintains its own
-      // SharedMutex, but it will be shared with thrift counters.
-      processNameCache_->add(pid);
-    }
+  // Many processes are short-lived, so the executable name must be grabbed
+  // soon after the access. To keep this cheap, only queue the pid the first
+  // time this thread sees it in a second, and let the resolver thread add it
+  // to the ProcessNameCache.
+  if (isNewPid) {
+    addNewPid(pid);
   }
 }
 
@@ -188,14 +223,20 @@ void ProcessAccessLog::recordDuration(
     pid_t pid,
     std::chrono::nanoseconds duration) {
   bool isNewPid = getTlb()->add(getSecondsSinceEpoch(), pid, duration);
-  if (pid != 0 && isNewPid) {
-    processNameCache_->add(pid);
+  if (isNewPid) {
+    addNewPid(pid);
   }
 }
 
 std::unordered_map<pid_t, AccessCounts> ProcessAccessLog::getAccessCounts(
     std::chrono::seconds lastNSeconds) {
   auto secondCount = lastNSeconds.count();
+  // Add the pids the resolver thread hasn't gotten to yet.
+  pid_t pid;
+  while (newPids_.try_dequeue(pid)) {
+    processNameCache_->add(pid);
+  }
+
   // First, merge all the thread-local buckets into their owners, including us.
   for (auto& tlb : threadLocalBucketPtr.accessAllThreads()) {
     // This must be done outside of acquiring our own state_ lock.
@@ -8,6 +8,8 @@
 #pragma once
 
 #include <folly/Synchronized.h>
+#include <folly/concurrency/UnboundedQueue.h>
+#include <thread>
 #include <type_traits>
 
 #include "eden/fs/service/gen-cpp2/eden_types.h"
@@ -49,7 +51,8 @@ class ProcessAccessLog {
    * calls on that thread will accumulate within this access log.
    *
    * Process IDs passed to recordAccess are also inserted into the
-   * ProcessNameCache.
+   * ProcessNameCache, in batches by a background thread, so that the callers
+   * don't contend on the ProcessNameCache's lock.
    */
   void recordAccess(pid_t pid, AccessType type);
   void recordDuration(pid_t pid, std::chrono::nanoseconds duration);
@@ -60,6 +63,10 @@ class ProcessAccessLog {
    *
    * Note: ProcessAccessLog buckets by whole seconds, so this number should be
    * considered an approximation.
+   *
+   * The pids still queued for the resolver thread are added to the
+   * ProcessNameCache before this returns, so that their names can be looked
+   * up, except for those the resolver thread is adding concurrently.
    */
   std::unordered_map<pid_t, AccessCounts> getAccessCounts(
       std::chrono::seconds lastNSeconds);
@@ -96,11 +103,25 @@ class ProcessAccessLog {
     Buckets buckets;
   };
 
+  // Recording an access from pid 0 doesn't add it to the ProcessNameCache,
+  // so it tells the resolver thread to stop.
+  static constexpr pid_t kStopResolver = 0;
+  static constexpr size_t kMaxResolveBatch = 256;
+
   const std::shared_ptr<ProcessNameCache> processNameCache_;
   folly::Synchronized<State> state_;
 
+  /**
+   * Pids seen for the first time in a thread-second, waiting for the resolver
+   * thread to add them to the ProcessNameCache.
+   */
+  folly::UMPMCQueue<pid_t, /*MayBlock=*/true> newPids_;
+  std::thread resolverThread_;
+
   uint64_t getSecondsSinceEpoch();
   ThreadLocalBucket* getTlb();
+  void addNewPid(pid_t pid);
+  void runResolverThread();
 
   friend struct ThreadLocalBucket;
 };
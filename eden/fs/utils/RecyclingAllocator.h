@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+
+namespace facebook::eden {
+
+namespace detail {
+
+/**
+ * Per-thread free lists of blocks of Size bytes.
+ *
+ * Freed blocks are kept on a list owned by the freeing thread, and handed out
+ * again by that thread's next allocations, without going through the
+ * allocator. Requests often complete on a different thread than the one they
+ * were received on: the blocks then flow from the threads completing
+ * requests to the threads receiving them through the allocator, and each
+ * thread keeps at most kMaxCachedBlocks blocks, which are freed when it exits.
+ */
+template <size_t Size>
+class RecycledBlocks {
+ public:
+  static constexpr size_t kMaxCachedBlocks = 1024;
+
+  static void* allocate() {
+    auto& list = localList();
+    if (auto* node = list.head) {
+      list.head = node->next;
+      --list.count;
+      return node;
+    }
+    return ::operator new(kBlockSize);
+  }
+
+  static void deallocate(void* block) noexcept {
+    auto& list = localList();
+    if (list.count >= kMaxCachedBlocks) {
+      ::operator delete(block);
+      return;
+    }
+    list.head = new (block) Node{list.head};
+    ++list.count;
+  }
+
+ private:
+  struct Node {
+    Node* next;
+  };
+
+  static constexpr size_t kBlockSize =
+      Size < sizeof(Node) ? sizeof(Node) : Size;
+
+  struct List {
+    ~List() {
+      while (head) {
+        auto* next = head->next;
+        ::operator delete(head);
+        head = next;
+      }
+      // Blocks freed by the destructors of other thread locals bypass the
+      // list from now on.
+      count = kMaxCachedBlocks;
+    }
+
+    Node* head{nullptr};
+    size_t count{0};
+  };
+
+  static List& localList() {
+    static thread_local List list;
+    return list;
+  }
+};
+
+} // namespace detail
+
+/**
+ * A standard allocator recycling single objects through per-thread free
+ * lists, for objects allocated and freed once per filesystem request, such as
+ * the request contexts, so that they don't go through the general purpose
+ * allocator at every request. Arrays are allocated normally.
+ *
+ * Use with std::allocate_shared to have the control block and the object
+ * recycled together.
+ */
+template <typename T>
+class RecyclingAllocator {
+ public:
+  using value_type = T;
+
+  static_assert(
+      alignof(T) <= alignof(std::max_align_t),
+      "over-aligned types are not supported");
+
+  RecyclingAllocator() noexcept = default;
+
+  template <typename U>
+  /* implicit */ RecyclingAllocator(const RecyclingAllocator<U>&) noexcept {}
+
+  T* allocate(size_t n) {
+    if (n == 1) {
+      return static_cast<T*>(detail::RecycledBlocks<sizeof(T)>::allocate());
+    }
+    return std::allocator<T>{}.allocate(n);
+  }
+
+  void deallocate(T* p, size_t n) noexcept {
+    if (n == 1) {
+      detail::RecycledBlocks<sizeof(T)>::deallocate(p);
+      return;
+    }
+    std::allocator<T>{}.deallocate(p, n);
+  }
+
+  template <typename U>
+  bool operator==(const RecyclingAllocator<U>&) const noexcept {
+    return true;
+  }
+
+  template <typename U>
+  bool operator!=(const RecyclingAllocator<U>&) const noexcept {
+    return false;
+  }
+};
+
+/**
+ * Base class recycling the allocations of Derived like RecyclingAllocator,
+ * for objects allocated with new, such as those of makeRefPtr or
+ * std::make_unique. Classes derived from Derived are allocated normally.
+ */
+template <typename Derived>
+class RecycledAllocation {
+ public:
+  static void* operator new(size_t size) {
+    if (size != sizeof(Derived)) {
+      return ::operator new(size);
+    }
+    return detail::RecycledBlocks<sizeof(Derived)>::allocate();
+  }
+
+  static void operator delete(void* p, size_t size) noexcept {
+    if (size != sizeof(Derived)) {
+      ::operator delete(p);
+      return;
+    }
+    detail::RecycledBlocks<sizeof(Derived)>::deallocate(p);
+  }
+};
+
+} // namespace facebook::eden
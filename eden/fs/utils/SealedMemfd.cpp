@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifdef __linux__
+
+#include "eden/fs/utils/SealedMemfd.h"
+
+#include <fcntl.h>
+#include <folly/Exception.h>
+#include <folly/FileUtil.h>
+#include <sys/mman.h>
+
+namespace facebook::eden {
+
+namespace {
+void unmapContents(void* buf, void* userData) {
+  ::munmap(buf, reinterpret_cast<size_t>(userData));
+}
+} // namespace
+
+SealedMemfd makeSealedMemfd(const char* name, const folly::IOBuf& contents) {
+  int fd = ::memfd_create(name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  folly::checkUnixError(fd, "memfd_create");
+  auto file = std::make_shared<folly::File>(fd, /*ownsFd=*/true);
+
+  auto size = contents.computeChainDataLength();
+  auto iov = contents.getIov();
+  auto written = folly::pwritevFull(
+      file->fd(), iov.data(), static_cast<int>(iov.size()), 0);
+  folly::checkUnixError(written, "unable to write memfd ", name);
+
+  // F_SEAL_WRITE is refused while a writable shared mapping exists, which is
+  // why the contents are written with pwritev rather than through a mapping.
+  folly::checkUnixError(
+      ::fcntl(
+          file->fd(),
+          F_ADD_SEALS,
+          F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL),
+      "unable to seal memfd ",
+      name);
+
+  if (size == 0) {
+    return SealedMemfd{std::move(file), folly::IOBuf{}};
+  }
+  void* addr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, file->fd(), 0);
+  if (addr == MAP_FAILED) {
+    folly::throwSystemError("unable to map memfd ", name);
+  }
+  return SealedMemfd{
+      std::move(file),
+      folly::IOBuf{
+          folly::IOBuf::TAKE_OWNERSHIP,
+          addr,
+          size,
+          unmapContents,
+          reinterpret_cast<void*>(size)}};
+}
+
+} // namespace facebook::eden
+
+#endif
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#ifdef __linux__
+
+#include <folly/File.h>
+#include <folly/io/IOBuf.h>
+#include <memory>
+
+namespace facebook::eden {
+
+/**
+ * A copy of some bytes in an anonymous memory file whose size and contents
+ * are sealed, so it can be handed to other processes, which can map it
+ * without having to trust edenfs to leave it alone, or fear that it changes
+ * under them.
+ */
+struct SealedMemfd {
+  std::shared_ptr<folly::File> file;
+
+  /**
+   * A read-only mapping of the file. It stays valid after the file is closed.
+   */
+  folly::IOBuf contents;
+};
+
+/**
+ * Copy contents into a new sealed memfd. The name only shows up in
+ * /proc/<pid>/fd and /proc/<pid>/maps. Throws on error.
+ */
+SealedMemfd makeSealedMemfd(const char* name, const folly::IOBuf& contents);
+
+} // namespace facebook::eden
+
+#endif
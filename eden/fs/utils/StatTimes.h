@@ -75,6 +75,19 @@ inline struct timespec stCtime(const struct stat& st) {
 #endif
 }
 
+/** Helper for setting the `ctime` field of a `struct stat` as a timespec.
+ * Linux and macOS have different names for this field. */
+inline void stCtime(struct stat& st, struct timespec ts) {
+#ifdef __APPLE__
+  st.st_ctimespec = ts;
+#elif defined(_BSD_SOURCE) || defined(_SVID_SOURCE) || \
+    _POSIX_C_SOURCE >= 200809L || _XOPEN_SOURCE >= 700
+  st.st_ctim = ts;
+#else
+  st.st_ctime = ts.tv_sec;
+#endif
+}
+
 /**
  * Access stat atime as a system_clock::time_point.
  */
@@ -11,6 +11,7 @@
 #include <folly/executors/ManualExecutor.h>
 #include <folly/executors/task_queue/UnboundedBlockingQueue.h>
 #include <folly/executors/thread_factory/NamedThreadFactory.h>
+#include "eden/fs/utils/WorkStealingExecutor.h"
 
 namespace facebook::eden {
 
@@ -27,4 +28,18 @@ UnboundedQueueExecutor::UnboundedQueueExecutor(
     std::shared_ptr<folly::ManualExecutor> executor)
     : executor_{std::move(executor)} {}
 
+UnboundedQueueExecutor::UnboundedQueueExecutor(
+    std::shared_ptr<WorkStealingExecutor> executor)
+    : executor_{executor}, workStealingExecutor_{executor.get()} {}
+
+void UnboundedQueueExecutor::addBulk(std::vector<folly::Func> funcs) {
+  if (workStealingExecutor_) {
+    workStealingExecutor_->addBulk(std::move(funcs));
+    return;
+  }
+  for (auto& func : funcs) {
+    executor_->add(std::move(func));
+  }
+}
+
 } // namespace facebook::eden
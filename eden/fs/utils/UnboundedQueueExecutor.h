@@ -9,6 +9,7 @@
 
 #include <folly/Executor.h>
 #include <folly/Range.h>
+#include <vector>
 
 namespace folly {
 class ManualExecutor;
@@ -16,6 +17,8 @@ class ManualExecutor;
 
 namespace facebook::eden {
 
+class WorkStealingExecutor;
+
 /**
  * An Executor that is guaranteed to never block, nor throw (except OOM), nor
  * execute inline from `add()`.
@@ -41,6 +44,12 @@ class UnboundedQueueExecutor : public folly::Executor {
   explicit UnboundedQueueExecutor(
       std::shared_ptr<folly::ManualExecutor> executor);
 
+  /**
+   * WorkStealingExecutors are unbounded, and additionally support priorities.
+   */
+  explicit UnboundedQueueExecutor(
+      std::shared_ptr<WorkStealingExecutor> executor);
+
   UnboundedQueueExecutor(const UnboundedQueueExecutor&) = delete;
   UnboundedQueueExecutor& operator=(const UnboundedQueueExecutor&) = delete;
   UnboundedQueueExecutor(UnboundedQueueExecutor&&) = delete;
@@ -50,8 +59,33 @@ class UnboundedQueueExecutor : public folly::Executor {
     executor_->add(std::move(func));
   }
 
+  /**
+   * Executors without priorities, like ManualExecutor, may throw from
+   * addWithPriority(), so the priority is ignored for them.
+   */
+  void addWithPriority(folly::Func func, int8_t priority) override {
+    if (executor_->getNumPriorities() > 1) {
+      executor_->addWithPriority(std::move(func), priority);
+    } else {
+      executor_->add(std::move(func));
+    }
+  }
+
+  uint8_t getNumPriorities() const override {
+    return executor_->getNumPriorities();
+  }
+
+  /**
+   * Adds a burst of tasks at once. A WorkStealingExecutor queues them with
+   * one lock acquisition and wakes as many workers as needed at once; other
+   * executors get them one at a time.
+   */
+  void addBulk(std::vector<folly::Func> funcs);
+
  private:
   std::shared_ptr<folly::Executor> executor_;
+  // Set when executor_ is a WorkStealingExecutor.
+  WorkStealingExecutor* workStealingExecutor_{nullptr};
 };
 
 } // namespace facebook::eden
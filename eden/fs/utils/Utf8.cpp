@@ -8,9 +8,63 @@
 #include "eden/fs/utils/Utf8.h"
 
 #include <folly/Unicode.h>
+#include <folly/lang/Bits.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define EDEN_UTF8_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define EDEN_UTF8_NEON 1
+#endif
 
 namespace facebook::eden {
 
+namespace {
+
+/**
+ * Return the number of ASCII characters at the start of [begin, end).
+ */
+size_t asciiPrefixLength(const char* begin, const char* end) {
+  const char* p = begin;
+#if EDEN_UTF8_SSE2
+  for (; end - p >= 16; p += 16) {
+    auto chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    // The mask has the high bit of each byte.
+    if (auto nonAscii = _mm_movemask_epi8(chars)) {
+      return p - begin + folly::findFirstSet(nonAscii) - 1;
+    }
+  }
+#elif EDEN_UTF8_NEON
+  for (; end - p >= 16; p += 16) {
+    auto chars = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+    if (vmaxvq_u8(chars) >= 0x80) {
+      break;
+    }
+  }
+#endif
+  while (p != end && !detail::isBitSet(*p, 7)) {
+    ++p;
+  }
+  return p - begin;
+}
+
+} // namespace
+
+bool detail::isValidUtf8Vectorized(folly::StringPiece str) {
+  const char* begin = str.begin();
+  const char* const end = str.end();
+  while (true) {
+    begin += asciiPrefixLength(begin, end);
+    if (begin == end) {
+      return true;
+    }
+    if (!consumeUtf8CodePoint(begin, end)) {
+      return false;
+    }
+  }
+}
+
 std::string ensureValidUtf8(folly::ByteRange str) {
   std::string output;
   output.reserve(str.size());
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <folly/Range.h>
+#include <folly/Traits.h>
 #include <folly/Utility.h>
 
 namespace facebook::eden {
@@ -43,7 +44,7 @@ constexpr bool isValidContinuation(
     const char* const end,
     size_t num,
     uint32_t& codepoint) {
-  if (begin + num - 1 > end) {
+  if (static_cast<size_t>(end - begin) < num) {
     return false;
   }
 
@@ -59,6 +60,66 @@ constexpr bool isValidContinuation(
 }
 } // namespace detail
 
+namespace detail {
+/**
+ * Consume the code point starting at begin, and return whether it is
+ * correctly encoded.
+ */
+constexpr bool consumeUtf8CodePoint(const char*& begin, const char* const end) {
+  char first = *begin++;
+  if (!isBitSet(first, 7)) {
+    // ASCII character, nothing to do.
+  } else if (!isBitSet(first, 6)) {
+    // 10xxxxxx isn't a valid for the first byte.
+    return false;
+  } else if (!isBitSet(first, 5)) {
+    // 110xxxxx: 2 bytes
+    uint32_t codepoint = folly::to_unsigned(first) & 0x1F;
+    if (!isValidContinuation(begin, end, 1, codepoint)) {
+      return false;
+    }
+
+    // Is this an overlong encoding?
+    if (codepoint < 0x80) {
+      return false;
+    }
+  } else if (!isBitSet(first, 4)) {
+    // 1110xxxx: 3 bytes
+    uint32_t codepoint = folly::to_unsigned(first) & 0xF;
+    if (!isValidContinuation(begin, end, 2, codepoint)) {
+      return false;
+    }
+
+    // Is this an overlong encoding?
+    if (codepoint < 0x800) {
+      return false;
+    }
+  } else if (!isBitSet(first, 3)) {
+    // 11110xxx: 4 bytes
+    uint32_t codepoint = folly::to_unsigned(first) & 0x7;
+    if (!isValidContinuation(begin, end, 3, codepoint)) {
+      return false;
+    }
+
+    // Is this an overlong encoding?
+    if (codepoint < 0x10000) {
+      return false;
+    }
+  } else {
+    // 11111xxx isn't ever valid.
+    return false;
+  }
+  return true;
+}
+
+/**
+ * The runtime implementation of isValidUtf8(). Runs of ASCII, which most
+ * paths entirely are, are checked 16 bytes at a time with SIMD instructions,
+ * and only the other code points are decoded.
+ */
+bool isValidUtf8Vectorized(folly::StringPiece str);
+} // namespace detail
+
 /**
  * Returns whether the given string is correctly-encoded UTF-8.
  *
@@ -66,55 +127,17 @@ constexpr bool isValidContinuation(
  * characters.
  */
 constexpr bool isValidUtf8(folly::StringPiece str) {
+  if (!folly::is_constant_evaluated_or(true)) {
+    return detail::isValidUtf8Vectorized(str);
+  }
+
   const char* begin = str.begin();
   const char* const end = str.end();
-
   while (begin != end) {
-    char first = *begin++;
-    if (!detail::isBitSet(first, 7)) {
-      // ASCII character, nothing to do.
-    } else if (!detail::isBitSet(first, 6)) {
-      // 10xxxxxx isn't a valid for the first byte.
-      return false;
-    } else if (!detail::isBitSet(first, 5)) {
-      // 110xxxxx: 2 bytes
-      uint32_t codepoint = folly::to_unsigned(first) & 0x1F;
-      if (!detail::isValidContinuation(begin, end, 1, codepoint)) {
-        return false;
-      }
-
-      // Is this an overlong encoding?
-      if (codepoint < 0x80) {
-        return false;
-      }
-    } else if (!detail::isBitSet(first, 4)) {
-      // 1110xxxx: 3 bytes
-      uint32_t codepoint = folly::to_unsigned(first) & 0xF;
-      if (!detail::isValidContinuation(begin, end, 2, codepoint)) {
-        return false;
-      }
-
-      // Is this an overlong encoding?
-      if (codepoint < 0x800) {
-        return false;
-      }
-    } else if (!detail::isBitSet(first, 3)) {
-      // 11110xxx: 4 bytes
-      uint32_t codepoint = folly::to_unsigned(first) & 0x7;
-      if (!detail::isValidContinuation(begin, end, 3, codepoint)) {
-        return false;
-      }
-
-      // Is this an overlong encoding?
-      if (codepoint < 0x10000) {
-        return false;
-      }
-    } else {
-      // 11111xxx isn't ever valid.
+    if (!detail::consumeUtf8CodePoint(begin, end)) {
       return false;
     }
   }
-
   return true;
 }
 
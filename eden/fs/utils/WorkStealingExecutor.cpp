@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/WorkStealingExecutor.h"
+
+#include <folly/Conv.h>
+#include <folly/ExceptionString.h>
+#include <folly/logging/xlog.h>
+#include <folly/system/ThreadName.h>
+#include <algorithm>
+#include <array>
+
+namespace facebook::eden {
+
+namespace {
+struct CurrentWorker {
+  const WorkStealingExecutor* executor{nullptr};
+  size_t index{0};
+};
+
+thread_local CurrentWorker currentWorker;
+} // namespace
+
+WorkStealingExecutor::WorkStealingExecutor(
+    size_t threadCount,
+    folly::StringPiece threadNamePrefix) {
+  threadCount = std::max<size_t>(threadCount, 1);
+  workers_.reserve(threadCount);
+  for (size_t i = 0; i < threadCount; ++i) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  // Only start the threads once all the deques exist, since they steal from
+  // each other.
+  for (size_t i = 0; i < threadCount; ++i) {
+    workers_[i]->thread =
+        std::thread([this, i, name = folly::to<std::string>(
+                                  threadNamePrefix, i)] {
+          folly::setThreadName(name);
+          currentWorker = CurrentWorker{this, i};
+          workerLoop(i);
+        });
+  }
+}
+
+WorkStealingExecutor::~WorkStealingExecutor() {
+  stopping_.store(true, std::memory_order_seq_cst);
+  {
+    std::lock_guard lock{sleepMutex_};
+    wakeUp_.notify_all();
+  }
+  for (auto& worker : workers_) {
+    worker->thread.join();
+  }
+}
+
+void WorkStealingExecutor::add(folly::Func func) {
+  if (currentWorker.executor == this) {
+    enqueue(workers_[currentWorker.index]->tasks, std::move(func));
+  } else {
+    enqueue(injection_, std::move(func));
+  }
+}
+
+void WorkStealingExecutor::addWithPriority(folly::Func func, int8_t priority) {
+  if (priority > folly::Executor::MID_PRI) {
+    enqueue(highPriority_, std::move(func));
+  } else if (priority < folly::Executor::MID_PRI) {
+    enqueue(lowPriority_, std::move(func));
+  } else {
+    add(std::move(func));
+  }
+}
+
+void WorkStealingExecutor::addBulk(std::vector<folly::Func> funcs) {
+  if (funcs.empty()) {
+    return;
+  }
+  auto& queue = currentWorker.executor == this
+      ? workers_[currentWorker.index]->tasks
+      : injection_;
+  {
+    auto tasks = queue.lock();
+    for (auto& func : funcs) {
+      tasks->push_back(std::move(func));
+    }
+  }
+  pending_.fetch_add(
+      static_cast<int64_t>(funcs.size()), std::memory_order_seq_cst);
+  wake(funcs.size());
+}
+
+void WorkStealingExecutor::enqueue(Queue& queue, folly::Func func) {
+  queue.lock()->push_back(std::move(func));
+  pending_.fetch_add(1, std::memory_order_seq_cst);
+  wake(1);
+}
+
+void WorkStealingExecutor::wake(size_t count) {
+  if (sleepers_.load(std::memory_order_seq_cst) == 0) {
+    return;
+  }
+  // Taking the lock guarantees that a worker that just decided to sleep is
+  // already waiting and gets the notification.
+  std::lock_guard lock{sleepMutex_};
+  count = std::min(count, sleepers_.load(std::memory_order_seq_cst));
+  for (size_t i = 0; i < count; ++i) {
+    wakeUp_.notify_one();
+  }
+}
+
+folly::Func WorkStealingExecutor::popFront(Queue& queue) {
+  auto tasks = queue.lock();
+  if (tasks->empty()) {
+    return {};
+  }
+  auto func = std::move(tasks->front());
+  tasks->pop_front();
+  pending_.fetch_sub(1, std::memory_order_relaxed);
+  return func;
+}
+
+folly::Func WorkStealingExecutor::popBack(Queue& queue) {
+  auto tasks = queue.lock();
+  if (tasks->empty()) {
+    return {};
+  }
+  auto func = std::move(tasks->back());
+  tasks->pop_back();
+  pending_.fetch_sub(1, std::memory_order_relaxed);
+  return func;
+}
+
+folly::Func WorkStealingExecutor::takeBatch(Queue& queue, size_t index) {
+  std::array<folly::Func, kMaxBatchSize> batch;
+  size_t count;
+  {
+    auto tasks = queue.lock();
+    if (tasks->empty()) {
+      return {};
+    }
+    count = std::min(kMaxBatchSize, (tasks->size() + 1) / 2);
+    for (size_t i = 0; i < count; ++i) {
+      batch[i] = std::move(tasks->front());
+      tasks->pop_front();
+    }
+  }
+  // The other tasks of the batch stay pending in this worker's deque.
+  pending_.fetch_sub(1, std::memory_order_relaxed);
+
+  if (count > 1) {
+    auto tasks = workers_[index]->tasks.lock();
+    // popBack() takes the last task first, so push the newest first.
+    for (size_t i = count - 1; i > 0; --i) {
+      tasks->push_back(std::move(batch[i]));
+    }
+  }
+  return std::move(batch[0]);
+}
+
+folly::Func WorkStealingExecutor::takeTask(size_t index, size_t& runCount) {
+  if (auto func = popFront(highPriority_)) {
+    return func;
+  }
+  if (++runCount % kInjectionInterval == 0) {
+    if (auto func = takeBatch(injection_, index)) {
+      return func;
+    }
+  }
+  if (auto func = popBack(workers_[index]->tasks)) {
+    return func;
+  }
+  if (auto func = takeBatch(injection_, index)) {
+    return func;
+  }
+  for (size_t i = 1; i < workers_.size(); ++i) {
+    auto& victim = workers_[(index + i) % workers_.size()]->tasks;
+    if (auto func = takeBatch(victim, index)) {
+      return func;
+    }
+  }
+  return popFront(lowPriority_);
+}
+
+void WorkStealingExecutor::workerLoop(size_t index) {
+  size_t runCount = 0;
+  for (;;) {
+    if (auto func = takeTask(index, runCount)) {
+      try {
+        func();
+      } catch (const std::exception& ex) {
+        XLOG(ERR) << "WorkStealingExecutor task threw unhandled exception: "
+                  << folly::exceptionStr(ex);
+      }
+      continue;
+    }
+
+    std::unique_lock lock{sleepMutex_};
+    sleepers_.fetch_add(1, std::memory_order_seq_cst);
+    wakeUp_.wait(lock, [&] {
+      return pending_.load(std::memory_order_seq_cst) > 0 ||
+          stopping_.load(std::memory_order_seq_cst);
+    });
+    sleepers_.fetch_sub(1, std::memory_order_seq_cst);
+    if (pending_.load(std::memory_order_seq_cst) <= 0 &&
+        stopping_.load(std::memory_order_seq_cst)) {
+      return;
+    }
+  }
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Executor.h>
+#include <folly/Range.h>
+#include <folly/Synchronized.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace facebook::eden {
+
+/**
+ * A thread pool where every worker has its own deque of tasks.
+ *
+ * - Tasks added from one of the workers, typically the continuations of the
+ *   task it is running, go to the back of its own deque and are run LIFO by
+ *   that worker, which keeps their data hot in its caches.
+ * - Tasks added from any other thread go to a shared FIFO injection queue.
+ * - Idle workers steal the oldest tasks from the front of the deques of the
+ *   others.
+ *
+ * Workers take tasks from the injection queue and from the deques of others
+ * in batches of up to half of the queue: the first one is run and the others
+ * are moved to the worker's own deque, so that a burst of tasks is spread
+ * over the workers with one lock acquisition per batch rather than per task.
+ *
+ * A busy worker still takes a task from the injection queue regularly, so
+ * that work submitted from outside the pool, like thrift requests, doesn't
+ * wait behind the thousands of tasks a checkout keeps adding to the local
+ * deques.
+ *
+ * addWithPriority() additionally supports a high and a low priority lane,
+ * both shared by all the workers: high priority tasks are taken before any
+ * other, low priority ones only when there's nothing else to do.
+ *
+ * Like UnboundedQueueExecutor, add() never blocks, never throws (except OOM)
+ * and never executes the task inline. Pending tasks are run before the
+ * destructor returns.
+ */
+class WorkStealingExecutor : public folly::Executor {
+ public:
+  WorkStealingExecutor(size_t threadCount, folly::StringPiece threadNamePrefix);
+  ~WorkStealingExecutor() override;
+
+  WorkStealingExecutor(const WorkStealingExecutor&) = delete;
+  WorkStealingExecutor& operator=(const WorkStealingExecutor&) = delete;
+  WorkStealingExecutor(WorkStealingExecutor&&) = delete;
+  WorkStealingExecutor& operator=(WorkStealingExecutor&&) = delete;
+
+  void add(folly::Func func) override;
+
+  /**
+   * Priorities above MID_PRI go to the high priority lane, and below to the
+   * low priority one.
+   */
+  void addWithPriority(folly::Func func, int8_t priority) override;
+
+  /**
+   * Adds all the tasks like add(), with one lock acquisition, and wakes at
+   * most as many sleeping workers as there are tasks.
+   */
+  void addBulk(std::vector<folly::Func> funcs);
+
+  uint8_t getNumPriorities() const override {
+    return 3;
+  }
+
+  size_t getThreadCount() const {
+    return workers_.size();
+  }
+
+ private:
+  /**
+   * How often a worker with local tasks takes one from the injection queue
+   * instead.
+   */
+  static constexpr size_t kInjectionInterval = 61;
+
+  /**
+   * The maximum number of tasks a worker takes from another queue at once.
+   */
+  static constexpr size_t kMaxBatchSize = 32;
+
+  using Queue = folly::Synchronized<std::deque<folly::Func>, std::mutex>;
+
+  struct Worker {
+    Queue tasks;
+    std::thread thread;
+  };
+
+  void enqueue(Queue& queue, folly::Func func);
+
+  /**
+   * Wakes up to count sleeping workers.
+   */
+  void wake(size_t count);
+
+  folly::Func popFront(Queue& queue);
+  folly::Func popBack(Queue& queue);
+
+  /**
+   * Takes the first half of the tasks of queue, up to kMaxBatchSize, moves
+   * all but the first one to the back of the given worker's deque, in an
+   * order that runs the oldest ones first, and returns the first one.
+   */
+  folly::Func takeBatch(Queue& queue, size_t index);
+
+  /**
+   * Returns the next task the given worker should run, or an empty function
+   * if there is none.
+   */
+  folly::Func takeTask(size_t index, size_t& runCount);
+
+  void workerLoop(size_t index);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  Queue highPriority_;
+  Queue injection_;
+  Queue lowPriority_;
+
+  // The number of tasks queued and not taken yet. Workers sleep while it is
+  // zero.
+  std::atomic<int64_t> pending_{0};
+  std::atomic<size_t> sleepers_{0};
+  std::atomic<bool> stopping_{false};
+  std::mutex sleepMutex_;
+  std::condition_variable wakeUp_;
+};
+
+} // namespace facebook::eden
@@ -27,6 +27,7 @@ constexpr int kENOATTR =
     ;
 
 constexpr folly::StringPiece kXattrSha1{"user.sha1"};
+constexpr folly::StringPiece kXattrSize{"user.size"};
 
 std::string fgetxattr(int fd, folly::StringPiece name);
 void fsetxattr(int fd, folly::StringPiece name, folly::StringPiece value);
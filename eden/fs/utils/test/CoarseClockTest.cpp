@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/CoarseClock.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+// Far longer than a timer tick, which is at most 10ms.
+constexpr auto kTolerance = 100ms;
+} // namespace
+
+TEST(CoarseClock, steadyTimeLagsThePreciseTimeByLessThanATick) {
+  auto before = std::chrono::steady_clock::now();
+  auto coarse = coarseSteadyNow();
+  auto after = std::chrono::steady_clock::now();
+  EXPECT_LE(coarse, after);
+  EXPECT_GT(coarse, before - kTolerance);
+}
+
+TEST(CoarseClock, systemTimeLagsThePreciseTimeByLessThanATick) {
+  auto before = std::chrono::system_clock::now();
+  auto coarse = coarseSystemNow();
+  auto after = std::chrono::system_clock::now();
+  EXPECT_LE(coarse, after);
+  EXPECT_GT(coarse, before - kTolerance);
+}
+
+TEST(CoarseClock, steadyTimeNeverGoesBackwards) {
+  auto previous = coarseSteadyNow();
+  for (int i = 0; i < 10000; ++i) {
+    auto now = coarseSteadyNow();
+    EXPECT_GE(now, previous);
+    previous = now;
+  }
+}
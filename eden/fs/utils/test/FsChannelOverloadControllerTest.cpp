@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/FsChannelOverloadController.h"
+
+#include <folly/portability/GTest.h>
+#include <memory>
+#include <optional>
+#include <system_error>
+#include <vector>
+
+using namespace facebook::eden;
+
+namespace {
+using Controller = FsChannelOverloadController;
+using Kind = FsChannelOverloadController::RequestKind;
+
+Controller::Config makeConfig(uint32_t maxInFlight, uint32_t maxQueuedBulk) {
+  Controller::Config config;
+  config.maxInFlight = maxInFlight;
+  config.maxQueuedBulk = maxQueuedBulk;
+  return config;
+}
+
+std::optional<Controller::Slot> admitNow(
+    Controller& controller,
+    pid_t pid,
+    Kind kind) {
+  auto admission = controller.admit(pid, kind);
+  EXPECT_TRUE(admission.isReady());
+  return std::move(admission).get();
+}
+} // namespace
+
+TEST(FsChannelOverloadController, disabledAdmitsEverything) {
+  auto controller = std::make_shared<Controller>(Controller::Config{});
+  std::vector<Controller::Slot> slots;
+  for (int i = 0; i < 100; ++i) {
+    auto admission = controller->admit(1, Kind::Bulk);
+    ASSERT_TRUE(admission.isReady());
+    slots.push_back(std::move(admission).get());
+  }
+  auto stats = controller->getStats();
+  EXPECT_EQ(0, stats.inFlight);
+  EXPECT_EQ(0, stats.deferred);
+}
+
+TEST(FsChannelOverloadController, metadataGoesBeforeBulk) {
+  auto controller = std::make_shared<Controller>(makeConfig(1, 0));
+  auto running = admitNow(*controller, 1, Kind::Bulk);
+
+  auto bulk = controller->admit(2, Kind::Bulk).semi();
+  auto metadata = controller->admit(3, Kind::Metadata).semi();
+  EXPECT_FALSE(bulk.isReady());
+  EXPECT_FALSE(metadata.isReady());
+  EXPECT_EQ(2, controller->getStats().deferred);
+
+  running.reset();
+  ASSERT_TRUE(metadata.isReady());
+  EXPECT_FALSE(bulk.isReady());
+
+  std::move(metadata).get();
+  ASSERT_TRUE(bulk.isReady());
+  auto slot = std::move(bulk).get();
+  EXPECT_EQ(1, controller->getStats().inFlight);
+}
+
+TEST(FsChannelOverloadController, processWithFewestInFlightGoesFirst) {
+  auto controller = std::make_shared<Controller>(makeConfig(2, 0));
+  auto first = admitNow(*controller, 1, Kind::Bulk);
+  auto second = admitNow(*controller, 1, Kind::Bulk);
+
+  auto heavy = controller->admit(1, Kind::Bulk).semi();
+  auto light = controller->admit(2, Kind::Bulk).semi();
+
+  first.reset();
+  EXPECT_TRUE(light.isReady());
+  EXPECT_FALSE(heavy.isReady());
+
+  second.reset();
+  EXPECT_TRUE(heavy.isReady());
+}
+
+TEST(FsChannelOverloadController, limitsBulkInFlightPerProcess) {
+  auto config = makeConfig(4, 0);
+  config.maxBulkInFlightPerPid = 1;
+  auto controller = std::make_shared<Controller>(config);
+  auto first = admitNow(*controller, 1, Kind::Bulk);
+
+  // Process 1 is at its limit, but not the other processes, and metadata
+  // requests aren't limited.
+  auto second = controller->admit(1, Kind::Bulk).semi();
+  EXPECT_FALSE(second.isReady());
+  auto other = admitNow(*controller, 2, Kind::Bulk);
+  auto metadata = admitNow(*controller, 1, Kind::Metadata);
+  EXPECT_EQ(3, controller->getStats().inFlight);
+
+  first.reset();
+  ASSERT_TRUE(second.isReady());
+  auto slot = std::move(second).get();
+  EXPECT_EQ(3, controller->getStats().inFlight);
+}
+
+TEST(FsChannelOverloadController, shedsNewestBulkOfHeaviestProcess) {
+  auto controller = std::make_shared<Controller>(makeConfig(1, 2));
+  auto running = admitNow(*controller, 1, Kind::Bulk);
+
+  auto older = controller->admit(1, Kind::Bulk).semi();
+  auto newer = controller->admit(1, Kind::Bulk).semi();
+
+  // The queue is full: the newest request of process 1 makes room.
+  auto other = controller->admit(2, Kind::Bulk).semi();
+  ASSERT_TRUE(newer.isReady());
+  EXPECT_THROW(std::move(newer).get(), std::system_error);
+  EXPECT_FALSE(older.isReady());
+  EXPECT_FALSE(other.isReady());
+
+  // Process 1 ties with process 2, and the incoming request is shed.
+  auto shed = controller->admit(1, Kind::Bulk);
+  ASSERT_TRUE(shed.isReady());
+  EXPECT_THROW(std::move(shed).get(), std::system_error);
+
+  // Metadata requests are never shed.
+  auto metadata = controller->admit(1, Kind::Metadata).semi();
+  EXPECT_FALSE(metadata.isReady());
+
+  auto stats = controller->getStats();
+  EXPECT_EQ(2, stats.shed);
+  EXPECT_EQ(4, stats.deferred);
+  EXPECT_EQ(1, stats.queuedMetadata);
+  EXPECT_EQ(2, stats.queuedBulk);
+}
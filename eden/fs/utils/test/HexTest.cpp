@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/Hex.h"
+
+#include <folly/portability/GTest.h>
+#include <string>
+#include <vector>
+
+using namespace facebook::eden;
+
+namespace {
+std::string encode(const std::vector<uint8_t>& bytes) {
+  std::string result(bytes.size() * 2, '\0');
+  encodeHex(folly::ByteRange{bytes.data(), bytes.size()}, result.data());
+  return result;
+}
+
+std::vector<uint8_t> allBytes(size_t size) {
+  std::vector<uint8_t> bytes(size);
+  for (size_t i = 0; i < size; ++i) {
+    bytes[i] = static_cast<uint8_t>(i * 7 + 3);
+  }
+  return bytes;
+}
+
+std::string scalarEncode(const std::vector<uint8_t>& bytes) {
+  static constexpr char digits[] = "0123456789abcdef";
+  std::string result;
+  for (auto byte : bytes) {
+    result.push_back(digits[byte >> 4]);
+    result.push_back(digits[byte & 0xf]);
+  }
+  return result;
+}
+} // namespace
+
+TEST(Hex, encode) {
+  EXPECT_EQ("", encode({}));
+  EXPECT_EQ("00ff10a9", encode({0x00, 0xff, 0x10, 0xa9}));
+}
+
+TEST(Hex, encodeMatchesScalarForAllSizes) {
+  // Cover the vectorized blocks and the scalar tail.
+  for (size_t size = 0; size <= 70; ++size) {
+    auto bytes = allBytes(size);
+    EXPECT_EQ(scalarEncode(bytes), encode(bytes)) << "size " << size;
+  }
+}
+
+TEST(Hex, encodesEveryByteValue) {
+  std::vector<uint8_t> bytes(256);
+  for (size_t i = 0; i < bytes.size(); ++i) {
+    bytes[i] = static_cast<uint8_t>(i);
+  }
+  EXPECT_EQ(scalarEncode(bytes), encode(bytes));
+}
+
+TEST(Hex, decodeRoundTripsForAllSizes) {
+  for (size_t size = 0; size <= 70; ++size) {
+    auto bytes = allBytes(size);
+    auto hex = encode(bytes);
+    std::vector<uint8_t> decoded(size);
+    ASSERT_TRUE(decodeHex(hex, decoded.data())) << "size " << size;
+    EXPECT_EQ(bytes, decoded) << "size " << size;
+  }
+}
+
+TEST(Hex, decodeAcceptsUppercase) {
+  std::string hex = "0123456789ABCDEFabcdef0123456789ABCDEFab";
+  std::vector<uint8_t> decoded(hex.size() / 2);
+  ASSERT_TRUE(decodeHex(hex, decoded.data()));
+  EXPECT_EQ(0x01, decoded[0]);
+  EXPECT_EQ(0xef, decoded[7]);
+  EXPECT_EQ(0xab, decoded[8]);
+  EXPECT_EQ(0xab, decoded[19]);
+}
+
+TEST(Hex, decodeRejectsInvalidCharactersAtEveryPosition) {
+  auto hex = encode(allBytes(24));
+  std::vector<uint8_t> decoded(24);
+  for (size_t i = 0; i < hex.size(); ++i) {
+    for (char c : {'g', 'G', '/', ':', '@', '`', ' ', '\0', '\xff'}) {
+      auto bad = hex;
+      bad[i] = c;
+      EXPECT_FALSE(decodeHex(bad, decoded.data()))
+          << "position " << i << " char " << int(c);
+    }
+  }
+}
+
+TEST(Hex, decodeRejectsOddSizes) {
+  uint8_t decoded[2];
+  EXPECT_FALSE(decodeHex("abc", decoded));
+}
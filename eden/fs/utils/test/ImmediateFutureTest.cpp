@@ -7,8 +7,13 @@
 
 #include "eden/fs/utils/ImmediateFuture.h"
 
+#include <folly/executors/ManualExecutor.h>
 #include <folly/portability/GTest.h>
 #include <folly/test/TestUtils.h>
+#if FOLLY_HAS_COROUTINES
+#include <folly/experimental/coro/BlockingWait.h>
+#include <folly/experimental/coro/Task.h>
+#endif
 
 namespace facebook::eden {
 
@@ -611,4 +616,43 @@ TEST(ImmediateFuture, constructionFromCompatible) {
       });
 }
 
+#if FOLLY_HAS_COROUTINES
+TEST(ImmediateFuture, co_await_ready) {
+  auto task = []() -> folly::coro::Task<int> {
+    auto value = co_await ImmediateFuture<int>{41};
+    co_return value + 1;
+  };
+  EXPECT_EQ(42, folly::coro::blockingWait(task()));
+}
+
+TEST(ImmediateFuture, co_await_not_ready) {
+  auto [promise, semiFut] = folly::makePromiseContract<int>();
+  auto task = [](ImmediateFuture<int> fut) -> folly::coro::Task<int> {
+    auto value = co_await std::move(fut);
+    co_return value + 1;
+  };
+  ImmediateFuture<int> fut{std::move(semiFut)};
+  EXPECT_FALSE(fut.isReady());
+
+  folly::ManualExecutor executor;
+  auto result = task(std::move(fut)).scheduleOn(&executor).start();
+  executor.drain();
+  EXPECT_FALSE(result.isReady());
+
+  promise.setValue(41);
+  executor.drain();
+  ASSERT_TRUE(result.isReady());
+  EXPECT_EQ(42, std::move(result).get());
+}
+
+TEST(ImmediateFuture, co_await_exception) {
+  auto task = []() -> folly::coro::Task<int> {
+    co_return co_await makeImmediateFuture<int>(
+        std::logic_error("Test exception"));
+  };
+  EXPECT_THROW_RE(
+      folly::coro::blockingWait(task()), std::logic_error, "Test exception");
+}
+#endif
+
 } // namespace facebook::eden
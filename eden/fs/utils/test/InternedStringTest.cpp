@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/InternedString.h"
+
+#include <folly/portability/GTest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "eden/fs/utils/PathFuncs.h"
+
+using namespace facebook::eden;
+using namespace std::literals;
+
+TEST(InternedString, equal_strings_share_their_storage) {
+  auto before = InternedString::getInternedCount();
+  {
+    std::string buckStr{"BUCK"};
+    InternedString a{"BUCK"sv};
+    InternedString b{buckStr};
+    InternedString c{"TARGETS"sv};
+    EXPECT_EQ(a.data(), b.data());
+    EXPECT_EQ(a, b);
+    EXPECT_NE(a, c);
+    EXPECT_EQ("BUCK"sv, std::string_view{a});
+    EXPECT_EQ(before + 2, InternedString::getInternedCount());
+
+    auto copy = a;
+    EXPECT_EQ(a.data(), copy.data());
+  }
+  EXPECT_EQ(before, InternedString::getInternedCount());
+}
+
+TEST(InternedString, empty) {
+  InternedString empty;
+  EXPECT_TRUE(empty.empty());
+  EXPECT_EQ(0, empty.size());
+  EXPECT_EQ(empty, InternedString{""sv});
+  EXPECT_NE(empty, InternedString{"a"sv});
+}
+
+TEST(InternedString, concurrent_interning) {
+  auto before = InternedString::getInternedCount();
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([] {
+      for (int i = 0; i < 10000; ++i) {
+        InternedString a{"__init__.py"sv};
+        InternedString b{std::to_string(i % 100)};
+        InternedString c{a};
+        EXPECT_EQ(a, c);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(before, InternedString::getInternedCount());
+}
+
+TEST(InternedString, path_components) {
+  InternedPathComponent a{"BUCK"_pc};
+  InternedPathComponent b{PathComponent{"BUCK"}};
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(a.value().data(), b.value().data());
+  EXPECT_EQ("BUCK"_pc, a);
+  EXPECT_NE("TARGETS"_pc, a);
+  EXPECT_EQ(hash_value(PathComponent{"BUCK"}), hash_value(a));
+  EXPECT_EQ("a/BUCK", (RelativePathPiece{"a"} + a).value());
+  EXPECT_EQ(PathComponent{"BUCK"}, a.copy());
+
+  EXPECT_THROW(
+      InternedPathComponent{folly::StringPiece{"a/b"}},
+      PathComponentContainsDirectorySeparator);
+  EXPECT_THROW(
+      InternedPathComponent{folly::StringPiece{".."}},
+      PathComponentValidationError);
+}
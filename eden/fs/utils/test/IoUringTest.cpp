@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifdef __linux__
+
+#include "eden/fs/utils/IoUring.h"
+
+#include <fcntl.h>
+#include <folly/Exception.h>
+#include <folly/File.h>
+#include <folly/portability/GTest.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#include "eden/fs/testharness/TempFile.h"
+
+using namespace facebook::eden;
+
+namespace {
+class IoUringTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    ring_ = IoUring::tryCreate(4);
+    if (!ring_) {
+      GTEST_SKIP() << "io_uring is not available";
+    }
+    tempDir_ = makeTempDir();
+    dir_ = folly::File{tempDir_.path().c_str(), O_RDONLY | O_DIRECTORY};
+  }
+
+  void createFile(const std::string& name) {
+    int fd = openat(
+        dir_.fd(), name.c_str(), O_CREAT | O_WRONLY | O_CLOEXEC, 0644);
+    folly::checkUnixError(fd, "failed to create ", name);
+    close(fd);
+  }
+
+  bool exists(const std::string& name) {
+    return faccessat(dir_.fd(), name.c_str(), F_OK, 0) == 0;
+  }
+
+  std::unique_ptr<IoUring> ring_;
+  folly::test::TemporaryDirectory tempDir_;
+  folly::File dir_;
+};
+} // namespace
+
+TEST_F(IoUringTest, unlinksBatchLargerThanRing) {
+  std::vector<std::string> names;
+  std::vector<IoUring::Op> ops;
+  for (int i = 0; i < 10; ++i) {
+    names.push_back("file" + std::to_string(i));
+    createFile(names.back());
+  }
+  for (const auto& name : names) {
+    ops.push_back(IoUring::Op::unlinkAt(dir_.fd(), name.c_str()));
+  }
+  ops.push_back(IoUring::Op::unlinkAt(dir_.fd(), "missing"));
+
+  auto results = ring_->submitAndWait(ops);
+  ASSERT_EQ(ops.size(), results.size());
+  if (results[0] == -EINVAL) {
+    GTEST_SKIP() << "the kernel does not support IORING_OP_UNLINKAT";
+  }
+  for (size_t i = 0; i < names.size(); ++i) {
+    EXPECT_EQ(0, results[i]) << names[i];
+    EXPECT_FALSE(exists(names[i])) << names[i];
+  }
+  EXPECT_EQ(-ENOENT, results.back());
+}
+
+TEST_F(IoUringTest, reportsFsyncResults) {
+  createFile("file");
+  folly::File file{
+      openat(dir_.fd(), "file", O_WRONLY | O_CLOEXEC), /* ownsFd */ true};
+
+  std::vector<IoUring::Op> ops{
+      IoUring::Op::fsync(file.fd()),
+      IoUring::Op::fdatasync(file.fd()),
+      IoUring::Op::fsync(-1),
+  };
+  auto results = ring_->submitAndWait(ops);
+  EXPECT_EQ((std::vector<int>{0, 0, -EBADF}), results);
+}
+
+#endif
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/LeaseCache.h"
+
+#include <folly/portability/GTest.h>
+#include <atomic>
+#include <thread>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+using Cache = LeaseCache<int, std::string>;
+
+/**
+ * Fetches whose completion is controlled by the test.
+ */
+struct Fetcher {
+  Cache::FutureType operator()(int key) {
+    ++fetches;
+    if (immediate) {
+      return std::make_shared<std::string>(std::to_string(key));
+    }
+    auto [promise, future] = folly::makePromiseContract<Cache::ValuePtr>();
+    promises.push_back(std::move(promise));
+    return std::move(future);
+  }
+
+  bool immediate{true};
+  int fetches{0};
+  std::vector<folly::Promise<Cache::ValuePtr>> promises;
+};
+} // namespace
+
+TEST(LeaseCache, valuesAreFetchedOnce) {
+  Fetcher fetcher;
+  Cache cache{100, [&](int key) { return fetcher(key); }};
+
+  EXPECT_EQ("1", *cache.get(1).get());
+  EXPECT_EQ("1", *cache.get(1).get());
+  EXPECT_EQ(1, fetcher.fetches);
+
+  auto stats = cache.getStats();
+  EXPECT_EQ(1, stats.misses);
+  EXPECT_EQ(1, stats.hits);
+}
+
+TEST(LeaseCache, concurrentGetsShareTheFetch) {
+  Fetcher fetcher;
+  fetcher.immediate = false;
+  Cache cache{100, [&](int key) { return fetcher(key); }};
+
+  auto first = cache.get(1);
+  auto second = cache.get(1);
+  auto dropped = cache.get(1);
+  dropped = Cache::FutureType{};
+  EXPECT_FALSE(first.isReady());
+  EXPECT_FALSE(second.isReady());
+  EXPECT_TRUE(cache.exists(1));
+  ASSERT_EQ(1, fetcher.promises.size());
+
+  fetcher.promises[0].setValue(std::make_shared<std::string>("one"));
+  EXPECT_EQ("one", *std::move(first).get(0ms));
+  EXPECT_EQ("one", *std::move(second).get(0ms));
+  EXPECT_EQ("one", *cache.get(1).get(0ms));
+  EXPECT_EQ(1, fetcher.fetches);
+  EXPECT_EQ(2, cache.getStats().joins);
+}
+
+TEST(LeaseCache, failuresAreNotCached) {
+  Fetcher fetcher;
+  fetcher.immediate = false;
+  Cache cache{100, [&](int key) { return fetcher(key); }};
+
+  auto first = cache.get(1);
+  fetcher.promises[0].setException(std::runtime_error("fetch failed"));
+  EXPECT_THROW(std::move(first).get(0ms), std::runtime_error);
+  EXPECT_FALSE(cache.exists(1));
+
+  fetcher.immediate = true;
+  EXPECT_EQ("1", *cache.get(1).get());
+  EXPECT_EQ(2, fetcher.fetches);
+}
+
+TEST(LeaseCache, erasedFetchesAreNotCached) {
+  Fetcher fetcher;
+  fetcher.immediate = false;
+  Cache cache{100, [&](int key) { return fetcher(key); }};
+
+  auto first = cache.get(1);
+  cache.erase(1);
+  fetcher.promises[0].setValue(std::make_shared<std::string>("stale"));
+  EXPECT_EQ("stale", *std::move(first).get(0ms));
+  EXPECT_FALSE(cache.exists(1));
+}
+
+TEST(LeaseCache, setValuesAreNotReplacedByFetches) {
+  Fetcher fetcher;
+  fetcher.immediate = false;
+  Cache cache{100, [&](int key) { return fetcher(key); }};
+
+  auto first = cache.get(1);
+  cache.set(1, std::make_shared<std::string>("set"));
+  fetcher.promises[0].setValue(std::make_shared<std::string>("fetched"));
+  EXPECT_EQ("fetched", *std::move(first).get(0ms));
+  EXPECT_EQ("set", *cache.get(1).get(0ms));
+  EXPECT_EQ(1, fetcher.fetches);
+}
+
+TEST(LeaseCache, valuesExpire) {
+  Fetcher fetcher;
+  Cache cache{100, [&](int key) { return fetcher(key); }, 10ms};
+
+  cache.get(1).get();
+  EXPECT_TRUE(cache.exists(1));
+  std::this_thread::sleep_for(20ms);
+  EXPECT_FALSE(cache.exists(1));
+
+  cache.get(1).get();
+  EXPECT_EQ(2, fetcher.fetches);
+  EXPECT_EQ(1, cache.getStats().expirations);
+}
+
+TEST(LeaseCache, leastRecentlyUsedValuesAreEvicted) {
+  Fetcher fetcher;
+  Cache cache{1, [&](int key) { return fetcher(key); }, 0ms, 1};
+
+  cache.get(1).get();
+  cache.get(2).get();
+  EXPECT_FALSE(cache.exists(1));
+  EXPECT_TRUE(cache.exists(2));
+  EXPECT_EQ(1, cache.getStats().evictions);
+}
+
+TEST(LeaseCache, getsFromManyThreads) {
+  std::atomic<int> fetches{0};
+  Cache cache{1000, [&](int key) -> Cache::FutureType {
+                ++fetches;
+                return std::make_shared<std::string>(std::to_string(key));
+              }};
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(std::to_string(i % 100), *cache.get(i % 100).get());
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  auto stats = cache.getStats();
+  EXPECT_EQ(100, fetches.load());
+  EXPECT_EQ(100, stats.misses);
+  EXPECT_EQ(8000, stats.hits + stats.misses + stats.joins);
+}
@@ -81,6 +81,23 @@ TEST_F(MappedDiskVectorTest, remembers_contents_on_reopen) {
   EXPECT_EQ(35, mdv[2]);
 }
 
+TEST_F(MappedDiskVectorTest, huge_pages_and_populate_keep_contents) {
+  {
+    auto mdv = MappedDiskVector<U64>::open(
+        mdvPath, /*shouldPopulate=*/true, /*useHugePages=*/true);
+    // Grow past the initial mapping so that it is remapped.
+    for (uint64_t i = 0; i < 1000000; ++i) {
+      mdv.emplace_back(i);
+    }
+  }
+
+  auto mdv = MappedDiskVector<U64>::open(
+      mdvPath, /*shouldPopulate=*/true, /*useHugePages=*/true);
+  ASSERT_EQ(1000000, mdv.size());
+  EXPECT_EQ(0, mdv[0]);
+  EXPECT_EQ(999999, mdv[999999]);
+}
+
 TEST_F(MappedDiskVectorTest, pop_back) {
   auto mdv = MappedDiskVector<U64>::open(mdvPath);
   mdv.emplace_back(1ull);
@@ -46,3 +46,13 @@ TEST(Memory, FBStringMemoryUsage) {
   }
 }
 #endif
+
+TEST(Memory, allocatorStats) {
+  auto stats = getAllocatorStats();
+  if (!stats) {
+    GTEST_SKIP() << "the allocator is not jemalloc";
+  }
+  EXPECT_GT(stats->allocated, 0);
+  EXPECT_GE(stats->active, stats->allocated);
+  EXPECT_GE(stats->resident, stats->active);
+}
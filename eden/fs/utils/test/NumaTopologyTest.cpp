@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/NumaTopology.h"
+
+#include <folly/portability/GMock.h>
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using namespace testing;
+
+TEST(NumaTopology, parseCpuList) {
+  EXPECT_THAT(NumaTopology::parseCpuList(""), IsEmpty());
+  EXPECT_THAT(NumaTopology::parseCpuList("3"), ElementsAre(3));
+  EXPECT_THAT(
+      NumaTopology::parseCpuList("0-2,8,10-11"),
+      ElementsAre(0, 1, 2, 8, 10, 11));
+  EXPECT_THROW(NumaTopology::parseCpuList("3-1"), std::invalid_argument);
+  EXPECT_ANY_THROW(NumaTopology::parseCpuList("a"));
+}
+
+TEST(NumaTopology, threads_are_spread_across_nodes) {
+  NumaTopology topology{{{0, 1}, {2, 3}}};
+  EXPECT_EQ(2, topology.getNodeCount());
+  EXPECT_EQ(0, topology.getNodeForThread(0));
+  EXPECT_EQ(1, topology.getNodeForThread(1));
+  EXPECT_EQ(0, topology.getNodeForThread(2));
+  EXPECT_THAT(topology.getCpus(1), ElementsAre(2, 3));
+}
+
+TEST(NumaTopology, no_topology_does_not_pin) {
+  NumaTopology topology{{}};
+  EXPECT_EQ(0, topology.getNodeCount());
+  EXPECT_EQ(0, topology.getNodeForThread(5));
+  EXPECT_FALSE(topology.pinCurrentThread(0));
+}
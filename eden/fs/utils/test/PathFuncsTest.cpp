@@ -563,6 +563,41 @@ TEST(PathFuncs, PathComponent) {
   EXPECT_THROW_RE(PathComponent(".."), std::domain_error, "must not be \\.\\.");
 }
 
+TEST(PathFuncs, validationOfLongPaths) {
+  // Long enough for the vectorized scans to find the invalid characters
+  // past their first block.
+  std::string longName(40, 'x');
+  EXPECT_NO_THROW(PathComponent{longName});
+  EXPECT_THROW_RE(
+      PathComponent(longName + "/" + longName),
+      std::domain_error,
+      "containing a directory separator");
+  EXPECT_THROW_RE(
+      PathComponent(longName + std::string(1, '\0') + longName),
+      std::domain_error,
+      "nul byte");
+  EXPECT_THROW_RE(
+      PathComponent(longName + "\xff"), std::domain_error, "non valid UTF8");
+
+  auto longPath = longName + "/" + longName + "/" + longName;
+  EXPECT_NO_THROW(RelativePath{longPath});
+  EXPECT_THROW_RE(
+      RelativePath(longPath + "/../" + longName),
+      std::domain_error,
+      "must not be \\.\\.");
+  EXPECT_THROW_RE(
+      RelativePath(longName + "//" + longName),
+      std::domain_error,
+      "empty PathComponent");
+  EXPECT_THROW_RE(
+      RelativePath(longPath + "/a" + std::string(1, '\0')),
+      std::domain_error,
+      "nul byte");
+  EXPECT_THROW_RE(
+      RelativePath(longPath + "/\xc3"), std::domain_error, "non valid UTF8");
+  EXPECT_NO_THROW(RelativePath{longPath + "/\xc3\xa9"});
+}
+
 TEST(PathFuncs, RelativePath) {
   RelativePath emptyRel;
   EXPECT_EQ("", emptyRel.stringPiece());
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/PathMap.h"
+
+#include <benchmark/benchmark.h>
+#include <fmt/format.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace facebook::eden;
+
+constexpr size_t kEntries = 50000;
+
+PathMap<size_t> makeDirectory(CaseSensitivity caseSensitive) {
+  PathMap<size_t> map{caseSensitive};
+  map.reserve(kEntries);
+  for (size_t i = 0; i < kEntries; ++i) {
+    map.emplace(PathComponent{fmt::format("SourceFile{:05}.cpp", i)}, i);
+  }
+  return map;
+}
+
+std::vector<PathComponent> makeLookups(CaseSensitivity caseSensitive) {
+  std::vector<PathComponent> lookups;
+  lookups.reserve(kEntries);
+  for (size_t i = 0; i < kEntries; ++i) {
+    // Visit the directory out of order, and with a different case when that
+    // still finds the entries.
+    auto n = (i * 7919) % kEntries;
+    lookups.emplace_back(
+        caseSensitive == CaseSensitivity::Sensitive
+            ? fmt::format("SourceFile{:05}.cpp", n)
+            : fmt::format("sourcefile{:05}.CPP", n));
+  }
+  return lookups;
+}
+
+void find(benchmark::State& state, CaseSensitivity caseSensitive) {
+  const auto map = makeDirectory(caseSensitive);
+  auto lookups = makeLookups(caseSensitive);
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(map.find(lookups[i]));
+    i = (i + 1) % lookups.size();
+  }
+}
+
+void find_case_sensitive(benchmark::State& state) {
+  find(state, CaseSensitivity::Sensitive);
+}
+BENCHMARK(find_case_sensitive);
+
+void find_case_insensitive(benchmark::State& state) {
+  find(state, CaseSensitivity::Insensitive);
+}
+BENCHMARK(find_case_insensitive);
+
+void build_and_find_case_insensitive(benchmark::State& state) {
+  const auto original = makeDirectory(CaseSensitivity::Insensitive);
+  auto lookups = makeLookups(CaseSensitivity::Insensitive);
+  for (auto _ : state) {
+    // Copies don't share the index, so this includes building it.
+    auto map = original;
+    benchmark::DoNotOptimize(map.find(lookups[0]));
+  }
+}
+BENCHMARK(build_and_find_case_insensitive);
+
+void create_in_large_directory(benchmark::State& state) {
+  // Like TreeInode::create: a lookup, then an insert in sorted order.
+  auto map = makeDirectory(CaseSensitivity::Sensitive);
+  size_t i = 0;
+  for (auto _ : state) {
+    PathComponent name{fmt::format("NewFile{}.cpp", i++)};
+    if (map.find(name) == map.end()) {
+      map.emplace(name, i);
+    }
+  }
+}
+BENCHMARK(create_in_large_directory);
+
+} // namespace
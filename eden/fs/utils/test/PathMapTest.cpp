@@ -6,8 +6,12 @@
  */
 
 #include "eden/fs/utils/PathMap.h"
+#include <fmt/format.h>
 #include <folly/portability/GTest.h>
 #include <folly/portability/Unistd.h>
+#include <algorithm>
+#include <string>
+#include <vector>
 
 using namespace facebook::eden;
 using namespace facebook::eden::path_literals;
@@ -126,6 +130,68 @@ TEST(PathMap, caseInSensitiveCopyMove) {
   EXPECT_TRUE(move_assign.at("Foo"_pc));
 }
 
+TEST(PathMap, caseInSensitiveLargeMap) {
+  PathMap<int> map(CaseSensitivity::Insensitive);
+  for (int i = 0; i < 1000; ++i) {
+    map.emplace(PathComponent{fmt::format("File{}", i)}, i);
+  }
+  for (int i = 0; i < 1000; ++i) {
+    auto it = map.find(PathComponent{fmt::format("fILE{}", i)});
+    ASSERT_NE(it, map.end());
+    EXPECT_EQ(i, it->second);
+  }
+  EXPECT_EQ(map.find("file1000"_pc), map.end());
+
+  // Mutations keep the lookups consistent.
+  EXPECT_EQ(1, map.erase("FILE500"_pc));
+  EXPECT_EQ(map.find("file500"_pc), map.end());
+  EXPECT_EQ(501, map.at("file501"_pc));
+  map["FILE1000"_pc] = 1000;
+  EXPECT_EQ(1000, map.at("file1000"_pc));
+  EXPECT_FALSE(map.emplace("file1000"_pc, 0).second);
+  map.erase(map.begin(), map.begin() + 10);
+  EXPECT_EQ(990, map.size());
+  EXPECT_EQ(map.find("file0"_pc), map.end());
+  EXPECT_EQ(999, map.at("file999"_pc));
+
+  PathMap<int> copied(map);
+  EXPECT_EQ(999, copied.at("FILE999"_pc));
+  map.clear();
+  EXPECT_EQ(map.find("file999"_pc), map.end());
+  EXPECT_EQ(999, copied.at("FILE999"_pc));
+}
+
+TEST(PathMap, caseSensitiveLargeMap) {
+  PathMap<int> map(CaseSensitivity::Sensitive);
+  for (int i = 0; i < 5000; i += 2) {
+    map.emplace(PathComponent{fmt::format("file{}", i)}, i);
+  }
+  EXPECT_EQ(2500, map.at("file2500"_pc));
+  EXPECT_EQ(map.find("FILE2500"_pc), map.end());
+
+  // Interleave inserts and erases with lookups, which go through the index.
+  for (int i = 1; i < 5000; i += 2) {
+    map[PathComponent{fmt::format("file{}", i)}] = i;
+    EXPECT_EQ(i, map.at(PathComponent{fmt::format("file{}", i)}));
+    if (i % 3 == 0) {
+      EXPECT_EQ(1, map.erase(PathComponent{fmt::format("file{}", i - 1)}));
+    }
+  }
+  for (int i = 0; i < 5000; ++i) {
+    auto it = map.find(PathComponent{fmt::format("file{}", i)});
+    if (i % 2 == 0 && (i + 1) % 3 == 0) {
+      EXPECT_EQ(it, map.end());
+    } else {
+      ASSERT_NE(it, map.end());
+      EXPECT_EQ(i, it->second);
+    }
+  }
+  EXPECT_TRUE(std::is_sorted(
+      map.begin(), map.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+      }));
+}
+
 TEST(PathMap, insert) {
   PathMap<bool> map(kPathMapDefaultCaseSensitive);
 
@@ -157,6 +223,24 @@ TEST(PathMap, insert) {
   EXPECT_THROW(cmap["notpresent"_pc], std::out_of_range);
 }
 
+TEST(PathMap, insertMovesSortedAndUnsortedKeys) {
+  PathMap<std::string> map(kPathMapDefaultCaseSensitive);
+
+  EXPECT_TRUE(map.insert({PathComponent("b"), "b"}).second);
+  EXPECT_TRUE(map.insert({PathComponent("d"), "d"}).second);
+  // Out of order keys still go to their sorted position.
+  EXPECT_TRUE(map.insert({PathComponent("a"), "a"}).second);
+  EXPECT_TRUE(map.insert({PathComponent("c"), "c"}).second);
+  EXPECT_FALSE(map.insert({PathComponent("d"), "other"}).second);
+
+  std::vector<std::string> values;
+  for (const auto& [name, value] : map) {
+    EXPECT_EQ(name.view(), value);
+    values.push_back(value);
+  }
+  EXPECT_EQ((std::vector<std::string>{"a", "b", "c", "d"}), values);
+}
+
 TEST(PathMap, iteration_and_erase) {
   PathMap<int> map(
       {
@@ -260,3 +344,37 @@ TEST(PathMap, swap) {
   EXPECT_EQ(0, b.size()) << "b now has 0 elements";
   EXPECT_EQ("foo", a.at("foo"_pc));
 }
+
+TEST(PathMap, generationChangesWithPositions) {
+  PathMap<std::string> map(kPathMapDefaultCaseSensitive);
+  auto generation = map.getGeneration();
+
+  map.insert(std::make_pair(PathComponent("foo"), "foo"));
+  EXPECT_NE(generation, map.getGeneration()) << "insert";
+  generation = map.getGeneration();
+
+  map.insert(std::make_pair(PathComponent("foo"), "other"));
+  map.emplace("foo"_pc, "other");
+  map["foo"_pc] = "bar";
+  EXPECT_EQ(generation, map.getGeneration()) << "existing key";
+
+  map["baz"_pc] = "baz";
+  EXPECT_NE(generation, map.getGeneration()) << "operator[] inserting";
+  generation = map.getGeneration();
+
+  map.erase("foo"_pc);
+  EXPECT_NE(generation, map.getGeneration()) << "erase";
+  generation = map.getGeneration();
+
+  PathMap<std::string> other(kPathMapDefaultCaseSensitive);
+  map.swap(other);
+  EXPECT_NE(generation, map.getGeneration()) << "swap";
+  generation = map.getGeneration();
+
+  map = other;
+  EXPECT_NE(generation, map.getGeneration()) << "assignment";
+  generation = map.getGeneration();
+
+  map.clear();
+  EXPECT_NE(generation, map.getGeneration()) << "clear";
+}
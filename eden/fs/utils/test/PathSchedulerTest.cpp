@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/PathScheduler.h"
+
+#include <folly/executors/ManualExecutor.h>
+#include <folly/portability/GTest.h>
+#include <string>
+#include <vector>
+
+using namespace facebook::eden;
+using namespace facebook::eden::path_literals;
+
+namespace {
+class PathSchedulerTest : public ::testing::Test {
+ protected:
+  folly::SemiFuture<folly::Unit> add(RelativePathPiece path) {
+    return scheduler_.add(
+        path, [this, path = path.copy()] { ran_.push_back(path.asString()); });
+  }
+
+  folly::ManualExecutor executor_;
+  PathScheduler scheduler_{
+      folly::getKeepAliveToken(executor_),
+      CaseSensitivity::Sensitive};
+  std::vector<std::string> ran_;
+};
+} // namespace
+
+TEST_F(PathSchedulerTest, unrelatedPathsRunConcurrently) {
+  add("a/x"_relpath);
+  add("b/y"_relpath);
+  add("a/z"_relpath);
+  EXPECT_EQ(3u, scheduler_.getPendingCount());
+
+  // All three are queued on the executor at once.
+  EXPECT_EQ(3u, executor_.run());
+  EXPECT_EQ(0u, scheduler_.getPendingCount());
+}
+
+TEST_F(PathSchedulerTest, ancestorsAndDescendantsRunInOrder) {
+  add("a/b"_relpath);
+  add("a"_relpath);
+  add("a/b/c"_relpath);
+  add("a/d"_relpath);
+
+  EXPECT_EQ(1u, executor_.run());
+  EXPECT_EQ(std::vector<std::string>{"a/b"}, ran_);
+  EXPECT_EQ(1u, executor_.run());
+  EXPECT_EQ((std::vector<std::string>{"a/b", "a"}), ran_);
+  // Neither is an ancestor of the other.
+  EXPECT_EQ(2u, executor_.run());
+  EXPECT_EQ(4u, ran_.size());
+  EXPECT_EQ(0u, executor_.run());
+}
+
+TEST_F(PathSchedulerTest, sameParentDoesNotSerialize) {
+  add("a/b/c"_relpath);
+  add("a/b/d"_relpath);
+  add("a/b/c"_relpath);
+
+  EXPECT_EQ(2u, executor_.run());
+  EXPECT_EQ(1u, executor_.run());
+  EXPECT_EQ((std::vector<std::string>{"a/b/c", "a/b/d", "a/b/c"}), ran_);
+}
+
+TEST_F(PathSchedulerTest, rootWaitsForEverything) {
+  add("a"_relpath);
+  add("b/c"_relpath);
+  auto barrier = add(RelativePathPiece{});
+  add("d"_relpath);
+
+  EXPECT_EQ(2u, executor_.run());
+  EXPECT_FALSE(barrier.isReady());
+  EXPECT_EQ(1u, executor_.run());
+  EXPECT_TRUE(barrier.isReady());
+  EXPECT_EQ(1u, executor_.run());
+  EXPECT_EQ((std::vector<std::string>{"a", "b/c", "", "d"}), ran_);
+}
+
+TEST_F(PathSchedulerTest, exceptionsAreReturnedAndDoNotBlock) {
+  auto failed = scheduler_.add(
+      "a"_relpath, [] { throw std::runtime_error("notification failed"); });
+  auto next = add("a/b"_relpath);
+
+  EXPECT_EQ(1u, executor_.run());
+  EXPECT_THROW(std::move(failed).get(), std::runtime_error);
+  EXPECT_EQ(1u, executor_.run());
+  EXPECT_TRUE(next.isReady());
+}
+
+TEST(PathScheduler, caseInsensitivePathsConflict) {
+  folly::ManualExecutor executor;
+  PathScheduler scheduler{
+      folly::getKeepAliveToken(executor), CaseSensitivity::Insensitive};
+  scheduler.add("A/b"_relpath, [] {});
+  scheduler.add("a/B/c"_relpath, [] {});
+
+  EXPECT_EQ(1u, executor.run());
+  EXPECT_EQ(1u, executor.run());
+  EXPECT_EQ(0u, scheduler.getPendingCount());
+}
@@ -8,6 +8,7 @@
 #include <folly/portability/GMock.h>
 #include <folly/portability/GTest.h>
 #include <sys/types.h>
+#include <thread>
 #include <utility>
 
 #include "eden/common/utils/ProcessNameCache.h"
@@ -49,5 +50,27 @@ TEST(ProcessAccessLog, accessAddsProcessToProcessNameCache) {
   auto processNameCache = std::make_shared<ProcessNameCache>();
   auto log = ProcessAccessLog{processNameCache};
   log.recordAccess(pid, ProcessAccessLog::AccessType::FsChannelOther);
+
+  // The pid is added by a background thread.
+  auto deadline = std::chrono::steady_clock::now() + 10s;
+  while (!processNameCache->getAllProcessNames().count(pid) &&
+         std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(1ms);
+  }
   EXPECT_THAT(processNameCache->getAllProcessNames(), Contains(Key(Eq(pid))));
 }
+
+TEST(ProcessAccessLog, readingCountsAddsQueuedProcesses) {
+  auto processNameCache = std::make_shared<ProcessNameCache>();
+  auto log = ProcessAccessLog{processNameCache};
+  for (pid_t pid = 1; pid <= 100; ++pid) {
+    log.recordAccess(pid, ProcessAccessLog::AccessType::FsChannelRead);
+  }
+  EXPECT_EQ(100, log.getAccessCounts(10s).size());
+}
+
+TEST(ProcessAccessLog, accessesFromPidZeroAreCounted) {
+  auto log = ProcessAccessLog{std::make_shared<ProcessNameCache>()};
+  log.recordAccess(0, ProcessAccessLog::AccessType::FsChannelRead);
+  EXPECT_THAT(log.getAccessCounts(10s), Contains(Key(Eq(0))));
+}
@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/RecyclingAllocator.h"
+
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+namespace {
+
+using namespace facebook::eden;
+
+// About the size of a FuseRequestContext.
+struct Context {
+  char data[256];
+};
+
+void make_shared_context(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(std::make_shared<Context>());
+  }
+}
+BENCHMARK(make_shared_context);
+
+void allocate_shared_recycled_context(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        std::allocate_shared<Context>(RecyclingAllocator<Context>{}));
+  }
+}
+BENCHMARK(allocate_shared_recycled_context);
+
+/**
+ * Many requests are in flight at once.
+ */
+void make_shared_context_batches(benchmark::State& state) {
+  std::vector<std::shared_ptr<Context>> contexts(64);
+  for (auto _ : state) {
+    for (auto& context : contexts) {
+      context = std::make_shared<Context>();
+    }
+    for (auto& context : contexts) {
+      context.reset();
+    }
+  }
+}
+BENCHMARK(make_shared_context_batches);
+
+void allocate_shared_recycled_context_batches(benchmark::State& state) {
+  std::vector<std::shared_ptr<Context>> contexts(64);
+  for (auto _ : state) {
+    for (auto& context : contexts) {
+      context = std::allocate_shared<Context>(RecyclingAllocator<Context>{});
+    }
+    for (auto& context : contexts) {
+      context.reset();
+    }
+  }
+}
+BENCHMARK(allocate_shared_recycled_context_batches);
+
+} // namespace
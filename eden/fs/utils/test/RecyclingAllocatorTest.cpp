@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/RecyclingAllocator.h"
+
+#include <folly/portability/GTest.h>
+#include <thread>
+#include <vector>
+
+using namespace facebook::eden;
+
+namespace {
+struct Object {
+  explicit Object(int v) : value{v} {}
+  int value;
+  char padding[100];
+};
+
+struct Recycled : RecycledAllocation<Recycled> {
+  virtual ~Recycled() = default;
+  char padding[200];
+};
+
+struct Larger : Recycled {
+  char morePadding[100];
+};
+} // namespace
+
+TEST(RecyclingAllocatorTest, freedObjectsAreReused) {
+  RecyclingAllocator<Object> alloc;
+  auto first = std::allocate_shared<Object>(alloc, 1);
+  const void* address = first.get();
+  first.reset();
+
+  auto second = std::allocate_shared<Object>(alloc, 2);
+  EXPECT_EQ(address, second.get());
+  EXPECT_EQ(2, second->value);
+}
+
+TEST(RecyclingAllocatorTest, objectsFreedOnAnotherThreadStayThere) {
+  RecyclingAllocator<Object> alloc;
+  auto object = std::allocate_shared<Object>(alloc, 1);
+  const void* address = object.get();
+
+  std::thread{[&] {
+    object.reset();
+    auto reused = std::allocate_shared<Object>(alloc, 2);
+    EXPECT_EQ(address, reused.get());
+  }}.join();
+}
+
+TEST(RecyclingAllocatorTest, arraysAreNotRecycled) {
+  std::vector<Object, RecyclingAllocator<Object>> objects;
+  for (int i = 0; i < 10; ++i) {
+    objects.emplace_back(i);
+  }
+  EXPECT_EQ(9, objects.back().value);
+}
+
+TEST(RecyclingAllocatorTest, recycledAllocationsAreReused) {
+  auto* first = new Recycled;
+  const void* address = first;
+  delete first;
+  auto second = std::make_unique<Recycled>();
+  EXPECT_EQ(address, second.get());
+
+  // Derived classes are allocated normally, and freed through their base.
+  std::unique_ptr<Recycled> larger = std::make_unique<Larger>();
+  larger.reset();
+}
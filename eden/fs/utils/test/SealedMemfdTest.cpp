@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifdef __linux__
+
+#include "eden/fs/utils/SealedMemfd.h"
+
+#include <fcntl.h>
+#include <folly/FileUtil.h>
+#include <folly/portability/GTest.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace facebook::eden;
+
+namespace {
+folly::IOBuf makeChain() {
+  folly::IOBuf chain{folly::IOBuf::COPY_BUFFER, "hello "};
+  chain.appendToChain(folly::IOBuf::copyBuffer("world"));
+  return chain;
+}
+} // namespace
+
+TEST(SealedMemfdTest, holdsAndMapsTheContents) {
+  auto memfd = makeSealedMemfd("test", makeChain());
+
+  EXPECT_EQ("hello world", memfd.contents.cloneAsValue().moveToFbString());
+
+  std::string fromFile;
+  ASSERT_TRUE(folly::readFile(memfd.file->fd(), fromFile));
+  EXPECT_EQ("hello world", fromFile);
+}
+
+TEST(SealedMemfdTest, cannotBeModified) {
+  auto memfd = makeSealedMemfd("test", makeChain());
+  int fd = memfd.file->fd();
+
+  EXPECT_EQ(
+      F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL,
+      ::fcntl(fd, F_GET_SEALS));
+  EXPECT_EQ(-1, ::pwrite(fd, "j", 1, 0));
+  EXPECT_EQ(EPERM, errno);
+  EXPECT_EQ(-1, ::ftruncate(fd, 0));
+  EXPECT_EQ(EPERM, errno);
+  EXPECT_EQ(
+      MAP_FAILED,
+      ::mmap(nullptr, 11, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+}
+
+TEST(SealedMemfdTest, mappingOutlivesTheFile) {
+  auto memfd = makeSealedMemfd("test", makeChain());
+  memfd.file.reset();
+  EXPECT_EQ("hello world", memfd.contents.cloneAsValue().moveToFbString());
+}
+
+TEST(SealedMemfdTest, emptyContents) {
+  auto memfd = makeSealedMemfd("test", folly::IOBuf{});
+  EXPECT_EQ(0, memfd.contents.computeChainDataLength());
+  struct stat st;
+  ASSERT_EQ(0, ::fstat(memfd.file->fd(), &st));
+  EXPECT_EQ(0, st.st_size);
+}
+
+#endif
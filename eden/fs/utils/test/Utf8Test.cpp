@@ -35,6 +35,23 @@ TEST(Utf8Test, isValidUtf8) {
   EXPECT_FALSE(isValidUtf8("\xA0prefix\xB0"));
 }
 
+TEST(Utf8Test, isValidUtf8LongStrings) {
+  // Multi-byte code points before, across and after 16 byte blocks.
+  std::string ascii(37, 'a');
+  for (size_t i = 0; i <= ascii.size(); ++i) {
+    auto str = ascii;
+    str.insert(i, "\xE2\x82\xAC");
+    EXPECT_TRUE(isValidUtf8(str)) << i;
+    str.insert(i, "\xff");
+    EXPECT_FALSE(isValidUtf8(str)) << i;
+  }
+
+  // A truncated code point is invalid even if the bytes after the string
+  // would complete it.
+  folly::StringPiece truncated{"abc\xC3\xA9", 4};
+  EXPECT_FALSE(isValidUtf8(truncated));
+}
+
 TEST(Utf8String, ensureValidUtf8) {
   for (auto str : kValidStrings) {
     EXPECT_EQ(str, ensureValidUtf8(str));
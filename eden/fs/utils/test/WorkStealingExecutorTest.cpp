@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/WorkStealingExecutor.h"
+
+#include <folly/portability/GTest.h>
+#include <folly/synchronization/Baton.h>
+#include <vector>
+
+#include "eden/fs/utils/UnboundedQueueExecutor.h"
+
+using namespace facebook::eden;
+
+TEST(WorkStealingExecutor, runs_tasks_added_from_outside) {
+  std::atomic<int> count{0};
+  {
+    WorkStealingExecutor executor{4, "Test"};
+    for (int i = 0; i < 1000; ++i) {
+      executor.add([&] { ++count; });
+    }
+  }
+  // The destructor runs the pending tasks.
+  EXPECT_EQ(1000, count.load());
+}
+
+TEST(WorkStealingExecutor, runs_tasks_added_from_workers) {
+  std::atomic<int> count{0};
+  folly::Baton<> done;
+  WorkStealingExecutor executor{4, "Test"};
+  executor.add([&] {
+    for (int i = 0; i < 1000; ++i) {
+      executor.add([&] {
+        if (++count == 1000) {
+          done.post();
+        }
+      });
+    }
+  });
+  done.wait();
+  EXPECT_EQ(1000, count.load());
+}
+
+TEST(WorkStealingExecutor, local_tasks_are_run_lifo) {
+  std::vector<int> order;
+  folly::Baton<> done;
+  WorkStealingExecutor executor{1, "Test"};
+  executor.add([&] {
+    for (int i = 0; i < 3; ++i) {
+      executor.add([&order, i] { order.push_back(i); });
+    }
+    executor.addWithPriority([&] { done.post(); }, folly::Executor::LO_PRI);
+  });
+  done.wait();
+  EXPECT_EQ((std::vector<int>{2, 1, 0}), order);
+}
+
+TEST(WorkStealingExecutor, priority_lanes) {
+  std::vector<std::string> order;
+  folly::Baton<> done;
+  WorkStealingExecutor executor{1, "Test"};
+  executor.add([&] {
+    executor.addWithPriority(
+        [&] {
+          order.push_back("low");
+          done.post();
+        },
+        folly::Executor::LO_PRI);
+    executor.add([&] { order.push_back("mid"); });
+    executor.addWithPriority(
+        [&] { order.push_back("high"); }, folly::Executor::HI_PRI);
+  });
+  done.wait();
+  EXPECT_EQ((std::vector<std::string>{"high", "mid", "low"}), order);
+}
+
+TEST(WorkStealingExecutor, idle_workers_steal) {
+  folly::Baton<> blocked;
+  folly::Baton<> stolen;
+  WorkStealingExecutor executor{2, "Test"};
+  executor.add([&] {
+    // Queued locally, while this worker stays busy until another one ran it.
+    executor.add([&] { stolen.post(); });
+    blocked.wait();
+  });
+  stolen.wait();
+  blocked.post();
+}
+
+TEST(WorkStealingExecutor, runs_tasks_added_in_bulk) {
+  std::atomic<int> count{0};
+  folly::Baton<> done;
+  WorkStealingExecutor executor{4, "Test"};
+  std::vector<folly::Func> funcs;
+  for (int i = 0; i < 1000; ++i) {
+    funcs.emplace_back([&] {
+      if (++count == 1000) {
+        done.post();
+      }
+    });
+  }
+  executor.addBulk(std::move(funcs));
+  done.wait();
+  EXPECT_EQ(1000, count.load());
+}
+
+TEST(WorkStealingExecutor, bursts_are_spread_over_the_workers) {
+  constexpr int kTasks = 64;
+  std::atomic<int> started{0};
+  folly::Baton<> allStarted;
+  folly::Baton<> release;
+  WorkStealingExecutor executor{2, "Test"};
+  executor.add([&] {
+    std::vector<folly::Func> funcs;
+    for (int i = 0; i < kTasks; ++i) {
+      funcs.emplace_back([&] {
+        if (++started == kTasks) {
+          allStarted.post();
+        }
+      });
+    }
+    // Queued locally, while this worker stays busy: the other one must take
+    // them all, in batches.
+    executor.addBulk(std::move(funcs));
+    release.wait();
+  });
+  allStarted.wait();
+  release.post();
+}
+
+TEST(WorkStealingExecutor, unbounded_queue_executor_forwards_bulk_adds) {
+  std::atomic<int> count{0};
+  {
+    UnboundedQueueExecutor executor{
+        std::make_shared<WorkStealingExecutor>(2, "Test")};
+    std::vector<folly::Func> funcs;
+    for (int i = 0; i < 100; ++i) {
+      funcs.emplace_back([&] { ++count; });
+    }
+    executor.addBulk(std::move(funcs));
+  }
+  EXPECT_EQ(100, count.load());
+}
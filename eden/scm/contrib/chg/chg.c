@@ -40,6 +40,7 @@ struct cmdserveropts {
   char initsockname[PATH_MAX];
   char redirectsockname[PATH_MAX];
   const char* cli_name;
+  int startinbackground;
 };
 
 static void initcmdserveropts(struct cmdserveropts* opts) {
@@ -142,14 +143,16 @@ static const char* gethgcmd(const char* cli_name) {
   return hgcmd;
 }
 
-static void execcmdserver(const struct cmdserveropts* opts) {
+static void execcmdserver(
+    const struct cmdserveropts* opts,
+    const char* address) {
   const char* hgcmd = gethgcmd(opts->cli_name);
 
   const char* argv[] = {
       hgcmd,
       "start-pfc-server",
       "--address",
-      opts->initsockname,
+      address,
       "--daemon-postexec",
       "chdir:/",
       NULL,
@@ -214,7 +217,47 @@ cleanup:
   return NULL;
 }
 
-/* Connect to a cmdserver. Will start a new server on demand. */
+/*
+ * Start a cmdserver at opts->sockname in a detached process, without waiting
+ * for it. The server binds opts->sockname itself, so no client needs to
+ * connect to it to clean up an init socket.
+ */
+static void startcmdserverinbackground(const struct cmdserveropts* opts) {
+  debugmsg("start cmdserver at %s in background", opts->sockname);
+
+  pid_t pid = fork();
+  if (pid < 0) {
+    debugmsg("failed to fork cmdserver process");
+    return;
+  }
+  if (pid > 0) {
+    /* collect the intermediate child, which exits right away */
+    waitpid(pid, NULL, 0);
+    return;
+  }
+
+  /* leave the session of the command, and get reparented to init, so that
+   * the server is neither signaled nor waited for along with the command.
+   * do not hold its stdio open either, as callers may wait for EOF on it. */
+  setsid();
+  if (fork() != 0)
+    _exit(0);
+  int fd = open("/dev/null", O_RDWR);
+  if (fd >= 0) {
+    dup2(fd, STDIN_FILENO);
+    dup2(fd, STDOUT_FILENO);
+    dup2(fd, STDERR_FILENO);
+    if (fd > STDERR_FILENO)
+      close(fd);
+  }
+  execcmdserver(opts, opts->sockname);
+}
+
+/*
+ * Connect to a cmdserver. Will start a new server on demand. If
+ * opts->startinbackground is set, the new server is started in background
+ * and NULL is returned.
+ */
 static hgclient_t* connectcmdserver(struct cmdserveropts* opts) {
   const char* sockname =
       opts->redirectsockname[0] ? opts->redirectsockname : opts->sockname;
@@ -230,13 +273,18 @@ static hgclient_t* connectcmdserver(struct cmdserveropts* opts) {
   if (sockname == opts->redirectsockname)
     unlink(opts->sockname);
 
+  if (opts->startinbackground) {
+    startcmdserverinbackground(opts);
+    return NULL;
+  }
+
   debugmsg("start cmdserver at %s", opts->initsockname);
 
   pid_t pid = fork();
   if (pid < 0)
     abortmsg("failed to fork cmdserver process");
   if (pid == 0) {
-    execcmdserver(opts);
+    execcmdserver(opts, opts->initsockname);
   } else {
     hgc = retryconnectcmdserver(opts, pid);
   }
@@ -340,6 +388,9 @@ int chg_main(
   struct cmdserveropts opts;
   initcmdserveropts(&opts);
   setcmdserveropts(&opts, cli_name);
+  /* with CHGSTARTINBACKGROUND set, a command that finds no server runs
+   * without chg instead of waiting for a new server to start */
+  opts.startinbackground = configint("CHGSTARTINBACKGROUND", 0);
 
   if (argc == 2) {
     if (strcmp(argv[1], "--kill-chg-daemon") == 0) {
@@ -352,6 +403,10 @@ int chg_main(
   size_t retry = 0;
   while (1) {
     hgc = connectcmdserver(&opts);
+    if (!hgc && opts.startinbackground) {
+      setenv("CHGDISABLE", "1", 1);
+      execoriginalhg(argv, cli_name);
+    }
     if (!hgc)
       abortmsg("cannot open hg client");
     int needreconnect = 0;
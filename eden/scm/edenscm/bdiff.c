@@ -35,42 +35,32 @@ struct pos {
 int bdiff_splitlines(const char* a, ssize_t len, struct bdiff_line** lr) {
   unsigned hash;
   int i;
-  const char *p, *b = a;
-  const char* const plast = a + len - 1;
+  const char *p, *b, *nl;
+  const char* const end = a + len;
   struct bdiff_line* l;
 
-  /* count the lines */
+  /* count the lines, the last one possibly without a newline; memchr is
+     vectorized by libc, unlike a loop testing every byte */
   i = 1; /* extra line for sentinel */
-  for (p = a; p < plast; p++)
-    if (*p == '\n')
-      i++;
-  if (p == plast)
+  for (p = a; p < end; p = nl + 1) {
     i++;
+    nl = memchr(p, '\n', end - p);
+    if (!nl)
+      break;
+  }
 
   *lr = l = (struct bdiff_line*)malloc(sizeof(struct bdiff_line) * i);
   if (!l)
     return -1;
 
-  /* build the line array and calculate hashes */
-  hash = 0;
-  for (p = a; p < plast; p++) {
-    hash = HASH(hash, *p);
-
-    if (*p == '\n') {
-      l->hash = hash;
-      hash = 0;
-      l->len = p - b + 1;
-      l->l = b;
-      l->n = INT_MAX;
-      l++;
-      b = p + 1;
-    }
-  }
-
-  if (p == plast) {
-    hash = HASH(hash, *p);
+  /* build the line array and calculate hashes, including the newlines */
+  for (b = a; b < end; b = p) {
+    nl = memchr(b, '\n', end - b);
+    hash = 0;
+    for (p = b; p < (nl ? nl + 1 : end); p++)
+      hash = HASH(hash, *p);
     l->hash = hash;
-    l->len = p - b + 1;
+    l->len = p - b;
     l->l = b;
     l->n = INT_MAX;
     l++;
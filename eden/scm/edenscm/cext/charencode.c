@@ -123,6 +123,318 @@ static const char hexchartable[16] = {
     'f',
 };
 
+/* SIMD kernels --------------------------------------------------------------
+ *
+ * Each kernel processes whole vectors from the start of its input, and
+ * returns the offset it stopped at: either the end of the last vector, or the
+ * start of the first vector that it cannot process. The scalar loops of the
+ * callers then carry on from there, and handle the bytes that need it.
+ *
+ * SSE2 and NEON are part of the x86-64 and AArch64 baselines. AVX2 is used
+ * when the CPU supports it, which is checked once at runtime.
+ */
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define CHARENCODE_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define CHARENCODE_AVX2
+#include <immintrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define CHARENCODE_NEON
+#include <arm_neon.h>
+#endif
+
+#ifdef CHARENCODE_AVX2
+static int hasavx2(void) {
+  static int cached = -1;
+  if (cached < 0) {
+    __builtin_cpu_init();
+    cached = __builtin_cpu_supports("avx2") ? 1 : 0;
+  }
+  return cached;
+}
+
+__attribute__((target("avx2"))) static Py_ssize_t
+asciiprefix_avx2(const char* buf, Py_ssize_t len) {
+  Py_ssize_t i = 0;
+  for (; i + 32 <= len; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(buf + i));
+    if (_mm256_movemask_epi8(v))
+      break;
+  }
+  return i;
+}
+
+__attribute__((target("avx2"))) static Py_ssize_t
+asciicasefold_avx2(char* dst, const char* src, Py_ssize_t len, char first) {
+  const __m256i lo = _mm256_set1_epi8(first - 1);
+  const __m256i hi = _mm256_set1_epi8(first + 26);
+  const __m256i bit = _mm256_set1_epi8(0x20);
+  Py_ssize_t i = 0;
+  for (; i + 32 <= len; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(src + i));
+    /* signed comparisons, the input being ASCII */
+    __m256i in = _mm256_and_si256(
+        _mm256_cmpgt_epi8(v, lo), _mm256_cmpgt_epi8(hi, v));
+    v = _mm256_xor_si256(v, _mm256_and_si256(in, bit));
+    _mm256_storeu_si256((__m256i*)(dst + i), v);
+  }
+  return i;
+}
+
+__attribute__((target("avx2"))) static Py_ssize_t
+jsonsafeprefix_avx2(const char* buf, Py_ssize_t len, bool paranoid) {
+  const __m256i ctrl = _mm256_set1_epi8(0x1f);
+  Py_ssize_t i = 0;
+  for (; i + 32 <= len; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(buf + i));
+    __m256i special = _mm256_or_si256(
+        _mm256_cmpeq_epi8(_mm256_min_epu8(v, ctrl), v),
+        _mm256_or_si256(
+            _mm256_or_si256(
+                _mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')),
+                _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))),
+            _mm256_cmpeq_epi8(v, _mm256_set1_epi8(0x7f))));
+    if (paranoid) {
+      special = _mm256_or_si256(
+          _mm256_or_si256(special, v),
+          _mm256_or_si256(
+              _mm256_cmpeq_epi8(v, _mm256_set1_epi8('<')),
+              _mm256_cmpeq_epi8(v, _mm256_set1_epi8('>'))));
+    }
+    if (_mm256_movemask_epi8(special))
+      break;
+  }
+  return i;
+}
+#endif /* CHARENCODE_AVX2 */
+
+#ifdef CHARENCODE_SSE2
+static Py_ssize_t asciiprefix_simd(const char* buf, Py_ssize_t len) {
+  Py_ssize_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(buf + i));
+    if (_mm_movemask_epi8(v))
+      break;
+  }
+  return i;
+}
+
+static Py_ssize_t
+asciicasefold_simd(char* dst, const char* src, Py_ssize_t len, char first) {
+  const __m128i lo = _mm_set1_epi8(first - 1);
+  const __m128i hi = _mm_set1_epi8(first + 26);
+  const __m128i bit = _mm_set1_epi8(0x20);
+  Py_ssize_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+    /* signed comparisons, the input being ASCII */
+    __m128i in = _mm_and_si128(_mm_cmpgt_epi8(v, lo), _mm_cmplt_epi8(v, hi));
+    v = _mm_xor_si128(v, _mm_and_si128(in, bit));
+    _mm_storeu_si128((__m128i*)(dst + i), v);
+  }
+  return i;
+}
+
+static Py_ssize_t
+jsonsafeprefix_simd(const char* buf, Py_ssize_t len, bool paranoid) {
+  const __m128i ctrl = _mm_set1_epi8(0x1f);
+  Py_ssize_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(buf + i));
+    __m128i special = _mm_or_si128(
+        _mm_cmpeq_epi8(_mm_min_epu8(v, ctrl), v),
+        _mm_or_si128(
+            _mm_or_si128(
+                _mm_cmpeq_epi8(v, _mm_set1_epi8('"')),
+                _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))),
+            _mm_cmpeq_epi8(v, _mm_set1_epi8(0x7f))));
+    if (paranoid) {
+      special = _mm_or_si128(
+          _mm_or_si128(special, v),
+          _mm_or_si128(
+              _mm_cmpeq_epi8(v, _mm_set1_epi8('<')),
+              _mm_cmpeq_epi8(v, _mm_set1_epi8('>'))));
+    }
+    if (_mm_movemask_epi8(special))
+      break;
+  }
+  return i;
+}
+
+/* values of 16 hex digits, or -1 if one of them isn't one */
+static inline int unhex16(__m128i c, __m128i* val) {
+  __m128i d = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+  __m128i digits = _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d);
+  __m128i l =
+      _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+  __m128i letters = _mm_cmpeq_epi8(_mm_min_epu8(l, _mm_set1_epi8(5)), l);
+  if (_mm_movemask_epi8(_mm_or_si128(digits, letters)) != 0xffff)
+    return -1;
+  *val = _mm_or_si128(
+      _mm_and_si128(digits, d),
+      _mm_and_si128(letters, _mm_add_epi8(l, _mm_set1_epi8(10))));
+  return 0;
+}
+
+/* returns the number of hex digits decoded into dst */
+static Py_ssize_t unhexlify_simd(char* dst, const char* src, Py_ssize_t len) {
+  const __m128i lowbyte = _mm_set1_epi16(0x00ff);
+  Py_ssize_t i = 0;
+  for (; i + 32 <= len; i += 32) {
+    __m128i a, b;
+    if (unhex16(_mm_loadu_si128((const __m128i*)(src + i)), &a) < 0 ||
+        unhex16(_mm_loadu_si128((const __m128i*)(src + i + 16)), &b) < 0)
+      break;
+    /* in each 16-bit lane, the low byte is the high nibble */
+    a = _mm_or_si128(
+        _mm_slli_epi16(_mm_and_si128(a, lowbyte), 4), _mm_srli_epi16(a, 8));
+    b = _mm_or_si128(
+        _mm_slli_epi16(_mm_and_si128(b, lowbyte), 4), _mm_srli_epi16(b, 8));
+    _mm_storeu_si128((__m128i*)(dst + i / 2), _mm_packus_epi16(a, b));
+  }
+  return i;
+}
+#elif defined(CHARENCODE_NEON)
+static Py_ssize_t asciiprefix_simd(const char* buf, Py_ssize_t len) {
+  Py_ssize_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    uint8x16_t v = vld1q_u8((const uint8_t*)(buf + i));
+    if (vmaxvq_u8(v) & 0x80)
+      break;
+  }
+  return i;
+}
+
+static Py_ssize_t
+asciicasefold_simd(char* dst, const char* src, Py_ssize_t len, char first) {
+  const uint8x16_t lo = vdupq_n_u8((uint8_t)first);
+  const uint8x16_t hi = vdupq_n_u8((uint8_t)(first + 25));
+  const uint8x16_t bit = vdupq_n_u8(0x20);
+  Py_ssize_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    uint8x16_t v = vld1q_u8((const uint8_t*)(src + i));
+    uint8x16_t in = vandq_u8(vcgeq_u8(v, lo), vcleq_u8(v, hi));
+    vst1q_u8((uint8_t*)(dst + i), veorq_u8(v, vandq_u8(in, bit)));
+  }
+  return i;
+}
+
+static Py_ssize_t
+jsonsafeprefix_simd(const char* buf, Py_ssize_t len, bool paranoid) {
+  Py_ssize_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    uint8x16_t v = vld1q_u8((const uint8_t*)(buf + i));
+    uint8x16_t special = vorrq_u8(
+        vcltq_u8(v, vdupq_n_u8(0x20)),
+        vorrq_u8(
+            vorrq_u8(
+                vceqq_u8(v, vdupq_n_u8('"')), vceqq_u8(v, vdupq_n_u8('\\'))),
+            vceqq_u8(v, vdupq_n_u8(0x7f))));
+    if (paranoid) {
+      special = vorrq_u8(
+          vorrq_u8(special, vcgeq_u8(v, vdupq_n_u8(0x80))),
+          vorrq_u8(vceqq_u8(v, vdupq_n_u8('<')), vceqq_u8(v, vdupq_n_u8('>'))));
+    }
+    if (vmaxvq_u8(special))
+      break;
+  }
+  return i;
+}
+
+/* values of 16 hex digits, or -1 if one of them isn't one */
+static inline int unhex16(uint8x16_t c, uint8x16_t* val) {
+  uint8x16_t d = vsubq_u8(c, vdupq_n_u8('0'));
+  uint8x16_t digits = vcleq_u8(d, vdupq_n_u8(9));
+  uint8x16_t l = vsubq_u8(vorrq_u8(c, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+  uint8x16_t letters = vcleq_u8(l, vdupq_n_u8(5));
+  if (vminvq_u8(vorrq_u8(digits, letters)) != 0xff)
+    return -1;
+  *val = vbslq_u8(digits, d, vaddq_u8(l, vdupq_n_u8(10)));
+  return 0;
+}
+
+/* returns the number of hex digits decoded into dst */
+static Py_ssize_t unhexlify_simd(char* dst, const char* src, Py_ssize_t len) {
+  Py_ssize_t i = 0;
+  for (; i + 32 <= len; i += 32) {
+    /* the high nibbles in val[0], the low ones in val[1] */
+    uint8x16x2_t c = vld2q_u8((const uint8_t*)(src + i));
+    uint8x16_t hi, lo;
+    if (unhex16(c.val[0], &hi) < 0 || unhex16(c.val[1], &lo) < 0)
+      break;
+    vst1q_u8((uint8_t*)(dst + i / 2), vorrq_u8(vshlq_n_u8(hi, 4), lo));
+  }
+  return i;
+}
+#else
+static Py_ssize_t asciiprefix_simd(const char* buf, Py_ssize_t len) {
+  return 0;
+}
+
+static Py_ssize_t
+asciicasefold_simd(char* dst, const char* src, Py_ssize_t len, char first) {
+  return 0;
+}
+
+static Py_ssize_t
+jsonsafeprefix_simd(const char* buf, Py_ssize_t len, bool paranoid) {
+  return 0;
+}
+
+static Py_ssize_t unhexlify_simd(char* dst, const char* src, Py_ssize_t len) {
+  return 0;
+}
+#endif
+
+/* length of the ASCII prefix of buf */
+static Py_ssize_t asciiprefix(const char* buf, Py_ssize_t len) {
+  Py_ssize_t i = 0;
+#ifdef CHARENCODE_AVX2
+  if (hasavx2())
+    i = asciiprefix_avx2(buf, len);
+#endif
+  i += asciiprefix_simd(buf + i, len - i);
+  while (i < len && !(buf[i] & 0x80))
+    i++;
+  return i;
+}
+
+/* convert ASCII src to lower case if table is lowertable, or to upper case */
+static void
+asciicasefold(char* dst, const char* src, Py_ssize_t len, const char* table) {
+  /* the range of the letters to convert */
+  char first = table == lowertable ? 'A' : 'a';
+  Py_ssize_t i = 0;
+#ifdef CHARENCODE_AVX2
+  if (hasavx2())
+    i = asciicasefold_avx2(dst, src, len, first);
+#endif
+  i += asciicasefold_simd(dst + i, src + i, len - i, first);
+  for (; i < len; i++)
+    dst[i] = table[(unsigned char)src[i]];
+}
+
+/* length of the prefix of buf that JSON escaping leaves as is */
+static Py_ssize_t
+jsonsafeprefix(const char* buf, Py_ssize_t len, bool paranoid) {
+  Py_ssize_t i = 0;
+#ifdef CHARENCODE_AVX2
+  if (hasavx2())
+    i = jsonsafeprefix_avx2(buf, len, paranoid);
+#endif
+  i += jsonsafeprefix_simd(buf + i, len - i, paranoid);
+  for (; i < len; i++) {
+    unsigned char c = (unsigned char)buf[i];
+    if (paranoid ? (c & 0x80) || jsonparanoidlentable[c] != 1
+                 : jsonlentable[c] != 1)
+      break;
+  }
+  return i;
+}
+
 /*
  * Turn a hex-encoded string into binary.
  */
@@ -138,7 +450,9 @@ PyObject* unhexlify(const char* str, Py_ssize_t len) {
 
   d = PyBytes_AsString(ret);
 
-  for (i = 0; i < len;) {
+  i = unhexlify_simd(d, str, len);
+  d += i / 2;
+  for (; i < len;) {
     int hi = hexdigit(str, i++);
     int lo = hexdigit(str, i++);
     *d++ = (hi << 4) | lo;
@@ -149,23 +463,11 @@ PyObject* unhexlify(const char* str, Py_ssize_t len) {
 
 PyObject* isasciistr(PyObject* self, PyObject* args) {
   const char* buf;
-  Py_ssize_t i, len;
+  Py_ssize_t len;
   if (!PyArg_ParseTuple(args, "s#:isasciistr", &buf, &len))
     return NULL;
-  i = 0;
-  /* char array in PyStringObject should be at least 4-byte aligned */
-  if (((uintptr_t)buf & 3) == 0) {
-    const uint32_t* p = (const uint32_t*)buf;
-    for (; i < len / 4; i++) {
-      if (p[i] & 0x80808080U)
-        Py_RETURN_FALSE;
-    }
-    i *= 4;
-  }
-  for (; i < len; i++) {
-    if (buf[i] & 0x80)
-      Py_RETURN_FALSE;
-  }
+  if (asciiprefix(buf, len) < len)
+    Py_RETURN_FALSE;
   Py_RETURN_TRUE;
 }
 
@@ -181,27 +483,27 @@ static inline PyObject* _asciitransform(
   str = PyBytes_AS_STRING(str_obj);
   len = PyBytes_GET_SIZE(str_obj);
 
+  /* check the whole string before converting any of it, so that non-ASCII
+   * strings go to the fallback without allocating */
+  i = asciiprefix(str, len);
+  if (i < len) {
+    if (fallback_fn != NULL) {
+      ret = PyObject_CallFunctionObjArgs(fallback_fn, str_obj, NULL);
+    } else {
+      PyObject* err = PyUnicodeDecodeError_Create(
+          "ascii", str, len, i, (i + 1), "unexpected code byte");
+      PyErr_SetObject(PyExc_UnicodeDecodeError, err);
+      Py_XDECREF(err);
+    }
+    goto quit;
+  }
+
   newobj = PyBytes_FromStringAndSize(NULL, len);
   if (!newobj)
     goto quit;
 
   newstr = PyBytes_AS_STRING(newobj);
-
-  for (i = 0; i < len; i++) {
-    char c = str[i];
-    if (c & 0x80) {
-      if (fallback_fn != NULL) {
-        ret = PyObject_CallFunctionObjArgs(fallback_fn, str_obj, NULL);
-      } else {
-        PyObject* err = PyUnicodeDecodeError_Create(
-            "ascii", str, len, i, (i + 1), "unexpected code byte");
-        PyErr_SetObject(PyExc_UnicodeDecodeError, err);
-        Py_XDECREF(err);
-      }
-      goto quit;
-    }
-    newstr[i] = table[(unsigned char)c];
-  }
+  asciicasefold(newstr, str, len, table);
 
   ret = newobj;
   Py_INCREF(ret);
@@ -299,11 +601,14 @@ quit:
 /* calculate length of JSON-escaped string; returns -1 if unsupported */
 static Py_ssize_t
 jsonescapelen(const char* buf, Py_ssize_t len, bool paranoid) {
-  Py_ssize_t i, esclen = 0;
+  Py_ssize_t i, esclen;
+
+  /* most strings need no escaping */
+  i = esclen = jsonsafeprefix(buf, len, paranoid);
 
   if (paranoid) {
     /* don't want to process multi-byte escapes in C */
-    for (i = 0; i < len; i++) {
+    for (; i < len; i++) {
       char c = buf[i];
       if (c & 0x80) {
         PyErr_SetString(PyExc_ValueError, "cannot process non-ascii str");
@@ -316,7 +621,7 @@ jsonescapelen(const char* buf, Py_ssize_t len, bool paranoid) {
       }
     }
   } else {
-    for (i = 0; i < len; i++) {
+    for (; i < len; i++) {
       char c = buf[i];
       esclen += jsonlentable[(unsigned char)c];
       if (esclen < 0) {
@@ -361,7 +666,9 @@ static void encodejsonescape(
   const uint8_t* lentable = (paranoid) ? jsonparanoidlentable : jsonlentable;
   Py_ssize_t i, j;
 
-  for (i = 0, j = 0; i < origlen; i++) {
+  i = j = jsonsafeprefix(origbuf, origlen, paranoid);
+  memcpy(escbuf, origbuf, i);
+  for (; i < origlen; i++) {
     char c = origbuf[i];
     uint8_t l = lentable[(unsigned char)c];
     assert(j + l <= esclen);
@@ -834,6 +834,27 @@ static PyObject* lazymanifest_diff(lazymanifest* self, PyObject* args) {
       result = 1;
     } else if (oneedle == other->numlines) {
       result = -1;
+    } else if (
+        left->len == right->len && left->hash_suffix == right->hash_suffix &&
+        (left->start == right->start ||
+         !memcmp(left->start, right->start, left->len))) {
+      /* Most lines of two related manifests are identical, and so are
+       * their paths: compare the whole lines at once, which memcmp
+       * vectorizes, and only build the key if clean files are listed. */
+      if (listclean) {
+#ifdef IS_PY3K
+        key = PyUnicode_FromString(left->start);
+#else
+        key = PyBytes_FromString(left->start);
+#endif
+        if (!key)
+          goto nomem;
+        PyDict_SetItem(ret, key, Py_None);
+        Py_DECREF(key);
+      }
+      sneedle++;
+      oneedle++;
+      continue;
     } else {
       result = linecmp(left, right);
     }
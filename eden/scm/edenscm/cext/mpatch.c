@@ -31,6 +31,9 @@
 #include <Python.h>
 #include <stdlib.h>
 #include <string.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 
 #include "eden/scm/edenscm/bitmanipulation.h"
 #include "eden/scm/edenscm/cext/util.h"
@@ -73,13 +76,107 @@ struct mpatch_flist* cpygetitem(void* bins, ssize_t pos) {
   return res;
 }
 
+/* patches per thread below which folding is not worth a thread */
+#define MIN_PATCHES_PER_THREAD 64
+
+/* number of threads to fold npatches patches with. folding only releases
+   the GIL when the patches are bytes objects, which are immutable. */
+static int foldthreads(Py_ssize_t npatches, int allbytes) {
+  long ncpus = 1;
+  Py_ssize_t n;
+
+  if (!allbytes)
+    return 1;
+#ifndef _WIN32
+  ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  n = npatches / MIN_PATCHES_PER_THREAD;
+  if (n > ncpus)
+    n = ncpus;
+  if (n > MPATCH_MAX_THREADS)
+    n = MPATCH_MAX_THREADS;
+  return n < 1 ? 1 : (int)n;
+}
+
+/* decode the n patches of bins into lists, holding a reference to each of
+   them in items. returns -1 with an exception set on failure. */
+static int decodeall(
+    PyObject* bins,
+    Py_ssize_t n,
+    struct mpatch_flist** lists,
+    PyObject** items,
+    int* allbytes) {
+  Py_ssize_t i;
+
+  *allbytes = 1;
+  for (i = 0; i < n; i++) {
+    items[i] = PyList_GetItem(bins, i);
+    if (!items[i] || !(lists[i] = cpygetitem(bins, i)))
+      goto fail;
+    Py_INCREF(items[i]);
+    if (!PyBytes_Check(items[i]))
+      *allbytes = 0;
+  }
+  return 0;
+
+fail:
+  while (i-- > 0) {
+    mpatch_lfree(lists[i]);
+    Py_DECREF(items[i]);
+  }
+  return -1;
+}
+
+/* fold the patches in lists[start:end], releasing the GIL if worth it */
+static struct mpatch_flist* foldall(
+    struct mpatch_flist** lists,
+    Py_ssize_t start,
+    Py_ssize_t end,
+    int allbytes) {
+  struct mpatch_flist* patch;
+  int nthreads = foldthreads(end - start, allbytes);
+
+  if (nthreads > 1) {
+    Py_BEGIN_ALLOW_THREADS
+    patch = mpatch_foldlists(lists + start, end - start, nthreads);
+    Py_END_ALLOW_THREADS
+  } else {
+    patch = mpatch_foldlists(lists + start, end - start, 1);
+  }
+  return patch;
+}
+
+/* apply a folded patch to the text in, returning the patched text */
+static PyObject*
+applyfolded(const char* in, Py_ssize_t inlen, struct mpatch_flist* patch) {
+  PyObject* result;
+  Py_ssize_t outlen;
+  int r;
+
+  outlen = mpatch_calcsize(inlen, patch);
+  if (outlen < 0) {
+    setpyerr((int)outlen);
+    return NULL;
+  }
+  result = PyBytes_FromStringAndSize(NULL, outlen);
+  if (!result)
+    return NULL;
+  if ((r = mpatch_apply(PyBytes_AsString(result), in, inlen, patch)) < 0) {
+    Py_DECREF(result);
+    setpyerr(r);
+    return NULL;
+  }
+  return result;
+}
+
 static PyObject* patches(PyObject* self, PyObject* args) {
-  PyObject *text, *bins, *result;
+  PyObject *text, *bins, *result = NULL;
   struct mpatch_flist* patch;
+  struct mpatch_flist** lists = NULL;
+  PyObject** items = NULL;
   const char* in;
-  int r = 0;
-  char* out;
-  Py_ssize_t len, outlen, inlen;
+  int allbytes;
+  Py_ssize_t i, len, inlen;
 
   if (!PyArg_ParseTuple(args, "OO:mpatch", &text, &bins))
     return NULL;
@@ -94,34 +191,117 @@ static PyObject* patches(PyObject* self, PyObject* args) {
   if (PyObject_AsCharBuffer(text, &in, &inlen))
     return NULL;
 
-  patch = mpatch_fold(bins, cpygetitem, 0, len);
-  if (!patch) { /* error already set or memory error */
-    if (!PyErr_Occurred())
-      PyErr_NoMemory();
-    return NULL;
+  lists = malloc(sizeof(*lists) * len);
+  items = malloc(sizeof(*items) * len);
+  if (!lists || !items) {
+    PyErr_NoMemory();
+    goto quit;
   }
+  if (decodeall(bins, len, lists, items, &allbytes) < 0)
+    goto quit;
 
-  outlen = mpatch_calcsize(inlen, patch);
-  if (outlen < 0) {
-    r = (int)outlen;
-    result = NULL;
-    goto cleanup;
+  patch = foldall(lists, 0, len, allbytes);
+  if (!patch) {
+    PyErr_NoMemory();
+  } else {
+    result = applyfolded(in, inlen, patch);
+    mpatch_lfree(patch);
   }
-  result = PyBytes_FromStringAndSize(NULL, outlen);
-  if (!result) {
-    result = NULL;
-    goto cleanup;
+
+  for (i = 0; i < len; i++)
+    Py_DECREF(items[i]);
+quit:
+  free(lists);
+  free(items);
+  return result;
+}
+
+/* apply the first ends[i] patches of bins to text, for each i */
+static PyObject* patchesbulk(PyObject* self, PyObject* args) {
+  PyObject *text, *bins, *ends, *results = NULL;
+  struct mpatch_flist* acc = NULL;
+  struct mpatch_flist** lists = NULL;
+  PyObject** items = NULL;
+  const char* in;
+  int allbytes = 1, decoded = 0;
+  Py_ssize_t i, len, nends, inlen, prev = 0;
+
+  if (!PyArg_ParseTuple(
+          args, "OO!O!:patchesbulk", &text, &PyList_Type, &bins, &PyList_Type,
+          &ends))
+    return NULL;
+
+  len = PyList_GET_SIZE(bins);
+  nends = PyList_GET_SIZE(ends);
+  if (PyObject_AsCharBuffer(text, &in, &inlen))
+    return NULL;
+
+  lists = malloc(sizeof(*lists) * (len + 1));
+  items = malloc(sizeof(*items) * (len + 1));
+  if (!lists || !items) {
+    PyErr_NoMemory();
+    goto quit;
   }
-  out = PyBytes_AsString(result);
-  if ((r = mpatch_apply(out, in, inlen, patch)) < 0) {
-    Py_DECREF(result);
-    result = NULL;
+  if (decodeall(bins, len, lists, items, &allbytes) < 0)
+    goto quit;
+  decoded = 1;
+
+  results = PyList_New(nends);
+  if (!results)
+    goto quit;
+
+  for (i = 0; i < nends; i++) {
+    PyObject* result;
+    Py_ssize_t end = PyLong_AsSsize_t(PyList_GET_ITEM(ends, i));
+
+    if (end == -1 && PyErr_Occurred())
+      goto fail;
+    if (end < prev || end > len) {
+      PyErr_SetString(
+          PyExc_ValueError, "ends must be increasing patch counts");
+      goto fail;
+    }
+    if (end == 0) {
+      Py_INCREF(text);
+      PyList_SET_ITEM(results, i, text);
+      continue;
+    }
+
+    if (end > prev) {
+      /* the patches of the previous revision are already folded: fold the
+         new ones onto them, in the slot of the last patch they used */
+      Py_ssize_t first = prev;
+      if (acc)
+        lists[--first] = acc;
+      acc = foldall(lists, first, end, allbytes);
+      prev = end;
+      if (!acc) {
+        PyErr_NoMemory();
+        goto fail;
+      }
+    }
+
+    result = applyfolded(in, inlen, acc);
+    if (!result)
+      goto fail;
+    PyList_SET_ITEM(results, i, result);
   }
-cleanup:
-  mpatch_lfree(patch);
-  if (!result && !PyErr_Occurred())
-    setpyerr(r);
-  return result;
+  goto quit;
+
+fail:
+  Py_CLEAR(results);
+quit:
+  mpatch_lfree(acc);
+  if (decoded) {
+    /* the lists before prev were folded */
+    for (i = prev; i < len; i++)
+      mpatch_lfree(lists[i]);
+    for (i = 0; i < len; i++)
+      Py_DECREF(items[i]);
+  }
+  free(lists);
+  free(items);
+  return results;
 }
 
 /* calculate size of a patched file directly */
@@ -157,6 +337,10 @@ static PyObject* patchedsize(PyObject* self, PyObject* args) {
 
 static PyMethodDef methods[] = {
     {"patches", patches, METH_VARARGS, "apply a series of patches\n"},
+    {"patchesbulk",
+     patchesbulk,
+     METH_VARARGS,
+     "apply the first patches of a series, for several counts of them\n"},
     {"patchedsize", patchedsize, METH_VARARGS, "calculed patched size\n"},
     {NULL, NULL}};
 
@@ -413,7 +413,7 @@ static PyObject* pack_dirstate(PyObject* self, PyObject* args) {
   const char* utf8c = NULL;
   const char* utf8k = NULL;
 #endif
-  int now;
+  int now, hascopies;
 
   if (!PyArg_ParseTuple(
           args,
@@ -431,6 +431,9 @@ static PyObject* pack_dirstate(PyObject* self, PyObject* args) {
     return NULL;
   }
 
+  /* Most dirstates record no copies: skip looking every file up then. */
+  hascopies = PyDict_Size(copymap) > 0;
+
   /* Figure out how much we need to allocate. */
   for (nbytes = 40, pos = 0; PyDict_Next(map, &pos, &k, &v);) {
     PyObject* c;
@@ -446,7 +449,7 @@ static PyObject* pack_dirstate(PyObject* self, PyObject* args) {
     }
     nbytes += utf8k_size + 17;
 
-    c = PyDict_GetItem(copymap, k);
+    c = hascopies ? PyDict_GetItem(copymap, k) : NULL;
 
     if (c) {
       if (!PyUnicode_Check(c)) {
@@ -466,7 +469,7 @@ static PyObject* pack_dirstate(PyObject* self, PyObject* args) {
       goto bail;
     }
     nbytes += PyBytes_GET_SIZE(k) + 17;
-    c = PyDict_GetItem(copymap, k);
+    c = hascopies ? PyDict_GetItem(copymap, k) : NULL;
     if (c) {
       if (!PyBytes_Check(c)) {
         PyErr_SetString(PyExc_TypeError, "expected string key");
@@ -545,7 +548,7 @@ static PyObject* pack_dirstate(PyObject* self, PyObject* args) {
     memcpy(p, PyBytes_AS_STRING(k), len);
 #endif
     p += len;
-    o = PyDict_GetItem(copymap, k);
+    o = hascopies ? PyDict_GetItem(copymap, k) : NULL;
     if (o) {
       *p++ = '\0';
 #ifdef IS_PY3K
@@ -78,12 +78,21 @@ static inline void memcopy(
     const void* src,
     Py_ssize_t len) {
   if (dest) {
-    assert(*destlen + len < destsize);
+    assert(*destlen + len <= destsize);
     memcpy((void*)&dest[*destlen], src, len);
   }
   *destlen += len;
 }
 
+/* length of the run of bytes of src[i:len] in bitset */
+static inline Py_ssize_t
+runlen(const uint32_t bitset[], const char* src, Py_ssize_t i, Py_ssize_t len) {
+  Py_ssize_t j = i;
+  while (j < len && inset(bitset, src[j]))
+    j++;
+  return j - i;
+}
+
 static inline void
 hexencode(char* dest, Py_ssize_t* destlen, size_t destsize, uint8_t c) {
   static const char hexdigit[] = "0123456789abcdef";
@@ -443,12 +452,14 @@ static Py_ssize_t _encode(
             break;
         }
         break;
-      case DEFAULT:
-        while (inset(onebyte, src[i])) {
-          charcopy(dest, &destlen, destsize, src[i++]);
-          if (i == len)
-            goto done;
-        }
+      case DEFAULT: {
+        /* most bytes are copied as they are: find the run of them and copy
+           it at once, rather than going through charcopy byte by byte */
+        Py_ssize_t run = runlen(onebyte, src, i, len);
+        memcopy(dest, &destlen, destsize, &src[i], run);
+        i += run;
+        if (i == len)
+          goto done;
         switch (src[i]) {
           case '.':
             state = DOT;
@@ -477,6 +488,7 @@ static Py_ssize_t _encode(
             break;
         }
         break;
+      }
     }
   }
 done:
@@ -510,9 +522,11 @@ _lowerencode(char* dest, size_t destsize, const char* src, Py_ssize_t len) {
   Py_ssize_t i, destlen = 0;
 
   for (i = 0; i < len; i++) {
-    if (inset(onebyte, src[i]))
-      charcopy(dest, &destlen, destsize, src[i]);
-    else if (inset(lower, src[i]))
+    Py_ssize_t run = runlen(onebyte, src, i, len);
+    if (run) {
+      memcopy(dest, &destlen, destsize, &src[i], run);
+      i += run - 1;
+    } else if (inset(lower, src[i]))
       charcopy(dest, &destlen, destsize, src[i] + 32);
     else
       escape3(dest, &destlen, destsize, src[i]);
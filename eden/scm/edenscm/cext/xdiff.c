@@ -60,6 +60,47 @@ static PyObject* blocks(PyObject* self, PyObject* args) {
   return rl;
 }
 
+static PyObject* limitedblocks(PyObject* self, PyObject* args) {
+  char *sa = NULL, *sb = NULL;
+  Py_ssize_t na = 0, nb = 0;
+  long long maxbytes = 0, maxlines = 0, maxcost = 0;
+  int approximate = 0;
+
+  if (!PyArg_ParseTuple(
+          args, "s#s#LLL", &sa, &na, &sb, &nb, &maxbytes, &maxlines, &maxcost))
+    return NULL;
+
+  mmfile_t a = {sa, na}, b = {sb, nb};
+
+  PyObject* rl = PyList_New(0);
+  if (!rl)
+    return PyErr_NoMemory();
+
+  xpparam_t xpp = {
+      XDF_INDENT_HEURISTIC, /* flags */
+  };
+  xdlimits_t xlim = {
+      maxbytes, /* max_bytes */
+      maxlines, /* max_lines */
+      maxcost, /* max_cost */
+  };
+  xdemitconf_t xecfg = {
+      XDL_EMIT_BDIFFHUNK, /* flags */
+      hunk_consumer, /* hunk_consume_func */
+  };
+  xdemitcb_t ecb = {
+      rl, /* priv */
+  };
+
+  if (xdl_diff_limited_vendored(
+          &a, &b, &xpp, &xlim, &xecfg, &ecb, &approximate) != 0) {
+    Py_DECREF(rl);
+    return PyErr_NoMemory();
+  }
+
+  return Py_BuildValue("(NO)", rl, approximate ? Py_True : Py_False);
+}
+
 static char xdiff_doc[] = "xdiff wrapper";
 
 static PyMethodDef methods[] = {
@@ -68,6 +109,14 @@ static PyMethodDef methods[] = {
      METH_VARARGS,
      "(a: str, b: str) -> List[(a1, a2, b1, b2)].\n"
      "Yield matched blocks. (a1, a2, b1, b2) are line numbers.\n"},
+    {"limitedblocks",
+     limitedblocks,
+     METH_VARARGS,
+     "(a: str, b: str, maxbytes: int, maxlines: int, maxcost: int)\n"
+     "  -> (List[(a1, a2, b1, b2)], approximate: bool).\n"
+     "Like blocks, within bounds (0 for none). Past maxbytes or maxlines, the\n"
+     "lines between the common prefix and suffix are reported as a single\n"
+     "change, and approximate is True.\n"},
     {NULL, NULL},
 };
 
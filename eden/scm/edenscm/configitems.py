@@ -316,6 +316,9 @@ coreconfigitem("experimental", "regexmatcher", default=True)
 coreconfigitem("experimental", "dynmatcher", default=False)
 coreconfigitem("experimental", "uncommitondirtywdir", default=True)
 coreconfigitem("experimental", "xdiff", default=True)
+coreconfigitem("experimental", "xdiff.maxbytes", default=0)
+coreconfigitem("experimental", "xdiff.maxlines", default=0)
+coreconfigitem("experimental", "xdiff.maxcost", default=0)
 coreconfigitem("extensions", ".*", default=None, generic=True)
 coreconfigitem("extdata", ".*", default=None, generic=True)
 coreconfigitem("format", "aggressivemergedeltas", default=False)
@@ -14,14 +14,18 @@
 #endif
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <chrono>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <list>
+#include <map>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #ifndef _WIN32
@@ -183,6 +187,114 @@ static void disable() {
   rdtscratio = (t2 - t1) / (double)(r2 - r1);
 }
 
+/* sampling ----------------------------------------------------------------- */
+
+/* Instead of tracing every call, a separate thread periodically records the
+ * stack of the profiled thread. The cost is then a GIL handoff per sample,
+ * independent of the number of calls. */
+
+/* upper bound of the code objects recorded, to bound memory usage */
+static const size_t maxsampledcodes = 1 << 22;
+
+/* the stacks sampled so far, as code objects from the innermost frame to
+ * the outermost one, each stack followed by NULL. The buffer is preallocated
+ * and only written by the sampler thread, which is joined before it is read,
+ * so it needs neither lock nor allocation while sampling. */
+static std::vector<PyCodeObject*> sampledstacks;
+/* references held on the code objects in sampledstacks */
+static std::unordered_set<PyCodeObject*> sampledcodes;
+static size_t samplecount;
+static size_t droppedsamplecount;
+
+static PyThreadState* sampledthread;
+static std::thread samplerthread;
+static std::atomic<bool> samplingstopped{true};
+static std::chrono::microseconds samplinginterval{10000};
+
+/* record the current stack of the profiled thread, with the GIL held */
+static void recordstack(PyFrameObject* frame) {
+  size_t start = sampledstacks.size();
+  for (; frame; frame = frame->f_back) {
+    if (sampledstacks.size() + 1 >= sampledstacks.capacity()) {
+      /* full: drop the partial stack */
+      sampledstacks.resize(start);
+      droppedsamplecount++;
+      return;
+    }
+    PyCodeObject* code = frame->f_code;
+    if (sampledcodes.insert(code).second) {
+      Py_INCREF(code);
+    }
+    sampledstacks.push_back(code);
+  }
+  sampledstacks.push_back(NULL);
+  samplecount++;
+}
+
+static void samplerloop() {
+  using clock = std::chrono::steady_clock;
+  auto next = clock::now();
+  while (true) {
+    next += samplinginterval;
+    auto now = clock::now();
+    if (next < now) {
+      next = now; /* fell behind, do not sample in bursts to catch up */
+    }
+    std::this_thread::sleep_until(next);
+    if (samplingstopped.load(std::memory_order_acquire)) {
+      return;
+    }
+    /* the profiled thread gives the GIL away at its next switch interval,
+     * where its stack is consistent */
+    PyGILState_STATE gil = PyGILState_Ensure();
+    recordstack(sampledthread->frame);
+    PyGILState_Release(gil);
+  }
+}
+
+static void setsamplinginterval(double microseconds) {
+  if (microseconds >= 1) {
+    samplinginterval = std::chrono::microseconds((int64_t)microseconds);
+  }
+}
+
+/* sample the calling thread until disablesampling() */
+static void enablesampling() {
+  if (!samplingstopped.load(std::memory_order_acquire)) {
+    return;
+  }
+  sampledstacks.reserve(maxsampledcodes);
+  sampledthread = PyThreadState_Get();
+  r1 = rdtsc();
+  t1 = now_microseconds() / 1000;
+  samplingstopped.store(false, std::memory_order_release);
+  samplerthread = std::thread(samplerloop);
+}
+
+static void disablesampling() {
+  if (samplingstopped.exchange(true, std::memory_order_acq_rel)) {
+    return;
+  }
+  /* the sampler may be waiting for the GIL */
+  Py_BEGIN_ALLOW_THREADS
+  samplerthread.join();
+  Py_END_ALLOW_THREADS
+  r2 = rdtsc();
+  t2 = now_microseconds() / 1000;
+  rdtscratio = (t2 - t1) / (double)(r2 - r1);
+}
+
+static void clearsampling() {
+  for (auto code : sampledcodes) {
+    Py_DECREF(code);
+  }
+  sampledcodes.clear();
+  /* release the preallocated buffer too */
+  std::vector<PyCodeObject*>().swap(sampledstacks);
+  samplecount = 0;
+  droppedsamplecount = 0;
+}
+
 /* reporting ---------------------------------------------------------------- */
 
 struct FrameSummary {
@@ -422,6 +534,7 @@ static void fprintframetree(
 }
 
 static void clear() {
+  clearsampling();
   summaries.clear();
   framechildren.clear();
   fid2hash.clear();
@@ -438,3 +551,67 @@ static void report(FILE* fp = stderr) {
   fprintframetree(fp, dedupfid(0));
   fprintf(fp, "Total time: %.0f ms\n", (double)(r2 - r1) * rdtscratio);
 }
+
+static std::string codestring(PyObject* obj) {
+#ifdef IS_PY3K
+  const char* str = PyUnicode_AsUTF8(obj);
+#else
+  const char* str = PyString_AsString(obj);
+#endif
+  if (!str) {
+    PyErr_Clear();
+    return "?";
+  }
+  return str;
+}
+
+/* "name (file:line)", the label of a frame in folded stacks */
+static std::string codelabel(PyCodeObject* code) {
+  std::string label = codestring(code->co_name);
+  label += " (";
+  label += shortname(codestring(code->co_filename));
+  label += ":";
+  label += std::to_string(code->co_firstlineno);
+  label += ")";
+  /* ";" separates frames, and the count follows the last space */
+  std::replace(label.begin(), label.end(), ';', ',');
+  return label;
+}
+
+/* print the sampled stacks in the folded format of flamegraph.pl: one line
+ * per distinct stack, its frames from the outermost one separated by ";",
+ * followed by the number of samples of the stack */
+static void reportfolded(FILE* fp = stderr) {
+  std::unordered_map<PyCodeObject*, std::string> labels;
+  std::map<std::string, size_t> folded;
+  std::vector<PyCodeObject*> stack;
+  for (auto code : sampledstacks) {
+    if (code) {
+      stack.push_back(code);
+      continue;
+    }
+    std::string line;
+    for (auto it = stack.rbegin(); it != stack.rend(); ++it) {
+      auto label = labels.find(*it);
+      if (label == labels.end()) {
+        label = labels.emplace(*it, codelabel(*it)).first;
+      }
+      if (!line.empty()) {
+        line += ";";
+      }
+      line += label->second;
+    }
+    folded[line]++;
+    stack.clear();
+  }
+  for (auto& entry : folded) {
+    fprintf(fp, "%s %zu\n", entry.first.c_str(), entry.second);
+  }
+  fprintf(
+      fp,
+      "# %zu samples (%zu dropped) every %lld us in %.0f ms\n",
+      samplecount,
+      droppedsamplecount,
+      (long long)samplinginterval.count(),
+      (double)(r2 - r1) * rdtscratio);
+}
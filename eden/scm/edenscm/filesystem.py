@@ -10,6 +10,7 @@
 
 from __future__ import absolute_import
 
+import collections
 import errno
 import os
 import stat
@@ -25,6 +26,9 @@ from .node import hex
 
 _rangemask = 0x7FFFFFFF
 
+# The fields of a stat result that status compares with the dirstate.
+walkstat = collections.namedtuple("walkstat", "st_mode st_size st_mtime")
+
 
 class physicalfilesystem(object):
     def __init__(self, root, dirstate):
@@ -269,11 +273,20 @@ class physicalfilesystem(object):
         traversedir = bool(match.traversedir)
         threadcount = self.ui.configint("workingcopy", "rustwalkerthreads")
         walker = workingcopy.walker(
-            join(""), self.ui.identity.dotdir(), match, traversedir, threadcount
+            join(""),
+            self.ui.identity.dotdir(),
+            match,
+            traversedir,
+            threadcount,
+            True,
         )
-        for fn in walker:
+        for fn, st in walker:
             fn = self.dirstate.normalize(fn)
-            st = util.lstat(join(fn))
+            if st is None:
+                st = util.lstat(join(fn))
+            else:
+                # Use the stat of the walk instead of another lstat per file.
+                st = walkstat(*st)
             if traversedir and stat.S_ISDIR(st.st_mode):
                 match.traversedir(fn)
             else:
@@ -34,6 +34,7 @@ _missing_newline_marker = b"\\ No newline at end of file\n"
 blocks = bdiff.blocks
 fixws = bdiff.fixws
 patches = mpatch.patches
+patchesbulk = mpatch.patchesbulk
 patchedsize = mpatch.patchedsize
 textdiff = bdiff.bdiff
 
@@ -49,6 +50,19 @@ def init(ui: "UI") -> None:
         #  int, int]]`; used as `(a: str, b: str) -> List[Tuple[int, int, int, int]]`.
         blocks = xdiff.blocks
 
+        # Bound the work of diffing very large files. Past maxbytes or
+        # maxlines, the lines between the common prefix and suffix are
+        # reported as a single change.
+        maxbytes = ui.configbytes("experimental", "xdiff.maxbytes")
+        maxlines = ui.configint("experimental", "xdiff.maxlines")
+        maxcost = ui.configint("experimental", "xdiff.maxcost")
+        if maxbytes or maxlines or maxcost:
+
+            def limitedblocks(a, b):
+                return xdiff.limitedblocks(a, b, maxbytes, maxlines, maxcost)[0]
+
+            blocks = limitedblocks
+
 
 def splitnewlines(text: bytes) -> "List[bytes]":
     """like str.splitlines, but only split on newlines."""
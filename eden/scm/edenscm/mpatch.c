@@ -29,6 +29,9 @@
 
 #include <stdlib.h>
 #include <string.h>
+#ifndef _WIN32
+#include <pthread.h>
+#endif
 
 #include "eden/scm/edenscm/bitmanipulation.h"
 #include "eden/scm/edenscm/compat.h"
@@ -283,3 +286,78 @@ struct mpatch_flist* mpatch_fold(
       mpatch_fold(bins, get_next_item, start, start + len),
       mpatch_fold(bins, get_next_item, start + len, end));
 }
+
+/* like mpatch_fold, for hunk lists that are already decoded */
+static struct mpatch_flist*
+foldrange(struct mpatch_flist** lists, ssize_t start, ssize_t end) {
+  ssize_t len;
+
+  if (start + 1 == end)
+    return lists[start];
+
+  len = (end - start) / 2;
+  return combine(
+      foldrange(lists, start, start + len), foldrange(lists, start + len, end));
+}
+
+#ifndef _WIN32
+/* a contiguous range of the lists, folded by one thread */
+struct foldjob {
+  struct mpatch_flist** lists;
+  ssize_t start, end;
+  struct mpatch_flist* res;
+};
+
+static void* foldjobrun(void* arg) {
+  struct foldjob* job = (struct foldjob*)arg;
+  job->res = foldrange(job->lists, job->start, job->end);
+  return NULL;
+}
+#endif
+
+/* combine n decoded hunk lists into one, using up to nthreads threads.
+   this deletes the lists. */
+struct mpatch_flist*
+mpatch_foldlists(struct mpatch_flist** lists, ssize_t n, int nthreads) {
+  if (n == 0)
+    return lalloc(1);
+
+#ifndef _WIN32
+  if (nthreads > MPATCH_MAX_THREADS)
+    nthreads = MPATCH_MAX_THREADS;
+  if (nthreads > n)
+    nthreads = (int)n;
+  if (nthreads > 1) {
+    /* combining is associative: each thread folds a contiguous range, and
+       the results of the ranges are folded in turn */
+    struct foldjob jobs[MPATCH_MAX_THREADS];
+    struct mpatch_flist* results[MPATCH_MAX_THREADS];
+    pthread_t threads[MPATCH_MAX_THREADS];
+    int started[MPATCH_MAX_THREADS];
+    int t;
+
+    for (t = 0; t < nthreads; t++) {
+      jobs[t].lists = lists;
+      jobs[t].start = n * t / nthreads;
+      jobs[t].end = n * (t + 1) / nthreads;
+      jobs[t].res = NULL;
+    }
+    for (t = 1; t < nthreads; t++) {
+      started[t] =
+          pthread_create(&threads[t], NULL, foldjobrun, &jobs[t]) == 0;
+      if (!started[t])
+        foldjobrun(&jobs[t]);
+    }
+    foldjobrun(&jobs[0]);
+    results[0] = jobs[0].res;
+    for (t = 1; t < nthreads; t++) {
+      if (started[t])
+        pthread_join(threads[t], NULL);
+      results[t] = jobs[t].res;
+    }
+    return foldrange(results, 0, nthreads);
+  }
+#endif
+
+  return foldrange(lists, 0, n);
+}
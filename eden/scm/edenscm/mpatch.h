@@ -17,6 +17,8 @@
 #define MPATCH_ERR_NO_MEM -3
 #define MPATCH_ERR_CANNOT_BE_DECODED -2
 #define MPATCH_ERR_INVALID_PATCH -1
+/* upper bound of the threads of mpatch_foldlists */
+#define MPATCH_MAX_THREADS 16
 #include "eden/scm/edenscm/compat.h"
 
 struct mpatch_frag {
@@ -41,5 +43,7 @@ struct mpatch_flist* mpatch_fold(
     struct mpatch_flist* (*get_next_item)(void*, ssize_t),
     ssize_t start,
     ssize_t end);
+struct mpatch_flist*
+mpatch_foldlists(struct mpatch_flist** lists, ssize_t n, int nthreads);
 
 #endif
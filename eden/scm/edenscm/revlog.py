@@ -36,7 +36,7 @@ from . import ancestor, error, mdiff, pycompat, templatefilters, util
 from .i18n import _
 
 # import stuff from node for others to import from revlog
-from .node import bbin, bhex, hex, nullid, nullrev, wdirhex, wdirid, wdirrev
+from .node import bbin, bhex, hex, nullhex, nullid, nullrev, wdirhex, wdirid, wdirrev
 from .pycompat import range
 
 
@@ -544,6 +544,18 @@ class revlog(object):
             self._nodepos = None
 
     def rev(self, node):
+        index2 = getattr(self, "index2", None)
+        if index2 is not None and isinstance(node, bytes) and len(node) == 20:
+            # The Rust index reads its nodemap from disk, so unlike the C
+            # index it doesn't scan every revision on the first lookup.
+            rev = index2.rev(node)
+            if rev is not None:
+                return rev
+            if node == nullid:
+                return nullrev
+            if node == wdirid:
+                raise error.WdirUnsupported
+            raise LookupError(node, self.indexfile, _("no node"))
         try:
             return self._nodecache[node]
         except TypeError:
@@ -1179,7 +1191,7 @@ class revlog(object):
     def _partialmatch(self, id):
         maybewdir = wdirhex.startswith(id)
         try:
-            partial = self.index.partialmatch(id)
+            partial = self._indexpartialmatch(id)
             if partial and self.hasnode(partial):
                 if maybewdir:
                     # single 'ff...' match in radix tree, ambiguous with wdir
@@ -1221,6 +1233,19 @@ class revlog(object):
             except (TypeError, binascii.Error):
                 pass
 
+    def _indexpartialmatch(self, id):
+        """Like index.partialmatch, with the Rust index's nodemap if there
+        is one"""
+        index2 = getattr(self, "index2", None)
+        if index2 is None or not 4 <= len(id) <= 40:
+            return self.index.partialmatch(id)
+        nodes = index2.nodesbyprefix(id)
+        if nullhex.startswith(id.lower()):
+            nodes.append(nullid)
+        if len(nodes) > 1:
+            raise RevlogError
+        return nodes[0] if nodes else None
+
     def lookup(self, id: "Union[int, str, bytes]") -> bytes:
         """locate a node based on:
         - revision number or str(revision number)
@@ -24,15 +24,75 @@ pub fn init_module(py: Python, package: &str) -> PyResult<PyModule> {
     Ok(m)
 }
 
+fn dirname(path: &str) -> &str {
+    path.rfind('/').map_or("", |i| &path[..i])
+}
+
+/// Add `count` paths in `dir`: `dir` gets `count` more entries, and its
+/// ancestors one more each, up to the first one that already existed.
+fn add_dir(map: &mut HashMap<PyPathBuf, u64>, dir: &str, count: u64) {
+    let mut prefix = dir;
+    let mut count = count;
+    loop {
+        if let Some(e) = map.get_mut(PyPath::from_str(prefix)) {
+            *e += count;
+            return;
+        }
+        map.insert(PyPath::from_str(prefix).to_owned(), count);
+        if prefix.is_empty() {
+            return;
+        }
+        prefix = dirname(prefix);
+        count = 1;
+    }
+}
+
 fn add_path(map: &mut HashMap<PyPathBuf, u64>, path: &PyPath) {
-    let path = path.as_str();
-    for (i, _) in path.rmatch_indices("/").chain(Some((0, ""))) {
-        let prefix = PyPath::from_str(&path[..i]);
-        if let Some(e) = map.get_mut(prefix) {
-            *e += 1;
+    add_dir(map, dirname(path.as_str()), 1);
+}
+
+/// Adds paths in bulk. Paths come sorted from manifests and dirstates, so
+/// most of them are in the same directory as the previous path: those are
+/// counted together, and added to the map once per directory instead of once
+/// per path.
+struct BulkAdder<'a> {
+    map: &'a mut HashMap<PyPathBuf, u64>,
+    dir: String,
+    count: u64,
+}
+
+impl<'a> BulkAdder<'a> {
+    fn new(map: &'a mut HashMap<PyPathBuf, u64>) -> Self {
+        Self {
+            map,
+            dir: String::new(),
+            count: 0,
+        }
+    }
+
+    fn add(&mut self, path: &PyPath) {
+        let dir = dirname(path.as_str());
+        if self.count > 0 && dir == self.dir {
+            self.count += 1;
             return;
         }
-        map.insert(prefix.to_owned(), 1);
+        self.flush();
+        self.dir.push_str(dir);
+        self.count = 1;
+    }
+
+    fn flush(&mut self) {
+        if self.count > 0 {
+            add_dir(self.map, &self.dir, self.count);
+        }
+        self.dir.clear();
+        self.count = 0;
+    }
+}
+
+impl Drop for BulkAdder<'_> {
+    fn drop(&mut self) {
+        self.flush();
     }
 }
 
@@ -63,9 +123,10 @@ py_class!(pub class dirs |py| {
     def __new__(_cls, init: Option<&PyObject>) -> PyResult<dirs> {
         let mut inner = HashMap::new();
         if let Some(init) = init {
+            let mut adder = BulkAdder::new(&mut inner);
             for path in init.iter(py)? {
                 RefFromPyObject::with_extracted(py, &path?, |path: &PyPath| {
-                    add_path(&mut inner, path);
+                    adder.add(path);
                 })?;
             }
         }
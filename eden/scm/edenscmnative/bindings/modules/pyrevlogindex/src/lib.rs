@@ -14,6 +14,11 @@ use ::revlogindex::RevlogIndex;
 use cpython::*;
 use cpython_ext::PyNone;
 use cpython_ext::ResultPyErrExt;
+use dag::nonblocking::non_blocking_result;
+use dag::ops::IdConvert;
+use dag::ops::PrefixLookup;
+use dag::Group;
+use dag::Vertex;
 use pydag::Spans;
 
 // XXX: The revlogindex is a temporary solution before migrating to
@@ -67,6 +72,32 @@ py_class!(class revlogindex |py| {
         Ok(revlog.parent_revs(rev).map_pyerr(py)?.as_revs().to_vec())
     }
 
+    /// Resolve a node to its revision number with the nodemap, which is read
+    /// from disk instead of built by scanning the index.
+    /// Return None if the node is unknown.
+    def rev(&self, node: PyBytes) -> PyResult<Option<u32>> {
+        let revlog = self.index(py).borrow();
+        let node = Vertex::copy_from(node.data(py));
+        let id = non_blocking_result(revlog.vertex_id_with_max_group(&node, Group::NON_MASTER))
+            .map_pyerr(py)?;
+        Ok(id.map(|id| id.0 as u32))
+    }
+
+    /// Find the nodes starting with a hex prefix, at most `limit` of them.
+    /// If the nodemap finds the prefix ambiguous, the list is padded with
+    /// empty nodes up to `limit`.
+    def nodesbyprefix(&self, hexprefix: &str, limit: usize = 2) -> PyResult<Vec<PyBytes>> {
+        if !hexprefix.bytes().all(|b| b.is_ascii_hexdigit()) {
+            return Ok(Vec::new());
+        }
+        let revlog = self.index(py).borrow();
+        let nodes = non_blocking_result(
+            revlog.vertexes_by_hex_prefix(hexprefix.to_ascii_lowercase().as_bytes(), limit),
+        )
+        .map_pyerr(py)?;
+        Ok(nodes.iter().map(|n| PyBytes::new(py, n.as_ref())).collect())
+    }
+
     /// Insert a new revision that hasn't been written to disk.
     /// Used by revlog._addrevision.
     def insert(&self, node: PyBytes, parents: Vec<u32>, data: Option<PyBytes> = None) -> PyResult<PyNone> {
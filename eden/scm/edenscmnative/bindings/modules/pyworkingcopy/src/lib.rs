@@ -26,6 +26,7 @@ use pyconfigparser::config;
 use pypathmatcher::extract_matcher;
 use pypathmatcher::extract_option_matcher;
 use pytreestate::treestate;
+use rsworkingcopy::walker::WalkEntry;
 use rsworkingcopy::walker::WalkError;
 use rsworkingcopy::walker::Walker;
 use rsworkingcopy::workingcopy::WorkingCopy;
@@ -41,6 +42,11 @@ pub fn init_module(py: Python, package: &str) -> PyResult<PyModule> {
 py_class!(class walker |py| {
     data inner: RefCell<Walker<Arc<dyn Matcher + Sync + Send>>>;
     data _errors: RefCell<Vec<Error>>;
+    data with_stat: bool;
+
+    /// If `with_stat` is set, the walker yields `(path, (mode, size, mtime))`
+    /// tuples from the metadata it read while walking, instead of paths. The
+    /// stat is None on platforms where that metadata has no POSIX mode.
     def __new__(
         _cls,
         root: PyPathBuf,
@@ -48,6 +54,7 @@ py_class!(class walker |py| {
         pymatcher: PyObject,
         include_directories: bool,
         thread_count: u8,
+        with_stat: bool = false,
     ) -> PyResult<walker> {
         let matcher = extract_matcher(py, pymatcher)?;
         let walker = Walker::new(
@@ -57,17 +64,25 @@ py_class!(class walker |py| {
             include_directories,
             thread_count,
         ).map_pyerr(py)?;
-        walker::create_instance(py, RefCell::new(walker), RefCell::new(Vec::new()))
+        walker::create_instance(py, RefCell::new(walker), RefCell::new(Vec::new()), with_stat)
     }
 
     def __iter__(&self) -> PyResult<Self> {
         Ok(self.clone_ref(py))
     }
 
-    def __next__(&self) -> PyResult<Option<PyPathBuf>> {
+    def __next__(&self) -> PyResult<Option<PyObject>> {
         loop {
             match self.inner(py).borrow_mut().next() {
-                Some(Ok(path)) => return Ok(Some(PyPathBuf::from(path.as_ref()))),
+                Some(Ok(entry)) => {
+                    let path = PyPathBuf::from(entry.as_ref());
+                    let item = if *self.with_stat(py) {
+                        (path, entry_stat(&entry)).to_py_object(py).into_object()
+                    } else {
+                        path.to_py_object(py).into_object()
+                    };
+                    return Ok(Some(item));
+                }
                 Some(Err(e)) => self._errors(py).borrow_mut().push(e),
                 None => return Ok(None),
             };
@@ -83,6 +98,29 @@ py_class!(class walker |py| {
 
 });
 
+/// The mode, size and mtime of a walked entry, which status compares with the
+/// dirstate.
+fn entry_stat(entry: &WalkEntry) -> Option<(u32, u64, i64)> {
+    #[cfg(unix)]
+    {
+        use std::os::unix::fs::MetadataExt;
+        const S_IFDIR: u32 = 0o040000;
+        match entry {
+            // The walker got the metadata from the directory entry, which
+            // does not follow symlinks, like lstat.
+            WalkEntry::File(_, metadata) => {
+                Some((metadata.mode(), metadata.size(), metadata.mtime()))
+            }
+            WalkEntry::Directory(_) => Some((S_IFDIR, 0, 0)),
+        }
+    }
+    #[cfg(not(unix))]
+    {
+        let _ = entry;
+        None
+    }
+}
+
 py_class!(pub class workingcopy |py| {
     data inner: Arc<RwLock<WorkingCopy>>;
 
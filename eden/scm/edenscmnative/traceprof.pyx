@@ -26,6 +26,14 @@ Config::
 
     # frame de-duplication (slower to print outputs)
     framededup = yes
+
+    # "trace" records every call. "sampling" records the stack every
+    # samplinginterval microseconds instead, which is cheap enough to leave
+    # on, and prints it as folded stacks for flamegraph.pl.
+    mode = trace
+
+    # microseconds between two samples in sampling mode
+    samplinginterval = 10000
 """
 
 from libc.stdio cimport fopen, fclose, FILE
@@ -46,12 +54,17 @@ cdef extern from "edenscm/ext/extlib/traceprofimpl.cpp":
     void setcountthreshold(size_t)
     void setdedup(int)
     void clear()
+    void enablesampling()
+    void disablesampling()
+    void reportfolded(FILE *)
+    void setsamplinginterval(double)
 
 cdef extern from "Python.h":
     FILE* PyFile_AsFile(PyObject *p)
 
 @contextlib.contextmanager
 def profile(ui, fp, section="profiling"):
+    sampling = False
     if ui is not None:
         if ui.configbool('traceprof', 'disablegc'):
             gc.disable() # slightly more predictable
@@ -63,11 +76,21 @@ def profile(ui, fp, section="profiling"):
             setcountthreshold(count)
         dedup = ui.configbool('traceprof', 'framededup', True)
         setdedup(<int>dedup)
-    enable()
+        sampling = ui.config('traceprof', 'mode') == 'sampling'
+        interval = ui.configint('traceprof', 'samplinginterval')
+        if interval is not None:
+            setsamplinginterval(<double>interval)
+    if sampling:
+        enablesampling()
+    else:
+        enable()
     try:
         yield
     finally:
-        disable()
+        if sampling:
+            disablesampling()
+        else:
+            disable()
         # "report" only accepts a real file. "fp" could be stringio.
         # Therefore always use a temporary file as a buffer.
         pyfd, filename = tempfile.mkstemp("traceprof")
@@ -78,7 +101,10 @@ def profile(ui, fp, section="profiling"):
         # on Windows. Workaround that by using `fopen` provided by Cython
         # so only the Cython version of the file handlers are used.
         cfp = fopen(pycompat.encodeutf8(filename), "w")
-        report(cfp)
+        if sampling:
+            reportfolded(cfp)
+        else:
+            report(cfp)
         fclose(cfp)
         content = open(filename).read()
         os.unlink(filename)
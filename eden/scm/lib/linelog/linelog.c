@@ -79,6 +79,9 @@ typedef size_t linelog_llinenum;
 #ifndef MIN
 #define MIN(x, y) (((x) < (y)) ? (x) : (y))
 #endif
+#ifndef MAX
+#define MAX(x, y) (((x) > (y)) ? (x) : (y))
+#endif
 static const linelog_loffset MAX_OFFSET =
     MIN(0x0ffffff0u, SIZE_MAX / INST_SIZE);
 static const linelog_llinenum MAX_LINENUM =
@@ -155,12 +158,16 @@ static linelog_result reservelines(
   if (linecount >= MAX_LINENUM)
     return LINELOG_RESULT_EOVERFLOW;
   if (ar->maxlinecount < linecount) {
-    size_t size = sizeof(linelog_lineinfo) * linecount;
+    /* grow geometrically, as lines are usually appended one by one */
+    linelog_llinenum newcount =
+        MIN(MAX(linecount, (linelog_llinenum)ar->maxlinecount * 2),
+            MAX_LINENUM);
+    size_t size = sizeof(linelog_lineinfo) * newcount;
     void* p = realloc(ar->lines, size);
     if (p == NULL)
       return LINELOG_RESULT_ENOMEM;
     ar->lines = (linelog_lineinfo*)p;
-    ar->maxlinecount = (linelog_linenum)linecount;
+    ar->maxlinecount = (linelog_linenum)newcount;
   }
   return LINELOG_RESULT_OK;
 }
@@ -208,20 +215,30 @@ inline static linelog_result appendline(
   return LINELOG_RESULT_OK;
 }
 
-linelog_result linelog_annotate(
+/* run annotate for rev. instructions are read from insts if it is not NULL,
+   or decoded from buf otherwise. buf must have passed readinst on inst0. */
+static linelog_result annotate(
     const linelog_buf* buf,
+    const linelog_inst* insts,
     linelog_annotateresult* ar,
     linelog_revnum rev) {
   linelog_inst inst0;
-  returnonerror(readinst(buf, &inst0, 0));
+  decode(buf->data, &inst0);
 
+  /* readinst's checks on pc, done once for the length */
+  linelog_loffset len = MIN((linelog_loffset)inst0.offset, MAX_OFFSET);
   linelog_offset pc, nextpc = 1, endoffset = 0;
   ar->linecount = 0;
   size_t step = (size_t)inst0.offset;
 
   while ((pc = nextpc++) != 0 && --step) {
+    if (pc >= len)
+      return LINELOG_RESULT_EILLDATA;
     linelog_inst i;
-    returnonerror(readinst(buf, &i, pc));
+    if (insts)
+      i = insts[pc];
+    else
+      decode(buf->data + (size_t)pc * INST_SIZE, &i);
 
     switch (i.opcode) {
       case JGE:
@@ -249,6 +266,39 @@ linelog_result linelog_annotate(
   return LINELOG_RESULT_OK;
 }
 
+linelog_result linelog_annotate(
+    const linelog_buf* buf,
+    linelog_annotateresult* ar,
+    linelog_revnum rev) {
+  linelog_inst inst0;
+  returnonerror(readinst(buf, &inst0, 0));
+  return annotate(buf, NULL, ar, rev);
+}
+
+linelog_result linelog_annotate_revs(
+    const linelog_buf* buf,
+    linelog_annotateresult* ars,
+    const linelog_revnum* revs,
+    size_t revcount) {
+  linelog_inst inst0;
+  returnonerror(readinst(buf, &inst0, 0));
+  if (revcount == 0)
+    return LINELOG_RESULT_OK;
+
+  size_t len = (size_t)inst0.offset;
+  linelog_inst* insts = malloc(sizeof(linelog_inst) * len);
+  if (insts == NULL)
+    return LINELOG_RESULT_ENOMEM;
+  for (size_t pc = 1; pc < len; ++pc)
+    decode(buf->data + pc * INST_SIZE, &insts[pc]);
+
+  linelog_result result = LINELOG_RESULT_OK;
+  for (size_t i = 0; i < revcount && result == LINELOG_RESULT_OK; ++i)
+    result = annotate(buf, insts, &ars[i], revs[i]);
+  free(insts);
+  return result;
+}
+
 static linelog_result replacelines(
     linelog_buf* buf,
     linelog_annotateresult* ar,
@@ -79,6 +79,21 @@ linelog_result linelog_annotate(
     linelog_annotateresult* ar,
     linelog_revnum rev);
 
+/* calculate annotateresults for several revisions, output the result for
+   revs[i] to ars[i], for i in range(0, revcount)
+
+   the results are the same as linelog_annotate's. the instructions are
+   decoded once for all the revisions, which makes it faster than calling
+   linelog_annotate for each of them, to annotate many revisions of a long
+   history.
+
+   on error, ars may be in an invalid state and need to be cleared */
+linelog_result linelog_annotate_revs(
+    const linelog_buf* buf,
+    linelog_annotateresult* ars,
+    const linelog_revnum* revs,
+    size_t revcount);
+
 /* update buf and ar, replace existing lines[a1:a2] with lines[b1:b2] in brev
 
    ar should be obtained using linelog_annotate(brev).
@@ -20,6 +20,7 @@
 #include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 #include "linelog.c" /* unusual but we want to access some private structs */
 
@@ -55,10 +56,11 @@ static const char helptext[] =
     "usage: linelogcli FILE CMDLIST\n"
     "where  CMDLIST := CMD | CMDLIST CMD\n"
     "       CMD := init | info | dump | ANNOTATECMD | REPLACELINESCMD | "
-    "GETALLLINESCMD\n"
+    "GETALLLINESCMD | BENCHCMD\n"
     "       ANNOTATECMD := annotate REV | annotate -\n"
     "       REPLACELINESCMD := replacelines rev a1:a2 b1:b2\n"
-    "       GETALLLINESCMD := getalllines offset1:offset2\n";
+    "       GETALLLINESCMD := getalllines offset1:offset2\n"
+    "       BENCHCMD := bench rev1:rev2\n";
 
 static void closefile(void) {
   if (buf.data) {
@@ -284,6 +286,59 @@ int cmdgetalllines(const char* args[]) {
   return r;
 }
 
+static double elapsedms(clock_t start) {
+  return (double)(clock() - start) * 1000.0 / CLOCKS_PER_SEC;
+}
+
+/* annotate every revision in range(rev1, rev2 + 1), one by one with
+   linelog_annotate, then batched with linelog_annotate_revs */
+int cmdbench(const char* args[]) {
+  unsigned rev1 = 0, rev2 = 0;
+  if (sscanf(args[0], "%u:%u", &rev1, &rev2) != 2 || rev2 < rev1)
+    rev1 = 0, rev2 = linelog_getmaxrev(&buf);
+  size_t count = (size_t)rev2 - rev1 + 1;
+
+  linelog_revnum* revs = calloc(count, sizeof(linelog_revnum));
+  linelog_annotateresult* ars = calloc(count, sizeof(linelog_annotateresult));
+  ensure(revs != NULL && ars != NULL);
+  for (size_t i = 0; i < count; ++i)
+    revs[i] = (linelog_revnum)(rev1 + i);
+
+  linelog_result r = LINELOG_RESULT_OK;
+  size_t linecount = 0;
+  clock_t start = clock();
+  for (size_t i = 0; i < count && r == LINELOG_RESULT_OK; ++i) {
+    r = linelog_annotate(&buf, &ars[i], revs[i]);
+    linecount += ars[i].linecount;
+  }
+  double onebyone = elapsedms(start);
+
+  if (r == LINELOG_RESULT_OK) {
+    for (size_t i = 0; i < count; ++i)
+      linelog_annotateresult_clear(&ars[i]);
+    start = clock();
+    r = linelog_annotate_revs(&buf, ars, revs, count);
+    double batched = elapsedms(start);
+    size_t batchedlinecount = 0;
+    for (size_t i = 0; i < count; ++i)
+      batchedlinecount += ars[i].linecount;
+    ensure(r != LINELOG_RESULT_OK || batchedlinecount == linecount);
+    if (r == LINELOG_RESULT_OK)
+      printf(
+          "bench: %lu revs, %lu lines: %.3f ms one by one, %.3f ms batched\n",
+          (unsigned long)count,
+          (unsigned long)linecount,
+          onebyone,
+          batched);
+  }
+
+  for (size_t i = 0; i < count; ++i)
+    linelog_annotateresult_clear(&ars[i]);
+  free(ars);
+  free(revs);
+  return r;
+}
+
 typedef int cmdfunc(const char* args[]);
 typedef struct {
   const char* name;
@@ -299,6 +354,7 @@ static cmdentry cmdtable[] = {
     {"replacelines", 'r', 3, cmdreplacelines},
     {"dump", 'd', 0, cmddump},
     {"getalllines", 'l', 1, cmdgetalllines},
+    {"bench", 'b', 1, cmdbench},
 };
 
 const cmdentry* findcmd(const char* name) {
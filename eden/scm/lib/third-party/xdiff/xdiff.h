@@ -53,6 +53,23 @@ typedef struct s_xpparam {
 	uint64_t flags;
 } xpparam_t;
 
+/*
+ * Bounds of the work of xdl_diff_limited_vendored. Zero means unbounded.
+ *
+ * Once the common prefix and suffix are trimmed, files whose remaining
+ * lines exceed max_bytes or max_lines in total are not diffed line by line:
+ * their remaining lines are reported as a single change instead, which takes
+ * linear time and no memory besides the files.
+ *
+ * max_cost caps the edit cost the search for a minimal diff explores at each
+ * split before falling back to its heuristics (see XDL_MAX_COST_MIN).
+ */
+typedef struct s_xdlimits {
+	int64_t max_bytes;
+	int64_t max_lines;
+	int64_t max_cost;
+} xdlimits_t;
+
 typedef struct s_xdemitcb {
 	void *priv;
 } xdemitcb_t;
@@ -77,6 +94,13 @@ int64_t xdl_mmfile_size_vendored(mmfile_t *mmf);
 int xdl_diff_vendored(mmfile_t *mf1, mmfile_t *mf2, xpparam_t const *xpp,
 	     xdemitconf_t const *xecfg, xdemitcb_t *ecb);
 
+/* Like xdl_diff_vendored, within the bounds of xlim (may be NULL). Sets
+ * *approximate to whether the bounds were exceeded, in which case the hunks
+ * describe a valid but not minimal diff. */
+int xdl_diff_limited_vendored(mmfile_t *mf1, mmfile_t *mf2,
+	     xpparam_t const *xpp, xdlimits_t const *xlim,
+	     xdemitconf_t const *xecfg, xdemitcb_t *ecb, int *approximate);
+
 #ifdef __cplusplus
 }
 #endif /* #ifdef __cplusplus */
@@ -326,7 +326,7 @@ int xdl_recs_cmp_vendored(diffdata_t *dd1, int64_t off1, int64_t lim1,
 
 
 int xdl_do_diff_vendored(mmfile_t *mf1, mmfile_t *mf2, xpparam_t const *xpp,
-		xdfenv_t *xe) {
+		xdlimits_t const *xlim, xdfenv_t *xe) {
 	int64_t ndiags;
 	int64_t *kvd, *kvdf, *kvdb;
 	xdalgoenv_t xenv;
@@ -357,6 +357,11 @@ int xdl_do_diff_vendored(mmfile_t *mf1, mmfile_t *mf2, xpparam_t const *xpp,
 		xenv.mxcost = XDL_MAX_COST_MIN;
 	xenv.snake_cnt = XDL_SNAKE_CNT;
 	xenv.heur_min = XDL_HEUR_MIN_COST;
+	if (xlim && xlim->max_cost > 0 && xenv.mxcost > xlim->max_cost) {
+		xenv.mxcost = xlim->max_cost;
+		if (xenv.heur_min > xenv.mxcost)
+			xenv.heur_min = xenv.mxcost;
+	}
 
 	dd1.nrec = xe->xdf1.nreff;
 	dd1.ha = xe->xdf1.ha;
@@ -1101,12 +1106,105 @@ static int xdl_call_hunk_func(xdfenv_t *xe, xdchange_t *xscr, xdemitcb_t *ecb,
 	return 0;
 }
 
+/*
+ * Number of records xdl_prepare_ctx would split mf into, without
+ * allocating them.
+ */
+static int64_t xdl_count_recs(mmfile_t *mf) {
+	char const *cur = mf->ptr, *top = mf->ptr + mf->size;
+	int64_t nrec = 0;
+
+	while (cur < top) {
+		nrec++;
+		if (!(cur = memchr(cur, '\n', top - cur)))
+			break;
+		cur++;
+	}
+
+	return nrec;
+}
+
+
+/*
+ * Checks whether the files left once their common prefix and suffix are
+ * trimmed exceed the bounds of xlim. If so, fills xe->nprefix, xe->nsuffix,
+ * xe->xdf1.nrec and xe->xdf2.nrec for xdl_call_approximate_hunk_func.
+ */
+static int xdl_exceeds_limits(mmfile_t *mf1, mmfile_t *mf2,
+			      xdlimits_t const *xlim, xdfenv_t *xe) {
+	mmfile_t tmf1, tmf2;
+	int64_t nrec1, nrec2;
+
+	if (!xlim || (xlim->max_bytes <= 0 && xlim->max_lines <= 0))
+		return 0;
+	if (xlim->max_lines <= 0 && mf1->size + mf2->size <= xlim->max_bytes)
+		return 0;
+
+	xdl_trim_files_vendored(mf1, mf2, 0, xe, &tmf1, &tmf2);
+	/* The trimming keeps a single common line, identical or not */
+	if (tmf1.size == tmf2.size && !memcmp(tmf1.ptr, tmf2.ptr, tmf1.size))
+		return 0;
+	if (xlim->max_bytes > 0 && tmf1.size + tmf2.size > xlim->max_bytes) {
+		xe->xdf1.nrec = xdl_count_recs(&tmf1);
+		xe->xdf2.nrec = xdl_count_recs(&tmf2);
+		return 1;
+	}
+	if (xlim->max_lines <= 0)
+		return 0;
+	nrec1 = xdl_count_recs(&tmf1);
+	nrec2 = xdl_count_recs(&tmf2);
+	if (nrec1 + nrec2 <= xlim->max_lines)
+		return 0;
+	xe->xdf1.nrec = nrec1;
+	xe->xdf2.nrec = nrec2;
+	return 1;
+}
+
+
+/*
+ * Reports all the lines between the common prefix and suffix as a single
+ * change, the way xdl_call_hunk_func would have reported it.
+ */
+static int xdl_call_approximate_hunk_func(xdfenv_t *xe, xdemitcb_t *ecb,
+					  xdemitconf_t const *xecfg)
+{
+	int64_t p = xe->nprefix, s = xe->nsuffix;
+	int64_t n1 = xe->xdf1.nrec, n2 = xe->xdf2.nrec;
+
+	if (!xecfg->hunk_func)
+		return -1;
+
+	if ((xecfg->flags & XDL_EMIT_BDIFFHUNK) != 0) {
+		if (n1 == 0 && n2 == 0)
+			return xecfg->hunk_func(0, p + s, 0, p + s, ecb->priv);
+		if (p > 0 && xecfg->hunk_func(0, p, 0, p, ecb->priv) < 0)
+			return -1;
+		return xecfg->hunk_func(p + n1, p + n1 + s, p + n2, p + n2 + s,
+					ecb->priv);
+	}
+	if (n1 == 0 && n2 == 0)
+		return 0;
+	return xecfg->hunk_func(p, n1, p, n2, ecb->priv);
+}
+
 int xdl_diff_vendored(mmfile_t *mf1, mmfile_t *mf2, xpparam_t const *xpp,
 	     xdemitconf_t const *xecfg, xdemitcb_t *ecb) {
+	return xdl_diff_limited_vendored(mf1, mf2, xpp, NULL, xecfg, ecb, NULL);
+}
+
+int xdl_diff_limited_vendored(mmfile_t *mf1, mmfile_t *mf2,
+	     xpparam_t const *xpp, xdlimits_t const *xlim,
+	     xdemitconf_t const *xecfg, xdemitcb_t *ecb, int *approximate) {
 	xdchange_t *xscr;
 	xdfenv_t xe;
+	int exceeds = xdl_exceeds_limits(mf1, mf2, xlim, &xe);
+
+	if (approximate)
+		*approximate = exceeds;
+	if (exceeds)
+		return xdl_call_approximate_hunk_func(&xe, ecb, xecfg);
 
-	if (xdl_do_diff_vendored(mf1, mf2, xpp, &xe) < 0) {
+	if (xdl_do_diff_vendored(mf1, mf2, xpp, xlim, &xe) < 0) {
 
 		return -1;
 	}
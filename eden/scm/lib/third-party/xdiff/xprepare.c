@@ -163,7 +163,7 @@ static int xdl_classify_record(unsigned int pass, xdlclassifier_t *cf, xrecord_t
  * outweighs the shift change. A diff result with suboptimal shifting is still
  * valid.
  */
-static void xdl_trim_files(mmfile_t *mf1, mmfile_t *mf2, int64_t reserved,
+void xdl_trim_files_vendored(mmfile_t *mf1, mmfile_t *mf2, int64_t reserved,
 		xdfenv_t *xe, mmfile_t *out_mf1, mmfile_t *out_mf2) {
 	mmfile_t msmall, mlarge;
 	/* prefix lines, prefix bytes, suffix lines, suffix bytes */
@@ -346,16 +346,17 @@ int xdl_prepare_env_vendored(mmfile_t *mf1, mmfile_t *mf2, xpparam_t const *xpp,
 
 	memset(&cf, 0, sizeof(cf));
 
+	/* Trim first so that the classifier is sized for the lines left */
+	xdl_trim_files_vendored(mf1, mf2, TRIM_RESERVED_LINES, xe, &tmf1, &tmf2);
+
 	sample = XDL_GUESS_NLINES1;
 
-	enl1 = xdl_guess_lines_vendored(mf1, sample) + 1;
-	enl2 = xdl_guess_lines_vendored(mf2, sample) + 1;
+	enl1 = xdl_guess_lines_vendored(&tmf1, sample) + 1;
+	enl2 = xdl_guess_lines_vendored(&tmf2, sample) + 1;
 
 	if (xdl_init_classifier(&cf, enl1 + enl2 + 1, xpp->flags) < 0)
 		return -1;
 
-	xdl_trim_files(mf1, mf2, TRIM_RESERVED_LINES, xe, &tmf1, &tmf2);
-
 	if (xdl_prepare_ctx(1, &tmf1, enl1, &cf, &xe->xdf1) < 0) {
 
 		xdl_free_classifier(&cf);
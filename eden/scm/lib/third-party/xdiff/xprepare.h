@@ -28,6 +28,8 @@
 int xdl_prepare_env_vendored(mmfile_t *mf1, mmfile_t *mf2, xpparam_t const *xpp,
 		    xdfenv_t *xe);
 void xdl_free_env_vendored(xdfenv_t *xe);
+void xdl_trim_files_vendored(mmfile_t *mf1, mmfile_t *mf2, int64_t reserved,
+		xdfenv_t *xe, mmfile_t *out_mf1, mmfile_t *out_mf2);
 
 
 
@@ -131,12 +131,16 @@ int xdl_recmatch_vendored(const char *l1, int64_t s1, const char *l2, int64_t s2
 uint64_t xdl_hash_record_vendored(char const **data, char const *top) {
 	uint64_t ha = 5381;
 	char const *ptr = *data;
+	/* Find the end of the line with memchr, which libc vectorizes, so that
+	 * the hashing loop doesn't also test every byte. */
+	char const *eol = memchr(ptr, '\n', top - ptr);
+	char const *end = eol ? eol : top;
 
-	for (; ptr < top && *ptr != '\n'; ptr++) {
+	for (; ptr < end; ptr++) {
 		ha += (ha << 5);
 		ha ^= (unsigned long) *ptr;
 	}
-	*data = ptr < top ? ptr + 1: ptr;
+	*data = eol ? eol + 1: top;
 
 	return ha;
 }
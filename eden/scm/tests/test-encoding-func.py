@@ -8,6 +8,7 @@ from __future__ import absolute_import
 import unittest
 
 from edenscm import encoding
+from edenscm.pure import charencode as charencodepure
 from hghave import require
 
 
@@ -26,6 +27,37 @@ class IsasciistrTest(unittest.TestCase):
                 self.assertFalse(encoding.isasciistr(bytes(t)))
 
 
+class LongStrTest(unittest.TestCase):
+    """strings long enough to go through the vectorized code paths"""
+
+    prefix = b"Some/Path/To/A/File-With_Mixed.Case" * 3
+
+    def testisasciistr(self):
+        self.assertTrue(encoding.isasciistr(self.prefix))
+        for i in range(len(self.prefix)):
+            t = bytearray(self.prefix)
+            t[i] |= 0x80
+            self.assertFalse(encoding.isasciistr(bytes(t)))
+
+    def testasciitransform(self):
+        s = self.prefix + b"@[`{"
+        self.assertEqual(encoding.asciilower(s), charencodepure.asciilower(s))
+        self.assertEqual(encoding.asciiupper(s), charencodepure.asciiupper(s))
+        with self.assertRaises(UnicodeDecodeError):
+            encoding.asciilower(self.prefix + b"\xc3\xa9")
+
+    def testjsonescape(self):
+        for suffix in [b"", b"\n", b'"', b"\\", b"\x7f", b"<>", b"\xc3\xa9"]:
+            s = self.prefix + suffix + self.prefix
+            for paranoid in [False, True]:
+                # escaping is done one character at a time
+                escaped = encoding.jsonescape(suffix, paranoid=paranoid)
+                self.assertEqual(
+                    encoding.jsonescape(s, paranoid=paranoid),
+                    self.prefix + escaped + self.prefix,
+                )
+
+
 class LocalEncodingTest(unittest.TestCase):
     def testasciifastpath(self):
         s = b"\0" * 100
@@ -0,0 +1,69 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+#
+# This software may be used and distributed according to the terms of the
+# GNU General Public License version 2.
+
+from __future__ import absolute_import
+
+import random
+import struct
+import unittest
+
+from edenscm import mdiff
+
+
+def mkpatch(text, rng):
+    """returns a random patch of text, and the patched text"""
+    count = rng.randint(0, 4)
+    points = sorted(rng.randint(0, len(text)) for _ in range(2 * count))
+    hunks, parts, last = [], [], 0
+    for i in range(count):
+        start, end = points[2 * i], points[2 * i + 1]
+        data = b"%d\n" % rng.randint(0, 1000)
+        hunks.append(struct.pack(">lll", start, end, len(data)) + data)
+        parts += [text[last:start], data]
+        last = end
+    parts.append(text[last:])
+    return b"".join(hunks), b"".join(parts)
+
+
+def mkchain(base, length):
+    """returns a chain of patches from base, and the text after each one"""
+    rng = random.Random(length)
+    bins, texts = [], [base]
+    for _ in range(length):
+        patch, text = mkpatch(texts[-1], rng)
+        bins.append(patch)
+        texts.append(text)
+    return bins, texts
+
+
+class MpatchTests(unittest.TestCase):
+    base = b"".join(b"line %d\n" % i for i in range(200))
+
+    def testpatches(self):
+        # long chains are folded by several threads
+        for length in [1, 2, 10, 300, 1000]:
+            bins, texts = mkchain(self.base, length)
+            self.assertEqual(mdiff.patches(self.base, bins), texts[-1])
+
+    def testpatchesbulk(self):
+        bins, texts = mkchain(self.base, 500)
+        ends = [0, 1, 1, 7, 200, 499, 500]
+        self.assertEqual(
+            mdiff.patchesbulk(self.base, bins, ends), [texts[e] for e in ends]
+        )
+        self.assertEqual(mdiff.patchesbulk(self.base, bins, []), [])
+
+    def testpatchesbulkerrors(self):
+        bins, texts = mkchain(self.base, 3)
+        with self.assertRaises(ValueError):
+            mdiff.patchesbulk(self.base, bins, [2, 1])
+        with self.assertRaises(ValueError):
+            mdiff.patchesbulk(self.base, bins, [4])
+
+
+if __name__ == "__main__":
+    import silenttestrunner
+
+    silenttestrunner.main(__name__)
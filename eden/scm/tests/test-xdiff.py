@@ -0,0 +1,69 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+#
+# This software may be used and distributed according to the terms of the
+# GNU General Public License version 2.
+
+from __future__ import absolute_import
+
+import unittest
+
+from edenscmnative import xdiff
+
+
+def mktext(lines):
+    return b"".join(b"%s\n" % l for l in lines)
+
+
+class XdiffLimitsTests(unittest.TestCase):
+    a = mktext(b"line %d" % i for i in range(1000))
+    # lines 100, 200, ..., 900 differ
+    b = mktext(
+        b"changed %d" % i if i and i % 100 == 0 else b"line %d" % i
+        for i in range(1000)
+    )
+
+    def testunlimited(self):
+        blocks, approximate = xdiff.limitedblocks(self.a, self.b, 0, 0, 0)
+        self.assertFalse(approximate)
+        self.assertEqual(blocks, xdiff.blocks(self.a, self.b))
+
+    def testwithinlimits(self):
+        blocks, approximate = xdiff.limitedblocks(
+            self.a, self.b, 1 << 20, 5000, 0
+        )
+        self.assertFalse(approximate)
+        self.assertEqual(blocks, xdiff.blocks(self.a, self.b))
+
+    def testmaxbytes(self):
+        # the common prefix and suffix are still matched
+        blocks, approximate = xdiff.limitedblocks(self.a, self.b, 1000, 0, 0)
+        self.assertTrue(approximate)
+        self.assertEqual(blocks, [(0, 100, 0, 100), (901, 1000, 901, 1000)])
+
+    def testmaxlines(self):
+        blocks, approximate = xdiff.limitedblocks(self.a, self.b, 0, 100, 0)
+        self.assertTrue(approximate)
+        self.assertEqual(blocks, [(0, 100, 0, 100), (901, 1000, 901, 1000)])
+
+    def testidentical(self):
+        for text in [b"", b"x", b"x\n", self.a]:
+            blocks, approximate = xdiff.limitedblocks(text, text, 1, 1, 0)
+            self.assertFalse(approximate)
+            self.assertEqual(blocks, xdiff.blocks(text, text))
+
+    def testmaxcost(self):
+        # a capped search still describes a valid diff
+        a = mktext(b"%d" % (i % 7) for i in range(3000))
+        b = mktext(b"%d" % (i % 5) for i in range(3000))
+        blocks, approximate = xdiff.limitedblocks(a, b, 0, 0, 1)
+        self.assertFalse(approximate)
+        alines, blines = a.splitlines(), b.splitlines()
+        for a1, a2, b1, b2 in blocks:
+            self.assertEqual(alines[a1:a2], blines[b1:b2])
+        self.assertEqual(blocks[-1], (3000, 3000, 3000, 3000))
+
+
+if __name__ == "__main__":
+    import silenttestrunner
+
+    silenttestrunner.main(__name__)